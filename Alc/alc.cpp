@@ -47,15 +47,24 @@
 #include "alFilter.h"
 #include "alEffect.h"
 #include "alAuxEffectSlot.h"
+#include "alSourceGroup.h"
 #include "alError.h"
 #include "mastering.h"
 #include "bformatdec.h"
+#ifdef ALSOFT_UHJ
 #include "uhjfilter.h"
+#endif
 #include "alu.h"
 #include "alconfig.h"
+#include "callrecord.h"
 #include "ringbuffer.h"
+#include "converter.h"
+#include "mirror.h"
+#include "mixerpool.h"
 #include "filters/splitter.h"
+#ifdef ALSOFT_BS2B
 #include "bs2b.h"
+#endif
 
 #include "fpu_modes.h"
 #include "cpu_caps.h"
@@ -70,6 +79,9 @@
 #ifdef HAVE_JACK
 #include "backends/jack.h"
 #endif
+#ifdef HAVE_PIPEWIRE
+#include "backends/pipewire.h"
+#endif
 #ifdef HAVE_PULSEAUDIO
 #include "backends/pulseaudio.h"
 #endif
@@ -82,6 +94,9 @@
 #ifdef HAVE_COREAUDIO
 #include "backends/coreaudio.h"
 #endif
+#ifdef HAVE_AAUDIO
+#include "backends/aaudio.h"
+#endif
 #ifdef HAVE_OPENSL
 #include "backends/opensl.h"
 #endif
@@ -109,6 +124,9 @@
 #ifdef HAVE_SDL2
 #include "backends/sdl2.h"
 #endif
+#ifdef HAVE_WEBAUDIO
+#include "backends/webaudio.h"
+#endif
 #ifdef HAVE_WAVE
 #include "backends/wave.h"
 #endif
@@ -133,6 +151,9 @@ BackendInfo BackendList[] = {
 #ifdef HAVE_JACK
     { "jack", JackBackendFactory::getFactory },
 #endif
+#ifdef HAVE_PIPEWIRE
+    { "pipewire", PipeWireBackendFactory::getFactory },
+#endif
 #ifdef HAVE_PULSEAUDIO
     { "pulse", PulseBackendFactory::getFactory },
 #endif
@@ -145,9 +166,15 @@ BackendInfo BackendList[] = {
 #ifdef HAVE_COREAUDIO
     { "core", CoreAudioBackendFactory::getFactory },
 #endif
+#ifdef HAVE_AAUDIO
+    { "aaudio", AAudioBackendFactory::getFactory },
+#endif
 #ifdef HAVE_OPENSL
     { "opensl", OSLBackendFactory::getFactory },
 #endif
+#ifdef HAVE_WEBAUDIO
+    { "webaudio", WebAudioBackendFactory::getFactory },
+#endif
 #ifdef HAVE_SOLARIS
     { "solaris", SolarisBackendFactory::getFactory },
 #endif
@@ -180,6 +207,15 @@ BackendInfo BackendList[] = {
 };
 auto BackendListEnd = std::end(BackendList);
 
+/* Backends are initialized in order of preference only as far as needed to
+ * find one for playback or capture, when a device of that type is first
+ * opened or enumerated. Apps that only use loopback devices then never load
+ * the system's audio libraries. BackendInitCur is the next backend to try,
+ * and backends that fail to initialize are removed from the list.
+ */
+std::mutex BackendInitLock;
+auto BackendInitCur = std::begin(BackendList);
+
 BackendInfo PlaybackBackend;
 BackendInfo CaptureBackend;
 
@@ -188,7 +224,7 @@ BackendInfo CaptureBackend;
  * Functions, enums, and errors
  ************************************************/
 #define DECL(x) { #x, (ALCvoid*)(x) }
-constexpr struct {
+const struct {
     const ALCchar *funcName;
     ALCvoid *address;
 } alcFunctions[] = {
@@ -212,6 +248,7 @@ constexpr struct {
     DECL(alcCaptureStart),
     DECL(alcCaptureStop),
     DECL(alcCaptureSamples),
+    DECL(alcCaptureCallbackSOFT),
 
     DECL(alcSetThreadContext),
     DECL(alcGetThreadContext),
@@ -219,6 +256,11 @@ constexpr struct {
     DECL(alcLoopbackOpenDeviceSOFT),
     DECL(alcIsRenderFormatSupportedSOFT),
     DECL(alcRenderSamplesSOFT),
+    DECL(alcRenderSamplesPlanarSOFT),
+    DECL(alcRenderSamplesBatchSOFT),
+    DECL(alcRenderSamplesSparseSOFT),
+
+    DECL(alcSetAllocatorCallbacksSOFT),
 
     DECL(alcDevicePauseSOFT),
     DECL(alcDeviceResumeSOFT),
@@ -226,6 +268,9 @@ constexpr struct {
     DECL(alcGetStringiSOFT),
     DECL(alcResetDeviceSOFT),
 
+    DECL(alcAddOutputMirrorSOFT),
+    DECL(alcRemoveOutputMirrorsSOFT),
+
     DECL(alcGetInteger64vSOFT),
 
     DECL(alEnable),
@@ -361,8 +406,36 @@ constexpr struct {
 
     DECL(alEventControlSOFT),
     DECL(alEventCallbackSOFT),
+    DECL(alEventBatchCallbackSOFT),
     DECL(alGetPointerSOFT),
     DECL(alGetPointervSOFT),
+
+    DECL(alSourceUpdateBatchSOFT),
+
+    DECL(alBufferDataBatchSOFT),
+
+    DECL(alBufferCallbackSOFT),
+
+    DECL(alBufferExternalSOFT),
+
+    DECL(alBufferFileSOFT),
+
+    DECL(alSourcePlayAtTimeSOFT),
+    DECL(alSourcePlayAtTimevSOFT),
+
+    DECL(alGenSourceGroupsSOFT),
+    DECL(alDeleteSourceGroupsSOFT),
+    DECL(alIsSourceGroupSOFT),
+    DECL(alSourceGroupfSOFT),
+    DECL(alGetSourceGroupfSOFT),
+
+    DECL(alGetSourcesStateSOFT),
+
+    DECL(alListenerfIndexSOFT),
+    DECL(alListenerfvIndexSOFT),
+    DECL(alListeneriIndexSOFT),
+    DECL(alGetListenerfvIndexSOFT),
+    DECL(alGetListeneriIndexSOFT),
 };
 #undef DECL
 
@@ -440,6 +513,35 @@ constexpr struct {
 
     DECL(ALC_OUTPUT_LIMITER_SOFT),
 
+    DECL(ALC_LOCKED_MEMORY_SIZE_SOFT),
+
+    DECL(ALC_MIXER_STATS_SOFT),
+    DECL(ALC_MIXER_PARAM_TIME_SOFT),
+    DECL(ALC_MIXER_VOICE_TIME_SOFT),
+    DECL(ALC_MIXER_VOICE_PLAIN_TIME_SOFT),
+    DECL(ALC_MIXER_VOICE_HRTF_TIME_SOFT),
+    DECL(ALC_MIXER_VOICE_AMBI_TIME_SOFT),
+    DECL(ALC_MIXER_EFFECT_TIME_SOFT),
+    DECL(ALC_MIXER_POSTPROCESS_TIME_SOFT),
+    DECL(ALC_MIXER_OUTPUT_TIME_SOFT),
+    DECL(ALC_MIXER_UPDATE_TIME_SOFT),
+    DECL(ALC_MIXER_PEAK_UPDATE_TIME_SOFT),
+    DECL(ALC_MIXER_VOICES_MIXED_SOFT),
+    DECL(ALC_MIXER_VOICES_SKIPPED_SOFT),
+    DECL(ALC_MIXER_UPDATE_COUNT_SOFT),
+    DECL(ALC_MIXER_XRUN_COUNT_SOFT),
+
+    DECL(ALC_BACKEND_WAKEUP_COUNT_SOFT),
+    DECL(ALC_BACKEND_MAX_WAKEUP_GAP_SOFT),
+    DECL(ALC_BACKEND_JITTER_HISTOGRAM_SOFT),
+    DECL(ALC_BACKEND_LATENCY_SOFT),
+    DECL(ALC_BACKEND_UNDERRUN_COUNT_SOFT),
+
+    DECL(ALC_OUTPUT_MIRROR_COUNT_SOFT),
+
+    DECL(ALC_CPU_EXTENSIONS_SOFT),
+    DECL(ALC_MIXER_KERNELS_SOFT),
+
     DECL(ALC_NO_ERROR),
     DECL(ALC_INVALID_DEVICE),
     DECL(ALC_INVALID_CONTEXT),
@@ -511,6 +613,19 @@ constexpr struct {
     DECL(AL_FORMAT_STEREO_IMA4),
     DECL(AL_FORMAT_MONO_MSADPCM_SOFT),
     DECL(AL_FORMAT_STEREO_MSADPCM_SOFT),
+
+    DECL(AL_FORMAT_MONO_I24_SOFT),
+    DECL(AL_FORMAT_STEREO_I24_SOFT),
+    DECL(AL_FORMAT_QUAD_I24_SOFT),
+    DECL(AL_FORMAT_51CHN_I24_SOFT),
+    DECL(AL_FORMAT_61CHN_I24_SOFT),
+    DECL(AL_FORMAT_71CHN_I24_SOFT),
+    DECL(AL_FORMAT_MONO_I32_SOFT),
+    DECL(AL_FORMAT_STEREO_I32_SOFT),
+    DECL(AL_FORMAT_QUAD_I32_SOFT),
+    DECL(AL_FORMAT_51CHN_I32_SOFT),
+    DECL(AL_FORMAT_61CHN_I32_SOFT),
+    DECL(AL_FORMAT_71CHN_I32_SOFT),
     DECL(AL_FORMAT_QUAD8_LOKI),
     DECL(AL_FORMAT_QUAD16_LOKI),
     DECL(AL_FORMAT_QUAD8),
@@ -555,6 +670,7 @@ constexpr struct {
     DECL(AL_SIZE),
     DECL(AL_UNPACK_BLOCK_ALIGNMENT_SOFT),
     DECL(AL_PACK_BLOCK_ALIGNMENT_SOFT),
+    DECL(AL_RESAMPLE_CACHE_SOFT),
 
     DECL(AL_SOURCE_RADIUS),
 
@@ -626,11 +742,20 @@ constexpr struct {
     DECL(AL_EFFECT_EQUALIZER),
     DECL(AL_EFFECT_DEDICATED_LOW_FREQUENCY_EFFECT),
     DECL(AL_EFFECT_DEDICATED_DIALOGUE),
+    DECL(AL_EFFECT_CONVOLUTION_REVERB_SOFT),
+    DECL(AL_EFFECT_EARLY_REFLECTIONS_SOFT),
 
     DECL(AL_EFFECTSLOT_EFFECT),
     DECL(AL_EFFECTSLOT_GAIN),
     DECL(AL_EFFECTSLOT_AUXILIARY_SEND_AUTO),
     DECL(AL_EFFECTSLOT_NULL),
+    DECL(AL_EFFECTSLOT_QUALITY_SOFT),
+    DECL(AL_QUALITY_DEFAULT_SOFT),
+    DECL(AL_QUALITY_LOW_SOFT),
+    DECL(AL_QUALITY_HIGH_SOFT),
+    DECL(AL_EFFECTSLOT_PROCESS_TIME_SOFT),
+    DECL(AL_EFFECTS_PROCESS_TIME_SOFT),
+    DECL(AL_EFFECTS_DOWNGRADED_SOFT),
 
     DECL(AL_EAXREVERB_DENSITY),
     DECL(AL_EAXREVERB_DIFFUSION),
@@ -747,6 +872,21 @@ constexpr struct {
     DECL(AL_EVENT_TYPE_ERROR_SOFT),
     DECL(AL_EVENT_TYPE_PERFORMANCE_SOFT),
     DECL(AL_EVENT_TYPE_DEPRECATED_SOFT),
+
+    DECL(AL_BUFFERS_COMPLETED_SOFT),
+    DECL(AL_BUFFER_COMPLETION_HANDLE_SOFT),
+
+    DECL(AL_SOURCE_MIX_COST_SOFT),
+    DECL(AL_SOURCE_INSTANCING_SOFT),
+
+    DECL(AL_MAX_LISTENERS_SOFT),
+    DECL(AL_LISTENER_OUTPUT_CHANNEL_SOFT),
+
+    DECL(AL_SOURCE_OUTPUT_CHANNEL_SOFT),
+    DECL(AL_OUTPUT_CHANNEL_FRONT_CENTER_SOFT),
+    DECL(AL_OUTPUT_CHANNEL_LFE_SOFT),
+
+    DECL(AL_FILTER_LINKED_SOFT),
 };
 #undef DECL
 
@@ -772,6 +912,9 @@ std::string alcCaptureDeviceList;
 std::string alcDefaultAllDevicesSpecifier;
 std::string alcCaptureDefaultDeviceSpecifier;
 
+/* The CPU extensions in use, named as for disable-cpu-exts */
+std::string alcCpuExtList;
+
 /* Default context extensions */
 constexpr ALchar alExtList[] =
     "AL_EXT_ALAW "
@@ -791,19 +934,43 @@ constexpr ALchar alExtList[] =
     "AL_EXT_STEREO_ANGLES "
     "AL_LOKI_quadriphonic "
     "AL_SOFT_block_alignment "
+    "AL_SOFTX_buffer_completion_wakeup "
+    "AL_SOFTX_buffer_data_batch "
+    "AL_SOFTX_buffer_resample_cache "
+    "AL_SOFTX_callback_buffer "
+    "AL_SOFTX_convolution_reverb "
     "AL_SOFT_deferred_updates "
     "AL_SOFT_direct_channels "
+    "AL_SOFTX_early_reflections "
     "AL_SOFTX_effect_chain "
+    "AL_SOFTX_effectslot_quality "
+    "AL_SOFTX_effect_timing "
+    "AL_SOFTX_event_batch "
     "AL_SOFTX_events "
+    "AL_SOFTX_external_buffer "
+    "AL_SOFTX_file_buffer "
     "AL_SOFTX_filter_gain_ex "
     "AL_SOFT_gain_clamp_ex "
+    "AL_SOFTX_int_formats "
+    "AL_SOFTX_hrtf_ready_event "
+    "AL_SOFTX_linked_filters "
     "AL_SOFT_loop_points "
     "AL_SOFTX_map_buffer "
     "AL_SOFT_MSADPCM "
+    "AL_SOFTX_multi_listener "
     "AL_SOFT_source_latency "
+    "AL_SOFTX_source_batch_update "
+    "AL_SOFTX_source_full_hrtf "
+    "AL_SOFTX_source_groups "
+    "AL_SOFTX_source_instancing "
+    "AL_SOFTX_source_mix_cost "
+    "AL_SOFTX_source_output_channel "
     "AL_SOFT_source_length "
+    "AL_SOFTX_source_priority "
     "AL_SOFT_source_resampler "
-    "AL_SOFT_source_spatialize";
+    "AL_SOFT_source_spatialize "
+    "AL_SOFTX_source_start_delay "
+    "AL_SOFTX_source_state_query";
 
 std::atomic<ALCenum> LastNullDeviceError{ALC_NO_ERROR};
 
@@ -835,6 +1002,65 @@ thread_local ThreadCtx LocalContext;
 /* Process-wide current context */
 std::atomic<ALCcontext*> GlobalContext{nullptr};
 
+/* Hazard slots, one per thread that's made AL calls with a global context.
+ * Slots are reused after their thread exits, but never freed.
+ */
+std::atomic<ContextHazard*> ContextHazards{nullptr};
+
+class ThreadHazard {
+    ContextHazard *mHazard{nullptr};
+
+public:
+    ~ThreadHazard()
+    {
+        if(mHazard)
+            mHazard->InUse.store(false, std::memory_order_release);
+        mHazard = nullptr;
+    }
+
+    ContextHazard *get()
+    {
+        if(LIKELY(mHazard))
+            return mHazard;
+
+        ContextHazard *hazard{ContextHazards.load(std::memory_order_acquire)};
+        for(;hazard;hazard = hazard->Next)
+        {
+            bool inuse{false};
+            if(hazard->InUse.compare_exchange_strong(inuse, true, std::memory_order_acquire))
+                break;
+        }
+        if(!hazard)
+        {
+            hazard = new ContextHazard{};
+            hazard->Next = ContextHazards.load(std::memory_order_relaxed);
+            while(!ContextHazards.compare_exchange_weak(hazard->Next, hazard,
+                std::memory_order_acq_rel, std::memory_order_relaxed))
+            { }
+        }
+        mHazard = hazard;
+        return hazard;
+    }
+};
+thread_local ThreadHazard LocalHazard;
+
+/* Contexts released while in a hazard slot, to be deleted once they're not.
+ * The flag lets clearing a slot skip the lock when there are none.
+ */
+std::mutex RetiredContextLock;
+al::vector<ALCcontext*> RetiredContexts;
+std::atomic<bool> HaveRetiredContexts{false};
+
+bool IsContextHazard(ALCcontext *context)
+{
+    for(ContextHazard *hazard{ContextHazards.load()};hazard;hazard = hazard->Next)
+    {
+        if(hazard->Context.load() == context)
+            return true;
+    }
+    return false;
+}
+
 /* Flag to trap ALC device errors */
 bool TrapALCError{false};
 
@@ -858,7 +1084,11 @@ constexpr ALCchar alcNoDeviceExtList[] =
     "ALC_ENUMERATION_EXT "
     "ALC_EXT_CAPTURE "
     "ALC_EXT_thread_local_context "
-    "ALC_SOFT_loopback";
+    "ALC_SOFT_loopback "
+    "ALC_SOFTX_allocator_callbacks "
+    "ALC_SOFTX_kernel_info "
+    "ALC_SOFTX_loopback_batch "
+    "ALC_SOFTX_loopback_sparse";
 constexpr ALCchar alcExtensionList[] =
     "ALC_ENUMERATE_ALL_EXT "
     "ALC_ENUMERATION_EXT "
@@ -871,7 +1101,17 @@ constexpr ALCchar alcExtensionList[] =
     "ALC_SOFT_HRTF "
     "ALC_SOFT_loopback "
     "ALC_SOFT_output_limiter "
-    "ALC_SOFT_pause_device";
+    "ALC_SOFT_pause_device "
+    "ALC_SOFTX_allocator_callbacks "
+    "ALC_SOFTX_backend_telemetry "
+    "ALC_SOFTX_capture_callback "
+    "ALC_SOFTX_kernel_info "
+    "ALC_SOFTX_locked_memory "
+    "ALC_SOFTX_loopback_batch "
+    "ALC_SOFTX_loopback_planar "
+    "ALC_SOFTX_loopback_sparse "
+    "ALC_SOFTX_mixer_stats "
+    "ALC_SOFTX_output_mirror";
 constexpr ALCint alcMajorVersion = 1;
 constexpr ALCint alcMinorVersion = 1;
 
@@ -887,10 +1127,19 @@ al::vector<ALCcontext*> ContextList;
 
 std::recursive_mutex ListLock;
 
+/* Worker threads for alcRenderSamplesBatchSOFT, started on first use. */
+std::mutex BatchRenderLock;
+std::unique_ptr<MixerPool> BatchRenderPool;
+bool BatchRenderPoolInit{false};
+
 } // namespace
 
 /* Mixing thread piority level */
 ALint RTPrioLevel;
+bool RTPrioFIFO{false};
+al::vector<unsigned int> MixerCPUs;
+al::vector<unsigned int> WorkerCPUs;
+std::string MMCSSTask;
 
 FILE *gLogFile{stderr};
 #ifdef _DEBUG
@@ -920,8 +1169,53 @@ BOOL APIENTRY DllMain(HINSTANCE module, DWORD reason, LPVOID /*reserved*/)
 }
 #endif
 
+/* Parses a comma-separated list of CPU indices and ranges (e.g. "0,2,4-7"). */
+static al::vector<unsigned int> ParseCPUList(const char *list)
+{
+    al::vector<unsigned int> cpus;
+    const char *str{list};
+    while(*str)
+    {
+        char *end;
+        const unsigned long first{strtoul(str, &end, 10)};
+        unsigned long last{first};
+        if(end != str && *end == '-')
+        {
+            const char *next{end+1};
+            last = strtoul(next, &end, 10);
+            if(end == next) last = first - 1;
+        }
+        if(end == str || (*end && *end != ',') || last < first || last >= 1024)
+        {
+            ERR("Invalid CPU list: %s\n", list);
+            return al::vector<unsigned int>{};
+        }
+        for(unsigned long cpu{first};cpu <= last;++cpu)
+            cpus.emplace_back(static_cast<unsigned int>(cpu));
+        str = *end ? end+1 : end;
+    }
+    return cpus;
+}
+
+/* Times the phases of library initialization, for the TRACE log. */
+class InitTimer {
+    std::chrono::steady_clock::time_point mStart{std::chrono::steady_clock::now()};
+
+public:
+    /* Returns the milliseconds since the last call (or construction). */
+    double lap() noexcept
+    {
+        const auto now = std::chrono::steady_clock::now();
+        const std::chrono::duration<double,std::milli> dur{now - mStart};
+        mStart = now;
+        return dur.count();
+    }
+};
+
 static void alc_initconfig(void)
 {
+    InitTimer total, timer;
+
     const char *str{getenv("ALSOFT_LOGLEVEL")};
     if(str)
     {
@@ -956,7 +1250,9 @@ static void alc_initconfig(void)
         }
         TRACE("Supported backends: %s\n", names.c_str());
     }
+    timer.lap();
     ReadALConfig();
+    TRACE("Read config in %.2fms\n", timer.lap());
 
     str = getenv("__ALSOFT_SUSPEND_CONTEXT");
     if(str && *str)
@@ -980,6 +1276,15 @@ static void alc_initconfig(void)
 #elif defined(HAVE_SSE)
     capfilter |= CPU_CAP_SSE;
 #endif
+#ifdef HAVE_AVX2
+    capfilter |= CPU_CAP_AVX2 | CPU_CAP_FMA;
+#endif
+#ifdef HAVE_AVX512
+    capfilter |= CPU_CAP_AVX512F;
+#endif
+#ifdef HAVE_F16C
+    capfilter |= CPU_CAP_F16C;
+#endif
 #ifdef HAVE_NEON
     capfilter |= CPU_CAP_NEON;
 #endif
@@ -1010,6 +1315,14 @@ static void alc_initconfig(void)
                     capfilter &= ~CPU_CAP_SSE3;
                 else if(len == 6 && strncasecmp(str, "sse4.1", len) == 0)
                     capfilter &= ~CPU_CAP_SSE4_1;
+                else if(len == 4 && strncasecmp(str, "avx2", len) == 0)
+                    capfilter &= ~CPU_CAP_AVX2;
+                else if(len == 3 && strncasecmp(str, "fma", len) == 0)
+                    capfilter &= ~CPU_CAP_FMA;
+                else if(len == 7 && strncasecmp(str, "avx512f", len) == 0)
+                    capfilter &= ~CPU_CAP_AVX512F;
+                else if(len == 4 && strncasecmp(str, "f16c", len) == 0)
+                    capfilter &= ~CPU_CAP_F16C;
                 else if(len == 4 && strncasecmp(str, "neon", len) == 0)
                     capfilter &= ~CPU_CAP_NEON;
                 else
@@ -1018,6 +1331,22 @@ static void alc_initconfig(void)
         }
     }
     FillCPUCaps(capfilter);
+    TRACE("Probed CPU capabilities in %.2fms\n", timer.lap());
+
+    static constexpr struct {
+        int flag;
+        const char name[8];
+    } cpuexts[]{
+        { CPU_CAP_SSE, "sse" }, { CPU_CAP_SSE2, "sse2" }, { CPU_CAP_SSE3, "sse3" },
+        { CPU_CAP_SSE4_1, "sse4.1" }, { CPU_CAP_AVX2, "avx2" }, { CPU_CAP_FMA, "fma" },
+        { CPU_CAP_AVX512F, "avx512f" }, { CPU_CAP_F16C, "f16c" }, { CPU_CAP_NEON, "neon" }
+    };
+    for(const auto &ext : cpuexts)
+    {
+        if(!(CPUCapFlags&ext.flag)) continue;
+        if(!alcCpuExtList.empty()) alcCpuExtList += ' ';
+        alcCpuExtList += ext.name;
+    }
 
 #ifdef _WIN32
     RTPrioLevel = 1;
@@ -1025,9 +1354,25 @@ static void alc_initconfig(void)
     RTPrioLevel = 0;
 #endif
     ConfigValueInt(nullptr, nullptr, "rt-prio", &RTPrioLevel);
-
+    if(ConfigValueStr(nullptr, nullptr, "rt-policy", &str))
+    {
+        if(strcasecmp(str, "fifo") == 0)
+            RTPrioFIFO = true;
+        else if(strcasecmp(str, "rr") != 0)
+            ERR("Invalid rt-policy: %s\n", str);
+    }
+    if(ConfigValueStr(nullptr, nullptr, "mixer-cpus", &str))
+        MixerCPUs = ParseCPUList(str);
+    WorkerCPUs = MixerCPUs;
+    if(ConfigValueStr(nullptr, nullptr, "worker-cpus", &str))
+        WorkerCPUs = ParseCPUList(str);
+    if(ConfigValueStr(nullptr, nullptr, "mmcss-task", &str))
+        MMCSSTask = str;
+
+    timer.lap();
     aluInit();
     aluInitMixer();
+    TRACE("Initialized mixer in %.2fms\n", timer.lap());
 
     str = getenv("ALSOFT_TRAP_ERROR");
     if(str && (strcasecmp(str, "true") == 0 || strtol(str, nullptr, 0) == 1))
@@ -1048,10 +1393,36 @@ static void alc_initconfig(void)
         TrapALCError = !!GetConfigValueBool(nullptr, nullptr, "trap-alc-error", TrapALCError);
     }
 
+#ifdef ALSOFT_EFFECTS
     float valf{};
     if(ConfigValueFloat(nullptr, "reverb", "boost", &valf))
         ReverbBoost *= std::pow(10.0f, valf / 20.0f);
 
+    const char *qualstr{};
+    if(ConfigValueStr(nullptr, "reverb", "quality", &qualstr))
+    {
+        if(strcasecmp(qualstr, "low") == 0)
+            ReverbQuality = AL_QUALITY_LOW_SOFT;
+        else if(strcasecmp(qualstr, "high") == 0)
+            ReverbQuality = AL_QUALITY_HIGH_SOFT;
+        else
+            ERR("Unhandled reverb quality: %s\n", qualstr);
+    }
+    ReverbHalfRate = !!GetConfigValueBool(nullptr, "reverb", "half-rate", ReverbHalfRate);
+    ReverbSizedLines = !!GetConfigValueBool(nullptr, "reverb", "sized-lines", ReverbSizedLines);
+    ChorusHalfRate = !!GetConfigValueBool(nullptr, "chorus", "half-rate", ChorusHalfRate);
+
+    if(ConfigValueStr(nullptr, "pshifter", "quality", &qualstr))
+    {
+        if(strcasecmp(qualstr, "low") == 0)
+            PshifterQuality = AL_QUALITY_LOW_SOFT;
+        else if(strcasecmp(qualstr, "high") == 0)
+            PshifterQuality = AL_QUALITY_HIGH_SOFT;
+        else
+            ERR("Unhandled pitch shifter quality: %s\n", qualstr);
+    }
+#endif
+
     const char *devs{getenv("ALSOFT_DRIVERS")};
     if((devs && devs[0]) || ConfigValueStr(nullptr, nullptr, "drivers", &devs))
     {
@@ -1106,40 +1477,8 @@ static void alc_initconfig(void)
             BackendListEnd = backendlist_cur;
     }
 
-    auto init_backend = [](BackendInfo &backend) -> bool
-    {
-        if(PlaybackBackend.name && CaptureBackend.name)
-            return true;
-
-        BackendFactory &factory = backend.getFactory();
-        if(!factory.init())
-        {
-            WARN("Failed to initialize backend \"%s\"\n", backend.name);
-            return true;
-        }
-
-        TRACE("Initialized backend \"%s\"\n", backend.name);
-        if(!PlaybackBackend.name && factory.querySupport(BackendType::Playback))
-        {
-            PlaybackBackend = backend;
-            TRACE("Added \"%s\" for playback\n", PlaybackBackend.name);
-        }
-        if(!CaptureBackend.name && factory.querySupport(BackendType::Capture))
-        {
-            CaptureBackend = backend;
-            TRACE("Added \"%s\" for capture\n", CaptureBackend.name);
-        }
-        return false;
-    };
-    BackendListEnd = std::remove_if(std::begin(BackendList), BackendListEnd, init_backend);
-
     LoopbackBackendFactory::getFactory().init();
 
-    if(!PlaybackBackend.name)
-        WARN("No playback backend available!\n");
-    if(!CaptureBackend.name)
-        WARN("No capture backend available!\n");
-
     if(ConfigValueStr(nullptr, nullptr, "excludefx", &str))
     {
         const char *next = str;
@@ -1159,31 +1498,88 @@ static void alc_initconfig(void)
             }
         } while(next++);
     }
+    /* Effects that weren't built are always disabled. */
+    for(const EffectList &effect : gEffectList)
+    {
+        if(!getFactoryByType(effect.val))
+            DisabledEffects[effect.type] = AL_TRUE;
+    }
 
     InitEffect(&DefaultEffect);
     str = getenv("ALSOFT_DEFAULT_REVERB");
     if((str && str[0]) || ConfigValueStr(nullptr, nullptr, "default-reverb", &str))
         LoadReverbPreset(str, &DefaultEffect);
+
+    RecordInit();
+
+    TRACE("Library initialized in %.2fms\n", total.lap());
 }
 #define DO_INITCONFIG() std::call_once(alc_config_once, [](){alc_initconfig();})
 
+/* Initializes backends, in order, until one supporting the given type is
+ * found (if not already), and returns it. The returned info has a null name
+ * if none is available. Must be called after the config is initialized.
+ */
+static BackendInfo InitBackend(BackendType type)
+{
+    std::lock_guard<std::mutex> _{BackendInitLock};
+
+    BackendInfo &target = (type == BackendType::Playback) ? PlaybackBackend : CaptureBackend;
+    while(!target.name && BackendInitCur != BackendListEnd)
+    {
+        BackendInfo &backend = *BackendInitCur;
+        BackendFactory &factory = backend.getFactory();
+
+        InitTimer timer;
+        if(!factory.init())
+        {
+            WARN("Failed to initialize backend \"%s\" (%.2fms)\n", backend.name, timer.lap());
+            BackendListEnd = std::move(BackendInitCur+1, BackendListEnd, BackendInitCur);
+            continue;
+        }
+        TRACE("Initialized backend \"%s\" in %.2fms\n", backend.name, timer.lap());
+
+        if(!PlaybackBackend.name && factory.querySupport(BackendType::Playback))
+        {
+            PlaybackBackend = backend;
+            TRACE("Added \"%s\" for playback\n", PlaybackBackend.name);
+        }
+        if(!CaptureBackend.name && factory.querySupport(BackendType::Capture))
+        {
+            CaptureBackend = backend;
+            TRACE("Added \"%s\" for capture\n", CaptureBackend.name);
+        }
+        ++BackendInitCur;
+
+        if(BackendInitCur == BackendListEnd)
+        {
+            if(!PlaybackBackend.name)
+                WARN("No playback backend available!\n");
+            if(!CaptureBackend.name)
+                WARN("No capture backend available!\n");
+        }
+    }
+    return target;
+}
+
 
 /************************************************
  * Device enumeration
  ************************************************/
-static void ProbeDevices(std::string *list, BackendInfo *backendinfo, DevProbe type)
+static void ProbeDevices(std::string *list, BackendType btype, DevProbe type)
 {
     DO_INITCONFIG();
+    BackendInfo backendinfo{InitBackend(btype)};
 
     std::lock_guard<std::recursive_mutex> _{ListLock};
     list->clear();
-    if(backendinfo->getFactory)
-        backendinfo->getFactory().probe(type, list);
+    if(backendinfo.getFactory)
+        backendinfo.getFactory().probe(type, list);
 }
 static void ProbeAllDevicesList(void)
-{ ProbeDevices(&alcAllDevicesList, &PlaybackBackend, DevProbe::Playback); }
+{ ProbeDevices(&alcAllDevicesList, BackendType::Playback, DevProbe::Playback); }
 static void ProbeCaptureDeviceList(void)
-{ ProbeDevices(&alcCaptureDeviceList, &CaptureBackend, DevProbe::Capture); }
+{ ProbeDevices(&alcCaptureDeviceList, BackendType::Capture, DevProbe::Capture); }
 
 
 /************************************************
@@ -1504,27 +1900,59 @@ void ALCcontext_ProcessUpdates(ALCcontext *context)
     std::lock_guard<std::mutex> _{context->PropLock};
     if(context->DeferUpdates.exchange(false))
     {
-        /* Tell the mixer to stop applying updates, then wait for any active
-         * updating to finish, before providing updates.
+        /* Publish the updates in a new batch, which the mixer leaves pending
+         * until it's committed.
          */
-        context->HoldUpdates.store(true, std::memory_order_release);
-        while((context->UpdateCount.load(std::memory_order_acquire)&1) != 0)
-            std::this_thread::yield();
+        const ALuint batch{context->CommittedBatch.load(std::memory_order_relaxed) + 1u};
+        context->PublishBatch.store(batch, std::memory_order_relaxed);
 
         if(!context->PropsClean.test_and_set(std::memory_order_acq_rel))
             UpdateContextProps(context);
-        if(!context->Listener.PropsClean.test_and_set(std::memory_order_acq_rel))
-            UpdateListenerProps(context);
+        auto update_listener = [context](ALlistener &listener) -> void
+        {
+            if(!listener.PropsClean.test_and_set(std::memory_order_acq_rel))
+                UpdateListenerProps(context, listener);
+        };
+        update_listener(context->Listener);
+        std::for_each(context->ExtraListeners.begin(), context->ExtraListeners.end(),
+            update_listener);
         UpdateAllEffectSlotProps(context);
         UpdateAllSourceProps(context);
 
-        /* Now with all updates declared, let the mixer continue applying them
-         * so they all happen at once.
+        UpdateAllSourceGroupProps(context);
+
+        /* Now with all updates declared, let the mixer apply them so they all
+         * happen at once.
          */
-        context->HoldUpdates.store(false, std::memory_order_release);
+        context->CommittedBatch.store(batch, std::memory_order_release);
     }
 }
 
+/* RetireObject
+ *
+ * Frees the object once the mixer's done with it, and any others retired
+ * earlier that it's done with. An object retired outside of a mix, or during
+ * a mix that's since finished, can't still be in use since it was replaced
+ * before retiring.
+ */
+void RetireObject(ALCcontext *context, void *ptr, void (*freefunc)(void*))
+{
+    ALCdevice *device{context->Device};
+    std::lock_guard<std::mutex> _{context->RetiredLock};
+
+    const ALuint mixcount{device->MixCount.load(std::memory_order_acquire)};
+    context->RetiredObjects.emplace_back(RetiredObject{ptr, freefunc, mixcount});
+
+    /* Keep the ones that may still be in use in front, freeing the rest. */
+    auto retired_end = std::partition(context->RetiredObjects.begin(),
+        context->RetiredObjects.end(),
+        [mixcount](const RetiredObject &obj) noexcept -> bool
+        { return (obj.MixCount&1) && obj.MixCount == mixcount; });
+    std::for_each(retired_end, context->RetiredObjects.end(),
+        [](const RetiredObject &obj) -> void { obj.Free(obj.Ptr); });
+    context->RetiredObjects.erase(retired_end, context->RetiredObjects.end());
+}
+
 
 /* alcSetError
  *
@@ -1555,11 +1983,72 @@ static void alcSetError(ALCdevice *device, ALCenum errorCode)
 
 static std::unique_ptr<Compressor> CreateDeviceLimiter(const ALCdevice *device, const ALfloat threshold)
 {
-    return CompressorInit(device->RealOut.NumChannels, device->Frequency,
+    return CompressorInit(device->RealOut.NumChannels, device->MixFrequency,
         AL_TRUE, AL_TRUE, AL_TRUE, AL_TRUE, AL_TRUE, 0.001f, 0.002f,
         0.0f, 0.0f, threshold, INFINITY, 0.0f, 0.020f, 0.200f);
 }
 
+/* UpdateContextMixParams
+ *
+ * Sets up the mixing targets for the context's voices and effects, which
+ * reference the device's mixing buffers.
+ */
+static void UpdateContextMixParams(ALCcontext *context, const ALCdevice *device)
+{
+    context->Dry = device->Dry;
+    context->RealOut = device->RealOut;
+    context->Clusters.resize((device->ClusterAngle > 0.0f) ? MAX_VOICE_CLUSTERS : 0);
+    context->NumClusters = 0;
+
+    /* Panning in world space needs a full 3D ambisonic mix to rotate. It's
+     * applied to the context's mix on the mixer thread, so it isn't used when
+     * the device mixes in parallel.
+     */
+    context->World = MixParams{};
+    context->WorldTouched = 0u;
+    context->WorldRotator = nullptr;
+    if(device->WorldPanning && !device->MixThreads && device->mRenderMode != HrtfRender
+        && device->mRenderMode != StereoPair)
+    {
+        auto rotator = al::make_unique<AmbiRotator>();
+        if(!rotator->init(device->Dry, device->mAmbiOrder))
+            WARN("World-space panning unavailable without a full 3D ambisonic mix\n");
+        else
+        {
+            rotator->setListener(context->Listener.Params.Matrix, ZScale, false);
+            context->WorldBuffer.resize(static_cast<size_t>(device->Dry.NumChannels));
+            context->World = device->Dry;
+            context->World.Buffer = &reinterpret_cast<ALfloat(&)[BUFFERSIZE]>(
+                context->WorldBuffer[0]);
+            context->World.Touched = &context->WorldTouched;
+            context->WorldRotator = std::move(rotator);
+        }
+    }
+    if(!context->WorldRotator)
+    {
+        context->WorldBuffer.clear();
+        context->WorldBuffer.shrink_to_fit();
+    }
+
+    if(!device->MixThreads)
+    {
+        context->Scratch = nullptr;
+        context->VoiceThreads.clear();
+        return;
+    }
+
+    if(!context->Scratch)
+        context->Scratch = std::unique_ptr<MixerScratch>{new MixerScratch{}};
+
+    context->VoiceThreads.resize(device->MixThreads->threadCount());
+    for(auto &thrd : context->VoiceThreads)
+    {
+        if(thrd) continue;
+        thrd = std::unique_ptr<VoiceMixThread>{new VoiceMixThread{}};
+        thrd->Log.resize(VOICE_LOG_COMMANDS, VOICE_LOG_SAMPLES);
+    }
+}
+
 /* UpdateClockBase
  *
  * Updates the device's base clock time with however many samples have been
@@ -1570,64 +2059,213 @@ static std::unique_ptr<Compressor> CreateDeviceLimiter(const ALCdevice *device,
 static inline void UpdateClockBase(ALCdevice *device)
 {
     IncrementRef(&device->MixCount);
-    device->ClockBase += nanoseconds{seconds{device->SamplesDone}} / device->Frequency;
+    device->ClockBase += nanoseconds{seconds{device->SamplesDone}} / device->MixFrequency;
     device->SamplesDone = 0;
     IncrementRef(&device->MixCount);
 }
 
+static DevFmtRequest GetDevFmtRequest(const ALCdevice *device)
+{
+    DevFmtRequest req{};
+    req.Frequency = device->Frequency;
+    req.UpdateSize = device->UpdateSize;
+    req.BufferSize = device->BufferSize;
+    req.FmtChans = device->FmtChans;
+    req.FmtType = device->FmtType;
+    req.Flags = device->Flags & (DEVICE_FREQUENCY_REQUEST|DEVICE_CHANNELS_REQUEST|
+        DEVICE_SAMPLE_TYPE_REQUEST);
+    return req;
+}
+
+static void SetDevFmtRequest(ALCdevice *device, const DevFmtRequest &req)
+{
+    device->Frequency = req.Frequency;
+    device->UpdateSize = req.UpdateSize;
+    device->BufferSize = req.BufferSize;
+    device->FmtChans = req.FmtChans;
+    device->FmtType = req.FmtType;
+    device->Flags = (device->Flags&~(DEVICE_FREQUENCY_REQUEST|DEVICE_CHANNELS_REQUEST|
+        DEVICE_SAMPLE_TYPE_REQUEST)) | req.Flags;
+}
+
+static bool SameDevFmt(const DevFmtRequest &lhs, const DevFmtRequest &rhs)
+{
+    return lhs.Frequency == rhs.Frequency && lhs.UpdateSize == rhs.UpdateSize &&
+        lhs.BufferSize == rhs.BufferSize && lhs.FmtChans == rhs.FmtChans &&
+        lhs.FmtType == rhs.FmtType;
+}
+
+/* Prepares a device to be reset. A running playback device has its output
+ * faded out and is held with the backend lock, which keeps the mixer waiting
+ * at an update boundary without stopping the backend. That lets the reset
+ * keep it running if its output format doesn't change. Anything else is
+ * stopped.
+ */
+static std::unique_lock<BackendBase> HoldDeviceForReset(ALCdevice *device)
+{
+    std::unique_lock<BackendBase> mixlock;
+    if(!(device->Flags&DEVICE_RUNNING))
+        return mixlock;
+
+    if(device->Type == Playback && device->Connected.load(std::memory_order_acquire) &&
+        GetConfigValueBool(device->DeviceName.c_str(), nullptr, "seamless-reset", 1))
+    {
+        /* Give the mixer about two buffers' worth of time to fade out. If it
+         * doesn't get to it, the output is cut off instead.
+         */
+        device->OutputFadeState.store(OutputFadeOut, std::memory_order_release);
+        const auto timeout = std::chrono::steady_clock::now() + std::chrono::milliseconds{10} +
+            nanoseconds{seconds{device->BufferSize*2}} / device->Frequency;
+        while(device->OutputFadeState.load(std::memory_order_acquire) != OutputFadeSilent &&
+            std::chrono::steady_clock::now() < timeout)
+            std::this_thread::sleep_for(std::chrono::milliseconds{1});
+
+        mixlock = std::unique_lock<BackendBase>{*device->Backend};
+        return mixlock;
+    }
+
+    device->Backend->stop();
+    device->Flags &= ~DEVICE_RUNNING;
+    return mixlock;
+}
+
+/* References to HRTFs loaded ahead of a reset. */
+struct HrtfPreload {
+    al::vector<HrtfEntry*> Hrtfs;
+
+    ~HrtfPreload()
+    {
+        for(HrtfEntry *hrtf : Hrtfs)
+            hrtf->DecRef();
+    }
+};
+
+/* Loads the HRTF a reset of a running device will use, before the device is
+ * held for it. Loading reads the data set, and may resample or convert it,
+ * which the held mixer shouldn't wait on. The reset then finds it already
+ * loaded. This follows the choices UpdateDeviceParams and aluInitRenderer
+ * make, for the rates they load at.
+ */
+static void PreloadHrtfs(ALCdevice *device, HrtfRequestMode hrtf_appreq, ALCsizei hrtf_id,
+    HrtfPreload *preload)
+{
+    if(!(device->Flags&DEVICE_RUNNING))
+        return;
+
+    const char *devname{device->DeviceName.c_str()};
+    HrtfRequestMode hrtf_userreq{Hrtf_Default};
+    if(device->Type != Loopback)
+    {
+        const char *hrtf;
+        if(ConfigValueStr(devname, nullptr, "hrtf", &hrtf))
+        {
+            if(strcasecmp(hrtf, "true") == 0)
+                hrtf_userreq = Hrtf_Enable;
+            else if(strcasecmp(hrtf, "false") == 0)
+                hrtf_userreq = Hrtf_Disable;
+        }
+    }
+
+    /* An HRTF is requested with a format change to its own rate. Otherwise,
+     * one may be used at the mixing rate if the device has one now (e.g. for
+     * headphones).
+     */
+    const bool requested{hrtf_userreq == Hrtf_Enable ||
+        (hrtf_userreq != Hrtf_Disable && hrtf_appreq == Hrtf_Enable)};
+    if(!requested && (hrtf_userreq == Hrtf_Disable || hrtf_appreq == Hrtf_Disable ||
+        !device->mHrtf))
+        return;
+
+    /* With hrtf-async, a reset only uses HRTFs that are already loaded. */
+    if(device->Type == Playback && !device->mHrtfLoadSync &&
+        GetConfigValueBool(devname, nullptr, "hrtf-async", 0))
+        return;
+
+    if(device->HrtfList.empty())
+        device->HrtfList = EnumerateHrtf(devname);
+    const al::vector<EnumeratedHrtf> &list = device->HrtfList;
+
+    auto preload_hrtf = [preload,&list,hrtf_id](const ALuint rate) -> void
+    {
+        HrtfEntry *hrtf{nullptr};
+        if(hrtf_id >= 0 && static_cast<size_t>(hrtf_id) < list.size())
+            hrtf = GetLoadedHrtf(list[hrtf_id].hrtf, rate);
+        for(auto iter = list.cbegin();!hrtf && iter != list.cend();++iter)
+            hrtf = GetLoadedHrtf(iter->hrtf, rate);
+        if(hrtf) preload->Hrtfs.emplace_back(hrtf);
+    };
+    if(requested)
+        preload_hrtf(0);
+    preload_hrtf(device->MixFrequency);
+}
+
+/* Stops a device held by HoldDeviceForReset, once its reset needs to. */
+static void StopHeldDevice(ALCdevice *device, std::unique_lock<BackendBase> &mixlock)
+{
+    mixlock.unlock();
+    device->Backend->stop();
+    device->Flags &= ~DEVICE_RUNNING;
+    device->OutputFadeState.store(OutputFadeNone, std::memory_order_relaxed);
+}
+
+static void StartHrtfLoader(ALCdevice *device, const ALCint *attrList, ALCsizei hrtf_id,
+    ALuint rate);
+
 /* UpdateDeviceParams
  *
  * Updates device parameters according to the attribute list (caller is
- * responsible for holding the list lock).
+ * responsible for holding the list lock). Without attributes, a running
+ * device is only updated if forced.
  */
-static ALCenum UpdateDeviceParams(ALCdevice *device, const ALCint *attrList)
+static ALCenum UpdateDeviceParams(ALCdevice *device, const ALCint *attrList, bool force=false)
 {
+    al::ArenaScope arena_scope{device->mArena};
     HrtfRequestMode hrtf_userreq = Hrtf_Default;
     HrtfRequestMode hrtf_appreq = Hrtf_Default;
     ALCenum gainLimiter = device->LimiterState;
+    ALCenum mixerStats = ALC_DONT_CARE_SOFT;
     const ALsizei old_sends = device->NumAuxSends;
     ALsizei new_sends = device->NumAuxSends;
     DevFmtChannels oldChans;
     DevFmtType oldType;
     ALboolean update_failed;
     ALCsizei hrtf_id = -1;
+    bool hrtf_native = false;
     ALCcontext *context;
     ALCuint oldFreq;
     int val;
 
+    /* HRTFs loaded before the device is held, released after the mixer lock. */
+    HrtfPreload preloaded;
+    /* Held while a running device is reset without stopping, keeping its
+     * mixer waiting until the new state is in place.
+     */
+    std::unique_lock<BackendBase> mixlock;
+    DevFmtRequest runfmt{};
+
     if((!attrList || !attrList[0]) && device->Type == Loopback)
     {
         WARN("Missing attributes for loopback device\n");
         return ALC_INVALID_VALUE;
     }
 
+    const bool hasattrs{attrList && attrList[0]};
+    const bool loopback{device->Type == Loopback};
+    const char *devname{loopback ? nullptr : device->DeviceName.c_str()};
+    ALCenum alayout = AL_NONE;
+    ALCenum ascale = AL_NONE;
+    ALCenum schans = AL_NONE;
+    ALCenum stype = AL_NONE;
+    ALCsizei aorder = 0;
+    ALCuint freq = 0;
+    auto numMono = static_cast<ALsizei>(device->NumMonoSources);
+    auto numStereo = static_cast<ALsizei>(device->NumStereoSources);
+    auto numSends = ALsizei{old_sends};
+
     // Check for attributes
-    if(attrList && attrList[0])
+    if(hasattrs)
     {
-        ALCenum alayout = AL_NONE;
-        ALCenum ascale = AL_NONE;
-        ALCenum schans = AL_NONE;
-        ALCenum stype = AL_NONE;
         ALCsizei attrIdx = 0;
-        ALCsizei aorder = 0;
-        ALCuint freq = 0;
-
-        const char *devname{nullptr};
-        const bool loopback{device->Type == Loopback};
-        if(!loopback)
-        {
-            devname = device->DeviceName.c_str();
-            /* If a context is already running on the device, stop playback so
-             * the device attributes can be updated.
-             */
-            if((device->Flags&DEVICE_RUNNING))
-                device->Backend->stop();
-            device->Flags &= ~DEVICE_RUNNING;
-        }
-
-        auto numMono = static_cast<ALsizei>(device->NumMonoSources);
-        auto numStereo = static_cast<ALsizei>(device->NumStereoSources);
-        auto numSends = ALsizei{old_sends};
 
 #define TRACE_ATTR(a, v) TRACE("%s = %d\n", #a, v)
         while(attrList[attrIdx])
@@ -1702,6 +2340,11 @@ static ALCenum UpdateDeviceParams(ALCdevice *device, const ALCint *attrList)
                 TRACE_ATTR(ALC_OUTPUT_LIMITER_SOFT, gainLimiter);
                 break;
 
+            case ALC_MIXER_STATS_SOFT:
+                mixerStats = attrList[attrIdx + 1];
+                TRACE_ATTR(ALC_MIXER_STATS_SOFT, mixerStats);
+                break;
+
             default:
                 TRACE("0x%04X = %d (0x%x)\n", attrList[attrIdx],
                     attrList[attrIdx + 1], attrList[attrIdx + 1]);
@@ -1736,10 +2379,27 @@ static ALCenum UpdateDeviceParams(ALCdevice *device, const ALCint *attrList)
                     return ALC_INVALID_VALUE;
             }
         }
+    }
 
-        if((device->Flags&DEVICE_RUNNING))
-            device->Backend->stop();
-        device->Flags &= ~DEVICE_RUNNING;
+    /* If a context is already running on the device, hold or stop playback so
+     * the device can be updated. Any HRTF the reset will use is loaded first,
+     * since that can take a while.
+     */
+    if(force || (hasattrs && !loopback))
+    {
+        PreloadHrtfs(device, hrtf_appreq, hrtf_id, &preloaded);
+        mixlock = HoldDeviceForReset(device);
+        runfmt = GetDevFmtRequest(device);
+    }
+
+    if(hasattrs)
+    {
+        if(!mixlock)
+        {
+            if((device->Flags&DEVICE_RUNNING))
+                device->Backend->stop();
+            device->Flags &= ~DEVICE_RUNNING;
+        }
 
         UpdateClockBase(device);
 
@@ -1810,31 +2470,16 @@ static ALCenum UpdateDeviceParams(ALCdevice *device, const ALCint *attrList)
             new_sends = numSends;
     }
 
-    if((device->Flags&DEVICE_RUNNING))
+    if((device->Flags&DEVICE_RUNNING) && !mixlock)
         return ALC_NO_ERROR;
 
-    device->Uhj_Encoder = nullptr;
-    device->Bs2b = nullptr;
-
-    device->Limiter = nullptr;
-    device->ChannelDelay.clear();
-    device->ChannelDelay.shrink_to_fit();
-
-    device->Dry.Buffer = nullptr;
-    device->Dry.NumChannels = 0;
-    device->RealOut.Buffer = nullptr;
-    device->RealOut.NumChannels = 0;
-    device->MixBuffer.clear();
-    device->MixBuffer.shrink_to_fit();
-
-    UpdateClockBase(device);
-    device->FixedLatency = nanoseconds::zero();
-
-    device->DitherSeed = DITHER_RNG_SEED;
-
     /*************************************************************************
      * Update device format request if HRTF is requested
      */
+    /* The requested HRTF replaces the device's once the mixer is stopped or
+     * held.
+     */
+    HrtfEntry *newhrtf{nullptr};
     device->HrtfStatus = ALC_HRTF_DISABLED_SOFT;
     if(device->Type != Loopback)
     {
@@ -1851,15 +2496,22 @@ static ALCenum UpdateDeviceParams(ALCdevice *device, const ALCint *attrList)
 
         if(hrtf_userreq == Hrtf_Enable || (hrtf_userreq != Hrtf_Disable && hrtf_appreq == Hrtf_Enable))
         {
+            /* With hrtf-async, the HRTF's rate is only used once it's loaded
+             * in the background.
+             */
+            const bool async{device->Type == Playback && !device->mHrtfLoadSync &&
+                GetConfigValueBool(device->DeviceName.c_str(), nullptr, "hrtf-async", 0)};
+            auto get_hrtf = async ? FindLoadedHrtf : GetLoadedHrtf;
+
             HrtfEntry *hrtf{nullptr};
-            if(device->HrtfList.empty())
+            if(device->HrtfList.empty() && !async)
                 device->HrtfList = EnumerateHrtf(device->DeviceName.c_str());
             if(!device->HrtfList.empty())
             {
                 if(hrtf_id >= 0 && static_cast<size_t>(hrtf_id) < device->HrtfList.size())
-                    hrtf = GetLoadedHrtf(device->HrtfList[hrtf_id].hrtf);
+                    hrtf = get_hrtf(device->HrtfList[hrtf_id].hrtf, 0);
                 else
-                    hrtf = GetLoadedHrtf(device->HrtfList.front().hrtf);
+                    hrtf = get_hrtf(device->HrtfList.front().hrtf, 0);
             }
 
             if(hrtf)
@@ -1867,9 +2519,13 @@ static ALCenum UpdateDeviceParams(ALCdevice *device, const ALCint *attrList)
                 device->FmtChans = DevFmtStereo;
                 device->Frequency = hrtf->sampleRate;
                 device->Flags |= DEVICE_CHANNELS_REQUEST | DEVICE_FREQUENCY_REQUEST;
-                if(HrtfEntry *oldhrtf{device->mHrtf})
-                    oldhrtf->DecRef();
-                device->mHrtf = hrtf;
+                newhrtf = hrtf;
+            }
+            else if(async)
+            {
+                device->FmtChans = DevFmtStereo;
+                device->Flags |= DEVICE_CHANNELS_REQUEST;
+                hrtf_native = true;
             }
             else
             {
@@ -1890,31 +2546,125 @@ static ALCenum UpdateDeviceParams(ALCdevice *device, const ALCint *attrList)
         (device->Flags&DEVICE_FREQUENCY_REQUEST)?"*":"", device->Frequency,
         device->UpdateSize, device->BufferSize);
 
-    try {
-        if(device->Backend->reset() == ALC_FALSE)
-            return ALC_INVALID_DEVICE;
+    /* A held device keeps running if it's already playing what's asked for,
+     * or the backend was last asked for the same. Otherwise it has to stop
+     * and be reset. Either way, the running format is put back while the
+     * mixer may still use it.
+     */
+    const DevFmtRequest request{GetDevFmtRequest(device)};
+    if(mixlock)
+    {
+        if(SameDevFmt(request, runfmt) || (SameDevFmt(request, device->LastRequest) &&
+            request.Flags == device->LastRequest.Flags))
+        {
+            TRACE("Keeping the running output format\n");
+            runfmt.Flags = request.Flags;
+            SetDevFmtRequest(device, runfmt);
+        }
+        else
+        {
+            SetDevFmtRequest(device, runfmt);
+            StopHeldDevice(device, mixlock);
+            SetDevFmtRequest(device, request);
+        }
     }
-    catch(std::exception &e) {
-        ERR("Device reset failed: %s\n", e.what());
-        return ALC_INVALID_DEVICE;
+
+    if(newhrtf)
+    {
+        if(HrtfEntry *oldhrtf{device->mHrtf})
+            oldhrtf->DecRef();
+        device->mHrtf = newhrtf;
     }
 
-    if(device->FmtChans != oldChans && (device->Flags&DEVICE_CHANNELS_REQUEST))
+#ifdef ALSOFT_UHJ
+    device->Uhj_Encoder = nullptr;
+#endif
+#ifdef ALSOFT_BS2B
+    device->Bs2b = nullptr;
+#endif
+
+    device->Limiter = nullptr;
+    device->ChannelDelay.clear();
+    device->ChannelDelay.shrink_to_fit();
+
+    device->Dry.Buffer = nullptr;
+    device->Dry.NumChannels = 0;
+    device->Dry.Touched = nullptr;
+    device->RealOut.Buffer = nullptr;
+    device->RealOut.NumChannels = 0;
+    device->MixBuffer.clear();
+    device->MixBuffer.shrink_to_fit();
+
+    /* Set where the device's large buffers go before they're reallocated. */
+    const bool hugepages{GetConfigValueBool(device->DeviceName.c_str(), nullptr, "hugepages",
+        0) != 0};
+    int numanode{-1};
+    const char *nodestr;
+    if(ConfigValueStr(device->DeviceName.c_str(), nullptr, "numa-node", &nodestr) && *nodestr)
     {
-        ERR("Failed to set %s, got %s instead\n", DevFmtChannelsString(oldChans),
-            DevFmtChannelsString(device->FmtChans));
-        device->Flags &= ~DEVICE_CHANNELS_REQUEST;
+        if(strcasecmp(nodestr, "auto") == 0)
+            numanode = al::GetCurrentNumaNode();
+        else
+            numanode = maxi(static_cast<int>(strtol(nodestr, nullptr, 0)), -1);
     }
-    if(device->FmtType != oldType && (device->Flags&DEVICE_SAMPLE_TYPE_REQUEST))
+    if(!al::SetArenaLargePolicy(device->mArena, hugepages, numanode))
+        WARN("Huge pages and NUMA node placement are not supported\n");
+    else if(hugepages || numanode >= 0)
+        TRACE("Large buffers using %s, NUMA node %d\n", hugepages ? "huge pages" : "normal pages",
+            numanode);
+
+    /* Lock what the mixer uses into memory, so touching it for the first time
+     * while mixing can't cause a page fault.
+     */
+    bool lockmem{GetConfigValueBool(device->DeviceName.c_str(), nullptr, "lock-memory", 0) != 0};
+    if(!al::SetArenaLocked(device->mArena, lockmem))
+    {
+        WARN("Memory locking is not supported\n");
+        lockmem = false;
+    }
+
+    UpdateClockBase(device);
+    device->FixedLatency = nanoseconds::zero();
+
+    /* Seed each dither lane from the base seed, with the LCG from opusdec.
+     * Xorshift generators need a non-zero state.
+     */
+    ALuint dither_seed{DITHER_RNG_SEED};
+    for(ALuint &seed : device->DitherSeeds)
     {
-        ERR("Failed to set %s, got %s instead\n", DevFmtTypeString(oldType),
-            DevFmtTypeString(device->FmtType));
-        device->Flags &= ~DEVICE_SAMPLE_TYPE_REQUEST;
+        dither_seed = dither_seed*96314165 + 907633515;
+        seed = dither_seed ? dither_seed : 1u;
     }
-    if(device->Frequency != oldFreq && (device->Flags&DEVICE_FREQUENCY_REQUEST))
+
+    if(!mixlock)
     {
-        ERR("Failed to set %uhz, got %uhz instead\n", oldFreq, device->Frequency);
-        device->Flags &= ~DEVICE_FREQUENCY_REQUEST;
+        try {
+            if(device->Backend->reset() == ALC_FALSE)
+                return ALC_INVALID_DEVICE;
+        }
+        catch(std::exception &e) {
+            ERR("Device reset failed: %s\n", e.what());
+            return ALC_INVALID_DEVICE;
+        }
+        device->LastRequest = request;
+
+        if(device->FmtChans != oldChans && (device->Flags&DEVICE_CHANNELS_REQUEST))
+        {
+            ERR("Failed to set %s, got %s instead\n", DevFmtChannelsString(oldChans),
+                DevFmtChannelsString(device->FmtChans));
+            device->Flags &= ~DEVICE_CHANNELS_REQUEST;
+        }
+        if(device->FmtType != oldType && (device->Flags&DEVICE_SAMPLE_TYPE_REQUEST))
+        {
+            ERR("Failed to set %s, got %s instead\n", DevFmtTypeString(oldType),
+                DevFmtTypeString(device->FmtType));
+            device->Flags &= ~DEVICE_SAMPLE_TYPE_REQUEST;
+        }
+        if(device->Frequency != oldFreq && (device->Flags&DEVICE_FREQUENCY_REQUEST))
+        {
+            ERR("Failed to set %uhz, got %uhz instead\n", oldFreq, device->Frequency);
+            device->Flags &= ~DEVICE_FREQUENCY_REQUEST;
+        }
     }
 
     if((device->UpdateSize&3) != 0)
@@ -1929,6 +2679,23 @@ static ALCenum UpdateDeviceParams(ALCdevice *device, const ALCint *attrList)
         DevFmtChannelsString(device->FmtChans), DevFmtTypeString(device->FmtType),
         device->Frequency, device->UpdateSize, device->BufferSize);
 
+    /* Voices and effects may be mixed at a lower rate than the output, with
+     * the mix upsampled to the output rate as it's written.
+     */
+    device->MixFrequency = device->Frequency;
+    if(device->Type == Playback)
+    {
+        ALuint mixfreq{0u};
+        ConfigValueUInt(device->DeviceName.c_str(), nullptr, "mix-rate", &mixfreq);
+        if(mixfreq > 0u)
+        {
+            mixfreq = clampu(mixfreq, MIN_OUTPUT_RATE, device->Frequency);
+            if(mixfreq != device->Frequency)
+                TRACE("Mixing at %uhz\n", mixfreq);
+            device->MixFrequency = mixfreq;
+        }
+    }
+
     aluInitRenderer(device, hrtf_id, hrtf_appreq, hrtf_userreq);
     TRACE("Channel config, Main: %d, Real: %d\n", device->Dry.NumChannels,
         device->RealOut.NumChannels);
@@ -1941,14 +2708,126 @@ static ALCenum UpdateDeviceParams(ALCdevice *device, const ALCint *attrList)
     device->MixBuffer.resize(num_chans);
 
     device->Dry.Buffer = &reinterpret_cast<ALfloat(&)[BUFFERSIZE]>(device->MixBuffer[0]);
+    device->DryTouched = 0u;
     if(device->RealOut.NumChannels != 0)
+    {
+        /* The post-process always writes all of the real output, so only a
+         * separate dry mix tracks which channels get written.
+         */
         device->RealOut.Buffer = device->Dry.Buffer + device->Dry.NumChannels;
+        device->Dry.Touched = &device->DryTouched;
+    }
     else
     {
         device->RealOut.Buffer = device->Dry.Buffer;
         device->RealOut.NumChannels = device->Dry.NumChannels;
     }
 
+    /* Start worker threads to mix contexts in parallel, if requested. The
+     * mixer thread processes contexts too, so it counts as one of them.
+     */
+    ALint mixthreads{1};
+    ConfigValueInt(device->DeviceName.c_str(), nullptr, "mix-threads", &mixthreads);
+    mixthreads = clampi(mixthreads, 1, MAX_MIX_THREADS);
+    ALint spinus{DEFAULT_MIX_THREAD_SPIN};
+    ConfigValueInt(device->DeviceName.c_str(), nullptr, "mix-thread-spin", &spinus);
+    const std::chrono::microseconds spintime{clampi(spinus, 0, 1000)};
+    ThreadGroup *thrdgroup{device->Backend->getThreadGroup()};
+    if(mixthreads < 2)
+        device->MixThreads = nullptr;
+    else if(!device->MixThreads ||
+        device->MixThreads->threadCount() != static_cast<size_t>(mixthreads) ||
+        device->MixThreads->spinTime() != spintime ||
+        device->MixThreads->threadGroup() != thrdgroup)
+    {
+        device->MixThreads = nullptr;
+        try {
+            device->MixThreads = std::unique_ptr<MixerPool>{
+                new MixerPool{static_cast<size_t>(mixthreads-1), spintime, thrdgroup}};
+        }
+        catch(std::exception &e) {
+            ERR("Failed to start mixer threads: %s\n", e.what());
+        }
+    }
+    if(device->MixThreads)
+        TRACE("Mixing contexts with %zu threads\n", device->MixThreads->threadCount());
+
+    /* Lower quantums keep the mixing buffers' working set smaller, at the
+     * cost of more per-iteration overhead. Some mixers prefer a multiple of
+     * 4.
+     */
+    ALint quantum{BUFFERSIZE};
+    ConfigValueInt(device->DeviceName.c_str(), nullptr, "mix-quantum", &quantum);
+    device->MixQuantum = clampi(quantum, MIN_MIX_QUANTUM, BUFFERSIZE) & ~3;
+    if(device->MixQuantum != quantum)
+        WARN("Mix quantum %d adjusted to %d\n", quantum, device->MixQuantum);
+    TRACE("Mix quantum: %d samples\n", device->MixQuantum);
+
+    ALint budget{0};
+    ConfigValueInt(device->DeviceName.c_str(), nullptr, "max-mixed-voices", &budget);
+    device->VoiceBudget = maxi(budget, 0);
+    if(device->VoiceBudget > 0)
+        TRACE("Mixing up to %d voices per context\n", device->VoiceBudget);
+
+    ALfloat clusterdeg{0.0f};
+    ConfigValueFloat(device->DeviceName.c_str(), nullptr, "voice-clustering", &clusterdeg);
+    if(!(clusterdeg > 0.0f))
+        device->ClusterAngle = 0.0f;
+    else
+    {
+        clusterdeg = clampf(clusterdeg, 1.0f, 90.0f);
+        device->ClusterAngle = Deg2Rad(clusterdeg);
+        TRACE("Clustering voices within %.1f degrees\n", clusterdeg);
+    }
+
+    device->WorldPanning = GetConfigValueBool(device->DeviceName.c_str(), nullptr,
+        "world-panning", 0);
+
+    ALint ramplen{0};
+    ConfigValueInt(device->DeviceName.c_str(), nullptr, "gain-ramp-length", &ramplen);
+    if(ramplen <= 0)
+        device->GainRampLength = 0;
+    else
+    {
+        device->GainRampLength = clampi(ramplen, 16, BUFFERSIZE);
+        TRACE("Fading voice gains over %d samples\n", device->GainRampLength);
+    }
+
+    ALfloat lodlevel{0.0f};
+    ConfigValueFloat(device->DeviceName.c_str(), nullptr, "voice-lod-threshold", &lodlevel);
+    if(!(lodlevel < 0.0f))
+        device->VoiceLodGain = 0.0f;
+    else
+    {
+        device->VoiceLodGain = std::pow(10.0f, maxf(lodlevel, -120.0f) / 20.0f);
+        TRACE("Lowering quality of voices below %.1fdB\n", lodlevel);
+    }
+
+    ALuint idlems{0u};
+    ConfigValueUInt(device->DeviceName.c_str(), nullptr, "idle-timeout", &idlems);
+    device->IdleTimeout = static_cast<ALuint>(minu64(
+        uint64_t{idlems} * device->MixFrequency / 1000u, std::numeric_limits<ALuint>::max()));
+    device->SilentSamples = 0u;
+    device->IdleOutput = false;
+    if(device->IdleTimeout > 0)
+        TRACE("Idling after %ums of silence\n", idlems);
+
+    ALfloat fxbudget{0.0f};
+    ConfigValueFloat(device->DeviceName.c_str(), nullptr, "effects-budget", &fxbudget);
+    device->EffectsBudget = clampf(fxbudget, 0.0f, 1.0f);
+    if(device->EffectsBudget > 0.0f)
+        TRACE("Effects budget: %.0f%% of each quantum\n", device->EffectsBudget*100.0f);
+
+    ALint cachesize{16384};
+    ConfigValueInt(device->DeviceName.c_str(), nullptr, "resample-cache-size", &cachesize);
+    device->ResampleCacheLimit = static_cast<size_t>(maxi(cachesize, 0)) * 1024u;
+    device->ResampleCacheAll = GetConfigValueBool(device->DeviceName.c_str(), nullptr,
+        "resample-cache", 0);
+    if(device->ResampleCacheAll && device->ResampleCacheLimit > 0)
+        TRACE("Caching resampled buffers, up to %zu KiB\n", device->ResampleCacheLimit/1024u);
+    device->LoopPadding = GetConfigValueBool(device->DeviceName.c_str(), nullptr, "loop-padding",
+        0);
+
     device->NumAuxSends = new_sends;
     TRACE("Max sources: %d (%d + %d), effect slots: %d, sends: %d\n",
           device->SourcesMax, device->NumMonoSources, device->NumStereoSources,
@@ -1990,6 +2869,24 @@ static ALCenum UpdateDeviceParams(ALCdevice *device, const ALCint *attrList)
         TRACE("Dithering enabled (%d-bit, %g)\n", float2int(std::log2(device->DitherDepth)+0.5f)+1,
               device->DitherDepth);
 
+    /* Without the app asking, the mixer stats' times are measured if the
+     * config says so.
+     */
+    if(mixerStats == ALC_DONT_CARE_SOFT)
+        device->MixerStatsEnabled = !!GetConfigValueBool(device->DeviceName.c_str(), nullptr,
+            "mixer-stats", 0);
+    else
+        device->MixerStatsEnabled = (mixerStats == ALC_TRUE);
+    if(device->MixerStatsEnabled)
+        TRACE("Mixer stats enabled\n");
+
+    ALfloat perfthreshold{0.8f};
+    ConfigValueFloat(device->DeviceName.c_str(), nullptr, "perf-event-threshold", &perfthreshold);
+    device->PerfEventThreshold = maxf(perfthreshold, 0.0f);
+    if(device->PerfEventThreshold > 0.0f)
+        TRACE("Performance events for updates over %.0f%% of their period\n",
+            device->PerfEventThreshold*100.0f);
+
     device->LimiterState = gainLimiter;
     if(ConfigValueBool(device->DeviceName.c_str(), nullptr, "output-limiter", &val))
         gainLimiter = val ? ALC_TRUE : ALC_FALSE;
@@ -2042,13 +2939,37 @@ static ALCenum UpdateDeviceParams(ALCdevice *device, const ALCint *attrList)
         const float thrshld_dB{std::log10(thrshld) * 20.0f};
         auto limiter = CreateDeviceLimiter(device, thrshld_dB);
         /* Convert the lookahead from samples to nanosamples to nanoseconds. */
-        device->FixedLatency += nanoseconds{seconds{limiter->getLookAhead()}} / device->Frequency;
+        device->FixedLatency += nanoseconds{seconds{limiter->getLookAhead()}} / device->MixFrequency;
         device->Limiter = std::move(limiter);
         TRACE("Output limiter enabled, %.4fdB limit\n", thrshld_dB);
     }
 
     aluSelectPostProcess(device);
 
+    device->OutputConverter = nullptr;
+    device->OutputMix.clear();
+    device->OutputConverted.clear();
+    device->OutputMixPos = 0;
+    device->OutputMixCount = 0;
+    if(device->MixFrequency != device->Frequency)
+    {
+        /* With dithering, the output is converted to float so it can be
+         * dithered at the output rate, then quantized when it's written.
+         */
+        const ALsizei numchans{device->RealOut.NumChannels};
+        const bool dither{device->DitherDepth > 0.0f};
+        device->OutputConverter = CreateSampleConverter(DevFmtFloat,
+            dither ? DevFmtFloat : device->FmtType, numchans, numchans,
+            static_cast<ALsizei>(device->MixFrequency), static_cast<ALsizei>(device->Frequency),
+            BSinc24Resampler);
+        device->OutputMix.resize(static_cast<size_t>(numchans) * BUFFERSIZE);
+        if(dither)
+            device->OutputConverted.resize(static_cast<size_t>(numchans) * BUFFERSIZE);
+        /* The resampler delays the mix by half its filter length. */
+        device->FixedLatency += nanoseconds{seconds{MAX_RESAMPLE_PADDING}} /
+            device->MixFrequency;
+    }
+
     TRACE("Fixed device latency: %ldns\n", (long)device->FixedLatency.count());
 
     /* Need to delay returning failure until replacement Send arrays have been
@@ -2056,17 +2977,25 @@ static ALCenum UpdateDeviceParams(ALCdevice *device, const ALCint *attrList)
      */
     update_failed = AL_FALSE;
     FPUCtl mixer_mode{};
+    /* Effect slots get new buffers for the device's ambisonic order. */
+    ResetEffectSlotBuffers(device,
+        static_cast<ALsizei>(AmbiChannelsFromOrder(device->mAmbiOrder)));
     context = device->ContextList.load();
     while(context)
     {
+        UpdateContextMixParams(context, device);
+
         if(context->DefaultSlot)
         {
             ALeffectslot *slot = context->DefaultSlot.get();
             aluInitEffectPanning(slot, device);
 
             EffectState *state{slot->Effect.State};
-            state->mOutBuffer = device->Dry.Buffer;
+            state->mOutBuffer = context->Dry.Buffer;
             state->mOutChannels = device->Dry.NumChannels;
+            state->mOutTouched = context->Dry.Touched;
+            if(state->mHalfRate)
+                state->mHalfRate->reset(device->SlotBufferChannels, state->mOutChannels);
             if(state->deviceUpdate(device) == AL_FALSE)
                 update_failed = AL_TRUE;
             else
@@ -2088,8 +3017,11 @@ static ALCenum UpdateDeviceParams(ALCdevice *device, const ALCint *attrList)
                 aluInitEffectPanning(slot, device);
 
                 EffectState *state{slot->Effect.State};
-                state->mOutBuffer = device->Dry.Buffer;
+                state->mOutBuffer = context->Dry.Buffer;
                 state->mOutChannels = device->Dry.NumChannels;
+                state->mOutTouched = context->Dry.Touched;
+                if(state->mHalfRate)
+                    state->mHalfRate->reset(device->SlotBufferChannels, state->mOutChannels);
                 if(state->deviceUpdate(device) == AL_FALSE)
                     update_failed = AL_TRUE;
                 else
@@ -2101,6 +3033,17 @@ static ALCenum UpdateDeviceParams(ALCdevice *device, const ALCint *attrList)
         std::unique_lock<std::mutex> srclock{context->SourceLock};
         for(auto &sublist : context->SourceList)
         {
+            /* Sends are stored per sublist, so a change in the send count
+             * needs new storage for the whole batch.
+             */
+            ALsource::SendData *newsends{nullptr};
+            if(old_sends != device->NumAuxSends && device->NumAuxSends > 0)
+            {
+                newsends = static_cast<ALsource::SendData*>(al_calloc(16,
+                    sizeof(ALsource::SendData)*64*device->NumAuxSends));
+                if(!newsends) throw std::bad_alloc();
+            }
+
             uint64_t usemask = ~sublist.FreeMask;
             while(usemask)
             {
@@ -2111,48 +3054,55 @@ static ALCenum UpdateDeviceParams(ALCdevice *device, const ALCint *attrList)
 
                 if(old_sends != device->NumAuxSends)
                 {
+                    ALsource::SendData *sends{newsends ? newsends + idx*device->NumAuxSends :
+                        nullptr};
                     ALsizei s;
                     for(s = device->NumAuxSends;s < old_sends;s++)
                     {
                         if(source->Send[s].Slot)
                             DecrementRef(&source->Send[s].Slot->ref);
                         source->Send[s].Slot = nullptr;
+                        if(source->Send[s].Link)
+                            DecrementRef(&source->Send[s].Link->ref);
+                        source->Send[s].Link = nullptr;
                     }
-                    source->Send.resize(device->NumAuxSends);
-                    source->Send.shrink_to_fit();
+                    std::copy_n(source->Send, mini(old_sends, device->NumAuxSends), sends);
                     for(s = old_sends;s < device->NumAuxSends;s++)
                     {
-                        source->Send[s].Slot = nullptr;
-                        source->Send[s].Gain = 1.0f;
-                        source->Send[s].GainHF = 1.0f;
-                        source->Send[s].HFReference = LOWPASSFREQREF;
-                        source->Send[s].GainLF = 1.0f;
-                        source->Send[s].LFReference = HIGHPASSFREQREF;
+                        sends[s].Slot = nullptr;
+                        sends[s].Link = nullptr;
+                        sends[s].Gain = 1.0f;
+                        sends[s].GainHF = 1.0f;
+                        sends[s].HFReference = LOWPASSFREQREF;
+                        sends[s].GainLF = 1.0f;
+                        sends[s].LFReference = HIGHPASSFREQREF;
                     }
+                    source->Send = sends;
+                    source->NumSends = device->NumAuxSends;
                 }
 
+                source->DirtyProps.store(VPROPS_ALL, std::memory_order_relaxed);
                 source->PropsClean.clear(std::memory_order_release);
             }
+
+            if(old_sends != device->NumAuxSends)
+            {
+                al_free(sublist.Sends);
+                sublist.Sends = newsends;
+            }
         }
 
-        /* Clear any pre-existing voice property structs, in case the number of
-         * auxiliary sends is changing. Active sources will have updates
+        /* Drop any pending voice updates, since they may refer to auxiliary
+         * sends that are going away. Active sources will have updates
          * respecified in UpdateAllSourceProps.
          */
-        ALvoiceProps *vprops{context->FreeVoiceProps.exchange(nullptr, std::memory_order_acq_rel)};
-        while(vprops)
-        {
-            ALvoiceProps *next = vprops->next.load(std::memory_order_relaxed);
-            delete vprops;
-            vprops = next;
-        }
-
         AllocateVoices(context, context->MaxVoices, old_sends);
         auto voices_end = context->Voices + context->VoiceCount.load(std::memory_order_relaxed);
         std::for_each(context->Voices, voices_end,
-            [device](ALvoice *voice) -> void
+            [device,context](ALvoice *voice) -> void
             {
-                delete voice->mUpdate.exchange(nullptr, std::memory_order_acq_rel);
+                if(ALvoiceProps *vprops{voice->mUpdate.exchange(nullptr, std::memory_order_acq_rel)})
+                    AtomicReplaceHead(context->FreeVoiceProps, vprops);
 
                 /* Force the voice to stopped if it was stopping. */
                 ALvoice::State vstate{ALvoice::Stopping};
@@ -2161,14 +3111,13 @@ static ALCenum UpdateDeviceParams(ALCdevice *device, const ALCint *attrList)
                 if(voice->mSourceID.load(std::memory_order_relaxed) == 0u)
                     return;
 
-                if(device->AvgSpeakerDist > 0.0f)
+                if(voice->mDirectNfc)
                 {
                     /* Reinitialize the NFC filters for new parameters. */
                     ALfloat w1 = SPEEDOFSOUNDMETRESPERSEC /
-                                 (device->AvgSpeakerDist * device->Frequency);
-                    std::for_each(voice->mDirect.Params, voice->mDirect.Params+voice->mNumChannels,
-                        [w1](DirectParams &params) noexcept -> void
-                        { params.NFCtrlFilter.init(w1); }
+                                 (device->AvgSpeakerDist * device->MixFrequency);
+                    std::for_each(voice->mDirectNfc, voice->mDirectNfc+voice->mNumChannels,
+                        [w1](NfcFilter &filter) noexcept -> void { filter.init(w1); }
                     );
                 }
             }
@@ -2177,23 +3126,70 @@ static ALCenum UpdateDeviceParams(ALCdevice *device, const ALCint *attrList)
 
         context->PropsClean.test_and_set(std::memory_order_release);
         UpdateContextProps(context);
-        context->Listener.PropsClean.test_and_set(std::memory_order_release);
-        UpdateListenerProps(context);
+        auto update_listener = [context](ALlistener &listener) -> void
+        {
+            listener.PropsClean.test_and_set(std::memory_order_release);
+            UpdateListenerProps(context, listener);
+        };
+        update_listener(context->Listener);
+        std::for_each(context->ExtraListeners.begin(), context->ExtraListeners.end(),
+            update_listener);
         UpdateAllSourceProps(context);
 
         context = context->next.load(std::memory_order_relaxed);
     }
     mixer_mode.leave();
     if(update_failed)
+    {
+        if(mixlock)
+            StopHeldDevice(device, mixlock);
         return ALC_INVALID_DEVICE;
+    }
+
+    device->HrtfLockedSize = (lockmem && device->mHrtf) ? LockHrtf(device->mHrtf, device->mArena) : 0u;
+    if(lockmem)
+    {
+        size_t failed;
+        const size_t locked{al::GetArenaLockedSize(device->mArena, &failed)};
+        TRACE("Locked %zuKB of mixer memory, %zuKB of HRTF tables\n", locked/1024,
+            device->HrtfLockedSize/1024);
+        if(failed > 0)
+            WARN("Failed to lock %zuKB of mixer memory (check RLIMIT_MEMLOCK)\n", failed/1024);
+    }
+
+    /* Set the mirrors up for the new output. Any that can't play it are
+     * dropped.
+     */
+    auto mirror_end = std::remove_if(device->Mirrors.begin(), device->Mirrors.end(),
+        [device](const OutputMirrorPtr &mirror) -> bool
+        {
+            if(mirror->reset(device))
+                return false;
+            WARN("Dropping output mirror \"%s\"\n", mirror->Device->DeviceName.c_str());
+            return true;
+        }
+    );
+    device->Mirrors.erase(mirror_end, device->Mirrors.end());
 
-    if(!(device->Flags&DEVICE_PAUSED))
+    if(mixlock)
+    {
+        /* The new state's in place, so let the held mixer continue, fading
+         * the output back in.
+         */
+        device->OutputFadeState.store(OutputFadeIn, std::memory_order_release);
+        mixlock.unlock();
+    }
+    else if(!(device->Flags&DEVICE_PAUSED))
     {
+        device->Backend->mTelemetry.restart();
         if(device->Backend->start() == ALC_FALSE)
             return ALC_INVALID_DEVICE;
         device->Flags |= DEVICE_RUNNING;
     }
 
+    if(device->mHrtfLoadPending)
+        StartHrtfLoader(device, attrList, hrtf_id, hrtf_native ? 0u : device->MixFrequency);
+
     return ALC_NO_ERROR;
 }
 
@@ -2211,8 +3207,26 @@ ALCdevice::~ALCdevice()
 {
     TRACE("%p\n", this);
 
+    /* The HRTF loader may be holding the last reference. */
+    if(mHrtfLoader.joinable())
+    {
+        if(mHrtfLoader.get_id() == std::this_thread::get_id())
+            mHrtfLoader.detach();
+        else
+            mHrtfLoader.join();
+    }
+
+    Mirrors.clear();
+    /* The mixer workers may be in the backend's thread group. */
+    MixThreads = nullptr;
     Backend = nullptr;
 
+    std::for_each(ResampleCaches.begin(), ResampleCaches.end(),
+        [](ResampleCache *cache) noexcept -> void { delete cache; });
+    ResampleCaches.clear();
+
+    ResetEffectSlotBuffers(this, 0);
+
     size_t count{std::accumulate(BufferList.cbegin(), BufferList.cend(), size_t{0u},
         [](size_t cur, const BufferSubList &sublist) noexcept -> size_t
         { return cur + POPCNT64(~sublist.FreeMask); }
@@ -2237,6 +3251,10 @@ ALCdevice::~ALCdevice()
     if(mHrtf)
         mHrtf->DecRef();
     mHrtf = nullptr;
+
+    /* Anything still holding arena memory keeps it alive until freed. */
+    al::ReleaseArena(mArena);
+    mArena = nullptr;
 }
 
 
@@ -2314,6 +3332,122 @@ static DeviceRef VerifyDevice(ALCdevice *device)
 }
 
 
+/* HrtfLoaderThread
+ *
+ * Loads an HRTF in the background for a device using hrtf-async, trying the
+ * requested one first and the rest in order (like aluInitRenderer), then
+ * resets the device to use it.
+ */
+static void HrtfLoaderThread(ALCdevice *device, std::string devname,
+    al::vector<EnumeratedHrtf> list, ALCsizei hrtf_id, ALuint rate)
+{
+    althrd_setname(HRTF_LOADER_THREAD_NAME);
+
+    if(list.empty())
+        list = EnumerateHrtf(devname.c_str());
+
+    HrtfEntry *hrtf{nullptr};
+    if(hrtf_id >= 0 && static_cast<size_t>(hrtf_id) < list.size())
+        hrtf = GetLoadedHrtf(list[hrtf_id].hrtf, rate);
+    for(auto iter = list.cbegin();!hrtf && iter != list.cend();++iter)
+        hrtf = GetLoadedHrtf(iter->hrtf, rate);
+
+    DeviceRef dev{VerifyDevice(device)};
+    if(dev)
+    {
+        std::lock_guard<std::mutex> _{dev->StateLock};
+        if(!hrtf)
+            WARN("Failed to load an HRTF for %s\n", devname.c_str());
+        else
+        {
+            if(dev->HrtfList.empty())
+                dev->HrtfList = std::move(list);
+
+            /* Reset the device like alcResetDeviceSOFT, with the HRTF now
+             * loaded so it's switched to without blocking.
+             */
+            dev->mHrtfLoadSync = true;
+            ALCenum err{UpdateDeviceParams(dev.get(),
+                dev->mHrtfLoadAttrs.empty() ? nullptr : dev->mHrtfLoadAttrs.data(), true)};
+            dev->mHrtfLoadSync = false;
+
+            if(err != ALC_NO_ERROR)
+            {
+                alcSetError(dev.get(), err);
+                if(err == ALC_INVALID_DEVICE)
+                    aluHandleDisconnect(dev.get(), "Device start failure");
+            }
+            else if(dev->mHrtf)
+            {
+                TRACE("Switched to HRTF \"%s\"\n", dev->HrtfName.c_str());
+
+                AsyncEvent evt{EventType_HrtfReady};
+                evt.u.user.type = AL_EVENT_TYPE_HRTF_READY_SOFT;
+                evt.u.user.id = 0;
+                evt.u.user.param = static_cast<ALuint>(dev->HrtfStatus);
+                snprintf(evt.u.user.msg, sizeof(evt.u.user.msg), "HRTF \"%s\" is ready",
+                    dev->HrtfName.c_str());
+
+                ALCcontext *ctx{dev->ContextList.load()};
+                for(;ctx != nullptr;ctx = ctx->next.load(std::memory_order_relaxed))
+                {
+                    const ALbitfieldSOFT enabledevt{ctx->EnabledEvts.load(std::memory_order_acquire)};
+                    if(!(enabledevt&EventType_HrtfReady))
+                        continue;
+
+                    RingBuffer *ring{ctx->AsyncEvents.get()};
+                    auto evt_data = ring->getWriteVector().first;
+                    if(evt_data.len > 0)
+                    {
+                        new (evt_data.buf) AsyncEvent{evt};
+                        ring->writeAdvance(1);
+                        WakeEventThrd();
+                    }
+                }
+            }
+        }
+        dev->mHrtfLoading.store(false);
+    }
+
+    /* The device holds its own reference now, if it's using it. */
+    if(hrtf)
+        hrtf->DecRef();
+}
+
+/* StartHrtfLoader
+ *
+ * Starts loading an HRTF in the background, or updates the attributes used to
+ * reset the device when one is already loading (caller is responsible for
+ * holding the device's state lock).
+ */
+static void StartHrtfLoader(ALCdevice *device, const ALCint *attrList, ALCsizei hrtf_id,
+    ALuint rate)
+{
+    device->mHrtfLoadAttrs.clear();
+    if(attrList && attrList[0])
+    {
+        const ALCint *attrEnd{attrList};
+        while(attrEnd[0])
+            attrEnd += 2;
+        device->mHrtfLoadAttrs.assign(attrList, attrEnd+1);
+    }
+
+    if(device->mHrtfLoading.exchange(true))
+        return;
+    if(device->mHrtfLoader.joinable())
+        device->mHrtfLoader.join();
+
+    try {
+        device->mHrtfLoader = std::thread{HrtfLoaderThread, device, device->DeviceName,
+            device->HrtfList, hrtf_id, rate};
+    }
+    catch(std::exception& e) {
+        ERR("Failed to start HRTF loader thread: %s\n", e.what());
+        device->mHrtfLoading.store(false);
+    }
+}
+
+
 ALCcontext::ALCcontext(ALCdevice *device) : Device{device}
 {
     PropsClean.test_and_set(std::memory_order_relaxed);
@@ -2360,9 +3494,6 @@ static ALvoid InitContext(ALCcontext *Context)
     listener.Params.SourceDistanceModel = Context->SourceDistanceModel;
     listener.Params.mDistanceModel = Context->mDistanceModel;
 
-
-    Context->AsyncEvents = CreateRingBuffer(511, sizeof(AsyncEvent), false);
-    StartEventThrd(Context);
 }
 
 
@@ -2399,8 +3530,42 @@ ALCcontext::~ALCcontext()
     if(count > 0)
         WARN("%zu Source%s not deleted\n", count, (count==1)?"":"s");
     SourceList.clear();
+    SourceFreeMap.clear();
     NumSources = 0;
 
+    count = 0;
+    for(ALbufferlistitem *&freelist : FreeQueueItems)
+    {
+        while(ALbufferlistitem *item{freelist})
+        {
+            freelist = item->next.load(std::memory_order_relaxed);
+            al_free(item);
+            ++count;
+        }
+    }
+    TRACE("Freed %zu buffer queue item%s\n", count, (count==1)?"":"s");
+
+    count = std::accumulate(SourceGroupList.cbegin(), SourceGroupList.cend(), size_t{0u},
+        [](size_t cur, const SourceGroupSubList &sublist) noexcept -> size_t
+        { return cur + POPCNT64(~sublist.FreeMask); }
+    );
+    if(count > 0)
+        WARN("%zu Source group%s not deleted\n", count, (count==1)?"":"s");
+    SourceGroupList.clear();
+    SourceGroupFreeMap.clear();
+    NumSourceGroups = 0;
+
+    count = 0;
+    ALsourceGroupProps *gprops{FreeSourceGroupProps.exchange(nullptr, std::memory_order_acquire)};
+    while(gprops)
+    {
+        ALsourceGroupProps *next{gprops->next.load(std::memory_order_relaxed)};
+        al_free(gprops);
+        gprops = next;
+        ++count;
+    }
+    TRACE("Freed %zu source group property object%s\n", count, (count==1)?"":"s");
+
     count = 0;
     ALeffectslotProps *eprops{FreeEffectslotProps.exchange(nullptr, std::memory_order_acquire)};
     while(eprops)
@@ -2416,6 +3581,11 @@ ALCcontext::~ALCcontext()
     delete ActiveAuxSlots.exchange(nullptr, std::memory_order_relaxed);
     DefaultSlot = nullptr;
 
+    /* The context isn't mixed anymore, so everything retired can go. */
+    std::for_each(RetiredObjects.begin(), RetiredObjects.end(),
+        [](const RetiredObject &obj) -> void { obj.Free(obj.Ptr); });
+    RetiredObjects.clear();
+
     count = std::accumulate(EffectSlotList.cbegin(), EffectSlotList.cend(), size_t{0u},
         [](size_t cur, const EffectSlotSubList &sublist) noexcept -> size_t
         { return cur + POPCNT64(~sublist.FreeMask); }
@@ -2423,33 +3593,43 @@ ALCcontext::~ALCcontext()
     if(count > 0)
         WARN("%zu AuxiliaryEffectSlot%s not deleted\n", count, (count==1)?"":"s");
     EffectSlotList.clear();
+    EffectSlotFreeMap.clear();
     NumEffectSlots = 0;
 
-    count = 0;
-    ALvoiceProps *vprops{FreeVoiceProps.exchange(nullptr, std::memory_order_acquire)};
-    while(vprops)
-    {
-        ALvoiceProps *next{vprops->next.load(std::memory_order_relaxed)};
-        delete vprops;
-        vprops = next;
-        ++count;
-    }
-    TRACE("Freed %zu voice property object%s\n", count, (count==1)?"":"s");
-
     std::for_each(Voices, Voices + MaxVoices, DeinitVoice);
     al_free(Voices);
     Voices = nullptr;
+    VoiceCapacity = 0;
+    std::for_each(VoiceChunks.begin(), VoiceChunks.end(), al_free);
+    VoiceChunks.clear();
     VoiceCount.store(0, std::memory_order_relaxed);
     MaxVoices = 0;
 
-    ALlistenerProps *lprops{Listener.Update.exchange(nullptr, std::memory_order_relaxed)};
-    if(lprops)
+    /* The voice property containers live in the pool's chunks, so they're
+     * all freed with them regardless of being in the freelist or pending.
+     */
+    const ALuint misses{VoicePropMisses.load(std::memory_order_relaxed)};
+    TRACE("Freed %zu voice property object%s in %zu chunk%s (%u pool miss%s)\n", NumVoiceProps,
+        (NumVoiceProps==1)?"":"s", VoicePropChunks.size(), (VoicePropChunks.size()==1)?"":"s",
+        misses, (misses==1)?"":"es");
+    FreeVoiceProps.store(nullptr, std::memory_order_relaxed);
+    std::for_each(VoicePropChunks.begin(), VoicePropChunks.end(), al_free);
+    VoicePropChunks.clear();
+    NumVoiceProps = 0;
+
+    auto free_update = [](ALlistener &listener) -> void
     {
-        TRACE("Freed unapplied listener update %p\n", lprops);
-        al_free(lprops);
-    }
+        ALlistenerProps *lprops{listener.Update.exchange(nullptr, std::memory_order_relaxed)};
+        if(lprops)
+        {
+            TRACE("Freed unapplied listener update %p\n", lprops);
+            al_free(lprops);
+        }
+    };
+    free_update(Listener);
+    std::for_each(ExtraListeners.begin(), ExtraListeners.end(), free_update);
     count = 0;
-    lprops = FreeListenerProps.exchange(nullptr, std::memory_order_acquire);
+    ALlistenerProps *lprops{FreeListenerProps.exchange(nullptr, std::memory_order_acquire)};
     while(lprops)
     {
         ALlistenerProps *next{lprops->next.load(std::memory_order_relaxed)};
@@ -2481,6 +3661,9 @@ ALCcontext::~ALCcontext()
             TRACE("Destructed %zu orphaned event%s\n", count, (count==1)?"":"s");
     }
 
+    delete CompletionWakeup.exchange(nullptr, std::memory_order_relaxed);
+    delete Instances.exchange(nullptr, std::memory_order_relaxed);
+
     ALCdevice_DecRef(Device);
 }
 
@@ -2533,7 +3716,7 @@ static bool ReleaseContext(ALCcontext *context, ALCdevice *device)
     return ret;
 }
 
-static void ALCcontext_IncRef(ALCcontext *context)
+void ALCcontext_IncRef(ALCcontext *context)
 {
     auto ref = IncrementRef(&context->ref);
     TRACEREF("%p increasing refcount to %u\n", context, ref);
@@ -2543,7 +3726,43 @@ void ALCcontext_DecRef(ALCcontext *context)
 {
     auto ref = DecrementRef(&context->ref);
     TRACEREF("%p decreasing refcount to %u\n", context, ref);
-    if(UNLIKELY(ref == 0)) delete context;
+    if(LIKELY(ref != 0)) return;
+
+    /* A thread may still be using the context through its hazard slot, in
+     * which case clearing the slot deletes it.
+     */
+    {
+        std::lock_guard<std::mutex> _{RetiredContextLock};
+        RetiredContexts.emplace_back(context);
+        HaveRetiredContexts.store(true);
+        if(IsContextHazard(context))
+        {
+            TRACE("Deferring deletion of %p, in use by another thread\n", context);
+            return;
+        }
+        RetiredContexts.pop_back();
+        HaveRetiredContexts.store(!RetiredContexts.empty(), std::memory_order_relaxed);
+    }
+    delete context;
+}
+
+void ClearContextHazard(ContextHazard *hazard) noexcept
+{
+    hazard->Context.store(nullptr);
+    if(LIKELY(!HaveRetiredContexts.load()))
+        return;
+
+    al::vector<ALCcontext*> todelete;
+    {
+        std::lock_guard<std::mutex> _{RetiredContextLock};
+        auto iter = std::stable_partition(RetiredContexts.begin(), RetiredContexts.end(),
+            IsContextHazard);
+        todelete.assign(iter, RetiredContexts.end());
+        RetiredContexts.erase(iter, RetiredContexts.end());
+        HaveRetiredContexts.store(!RetiredContexts.empty(), std::memory_order_relaxed);
+    }
+    for(ALCcontext *context : todelete)
+        delete context;
 }
 
 /* VerifyContext
@@ -2569,48 +3788,189 @@ static ContextRef VerifyContext(ALCcontext *context)
  */
 ContextRef GetContextRef(void)
 {
+    /* The thread holds a reference to its own context, which only it can
+     * release, so it stays valid for the call.
+     */
     ALCcontext *context{LocalContext.get()};
     if(context)
-        ALCcontext_IncRef(context);
-    else
+        return ContextRef::borrow(context);
+
+    /* The global context is protected by putting it in the thread's hazard
+     * slot, and checking it's still the global context afterward. Releasing
+     * the global context's reference happens after it's replaced, and won't
+     * delete it while it's in a slot.
+     */
+    ContextHazard *hazard{LocalHazard.get()};
+    ALCcontext *held{hazard->Context.load(std::memory_order_relaxed)};
+    if(LIKELY(!held))
     {
-        std::lock_guard<std::recursive_mutex> _{ListLock};
         context = GlobalContext.load(std::memory_order_acquire);
-        if(context) ALCcontext_IncRef(context);
+        while(context)
+        {
+            hazard->Context.store(context);
+            ALCcontext *current{GlobalContext.load()};
+            if(LIKELY(current == context))
+                return ContextRef{context, hazard};
+            context = current;
+        }
+        ClearContextHazard(hazard);
+        return ContextRef{};
     }
+
+    /* The slot is already in use by an outer call. If it's holding the
+     * current global context, it's protected for this call too. Otherwise,
+     * take a reference.
+     */
+    context = GlobalContext.load();
+    if(context == held)
+        return ContextRef::borrow(context);
+
+    std::lock_guard<std::recursive_mutex> _{ListLock};
+    context = GlobalContext.load(std::memory_order_acquire);
+    if(context) ALCcontext_IncRef(context);
     return ContextRef{context};
 }
 
 
+namespace {
+
+/* Copies the filters and gains of a voice's direct or send parameters,
+ * leaving the destinations' gain storage in place.
+ */
+template<typename T, size_t N>
+void CopyVoiceParams(T (&dst)[N], const T (&src)[N], const ALsizei numgains)
+{
+    for(size_t i{0};i < N;++i)
+    {
+        dst[i].LowPass = src[i].LowPass;
+        dst[i].HighPass = src[i].HighPass;
+        std::copy_n(src[i].Gains.Current, numgains, dst[i].Gains.Current);
+        std::copy_n(src[i].Gains.Target, numgains, dst[i].Gains.Target);
+    }
+}
+
+} // namespace
+
 void AllocateVoices(ALCcontext *context, ALsizei num_voices, ALsizei old_sends)
 {
     ALCdevice *device{context->Device};
+    /* Voices are mixer memory, so they come from the device's arena even when
+     * added by playing a source.
+     */
+    al::ArenaScope arena_scope{device->mArena};
     const ALsizei num_sends{device->NumAuxSends};
 
-    if(num_voices == context->MaxVoices && num_sends == old_sends)
+    /* The HRTF and NFC state make up most of a voice's size, so they're only
+     * allocated when the device uses them.
+     */
+    const bool use_hrtf{device->mHrtf != nullptr};
+    const bool use_nfc{device->AvgSpeakerDist > 0.0f};
+    /* The voice gains need to cover every buffer a voice can mix to, which
+     * can be up to 64 channels for a seventh-order ambisonic device. Keep it
+     * a multiple of 4 so each gain array stays aligned.
+     */
+    const size_t max_chans{maxz(AmbiChannelsFromOrder(device->mAmbiOrder),
+        static_cast<size_t>(maxi(device->Dry.NumChannels, device->RealOut.NumChannels)))};
+    const auto num_gains = static_cast<ALsizei>(RoundUp(max_chans, 4));
+    const bool same_layout{num_sends == old_sends && use_hrtf == context->VoiceHrtf &&
+        use_nfc == context->VoiceNfc && num_gains == context->VoiceGains};
+
+    if(num_voices == context->MaxVoices && same_layout)
         return;
 
-    /* Allocate the voice pointers, voices, and the voices' stored source
-     * property set (including the dynamically-sized Send[] array) in one
-     * chunk.
+    /* Adding voices with the same layout leaves the existing ones where they
+     * are, and only needs a chunk for the new ones. Otherwise, all the voices
+     * are moved to a new chunk.
+     */
+    const bool grow{same_layout && num_voices > context->MaxVoices};
+    const ALsizei first_new{grow ? context->MaxVoices : 0};
+
+    /* Allocate the voice pointers, and the voices with their stored source
+     * property set (including the dynamically-sized Send[] array), followed
+     * by the HRTF and NFC state if needed, and the current and target gains
+     * of each direct and send parameter.
      */
-    const size_t sizeof_voice{RoundUp(ALvoice::Sizeof(num_sends), 16)};
-    const size_t size{sizeof(ALvoice*) + sizeof_voice};
+    const size_t sizeof_base{RoundUp(ALvoice::Sizeof(num_sends), 16)};
+    const size_t sizeof_hrtf{use_hrtf ?
+        RoundUp(sizeof(DirectHrtfParams)*MAX_INPUT_CHANNELS, 16) : 0};
+    const size_t sizeof_nfc{use_nfc ? RoundUp(sizeof(NfcFilter)*MAX_INPUT_CHANNELS, 16) : 0};
+    const size_t sizeof_gains{sizeof(ALfloat)*2*static_cast<size_t>(num_gains) *
+        MAX_INPUT_CHANNELS * static_cast<size_t>(num_sends+1)};
+    const size_t sizeof_voice{sizeof_base + sizeof_hrtf + sizeof_nfc + sizeof_gains};
+
+    auto construct_voice = [num_sends,num_gains,sizeof_base,sizeof_hrtf,sizeof_nfc](
+        ALvoice *mem, bool hrtf, bool nfc) -> ALvoice*
+    {
+        char *base{reinterpret_cast<char*>(mem)};
+        ALvoice *ret = new (mem) ALvoice{static_cast<size_t>(num_sends)};
+
+        auto gains = reinterpret_cast<ALfloat*>(base + sizeof_base + sizeof_hrtf + sizeof_nfc);
+        for(DirectParams &params : ret->mDirect.Params)
+        {
+            params.Gains.Current = gains; gains += num_gains;
+            params.Gains.Target = gains; gains += num_gains;
+        }
+        for(ALvoice::SendData &send : ret->mSend)
+        {
+            for(SendParams &params : send.Params)
+            {
+                params.Gains.Current = gains; gains += num_gains;
+                params.Gains.Target = gains; gains += num_gains;
+            }
+        }
+        ret->mNumGains = num_gains;
 
-    auto voices = static_cast<ALvoice**>(al_calloc(16, RoundUp(size*num_voices, 16)));
-    auto voice = reinterpret_cast<ALvoice*>(reinterpret_cast<char*>(voices) + RoundUp(num_voices*sizeof(ALvoice*), 16));
+        if(hrtf)
+        {
+            auto params = reinterpret_cast<DirectHrtfParams*>(base + sizeof_base);
+            for(size_t i{0};i < MAX_INPUT_CHANNELS;++i)
+                new (params+i) DirectHrtfParams{};
+            ret->mDirectHrtf = params;
+        }
+        if(nfc)
+        {
+            auto filters = reinterpret_cast<NfcFilter*>(base + sizeof_base + sizeof_hrtf);
+            for(size_t i{0};i < MAX_INPUT_CHANNELS;++i)
+                new (filters+i) NfcFilter{};
+            ret->mDirectNfc = filters;
+        }
+        return ret;
+    };
+
+    /* The pointer array keeps spare capacity when growing, so adding a chunk
+     * usually only needs to fill in the new pointers.
+     */
+    ALvoice **voices{context->Voices};
+    if(!grow || num_voices > context->VoiceCapacity)
+    {
+        const ALsizei capacity{grow ? maxi(num_voices, context->VoiceCapacity*2) : num_voices};
+        voices = static_cast<ALvoice**>(al_calloc(16,
+            RoundUp(static_cast<size_t>(capacity)*sizeof(ALvoice*), 16)));
+        context->VoiceCapacity = capacity;
+    }
+    auto voice = static_cast<ALvoice*>(al_calloc(16,
+        sizeof_voice*static_cast<size_t>(num_voices-first_new)));
+    void *chunk{voice};
 
     auto viter = voices;
-    if(context->Voices)
+    if(grow)
+    {
+        if(voices != context->Voices)
+            std::copy_n(context->Voices, context->MaxVoices, viter);
+        viter += context->MaxVoices;
+    }
+    else if(context->Voices)
     {
         const ALsizei v_count = mini(context->VoiceCount.load(std::memory_order_relaxed),
                                      num_voices);
         const ALsizei s_count = mini(old_sends, num_sends);
+        const ALsizei g_count = mini(context->VoiceGains, num_gains);
 
         /* Copy the old voice data to the new storage. */
-        auto copy_voice = [&voice,num_sends,sizeof_voice,s_count](ALvoice *old_voice) -> ALvoice*
+        auto copy_voice = [&voice,&construct_voice,sizeof_voice,s_count,g_count,use_hrtf,use_nfc](
+            ALvoice *old_voice) -> ALvoice*
         {
-            voice = new (voice) ALvoice{static_cast<size_t>(num_sends)};
+            voice = construct_voice(voice, use_hrtf, use_nfc);
 
             /* Make sure the old voice's Update (if any) is cleared so it
              * doesn't get deleted on deinit.
@@ -2622,6 +3982,7 @@ void AllocateVoices(ALCcontext *context, ALsizei num_voices, ALsizei old_sends)
                 std::memory_order_relaxed);
             voice->mPlayState.store(old_voice->mPlayState.load(std::memory_order_relaxed),
                 std::memory_order_relaxed);
+            voice->mCompletedCount = old_voice->mCompletedCount;
 
             voice->mProps = old_voice->mProps;
             /* Clear extraneous property set sends. */
@@ -2645,21 +4006,61 @@ void AllocateVoices(ALCcontext *context, ALsizei num_voices, ALsizei old_sends)
 
             voice->mStep = old_voice->mStep;
             voice->mResampler = old_voice->mResampler;
+            voice->mMultiResampler = old_voice->mMultiResampler;
 
-            voice->mFlags = old_voice->mFlags;
+            /* The send count may have changed, so recalculate attenuation. And
+             * don't use HRTF or NFC if the voice no longer has the state for
+             * it (the next update will set things right).
+             */
+            voice->mFlags = old_voice->mFlags & ~VOICE_ATTN_CACHED;
+            if(!use_hrtf) voice->mFlags &= ~VOICE_HAS_HRTF;
+            if(!use_nfc) voice->mFlags &= ~VOICE_HAS_NFC;
+            voice->mStartTime = old_voice->mStartTime;
 
             std::copy(std::begin(old_voice->mPrevSamples), std::end(old_voice->mPrevSamples),
                 std::begin(voice->mPrevSamples));
 
             voice->mResampleState = old_voice->mResampleState;
 
+            voice->mCallbackBlock = std::move(old_voice->mCallbackBlock);
+            voice->mCallbackBlockLen = old_voice->mCallbackBlockLen;
+            voice->mReadAheadPos = old_voice->mReadAheadPos;
+            voice->mResampled = old_voice->mResampled;
+
+            voice->mClusterKey = old_voice->mClusterKey;
+            voice->mClusterGain = old_voice->mClusterGain;
+
             voice->mAmbiScales = old_voice->mAmbiScales;
             voice->mAmbiSplitter = old_voice->mAmbiSplitter;
             std::for_each(voice->mAmbiSplitter.begin(),voice->mAmbiSplitter.end(),
                 std::bind(std::mem_fn(&BandSplitter::clear), _1));
 
-            voice->mDirect = old_voice->mDirect;
-            std::copy_n(old_voice->mSend.begin(), s_count, voice->mSend.begin());
+            /* The parameters point to their voice's gains, so they can't just
+             * be copied over. If the gain count changed, the device was reset
+             * and the gains will be updated before they're used again.
+             */
+            voice->mDirect.FilterType = old_voice->mDirect.FilterType;
+            CopyVoiceParams(voice->mDirect.Params, old_voice->mDirect.Params, g_count);
+            voice->mDirect.Buffer = old_voice->mDirect.Buffer;
+            voice->mDirect.Channels = old_voice->mDirect.Channels;
+            voice->mDirect.Touched = old_voice->mDirect.Touched;
+            std::copy(std::begin(old_voice->mDirect.ChannelsPerOrder),
+                std::end(old_voice->mDirect.ChannelsPerOrder),
+                std::begin(voice->mDirect.ChannelsPerOrder));
+            for(ALsizei i{0};i < s_count;++i)
+            {
+                ALvoice::SendData &send = voice->mSend[i];
+                const ALvoice::SendData &old_send = old_voice->mSend[i];
+                send.FilterType = old_send.FilterType;
+                CopyVoiceParams(send.Params, old_send.Params, g_count);
+                send.Buffer = old_send.Buffer;
+                send.Channels = old_send.Channels;
+                send.Touched = old_send.Touched;
+            }
+            if(voice->mDirectHrtf && old_voice->mDirectHrtf)
+                std::copy_n(old_voice->mDirectHrtf, MAX_INPUT_CHANNELS, voice->mDirectHrtf);
+            if(voice->mDirectNfc && old_voice->mDirectNfc)
+                std::copy_n(old_voice->mDirectNfc, MAX_INPUT_CHANNELS, voice->mDirectNfc);
 
             /* Set this voice's reference. */
             ALvoice *ret = voice;
@@ -2672,20 +4073,29 @@ void AllocateVoices(ALCcontext *context, ALsizei num_voices, ALsizei old_sends)
         /* Deinit old voices. */
         auto voices_end = context->Voices + context->MaxVoices;
         std::for_each(context->Voices, voices_end, DeinitVoice);
+        std::for_each(context->VoiceChunks.begin(), context->VoiceChunks.end(), al_free);
+        context->VoiceChunks.clear();
     }
+    context->VoiceChunks.emplace_back(chunk);
     /* Finish setting the voices and references. */
-    auto init_voice = [&voice,num_sends,sizeof_voice]() -> ALvoice*
+    auto init_voice = [&voice,&construct_voice,sizeof_voice,use_hrtf,use_nfc]() -> ALvoice*
     {
-        ALvoice *ret = new (voice) ALvoice{static_cast<size_t>(num_sends)};
+        ALvoice *ret = construct_voice(voice, use_hrtf, use_nfc);
         voice = reinterpret_cast<ALvoice*>(reinterpret_cast<char*>(voice) + sizeof_voice);
         return ret;
     };
     std::generate(viter, voices+num_voices, init_voice);
 
-    al_free(context->Voices);
+    if(voices != context->Voices)
+        al_free(context->Voices);
     context->Voices = voices;
     context->MaxVoices = num_voices;
+    context->VoiceHrtf = use_hrtf;
+    context->VoiceNfc = use_nfc;
+    context->VoiceGains = num_gains;
+    context->VoiceRanking.resize(static_cast<size_t>(num_voices));
     context->VoiceCount = mini(context->VoiceCount.load(std::memory_order_relaxed), num_voices);
+    context->NextVoiceIdx = mini(context->NextVoiceIdx, num_voices);
 }
 
 
@@ -2721,7 +4131,11 @@ START_API_FUNC
     if(!ctx)
         alcSetError(nullptr, ALC_INVALID_CONTEXT);
     else
+    {
+        if(UNLIKELY(RecordEnabled))
+            RecordDeferUpdates(ctx.get(), RecordCall::DeferUpdates);
         ALCcontext_DeferUpdates(ctx.get());
+    }
 }
 END_API_FUNC
 
@@ -2739,7 +4153,11 @@ START_API_FUNC
     if(!ctx)
         alcSetError(nullptr, ALC_INVALID_CONTEXT);
     else
+    {
+        if(UNLIKELY(RecordEnabled))
+            RecordDeferUpdates(ctx.get(), RecordCall::ProcessUpdates);
         ALCcontext_ProcessUpdates(ctx.get());
+    }
 }
 END_API_FUNC
 
@@ -2846,6 +4264,16 @@ START_API_FUNC
         }
         break;
 
+    case ALC_CPU_EXTENSIONS_SOFT:
+        DO_INITCONFIG();
+        value = alcCpuExtList.c_str();
+        break;
+
+    case ALC_MIXER_KERNELS_SOFT:
+        DO_INITCONFIG();
+        value = aluGetMixerKernels();
+        break;
+
     default:
         dev = VerifyDevice(Device);
         alcSetError(dev.get(), ALC_INVALID_ENUM);
@@ -2866,6 +4294,13 @@ static inline ALCsizei NumAttrsForDevice(ALCdevice *device)
     return 29;
 }
 
+/* Returns the bytes of the device's memory locked with lock-memory. */
+static size_t GetLockedMemorySize(ALCdevice *device)
+{
+    std::lock_guard<std::mutex> _{device->StateLock};
+    return al::GetArenaLockedSize(device->mArena, nullptr) + device->HrtfLockedSize;
+}
+
 static ALCsizei GetIntegerv(ALCdevice *device, ALCenum param, ALCsizei size, ALCint *values)
 {
     ALCsizei i;
@@ -2931,7 +4366,8 @@ static ALCsizei GetIntegerv(ALCdevice *device, ALCenum param, ALCsizei size, ALC
                     values[i++] = ALC_MINOR_VERSION;
                     values[i++] = alcMinorVersion;
                     values[i++] = ALC_CAPTURE_SAMPLES;
-                    values[i++] = device->Backend->availableSamples();
+                    values[i++] = device->CaptureCallback ? 0 :
+                        device->Backend->availableSamples();
                     values[i++] = ALC_CONNECTED;
                     values[i++] = device->Connected.load(std::memory_order_relaxed);
                     values[i++] = 0;
@@ -2947,7 +4383,8 @@ static ALCsizei GetIntegerv(ALCdevice *device, ALCenum param, ALCsizei size, ALC
 
             case ALC_CAPTURE_SAMPLES:
                 { std::lock_guard<std::mutex> _{device->StateLock};
-                    values[0] = device->Backend->availableSamples();
+                    values[0] = device->CaptureCallback ? 0 :
+                        device->Backend->availableSamples();
                 }
                 return 1;
 
@@ -3166,8 +4603,23 @@ static ALCsizei GetIntegerv(ALCdevice *device, ALCenum param, ALCsizei size, ALC
             values[0] = device->Limiter ? ALC_TRUE : ALC_FALSE;
             return 1;
 
-        case ALC_MAX_AMBISONIC_ORDER_SOFT:
-            values[0] = MAX_AMBI_ORDER;
+        case ALC_MAX_AMBISONIC_ORDER_SOFT:
+            values[0] = MAX_AMBI_ORDER;
+            return 1;
+
+        case ALC_LOCKED_MEMORY_SIZE_SOFT:
+            values[0] = static_cast<ALCint>(minz(GetLockedMemorySize(device),
+                static_cast<size_t>(std::numeric_limits<ALCint>::max())));
+            return 1;
+
+        case ALC_MIXER_STATS_SOFT:
+            values[0] = device->MixerStatsEnabled ? ALC_TRUE : ALC_FALSE;
+            return 1;
+
+        case ALC_OUTPUT_MIRROR_COUNT_SOFT:
+            { std::lock_guard<std::mutex> _{device->StateLock};
+                values[0] = static_cast<ALCint>(device->Mirrors.size());
+            }
             return 1;
 
         default:
@@ -3192,6 +4644,28 @@ START_API_FUNC
 }
 END_API_FUNC
 
+/* Gets the mixer stat queried by the given ALC_MIXER_*_SOFT enum. */
+static const MixerStat &GetMixerStat(const MixerStats &stats, ALCenum pname)
+{
+    switch(pname)
+    {
+    case ALC_MIXER_PARAM_TIME_SOFT: return stats.ParamTime;
+    case ALC_MIXER_VOICE_TIME_SOFT: return stats.VoiceTime;
+    case ALC_MIXER_VOICE_PLAIN_TIME_SOFT:
+        return stats.VoiceTypeTime[MixerThreadStats::PlainVoice];
+    case ALC_MIXER_VOICE_HRTF_TIME_SOFT:
+        return stats.VoiceTypeTime[MixerThreadStats::HrtfVoice];
+    case ALC_MIXER_VOICE_AMBI_TIME_SOFT:
+        return stats.VoiceTypeTime[MixerThreadStats::AmbiVoice];
+    case ALC_MIXER_EFFECT_TIME_SOFT: return stats.EffectTime;
+    case ALC_MIXER_POSTPROCESS_TIME_SOFT: return stats.PostProcessTime;
+    case ALC_MIXER_OUTPUT_TIME_SOFT: return stats.OutputTime;
+    case ALC_MIXER_UPDATE_TIME_SOFT: return stats.UpdateTime;
+    case ALC_MIXER_VOICES_MIXED_SOFT: return stats.VoicesMixed;
+    }
+    return stats.VoicesSkipped;
+}
+
 ALC_API void ALC_APIENTRY alcGetInteger64vSOFT(ALCdevice *device, ALCenum pname, ALCsizei size, ALCint64SOFT *values)
 START_API_FUNC
 {
@@ -3291,7 +4765,7 @@ START_API_FUNC
                         basecount = dev->ClockBase;
                         samplecount = dev->SamplesDone;
                     } while(refcount != ReadRef(&dev->MixCount));
-                    basecount += nanoseconds{seconds{samplecount}} / dev->Frequency;
+                    basecount += nanoseconds{seconds{samplecount}} / dev->MixFrequency;
                     *values = basecount.count();
                 }
                 break;
@@ -3303,6 +4777,10 @@ START_API_FUNC
                 }
                 break;
 
+            case ALC_LOCKED_MEMORY_SIZE_SOFT:
+                *values = static_cast<ALCint64SOFT>(GetLockedMemorySize(dev.get()));
+                break;
+
             case ALC_DEVICE_CLOCK_LATENCY_SOFT:
                 if(size < 2)
                     alcSetError(dev.get(), ALC_INVALID_VALUE);
@@ -3315,6 +4793,98 @@ START_API_FUNC
                 }
                 break;
 
+            case ALC_MIXER_PARAM_TIME_SOFT:
+            case ALC_MIXER_VOICE_TIME_SOFT:
+            case ALC_MIXER_VOICE_PLAIN_TIME_SOFT:
+            case ALC_MIXER_VOICE_HRTF_TIME_SOFT:
+            case ALC_MIXER_VOICE_AMBI_TIME_SOFT:
+            case ALC_MIXER_EFFECT_TIME_SOFT:
+            case ALC_MIXER_POSTPROCESS_TIME_SOFT:
+            case ALC_MIXER_OUTPUT_TIME_SOFT:
+            case ALC_MIXER_UPDATE_TIME_SOFT:
+            case ALC_MIXER_VOICES_MIXED_SOFT:
+            case ALC_MIXER_VOICES_SKIPPED_SOFT:
+                if(size < 2)
+                    alcSetError(dev.get(), ALC_INVALID_VALUE);
+                else
+                {
+                    const MixerStat &stat = GetMixerStat(dev->MixStats, pname);
+                    values[0] = static_cast<ALCint64SOFT>(stat.Total.load(std::memory_order_relaxed));
+                    values[1] = static_cast<ALCint64SOFT>(stat.Last.load(std::memory_order_relaxed));
+                }
+                break;
+
+            case ALC_MIXER_PEAK_UPDATE_TIME_SOFT:
+                if(size < 2)
+                    alcSetError(dev.get(), ALC_INVALID_VALUE);
+                else
+                {
+                    const MixerStats &stats = dev->MixStats;
+                    values[0] = static_cast<ALCint64SOFT>(
+                        stats.PeakUpdateTime.load(std::memory_order_relaxed));
+                    values[1] = static_cast<ALCint64SOFT>(
+                        stats.PeakUpdatePeriod.load(std::memory_order_relaxed));
+                }
+                break;
+
+            case ALC_MIXER_UPDATE_COUNT_SOFT:
+                if(size < 2)
+                    alcSetError(dev.get(), ALC_INVALID_VALUE);
+                else
+                {
+                    const MixerStats &stats = dev->MixStats;
+                    values[0] = static_cast<ALCint64SOFT>(
+                        stats.Updates.load(std::memory_order_relaxed));
+                    values[1] = static_cast<ALCint64SOFT>(
+                        stats.LateUpdates.load(std::memory_order_relaxed));
+                }
+                break;
+
+            case ALC_MIXER_XRUN_COUNT_SOFT:
+            case ALC_BACKEND_UNDERRUN_COUNT_SOFT:
+                *values = static_cast<ALCint64SOFT>(
+                    dev->Backend->mTelemetry.Underruns.load(std::memory_order_relaxed));
+                break;
+
+            case ALC_BACKEND_WAKEUP_COUNT_SOFT:
+                *values = static_cast<ALCint64SOFT>(
+                    dev->Backend->mTelemetry.Wakeups.load(std::memory_order_relaxed));
+                break;
+
+            case ALC_BACKEND_MAX_WAKEUP_GAP_SOFT:
+                *values = static_cast<ALCint64SOFT>(
+                    dev->Backend->mTelemetry.MaxWakeGap.load(std::memory_order_relaxed));
+                break;
+
+            case ALC_BACKEND_JITTER_HISTOGRAM_SOFT:
+                if(size < static_cast<ALCsizei>(BackendTelemetry::JitterBuckets))
+                    alcSetError(dev.get(), ALC_INVALID_VALUE);
+                else
+                {
+                    const BackendTelemetry &telemetry = dev->Backend->mTelemetry;
+                    std::transform(std::begin(telemetry.Jitter), std::end(telemetry.Jitter),
+                        values, [](const std::atomic<uint64_t> &count) noexcept -> ALCint64SOFT
+                        { return static_cast<ALCint64SOFT>(count.load(std::memory_order_relaxed)); }
+                    );
+                }
+                break;
+
+            case ALC_BACKEND_LATENCY_SOFT:
+                if(size < 2)
+                    alcSetError(dev.get(), ALC_INVALID_VALUE);
+                else
+                {
+                    /* The latency the backend measures, and what the buffer
+                     * size it reports makes for.
+                     */
+                    std::lock_guard<std::mutex> _{dev->StateLock};
+                    ClockLatency clock{GetClockLatency(dev.get())};
+                    values[0] = clock.Latency.count();
+                    values[1] = (nanoseconds{seconds{dev->BufferSize}}/dev->Frequency +
+                        dev->FixedLatency).count();
+                }
+                break;
+
             default:
                 al::vector<ALCint> ivals(size);
                 size = GetIntegerv(dev.get(), pname, size, ivals.data());
@@ -3433,6 +5003,7 @@ START_API_FUNC
 
     dev->LastError.store(ALC_NO_ERROR);
 
+    al::ArenaScope arena_scope{dev->mArena};
     ContextRef context{new ALCcontext{dev.get()}};
     ALCdevice_IncRef(context->Device);
 
@@ -3446,7 +5017,13 @@ START_API_FUNC
 
         return nullptr;
     }
-    AllocateVoices(context.get(), 256, dev->NumAuxSends);
+    UpdateContextMixParams(context.get(), dev.get());
+    /* Start with one chunk of voices, more get added as sources play. */
+    AllocateVoices(context.get(), VOICE_CHUNK_SIZE, dev->NumAuxSends);
+    /* Preallocate enough voice property containers for every source to have
+     * an update in flight, so typical updates don't need to allocate.
+     */
+    ReserveVoiceProps(context.get(), minu(dev->SourcesMax, MaxPreallocVoiceProps));
 
     if(DefaultEffect.type != AL_EFFECT_NULL && dev->Type == Playback)
     {
@@ -3477,7 +5054,9 @@ START_API_FUNC
             TRACE("volume-adjust gain: %f\n", context->GainBoost);
         }
     }
-    UpdateListenerProps(context.get());
+    UpdateListenerProps(context.get(), context->Listener);
+    for(ALlistener &listener : context->ExtraListeners)
+        UpdateListenerProps(context.get(), listener);
 
     {
         {
@@ -3502,6 +5081,9 @@ START_API_FUNC
             ERR("Failed to initialize the default effect\n");
     }
 
+    if(UNLIKELY(RecordEnabled))
+        RecordCreateContext(context.get());
+
     TRACE("Created context %p\n", context.get());
     return context.get();
 }
@@ -3529,6 +5111,9 @@ START_API_FUNC
     ContextRef ctx{*iter};
     ContextList.erase(iter);
 
+    if(UNLIKELY(RecordEnabled))
+        RecordDestroyContext(ctx.get());
+
     if(ALCdevice *Device{ctx->Device})
     {
         std::lock_guard<std::mutex> _{Device->StateLock};
@@ -3647,6 +5232,39 @@ START_API_FUNC
 END_API_FUNC
 
 
+/* Opens the named playback device as an output mirror, with the playback
+ * backend. It isn't set up for a main device's output until reset.
+ */
+static OutputMirrorPtr OpenOutputMirror(const ALCchar *deviceName)
+{
+    const BackendInfo backendinfo{InitBackend(BackendType::Playback)};
+    if(!backendinfo.name)
+        return nullptr;
+
+    if(deviceName && (!deviceName[0] || strcasecmp(deviceName, alcDefaultName) == 0))
+        deviceName = nullptr;
+
+    OutputMirrorPtr mirror{new OutputMirror{new ALCdevice{Playback}}};
+    ALCdevice *device{mirror->Device.get()};
+    device->Mirror = mirror.get();
+    try {
+        device->Backend = backendinfo.getFactory().createBackend(device,
+            BackendType::Playback);
+        if(device->Backend->open(deviceName) != ALC_NO_ERROR)
+        {
+            WARN("Failed to open output mirror \"%s\"\n", deviceName ? deviceName : "");
+            return nullptr;
+        }
+    }
+    catch(al::backend_exception &e) {
+        WARN("Failed to open output mirror: %s\n", e.what());
+        return nullptr;
+    }
+
+    TRACE("Opened output mirror \"%s\"\n", device->DeviceName.c_str());
+    return mirror;
+}
+
 /* alcOpenDevice
  *
  * Opens the named device.
@@ -3656,7 +5274,8 @@ START_API_FUNC
 {
     DO_INITCONFIG();
 
-    if(!PlaybackBackend.name)
+    const BackendInfo backendinfo{InitBackend(BackendType::Playback)};
+    if(!backendinfo.name)
     {
         alcSetError(nullptr, ALC_INVALID_VALUE);
         return nullptr;
@@ -3680,6 +5299,7 @@ START_API_FUNC
     device->FmtChans = DevFmtChannelsDefault;
     device->FmtType = DevFmtTypeDefault;
     device->Frequency = DEFAULT_OUTPUT_RATE;
+    device->MixFrequency = device->Frequency;
     device->UpdateSize = DEFAULT_UPDATE_SIZE;
     device->BufferSize = DEFAULT_UPDATE_SIZE * DEFAULT_NUM_UPDATES;
     device->LimiterState = ALC_TRUE;
@@ -3690,7 +5310,7 @@ START_API_FUNC
 
     try {
         /* Create the device backend. */
-        device->Backend = PlaybackBackend.getFactory().createBackend(device.get(),
+        device->Backend = backendinfo.getFactory().createBackend(device.get(),
             BackendType::Playback);
 
         /* Find a playback device to open */
@@ -3804,6 +5424,10 @@ START_API_FUNC
             DEFAULT_SENDS, 0, clampi(device->NumAuxSends, 0, MAX_SENDS)
         );
 
+    ALuint poolsize{0u};
+    ConfigValueUInt(deviceName, nullptr, "buffer-pool-size", &poolsize);
+    device->BufferPoolLimit = size_t{poolsize} * 1024u;
+
     device->NumStereoSources = 1;
     device->NumMonoSources = device->SourcesMax - device->NumStereoSources;
 
@@ -3838,6 +5462,25 @@ START_API_FUNC
             ERR("Unsupported ambi-format: %s\n", fmt);
     }
 
+    if(ConfigValueStr(deviceName, nullptr, "mirror-devices", &fmt))
+    {
+        const char *next{fmt};
+        do {
+            const char *name{next};
+            while(isspace(name[0]))
+                name++;
+            next = strchr(name, ',');
+            size_t len{next ? static_cast<size_t>(next-name) : strlen(name)};
+            while(len > 0 && isspace(name[len-1])) --len;
+            if(len == 0) continue;
+
+            const std::string mirrorname{name, len};
+            OutputMirrorPtr mirror{OpenOutputMirror(mirrorname.c_str())};
+            if(mirror)
+                device->Mirrors.emplace_back(std::move(mirror));
+        } while(next++);
+    }
+
     {
         std::lock_guard<std::recursive_mutex> _{ListLock};
         auto iter = std::lower_bound(DeviceList.cbegin(), DeviceList.cend(), device.get());
@@ -3897,6 +5540,7 @@ START_API_FUNC
     if((device->Flags&DEVICE_RUNNING))
         device->Backend->stop();
     device->Flags &= ~DEVICE_RUNNING;
+    device->Mirrors.clear();
     statelock.unlock();
 
     ALCdevice_DecRef(device);
@@ -3914,7 +5558,8 @@ START_API_FUNC
 {
     DO_INITCONFIG();
 
-    if(!CaptureBackend.name)
+    const BackendInfo backendinfo{InitBackend(BackendType::Capture)};
+    if(!backendinfo.name)
     {
         alcSetError(nullptr, ALC_INVALID_VALUE);
         return nullptr;
@@ -3932,6 +5577,7 @@ START_API_FUNC
     DeviceRef device{new ALCdevice{Capture}};
 
     device->Frequency = frequency;
+    device->MixFrequency = device->Frequency;
     device->Flags |= DEVICE_FREQUENCY_REQUEST;
 
     if(DecomposeDevFormat(format, &device->FmtChans, &device->FmtType) == AL_FALSE)
@@ -3945,7 +5591,7 @@ START_API_FUNC
     device->BufferSize = samples;
 
     try {
-        device->Backend = CaptureBackend.getFactory().createBackend(device.get(),
+        device->Backend = backendinfo.getFactory().createBackend(device.get(),
             BackendType::Capture);
 
         TRACE("Capture format: %s, %s, %uhz, %u / %u buffer\n",
@@ -4061,8 +5707,11 @@ START_API_FUNC
 
     ALCenum err{ALC_INVALID_VALUE};
     { std::lock_guard<std::mutex> _{dev->StateLock};
+        /* The capture thread is the ring's reader while a callback is set. */
         BackendBase *backend{dev->Backend.get()};
-        if(samples >= 0 && backend->availableSamples() >= static_cast<ALCuint>(samples))
+        if(dev->CaptureCallback)
+            err = samples ? ALC_INVALID_VALUE : ALC_NO_ERROR;
+        else if(samples >= 0 && backend->availableSamples() >= static_cast<ALCuint>(samples))
             err = backend->captureSamples(buffer, samples);
     }
     if(err != ALC_NO_ERROR)
@@ -4070,6 +5719,41 @@ START_API_FUNC
 }
 END_API_FUNC
 
+/* alcCaptureCallbackSOFT
+ *
+ * Sets a function to be called from the backend's capture thread with each
+ * period of captured audio, in the device's format, instead of it being held
+ * for alcCaptureSamples. A null callback goes back to polling. Capture must
+ * be stopped, and the backend must capture on its own thread.
+ */
+ALC_API ALCboolean ALC_APIENTRY alcCaptureCallbackSOFT(ALCdevice *device, ALCCAPTUREPROCSOFT callback, ALCvoid *userptr)
+START_API_FUNC
+{
+    DeviceRef dev{VerifyDevice(device)};
+    if(!dev || dev->Type != Capture)
+    {
+        alcSetError(dev.get(), ALC_INVALID_DEVICE);
+        return ALC_FALSE;
+    }
+
+    std::lock_guard<std::mutex> _{dev->StateLock};
+    if((dev->Flags&DEVICE_RUNNING))
+    {
+        alcSetError(dev.get(), ALC_INVALID_VALUE);
+        return ALC_FALSE;
+    }
+    if(callback && !dev->Backend->supportsCaptureCallback())
+    {
+        alcSetError(dev.get(), ALC_INVALID_DEVICE);
+        return ALC_FALSE;
+    }
+
+    dev->CaptureCallback = callback;
+    dev->CaptureUserPtr = callback ? userptr : nullptr;
+    return ALC_TRUE;
+}
+END_API_FUNC
+
 
 /************************************************
  * ALC loopback functions
@@ -4102,6 +5786,7 @@ START_API_FUNC
     device->UpdateSize = 0;
 
     device->Frequency = DEFAULT_OUTPUT_RATE;
+    device->MixFrequency = device->Frequency;
     device->FmtChans = DevFmtChannelsDefault;
     device->FmtType = DevFmtTypeDefault;
 
@@ -4117,6 +5802,10 @@ START_API_FUNC
             DEFAULT_SENDS, 0, clampi(device->NumAuxSends, 0, MAX_SENDS)
         );
 
+    ALuint poolsize{0u};
+    ConfigValueUInt(nullptr, nullptr, "buffer-pool-size", &poolsize);
+    device->BufferPoolLimit = size_t{poolsize} * 1024u;
+
     device->NumStereoSources = 1;
     device->NumMonoSources = device->SourcesMax - device->NumStereoSources;
 
@@ -4188,6 +5877,150 @@ START_API_FUNC
 }
 END_API_FUNC
 
+/* alcRenderSamplesPlanarSOFT
+ *
+ * Renders some samples into separate buffers, one for each output channel.
+ * The device must be using float samples, which are written without any
+ * interleaving or conversion.
+ */
+FORCE_ALIGN ALC_API void ALC_APIENTRY alcRenderSamplesPlanarSOFT(ALCdevice *device, ALCvoid **buffers, ALCsizei samples)
+START_API_FUNC
+{
+    DeviceRef dev{VerifyDevice(device)};
+    if(!dev || dev->Type != Loopback)
+        alcSetError(dev.get(), ALC_INVALID_DEVICE);
+    else if(samples < 0 || (samples > 0 && buffers == nullptr))
+        alcSetError(dev.get(), ALC_INVALID_VALUE);
+    else if(dev->FmtType != DevFmtFloat)
+        alcSetError(dev.get(), ALC_INVALID_VALUE);
+    else
+    {
+        BackendLockGuard _{*device->Backend};
+        aluMixDataPlanar(dev.get(), reinterpret_cast<ALfloat*const*>(buffers), samples);
+    }
+}
+END_API_FUNC
+
+/* alcRenderSamplesSparseSOFT
+ *
+ * Renders samples like alcRenderSamplesSOFT, except when the output would be
+ * entirely silent the buffer is left unwritten and ALC_FALSE is returned.
+ * Returns ALC_TRUE when the buffer was written.
+ */
+FORCE_ALIGN ALC_API ALCboolean ALC_APIENTRY alcRenderSamplesSparseSOFT(ALCdevice *device, ALCvoid *buffer, ALCsizei samples)
+START_API_FUNC
+{
+    DeviceRef dev{VerifyDevice(device)};
+    if(!dev || dev->Type != Loopback)
+        alcSetError(dev.get(), ALC_INVALID_DEVICE);
+    else if(samples < 0 || (samples > 0 && buffer == nullptr))
+        alcSetError(dev.get(), ALC_INVALID_VALUE);
+    else
+    {
+        BackendLockGuard _{*device->Backend};
+        if(aluMixDataSparse(dev.get(), buffer, samples))
+            return ALC_TRUE;
+    }
+    return ALC_FALSE;
+}
+END_API_FUNC
+
+/* alcRenderSamplesBatchSOFT
+ *
+ * Renders samples for a list of loopback devices, like calling
+ * alcRenderSamplesSOFT for each in turn, except different devices are
+ * rendered in parallel. A device may be listed more than once, in which case
+ * its renders happen in the order given. Nothing is rendered if any entry is
+ * invalid.
+ */
+FORCE_ALIGN ALC_API void ALC_APIENTRY alcRenderSamplesBatchSOFT(ALCsizei count, ALCdevice *const *devices, ALCvoid *const *buffers, const ALCsizei *samples)
+START_API_FUNC
+{
+    if(count < 0 || (count > 0 && (!devices || !buffers || !samples)))
+    {
+        alcSetError(nullptr, ALC_INVALID_VALUE);
+        return;
+    }
+    if(count == 0) return;
+
+    al::vector<DeviceRef> devs;
+    devs.reserve(static_cast<size_t>(count));
+    for(ALCsizei i{0};i < count;++i)
+    {
+        DeviceRef dev{VerifyDevice(devices[i])};
+        if(!dev || dev->Type != Loopback)
+        {
+            alcSetError(dev.get(), ALC_INVALID_DEVICE);
+            return;
+        }
+        if(samples[i] < 0 || (samples[i] > 0 && buffers[i] == nullptr))
+        {
+            alcSetError(dev.get(), ALC_INVALID_VALUE);
+            return;
+        }
+        devs.emplace_back(std::move(dev));
+    }
+
+    /* Group the entries by device, keeping each device's entries in order, so
+     * a device is only ever rendered by one job.
+     */
+    al::vector<ALCsizei> order(static_cast<size_t>(count));
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(),
+        [&devs](const ALCsizei lhs, const ALCsizei rhs) -> bool
+        { return std::less<ALCdevice*>{}(devs[lhs].get(), devs[rhs].get()); });
+
+    al::vector<size_t> groups;
+    for(size_t i{0};i < order.size();++i)
+    {
+        if(i == 0 || devs[order[i]].get() != devs[order[i-1]].get())
+            groups.emplace_back(i);
+    }
+    groups.emplace_back(order.size());
+
+    auto render_group = [&devs,&order,&groups,buffers,samples](size_t group) -> void
+    {
+        for(size_t i{groups[group]};i < groups[group+1];++i)
+        {
+            const ALCsizei idx{order[i]};
+            ALCdevice *device{devs[idx].get()};
+            BackendLockGuard _{*device->Backend};
+            aluMixData(device, buffers[idx], samples[idx]);
+        }
+    };
+
+    std::lock_guard<std::mutex> _{BatchRenderLock};
+    if(!BatchRenderPoolInit)
+    {
+        BatchRenderPoolInit = true;
+
+        ALint numthreads{static_cast<ALint>(std::thread::hardware_concurrency())};
+        ConfigValueInt(nullptr, nullptr, "batch-render-threads", &numthreads);
+        numthreads = clampi(numthreads, 1, MAX_MIX_THREADS);
+        ALint spinus{DEFAULT_MIX_THREAD_SPIN};
+        ConfigValueInt(nullptr, nullptr, "mix-thread-spin", &spinus);
+        if(numthreads > 1)
+        {
+            try {
+                BatchRenderPool = std::unique_ptr<MixerPool>{
+                    new MixerPool{static_cast<size_t>(numthreads-1),
+                        std::chrono::microseconds{clampi(spinus, 0, 1000)}}};
+                TRACE("Rendering loopback batches with %d threads\n", numthreads);
+            }
+            catch(std::exception &e) {
+                ERR("Failed to start batch render threads: %s\n", e.what());
+            }
+        }
+    }
+
+    const size_t numgroups{groups.size() - 1};
+    if(BatchRenderPool)
+        BatchRenderPool->run(numgroups, render_group);
+    else for(size_t group{0};group < numgroups;++group)
+        render_group(group);
+}
+END_API_FUNC
+
 
 /************************************************
  * ALC DSP pause/resume functions
@@ -4235,6 +6068,7 @@ START_API_FUNC
     if(dev->ContextList.load() == nullptr)
         return;
 
+    dev->Backend->mTelemetry.restart();
     if(dev->Backend->start() == ALC_FALSE)
     {
         aluHandleDisconnect(dev.get(), "Device start failure");
@@ -4295,15 +6129,18 @@ START_API_FUNC
     std::lock_guard<std::mutex> _{dev->StateLock};
     listlock.unlock();
 
-    /* Force the backend to stop mixing first since we're resetting. Also reset
-     * the connected state so lost devices can attempt recover.
+    /* Force a lost device's backend to stop mixing first, and reset the
+     * connected state so it can attempt to recover. A connected device is
+     * left for the reset to hold or stop.
      */
-    if((dev->Flags&DEVICE_RUNNING))
-        dev->Backend->stop();
-    dev->Flags &= ~DEVICE_RUNNING;
-    device->Connected.store(true);
+    if(!dev->Connected.exchange(true))
+    {
+        if((dev->Flags&DEVICE_RUNNING))
+            dev->Backend->stop();
+        dev->Flags &= ~DEVICE_RUNNING;
+    }
 
-    ALCenum err{UpdateDeviceParams(dev.get(), attribs)};
+    ALCenum err{UpdateDeviceParams(dev.get(), attribs, true)};
     if(LIKELY(err == ALC_NO_ERROR)) return ALC_TRUE;
 
     alcSetError(dev.get(), err);
@@ -4312,3 +6149,102 @@ START_API_FUNC
     return ALC_FALSE;
 }
 END_API_FUNC
+
+
+/************************************************
+ * ALC output mirror functions
+ ************************************************/
+
+/* alcAddOutputMirrorSOFT
+ *
+ * Opens another playback device to play the device's output as well, without
+ * mixing it again. The mirror plays in the format it gets closest to the
+ * device's, converted and kept in sync with it, starting from the device's
+ * next reset if it hasn't had one yet.
+ */
+ALC_API ALCboolean ALC_APIENTRY alcAddOutputMirrorSOFT(ALCdevice *device, const ALCchar *deviceName)
+START_API_FUNC
+{
+    std::unique_lock<std::recursive_mutex> listlock{ListLock};
+    DeviceRef dev{VerifyDevice(device)};
+    if(!dev || dev->Type == Capture)
+    {
+        listlock.unlock();
+        alcSetError(dev.get(), ALC_INVALID_DEVICE);
+        return ALC_FALSE;
+    }
+    std::lock_guard<std::mutex> _{dev->StateLock};
+    listlock.unlock();
+
+    OutputMirrorPtr mirror{OpenOutputMirror(deviceName)};
+    if(!mirror)
+    {
+        alcSetError(dev.get(), ALC_INVALID_VALUE);
+        return ALC_FALSE;
+    }
+    if(dev->RealOut.NumChannels > 0 && !mirror->reset(dev.get()))
+    {
+        alcSetError(dev.get(), ALC_INVALID_VALUE);
+        return ALC_FALSE;
+    }
+
+    BackendLockGuard __{*dev->Backend};
+    dev->Mirrors.emplace_back(std::move(mirror));
+    return ALC_TRUE;
+}
+END_API_FUNC
+
+/* alcRemoveOutputMirrorsSOFT
+ *
+ * Stops and closes all of the device's output mirrors.
+ */
+ALC_API ALCboolean ALC_APIENTRY alcRemoveOutputMirrorsSOFT(ALCdevice *device)
+START_API_FUNC
+{
+    std::unique_lock<std::recursive_mutex> listlock{ListLock};
+    DeviceRef dev{VerifyDevice(device)};
+    if(!dev || dev->Type == Capture)
+    {
+        listlock.unlock();
+        alcSetError(dev.get(), ALC_INVALID_DEVICE);
+        return ALC_FALSE;
+    }
+    std::lock_guard<std::mutex> _{dev->StateLock};
+    listlock.unlock();
+
+    /* Take the mirrors from the mixer before closing them, so their backends
+     * aren't stopped with the device's locked.
+     */
+    al::vector<OutputMirrorPtr> mirrors;
+    {
+        BackendLockGuard __{*dev->Backend};
+        mirrors.swap(dev->Mirrors);
+    }
+    mirrors.clear();
+    return ALC_TRUE;
+}
+END_API_FUNC
+
+
+/************************************************
+ * ALC memory allocation functions
+ ************************************************/
+
+/* alcSetAllocatorCallbacksSOFT
+ *
+ * Sets the functions the library allocates memory with, or restores the
+ * default when both are null. Memory already allocated is still freed with
+ * the functions it was allocated with.
+ */
+ALC_API ALCboolean ALC_APIENTRY alcSetAllocatorCallbacksSOFT(ALCALLOCPROCSOFT allocfn, ALCFREEPROCSOFT freefn, ALCvoid *userptr)
+START_API_FUNC
+{
+    if(!allocfn != !freefn)
+    {
+        alcSetError(nullptr, ALC_INVALID_VALUE);
+        return ALC_FALSE;
+    }
+    al_set_allocator(allocfn, freefn, userptr);
+    return ALC_TRUE;
+}
+END_API_FUNC
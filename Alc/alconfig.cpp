@@ -31,6 +31,7 @@
 #include <cstdlib>
 #include <cctype>
 #include <cstring>
+#include <cstdint>
 #ifdef _WIN32_IE
 #include <windows.h>
 #include <shlobj.h>
@@ -54,6 +55,7 @@ namespace {
 struct ConfigEntry {
     std::string key;
     std::string value;
+    uint32_t hash{0u};
 
     template<typename T0, typename T1>
     ConfigEntry(T0&& key_, T1&& val_)
@@ -61,6 +63,104 @@ struct ConfigEntry {
     { }
 };
 al::vector<ConfigEntry> ConfOpts;
+/* Open-addressed hash table of ConfOpts indices (plus one, with 0 for an
+ * empty slot), rebuilt after loading each config file. Lookups happen many
+ * times for each device reset, while the options never change after loading.
+ */
+al::vector<size_t> ConfIndex;
+
+
+/* A key to look up, as up to three parts joined with '/', so the full key
+ * string doesn't need to be built.
+ */
+struct ConfigKey {
+    const char *parts[3];
+    size_t count{0u};
+
+    void add(const char *part) noexcept { parts[count++] = part; }
+
+    std::string join() const
+    {
+        std::string ret;
+        for(size_t i{0u};i < count;++i)
+        {
+            if(i > 0) ret += '/';
+            ret += parts[i];
+        }
+        return ret;
+    }
+};
+
+/* FNV-1a hash of the joined key. */
+uint32_t HashKey(const ConfigKey &key) noexcept
+{
+    uint32_t hash{2166136261u};
+    for(size_t i{0u};i < key.count;++i)
+    {
+        if(i > 0) hash = (hash^static_cast<unsigned char>('/')) * 16777619u;
+        for(const char *c{key.parts[i]};*c;++c)
+            hash = (hash^static_cast<unsigned char>(*c)) * 16777619u;
+    }
+    return hash;
+}
+
+bool KeyMatches(const std::string &str, const ConfigKey &key) noexcept
+{
+    const char *pos{str.c_str()};
+    const char *end{pos + str.length()};
+    for(size_t i{0u};i < key.count;++i)
+    {
+        if(i > 0)
+        {
+            if(pos == end || *pos != '/')
+                return false;
+            ++pos;
+        }
+        const size_t len{strlen(key.parts[i])};
+        if(static_cast<size_t>(end-pos) < len || memcmp(pos, key.parts[i], len) != 0)
+            return false;
+        pos += len;
+    }
+    return pos == end;
+}
+
+void BuildConfigIndex()
+{
+    size_t size{8u};
+    while(size < ConfOpts.size()*2)
+        size <<= 1;
+    ConfIndex.assign(size, 0u);
+
+    const size_t mask{size-1};
+    for(size_t i{0u};i < ConfOpts.size();++i)
+    {
+        ConfigEntry &entry = ConfOpts[i];
+        ConfigKey key;
+        key.add(entry.key.c_str());
+        entry.hash = HashKey(key);
+
+        size_t pos{entry.hash & mask};
+        while(ConfIndex[pos] != 0)
+            pos = (pos+1) & mask;
+        ConfIndex[pos] = i+1;
+    }
+}
+
+const ConfigEntry *FindConfigEntry(const ConfigKey &key) noexcept
+{
+    if(ConfIndex.empty())
+        return nullptr;
+
+    const uint32_t hash{HashKey(key)};
+    const size_t mask{ConfIndex.size()-1};
+    for(size_t pos{hash & mask};ConfIndex[pos] != 0;pos = (pos+1) & mask)
+    {
+        const ConfigEntry &entry = ConfOpts[ConfIndex[pos]-1];
+        if(entry.hash == hash && KeyMatches(entry.key, key))
+            return &entry;
+    }
+    return nullptr;
+}
 
 
 std::string &lstrip(std::string &line)
@@ -279,6 +379,7 @@ void LoadConfigFromFile(std::istream &f)
         TRACE("found '%s' = '%s'\n", ent->key.c_str(), ent->value.c_str());
     }
     ConfOpts.shrink_to_fit();
+    BuildConfigIndex();
 }
 
 } // namespace
@@ -453,43 +554,32 @@ const char *GetConfigValue(const char *devName, const char *blockName, const cha
     if(!keyName)
         return def;
 
-    std::string key;
+    ConfigKey key;
     if(blockName && strcasecmp(blockName, "general") != 0)
     {
-        key = blockName;
+        key.add(blockName);
         if(devName)
-        {
-            key += '/';
-            key += devName;
-        }
-        key += '/';
-        key += keyName;
+            key.add(devName);
+        key.add(keyName);
     }
     else
     {
         if(devName)
-        {
-            key = devName;
-            key += '/';
-        }
-        key += keyName;
+            key.add(devName);
+        key.add(keyName);
     }
 
-    auto iter = std::find_if(ConfOpts.cbegin(), ConfOpts.cend(),
-        [&key](const ConfigEntry &entry) -> bool
-        { return entry.key == key; }
-    );
-    if(iter != ConfOpts.cend())
+    if(const ConfigEntry *entry{FindConfigEntry(key)})
     {
-        TRACE("Found %s = \"%s\"\n", key.c_str(), iter->value.c_str());
-        if(!iter->value.empty())
-            return iter->value.c_str();
+        TRACE("Found %s = \"%s\"\n", key.join().c_str(), entry->value.c_str());
+        if(!entry->value.empty())
+            return entry->value.c_str();
         return def;
     }
 
     if(!devName)
     {
-        TRACE("Key %s not found\n", key.c_str());
+        TRACE("Key %s not found\n", key.join().c_str());
         return def;
     }
     return GetConfigValue(nullptr, blockName, keyName, def);
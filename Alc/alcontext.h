@@ -13,15 +13,24 @@
 
 #include "atomic.h"
 #include "vector.h"
+#include "stablevector.h"
+#include "freemap.h"
 #include "threads.h"
 #include "almalloc.h"
 #include "alnumeric.h"
 
+#include "alMain.h"
+#include "alu.h"
 #include "alListener.h"
+#include "ambirotate.h"
 
 
 struct ALsource;
+struct ALsourceSend;
+struct ALbufferlistitem;
 struct ALeffectslot;
+struct ALsourceGroup;
+struct ALsourceGroupProps;
 struct ALcontextProps;
 struct ALlistenerProps;
 struct ALvoiceProps;
@@ -42,44 +51,138 @@ enum class DistanceModel {
 };
 
 struct SourceSubList {
-    uint64_t FreeMask{~0_u64};
+    std::atomic<uint64_t> FreeMask{~0_u64};
     ALsource *Sources{nullptr}; /* 64 */
+    ALsourceSend *Sends{nullptr}; /* 64 * NumAuxSends */
 
     SourceSubList() noexcept = default;
     SourceSubList(const SourceSubList&) = delete;
-    SourceSubList(SourceSubList&& rhs) noexcept : FreeMask{rhs.FreeMask}, Sources{rhs.Sources}
-    { rhs.FreeMask = ~0_u64; rhs.Sources = nullptr; }
     ~SourceSubList();
 
     SourceSubList& operator=(const SourceSubList&) = delete;
-    SourceSubList& operator=(SourceSubList&& rhs) noexcept
-    { std::swap(FreeMask, rhs.FreeMask); std::swap(Sources, rhs.Sources); return *this; }
+};
+
+struct SourceGroupSubList {
+    std::atomic<uint64_t> FreeMask{~0_u64};
+    ALsourceGroup *Groups{nullptr}; /* 64 */
+
+    SourceGroupSubList() noexcept = default;
+    SourceGroupSubList(const SourceGroupSubList&) = delete;
+    ~SourceGroupSubList();
+
+    SourceGroupSubList& operator=(const SourceGroupSubList&) = delete;
 };
 
 struct EffectSlotSubList {
-    uint64_t FreeMask{~0_u64};
+    std::atomic<uint64_t> FreeMask{~0_u64};
     ALeffectslot *EffectSlots{nullptr}; /* 64 */
 
     EffectSlotSubList() noexcept = default;
     EffectSlotSubList(const EffectSlotSubList&) = delete;
-    EffectSlotSubList(EffectSlotSubList&& rhs) noexcept
-      : FreeMask{rhs.FreeMask}, EffectSlots{rhs.EffectSlots}
-    { rhs.FreeMask = ~0_u64; rhs.EffectSlots = nullptr; }
     ~EffectSlotSubList();
 
     EffectSlotSubList& operator=(const EffectSlotSubList&) = delete;
-    EffectSlotSubList& operator=(EffectSlotSubList&& rhs) noexcept
-    { std::swap(FreeMask, rhs.FreeMask); std::swap(EffectSlots, rhs.EffectSlots); return *this; }
+};
+
+/* Largest buffer queue item, in buffers, a context keeps for reuse after it's
+ * unqueued. Bigger layered items are rare enough to allocate as needed.
+ */
+#define MAX_POOLED_QUEUE_BUFFERS 8
+
+/* How much each thread mixing a context's voices can record of them in an
+ * update, in commands and samples. Voices that don't fit are mixed after the
+ * others, by the thread running the update.
+ */
+#define VOICE_LOG_COMMANDS 4096
+#define VOICE_LOG_SAMPLES (BUFFERSIZE*256)
+
+/* Storage for a pool thread mixing some of a context's voices, which it
+ * records the voices' output to.
+ */
+struct VoiceMixThread {
+    MixerScratch Scratch;
+    VoiceMixLog Log;
+
+    VoiceMixThread() { Scratch.Log = &Log; }
+    VoiceMixThread(const VoiceMixThread&) = delete;
+    VoiceMixThread& operator=(const VoiceMixThread&) = delete;
+
+    DEF_NEWDEL(VoiceMixThread)
+};
+
+/* Maximum number of voice clusters a context mixes each update. Voices in
+ * other directions are mixed individually.
+ */
+#define MAX_VOICE_CLUSTERS 32
+
+/* Accumulates the voices in one direction bucket, to be panned together. */
+struct VoiceCluster {
+    alignas(16) ALfloat Samples[BUFFERSIZE];
+    ALuint Key;
+    ALsizei Count;
+};
+
+/* Maximum number of voice instances a context mixes each update, and the most
+ * channels an instanced voice may have.
+ */
+#define MAX_VOICE_INSTANCES 16
+#define MAX_INSTANCE_CHANNELS 2
+
+/* The resampled samples of voices playing the same buffer at the same step and
+ * position, resampled once by the instance's leader and shared by the rest.
+ */
+struct VoiceInstance {
+    alignas(16) ALfloat Samples[MAX_INSTANCE_CHANNELS][BUFFERSIZE];
+    ALvoice *Leader;
+    ALsizei Count;
+};
+
+struct VoiceInstanceArray {
+    VoiceInstance Items[MAX_VOICE_INSTANCES];
+    size_t Count{0};
+
+    DEF_NEWDEL(VoiceInstanceArray)
+};
+
+/* An object replaced while the mixer may still be using it, with the device's
+ * mix count from when it was replaced.
+ */
+struct RetiredObject {
+    void *Ptr;
+    void (*Free)(void *ptr);
+    ALuint MixCount;
 };
 
 struct ALCcontext {
     RefCount ref{1u};
 
-    al::vector<SourceSubList> SourceList;
+    al::stable_vector<SourceSubList> SourceList;
+    al::sublist_freemap SourceFreeMap;
     ALuint NumSources{0};
     std::mutex SourceLock;
+    /* Unqueued buffer queue items kept for reuse by any source, with a list
+     * for each item capacity up to MAX_POOLED_QUEUE_BUFFERS. Guarded by
+     * SourceLock, same as the source queues.
+     */
+    ALbufferlistitem *FreeQueueItems[MAX_POOLED_QUEUE_BUFFERS]{};
+
+    al::stable_vector<SourceGroupSubList> SourceGroupList;
+    al::sublist_freemap SourceGroupFreeMap;
+    ALuint NumSourceGroups{0u};
+    std::mutex SourceGroupLock;
+    /* Set when a source group's properties are updated, so the mixer applies
+     * the update and updates the voices in groups. The mixer sets it again
+     * while an update's batch isn't committed.
+     */
+    std::atomic<bool> SourceGroupsChanged{false};
+    std::atomic<ALsourceGroupProps*> FreeSourceGroupProps{nullptr};
+    /* The device's linked filter generation the mixer last updated the
+     * voices for. Only used by the mixer.
+     */
+    ALuint LinkedFilterGen{0u};
 
-    al::vector<EffectSlotSubList> EffectSlotList;
+    al::stable_vector<EffectSlotSubList> EffectSlotList;
+    al::sublist_freemap EffectSlotFreeMap;
     ALuint NumEffectSlots{0u};
     std::mutex EffectSlotLock;
 
@@ -98,11 +201,14 @@ struct ALCcontext {
 
     std::mutex PropLock;
 
-    /* Counter for the pre-mixing updates, in 31.1 fixed point (lowest bit
-     * indicates if updates are currently happening).
+    /* Property updates are tagged with the batch they're published in, and
+     * the mixer leaves those from a batch past CommittedBatch pending. Deferred
+     * updates are published in a new batch that's committed once all of them
+     * are set, so the mixer applies them together without either side waiting
+     * on the other.
      */
-    RefCount UpdateCount{0u};
-    std::atomic<bool> HoldUpdates{false};
+    std::atomic<ALuint> PublishBatch{0u};
+    std::atomic<ALuint> CommittedBatch{0u};
 
     ALfloat GainBoost{1.0f};
 
@@ -115,32 +221,138 @@ struct ALCcontext {
     std::atomic<ALlistenerProps*> FreeListenerProps{nullptr};
     std::atomic<ALvoiceProps*> FreeVoiceProps{nullptr};
     std::atomic<ALeffectslotProps*> FreeEffectslotProps{nullptr};
+    /* Set by the mixer when it leaves an effect state to be released in a
+     * property object it puts in the freelist.
+     */
+    std::atomic<bool> EffectStatesRetired{false};
+
+    /* The storage the voice property containers are constructed in. They're
+     * allocated in chunks that are kept until the context is destroyed, with
+     * VoicePropMisses counting how often the freelist ran dry and needed
+     * another chunk.
+     */
+    std::mutex VoicePropLock;
+    al::vector<void*> VoicePropChunks;
+    size_t NumVoiceProps{0u};
+    std::atomic<ALuint> VoicePropMisses{0u};
 
     ALvoice **Voices{nullptr};
     std::atomic<ALsizei> VoiceCount{0};
     ALsizei MaxVoices{0};
+    /* The number of voice pointers the Voices array has room for. */
+    ALsizei VoiceCapacity{0};
+    /* The storage the voices are constructed in. Adding voices adds a chunk
+     * instead of moving the existing ones, so voices only move when the
+     * device's send count, gain count, or HRTF/NFC use changes.
+     */
+    al::vector<void*> VoiceChunks;
+    /* Whether the voices have HRTF and NFC state allocated. */
+    bool VoiceHrtf{false};
+    bool VoiceNfc{false};
+    /* The number of gains allocated for each voice parameter. */
+    ALsizei VoiceGains{0};
+    /* Where the search for an unused voice resumes, just past the last one
+     * taken.
+     */
+    ALsizei NextVoiceIdx{0};
+    /* Storage for ranking the active voices, when the device has a voice
+     * budget. Sized to MaxVoices.
+     */
+    al::vector<ALvoice*> VoiceRanking;
 
     using ALeffectslotArray = al::FlexArray<ALeffectslot*>;
     std::atomic<ALeffectslotArray*> ActiveAuxSlots{nullptr};
 
-    std::thread EventThread;
-    al::semaphore EventSem;
+    /* Objects retired with RetireObject, which are freed by a later call once
+     * the mixer is past the update that may have used them.
+     */
+    std::mutex RetiredLock;
+    al::vector<RetiredObject> RetiredObjects;
+
+    /* Created when events are first enabled, which adds the context to the
+     * event thread shared by all contexts.
+     */
     std::unique_ptr<RingBuffer> AsyncEvents;
     std::atomic<ALbitfieldSOFT> EnabledEvts{0u};
     std::mutex EventCbLock;
     ALEVENTPROCSOFT EventCb{};
     void *EventParam{nullptr};
+    /* Set instead of EventCb to get each batch of pending events in one call,
+     * with their messages only if EventBatchMessages is set.
+     */
+    ALEVENTBATCHPROCSOFT EventBatchCb{};
+    void *EventBatchParam{nullptr};
+    bool EventBatchMessages{false};
+    /* Signaled by the mixer when any source completes a buffer. Created when
+     * the application first asks for its handle.
+     */
+    std::atomic<al::wakeup_handle*> CompletionWakeup{nullptr};
 
     /* Default effect slot */
     std::unique_ptr<ALeffectslot> DefaultSlot;
 
+    /* Mixing targets for this context's voices and effects, referencing the
+     * device's mixing buffers.
+     */
+    MixParams Dry;
+    RealMixParams RealOut;
+    std::unique_ptr<MixerScratch> Scratch;
+    /* The effect slots, and whether any were retargeted, from the context's
+     * property updates when they're processed ahead of mixing.
+     */
+    const ALeffectslotArray *MixAuxSlots{nullptr};
+    bool MixRetarget{false};
+
+    /* With world-space panning, voices that are only panned to the dry mix
+     * instead go to this bus, with the same layout, which WorldRotator
+     * rotates into the dry mix for the listener's orientation. World.Buffer
+     * is null otherwise.
+     */
+    MixParams World;
+    al::vector<std::array<ALfloat,BUFFERSIZE>, 16> WorldBuffer;
+    ChannelMask WorldTouched{0u};
+    std::unique_ptr<AmbiRotator> WorldRotator;
+
+    /* One for each of the device's mixer pool threads (including the one
+     * running the update), used when the context's voices are split between
+     * threads.
+     */
+    al::vector<std::unique_ptr<VoiceMixThread>> VoiceThreads;
+
+    /* Clusters of voices sharing a direction, when the device clusters voices
+     * (empty otherwise). Only voices mixed on the calling thread are
+     * clustered.
+     */
+    al::vector<VoiceCluster, 16> Clusters;
+    size_t NumClusters{0};
+    /* Instances of voices sharing resampled samples. Created when a source
+     * first allows instancing.
+     */
+    std::atomic<VoiceInstanceArray*> Instances{nullptr};
+    /* Serializes event writes from voices being mixed on different threads. */
+    std::atomic_flag EventWriteLock = ATOMIC_FLAG_INIT;
+
+    /* Time spent processing the context's effect slots each quantum. */
+    ProcessTimeStats EffectsTime;
+    /* Set while the effects are over the device's budget, making effect slots
+     * with default quality use low quality. EffectsQualityChanged tells the
+     * mixer to update the slots when it toggles, and EffectsUnderBudget
+     * counts the samples the effects have been well under budget for.
+     */
+    std::atomic<bool> EffectsDowngraded{false};
+    bool EffectsQualityChanged{false};
+    ALuint EffectsUnderBudget{0u};
+
     ALCdevice *const Device;
     const ALCchar *ExtensionList{nullptr};
 
     std::atomic<ALCcontext*> next{nullptr};
 
     ALlistener Listener{};
-
+    /* The context's other listeners, each mixing the voices to a pair of the
+     * output channels, for split-screen play.
+     */
+    std::array<ALlistener,MAX_LISTENERS-1> ExtraListeners;
 
     ALCcontext(ALCdevice *device);
     ALCcontext(const ALCcontext&) = delete;
@@ -151,6 +363,7 @@ struct ALCcontext {
     DEF_NEWDEL(ALCcontext)
 };
 
+void ALCcontext_IncRef(ALCcontext *context);
 void ALCcontext_DecRef(ALCcontext *context);
 
 void UpdateContextProps(ALCcontext *context);
@@ -158,41 +371,99 @@ void UpdateContextProps(ALCcontext *context);
 void ALCcontext_DeferUpdates(ALCcontext *context);
 void ALCcontext_ProcessUpdates(ALCcontext *context);
 
+/* Frees the given object with freefunc once the mixer can no longer be using
+ * it, after it's been replaced in whatever the mixer reads it from. Instead
+ * of waiting for the mixer, it's kept until a later call (or the context's
+ * destruction) finds the mixer has moved on. Any earlier retired objects the
+ * mixer is done with are freed now.
+ */
+void RetireObject(ALCcontext *context, void *ptr, void (*freefunc)(void*));
+
+
+/* A thread's hazard slot, which keeps the global context it holds from being
+ * deleted without taking a reference on it. Deleting a context that's in a
+ * hazard slot is deferred until the slot is cleared.
+ */
+struct ContextHazard {
+    std::atomic<ALCcontext*> Context{nullptr};
+    std::atomic<bool> InUse{true};
+    ContextHazard *Next{nullptr};
+};
+void ClearContextHazard(ContextHazard *hazard) noexcept;
+
 
 /* Simple RAII context reference. Takes the reference of the provided
  * ALCcontext, and decrements it when leaving scope. Movable (transfer
  * reference) but not copyable (no new references).
+ *
+ * GetContextRef can also give one that holds the context without a reference,
+ * either borrowed from the calling thread's own context or protected by the
+ * thread's hazard slot, which avoids atomically modifying the context's
+ * reference count for every AL call. These must not outlive the call.
  */
 class ContextRef {
     ALCcontext *mCtx{nullptr};
+    ContextHazard *mHazard{nullptr};
+    bool mBorrowed{false};
 
     void reset() noexcept
     {
-        if(mCtx)
+        if(mHazard)
+            ClearContextHazard(mHazard);
+        else if(mCtx && !mBorrowed)
             ALCcontext_DecRef(mCtx);
         mCtx = nullptr;
+        mHazard = nullptr;
+        mBorrowed = false;
     }
 
 public:
     ContextRef() noexcept = default;
-    ContextRef(ContextRef&& rhs) noexcept : mCtx{rhs.mCtx}
-    { rhs.mCtx = nullptr; }
+    ContextRef(ContextRef&& rhs) noexcept
+      : mCtx{rhs.mCtx}, mHazard{rhs.mHazard}, mBorrowed{rhs.mBorrowed}
+    { rhs.mCtx = nullptr; rhs.mHazard = nullptr; rhs.mBorrowed = false; }
     explicit ContextRef(ALCcontext *ctx) noexcept : mCtx(ctx) { }
+    /* Holds the context protected by the hazard slot. */
+    ContextRef(ALCcontext *ctx, ContextHazard *hazard) noexcept
+      : mCtx{ctx}, mHazard{hazard}, mBorrowed{true}
+    { }
     ~ContextRef() { reset(); }
 
+    /* Holds the context without a reference, for the calling thread's own
+     * context.
+     */
+    static ContextRef borrow(ALCcontext *ctx) noexcept
+    {
+        ContextRef ret{ctx};
+        ret.mBorrowed = true;
+        return ret;
+    }
+
     ContextRef& operator=(const ContextRef&) = delete;
     ContextRef& operator=(ContextRef&& rhs) noexcept
-    { std::swap(mCtx, rhs.mCtx); return *this; }
+    {
+        std::swap(mCtx, rhs.mCtx);
+        std::swap(mHazard, rhs.mHazard);
+        std::swap(mBorrowed, rhs.mBorrowed);
+        return *this;
+    }
 
     operator bool() const noexcept { return mCtx != nullptr; }
 
     ALCcontext* operator->() noexcept { return mCtx; }
     ALCcontext* get() noexcept { return mCtx; }
 
+    /* Returns the context with a reference for the caller to own. */
     ALCcontext* release() noexcept
     {
         ALCcontext *ret{mCtx};
+        if(ret && mBorrowed)
+            ALCcontext_IncRef(ret);
+        if(mHazard)
+            ClearContextHazard(mHazard);
         mCtx = nullptr;
+        mHazard = nullptr;
+        mBorrowed = false;
         return ret;
     }
 };
@@ -208,6 +479,8 @@ struct ALcontextProps {
     DistanceModel mDistanceModel;
     ALfloat MetersPerUnit;
 
+    ALuint Batch;
+
     std::atomic<ALcontextProps*> next;
 };
 
@@ -20,6 +20,10 @@
 
 #include "config.h"
 
+#ifdef HAVE_SSE_INTRINSICS
+#include <xmmintrin.h>
+#endif
+
 #include <math.h>
 #include <stdlib.h>
 #include <string.h>
@@ -27,6 +31,7 @@
 #include <assert.h>
 
 #include <cmath>
+#include <chrono>
 #include <limits>
 #include <numeric>
 #include <algorithm>
@@ -38,16 +43,27 @@
 #include "alBuffer.h"
 #include "alListener.h"
 #include "alAuxEffectSlot.h"
+#include "alSourceGroup.h"
+#include "alFilter.h"
 #include "alu.h"
-#include "bs2b.h"
 #include "hrtf.h"
 #include "mastering.h"
+#ifdef ALSOFT_BS2B
+#include "bs2b.h"
+#endif
+#ifdef ALSOFT_UHJ
 #include "uhjfilter.h"
+#endif
 #include "bformatdec.h"
 #include "ringbuffer.h"
+#include "altrace.h"
+#include "converter.h"
+#include "mirror.h"
+#include "mixerpool.h"
 #include "filters/splitter.h"
 
 #include "mixer/defs.h"
+#include "mixer/kernels.h"
 #include "fpu_modes.h"
 #include "cpu_caps.h"
 #include "bsinc_inc.h"
@@ -98,11 +114,6 @@ const ALboolean OverrideReverbSpeedOfSound{InitReverbSOS()};
 
 namespace {
 
-void ClearArray(ALfloat (&f)[MAX_OUTPUT_CHANNELS])
-{
-    std::fill(std::begin(f), std::end(f), 0.0f);
-}
-
 struct ChanMap {
     Channel channel;
     ALfloat angle;
@@ -111,18 +122,7 @@ struct ChanMap {
 
 HrtfDirectMixerFunc MixDirectHrtf = MixDirectHrtf_<CTag>;
 inline HrtfDirectMixerFunc SelectHrtfMixer(void)
-{
-#ifdef HAVE_NEON
-    if((CPUCapFlags&CPU_CAP_NEON))
-        return MixDirectHrtf_<NEONTag>;
-#endif
-#ifdef HAVE_SSE
-    if((CPUCapFlags&CPU_CAP_SSE))
-        return MixDirectHrtf_<SSETag>;
-#endif
-
-    return MixDirectHrtf_<CTag>;
-}
+{ return GetDirectHrtfMixerOptions().best(); }
 
 
 void ProcessHrtf(ALCdevice *device, const ALsizei SamplesToDo)
@@ -134,16 +134,17 @@ void ProcessHrtf(ALCdevice *device, const ALsizei SamplesToDo)
 
     DirectHrtfState *state{device->mHrtfState.get()};
     MixDirectHrtf(device->RealOut.Buffer[lidx], device->RealOut.Buffer[ridx], device->Dry.Buffer,
-        device->HrtfAccumData, state, device->Dry.NumChannels, SamplesToDo);
+        device->Scratch.HrtfAccumData, state, device->Dry.NumChannels, SamplesToDo);
 }
 
 void ProcessAmbiDec(ALCdevice *device, const ALsizei SamplesToDo)
 {
     BFormatDec *ambidec{device->AmbiDecoder.get()};
     ambidec->process(device->RealOut.Buffer, device->RealOut.NumChannels, device->Dry.Buffer,
-        SamplesToDo);
+        *device->Dry.Touched, SamplesToDo);
 }
 
+#ifdef ALSOFT_UHJ
 void ProcessUhj(ALCdevice *device, const ALsizei SamplesToDo)
 {
     /* UHJ is stereo output only. */
@@ -156,7 +157,9 @@ void ProcessUhj(ALCdevice *device, const ALsizei SamplesToDo)
     uhj2enc->encode(device->RealOut.Buffer[lidx], device->RealOut.Buffer[ridx],
         device->Dry.Buffer, SamplesToDo);
 }
+#endif
 
+#ifdef ALSOFT_BS2B
 void ProcessBs2b(ALCdevice *device, const ALsizei SamplesToDo)
 {
     /* BS2B is stereo output only. */
@@ -168,6 +171,7 @@ void ProcessBs2b(ALCdevice *device, const ALsizei SamplesToDo)
     bs2b_cross_feed(device->Bs2b.get(), device->RealOut.Buffer[lidx],
                     device->RealOut.Buffer[ridx], SamplesToDo);
 }
+#endif
 
 } // namespace
 
@@ -179,7 +183,8 @@ void aluInit(void)
 
 void DeinitVoice(ALvoice *voice) noexcept
 {
-    delete voice->mUpdate.exchange(nullptr, std::memory_order_acq_rel);
+    /* Any pending update belongs to the context's voice property pool. */
+    voice->mUpdate.store(nullptr, std::memory_order_relaxed);
     voice->~ALvoice();
 }
 
@@ -190,10 +195,14 @@ void aluSelectPostProcess(ALCdevice *device)
         device->PostProcess = ProcessHrtf;
     else if(device->AmbiDecoder)
         device->PostProcess = ProcessAmbiDec;
+#ifdef ALSOFT_UHJ
     else if(device->Uhj_Encoder)
         device->PostProcess = ProcessUhj;
+#endif
+#ifdef ALSOFT_BS2B
     else if(device->Bs2b)
         device->PostProcess = ProcessBs2b;
+#endif
     else
         device->PostProcess = nullptr;
 }
@@ -229,19 +238,23 @@ void BsincPrepare(const ALuint increment, BsincState *state, const BSincTable *t
 }
 
 
-namespace {
-
-/* This RNG method was created based on the math found in opusdec. It's quick,
- * and starting with a seed value of 22222, is suitable for generating
- * whitenoise.
- */
-inline ALuint dither_rng(ALuint *seed) noexcept
+void ClearTouchedChannels(ALfloat (*Buffer)[BUFFERSIZE], ChannelMask *touched,
+    const ALsizei SamplesToDo)
 {
-    *seed = (*seed * 96314165) + 907633515;
-    return *seed;
+    ChannelMask todo{*touched};
+    *touched = 0u;
+    while(todo)
+    {
+        const int c{CTZ64(todo)};
+        todo &= todo-1;
+
+        std::fill_n(Buffer[c], SamplesToDo, 0.0f);
+    }
 }
 
 
+namespace {
+
 inline alu::Vector aluCrossproduct(const alu::Vector &in1, const alu::Vector &in2)
 {
     return alu::Vector{
@@ -269,34 +282,101 @@ alu::Vector operator*(const alu::Matrix &mtx, const alu::Vector &vec) noexcept
 }
 
 
-bool CalcContextParams(ALCcontext *Context)
+/* Takes the pending update container, unless it's from a batch that hasn't
+ * been committed yet. The container is taken before its batch is checked,
+ * since a container the app replaces can be reused for a later update while
+ * it's being checked. One from an uncommitted batch is put back, after being
+ * combined with any newer one the app set in the meantime.
+ */
+template<typename T, typename BatchGetter, typename Combiner>
+T *TakeCommittedUpdate(std::atomic<T*> &update, const ALuint committed, BatchGetter get_batch,
+    Combiner combine)
+{
+    if(!update.load(std::memory_order_relaxed))
+        return nullptr;
+    T *props{update.exchange(nullptr, std::memory_order_acq_rel)};
+    if(!props || static_cast<ALint>(get_batch(props) - committed) <= 0)
+        return props;
+
+    T *newer{nullptr};
+    while(!update.compare_exchange_weak(newer, props, std::memory_order_acq_rel,
+        std::memory_order_acquire))
+    {
+        if(newer)
+            props = combine(props, update.exchange(nullptr, std::memory_order_acq_rel));
+        newer = nullptr;
+    }
+    return nullptr;
+}
+
+/* A combiner for TakeCommittedUpdate, for containers that hold all of the
+ * object's properties, so a newer one replaces the older.
+ */
+template<typename T>
+struct ReplaceUpdate {
+    std::atomic<T*> &mFreeList;
+
+    T *operator()(T *older, T *newer) const noexcept
+    {
+        AtomicReplaceHead(mFreeList, older);
+        return newer;
+    }
+};
+template<typename T>
+inline ReplaceUpdate<T> MakeReplaceUpdate(std::atomic<T*> &freelist) noexcept
+{ return ReplaceUpdate<T>{freelist}; }
+
+bool CalcContextParams(ALCcontext *Context, const ALuint committed)
 {
-    ALcontextProps *props{Context->Update.exchange(nullptr, std::memory_order_acq_rel)};
+    ALcontextProps *props{TakeCommittedUpdate(Context->Update, committed,
+        [](const ALcontextProps *p) noexcept { return p->Batch; },
+        MakeReplaceUpdate(Context->FreeContextProps))};
     if(!props) return false;
 
-    ALlistener &Listener = Context->Listener;
-    Listener.Params.MetersPerUnit = props->MetersPerUnit;
+    auto set_params = [props](ALlistener &Listener) noexcept -> void
+    {
+        Listener.Params.MetersPerUnit = props->MetersPerUnit;
 
-    Listener.Params.DopplerFactor = props->DopplerFactor;
-    Listener.Params.SpeedOfSound = props->SpeedOfSound * props->DopplerVelocity;
-    if(!OverrideReverbSpeedOfSound)
-        Listener.Params.ReverbSpeedOfSound = Listener.Params.SpeedOfSound *
-                                             Listener.Params.MetersPerUnit;
+        Listener.Params.DopplerFactor = props->DopplerFactor;
+        Listener.Params.SpeedOfSound = props->SpeedOfSound * props->DopplerVelocity;
+        if(!OverrideReverbSpeedOfSound)
+            Listener.Params.ReverbSpeedOfSound = Listener.Params.SpeedOfSound *
+                                                 Listener.Params.MetersPerUnit;
 
-    Listener.Params.SourceDistanceModel = props->SourceDistanceModel;
-    Listener.Params.mDistanceModel = props->mDistanceModel;
+        Listener.Params.SourceDistanceModel = props->SourceDistanceModel;
+        Listener.Params.mDistanceModel = props->mDistanceModel;
+    };
+    set_params(Context->Listener);
+    std::for_each(Context->ExtraListeners.begin(), Context->ExtraListeners.end(), set_params);
 
     AtomicReplaceHead(Context->FreeContextProps, props);
     return true;
 }
 
-bool CalcListenerParams(ALCcontext *Context)
+/* Returns true if the listener changed. If turnonly is given, it's set to
+ * whether only the listener's orientation changed.
+ */
+bool CalcListenerParams(ALCcontext *Context, ALlistener &Listener, const ALuint committed,
+    bool *turnonly=nullptr)
 {
-    ALlistener &Listener = Context->Listener;
-
-    ALlistenerProps *props{Listener.Update.exchange(nullptr, std::memory_order_acq_rel)};
+    ALlistenerProps *props{TakeCommittedUpdate(Listener.Update, committed,
+        [](const ALlistenerProps *p) noexcept { return p->Batch; },
+        MakeReplaceUpdate(Context->FreeListenerProps))};
     if(!props) return false;
 
+    if(turnonly)
+    {
+        const auto &params = Listener.Params;
+        *turnonly = params.Position[0] == props->Position[0]
+            && params.Position[1] == props->Position[1]
+            && params.Position[2] == props->Position[2]
+            && params.WorldVelocity[0] == props->Velocity[0]
+            && params.WorldVelocity[1] == props->Velocity[1]
+            && params.WorldVelocity[2] == props->Velocity[2]
+            && params.Gain == props->Gain*Context->GainBoost
+            && params.OutputChannel == props->OutputChannel;
+    }
+
     /* AT then UP */
     alu::Vector N{props->OrientAt[0], props->OrientAt[1], props->OrientAt[2], 0.0f};
     N.normalize();
@@ -316,19 +396,34 @@ bool CalcListenerParams(ALCcontext *Context)
     const alu::Vector P{Listener.Params.Matrix *
         alu::Vector{props->Position[0], props->Position[1], props->Position[2], 1.0f}};
     Listener.Params.Matrix.setRow(3, -P[0], -P[1], -P[2], 1.0f);
+    Listener.Params.Position = alu::Vector{props->Position[0], props->Position[1],
+        props->Position[2], 1.0f};
 
     const alu::Vector vel{props->Velocity[0], props->Velocity[1], props->Velocity[2], 0.0f};
     Listener.Params.Velocity = Listener.Params.Matrix * vel;
+    Listener.Params.WorldVelocity = vel;
 
     Listener.Params.Gain = props->Gain * Context->GainBoost;
+    Listener.Params.OutputChannel = props->OutputChannel;
 
     AtomicReplaceHead(Context->FreeListenerProps, props);
     return true;
 }
 
-bool CalcEffectSlotParams(ALeffectslot *slot, ALCcontext *context, bool force)
+bool CalcEffectSlotParams(ALeffectslot *slot, ALCcontext *context, const ALuint committed,
+    bool force)
 {
-    ALeffectslotProps *props{slot->Update.exchange(nullptr, std::memory_order_acq_rel)};
+    /* A replaced container's effect state is left for the app thread to
+     * release, as it may be the last reference.
+     */
+    ALeffectslotProps *props{TakeCommittedUpdate(slot->Update, committed,
+        [](const ALeffectslotProps *p) noexcept { return p->Batch; },
+        [context](ALeffectslotProps *older, ALeffectslotProps *newer) noexcept -> ALeffectslotProps*
+        {
+            AtomicReplaceHead(context->FreeEffectslotProps, older);
+            context->EffectStatesRetired.store(true, std::memory_order_release);
+            return newer;
+        })};
     if(!props && !force) return false;
 
     EffectState *state;
@@ -339,6 +434,13 @@ bool CalcEffectSlotParams(ALeffectslot *slot, ALCcontext *context, bool force)
         slot->Params.Gain = props->Gain;
         slot->Params.AuxSendAuto = props->AuxSendAuto;
         slot->Params.Target = props->Target;
+        slot->Params.Quality = props->Quality;
+        if(slot->Params.EffectType != props->Type || !slot->Params.mFactory)
+        {
+            slot->Params.mFactory = getFactoryByType(props->Type);
+            slot->Wet.NumChannels = GetEffectSlotInputChannels(slot->Params.mFactory,
+                context->Device);
+        }
         slot->Params.EffectType = props->Type;
         slot->Params.mEffectProps = props->Props;
         if(IsReverbEffect(props->Type))
@@ -378,43 +480,29 @@ bool CalcEffectSlotParams(ALeffectslot *slot, ALCcontext *context, bool force)
              */
         }
 
+        /* Otherwise, if it would be deleted, leave it in the property object
+         * for the app thread to release with its next update.
+         */
         if(oldval < 2)
-        {
-            /* Otherwise, if it would be deleted, send it off with a release
-             * event.
-             */
-            RingBuffer *ring{context->AsyncEvents.get()};
-            auto evt_vec = ring->getWriteVector();
-            if(LIKELY(evt_vec.first.len > 0))
-            {
-                AsyncEvent *evt{new (evt_vec.first.buf) AsyncEvent{EventType_ReleaseEffectState}};
-                evt->u.mEffectState = oldstate;
-                ring->writeAdvance(1);
-                context->EventSem.post();
-            }
-            else
-            {
-                /* If writing the event failed, the queue was probably full.
-                 * Store the old state in the property object where it can
-                 * eventually be cleaned up sometime later (not ideal, but
-                 * better than blocking or leaking).
-                 */
-                props->State = oldstate;
-            }
-        }
+            props->State = oldstate;
 
         AtomicReplaceHead(context->FreeEffectslotProps, props);
+        if(oldval < 2)
+            context->EffectStatesRetired.store(true, std::memory_order_release);
     }
 
     EffectTarget output;
     if(ALeffectslot *target{slot->Params.Target})
         output = EffectTarget{&target->Wet, nullptr};
     else
-    {
-        ALCdevice *device{context->Device};
-        output = EffectTarget{&device->Dry, &device->RealOut};
-    }
+        output = EffectTarget{&context->Dry, &context->RealOut};
     state->update(context, slot, &slot->Params.mEffectProps, output);
+
+    /* Find which mask tracks the output buffer the effect chose. */
+    if(output.RealOut && state->mOutBuffer == output.RealOut->Buffer)
+        state->mOutTouched = output.RealOut->Touched;
+    else
+        state->mOutTouched = output.Main->Touched;
     return true;
 }
 
@@ -430,12 +518,98 @@ inline float ScaleAzimuthFront(float azimuth, float scale)
     return azimuth;
 }
 
+/* Voices are clustered in direction buckets about the device's cluster angle
+ * in size. The buckets are laid out in rings of elevation, with the number of
+ * buckets in each ring scaled by its circumference, so the key gives the ring
+ * in the upper 16 bits and the bucket within the ring in the lower 16 (plus
+ * one, so 0 is never a valid key).
+ */
+inline ALint ClusterRingCount(const ALfloat step) noexcept
+{ return maxi(fastf2i(al::MathDefs<float>::Pi()*0.5f / step), 1); }
+
+inline ALint ClusterRingSize(const ALfloat step, const ALfloat elev) noexcept
+{ return maxi(fastf2i(al::MathDefs<float>::Tau()*std::cos(elev) / step), 1); }
+
+ALuint CalcClusterKey(const ALfloat step, const ALfloat azimuth, const ALfloat elevation)
+{
+    const ALint rings{ClusterRingCount(step)};
+    const ALfloat ringstep{al::MathDefs<float>::Pi()*0.5f / static_cast<ALfloat>(rings)};
+    const ALint ring{clampi(fastf2i(elevation / ringstep), -rings, rings)};
+
+    const ALint count{ClusterRingSize(step, static_cast<ALfloat>(ring)*ringstep)};
+    ALint idx{fastf2i(azimuth / al::MathDefs<float>::Tau() * static_cast<ALfloat>(count))};
+    idx %= count;
+    if(idx < 0) idx += count;
+
+    return (static_cast<ALuint>(ring+rings)<<16 | static_cast<ALuint>(idx)) + 1;
+}
+
+/* Calculates the coefficients for panning to the center of the given
+ * cluster's bucket.
+ */
+void CalcClusterCoeffs(const ALCdevice *Device, const ALuint key,
+    ALfloat (&coeffs)[MAX_AMBI_CHANNELS])
+{
+    const ALfloat step{Device->ClusterAngle};
+    const ALint rings{ClusterRingCount(step)};
+    const ALfloat ringstep{al::MathDefs<float>::Pi()*0.5f / static_cast<ALfloat>(rings)};
+    const ALint ring{static_cast<ALint>((key-1)>>16) - rings};
+    const ALint idx{static_cast<ALint>((key-1)&0xffff)};
+
+    const ALfloat ev{static_cast<ALfloat>(ring) * ringstep};
+    const ALint count{ClusterRingSize(step, ev)};
+    ALfloat az{static_cast<ALfloat>(idx) * al::MathDefs<float>::Tau() / static_cast<ALfloat>(count)};
+    if(az > al::MathDefs<float>::Pi())
+        az -= al::MathDefs<float>::Tau();
+
+    if(Device->mRenderMode == StereoPair)
+        az = ScaleAzimuthFront(az, 1.5f);
+    CalcAngleCoeffs(az, ev, 0.0f, coeffs);
+}
+
+/* Calculates the level the voice's quality is lowered by for its loudness.
+ * Each level starts another 20dB down from the device's threshold, and the
+ * voice has to get 6dB louder than that to go back up a level, so it doesn't
+ * flip between them. Sources with a positive priority keep full quality.
+ */
+ALuint CalcVoiceQuality(const ALvoice *voice, const ALvoicePropsBase *props,
+    const ALCdevice *Device)
+{
+    const ALfloat threshold{Device->VoiceLodGain};
+    if(!(threshold > 0.0f) || props->Priority > 0)
+        return 0;
+
+    auto level_gain = [threshold](const ALuint level) noexcept -> ALfloat
+    { return threshold * std::pow(0.1f, static_cast<ALfloat>(level-1)); };
+
+    const ALfloat gain{voice->mAudibility};
+    ALuint quality{voice->mQuality};
+    while(quality < VOICE_LOD_LEVELS && gain < level_gain(quality+1))
+        ++quality;
+    while(quality > 0 && gain > level_gain(quality)*2.0f)
+        --quality;
+    return quality;
+}
+
+/* Gets the resampler to use for the given quality level. The first level
+ * drops the bsinc resamplers to cubic, and the next anything better to
+ * linear.
+ */
+Resampler GetLodResampler(const Resampler resampler, const ALuint quality) noexcept
+{
+    if(quality >= 2)
+        return std::min(resampler, LinearResampler);
+    if(quality >= 1)
+        return std::min(resampler, FIR4Resampler);
+    return resampler;
+}
+
 void CalcPanningAndFilters(ALvoice *voice, const ALfloat xpos, const ALfloat ypos,
     const ALfloat zpos, const ALfloat Distance, const ALfloat Spread, const ALfloat DryGain,
     const ALfloat DryGainHF, const ALfloat DryGainLF, const ALfloat (&WetGain)[MAX_SENDS],
     const ALfloat (&WetGainLF)[MAX_SENDS], const ALfloat (&WetGainHF)[MAX_SENDS],
     ALeffectslot *(&SendSlots)[MAX_SENDS], const ALvoicePropsBase *props,
-    const ALlistener &Listener, const ALCdevice *Device)
+    const ALlistener &Listener, const ALCcontext *Context, bool UpdateFilters)
 {
     static constexpr ChanMap MonoMap[1]{
         { FrontCenter, 0.0f, 0.0f }
@@ -478,10 +652,26 @@ void CalcPanningAndFilters(ALvoice *voice, const ALfloat xpos, const ALfloat ypo
         { FrontRight, Deg2Rad( 30.0f), Deg2Rad(0.0f) }
     };
 
-    const auto Frequency = static_cast<ALfloat>(Device->Frequency);
+    const ALCdevice *Device{Context->Device};
+    const auto Frequency = static_cast<ALfloat>(Device->MixFrequency);
     const ALsizei NumSends{Device->NumAuxSends};
     ASSUME(NumSends >= 0);
 
+    voice->mAudibility = DryGain;
+    for(ALsizei i{0};i < NumSends;i++)
+    {
+        if(SendSlots[i])
+            voice->mAudibility = maxf(voice->mAudibility, WetGain[i]);
+    }
+
+    /* Changing quality may change which filters are skipped. */
+    const ALuint quality{CalcVoiceQuality(voice, props, Device)};
+    if(quality != voice->mQuality)
+    {
+        voice->mQuality = quality;
+        UpdateFilters = true;
+    }
+
     bool DirectChannels{props->DirectChannels != AL_FALSE};
     const ChanMap *chans{nullptr};
     ALsizei num_channels{0};
@@ -553,24 +743,28 @@ void CalcPanningAndFilters(ALvoice *voice, const ALfloat xpos, const ALfloat ypo
     }
     ASSUME(num_channels > 0);
 
+    const ALsizei num_gains{voice->mNumGains};
     std::for_each(std::begin(voice->mDirect.Params),
         std::begin(voice->mDirect.Params)+num_channels,
-        [](DirectParams &params) -> void
-        {
-            params.Hrtf.Target = HrtfParams{};
-            ClearArray(params.Gains.Target);
-        }
+        [num_gains](DirectParams &params) -> void
+        { std::fill_n(params.Gains.Target, num_gains, 0.0f); }
     );
+    if(voice->mDirectHrtf)
+        std::for_each(voice->mDirectHrtf, voice->mDirectHrtf+num_channels,
+            [](DirectHrtfParams &params) -> void { params.Target = HrtfParams{}; }
+        );
     std::for_each(voice->mSend.begin(), voice->mSend.end(),
-        [num_channels](ALvoice::SendData &send) -> void
+        [num_channels,num_gains](ALvoice::SendData &send) -> void
         {
             std::for_each(std::begin(send.Params), std::begin(send.Params)+num_channels,
-                [](SendParams &params) -> void { ClearArray(params.Gains.Target); }
+                [num_gains](SendParams &params) -> void
+                { std::fill_n(params.Gains.Target, num_gains, 0.0f); }
             );
         }
     );
 
     voice->mFlags &= ~(VOICE_HAS_HRTF | VOICE_HAS_NFC);
+    voice->mClusterKey = 0;
     if(isbformat)
     {
         /* Special handling for B-Format sources. */
@@ -591,7 +785,7 @@ void CalcPanningAndFilters(ALvoice *voice, const ALfloat xpos, const ALfloat ypo
                 const ALfloat w0{SPEEDOFSOUNDMETRESPERSEC / (mdist * Frequency)};
 
                 /* Only need to adjust the first channel of a B-Format source. */
-                voice->mDirect.Params[0].NFCtrlFilter.adjust(w0);
+                voice->mDirectNfc[0].adjust(w0);
 
                 std::copy(std::begin(Device->NumChannelsPerOrder),
                           std::end(Device->NumChannelsPerOrder),
@@ -621,12 +815,12 @@ void CalcPanningAndFilters(ALvoice *voice, const ALfloat xpos, const ALfloat ypo
             /* NOTE: W needs to be scaled due to FuMa normalization. */
             const ALfloat &scale0 = AmbiScale::FromFuMa[0];
             ComputePanGains(&Device->Dry, coeffs, DryGain*scale0,
-                voice->mDirect.Params[0].Gains.Target);
+                voice->mDirect.Params[0].Gains.Target, num_gains);
             for(ALsizei i{0};i < NumSends;i++)
             {
                 if(const ALeffectslot *Slot{SendSlots[i]})
                     ComputePanGains(&Slot->Wet, coeffs, WetGain[i]*scale0,
-                        voice->mSend[i].Params[0].Gains.Target);
+                        voice->mSend[i].Params[0].Gains.Target, num_gains);
             }
         }
         else
@@ -637,7 +831,7 @@ void CalcPanningAndFilters(ALvoice *voice, const ALfloat xpos, const ALfloat ypo
                  * is what we want for FOA input. The first channel may have
                  * been previously re-adjusted if panned, so reset it.
                  */
-                voice->mDirect.Params[0].NFCtrlFilter.adjust(0.0f);
+                voice->mDirectNfc[0].adjust(0.0f);
 
                 voice->mDirect.ChannelsPerOrder[0] = 1;
                 voice->mDirect.ChannelsPerOrder[1] = mini(voice->mDirect.Channels-1, 3);
@@ -681,13 +875,63 @@ void CalcPanningAndFilters(ALvoice *voice, const ALfloat xpos, const ALfloat ypo
 
             for(ALsizei c{0};c < num_channels;c++)
                 ComputePanGains(&Device->Dry, matrix[c], DryGain,
-                    voice->mDirect.Params[c].Gains.Target);
+                    voice->mDirect.Params[c].Gains.Target, num_gains);
             for(ALsizei i{0};i < NumSends;i++)
             {
                 if(const ALeffectslot *Slot{SendSlots[i]})
                     for(ALsizei c{0};c < num_channels;c++)
                         ComputePanGains(&Slot->Wet, matrix[c], WetGain[i],
-                            voice->mSend[i].Params[c].Gains.Target);
+                            voice->mSend[i].Params[c].Gains.Target, num_gains);
+            }
+        }
+    }
+    else if(props->OutputChannel != AL_NONE)
+    {
+        /* Sources routed to a dedicated output have all their channels mixed
+         * straight to the matching real output, skipping the virtual channels
+         * like direct channels. Without a front-center speaker, the dialog
+         * plays from the front-center location instead, and without an LFE
+         * channel the direct path is silent.
+         */
+        const Channel outchan{(props->OutputChannel == AL_OUTPUT_CHANNEL_LFE_SOFT) ? LFE :
+            FrontCenter};
+        const int idx{GetChannelIdxByName(Device->RealOut, outchan)};
+        if(idx != -1)
+        {
+            voice->mDirect.Buffer = Context->RealOut.Buffer;
+            voice->mDirect.Channels = Device->RealOut.NumChannels;
+            voice->mDirect.Touched = Context->RealOut.Touched;
+
+            for(ALsizei c{0};c < num_channels;c++)
+                voice->mDirect.Params[c].Gains.Target[idx] = DryGain;
+        }
+        else if(outchan == FrontCenter)
+        {
+            ALfloat coeffs[MAX_AMBI_CHANNELS];
+            CalcAngleCoeffs(0.0f, 0.0f, 0.0f, coeffs);
+
+            for(ALsizei c{0};c < num_channels;c++)
+                ComputePanGains(&Device->Dry, coeffs, DryGain,
+                    voice->mDirect.Params[c].Gains.Target, num_gains);
+        }
+
+        /* Auxiliary sends still pan the source's channels normally. */
+        ALfloat azimuths[MAX_INPUT_CHANNELS], elevations[MAX_INPUT_CHANNELS];
+        for(ALsizei c{0};c < num_channels;c++)
+        {
+            azimuths[c] = chans[c].angle;
+            elevations[c] = chans[c].elevation;
+        }
+        ALfloat coeffs[MAX_INPUT_CHANNELS][MAX_AMBI_CHANNELS];
+        CalcAngleCoeffsMulti(azimuths, elevations, 0.0f, num_channels, coeffs);
+
+        for(ALsizei c{0};c < num_channels;c++)
+        {
+            for(ALsizei i{0};i < NumSends;i++)
+            {
+                if(const ALeffectslot *Slot{SendSlots[i]})
+                    ComputePanGains(&Slot->Wet, coeffs[c], WetGain[i],
+                        voice->mSend[i].Params[c].Gains.Target, num_gains);
             }
         }
     }
@@ -696,8 +940,9 @@ void CalcPanningAndFilters(ALvoice *voice, const ALfloat xpos, const ALfloat ypo
         /* Direct source channels always play local. Skip the virtual channels
          * and write inputs to the matching real outputs.
          */
-        voice->mDirect.Buffer = Device->RealOut.Buffer;
+        voice->mDirect.Buffer = Context->RealOut.Buffer;
         voice->mDirect.Channels = Device->RealOut.NumChannels;
+        voice->mDirect.Touched = Context->RealOut.Touched;
 
         for(ALsizei c{0};c < num_channels;c++)
         {
@@ -708,26 +953,42 @@ void CalcPanningAndFilters(ALvoice *voice, const ALfloat xpos, const ALfloat ypo
         /* Auxiliary sends still use normal channel panning since they mix to
          * B-Format, which can't channel-match.
          */
+        ALfloat azimuths[MAX_INPUT_CHANNELS], elevations[MAX_INPUT_CHANNELS];
         for(ALsizei c{0};c < num_channels;c++)
         {
-            ALfloat coeffs[MAX_AMBI_CHANNELS];
-            CalcAngleCoeffs(chans[c].angle, chans[c].elevation, 0.0f, coeffs);
+            azimuths[c] = chans[c].angle;
+            elevations[c] = chans[c].elevation;
+        }
+        ALfloat coeffs[MAX_INPUT_CHANNELS][MAX_AMBI_CHANNELS];
+        CalcAngleCoeffsMulti(azimuths, elevations, 0.0f, num_channels, coeffs);
 
+        for(ALsizei c{0};c < num_channels;c++)
+        {
             for(ALsizei i{0};i < NumSends;i++)
             {
                 if(const ALeffectslot *Slot{SendSlots[i]})
-                    ComputePanGains(&Slot->Wet, coeffs, WetGain[i],
-                        voice->mSend[i].Params[c].Gains.Target);
+                    ComputePanGains(&Slot->Wet, coeffs[c], WetGain[i],
+                        voice->mSend[i].Params[c].Gains.Target, num_gains);
             }
         }
     }
-    else if(Device->mRenderMode == HrtfRender)
+    else if(Device->mRenderMode == HrtfRender || (Device->mHrtf && props->FullHrtf))
     {
-        /* Full HRTF rendering. Skip the virtual channels and render to the
-         * real outputs.
+        /* Full HRTF rendering, either for all sources or just the ones asking
+         * for it when the rest use the ambisonic mix. Skip the virtual
+         * channels and render to the real outputs.
          */
-        voice->mDirect.Buffer = Device->RealOut.Buffer;
+        voice->mDirect.Buffer = Context->RealOut.Buffer;
         voice->mDirect.Channels = Device->RealOut.NumChannels;
+        voice->mDirect.Touched = Context->RealOut.Touched;
+
+        /* Distant and low priority sources may use shorter HRIRs, while high
+         * priority sources always use the full length.
+         */
+        ALsizei irsize{Device->mHrtf->irSize};
+        if(Device->mHrtfLodSize > 0 && props->Priority <= 0 &&
+            (props->Priority < 0 || Distance >= Device->mHrtfLodDistance))
+            irsize = Device->mHrtfLodSize;
 
         if(Distance > std::numeric_limits<float>::epsilon())
         {
@@ -737,17 +998,16 @@ void CalcPanningAndFilters(ALvoice *voice, const ALfloat xpos, const ALfloat ypo
             /* Get the HRIR coefficients and delays just once, for the given
              * source direction.
              */
-            GetHrtfCoeffs(Device->mHrtf, ev, az, Distance, Spread,
-                voice->mDirect.Params[0].Hrtf.Target.Coeffs,
-                voice->mDirect.Params[0].Hrtf.Target.Delay);
-            voice->mDirect.Params[0].Hrtf.Target.Gain = DryGain * downmix_gain;
+            GetHrtfParams(Device->mHrtf, Device->mHrtfCache.get(), ev, az, Distance, Spread,
+                irsize, voice->mDirectHrtf[0].Target);
+            voice->mDirectHrtf[0].Target.Gain = DryGain * downmix_gain;
 
             /* Remaining channels use the same results as the first. */
             for(ALsizei c{1};c < num_channels;c++)
             {
                 /* Skip LFE */
                 if(chans[c].channel != LFE)
-                    voice->mDirect.Params[c].Hrtf.Target = voice->mDirect.Params[0].Hrtf.Target;
+                    voice->mDirectHrtf[c].Target = voice->mDirectHrtf[0].Target;
             }
 
             /* Calculate the directional coefficients once, which apply to all
@@ -764,7 +1024,7 @@ void CalcPanningAndFilters(ALvoice *voice, const ALfloat xpos, const ALfloat ypo
                         /* Skip LFE */
                         if(chans[c].channel != LFE)
                             ComputePanGains(&Slot->Wet, coeffs, WetGain[i] * downmix_gain,
-                                voice->mSend[i].Params[c].Gains.Target);
+                                voice->mSend[i].Params[c].Gains.Target, num_gains);
                     }
             }
         }
@@ -774,6 +1034,15 @@ void CalcPanningAndFilters(ALvoice *voice, const ALfloat xpos, const ALfloat ypo
              * relative location around the listener, providing "virtual
              * speaker" responses.
              */
+            ALfloat azimuths[MAX_INPUT_CHANNELS], elevations[MAX_INPUT_CHANNELS];
+            for(ALsizei c{0};c < num_channels;c++)
+            {
+                azimuths[c] = chans[c].angle;
+                elevations[c] = chans[c].elevation;
+            }
+            ALfloat coeffs[MAX_INPUT_CHANNELS][MAX_AMBI_CHANNELS];
+            CalcAngleCoeffsMulti(azimuths, elevations, Spread, num_channels, coeffs);
+
             for(ALsizei c{0};c < num_channels;c++)
             {
                 /* Skip LFE */
@@ -783,21 +1052,17 @@ void CalcPanningAndFilters(ALvoice *voice, const ALfloat xpos, const ALfloat ypo
                 /* Get the HRIR coefficients and delays for this channel
                  * position.
                  */
-                GetHrtfCoeffs(Device->mHrtf, chans[c].elevation, chans[c].angle,
-                    std::numeric_limits<float>::infinity(), Spread,
-                    voice->mDirect.Params[c].Hrtf.Target.Coeffs,
-                    voice->mDirect.Params[c].Hrtf.Target.Delay);
-                voice->mDirect.Params[c].Hrtf.Target.Gain = DryGain;
+                GetHrtfParams(Device->mHrtf, Device->mHrtfCache.get(), chans[c].elevation,
+                    chans[c].angle, std::numeric_limits<float>::infinity(), Spread, irsize,
+                    voice->mDirectHrtf[c].Target);
+                voice->mDirectHrtf[c].Target.Gain = DryGain;
 
                 /* Normal panning for auxiliary sends. */
-                ALfloat coeffs[MAX_AMBI_CHANNELS];
-                CalcAngleCoeffs(chans[c].angle, chans[c].elevation, Spread, coeffs);
-
                 for(ALsizei i{0};i < NumSends;i++)
                 {
                     if(const ALeffectslot *Slot{SendSlots[i]})
-                        ComputePanGains(&Slot->Wet, coeffs, WetGain[i],
-                            voice->mSend[i].Params[c].Gains.Target);
+                        ComputePanGains(&Slot->Wet, coeffs[c], WetGain[i],
+                            voice->mSend[i].Params[c].Gains.Target, num_gains);
                 }
             }
         }
@@ -821,7 +1086,7 @@ void CalcPanningAndFilters(ALvoice *voice, const ALfloat xpos, const ALfloat ypo
 
                 /* Adjust NFC filters. */
                 for(ALsizei c{0};c < num_channels;c++)
-                    voice->mDirect.Params[c].NFCtrlFilter.adjust(w0);
+                    voice->mDirectNfc[c].adjust(w0);
 
                 std::copy(std::begin(Device->NumChannelsPerOrder),
                     std::end(Device->NumChannelsPerOrder),
@@ -842,6 +1107,24 @@ void CalcPanningAndFilters(ALvoice *voice, const ALfloat xpos, const ALfloat ypo
                 CalcAngleCoeffs(ScaleAzimuthFront(az, 1.5f), ev, Spread, coeffs);
             }
 
+            /* A mono point source can be mixed into a cluster with others in
+             * the same direction, panned once to the bucket's center. The
+             * voice's own gains are still set for that direction, for when
+             * it's mixed alone.
+             */
+            const ALfloat *drycoeffs{coeffs};
+            ALfloat clustercoeffs[MAX_AMBI_CHANNELS];
+            if(Device->ClusterAngle > 0.0f && num_channels == 1 && chans[0].channel != LFE
+                && !(voice->mFlags&VOICE_HAS_NFC) && !(Spread > 0.0f))
+            {
+                const ALfloat ev{std::asin(clampf(ypos, -1.0f, 1.0f))};
+                const ALfloat az{std::atan2(xpos, -zpos)};
+                voice->mClusterKey = CalcClusterKey(Device->ClusterAngle, az, ev);
+                voice->mClusterGain.Target = DryGain * downmix_gain;
+                CalcClusterCoeffs(Device, voice->mClusterKey, clustercoeffs);
+                drycoeffs = clustercoeffs;
+            }
+
             for(ALsizei c{0};c < num_channels;c++)
             {
                 /* Special-case LFE */
@@ -855,8 +1138,8 @@ void CalcPanningAndFilters(ALvoice *voice, const ALfloat xpos, const ALfloat ypo
                     continue;
                 }
 
-                ComputePanGains(&Device->Dry, coeffs, DryGain * downmix_gain,
-                    voice->mDirect.Params[c].Gains.Target);
+                ComputePanGains(&Device->Dry, drycoeffs, DryGain * downmix_gain,
+                    voice->mDirect.Params[c].Gains.Target, num_gains);
             }
 
             for(ALsizei i{0};i < NumSends;i++)
@@ -867,7 +1150,7 @@ void CalcPanningAndFilters(ALvoice *voice, const ALfloat xpos, const ALfloat ypo
                         /* Skip LFE */
                         if(chans[c].channel != LFE)
                             ComputePanGains(&Slot->Wet, coeffs, WetGain[i] * downmix_gain,
-                                voice->mSend[i].Params[c].Gains.Target);
+                                voice->mSend[i].Params[c].Gains.Target, num_gains);
                     }
             }
         }
@@ -883,7 +1166,7 @@ void CalcPanningAndFilters(ALvoice *voice, const ALfloat xpos, const ALfloat ypo
                 const ALfloat w0{SPEEDOFSOUNDMETRESPERSEC / (Device->AvgSpeakerDist * Frequency)};
 
                 for(ALsizei c{0};c < num_channels;c++)
-                    voice->mDirect.Params[c].NFCtrlFilter.adjust(w0);
+                    voice->mDirectNfc[c].adjust(w0);
 
                 std::copy(std::begin(Device->NumChannelsPerOrder),
                     std::end(Device->NumChannelsPerOrder),
@@ -891,6 +1174,16 @@ void CalcPanningAndFilters(ALvoice *voice, const ALfloat xpos, const ALfloat ypo
                 voice->mFlags |= VOICE_HAS_NFC;
             }
 
+            ALfloat azimuths[MAX_INPUT_CHANNELS], elevations[MAX_INPUT_CHANNELS];
+            for(ALsizei c{0};c < num_channels;c++)
+            {
+                azimuths[c] = (Device->mRenderMode==StereoPair) ?
+                    ScaleAzimuthFront(chans[c].angle, 3.0f) : chans[c].angle;
+                elevations[c] = chans[c].elevation;
+            }
+            ALfloat coeffs[MAX_INPUT_CHANNELS][MAX_AMBI_CHANNELS];
+            CalcAngleCoeffsMulti(azimuths, elevations, Spread, num_channels, coeffs);
+
             for(ALsizei c{0};c < num_channels;c++)
             {
                 /* Special-case LFE */
@@ -904,40 +1197,64 @@ void CalcPanningAndFilters(ALvoice *voice, const ALfloat xpos, const ALfloat ypo
                     continue;
                 }
 
-                ALfloat coeffs[MAX_AMBI_CHANNELS];
-                CalcAngleCoeffs(
-                    (Device->mRenderMode==StereoPair) ? ScaleAzimuthFront(chans[c].angle, 3.0f)
-                                                      : chans[c].angle,
-                    chans[c].elevation, Spread, coeffs
-                );
-
-                ComputePanGains(&Device->Dry, coeffs, DryGain,
-                    voice->mDirect.Params[c].Gains.Target);
+                ComputePanGains(&Device->Dry, coeffs[c], DryGain,
+                    voice->mDirect.Params[c].Gains.Target, num_gains);
                 for(ALsizei i{0};i < NumSends;i++)
                 {
                     if(const ALeffectslot *Slot{SendSlots[i]})
-                        ComputePanGains(&Slot->Wet, coeffs, WetGain[i],
-                            voice->mSend[i].Params[c].Gains.Target);
+                        ComputePanGains(&Slot->Wet, coeffs[c], WetGain[i],
+                            voice->mSend[i].Params[c].Gains.Target, num_gains);
                 }
             }
         }
     }
 
+    /* The filters only depend on the gains and source properties, so they may
+     * be left alone if those didn't change.
+     */
+    if(!UpdateFilters)
+        return;
+
+    /* Sources sharing a filter usually end up with the same shelf parameters,
+     * so the coefficients last calculated for each shelf type are kept and
+     * reused when the parameters match.
+     */
+    struct ShelfCache {
+        ALfloat gain{0.0f}, f0norm{0.0f};
+        BiquadFilter filter;
+    };
+    static thread_local ShelfCache shelves[2];
+    auto set_shelf = [](BiquadFilter &filter, const BiquadType type, const ALfloat gain,
+        const ALfloat f0norm) -> void
+    {
+        ShelfCache &shelf = shelves[(type == BiquadType::HighShelf) ? 0 : 1];
+        if(!(shelf.gain == gain && shelf.f0norm == f0norm))
+        {
+            shelf.filter.setParams(type, gain, f0norm, calc_rcpQ_from_slope(gain, 1.0f));
+            shelf.gain = gain;
+            shelf.f0norm = f0norm;
+        }
+        filter.copyParamsFrom(shelf.filter);
+    };
+
+    /* At the lowest quality, filters within 6dB of flat are skipped. */
+    const ALfloat flatgain{(voice->mQuality >= VOICE_LOD_LEVELS) ? 0.5f : 1.0f};
+    auto get_filter_type = [flatgain](const ALfloat gainHF, const ALfloat gainLF) noexcept -> int
+    {
+        int type{AF_None};
+        if(!(gainHF >= flatgain && gainHF <= 1.0f)) type |= AF_LowPass;
+        if(!(gainLF >= flatgain && gainLF <= 1.0f)) type |= AF_HighPass;
+        return type;
+    };
     {
         const ALfloat hfScale{props->Direct.HFReference / Frequency};
         const ALfloat lfScale{props->Direct.LFReference / Frequency};
         const ALfloat gainHF{maxf(DryGainHF, 0.001f)}; /* Limit -60dB */
         const ALfloat gainLF{maxf(DryGainLF, 0.001f)};
 
-        voice->mDirect.FilterType = AF_None;
-        if(gainHF != 1.0f) voice->mDirect.FilterType |= AF_LowPass;
-        if(gainLF != 1.0f) voice->mDirect.FilterType |= AF_HighPass;
-        voice->mDirect.Params[0].LowPass.setParams(BiquadType::HighShelf,
-            gainHF, hfScale, calc_rcpQ_from_slope(gainHF, 1.0f)
-        );
-        voice->mDirect.Params[0].HighPass.setParams(BiquadType::LowShelf,
-            gainLF, lfScale, calc_rcpQ_from_slope(gainLF, 1.0f)
-        );
+        voice->mDirect.FilterType = get_filter_type(gainHF, gainLF);
+        set_shelf(voice->mDirect.Params[0].LowPass, BiquadType::HighShelf, gainHF, hfScale);
+        set_shelf(voice->mDirect.Params[0].HighPass, BiquadType::LowShelf, gainLF, lfScale);
         for(ALsizei c{1};c < num_channels;c++)
         {
             voice->mDirect.Params[c].LowPass.copyParamsFrom(voice->mDirect.Params[0].LowPass);
@@ -951,15 +1268,9 @@ void CalcPanningAndFilters(ALvoice *voice, const ALfloat xpos, const ALfloat ypo
         const ALfloat gainHF{maxf(WetGainHF[i], 0.001f)};
         const ALfloat gainLF{maxf(WetGainLF[i], 0.001f)};
 
-        voice->mSend[i].FilterType = AF_None;
-        if(gainHF != 1.0f) voice->mSend[i].FilterType |= AF_LowPass;
-        if(gainLF != 1.0f) voice->mSend[i].FilterType |= AF_HighPass;
-        voice->mSend[i].Params[0].LowPass.setParams(BiquadType::HighShelf,
-            gainHF, hfScale, calc_rcpQ_from_slope(gainHF, 1.0f)
-        );
-        voice->mSend[i].Params[0].HighPass.setParams(BiquadType::LowShelf,
-            gainLF, lfScale, calc_rcpQ_from_slope(gainLF, 1.0f)
-        );
+        voice->mSend[i].FilterType = get_filter_type(gainHF, gainLF);
+        set_shelf(voice->mSend[i].Params[0].LowPass, BiquadType::HighShelf, gainHF, hfScale);
+        set_shelf(voice->mSend[i].Params[0].HighPass, BiquadType::LowShelf, gainLF, lfScale);
         for(ALsizei c{1};c < num_channels;c++)
         {
             voice->mSend[i].Params[c].LowPass.copyParamsFrom(voice->mSend[i].Params[0].LowPass);
@@ -968,13 +1279,90 @@ void CalcPanningAndFilters(ALvoice *voice, const ALfloat xpos, const ALfloat ypo
     }
 }
 
+/* Sets up the resampler for the voice's step and quality. A voice that was
+ * already playing crossfades from its old resampler over the next mix when it
+ * changes.
+ */
+void SetVoiceResampler(ALvoice *voice, const ALvoicePropsBase *props)
+{
+    const Resampler resampler{GetLodResampler(props->mResampler, voice->mQuality)};
+    if(voice->mResampler && resampler != voice->mActiveResampler)
+    {
+        voice->mPrevResampler = voice->mResampler;
+        voice->mPrevResampleState = voice->mResampleState;
+    }
+    voice->mActiveResampler = resampler;
+
+    if(resampler == BSinc32Resampler)
+        BsincPrepare(voice->mStep, &voice->mResampleState.bsinc, &bsinc32);
+    else if(resampler == BSinc24Resampler)
+        BsincPrepare(voice->mStep, &voice->mResampleState.bsinc, &bsinc24);
+    else if(resampler == BSinc12Resampler)
+        BsincPrepare(voice->mStep, &voice->mResampleState.bsinc, &bsinc12);
+    voice->mResampler = SelectResampler(resampler, voice->mStep);
+    voice->mMultiResampler = SelectMultiResampler(resampler, voice->mStep);
+}
+
+/* The gain and pitch of the voice's source group, applied on top of its own. */
+inline ALfloat GetGroupGain(const ALvoicePropsBase *props) noexcept
+{ return props->Group ? props->Group->Params.Gain : 1.0f; }
+inline ALfloat GetGroupPitch(const ALvoicePropsBase *props) noexcept
+{ return props->Group ? props->Group->Params.Pitch : 1.0f; }
+
+/* Takes a voice filter's properties from the filter it's linked to, if any.
+ * Returns true if it's linked.
+ */
+template<typename T>
+inline bool ApplyFilterLink(T &dst) noexcept
+{
+    const ALfilter *link{dst.Link};
+    if(!link) return false;
+    dst.Gain = link->Params.Gain.load(std::memory_order_relaxed);
+    dst.GainHF = link->Params.GainHF.load(std::memory_order_relaxed);
+    dst.HFReference = link->Params.HFReference.load(std::memory_order_relaxed);
+    dst.GainLF = link->Params.GainLF.load(std::memory_order_relaxed);
+    dst.LFReference = link->Params.LFReference.load(std::memory_order_relaxed);
+    return true;
+}
+bool ApplyFilterLinks(ALvoicePropsBase &props, const ALsizei num_sends) noexcept
+{
+    bool linked{ApplyFilterLink(props.Direct)};
+    for(ALsizei i{0};i < num_sends;++i)
+        linked |= ApplyFilterLink(props.Send[i]);
+    return linked;
+}
+
+/* Moves the voice's direct path to or from the context's world bus, with its
+ * target gains given for the dry mix. The current gains are converted for the
+ * rotation last applied when it moves, so it continues from the same place.
+ */
+void SetVoiceWorldSpace(ALvoice *voice, const ALCcontext *ctx, const bool wasworld,
+    const bool world)
+{
+    const AmbiRotator *rotator{ctx->WorldRotator.get()};
+    DirectParams &params = voice->mDirect.Params[0];
+    if(world)
+    {
+        voice->mDirect.Buffer = ctx->World.Buffer;
+        voice->mDirect.Touched = ctx->World.Touched;
+        rotator->toWorld(params.Gains.Target);
+        if(!wasworld)
+            rotator->currentToWorld(params.Gains.Current);
+    }
+    else if(wasworld)
+        rotator->currentFromWorld(params.Gains.Current);
+}
+
 void CalcNonAttnSourceParams(ALvoice *voice, const ALvoicePropsBase *props, const ALCcontext *ALContext)
 {
     const ALCdevice *Device{ALContext->Device};
     ALeffectslot *SendSlots[MAX_SENDS];
 
-    voice->mDirect.Buffer = Device->Dry.Buffer;
+    if(voice->mDirect.Buffer && voice->mDirect.Buffer == ALContext->World.Buffer)
+        SetVoiceWorldSpace(voice, ALContext, true, false);
+    voice->mDirect.Buffer = ALContext->Dry.Buffer;
     voice->mDirect.Channels = Device->Dry.NumChannels;
+    voice->mDirect.Touched = ALContext->Dry.Touched;
     for(ALsizei i{0};i < Device->NumAuxSends;i++)
     {
         SendSlots[i] = props->Send[i].Slot;
@@ -985,31 +1373,29 @@ void CalcNonAttnSourceParams(ALvoice *voice, const ALvoicePropsBase *props, cons
             SendSlots[i] = nullptr;
             voice->mSend[i].Buffer = nullptr;
             voice->mSend[i].Channels = 0;
+            voice->mSend[i].Touched = nullptr;
         }
         else
         {
             voice->mSend[i].Buffer = SendSlots[i]->Wet.Buffer;
             voice->mSend[i].Channels = SendSlots[i]->Wet.NumChannels;
+            voice->mSend[i].Touched = SendSlots[i]->Wet.Touched;
         }
     }
 
     /* Calculate the stepping value */
     const auto Pitch = static_cast<ALfloat>(voice->mFrequency) /
-        static_cast<ALfloat>(Device->Frequency) * props->Pitch;
+        static_cast<ALfloat>(Device->MixFrequency) * props->Pitch * GetGroupPitch(props);
     if(Pitch > static_cast<ALfloat>(MAX_PITCH))
         voice->mStep = MAX_PITCH<<FRACTIONBITS;
     else
         voice->mStep = maxi(fastf2i(Pitch * FRACTIONONE), 1);
-    if(props->mResampler == BSinc24Resampler)
-        BsincPrepare(voice->mStep, &voice->mResampleState.bsinc, &bsinc24);
-    else if(props->mResampler == BSinc12Resampler)
-        BsincPrepare(voice->mStep, &voice->mResampleState.bsinc, &bsinc12);
-    voice->mResampler = SelectResampler(props->mResampler);
 
     /* Calculate gains */
     const ALlistener &Listener = ALContext->Listener;
+    const ALfloat ListenerGain{Listener.Params.Gain * GetGroupGain(props)};
     ALfloat DryGain{clampf(props->Gain, props->MinGain, props->MaxGain)};
-    DryGain *= props->Direct.Gain * Listener.Params.Gain;
+    DryGain *= props->Direct.Gain * ListenerGain;
     DryGain  = minf(DryGain, GAIN_MIX_MAX);
     ALfloat DryGainHF{props->Direct.GainHF};
     ALfloat DryGainLF{props->Direct.GainLF};
@@ -1017,38 +1403,32 @@ void CalcNonAttnSourceParams(ALvoice *voice, const ALvoicePropsBase *props, cons
     for(ALsizei i{0};i < Device->NumAuxSends;i++)
     {
         WetGain[i]  = clampf(props->Gain, props->MinGain, props->MaxGain);
-        WetGain[i] *= props->Send[i].Gain * Listener.Params.Gain;
+        WetGain[i] *= props->Send[i].Gain * ListenerGain;
         WetGain[i]  = minf(WetGain[i], GAIN_MIX_MAX);
         WetGainHF[i] = props->Send[i].GainHF;
         WetGainLF[i] = props->Send[i].GainLF;
     }
 
     CalcPanningAndFilters(voice, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f, DryGain, DryGainHF, DryGainLF,
-        WetGain, WetGainLF, WetGainHF, SendSlots, props, Listener, Device);
+        WetGain, WetGainLF, WetGainHF, SendSlots, props, Listener, ALContext, true);
+    SetVoiceResampler(voice, props);
 }
 
-void CalcAttnSourceParams(ALvoice *voice, const ALvoicePropsBase *props, const ALCcontext *ALContext)
+/* Calculates the distance and cone attenuation for a voice, along with the
+ * effect sends' initial decay and air absorption.
+ */
+void CalcAttenuation(VoiceAttenuation &attn, const ALvoicePropsBase *props,
+    ALeffectslot *const (&SendSlots)[MAX_SENDS], const ALsizei NumSends,
+    const ALlistener &Listener)
 {
-    const ALCdevice *Device{ALContext->Device};
-    const ALsizei NumSends{Device->NumAuxSends};
-    const ALlistener &Listener = ALContext->Listener;
-
-    /* Set mixing buffers and get send parameters. */
-    voice->mDirect.Buffer = Device->Dry.Buffer;
-    voice->mDirect.Channels = Device->Dry.NumChannels;
-    ALeffectslot *SendSlots[MAX_SENDS];
     ALfloat RoomRolloff[MAX_SENDS];
     ALfloat DecayDistance[MAX_SENDS];
     ALfloat DecayLFDistance[MAX_SENDS];
     ALfloat DecayHFDistance[MAX_SENDS];
     for(ALsizei i{0};i < NumSends;i++)
     {
-        SendSlots[i] = props->Send[i].Slot;
-        if(!SendSlots[i] && i == 0)
-            SendSlots[i] = ALContext->DefaultSlot.get();
-        if(!SendSlots[i] || SendSlots[i]->Params.EffectType == AL_EFFECT_NULL)
+        if(!SendSlots[i])
         {
-            SendSlots[i] = nullptr;
             RoomRolloff[i] = 0.0f;
             DecayDistance[i] = 0.0f;
             DecayLFDistance[i] = 0.0f;
@@ -1088,45 +1468,15 @@ void CalcAttnSourceParams(ALvoice *voice, const ALvoicePropsBase *props, const A
             DecayLFDistance[i] = 0.0f;
             DecayHFDistance[i] = 0.0f;
         }
-
-        if(!SendSlots[i])
-        {
-            voice->mSend[i].Buffer = nullptr;
-            voice->mSend[i].Channels = 0;
-        }
-        else
-        {
-            voice->mSend[i].Buffer = SendSlots[i]->Wet.Buffer;
-            voice->mSend[i].Channels = SendSlots[i]->Wet.NumChannels;
-        }
-    }
-
-    /* Transform source to listener space (convert to head relative) */
-    alu::Vector Position{props->Position[0], props->Position[1], props->Position[2], 1.0f};
-    alu::Vector Velocity{props->Velocity[0], props->Velocity[1], props->Velocity[2], 0.0f};
-    alu::Vector Direction{props->Direction[0], props->Direction[1], props->Direction[2], 0.0f};
-    if(props->HeadRelative == AL_FALSE)
-    {
-        /* Transform source vectors */
-        Position = Listener.Params.Matrix * Position;
-        Velocity = Listener.Params.Matrix * Velocity;
-        Direction = Listener.Params.Matrix * Direction;
     }
-    else
-    {
-        /* Offset the source velocity to be relative of the listener velocity */
-        Velocity += Listener.Params.Velocity;
-    }
-
-    const bool directional{Direction.normalize() > 0.0f};
-    alu::Vector ToSource{Position[0], Position[1], Position[2], 0.0f};
-    const ALfloat Distance{ToSource.normalize()};
 
     /* Initial source gain */
     ALfloat DryGain{props->Gain};
     ALfloat DryGainHF{1.0f};
     ALfloat DryGainLF{1.0f};
-    ALfloat WetGain[MAX_SENDS], WetGainHF[MAX_SENDS], WetGainLF[MAX_SENDS];
+    ALfloat (&WetGain)[MAX_SENDS] = attn.WetGain;
+    ALfloat (&WetGainHF)[MAX_SENDS] = attn.WetGainHF;
+    ALfloat (&WetGainLF)[MAX_SENDS] = attn.WetGainLF;
     for(ALsizei i{0};i < NumSends;i++)
     {
         WetGain[i] = props->Gain;
@@ -1135,8 +1485,7 @@ void CalcAttnSourceParams(ALvoice *voice, const ALvoicePropsBase *props, const A
     }
 
     /* Calculate distance attenuation */
-    ALfloat ClampedDist{Distance};
-
+    ALfloat ClampedDist{attn.Distance};
     switch(Listener.Params.SourceDistanceModel ?
            props->mDistanceModel : Listener.Params.mDistanceModel)
     {
@@ -1201,10 +1550,9 @@ void CalcAttnSourceParams(ALvoice *voice, const ALvoicePropsBase *props, const A
     }
 
     /* Calculate directional soundcones */
-    if(directional && props->InnerAngle < 360.0f)
+    if(attn.Directional && props->InnerAngle < 360.0f)
     {
-        const ALfloat Angle{Rad2Deg(std::acos(-aluDotproduct(Direction, ToSource)) *
-            ConeScale * 2.0f)};
+        const ALfloat Angle{Rad2Deg(std::acos(attn.ConeDot) * ConeScale * 2.0f)};
 
         ALfloat ConeVolume, ConeHF;
         if(!(Angle > props->InnerAngle))
@@ -1240,14 +1588,15 @@ void CalcAttnSourceParams(ALvoice *voice, const ALvoicePropsBase *props, const A
     }
 
     /* Apply gain and frequency filters */
+    const ALfloat ListenerGain{Listener.Params.Gain * GetGroupGain(props)};
     DryGain = clampf(DryGain, props->MinGain, props->MaxGain);
-    DryGain = minf(DryGain*props->Direct.Gain*Listener.Params.Gain, GAIN_MIX_MAX);
+    DryGain = minf(DryGain*props->Direct.Gain*ListenerGain, GAIN_MIX_MAX);
     DryGainHF *= props->Direct.GainHF;
     DryGainLF *= props->Direct.GainLF;
     for(ALsizei i{0};i < NumSends;i++)
     {
         WetGain[i] = clampf(WetGain[i], props->MinGain, props->MaxGain);
-        WetGain[i] = minf(WetGain[i]*props->Send[i].Gain*Listener.Params.Gain, GAIN_MIX_MAX);
+        WetGain[i] = minf(WetGain[i]*props->Send[i].Gain*ListenerGain, GAIN_MIX_MAX);
         WetGainHF[i] *= props->Send[i].GainHF;
         WetGainLF[i] *= props->Send[i].GainLF;
     }
@@ -1294,55 +1643,293 @@ void CalcAttnSourceParams(ALvoice *voice, const ALvoicePropsBase *props, const A
         }
     }
 
+    attn.DryGain = DryGain;
+    attn.DryGainHF = DryGainHF;
+    attn.DryGainLF = DryGainLF;
+}
 
-    /* Initial source pitch */
-    ALfloat Pitch{props->Pitch};
-
-    /* Calculate velocity-based doppler effect */
-    ALfloat DopplerFactor{props->DopplerFactor * Listener.Params.DopplerFactor};
-    if(DopplerFactor > 0.0f)
-    {
-        const alu::Vector &lvelocity = Listener.Params.Velocity;
-        ALfloat vss{aluDotproduct(Velocity, ToSource) * -DopplerFactor};
-        ALfloat vls{aluDotproduct(lvelocity, ToSource) * -DopplerFactor};
+/* Number of voices to find the listener-relative parameters for at once. */
+constexpr size_t VoiceBatchSize{16};
 
-        const ALfloat SpeedOfSound{Listener.Params.SpeedOfSound};
-        if(!(vls < SpeedOfSound))
-        {
-            /* Listener moving away from the source at the speed of sound.
-             * Sound waves can't catch it.
-             */
-            Pitch = 0.0f;
-        }
-        else if(!(vss < SpeedOfSound))
-        {
-            /* Source moving toward the listener at the speed of sound. Sound
-             * waves bunch up to extreme frequencies.
-             */
-            Pitch = std::numeric_limits<float>::infinity();
-        }
-        else
-        {
-            /* Source and listener movement is nominal. Calculate the proper
-             * doppler shift.
-             */
-            Pitch *= (SpeedOfSound-vls) / (SpeedOfSound-vss);
-        }
-    }
+/* A source's position and movement relative to the listener. */
+struct VoiceRelativeParams {
+    /* Normalized direction to the source, in listener space. */
+    alu::Vector ToSource;
+    ALfloat Distance;
 
-    /* Adjust pitch based on the buffer and output frequencies, and calculate
-     * fixed-point stepping value.
+    /* Cosine of the angle between the source's direction and the listener,
+     * if the source is directional.
      */
-    Pitch *= static_cast<ALfloat>(voice->mFrequency)/static_cast<ALfloat>(Device->Frequency);
-    if(Pitch > static_cast<ALfloat>(MAX_PITCH))
-        voice->mStep = MAX_PITCH<<FRACTIONBITS;
+    bool Directional;
+    ALfloat ConeDot;
+
+    /* Source and listener velocities along ToSource. */
+    ALfloat SourceVelDot;
+    ALfloat ListenerVelDot;
+};
+
+/* Calculates the listener-relative parameters for a batch of spatialized
+ * voices. The source vectors are loaded into separate arrays for each
+ * component so the transforms, distances, and dot products can be calculated
+ * for 4 voices at a time with SSE, where available. The SSE path does the
+ * same operations in the same order as the scalar one, so the results match
+ * exactly (aside from the sign of a zero cone dot product, which is only used
+ * for an angle). Keep them that way when changing either.
+ */
+void CalcVoiceRelativeParams(ALvoice *const *RESTRICT voices, const size_t count,
+    const ALlistener &Listener, VoiceRelativeParams *RESTRICT rel)
+{
+    ASSUME(count > 0 && count <= VoiceBatchSize);
+
+    alignas(16) ALfloat px[VoiceBatchSize], py[VoiceBatchSize], pz[VoiceBatchSize];
+    alignas(16) ALfloat vx[VoiceBatchSize], vy[VoiceBatchSize], vz[VoiceBatchSize];
+    alignas(16) ALfloat dx[VoiceBatchSize], dy[VoiceBatchSize], dz[VoiceBatchSize];
+    alignas(16) ALfloat headrel[VoiceBatchSize];
+    /* Unused entries are cleared so the batch can always be processed whole,
+     * without remainder handling.
+     */
+    std::fill(std::begin(px), std::end(px), 0.0f);
+    std::fill(std::begin(py), std::end(py), 0.0f);
+    std::fill(std::begin(pz), std::end(pz), 0.0f);
+    std::fill(std::begin(vx), std::end(vx), 0.0f);
+    std::fill(std::begin(vy), std::end(vy), 0.0f);
+    std::fill(std::begin(vz), std::end(vz), 0.0f);
+    std::fill(std::begin(dx), std::end(dx), 0.0f);
+    std::fill(std::begin(dy), std::end(dy), 0.0f);
+    std::fill(std::begin(dz), std::end(dz), 0.0f);
+    std::fill(std::begin(headrel), std::end(headrel), 0.0f);
+    for(size_t i{0};i < count;++i)
+    {
+        const ALvoicePropsBase &props = voices[i]->mProps;
+        px[i] = props.Position[0]; py[i] = props.Position[1]; pz[i] = props.Position[2];
+        vx[i] = props.Velocity[0]; vy[i] = props.Velocity[1]; vz[i] = props.Velocity[2];
+        dx[i] = props.Direction[0]; dy[i] = props.Direction[1]; dz[i] = props.Direction[2];
+        headrel[i] = props.HeadRelative ? 1.0f : 0.0f;
+    }
+
+    const alu::Matrix &mtx = Listener.Params.Matrix;
+    const alu::Vector &lpos = Listener.Params.Position;
+    const alu::Vector &lvel = Listener.Params.Velocity;
+    constexpr ALfloat epsilon{std::numeric_limits<float>::epsilon()};
+
+    alignas(16) ALfloat tx[VoiceBatchSize], ty[VoiceBatchSize], tz[VoiceBatchSize];
+    alignas(16) ALfloat dist[VoiceBatchSize], dirlen[VoiceBatchSize], conedot[VoiceBatchSize];
+    alignas(16) ALfloat svel[VoiceBatchSize], lveldot[VoiceBatchSize];
+#ifdef HAVE_SSE_INTRINSICS
+    auto select = [](const __m128 mask, const __m128 a, const __m128 b) noexcept -> __m128
+    { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); };
+    auto dot3 = [](const __m128 x0, const __m128 y0, const __m128 z0, const __m128 x1,
+        const __m128 y1, const __m128 z1) noexcept -> __m128
+    { return _mm_add_ps(_mm_add_ps(_mm_mul_ps(x0, x1), _mm_mul_ps(y0, y1)), _mm_mul_ps(z0, z1)); };
+    /* Reciprocal of the length, or 0 if it's too small. */
+    const __m128 eps4{_mm_set1_ps(epsilon)};
+    const __m128 one4{_mm_set1_ps(1.0f)};
+    auto safe_rcp = [eps4,one4](const __m128 len) noexcept -> __m128
+    { return _mm_and_ps(_mm_cmpgt_ps(len, eps4), _mm_div_ps(one4, _mm_max_ps(len, eps4))); };
+    auto transform = [&mtx](const size_t col, const __m128 x, const __m128 y, const __m128 z)
+        noexcept -> __m128
+    {
+        return _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(mtx[0][col])),
+            _mm_mul_ps(y, _mm_set1_ps(mtx[1][col]))), _mm_mul_ps(z, _mm_set1_ps(mtx[2][col])));
+    };
+
+    /* See the scalar version below for details. */
+    static_assert((VoiceBatchSize&3) == 0, "VoiceBatchSize must be a multiple of 4");
+    for(size_t i{0};i < VoiceBatchSize;i += 4)
+    {
+        const __m128 isrel{_mm_cmpneq_ps(_mm_load_ps(&headrel[i]), _mm_setzero_ps())};
+        const __m128 x4{_mm_load_ps(&px[i])}, y4{_mm_load_ps(&py[i])}, z4{_mm_load_ps(&pz[i])};
+        const __m128 dx4{_mm_load_ps(&dx[i])}, dy4{_mm_load_ps(&dy[i])}, dz4{_mm_load_ps(&dz[i])};
+        const __m128 vx4{_mm_load_ps(&vx[i])}, vy4{_mm_load_ps(&vy[i])}, vz4{_mm_load_ps(&vz[i])};
+
+        const __m128 rx{select(isrel, x4, _mm_sub_ps(x4, _mm_set1_ps(lpos[0])))};
+        const __m128 ry{select(isrel, y4, _mm_sub_ps(y4, _mm_set1_ps(lpos[1])))};
+        const __m128 rz{select(isrel, z4, _mm_sub_ps(z4, _mm_set1_ps(lpos[2])))};
+        const __m128 rlen{_mm_sqrt_ps(dot3(rx, ry, rz, rx, ry, rz))};
+        const __m128 dlen{_mm_sqrt_ps(dot3(dx4, dy4, dz4, dx4, dy4, dz4))};
+        const __m128 rscale{safe_rcp(rlen)};
+        const __m128 dscale{safe_rcp(dlen)};
+        _mm_store_ps(&dist[i], _mm_and_ps(_mm_cmpgt_ps(rlen, eps4), rlen));
+        _mm_store_ps(&dirlen[i], _mm_mul_ps(dlen, dscale));
+        _mm_store_ps(&conedot[i], _mm_sub_ps(_mm_setzero_ps(),
+            _mm_mul_ps(_mm_mul_ps(dot3(rx, ry, rz, dx4, dy4, dz4), rscale), dscale)));
+
+        const __m128 x{select(isrel, x4,
+            _mm_add_ps(transform(0, x4, y4, z4), _mm_set1_ps(mtx[3][0])))};
+        const __m128 y{select(isrel, y4,
+            _mm_add_ps(transform(1, x4, y4, z4), _mm_set1_ps(mtx[3][1])))};
+        const __m128 z{select(isrel, z4,
+            _mm_add_ps(transform(2, x4, y4, z4), _mm_set1_ps(mtx[3][2])))};
+        const __m128 velx{select(isrel, _mm_add_ps(vx4, _mm_set1_ps(lvel[0])),
+            transform(0, vx4, vy4, vz4))};
+        const __m128 vely{select(isrel, _mm_add_ps(vy4, _mm_set1_ps(lvel[1])),
+            transform(1, vx4, vy4, vz4))};
+        const __m128 velz{select(isrel, _mm_add_ps(vz4, _mm_set1_ps(lvel[2])),
+            transform(2, vx4, vy4, vz4))};
+
+        const __m128 tscale{safe_rcp(_mm_sqrt_ps(dot3(x, y, z, x, y, z)))};
+        const __m128 tx4{_mm_mul_ps(x, tscale)};
+        const __m128 ty4{_mm_mul_ps(y, tscale)};
+        const __m128 tz4{_mm_mul_ps(z, tscale)};
+        _mm_store_ps(&tx[i], tx4);
+        _mm_store_ps(&ty[i], ty4);
+        _mm_store_ps(&tz[i], tz4);
+        _mm_store_ps(&svel[i], dot3(velx, vely, velz, tx4, ty4, tz4));
+        _mm_store_ps(&lveldot[i], dot3(_mm_set1_ps(lvel[0]), _mm_set1_ps(lvel[1]),
+            _mm_set1_ps(lvel[2]), tx4, ty4, tz4));
+    }
+#else
+    for(size_t i{0};i < VoiceBatchSize;++i)
+    {
+        const bool isrel{headrel[i] != 0.0f};
+
+        /* The distance and cone angle are taken from the untransformed
+         * vectors, so they stay exactly the same when only the listener's
+         * orientation changes.
+         */
+        const ALfloat rx{isrel ? px[i] : px[i]-lpos[0]};
+        const ALfloat ry{isrel ? py[i] : py[i]-lpos[1]};
+        const ALfloat rz{isrel ? pz[i] : pz[i]-lpos[2]};
+        const ALfloat rlen{std::sqrt(rx*rx + ry*ry + rz*rz)};
+        const ALfloat dlen{std::sqrt(dx[i]*dx[i] + dy[i]*dy[i] + dz[i]*dz[i])};
+        const ALfloat rscale{(rlen > epsilon) ? 1.0f/rlen : 0.0f};
+        const ALfloat dscale{(dlen > epsilon) ? 1.0f/dlen : 0.0f};
+        dist[i] = (rlen > epsilon) ? rlen : 0.0f;
+        dirlen[i] = dlen * dscale;
+        conedot[i] = -(rx*dx[i] + ry*dy[i] + rz*dz[i]) * rscale * dscale;
+
+        /* Transform the position and velocity to listener space, unless
+         * they're already head relative. Head-relative velocities get offset
+         * by the listener's velocity instead.
+         */
+        const ALfloat x{isrel ? px[i] :
+            px[i]*mtx[0][0] + py[i]*mtx[1][0] + pz[i]*mtx[2][0] + mtx[3][0]};
+        const ALfloat y{isrel ? py[i] :
+            px[i]*mtx[0][1] + py[i]*mtx[1][1] + pz[i]*mtx[2][1] + mtx[3][1]};
+        const ALfloat z{isrel ? pz[i] :
+            px[i]*mtx[0][2] + py[i]*mtx[1][2] + pz[i]*mtx[2][2] + mtx[3][2]};
+        const ALfloat velx{isrel ? vx[i]+lvel[0] :
+            vx[i]*mtx[0][0] + vy[i]*mtx[1][0] + vz[i]*mtx[2][0]};
+        const ALfloat vely{isrel ? vy[i]+lvel[1] :
+            vx[i]*mtx[0][1] + vy[i]*mtx[1][1] + vz[i]*mtx[2][1]};
+        const ALfloat velz{isrel ? vz[i]+lvel[2] :
+            vx[i]*mtx[0][2] + vy[i]*mtx[1][2] + vz[i]*mtx[2][2]};
+
+        const ALfloat tlen{std::sqrt(x*x + y*y + z*z)};
+        const ALfloat tscale{(tlen > epsilon) ? 1.0f/tlen : 0.0f};
+        tx[i] = x * tscale;
+        ty[i] = y * tscale;
+        tz[i] = z * tscale;
+        svel[i] = velx*tx[i] + vely*ty[i] + velz*tz[i];
+        lveldot[i] = lvel[0]*tx[i] + lvel[1]*ty[i] + lvel[2]*tz[i];
+    }
+
+#endif
+
+    for(size_t i{0};i < count;++i)
+    {
+        rel[i].ToSource = alu::Vector{tx[i], ty[i], tz[i], 0.0f};
+        rel[i].Distance = dist[i];
+        rel[i].Directional = dirlen[i] > 0.0f;
+        rel[i].ConeDot = rel[i].Directional ? conedot[i] : 0.0f;
+        rel[i].SourceVelDot = svel[i];
+        rel[i].ListenerVelDot = lveldot[i];
+    }
+}
+
+void CalcAttnSourceParams(ALvoice *voice, const ALvoicePropsBase *props, const ALCcontext *ALContext,
+    const VoiceRelativeParams &rel)
+{
+    const ALCdevice *Device{ALContext->Device};
+    const ALsizei NumSends{Device->NumAuxSends};
+    const ALlistener &Listener = ALContext->Listener;
+
+    /* Set mixing buffers and get send parameters. */
+    const bool wasworld{voice->mDirect.Buffer && voice->mDirect.Buffer == ALContext->World.Buffer};
+    voice->mDirect.Buffer = ALContext->Dry.Buffer;
+    voice->mDirect.Channels = Device->Dry.NumChannels;
+    voice->mDirect.Touched = ALContext->Dry.Touched;
+    ALeffectslot *SendSlots[MAX_SENDS];
+    for(ALsizei i{0};i < NumSends;i++)
+    {
+        SendSlots[i] = props->Send[i].Slot;
+        if(!SendSlots[i] && i == 0)
+            SendSlots[i] = ALContext->DefaultSlot.get();
+        if(!SendSlots[i] || SendSlots[i]->Params.EffectType == AL_EFFECT_NULL)
+        {
+            SendSlots[i] = nullptr;
+            voice->mSend[i].Buffer = nullptr;
+            voice->mSend[i].Channels = 0;
+            voice->mSend[i].Touched = nullptr;
+        }
+        else
+        {
+            voice->mSend[i].Buffer = SendSlots[i]->Wet.Buffer;
+            voice->mSend[i].Channels = SendSlots[i]->Wet.NumChannels;
+            voice->mSend[i].Touched = SendSlots[i]->Wet.Touched;
+        }
+    }
+
+    const ALfloat Distance{rel.Distance};
+    const bool directional{rel.Directional};
+    const ALfloat ConeDot{rel.ConeDot};
+    const alu::Vector &ToSource = rel.ToSource;
+
+    /* Recalculate the attenuation only if its inputs changed. */
+    VoiceAttenuation &attn = voice->mAttn;
+    const bool attn_changed{!(voice->mFlags&VOICE_ATTN_CACHED) || attn.Distance != Distance
+        || attn.Directional != directional || attn.ConeDot != ConeDot};
+    if(attn_changed)
+    {
+        attn.Distance = Distance;
+        attn.Directional = directional;
+        attn.ConeDot = ConeDot;
+        CalcAttenuation(attn, props, SendSlots, NumSends, Listener);
+        voice->mFlags |= VOICE_ATTN_CACHED;
+    }
+
+    /* Initial source pitch */
+    ALfloat Pitch{props->Pitch * GetGroupPitch(props)};
+
+    /* Calculate velocity-based doppler effect */
+    ALfloat DopplerFactor{props->DopplerFactor * Listener.Params.DopplerFactor};
+    if(DopplerFactor > 0.0f)
+    {
+        ALfloat vss{rel.SourceVelDot * -DopplerFactor};
+        ALfloat vls{rel.ListenerVelDot * -DopplerFactor};
+
+        const ALfloat SpeedOfSound{Listener.Params.SpeedOfSound};
+        if(!(vls < SpeedOfSound))
+        {
+            /* Listener moving away from the source at the speed of sound.
+             * Sound waves can't catch it.
+             */
+            Pitch = 0.0f;
+        }
+        else if(!(vss < SpeedOfSound))
+        {
+            /* Source moving toward the listener at the speed of sound. Sound
+             * waves bunch up to extreme frequencies.
+             */
+            Pitch = std::numeric_limits<float>::infinity();
+        }
+        else
+        {
+            /* Source and listener movement is nominal. Calculate the proper
+             * doppler shift.
+             */
+            Pitch *= (SpeedOfSound-vls) / (SpeedOfSound-vss);
+        }
+    }
+
+    /* Adjust pitch based on the buffer and output frequencies, and calculate
+     * fixed-point stepping value.
+     */
+    Pitch *= static_cast<ALfloat>(voice->mFrequency)/static_cast<ALfloat>(Device->MixFrequency);
+    if(Pitch > static_cast<ALfloat>(MAX_PITCH))
+        voice->mStep = MAX_PITCH<<FRACTIONBITS;
     else
         voice->mStep = maxi(fastf2i(Pitch * FRACTIONONE), 1);
-    if(props->mResampler == BSinc24Resampler)
-        BsincPrepare(voice->mStep, &voice->mResampleState.bsinc, &bsinc24);
-    else if(props->mResampler == BSinc12Resampler)
-        BsincPrepare(voice->mStep, &voice->mResampleState.bsinc, &bsinc12);
-    voice->mResampler = SelectResampler(props->mResampler);
 
     ALfloat spread{0.0f};
     if(props->Radius > Distance)
@@ -1351,130 +1938,1176 @@ void CalcAttnSourceParams(ALvoice *voice, const ALvoicePropsBase *props, const A
         spread = std::asin(props->Radius/Distance) * 2.0f;
 
     CalcPanningAndFilters(voice, ToSource[0], ToSource[1], ToSource[2]*ZScale,
-        Distance*Listener.Params.MetersPerUnit, spread, DryGain, DryGainHF, DryGainLF, WetGain,
-        WetGainLF, WetGainHF, SendSlots, props, Listener, Device);
+        Distance*Listener.Params.MetersPerUnit, spread, attn.DryGain, attn.DryGainHF,
+        attn.DryGainLF, attn.WetGain, attn.WetGainLF, attn.WetGainHF, SendSlots, props, Listener,
+        ALContext, attn_changed);
+    SetVoiceResampler(voice, props);
+
+    /* A mono voice only panned to the dry mix can be mixed in world space,
+     * so it doesn't need recalculating when the listener just turns.
+     */
+    if(ALContext->WorldRotator)
+    {
+        const bool world{!props->HeadRelative && voice->mFmtChannels == FmtMono
+            && Distance > std::numeric_limits<float>::epsilon()
+            && voice->mDirect.Buffer == ALContext->Dry.Buffer
+            && !(voice->mFlags&VOICE_HAS_HRTF) && voice->mClusterKey == 0
+            && std::all_of(SendSlots, SendSlots+NumSends,
+                [](const ALeffectslot *slot) noexcept { return slot == nullptr; })};
+        if(world || wasworld)
+            SetVoiceWorldSpace(voice, ALContext, wasworld, world);
+    }
 }
 
-void CalcSourceParams(ALvoice *voice, ALCcontext *context, bool force)
+/* Copies the groups of properties an update changed into the voice's own
+ * copy of them.
+ */
+void MergeVoiceProps(ALvoicePropsBase &dst, const ALvoiceProps &src, const ALsizei num_sends)
 {
-    ALvoiceProps *props{voice->mUpdate.exchange(nullptr, std::memory_order_acq_rel)};
-    if(!props && !force) return;
-
-    if(props)
+    const ALuint changed{src.mChanged};
+    if((changed&VPROPS_POSE))
     {
-        voice->mProps = *props;
+        dst.Position = src.Position;
+        dst.Velocity = src.Velocity;
+        dst.Direction = src.Direction;
+        dst.OrientAt = src.OrientAt;
+        dst.OrientUp = src.OrientUp;
+    }
 
-        AtomicReplaceHead(context->FreeVoiceProps, props);
+    if((changed&VPROPS_PARAMS))
+    {
+        dst.Pitch = src.Pitch;
+        dst.Gain = src.Gain;
+        dst.OuterGain = src.OuterGain;
+        dst.MinGain = src.MinGain;
+        dst.MaxGain = src.MaxGain;
+        dst.InnerAngle = src.InnerAngle;
+        dst.OuterAngle = src.OuterAngle;
+        dst.RefDistance = src.RefDistance;
+        dst.MaxDistance = src.MaxDistance;
+        dst.RolloffFactor = src.RolloffFactor;
+        dst.HeadRelative = src.HeadRelative;
+        dst.mDistanceModel = src.mDistanceModel;
+        dst.mResampler = src.mResampler;
+        dst.DirectChannels = src.DirectChannels;
+        dst.mSpatializeMode = src.mSpatializeMode;
+        dst.Priority = src.Priority;
+        dst.FullHrtf = src.FullHrtf;
+        dst.OutputChannel = src.OutputChannel;
+        dst.Instancing = src.Instancing;
+
+        dst.DryGainHFAuto = src.DryGainHFAuto;
+        dst.WetGainAuto = src.WetGainAuto;
+        dst.WetGainHFAuto = src.WetGainHFAuto;
+        dst.OuterGainHF = src.OuterGainHF;
+
+        dst.AirAbsorptionFactor = src.AirAbsorptionFactor;
+        dst.RoomRolloffFactor = src.RoomRolloffFactor;
+        dst.DopplerFactor = src.DopplerFactor;
+
+        dst.StereoPan = src.StereoPan;
+
+        dst.Radius = src.Radius;
+
+        dst.Group = src.Group;
+
+        dst.Direct = src.Direct;
     }
 
-    if((voice->mProps.mSpatializeMode == SpatializeAuto && voice->mFmtChannels == FmtMono) ||
-       voice->mProps.mSpatializeMode == SpatializeOn)
-        CalcAttnSourceParams(voice, &voice->mProps, context);
-    else
-        CalcNonAttnSourceParams(voice, &voice->mProps, context);
+    if((changed&VPROPS_SENDS))
+        std::copy_n(src.Send, num_sends, dst.Send);
 }
 
+/* Gets where a non-spatialized voice's channel is placed in the other
+ * listeners' stereo mixes, from -1 (left) to +1 (right).
+ */
+ALfloat GetChannelPan(const FmtChannels chans, const ALsizei chan) noexcept
+{
+    static constexpr ALfloat X51Pan[6]{-1.0f, 1.0f, 0.0f, 0.0f, -1.0f, 1.0f};
+    static constexpr ALfloat X61Pan[7]{-1.0f, 1.0f, 0.0f, 0.0f, 0.0f, -1.0f, 1.0f};
+    static constexpr ALfloat X71Pan[8]{-1.0f, 1.0f, 0.0f, 0.0f, -1.0f, 1.0f, -1.0f, 1.0f};
+
+    switch(chans)
+    {
+    case FmtStereo:
+    case FmtRear:
+    case FmtQuad:
+        return (chan&1) ? 1.0f : -1.0f;
+    case FmtX51: return X51Pan[chan];
+    case FmtX61: return X61Pan[chan];
+    case FmtX71: return X71Pan[chan];
+    case FmtMono:
+    case FmtBFormat2D:
+    case FmtBFormat3D:
+        break;
+    }
+    return 0.0f;
+}
 
-void ProcessParamUpdates(ALCcontext *ctx, const ALeffectslotArray *slots)
+/* Calculates the voice's mix for one of the context's other listeners. A
+ * spatialized voice (given its parameters relative to the listener) gets the
+ * listener's distance and cone attenuation, and is panned between the
+ * listener's pair of output channels by the direction to it. Others have each
+ * channel placed by its side, with only the listener's gain applied. The
+ * pitch and filters follow the main listener.
+ */
+void CalcListenerMix(ALvoice *voice, const ALvoicePropsBase *props, const ALCcontext *ALContext,
+    const size_t idx, const VoiceRelativeParams *rel)
 {
-    IncrementRef(&ctx->UpdateCount);
-    if(LIKELY(!ctx->HoldUpdates.load(std::memory_order_acquire)))
+    const ALlistener &Listener = ALContext->ExtraListeners[idx];
+    ALvoice::ListenerMixData &lmix = voice->mListenerMix[idx];
+
+    const ALint outchan{Listener.Params.OutputChannel};
+    if(outchan < 0 || outchan+2 > ALContext->RealOut.NumChannels)
     {
-        bool cforce{CalcContextParams(ctx)};
-        bool force{CalcListenerParams(ctx) || cforce};
-        force = std::accumulate(slots->begin(), slots->end(), force,
-            [ctx,cforce](bool force, ALeffectslot *slot) -> bool
-            { return CalcEffectSlotParams(slot, ctx, cforce) | force; }
-        );
+        lmix.Buffer = nullptr;
+        return;
+    }
+    lmix.Buffer = ALContext->RealOut.Buffer + outchan;
+    lmix.Channels = outchan + 2;
+    lmix.Touched = ALContext->RealOut.Touched;
 
-        std::for_each(ctx->Voices, ctx->Voices+ctx->VoiceCount.load(std::memory_order_acquire),
-            [ctx,force](ALvoice *voice) -> void
-            {
-                ALuint sid{voice->mSourceID.load(std::memory_order_acquire)};
-                if(sid) CalcSourceParams(voice, ctx, force);
-            }
-        );
+    auto set_gains = [&lmix](const ALsizei chan, const ALfloat pan, const ALfloat gain)
+        noexcept -> void
+    {
+        lmix.Gains[chan].Target[0] = std::sqrt(0.5f*(1.0f-pan)) * gain;
+        lmix.Gains[chan].Target[1] = std::sqrt(0.5f*(1.0f+pan)) * gain;
+    };
+
+    const ALsizei num_channels{voice->mNumChannels};
+    if(rel)
+    {
+        ALeffectslot *const nosends[MAX_SENDS]{};
+        VoiceAttenuation attn{};
+        attn.Distance = rel->Distance;
+        attn.Directional = rel->Directional;
+        attn.ConeDot = rel->ConeDot;
+        CalcAttenuation(attn, props, nosends, 0, Listener);
+
+        const ALfloat pan{clampf(rel->ToSource[0], -1.0f, 1.0f)};
+        for(ALsizei c{0};c < num_channels;c++)
+            set_gains(c, pan, attn.DryGain);
+        return;
     }
-    IncrementRef(&ctx->UpdateCount);
+
+    ALfloat DryGain{clampf(props->Gain, props->MinGain, props->MaxGain)};
+    DryGain *= props->Direct.Gain * Listener.Params.Gain * GetGroupGain(props);
+    DryGain = minf(DryGain, GAIN_MIX_MAX);
+
+    /* Only the W channel of B-Format is mixed. */
+    const bool isbformat{voice->mFmtChannels == FmtBFormat2D ||
+        voice->mFmtChannels == FmtBFormat3D};
+    for(ALsizei c{0};c < num_channels;c++)
+        set_gains(c, GetChannelPan(voice->mFmtChannels, c),
+            (isbformat && c > 0) ? 0.0f : DryGain);
 }
 
-void ProcessContext(ALCcontext *ctx, const ALsizei SamplesToDo)
+inline void UpdateHasListenerMix(ALvoice *voice) noexcept
 {
-    ASSUME(SamplesToDo > 0);
+    voice->mHasListenerMix = std::any_of(voice->mListenerMix.cbegin(),
+        voice->mListenerMix.cend(),
+        [](const ALvoice::ListenerMixData &lmix) noexcept -> bool
+        { return lmix.Buffer != nullptr; });
+}
 
-    const ALeffectslotArray *auxslots{ctx->ActiveAuxSlots.load(std::memory_order_acquire)};
+/* Applies the source group's committed update, if any. */
+void CalcSourceGroupParams(ALCcontext *context, ALsourceGroup *group, const ALuint committed)
+{
+    ALsourceGroupProps *props{TakeCommittedUpdate(group->Update, committed,
+        [](const ALsourceGroupProps *p) noexcept { return p->Batch; },
+        MakeReplaceUpdate(context->FreeSourceGroupProps))};
+    if(!props) return;
 
-    /* Process pending propery updates for objects on the context. */
-    ProcessParamUpdates(ctx, auxslots);
+    group->Params.Gain = props->Gain;
+    group->Params.Pitch = props->Pitch;
 
-    /* Clear auxiliary effect slot mixing buffers. */
-    std::for_each(auxslots->begin(), auxslots->end(),
-        [SamplesToDo](ALeffectslot *slot) -> void
+    AtomicReplaceHead(context->FreeSourceGroupProps, props);
+}
+
+/* Applies the committed updates of the playing voices' source groups, before
+ * any of the voices are updated so they all see the same values. Returns true
+ * if the groups were changed, which needs the grouped voices updated. An
+ * update from an uncommitted batch is left for a later pass.
+ */
+bool CalcSourceGroupsParams(ALCcontext *context, const ALuint committed)
+{
+    if(!context->SourceGroupsChanged.exchange(false, std::memory_order_acq_rel))
+        return false;
+
+    bool pending{false};
+    std::for_each(context->Voices, context->Voices+context->VoiceCount.load(std::memory_order_acquire),
+        [context,committed,&pending](ALvoice *voice) -> void
         {
-            for(auto &buffer : slot->MixBuffer)
-                std::fill_n(buffer.begin(), SamplesToDo, 0.0f);
+            if(!voice->mSourceID.load(std::memory_order_acquire)) return;
+            ALsourceGroup *group{voice->mProps.Group};
+            if(!group) return;
+
+            CalcSourceGroupParams(context, group, committed);
+            pending |= (group->Update.load(std::memory_order_relaxed) != nullptr);
         }
     );
+    if(pending)
+        context->SourceGroupsChanged.store(true, std::memory_order_release);
+    return true;
+}
 
-    /* Process voices that have a playing source. */
-    std::for_each(ctx->Voices, ctx->Voices+ctx->VoiceCount.load(std::memory_order_acquire),
-        [SamplesToDo,ctx](ALvoice *voice) -> void
+/* Updates the parameters of the context's voices that have new properties,
+ * or all of them if forced, along with those in a source group if a group
+ * changed and those linked to filters if a linked filter changed. Voices
+ * panned in world space are instead forced by worldforce. Spatialized voices
+ * are collected into batches to find their listener-relative parameters
+ * together.
+ */
+void CalcSourceParams(ALCcontext *context, const ALuint committed, const bool force,
+    const bool worldforce, const bool attnforce, const bool groupforce, const bool linkforce)
+{
+    const ALsizei num_sends{context->Device->NumAuxSends};
+    ALvoice *batch[VoiceBatchSize];
+    size_t batchcount{0};
+    auto calc_batch = [context,&batch,&batchcount]() -> void
+    {
+        VoiceRelativeParams rel[VoiceBatchSize];
+        CalcVoiceRelativeParams(batch, batchcount, context->Listener, rel);
+        for(size_t i{0};i < batchcount;++i)
+            CalcAttnSourceParams(batch[i], &batch[i]->mProps, context, rel[i]);
+        for(size_t idx{0};idx < context->ExtraListeners.size();++idx)
+        {
+            const ALlistener &listener = context->ExtraListeners[idx];
+            const bool enabled{listener.Params.OutputChannel >= 0};
+            if(enabled)
+                CalcVoiceRelativeParams(batch, batchcount, listener, rel);
+            for(size_t i{0};i < batchcount;++i)
+                CalcListenerMix(batch[i], &batch[i]->mProps, context, idx,
+                    enabled ? &rel[i] : nullptr);
+        }
+        for(size_t i{0};i < batchcount;++i)
+            UpdateHasListenerMix(batch[i]);
+        batchcount = 0;
+    };
+
+    std::for_each(context->Voices, context->Voices+context->VoiceCount.load(std::memory_order_acquire),
+        [context,committed,force,worldforce,attnforce,groupforce,linkforce,num_sends,&batch,&batchcount,&calc_batch](ALvoice *voice) -> void
         {
-            const ALvoice::State vstate{voice->mPlayState.load(std::memory_order_acquire)};
-            if(vstate == ALvoice::Stopped) return;
-            const ALuint sid{voice->mSourceID.load(std::memory_order_relaxed)};
-            if(voice->mStep < 1) return;
+            ALuint sid{voice->mSourceID.load(std::memory_order_acquire)};
+            if(!sid) return;
+            const bool grouped{groupforce && voice->mProps.Group != nullptr};
+            if(attnforce || grouped) voice->mFlags &= ~VOICE_ATTN_CACHED;
+
+            /* Voice updates only hold the changed properties, so a newer one
+             * is merged into the older.
+             */
+            ALvoiceProps *props{TakeCommittedUpdate(voice->mUpdate, committed,
+                [](const ALvoiceProps *p) noexcept { return p->mBatch; },
+                [context,num_sends](ALvoiceProps *older, ALvoiceProps *newer) noexcept -> ALvoiceProps*
+                {
+                    MergeVoiceProps(*older, *newer, num_sends);
+                    older->mChanged |= newer->mChanged;
+                    older->mBatch = newer->mBatch;
+                    AtomicReplaceHead(context->FreeVoiceProps, newer);
+                    return older;
+                })};
+            if(props)
+            {
+                MergeVoiceProps(voice->mProps, *props, num_sends);
+                voice->mFlags &= ~VOICE_ATTN_CACHED;
+
+                AtomicReplaceHead(context->FreeVoiceProps, props);
+
+                /* A voice joining a group none of the playing voices were in
+                 * may have an update to apply.
+                 */
+                if(ALsourceGroup *group{voice->mProps.Group})
+                    CalcSourceGroupParams(context, group, committed);
+            }
+
+            /* Linked filter properties are always taken from the filters,
+             * since the sources' copies may be out of date.
+             */
+            const bool world{voice->mDirect.Buffer && voice->mDirect.Buffer == context->World.Buffer};
+            const bool update{props || (world ? worldforce : force) || grouped};
+            if(!update && !linkforce) return;
+            if(ApplyFilterLinks(voice->mProps, num_sends))
+            {
+                if(linkforce) voice->mFlags &= ~VOICE_ATTN_CACHED;
+            }
+            else if(!update)
+                return;
 
-            MixVoice(voice, vstate, sid, ctx, SamplesToDo);
+            if((voice->mProps.mSpatializeMode == SpatializeAuto && voice->mFmtChannels == FmtMono)
+                || voice->mProps.mSpatializeMode == SpatializeOn)
+            {
+                batch[batchcount++] = voice;
+                if(batchcount == VoiceBatchSize)
+                    calc_batch();
+            }
+            else
+            {
+                CalcNonAttnSourceParams(voice, &voice->mProps, context);
+                for(size_t idx{0};idx < context->ExtraListeners.size();++idx)
+                    CalcListenerMix(voice, &voice->mProps, context, idx, nullptr);
+                UpdateHasListenerMix(voice);
+            }
         }
     );
+    if(batchcount > 0)
+        calc_batch();
+}
 
-    /* Process effects. */
-    if(auxslots->size() < 1) return;
+
+/* Returns true if any effect slot's target changed. */
+bool ProcessParamUpdates(ALCcontext *ctx, const ALeffectslotArray *slots)
+{
+    /* Updates from a batch that's still being published are left for a later
+     * pass, so the whole batch is applied together.
+     */
+    const ALuint committed{ctx->CommittedBatch.load(std::memory_order_acquire)};
+
+    bool retarget{false};
+    bool cforce{CalcContextParams(ctx, committed)};
+    const ALfloat oldgain{ctx->Listener.Params.Gain};
+    bool turnonly{false};
+    const bool lforce{CalcListenerParams(ctx, ctx->Listener, committed, &turnonly)};
+    /* The world bus is rotated for the listener's orientation, so voices
+     * panned in world space only need updating when the listener turns if
+     * something else changed too.
+     */
+    if(lforce && ctx->WorldRotator)
+        ctx->WorldRotator->setListener(ctx->Listener.Params.Matrix, ZScale, true);
+    bool force{cforce};
+    /* The other listeners only need their mixes recalculated. */
+    force = std::accumulate(ctx->ExtraListeners.begin(), ctx->ExtraListeners.end(), force,
+        [ctx,committed](bool force, ALlistener &listener) -> bool
+        { return CalcListenerParams(ctx, listener, committed) || force; });
+    /* The slots' effects need updating when the budget changes their
+     * quality.
+     */
+    const bool qualforce{cforce || ctx->EffectsQualityChanged};
+    ctx->EffectsQualityChanged = false;
+    bool slotforce{std::accumulate(slots->begin(), slots->end(), false,
+        [ctx,committed,qualforce,&retarget](bool force, ALeffectslot *slot) -> bool
+        {
+            const ALeffectslot *oldtarget{slot->Params.Target};
+            force |= CalcEffectSlotParams(slot, ctx, committed, qualforce);
+            retarget |= (slot->Params.Target != oldtarget);
+            return force;
+        }
+    )};
+    force |= slotforce;
+    const bool worldforce{force || (lforce && !turnonly)};
+    force |= lforce;
+
+    /* Moving or turning the listener only changes the sources' relative
+     * distance and direction, which voices check for themselves. Anything
+     * else affecting the attenuation needs it recalculated.
+     */
+    const bool attnforce{cforce || slotforce || ctx->Listener.Params.Gain != oldgain};
+    const bool groupforce{CalcSourceGroupsParams(ctx, committed)};
+    const ALuint filtergen{ctx->Device->LinkedFilterGen.load(std::memory_order_acquire)};
+    const bool linkforce{filtergen != ctx->LinkedFilterGen};
+    ctx->LinkedFilterGen = filtergen;
+
+    CalcSourceParams(ctx, committed, force, worldforce, attnforce, groupforce, linkforce);
+    return retarget;
+}
+
+/* Returns how many slots the given slot's output goes through before reaching
+ * the context's output.
+ */
+inline size_t EffectSlotDepth(const ALeffectslot *slot) noexcept
+{
+    size_t depth{0u};
+    while((slot=slot->Params.Target) != nullptr)
+        ++depth;
+    return depth;
+}
+
+/* Sorts the slots into the array's scratch storage, following the slots, so
+ * that effects come before their effect target (or their targets' target).
+ * They're ordered from the deepest in a target chain to the shallowest, which
+ * keeps slots that can't feed each other next to each other.
+ */
+void SortEffectSlots(const ALeffectslotArray *auxslots)
+{
     auto slots = auxslots->data();
     auto slots_end = slots + auxslots->size();
 
-    /* First sort the slots into scratch storage, so that effects come before
-     * their effect target (or their targets' target).
-     */
     auto sorted_slots = const_cast<ALeffectslot**>(slots_end);
     auto sorted_slots_end = sorted_slots;
-    auto in_chain = [](const ALeffectslot *slot1, const ALeffectslot *slot2) noexcept -> bool
+    for(;slots != slots_end;++slots)
+    {
+        /* Insert this effect slot prior to the first one with a lesser depth,
+         * which includes any slot it targets, directly or indirectly.
+         */
+        const size_t depth{EffectSlotDepth(*slots)};
+        auto checker = std::find_if(sorted_slots, sorted_slots_end,
+            [depth](const ALeffectslot *slot) noexcept -> bool
+            { return EffectSlotDepth(slot) < depth; });
+
+        checker = std::move_backward(checker, sorted_slots_end, sorted_slots_end+1);
+        *--checker = *slots;
+        ++sorted_slots_end;
+    }
+}
+
+/* Limits the number of voices mixed to the given budget. The voices with the
+ * highest priority are kept, and the loudest of those with equal priority.
+ * The rest get flagged as culled, so they fade out and then only have their
+ * playback position updated, until they make the cut again and fade back in.
+ */
+void CullVoices(ALCcontext *ctx, const size_t budget)
+{
+    ALvoice **voices{ctx->Voices};
+    ALvoice **voices_end{voices + ctx->VoiceCount.load(std::memory_order_acquire)};
+    ALvoice **ranking{ctx->VoiceRanking.data()};
+    ALvoice **ranking_end{std::copy_if(voices, voices_end, ranking,
+        [](const ALvoice *voice) noexcept -> bool
+        {
+            return voice->mPlayState.load(std::memory_order_acquire) == ALvoice::Playing
+                && voice->mStep > 0;
+        }
+    )};
+
+    auto uncull = [](ALvoice *voice) noexcept -> void { voice->mFlags &= ~VOICE_IS_CULLED; };
+    if(static_cast<size_t>(ranking_end-ranking) <= budget)
     {
-        while((slot1=slot1->Params.Target) != nullptr) {
-            if(slot1 == slot2) return true;
+        std::for_each(ranking, ranking_end, uncull);
+        return;
+    }
+
+    ALvoice **cutoff{ranking + budget};
+    std::nth_element(ranking, cutoff, ranking_end,
+        [](const ALvoice *lhs, const ALvoice *rhs) noexcept -> bool
+        {
+            if(lhs->mProps.Priority != rhs->mProps.Priority)
+                return lhs->mProps.Priority > rhs->mProps.Priority;
+            return lhs->mAudibility > rhs->mAudibility;
         }
+    );
+    std::for_each(ranking, cutoff, uncull);
+    std::for_each(cutoff, ranking_end,
+        [](ALvoice *voice) noexcept -> void { voice->mFlags |= VOICE_IS_CULLED; });
+}
+
+/* How often a voice's mix is timed for its mix cost, in quanta. Must be a
+ * power of 2.
+ */
+constexpr ALuint MixCostInterval{16u};
+
+/* Gets the path a voice is mixed with, for its mix cost. */
+ALuint GetVoiceMixPath(const ALvoice *voice) noexcept
+{
+    ALuint path{(voice->mStep == FRACTIONONE) ? 0u :
+        static_cast<ALuint>(voice->mActiveResampler) + 1u};
+    if((voice->mFlags&VOICE_HAS_HRTF)) path |= VOICE_COST_HRTF;
+    if((voice->mFlags&VOICE_HAS_NFC)) path |= VOICE_COST_NFC;
+    if((voice->mFlags&VOICE_IS_AMBISONIC)) path |= VOICE_COST_AMBISONIC;
+    path |= static_cast<ALuint>(voice->mNumChannels) << VOICE_COST_CHANNELS_SHIFT;
+
+    const auto sends = std::count_if(voice->mSend.begin(), voice->mSend.end(),
+        [](const ALvoice::SendData &send) noexcept -> bool { return send.Buffer != nullptr; });
+    path |= static_cast<ALuint>(sends) << VOICE_COST_SENDS_SHIFT;
+    return path;
+}
+
+void MixAndTimeVoice(ALvoice *voice, ALCcontext *ctx, MixerScratch &scratch,
+    const ALsizei SamplesToDo)
+{
+    const ALvoice::State vstate{voice->mPlayState.load(std::memory_order_acquire)};
+    if(vstate == ALvoice::Stopped) return;
+    const ALuint sid{voice->mSourceID.load(std::memory_order_relaxed)};
+    if(voice->mStep < 1) return;
+
+    AL_TRACE_SCOPE("MixVoice");
+    const bool timed{ctx->Device->MixerTimed};
+    if(LIKELY(!timed && (voice->mMixCostCounter++ & (MixCostInterval-1)) != 0))
+    {
+        MixVoice(voice, vstate, sid, ctx, scratch, SamplesToDo);
+        return;
+    }
+
+    /* The flags may change as it's mixed (e.g. if it stops), so get the path
+     * first.
+     */
+    const ALuint path{GetVoiceMixPath(voice)};
+    const auto start = std::chrono::steady_clock::now();
+    MixVoice(voice, vstate, sid, ctx, scratch, SamplesToDo);
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    const auto ns = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+
+    /* Keep a running average, starting with the first sample. */
+    const ALuint lastns{voice->mMixCostNs.load(std::memory_order_relaxed)};
+    const auto curns = static_cast<ALuint>(minu64(ns, std::numeric_limits<ALuint>::max()));
+    voice->mMixCostNs.store(lastns ? lastns - lastns/8u + curns/8u : curns,
+        std::memory_order_relaxed);
+    voice->mMixCostPath.store(path, std::memory_order_relaxed);
+    if(!timed) return;
+
+    const size_t type{(path&VOICE_COST_HRTF) ? MixerThreadStats::HrtfVoice :
+        (path&VOICE_COST_AMBISONIC) ? MixerThreadStats::AmbiVoice :
+        MixerThreadStats::PlainVoice};
+    scratch.Stats.VoiceTime[type] += ns;
+}
+
+/* Instance leaders are mixed ahead of the other voices, so they're skipped
+ * here.
+ */
+inline void MixActiveVoice(ALvoice *voice, ALCcontext *ctx, MixerScratch &scratch,
+    const ALsizei SamplesToDo)
+{
+    if(voice->mInstance && voice->mInstance->Leader == voice)
+        return;
+    MixAndTimeVoice(voice, ctx, scratch, SamplesToDo);
+}
+
+/* Splits the context's voices between the pool's threads, with each thread
+ * recording the output of the voices it mixes. The recordings are replayed in
+ * voice order after all the threads are done, so the result doesn't depend on
+ * which thread mixed which voice, and matches mixing on one thread. Voices a
+ * thread has no room left to record are mixed during the replay instead.
+ */
+void MixVoicesParallel(ALCcontext *ctx, MixerPool *pool, MixerScratch &scratch,
+    const ALsizei numvoices, const ALsizei SamplesToDo)
+{
+    ASSUME(SamplesToDo > 0);
+
+    std::for_each(ctx->VoiceThreads.begin(), ctx->VoiceThreads.end(),
+        [](std::unique_ptr<VoiceMixThread> &thrd) noexcept -> void { thrd->Log.clear(); });
+
+    pool->runWithThreadIdx(static_cast<size_t>(numvoices),
+        [ctx,SamplesToDo](size_t thread, size_t idx)
+        {
+            ALvoice *voice{ctx->Voices[idx]};
+            VoiceMixThread &thrd = *ctx->VoiceThreads[thread];
+            voice->mMixLog = nullptr;
+            if(!thrd.Log.canRecord(voice, SamplesToDo))
+                return;
+
+            voice->mMixLog = &thrd.Log;
+            voice->mMixLogBegin = thrd.Log.NumCommands;
+            MixActiveVoice(voice, ctx, thrd.Scratch, SamplesToDo);
+            voice->mMixLogEnd = thrd.Log.NumCommands;
+        }
+    );
+
+    std::for_each(ctx->Voices, ctx->Voices+numvoices,
+        [ctx,&scratch,SamplesToDo](ALvoice *voice) -> void
+        {
+            if(const VoiceMixLog *log{voice->mMixLog})
+                log->replay(voice->mMixLogBegin, voice->mMixLogEnd);
+            else
+                MixActiveVoice(voice, ctx, scratch, SamplesToDo);
+        }
+    );
+}
+
+/* Checks if the effect slot can skip processing. A slot goes idle once its
+ * input has been silent for longer than the effect's tail, and stays idle
+ * until it gets non-silent input again.
+ */
+bool EffectSlotIsIdle(ALeffectslot *slot, const ALsizei SamplesToDo)
+{
+    ASSUME(SamplesToDo > 0);
+
+    /* Only the channels written this update can be non-silent. */
+    bool silent{true};
+    ChannelMask touched{slot->WetTouched};
+    while(touched && silent)
+    {
+        const int c{CTZ64(touched)};
+        touched &= touched-1;
+
+        silent = std::all_of(slot->Wet.Buffer[c], slot->Wet.Buffer[c]+SamplesToDo,
+            [](const ALfloat s) noexcept -> bool
+            { return !(std::fabs(s) > GAIN_SILENCE_THRESHOLD); });
+    }
+    if(!silent)
+    {
+        slot->Params.IdleSamples = 0u;
         return false;
+    }
+
+    /* A half-rate state's tail is in half-rate samples, and its output is
+     * delayed by the rate conversion.
+     */
+    const EffectState *state{slot->Params.mEffectState};
+    const ALuint tail{state->mHalfRate ? state->mTailSamples*2 + EffectHalfRate::Latency :
+        state->mTailSamples};
+    if(slot->Params.IdleSamples > tail)
+        return true;
+    slot->Params.IdleSamples += static_cast<ALuint>(SamplesToDo);
+    return false;
+}
+
+/* Runs the slot's effect, writing to the given output, and records how long
+ * it took.
+ */
+void ProcessEffectSlot(ALeffectslot *slot, ALfloat (*outbuf)[BUFFERSIZE], const ALsizei SamplesToDo)
+{
+    AL_TRACE_SCOPE("EffectState::process");
+    EffectState *state{slot->Params.mEffectState};
+    const auto start = std::chrono::steady_clock::now();
+    if(EffectHalfRate *halfrate{state->mHalfRate.get()})
+    {
+        const ALsizei halfToDo{halfrate->decimate(slot->Wet.Buffer, slot->Wet.NumChannels,
+            SamplesToDo)};
+        if(halfToDo > 0)
+            state->process(halfToDo,
+                &reinterpret_cast<const ALfloat(&)[BUFFERSIZE]>(halfrate->mSamplesIn[0]),
+                slot->Wet.NumChannels,
+                &reinterpret_cast<ALfloat(&)[BUFFERSIZE]>(halfrate->mSamplesOut[0]),
+                state->mOutChannels);
+        halfrate->interpolate(outbuf, state->mOutChannels, SamplesToDo, halfToDo);
+    }
+    else
+        state->process(SamplesToDo, slot->Wet.Buffer, slot->Wet.NumChannels, outbuf,
+            state->mOutChannels);
+    if(outbuf == state->mOutBuffer)
+        MarkChannels(state->mOutTouched, state->mOutChannels);
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    slot->ProcessTime.add(static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+}
+
+/* Processes slots that don't feed each other. Those with the same effect type
+ * are grouped together, so effects that support it can process them as a
+ * batch. The batch's time is split evenly between its slots.
+ */
+void ProcessEffectSlotRun(ALeffectslot **slots, ALeffectslot **slots_end, const ALsizei SamplesToDo)
+{
+    static constexpr size_t MaxBatchSize{16};
+
+    /* Reordering slots at the same depth doesn't change the result. It's
+     * usually already sorted from the last update.
+     */
+    std::sort(slots, slots_end, [](const ALeffectslot *lhs, const ALeffectslot *rhs) noexcept -> bool
+        { return std::less<EffectStateFactory*>{}(lhs->Params.mFactory, rhs->Params.mFactory); });
+
+    auto process_batch = [SamplesToDo](EffectStateFactory *factory, ALeffectslot **batch,
+        const EffectBatchItem *items, const size_t count) -> void
+    {
+        if(count == 1)
+        {
+            ProcessEffectSlot(batch[0], items[0].SamplesOut, SamplesToDo);
+            return;
+        }
+        AL_TRACE_SCOPE("EffectState::processBatch");
+        const auto start = std::chrono::steady_clock::now();
+        factory->processBatch(SamplesToDo, items, static_cast<ALsizei>(count));
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        const auto ns = static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+        std::for_each(batch, batch+count,
+            [ns,count](ALeffectslot *slot) -> void { slot->ProcessTime.add(ns / count); });
     };
 
-    *sorted_slots_end = *slots;
-    ++sorted_slots_end;
-    while(++slots != slots_end)
+    while(slots != slots_end)
     {
-        /* If this effect slot targets an effect slot already in the list (i.e.
-         * slots outputs to something in sorted_slots), directly or indirectly,
-         * insert it prior to that element.
-         */
-        auto checker = sorted_slots;
-        do {
-            if(in_chain(*slots, *checker)) break;
-        } while(++checker != sorted_slots_end);
+        EffectStateFactory *factory{(*slots)->Params.mFactory};
+        auto group_end = std::find_if(slots+1, slots_end,
+            [factory](const ALeffectslot *slot) noexcept -> bool
+            { return slot->Params.mFactory != factory; });
+        if(!factory || !factory->canBatch() || group_end-slots < 2)
+        {
+            std::for_each(slots, group_end,
+                [SamplesToDo](ALeffectslot *slot) -> void
+                {
+                    if(EffectSlotIsIdle(slot, SamplesToDo)) return;
+                    ProcessEffectSlot(slot, slot->Params.mEffectState->mOutBuffer, SamplesToDo);
+                }
+            );
+            slots = group_end;
+            continue;
+        }
 
-        checker = std::move_backward(checker, sorted_slots_end, sorted_slots_end+1);
-        *--checker = *slots;
-        ++sorted_slots_end;
+        ALeffectslot *batch[MaxBatchSize];
+        EffectBatchItem items[MaxBatchSize];
+        size_t count{0};
+        for(;slots != group_end;++slots)
+        {
+            ALeffectslot *slot{*slots};
+            if(EffectSlotIsIdle(slot, SamplesToDo)) continue;
+
+            EffectState *state{slot->Params.mEffectState};
+            batch[count] = slot;
+            items[count] = EffectBatchItem{state, slot->Wet.Buffer, slot->Wet.NumChannels,
+                state->mOutBuffer, state->mOutChannels};
+            MarkChannels(state->mOutTouched, state->mOutChannels);
+            if(++count == MaxBatchSize)
+            {
+                process_batch(factory, batch, items, count);
+                count = 0;
+            }
+        }
+        if(count > 0)
+            process_batch(factory, batch, items, count);
+    }
+}
+
+/* Checks the time the context's effects took against the device's budget.
+ * Going over lowers the quality of effect slots at default quality, and it's
+ * restored once the effects have stayed under half the budget for a second.
+ */
+void UpdateEffectsBudget(ALCcontext *ctx, const uint64_t ns, const ALsizei SamplesToDo)
+{
+    const ALCdevice *device{ctx->Device};
+    const ALfloat budget{device->EffectsBudget * static_cast<ALfloat>(SamplesToDo) /
+        static_cast<ALfloat>(device->MixFrequency) * 1000000000.0f};
+    const auto elapsed = static_cast<ALfloat>(ns);
+
+    const bool downgraded{ctx->EffectsDowngraded.load(std::memory_order_relaxed)};
+    if(elapsed > budget)
+    {
+        ctx->EffectsUnderBudget = 0u;
+        if(!downgraded)
+        {
+            ctx->EffectsDowngraded.store(true, std::memory_order_relaxed);
+            ctx->EffectsQualityChanged = true;
+        }
+    }
+    else if(downgraded && elapsed < budget*0.5f)
+    {
+        ctx->EffectsUnderBudget += static_cast<ALuint>(SamplesToDo);
+        if(ctx->EffectsUnderBudget >= device->MixFrequency)
+        {
+            ctx->EffectsUnderBudget = 0u;
+            ctx->EffectsDowngraded.store(false, std::memory_order_relaxed);
+            ctx->EffectsQualityChanged = true;
+        }
+    }
+    else
+        ctx->EffectsUnderBudget = 0u;
+}
+
+/* Checks if the slots, all at the same depth, can be processed on separate
+ * threads with the same result as processing them in order. That needs each
+ * effect to be processed alone (not batched with others of its type), and
+ * their outputs to not overlap, as the effects add to their output.
+ */
+bool CanProcessSlotsApart(ALeffectslot **slots, ALeffectslot **slots_end)
+{
+    auto conflicts = [](const ALeffectslot *lhs, const ALeffectslot *rhs) noexcept -> bool
+    {
+        if(lhs->Params.mFactory == rhs->Params.mFactory && lhs->Params.mFactory
+            && lhs->Params.mFactory->canBatch())
+            return true;
+
+        const EffectState *lstate{lhs->Params.mEffectState};
+        const EffectState *rstate{rhs->Params.mEffectState};
+        if(!lstate->mOutBuffer || !rstate->mOutBuffer)
+            return false;
+        if(lstate->mOutTouched && lstate->mOutTouched == rstate->mOutTouched)
+            return true;
+        return lstate->mOutBuffer < rstate->mOutBuffer+rstate->mOutChannels
+            && rstate->mOutBuffer < lstate->mOutBuffer+lstate->mOutChannels;
+    };
+    for(;slots != slots_end;++slots)
+    {
+        ALeffectslot *slot{*slots};
+        if(std::any_of(slots+1, slots_end,
+            [slot,&conflicts](const ALeffectslot *other) noexcept -> bool
+            { return conflicts(slot, other); }))
+            return false;
+    }
+    return true;
+}
+
+/* Processes the sorted effect slots, splitting each depth between the pool's
+ * threads when the slots there can be processed apart. Slots at the same
+ * depth can't target each other, and each depth is processed in turn, with
+ * the deepest first (each slot only feeds slots one depth less than itself).
+ */
+void ProcessEffectSlotsParallel(ALeffectslot **sorted_slots, ALeffectslot **sorted_slots_end,
+    MixerPool *pool, const ALsizei SamplesToDo)
+{
+    ASSUME(SamplesToDo > 0);
+
+    while(sorted_slots != sorted_slots_end)
+    {
+        const size_t depth{EffectSlotDepth(*sorted_slots)};
+        auto batch_end = std::find_if(sorted_slots+1, sorted_slots_end,
+            [depth](const ALeffectslot *slot) noexcept -> bool
+            { return EffectSlotDepth(slot) != depth; });
+
+        if(batch_end-sorted_slots < 2 || !CanProcessSlotsApart(sorted_slots, batch_end))
+            ProcessEffectSlotRun(sorted_slots, batch_end, SamplesToDo);
+        else
+        {
+            pool->run(static_cast<size_t>(batch_end-sorted_slots),
+                [sorted_slots,SamplesToDo](size_t idx) -> void
+                {
+                    ALeffectslot *slot{sorted_slots[idx]};
+                    if(EffectSlotIsIdle(slot, SamplesToDo)) return;
+                    ProcessEffectSlot(slot, slot->Params.mEffectState->mOutBuffer, SamplesToDo);
+                }
+            );
+        }
+        sorted_slots = batch_end;
+    }
+}
+
+/* Finds the clusters for the voices about to be mixed. Voices in a direction
+ * bucket with at least one other voice get the cluster's buffer to mix into,
+ * while others (or all, when not clustering) are mixed individually.
+ */
+void AssignVoiceClusters(ALCcontext *ctx, const ALsizei numvoices, const bool clustering,
+    const ALsizei SamplesToDo)
+{
+    ASSUME(SamplesToDo > 0);
+
+    auto voices_end = ctx->Voices + numvoices;
+    std::for_each(ctx->Voices, voices_end,
+        [](ALvoice *voice) noexcept -> void { voice->mClusterBuffer = nullptr; });
+    ctx->NumClusters = 0;
+    if(!clustering) return;
+
+    auto clusters_begin = ctx->Clusters.begin();
+    auto find_cluster = [ctx,clusters_begin](const ALuint key) noexcept
+    {
+        auto clusters_end = clusters_begin + static_cast<ptrdiff_t>(ctx->NumClusters);
+        return std::find_if(clusters_begin, clusters_end,
+            [key](const VoiceCluster &cluster) noexcept -> bool
+            { return cluster.Key == key; });
+    };
+    auto is_clusterable = [](const ALvoice *voice) noexcept -> bool
+    {
+        return voice->mClusterKey != 0 && voice->mStep > 0 &&
+            voice->mPlayState.load(std::memory_order_relaxed) != ALvoice::Stopped;
+    };
+
+    std::for_each(ctx->Voices, voices_end,
+        [ctx,&find_cluster,&is_clusterable](ALvoice *voice) -> void
+        {
+            if(!is_clusterable(voice)) return;
+
+            auto cluster = find_cluster(voice->mClusterKey);
+            if(cluster - ctx->Clusters.begin() == static_cast<ptrdiff_t>(ctx->NumClusters))
+            {
+                if(ctx->NumClusters == ctx->Clusters.size()) return;
+                cluster->Key = voice->mClusterKey;
+                cluster->Count = 0;
+                ++ctx->NumClusters;
+            }
+            ++cluster->Count;
+        }
+    );
+
+    std::for_each(ctx->Voices, voices_end,
+        [ctx,&find_cluster,&is_clusterable](ALvoice *voice) -> void
+        {
+            if(!is_clusterable(voice)) return;
+
+            auto cluster = find_cluster(voice->mClusterKey);
+            if(cluster - ctx->Clusters.begin() < static_cast<ptrdiff_t>(ctx->NumClusters)
+                && cluster->Count > 1)
+                voice->mClusterBuffer = &cluster->Samples;
+        }
+    );
+
+    auto clusters_end = clusters_begin + static_cast<ptrdiff_t>(ctx->NumClusters);
+    std::for_each(clusters_begin, clusters_end,
+        [SamplesToDo](VoiceCluster &cluster) -> void
+        {
+            if(cluster.Count > 1)
+                std::fill_n(std::begin(cluster.Samples), SamplesToDo, 0.0f);
+        }
+    );
+}
+
+/* Finds the voices that can share their resampled samples, those playing the
+ * same static buffer with the same step and resampler at nearly the same
+ * position, and mixes each instance's leader so the others can use what it
+ * resampled. Voices within a millisecond of their leader are snapped to its
+ * position, which the source allowed by enabling instancing.
+ */
+void MixVoiceInstances(ALCcontext *ctx, MixerScratch &scratch, const ALsizei numvoices,
+    const ALsizei SamplesToDo)
+{
+    ASSUME(SamplesToDo > 0);
+
+    VoiceInstanceArray *instances{ctx->Instances.load(std::memory_order_acquire)};
+    if(!instances) return;
+
+    auto voices_end = ctx->Voices + numvoices;
+    std::for_each(ctx->Voices, voices_end,
+        [](ALvoice *voice) noexcept -> void { voice->mInstance = nullptr; });
+    instances->Count = 0;
+
+    /* Each source has its own queue item, so voices are matched by the buffer
+     * they play (or its resample cache).
+     */
+    auto data_buffer = [](const ALvoice *voice) noexcept -> const ALbuffer*
+    {
+        const ALbufferlistitem *item{voice->mCurrentBuffer.load(std::memory_order_relaxed)};
+        if(item && voice->mResampled) item = voice->mResampled->Item;
+        return item ? item->buffers[0] : nullptr;
+    };
+    auto is_instanceable = [&data_buffer](const ALvoice *voice) noexcept -> bool
+    {
+        if(!voice->mProps.Instancing || voice->mStep < 1 || voice->mPrevResampler
+            || voice->mPlayState.load(std::memory_order_relaxed) != ALvoice::Playing)
+            return false;
+        if((voice->mFlags&(VOICE_IS_STATIC|VOICE_IS_CALLBACK|VOICE_IS_AMBISONIC|VOICE_IS_DELAYED))
+            != VOICE_IS_STATIC || voice->mNumChannels > MAX_INSTANCE_CHANNELS)
+            return false;
+
+        const ALbuffer *buffer{data_buffer(voice)};
+        return buffer && !IsADPCMFmt(buffer->mFmtType) && buffer->FileReadAhead == 0;
+    };
+
+    /* Positions are compared in fixed-point source samples. */
+    const int64_t window{static_cast<int64_t>(ctx->Device->MixFrequency / 1000)};
+    auto find_instance = [instances,&data_buffer,window](const ALvoice *voice) noexcept
+    {
+        const int64_t pos{static_cast<int64_t>(
+            (voice->mPosition.load(std::memory_order_relaxed)<<FRACTIONBITS) +
+            static_cast<ALuint>(voice->mPositionFrac.load(std::memory_order_relaxed)))};
+        const bool looping{voice->mLoopBuffer.load(std::memory_order_relaxed) != nullptr};
+
+        auto instances_end = std::begin(instances->Items) + instances->Count;
+        return std::find_if(std::begin(instances->Items), instances_end,
+            [voice,&data_buffer,window,pos,looping](const VoiceInstance &inst) noexcept -> bool
+            {
+                const ALvoice *leader{inst.Leader};
+                if(data_buffer(leader) != data_buffer(voice) || leader->mStep != voice->mStep
+                    || leader->mResampler != voice->mResampler
+                    || leader->mActiveResampler != voice->mActiveResampler
+                    || leader->mNumChannels != voice->mNumChannels
+                    || (leader->mLoopBuffer.load(std::memory_order_relaxed) != nullptr) != looping)
+                    return false;
+
+                const int64_t leadpos{static_cast<int64_t>(
+                    (leader->mPosition.load(std::memory_order_relaxed)<<FRACTIONBITS) +
+                    static_cast<ALuint>(leader->mPositionFrac.load(std::memory_order_relaxed)))};
+                return std::abs(pos - leadpos) <= window*voice->mStep;
+            });
+    };
+
+    std::for_each(ctx->Voices, voices_end,
+        [instances,&is_instanceable,&find_instance](ALvoice *voice) -> void
+        {
+            if(!is_instanceable(voice)) return;
+
+            auto inst = find_instance(voice);
+            if(inst == std::begin(instances->Items) + instances->Count)
+            {
+                if(instances->Count == MAX_VOICE_INSTANCES) return;
+                inst->Leader = voice;
+                inst->Count = 0;
+                ++instances->Count;
+            }
+            ++inst->Count;
+            voice->mInstance = inst;
+        }
+    );
+
+    std::for_each(ctx->Voices, voices_end,
+        [](ALvoice *voice) noexcept -> void
+        {
+            VoiceInstance *inst{voice->mInstance};
+            if(!inst) return;
+            if(inst->Count < 2)
+            {
+                voice->mInstance = nullptr;
+                return;
+            }
+
+            const ALvoice *leader{inst->Leader};
+            if(leader == voice) return;
+            voice->mPosition.store(leader->mPosition.load(std::memory_order_relaxed),
+                std::memory_order_relaxed);
+            voice->mPositionFrac.store(leader->mPositionFrac.load(std::memory_order_relaxed),
+                std::memory_order_relaxed);
+        }
+    );
+
+    auto instances_end = std::begin(instances->Items) + instances->Count;
+    std::for_each(std::begin(instances->Items), instances_end,
+        [ctx,&scratch,SamplesToDo](VoiceInstance &inst) -> void
+        {
+            if(inst.Count > 1)
+                MixAndTimeVoice(inst.Leader, ctx, scratch, SamplesToDo);
+        }
+    );
+}
+
+/* Pans each cluster with more than one voice to the center of its direction
+ * bucket.
+ */
+void MixVoiceClusters(ALCcontext *ctx, const ALsizei SamplesToDo)
+{
+    ASSUME(SamplesToDo > 0);
+
+    auto clusters_end = ctx->Clusters.begin() + static_cast<ptrdiff_t>(ctx->NumClusters);
+    std::for_each(ctx->Clusters.begin(), clusters_end,
+        [ctx,SamplesToDo](VoiceCluster &cluster) -> void
+        {
+            if(cluster.Count < 2) return;
+
+            ALfloat coeffs[MAX_AMBI_CHANNELS];
+            CalcClusterCoeffs(ctx->Device, cluster.Key, coeffs);
+
+            ALfloat gains[MAX_OUTPUT_CHANNELS]{};
+            ComputePanGains(&ctx->Dry, coeffs, 1.0f, gains);
+
+            MarkChannels(ctx->Dry.Touched, ctx->Dry.NumChannels);
+            MixSamples(cluster.Samples, ctx->Dry.NumChannels, ctx->Dry.Buffer, gains, gains,
+                0, 0, SamplesToDo);
+        }
+    );
+}
+
+/* Processes pending property updates for objects on the context, returning
+ * true if an effect slot's target changed. This doesn't touch the mix, so
+ * it's safe to run for several contexts at once.
+ */
+bool ProcessContextUpdates(ALCcontext *ctx, const ALeffectslotArray *auxslots)
+{
+    /* Contexts being mixed in parallel have their own temp storage. */
+    MixerScratch &scratch = ctx->Scratch ? *ctx->Scratch : ctx->Device->Scratch;
+
+    const bool timed{ctx->Device->MixerTimed};
+    const auto param_start = timed ? std::chrono::steady_clock::now() :
+        std::chrono::steady_clock::time_point{};
+    const bool retarget{ProcessParamUpdates(ctx, auxslots)};
+
+    if(const ALsizei budget{ctx->Device->VoiceBudget})
+        CullVoices(ctx, static_cast<size_t>(budget));
+    if(timed)
+    {
+        const auto elapsed = std::chrono::steady_clock::now() - param_start;
+        scratch.Stats.ParamTime += static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+    }
+    return retarget;
+}
+
+/* Mixes the context's voices and effects, after its updates have been
+ * processed.
+ */
+void MixContext(ALCcontext *ctx, const ALeffectslotArray *auxslots, const bool retarget,
+    const ALsizei SamplesToDo, MixerPool *pool)
+{
+    ASSUME(SamplesToDo > 0);
+    AL_TRACE_SCOPE("ProcessContext");
+
+    MixerScratch &scratch = ctx->Scratch ? *ctx->Scratch : ctx->Device->Scratch;
+    const bool timed{ctx->Device->MixerTimed};
+
+    /* Process voices that have a playing source. */
+    const ALsizei numvoices{ctx->VoiceCount.load(std::memory_order_acquire)};
+    if(!ctx->Clusters.empty())
+        AssignVoiceClusters(ctx, numvoices, true, SamplesToDo);
+    MixVoiceInstances(ctx, scratch, numvoices, SamplesToDo);
+    if(pool && numvoices > 1 && ctx->VoiceThreads.size() == pool->threadCount())
+        MixVoicesParallel(ctx, pool, scratch, numvoices, SamplesToDo);
+    else
+        std::for_each(ctx->Voices, ctx->Voices+numvoices,
+            [SamplesToDo,ctx,&scratch](ALvoice *voice) -> void
+            { MixActiveVoice(voice, ctx, scratch, SamplesToDo); }
+        );
+    if(ctx->NumClusters > 0)
+        MixVoiceClusters(ctx, SamplesToDo);
+    if(AmbiRotator *rotator{ctx->WorldRotator.get()})
+        rotator->process(ctx->Dry.Buffer, ctx->Dry.Touched, ctx->World.Buffer,
+            ctx->World.Touched, ctx->Device->GainRampLength, SamplesToDo);
+
+    /* Process effects. */
+    if(auxslots->size() < 1) return;
+
+    /* The sorted order is kept in the array's scratch storage, and only needs
+     * to be redone when a slot's target changes, or for a new array (which
+     * starts zeroed, so the first sorted entry is null).
+     */
+    auto sorted_slots = const_cast<ALeffectslot**>(auxslots->data() + auxslots->size());
+    auto sorted_slots_end = sorted_slots + auxslots->size();
+    if(retarget || !*sorted_slots)
+        SortEffectSlots(auxslots);
+
+    const auto start = std::chrono::steady_clock::now();
+    if(pool && auxslots->size() > 1)
+        ProcessEffectSlotsParallel(sorted_slots, sorted_slots_end, pool, SamplesToDo);
+    else while(sorted_slots != sorted_slots_end)
+    {
+        const size_t depth{EffectSlotDepth(*sorted_slots)};
+        auto batch_end = std::find_if(sorted_slots+1, sorted_slots_end,
+            [depth](const ALeffectslot *slot) noexcept -> bool
+            { return EffectSlotDepth(slot) != depth; });
+        ProcessEffectSlotRun(sorted_slots, batch_end, SamplesToDo);
+        sorted_slots = batch_end;
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    const auto ns = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+
+    ctx->EffectsTime.add(ns);
+    if(timed) scratch.Stats.EffectTime += ns;
+    if(ctx->Device->EffectsBudget > 0.0f)
+        UpdateEffectsBudget(ctx, ns, SamplesToDo);
+    else if(UNLIKELY(ctx->EffectsDowngraded.load(std::memory_order_relaxed)))
+    {
+        /* The device was reset without a budget. */
+        ctx->EffectsDowngraded.store(false, std::memory_order_relaxed);
+        ctx->EffectsQualityChanged = true;
+    }
+
+    /* Clear what was mixed to the effect slots, leaving them silent for the
+     * next update.
+     */
+    std::for_each(auxslots->begin(), auxslots->end(),
+        [SamplesToDo](ALeffectslot *slot) -> void
+        { ClearTouchedChannels(slot->Wet.Buffer, slot->Wet.Touched, SamplesToDo); }
+    );
+}
+
+void ProcessContext(ALCcontext *ctx, const ALsizei SamplesToDo, MixerPool *pool)
+{
+    const ALeffectslotArray *auxslots{ctx->ActiveAuxSlots.load(std::memory_order_acquire)};
+    const bool retarget{ProcessContextUpdates(ctx, auxslots)};
+    MixContext(ctx, auxslots, retarget, SamplesToDo, pool);
+}
+
+/* Processes the device's contexts using the pool's threads. A lone context
+ * has its voices split between the threads. With multiple contexts, their
+ * property updates are processed in parallel, then they're mixed directly into
+ * the device's buffers one after another in list order, the same as mixing
+ * serially. Mixing them in parallel would need each mixed separately and
+ * summed, and float addition isn't associative, so that wouldn't give the
+ * same output.
+ */
+void ProcessContextsParallel(MixerPool *pool, ALCcontext *head, const ALsizei SamplesToDo)
+{
+    ASSUME(SamplesToDo > 0);
+
+    /* New contexts are only added to the front of the list while the mixer is
+     * running, so the list following the given head remains stable
+     * throughout.
+     */
+    size_t numctx{0u};
+    for(ALCcontext *ctx{head};ctx;ctx = ctx->next.load(std::memory_order_relaxed))
+        ++numctx;
+
+    if(numctx == 1)
+    {
+        ProcessContext(head, SamplesToDo, pool);
+        return;
     }
 
-    std::for_each(sorted_slots, sorted_slots_end,
-        [SamplesToDo](const ALeffectslot *slot) -> void
+    pool->run(numctx,
+        [head](size_t idx) -> void
         {
-            EffectState *state{slot->Params.mEffectState};
-            state->process(SamplesToDo, slot->Wet.Buffer, slot->Wet.NumChannels,
-                state->mOutBuffer, state->mOutChannels);
+            ALCcontext *ctx{head};
+            while(idx-- > 0)
+                ctx = ctx->next.load(std::memory_order_relaxed);
+
+            ctx->MixAuxSlots = ctx->ActiveAuxSlots.load(std::memory_order_acquire);
+            ctx->MixRetarget = ProcessContextUpdates(ctx, ctx->MixAuxSlots);
         }
     );
-}
 
+    for(ALCcontext *ctx{head};ctx;ctx = ctx->next.load(std::memory_order_relaxed))
+        MixContext(ctx, ctx->MixAuxSlots, ctx->MixRetarget, SamplesToDo, nullptr);
+}
 
 void ApplyStablizer(FrontStablizer *Stablizer, ALfloat (*RESTRICT Buffer)[BUFFERSIZE],
                     int lidx, int ridx, int cidx, const ALsizei SamplesToDo,
@@ -1573,7 +3206,7 @@ void ApplyStablizer(FrontStablizer *Stablizer, ALfloat (*RESTRICT Buffer)[BUFFER
     }
 }
 
-void ApplyDistanceComp(ALfloat (*Samples)[BUFFERSIZE], const DistanceComp &distcomp,
+void ApplyDistanceComp(ALfloat (*Samples)[BUFFERSIZE], DistanceComp &distcomp,
                        const ALsizei SamplesToDo, const ALsizei numchans)
 {
     ASSUME(SamplesToDo > 0);
@@ -1581,56 +3214,48 @@ void ApplyDistanceComp(ALfloat (*Samples)[BUFFERSIZE], const DistanceComp &distc
 
     for(ALsizei c{0};c < numchans;c++)
     {
-        const ALfloat gain{distcomp[c].Gain};
-        const ALsizei base{distcomp[c].Length};
-        ALfloat *distbuf{al::assume_aligned<16>(distcomp[c].Buffer)};
-
-        if(base < 1)
+        DistanceComp::DistData &chan = distcomp[c];
+        const ALfloat gain{chan.Gain};
+        const ALsizei length{chan.Length};
+        if(length < 1)
             continue;
 
-        ALfloat *inout{al::assume_aligned<16>(Samples[c])};
-        auto inout_end = inout + SamplesToDo;
-        if(LIKELY(SamplesToDo >= base))
-        {
-            auto delay_end = std::rotate(inout, inout_end - base, inout_end);
-            std::swap_ranges(inout, delay_end, distbuf);
-        }
-        else
+        /* Exchange each sample with the oldest one in the delay history,
+         * which leaves the input delayed by the history's length, and apply
+         * the gain to what comes out.
+         */
+        ALfloat *RESTRICT distbuf{al::assume_aligned<16>(chan.Buffer)};
+        ALfloat *RESTRICT inout{al::assume_aligned<16>(Samples[c])};
+        ALsizei pos{chan.Pos};
+        for(ALsizei base{0};base < SamplesToDo;)
         {
-            auto delay_start = std::swap_ranges(inout, inout_end, distbuf);
-            std::rotate(distbuf, delay_start, distbuf + base);
+            const ALsizei todo{mini(SamplesToDo-base, length-pos)};
+            for(ALsizei i{0};i < todo;++i)
+            {
+                const ALfloat delayed{distbuf[pos+i]};
+                distbuf[pos+i] = inout[base+i];
+                inout[base+i] = delayed * gain;
+            }
+            base += todo;
+            pos += todo;
+            if(pos == length) pos = 0;
         }
-        std::transform(inout, inout_end, inout, std::bind(std::multiplies<float>{}, _1, gain));
+        chan.Pos = pos;
     }
 }
 
-void ApplyDither(ALfloat (*Samples)[BUFFERSIZE], ALuint *dither_seed, const ALfloat quant_scale,
+void ApplyDither(ALfloat (*Samples)[BUFFERSIZE], ALuint *dither_seeds, const ALfloat quant_scale,
                  const ALsizei SamplesToDo, const ALsizei numchans)
 {
     ASSUME(numchans > 0);
 
-    /* Dithering. Generate whitenoise (uniform distribution of random values
-     * between -1 and +1) and add it to the sample values, after scaling up to
-     * the desired quantization depth amd before rounding.
+    /* Dithering. Add triangular noise (between -1 and +1) to the sample
+     * values, after scaling up to the desired quantization depth and before
+     * rounding. The generator lanes carry on from one channel to the next.
      */
-    const ALfloat invscale{1.0f / quant_scale};
-    ALuint seed{*dither_seed};
-    auto dither_channel = [&seed,invscale,quant_scale,SamplesToDo](ALfloat *input) -> void
-    {
-        ASSUME(SamplesToDo > 0);
-        ALfloat *buffer{al::assume_aligned<16>(input)};
-        auto dither_sample = [&seed,invscale,quant_scale](ALfloat sample) noexcept -> ALfloat
-        {
-            ALfloat val{sample * quant_scale};
-            ALuint rng0{dither_rng(&seed)};
-            ALuint rng1{dither_rng(&seed)};
-            val += static_cast<ALfloat>(rng0*(1.0/UINT_MAX) - rng1*(1.0/UINT_MAX));
-            return fast_roundf(val) * invscale;
-        };
-        std::transform(buffer, buffer+SamplesToDo, buffer, dither_sample);
-    };
+    auto dither_channel = [dither_seeds,quant_scale,SamplesToDo](ALfloat *input) -> void
+    { DitherSamples(al::assume_aligned<16>(input), dither_seeds, quant_scale, SamplesToDo); };
     std::for_each(Samples, Samples+numchans, dither_channel);
-    *dither_seed = seed;
 }
 
 
@@ -1664,125 +3289,693 @@ template<> inline ALushort SampleConv(ALfloat val) noexcept
 template<> inline ALubyte SampleConv(ALfloat val) noexcept
 { return SampleConv<ALbyte>(val) + 128; }
 
-template<DevFmtType T>
-void Write(const ALfloat (*InBuffer)[BUFFERSIZE], ALvoid *OutBuffer, ALsizei Offset,
-           ALsizei SamplesToDo, ALsizei numchans)
+/* Finishes the device's output in place, applying the distance compensation
+ * and dithering. With an output converter, dithering is left for after the
+ * output is upsampled.
+ */
+void FinishOutput(ALCdevice *device, const ALsizei SamplesToDo)
+{
+    /* Apply delays and attenuation for mismatched speaker distances. */
+    ApplyDistanceComp(device->RealOut.Buffer, device->ChannelDelay, SamplesToDo,
+        device->RealOut.NumChannels);
+
+    /* Apply dithering. The compressor should have left enough headroom for
+     * the dither noise to not saturate.
+     */
+    if(device->DitherDepth > 0.0f && !device->OutputConverter)
+        ApplyDither(device->RealOut.Buffer, device->DitherSeeds, device->DitherDepth,
+            SamplesToDo, device->RealOut.NumChannels);
+}
+
+/* Finishes the device's output and writes it, interleaved and converted. N
+ * is the channel count, if it's known at compile time.
+ */
+template<DevFmtType T, ALsizei N=0>
+void WriteOutput(ALCdevice *device, ALvoid *OutBuffer, const ALsizei Offset,
+    const ALsizei SamplesToDo)
 {
     using SampleType = typename DevFmtTypeTraits<T>::Type;
 
+    const ALsizei numchans{N ? N : device->RealOut.NumChannels};
     ASSUME(numchans > 0);
+    ASSUME(SamplesToDo > 0);
+
+    FinishOutput(device, SamplesToDo);
+
+    /* The common sample types are written by the interleaving kernel. */
+    SampleType *outbase = static_cast<SampleType*>(OutBuffer) + Offset*numchans;
+    if(T == DevFmtShort || T == DevFmtInt || T == DevFmtFloat)
+    {
+        const ALfloat *srcs[MAX_OUTPUT_CHANNELS];
+        for(ALsizei c{0};c < numchans;++c)
+            srcs[c] = device->RealOut.Buffer[c];
+        StorePCMSamples(outbase, srcs, numchans, numchans, T, SamplesToDo);
+        return;
+    }
+
+    for(ALsizei c{0};c < numchans;++c)
+    {
+        const ALfloat *RESTRICT input{al::assume_aligned<16>(device->RealOut.Buffer[c])};
+        SampleType *out{outbase + c};
+        for(ALsizei i{0};i < SamplesToDo;++i)
+            out[i*numchans] = SampleConv<SampleType>(input[i]);
+    }
+}
+
+#ifdef ALSOFT_FIXED_TYPE
+constexpr ALsizei FixedChannelCount{
+    (ALSOFT_FIXED_CHANNELS == DevFmtMono) ? 1 :
+    (ALSOFT_FIXED_CHANNELS == DevFmtStereo) ? 2 :
+    (ALSOFT_FIXED_CHANNELS == DevFmtQuad) ? 4 :
+    (ALSOFT_FIXED_CHANNELS == DevFmtX51) ? 6 :
+    (ALSOFT_FIXED_CHANNELS == DevFmtX61) ? 7 : 8};
+#endif
+
+/* Finishes the device's output and writes it in the device's format. With
+ * the library built for a fixed output format, that's checked for first, so
+ * its writer is inlined with the channel count as a constant.
+ */
+void WriteDeviceOutput(ALCdevice *device, ALvoid *OutBuffer, const ALsizei Offset,
+    const ALsizei SamplesToDo)
+{
+#ifdef ALSOFT_FIXED_TYPE
+    if(LIKELY(device->FmtType == ALSOFT_FIXED_TYPE
+        && device->RealOut.NumChannels == FixedChannelCount))
+    {
+        WriteOutput<ALSOFT_FIXED_TYPE,FixedChannelCount>(device, OutBuffer, Offset,
+            SamplesToDo);
+        return;
+    }
+#endif
+
+    switch(device->FmtType)
+    {
+#define HANDLE_WRITE(T) case T:                                            \
+    WriteOutput<T>(device, OutBuffer, Offset, SamplesToDo); break;
+        HANDLE_WRITE(DevFmtByte)
+        HANDLE_WRITE(DevFmtUByte)
+        HANDLE_WRITE(DevFmtShort)
+        HANDLE_WRITE(DevFmtUShort)
+        HANDLE_WRITE(DevFmtInt)
+        HANDLE_WRITE(DevFmtUInt)
+        HANDLE_WRITE(DevFmtFloat)
+#undef HANDLE_WRITE
+    }
+}
+
+/* Writes SamplesToDo frames of silence in the device's format. */
+template<DevFmtType T>
+void WriteSilence(ALCdevice *device, ALvoid *OutBuffer, const ALsizei Offset,
+    const ALsizei SamplesToDo)
+{
+    using SampleType = typename DevFmtTypeTraits<T>::Type;
+
+    const ALsizei numchans{device->RealOut.NumChannels};
     SampleType *outbase = static_cast<SampleType*>(OutBuffer) + Offset*numchans;
-    auto conv_channel = [&outbase,SamplesToDo,numchans](const ALfloat *inbuf) -> void
+    std::fill_n(outbase, SamplesToDo*numchans, SampleConv<SampleType>(0.0f));
+}
+
+/* Checks if the mixed update, and the distance compensation history it will
+ * be delayed with, is all below the silence threshold.
+ */
+bool OutputIsSilent(const ALCdevice *device, const ALsizei SamplesToDo)
+{
+    auto is_silent = [](const ALfloat *begin, const ALfloat *end) -> bool
+    {
+        return std::all_of(begin, end,
+            [](const ALfloat val) -> bool { return std::fabs(val) < GAIN_SILENCE_THRESHOLD; });
+    };
+
+    const ALsizei numchans{device->RealOut.NumChannels};
+    for(ALsizei c{0};c < numchans;++c)
+    {
+        const ALfloat *buffer{device->RealOut.Buffer[c]};
+        if(!is_silent(buffer, buffer+SamplesToDo))
+            return false;
+
+        const DistanceComp::DistData &chan = device->ChannelDelay[c];
+        if(chan.Buffer && !is_silent(chan.Buffer, chan.Buffer+chan.Length))
+            return false;
+    }
+    return true;
+}
+
+inline uint64_t ElapsedNs(const std::chrono::steady_clock::time_point start,
+    const std::chrono::steady_clock::time_point end) noexcept
+{
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+}
+
+/* Collects the update's stats from the scratch storage of each thread that
+ * mixed the given contexts, adding them to the device's stats, and clears
+ * them for the next update. This must be done before the mix count says the
+ * update is done, as the contexts may be released after.
+ */
+void GatherMixerStats(ALCdevice *device, ALCcontext *head)
+{
+    MixerThreadStats total{};
+    auto gather = [&total](MixerScratch &scratch) noexcept -> void
+    {
+        MixerThreadStats &stats = scratch.Stats;
+        total.ParamTime += stats.ParamTime;
+        std::transform(std::begin(stats.VoiceTime), std::end(stats.VoiceTime),
+            std::begin(total.VoiceTime), std::begin(total.VoiceTime), std::plus<uint64_t>{});
+        total.EffectTime += stats.EffectTime;
+        total.VoicesMixed += stats.VoicesMixed;
+        total.VoicesSkipped += stats.VoicesSkipped;
+        stats = MixerThreadStats{};
+    };
+    gather(device->Scratch);
+    for(ALCcontext *ctx{head};ctx;ctx = ctx->next.load(std::memory_order_relaxed))
+    {
+        if(ctx->Scratch)
+            gather(*ctx->Scratch);
+        for(auto &thrd : ctx->VoiceThreads)
+            gather(thrd->Scratch);
+    }
+
+    MixerStats &stats = device->MixStats;
+    stats.VoicesMixed.add(total.VoicesMixed);
+    stats.VoicesSkipped.add(total.VoicesSkipped);
+    if(!device->MixerTimed)
+        return;
+
+    stats.ParamTime.add(total.ParamTime);
+    uint64_t voicetime{0u};
+    for(size_t i{0};i < MixerThreadStats::VoiceTypeCount;++i)
+    {
+        stats.VoiceTypeTime[i].add(total.VoiceTime[i]);
+        voicetime += total.VoiceTime[i];
+    }
+    stats.VoiceTime.add(voicetime);
+    stats.EffectTime.add(total.EffectTime);
+}
+
+/* Checks if any of the device's contexts are listening for performance
+ * events, and could be sent one.
+ */
+bool WantPerfEvents(const ALCdevice *device, const ALCcontext *head) noexcept
+{
+    if(!(device->PerfEventThreshold > 0.0f))
+        return false;
+    for(const ALCcontext *ctx{head};ctx;ctx = ctx->next.load(std::memory_order_relaxed))
+    {
+        if((ctx->EnabledEvts.load(std::memory_order_acquire)&EventType_Performance))
+            return true;
+    }
+    return false;
+}
+
+/* Sends a performance event to the contexts listening for them, for an update
+ * that took too much of its period. It carries the update's stage times, so
+ * the app can see what to cut back on.
+ */
+void SendPerfEvent(ALCdevice *device, const uint64_t updatetime, const uint64_t period)
+{
+    const MixerStats &stats = device->MixStats;
+    auto last_us = [](const MixerStat &stat) noexcept -> unsigned long
+    { return static_cast<unsigned long>(stat.Last.load(std::memory_order_relaxed) / 1000u); };
+
+    AsyncEvent evt{EventType_Performance};
+    evt.u.user.type = AL_EVENT_TYPE_PERFORMANCE_SOFT;
+    evt.u.user.id = 0;
+    /* The percentage of the period used. */
+    evt.u.user.param = static_cast<ALuint>(minu64(updatetime*100u / period,
+        std::numeric_limits<ALuint>::max()));
+    snprintf(evt.u.user.msg, sizeof(evt.u.user.msg),
+        "Mixer update took %lluus of its %lluus period (params %luus, voices %luus, "
+        "effects %luus, post-process %luus, output %luus; %lu voices mixed)",
+        static_cast<unsigned long long>(updatetime/1000u),
+        static_cast<unsigned long long>(period/1000u), last_us(stats.ParamTime),
+        last_us(stats.VoiceTime), last_us(stats.EffectTime), last_us(stats.PostProcessTime),
+        last_us(stats.OutputTime),
+        static_cast<unsigned long>(stats.VoicesMixed.Last.load(std::memory_order_relaxed)));
+
+    /* The backend's lock is held while mixing, so the context list can't
+     * change under us.
+     */
+    ALCcontext *ctx{device->ContextList.load(std::memory_order_acquire)};
+    for(;ctx;ctx = ctx->next.load(std::memory_order_relaxed))
+    {
+        if(!(ctx->EnabledEvts.load(std::memory_order_acquire)&EventType_Performance))
+            continue;
+        RingBuffer *ring{ctx->AsyncEvents.get()};
+        auto evt_data = ring->getWriteVector().first;
+        if(evt_data.len > 0)
+        {
+            new (evt_data.buf) AsyncEvent{evt};
+            ring->writeAdvance(1);
+            WakeEventThrd();
+        }
+    }
+}
+
+/* Finishes the device's stats for an update, once its output is written, and
+ * passes the output on to any mirrors.
+ */
+void EndMixerUpdate(ALCdevice *device, const ALsizei SamplesToDo)
+{
+    for(OutputMirrorPtr &mirror : device->Mirrors)
+        mirror->write(device->RealOut.Buffer, SamplesToDo);
+
+    MixerStats &stats = device->MixStats;
+    stats.Updates.store(stats.Updates.load(std::memory_order_relaxed)+1,
+        std::memory_order_relaxed);
+    if(!device->MixerTimed)
+        return;
+
+    const auto now = std::chrono::steady_clock::now();
+    const uint64_t updatetime{ElapsedNs(stats.UpdateStart, now)};
+    stats.OutputTime.add(ElapsedNs(stats.PostProcessEnd, now));
+    stats.UpdateTime.add(updatetime);
+
+    const uint64_t period{static_cast<uint64_t>(SamplesToDo) * 1000000000u /
+        device->MixFrequency};
+    if(updatetime > period)
+        stats.LateUpdates.store(stats.LateUpdates.load(std::memory_order_relaxed)+1,
+            std::memory_order_relaxed);
+    if(updatetime > stats.PeakUpdateTime.load(std::memory_order_relaxed))
+    {
+        stats.PeakUpdateTime.store(updatetime, std::memory_order_relaxed);
+        stats.PeakUpdatePeriod.store(period, std::memory_order_relaxed);
+    }
+
+    if(device->PerfEventThreshold > 0.0f && period > 0
+        && static_cast<double>(updatetime) > static_cast<double>(period)*device->PerfEventThreshold)
+        SendPerfEvent(device, updatetime, period);
+}
+
+/* Increments the clock time. Every second's worth of samples is converted and
+ * added to clock base so that large sample counts don't overflow during
+ * conversion. This also guarantees a stable conversion.
+ */
+inline void AdvanceClock(ALCdevice *device, const ALsizei SamplesToDo)
+{
+    device->SamplesDone += static_cast<ALuint>(SamplesToDo);
+    device->ClockBase += std::chrono::seconds{device->SamplesDone / device->MixFrequency};
+    device->SamplesDone %= device->MixFrequency;
+}
+
+/* Applies the fade asked for around a reset that keeps the device running to
+ * the update's RealOut buffer, moving on to the next stage once a fade is
+ * done. Silent is set when the buffer is known to be silent already.
+ */
+void ApplyOutputFade(ALCdevice *device, const ALsizei SamplesToDo, const bool silent)
+{
+    OutputFade fade{device->OutputFadeState.load(std::memory_order_acquire)};
+    if(LIKELY(fade == OutputFadeNone))
+        return;
+
+    if(!silent && fade == OutputFadeSilent)
+        std::for_each(device->RealOut.Buffer, device->RealOut.Buffer+device->RealOut.NumChannels,
+            [SamplesToDo](ALfloat (&buffer)[BUFFERSIZE]) -> void
+            { std::fill_n(std::begin(buffer), SamplesToDo, 0.0f); }
+        );
+    else if(!silent)
     {
-        ASSUME(SamplesToDo > 0);
-        SampleType *out{outbase++};
-        std::for_each<const ALfloat*RESTRICT>(inbuf, inbuf+SamplesToDo,
-            [numchans,&out](const ALfloat s) noexcept -> void
+        /* Fade over the whole update, ending silent for a fade-out and
+         * starting silent for a fade-in.
+         */
+        const ALfloat step{1.0f / static_cast<ALfloat>(SamplesToDo)};
+        const bool fadeout{fade == OutputFadeOut};
+        std::for_each(device->RealOut.Buffer, device->RealOut.Buffer+device->RealOut.NumChannels,
+            [SamplesToDo,step,fadeout](ALfloat (&buffer)[BUFFERSIZE]) -> void
             {
-                *out = SampleConv<SampleType>(s);
-                out += numchans;
+                for(ALsizei i{0};i < SamplesToDo;++i)
+                {
+                    const ALfloat gain{fadeout ? static_cast<ALfloat>(SamplesToDo-1-i)*step :
+                        static_cast<ALfloat>(i)*step};
+                    buffer[i] *= gain;
+                }
             }
         );
-    };
-    std::for_each(InBuffer, InBuffer+numchans, conv_channel);
+    }
+
+    /* A reset asking for another fade-out while this one was applied is left
+     * for the next update.
+     */
+    if(fade == OutputFadeOut)
+        device->OutputFadeState.compare_exchange_strong(fade, OutputFadeSilent,
+            std::memory_order_acq_rel, std::memory_order_acquire);
+    else if(fade == OutputFadeIn)
+        device->OutputFadeState.compare_exchange_strong(fade, OutputFadeNone,
+            std::memory_order_acq_rel, std::memory_order_acquire);
 }
 
-} // namespace
+/* Mixes and post-processes one update of SamplesToDo samples (no more than
+ * the device's mix quantum) into the device's RealOut buffer. The output then
+ * needs to be finished with WriteOutput or FinishOutput, followed by
+ * EndMixerUpdate.
+ */
+void MixUpdate(ALCdevice *device, const ALsizei SamplesToDo)
+{
+    /* The update's start is always noted, as whether it's timed isn't known
+     * until the context list can be checked for performance event listeners.
+     */
+    device->MixStats.UpdateStart = std::chrono::steady_clock::now();
 
-void aluMixData(ALCdevice *device, ALvoid *OutBuffer, ALsizei NumSamples)
+    /* Clear the real output. A separate dry mix is instead cleared as it's
+     * used by the post-process, so it starts silent.
+     */
+    std::for_each(device->RealOut.Buffer, device->RealOut.Buffer+device->RealOut.NumChannels,
+        [SamplesToDo](ALfloat (&buffer)[BUFFERSIZE]) -> void
+        { std::fill_n(std::begin(buffer), SamplesToDo, 0.0f); }
+    );
+
+    /* Increment the mix count at the start (lsb should now be 1). */
+    IncrementRef(&device->MixCount);
+
+    /* For each context on this device, process and mix its sources and
+     * effects.
+     */
+    ALCcontext *const head{device->ContextList.load(std::memory_order_acquire)};
+    const bool timed{device->MixerStatsEnabled || WantPerfEvents(device, head)};
+    device->MixerTimed = timed;
+    if(MixerPool *pool{device->MixThreads.get()})
+        ProcessContextsParallel(pool, head, SamplesToDo);
+    else for(ALCcontext *ctx{head};ctx;ctx = ctx->next.load(std::memory_order_relaxed))
+        ProcessContext(ctx, SamplesToDo, nullptr);
+    GatherMixerStats(device, head);
+
+    AdvanceClock(device, SamplesToDo);
+
+    /* Increment the mix count at the end (lsb should now be 0). */
+    IncrementRef(&device->MixCount);
+
+    const auto post_start = timed ? std::chrono::steady_clock::now() :
+        std::chrono::steady_clock::time_point{};
+
+    /* Apply any needed post-process for finalizing the Dry mix to the
+     * RealOut (Ambisonic decode, UHJ encode, etc).
+     */
+    if(LIKELY(device->PostProcess))
+    {
+        AL_TRACE_SCOPE("PostProcess");
+        device->PostProcess(device, SamplesToDo);
+    }
+    if(device->Dry.Touched)
+        ClearTouchedChannels(device->Dry.Buffer, device->Dry.Touched, SamplesToDo);
+
+    /* Apply front image stablization for surround sound, if applicable. */
+    if(device->Stablizer)
+    {
+        const int lidx{GetChannelIdxByName(device->RealOut, FrontLeft)};
+        const int ridx{GetChannelIdxByName(device->RealOut, FrontRight)};
+        const int cidx{GetChannelIdxByName(device->RealOut, FrontCenter)};
+        assert(lidx >= 0 && ridx >= 0 && cidx >= 0);
+
+        ApplyStablizer(device->Stablizer.get(), device->RealOut.Buffer, lidx, ridx, cidx,
+            SamplesToDo, device->RealOut.NumChannels);
+    }
+
+    /* Apply compression, limiting sample amplitude if needed or desired. */
+    if(Compressor *comp{device->Limiter.get()})
+        comp->process(SamplesToDo, device->RealOut.Buffer);
+
+    ApplyOutputFade(device, SamplesToDo, false);
+
+    if(timed)
+    {
+        MixerStats &stats = device->MixStats;
+        stats.PostProcessEnd = std::chrono::steady_clock::now();
+        stats.PostProcessTime.add(ElapsedNs(post_start, stats.PostProcessEnd));
+    }
+
+    /* The distance compensation and dithering are left for the output to be
+     * finished with.
+     */
+}
+
+/* Checks if any of the device's contexts have a voice playing (or stopping). */
+bool HasActiveVoices(const ALCdevice *device) noexcept
 {
-    FPUCtl mixer_mode{};
-    for(ALsizei SamplesDone{0};SamplesDone < NumSamples;)
+    const ALCcontext *ctx{device->ContextList.load(std::memory_order_acquire)};
+    for(;ctx;ctx = ctx->next.load(std::memory_order_relaxed))
     {
-        const ALsizei SamplesToDo{mini(NumSamples-SamplesDone, BUFFERSIZE)};
+        ALvoice **voices{ctx->Voices};
+        ALvoice **voices_end{voices + ctx->VoiceCount.load(std::memory_order_acquire)};
+        auto is_active = [](const ALvoice *voice) noexcept -> bool
+        { return voice->mPlayState.load(std::memory_order_acquire) != ALvoice::Stopped; };
+        if(std::any_of(voices, voices_end, is_active))
+            return true;
+    }
+    return false;
+}
 
-        /* Clear main mixing buffers. */
-        std::for_each(device->MixBuffer.begin(), device->MixBuffer.end(),
-            [SamplesToDo](std::array<ALfloat,BUFFERSIZE> &buffer) -> void
-            { std::fill_n(buffer.begin(), SamplesToDo, 0.0f); }
-        );
+/* Mixes an update like MixUpdate, unless the device has had nothing playing
+ * and silent output for its idle timeout. An idle update leaves the RealOut
+ * buffer silent without processing the contexts, only advancing the clock,
+ * and returns false as the output doesn't need finishing. Pending property
+ * changes are left for when something plays again, which wakes the device
+ * for the next update.
+ */
+bool MixUpdateUnlessIdle(ALCdevice *device, const ALsizei SamplesToDo)
+{
+    if(LIKELY(device->IdleTimeout == 0))
+    {
+        MixUpdate(device, SamplesToDo);
+        return true;
+    }
+
+    const bool active{HasActiveVoices(device)};
+    if(!active && device->SilentSamples >= device->IdleTimeout)
+    {
+        if(!device->IdleOutput)
+        {
+            std::for_each(device->RealOut.Buffer,
+                device->RealOut.Buffer+device->RealOut.NumChannels,
+                [](ALfloat (&buffer)[BUFFERSIZE]) -> void
+                { std::fill(std::begin(buffer), std::end(buffer), 0.0f); }
+            );
+            device->IdleOutput = true;
+        }
 
-        /* Increment the mix count at the start (lsb should now be 1). */
+        ApplyOutputFade(device, SamplesToDo, true);
+
+        device->MixerTimed = false;
+        IncrementRef(&device->MixCount);
+        AdvanceClock(device, SamplesToDo);
         IncrementRef(&device->MixCount);
+        return false;
+    }
+    device->IdleOutput = false;
 
-        /* For each context on this device, process and mix its sources and
-         * effects.
-         */
-        ALCcontext *ctx{device->ContextList.load(std::memory_order_acquire)};
-        while(ctx)
+    MixUpdate(device, SamplesToDo);
+    if(active || !OutputIsSilent(device, SamplesToDo))
+        device->SilentSamples = 0;
+    else
+        device->SilentSamples = minu(device->SilentSamples+static_cast<ALuint>(SamplesToDo),
+            device->IdleTimeout);
+    return true;
+}
+
+/* Writes SamplesToDo frames of silence in the device's format. */
+void WriteDeviceSilence(ALCdevice *device, ALvoid *OutBuffer, const ALsizei Offset,
+    const ALsizei SamplesToDo)
+{
+    switch(device->FmtType)
+    {
+#define HANDLE_WRITE(T) case T:                                            \
+    WriteSilence<T>(device, OutBuffer, Offset, SamplesToDo); break;
+        HANDLE_WRITE(DevFmtByte)
+        HANDLE_WRITE(DevFmtUByte)
+        HANDLE_WRITE(DevFmtShort)
+        HANDLE_WRITE(DevFmtUShort)
+        HANDLE_WRITE(DevFmtInt)
+        HANDLE_WRITE(DevFmtUInt)
+        HANDLE_WRITE(DevFmtFloat)
+#undef HANDLE_WRITE
+    }
+}
+
+/* Mixes at the device's mix rate, upsampling the finished mix to the output
+ * rate and format with the output converter. Only as much is mixed as the
+ * converter needs for the requested output, with any leftover mix kept for
+ * the next call. With dithering, the converter's output stays float, to be
+ * dithered at the output rate before it's quantized.
+ */
+void MixDataResampled(ALCdevice *device, ALvoid *OutBuffer, ALsizei NumSamples)
+{
+    SampleConverter *converter{device->OutputConverter.get()};
+    const ALsizei numchans{device->RealOut.NumChannels};
+    const ALsizei frame_size{numchans * BytesFromDevFmt(device->FmtType)};
+    const uint64_t mixfreq{device->MixFrequency};
+    const uint64_t outfreq{device->Frequency};
+
+    auto output = static_cast<ALbyte*>(OutBuffer);
+    while(NumSamples > 0)
+    {
+        if(device->OutputMixCount == 0)
+        {
+            const auto needed = static_cast<ALsizei>(
+                (static_cast<uint64_t>(NumSamples)*mixfreq + outfreq-1) / outfreq);
+            const ALsizei SamplesToDo{mini((needed+3)&~3, device->MixQuantum)};
+
+            if(MixUpdateUnlessIdle(device, SamplesToDo))
+                FinishOutput(device, SamplesToDo);
+
+            const ALfloat *srcs[MAX_OUTPUT_CHANNELS];
+            for(ALsizei c{0};c < numchans;++c)
+                srcs[c] = device->RealOut.Buffer[c];
+            StorePCMSamples(device->OutputMix.data(), srcs, numchans, numchans, DevFmtFloat,
+                SamplesToDo);
+            EndMixerUpdate(device, SamplesToDo);
+            device->OutputMixPos = 0;
+            device->OutputMixCount = SamplesToDo;
+        }
+
+        const ALvoid *src{device->OutputMix.data() + device->OutputMixPos*numchans};
+        ALsizei srcframes{device->OutputMixCount};
+        ALsizei done;
+        if(!(device->DitherDepth > 0.0f))
+            done = converter->convert(&src, &srcframes, output, NumSamples);
+        else
         {
-            ProcessContext(ctx, SamplesToDo);
+            /* The mix in RealOut has been copied to OutputMix, so RealOut
+             * holds the converted samples for dithering.
+             */
+            ALfloat *converted{device->OutputConverted.data()};
+            done = converter->convert(&src, &srcframes, converted, mini(NumSamples, BUFFERSIZE));
+            for(ALsizei c{0};c < numchans;++c)
+            {
+                ALfloat *RESTRICT dst{device->RealOut.Buffer[c]};
+                for(ALsizei i{0};i < done;++i)
+                    dst[i] = converted[i*numchans + c];
+            }
+            if(done > 0)
+            {
+                ApplyDither(device->RealOut.Buffer, device->DitherSeeds, device->DitherDepth,
+                    done, numchans);
 
-            ctx = ctx->next.load(std::memory_order_relaxed);
+                const ALfloat *srcs[MAX_OUTPUT_CHANNELS];
+                for(ALsizei c{0};c < numchans;++c)
+                    srcs[c] = device->RealOut.Buffer[c];
+                StorePCMSamples(output, srcs, numchans, numchans, device->FmtType, done);
+            }
         }
+        device->OutputMixPos += device->OutputMixCount - srcframes;
+        device->OutputMixCount = srcframes;
 
-        /* Increment the clock time. Every second's worth of samples is
-         * converted and added to clock base so that large sample counts don't
-         * overflow during conversion. This also guarantees a stable
-         * conversion.
-         */
-        device->SamplesDone += SamplesToDo;
-        device->ClockBase += std::chrono::seconds{device->SamplesDone / device->Frequency};
-        device->SamplesDone %= device->Frequency;
+        output += done*frame_size;
+        NumSamples -= done;
+    }
+}
 
-        /* Increment the mix count at the end (lsb should now be 0). */
-        IncrementRef(&device->MixCount);
+} // namespace
 
-        /* Apply any needed post-process for finalizing the Dry mix to the
-         * RealOut (Ambisonic decode, UHJ encode, etc).
-         */
-        if(LIKELY(device->PostProcess))
-            device->PostProcess(device, SamplesToDo);
+bool aluMixDataSparse(ALCdevice *device, ALvoid *OutBuffer, ALsizei NumSamples)
+{
+    AL_TRACE_SCOPE("aluMixDataSparse");
+    FPUCtl mixer_mode{};
+    al::RTSection rt_section{};
+    bool written{false};
+    for(ALsizei SamplesDone{0};SamplesDone < NumSamples;)
+    {
+        const ALsizei SamplesToDo{mini(NumSamples-SamplesDone, device->MixQuantum)};
 
-        /* Apply front image stablization for surround sound, if applicable. */
-        if(device->Stablizer)
+        const bool mixed{MixUpdateUnlessIdle(device, SamplesToDo)};
+
+        /* Until something audible is mixed, the output is left alone. Once
+         * it is, the updates skipped so far are filled with silence and the
+         * rest is written as normal.
+         */
+        if(!written)
         {
-            const int lidx{GetChannelIdxByName(device->RealOut, FrontLeft)};
-            const int ridx{GetChannelIdxByName(device->RealOut, FrontRight)};
-            const int cidx{GetChannelIdxByName(device->RealOut, FrontCenter)};
-            assert(lidx >= 0 && ridx >= 0 && cidx >= 0);
+            if(!mixed || OutputIsSilent(device, SamplesToDo))
+            {
+                EndMixerUpdate(device, SamplesToDo);
+                SamplesDone += SamplesToDo;
+                continue;
+            }
+            written = true;
 
-            ApplyStablizer(device->Stablizer.get(), device->RealOut.Buffer, lidx, ridx, cidx,
-                SamplesToDo, device->RealOut.NumChannels);
+            if(SamplesDone > 0)
+                WriteDeviceSilence(device, OutBuffer, 0, SamplesDone);
         }
 
-        /* Apply compression, limiting sample amplitude if needed or desired. */
-        if(Compressor *comp{device->Limiter.get()})
-            comp->process(SamplesToDo, device->RealOut.Buffer);
+        if(mixed)
+            WriteDeviceOutput(device, OutBuffer, SamplesDone, SamplesToDo);
+        else
+            WriteDeviceSilence(device, OutBuffer, SamplesDone, SamplesToDo);
+        EndMixerUpdate(device, SamplesToDo);
 
-        /* Apply delays and attenuation for mismatched speaker distances. */
-        ApplyDistanceComp(device->RealOut.Buffer, device->ChannelDelay, SamplesToDo,
-            device->RealOut.NumChannels);
+        SamplesDone += SamplesToDo;
+    }
+    return written;
+}
 
-        /* Apply dithering. The compressor should have left enough headroom for
-         * the dither noise to not saturate.
-         */
-        if(device->DitherDepth > 0.0f)
-            ApplyDither(device->RealOut.Buffer, &device->DitherSeed, device->DitherDepth,
-                SamplesToDo, device->RealOut.NumChannels);
+void aluMixData(ALCdevice *device, ALvoid *OutBuffer, ALsizei NumSamples)
+{
+    AL_TRACE_SCOPE("aluMixData");
+    if(OutputMirror *mirror{device->Mirror})
+    {
+        mirror->read(OutBuffer, NumSamples);
+        return;
+    }
 
-        if(LIKELY(OutBuffer))
+    FPUCtl mixer_mode{};
+    al::RTSection rt_section{};
+    if(device->OutputConverter)
+    {
+        if(OutBuffer)
         {
-            ALfloat (*Buffer)[BUFFERSIZE]{device->RealOut.Buffer};
-            ALsizei Channels{device->RealOut.NumChannels};
+            MixDataResampled(device, OutBuffer, NumSamples);
+            return;
+        }
+        /* With nothing to write, just mix the equivalent time. */
+        NumSamples = static_cast<ALsizei>((static_cast<uint64_t>(NumSamples)*device->MixFrequency
+            + device->Frequency/2) / device->Frequency);
+    }
+
+    for(ALsizei SamplesDone{0};SamplesDone < NumSamples;)
+    {
+        const ALsizei SamplesToDo{mini(NumSamples-SamplesDone, device->MixQuantum)};
 
-            /* Finally, interleave and convert samples, writing to the device's
-             * output buffer.
+        if(!MixUpdateUnlessIdle(device, SamplesToDo))
+        {
+            if(LIKELY(OutBuffer))
+                WriteDeviceSilence(device, OutBuffer, SamplesDone, SamplesToDo);
+        }
+        else if(LIKELY(OutBuffer))
+        {
+            /* Finally, finish, interleave, and convert samples, writing to the
+             * device's output buffer.
              */
-            switch(device->FmtType)
-            {
-#define HANDLE_WRITE(T) case T:                                            \
-    Write<T>(Buffer, OutBuffer, SamplesDone, SamplesToDo, Channels); break;
-                HANDLE_WRITE(DevFmtByte)
-                HANDLE_WRITE(DevFmtUByte)
-                HANDLE_WRITE(DevFmtShort)
-                HANDLE_WRITE(DevFmtUShort)
-                HANDLE_WRITE(DevFmtInt)
-                HANDLE_WRITE(DevFmtUInt)
-                HANDLE_WRITE(DevFmtFloat)
-#undef HANDLE_WRITE
-            }
+            WriteDeviceOutput(device, OutBuffer, SamplesDone, SamplesToDo);
         }
+        else
+            FinishOutput(device, SamplesToDo);
+        EndMixerUpdate(device, SamplesToDo);
+
+        SamplesDone += SamplesToDo;
+    }
+}
+
+void aluMixDataPlanar(ALCdevice *device, ALfloat *const *OutBuffers, ALsizei NumSamples)
+{
+    AL_TRACE_SCOPE("aluMixDataPlanar");
+    if(OutputMirror *mirror{device->Mirror})
+    {
+        mirror->readPlanar(OutBuffers, NumSamples);
+        return;
+    }
+
+    FPUCtl mixer_mode{};
+    al::RTSection rt_section{};
+    for(ALsizei SamplesDone{0};SamplesDone < NumSamples;)
+    {
+        const ALsizei SamplesToDo{mini(NumSamples-SamplesDone, device->MixQuantum)};
+
+        if(MixUpdateUnlessIdle(device, SamplesToDo))
+            FinishOutput(device, SamplesToDo);
+
+        /* Copy each output channel straight to its own buffer. */
+        const ALfloat (*Buffer)[BUFFERSIZE]{device->RealOut.Buffer};
+        const ALsizei Channels{device->RealOut.NumChannels};
+        for(ALsizei c{0};c < Channels;++c)
+            std::copy_n(Buffer[c], SamplesToDo, OutBuffers[c] + SamplesDone);
+        EndMixerUpdate(device, SamplesToDo);
 
         SamplesDone += SamplesToDo;
     }
@@ -1819,7 +4012,7 @@ void aluHandleDisconnect(ALCdevice *device, const char *msg, ...)
             {
                 new (evt_data.buf) AsyncEvent{evt};
                 ring->writeAdvance(1);
-                ctx->EventSem.post();
+                WakeEventThrd();
             }
         }
 
@@ -5,9 +5,14 @@
 
 /* The maximum number of Ambisonics channels. For a given order (o), the size
  * needed will be (o+1)**2, thus zero-order has 1, first-order has 4, second-
- * order has 9, third-order has 16, and fourth-order has 25.
+ * order has 9, third-order has 16, fourth-order has 25, and so on up to
+ * seventh-order with 64.
+ *
+ * Only loopback devices can output above third-order, and the FuMa layout and
+ * scaling only go up to third-order. Mixing buffers are sized for the order
+ * actually in use, so this just sets the size of the static tables.
  */
-#define MAX_AMBI_ORDER 3
+#define MAX_AMBI_ORDER 7
 constexpr inline size_t AmbiChannelsFromOrder(size_t order) noexcept
 { return (order+1) * (order+1); }
 #define MAX_AMBI_CHANNELS AmbiChannelsFromOrder(MAX_AMBI_ORDER)
@@ -42,6 +47,12 @@ constexpr inline size_t Ambi2DChannelsFromOrder(size_t order) noexcept
  */
 struct AmbiScale {
     static constexpr std::array<float,MAX_AMBI_CHANNELS> FromN3D{{
+        1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f,
+        1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f,
+        1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f,
+        1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f,
+        1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f,
+        1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f,
         1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f,
         1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f
     }};
@@ -62,7 +73,56 @@ struct AmbiScale {
         2.645751311f, /* ACN 13, sqrt(7) */
         2.645751311f, /* ACN 14, sqrt(7) */
         2.645751311f, /* ACN 15, sqrt(7) */
+        3.000000000f, /* ACN 16, sqrt(9) */
+        3.000000000f, /* ACN 17, sqrt(9) */
+        3.000000000f, /* ACN 18, sqrt(9) */
+        3.000000000f, /* ACN 19, sqrt(9) */
+        3.000000000f, /* ACN 20, sqrt(9) */
+        3.000000000f, /* ACN 21, sqrt(9) */
+        3.000000000f, /* ACN 22, sqrt(9) */
+        3.000000000f, /* ACN 23, sqrt(9) */
+        3.000000000f, /* ACN 24, sqrt(9) */
+        3.316624790f, /* ACN 25, sqrt(11) */
+        3.316624790f, /* ACN 26, sqrt(11) */
+        3.316624790f, /* ACN 27, sqrt(11) */
+        3.316624790f, /* ACN 28, sqrt(11) */
+        3.316624790f, /* ACN 29, sqrt(11) */
+        3.316624790f, /* ACN 30, sqrt(11) */
+        3.316624790f, /* ACN 31, sqrt(11) */
+        3.316624790f, /* ACN 32, sqrt(11) */
+        3.316624790f, /* ACN 33, sqrt(11) */
+        3.316624790f, /* ACN 34, sqrt(11) */
+        3.316624790f, /* ACN 35, sqrt(11) */
+        3.605551275f, /* ACN 36, sqrt(13) */
+        3.605551275f, /* ACN 37, sqrt(13) */
+        3.605551275f, /* ACN 38, sqrt(13) */
+        3.605551275f, /* ACN 39, sqrt(13) */
+        3.605551275f, /* ACN 40, sqrt(13) */
+        3.605551275f, /* ACN 41, sqrt(13) */
+        3.605551275f, /* ACN 42, sqrt(13) */
+        3.605551275f, /* ACN 43, sqrt(13) */
+        3.605551275f, /* ACN 44, sqrt(13) */
+        3.605551275f, /* ACN 45, sqrt(13) */
+        3.605551275f, /* ACN 46, sqrt(13) */
+        3.605551275f, /* ACN 47, sqrt(13) */
+        3.605551275f, /* ACN 48, sqrt(13) */
+        3.872983346f, /* ACN 49, sqrt(15) */
+        3.872983346f, /* ACN 50, sqrt(15) */
+        3.872983346f, /* ACN 51, sqrt(15) */
+        3.872983346f, /* ACN 52, sqrt(15) */
+        3.872983346f, /* ACN 53, sqrt(15) */
+        3.872983346f, /* ACN 54, sqrt(15) */
+        3.872983346f, /* ACN 55, sqrt(15) */
+        3.872983346f, /* ACN 56, sqrt(15) */
+        3.872983346f, /* ACN 57, sqrt(15) */
+        3.872983346f, /* ACN 58, sqrt(15) */
+        3.872983346f, /* ACN 59, sqrt(15) */
+        3.872983346f, /* ACN 60, sqrt(15) */
+        3.872983346f, /* ACN 61, sqrt(15) */
+        3.872983346f, /* ACN 62, sqrt(15) */
+        3.872983346f, /* ACN 63, sqrt(15) */
     }};
+    /* FuMa only goes up to third-order, so the rest is 0. */
     static constexpr std::array<float,MAX_AMBI_CHANNELS> FromFuMa{{
         1.414213562f, /* ACN  0 (W), sqrt(2) */
         1.732050808f, /* ACN  1 (Y), sqrt(3) */
@@ -84,6 +144,7 @@ struct AmbiScale {
 };
 
 struct AmbiIndex {
+    /* FuMa only goes up to third-order, so the rest is 0. */
     static constexpr std::array<int,MAX_AMBI_CHANNELS> FromFuMa{{
         0,  /* W */
         3,  /* X */
@@ -103,16 +164,28 @@ struct AmbiIndex {
         9,  /* Q */
     }};
     static constexpr std::array<int,MAX_AMBI_CHANNELS> FromACN{{
-        0,  1,  2,  3,  4,  5,  6,  7,
-        8,  9, 10, 11, 12, 13, 14, 15
+         0,  1,  2,  3,  4,  5,  6,  7,
+         8,  9, 10, 11, 12, 13, 14, 15,
+        16, 17, 18, 19, 20, 21, 22, 23,
+        24, 25, 26, 27, 28, 29, 30, 31,
+        32, 33, 34, 35, 36, 37, 38, 39,
+        40, 41, 42, 43, 44, 45, 46, 47,
+        48, 49, 50, 51, 52, 53, 54, 55,
+        56, 57, 58, 59, 60, 61, 62, 63
     }};
 
     static constexpr std::array<int,MAX_AMBI2D_CHANNELS> From2D{{
-        0, 1,3, 4,8, 9,15
+        0, 1,3, 4,8, 9,15, 16,24, 25,35, 36,48, 49,63
     }};
     static constexpr std::array<int,MAX_AMBI_CHANNELS> From3D{{
-        0,  1,  2,  3,  4,  5,  6,  7,
-        8,  9, 10, 11, 12, 13, 14, 15
+         0,  1,  2,  3,  4,  5,  6,  7,
+         8,  9, 10, 11, 12, 13, 14, 15,
+        16, 17, 18, 19, 20, 21, 22, 23,
+        24, 25, 26, 27, 28, 29, 30, 31,
+        32, 33, 34, 35, 36, 37, 38, 39,
+        40, 41, 42, 43, 44, 45, 46, 47,
+        48, 49, 50, 51, 52, 53, 54, 55,
+        56, 57, 58, 59, 60, 61, 62, 63
     }};
 };
 
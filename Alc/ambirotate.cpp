@@ -0,0 +1,260 @@
+/**
+ * OpenAL cross platform audio library
+ * Copyright (C) 2019 by authors.
+ * This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Library General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ *  License along with this library; if not, write to the
+ *  Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ * Or go to http://www.gnu.org/copyleft/lgpl.html
+ */
+
+#include "config.h"
+
+#include "ambirotate.h"
+
+#include <cmath>
+#include <algorithm>
+
+#include "alnumeric.h"
+#include "alu.h"
+
+
+namespace {
+
+/* Sets the rotation's blocks to identity. */
+template<size_t N>
+void SetIdentity(std::array<ALfloat,N> &rot, const ALsizei order) noexcept
+{
+    std::fill(rot.begin(), rot.end(), 0.0f);
+    size_t offset{0};
+    for(size_t l{0};l <= static_cast<size_t>(order);++l)
+    {
+        const size_t n{l*2 + 1};
+        for(size_t i{0};i < n;++i)
+            rot[offset + i*n + i] = 1.0f;
+        offset += n*n;
+    }
+}
+
+} // namespace
+
+constexpr size_t AmbiRotator::sNumCoeffs;
+
+bool AmbiRotator::init(const MixParams &mix, const ALsizei order) noexcept
+{
+    if(mix.PanMatrix || order < 1 || order > MAX_AMBI_ORDER)
+        return false;
+
+    const auto count = static_cast<ALsizei>(AmbiChannelsFromOrder(static_cast<size_t>(order)));
+    if(mix.NumChannels != count)
+        return false;
+
+    /* Every coefficient up to the order needs its own channel. */
+    mChannel.fill(-1);
+    for(ALsizei i{0};i < count;++i)
+    {
+        const BFChannelConfig &chan = mix.AmbiMap[static_cast<size_t>(i)];
+        if(chan.Index < 0 || chan.Index >= count || !(chan.Scale > 0.0f)
+            || mChannel[static_cast<size_t>(chan.Index)] != -1)
+            return false;
+        mChannel[static_cast<size_t>(chan.Index)] = i;
+        mScale[static_cast<size_t>(chan.Index)] = chan.Scale;
+    }
+    mOrder = order;
+
+    SetIdentity(mCurrent, mOrder);
+    SetIdentity(mTarget, mOrder);
+    return true;
+}
+
+void AmbiRotator::setListener(const alu::Matrix &mtx, const ALfloat zscale, const bool fade) noexcept
+{
+    /* The first-order block is the listener's rotation itself, in ambisonic
+     * coordinates with the components in ACN order (Y, Z, X). Each column is
+     * an axis of the world bus, as it appears to the listener.
+     */
+    ALfloat r1[3][3];
+    for(size_t j{0};j < 3;++j)
+    {
+        /* Ambisonic Y = OpenAL -X, Z = Y, X = -Z. */
+        const ALfloat in[3]{(j==0) ? -1.0f : 0.0f, (j==1) ? 1.0f : 0.0f,
+            (j==2) ? -zscale : 0.0f};
+        ALfloat out[3];
+        for(size_t c{0};c < 3;++c)
+            out[c] = in[0]*mtx[0][c] + in[1]*mtx[1][c] + in[2]*mtx[2][c];
+        r1[0][j] = -out[0];
+        r1[1][j] = out[1];
+        r1[2][j] = -out[2] * zscale;
+    }
+
+    mTarget[0] = 1.0f;
+    for(size_t i{0};i < 3;++i)
+    {
+        for(size_t j{0};j < 3;++j)
+            mTarget[1 + i*3 + j] = r1[i][j];
+    }
+
+    /* Higher orders are built up from the previous one with Ivanic and
+     * Ruedenberg's recurrence ("Rotation Matrices for Real Spherical
+     * Harmonics. Direct Determination by Recursion", 1996, with the 1998
+     * corrections).
+     */
+    static constexpr ALfloat Sqrt2{1.41421356237309504880f};
+    auto R1 = [&r1](const int i, const int j) noexcept -> ALfloat { return r1[i+1][j+1]; };
+    for(int l{2};l <= mOrder;++l)
+    {
+        const size_t prevoffset{AmbiRotationCoeffs(static_cast<size_t>(l-2))};
+        const size_t offset{AmbiRotationCoeffs(static_cast<size_t>(l-1))};
+        const int prevn{l*2 - 1};
+        const int n{l*2 + 1};
+        auto Rprev = [this,prevoffset,prevn,l](const int a, const int b) noexcept -> ALfloat
+        { return mTarget[prevoffset + static_cast<size_t>((a+l-1)*prevn + (b+l-1))]; };
+
+        auto P = [l,&R1,&Rprev](const int i, const int a, const int b) noexcept -> ALfloat
+        {
+            if(b == -l)
+                return R1(i, 1)*Rprev(a, -l+1) + R1(i, -1)*Rprev(a, l-1);
+            if(b == l)
+                return R1(i, 1)*Rprev(a, l-1) - R1(i, -1)*Rprev(a, -l+1);
+            return R1(i, 0)*Rprev(a, b);
+        };
+
+        for(int m{-l};m <= l;++m)
+        {
+            const int am{std::abs(m)};
+            for(int k{-l};k <= l;++k)
+            {
+                const ALfloat denom{(std::abs(k) == l) ? static_cast<ALfloat>(2*l * (2*l-1)) :
+                    static_cast<ALfloat>((l+k) * (l-k))};
+                const ALfloat u{std::sqrt(static_cast<ALfloat>((l+m) * (l-m)) / denom)};
+                const ALfloat v{(m == 0) ?
+                    -std::sqrt(static_cast<ALfloat>(2 * (l-1) * l) / denom) * 0.5f :
+                    std::sqrt(static_cast<ALfloat>((l+am-1) * (l+am)) / denom) * 0.5f};
+                const ALfloat w{(m == 0) ? 0.0f :
+                    -std::sqrt(static_cast<ALfloat>((l-am-1) * (l-am)) / denom) * 0.5f};
+
+                ALfloat val{0.0f};
+                if(u != 0.0f)
+                    val += u * P(0, m, k);
+                if(m == 0)
+                    val += v * (P(1, 1, k) + P(-1, -1, k));
+                else if(m > 0)
+                {
+                    const bool d{m == 1};
+                    val += v * (P(1, m-1, k)*(d ? Sqrt2 : 1.0f) -
+                        (d ? 0.0f : P(-1, -m+1, k)));
+                }
+                else
+                {
+                    const bool d{m == -1};
+                    val += v * ((d ? 0.0f : P(1, m+1, k)) +
+                        P(-1, -m-1, k)*(d ? Sqrt2 : 1.0f));
+                }
+                if(w != 0.0f)
+                {
+                    if(m > 0)
+                        val += w * (P(1, m+1, k) + P(-1, -m-1, k));
+                    else
+                        val += w * (P(1, m-1, k) - P(-1, -m+1, k));
+                }
+                mTarget[offset + static_cast<size_t>((m+l)*n + (k+l))] = val;
+            }
+        }
+    }
+
+    if(!fade)
+        mCurrent = mTarget;
+}
+
+void AmbiRotator::transform(const Rotation &rot, const bool inverse, ALfloat *gains) const noexcept
+{
+    size_t offset{0};
+    for(size_t l{0};l <= static_cast<size_t>(mOrder);++l)
+    {
+        const size_t base{l*l};
+        const size_t n{l*2 + 1};
+
+        ALfloat in[MAX_AMBI_ORDER*2 + 1];
+        for(size_t i{0};i < n;++i)
+            in[i] = gains[mChannel[base+i]] / mScale[base+i];
+        for(size_t i{0};i < n;++i)
+        {
+            ALfloat out{0.0f};
+            for(size_t j{0};j < n;++j)
+                out += (inverse ? rot[offset + j*n + i] : rot[offset + i*n + j]) * in[j];
+            gains[mChannel[base+i]] = out * mScale[base+i];
+        }
+        offset += n*n;
+    }
+}
+
+void AmbiRotator::process(ALfloat (*OutBuffer)[BUFFERSIZE], ChannelMask *OutTouched,
+    ALfloat (*InBuffer)[BUFFERSIZE], ChannelMask *InTouched, const ALsizei fadelen,
+    const ALsizei SamplesToDo)
+{
+    ASSUME(SamplesToDo > 0);
+
+    const ChannelMask intouched{*InTouched};
+    const bool fading{mCurrent != mTarget};
+    const ALsizei fadesize{(fadelen > 0) ? mini(fadelen, SamplesToDo) : SamplesToDo};
+    const ALfloat delta{1.0f / static_cast<ALfloat>(fadesize)};
+
+    size_t offset{0};
+    for(size_t l{0};l <= static_cast<size_t>(mOrder) && intouched;++l)
+    {
+        const size_t base{l*l};
+        const size_t n{l*2 + 1};
+        for(size_t i{0};i < n;++i)
+        {
+            const ALsizei outchan{mChannel[base+i]};
+            ALfloat *RESTRICT dst{OutBuffer[outchan]};
+            bool written{false};
+            for(size_t j{0};j < n;++j)
+            {
+                const ALsizei inchan{mChannel[base+j]};
+                if(!((intouched>>inchan)&1))
+                    continue;
+
+                const ALfloat scale{mScale[base+i] / mScale[base+j]};
+                const ALfloat gain{mTarget[offset + i*n + j] * scale};
+                const ALfloat *RESTRICT src{InBuffer[inchan]};
+                ALsizei pos{0};
+                if(fading)
+                {
+                    const ALfloat step{(gain - mCurrent[offset + i*n + j]*scale) * delta};
+                    if(std::fabs(step)*static_cast<ALfloat>(fadesize) > GAIN_SILENCE_THRESHOLD)
+                    {
+                        ALfloat g{gain - step*static_cast<ALfloat>(fadesize)};
+                        for(;pos < fadesize;++pos)
+                        {
+                            dst[pos] += src[pos] * g;
+                            g += step;
+                        }
+                        written = true;
+                    }
+                }
+                if(!(std::fabs(gain) > GAIN_SILENCE_THRESHOLD))
+                    continue;
+                for(;pos < SamplesToDo;++pos)
+                    dst[pos] += src[pos] * gain;
+                written = true;
+            }
+            if(written && OutTouched)
+                *OutTouched |= ChannelMask{1u} << outchan;
+        }
+        offset += n*n;
+    }
+
+    mCurrent = mTarget;
+    ClearTouchedChannels(InBuffer, InTouched, SamplesToDo);
+}
@@ -0,0 +1,79 @@
+#ifndef AMBIROTATE_H
+#define AMBIROTATE_H
+
+#include <array>
+
+#include "alMain.h"
+#include "almalloc.h"
+#include "ambidefs.h"
+#include "vecmat.h"
+
+
+/* The number of rotation coefficients for all orders up to the given one. */
+constexpr inline size_t AmbiRotationCoeffs(size_t order) noexcept
+{ return (order+1) * (order*2 + 1) * (order*2 + 3) / 3; }
+
+/* Rotates a full 3D ambisonic mix to the listener's orientation. Voices panned
+ * in world space are mixed to a separate bus with the same layout as the dry
+ * mix, which gets rotated into the dry mix once per update. Turning the
+ * listener then only changes the rotation, rather than every voice's panning.
+ *
+ * Ambisonic channels only mix with others of the same order when rotated, so
+ * the rotation is kept as one (2l+1)x(2l+1) block per order l, for N3D
+ * coefficients in ACN order. The mix's own channel order and scaling are
+ * applied around it.
+ */
+class AmbiRotator {
+    static constexpr size_t sNumCoeffs{AmbiRotationCoeffs(MAX_AMBI_ORDER)};
+
+    using Rotation = std::array<ALfloat,sNumCoeffs>;
+
+    ALsizei mOrder{0};
+    /* The mix's channel, and its scale, for each ACN index. */
+    std::array<ALsizei,MAX_AMBI_CHANNELS> mChannel{};
+    std::array<ALfloat,MAX_AMBI_CHANNELS> mScale{};
+
+    /* The rotation last applied to the bus, and the one it fades to with the
+     * next update.
+     */
+    Rotation mCurrent{};
+    Rotation mTarget{};
+
+    void transform(const Rotation &rot, const bool inverse, ALfloat *gains) const noexcept;
+
+public:
+    /* Sets up for rotating the given mix, returning false if it isn't a full
+     * 3D ambisonic mix of the given order.
+     */
+    bool init(const MixParams &mix, const ALsizei order) noexcept;
+
+    /* Sets the rotation to fade to for the listener's transform, with its Z
+     * axis scaled the same as voice directions. Without fading, it's also
+     * applied immediately.
+     */
+    void setListener(const alu::Matrix &mtx, const ALfloat zscale, const bool fade) noexcept;
+
+    /* Converts gains for the mix to gains for the world bus, for the target
+     * rotation.
+     */
+    void toWorld(ALfloat *gains) const noexcept { transform(mTarget, true, gains); }
+
+    /* Converts a voice's current gains between the mix and the world bus, for
+     * the rotation last applied, so a voice moving between them continues
+     * from where it left off.
+     */
+    void currentToWorld(ALfloat *gains) const noexcept { transform(mCurrent, true, gains); }
+    void currentFromWorld(ALfloat *gains) const noexcept { transform(mCurrent, false, gains); }
+
+    /* Adds the world bus's written channels into the mix, rotated and fading
+     * from the current to the target rotation over fadelen samples, then
+     * clears them.
+     */
+    void process(ALfloat (*OutBuffer)[BUFFERSIZE], ChannelMask *OutTouched,
+        ALfloat (*InBuffer)[BUFFERSIZE], ChannelMask *InTouched, const ALsizei fadelen,
+        const ALsizei SamplesToDo);
+
+    DEF_NEWDEL(AmbiRotator)
+};
+
+#endif /* AMBIROTATE_H */
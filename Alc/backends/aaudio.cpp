@@ -0,0 +1,447 @@
+/**
+ * OpenAL cross platform audio library
+ * Copyright (C) 1999-2007 by authors.
+ * This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Library General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ *  License along with this library; if not, write to the
+ *  Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ * Or go to http://www.gnu.org/copyleft/lgpl.html
+ */
+
+#include "config.h"
+
+#include "backends/aaudio.h"
+
+#include <time.h>
+
+#include <cstring>
+
+#include <string>
+#include <algorithm>
+
+#include "alMain.h"
+#include "alu.h"
+#include "alconfig.h"
+#include "compat.h"
+
+#include <aaudio/AAudio.h>
+
+
+namespace {
+
+constexpr ALCchar aaudioDevice[] = "AAudio Default";
+
+
+#ifdef HAVE_DYNLOAD
+#define AAUDIO_FUNCS(MAGIC)                                                   \
+    MAGIC(AAudio_convertResultToText);                                        \
+    MAGIC(AAudio_createStreamBuilder);                                        \
+    MAGIC(AAudioStreamBuilder_delete);                                        \
+    MAGIC(AAudioStreamBuilder_openStream);                                    \
+    MAGIC(AAudioStreamBuilder_setDirection);                                  \
+    MAGIC(AAudioStreamBuilder_setSharingMode);                                \
+    MAGIC(AAudioStreamBuilder_setPerformanceMode);                            \
+    MAGIC(AAudioStreamBuilder_setFormat);                                     \
+    MAGIC(AAudioStreamBuilder_setChannelCount);                               \
+    MAGIC(AAudioStreamBuilder_setSampleRate);                                 \
+    MAGIC(AAudioStreamBuilder_setDataCallback);                               \
+    MAGIC(AAudioStreamBuilder_setErrorCallback);                              \
+    MAGIC(AAudioStream_close);                                                \
+    MAGIC(AAudioStream_requestStart);                                         \
+    MAGIC(AAudioStream_requestStop);                                          \
+    MAGIC(AAudioStream_waitForStateChange);                                   \
+    MAGIC(AAudioStream_getFramesPerBurst);                                    \
+    MAGIC(AAudioStream_getBufferCapacityInFrames);                            \
+    MAGIC(AAudioStream_getBufferSizeInFrames);                                \
+    MAGIC(AAudioStream_setBufferSizeInFrames);                                \
+    MAGIC(AAudioStream_getSampleRate);                                        \
+    MAGIC(AAudioStream_getChannelCount);                                      \
+    MAGIC(AAudioStream_getFormat);                                            \
+    MAGIC(AAudioStream_getSharingMode);                                       \
+    MAGIC(AAudioStream_getPerformanceMode);                                   \
+    MAGIC(AAudioStream_getFramesWritten);                                     \
+    MAGIC(AAudioStream_getTimestamp);
+
+void *aaudio_handle;
+#define MAKE_FUNC(x) decltype(x) * p##x
+AAUDIO_FUNCS(MAKE_FUNC)
+#undef MAKE_FUNC
+
+#ifndef IN_IDE_PARSER
+#define AAudio_convertResultToText pAAudio_convertResultToText
+#define AAudio_createStreamBuilder pAAudio_createStreamBuilder
+#define AAudioStreamBuilder_delete pAAudioStreamBuilder_delete
+#define AAudioStreamBuilder_openStream pAAudioStreamBuilder_openStream
+#define AAudioStreamBuilder_setDirection pAAudioStreamBuilder_setDirection
+#define AAudioStreamBuilder_setSharingMode pAAudioStreamBuilder_setSharingMode
+#define AAudioStreamBuilder_setPerformanceMode pAAudioStreamBuilder_setPerformanceMode
+#define AAudioStreamBuilder_setFormat pAAudioStreamBuilder_setFormat
+#define AAudioStreamBuilder_setChannelCount pAAudioStreamBuilder_setChannelCount
+#define AAudioStreamBuilder_setSampleRate pAAudioStreamBuilder_setSampleRate
+#define AAudioStreamBuilder_setDataCallback pAAudioStreamBuilder_setDataCallback
+#define AAudioStreamBuilder_setErrorCallback pAAudioStreamBuilder_setErrorCallback
+#define AAudioStream_close pAAudioStream_close
+#define AAudioStream_requestStart pAAudioStream_requestStart
+#define AAudioStream_requestStop pAAudioStream_requestStop
+#define AAudioStream_waitForStateChange pAAudioStream_waitForStateChange
+#define AAudioStream_getFramesPerBurst pAAudioStream_getFramesPerBurst
+#define AAudioStream_getBufferCapacityInFrames pAAudioStream_getBufferCapacityInFrames
+#define AAudioStream_getBufferSizeInFrames pAAudioStream_getBufferSizeInFrames
+#define AAudioStream_setBufferSizeInFrames pAAudioStream_setBufferSizeInFrames
+#define AAudioStream_getSampleRate pAAudioStream_getSampleRate
+#define AAudioStream_getChannelCount pAAudioStream_getChannelCount
+#define AAudioStream_getFormat pAAudioStream_getFormat
+#define AAudioStream_getSharingMode pAAudioStream_getSharingMode
+#define AAudioStream_getPerformanceMode pAAudioStream_getPerformanceMode
+#define AAudioStream_getFramesWritten pAAudioStream_getFramesWritten
+#define AAudioStream_getTimestamp pAAudioStream_getTimestamp
+#endif /* IN_IDE_PARSER */
+
+#endif
+
+
+bool aaudio_load()
+{
+#ifdef HAVE_DYNLOAD
+    if(!aaudio_handle)
+    {
+        bool ret{true};
+        std::string missing_funcs;
+
+#define AAUDIO_LIB "libaaudio.so"
+        aaudio_handle = LoadLib(AAUDIO_LIB);
+        if(!aaudio_handle)
+        {
+            WARN("Failed to load %s\n", AAUDIO_LIB);
+            return false;
+        }
+
+#define LOAD_FUNC(x) do {                                                     \
+    p##x = reinterpret_cast<decltype(p##x)>(GetSymbol(aaudio_handle, #x));    \
+    if(!(p##x)) {                                                             \
+        ret = false;                                                          \
+        missing_funcs += "\n" #x;                                             \
+    }                                                                         \
+} while(0)
+        AAUDIO_FUNCS(LOAD_FUNC)
+#undef LOAD_FUNC
+
+        if(!ret)
+        {
+            WARN("Missing expected functions:%s\n", missing_funcs.c_str());
+            CloseLib(aaudio_handle);
+            aaudio_handle = nullptr;
+            return false;
+        }
+    }
+#endif /* HAVE_DYNLOAD */
+
+    return true;
+}
+
+
+struct AAudioPlayback final : public BackendBase {
+    AAudioPlayback(ALCdevice *device) noexcept : BackendBase{device} { }
+    ~AAudioPlayback() override;
+
+    static aaudio_data_callback_result_t dataCallbackC(AAudioStream *stream, void *userdata,
+        void *audioData, int32_t numFrames);
+    aaudio_data_callback_result_t dataCallback(void *audioData, int32_t numFrames);
+
+    static void errorCallbackC(AAudioStream *stream, void *userdata, aaudio_result_t error);
+    void errorCallback(aaudio_result_t error);
+
+    aaudio_result_t openStream(aaudio_sharing_mode_t sharing);
+    void closeStream();
+
+    ALCenum open(const ALCchar *name) override;
+    ALCboolean reset() override;
+    ALCboolean start() override;
+    void stop() override;
+    ClockLatency getClockLatency() override;
+
+    AAudioStream *mStream{nullptr};
+
+    static constexpr inline const char *CurrentPrefix() noexcept { return "AAudioPlayback::"; }
+    DEF_NEWDEL(AAudioPlayback)
+};
+
+AAudioPlayback::~AAudioPlayback()
+{ closeStream(); }
+
+
+aaudio_data_callback_result_t AAudioPlayback::dataCallbackC(AAudioStream*, void *userdata,
+    void *audioData, int32_t numFrames)
+{ return static_cast<AAudioPlayback*>(userdata)->dataCallback(audioData, numFrames); }
+
+aaudio_data_callback_result_t AAudioPlayback::dataCallback(void *audioData, int32_t numFrames)
+{
+    /* Mix directly into the stream's buffer, which is the device's own when
+     * the MMAP path is in use.
+     */
+    recordWakeup(static_cast<ALuint>(numFrames));
+    lock();
+    aluMixData(mDevice, audioData, numFrames);
+    unlock();
+    return AAUDIO_CALLBACK_RESULT_CONTINUE;
+}
+
+void AAudioPlayback::errorCallbackC(AAudioStream*, void *userdata, aaudio_result_t error)
+{ static_cast<AAudioPlayback*>(userdata)->errorCallback(error); }
+
+void AAudioPlayback::errorCallback(aaudio_result_t error)
+{
+    /* The stream can't be stopped or closed from this callback, so just flag
+     * the device as disconnected.
+     */
+    ERR("Stream error: %s\n", AAudio_convertResultToText(error));
+    aluHandleDisconnect(mDevice, "AAudio stream error: %s", AAudio_convertResultToText(error));
+}
+
+
+aaudio_result_t AAudioPlayback::openStream(aaudio_sharing_mode_t sharing)
+{
+    AAudioStreamBuilder *builder{};
+    aaudio_result_t res{AAudio_createStreamBuilder(&builder)};
+    if(res != AAUDIO_OK)
+        return res;
+
+    AAudioStreamBuilder_setDirection(builder, AAUDIO_DIRECTION_OUTPUT);
+    AAudioStreamBuilder_setSharingMode(builder, sharing);
+    AAudioStreamBuilder_setPerformanceMode(builder, AAUDIO_PERFORMANCE_MODE_LOW_LATENCY);
+    AAudioStreamBuilder_setFormat(builder, (mDevice->FmtType == DevFmtShort) ?
+        AAUDIO_FORMAT_PCM_I16 : AAUDIO_FORMAT_PCM_FLOAT);
+    AAudioStreamBuilder_setChannelCount(builder, mDevice->channelsFromFmt());
+    AAudioStreamBuilder_setSampleRate(builder, static_cast<int32_t>(mDevice->Frequency));
+    AAudioStreamBuilder_setDataCallback(builder, &AAudioPlayback::dataCallbackC, this);
+    AAudioStreamBuilder_setErrorCallback(builder, &AAudioPlayback::errorCallbackC, this);
+
+    res = AAudioStreamBuilder_openStream(builder, &mStream);
+    AAudioStreamBuilder_delete(builder);
+    if(res != AAUDIO_OK)
+        mStream = nullptr;
+    return res;
+}
+
+void AAudioPlayback::closeStream()
+{
+    if(mStream)
+        AAudioStream_close(mStream);
+    mStream = nullptr;
+}
+
+
+ALCenum AAudioPlayback::open(const ALCchar *name)
+{
+    if(!name)
+        name = aaudioDevice;
+    else if(strcmp(name, aaudioDevice) != 0)
+        return ALC_INVALID_VALUE;
+
+    mDevice->DeviceName = name;
+    return ALC_NO_ERROR;
+}
+
+ALCboolean AAudioPlayback::reset()
+{
+    closeStream();
+
+    /* AAudio only handles 16-bit and float samples, and doesn't have a
+     * defined channel order for more than stereo.
+     */
+    switch(mDevice->FmtType)
+    {
+        case DevFmtByte:
+        case DevFmtUByte:
+        case DevFmtUShort:
+            mDevice->FmtType = DevFmtShort;
+            break;
+        case DevFmtInt:
+        case DevFmtUInt:
+            mDevice->FmtType = DevFmtFloat;
+            break;
+        case DevFmtShort:
+        case DevFmtFloat:
+            break;
+    }
+    if(mDevice->FmtChans != DevFmtMono)
+        mDevice->FmtChans = DevFmtStereo;
+
+    /* Exclusive sharing gets the MMAP path when the device supports it,
+     * mixing straight into the hardware buffer. Fall back to shared mode if
+     * it's unavailable.
+     */
+    aaudio_result_t res{AAUDIO_ERROR_UNAVAILABLE};
+    if(GetConfigValueBool(mDevice->DeviceName.c_str(), "aaudio", "exclusive", 1))
+    {
+        res = openStream(AAUDIO_SHARING_MODE_EXCLUSIVE);
+        if(res != AAUDIO_OK)
+            WARN("Failed to open exclusive stream: %s\n", AAudio_convertResultToText(res));
+    }
+    if(res != AAUDIO_OK)
+        res = openStream(AAUDIO_SHARING_MODE_SHARED);
+    if(res != AAUDIO_OK)
+    {
+        ERR("Failed to open stream: %s\n", AAudio_convertResultToText(res));
+        return ALC_FALSE;
+    }
+
+    mDevice->Frequency = static_cast<ALuint>(AAudioStream_getSampleRate(mStream));
+    if(AAudioStream_getChannelCount(mStream) == 1)
+        mDevice->FmtChans = DevFmtMono;
+    else if(AAudioStream_getChannelCount(mStream) == 2)
+        mDevice->FmtChans = DevFmtStereo;
+    else
+    {
+        ERR("Unhandled channel count: %d\n", AAudioStream_getChannelCount(mStream));
+        closeStream();
+        return ALC_FALSE;
+    }
+    if(AAudioStream_getFormat(mStream) == AAUDIO_FORMAT_PCM_I16)
+        mDevice->FmtType = DevFmtShort;
+    else if(AAudioStream_getFormat(mStream) == AAUDIO_FORMAT_PCM_FLOAT)
+        mDevice->FmtType = DevFmtFloat;
+    else
+    {
+        ERR("Unhandled sample format: %d\n", AAudioStream_getFormat(mStream));
+        closeStream();
+        return ALC_FALSE;
+    }
+
+    /* Match the update size to the device's burst size, and keep the buffer
+     * at two bursts, the least that avoids underruns under normal load.
+     */
+    const int32_t burst{AAudioStream_getFramesPerBurst(mStream)};
+    if(burst > 0)
+    {
+        const int32_t capacity{AAudioStream_getBufferCapacityInFrames(mStream)};
+        const int32_t bufsize{std::min(burst*2, std::max(capacity, burst))};
+        AAudioStream_setBufferSizeInFrames(mStream, bufsize);
+        mDevice->UpdateSize = static_cast<ALuint>(burst);
+    }
+    const int32_t bufsize{AAudioStream_getBufferSizeInFrames(mStream)};
+    mDevice->BufferSize = static_cast<ALuint>(std::max(bufsize, burst));
+    mDevice->BufferSize = maxu(mDevice->BufferSize, mDevice->UpdateSize);
+
+    TRACE("Opened %s stream, %s performance, %u burst, %u buffer\n",
+        (AAudioStream_getSharingMode(mStream) == AAUDIO_SHARING_MODE_EXCLUSIVE) ?
+            "exclusive" : "shared",
+        (AAudioStream_getPerformanceMode(mStream) == AAUDIO_PERFORMANCE_MODE_LOW_LATENCY) ?
+            "low-latency" : "normal",
+        mDevice->UpdateSize, mDevice->BufferSize);
+
+    SetDefaultWFXChannelOrder(mDevice);
+
+    return ALC_TRUE;
+}
+
+ALCboolean AAudioPlayback::start()
+{
+    aaudio_result_t res{AAudioStream_requestStart(mStream)};
+    if(res != AAUDIO_OK)
+    {
+        ERR("Failed to start stream: %s\n", AAudio_convertResultToText(res));
+        return ALC_FALSE;
+    }
+    return ALC_TRUE;
+}
+
+void AAudioPlayback::stop()
+{
+    aaudio_result_t res{AAudioStream_requestStop(mStream)};
+    if(res != AAUDIO_OK)
+    {
+        ERR("Failed to stop stream: %s\n", AAudio_convertResultToText(res));
+        return;
+    }
+
+    /* Stopping is asynchronous. Wait for it to finish so the data callback
+     * won't be called again.
+     */
+    aaudio_stream_state_t state{AAUDIO_STREAM_STATE_STOPPING};
+    while(state == AAUDIO_STREAM_STATE_STOPPING)
+    {
+        res = AAudioStream_waitForStateChange(mStream, state, &state, 1000000000);
+        if(res != AAUDIO_OK)
+        {
+            ERR("Failed waiting for stream to stop: %s\n", AAudio_convertResultToText(res));
+            break;
+        }
+    }
+}
+
+ClockLatency AAudioPlayback::getClockLatency()
+{
+    ClockLatency ret;
+
+    lock();
+    ret.ClockTime = GetDeviceClockTime(mDevice);
+
+    /* The timestamp gives the frame being presented at a given time. The
+     * latency is how far the written position is ahead of that, less the time
+     * passed since.
+     */
+    int64_t framepos{}, frametime{};
+    ret.Latency = std::chrono::nanoseconds::zero();
+    if(AAudioStream_getTimestamp(mStream, CLOCK_MONOTONIC, &framepos, &frametime) == AAUDIO_OK)
+    {
+        timespec now{};
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        const int64_t nowtime{now.tv_sec*1000000000_i64 + now.tv_nsec};
+
+        const int64_t delay{AAudioStream_getFramesWritten(mStream) - framepos};
+        ret.Latency = std::chrono::seconds{delay};
+        ret.Latency /= mDevice->Frequency;
+        ret.Latency -= std::chrono::nanoseconds{nowtime - frametime};
+        ret.Latency = std::max(ret.Latency, std::chrono::nanoseconds::zero());
+    }
+    unlock();
+
+    return ret;
+}
+
+} // namespace
+
+
+bool AAudioBackendFactory::init()
+{ return aaudio_load(); }
+
+bool AAudioBackendFactory::querySupport(BackendType type)
+{ return (type == BackendType::Playback); }
+
+void AAudioBackendFactory::probe(DevProbe type, std::string *outnames)
+{
+    switch(type)
+    {
+        case DevProbe::Playback:
+            /* Includes null char. */
+            outnames->append(aaudioDevice, sizeof(aaudioDevice));
+            break;
+
+        case DevProbe::Capture:
+            break;
+    }
+}
+
+BackendPtr AAudioBackendFactory::createBackend(ALCdevice *device, BackendType type)
+{
+    if(type == BackendType::Playback)
+        return BackendPtr{new AAudioPlayback{device}};
+    return nullptr;
+}
+
+BackendFactory &AAudioBackendFactory::getFactory()
+{
+    static AAudioBackendFactory factory{};
+    return factory;
+}
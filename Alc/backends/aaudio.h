@@ -0,0 +1,19 @@
+#ifndef BACKENDS_AAUDIO_H
+#define BACKENDS_AAUDIO_H
+
+#include "backends/base.h"
+
+struct AAudioBackendFactory final : public BackendFactory {
+public:
+    bool init() override;
+
+    bool querySupport(BackendType type) override;
+
+    void probe(DevProbe type, std::string *outnames) override;
+
+    BackendPtr createBackend(ALCdevice *device, BackendType type) override;
+
+    static BackendFactory &getFactory();
+};
+
+#endif /* BACKENDS_AAUDIO_H */
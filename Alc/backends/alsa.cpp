@@ -27,6 +27,7 @@
 #include <memory.h>
 
 #include <atomic>
+#include <chrono>
 #include <thread>
 #include <vector>
 #include <string>
@@ -38,6 +39,7 @@
 #include "alconfig.h"
 #include "ringbuffer.h"
 #include "compat.h"
+#include "altrace.h"
 
 #include <alsa/asoundlib.h>
 
@@ -388,6 +390,7 @@ struct AlsaPlayback final : public BackendBase {
     ~AlsaPlayback() override;
 
     int mixerProc();
+    int mixerTSchedProc();
     int mixerNoMMapProc();
 
     ALCenum open(const ALCchar *name) override;
@@ -401,6 +404,11 @@ struct AlsaPlayback final : public BackendBase {
 
     al::vector<char> mBuffer;
 
+    /* Set to use timer-based scheduling with mmap access, with UpdateSize
+     * being the mixing quantum instead of the hardware period.
+     */
+    bool mTSched{false};
+
     std::atomic<bool> mKillNow{true};
     std::thread mThread;
 
@@ -432,6 +440,8 @@ int AlsaPlayback::mixerProc()
             aluHandleDisconnect(mDevice, "Bad state: %s", snd_strerror(state));
             break;
         }
+        if(state == SND_PCM_STATE_XRUN)
+            recordUnderrun();
 
         snd_pcm_sframes_t avail{snd_pcm_avail_update(mPcmHandle)};
         if(avail < 0)
@@ -459,12 +469,13 @@ int AlsaPlayback::mixerProc()
                     continue;
                 }
             }
-            if(snd_pcm_wait(mPcmHandle, 1000) == 0)
+            if(AL_TRACE_EXPR("snd_pcm_wait", snd_pcm_wait(mPcmHandle, 1000)) == 0)
                 ERR("Wait timeout... buffer size too low?\n");
             continue;
         }
         avail -= avail%update_size;
 
+        recordWakeup(static_cast<ALuint>(avail));
         // it is possible that contiguous areas are smaller, thus we use a loop
         lock();
         while(avail > 0)
@@ -499,6 +510,131 @@ int AlsaPlayback::mixerProc()
     return 0;
 }
 
+/* Mixes with timer-based scheduling. Instead of waiting on the hardware's
+ * period interrupts and mixing whatever is available, the fill level is read
+ * from the hardware pointer and the thread sleeps until it drops to a
+ * watermark, then mixes just enough whole quanta to get back above it. The
+ * watermark grows when an underrun occurs, and slowly shrinks again while
+ * playback is underrun-free, keeping the latency as low as the system
+ * allows.
+ */
+int AlsaPlayback::mixerTSchedProc()
+{
+    SetRTPriority();
+    althrd_setname(MIXER_THREAD_NAME);
+
+    const snd_pcm_uframes_t update_size{mDevice->UpdateSize};
+    const snd_pcm_uframes_t buffer_size{mDevice->BufferSize};
+    const ALuint frequency{mDevice->Frequency};
+    const snd_pcm_uframes_t max_watermark{buffer_size - update_size};
+    snd_pcm_uframes_t watermark{std::min(update_size*2, max_watermark)};
+    /* Samples mixed since the last underrun or watermark decrease. */
+    snd_pcm_uframes_t clean_frames{0};
+    while(!mKillNow.load(std::memory_order_acquire))
+    {
+        if(snd_pcm_state(mPcmHandle) == SND_PCM_STATE_XRUN)
+        {
+            watermark = std::min(watermark*2, max_watermark);
+            clean_frames = 0;
+            WARN("Underrun, increasing watermark to %lu samples\n", watermark);
+        }
+
+        int state{verify_state(mPcmHandle)};
+        if(state < 0)
+        {
+            ERR("Invalid state detected: %s\n", snd_strerror(state));
+            aluHandleDisconnect(mDevice, "Bad state: %s", snd_strerror(state));
+            break;
+        }
+        if(state == SND_PCM_STATE_XRUN)
+            recordUnderrun();
+
+        snd_pcm_sframes_t avail{snd_pcm_avail_update(mPcmHandle)};
+        if(avail < 0)
+        {
+            ERR("available update failed: %s\n", snd_strerror(avail));
+            continue;
+        }
+
+        if(static_cast<snd_pcm_uframes_t>(avail) > buffer_size)
+        {
+            WARN("available samples exceeds the buffer size\n");
+            snd_pcm_reset(mPcmHandle);
+            continue;
+        }
+
+        const snd_pcm_uframes_t filled{buffer_size - static_cast<snd_pcm_uframes_t>(avail)};
+        if(filled > watermark)
+        {
+            if(state != SND_PCM_STATE_RUNNING)
+            {
+                int err{snd_pcm_start(mPcmHandle)};
+                if(err < 0)
+                {
+                    ERR("start failed: %s\n", snd_strerror(err));
+                    continue;
+                }
+            }
+
+            /* Sleep until the hardware has played down to the watermark. */
+            std::this_thread::sleep_for(std::chrono::microseconds{
+                static_cast<int64_t>((filled-watermark) * 1000000_u64 / frequency)});
+            continue;
+        }
+
+        /* Mix the whole quanta needed to get back above the watermark. */
+        snd_pcm_uframes_t todo{(watermark - filled)/update_size*update_size + update_size};
+        todo = std::min(todo, avail - avail%update_size);
+
+        recordWakeup(static_cast<ALuint>(todo));
+        lock();
+        for(snd_pcm_uframes_t remaining{todo};remaining > 0;)
+        {
+            snd_pcm_uframes_t frames{remaining};
+
+            const snd_pcm_channel_area_t *areas{};
+            snd_pcm_uframes_t offset{};
+            int err{snd_pcm_mmap_begin(mPcmHandle, &areas, &offset, &frames)};
+            if(err < 0)
+            {
+                ERR("mmap begin error: %s\n", snd_strerror(err));
+                break;
+            }
+
+            char *WritePtr{static_cast<char*>(areas->addr) + (offset * areas->step / 8)};
+            aluMixData(mDevice, WritePtr, frames);
+
+            snd_pcm_sframes_t commitres{snd_pcm_mmap_commit(mPcmHandle, offset, frames)};
+            if(commitres < 0 || (commitres-frames) != 0)
+            {
+                ERR("mmap commit error: %s\n",
+                    snd_strerror(commitres >= 0 ? -EPIPE : commitres));
+                break;
+            }
+
+            remaining -= frames;
+        }
+        unlock();
+
+        /* After a couple seconds without an underrun, lower the watermark by
+         * half a quantum.
+         */
+        clean_frames += todo;
+        if(clean_frames >= frequency*2_u64)
+        {
+            clean_frames = 0;
+            if(watermark > update_size)
+            {
+                watermark = std::max(watermark - update_size/2, update_size);
+                TRACE("Decreasing watermark to %lu samples\n", watermark);
+            }
+        }
+    }
+
+    return 0;
+}
+
+
 int AlsaPlayback::mixerNoMMapProc()
 {
     SetRTPriority();
@@ -515,6 +651,8 @@ int AlsaPlayback::mixerNoMMapProc()
             aluHandleDisconnect(mDevice, "Bad state: %s", snd_strerror(state));
             break;
         }
+        if(state == SND_PCM_STATE_XRUN)
+            recordUnderrun();
 
         snd_pcm_sframes_t avail{snd_pcm_avail_update(mPcmHandle)};
         if(avail < 0)
@@ -541,7 +679,7 @@ int AlsaPlayback::mixerNoMMapProc()
                     continue;
                 }
             }
-            if(snd_pcm_wait(mPcmHandle, 1000) == 0)
+            if(AL_TRACE_EXPR("snd_pcm_wait", snd_pcm_wait(mPcmHandle, 1000)) == 0)
                 ERR("Wait timeout... buffer size too low?\n");
             continue;
         }
@@ -549,6 +687,7 @@ int AlsaPlayback::mixerNoMMapProc()
         lock();
         char *WritePtr{mBuffer.data()};
         avail = snd_pcm_bytes_to_frames(mPcmHandle, mBuffer.size());
+        recordWakeup(static_cast<ALuint>(avail));
         aluMixData(mDevice, WritePtr, avail);
         while(avail > 0)
         {
@@ -562,6 +701,8 @@ int AlsaPlayback::mixerNoMMapProc()
 #endif
             case -EPIPE:
             case -EINTR:
+                if(ret == -EPIPE)
+                    recordUnderrun();
                 ret = snd_pcm_recover(mPcmHandle, ret, 1);
                 if(ret < 0)
                     avail = 0;
@@ -654,9 +795,19 @@ ALCboolean AlsaPlayback::reset()
     }
 
     bool allowmmap{!!GetConfigValueBool(mDevice->DeviceName.c_str(), "alsa", "mmap", 1)};
+    bool tsched{allowmmap &&
+        GetConfigValueBool(mDevice->DeviceName.c_str(), "alsa", "tsched", 0)};
     ALuint periodLen{static_cast<ALuint>(mDevice->UpdateSize * 1000000_u64 / mDevice->Frequency)};
     ALuint bufferLen{static_cast<ALuint>(mDevice->BufferSize * 1000000_u64 / mDevice->Frequency)};
     ALuint rate{mDevice->Frequency};
+    /* With timer-based scheduling, the update size is the mixing quantum
+     * regardless of the hardware period, and the latency is set by how full
+     * the buffer is kept. Ask for a larger hardware buffer so there's room to
+     * back off after underruns.
+     */
+    const ALuint quantumLen{periodLen};
+    if(tsched)
+        bufferLen = maxu(bufferLen, 100000u);
 
     snd_pcm_uframes_t periodSizeInFrames{};
     snd_pcm_uframes_t bufferSizeInFrames{};
@@ -763,6 +914,15 @@ ALCboolean AlsaPlayback::reset()
     mDevice->UpdateSize = periodSizeInFrames;
     mDevice->Frequency = rate;
 
+    mTSched = tsched && access == SND_PCM_ACCESS_MMAP_INTERLEAVED;
+    if(mTSched)
+    {
+        mDevice->UpdateSize = static_cast<ALuint>(quantumLen * uint64_t{rate} / 1000000u);
+        mDevice->UpdateSize = clampu(mDevice->UpdateSize, 64u, mDevice->BufferSize/2);
+        TRACE("Timer-based scheduling, %u sample quantum, %u sample buffer\n",
+            mDevice->UpdateSize, mDevice->BufferSize);
+    }
+
     SetDefaultChannelOrder(mDevice);
 
     return ALC_TRUE;
@@ -811,7 +971,7 @@ ALCboolean AlsaPlayback::start()
             ERR("snd_pcm_prepare(data->mPcmHandle) failed: %s\n", snd_strerror(err));
             return ALC_FALSE;
         }
-        thread_func = &AlsaPlayback::mixerProc;
+        thread_func = mTSched ? &AlsaPlayback::mixerTSchedProc : &AlsaPlayback::mixerProc;
     }
 
     try {
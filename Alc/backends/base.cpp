@@ -7,6 +7,8 @@
 
 #include "alMain.h"
 #include "alu.h"
+#include "converter.h"
+#include "ringbuffer.h"
 
 #include "backends/base.h"
 
@@ -20,12 +22,49 @@ ClockLatency GetClockLatency(ALCdevice *device)
 }
 
 
+void BackendTelemetry::addWakeup(const std::chrono::nanoseconds length) noexcept
+{
+    Wakeups.store(Wakeups.load(std::memory_order_relaxed)+1, std::memory_order_relaxed);
+
+    const auto now = std::chrono::steady_clock::now();
+    const auto last = LastWake;
+    const auto period = LastLength;
+    LastWake = now;
+    LastLength = length;
+    if(last == std::chrono::steady_clock::time_point{})
+        return;
+
+    const auto gap = std::chrono::duration_cast<std::chrono::nanoseconds>(now - last);
+    if(static_cast<uint64_t>(gap.count()) > MaxWakeGap.load(std::memory_order_relaxed))
+        MaxWakeGap.store(static_cast<uint64_t>(gap.count()), std::memory_order_relaxed);
+
+    const auto jitter = (gap > period) ? gap - period : period - gap;
+    auto limit = std::chrono::nanoseconds{std::chrono::microseconds{250}};
+    size_t bucket{0};
+    while(bucket < JitterBuckets-1 && jitter >= limit)
+    {
+        limit *= 2;
+        ++bucket;
+    }
+    Jitter[bucket].store(Jitter[bucket].load(std::memory_order_relaxed)+1,
+        std::memory_order_relaxed);
+}
+
+
 /* BackendBase method implementations. */
 BackendBase::BackendBase(ALCdevice *device) noexcept : mDevice{device}
 { }
 
 BackendBase::~BackendBase() = default;
 
+void BackendBase::recordWakeup(ALuint frames) noexcept
+{
+    using std::chrono::seconds;
+    using std::chrono::nanoseconds;
+
+    mTelemetry.addWakeup(nanoseconds{seconds{frames}} / mDevice->Frequency);
+}
+
 ALCboolean BackendBase::reset()
 { return ALC_FALSE; }
 
@@ -35,6 +74,38 @@ ALCenum BackendBase::captureSamples(void* UNUSED(buffer), ALCuint UNUSED(samples
 ALCuint BackendBase::availableSamples()
 { return 0; }
 
+void BackendBase::dispatchCapture(RingBuffer *ring, const ChannelConverter *chanconv,
+    SampleConverter *sampleconv)
+{
+    const ALCCAPTUREPROCSOFT callback{mDevice->CaptureCallback};
+    if(!callback) return;
+    void *userptr{mDevice->CaptureUserPtr};
+
+    if(!chanconv && !sampleconv)
+    {
+        /* The ring already holds the device format, so hand over its
+         * segments as-is.
+         */
+        auto vec = ring->getReadVector();
+        if(vec.first.len > 0)
+            callback(userptr, vec.first.buf, static_cast<ALCsizei>(vec.first.len));
+        if(vec.second.len > 0)
+            callback(userptr, vec.second.buf, static_cast<ALCsizei>(vec.second.len));
+        ring->readAdvance(vec.first.len + vec.second.len);
+        return;
+    }
+
+    alignas(16) ALfloat buffer[BUFFERSIZE*4];
+    const ALsizei frame_size{mDevice->frameSizeFromFmt()};
+    const auto maxframes = static_cast<ALsizei>(sizeof(buffer) / frame_size);
+    ALsizei got;
+    while((got=ConvertCaptureRing(ring, chanconv, sampleconv, buffer, maxframes)) > 0)
+    {
+        callback(userptr, buffer, got);
+        if(got < maxframes) break;
+    }
+}
+
 ClockLatency BackendBase::getClockLatency()
 {
     ClockLatency ret;
@@ -1,6 +1,7 @@
 #ifndef ALC_BACKENDS_BASE_H
 #define ALC_BACKENDS_BASE_H
 
+#include <atomic>
 #include <memory>
 #include <chrono>
 #include <string>
@@ -22,12 +23,53 @@ inline std::chrono::nanoseconds GetDeviceClockTime(ALCdevice *device)
     using std::chrono::seconds;
     using std::chrono::nanoseconds;
 
-    auto ns = nanoseconds{seconds{device->SamplesDone}} / device->Frequency;
+    auto ns = nanoseconds{seconds{device->SamplesDone}} / device->MixFrequency;
     return device->ClockBase + ns;
 }
 
 ClockLatency GetClockLatency(ALCdevice *device);
 
+/* Timing of a playback backend's mixer thread, and the underruns it had, for
+ * ALC_SOFT_backend_telemetry. Only the mixer thread updates it, while the app
+ * may read it at any time.
+ */
+struct BackendTelemetry {
+    /* Number of buckets in the jitter histogram. Each bucket counts wakeups
+     * whose gap since the last was off from the length of audio mixed on the
+     * last by less than twice the previous bucket's limit, starting with
+     * 250us for the first. The last bucket counts any beyond that.
+     */
+    static constexpr size_t JitterBuckets{8};
+
+    std::atomic<uint64_t> Underruns{0u};
+    std::atomic<uint64_t> Wakeups{0u};
+    /* The longest gap between wakeups, in nanoseconds. */
+    std::atomic<uint64_t> MaxWakeGap{0u};
+    std::atomic<uint64_t> Jitter[JitterBuckets]{};
+
+    /* When the mixer thread last woke, or a default time point if it hasn't
+     * since being started, and the length of audio it mixed then. Only used
+     * by the mixer thread.
+     */
+    std::chrono::steady_clock::time_point LastWake;
+    std::chrono::nanoseconds LastLength{};
+
+    void addUnderrun() noexcept
+    { Underruns.store(Underruns.load(std::memory_order_relaxed)+1, std::memory_order_relaxed); }
+
+    void addWakeup(const std::chrono::nanoseconds length) noexcept;
+
+    /* Forgets the last wakeup, so the gap across a stop isn't counted. Must
+     * only be called while the mixer thread isn't running.
+     */
+    void restart() noexcept { LastWake = std::chrono::steady_clock::time_point{}; }
+};
+
+struct RingBuffer;
+struct ChannelConverter;
+struct SampleConverter;
+struct ThreadGroup;
+
 struct BackendBase {
     virtual ALCenum open(const ALCchar *name) = 0;
 
@@ -40,13 +82,40 @@ struct BackendBase {
 
     virtual ClockLatency getClockLatency();
 
+    /* Returns the OS thread group the backend's audio thread runs in, for the
+     * mixer's worker threads to join, or nullptr if there isn't one. It must
+     * stay valid for the life of the backend.
+     */
+    virtual ThreadGroup *getThreadGroup() { return nullptr; }
+
+    /* Backends that capture on their own thread return true, and call
+     * dispatchCapture after each period is written to the ring.
+     */
+    virtual bool supportsCaptureCallback() { return false; }
+
     virtual void lock() { mMutex.lock(); }
     virtual void unlock() { mMutex.unlock(); }
 
+    /* Hands everything in the capture ring to the app's capture callback, if
+     * one is set, converting it to the device format as needed. Must only be
+     * called from the thread that writes the ring.
+     */
+    void dispatchCapture(RingBuffer *ring, const ChannelConverter *chanconv=nullptr,
+        SampleConverter *sampleconv=nullptr);
+
+    /* Playback backends call these from their mixer thread or callback: the
+     * first each time it wakes to mix, with the number of sample frames it's
+     * about to mix, and the second when the device reports an underrun.
+     */
+    void recordWakeup(ALuint frames) noexcept;
+    void recordUnderrun() noexcept { mTelemetry.addUnderrun(); }
+
     ALCdevice *mDevice;
 
     std::recursive_mutex mMutex;
 
+    BackendTelemetry mTelemetry;
+
     BackendBase(ALCdevice *device) noexcept;
     virtual ~BackendBase();
 };
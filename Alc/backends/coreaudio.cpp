@@ -30,11 +30,15 @@
 #include "alu.h"
 #include "ringbuffer.h"
 #include "converter.h"
+#include "mixerpool.h"
 #include "backends/base.h"
 
 #include <unistd.h>
 #include <AudioUnit/AudioUnit.h>
 #include <AudioToolbox/AudioToolbox.h>
+#ifdef HAVE_OS_WORKGROUP_H
+#include <os/workgroup.h>
+#endif
 
 
 namespace {
@@ -42,6 +46,41 @@ namespace {
 static const ALCchar ca_device[] = "CoreAudio Default";
 
 
+#ifdef HAVE_OS_WORKGROUP_H
+/* The audio workgroup of the output unit's device, which its render callback
+ * runs in. Mixer workers that join it get the same deadline-aware scheduling,
+ * rather than possibly landing on efficiency cores.
+ */
+struct API_AVAILABLE(macos(11.0), ios(14.0), tvos(14.0)) AudioWorkgroup final : public ThreadGroup {
+    os_workgroup_t mGroup;
+
+    AudioWorkgroup(os_workgroup_t group) noexcept : mGroup{group} { }
+    ~AudioWorkgroup() override { os_release(mGroup); }
+
+    void *join() override
+    {
+        std::unique_ptr<os_workgroup_join_token_s> token{new os_workgroup_join_token_s{}};
+        const int err{os_workgroup_join(mGroup, token.get())};
+        if(err != 0)
+        {
+            ERR("os_workgroup_join failed: %d\n", err);
+            return nullptr;
+        }
+        return token.release();
+    }
+
+    void leave(void *token) override
+    {
+        auto jointoken = static_cast<os_workgroup_join_token_s*>(token);
+        os_workgroup_leave(mGroup, jointoken);
+        delete jointoken;
+    }
+
+    DEF_NEWDEL(AudioWorkgroup)
+};
+#endif
+
+
 struct CoreAudioPlayback final : public BackendBase {
     CoreAudioPlayback(ALCdevice *device) noexcept : BackendBase{device} { }
     ~CoreAudioPlayback() override;
@@ -57,10 +96,17 @@ struct CoreAudioPlayback final : public BackendBase {
     ALCboolean reset() override;
     ALCboolean start() override;
     void stop() override;
+    ThreadGroup *getThreadGroup() override { return mWorkgroup.get(); }
 
     AudioUnit mAudioUnit;
 
+    std::unique_ptr<ThreadGroup> mWorkgroup;
+
     ALuint mFrameSize{0u};
+    /* Float output uses one buffer per channel, the output unit's native
+     * layout, so the mixer can write to it without interleaving.
+     */
+    bool mPlanar{false};
     AudioStreamBasicDescription mFormat{}; // This is the OpenAL format as a CoreAudio ASBD
 
     static constexpr inline const char *CurrentPrefix() noexcept { return "CoreAudioPlayback::"; }
@@ -86,6 +132,20 @@ OSStatus CoreAudioPlayback::MixerProc(AudioUnitRenderActionFlags* UNUSED(ioActio
     const AudioTimeStamp* UNUSED(inTimeStamp), UInt32 UNUSED(inBusNumber),
     UInt32 UNUSED(inNumberFrames), AudioBufferList *ioData)
 {
+    recordWakeup(ioData->mBuffers[0].mDataByteSize/mFrameSize);
+    if(mPlanar)
+    {
+        ALfloat *outbufs[MAX_OUTPUT_CHANNELS];
+        const UInt32 numbufs{minu(ioData->mNumberBuffers, MAX_OUTPUT_CHANNELS)};
+        for(UInt32 i{0};i < numbufs;++i)
+            outbufs[i] = static_cast<ALfloat*>(ioData->mBuffers[i].mData);
+
+        lock();
+        aluMixDataPlanar(mDevice, outbufs, ioData->mBuffers[0].mDataByteSize/mFrameSize);
+        unlock();
+        return noErr;
+    }
+
     lock();
     aluMixData(mDevice, ioData->mBuffers[0].mData, ioData->mBuffers[0].mDataByteSize/mFrameSize);
     unlock();
@@ -135,6 +195,20 @@ ALCenum CoreAudioPlayback::open(const ALCchar *name)
         return ALC_INVALID_VALUE;
     }
 
+#ifdef HAVE_OS_WORKGROUP_H
+    if(__builtin_available(macOS 11.0, iOS 14.0, tvOS 14.0, *))
+    {
+        os_workgroup_t group{nullptr};
+        UInt32 propsize{sizeof(group)};
+        err = AudioUnitGetProperty(mAudioUnit, kAudioOutputUnitProperty_OSWorkgroup,
+            kAudioUnitScope_Global, 0, &group, &propsize);
+        if(err != noErr || !group)
+            WARN("Failed to get the output's audio workgroup: %d\n", err);
+        else
+            mWorkgroup = std::unique_ptr<ThreadGroup>{new AudioWorkgroup{group}};
+    }
+#endif
+
     mDevice->DeviceName = name;
     return ALC_NO_ERROR;
 }
@@ -251,6 +325,17 @@ ALCboolean CoreAudioPlayback::reset()
     streamFormat.mFormatFlags |= kAudioFormatFlagsNativeEndian |
                                  kLinearPCMFormatFlagIsPacked;
 
+    /* For non-interleaved output, each buffer holds one channel, so the
+     * sizes are for a single sample.
+     */
+    mPlanar = (mDevice->FmtType == DevFmtFloat);
+    if(mPlanar)
+    {
+        streamFormat.mFormatFlags |= kAudioFormatFlagIsNonInterleaved;
+        streamFormat.mBytesPerFrame = streamFormat.mBitsPerChannel / 8;
+        streamFormat.mBytesPerPacket = streamFormat.mBytesPerFrame;
+    }
+
     err = AudioUnitSetProperty(mAudioUnit, kAudioUnitProperty_StreamFormat, kAudioUnitScope_Input,
         0, &streamFormat, sizeof(AudioStreamBasicDescription));
     if(err != noErr)
@@ -260,7 +345,7 @@ ALCboolean CoreAudioPlayback::reset()
     }
 
     /* setup callback */
-    mFrameSize = mDevice->frameSizeFromFmt();
+    mFrameSize = mPlanar ? mDevice->bytesFromFmt() : mDevice->frameSizeFromFmt();
     AURenderCallbackStruct input{};
     input.inputProc = CoreAudioPlayback::MixerProcC;
     input.inputProcRefCon = this;
@@ -319,6 +404,7 @@ struct CoreAudioCapture final : public BackendBase {
     void stop() override;
     ALCenum captureSamples(void *buffer, ALCuint samples) override;
     ALCuint availableSamples() override;
+    bool supportsCaptureCallback() override { return true; }
 
     AudioUnit mAudioUnit{0};
 
@@ -390,6 +476,7 @@ OSStatus CoreAudioCapture::RecordProc(AudioUnitRenderActionFlags* UNUSED(ioActio
     }
 
     mRing->writeAdvance(inNumberFrames);
+    dispatchCapture(mRing.get(), nullptr, mConverter.get());
     return noErr;
 }
 
@@ -616,8 +703,8 @@ ALCenum CoreAudioCapture::open(const ALCchar *name)
     // Set up sample converter if needed
     if(outputFormat.mSampleRate != mDevice->Frequency)
         mConverter = CreateSampleConverter(mDevice->FmtType, mDevice->FmtType,
-            mFormat.mChannelsPerFrame, hardwareFormat.mSampleRate, mDevice->Frequency,
-            BSinc24Resampler);
+            mFormat.mChannelsPerFrame, mFormat.mChannelsPerFrame, hardwareFormat.mSampleRate,
+            mDevice->Frequency, BSinc24Resampler);
 
     mRing = CreateRingBuffer(outputFrameCount, mFrameSize, false);
     if(!mRing) return ALC_INVALID_VALUE;
@@ -647,27 +734,8 @@ void CoreAudioCapture::stop()
 
 ALCenum CoreAudioCapture::captureSamples(void *buffer, ALCuint samples)
 {
-    if(!mConverter)
-    {
-        mRing->read(buffer, samples);
-        return ALC_NO_ERROR;
-    }
-
-    auto rec_vec = mRing->getReadVector();
-    const void *src0{rec_vec.first.buf};
-    auto src0len = static_cast<ALsizei>(rec_vec.first.len);
-    auto got = static_cast<ALuint>(mConverter->convert(&src0, &src0len, buffer, samples));
-    size_t total_read{rec_vec.first.len - src0len};
-    if(got < samples && !src0len && rec_vec.second.len > 0)
-    {
-        const void *src1{rec_vec.second.buf};
-        auto src1len = static_cast<ALsizei>(rec_vec.second.len);
-        got += static_cast<ALuint>(mConverter->convert(&src1, &src1len,
-            static_cast<char*>(buffer)+got, samples-got));
-        total_read += rec_vec.second.len - src1len;
-    }
-
-    mRing->readAdvance(total_read);
+    ConvertCaptureRing(mRing.get(), nullptr, mConverter.get(), buffer,
+        static_cast<ALsizei>(samples));
     return ALC_NO_ERROR;
 }
 
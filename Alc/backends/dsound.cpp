@@ -44,6 +44,7 @@
 #include "alu.h"
 #include "ringbuffer.h"
 #include "compat.h"
+#include "altrace.h"
 
 /* MinGW-w64 needs this for some unknown reason now. */
 using LPCWAVEFORMATEX = const WAVEFORMATEX*;
@@ -241,7 +242,8 @@ FORCE_ALIGN int DSoundPlayback::mixerProc()
                 Playing = true;
             }
 
-            avail = WaitForSingleObjectEx(mNotifyEvent, 2000, FALSE);
+            avail = AL_TRACE_EXPR("WaitForSingleObjectEx",
+                WaitForSingleObjectEx(mNotifyEvent, 2000, FALSE));
             if(avail != WAIT_OBJECT_0)
                 ERR("WaitForSingleObjectEx error: 0x%lx\n", avail);
             continue;
@@ -269,6 +271,7 @@ FORCE_ALIGN int DSoundPlayback::mixerProc()
 
         if(SUCCEEDED(err))
         {
+            recordWakeup(static_cast<ALuint>((WriteCnt1+WriteCnt2)/FrameSize));
             lock();
             aluMixData(mDevice, WritePtr1, WriteCnt1/FrameSize);
             if(WriteCnt2 > 0)
@@ -173,6 +173,11 @@ struct JackPlayback final : public BackendBase {
     RingBufferPtr mRing;
     al::semaphore mSem;
 
+    /* Set to mix directly into the port buffers from the process callback,
+     * instead of going through the ring buffer and mixer thread.
+     */
+    bool mDirectMix{false};
+
     std::atomic<bool> mKillNow{true};
     std::thread mThread;
 
@@ -205,11 +210,13 @@ int JackPlayback::bufferSizeNotify(jack_nframes_t numframes)
     mDevice->BufferSize = numframes*2;
 
     ALuint bufsize{mDevice->UpdateSize};
-    if(ConfigValueUInt(mDevice->DeviceName.c_str(), "jack", "buffer-size", &bufsize))
+    if(!mDirectMix && ConfigValueUInt(mDevice->DeviceName.c_str(), "jack", "buffer-size", &bufsize))
         bufsize = maxu(NextPowerOf2(bufsize), mDevice->UpdateSize);
     mDevice->BufferSize = bufsize + mDevice->UpdateSize;
 
     TRACE("%u / %u buffer\n", mDevice->UpdateSize, mDevice->BufferSize);
+    if(mDirectMix)
+        return 0;
 
     mRing = nullptr;
     mRing = CreateRingBuffer(bufsize, mDevice->frameSizeFromFmt(), true);
@@ -235,6 +242,23 @@ int JackPlayback::process(jack_nframes_t numframes)
         out[numchans++] = static_cast<float*>(jack_port_get_buffer(port, numframes));
     }
 
+    if(mDirectMix)
+    {
+        recordWakeup(numframes);
+        /* Don't wait on the mixer lock in the realtime thread. If it's held
+         * (e.g. the device is being reset), output silence for this period.
+         */
+        std::unique_lock<std::recursive_mutex> mixlock{mMutex, std::try_to_lock};
+        if(LIKELY(mixlock.owns_lock()))
+            aluMixDataPlanar(mDevice, out, static_cast<ALsizei>(numframes));
+        else
+            std::for_each(out, out+numchans,
+                [numframes](ALfloat *outbuf) -> void
+                { std::fill_n(outbuf, numframes, 0.0f); }
+            );
+        return 0;
+    }
+
     auto data = mRing->getReadVector();
     jack_nframes_t todo{minu(numframes, data.first.len)};
     std::transform(out, out+numchans, out,
@@ -282,6 +306,8 @@ int JackPlayback::process(jack_nframes_t numframes)
 
     if(numframes > total)
     {
+        /* The mixer thread didn't keep up. */
+        recordUnderrun();
         todo = numframes-total;
         std::transform(out, out+numchans, out,
             [todo](ALfloat *outbuf) -> ALfloat*
@@ -319,6 +345,7 @@ int JackPlayback::mixerProc()
         ALuint len1{minu(data.first.len, todo)};
         ALuint len2{minu(data.second.len, todo-len1)};
 
+        recordWakeup(todo);
         aluMixData(mDevice, data.first.buf, len1);
         if(len2 > 0)
             aluMixData(mDevice, data.second.buf, len2);
@@ -383,6 +410,13 @@ ALCboolean JackPlayback::reset()
     /* Force 32-bit float output. */
     mDevice->FmtType = DevFmtFloat;
 
+    /* Direct mixing renders each JACK period as it's requested, so the update
+     * size is the JACK period and there's no extra buffering.
+     */
+    mDirectMix = !!GetConfigValueBool(mDevice->DeviceName.c_str(), "jack", "direct-mix", 0);
+    if(mDirectMix)
+        mDevice->BufferSize = mDevice->UpdateSize;
+
     ALsizei numchans{mDevice->channelsFromFmt()};
     auto ports_end = std::begin(mPort) + numchans;
     auto bad_port = std::find_if_not(std::begin(mPort), ports_end,
@@ -415,11 +449,14 @@ ALCboolean JackPlayback::reset()
     }
 
     mRing = nullptr;
-    mRing = CreateRingBuffer(bufsize, mDevice->frameSizeFromFmt(), true);
-    if(!mRing)
+    if(!mDirectMix)
     {
-        ERR("Failed to allocate ringbuffer\n");
-        return ALC_FALSE;
+        mRing = CreateRingBuffer(bufsize, mDevice->frameSizeFromFmt(), true);
+        if(!mRing)
+        {
+            ERR("Failed to allocate ringbuffer\n");
+            return ALC_FALSE;
+        }
     }
 
     SetDefaultChannelOrder(mDevice);
@@ -460,6 +497,9 @@ ALCboolean JackPlayback::start()
     );
     jack_free(ports);
 
+    if(mDirectMix)
+        return ALC_TRUE;
+
     try {
         mKillNow.store(false, std::memory_order_release);
         mThread = std::thread{std::mem_fn(&JackPlayback::mixerProc), this};
@@ -476,6 +516,12 @@ ALCboolean JackPlayback::start()
 
 void JackPlayback::stop()
 {
+    if(mDirectMix)
+    {
+        jack_deactivate(mClient);
+        return;
+    }
+
     if(mKillNow.exchange(true, std::memory_order_acq_rel) || !mThread.joinable())
         return;
 
@@ -492,7 +538,10 @@ ClockLatency JackPlayback::getClockLatency()
 
     lock();
     ret.ClockTime = GetDeviceClockTime(mDevice);
-    ret.Latency  = std::chrono::seconds{mRing->readSpace()};
+    /* With direct mixing, only the period currently being played is
+     * buffered.
+     */
+    ret.Latency  = std::chrono::seconds{mRing ? mRing->readSpace() : mDevice->UpdateSize};
     ret.Latency /= mDevice->Frequency;
     unlock();
 
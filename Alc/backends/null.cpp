@@ -83,6 +83,7 @@ int NullBackend::mixerProc()
             std::this_thread::sleep_for(restTime);
             continue;
         }
+        recordWakeup(static_cast<ALuint>((avail-done) / mDevice->UpdateSize * mDevice->UpdateSize));
         while(avail-done >= mDevice->UpdateSize)
         {
             lock();
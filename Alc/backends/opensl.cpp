@@ -263,6 +263,7 @@ int OpenSLPlayback::mixerProc()
         }
 
         auto data = mRing->getWriteVector();
+        recordWakeup(static_cast<ALuint>(data.first.len+data.second.len) * mDevice->UpdateSize);
         aluMixData(mDevice, data.first.buf, data.first.len*mDevice->UpdateSize);
         if(data.second.len > 0)
             aluMixData(mDevice, data.second.buf, data.second.len*mDevice->UpdateSize);
@@ -48,6 +48,7 @@
 #include "alconfig.h"
 #include "ringbuffer.h"
 #include "compat.h"
+#include "altrace.h"
 
 #include <sys/soundcard.h>
 
@@ -288,7 +289,7 @@ int OSSPlayback::mixerProc()
         pollitem.events = POLLOUT;
 
         unlock();
-        int pret{poll(&pollitem, 1, 1000)};
+        int pret{AL_TRACE_EXPR("poll", poll(&pollitem, 1, 1000))};
         lock();
         if(pret < 0)
         {
@@ -306,6 +307,7 @@ int OSSPlayback::mixerProc()
 
         ALubyte *write_ptr{mMixData.data()};
         size_t to_write{mMixData.size()};
+        recordWakeup(static_cast<ALuint>(to_write/frame_size));
         aluMixData(mDevice, write_ptr, to_write/frame_size);
         while(to_write > 0 && !mKillNow.load(std::memory_order_acquire))
         {
@@ -482,6 +484,7 @@ struct OSScapture final : public BackendBase {
     void stop() override;
     ALCenum captureSamples(ALCvoid *buffer, ALCuint samples) override;
     ALCuint availableSamples() override;
+    bool supportsCaptureCallback() override { return true; }
 
     int mFd{-1};
 
@@ -541,6 +544,7 @@ int OSScapture::recordProc()
                 break;
             }
             mRing->writeAdvance(amt/frame_size);
+            dispatchCapture(mRing.get());
         }
     }
 
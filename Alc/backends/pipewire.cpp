@@ -0,0 +1,765 @@
+/**
+ * OpenAL cross platform audio library
+ * Copyright (C) 1999-2007 by authors.
+ * This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Library General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ *  License along with this library; if not, write to the
+ *  Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ * Or go to http://www.gnu.org/copyleft/lgpl.html
+ */
+
+#include "config.h"
+
+#include "backends/pipewire.h"
+
+#include <cstring>
+
+#include <string>
+#include <atomic>
+#include <mutex>
+#include <algorithm>
+
+#include "alMain.h"
+#include "alu.h"
+#include "alconfig.h"
+#include "ringbuffer.h"
+#include "compat.h"
+
+#include <pipewire/pipewire.h>
+#include <spa/param/audio/format-utils.h>
+#include <spa/pod/builder.h>
+
+
+namespace {
+
+constexpr ALCchar pwireDevice[] = "PipeWire Output";
+constexpr ALCchar pwireInput[] = "PipeWire Input";
+
+
+#ifdef HAVE_DYNLOAD
+#define PWIRE_FUNCS(MAGIC)                                                    \
+    MAGIC(pw_init);                                                           \
+    MAGIC(pw_get_library_version);                                            \
+    MAGIC(pw_loop_new);                                                       \
+    MAGIC(pw_loop_destroy);                                                   \
+    MAGIC(pw_context_new);                                                    \
+    MAGIC(pw_context_destroy);                                                \
+    MAGIC(pw_context_connect);                                                \
+    MAGIC(pw_core_disconnect);                                                \
+    MAGIC(pw_thread_loop_new);                                                \
+    MAGIC(pw_thread_loop_destroy);                                            \
+    MAGIC(pw_thread_loop_start);                                              \
+    MAGIC(pw_thread_loop_stop);                                               \
+    MAGIC(pw_thread_loop_lock);                                               \
+    MAGIC(pw_thread_loop_unlock);                                             \
+    MAGIC(pw_thread_loop_wait);                                               \
+    MAGIC(pw_thread_loop_signal);                                             \
+    MAGIC(pw_thread_loop_get_loop);                                           \
+    MAGIC(pw_properties_new);                                                 \
+    MAGIC(pw_properties_setf);                                                \
+    MAGIC(pw_stream_new_simple);                                              \
+    MAGIC(pw_stream_destroy);                                                 \
+    MAGIC(pw_stream_connect);                                                 \
+    MAGIC(pw_stream_set_active);                                              \
+    MAGIC(pw_stream_get_state);                                               \
+    MAGIC(pw_stream_get_time);                                                \
+    MAGIC(pw_stream_dequeue_buffer);                                          \
+    MAGIC(pw_stream_queue_buffer);
+
+void *pwire_handle;
+#define MAKE_FUNC(x) decltype(x) * p##x
+PWIRE_FUNCS(MAKE_FUNC)
+#undef MAKE_FUNC
+
+#ifndef IN_IDE_PARSER
+#define pw_init ppw_init
+#define pw_get_library_version ppw_get_library_version
+#define pw_loop_new ppw_loop_new
+#define pw_loop_destroy ppw_loop_destroy
+#define pw_context_new ppw_context_new
+#define pw_context_destroy ppw_context_destroy
+#define pw_context_connect ppw_context_connect
+#define pw_core_disconnect ppw_core_disconnect
+#define pw_thread_loop_new ppw_thread_loop_new
+#define pw_thread_loop_destroy ppw_thread_loop_destroy
+#define pw_thread_loop_start ppw_thread_loop_start
+#define pw_thread_loop_stop ppw_thread_loop_stop
+#define pw_thread_loop_lock ppw_thread_loop_lock
+#define pw_thread_loop_unlock ppw_thread_loop_unlock
+#define pw_thread_loop_wait ppw_thread_loop_wait
+#define pw_thread_loop_signal ppw_thread_loop_signal
+#define pw_thread_loop_get_loop ppw_thread_loop_get_loop
+#define pw_properties_new ppw_properties_new
+#define pw_properties_setf ppw_properties_setf
+#define pw_stream_new_simple ppw_stream_new_simple
+#define pw_stream_destroy ppw_stream_destroy
+#define pw_stream_connect ppw_stream_connect
+#define pw_stream_set_active ppw_stream_set_active
+#define pw_stream_get_state ppw_stream_get_state
+#define pw_stream_get_time ppw_stream_get_time
+#define pw_stream_dequeue_buffer ppw_stream_dequeue_buffer
+#define pw_stream_queue_buffer ppw_stream_queue_buffer
+#endif /* IN_IDE_PARSER */
+
+#endif
+
+
+bool pwire_load()
+{
+#ifdef HAVE_DYNLOAD
+    if(!pwire_handle)
+    {
+        bool ret{true};
+        std::string missing_funcs;
+
+#define PWIRE_LIB "libpipewire-0.3.so.0"
+        pwire_handle = LoadLib(PWIRE_LIB);
+        if(!pwire_handle)
+        {
+            WARN("Failed to load %s\n", PWIRE_LIB);
+            return false;
+        }
+
+#define LOAD_FUNC(x) do {                                                     \
+    p##x = reinterpret_cast<decltype(p##x)>(GetSymbol(pwire_handle, #x));     \
+    if(!(p##x)) {                                                             \
+        ret = false;                                                          \
+        missing_funcs += "\n" #x;                                             \
+    }                                                                         \
+} while(0)
+        PWIRE_FUNCS(LOAD_FUNC)
+#undef LOAD_FUNC
+
+        if(!ret)
+        {
+            WARN("Missing expected functions:%s\n", missing_funcs.c_str());
+            CloseLib(pwire_handle);
+            pwire_handle = nullptr;
+            return false;
+        }
+    }
+#endif /* HAVE_DYNLOAD */
+
+    return true;
+}
+
+
+/* Fills in the raw audio format for the device's sample type, rate, and
+ * channel configuration. Ambisonic output isn't supported, so that's changed
+ * to stereo.
+ */
+spa_audio_info_raw make_spa_info(ALCdevice *device)
+{
+    spa_audio_info_raw info{};
+    switch(device->FmtType)
+    {
+        case DevFmtByte: info.format = SPA_AUDIO_FORMAT_S8; break;
+        case DevFmtUByte: info.format = SPA_AUDIO_FORMAT_U8; break;
+        case DevFmtShort: info.format = SPA_AUDIO_FORMAT_S16; break;
+        case DevFmtUShort: info.format = SPA_AUDIO_FORMAT_U16; break;
+        case DevFmtInt: info.format = SPA_AUDIO_FORMAT_S32; break;
+        case DevFmtUInt: info.format = SPA_AUDIO_FORMAT_U32; break;
+        case DevFmtFloat: info.format = SPA_AUDIO_FORMAT_F32; break;
+    }
+    info.rate = device->Frequency;
+
+    /* These match the channel orders set by SetDefaultWFXChannelOrder. */
+    static constexpr uint32_t MonoMap[]{ SPA_AUDIO_CHANNEL_MONO };
+    static constexpr uint32_t StereoMap[]{ SPA_AUDIO_CHANNEL_FL, SPA_AUDIO_CHANNEL_FR };
+    static constexpr uint32_t QuadMap[]{
+        SPA_AUDIO_CHANNEL_FL, SPA_AUDIO_CHANNEL_FR, SPA_AUDIO_CHANNEL_RL, SPA_AUDIO_CHANNEL_RR
+    };
+    static constexpr uint32_t X51Map[]{
+        SPA_AUDIO_CHANNEL_FL, SPA_AUDIO_CHANNEL_FR, SPA_AUDIO_CHANNEL_FC, SPA_AUDIO_CHANNEL_LFE,
+        SPA_AUDIO_CHANNEL_SL, SPA_AUDIO_CHANNEL_SR
+    };
+    static constexpr uint32_t X51RearMap[]{
+        SPA_AUDIO_CHANNEL_FL, SPA_AUDIO_CHANNEL_FR, SPA_AUDIO_CHANNEL_FC, SPA_AUDIO_CHANNEL_LFE,
+        SPA_AUDIO_CHANNEL_RL, SPA_AUDIO_CHANNEL_RR
+    };
+    static constexpr uint32_t X61Map[]{
+        SPA_AUDIO_CHANNEL_FL, SPA_AUDIO_CHANNEL_FR, SPA_AUDIO_CHANNEL_FC, SPA_AUDIO_CHANNEL_LFE,
+        SPA_AUDIO_CHANNEL_RC, SPA_AUDIO_CHANNEL_SL, SPA_AUDIO_CHANNEL_SR
+    };
+    static constexpr uint32_t X71Map[]{
+        SPA_AUDIO_CHANNEL_FL, SPA_AUDIO_CHANNEL_FR, SPA_AUDIO_CHANNEL_FC, SPA_AUDIO_CHANNEL_LFE,
+        SPA_AUDIO_CHANNEL_RL, SPA_AUDIO_CHANNEL_RR, SPA_AUDIO_CHANNEL_SL, SPA_AUDIO_CHANNEL_SR
+    };
+    auto set_map = [&info](const uint32_t *map, size_t count) -> void
+    {
+        info.channels = static_cast<uint32_t>(count);
+        std::copy_n(map, count, info.position);
+    };
+    switch(device->FmtChans)
+    {
+        case DevFmtMono: set_map(MonoMap, COUNTOF(MonoMap)); break;
+        case DevFmtAmbi3D:
+            device->FmtChans = DevFmtStereo;
+            /*fall-through*/
+        case DevFmtStereo: set_map(StereoMap, COUNTOF(StereoMap)); break;
+        case DevFmtQuad: set_map(QuadMap, COUNTOF(QuadMap)); break;
+        case DevFmtX51: set_map(X51Map, COUNTOF(X51Map)); break;
+        case DevFmtX51Rear: set_map(X51RearMap, COUNTOF(X51RearMap)); break;
+        case DevFmtX61: set_map(X61Map, COUNTOF(X61Map)); break;
+        case DevFmtX71: set_map(X71Map, COUNTOF(X71Map)); break;
+    }
+    return info;
+}
+
+
+/* Owns a PipeWire thread loop, which runs the stream's non-realtime events.
+ * With PW_STREAM_FLAG_RT_PROCESS, the process callback instead runs on
+ * PipeWire's own realtime data thread.
+ */
+struct PwireThreadLoop {
+    pw_thread_loop *mLoop{nullptr};
+
+    ~PwireThreadLoop()
+    {
+        if(mLoop)
+        {
+            pw_thread_loop_stop(mLoop);
+            pw_thread_loop_destroy(mLoop);
+        }
+        mLoop = nullptr;
+    }
+
+    bool init(const char *name)
+    {
+        mLoop = pw_thread_loop_new(name, nullptr);
+        if(!mLoop)
+        {
+            ERR("Failed to create PipeWire thread loop\n");
+            return false;
+        }
+        if(pw_thread_loop_start(mLoop) != 0)
+        {
+            ERR("Failed to start PipeWire thread loop\n");
+            pw_thread_loop_destroy(mLoop);
+            mLoop = nullptr;
+            return false;
+        }
+        return true;
+    }
+
+    void lock() { pw_thread_loop_lock(mLoop); }
+    void unlock() { pw_thread_loop_unlock(mLoop); }
+};
+using PwireLoopLock = std::unique_lock<PwireThreadLoop>;
+
+
+/* Creates and connects a stream with the given format, then waits for it to
+ * finish connecting. The stream is left inactive. The loop must be locked.
+ */
+pw_stream *connect_stream(PwireThreadLoop &loop, const char *name, pw_properties *props,
+    const pw_stream_events *events, void *data, pw_direction direction,
+    spa_audio_info_raw *info)
+{
+    pw_stream *stream{pw_stream_new_simple(pw_thread_loop_get_loop(loop.mLoop), name, props,
+        events, data)};
+    if(!stream)
+    {
+        ERR("Failed to create PipeWire stream\n");
+        return nullptr;
+    }
+
+    uint8_t pod_buffer[1024];
+    spa_pod_builder builder{};
+    spa_pod_builder_init(&builder, pod_buffer, sizeof(pod_buffer));
+    const spa_pod *params[]{spa_format_audio_raw_build(&builder, SPA_PARAM_EnumFormat, info)};
+
+    const auto flags = static_cast<pw_stream_flags>(PW_STREAM_FLAG_AUTOCONNECT |
+        PW_STREAM_FLAG_INACTIVE | PW_STREAM_FLAG_MAP_BUFFERS | PW_STREAM_FLAG_RT_PROCESS);
+    if(int res{pw_stream_connect(stream, direction, PW_ID_ANY, flags, params, 1)})
+    {
+        ERR("Failed to connect PipeWire stream: %d\n", res);
+        pw_stream_destroy(stream);
+        return nullptr;
+    }
+
+    const char *error{nullptr};
+    pw_stream_state state;
+    while((state=pw_stream_get_state(stream, &error)) == PW_STREAM_STATE_CONNECTING)
+        pw_thread_loop_wait(loop.mLoop);
+    if(state == PW_STREAM_STATE_ERROR || state == PW_STREAM_STATE_UNCONNECTED)
+    {
+        ERR("PipeWire stream failed to connect: %s\n", error ? error : "(unknown)");
+        pw_stream_destroy(stream);
+        return nullptr;
+    }
+    return stream;
+}
+
+/* Returns the stream's latency, the delay until the next sample written is
+ * heard (or the last sample read was recorded), in nanoseconds.
+ */
+std::chrono::nanoseconds get_stream_latency(pw_stream *stream, ALuint frequency,
+    ALuint frame_size)
+{
+    using std::chrono::seconds;
+    using std::chrono::nanoseconds;
+
+    pw_time ptime{};
+    if(pw_stream_get_time(stream, &ptime) != 0 || ptime.rate.denom == 0)
+        return nanoseconds::zero();
+
+    nanoseconds latency{0};
+    if(ptime.delay > 0)
+        latency = nanoseconds{seconds{ptime.delay}} * ptime.rate.num / ptime.rate.denom;
+    latency += nanoseconds{seconds{ptime.queued/frame_size}} / frequency;
+    return latency;
+}
+
+
+struct PipeWirePlayback final : public BackendBase {
+    PipeWirePlayback(ALCdevice *device) noexcept : BackendBase{device} { }
+    ~PipeWirePlayback() override;
+
+    static void stateChangedCallbackC(void *data, pw_stream_state old, pw_stream_state state,
+        const char *error);
+    void stateChangedCallback(pw_stream_state old, pw_stream_state state, const char *error);
+
+    static void processCallbackC(void *data);
+    void processCallback();
+
+    ALCenum open(const ALCchar *name) override;
+    ALCboolean reset() override;
+    ALCboolean start() override;
+    void stop() override;
+    ClockLatency getClockLatency() override;
+
+    PwireThreadLoop mLoop;
+    pw_stream *mStream{nullptr};
+    pw_stream_events mEvents{};
+
+    ALuint mFrameSize{0u};
+    /* The last graph quantum seen, so the device's update size can follow it. */
+    ALuint mQuantum{0u};
+
+    static constexpr inline const char *CurrentPrefix() noexcept { return "PipeWirePlayback::"; }
+    DEF_NEWDEL(PipeWirePlayback)
+};
+
+PipeWirePlayback::~PipeWirePlayback()
+{
+    if(!mLoop.mLoop)
+        return;
+
+    /* Stop the loop first, so the stream can be destroyed without it
+     * running.
+     */
+    pw_thread_loop_stop(mLoop.mLoop);
+    if(mStream)
+        pw_stream_destroy(mStream);
+    mStream = nullptr;
+}
+
+
+void PipeWirePlayback::stateChangedCallbackC(void *data, pw_stream_state old,
+    pw_stream_state state, const char *error)
+{ static_cast<PipeWirePlayback*>(data)->stateChangedCallback(old, state, error); }
+
+void PipeWirePlayback::stateChangedCallback(pw_stream_state, pw_stream_state state,
+    const char *error)
+{
+    if(state == PW_STREAM_STATE_ERROR)
+    {
+        ERR("Received stream error: %s\n", error ? error : "(unknown)");
+        aluHandleDisconnect(mDevice, "PipeWire stream error: %s", error ? error : "(unknown)");
+    }
+    pw_thread_loop_signal(mLoop.mLoop, false);
+}
+
+void PipeWirePlayback::processCallbackC(void *data)
+{ static_cast<PipeWirePlayback*>(data)->processCallback(); }
+
+void PipeWirePlayback::processCallback()
+{
+    pw_buffer *pwbuf{pw_stream_dequeue_buffer(mStream)};
+    if(UNLIKELY(!pwbuf)) return;
+
+    spa_data &data = pwbuf->buffer->datas[0];
+    if(UNLIKELY(!data.data))
+    {
+        pw_stream_queue_buffer(mStream, pwbuf);
+        return;
+    }
+
+    /* Mix as much as the graph wants this cycle, directly into the buffer the
+     * server will read.
+     */
+    ALuint todo{data.maxsize / mFrameSize};
+#if PW_CHECK_VERSION(0,3,49)
+    if(pwbuf->requested > 0)
+    {
+        todo = static_cast<ALuint>(minu64(todo, pwbuf->requested));
+        if(UNLIKELY(todo != mQuantum))
+        {
+            /* Follow the graph quantum, so the update size reported to the
+             * app is accurate. Don't wait on the state lock from the realtime
+             * thread, though; it'll be caught on a later cycle.
+             */
+            std::unique_lock<std::mutex> statelock{mDevice->StateLock, std::try_to_lock};
+            if(statelock.owns_lock())
+            {
+                mQuantum = todo;
+                mDevice->UpdateSize = todo;
+                mDevice->BufferSize = todo * 2;
+                TRACE("Graph quantum changed to %u samples\n", todo);
+            }
+        }
+    }
+#endif
+
+    recordWakeup(static_cast<ALuint>(todo));
+    /* Don't wait on the mixer lock in the realtime thread. If it's held (e.g.
+     * the device is being reset), output silence for this cycle.
+     */
+    std::unique_lock<std::recursive_mutex> mixlock{mMutex, std::try_to_lock};
+    if(LIKELY(mixlock.owns_lock()))
+        aluMixData(mDevice, data.data, static_cast<ALsizei>(todo));
+    else
+        memset(data.data, ((mDevice->FmtType == DevFmtUByte) ? 0x80 : 0), todo*mFrameSize);
+
+    data.chunk->offset = 0;
+    data.chunk->stride = static_cast<int32_t>(mFrameSize);
+    data.chunk->size = todo * mFrameSize;
+    pw_stream_queue_buffer(mStream, pwbuf);
+}
+
+
+ALCenum PipeWirePlayback::open(const ALCchar *name)
+{
+    if(!name)
+        name = pwireDevice;
+    else if(strcmp(name, pwireDevice) != 0)
+        return ALC_INVALID_VALUE;
+
+    if(!mLoop.init("ALSoft PipeWire Playback"))
+        return ALC_INVALID_VALUE;
+
+    mEvents.version = PW_VERSION_STREAM_EVENTS;
+    mEvents.state_changed = &PipeWirePlayback::stateChangedCallbackC;
+    mEvents.process = &PipeWirePlayback::processCallbackC;
+
+    mDevice->DeviceName = name;
+    return ALC_NO_ERROR;
+}
+
+ALCboolean PipeWirePlayback::reset()
+{
+    PwireLoopLock looplock{mLoop};
+    if(mStream)
+        pw_stream_destroy(mStream);
+    mStream = nullptr;
+
+    spa_audio_info_raw info{make_spa_info(mDevice)};
+
+    /* Ask for the graph to run at the device's rate and update size. The
+     * server has the final say on the quantum, which the mixer follows as it
+     * changes.
+     */
+    pw_properties *props{pw_properties_new(PW_KEY_MEDIA_TYPE, "Audio",
+        PW_KEY_MEDIA_CATEGORY, "Playback", PW_KEY_MEDIA_ROLE, "Game",
+        PW_KEY_NODE_ALWAYS_PROCESS, "true", nullptr)};
+    if(!props)
+    {
+        ERR("Failed to create PipeWire stream properties\n");
+        return ALC_FALSE;
+    }
+    pw_properties_setf(props, PW_KEY_NODE_LATENCY, "%u/%u", mDevice->UpdateSize,
+        mDevice->Frequency);
+    pw_properties_setf(props, PW_KEY_NODE_RATE, "1/%u", mDevice->Frequency);
+
+    mStream = connect_stream(mLoop, "Playback Stream", props, &mEvents, this,
+        PW_DIRECTION_OUTPUT, &info);
+    if(!mStream)
+        return ALC_FALSE;
+
+    mFrameSize = mDevice->frameSizeFromFmt();
+    mQuantum = mDevice->UpdateSize;
+    mDevice->BufferSize = mDevice->UpdateSize * 2;
+    SetDefaultWFXChannelOrder(mDevice);
+
+    return ALC_TRUE;
+}
+
+ALCboolean PipeWirePlayback::start()
+{
+    PwireLoopLock looplock{mLoop};
+    if(int res{pw_stream_set_active(mStream, true)})
+    {
+        ERR("Failed to start PipeWire stream: %d\n", res);
+        return ALC_FALSE;
+    }
+    return ALC_TRUE;
+}
+
+void PipeWirePlayback::stop()
+{
+    PwireLoopLock looplock{mLoop};
+    if(int res{pw_stream_set_active(mStream, false)})
+        ERR("Failed to stop PipeWire stream: %d\n", res);
+}
+
+
+ClockLatency PipeWirePlayback::getClockLatency()
+{
+    ClockLatency ret;
+
+    lock();
+    ret.ClockTime = GetDeviceClockTime(mDevice);
+    ret.Latency = get_stream_latency(mStream, mDevice->Frequency, mFrameSize);
+    unlock();
+
+    return ret;
+}
+
+
+struct PipeWireCapture final : public BackendBase {
+    PipeWireCapture(ALCdevice *device) noexcept : BackendBase{device} { }
+    ~PipeWireCapture() override;
+
+    static void stateChangedCallbackC(void *data, pw_stream_state old, pw_stream_state state,
+        const char *error);
+    void stateChangedCallback(pw_stream_state old, pw_stream_state state, const char *error);
+
+    static void processCallbackC(void *data);
+    void processCallback();
+
+    ALCenum open(const ALCchar *name) override;
+    ALCboolean start() override;
+    void stop() override;
+    ALCenum captureSamples(ALCvoid *buffer, ALCuint samples) override;
+    ALCuint availableSamples() override;
+    bool supportsCaptureCallback() override { return true; }
+    ClockLatency getClockLatency() override;
+
+    PwireThreadLoop mLoop;
+    pw_stream *mStream{nullptr};
+    pw_stream_events mEvents{};
+
+    ALuint mFrameSize{0u};
+
+    RingBufferPtr mRing{nullptr};
+
+    static constexpr inline const char *CurrentPrefix() noexcept { return "PipeWireCapture::"; }
+    DEF_NEWDEL(PipeWireCapture)
+};
+
+PipeWireCapture::~PipeWireCapture()
+{
+    if(!mLoop.mLoop)
+        return;
+
+    pw_thread_loop_stop(mLoop.mLoop);
+    if(mStream)
+        pw_stream_destroy(mStream);
+    mStream = nullptr;
+}
+
+
+void PipeWireCapture::stateChangedCallbackC(void *data, pw_stream_state old,
+    pw_stream_state state, const char *error)
+{ static_cast<PipeWireCapture*>(data)->stateChangedCallback(old, state, error); }
+
+void PipeWireCapture::stateChangedCallback(pw_stream_state, pw_stream_state state,
+    const char *error)
+{
+    if(state == PW_STREAM_STATE_ERROR)
+    {
+        ERR("Received stream error: %s\n", error ? error : "(unknown)");
+        aluHandleDisconnect(mDevice, "PipeWire stream error: %s", error ? error : "(unknown)");
+    }
+    pw_thread_loop_signal(mLoop.mLoop, false);
+}
+
+void PipeWireCapture::processCallbackC(void *data)
+{ static_cast<PipeWireCapture*>(data)->processCallback(); }
+
+void PipeWireCapture::processCallback()
+{
+    pw_buffer *pwbuf{pw_stream_dequeue_buffer(mStream)};
+    if(UNLIKELY(!pwbuf)) return;
+
+    const spa_data &data = pwbuf->buffer->datas[0];
+    if(LIKELY(data.data != nullptr))
+    {
+        const ALuint offset{minu(data.chunk->offset, data.maxsize)};
+        const ALuint size{minu(data.chunk->size, data.maxsize - offset)};
+        mRing->write(static_cast<const char*>(data.data) + offset, size / mFrameSize);
+        dispatchCapture(mRing.get());
+    }
+    pw_stream_queue_buffer(mStream, pwbuf);
+}
+
+
+ALCenum PipeWireCapture::open(const ALCchar *name)
+{
+    if(!name)
+        name = pwireInput;
+    else if(strcmp(name, pwireInput) != 0)
+        return ALC_INVALID_VALUE;
+
+    if(mDevice->FmtChans == DevFmtAmbi3D)
+    {
+        ERR("%s capture not supported\n", DevFmtChannelsString(mDevice->FmtChans));
+        return ALC_INVALID_VALUE;
+    }
+
+    /* Make sure the ring buffer holds at least 100ms. */
+    ALuint samples{maxu(mDevice->BufferSize, mDevice->Frequency / 10)};
+    mFrameSize = mDevice->frameSizeFromFmt();
+    mRing = CreateRingBuffer(samples, mFrameSize, false);
+    if(!mRing) return ALC_INVALID_VALUE;
+
+    if(!mLoop.init("ALSoft PipeWire Capture"))
+        return ALC_INVALID_VALUE;
+
+    mEvents.version = PW_VERSION_STREAM_EVENTS;
+    mEvents.state_changed = &PipeWireCapture::stateChangedCallbackC;
+    mEvents.process = &PipeWireCapture::processCallbackC;
+
+    PwireLoopLock looplock{mLoop};
+    spa_audio_info_raw info{make_spa_info(mDevice)};
+    pw_properties *props{pw_properties_new(PW_KEY_MEDIA_TYPE, "Audio",
+        PW_KEY_MEDIA_CATEGORY, "Capture", PW_KEY_MEDIA_ROLE, "Game", nullptr)};
+    if(!props)
+    {
+        ERR("Failed to create PipeWire stream properties\n");
+        return ALC_INVALID_VALUE;
+    }
+    pw_properties_setf(props, PW_KEY_NODE_LATENCY, "%u/%u", mDevice->UpdateSize,
+        mDevice->Frequency);
+    pw_properties_setf(props, PW_KEY_NODE_RATE, "1/%u", mDevice->Frequency);
+
+    mStream = connect_stream(mLoop, "Capture Stream", props, &mEvents, this,
+        PW_DIRECTION_INPUT, &info);
+    if(!mStream)
+        return ALC_INVALID_VALUE;
+
+    mDevice->DeviceName = name;
+    return ALC_NO_ERROR;
+}
+
+ALCboolean PipeWireCapture::start()
+{
+    PwireLoopLock looplock{mLoop};
+    if(int res{pw_stream_set_active(mStream, true)})
+    {
+        ERR("Failed to start PipeWire stream: %d\n", res);
+        return ALC_FALSE;
+    }
+    return ALC_TRUE;
+}
+
+void PipeWireCapture::stop()
+{
+    PwireLoopLock looplock{mLoop};
+    if(int res{pw_stream_set_active(mStream, false)})
+        ERR("Failed to stop PipeWire stream: %d\n", res);
+}
+
+ALCenum PipeWireCapture::captureSamples(ALCvoid *buffer, ALCuint samples)
+{
+    mRing->read(buffer, samples);
+    return ALC_NO_ERROR;
+}
+
+ALCuint PipeWireCapture::availableSamples()
+{ return static_cast<ALCuint>(mRing->readSpace()); }
+
+ClockLatency PipeWireCapture::getClockLatency()
+{
+    ClockLatency ret;
+
+    lock();
+    ret.ClockTime = GetDeviceClockTime(mDevice);
+    ret.Latency = get_stream_latency(mStream, mDevice->Frequency, mFrameSize);
+    unlock();
+
+    return ret;
+}
+
+} // namespace
+
+
+bool PipeWireBackendFactory::init()
+{
+    if(!pwire_load())
+        return false;
+
+    pw_init(nullptr, nullptr);
+    TRACE("Found PipeWire version \"%s\"\n", pw_get_library_version());
+
+    /* Make sure there's a server to connect to, so the backend can be skipped
+     * in favor of another when there isn't.
+     */
+    pw_loop *loop{pw_loop_new(nullptr)};
+    if(!loop)
+    {
+        WARN("Failed to create PipeWire loop\n");
+        return false;
+    }
+    bool ret{false};
+    if(pw_context *context{pw_context_new(loop, nullptr, 0)})
+    {
+        if(pw_core *core{pw_context_connect(context, nullptr, 0)})
+        {
+            pw_core_disconnect(core);
+            ret = true;
+        }
+        else
+            WARN("Failed to connect to PipeWire server\n");
+        pw_context_destroy(context);
+    }
+    else
+        WARN("Failed to create PipeWire context\n");
+    pw_loop_destroy(loop);
+
+    return ret;
+}
+
+bool PipeWireBackendFactory::querySupport(BackendType type)
+{ return type == BackendType::Playback || type == BackendType::Capture; }
+
+void PipeWireBackendFactory::probe(DevProbe type, std::string *outnames)
+{
+    switch(type)
+    {
+        case DevProbe::Playback:
+            /* Includes null char. */
+            outnames->append(pwireDevice, sizeof(pwireDevice));
+            break;
+
+        case DevProbe::Capture:
+            /* Includes null char. */
+            outnames->append(pwireInput, sizeof(pwireInput));
+            break;
+    }
+}
+
+BackendPtr PipeWireBackendFactory::createBackend(ALCdevice *device, BackendType type)
+{
+    if(type == BackendType::Playback)
+        return BackendPtr{new PipeWirePlayback{device}};
+    if(type == BackendType::Capture)
+        return BackendPtr{new PipeWireCapture{device}};
+    return nullptr;
+}
+
+BackendFactory &PipeWireBackendFactory::getFactory()
+{
+    static PipeWireBackendFactory factory{};
+    return factory;
+}
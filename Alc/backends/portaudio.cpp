@@ -112,8 +112,11 @@ int PortPlayback::writeCallbackC(const void *inputBuffer, void *outputBuffer,
 
 int PortPlayback::writeCallback(const void* UNUSED(inputBuffer), void *outputBuffer,
     unsigned long framesPerBuffer, const PaStreamCallbackTimeInfo* UNUSED(timeInfo),
-    const PaStreamCallbackFlags UNUSED(statusFlags))
+    const PaStreamCallbackFlags statusFlags)
 {
+    if((statusFlags&paOutputUnderflow))
+        recordUnderrun();
+    recordWakeup(static_cast<ALuint>(framesPerBuffer));
     lock();
     aluMixData(mDevice, outputBuffer, framesPerBuffer);
     unlock();
@@ -250,6 +253,7 @@ struct PortCapture final : public BackendBase {
     void stop() override;
     ALCenum captureSamples(ALCvoid *buffer, ALCuint samples) override;
     ALCuint availableSamples() override;
+    bool supportsCaptureCallback() override { return true; }
 
     PaStream *mStream{nullptr};
     PaStreamParameters mParams;
@@ -282,6 +286,7 @@ int PortCapture::readCallback(const void *inputBuffer, void *UNUSED(outputBuffer
     const PaStreamCallbackFlags UNUSED(statusFlags))
 {
     mRing->write(inputBuffer, framesPerBuffer);
+    dispatchCapture(mRing.get());
     return 0;
 }
 
@@ -103,9 +103,7 @@ namespace {
     MAGIC(pa_frame_size);                                                     \
     MAGIC(pa_strerror);                                                       \
     MAGIC(pa_path_get_filename);                                              \
-    MAGIC(pa_get_binary_name);                                                \
-    MAGIC(pa_xmalloc);                                                        \
-    MAGIC(pa_xfree);
+    MAGIC(pa_get_binary_name);
 
 void *pulse_handle;
 #define MAKE_FUNC(x) decltype(x) * p##x
@@ -153,7 +151,7 @@ PULSE_FUNCS(MAKE_FUNC)
 #define pa_stream_get_device_name ppa_stream_get_device_name
 #define pa_stream_get_latency ppa_stream_get_latency
 #define pa_stream_set_buffer_attr_callback ppa_stream_set_buffer_attr_callback
-#define pa_stream_begin_write ppa_stream_begin_write*/
+#define pa_stream_begin_write ppa_stream_begin_write
 #define pa_channel_map_init_auto ppa_channel_map_init_auto
 #define pa_channel_map_parse ppa_channel_map_parse
 #define pa_channel_map_snprint ppa_channel_map_snprint
@@ -167,10 +165,8 @@ PULSE_FUNCS(MAKE_FUNC)
 #define pa_stream_get_state ppa_stream_get_state
 #define pa_stream_peek ppa_stream_peek
 #define pa_stream_write ppa_stream_write
-#define pa_xfree ppa_xfree
 #define pa_path_get_filename ppa_path_get_filename
 #define pa_get_binary_name ppa_get_binary_name
-#define pa_xmalloc ppa_xmalloc
 #endif /* IN_IDE_PARSER */
 
 #endif
@@ -428,6 +424,7 @@ void pulse_close(pa_context *context, pa_stream *stream)
         pa_stream_set_state_callback(stream, nullptr, nullptr);
         pa_stream_set_moved_callback(stream, nullptr, nullptr);
         pa_stream_set_write_callback(stream, nullptr, nullptr);
+        pa_stream_set_underflow_callback(stream, nullptr, nullptr);
         pa_stream_set_buffer_attr_callback(stream, nullptr, nullptr);
         pa_stream_disconnect(stream);
         pa_stream_unref(stream);
@@ -654,6 +651,8 @@ struct PulsePlayback final : public BackendBase {
     static void streamWriteCallbackC(pa_stream *stream, size_t nbytes, void *pdata);
     void streamWriteCallback(pa_stream *stream, size_t nbytes);
 
+    static void streamUnderflowCallbackC(pa_stream *stream, void *pdata);
+
     static void sinkInfoCallbackC(pa_context *context, const pa_sink_info *info, int eol, void *pdata);
     void sinkInfoCallback(pa_context *context, const pa_sink_info *info, int eol);
 
@@ -681,6 +680,9 @@ struct PulsePlayback final : public BackendBase {
 
     ALuint mFrameSize{0u};
 
+    /* Mixing buffer for when the server can't provide one to write into. */
+    al::vector<ALubyte> mWriteBuffer;
+
     static constexpr inline const char *CurrentPrefix() noexcept { return "PulsePlayback::"; }
     DEF_NEWDEL(PulsePlayback)
 };
@@ -741,14 +743,45 @@ void PulsePlayback::streamWriteCallbackC(pa_stream *stream, size_t nbytes, void
 
 void PulsePlayback::streamWriteCallback(pa_stream *stream, size_t nbytes)
 {
-    void *buf{pa_xmalloc(nbytes)};
-    aluMixData(mDevice, buf, nbytes/mFrameSize);
+    nbytes -= nbytes%mFrameSize;
+    recordWakeup(static_cast<ALuint>(nbytes/mFrameSize));
+    while(nbytes > 0)
+    {
+        /* Mix directly into the server's buffer when it provides one, which
+         * pa_stream_write then commits without copying.
+         */
+        void *buf{nullptr};
+        size_t todo{nbytes};
+        int ret{pa_stream_begin_write(stream, &buf, &todo)};
+        if(LIKELY(ret == PA_OK && buf && todo >= mFrameSize))
+            todo = minz(todo, nbytes);
+        else
+        {
+            /* Otherwise mix into our own buffer, which pa_stream_write copies
+             * from since there's no free callback.
+             */
+            if(UNLIKELY(mWriteBuffer.size() < nbytes))
+                mWriteBuffer.resize(nbytes);
+            buf = mWriteBuffer.data();
+            todo = nbytes;
+        }
+        todo -= todo%mFrameSize;
+
+        aluMixData(mDevice, buf, static_cast<ALsizei>(todo/mFrameSize));
 
-    int ret{pa_stream_write(stream, buf, nbytes, pa_xfree, 0, PA_SEEK_RELATIVE)};
-    if(UNLIKELY(ret != PA_OK))
-        ERR("Failed to write to stream: %d, %s\n", ret, pa_strerror(ret));
+        ret = pa_stream_write(stream, buf, todo, nullptr, 0, PA_SEEK_RELATIVE);
+        if(UNLIKELY(ret != PA_OK))
+        {
+            ERR("Failed to write to stream: %d, %s\n", ret, pa_strerror(ret));
+            break;
+        }
+        nbytes -= todo;
+    }
 }
 
+void PulsePlayback::streamUnderflowCallbackC(pa_stream* UNUSED(stream), void *pdata)
+{ static_cast<PulsePlayback*>(pdata)->recordUnderrun(); }
+
 void PulsePlayback::sinkInfoCallbackC(pa_context *context, const pa_sink_info *info, int eol, void *pdata)
 { static_cast<PulsePlayback*>(pdata)->sinkInfoCallback(context, info, eol); }
 
@@ -887,6 +920,7 @@ ALCboolean PulsePlayback::reset()
         pa_stream_set_state_callback(mStream, nullptr, nullptr);
         pa_stream_set_moved_callback(mStream, nullptr, nullptr);
         pa_stream_set_write_callback(mStream, nullptr, nullptr);
+        pa_stream_set_underflow_callback(mStream, nullptr, nullptr);
         pa_stream_set_buffer_attr_callback(mStream, nullptr, nullptr);
         pa_stream_disconnect(mStream);
         pa_stream_unref(mStream);
@@ -1016,6 +1050,11 @@ ALCboolean PulsePlayback::reset()
     mDevice->BufferSize = mAttr.tlength / mFrameSize;
     mDevice->UpdateSize = mAttr.minreq / mFrameSize;
 
+    /* Size the fallback mixing buffer for the whole target length up front,
+     * so writing doesn't need to allocate.
+     */
+    mWriteBuffer.resize(mAttr.tlength);
+
     /* HACK: prebuf should be 0 as that's what we set it to. However on some
      * systems it comes back as non-0, so we have to make sure the device will
      * write enough audio to start playback. The lack of manual start control
@@ -1038,6 +1077,7 @@ ALCboolean PulsePlayback::start()
     std::unique_lock<std::mutex> plock{pulse_lock};
 
     pa_stream_set_write_callback(mStream, &PulsePlayback::streamWriteCallbackC, this);
+    pa_stream_set_underflow_callback(mStream, &PulsePlayback::streamUnderflowCallbackC, this);
     pa_operation *op{pa_stream_cork(mStream, 0, stream_success_callback, nullptr)};
     wait_for_operation(op, plock);
 
@@ -1049,6 +1089,7 @@ void PulsePlayback::stop()
     std::unique_lock<std::mutex> plock{pulse_lock};
 
     pa_stream_set_write_callback(mStream, nullptr, nullptr);
+    pa_stream_set_underflow_callback(mStream, nullptr, nullptr);
     pa_operation *op{pa_stream_cork(mStream, 1, stream_success_callback, nullptr)};
     wait_for_operation(op, plock);
 }
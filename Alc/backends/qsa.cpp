@@ -234,6 +234,7 @@ FORCE_ALIGN static int qsa_proc_playback(void *ptr)
 
         len = data->size;
         write_ptr = static_cast<char*>(data->buffer);
+        self->recordWakeup(static_cast<ALuint>(len/frame_size));
         aluMixData(device, write_ptr, len/frame_size);
         while(len>0 && !data->mKillNow.load(std::memory_order_acquire))
         {
@@ -252,6 +253,8 @@ FORCE_ALIGN static int qsa_proc_playback(void *ptr)
                 if(status.status == SND_PCM_STATUS_UNDERRUN ||
                    status.status == SND_PCM_STATUS_READY)
                 {
+                    if(status.status == SND_PCM_STATUS_UNDERRUN)
+                        self->recordUnderrun();
                     if(snd_pcm_plugin_prepare(data->pcmHandle, SND_PCM_CHANNEL_PLAYBACK) < 0)
                     {
                         aluHandleDisconnect(device, "Playback recovery failed");
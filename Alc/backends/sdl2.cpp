@@ -82,6 +82,7 @@ void Sdl2Backend::audioCallbackC(void *ptr, Uint8 *stream, int len)
 void Sdl2Backend::audioCallback(Uint8 *stream, int len)
 {
     assert((len % mFrameSize) == 0);
+    recordWakeup(static_cast<ALuint>(len / mFrameSize));
     aluMixData(mDevice, stream, len / mFrameSize);
 }
 
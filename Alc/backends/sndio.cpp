@@ -85,6 +85,7 @@ int SndioPlayback::mixerProc()
         auto WritePtr = static_cast<ALubyte*>(mBuffer.data());
         size_t len{mBuffer.size()};
 
+        recordWakeup(static_cast<ALuint>(len/frameSize));
         lock();
         aluMixData(mDevice, WritePtr, len/frameSize);
         unlock();
@@ -255,6 +256,7 @@ struct SndioCapture final : public BackendBase {
     void stop() override;
     ALCenum captureSamples(void *buffer, ALCuint samples) override;
     ALCuint availableSamples() override;
+    bool supportsCaptureCallback() override { return true; }
 
     sio_hdl *mSndHandle{nullptr};
 
@@ -315,6 +317,7 @@ int SndioCapture::recordProc()
             total += got;
         }
         mRing->writeAdvance(total / frameSize);
+        dispatchCapture(mRing.get());
     }
 
     return 0;
@@ -119,6 +119,7 @@ int SolarisBackend::mixerProc()
 
         ALubyte *write_ptr{mBuffer.data()};
         size_t to_write{mBuffer.size()};
+        recordWakeup(static_cast<ALuint>(to_write/frame_size));
         aluMixData(mDevice, write_ptr, to_write/frame_size);
         while(to_write > 0 && !mKillNow.load(std::memory_order_acquire))
         {
@@ -53,8 +53,10 @@
 
 #include "alMain.h"
 #include "alu.h"
+#include "alconfig.h"
 #include "ringbuffer.h"
 #include "compat.h"
+#include "altrace.h"
 #include "converter.h"
 
 
@@ -514,6 +516,8 @@ struct WasapiPlayback final : public BackendBase, WasapiProxy {
 
     ALCboolean reset() override;
     HRESULT resetProxy() override;
+    HRESULT initExclusive(WAVEFORMATEXTENSIBLE *format, REFERENCE_TIME per_time);
+    UINT32 initLowLatency(WAVEFORMATEXTENSIBLE *format);
     ALCboolean start() override;
     HRESULT startProxy() override;
     void stop() override;
@@ -528,6 +532,11 @@ struct WasapiPlayback final : public BackendBase, WasapiProxy {
     IAudioRenderClient *mRender{nullptr};
     HANDLE mNotifyEvent{nullptr};
 
+    /* Set when the client was initialized in exclusive mode, mixing directly
+     * in the device's format.
+     */
+    bool mExclusive{false};
+
     std::atomic<UINT32> mPadding{0u};
 
     std::atomic<bool> mKillNow{true};
@@ -562,7 +571,38 @@ FORCE_ALIGN int WasapiPlayback::mixerProc()
 
     const ALuint update_size{mDevice->UpdateSize};
     const UINT32 buffer_len{mDevice->BufferSize};
-    while(!mKillNow.load(std::memory_order_relaxed))
+    while(mExclusive && !mKillNow.load(std::memory_order_relaxed))
+    {
+        /* In exclusive mode, the device signals when it's done with one of
+         * its two period buffers, and the whole period gets refilled.
+         */
+        DWORD res{AL_TRACE_EXPR("WaitForSingleObjectEx",
+            WaitForSingleObjectEx(mNotifyEvent, 2000, FALSE))};
+        if(res != WAIT_OBJECT_0)
+        {
+            ERR("WaitForSingleObjectEx error: 0x%lx\n", res);
+            continue;
+        }
+
+        BYTE *buffer;
+        hr = mRender->GetBuffer(update_size, &buffer);
+        if(SUCCEEDED(hr))
+        {
+            recordWakeup(update_size);
+            lock();
+            aluMixData(mDevice, buffer, update_size);
+            mPadding.store(buffer_len, std::memory_order_relaxed);
+            unlock();
+            hr = mRender->ReleaseBuffer(update_size, 0);
+        }
+        if(FAILED(hr))
+        {
+            ERR("Failed to buffer data: 0x%08lx\n", hr);
+            aluHandleDisconnect(mDevice, "Failed to send playback samples: 0x%08lx", hr);
+            break;
+        }
+    }
+    while(!mExclusive && !mKillNow.load(std::memory_order_relaxed))
     {
         UINT32 written;
         hr = mClient->GetCurrentPadding(&written);
@@ -577,7 +617,8 @@ FORCE_ALIGN int WasapiPlayback::mixerProc()
         ALuint len{buffer_len - written};
         if(len < update_size)
         {
-            DWORD res{WaitForSingleObjectEx(mNotifyEvent, 2000, FALSE)};
+            DWORD res{AL_TRACE_EXPR("WaitForSingleObjectEx",
+                WaitForSingleObjectEx(mNotifyEvent, 2000, FALSE))};
             if(res != WAIT_OBJECT_0)
                 ERR("WaitForSingleObjectEx error: 0x%lx\n", res);
             continue;
@@ -587,6 +628,7 @@ FORCE_ALIGN int WasapiPlayback::mixerProc()
         hr = mRender->GetBuffer(len, &buffer);
         if(SUCCEEDED(hr))
         {
+            recordWakeup(len);
             lock();
             aluMixData(mDevice, buffer, len);
             mPadding.store(written + len, std::memory_order_relaxed);
@@ -886,11 +928,29 @@ HRESULT WasapiPlayback::resetProxy()
     OutputType.Format.nAvgBytesPerSec = OutputType.Format.nSamplesPerSec *
                                         OutputType.Format.nBlockAlign;
 
-    hr = mClient->IsFormatSupported(AUDCLNT_SHAREMODE_SHARED, &OutputType.Format, &wfx);
-    if(FAILED(hr))
+    /* Exclusive mode needs the exact format to be supported by the device,
+     * otherwise fall back to shared mode.
+     */
+    mExclusive = false;
+    if(GetConfigValueBool(mDevice->DeviceName.c_str(), "wasapi", "exclusive-mode", 0))
     {
-        ERR("Failed to check format support: 0x%08lx\n", hr);
-        hr = mClient->GetMixFormat(&wfx);
+        hr = mClient->IsFormatSupported(AUDCLNT_SHAREMODE_EXCLUSIVE, &OutputType.Format,
+            nullptr);
+        if(hr == S_OK)
+            mExclusive = true;
+        else
+            WARN("Format not supported in exclusive mode (0x%08lx), using shared mode\n", hr);
+    }
+
+    hr = S_OK;
+    if(!mExclusive)
+    {
+        hr = mClient->IsFormatSupported(AUDCLNT_SHAREMODE_SHARED, &OutputType.Format, &wfx);
+        if(FAILED(hr))
+        {
+            ERR("Failed to check format support: 0x%08lx\n", hr);
+            hr = mClient->GetMixFormat(&wfx);
+        }
     }
     if(FAILED(hr))
     {
@@ -967,44 +1027,190 @@ HRESULT WasapiPlayback::resetProxy()
 
     SetDefaultWFXChannelOrder(mDevice);
 
-    hr = mClient->Initialize(AUDCLNT_SHAREMODE_SHARED, AUDCLNT_STREAMFLAGS_EVENTCALLBACK, buf_time,
-        0, &OutputType.Format, nullptr);
+    if(mExclusive)
+        hr = initExclusive(&OutputType, per_time);
+    else
+    {
+        UINT32 period_len{0u};
+        if(GetConfigValueBool(mDevice->DeviceName.c_str(), "wasapi", "low-latency", 0))
+            period_len = initLowLatency(&OutputType);
+        if(period_len > 0)
+        {
+            /* The engine processes the stream every period, so that's the
+             * update size.
+             */
+            UINT32 buffer_len;
+            hr = mClient->GetBufferSize(&buffer_len);
+            if(FAILED(hr))
+            {
+                ERR("Failed to get audio buffer info: 0x%08lx\n", hr);
+                return hr;
+            }
+            mDevice->UpdateSize = minu(period_len, buffer_len/2);
+            mDevice->BufferSize = buffer_len;
+        }
+        else
+        {
+            hr = mClient->Initialize(AUDCLNT_SHAREMODE_SHARED, AUDCLNT_STREAMFLAGS_EVENTCALLBACK,
+                buf_time, 0, &OutputType.Format, nullptr);
+            if(FAILED(hr))
+            {
+                ERR("Failed to initialize audio client: 0x%08lx\n", hr);
+                return hr;
+            }
+
+            UINT32 buffer_len, min_len;
+            REFERENCE_TIME min_per;
+            hr = mClient->GetDevicePeriod(&min_per, nullptr);
+            if(SUCCEEDED(hr))
+                hr = mClient->GetBufferSize(&buffer_len);
+            if(FAILED(hr))
+            {
+                ERR("Failed to get audio buffer info: 0x%08lx\n", hr);
+                return hr;
+            }
+
+            /* Find the nearest multiple of the period size to the update size */
+            if(min_per < per_time)
+                min_per *= maxu((per_time + min_per/2) / min_per, 1u);
+            min_len = (UINT32)ScaleCeil(min_per, mDevice->Frequency, REFTIME_PER_SEC);
+            min_len = minu(min_len, buffer_len/2);
+
+            mDevice->UpdateSize = min_len;
+            mDevice->BufferSize = buffer_len;
+        }
+    }
+    if(FAILED(hr))
+        return hr;
+
+    hr = mClient->SetEventHandle(mNotifyEvent);
     if(FAILED(hr))
     {
-        ERR("Failed to initialize audio client: 0x%08lx\n", hr);
+        ERR("Failed to set event handle: 0x%08lx\n", hr);
         return hr;
     }
 
-    UINT32 buffer_len, min_len;
+    return hr;
+}
+
+
+/* Initializes the client in exclusive mode, with a period as close to the
+ * requested update size as the device allows. Samples are mixed straight into
+ * the device's buffer in its own format, bypassing the audio engine.
+ */
+HRESULT WasapiPlayback::initExclusive(WAVEFORMATEXTENSIBLE *format, REFERENCE_TIME per_time)
+{
     REFERENCE_TIME min_per;
-    hr = mClient->GetDevicePeriod(&min_per, nullptr);
-    if(SUCCEEDED(hr))
-        hr = mClient->GetBufferSize(&buffer_len);
+    HRESULT hr{mClient->GetDevicePeriod(nullptr, &min_per)};
     if(FAILED(hr))
     {
-        ERR("Failed to get audio buffer info: 0x%08lx\n", hr);
+        ERR("Failed to get device period: 0x%08lx\n", hr);
         return hr;
     }
+    REFERENCE_TIME period{maxi64(per_time, min_per)};
 
-    /* Find the nearest multiple of the period size to the update size */
-    if(min_per < per_time)
-        min_per *= maxu((per_time + min_per/2) / min_per, 1u);
-    min_len = (UINT32)ScaleCeil(min_per, mDevice->Frequency, REFTIME_PER_SEC);
-    min_len = minu(min_len, buffer_len/2);
+    hr = mClient->Initialize(AUDCLNT_SHAREMODE_EXCLUSIVE, AUDCLNT_STREAMFLAGS_EVENTCALLBACK,
+        period, period, &format->Format, nullptr);
+    if(hr == AUDCLNT_E_BUFFER_SIZE_NOT_ALIGNED)
+    {
+        /* The device needs an aligned buffer size. Get the size it would use,
+         * and retry with a new client since the failed one can't be reused.
+         */
+        UINT32 aligned_len;
+        hr = mClient->GetBufferSize(&aligned_len);
+        if(FAILED(hr))
+        {
+            ERR("Failed to get aligned buffer size: 0x%08lx\n", hr);
+            return hr;
+        }
+        period = ScaleCeil(aligned_len, REFTIME_PER_SEC, format->Format.nSamplesPerSec);
+        TRACE("Retrying with aligned buffer size %u\n", aligned_len);
 
-    mDevice->UpdateSize = min_len;
-    mDevice->BufferSize = buffer_len;
+        mClient->Release();
+        mClient = nullptr;
 
-    hr = mClient->SetEventHandle(mNotifyEvent);
+        void *ptr;
+        hr = mMMDev->Activate(IID_IAudioClient, CLSCTX_INPROC_SERVER, nullptr, &ptr);
+        if(FAILED(hr))
+        {
+            ERR("Failed to reactivate audio client: 0x%08lx\n", hr);
+            return hr;
+        }
+        mClient = static_cast<IAudioClient*>(ptr);
+
+        hr = mClient->Initialize(AUDCLNT_SHAREMODE_EXCLUSIVE, AUDCLNT_STREAMFLAGS_EVENTCALLBACK,
+            period, period, &format->Format, nullptr);
+    }
     if(FAILED(hr))
     {
-        ERR("Failed to set event handle: 0x%08lx\n", hr);
+        ERR("Failed to initialize exclusive audio client: 0x%08lx\n", hr);
         return hr;
     }
 
+    /* The buffer is one period, which the device double-buffers. */
+    UINT32 buffer_len;
+    hr = mClient->GetBufferSize(&buffer_len);
+    if(FAILED(hr))
+    {
+        ERR("Failed to get audio buffer info: 0x%08lx\n", hr);
+        return hr;
+    }
+    mDevice->UpdateSize = buffer_len;
+    mDevice->BufferSize = buffer_len * 2;
+    TRACE("Exclusive mode period: %u samples\n", buffer_len);
+
     return hr;
 }
 
+/* Attempts to initialize the client as a shared stream with a period smaller
+ * than the engine's default, using IAudioClient3. The period is the nearest
+ * multiple of the engine's fundamental period to the requested update size,
+ * clamped to what the engine supports. Returns the period length in samples,
+ * or 0 if the client wasn't initialized.
+ */
+UINT32 WasapiPlayback::initLowLatency(WAVEFORMATEXTENSIBLE *format)
+{
+#ifdef __IAudioClient3_INTERFACE_DEFINED__
+    void *ptr;
+    HRESULT hr{mClient->QueryInterface(IID_IAudioClient3, &ptr)};
+    if(FAILED(hr))
+    {
+        WARN("IAudioClient3 not available: 0x%08lx\n", hr);
+        return 0;
+    }
+    auto client3 = static_cast<IAudioClient3*>(ptr);
+
+    UINT32 default_len, fundamental_len, min_len, max_len;
+    hr = client3->GetSharedModeEnginePeriod(&format->Format, &default_len, &fundamental_len,
+        &min_len, &max_len);
+    if(FAILED(hr) || fundamental_len == 0)
+    {
+        WARN("Failed to get shared mode engine period: 0x%08lx\n", hr);
+        client3->Release();
+        return 0;
+    }
+
+    UINT32 period_len{(mDevice->UpdateSize + fundamental_len/2) / fundamental_len};
+    period_len = clampu(maxu(period_len, 1u) * fundamental_len, min_len, max_len);
+    TRACE("Engine periods: default %u, fundamental %u, min %u, max %u; using %u\n",
+        default_len, fundamental_len, min_len, max_len, period_len);
+
+    hr = client3->InitializeSharedAudioStream(AUDCLNT_STREAMFLAGS_EVENTCALLBACK, period_len,
+        &format->Format, nullptr);
+    client3->Release();
+    if(FAILED(hr))
+    {
+        WARN("Failed to initialize low-latency shared stream: 0x%08lx\n", hr);
+        return 0;
+    }
+    return period_len;
+#else
+    (void)format;
+    WARN("Low-latency shared mode not supported in this build\n");
+    return 0;
+#endif
+}
+
 
 ALCboolean WasapiPlayback::start()
 {
@@ -1096,6 +1302,7 @@ struct WasapiCapture final : public BackendBase, WasapiProxy {
 
     ALCenum captureSamples(void *buffer, ALCuint samples) override;
     ALCuint availableSamples() override;
+    bool supportsCaptureCallback() override { return true; }
 
     std::wstring mDevId;
 
@@ -1137,7 +1344,6 @@ FORCE_ALIGN int WasapiCapture::recordProc()
 
     althrd_setname(RECORD_THREAD_NAME);
 
-    al::vector<float> samples;
     while(!mKillNow.load(std::memory_order_relaxed))
     {
         UINT32 avail;
@@ -1155,46 +1361,11 @@ FORCE_ALIGN int WasapiCapture::recordProc()
                 ERR("Failed to get capture buffer: 0x%08lx\n", hr);
             else
             {
-                if(mChannelConv)
-                {
-                    samples.resize(numsamples*2);
-                    mChannelConv->convert(rdata, samples.data(), numsamples);
-                    rdata = reinterpret_cast<BYTE*>(samples.data());
-                }
-
-                auto data = mRing->getWriteVector();
-
-                size_t dstframes;
-                if(mSampleConv)
-                {
-                    const ALvoid *srcdata{rdata};
-                    auto srcframes = static_cast<ALsizei>(numsamples);
-
-                    dstframes = mSampleConv->convert(&srcdata, &srcframes, data.first.buf,
-                        static_cast<ALsizei>(minz(data.first.len, INT_MAX)));
-                    if(srcframes > 0 && dstframes == data.first.len && data.second.len > 0)
-                    {
-                        /* If some source samples remain, all of the first dest
-                         * block was filled, and there's space in the second
-                         * dest block, do another run for the second block.
-                         */
-                        dstframes += mSampleConv->convert(&srcdata, &srcframes, data.second.buf,
-                            static_cast<ALsizei>(minz(data.second.len, INT_MAX)));
-                    }
-                }
-                else
-                {
-                    const auto framesize = static_cast<ALuint>(mDevice->frameSizeFromFmt());
-                    size_t len1 = minz(data.first.len, numsamples);
-                    size_t len2 = minz(data.second.len, numsamples-len1);
-
-                    memcpy(data.first.buf, rdata, len1*framesize);
-                    if(len2 > 0)
-                        memcpy(data.second.buf, rdata+len1*framesize, len2*framesize);
-                    dstframes = len1 + len2;
-                }
-
-                mRing->writeAdvance(dstframes);
+                /* Store the device's samples as-is. Any conversion is done
+                 * when the app reads them, straight into its buffer.
+                 */
+                mRing->write(rdata, numsamples);
+                dispatchCapture(mRing.get(), mChannelConv.get(), mSampleConv.get());
 
                 hr = mCapture->ReleaseBuffer(numsamples);
                 if(FAILED(hr)) ERR("Failed to release capture buffer: 0x%08lx\n", hr);
@@ -1207,7 +1378,8 @@ FORCE_ALIGN int WasapiCapture::recordProc()
             break;
         }
 
-        DWORD res{WaitForSingleObjectEx(mNotifyEvent, 2000, FALSE)};
+        DWORD res{AL_TRACE_EXPR("WaitForSingleObjectEx",
+            WaitForSingleObjectEx(mNotifyEvent, 2000, FALSE))};
         if(res != WAIT_OBJECT_0)
             ERR("WaitForSingleObjectEx error: 0x%lx\n", res);
     }
@@ -1481,7 +1653,32 @@ HRESULT WasapiCapture::resetProxy()
         return E_FAIL;
     }
 
-    if(mDevice->FmtChans == DevFmtMono && OutputType.Format.nChannels == 2)
+    /* A mono/stereo conversion outputs float. When the sample type or rate
+     * needs converting too, the sample converter does the channel conversion
+     * in the same pass instead.
+     */
+    const auto srcChans = static_cast<ALsizei>(OutputType.Format.nChannels);
+    const bool chanconv{mDevice->channelsFromFmt() != srcChans};
+    if(mDevice->Frequency != OutputType.Format.nSamplesPerSec ||
+       mDevice->FmtType != (chanconv ? DevFmtFloat : srcType))
+    {
+        mSampleConv = CreateSampleConverter(srcType, mDevice->FmtType, srcChans,
+            mDevice->channelsFromFmt(), OutputType.Format.nSamplesPerSec, mDevice->Frequency,
+            BSinc24Resampler);
+        if(!mSampleConv)
+        {
+            ERR("Failed to create converter for %s format, dst: %s %uhz, src: %d channel%s %s %luhz\n",
+                DevFmtChannelsString(mDevice->FmtChans), DevFmtTypeString(mDevice->FmtType),
+                mDevice->Frequency, srcChans, (srcChans==1)?"":"s", DevFmtTypeString(srcType),
+                OutputType.Format.nSamplesPerSec);
+            return E_FAIL;
+        }
+        TRACE("Created converter for %s format, dst: %s %uhz, src: %d channel%s %s %luhz\n",
+              DevFmtChannelsString(mDevice->FmtChans), DevFmtTypeString(mDevice->FmtType),
+              mDevice->Frequency, srcChans, (srcChans==1)?"":"s", DevFmtTypeString(srcType),
+              OutputType.Format.nSamplesPerSec);
+    }
+    else if(mDevice->FmtChans == DevFmtMono && srcChans == 2)
     {
         mChannelConv = CreateChannelConverter(srcType, DevFmtStereo, mDevice->FmtChans);
         if(!mChannelConv)
@@ -1490,12 +1687,8 @@ HRESULT WasapiCapture::resetProxy()
             return E_FAIL;
         }
         TRACE("Created %s stereo-to-mono converter\n", DevFmtTypeString(srcType));
-        /* The channel converter always outputs float, so change the input type
-         * for the resampler/type-converter.
-         */
-        srcType = DevFmtFloat;
     }
-    else if(mDevice->FmtChans == DevFmtStereo && OutputType.Format.nChannels == 1)
+    else if(mDevice->FmtChans == DevFmtStereo && srcChans == 1)
     {
         mChannelConv = CreateChannelConverter(srcType, DevFmtMono, mDevice->FmtChans);
         if(!mChannelConv)
@@ -1504,23 +1697,6 @@ HRESULT WasapiCapture::resetProxy()
             return E_FAIL;
         }
         TRACE("Created %s mono-to-stereo converter\n", DevFmtTypeString(srcType));
-        srcType = DevFmtFloat;
-    }
-
-    if(mDevice->Frequency != OutputType.Format.nSamplesPerSec || mDevice->FmtType != srcType)
-    {
-        mSampleConv = CreateSampleConverter(srcType, mDevice->FmtType, mDevice->channelsFromFmt(),
-            OutputType.Format.nSamplesPerSec, mDevice->Frequency, BSinc24Resampler);
-        if(!mSampleConv)
-        {
-            ERR("Failed to create converter for %s format, dst: %s %uhz, src: %s %luhz\n",
-                DevFmtChannelsString(mDevice->FmtChans), DevFmtTypeString(mDevice->FmtType),
-                mDevice->Frequency, DevFmtTypeString(srcType), OutputType.Format.nSamplesPerSec);
-            return E_FAIL;
-        }
-        TRACE("Created converter for %s format, dst: %s %uhz, src: %s %luhz\n",
-              DevFmtChannelsString(mDevice->FmtChans), DevFmtTypeString(mDevice->FmtType),
-              mDevice->Frequency, DevFmtTypeString(srcType), OutputType.Format.nSamplesPerSec);
     }
 
     hr = mClient->Initialize(AUDCLNT_SHAREMODE_SHARED, AUDCLNT_STREAMFLAGS_EVENTCALLBACK, buf_time,
@@ -1545,8 +1721,10 @@ HRESULT WasapiCapture::resetProxy()
         REFTIME_PER_SEC));
     mDevice->BufferSize = buffer_len;
 
-    buffer_len = maxu(mDevice->BufferSize, buffer_len);
-    mRing = CreateRingBuffer(buffer_len, mDevice->frameSizeFromFmt(), false);
+    /* The ring holds the device's own format, which gets converted as it's
+     * read.
+     */
+    mRing = CreateRingBuffer(buffer_len, OutputType.Format.nBlockAlign, false);
     if(!mRing)
     {
         ERR("Failed to allocate capture ring buffer\n");
@@ -1627,11 +1805,17 @@ void WasapiCapture::stopProxy()
 
 
 ALCuint WasapiCapture::availableSamples()
-{ return (ALCuint)mRing->readSpace(); }
+{
+    if(!mSampleConv)
+        return static_cast<ALCuint>(mRing->readSpace());
+    return static_cast<ALCuint>(mSampleConv->availableOut(static_cast<ALsizei>(
+        mRing->readSpace())));
+}
 
 ALCenum WasapiCapture::captureSamples(void *buffer, ALCuint samples)
 {
-    mRing->read(buffer, samples);
+    ConvertCaptureRing(mRing.get(), mChannelConv.get(), mSampleConv.get(), buffer,
+        static_cast<ALsizei>(samples));
     return ALC_NO_ERROR;
 }
 
@@ -31,11 +31,14 @@
 #include <thread>
 #include <vector>
 #include <functional>
+#include <cinttypes>
+#include <cstring>
 
 #include "alMain.h"
 #include "alu.h"
 #include "alconfig.h"
 #include "compat.h"
+#include "threads.h"
 
 
 namespace {
@@ -65,6 +68,32 @@ constexpr ALubyte SUBTYPE_BFORMAT_FLOAT[]{
     0xca, 0x00, 0x00, 0x00
 };
 
+const ALubyte GUID_W64_RIFF[]{
+    'r', 'i', 'f', 'f', 0x2e, 0x91, 0xcf, 0x11, 0xa5, 0xd6, 0x28, 0xdb, 0x04,
+    0xc1, 0x00, 0x00
+};
+const ALubyte GUID_W64_WAVE[]{
+    'w', 'a', 'v', 'e', 0xf3, 0xac, 0xd3, 0x11, 0x8c, 0xd1, 0x00, 0xc0, 0x4f,
+    0x8e, 0xdb, 0x8a
+};
+const ALubyte GUID_W64_FMT[]{
+    'f', 'm', 't', ' ', 0xf3, 0xac, 0xd3, 0x11, 0x8c, 0xd1, 0x00, 0xc0, 0x4f,
+    0x8e, 0xdb, 0x8a
+};
+const ALubyte GUID_W64_DATA[]{
+    'd', 'a', 't', 'a', 0xf3, 0xac, 0xd3, 0x11, 0x8c, 0xd1, 0x00, 0xc0, 0x4f,
+    0x8e, 0xdb, 0x8a
+};
+
+/* CAF channel layout tag for ACN/SN3D ambisonics (AmbiX), with the channel
+ * count in the low 16 bits.
+ */
+constexpr ALuint CAF_LAYOUT_HOA_ACN_SN3D{190u << 16};
+/* CAF channel layout tag for using the channel bitmap, which uses the same
+ * speaker bits as WAVE_FORMAT_EXTENSIBLE's channel mask.
+ */
+constexpr ALuint CAF_LAYOUT_USE_BITMAP{1u << 16};
+
 void fwrite16le(ALushort val, FILE *f)
 {
     ALubyte data[2]{ static_cast<ALubyte>(val&0xff), static_cast<ALubyte>((val>>8)&0xff) };
@@ -78,12 +107,90 @@ void fwrite32le(ALuint val, FILE *f)
     fwrite(data, 1, 4, f);
 }
 
+void fwrite64le(uint64_t val, FILE *f)
+{
+    fwrite32le(static_cast<ALuint>(val&0xffffffff), f);
+    fwrite32le(static_cast<ALuint>(val>>32), f);
+}
+
+void fwrite16be(ALushort val, FILE *f)
+{
+    ALubyte data[2]{ static_cast<ALubyte>((val>>8)&0xff), static_cast<ALubyte>(val&0xff) };
+    fwrite(data, 1, 2, f);
+}
+
+void fwrite32be(ALuint val, FILE *f)
+{
+    ALubyte data[4]{ static_cast<ALubyte>((val>>24)&0xff), static_cast<ALubyte>((val>>16)&0xff),
+        static_cast<ALubyte>((val>>8)&0xff), static_cast<ALubyte>(val&0xff) };
+    fwrite(data, 1, 4, f);
+}
+
+void fwrite64be(uint64_t val, FILE *f)
+{
+    fwrite32be(static_cast<ALuint>(val>>32), f);
+    fwrite32be(static_cast<ALuint>(val&0xffffffff), f);
+}
+
+/* Writes the 40-byte WAVE_FORMAT_EXTENSIBLE structure used by both the RIFF
+ * and W64 'fmt ' chunks.
+ */
+void fwriteWaveFormatExt(FILE *f, ALuint frequency, ALuint channels, ALuint bytes,
+    ALuint chanmask, const ALubyte *subtype)
+{
+    // 16-bit val, format type id (extensible: 0xFFFE)
+    fwrite16le(0xFFFE, f);
+    // 16-bit val, channel count
+    fwrite16le(channels, f);
+    // 32-bit val, frequency
+    fwrite32le(frequency, f);
+    // 32-bit val, bytes per second
+    fwrite32le(frequency * channels * bytes, f);
+    // 16-bit val, frame size
+    fwrite16le(channels * bytes, f);
+    // 16-bit val, bits per sample
+    fwrite16le(bytes * 8, f);
+    // 16-bit val, extra byte count
+    fwrite16le(22, f);
+    // 16-bit val, valid bits per sample
+    fwrite16le(bytes * 8, f);
+    // 32-bit val, channel mask
+    fwrite32le(chanmask, f);
+    // 16 byte GUID, sub-type format
+    size_t val{fwrite(subtype, 1, 16, f)};
+    (void)val;
+}
+
+bool HasExtension(const char *fname, const char *ext)
+{
+    const size_t namelen{strlen(fname)};
+    const size_t extlen{strlen(ext)};
+    return namelen > extlen && strcasecmp(fname+namelen-extlen, ext) == 0;
+}
+
+
+enum class FileFormat {
+    Wave,  /* RIFF WAVE, limited to 4GB */
+    Wave64,/* Sony Wave64, 64-bit chunk sizes */
+    Caf    /* Apple Core Audio Format, 64-bit chunk sizes */
+};
 
 struct WaveBackend final : public BackendBase {
     WaveBackend(ALCdevice *device) noexcept : BackendBase{device} { }
     ~WaveBackend() override;
 
     int mixerProc();
+    int offlineProc();
+    int writerProc();
+
+    void renderSamples(ALbyte *buffer, ALsizei frames);
+    bool writeSamples(const ALbyte *buffer, size_t bytes);
+    ALbyte *getBuffer();
+    bool commitBuffer();
+
+    void writeWaveHeader(ALuint channels, ALuint bytes, ALuint chanmask, const ALubyte *subtype);
+    void writeWave64Header(ALuint channels, ALuint bytes, ALuint chanmask, const ALubyte *subtype);
+    void writeCafHeader(ALuint channels, ALuint bytes, ALuint layoutTag, ALuint chanmask);
 
     ALCenum open(const ALCchar *name) override;
     ALCboolean reset() override;
@@ -92,8 +199,25 @@ struct WaveBackend final : public BackendBase {
 
     FILE *mFile{nullptr};
     long mDataStart{-1};
-
-    al::vector<ALbyte> mBuffer;
+    uint64_t mDataSize{0};
+
+    FileFormat mFormat{FileFormat::Wave};
+    bool mRealtime{true};
+    bool mAsyncWrite{false};
+
+    /* The number of sample frames mixed and written at a time. */
+    ALsizei mChunkSize{0};
+
+    /* Two buffers are used when writing asynchronously, so one can be mixed
+     * while the other is being written.
+     */
+    al::vector<ALbyte> mBuffer[2];
+    size_t mMixIndex{0};
+    std::atomic<ALuint> mQueued{0u};
+    std::atomic<bool> mWriteFailed{false};
+    al::semaphore mFreeSem{2};
+    al::semaphore mReadySem;
+    std::thread mWriteThread;
 
     std::atomic<bool> mKillNow{true};
     std::thread mThread;
@@ -109,13 +233,104 @@ WaveBackend::~WaveBackend()
     mFile = nullptr;
 }
 
+void WaveBackend::renderSamples(ALbyte *buffer, ALsizei frames)
+{
+    lock();
+    aluMixData(mDevice, buffer, frames);
+    unlock();
+
+    if(!IS_LITTLE_ENDIAN)
+    {
+        const ALsizei bytesize{mDevice->bytesFromFmt()};
+        const ALsizei len{frames * mDevice->channelsFromFmt()};
+        ALsizei i;
+
+        if(bytesize == 2)
+        {
+            ALushort *samples = reinterpret_cast<ALushort*>(buffer);
+            for(i = 0;i < len;i++)
+            {
+                ALushort samp = samples[i];
+                samples[i] = (samp>>8) | (samp<<8);
+            }
+        }
+        else if(bytesize == 4)
+        {
+            ALuint *samples = reinterpret_cast<ALuint*>(buffer);
+            for(i = 0;i < len;i++)
+            {
+                ALuint samp = samples[i];
+                samples[i] = (samp>>24) | ((samp>>8)&0x0000ff00) |
+                             ((samp<<8)&0x00ff0000) | (samp<<24);
+            }
+        }
+    }
+}
+
+bool WaveBackend::writeSamples(const ALbyte *buffer, size_t bytes)
+{
+    size_t fs{fwrite(buffer, 1, bytes, mFile)};
+    mDataSize += fs;
+    return !ferror(mFile);
+}
+
+/* Gets the next buffer to mix into. When writing asynchronously, this waits
+ * for the writer thread to finish with it.
+ */
+ALbyte *WaveBackend::getBuffer()
+{
+    if(!mAsyncWrite)
+        return mBuffer[0].data();
+    mFreeSem.wait();
+    return mBuffer[mMixIndex].data();
+}
+
+/* Writes out the buffer last returned by getBuffer, or queues it for the
+ * writer thread. Returns false if writing has failed.
+ */
+bool WaveBackend::commitBuffer()
+{
+    if(!mAsyncWrite)
+        return writeSamples(mBuffer[0].data(), mBuffer[0].size());
+
+    mMixIndex ^= 1;
+    mQueued.fetch_add(1u, std::memory_order_acq_rel);
+    mReadySem.post();
+    return !mWriteFailed.load(std::memory_order_acquire);
+}
+
+int WaveBackend::writerProc()
+{
+    size_t idx{0};
+    while(true)
+    {
+        mReadySem.wait();
+        /* A wakeup with nothing queued means the mixer has stopped. */
+        if(mQueued.load(std::memory_order_acquire) == 0)
+            break;
+
+        if(!mWriteFailed.load(std::memory_order_relaxed))
+        {
+            if(!writeSamples(mBuffer[idx].data(), mBuffer[idx].size()))
+                mWriteFailed.store(true, std::memory_order_release);
+        }
+        idx ^= 1;
+
+        mQueued.fetch_sub(1u, std::memory_order_acq_rel);
+        mFreeSem.post();
+    }
+
+    return 0;
+}
+
 int WaveBackend::mixerProc()
 {
     const milliseconds restTime{mDevice->UpdateSize*1000/mDevice->Frequency / 2};
 
     althrd_setname(MIXER_THREAD_NAME);
 
-    const ALsizei frameSize{mDevice->frameSizeFromFmt()};
+    if(!mRealtime)
+        return offlineProc();
 
     int64_t done{0};
     auto start = std::chrono::steady_clock::now();
@@ -132,44 +347,13 @@ int WaveBackend::mixerProc()
             std::this_thread::sleep_for(restTime);
             continue;
         }
+        recordWakeup(static_cast<ALuint>((avail-done) / mDevice->UpdateSize * mDevice->UpdateSize));
         while(avail-done >= mDevice->UpdateSize)
         {
-            lock();
-            aluMixData(mDevice, mBuffer.data(), mDevice->UpdateSize);
-            unlock();
+            renderSamples(getBuffer(), mDevice->UpdateSize);
             done += mDevice->UpdateSize;
 
-            if(!IS_LITTLE_ENDIAN)
-            {
-                const ALsizei bytesize{mDevice->bytesFromFmt()};
-                ALsizei i;
-
-                if(bytesize == 2)
-                {
-                    ALushort *samples = reinterpret_cast<ALushort*>(mBuffer.data());
-                    const auto len = static_cast<ALsizei>(mBuffer.size() / 2);
-                    for(i = 0;i < len;i++)
-                    {
-                        ALushort samp = samples[i];
-                        samples[i] = (samp>>8) | (samp<<8);
-                    }
-                }
-                else if(bytesize == 4)
-                {
-                    ALuint *samples = reinterpret_cast<ALuint*>(mBuffer.data());
-                    const auto len = static_cast<ALsizei>(mBuffer.size() / 4);
-                    for(i = 0;i < len;i++)
-                    {
-                        ALuint samp = samples[i];
-                        samples[i] = (samp>>24) | ((samp>>8)&0x0000ff00) |
-                                     ((samp<<8)&0x00ff0000) | (samp<<24);
-                    }
-                }
-            }
-
-            size_t fs{fwrite(mBuffer.data(), frameSize, mDevice->UpdateSize, mFile)};
-            (void)fs;
-            if(ferror(mFile))
+            if(!commitBuffer())
             {
                 ERR("Error writing to file\n");
                 aluHandleDisconnect(mDevice, "Failed to write playback samples");
@@ -193,6 +377,27 @@ int WaveBackend::mixerProc()
     return 0;
 }
 
+/* Renders as fast as possible without pacing to the wall clock, for offline
+ * (non-interactive) rendering. The device lock is released between chunks so
+ * the app can still update the context.
+ */
+int WaveBackend::offlineProc()
+{
+    while(!mKillNow.load(std::memory_order_acquire) &&
+          mDevice->Connected.load(std::memory_order_acquire))
+    {
+        renderSamples(getBuffer(), mChunkSize);
+        if(!commitBuffer())
+        {
+            ERR("Error writing to file\n");
+            aluHandleDisconnect(mDevice, "Failed to write playback samples");
+            break;
+        }
+    }
+
+    return 0;
+}
+
 ALCenum WaveBackend::open(const ALCchar *name)
 {
     const char *fname{GetConfigValue(nullptr, "wave", "file", "")};
@@ -203,6 +408,26 @@ ALCenum WaveBackend::open(const ALCchar *name)
     else if(strcmp(name, waveDevice) != 0)
         return ALC_INVALID_VALUE;
 
+    mFormat = FileFormat::Wave;
+    if(HasExtension(fname, ".w64"))
+        mFormat = FileFormat::Wave64;
+    else if(HasExtension(fname, ".caf"))
+        mFormat = FileFormat::Caf;
+    if(const char *fmtstr{GetConfigValue(nullptr, "wave", "format", "")})
+    {
+        if(strcasecmp(fmtstr, "wav") == 0)
+            mFormat = FileFormat::Wave;
+        else if(strcasecmp(fmtstr, "w64") == 0)
+            mFormat = FileFormat::Wave64;
+        else if(strcasecmp(fmtstr, "caf") == 0)
+            mFormat = FileFormat::Caf;
+        else if(fmtstr[0])
+            ERR("Unsupported file format: %s\n", fmtstr);
+    }
+
+    mRealtime = GetConfigValueBool(nullptr, "wave", "realtime", 1);
+    mAsyncWrite = GetConfigValueBool(nullptr, "wave", "async-write", 0);
+
 #ifdef _WIN32
     {
         std::wstring wname = utf8_to_wstr(fname);
@@ -222,11 +447,80 @@ ALCenum WaveBackend::open(const ALCchar *name)
     return ALC_NO_ERROR;
 }
 
+void WaveBackend::writeWaveHeader(ALuint channels, ALuint bytes, ALuint chanmask,
+    const ALubyte *subtype)
+{
+    fputs("RIFF", mFile);
+    fwrite32le(0xFFFFFFFF, mFile); // 'RIFF' header len; filled in at close
+
+    fputs("WAVE", mFile);
+
+    fputs("fmt ", mFile);
+    fwrite32le(40, mFile); // 'fmt ' header len; 40 bytes for EXTENSIBLE
+    fwriteWaveFormatExt(mFile, mDevice->Frequency, channels, bytes, chanmask, subtype);
+
+    fputs("data", mFile);
+    fwrite32le(0xFFFFFFFF, mFile); // 'data' header len; filled in at close
+}
+
+void WaveBackend::writeWave64Header(ALuint channels, ALuint bytes, ALuint chanmask,
+    const ALubyte *subtype)
+{
+    /* W64 chunk sizes are 64-bit and include the 24-byte GUID+size header. */
+    fwrite(GUID_W64_RIFF, 1, 16, mFile);
+    fwrite64le(~uint64_t{0}, mFile); // 'riff' chunk len; filled in at close
+    fwrite(GUID_W64_WAVE, 1, 16, mFile);
+
+    fwrite(GUID_W64_FMT, 1, 16, mFile);
+    fwrite64le(24 + 40, mFile);
+    fwriteWaveFormatExt(mFile, mDevice->Frequency, channels, bytes, chanmask, subtype);
+
+    fwrite(GUID_W64_DATA, 1, 16, mFile);
+    fwrite64le(~uint64_t{0}, mFile); // 'data' chunk len; filled in at close
+}
+
+void WaveBackend::writeCafHeader(ALuint channels, ALuint bytes, ALuint layoutTag,
+    ALuint chanmask)
+{
+    /* CAF is big-endian, but the samples themselves are flagged as little-
+     * endian so they're written the same as for WAVE.
+     */
+    fputs("caff", mFile);
+    fwrite16be(1, mFile); // file version
+    fwrite16be(0, mFile); // file flags
+
+    fputs("desc", mFile);
+    fwrite64be(32, mFile);
+    uint64_t rate;
+    const double frequency{static_cast<double>(mDevice->Frequency)};
+    memcpy(&rate, &frequency, sizeof(rate));
+    fwrite64be(rate, mFile); // sample rate, as a 64-bit float
+    fputs("lpcm", mFile);
+    // format flags: little-endian (0x2), and float (0x1)
+    fwrite32be((mDevice->FmtType == DevFmtFloat) ? 0x3 : 0x2, mFile);
+    fwrite32be(channels * bytes, mFile); // bytes per packet
+    fwrite32be(1, mFile); // frames per packet
+    fwrite32be(channels, mFile);
+    fwrite32be(bytes * 8, mFile); // bits per channel
+
+    if(layoutTag != 0)
+    {
+        fputs("chan", mFile);
+        fwrite64be(12, mFile);
+        fwrite32be(layoutTag, mFile);
+        fwrite32be(chanmask, mFile);
+        fwrite32be(0, mFile); // number of channel descriptions
+    }
+
+    fputs("data", mFile);
+    fwrite64be(~uint64_t{0}, mFile); // 'data' chunk len; filled in at close
+    fwrite32be(0, mFile); // edit count
+}
+
 ALCboolean WaveBackend::reset()
 {
     ALuint channels=0, bytes=0, chanmask=0;
-    int isbformat = 0;
-    size_t val;
+    bool isbformat{false}, isambix{false};
 
     fseek(mFile, 0, SEEK_SET);
     clearerr(mFile);
@@ -234,13 +528,27 @@ ALCboolean WaveBackend::reset()
     if(GetConfigValueBool(nullptr, "wave", "bformat", 0))
     {
         mDevice->FmtChans = DevFmtAmbi3D;
-        mDevice->mAmbiOrder = 1;
+        int order{1};
+        ConfigValueInt(nullptr, "wave", "bformat-order", &order);
+        mDevice->mAmbiOrder = clampi(order, 1, 3);
+
+        const char *layout{GetConfigValue(nullptr, "wave", "bformat-layout", "fuma")};
+        if(strcasecmp(layout, "ambix") == 0)
+            isambix = true;
+        else if(strcasecmp(layout, "fuma") != 0)
+            ERR("Unsupported B-Format layout: %s\n", layout);
     }
 
     switch(mDevice->FmtType)
     {
         case DevFmtByte:
-            mDevice->FmtType = DevFmtUByte;
+            /* 8-bit WAVE samples are unsigned, while CAF's are signed. */
+            if(mFormat != FileFormat::Caf)
+                mDevice->FmtType = DevFmtUByte;
+            break;
+        case DevFmtUByte:
+            if(mFormat == FileFormat::Caf)
+                mDevice->FmtType = DevFmtByte;
             break;
         case DevFmtUShort:
             mDevice->FmtType = DevFmtShort;
@@ -248,7 +556,6 @@ ALCboolean WaveBackend::reset()
         case DevFmtUInt:
             mDevice->FmtType = DevFmtInt;
             break;
-        case DevFmtUByte:
         case DevFmtShort:
         case DevFmtInt:
         case DevFmtFloat:
@@ -264,11 +571,22 @@ ALCboolean WaveBackend::reset()
         case DevFmtX61: chanmask = 0x01 | 0x02 | 0x04 | 0x08 | 0x100 | 0x200 | 0x400; break;
         case DevFmtX71: chanmask = 0x01 | 0x02 | 0x04 | 0x08 | 0x010 | 0x020 | 0x200 | 0x400; break;
         case DevFmtAmbi3D:
-            /* .amb output requires FuMa */
             mDevice->mAmbiOrder = mini(mDevice->mAmbiOrder, 3);
-            mDevice->mAmbiLayout = AmbiLayout::FuMa;
-            mDevice->mAmbiScale = AmbiNorm::FuMa;
-            isbformat = 1;
+            if(isambix)
+            {
+                /* AmbiX uses ACN ordering with SN3D normalization, stored as
+                 * plain channels with no speaker mask.
+                 */
+                mDevice->mAmbiLayout = AmbiLayout::ACN;
+                mDevice->mAmbiScale = AmbiNorm::SN3D;
+            }
+            else
+            {
+                /* .amb output requires FuMa */
+                mDevice->mAmbiLayout = AmbiLayout::FuMa;
+                mDevice->mAmbiScale = AmbiNorm::FuMa;
+                isbformat = true;
+            }
             chanmask = 0;
             break;
     }
@@ -277,40 +595,29 @@ ALCboolean WaveBackend::reset()
 
     rewind(mFile);
 
-    fputs("RIFF", mFile);
-    fwrite32le(0xFFFFFFFF, mFile); // 'RIFF' header len; filled in at close
-
-    fputs("WAVE", mFile);
-
-    fputs("fmt ", mFile);
-    fwrite32le(40, mFile); // 'fmt ' header len; 40 bytes for EXTENSIBLE
-
-    // 16-bit val, format type id (extensible: 0xFFFE)
-    fwrite16le(0xFFFE, mFile);
-    // 16-bit val, channel count
-    fwrite16le(channels, mFile);
-    // 32-bit val, frequency
-    fwrite32le(mDevice->Frequency, mFile);
-    // 32-bit val, bytes per second
-    fwrite32le(mDevice->Frequency * channels * bytes, mFile);
-    // 16-bit val, frame size
-    fwrite16le(channels * bytes, mFile);
-    // 16-bit val, bits per sample
-    fwrite16le(bytes * 8, mFile);
-    // 16-bit val, extra byte count
-    fwrite16le(22, mFile);
-    // 16-bit val, valid bits per sample
-    fwrite16le(bytes * 8, mFile);
-    // 32-bit val, channel mask
-    fwrite32le(chanmask, mFile);
-    // 16 byte GUID, sub-type format
-    val = fwrite((mDevice->FmtType == DevFmtFloat) ?
-                 (isbformat ? SUBTYPE_BFORMAT_FLOAT : SUBTYPE_FLOAT) :
-                 (isbformat ? SUBTYPE_BFORMAT_PCM : SUBTYPE_PCM), 1, 16, mFile);
-    (void)val;
-
-    fputs("data", mFile);
-    fwrite32le(0xFFFFFFFF, mFile); // 'data' header len; filled in at close
+    const bool isfloat{mDevice->FmtType == DevFmtFloat};
+    const ALubyte *subtype{isfloat ? (isbformat ? SUBTYPE_BFORMAT_FLOAT : SUBTYPE_FLOAT) :
+        (isbformat ? SUBTYPE_BFORMAT_PCM : SUBTYPE_PCM)};
+    switch(mFormat)
+    {
+    case FileFormat::Wave:
+        writeWaveHeader(channels, bytes, chanmask, subtype);
+        break;
+    case FileFormat::Wave64:
+        writeWave64Header(channels, bytes, chanmask, subtype);
+        break;
+    case FileFormat::Caf:
+        if(mDevice->FmtChans == DevFmtAmbi3D)
+        {
+            if(isbformat)
+                WARN("CAF output has no FuMa channel layout, writing unlabeled channels\n");
+            writeCafHeader(channels, bytes, isbformat ? 0 : (CAF_LAYOUT_HOA_ACN_SN3D|channels),
+                0);
+        }
+        else
+            writeCafHeader(channels, bytes, CAF_LAYOUT_USE_BITMAP, chanmask);
+        break;
+    }
 
     if(ferror(mFile))
     {
@@ -318,11 +625,20 @@ ALCboolean WaveBackend::reset()
         return ALC_FALSE;
     }
     mDataStart = ftell(mFile);
+    mDataSize = 0;
 
     SetDefaultWFXChannelOrder(mDevice);
 
-    const ALuint bufsize{mDevice->frameSizeFromFmt() * mDevice->UpdateSize};
-    mBuffer.resize(bufsize);
+    /* When not rendering in real-time, mix larger chunks to reduce the
+     * locking and write call overhead.
+     */
+    mChunkSize = mDevice->UpdateSize;
+    if(!mRealtime)
+        mChunkSize *= maxi(1, 8192/mChunkSize);
+
+    const ALuint bufsize{mDevice->frameSizeFromFmt() * static_cast<ALuint>(mChunkSize)};
+    mBuffer[0].resize(bufsize);
+    mBuffer[1].resize(mAsyncWrite ? bufsize : 0);
 
     return ALC_TRUE;
 }
@@ -330,6 +646,11 @@ ALCboolean WaveBackend::reset()
 ALCboolean WaveBackend::start()
 {
     try {
+        mMixIndex = 0;
+        mWriteFailed.store(false, std::memory_order_release);
+        if(mAsyncWrite)
+            mWriteThread = std::thread{std::mem_fn(&WaveBackend::writerProc), this};
+
         mKillNow.store(false, std::memory_order_release);
         mThread = std::thread{std::mem_fn(&WaveBackend::mixerProc), this};
         return ALC_TRUE;
@@ -339,6 +660,11 @@ ALCboolean WaveBackend::start()
     }
     catch(...) {
     }
+    if(mWriteThread.joinable())
+    {
+        mReadySem.post();
+        mWriteThread.join();
+    }
     return ALC_FALSE;
 }
 
@@ -348,15 +674,50 @@ void WaveBackend::stop()
         return;
     mThread.join();
 
-    long size{ftell(mFile)};
-    if(size > 0)
+    if(mWriteThread.joinable())
+    {
+        /* Wake the writer with nothing queued so it quits after flushing. */
+        mReadySem.post();
+        mWriteThread.join();
+    }
+
+    if(ftell(mFile) < 0)
+        return;
+
+    switch(mFormat)
     {
-        long dataLen{size - mDataStart};
-        if(fseek(mFile, mDataStart-4, SEEK_SET) == 0)
-            fwrite32le(dataLen, mFile); // 'data' header len
-        if(fseek(mFile, 4, SEEK_SET) == 0)
-            fwrite32le(size-8, mFile); // 'WAVE' header len
+    case FileFormat::Wave:
+        {
+            const uint64_t riffLen{static_cast<uint64_t>(mDataStart) + mDataSize - 8};
+            if(riffLen > 0xFFFFFFFF)
+                WARN("Data too large for WAVE (%" PRIu64 " bytes), use W64 or CAF output\n",
+                    mDataSize);
+            if(fseek(mFile, mDataStart-4, SEEK_SET) == 0)
+                fwrite32le(static_cast<ALuint>(minu64(mDataSize, 0xFFFFFFFF)), mFile); // 'data' header len
+            if(fseek(mFile, 4, SEEK_SET) == 0)
+                fwrite32le(static_cast<ALuint>(minu64(riffLen, 0xFFFFFFFF)), mFile); // 'WAVE' header len
+        }
+        break;
+    case FileFormat::Wave64:
+        {
+            /* Chunks are padded to 8-byte alignment. */
+            static constexpr ALubyte padding[8]{};
+            const size_t padLen{static_cast<size_t>((8 - (mDataSize&7)) & 7)};
+            fwrite(padding, 1, padLen, mFile);
+
+            if(fseek(mFile, mDataStart-8, SEEK_SET) == 0)
+                fwrite64le(24 + mDataSize, mFile); // 'data' chunk len
+            if(fseek(mFile, 16, SEEK_SET) == 0)
+                fwrite64le(static_cast<uint64_t>(mDataStart) + mDataSize + padLen, mFile); // 'riff' chunk len
+        }
+        break;
+    case FileFormat::Caf:
+        /* The data chunk size includes the 4-byte edit count. */
+        if(fseek(mFile, mDataStart-12, SEEK_SET) == 0)
+            fwrite64be(mDataSize + 4, mFile);
+        break;
     }
+    fseek(mFile, 0, SEEK_END);
 }
 
 } // namespace
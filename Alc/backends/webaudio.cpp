@@ -0,0 +1,519 @@
+/**
+ * OpenAL cross platform audio library
+ * Copyright (C) 1999-2007 by authors.
+ * This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Library General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ *  License along with this library; if not, write to the
+ *  Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ * Or go to http://www.gnu.org/copyleft/lgpl.html
+ */
+
+#include "config.h"
+
+#include "backends/webaudio.h"
+
+#include <cstring>
+
+#include <algorithm>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "alMain.h"
+#include "alu.h"
+#include "alconfig.h"
+#include "ringbuffer.h"
+#include "threads.h"
+#include "compat.h"
+
+#include <emscripten/em_asm.h>
+#include <emscripten/proxying.h>
+#include <emscripten/threading.h>
+#include <emscripten/webaudio.h>
+
+
+namespace {
+
+constexpr ALCchar webaudioDevice[] = "Web Audio Default";
+
+constexpr char ProcessorName[] = "openal-soft-output";
+
+/* Web Audio always renders in quanta of this many sample frames. */
+constexpr ALuint RenderQuantum{128};
+
+
+struct WebAudioPlayback;
+
+/* The part of a device's worklet node seen by its process callback, on the
+ * audio worklet thread. The browser may still call the callback after the
+ * node is dropped, so this is never freed; it's only detached from the
+ * device, after which the callback lets the node end.
+ */
+struct NodeState {
+    std::atomic<WebAudioPlayback*> mBackend;
+    std::atomic<bool> mInProcess{false};
+
+    NodeState(WebAudioPlayback *backend) noexcept : mBackend{backend} { }
+
+    DEF_NEWDEL(NodeState)
+};
+
+
+/* Browsers limit how many AudioContexts a page can have, so all devices
+ * share one, along with the Wasm audio worklet thread and processor set up on
+ * it. Web Audio can only be used from the main browser thread, where the
+ * worklet's setup also completes asynchronously. Devices started before then
+ * wait in HostPending, and get their node once it's ready.
+ */
+enum class HostState {
+    Idle,
+    Starting,
+    Ready,
+    Failed
+};
+std::mutex HostLock;
+HostState HostStatus{HostState::Idle};
+EMSCRIPTEN_WEBAUDIO_T HostContext{0};
+al::vector<WebAudioPlayback*> HostPending;
+
+alignas(16) char WorkletStack[16384];
+
+template<typename F>
+void RunOnMainThread(F func)
+{
+    if(emscripten_is_main_runtime_thread())
+        func();
+    else
+        emscripten_proxy_sync(emscripten_proxy_get_system_queue(),
+            emscripten_main_runtime_thread_id(),
+            [](void *arg) -> void { (*static_cast<F*>(arg))(); }, &func);
+}
+
+
+struct WebAudioPlayback final : public BackendBase {
+    WebAudioPlayback(ALCdevice *device) noexcept : BackendBase{device} { }
+    ~WebAudioPlayback() override;
+
+    static EM_BOOL processC(int numInputs, const AudioSampleFrame *inputs, int numOutputs,
+        AudioSampleFrame *outputs, int numParams, const AudioParamFrame *params,
+        void *userData);
+    void process(AudioSampleFrame &output);
+
+    int mixerProc();
+
+    void createNode();
+    void destroyNode();
+
+    ALCenum open(const ALCchar *name) override;
+    ALCboolean reset() override;
+    ALCboolean start() override;
+    void stop() override;
+    ClockLatency getClockLatency() override;
+
+    /* Only set or cleared on the main browser thread, with HostLock held
+     * while the device may be in HostPending.
+     */
+    EMSCRIPTEN_AUDIO_WORKLET_NODE_T mNode{0};
+    NodeState *mState{nullptr};
+
+    RingBufferPtr mRing;
+    al::semaphore mSem;
+
+    std::atomic<bool> mKillNow{true};
+    std::thread mThread;
+
+    static constexpr inline const char *CurrentPrefix() noexcept { return "WebAudioPlayback::"; }
+    DEF_NEWDEL(WebAudioPlayback)
+};
+
+
+void WorkletProcessorCreated(EMSCRIPTEN_WEBAUDIO_T, EM_BOOL success, void*)
+{
+    std::lock_guard<std::mutex> _{HostLock};
+    if(!success)
+    {
+        ERR("Failed to create the audio worklet processor\n");
+        HostStatus = HostState::Failed;
+        for(WebAudioPlayback *backend : HostPending)
+            aluHandleDisconnect(backend->mDevice, "Failed to create the audio worklet");
+        HostPending.clear();
+        return;
+    }
+
+    TRACE("Audio worklet ready\n");
+    HostStatus = HostState::Ready;
+    for(WebAudioPlayback *backend : HostPending)
+        backend->createNode();
+    HostPending.clear();
+}
+
+void WorkletThreadStarted(EMSCRIPTEN_WEBAUDIO_T context, EM_BOOL success, void*)
+{
+    if(!success)
+    {
+        ERR("Failed to start the audio worklet thread\n");
+        WorkletProcessorCreated(context, EM_FALSE, nullptr);
+        return;
+    }
+
+    WebAudioWorkletProcessorCreateOptions opts{};
+    opts.name = ProcessorName;
+    emscripten_create_wasm_audio_worklet_processor_async(context, &opts,
+        WorkletProcessorCreated, nullptr);
+}
+
+/* Must be called on the main browser thread. */
+void StartHost()
+{
+    std::lock_guard<std::mutex> _{HostLock};
+    if(HostStatus != HostState::Idle)
+        return;
+
+    HostContext = emscripten_create_audio_context(nullptr);
+    if(HostContext <= 0)
+    {
+        ERR("Failed to create an AudioContext\n");
+        HostStatus = HostState::Failed;
+        return;
+    }
+    HostStatus = HostState::Starting;
+
+    /* Browsers keep a new AudioContext suspended until the page gets a user
+     * gesture, so resume it on the first one.
+     */
+    EM_ASM({
+        var ctx = emscriptenGetAudioObject($0);
+        var events = ['click', 'keydown', 'touchend'];
+        var resume = function() {
+            ctx.resume();
+            events.forEach(function(e) { window.removeEventListener(e, resume, true); });
+        };
+        events.forEach(function(e) { window.addEventListener(e, resume, true); });
+    }, HostContext);
+    emscripten_start_wasm_audio_worklet_thread_async(HostContext, WorkletStack,
+        sizeof(WorkletStack), WorkletThreadStarted, nullptr);
+}
+
+
+WebAudioPlayback::~WebAudioPlayback()
+{
+    std::lock_guard<std::mutex> _{HostLock};
+    auto iter = std::find(HostPending.begin(), HostPending.end(), this);
+    if(iter != HostPending.end())
+        HostPending.erase(iter);
+}
+
+
+EM_BOOL WebAudioPlayback::processC(int, const AudioSampleFrame*, int numOutputs,
+    AudioSampleFrame *outputs, int, const AudioParamFrame*, void *userData)
+{
+    auto state = static_cast<NodeState*>(userData);
+    state->mInProcess.store(true);
+    WebAudioPlayback *self{state->mBackend.load()};
+    if(self && numOutputs > 0)
+        self->process(outputs[0]);
+    state->mInProcess.store(false);
+    /* Once detached, let the browser stop processing the node. */
+    return self ? EM_TRUE : EM_FALSE;
+}
+
+void WebAudioPlayback::process(AudioSampleFrame &output)
+{
+    /* Output is planar, with each channel's quantum after the last. */
+    const auto numchans = static_cast<ALuint>(mDevice->channelsFromFmt());
+    const ALuint outchans{minu(static_cast<ALuint>(output.numberOfChannels), numchans)};
+    auto deinterleave = [&output,numchans,outchans](const char *src, ALuint offset,
+        ALuint count) -> void
+    {
+        const ALfloat *RESTRICT in{reinterpret_cast<const ALfloat*>(src)};
+        for(ALuint c{0};c < outchans;++c)
+        {
+            ALfloat *RESTRICT out{output.data + c*RenderQuantum + offset};
+            for(ALuint i{0};i < count;++i)
+                out[i] = in[i*numchans + c];
+        }
+    };
+
+    auto data = mRing->getReadVector();
+    ALuint total{minu(RenderQuantum, data.first.len)};
+    deinterleave(data.first.buf, 0, total);
+
+    const ALuint todo{minu(RenderQuantum-total, data.second.len)};
+    if(todo > 0)
+    {
+        deinterleave(data.second.buf, total, todo);
+        total += todo;
+    }
+
+    mRing->readAdvance(total);
+    mSem.post();
+
+    if(total < RenderQuantum)
+    {
+        /* The mixer thread didn't keep up. */
+        recordUnderrun();
+        for(ALuint c{0};c < outchans;++c)
+            std::fill_n(output.data + c*RenderQuantum + total, RenderQuantum-total, 0.0f);
+    }
+    for(ALuint c{outchans};c < static_cast<ALuint>(output.numberOfChannels);++c)
+        std::fill_n(output.data + c*RenderQuantum, RenderQuantum, 0.0f);
+}
+
+int WebAudioPlayback::mixerProc()
+{
+    SetRTPriority();
+    althrd_setname(MIXER_THREAD_NAME);
+
+    lock();
+    while(!mKillNow.load(std::memory_order_acquire) &&
+          mDevice->Connected.load(std::memory_order_acquire))
+    {
+        if(mRing->writeSpace() < mDevice->UpdateSize)
+        {
+            unlock();
+            mSem.wait();
+            lock();
+            continue;
+        }
+
+        auto data = mRing->getWriteVector();
+        auto todo = static_cast<ALuint>(data.first.len + data.second.len);
+        todo -= todo%mDevice->UpdateSize;
+
+        ALuint len1{minu(data.first.len, todo)};
+        ALuint len2{minu(data.second.len, todo-len1)};
+
+        recordWakeup(todo);
+        aluMixData(mDevice, data.first.buf, len1);
+        if(len2 > 0)
+            aluMixData(mDevice, data.second.buf, len2);
+        mRing->writeAdvance(todo);
+    }
+    unlock();
+
+    return 0;
+}
+
+
+/* Must be called on the main browser thread, once the worklet is ready. */
+void WebAudioPlayback::createNode()
+{
+    int numchans{mDevice->channelsFromFmt()};
+    EmscriptenAudioWorkletNodeCreateOptions opts{};
+    opts.numberOfInputs = 0;
+    opts.numberOfOutputs = 1;
+    opts.outputChannelCounts = &numchans;
+
+    mState = new NodeState{this};
+    mNode = emscripten_create_wasm_audio_worklet_node(HostContext, ProcessorName, &opts,
+        &WebAudioPlayback::processC, mState);
+    EM_ASM({
+        var node = emscriptenGetAudioObject($0);
+        var dest = emscriptenGetAudioObject($1).destination;
+        dest.channelCount = $2;
+        dest.channelInterpretation = ($2 > 2) ? 'discrete' : 'speakers';
+        node.connect(dest);
+    }, mNode, HostContext, numchans);
+
+    /* Won't take effect before the page gets a user gesture. */
+    emscripten_resume_audio_context_sync(HostContext);
+}
+
+/* Must be called on the main browser thread. */
+void WebAudioPlayback::destroyNode()
+{
+    EM_ASM({ emscriptenGetAudioObject($0).disconnect(); }, mNode);
+    emscripten_destroy_web_audio_node(mNode);
+    mNode = 0;
+}
+
+
+ALCenum WebAudioPlayback::open(const ALCchar *name)
+{
+    if(!name)
+        name = webaudioDevice;
+    else if(strcmp(name, webaudioDevice) != 0)
+        return ALC_INVALID_VALUE;
+
+    RunOnMainThread(StartHost);
+    {
+        std::lock_guard<std::mutex> _{HostLock};
+        if(HostStatus == HostState::Failed)
+            return ALC_INVALID_VALUE;
+    }
+
+    mDevice->DeviceName = name;
+    return ALC_NO_ERROR;
+}
+
+ALCboolean WebAudioPlayback::reset()
+{
+    /* The AudioContext resamples the output as needed, but mixing at its rate
+     * avoids that.
+     */
+    mDevice->Frequency = static_cast<ALuint>(MAIN_THREAD_EM_ASM_INT({
+        return emscriptenGetAudioObject($0).sampleRate;
+    }, HostContext));
+
+    const int maxchans{MAIN_THREAD_EM_ASM_INT({
+        return emscriptenGetAudioObject($0).destination.maxChannelCount;
+    }, HostContext)};
+    if(mDevice->channelsFromFmt() > maxchans)
+    {
+        WARN("%s output not supported, destination only has %d channels\n",
+            DevFmtChannelsString(mDevice->FmtChans), maxchans);
+        mDevice->FmtChans = (maxchans < 2) ? DevFmtMono : DevFmtStereo;
+        mDevice->mAmbiOrder = 0;
+    }
+
+    /* Force 32-bit float output. */
+    mDevice->FmtType = DevFmtFloat;
+
+    /* Mix one render quantum at a time, keeping enough buffered ahead of the
+     * worklet to cover the mixer thread's scheduling delays.
+     */
+    ALuint bufsize{RenderQuantum * 4};
+    ConfigValueUInt(mDevice->DeviceName.c_str(), "webaudio", "buffer-size", &bufsize);
+    bufsize = maxu(NextPowerOf2(bufsize), RenderQuantum*2);
+    mDevice->UpdateSize = RenderQuantum;
+    mDevice->BufferSize = bufsize + mDevice->UpdateSize;
+
+    mRing = nullptr;
+    mRing = CreateRingBuffer(bufsize, mDevice->frameSizeFromFmt(), true);
+    if(!mRing)
+    {
+        ERR("Failed to allocate ringbuffer\n");
+        return ALC_FALSE;
+    }
+
+    SetDefaultWFXChannelOrder(mDevice);
+
+    return ALC_TRUE;
+}
+
+ALCboolean WebAudioPlayback::start()
+{
+    try {
+        mKillNow.store(false, std::memory_order_release);
+        mThread = std::thread{std::mem_fn(&WebAudioPlayback::mixerProc), this};
+    }
+    catch(std::exception& e) {
+        ERR("Could not create playback thread: %s\n", e.what());
+        return ALC_FALSE;
+    }
+    catch(...) {
+        return ALC_FALSE;
+    }
+
+    std::unique_lock<std::mutex> hostlock{HostLock};
+    if(HostStatus == HostState::Starting)
+    {
+        HostPending.emplace_back(this);
+        return ALC_TRUE;
+    }
+    const bool ready{HostStatus == HostState::Ready};
+    hostlock.unlock();
+
+    if(ready)
+    {
+        RunOnMainThread([this]() -> void { createNode(); });
+        return ALC_TRUE;
+    }
+
+    mKillNow.store(true, std::memory_order_release);
+    mSem.post();
+    mThread.join();
+    return ALC_FALSE;
+}
+
+void WebAudioPlayback::stop()
+{
+    if(mKillNow.exchange(true, std::memory_order_acq_rel) || !mThread.joinable())
+        return;
+
+    NodeState *state{nullptr};
+    {
+        std::lock_guard<std::mutex> _{HostLock};
+        auto iter = std::find(HostPending.begin(), HostPending.end(), this);
+        if(iter != HostPending.end())
+            HostPending.erase(iter);
+        state = mState;
+        mState = nullptr;
+    }
+    if(state)
+    {
+        /* Make sure the worklet is done with the ring before it's touched. */
+        state->mBackend.store(nullptr);
+        while(state->mInProcess.load())
+            std::this_thread::yield();
+        RunOnMainThread([this]() -> void { destroyNode(); });
+    }
+
+    mSem.post();
+    mThread.join();
+}
+
+ClockLatency WebAudioPlayback::getClockLatency()
+{
+    ClockLatency ret;
+
+    lock();
+    ret.ClockTime = GetDeviceClockTime(mDevice);
+    ret.Latency  = std::chrono::seconds{mRing->readSpace()};
+    ret.Latency /= mDevice->Frequency;
+    unlock();
+
+    return ret;
+}
+
+} // namespace
+
+
+bool WebAudioBackendFactory::init()
+{
+    /* The worklet needs shared memory to read the mixer thread's output. */
+    return MAIN_THREAD_EM_ASM_INT({
+        if(typeof SharedArrayBuffer === 'undefined' || typeof AudioContext === 'undefined')
+            return 0;
+        return ('audioWorklet' in AudioContext.prototype) ? 1 : 0;
+    }) != 0;
+}
+
+bool WebAudioBackendFactory::querySupport(BackendType type)
+{ return (type == BackendType::Playback); }
+
+void WebAudioBackendFactory::probe(DevProbe type, std::string *outnames)
+{
+    switch(type)
+    {
+        case DevProbe::Playback:
+            /* Includes null char. */
+            outnames->append(webaudioDevice, sizeof(webaudioDevice));
+            break;
+        case DevProbe::Capture:
+            break;
+    }
+}
+
+BackendPtr WebAudioBackendFactory::createBackend(ALCdevice *device, BackendType type)
+{
+    if(type == BackendType::Playback)
+        return BackendPtr{new WebAudioPlayback{device}};
+    return nullptr;
+}
+
+BackendFactory &WebAudioBackendFactory::getFactory()
+{
+    static WebAudioBackendFactory factory{};
+    return factory;
+}
@@ -0,0 +1,19 @@
+#ifndef BACKENDS_WEBAUDIO_H
+#define BACKENDS_WEBAUDIO_H
+
+#include "backends/base.h"
+
+struct WebAudioBackendFactory final : public BackendFactory {
+public:
+    bool init() override;
+
+    bool querySupport(BackendType type) override;
+
+    void probe(DevProbe type, std::string *outnames) override;
+
+    BackendPtr createBackend(ALCdevice *device, BackendType type) override;
+
+    static BackendFactory &getFactory();
+};
+
+#endif /* BACKENDS_WEBAUDIO_H */
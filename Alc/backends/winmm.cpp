@@ -196,6 +196,7 @@ FORCE_ALIGN int WinMMPlayback::mixerProc()
             continue;
         }
 
+        recordWakeup(static_cast<ALuint>(todo) * mDevice->UpdateSize);
         int widx{mIdx};
         do {
             WAVEHDR &waveHdr = mWaveBuffer[widx];
@@ -378,6 +379,7 @@ struct WinMMCapture final : public BackendBase {
     void stop() override;
     ALCenum captureSamples(void *buffer, ALCuint samples) override;
     ALCuint availableSamples() override;
+    bool supportsCaptureCallback() override { return true; }
 
     std::atomic<ALuint> mReadable{0u};
     al::semaphore mSem;
@@ -451,6 +453,7 @@ int WinMMCapture::captureProc()
             waveInAddBuffer(mInHdl, &waveHdr, sizeof(WAVEHDR));
         } while(--todo);
         mIdx = widx;
+        dispatchCapture(mRing.get());
     }
     unlock();
 
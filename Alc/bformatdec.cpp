@@ -22,6 +22,11 @@ namespace {
 using namespace std::placeholders;
 
 
+/* The number of samples to band-split before decoding them. A multiple of 4
+ * keeps the row mixer's input and output aligned.
+ */
+constexpr ALsizei SplitBlockSize{128};
+
 constexpr ALfloat Ambi3DDecoderHFScale[MAX_AMBI_ORDER+1] = {
     1.00000000e+00f, 1.00000000e+00f
 };
@@ -146,39 +151,73 @@ BFormatDec::BFormatDec(const ALsizei inchans, const ALsizei chancount,
 }
 
 
-void BFormatDec::process(ALfloat (*OutBuffer)[BUFFERSIZE], const ALsizei OutChannels, const ALfloat (*InSamples)[BUFFERSIZE], const ALsizei SamplesToDo)
+void BFormatDec::process(ALfloat (*OutBuffer)[BUFFERSIZE], const ALsizei OutChannels, const ALfloat (*InSamples)[BUFFERSIZE], const ChannelMask InMask, const ALsizei SamplesToDo)
 {
     ASSUME(OutChannels > 0);
     ASSUME(mNumChannels > 0);
 
+    const ChannelMask inmask{InMask & ChannelMaskFor(mNumChannels)};
     if(mDualBand)
     {
-        for(ALsizei i{0};i < mNumChannels;i++)
-            mXOver[i].process(mSamplesHF[i].data(), mSamplesLF[i].data(), InSamples[i],
-                              SamplesToDo);
+        /* The band splitters need to keep running on silent input to let
+         * their state decay, so every input channel is processed.
+         */
+        auto *samplesHF = &reinterpret_cast<ALfloat(&)[BUFFERSIZE]>(mSamplesHF[0]);
+        auto *samplesLF = &reinterpret_cast<ALfloat(&)[BUFFERSIZE]>(mSamplesLF[0]);
+
+        /* Split and decode a block at a time, so the split samples are still
+         * in cache when they get mixed.
+         */
+        for(ALsizei base{0};base < SamplesToDo;)
+        {
+            const ALsizei todo{mini(SamplesToDo-base, SplitBlockSize)};
+
+            for(ALsizei i{0};i < mNumChannels;i++)
+                mXOver[i].process(samplesHF[i]+base, samplesLF[i]+base, InSamples[i]+base,
+                    todo);
+
+            for(ALsizei chan{0};chan < OutChannels;chan++)
+            {
+                if(UNLIKELY(!(mEnabled&(1<<chan))))
+                    continue;
+
+                MixRowSamples(OutBuffer[chan]+base, mMatrix.Dual[chan][sHFBand], samplesHF,
+                    mNumChannels, base, todo);
+                MixRowSamples(OutBuffer[chan]+base, mMatrix.Dual[chan][sLFBand], samplesLF,
+                    mNumChannels, base, todo);
+            }
 
+            base += todo;
+        }
+    }
+    else if(inmask == ChannelMaskFor(mNumChannels))
+    {
         for(ALsizei chan{0};chan < OutChannels;chan++)
         {
             if(UNLIKELY(!(mEnabled&(1<<chan))))
                 continue;
 
-            MixRowSamples(OutBuffer[chan], mMatrix.Dual[chan][sHFBand],
-                &reinterpret_cast<ALfloat(&)[BUFFERSIZE]>(mSamplesHF[0]),
-                mNumChannels, 0, SamplesToDo);
-            MixRowSamples(OutBuffer[chan], mMatrix.Dual[chan][sLFBand],
-                &reinterpret_cast<ALfloat(&)[BUFFERSIZE]>(mSamplesLF[0]),
-                mNumChannels, 0, SamplesToDo);
+            MixRowSamples(OutBuffer[chan], mMatrix.Single[chan], InSamples,
+                          mNumChannels, 0, SamplesToDo);
         }
     }
     else
     {
+        /* Only mix the input channels that have something in them. */
         for(ALsizei chan{0};chan < OutChannels;chan++)
         {
             if(UNLIKELY(!(mEnabled&(1<<chan))))
                 continue;
 
-            MixRowSamples(OutBuffer[chan], mMatrix.Single[chan], InSamples,
-                          mNumChannels, 0, SamplesToDo);
+            ChannelMask todo{inmask};
+            while(todo)
+            {
+                const int c{CTZ64(todo)};
+                todo &= todo-1;
+
+                MixRowSamples(OutBuffer[chan], &mMatrix.Single[chan][c], InSamples+c, 1, 0,
+                              SamplesToDo);
+            }
         }
     }
 }
@@ -42,9 +42,12 @@ public:
         const ChannelDec (&chancoeffs)[MAX_OUTPUT_CHANNELS],
         const ALsizei (&chanmap)[MAX_OUTPUT_CHANNELS]);
 
-    /* Decodes the ambisonic input to the given output channels. */
+    /* Decodes the ambisonic input to the given output channels. Input
+     * channels not in InMask are known to be silent.
+     */
     void process(ALfloat (*OutBuffer)[BUFFERSIZE], const ALsizei OutChannels,
-        const ALfloat (*InSamples)[BUFFERSIZE], const ALsizei SamplesToDo);
+        const ALfloat (*InSamples)[BUFFERSIZE], const ChannelMask InMask,
+        const ALsizei SamplesToDo);
 
     /* Retrieves per-order HF scaling factors for "upsampling" ambisonic data. */
     static std::array<ALfloat,MAX_AMBI_ORDER+1> GetHFOrderScales(const ALsizei in_order,
@@ -26,6 +26,7 @@
 #include <cmath>
 #include <cstring>
 #include <algorithm>
+#include <iterator>
 
 #include "bs2b.h"
 #include "math_defs.h"
@@ -0,0 +1,343 @@
+
+#include "config.h"
+
+#include "callrecord.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#include "alMain.h"
+#include "alcontext.h"
+#include "logging.h"
+#include "compat.h"
+#include "vector.h"
+
+#include "backends/base.h"
+
+
+bool RecordEnabled{false};
+
+namespace {
+
+std::mutex RecordLock;
+FILE *RecordFile{nullptr};
+
+/* Contexts and devices are given small indices in the trace, since their
+ * pointers mean nothing to the replay. Each device also keeps the clock time
+ * it got its first context at, so the replay's clock starts together with it.
+ */
+struct RecordedDevice {
+    ALCdevice *Device;
+    ALuint Index;
+    std::chrono::nanoseconds ClockStart;
+};
+struct RecordedContext {
+    ALCcontext *Context;
+    ALuint Index;
+    RecordedDevice *Device;
+};
+al::vector<std::unique_ptr<RecordedDevice>> RecordDevices;
+al::vector<RecordedContext> RecordContexts;
+ALuint NextDeviceIndex{1u};
+ALuint NextContextIndex{1u};
+
+
+std::chrono::nanoseconds ReadDeviceClock(ALCdevice *device)
+{
+    std::chrono::nanoseconds clocktime;
+    ALuint refcount;
+    do {
+        while(((refcount=device->MixCount.load(std::memory_order_acquire))&1))
+            std::this_thread::yield();
+        clocktime = GetDeviceClockTime(device);
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } while(refcount != device->MixCount.load(std::memory_order_relaxed));
+    return clocktime;
+}
+
+const RecordedContext *FindContext(ALCcontext *context)
+{
+    auto iter = std::find_if(RecordContexts.cbegin(), RecordContexts.cend(),
+        [context](const RecordedContext &rec) noexcept -> bool
+        { return rec.Context == context; });
+    return (iter != RecordContexts.cend()) ? &*iter : nullptr;
+}
+
+
+/* Writes one record, holding the record lock from the header until the entry
+ * goes out of scope. The payload size must be given up front, and the puts
+ * must add up to it.
+ */
+class RecordEntry {
+    std::unique_lock<std::mutex> mLock;
+    bool mActive{false};
+
+public:
+    RecordEntry(RecordCall call, ALCcontext *context, size_t size) : mLock{RecordLock}
+    {
+        if(!RecordFile) return;
+
+        const RecordedContext *rec{FindContext(context)};
+        if(!rec) return;
+
+        auto clocktime = ReadDeviceClock(context->Device) - rec->Device->ClockStart;
+        put(static_cast<ALuint>(call));
+        put(rec->Index);
+        put(static_cast<uint64_t>(std::max<int64_t>(clocktime.count(), 0)));
+        put(static_cast<ALuint>(size));
+        mActive = true;
+    }
+
+    template<typename T>
+    void put(const T &value) { fwrite(&value, sizeof(value), 1, RecordFile); }
+    template<typename T>
+    void put(const T *values, ALsizei count)
+    { fwrite(values, sizeof(*values), static_cast<size_t>(count), RecordFile); }
+
+    bool active() const noexcept { return mActive; }
+};
+
+void RecordIds(RecordCall call, ALCcontext *context, RecordObject obj, ALsizei n,
+    const ALuint *ids)
+{
+    if(n <= 0 || !ids) return;
+    RecordEntry entry{call, context, sizeof(ALuint)*2 + sizeof(ALuint)*static_cast<size_t>(n)};
+    if(!entry.active()) return;
+    entry.put(static_cast<ALuint>(obj));
+    entry.put(n);
+    entry.put(ids, n);
+}
+
+template<typename T>
+void RecordParams(RecordCall call, ALCcontext *context, RecordObject obj, ALuint id,
+    ALenum param, ALsizei count, const T *values)
+{
+    if(count <= 0 || !values) return;
+    RecordEntry entry{call, context, sizeof(ALuint)*4 + sizeof(T)*static_cast<size_t>(count)};
+    if(!entry.active()) return;
+    entry.put(static_cast<ALuint>(obj));
+    entry.put(id);
+    entry.put(param);
+    entry.put(count);
+    entry.put(values, count);
+}
+
+} // namespace
+
+
+void RecordInit()
+{
+    const char *fname{getenv("ALSOFT_RECORD_FILE")};
+    if(!fname || !fname[0]) return;
+
+#ifdef _WIN32
+    std::wstring wname{utf8_to_wstr(fname)};
+    RecordFile = _wfopen(wname.c_str(), L"wb");
+#else
+    RecordFile = fopen(fname, "wb");
+#endif
+    if(!RecordFile)
+    {
+        ERR("Failed to open record file '%s'\n", fname);
+        return;
+    }
+
+    fwrite(RECORD_FILE_MAGIC, 1, 4, RecordFile);
+    const ALuint version{RECORD_FILE_VERSION};
+    fwrite(&version, sizeof(version), 1, RecordFile);
+    RecordEnabled = true;
+    TRACE("Recording AL calls to %s\n", fname);
+}
+
+
+void RecordCreateContext(ALCcontext *context)
+{
+    ALCdevice *device{context->Device};
+    {
+        std::lock_guard<std::mutex> _{RecordLock};
+
+        /* Contexts and devices may have been freed without being destroyed
+         * by the app (e.g. closing the device), and their pointers reused.
+         * Forget any context with this pointer, and any device left without
+         * contexts, so they're treated as new.
+         */
+        auto ctxend = std::remove_if(RecordContexts.begin(), RecordContexts.end(),
+            [context](const RecordedContext &rec) noexcept -> bool
+            { return rec.Context == context; });
+        RecordContexts.erase(ctxend, RecordContexts.end());
+        auto devend = std::remove_if(RecordDevices.begin(), RecordDevices.end(),
+            [](const std::unique_ptr<RecordedDevice> &dev) -> bool
+            {
+                return std::none_of(RecordContexts.cbegin(), RecordContexts.cend(),
+                    [&dev](const RecordedContext &rec) noexcept -> bool
+                    { return rec.Device == dev.get(); });
+            });
+        RecordDevices.erase(devend, RecordDevices.end());
+
+        auto iter = std::find_if(RecordDevices.begin(), RecordDevices.end(),
+            [device](const std::unique_ptr<RecordedDevice> &rec) noexcept -> bool
+            { return rec->Device == device; });
+        RecordedDevice *dev{};
+        if(iter != RecordDevices.end())
+            dev = iter->get();
+        else
+        {
+            RecordDevices.emplace_back(new RecordedDevice{device, NextDeviceIndex++,
+                ReadDeviceClock(device)});
+            dev = RecordDevices.back().get();
+        }
+        RecordContexts.emplace_back(RecordedContext{context, NextContextIndex++, dev});
+    }
+
+    RecordEntry entry{RecordCall::CreateContext, context, sizeof(ALuint)*9};
+    if(!entry.active()) return;
+    entry.put(FindContext(context)->Device->Index);
+    entry.put(device->Frequency);
+    entry.put(static_cast<ALuint>(device->FmtChans));
+    entry.put(static_cast<ALuint>(device->mAmbiOrder));
+    entry.put(device->UpdateSize);
+    entry.put(static_cast<ALuint>(device->mHrtf ? 1 : 0));
+    entry.put(device->NumMonoSources);
+    entry.put(device->NumStereoSources);
+    entry.put(static_cast<ALuint>(device->NumAuxSends));
+}
+
+void RecordDestroyContext(ALCcontext *context)
+{
+    {
+        RecordEntry entry{RecordCall::DestroyContext, context, 0};
+        if(RecordFile) fflush(RecordFile);
+    }
+
+    std::lock_guard<std::mutex> _{RecordLock};
+    auto iter = std::find_if(RecordContexts.begin(), RecordContexts.end(),
+        [context](const RecordedContext &rec) noexcept -> bool
+        { return rec.Context == context; });
+    if(iter != RecordContexts.end())
+        RecordContexts.erase(iter);
+}
+
+
+void RecordGen(ALCcontext *context, RecordObject obj, ALsizei n, const ALuint *ids)
+{ RecordIds(RecordCall::Gen, context, obj, n, ids); }
+
+void RecordDelete(ALCcontext *context, RecordObject obj, ALsizei n, const ALuint *ids)
+{ RecordIds(RecordCall::Delete, context, obj, n, ids); }
+
+void RecordParamfv(ALCcontext *context, RecordObject obj, ALuint id, ALenum param, ALsizei count,
+    const ALfloat *values)
+{ RecordParams(RecordCall::Paramf, context, obj, id, param, count, values); }
+
+void RecordParamiv(ALCcontext *context, RecordObject obj, ALuint id, ALenum param, ALsizei count,
+    const ALint *values)
+{ RecordParams(RecordCall::Parami, context, obj, id, param, count, values); }
+
+void RecordParami64v(ALCcontext *context, RecordObject obj, ALuint id, ALenum param,
+    ALsizei count, const ALint64SOFT *values)
+{ RecordParams(RecordCall::Parami64, context, obj, id, param, count, values); }
+
+
+void RecordStatef(ALCcontext *context, ALenum param, ALfloat value)
+{
+    RecordEntry entry{RecordCall::Statef, context, sizeof(param)+sizeof(value)};
+    if(!entry.active()) return;
+    entry.put(param);
+    entry.put(value);
+}
+
+void RecordStatei(ALCcontext *context, ALenum param, ALint value)
+{
+    RecordEntry entry{RecordCall::Statei, context, sizeof(param)+sizeof(value)};
+    if(!entry.active()) return;
+    entry.put(param);
+    entry.put(value);
+}
+
+void RecordCapability(ALCcontext *context, RecordCall call, ALenum capability)
+{
+    RecordEntry entry{call, context, sizeof(capability)};
+    if(!entry.active()) return;
+    entry.put(capability);
+}
+
+void RecordDeferUpdates(ALCcontext *context, RecordCall call)
+{ RecordEntry entry{call, context, 0}; }
+
+
+void RecordSourceOp(ALCcontext *context, RecordCall call, ALsizei n, const ALuint *sources)
+{
+    if(n <= 0 || !sources) return;
+    RecordEntry entry{call, context, sizeof(ALuint) + sizeof(ALuint)*static_cast<size_t>(n)};
+    if(!entry.active()) return;
+    entry.put(n);
+    entry.put(sources, n);
+}
+
+void RecordSourceQueue(ALCcontext *context, ALuint source, ALsizei n, const ALuint *buffers)
+{
+    if(n <= 0 || !buffers) return;
+    RecordEntry entry{RecordCall::SourceQueue, context,
+        sizeof(ALuint)*2 + sizeof(ALuint)*static_cast<size_t>(n)};
+    if(!entry.active()) return;
+    entry.put(source);
+    entry.put(n);
+    entry.put(buffers, n);
+}
+
+void RecordSourceUnqueue(ALCcontext *context, ALuint source, ALsizei n)
+{
+    if(n <= 0) return;
+    RecordEntry entry{RecordCall::SourceUnqueue, context, sizeof(ALuint)*2};
+    if(!entry.active()) return;
+    entry.put(source);
+    entry.put(n);
+}
+
+void RecordSourceUpdateBatch(ALCcontext *context, ALsizei count, const ALuint *sources,
+    const ALsourceUpdateSOFT *updates)
+{
+    if(count <= 0) return;
+    const size_t size{sizeof(ALuint) +
+        (sizeof(ALuint)+sizeof(ALsourceUpdateSOFT))*static_cast<size_t>(count)};
+    RecordEntry entry{RecordCall::SourceUpdateBatch, context, size};
+    if(!entry.active()) return;
+    entry.put(count);
+    for(ALsizei i{0};i < count;++i)
+    {
+        entry.put(sources[i]);
+        entry.put(updates[i]);
+    }
+}
+
+
+void RecordBufferData(ALCcontext *context, ALuint buffer, ALenum format, const ALvoid *data,
+    ALsizei size, ALsizei freq)
+{
+    /* FNV-1a, so the replay can tell identical uploads apart from different
+     * ones without the trace holding the samples.
+     */
+    uint64_t hash{0};
+    if(data && size > 0)
+    {
+        hash = 14695981039346656037ull;
+        auto bytes = static_cast<const unsigned char*>(data);
+        for(ALsizei i{0};i < size;++i)
+            hash = (hash^bytes[i]) * 1099511628211ull;
+    }
+
+    RecordEntry entry{RecordCall::BufferData, context, sizeof(ALuint)*4 + sizeof(hash)};
+    if(!entry.active()) return;
+    entry.put(buffer);
+    entry.put(format);
+    entry.put(size);
+    entry.put(freq);
+    entry.put(hash);
+}
@@ -0,0 +1,110 @@
+#ifndef CALLRECORD_H
+#define CALLRECORD_H
+
+#include "AL/al.h"
+#include "AL/alc.h"
+#include "AL/alext.h"
+#include "inprogext.h"
+
+struct ALCcontext;
+
+
+/* Records the AL calls that drive the mixer's load (object creation, property
+ * changes, playback control, and buffer uploads) to the file named by the
+ * ALSOFT_RECORD_FILE environment variable, for openal-replay to reproduce on
+ * a loopback device. Queries aren't recorded, and buffer data is stored as
+ * just its size and a hash, so the trace stays small and doesn't hold the
+ * app's audio.
+ *
+ * The file starts with the 4-byte magic "ALSR" and a 32-bit version, followed
+ * by records of a 32-bit RecordCall, a 32-bit context index (from 1, in order
+ * of creation), a 64-bit device clock time in nanoseconds (since the context's
+ * device got its first context), and a 32-bit payload size, followed by the
+ * payload. Everything is in host byte order.
+ */
+#define RECORD_FILE_MAGIC "ALSR"
+#define RECORD_FILE_VERSION 1
+
+enum class RecordCall : ALuint {
+    /* device index, frequency, DevFmtChannels, ambisonic order, update size,
+     * HRTF enabled, mono sources, stereo sources, aux sends
+     */
+    CreateContext = 1,
+    DestroyContext, /* (none) */
+
+    /* RecordObject, count, IDs[count] */
+    Gen,
+    Delete,
+    /* RecordObject, ID, param, count, values[count] */
+    Paramf,
+    Parami,
+    Parami64,
+
+    Statef, /* param, value */
+    Statei, /* param, value */
+    Enable, /* capability */
+    Disable, /* capability */
+    DeferUpdates, /* (none) */
+    ProcessUpdates, /* (none) */
+
+    /* count, source IDs[count] */
+    SourcePlay,
+    SourcePause,
+    SourceStop,
+    SourceRewind,
+    /* source ID, count, buffer IDs[count] */
+    SourceQueue,
+    SourceUnqueue, /* source ID, count */
+    /* count, {source ID, ALsourceUpdateSOFT}[count] */
+    SourceUpdateBatch,
+
+    /* buffer ID, format, size, frequency, 64-bit FNV-1a hash of the data (0
+     * for no data)
+     */
+    BufferData,
+};
+
+enum class RecordObject : ALuint {
+    Source = 1,
+    Buffer,
+    Effect,
+    Filter,
+    EffectSlot,
+    Listener,
+};
+
+
+extern bool RecordEnabled;
+
+/* Opens the record file, if one is set. Must be called before any contexts
+ * are created.
+ */
+void RecordInit();
+
+void RecordCreateContext(ALCcontext *context);
+void RecordDestroyContext(ALCcontext *context);
+
+void RecordGen(ALCcontext *context, RecordObject obj, ALsizei n, const ALuint *ids);
+void RecordDelete(ALCcontext *context, RecordObject obj, ALsizei n, const ALuint *ids);
+void RecordParamfv(ALCcontext *context, RecordObject obj, ALuint id, ALenum param, ALsizei count,
+    const ALfloat *values);
+void RecordParamiv(ALCcontext *context, RecordObject obj, ALuint id, ALenum param, ALsizei count,
+    const ALint *values);
+void RecordParami64v(ALCcontext *context, RecordObject obj, ALuint id, ALenum param,
+    ALsizei count, const ALint64SOFT *values);
+
+void RecordStatef(ALCcontext *context, ALenum param, ALfloat value);
+void RecordStatei(ALCcontext *context, ALenum param, ALint value);
+void RecordCapability(ALCcontext *context, RecordCall call, ALenum capability);
+void RecordDeferUpdates(ALCcontext *context, RecordCall call);
+
+void RecordSourceOp(ALCcontext *context, RecordCall call, ALsizei n, const ALuint *sources);
+void RecordSourceQueue(ALCcontext *context, ALuint source, ALsizei n, const ALuint *buffers);
+void RecordSourceUnqueue(ALCcontext *context, ALuint source, ALsizei n);
+void RecordSourceUpdateBatch(ALCcontext *context, ALsizei count, const ALuint *sources,
+    const ALsourceUpdateSOFT *updates);
+
+void RecordBufferData(ALCcontext *context, ALuint buffer, ALenum format, const ALvoid *data,
+    ALsizei size, ALsizei freq);
+
+#endif /* CALLRECORD_H */
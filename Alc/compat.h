@@ -225,6 +225,37 @@ using ifstream = std::ifstream;
 struct PathNamePair { std::string path, fname; };
 const PathNamePair &GetProcBinary(void);
 
+/* A read-only view of a file's contents, shared with other processes mapping
+ * the same file. ptr is null if the file couldn't be mapped.
+ */
+struct FileMapping {
+    void *ptr;
+    size_t len;
+};
+FileMapping MapFileToMem(const char *fname);
+void UnmapFileMem(const FileMapping *mapping);
+/* Hints that the given range of a mapping will be read soon, so it can start
+ * being paged in.
+ */
+void PrefetchFileMem(const void *ptr, size_t len);
+
+/* Maps an existing named shared memory object for reading. The name is a
+ * plain identifier, without any path separators. Like the file mappings, it's
+ * unmapped with UnmapFileMem.
+ */
+FileMapping MapSharedMem(const char *name);
+/* Creates a named shared memory object holding a copy of the given data, and
+ * maps it for reading. Fails if the object already exists. The first 8 bytes
+ * are written last, so other processes checking for a header marker won't use
+ * partially written data.
+ */
+FileMapping CreateSharedMem(const char *name, const void *data, size_t len);
+/* Removes the name of a shared memory object created with CreateSharedMem.
+ * Existing mappings stay valid, and the object is freed once they're all
+ * unmapped.
+ */
+void UnlinkSharedMem(const char *name);
+
 #ifdef HAVE_DYNLOAD
 void *LoadLib(const char *name);
 void CloseLib(void *handle);
@@ -4,13 +4,30 @@
 #include "converter.h"
 
 #include <algorithm>
+#include <cmath>
+#include <limits>
 
 #include "fpu_modes.h"
+#include "ringbuffer.h"
 #include "mixer/defs.h"
 
 
 namespace {
 
+/* Weight of each new fill in the adaptive rate's smoothed fill. The fill jumps
+ * by the producer's and consumer's update sizes, so it's averaged over a
+ * couple dozen reads.
+ */
+constexpr ALdouble FillSmoothing{0.05};
+/* The adaptive rate's proportional gain (the rate change for the smoothed fill
+ * being off from the target by the target's size), its integral gain (how
+ * much that error adds to the lasting drift correction with each read), and
+ * the most the rate may change. Clock drift is usually well under 0.1%.
+ */
+constexpr ALdouble DriftGain{0.01};
+constexpr ALdouble DriftIntegralGain{0.00002};
+constexpr ALdouble MaxDriftAdjust{0.005};
+
 /* Base template left undefined. Should be marked =delete, but Clang 3.8.1
  * chokes on that given the inline specializations.
  */
@@ -61,6 +78,43 @@ void LoadSamples(ALfloat *dst, const ALvoid *src, size_t srcstep, DevFmtType src
 #undef HANDLE_FMT
 }
 
+/* Loads the sum of each frame's srcchans samples, scaled, to fold a channel
+ * conversion into the loading.
+ */
+template<DevFmtType T>
+inline void LoadMixedArray(ALfloat *RESTRICT dst, const void *src, ALsizei srcchans,
+    ALfloat scale, ALsizei frames)
+{
+    using SampleType = typename DevFmtTypeTraits<T>::Type;
+
+    const SampleType *ssrc = static_cast<const SampleType*>(src);
+    for(ALsizei i{0};i < frames;i++)
+    {
+        ALfloat sum{LoadSample<T>(ssrc[i*srcchans])};
+        for(ALsizei c{1};c < srcchans;c++)
+            sum += LoadSample<T>(ssrc[i*srcchans + c]);
+        dst[i] = sum * scale;
+    }
+}
+
+void LoadMixedSamples(ALfloat *dst, const ALvoid *src, ALsizei srcchans, DevFmtType srctype,
+    ALfloat scale, ALsizei frames)
+{
+#define HANDLE_FMT(T)                                                         \
+    case T: LoadMixedArray<T>(dst, src, srcchans, scale, frames); break
+    switch(srctype)
+    {
+        HANDLE_FMT(DevFmtByte);
+        HANDLE_FMT(DevFmtUByte);
+        HANDLE_FMT(DevFmtShort);
+        HANDLE_FMT(DevFmtUShort);
+        HANDLE_FMT(DevFmtInt);
+        HANDLE_FMT(DevFmtUInt);
+        HANDLE_FMT(DevFmtFloat);
+    }
+#undef HANDLE_FMT
+}
+
 
 template<DevFmtType T>
 inline typename DevFmtTypeTraits<T>::Type StoreSample(ALfloat);
@@ -94,21 +148,47 @@ inline void StoreSampleArray(void *dst, const ALfloat *RESTRICT src, size_t dsts
 }
 
 
-void StoreSamples(ALvoid *dst, const ALfloat *src, size_t dststep, DevFmtType dsttype, ALsizei samples)
+/* Stores numchans rows of samples as interleaved frames. */
+void StoreFrames(ALvoid *dst, const ALfloat *const *src, ALsizei numchans, DevFmtType dsttype,
+    ALsizei samples)
 {
-#define HANDLE_FMT(T)                                                         \
-    case T: StoreSampleArray<T>(dst, src, dststep, samples); break
     switch(dsttype)
     {
-        HANDLE_FMT(DevFmtByte);
-        HANDLE_FMT(DevFmtUByte);
-        HANDLE_FMT(DevFmtShort);
-        HANDLE_FMT(DevFmtUShort);
-        HANDLE_FMT(DevFmtInt);
-        HANDLE_FMT(DevFmtUInt);
-        HANDLE_FMT(DevFmtFloat);
+        /* The signed 16- and 32-bit and float types use the device's output
+         * kernel, which writes all the channels in one pass.
+         */
+        case DevFmtShort:
+        case DevFmtInt:
+        case DevFmtFloat:
+            StorePCMSamples(dst, src, numchans, numchans, dsttype, samples);
+            return;
+
+        case DevFmtByte:
+        case DevFmtUByte:
+        case DevFmtUShort:
+        case DevFmtUInt:
+            break;
     }
+
+    const ALsizei typesize{BytesFromDevFmt(dsttype)};
+    for(ALsizei c{0};c < numchans;c++)
+    {
+        ALvoid *chandst{static_cast<ALbyte*>(dst) + typesize*c};
+#define HANDLE_FMT(T)                                                         \
+    case T: StoreSampleArray<T>(chandst, src[c], numchans, samples); break
+        switch(dsttype)
+        {
+            HANDLE_FMT(DevFmtByte);
+            HANDLE_FMT(DevFmtUByte);
+            HANDLE_FMT(DevFmtUShort);
+            HANDLE_FMT(DevFmtUInt);
+            case DevFmtShort:
+            case DevFmtInt:
+            case DevFmtFloat:
+                break;
+        }
 #undef HANDLE_FMT
+    }
 }
 
 
@@ -135,39 +215,101 @@ void Stereo2Mono(ALfloat *RESTRICT dst, const void *src, ALsizei frames)
 
 } // namespace
 
-SampleConverterPtr CreateSampleConverter(DevFmtType srcType, DevFmtType dstType, ALsizei numchans,
-                                         ALsizei srcRate, ALsizei dstRate, Resampler resampler)
+SampleConverterPtr CreateSampleConverter(DevFmtType srcType, DevFmtType dstType,
+    ALsizei srcchans, ALsizei dstchans, ALsizei srcRate, ALsizei dstRate, Resampler resampler)
 {
-    if(numchans <= 0 || srcRate <= 0 || dstRate <= 0)
+    if(srcchans <= 0 || dstchans <= 0 || srcRate <= 0 || dstRate <= 0)
+        return nullptr;
+    if(srcchans != dstchans && !((srcchans == 1 && dstchans == 2) ||
+                                 (srcchans == 2 && dstchans == 1)))
+        return nullptr;
+    if(dstchans > MAX_OUTPUT_CHANNELS)
         return nullptr;
 
-    void *ptr{al_calloc(16, SampleConverter::Sizeof(numchans))};
+    /* A mono/stereo conversion only resamples the one channel. */
+    const ALsizei numchans{(srcchans == dstchans) ? dstchans : 1};
+    void *ptr{al_calloc(16, SampleConverter::Sizeof(static_cast<size_t>(numchans)))};
     SampleConverterPtr converter{new (ptr) SampleConverter{static_cast<size_t>(numchans)}};
     converter->mSrcType = srcType;
     converter->mDstType = dstType;
     converter->mSrcTypeSize = BytesFromDevFmt(srcType);
     converter->mDstTypeSize = BytesFromDevFmt(dstType);
+    converter->mSrcChans = srcchans;
+    converter->mDstChans = dstchans;
 
     converter->mSrcPrepCount = 0;
     converter->mFracOffset = 0;
+    converter->mResampler = resampler;
 
-    /* Have to set the mixer FPU mode since that's what the resampler code expects. */
-    FPUCtl mixer_mode{};
     auto step = static_cast<ALsizei>(
         mind(static_cast<ALdouble>(srcRate)/dstRate*FRACTIONONE + 0.5, MAX_PITCH*FRACTIONONE));
-    converter->mIncrement = maxi(step, 1);
-    if(converter->mIncrement == FRACTIONONE)
-        converter->mResample = Resample_<CopyTag,CTag>;
-    else
+    converter->setIncrement(step);
+
+    return converter;
+}
+
+void SampleConverter::setIncrement(ALsizei increment)
+{
+    increment = clampi(increment, 1, MAX_PITCH*FRACTIONONE);
+    if(increment == mIncrement)
+        return;
+    mIncrement = increment;
+
+    /* An adaptive rate keeps the resampler at 1:1, rather than switching to
+     * copying and back as the step wanders around it.
+     */
+    mResampleMulti = nullptr;
+    if(mIncrement == FRACTIONONE && !mAdaptive)
     {
-        if(resampler == BSinc24Resampler)
-            BsincPrepare(converter->mIncrement, &converter->mState.bsinc, &bsinc24);
-        else if(resampler == BSinc12Resampler)
-            BsincPrepare(converter->mIncrement, &converter->mState.bsinc, &bsinc12);
-        converter->mResample = SelectResampler(resampler);
+        mResample = Resample_<CopyTag,CTag>;
+        return;
     }
 
-    return converter;
+    /* Have to set the mixer FPU mode since that's what the resampler code expects. */
+    FPUCtl mixer_mode{};
+    if(mResampler == BSinc32Resampler)
+        BsincPrepare(mIncrement, &mState.bsinc, &bsinc32);
+    else if(mResampler == BSinc24Resampler)
+        BsincPrepare(mIncrement, &mState.bsinc, &bsinc24);
+    else if(mResampler == BSinc12Resampler)
+        BsincPrepare(mIncrement, &mState.bsinc, &bsinc12);
+    mResample = SelectResampler(mResampler, mIncrement);
+    if(mChan.size() > 1)
+        mResampleMulti = SelectMultiResampler(mResampler, mIncrement);
+}
+
+void SampleConverter::enableAdaptiveRate(ALsizei targetfill)
+{
+    if(!mAdaptive)
+        mBaseIncrement = mIncrement;
+    mAdaptive = true;
+    mTargetFill = maxi(targetfill, 1);
+    mFillAverage = mTargetFill;
+    mDriftCorrection = 0.0;
+    mFineIncrement = mBaseIncrement;
+    mIncrementError = 0.0;
+
+    /* Reselect the resampler for staying on it at 1:1. */
+    const ALsizei increment{mIncrement};
+    mIncrement = 0;
+    setIncrement(increment);
+}
+
+void SampleConverter::updateFill(size_t fill)
+{
+    if(!mAdaptive) return;
+
+    mFillAverage += (static_cast<ALdouble>(fill)-mFillAverage) * FillSmoothing;
+
+    /* Convert faster when the buffer is fuller than the target and slower
+     * when it's emptier, with the integral taking up the steady drift.
+     */
+    const ALdouble error{(mFillAverage-mTargetFill) / mTargetFill};
+    mDriftCorrection = clampd(mDriftCorrection + error*DriftIntegralGain, -MaxDriftAdjust,
+        MaxDriftAdjust);
+    const ALdouble adjust{clampd(mDriftCorrection + error*DriftGain, -MaxDriftAdjust,
+        MaxDriftAdjust)};
+    mFineIncrement = mBaseIncrement * (1.0+adjust);
 }
 
 ALsizei SampleConverter::availableOut(ALsizei srcframes) const
@@ -201,18 +343,35 @@ ALsizei SampleConverter::availableOut(ALsizei srcframes) const
     DataSize64 <<= FRACTIONBITS;
     DataSize64 -= mFracOffset;
 
-    /* If we have a full prep, we can generate at least one sample. */
-    return static_cast<ALsizei>(clampu64((DataSize64 + mIncrement-1)/mIncrement, 1, BUFFERSIZE));
+    /* If we have a full prep, we can generate at least one sample. This isn't
+     * limited to one pass of convert, so a capture device can report all of
+     * its converted samples as available.
+     */
+    return static_cast<ALsizei>(clampu64((DataSize64 + mIncrement-1)/mIncrement, 1,
+        static_cast<uint64_t>(std::numeric_limits<ALsizei>::max())));
 }
 
 ALsizei SampleConverter::convert(const ALvoid **src, ALsizei *srcframes, ALvoid *dst, ALsizei dstframes)
 {
-    const ALsizei SrcFrameSize{static_cast<ALsizei>(mChan.size()) * mSrcTypeSize};
-    const ALsizei DstFrameSize{static_cast<ALsizei>(mChan.size()) * mDstTypeSize};
-    const ALsizei increment{mIncrement};
+    const ALsizei SrcFrameSize{mSrcChans * mSrcTypeSize};
+    const ALsizei DstFrameSize{mDstChans * mDstTypeSize};
+    const auto numchans = static_cast<ALsizei>(mChan.size());
     auto SamplesIn = static_cast<const ALbyte*>(*src);
     ALsizei NumSrcSamples{*srcframes};
 
+    /* A mono/stereo conversion is folded into the loading, with the same
+     * scaling as the ChannelConverter.
+     */
+    auto load_channel = [this](ALfloat *dstbuf, const ALbyte *input, ALsizei chan,
+        ALsizei count) -> void
+    {
+        if(mSrcChans == mDstChans)
+            LoadSamples(dstbuf, input + mSrcTypeSize*chan, static_cast<size_t>(mSrcChans),
+                mSrcType, count);
+        else
+            LoadMixedSamples(dstbuf, input, mSrcChans, mSrcType, 0.707106781187f, count);
+    };
+
     FPUCtl mixer_mode{};
     ALsizei pos{0};
     while(pos < dstframes && NumSrcSamples > 0)
@@ -232,7 +391,15 @@ ALsizei SampleConverter::convert(const ALvoid **src, ALsizei *srcframes, ALvoid
             mSrcPrepCount = 0;
             continue;
         }
-        ALint toread{mini(NumSrcSamples, BUFFERSIZE - MAX_RESAMPLE_PADDING*2)};
+        /* With an adaptive rate, take the whole step closest to the fine one
+         * plus what the previous passes were off by.
+         */
+        if(mAdaptive)
+            setIncrement(static_cast<ALsizei>(
+                std::floor(mFineIncrement + mIncrementError/AdaptiveBlockSize + 0.5)));
+        const ALsizei increment{mIncrement};
+
+        ALint toread{mini(NumSrcSamples, BlockSize - MAX_RESAMPLE_PADDING*2)};
 
         if(prepcount < MAX_RESAMPLE_PADDING*2 &&
            MAX_RESAMPLE_PADDING*2 - prepcount >= toread)
@@ -240,17 +407,14 @@ ALsizei SampleConverter::convert(const ALvoid **src, ALsizei *srcframes, ALvoid
             /* Not enough input samples to generate an output sample. Store
              * what we're given for later.
              */
-            for(size_t chan{0u};chan < mChan.size();chan++)
-                LoadSamples(&mChan[chan].PrevSamples[prepcount], SamplesIn + mSrcTypeSize*chan,
-                    mChan.size(), mSrcType, toread);
+            for(ALsizei chan{0};chan < numchans;chan++)
+                load_channel(&mChan[chan].PrevSamples[prepcount], SamplesIn, chan, toread);
 
             mSrcPrepCount = prepcount + toread;
             NumSrcSamples = 0;
             break;
         }
 
-        ALfloat *RESTRICT SrcData{mSrcSamples};
-        ALfloat *RESTRICT DstData{mDstSamples};
         ALsizei DataPosFrac{mFracOffset};
         auto DataSize64 = static_cast<uint64_t>(prepcount);
         DataSize64 += toread;
@@ -260,41 +424,61 @@ ALsizei SampleConverter::convert(const ALvoid **src, ALsizei *srcframes, ALvoid
 
         /* If we have a full prep, we can generate at least one sample. */
         auto DstSize = static_cast<ALsizei>(
-            clampu64((DataSize64 + increment-1)/increment, 1, BUFFERSIZE));
+            clampu64((DataSize64 + increment-1)/increment, 1, BlockSize));
         DstSize = mini(DstSize, dstframes-pos);
+        if(mAdaptive)
+        {
+            DstSize = mini(DstSize, AdaptiveBlockSize);
+            mIncrementError += (mFineIncrement-increment) * DstSize;
+        }
 
-        for(size_t chan{0u};chan < mChan.size();chan++)
+        const ALsizei SrcDataEnd{(DstSize*increment + DataPosFrac)>>FRACTIONBITS};
+        const ALfloat *SrcRows[MAX_OUTPUT_CHANNELS];
+        ALfloat *DstRows[MAX_OUTPUT_CHANNELS];
+        for(ALsizei chan{0};chan < numchans;chan++)
         {
-            const ALbyte *SrcSamples = SamplesIn + mSrcTypeSize*chan;
-            ALbyte *DstSamples = static_cast<ALbyte*>(dst) + mDstTypeSize*chan;
+            ChanSamples &samples = mChan[chan];
 
             /* Load the previous samples into the source data first, then the
              * new samples from the input buffer.
              */
-            std::copy_n(mChan[chan].PrevSamples, prepcount, SrcData);
-            LoadSamples(SrcData + prepcount, SrcSamples, mChan.size(), mSrcType, toread);
+            std::copy_n(samples.PrevSamples, prepcount, samples.SrcSamples);
+            load_channel(samples.SrcSamples + prepcount, SamplesIn, chan, toread);
 
             /* Store as many prep samples for next time as possible, given the
              * number of output samples being generated.
              */
-            ALsizei SrcDataEnd{(DstSize*increment + DataPosFrac)>>FRACTIONBITS};
             if(SrcDataEnd >= prepcount+toread)
-                std::fill(std::begin(mChan[chan].PrevSamples),
-                          std::end(mChan[chan].PrevSamples), 0.0f);
+                std::fill(std::begin(samples.PrevSamples), std::end(samples.PrevSamples), 0.0f);
             else
             {
                 size_t len = mini(MAX_RESAMPLE_PADDING*2, prepcount+toread-SrcDataEnd);
-                std::copy_n(SrcData+SrcDataEnd, len, mChan[chan].PrevSamples);
-                std::fill(std::begin(mChan[chan].PrevSamples)+len,
-                          std::end(mChan[chan].PrevSamples), 0.0f);
+                std::copy_n(samples.SrcSamples+SrcDataEnd, len, samples.PrevSamples);
+                std::fill(std::begin(samples.PrevSamples)+len, std::end(samples.PrevSamples),
+                    0.0f);
             }
 
-            /* Now resample, and store the result in the output buffer. */
-            const ALfloat *ResampledData{mResample(&mState, SrcData+MAX_RESAMPLE_PADDING,
-                DataPosFrac, increment, DstData, DstSize)};
+            SrcRows[chan] = samples.SrcSamples + MAX_RESAMPLE_PADDING;
+            DstRows[chan] = samples.DstSamples;
+        }
 
-            StoreSamples(DstSamples, ResampledData, mChan.size(), mDstType, DstSize);
+        /* Now resample, with the channels sharing the filter calculations when
+         * possible, and store the result in the output buffer (repeating the
+         * one channel for mono-to-stereo).
+         */
+        const ALfloat *ResampledRows[MAX_OUTPUT_CHANNELS];
+        if(mResampleMulti)
+        {
+            mResampleMulti(&mState, SrcRows, numchans, DataPosFrac, increment, DstRows,
+                DstSize);
+            std::copy_n(DstRows, numchans, ResampledRows);
         }
+        else for(ALsizei chan{0};chan < numchans;chan++)
+            ResampledRows[chan] = mResample(&mState, SrcRows[chan], DataPosFrac, increment,
+                DstRows[chan], DstSize);
+        for(ALsizei chan{numchans};chan < mDstChans;chan++)
+            ResampledRows[chan] = ResampledRows[0];
+        StoreFrames(dst, ResampledRows, mDstChans, mDstType, DstSize);
 
         /* Update the number of prep samples still available, as well as the
          * fractional offset.
@@ -304,9 +488,13 @@ ALsizei SampleConverter::convert(const ALvoid **src, ALsizei *srcframes, ALvoid
             MAX_RESAMPLE_PADDING*2);
         mFracOffset = DataPosFrac & FRACTIONMASK;
 
-        /* Update the src and dst pointers in case there's still more to do. */
-        SamplesIn += SrcFrameSize*(DataPosFrac>>FRACTIONBITS);
-        NumSrcSamples -= mini(NumSrcSamples, (DataPosFrac>>FRACTIONBITS));
+        /* Update the src and dst pointers in case there's still more to do.
+         * The input read is what was stepped over, less the old prep samples
+         * it started with, plus what was kept for the next prep.
+         */
+        const ALsizei srcread{(DataPosFrac>>FRACTIONBITS) + mSrcPrepCount - prepcount};
+        SamplesIn += SrcFrameSize*srcread;
+        NumSrcSamples -= mini(NumSrcSamples, srcread);
 
         dst = static_cast<ALbyte*>(dst) + DstFrameSize*DstSize;
         pos += DstSize;
@@ -367,3 +555,82 @@ void ChannelConverter::convert(const ALvoid *src, ALfloat *dst, ALsizei frames)
         }
     }
 }
+
+
+ALsizei ConvertCaptureRing(RingBuffer *ring, const ChannelConverter *chanconv,
+    SampleConverter *sampleconv, ALvoid *dst, ALsizei dstframes)
+{
+    if(!chanconv && !sampleconv)
+        return static_cast<ALsizei>(ring->read(dst, static_cast<size_t>(dstframes)));
+    if(sampleconv && sampleconv->mAdaptive)
+        sampleconv->updateFill(ring->readSpace());
+
+    const size_t srcframesize{ring->mElemSize};
+    const ALsizei dstframesize{sampleconv ?
+        sampleconv->mDstChans * sampleconv->mDstTypeSize :
+        ChannelsFromDevFmt(chanconv->mDstChans, 0) * static_cast<ALsizei>(sizeof(ALfloat))};
+    auto output = static_cast<ALbyte*>(dst);
+
+    /* Converts what it can of a block of ring data, returning the number of
+     * frames used. The channel converter is stateless, so its output for
+     * frames the sample converter didn't take is simply discarded, leaving
+     * them in the ring to be converted again next time.
+     */
+    ALsizei got{0};
+    auto convert_block = [=,&output,&got](const ll_ringbuffer_data &block) -> size_t
+    {
+        const ALvoid *srcdata{block.buf};
+        auto srcframes = static_cast<ALsizei>(minz(block.len,
+            static_cast<size_t>(std::numeric_limits<ALsizei>::max())));
+        if(!chanconv)
+        {
+            const ALsizei total{srcframes};
+            const ALsizei done{sampleconv->convert(&srcdata, &srcframes, output, dstframes-got)};
+            output += done*dstframesize;
+            got += done;
+            return static_cast<size_t>(total - srcframes);
+        }
+
+        alignas(16) ALfloat samples[BUFFERSIZE*2];
+        size_t used{0};
+        while(srcframes > 0 && got < dstframes)
+        {
+            if(!sampleconv)
+            {
+                const ALsizei todo{mini(srcframes, dstframes-got)};
+                chanconv->convert(srcdata, reinterpret_cast<ALfloat*>(output), todo);
+                output += todo*dstframesize;
+                got += todo;
+                used += static_cast<size_t>(todo);
+                srcdata = static_cast<const ALbyte*>(srcdata) + todo*srcframesize;
+                srcframes -= todo;
+                continue;
+            }
+
+            const ALsizei todo{mini(srcframes, BUFFERSIZE)};
+            chanconv->convert(srcdata, samples, todo);
+
+            const ALvoid *convdata{samples};
+            ALsizei convframes{todo};
+            const ALsizei done{sampleconv->convert(&convdata, &convframes, output,
+                dstframes-got)};
+            output += done*dstframesize;
+            got += done;
+
+            const ALsizei usedframes{todo - convframes};
+            used += static_cast<size_t>(usedframes);
+            srcdata = static_cast<const ALbyte*>(srcdata) + usedframes*srcframesize;
+            srcframes -= usedframes;
+            if(convframes > 0) break;
+        }
+        return used;
+    };
+
+    auto rec_vec = ring->getReadVector();
+    size_t total_read{convert_block(rec_vec.first)};
+    if(got < dstframes && total_read == rec_vec.first.len && rec_vec.second.len > 0)
+        total_read += convert_block(rec_vec.second);
+    ring->readAdvance(total_read);
+
+    return got;
+}
@@ -7,24 +7,58 @@
 #include "alu.h"
 #include "almalloc.h"
 
+struct RingBuffer;
+
 struct SampleConverter {
+    /* Frames resampled per pass, in and out. This is several mixer updates'
+     * worth, so a capture read usually only needs one or two passes.
+     */
+    static constexpr ALsizei BlockSize{BUFFERSIZE*4};
+    /* Most frames written per pass with an adaptive rate, so the step can be
+     * changed often enough to follow a finer rate than it can hold.
+     */
+    static constexpr ALsizei AdaptiveBlockSize{256};
+
     DevFmtType mSrcType{};
     DevFmtType mDstType{};
     ALsizei mSrcTypeSize{};
     ALsizei mDstTypeSize{};
+    /* Channels in each source and destination frame. These differ for a
+     * mono/stereo conversion, which only resamples one channel.
+     */
+    ALsizei mSrcChans{};
+    ALsizei mDstChans{};
 
     ALint mSrcPrepCount{};
 
     ALsizei mFracOffset{};
     ALsizei mIncrement{};
+    /* Resampler used for steps other than 1:1, kept for changing the step. */
+    Resampler mResampler{};
     InterpState mState{};
     ResamplerFunc mResample{};
-
-    alignas(16) ALfloat mSrcSamples[BUFFERSIZE]{};
-    alignas(16) ALfloat mDstSamples[BUFFERSIZE]{};
+    /* Null if the resampler has no multi-channel version, or there's only
+     * one channel to resample.
+     */
+    ResamplerMultiFunc mResampleMulti{};
+
+    /* With an adaptive rate, the input is read from a buffer filled from
+     * another clock domain, and the rate is steered by a PI controller to
+     * hold the buffer's fill near a target. The fine step it wants is spread
+     * over the passes as whole steps, carrying the difference between them.
+     */
+    bool mAdaptive{false};
+    ALsizei mBaseIncrement{};
+    ALdouble mTargetFill{};
+    ALdouble mFillAverage{};
+    ALdouble mDriftCorrection{};
+    ALdouble mFineIncrement{};
+    ALdouble mIncrementError{};
 
     struct ChanSamples {
         alignas(16) ALfloat PrevSamples[MAX_RESAMPLE_PADDING*2];
+        alignas(16) ALfloat SrcSamples[BlockSize];
+        alignas(16) ALfloat DstSamples[BlockSize];
     };
     al::FlexArray<ChanSamples> mChan;
 
@@ -35,6 +69,19 @@ struct SampleConverter {
     ALsizei convert(const ALvoid **src, ALsizei *srcframes, ALvoid *dst, ALsizei dstframes);
     ALsizei availableOut(ALsizei srcframes) const;
 
+    /* Changes the resampling step (in FRACTIONBITS fixed point) between
+     * passes.
+     */
+    void setIncrement(ALsizei increment);
+
+    /* Makes the rate adaptive, for holding the fill of the buffer the input is
+     * read from at targetfill frames. The fill needs to be given to
+     * updateFill before each conversion (ConvertCaptureRing does this for its
+     * ring). The rate is changed by at most MaxDriftAdjust from the nominal.
+     */
+    void enableAdaptiveRate(ALsizei targetfill);
+    void updateFill(size_t fill);
+
     static constexpr size_t Sizeof(size_t length) noexcept
     {
         return maxz(sizeof(SampleConverter),
@@ -45,8 +92,11 @@ struct SampleConverter {
 };
 using SampleConverterPtr = std::unique_ptr<SampleConverter>;
 
-SampleConverterPtr CreateSampleConverter(DevFmtType srcType, DevFmtType dstType, ALsizei numchans,
-    ALsizei srcRate, ALsizei dstRate, Resampler resampler);
+/* Creates a converter from srcchans to dstchans channels, which must match
+ * or be a mono/stereo conversion.
+ */
+SampleConverterPtr CreateSampleConverter(DevFmtType srcType, DevFmtType dstType,
+    ALsizei srcchans, ALsizei dstchans, ALsizei srcRate, ALsizei dstRate, Resampler resampler);
 
 
 struct ChannelConverter {
@@ -67,4 +117,14 @@ using ChannelConverterPtr = std::unique_ptr<ChannelConverter>;
 ChannelConverterPtr CreateChannelConverter(DevFmtType srcType, DevFmtChannels srcChans,
     DevFmtChannels dstChans);
 
+
+/* Reads up to dstframes frames from a capture ring buffer holding the
+ * device's native samples, converting them straight into dst, and returns
+ * the number written. The ring only advances past the source frames that were
+ * used. Either converter may be null; with both, the channel converter's
+ * output is the sample converter's (float) input.
+ */
+ALsizei ConvertCaptureRing(RingBuffer *ring, const ChannelConverter *chanconv,
+    SampleConverter *sampleconv, ALvoid *dst, ALsizei dstframes);
+
 #endif /* CONVERTER_H */
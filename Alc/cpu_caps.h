@@ -12,6 +12,10 @@ enum {
     CPU_CAP_SSE3   = 1<<2,
     CPU_CAP_SSE4_1 = 1<<3,
     CPU_CAP_NEON   = 1<<4,
+    CPU_CAP_AVX2   = 1<<5,
+    CPU_CAP_FMA    = 1<<6,
+    CPU_CAP_AVX512F = 1<<7,
+    CPU_CAP_F16C   = 1<<8,
 };
 
 void FillCPUCaps(int capfilter);
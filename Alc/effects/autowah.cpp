@@ -23,6 +23,10 @@
 #include <cmath>
 #include <cstdlib>
 
+#ifdef HAVE_SSE_INTRINSICS
+#include <xmmintrin.h>
+#endif
+
 #include <algorithm>
 
 #include "alMain.h"
@@ -39,6 +43,11 @@ namespace {
 #define MAX_FREQ 2500.0f
 #define Q_FACTOR 5.0f
 
+/* The number of samples between calculations of the filter's frequency from
+ * the envelope. The filter coefficients are linearly interpolated in between.
+ */
+#define COEFF_STEP 16
+
 struct ALautowahState final : public EffectState {
     /* Effect parameters */
     ALfloat mAttackRate;
@@ -49,10 +58,18 @@ struct ALautowahState final : public EffectState {
     ALfloat mBandwidthNorm;
     ALfloat mEnvDelay;
 
-    /* Filter components derived from the envelope. */
+    /* The cos and alpha components at the last calculated point, which the
+     * next are interpolated from.
+     */
+    ALfloat mLastCos;
+    ALfloat mLastAlpha;
+
+    /* Normalized filter coefficients derived from the envelope, shared by
+     * all channels. The a1 coefficient for a peaking filter is the same as
+     * b1.
+     */
     struct {
-        ALfloat cos_w0;
-        ALfloat alpha;
+        ALfloat b0, b1, b2, a2;
     } mEnv[BUFFERSIZE];
 
     struct {
@@ -66,10 +83,13 @@ struct ALautowahState final : public EffectState {
         ALfloat TargetGains[MAX_OUTPUT_CHANNELS];
     } mChans[MAX_AMBI_CHANNELS];
 
-    /* Effects buffers */
-    alignas(16) ALfloat mBufferOut[BUFFERSIZE];
+    /* Effects buffers, for up to four channels filtered together. */
+    alignas(16) ALfloat mBufferOut[4][BUFFERSIZE];
 
 
+    void filterChannel(const ALsizei c, const ALfloat *RESTRICT src, ALfloat *RESTRICT dst,
+        const ALsizei samplesToDo);
+
     ALboolean deviceUpdate(const ALCdevice *device) override;
     void update(const ALCcontext *context, const ALeffectslot *slot, const EffectProps *props, const EffectTarget target) override;
     void process(ALsizei samplesToDo, const ALfloat (*RESTRICT samplesIn)[BUFFERSIZE], const ALsizei numInput, ALfloat (*RESTRICT samplesOut)[BUFFERSIZE], const ALsizei numOutput) override;
@@ -89,10 +109,18 @@ ALboolean ALautowahState::deviceUpdate(const ALCdevice *UNUSED(device))
     mBandwidthNorm = 0.05f;
     mEnvDelay      = 0.0f;
 
+    /* Start from a filter that passes everything (w0 = 0), to quickly
+     * interpolate to the envelope's.
+     */
+    mLastCos   = 1.0f;
+    mLastAlpha = 0.0f;
+
     for(auto &e : mEnv)
     {
-        e.cos_w0 = 0.0f;
-        e.alpha = 0.0f;
+        e.b0 = 1.0f;
+        e.b1 = 0.0f;
+        e.b2 = 0.0f;
+        e.a2 = 0.0f;
     }
 
     for(auto &chan : mChans)
@@ -111,13 +139,13 @@ void ALautowahState::update(const ALCcontext *context, const ALeffectslot *slot,
 
     const ALfloat ReleaseTime{clampf(props->Autowah.ReleaseTime, 0.001f, 1.0f)};
 
-    mAttackRate    = expf(-1.0f / (props->Autowah.AttackTime*device->Frequency));
-    mReleaseRate   = expf(-1.0f / (ReleaseTime*device->Frequency));
+    mAttackRate    = expf(-1.0f / (props->Autowah.AttackTime*device->MixFrequency));
+    mReleaseRate   = expf(-1.0f / (ReleaseTime*device->MixFrequency));
     /* 0-20dB Resonance Peak gain */
     mResonanceGain = std::sqrt(std::log10(props->Autowah.Resonance)*10.0f / 3.0f);
     mPeakGain      = 1.0f - std::log10(props->Autowah.PeakGain/AL_AUTOWAH_MAX_PEAK_GAIN);
-    mFreqMinNorm   = MIN_FREQ / device->Frequency;
-    mBandwidthNorm = (MAX_FREQ-MIN_FREQ) / device->Frequency;
+    mFreqMinNorm   = MIN_FREQ / device->MixFrequency;
+    mBandwidthNorm = (MAX_FREQ-MIN_FREQ) / device->MixFrequency;
 
     mOutBuffer = target.Main->Buffer;
     mOutChannels = target.Main->NumChannels;
@@ -128,6 +156,24 @@ void ALautowahState::update(const ALCcontext *context, const ALeffectslot *slot,
     }
 }
 
+/* Runs one channel's filter with the envelope's coefficients. */
+void ALautowahState::filterChannel(const ALsizei c, const ALfloat *RESTRICT src,
+    ALfloat *RESTRICT dst, const ALsizei samplesToDo)
+{
+    ALfloat z1{mChans[c].Filter.z1};
+    ALfloat z2{mChans[c].Filter.z2};
+    for(ALsizei i{0};i < samplesToDo;i++)
+    {
+        const ALfloat input{src[i]};
+        const ALfloat output{input*mEnv[i].b0 + z1};
+        z1 = input*mEnv[i].b1 - output*mEnv[i].b1 + z2;
+        z2 = input*mEnv[i].b2 - output*mEnv[i].a2;
+        dst[i] = output;
+    }
+    mChans[c].Filter.z1 = z1;
+    mChans[c].Filter.z2 = z2;
+}
+
 void ALautowahState::process(ALsizei samplesToDo, const ALfloat (*RESTRICT samplesIn)[BUFFERSIZE], const ALsizei numInput, ALfloat (*RESTRICT samplesOut)[BUFFERSIZE], const ALsizei numOutput)
 {
     const ALfloat attack_rate = mAttackRate;
@@ -136,66 +182,127 @@ void ALautowahState::process(ALsizei samplesToDo, const ALfloat (*RESTRICT sampl
     const ALfloat peak_gain = mPeakGain;
     const ALfloat freq_min = mFreqMinNorm;
     const ALfloat bandwidth = mBandwidthNorm;
-    ALfloat env_delay;
-    ALsizei c, i;
+    ALfloat env_delay{mEnvDelay};
+    ALfloat last_cos{mLastCos};
+    ALfloat last_alpha{mLastAlpha};
 
-    env_delay = mEnvDelay;
-    for(i = 0;i < samplesToDo;i++)
+    for(ALsizei base{0};base < samplesToDo;)
     {
-        ALfloat w0, sample, a;
+        const ALsizei todo{mini(COEFF_STEP, samplesToDo-base)};
 
         /* Envelope follower described on the book: Audio Effects, Theory,
          * Implementation and Application.
          */
-        sample = peak_gain * std::fabs(samplesIn[0][i]);
-        a = (sample > env_delay) ? attack_rate : release_rate;
-        env_delay = lerp(sample, env_delay, a);
-
-        /* Calculate the cos and alpha components for this sample's filter. */
-        w0 = minf((bandwidth*env_delay + freq_min), 0.46f) * al::MathDefs<float>::Tau();
-        mEnv[i].cos_w0 = cosf(w0);
-        mEnv[i].alpha = sinf(w0)/(2.0f * Q_FACTOR);
+        for(ALsizei i{0};i < todo;i++)
+        {
+            const ALfloat sample{peak_gain * std::fabs(samplesIn[0][base+i])};
+            const ALfloat a{(sample > env_delay) ? attack_rate : release_rate};
+            env_delay = lerp(sample, env_delay, a);
+        }
+
+        /* Calculate the cos and alpha components for the filter at the end
+         * of this step.
+         */
+        const ALfloat w0{minf((bandwidth*env_delay + freq_min), 0.46f) *
+            al::MathDefs<float>::Tau()};
+        const ALfloat cos_w0{std::cos(w0)};
+        const ALfloat alpha{std::sin(w0)/(2.0f * Q_FACTOR)};
+
+        /* This effectively inlines BiquadFilter_setParams for a peaking
+         * filter, with the components interpolated up to this step's.
+         */
+        const ALfloat scale{1.0f / static_cast<ALfloat>(todo)};
+        for(ALsizei i{0};i < todo;i++)
+        {
+            const ALfloat mu{static_cast<ALfloat>(i+1) * scale};
+            const ALfloat c{lerp(last_cos, cos_w0, mu)};
+            const ALfloat al{lerp(last_alpha, alpha, mu)};
+            const ALfloat a0_inv{1.0f / (1.0f + al/res_gain)};
+
+            mEnv[base+i].b0 = (1.0f + al*res_gain) * a0_inv;
+            mEnv[base+i].b1 = -2.0f * c * a0_inv;
+            mEnv[base+i].b2 = (1.0f - al*res_gain) * a0_inv;
+            mEnv[base+i].a2 = (1.0f - al/res_gain) * a0_inv;
+        }
+        last_cos = cos_w0;
+        last_alpha = alpha;
+
+        base += todo;
     }
     mEnvDelay = env_delay;
+    mLastCos = last_cos;
+    mLastAlpha = last_alpha;
 
     ASSUME(numInput > 0);
-    for(c = 0;c < numInput;++c)
+    for(ALsizei c{0};c < numInput;c += 4)
     {
-        /* This effectively inlines BiquadFilter_setParams for a peaking
-         * filter and BiquadFilter_processC. The alpha and cosine components
-         * for the filter coefficients were previously calculated with the
-         * envelope. Because the filter changes for each sample, the
-         * coefficients are transient and don't need to be held.
+        const ALsizei numchans{mini(numInput-c, 4)};
+        ALsizei i{0};
+#ifdef HAVE_SSE_INTRINSICS
+        /* Filter four channels together, each in a lane of a vector, since
+         * they all use the same coefficients. Blocks of four samples are
+         * transposed in and out so each vector holds one sample frame.
          */
-        ALfloat z1 = mChans[c].Filter.z1;
-        ALfloat z2 = mChans[c].Filter.z2;
-
-        for(i = 0;i < samplesToDo;i++)
+        if(numchans == 4)
+        {
+            __m128 z1{_mm_setr_ps(mChans[c].Filter.z1, mChans[c+1].Filter.z1,
+                mChans[c+2].Filter.z1, mChans[c+3].Filter.z1)};
+            __m128 z2{_mm_setr_ps(mChans[c].Filter.z2, mChans[c+1].Filter.z2,
+                mChans[c+2].Filter.z2, mChans[c+3].Filter.z2)};
+            auto proc_frame = [this,&z1,&z2](const __m128 input, const ALsizei idx) noexcept
+                -> __m128
+            {
+                const __m128 b0{_mm_set1_ps(mEnv[idx].b0)};
+                const __m128 b1{_mm_set1_ps(mEnv[idx].b1)};
+                const __m128 b2{_mm_set1_ps(mEnv[idx].b2)};
+                const __m128 a2{_mm_set1_ps(mEnv[idx].a2)};
+                const __m128 output{_mm_add_ps(_mm_mul_ps(input, b0), z1)};
+                z1 = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(input, b1), _mm_mul_ps(output, b1)), z2);
+                z2 = _mm_sub_ps(_mm_mul_ps(input, b2), _mm_mul_ps(output, a2));
+                return output;
+            };
+            for(;samplesToDo-i >= 4;i += 4)
+            {
+                __m128 f0{_mm_loadu_ps(&samplesIn[c  ][i])};
+                __m128 f1{_mm_loadu_ps(&samplesIn[c+1][i])};
+                __m128 f2{_mm_loadu_ps(&samplesIn[c+2][i])};
+                __m128 f3{_mm_loadu_ps(&samplesIn[c+3][i])};
+                _MM_TRANSPOSE4_PS(f0, f1, f2, f3);
+                f0 = proc_frame(f0, i);
+                f1 = proc_frame(f1, i+1);
+                f2 = proc_frame(f2, i+2);
+                f3 = proc_frame(f3, i+3);
+                _MM_TRANSPOSE4_PS(f0, f1, f2, f3);
+                _mm_store_ps(&mBufferOut[0][i], f0);
+                _mm_store_ps(&mBufferOut[1][i], f1);
+                _mm_store_ps(&mBufferOut[2][i], f2);
+                _mm_store_ps(&mBufferOut[3][i], f3);
+            }
+            alignas(16) ALfloat z[2][4];
+            _mm_store_ps(z[0], z1);
+            _mm_store_ps(z[1], z2);
+            for(ALsizei l{0};l < 4;l++)
+            {
+                mChans[c+l].Filter.z1 = z[0][l];
+                mChans[c+l].Filter.z2 = z[1][l];
+            }
+        }
+#endif
+        if(i < samplesToDo)
         {
-            const ALfloat alpha = mEnv[i].alpha;
-            const ALfloat cos_w0 = mEnv[i].cos_w0;
-            ALfloat input, output;
-            ALfloat a[3], b[3];
-
-            b[0] =  1.0f + alpha*res_gain;
-            b[1] = -2.0f * cos_w0;
-            b[2] =  1.0f - alpha*res_gain;
-            a[0] =  1.0f + alpha/res_gain;
-            a[1] = -2.0f * cos_w0;
-            a[2] =  1.0f - alpha/res_gain;
-
-            input = samplesIn[c][i];
-            output = input*(b[0]/a[0]) + z1;
-            z1 = input*(b[1]/a[0]) - output*(a[1]/a[0]) + z2;
-            z2 = input*(b[2]/a[0]) - output*(a[2]/a[0]);
-            mBufferOut[i] = output;
+            /* filterChannel works from the start of the envelope, so the
+             * remaining samples' coefficients are moved there.
+             */
+            if(i > 0)
+                std::copy(std::begin(mEnv)+i, std::begin(mEnv)+samplesToDo, std::begin(mEnv));
+            for(ALsizei l{0};l < numchans;l++)
+                filterChannel(c+l, &samplesIn[c+l][i], &mBufferOut[l][i], samplesToDo-i);
         }
-        mChans[c].Filter.z1 = z1;
-        mChans[c].Filter.z2 = z2;
 
         /* Now, mix the processed sound data to the output. */
-        MixSamples(mBufferOut, numOutput, samplesOut, mChans[c].CurrentGains,
-            mChans[c].TargetGains, samplesToDo, 0, samplesToDo);
+        for(ALsizei l{0};l < numchans;l++)
+            MixSamples(mBufferOut[l], numOutput, samplesOut, mChans[c+l].CurrentGains,
+                mChans[c+l].TargetGains, samplesToDo, 0, samplesToDo);
     }
 }
 
@@ -1,13 +1,19 @@
 #ifndef EFFECTS_BASE_H
 #define EFFECTS_BASE_H
 
+#include <algorithm>
+#include <array>
+#include <memory>
+
 #include "alMain.h"
 
 #include "almalloc.h"
 #include "atomic.h"
+#include "vector.h"
 
 
 struct ALeffectslot;
+struct ALbuffer;
 
 
 union EffectProps {
@@ -140,15 +146,86 @@ struct EffectTarget {
     RealMixParams *RealOut;
 };
 
+/* Decimates an effect's input to half the mixing rate, and interpolates its
+ * output back up, for effect states that process at half rate. Both sides use
+ * a 63-tap half-band filter, together delaying the output by 63 samples (at
+ * the mixing rate). The mixer calls these around the state's process method.
+ */
+struct EffectHalfRate {
+    /* Non-zero taps on each side of the filter's center. */
+    static constexpr ALsizei FilterTaps{16};
+    static constexpr ALsizei InHistory{FilterTaps*4 - 2};
+    static constexpr ALsizei OutHistory{FilterTaps*2 - 1};
+    static constexpr ALuint Latency{FilterTaps*4 - 1};
+
+    /* The half-rate samples given to and taken from the effect. */
+    al::vector<std::array<ALfloat,BUFFERSIZE>,16> mSamplesIn;
+    al::vector<std::array<ALfloat,BUFFERSIZE>,16> mSamplesOut;
+
+    /* Full-rate input samples not yet decimated (mInCount of them), and
+     * half-rate output samples kept for the interpolation filter.
+     */
+    al::vector<std::array<ALfloat,InHistory+BUFFERSIZE>,16> mInLines;
+    al::vector<std::array<ALfloat,OutHistory+BUFFERSIZE/2+1>,16> mOutLines;
+    ALsizei mInCount{InHistory};
+
+    /* An interpolated sample that didn't fit in the last update's output. */
+    al::vector<ALfloat,16> mCarry;
+    bool mHasCarry{false};
+
+    /* Resizes for the given channel counts, and clears the filter history. */
+    void reset(const ALsizei numInput, const ALsizei numOutput);
+
+    /* Decimates the input into mSamplesIn, and clears mSamplesOut, returning
+     * the number of half-rate samples to process.
+     */
+    ALsizei decimate(const ALfloat (*RESTRICT samplesIn)[BUFFERSIZE], const ALsizei numInput,
+        const ALsizei samplesToDo);
+    /* Interpolates the half-rate samples in mSamplesOut, adding them to the
+     * output.
+     */
+    void interpolate(ALfloat (*RESTRICT samplesOut)[BUFFERSIZE], const ALsizei numOutput,
+        const ALsizei samplesToDo, const ALsizei halfToDo);
+
+    DEF_NEWDEL(EffectHalfRate)
+};
+
 struct EffectState {
     RefCount mRef{1u};
 
     ALfloat (*mOutBuffer)[BUFFERSIZE]{nullptr};
     ALsizei mOutChannels{0};
+    /* Set by the mixer after an update, from the target mOutBuffer is in. */
+    ChannelMask *mOutTouched{nullptr};
+
+    /* The number of samples the effect may keep producing output for after
+     * its input goes silent. The slot stops being processed once its input
+     * has been silent for longer, until it gets non-silent input again.
+     */
+    ALuint mTailSamples{0u};
+
+    /* Set for states that process at half the device's mixing rate. These
+     * should size and time everything for processRate, with mTailSamples in
+     * half-rate samples.
+     */
+    std::unique_ptr<EffectHalfRate> mHalfRate;
 
 
     virtual ~EffectState() = default;
 
+    ALuint processRate(const ALCdevice *device) const noexcept
+    { return mHalfRate ? device->MixFrequency/2 : device->MixFrequency; }
+
+    /* Sets the buffer used by effects that take sample data (the buffer may
+     * be null). Called on a new state before deviceUpdate.
+     */
+    virtual void setBuffer(const ALbuffer* UNUSED(buffer)) { }
+    /* Called on the application thread with new properties, before they're
+     * published for update. The mixer may be processing the state meanwhile,
+     * so anything allocated for them has to be handed over for update to
+     * pick up.
+     */
+    virtual void prepare(const EffectProps* UNUSED(props)) { }
     virtual ALboolean deviceUpdate(const ALCdevice *device) = 0;
     virtual void update(const ALCcontext *context, const ALeffectslot *slot, const EffectProps *props, const EffectTarget target) = 0;
     virtual void process(ALsizei samplesToDo, const ALfloat (*RESTRICT samplesIn)[BUFFERSIZE], const ALsizei numInput, ALfloat (*RESTRICT samplesOut)[BUFFERSIZE], const ALsizei numOutput) = 0;
@@ -158,12 +235,50 @@ struct EffectState {
 };
 
 
+/* An effect state to process with others in a batch, with its input and
+ * output.
+ */
+struct EffectBatchItem {
+    EffectState *State;
+    const ALfloat (*SamplesIn)[BUFFERSIZE];
+    ALsizei NumInput;
+    ALfloat (*SamplesOut)[BUFFERSIZE];
+    ALsizei NumOutput;
+};
+
 struct EffectStateFactory {
     virtual ~EffectStateFactory() { }
 
     virtual EffectState *create() = 0;
     virtual EffectProps getDefaultProps() const noexcept = 0;
     virtual const EffectVtable *getEffectVtable() const noexcept = 0;
+
+    /* Effects that can process multiple states together (e.g. with each state
+     * in a separate SIMD lane) return true, and get their independent states
+     * passed to processBatch instead of having each processed separately.
+     */
+    virtual bool canBatch() const noexcept { return false; }
+
+    /* Effects that hold up with less bandwidth (e.g. reverb tails) may return
+     * true when configured to, and have their new states process at half the
+     * mixing rate.
+     */
+    virtual bool useHalfRate() const noexcept { return false; }
+
+    /* Effects that only use the first (W) channel of their input return true,
+     * so sends to their slots only mix that one channel.
+     */
+    virtual bool monoInput() const noexcept { return false; }
+    virtual void processBatch(ALsizei samplesToDo, const EffectBatchItem *items, ALsizei count)
+    {
+        std::for_each(items, items+count,
+            [samplesToDo](const EffectBatchItem &item) -> void
+            {
+                item.State->process(samplesToDo, item.SamplesIn, item.NumInput, item.SamplesOut,
+                    item.NumOutput);
+            }
+        );
+    }
 };
 
 
@@ -180,6 +295,8 @@ EffectStateFactory *FlangerStateFactory_getFactory(void);
 EffectStateFactory *FshifterStateFactory_getFactory(void);
 EffectStateFactory *ModulatorStateFactory_getFactory(void);
 EffectStateFactory *PshifterStateFactory_getFactory(void);
+EffectStateFactory *ReflectionsStateFactory_getFactory(void);
+EffectStateFactory *ConvolutionStateFactory_getFactory(void);
 
 EffectStateFactory *DedicatedStateFactory_getFactory(void);
 
@@ -34,6 +34,12 @@
 #include "vector.h"
 
 
+/* This is a user config option for processing new chorus and flanger states at
+ * half the mixing rate.
+ */
+bool ChorusHalfRate{false};
+
+
 namespace {
 
 static_assert(AL_CHORUS_WAVEFORM_SINUSOID == AL_FLANGER_WAVEFORM_SINUSOID, "Chorus/Flanger waveform value mismatch");
@@ -44,6 +50,11 @@ enum class WaveForm {
     Triangle
 };
 
+/* The longest LFO period, in seconds, that gets a precomputed table of
+ * modulation delays. Slower LFOs compute the delays as they go.
+ */
+constexpr ALfloat MAX_LFO_TABLE_PERIOD{4.0f};
+
 void GetTriangleDelays(ALint *delays, ALsizei offset, ALsizei lfo_range, ALfloat lfo_scale,
                        ALfloat depth, ALsizei delay, ALsizei todo)
 {
@@ -77,6 +88,12 @@ struct ChorusState final : public EffectState {
     ALfloat mLfoScale{0.0f};
     ALint mLfoDisp{0};
 
+    /* One period of the modulated delay, indexed by the LFO offset. It's only
+     * valid when mLfoTableValid is set, which requires the period to fit.
+     */
+    al::vector<ALint,16> mLfoTable;
+    bool mLfoTableValid{false};
+
     /* Gains for left and right sides */
     struct {
         ALfloat Current[MAX_OUTPUT_CHANNELS]{};
@@ -94,6 +111,8 @@ struct ChorusState final : public EffectState {
     void update(const ALCcontext *context, const ALeffectslot *slot, const EffectProps *props, const EffectTarget target) override;
     void process(ALsizei samplesToDo, const ALfloat (*RESTRICT samplesIn)[BUFFERSIZE], const ALsizei numInput, ALfloat (*RESTRICT samplesOut)[BUFFERSIZE], const ALsizei numOutput) override;
 
+    void getDelays(ALint *delays, const ALsizei offset, const ALsizei todo);
+
     DEF_NEWDEL(ChorusState)
 };
 
@@ -102,7 +121,7 @@ ALboolean ChorusState::deviceUpdate(const ALCdevice *Device)
     const ALfloat max_delay = maxf(AL_CHORUS_MAX_DELAY, AL_FLANGER_MAX_DELAY);
     size_t maxlen;
 
-    maxlen = NextPowerOf2(float2int(max_delay*2.0f*Device->Frequency) + 1u);
+    maxlen = NextPowerOf2(float2int(max_delay*2.0f*processRate(Device)) + 1u);
     if(maxlen <= 0) return AL_FALSE;
 
     if(maxlen != mSampleBuffer.size())
@@ -112,6 +131,15 @@ ALboolean ChorusState::deviceUpdate(const ALCdevice *Device)
     }
 
     std::fill(mSampleBuffer.begin(), mSampleBuffer.end(), 0.0f);
+
+    const auto tablelen = static_cast<size_t>(float2int(MAX_LFO_TABLE_PERIOD*processRate(Device)));
+    if(tablelen != mLfoTable.size())
+    {
+        mLfoTable.resize(tablelen);
+        mLfoTable.shrink_to_fit();
+    }
+    mLfoTableValid = false;
+
     for(auto &e : mGains)
     {
         std::fill(std::begin(e.Current), std::end(e.Current), 0.0f);
@@ -125,6 +153,11 @@ void ChorusState::update(const ALCcontext *Context, const ALeffectslot *Slot, co
 {
     static constexpr ALsizei mindelay = MAX_RESAMPLE_PADDING << FRACTIONBITS;
 
+    const WaveForm oldwave{mWaveform};
+    const ALint olddelay{mDelay};
+    const ALfloat olddepth{mDepth};
+    const ALsizei oldrange{mLfoRange};
+
     switch(props->Chorus.Waveform)
     {
         case AL_CHORUS_WAVEFORM_TRIANGLE:
@@ -139,12 +172,20 @@ void ChorusState::update(const ALCcontext *Context, const ALeffectslot *Slot, co
      * delay and depth to allow enough padding for resampling.
      */
     const ALCdevice *device{Context->Device};
-    auto frequency = static_cast<ALfloat>(device->Frequency);
+    auto frequency = static_cast<ALfloat>(processRate(device));
     mDelay = maxi(float2int(props->Chorus.Delay*frequency*FRACTIONONE + 0.5f), mindelay);
     mDepth = minf(props->Chorus.Depth * mDelay, static_cast<ALfloat>(mDelay - mindelay));
 
     mFeedback = props->Chorus.Feedback;
 
+    /* The output lasts until the feedback repeats of the longest delay fall
+     * below the silence threshold.
+     */
+    const ALfloat feedback{std::fabs(mFeedback)};
+    const ALfloat repeats{(feedback > GAIN_SILENCE_THRESHOLD) ?
+        std::log(GAIN_SILENCE_THRESHOLD) / std::log(minf(feedback, 0.999f)) : 0.0f};
+    mTailSamples = static_cast<ALuint>((mDelay+mDepth) / FRACTIONONE * (repeats+1.0f)) + 1u;
+
     /* Gains for left and right sides */
     ALfloat coeffs[2][MAX_AMBI_CHANNELS];
     CalcAngleCoeffs(al::MathDefs<float>::Pi()*-0.5f, 0.0f, 0.0f, coeffs[0]);
@@ -187,6 +228,44 @@ void ChorusState::update(const ALCcontext *Context, const ALeffectslot *Slot, co
         if(phase < 0) phase = 360 + phase;
         mLfoDisp = (mLfoRange*phase + 180) / 360;
     }
+
+    /* Regenerate the delay table when the modulation changes. The generators
+     * pre-increment the offset, so start from -1 to fill from offset 0.
+     */
+    if(static_cast<size_t>(mLfoRange) > mLfoTable.size())
+        mLfoTableValid = false;
+    else if(!mLfoTableValid || mWaveform != oldwave || mDelay != olddelay || mDepth != olddepth
+        || mLfoRange != oldrange)
+    {
+        if(mWaveform == WaveForm::Sinusoid)
+            GetSinusoidDelays(mLfoTable.data(), -1, mLfoRange, mLfoScale, mDepth, mDelay,
+                mLfoRange);
+        else /*if(mWaveform == WaveForm::Triangle)*/
+            GetTriangleDelays(mLfoTable.data(), -1, mLfoRange, mLfoScale, mDepth, mDelay,
+                mLfoRange);
+        mLfoTableValid = true;
+    }
+}
+
+/* Gets todo modulated delays, for the LFO offsets following the given one. */
+void ChorusState::getDelays(ALint *delays, const ALsizei offset, const ALsizei todo)
+{
+    if(LIKELY(mLfoTableValid))
+    {
+        ALsizei pos{(offset+1) % mLfoRange};
+        ALsizei done{0};
+        while(done < todo)
+        {
+            const ALsizei count{mini(todo-done, mLfoRange-pos)};
+            std::copy_n(mLfoTable.cbegin()+pos, count, delays+done);
+            done += count;
+            pos = 0;
+        }
+    }
+    else if(mWaveform == WaveForm::Sinusoid)
+        GetSinusoidDelays(delays, offset, mLfoRange, mLfoScale, mDepth, mDelay, todo);
+    else /*if(mWaveform == WaveForm::Triangle)*/
+        GetTriangleDelays(delays, offset, mLfoRange, mLfoScale, mDepth, mDelay, todo);
 }
 
 void ChorusState::process(ALsizei samplesToDo, const ALfloat (*RESTRICT samplesIn)[BUFFERSIZE], const ALsizei /*numInput*/, ALfloat (*RESTRICT samplesOut)[BUFFERSIZE], const ALsizei numOutput)
@@ -205,45 +284,33 @@ void ChorusState::process(ALsizei samplesToDo, const ALfloat (*RESTRICT samplesI
         ALint moddelays[2][256];
         alignas(16) ALfloat temps[2][256];
 
-        if(mWaveform == WaveForm::Sinusoid)
-        {
-            GetSinusoidDelays(moddelays[0], mLfoOffset, mLfoRange, mLfoScale, mDepth, mDelay,
-                              todo);
-            GetSinusoidDelays(moddelays[1], (mLfoOffset+mLfoDisp)%mLfoRange, mLfoRange, mLfoScale,
-                              mDepth, mDelay, todo);
-        }
-        else /*if(mWaveform == WaveForm::Triangle)*/
-        {
-            GetTriangleDelays(moddelays[0], mLfoOffset, mLfoRange, mLfoScale, mDepth, mDelay,
-                              todo);
-            GetTriangleDelays(moddelays[1], (mLfoOffset+mLfoDisp)%mLfoRange, mLfoRange, mLfoScale,
-                              mDepth, mDelay, todo);
-        }
+        getDelays(moddelays[0], mLfoOffset, todo);
+        getDelays(moddelays[1], (mLfoOffset+mLfoDisp)%mLfoRange, todo);
         mLfoOffset = (mLfoOffset+todo) % mLfoRange;
 
+        /* The taps are always at least MAX_RESAMPLE_PADDING samples behind,
+         * as is the feedback, so the whole block can be fed into the buffer
+         * before reading either tap.
+         */
         for(i = 0;i < todo;i++)
         {
-            // Feed the buffer's input first (necessary for delays < 1).
-            delaybuf[offset&bufmask] = samplesIn[0][base+i];
-
-            // Tap for the left output.
-            ALint delay{offset - (moddelays[0][i]>>FRACTIONBITS)};
-            ALfloat mu{(moddelays[0][i]&FRACTIONMASK) * (1.0f/FRACTIONONE)};
-            temps[0][i] = cubic(delaybuf[(delay+1) & bufmask], delaybuf[(delay  ) & bufmask],
-                                delaybuf[(delay-1) & bufmask], delaybuf[(delay-2) & bufmask],
-                                mu);
-
-            // Tap for the right output.
-            delay = offset - (moddelays[1][i]>>FRACTIONBITS);
-            mu = (moddelays[1][i]&FRACTIONMASK) * (1.0f/FRACTIONONE);
-            temps[1][i] = cubic(delaybuf[(delay+1) & bufmask], delaybuf[(delay  ) & bufmask],
-                                delaybuf[(delay-1) & bufmask], delaybuf[(delay-2) & bufmask],
-                                mu);
-
-            // Accumulate feedback from the average delay of the taps.
-            delaybuf[offset&bufmask] += delaybuf[(offset-avgdelay) & bufmask] * feedback;
-            offset++;
+            delaybuf[(offset+i)&bufmask] = samplesIn[0][base+i] +
+                delaybuf[(offset+i-avgdelay) & bufmask]*feedback;
+        }
+
+        for(c = 0;c < 2;c++)
+        {
+            const ALint *RESTRICT delays{moddelays[c]};
+            ALfloat *RESTRICT temp{temps[c]};
+            for(i = 0;i < todo;i++)
+            {
+                const ALint delay{offset+i - (delays[i]>>FRACTIONBITS)};
+                const ALfloat mu{(delays[i]&FRACTIONMASK) * (1.0f/FRACTIONONE)};
+                temp[i] = cubic(delaybuf[(delay+1) & bufmask], delaybuf[(delay  ) & bufmask],
+                    delaybuf[(delay-1) & bufmask], delaybuf[(delay-2) & bufmask], mu);
+            }
         }
+        offset += todo;
 
         for(c = 0;c < 2;c++)
             MixSamples(temps[c], numOutput, samplesOut, mGains[c].Current, mGains[c].Target,
@@ -365,6 +432,8 @@ struct ChorusStateFactory final : public EffectStateFactory {
     EffectState *create() override { return new ChorusState{}; }
     EffectProps getDefaultProps() const noexcept override;
     const EffectVtable *getEffectVtable() const noexcept override { return &Chorus_vtable; }
+    bool useHalfRate() const noexcept override { return ChorusHalfRate; }
+    bool monoInput() const noexcept override { return true; }
 };
 
 EffectProps ChorusStateFactory::getDefaultProps() const noexcept
@@ -492,6 +561,8 @@ struct FlangerStateFactory final : public EffectStateFactory {
     EffectState *create() override { return new ChorusState{}; }
     EffectProps getDefaultProps() const noexcept override;
     const EffectVtable *getEffectVtable() const noexcept override { return &Flanger_vtable; }
+    bool useHalfRate() const noexcept override { return ChorusHalfRate; }
+    bool monoInput() const noexcept override { return true; }
 };
 
 EffectProps FlangerStateFactory::getDefaultProps() const noexcept
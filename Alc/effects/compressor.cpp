@@ -62,8 +62,8 @@ ALboolean CompressorState::deviceUpdate(const ALCdevice *device)
     /* Number of samples to do a full attack and release (non-integer sample
      * counts are okay).
      */
-    const ALfloat attackCount  = static_cast<ALfloat>(device->Frequency) * ATTACK_TIME;
-    const ALfloat releaseCount = static_cast<ALfloat>(device->Frequency) * RELEASE_TIME;
+    const ALfloat attackCount  = static_cast<ALfloat>(device->MixFrequency) * ATTACK_TIME;
+    const ALfloat releaseCount = static_cast<ALfloat>(device->MixFrequency) * RELEASE_TIME;
 
     /* Calculate per-sample multipliers to attack and release at the desired
      * rates.
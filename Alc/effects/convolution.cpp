@@ -0,0 +1,834 @@
+/**
+ * OpenAL cross platform audio library
+ * Copyright (C) 2019 by authors.
+ * This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Library General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ *  License along with this library; if not, write to the
+ *  Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ * Or go to http://www.gnu.org/copyleft/lgpl.html
+ */
+
+#include "config.h"
+
+#include <cmath>
+#include <cstdlib>
+
+#include <algorithm>
+#include <atomic>
+#include <complex>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "alMain.h"
+#include "alcontext.h"
+#include "alAuxEffectSlot.h"
+#include "alBuffer.h"
+#include "alError.h"
+#include "alu.h"
+#include "ambidefs.h"
+#include "sample_cvt.h"
+
+#include "alcomplex.h"
+#include "fpu_modes.h"
+#include "polyphase_resampler.h"
+#include "threads.h"
+#include "vector.h"
+
+
+namespace {
+
+using complex_f = std::complex<float>;
+
+/* Only the first few samples of the response are applied directly in the
+ * time domain, so the effect adds no latency. The rest of the head is split
+ * into partitions of the same size, convolved in the frequency domain as each
+ * block of input completes.
+ */
+constexpr ALsizei DirectSize{32};
+/* The early part of the response after the head uses head-sized partitions,
+ * also convolved in the mixer.
+ */
+constexpr ALsizei HeadSize{256};
+
+/* The tail of the response, starting at TailStart, uses much larger
+ * partitions and is convolved on the tail worker thread. The tail's first
+ * partition is delayed by a full block, giving the worker a block's worth of
+ * time to finish before its output is needed. The mixer never waits on it; a
+ * result that isn't ready in time is added once it is, late. Loopback devices
+ * render on demand without a deadline, so they convolve the tail inline.
+ */
+constexpr ALsizei TailSize{2048};
+constexpr ALsizei TailStart{TailSize*2};
+/* Number of tail blocks that can be in flight. Any more while the worker is
+ * behind are dropped.
+ */
+constexpr ALuint TailJobCount{3};
+
+/* The output accumulation ring must hold the full output of a tail block. */
+constexpr ALsizei OutputSize{TailSize*2};
+constexpr ALsizei OutputMask{OutputSize-1};
+
+constexpr ALsizei MaxIrChannels{4};
+/* Longest response used, in seconds. Anything after is ignored. */
+constexpr ALsizei MaxIrSeconds{10};
+
+
+template<FmtType T>
+inline ALfloat LoadSample(typename FmtTypeTraits<T>::Type val);
+
+template<> inline ALfloat LoadSample<FmtUByte>(FmtTypeTraits<FmtUByte>::Type val)
+{ return (val-128) * (1.0f/128.0f); }
+template<> inline ALfloat LoadSample<FmtShort>(FmtTypeTraits<FmtShort>::Type val)
+{ return val * (1.0f/32768.0f); }
+template<> inline ALfloat LoadSample<FmtFloat>(FmtTypeTraits<FmtFloat>::Type val)
+{ return val; }
+template<> inline ALfloat LoadSample<FmtDouble>(FmtTypeTraits<FmtDouble>::Type val)
+{ return static_cast<ALfloat>(val); }
+template<> inline ALfloat LoadSample<FmtMulaw>(FmtTypeTraits<FmtMulaw>::Type val)
+{ return muLawDecompressionTable[val] * (1.0f/32768.0f); }
+template<> inline ALfloat LoadSample<FmtAlaw>(FmtTypeTraits<FmtAlaw>::Type val)
+{ return aLawDecompressionTable[val] * (1.0f/32768.0f); }
+template<> inline ALfloat LoadSample<FmtInt24>(FmtTypeTraits<FmtInt24>::Type val)
+{ return static_cast<ALfloat>(val.lo | (val.mid<<8) | (val.hi<<16)) * (1.0f/8388608.0f); }
+template<> inline ALfloat LoadSample<FmtInt>(FmtTypeTraits<FmtInt>::Type val)
+{ return static_cast<ALfloat>(val) * (1.0f/2147483648.0f); }
+
+template<FmtType T>
+inline void LoadSampleArray(ALfloat *RESTRICT dst, const void *src, ALsizei srcstep,
+    const ALsizei samples)
+{
+    using SampleType = typename FmtTypeTraits<T>::Type;
+
+    const SampleType *ssrc = static_cast<const SampleType*>(src);
+    for(ALsizei i{0};i < samples;i++)
+        dst[i] = LoadSample<T>(ssrc[i*srcstep]);
+}
+
+void LoadSamples(ALfloat *RESTRICT dst, const ALbyte *src, ALsizei srcstep, FmtType srctype,
+    const ALsizei samples)
+{
+#define HANDLE_FMT(T)  case T: LoadSampleArray<T>(dst, src, srcstep, samples); break
+    switch(srctype)
+    {
+        HANDLE_FMT(FmtUByte);
+        HANDLE_FMT(FmtShort);
+        HANDLE_FMT(FmtFloat);
+        HANDLE_FMT(FmtDouble);
+        HANDLE_FMT(FmtMulaw);
+        HANDLE_FMT(FmtAlaw);
+        HANDLE_FMT(FmtInt24);
+        HANDLE_FMT(FmtInt);
+        /* ADPCM needs per-block decoding, which is handled by the caller. */
+        case FmtIMA4: case FmtMSADPCM: break;
+    }
+#undef HANDLE_FMT
+}
+
+
+inline void ComplexMulAdd(float2 *RESTRICT dst, const float2 *RESTRICT a,
+    const float2 *RESTRICT b, const ALsizei count)
+{
+    for(ALsizei k{0};k < count;++k)
+    {
+        dst[k][0] += a[k][0]*b[k][0] - a[k][1]*b[k][1];
+        dst[k][1] += a[k][0]*b[k][1] + a[k][1]*b[k][0];
+    }
+}
+
+
+/* Uniformly partitioned overlap-add convolution of a single input with a
+ * multichannel response. Each call to process takes one partition's worth of
+ * input and produces two partitions' worth of output per channel, which must
+ * be added over the previous output shifted by one partition.
+ */
+class PartConvolver {
+    ALsizei mPartSize{0};
+    ALsizei mNumParts{0};
+    ALsizei mNumChans{0};
+    ALsizei mAccumPos{0};
+
+    /* The half spectrum of each channel's partitions, and the ring of output
+     * spectra being accumulated for upcoming blocks.
+     */
+    al::vector<float2,16> mFilter;
+    al::vector<float2,16> mAccum;
+    al::vector<float2,16> mInput;
+    al::vector<ALfloat,16> mReal;
+    al::vector<complex_f,16> mFft;
+
+    RealFftPlan<ALfloat> mRealPlan;
+    FftPlan<ALfloat> mPlan;
+
+public:
+    ~PartConvolver();
+
+    void init(const ALsizei partsize, const ALsizei numchans, const ALfloat *ir,
+        const ALsizei irstride, const ALsizei start, const ALsizei end);
+    void process(const ALfloat *RESTRICT input, ALfloat *RESTRICT output);
+
+    ALsizei numParts() const noexcept { return mNumParts; }
+};
+
+PartConvolver::~PartConvolver() = default;
+
+void PartConvolver::init(const ALsizei partsize, const ALsizei numchans, const ALfloat *ir,
+    const ALsizei irstride, const ALsizei start, const ALsizei end)
+{
+    const ALsizei fftsize{partsize*2};
+    const ALsizei numbins{partsize+1};
+
+    mPartSize = partsize;
+    mNumParts = (end > start) ? (end-start + partsize-1) / partsize : 0;
+    mNumChans = numchans;
+    mAccumPos = 0;
+
+    const size_t total{static_cast<size_t>(numchans*mNumParts*numbins)};
+    mFilter.resize(total);
+    mAccum.assign(total, float2{});
+    mInput.resize(numbins);
+    mReal.resize(fftsize);
+    mFft.resize(fftsize);
+    mRealPlan = RealFftPlan<ALfloat>{fftsize};
+    mPlan = FftPlan<ALfloat>{fftsize};
+
+    /* Fold in the scaling for the (unnormalized) inverse transform. */
+    const ALfloat scale{1.0f / static_cast<ALfloat>(fftsize)};
+    auto filter = mFilter.begin();
+    for(ALsizei c{0};c < numchans;++c)
+    {
+        for(ALsizei p{0};p < mNumParts;++p)
+        {
+            const ALfloat *src{ir + c*irstride + start + p*partsize};
+            const ALsizei todo{mini(partsize, end - (start + p*partsize))};
+            std::fill(std::copy_n(src, todo, mReal.begin()), mReal.end(), 0.0f);
+
+            mRealPlan.forward(mReal.data(), mFft.data());
+            filter = std::transform(mFft.cbegin(), mFft.cbegin()+numbins, filter,
+                [scale](const complex_f &val) noexcept -> float2
+                { return float2{{val.real()*scale, val.imag()*scale}}; });
+        }
+    }
+}
+
+void PartConvolver::process(const ALfloat *RESTRICT input, ALfloat *RESTRICT output)
+{
+    const ALsizei fftsize{mPartSize*2};
+    const ALsizei numbins{mPartSize+1};
+
+    std::fill(std::copy_n(input, mPartSize, mReal.begin()), mReal.end(), 0.0f);
+    mRealPlan.forward(mReal.data(), mFft.data());
+    std::transform(mFft.cbegin(), mFft.cbegin()+numbins, mInput.begin(),
+        [](const complex_f &val) noexcept -> float2 { return float2{{val.real(), val.imag()}}; });
+
+    /* Partition p contributes to the output block p blocks after this one,
+     * which the ring has at AccumPos+p.
+     */
+    for(ALsizei c{0};c < mNumChans;++c)
+    {
+        float2 *accum{&mAccum[c*mNumParts*numbins]};
+        const float2 *filter{&mFilter[c*mNumParts*numbins]};
+        for(ALsizei p{0};p < mNumParts;++p)
+        {
+            const ALsizei slot{(mAccumPos+p) % mNumParts};
+            ComplexMulAdd(accum + slot*numbins, mInput.data(), filter + p*numbins, numbins);
+        }
+    }
+
+    /* Inverse transform the current block's spectra two channels at a time,
+     * combined so the outputs are the real and imaginary parts.
+     */
+    for(ALsizei c{0};c < mNumChans;c += 2)
+    {
+        float2 *left{&mAccum[(c*mNumParts + mAccumPos)*numbins]};
+        if(c+1 < mNumChans)
+        {
+            float2 *right{&mAccum[((c+1)*mNumParts + mAccumPos)*numbins]};
+            for(ALsizei k{0};k < numbins;++k)
+                mFft[k] = complex_f{left[k][0] - right[k][1], left[k][1] + right[k][0]};
+            for(ALsizei k{1};k < numbins-1;++k)
+                mFft[fftsize-k] = complex_f{left[k][0] + right[k][1], right[k][0] - left[k][1]};
+            std::fill_n(right, numbins, float2{});
+        }
+        else
+        {
+            for(ALsizei k{0};k < numbins;++k)
+                mFft[k] = complex_f{left[k][0], left[k][1]};
+            for(ALsizei k{1};k < numbins-1;++k)
+                mFft[fftsize-k] = complex_f{left[k][0], -left[k][1]};
+        }
+        std::fill_n(left, numbins, float2{});
+
+        mPlan.inverse(mFft.data());
+        ALfloat *RESTRICT out0{output + c*fftsize};
+        for(ALsizei i{0};i < fftsize;++i)
+            out0[i] = mFft[i].real();
+        if(c+1 < mNumChans)
+        {
+            ALfloat *RESTRICT out1{output + (c+1)*fftsize};
+            for(ALsizei i{0};i < fftsize;++i)
+                out1[i] = mFft[i].imag();
+        }
+    }
+    mAccumPos = (mAccumPos+1) % mNumParts;
+}
+
+
+struct ConvolutionState;
+
+/* A real-time priority thread shared by all convolution effects with a tail,
+ * started with the first and stopped with the last. Mixers hand it tail
+ * blocks without locking, and it processes them in order for each effect.
+ */
+class TailWorker {
+    /* Held while processing, so an effect can be reset or removed safely. */
+    std::mutex mStateLock;
+    al::vector<ConvolutionState*> mStates;
+
+    al::semaphore mSem;
+    std::atomic<bool> mQuit{false};
+    std::thread mThread;
+
+    void proc();
+
+public:
+    TailWorker() : mThread{&TailWorker::proc, this} { }
+    ~TailWorker();
+
+    std::mutex &stateLock() noexcept { return mStateLock; }
+    void wake() { mSem.post(); }
+
+    static TailWorker *add(ConvolutionState *state);
+    static void remove(ConvolutionState *state);
+};
+
+std::mutex TailWorkerLock;
+std::unique_ptr<TailWorker> TailWorkerInstance;
+
+
+struct ConvolutionState final : public EffectState {
+    /* The response as loaded from the buffer, one channel after another. */
+    al::vector<ALfloat> mIrData;
+    ALsizei mIrLength{0};
+    ALsizei mIrRate{0};
+    FmtChannels mChannels{FmtMono};
+    ALsizei mNumChans{0};
+
+    /* The start of the response, applied directly. */
+    al::vector<ALfloat,16> mDirectFilter;
+    alignas(16) ALfloat mInput[DirectSize*2]{};
+    ALsizei mInputPos{0};
+
+    PartConvolver mHead;
+    al::vector<ALfloat,16> mHeadOutput;
+
+    PartConvolver mEarly;
+    al::vector<ALfloat,16> mEarlyInput;
+    ALsizei mEarlyPos{0};
+    al::vector<ALfloat,16> mEarlyOutput;
+
+    /* The tail, convolved by the tail worker. The mixer queues a block of
+     * input once it completes, and collects the result when its output is
+     * due. The worker side (mTail and mTailRun) is only touched by the mixer
+     * with the worker's state lock held, outside of processing, or when there
+     * is no worker.
+     */
+    struct TailJob {
+        al::vector<ALfloat,16> Input;
+        al::vector<ALfloat,16> Output;
+        uint64_t Due{0u};
+        /* Blocks dropped just before this one, which the worker runs as
+         * silence to keep the partitions in step.
+         */
+        ALuint Skips{0u};
+        std::atomic<bool> Done{false};
+    };
+    PartConvolver mTail;
+    al::vector<ALfloat,16> mTailInput;
+    ALsizei mTailPos{0};
+    al::vector<ALfloat,16> mTailSilence;
+    TailJob mTailJobs[TailJobCount];
+    ALuint mTailSubmitted{0u};
+    ALuint mTailCollected{0u};
+    ALuint mTailSkips{0u};
+    std::atomic<ALuint> mTailQueued{0u};
+    ALuint mTailRun{0u};
+    TailWorker *mWorker{nullptr};
+
+    /* Ring of upcoming output samples for each channel, and the number of
+     * samples processed since the last reset.
+     */
+    al::vector<ALfloat,16> mOutput;
+    ALsizei mOutPos{0};
+    uint64_t mTime{0u};
+
+    struct {
+        ALfloat Current[MAX_OUTPUT_CHANNELS]{};
+        ALfloat Target[MAX_OUTPUT_CHANNELS]{};
+    } mGains[MaxIrChannels];
+
+
+    ConvolutionState() = default;
+    ~ConvolutionState() override;
+
+    void addOutput(const ALfloat *RESTRICT src, const ALsizei todo);
+    void queueTail(const ALfloat *RESTRICT block);
+    void collectTail();
+    void runTailJobs();
+    void setTailWorker(const bool usetail);
+
+    void setBuffer(const ALbuffer *buffer) override;
+    ALboolean deviceUpdate(const ALCdevice *device) override;
+    void update(const ALCcontext *context, const ALeffectslot *slot, const EffectProps *props, const EffectTarget target) override;
+    void process(ALsizei samplesToDo, const ALfloat (*RESTRICT samplesIn)[BUFFERSIZE], const ALsizei numInput, ALfloat (*RESTRICT samplesOut)[BUFFERSIZE], const ALsizei numOutput) override;
+
+    DEF_NEWDEL(ConvolutionState)
+};
+
+ConvolutionState::~ConvolutionState()
+{
+    if(mWorker)
+        TailWorker::remove(this);
+}
+
+void ConvolutionState::addOutput(const ALfloat *RESTRICT src, const ALsizei todo)
+{
+    for(ALsizei c{0};c < mNumChans;++c)
+    {
+        ALfloat *RESTRICT ring{&mOutput[c*OutputSize]};
+        for(ALsizei i{0};i < todo;++i)
+            ring[(mOutPos+i)&OutputMask] += src[i];
+        src += todo;
+    }
+}
+
+void ConvolutionState::queueTail(const ALfloat *RESTRICT block)
+{
+    std::copy_n(block, HeadSize, &mTailInput[mTailPos]);
+    mTailPos += HeadSize;
+    if(mTailPos < TailSize)
+        return;
+    mTailPos = 0;
+
+    /* If the worker is too far behind to take another block, drop it rather
+     * than wait.
+     */
+    if(mTailSubmitted-mTailCollected == TailJobCount)
+    {
+        ++mTailSkips;
+        return;
+    }
+
+    TailJob &job = mTailJobs[mTailSubmitted%TailJobCount];
+    std::copy(mTailInput.cbegin(), mTailInput.cend(), job.Input.begin());
+    job.Due = mTime + TailStart - TailSize;
+    job.Skips = mTailSkips;
+    mTailSkips = 0;
+    mTailQueued.store(++mTailSubmitted, std::memory_order_release);
+    if(mWorker)
+        mWorker->wake();
+    else
+        runTailJobs();
+}
+
+void ConvolutionState::collectTail()
+{
+    /* Results are only collected once due, so on-time output is always added
+     * in the same order. One that's late lags by however late it is.
+     */
+    while(mTailCollected != mTailSubmitted)
+    {
+        TailJob &job = mTailJobs[mTailCollected%TailJobCount];
+        if(job.Due > mTime || !job.Done.load(std::memory_order_acquire))
+            break;
+        addOutput(job.Output.data(), TailSize*2);
+        job.Done.store(false, std::memory_order_relaxed);
+        ++mTailCollected;
+    }
+}
+
+void ConvolutionState::runTailJobs()
+{
+    const ALuint queued{mTailQueued.load(std::memory_order_acquire)};
+    for(;mTailRun != queued;++mTailRun)
+    {
+        TailJob &job = mTailJobs[mTailRun%TailJobCount];
+        for(ALuint i{0};i < job.Skips;++i)
+            mTail.process(mTailSilence.data(), job.Output.data());
+        mTail.process(job.Input.data(), job.Output.data());
+        job.Done.store(true, std::memory_order_release);
+    }
+}
+
+/* Registers with or leaves the tail worker, as needed. Without it, the tail
+ * is convolved inline.
+ */
+void ConvolutionState::setTailWorker(const bool usetail)
+{
+    if(usetail && !mWorker)
+    {
+        try {
+            mWorker = TailWorker::add(this);
+        }
+        catch(std::exception& e) {
+            ERR("Failed to start convolution thread: %s\n", e.what());
+        }
+    }
+    else if(!usetail && mWorker)
+    {
+        TailWorker::remove(this);
+        mWorker = nullptr;
+    }
+}
+
+
+TailWorker::~TailWorker()
+{
+    mQuit.store(true, std::memory_order_release);
+    mSem.post();
+    mThread.join();
+}
+
+void TailWorker::proc()
+{
+    SetWorkerRTPriority();
+    althrd_setname(CONVOLUTION_THREAD_NAME);
+    FPUCtl mixer_mode{};
+
+    while(1)
+    {
+        mSem.wait();
+        if(mQuit.load(std::memory_order_acquire))
+            break;
+
+        std::lock_guard<std::mutex> _{mStateLock};
+        for(ConvolutionState *state : mStates)
+            state->runTailJobs();
+    }
+}
+
+TailWorker *TailWorker::add(ConvolutionState *state)
+{
+    std::lock_guard<std::mutex> _{TailWorkerLock};
+    if(!TailWorkerInstance)
+        TailWorkerInstance = std::unique_ptr<TailWorker>{new TailWorker{}};
+
+    TailWorker *worker{TailWorkerInstance.get()};
+    std::lock_guard<std::mutex> __{worker->mStateLock};
+    worker->mStates.emplace_back(state);
+    return worker;
+}
+
+void TailWorker::remove(ConvolutionState *state)
+{
+    std::lock_guard<std::mutex> _{TailWorkerLock};
+    TailWorker *worker{TailWorkerInstance.get()};
+    {
+        std::lock_guard<std::mutex> __{worker->mStateLock};
+        auto iter = std::find(worker->mStates.begin(), worker->mStates.end(), state);
+        if(iter != worker->mStates.end())
+            worker->mStates.erase(iter);
+        if(!worker->mStates.empty())
+            return;
+    }
+    TailWorkerInstance = nullptr;
+}
+
+
+void ConvolutionState::setBuffer(const ALbuffer *buffer)
+{
+    mIrData.clear();
+    mIrLength = 0;
+    mNumChans = 0;
+    if(!buffer || buffer->SampleLen < 1)
+        return;
+
+    switch(buffer->mFmtChannels)
+    {
+    case FmtMono: case FmtStereo: case FmtRear: case FmtQuad:
+    case FmtBFormat2D: case FmtBFormat3D:
+        break;
+    case FmtX51: case FmtX61: case FmtX71:
+        WARN("Unsupported convolution response channel format\n");
+        return;
+    }
+
+    mChannels = buffer->mFmtChannels;
+    mNumChans = ChannelsFromFmt(buffer->mFmtChannels);
+    mIrRate = buffer->Frequency;
+    mIrLength = static_cast<ALsizei>(mini64(buffer->SampleLen, MaxIrSeconds*buffer->Frequency));
+
+    mIrData.resize(static_cast<size_t>(mNumChans*mIrLength));
+    if(IsADPCMFmt(buffer->mFmtType))
+    {
+        std::fill(mIrData.begin(), mIrData.end(), 0.0f);
+        for(ALsizei c{0};c < mNumChans;++c)
+        {
+            ADPCMState state{};
+            DecodeADPCMSamples(&mIrData[c*mIrLength], buffer, c, 0, mIrLength, state, 0);
+        }
+        return;
+    }
+
+    const ALsizei bytes{BytesFromFmt(buffer->mFmtType)};
+    for(ALsizei c{0};c < mNumChans;++c)
+        LoadSamples(&mIrData[c*mIrLength], buffer->samples() + c*bytes, mNumChans,
+            buffer->mFmtType, mIrLength);
+}
+
+ALboolean ConvolutionState::deviceUpdate(const ALCdevice *device)
+{
+    /* Keep the worker off this effect while it's reset. */
+    std::unique_lock<std::mutex> tail_lock;
+    if(mWorker)
+        tail_lock = std::unique_lock<std::mutex>{mWorker->stateLock()};
+
+    std::fill(std::begin(mInput), std::end(mInput), 0.0f);
+    mInputPos = 0;
+    mEarlyPos = 0;
+    mTailPos = 0;
+    mTailSubmitted = 0u;
+    mTailCollected = 0u;
+    mTailSkips = 0u;
+    mTailQueued.store(0u, std::memory_order_relaxed);
+    mTailRun = 0u;
+    for(auto &job : mTailJobs)
+        job.Done.store(false, std::memory_order_relaxed);
+    mOutPos = 0;
+    mTime = 0u;
+    for(auto &gains : mGains)
+    {
+        std::fill(std::begin(gains.Current), std::end(gains.Current), 0.0f);
+        std::fill(std::begin(gains.Target), std::end(gains.Target), 0.0f);
+    }
+    mTailSamples = 0u;
+    if(mNumChans < 1)
+    {
+        if(tail_lock) tail_lock.unlock();
+        setTailWorker(false);
+        return AL_TRUE;
+    }
+
+    /* Resample the response to the device rate, as needed. */
+    const auto rate = static_cast<ALsizei>(device->MixFrequency);
+    ALsizei length{mIrLength};
+    al::vector<ALfloat> resampled;
+    const ALfloat *ir{mIrData.data()};
+    if(mIrRate != rate)
+    {
+        length = static_cast<ALsizei>((static_cast<uint64_t>(mIrLength)*rate + mIrRate-1) /
+            mIrRate);
+        resampled.resize(static_cast<size_t>(mNumChans*length));
+
+        /* Scale the result by the rate change, so the response keeps the
+         * same overall gain with a different number of samples.
+         */
+        const double scale{static_cast<double>(mIrRate) / rate};
+        PPhaseResampler resampler;
+        resampler.init(static_cast<ALuint>(mIrRate), static_cast<ALuint>(rate));
+        al::vector<double> srcbuf(static_cast<size_t>(mIrLength));
+        al::vector<double> dstbuf(static_cast<size_t>(length));
+        for(ALsizei c{0};c < mNumChans;++c)
+        {
+            std::copy_n(&mIrData[c*mIrLength], mIrLength, srcbuf.begin());
+            resampler.process(static_cast<ALuint>(mIrLength), srcbuf.data(),
+                static_cast<ALuint>(length), dstbuf.data());
+            std::transform(dstbuf.cbegin(), dstbuf.cend(), resampled.begin() + c*length,
+                [scale](const double d) noexcept -> ALfloat
+                { return static_cast<ALfloat>(d*scale); });
+        }
+        ir = resampled.data();
+    }
+
+    mDirectFilter.assign(static_cast<size_t>(mNumChans*DirectSize), 0.0f);
+    for(ALsizei c{0};c < mNumChans;++c)
+        std::copy_n(ir + c*length, mini(DirectSize, length), &mDirectFilter[c*DirectSize]);
+
+    mHead.init(DirectSize, mNumChans, ir, length, DirectSize, mini(length, HeadSize));
+    mHeadOutput.resize(static_cast<size_t>(mNumChans*DirectSize*2));
+
+    mEarly.init(HeadSize, mNumChans, ir, length, HeadSize, mini(length, TailStart));
+    mEarlyInput.assign(HeadSize, 0.0f);
+    mEarlyOutput.resize(static_cast<size_t>(mNumChans*HeadSize*2));
+
+    mTail.init(TailSize, mNumChans, ir, length, TailStart, length);
+    if(mTail.numParts() > 0)
+    {
+        mTailInput.assign(TailSize, 0.0f);
+        mTailSilence.assign(TailSize, 0.0f);
+        for(auto &job : mTailJobs)
+        {
+            job.Input.resize(TailSize);
+            job.Output.resize(static_cast<size_t>(mNumChans*TailSize*2));
+        }
+    }
+
+    mOutput.assign(static_cast<size_t>(mNumChans*OutputSize), 0.0f);
+    /* The tail partitions' output ends two blocks after the input, and can
+     * lag further by as many blocks as can be in flight.
+     */
+    mTailSamples = static_cast<ALuint>(length + TailSize*(2+TailJobCount));
+    TRACE("Convolution response: %d channel%s, %d samples (%d head, %d early, %d tail partitions)\n",
+        mNumChans, (mNumChans==1)?"":"s", length, mHead.numParts(), mEarly.numParts(),
+        mTail.numParts());
+
+    if(tail_lock) tail_lock.unlock();
+    setTailWorker(mTail.numParts() > 0 && device->Type != Loopback);
+    return AL_TRUE;
+}
+
+void ConvolutionState::update(const ALCcontext* UNUSED(context), const ALeffectslot *slot, const EffectProps* UNUSED(props), const EffectTarget target)
+{
+    mOutBuffer = target.Main->Buffer;
+    mOutChannels = target.Main->NumChannels;
+
+    ALfloat coeffs[MaxIrChannels][MAX_AMBI_CHANNELS]{};
+    switch(mChannels)
+    {
+    case FmtMono:
+        /* A single channel response is treated as diffuse. */
+        CalcAngleCoeffs(0.0f, 0.0f, al::MathDefs<float>::Tau(), coeffs[0]);
+        break;
+    case FmtStereo:
+        CalcAngleCoeffs(Deg2Rad(-30.0f), 0.0f, 0.0f, coeffs[0]);
+        CalcAngleCoeffs(Deg2Rad( 30.0f), 0.0f, 0.0f, coeffs[1]);
+        break;
+    case FmtRear:
+        CalcAngleCoeffs(Deg2Rad(-150.0f), 0.0f, 0.0f, coeffs[0]);
+        CalcAngleCoeffs(Deg2Rad( 150.0f), 0.0f, 0.0f, coeffs[1]);
+        break;
+    case FmtQuad:
+        CalcAngleCoeffs(Deg2Rad( -45.0f), 0.0f, 0.0f, coeffs[0]);
+        CalcAngleCoeffs(Deg2Rad(  45.0f), 0.0f, 0.0f, coeffs[1]);
+        CalcAngleCoeffs(Deg2Rad(-135.0f), 0.0f, 0.0f, coeffs[2]);
+        CalcAngleCoeffs(Deg2Rad( 135.0f), 0.0f, 0.0f, coeffs[3]);
+        break;
+    case FmtBFormat2D:
+    case FmtBFormat3D:
+        /* Convert the FuMa channels to N3D-scaled ACN. */
+        for(ALsizei c{0};c < mNumChans;++c)
+        {
+            const int acn{AmbiIndex::FromFuMa[c]};
+            coeffs[c][acn] = AmbiScale::FromFuMa[acn];
+        }
+        break;
+    case FmtX51: case FmtX61: case FmtX71:
+        break;
+    }
+
+    for(ALsizei c{0};c < mNumChans;++c)
+        ComputePanGains(target.Main, coeffs[c], slot->Params.Gain, mGains[c].Target);
+}
+
+void ConvolutionState::process(ALsizei samplesToDo, const ALfloat (*RESTRICT samplesIn)[BUFFERSIZE], const ALsizei /*numInput*/, ALfloat (*RESTRICT samplesOut)[BUFFERSIZE], const ALsizei numOutput)
+{
+    if(mNumChans < 1) return;
+
+    for(ALsizei base{0};base < samplesToDo;)
+    {
+        const ALsizei todo{mini(DirectSize-mInputPos, samplesToDo-base)};
+        std::copy_n(samplesIn[0]+base, todo, mInput+DirectSize+mInputPos);
+
+        /* Apply the start of the response directly, along with what's
+         * accumulated in the output ring from the partitions.
+         */
+        alignas(16) ALfloat temps[MaxIrChannels][DirectSize];
+        for(ALsizei c{0};c < mNumChans;++c)
+        {
+            const ALfloat *RESTRICT filter{&mDirectFilter[c*DirectSize]};
+            ALfloat *RESTRICT ring{&mOutput[c*OutputSize]};
+            for(ALsizei i{0};i < todo;++i)
+            {
+                const ALfloat *in{mInput + DirectSize + mInputPos + i};
+                const ALsizei pos{(mOutPos+i) & OutputMask};
+                ALfloat out{ring[pos]};
+                ring[pos] = 0.0f;
+                for(ALsizei j{0};j < DirectSize;++j)
+                    out += filter[j] * in[-j];
+                temps[c][i] = out;
+            }
+        }
+        for(ALsizei c{0};c < mNumChans;++c)
+            MixSamples(temps[c], numOutput, samplesOut, mGains[c].Current, mGains[c].Target,
+                samplesToDo-base, base, todo);
+
+        mInputPos += todo;
+        mOutPos = (mOutPos+todo) & OutputMask;
+        mTime += static_cast<ALuint>(todo);
+        base += todo;
+        if(mTailSubmitted != mTailCollected)
+            collectTail();
+        if(mInputPos < DirectSize)
+            continue;
+        mInputPos = 0;
+
+        const ALfloat *block{mInput + DirectSize};
+        if(mHead.numParts() > 0)
+        {
+            mHead.process(block, mHeadOutput.data());
+            addOutput(mHeadOutput.data(), DirectSize*2);
+        }
+
+        if(mEarly.numParts() > 0)
+        {
+            std::copy_n(block, DirectSize, &mEarlyInput[mEarlyPos]);
+            mEarlyPos += DirectSize;
+            if(mEarlyPos == HeadSize)
+            {
+                mEarlyPos = 0;
+                mEarly.process(mEarlyInput.data(), mEarlyOutput.data());
+                addOutput(mEarlyOutput.data(), HeadSize*2);
+                if(mTail.numParts() > 0)
+                    queueTail(mEarlyInput.data());
+            }
+        }
+
+        std::copy_n(block, DirectSize, mInput);
+    }
+}
+
+void Convolution_setParami(EffectProps*, ALCcontext *context, ALenum param, ALint)
+{ alSetError(context, AL_INVALID_ENUM, "Invalid convolution integer property 0x%04x", param); }
+void Convolution_setParamiv(EffectProps*, ALCcontext *context, ALenum param, const ALint*)
+{ alSetError(context, AL_INVALID_ENUM, "Invalid convolution integer-vector property 0x%04x", param); }
+void Convolution_setParamf(EffectProps*, ALCcontext *context, ALenum param, ALfloat)
+{ alSetError(context, AL_INVALID_ENUM, "Invalid convolution float property 0x%04x", param); }
+void Convolution_setParamfv(EffectProps*, ALCcontext *context, ALenum param, const ALfloat*)
+{ alSetError(context, AL_INVALID_ENUM, "Invalid convolution float-vector property 0x%04x", param); }
+
+void Convolution_getParami(const EffectProps*, ALCcontext *context, ALenum param, ALint*)
+{ alSetError(context, AL_INVALID_ENUM, "Invalid convolution integer property 0x%04x", param); }
+void Convolution_getParamiv(const EffectProps*, ALCcontext *context, ALenum param, ALint*)
+{ alSetError(context, AL_INVALID_ENUM, "Invalid convolution integer-vector property 0x%04x", param); }
+void Convolution_getParamf(const EffectProps*, ALCcontext *context, ALenum param, ALfloat*)
+{ alSetError(context, AL_INVALID_ENUM, "Invalid convolution float property 0x%04x", param); }
+void Convolution_getParamfv(const EffectProps*, ALCcontext *context, ALenum param, ALfloat*)
+{ alSetError(context, AL_INVALID_ENUM, "Invalid convolution float-vector property 0x%04x", param); }
+
+DEFINE_ALEFFECT_VTABLE(Convolution);
+
+
+struct ConvolutionStateFactory final : public EffectStateFactory {
+    EffectState *create() override { return new ConvolutionState{}; }
+    EffectProps getDefaultProps() const noexcept override { return EffectProps{}; }
+    const EffectVtable *getEffectVtable() const noexcept override { return &Convolution_vtable; }
+    bool monoInput() const noexcept override { return true; }
+};
+
+} // namespace
+
+EffectStateFactory *ConvolutionStateFactory_getFactory()
+{
+    static ConvolutionStateFactory ConvolutionFactory{};
+    return &ConvolutionFactory;
+}
@@ -144,6 +144,7 @@ struct DedicatedStateFactory final : public EffectStateFactory {
     EffectState *create() override { return new DedicatedState{}; }
     EffectProps getDefaultProps() const noexcept override;
     const EffectVtable *getEffectVtable() const noexcept override { return &Dedicated_vtable; }
+    bool monoInput() const noexcept override { return true; }
 };
 
 EffectProps DedicatedStateFactory::getDefaultProps() const noexcept
@@ -22,8 +22,14 @@
 
 #include <cmath>
 #include <cstdlib>
+#include <tuple>
 
-#include <cmath>
+#if defined(HAVE_SSE_INTRINSICS)
+#include <xmmintrin.h>
+#elif (defined(__ARM_NEON) || defined(__ARM_NEON__)) && defined(__aarch64__)
+#include <arm_neon.h>
+#define HAVE_NEON_INTRINSICS
+#endif
 
 #include "alMain.h"
 #include "alcontext.h"
@@ -77,7 +83,7 @@ void DistortionState::update(const ALCcontext *context, const ALeffectslot *slot
     /* Multiply sampling frequency by the amount of oversampling done during
      * processing.
      */
-    auto frequency = static_cast<ALfloat>(device->Frequency);
+    auto frequency = static_cast<ALfloat>(device->MixFrequency);
     mLowpass.setParams(BiquadType::LowPass, 1.0f, cutoff / (frequency*4.0f),
         calc_rcpQ_from_bandwidth(cutoff / (frequency*4.0f), bandwidth)
     );
@@ -97,56 +103,119 @@ void DistortionState::update(const ALCcontext *context, const ALeffectslot *slot
     ComputePanGains(target.Main, coeffs, slot->Params.Gain*props->Distortion.Gain, mGain);
 }
 
+/* Passes the zero-stuffed input through the lowpass filter. Only one of every
+ * four samples is non-zero, so the filter's input terms for the others can be
+ * skipped, and the input doesn't need to be stuffed in a separate buffer.
+ */
+void LowpassZeroStuffed(BiquadFilter &filter, ALfloat *RESTRICT dst,
+    const ALfloat *RESTRICT src, const ALsizei count)
+{
+    const auto coeffs = filter.getCoefficients();
+    const ALfloat a1{coeffs[3]};
+    const ALfloat a2{coeffs[4]};
+    ALfloat z1, z2;
+    std::tie(z1, z2) = filter.getComponents();
+    for(ALsizei i{0};i < count;++i)
+    {
+        /* Multiply the sample by the amount of oversampling to maintain the
+         * signal's power.
+         */
+        *(dst++) = filter.processOne(src[i] * 4.0f, z1, z2);
+        for(int j{1};j < 4;++j)
+        {
+            const ALfloat out{z1};
+            z1 = z2 - out*a1;
+            z2 = -out*a2;
+            *(dst++) = out;
+        }
+    }
+    filter.setComponents(z1, z2);
+}
+
+/* Three steps of waveshaping, to emulate signal processing during tube
+ * overdriving. They're intended to modify the waveform without boost,
+ * clipping, or attenuation.
+ */
+void Waveshape(ALfloat *RESTRICT dst, const ALfloat *RESTRICT src, const ALfloat fc,
+    const ALsizei count)
+{
+    ALsizei i{0};
+#if defined(HAVE_SSE_INTRINSICS)
+    const __m128 fc4{_mm_set1_ps(fc)};
+    const __m128 scale4{_mm_set1_ps(1.0f + fc)};
+    const __m128 one4{_mm_set1_ps(1.0f)};
+    const __m128 sign4{_mm_set1_ps(-0.0f)};
+    auto shape = [fc4,scale4,one4,sign4](const __m128 smp) noexcept -> __m128
+    {
+        const __m128 den{_mm_add_ps(one4, _mm_mul_ps(fc4, _mm_andnot_ps(sign4, smp)))};
+        return _mm_div_ps(_mm_mul_ps(scale4, smp), den);
+    };
+    for(;count-i >= 4;i += 4)
+    {
+        __m128 smp{_mm_loadu_ps(&src[i])};
+        smp = shape(smp);
+        smp = _mm_xor_ps(shape(smp), sign4);
+        smp = shape(smp);
+        _mm_storeu_ps(&dst[i], smp);
+    }
+#elif defined(HAVE_NEON_INTRINSICS)
+    const float32x4_t fc4{vdupq_n_f32(fc)};
+    const float32x4_t scale4{vdupq_n_f32(1.0f + fc)};
+    const float32x4_t one4{vdupq_n_f32(1.0f)};
+    auto shape = [fc4,scale4,one4](const float32x4_t smp) noexcept -> float32x4_t
+    {
+        const float32x4_t den{vaddq_f32(one4, vmulq_f32(fc4, vabsq_f32(smp)))};
+        return vdivq_f32(vmulq_f32(scale4, smp), den);
+    };
+    for(;count-i >= 4;i += 4)
+    {
+        float32x4_t smp{vld1q_f32(&src[i])};
+        smp = shape(smp);
+        smp = vnegq_f32(shape(smp));
+        smp = shape(smp);
+        vst1q_f32(&dst[i], smp);
+    }
+#endif
+    for(;i < count;++i)
+    {
+        ALfloat smp{src[i]};
+
+        smp = (1.0f + fc) * smp/(1.0f + fc*std::fabs(smp));
+        smp = (1.0f + fc) * smp/(1.0f + fc*std::fabs(smp)) * -1.0f;
+        smp = (1.0f + fc) * smp/(1.0f + fc*std::fabs(smp));
+
+        dst[i] = smp;
+    }
+}
+
 void DistortionState::process(ALsizei samplesToDo, const ALfloat (*RESTRICT samplesIn)[BUFFERSIZE], const ALsizei /*numInput*/, ALfloat (*RESTRICT samplesOut)[BUFFERSIZE], const ALsizei numOutput)
 {
     ALfloat (*RESTRICT buffer)[BUFFERSIZE] = mBuffer;
     const ALfloat fc = mEdgeCoeff;
-    ALsizei base;
-    ALsizei i, k;
 
-    for(base = 0;base < samplesToDo;)
+    for(ALsizei base{0};base < samplesToDo;)
     {
         /* Perform 4x oversampling to avoid aliasing. Oversampling greatly
          * improves distortion quality and allows to implement lowpass and
          * bandpass filters using high frequencies, at which classic IIR
          * filters became unstable.
          */
-        ALsizei todo{mini(BUFFERSIZE, (samplesToDo-base) * 4)};
+        const ALsizei todo{mini(BUFFERSIZE/4, samplesToDo-base)};
 
-        /* Fill oversample buffer using zero stuffing. Multiply the sample by
-         * the amount of oversampling to maintain the signal's power.
+        /* First step, do lowpass filtering of the zero-stuffed signal. This
+         * combines interpolation and the lowpass cutoff for oversampling
+         * (which is fortunately first step of distortion) with the effect's
+         * own lowpass into the one operation.
          */
-        for(i = 0;i < todo;i++)
-            buffer[0][i] = !(i&3) ? samplesIn[0][(i>>2)+base] * 4.0f : 0.0f;
+        LowpassZeroStuffed(mLowpass, buffer[1], &samplesIn[0][base], todo);
 
-        /* First step, do lowpass filtering of original signal. Additionally
-         * perform buffer interpolation and lowpass cutoff for oversampling
-         * (which is fortunately first step of distortion). So combine three
-         * operations into the one.
-         */
-        mLowpass.process(buffer[1], buffer[0], todo);
-
-        /* Second step, do distortion using waveshaper function to emulate
-         * signal processing during tube overdriving. Three steps of
-         * waveshaping are intended to modify waveform without boost/clipping/
-         * attenuation process.
-         */
-        for(i = 0;i < todo;i++)
-        {
-            ALfloat smp = buffer[1][i];
-
-            smp = (1.0f + fc) * smp/(1.0f + fc*fabsf(smp));
-            smp = (1.0f + fc) * smp/(1.0f + fc*fabsf(smp)) * -1.0f;
-            smp = (1.0f + fc) * smp/(1.0f + fc*fabsf(smp));
-
-            buffer[0][i] = smp;
-        }
+        /* Second step, do distortion using the waveshaper. */
+        Waveshape(buffer[0], buffer[1], fc, todo*4);
 
         /* Third step, do bandpass filtering of distorted signal. */
-        mBandpass.process(buffer[1], buffer[0], todo);
+        mBandpass.process(buffer[1], buffer[0], todo*4);
 
-        todo >>= 2;
-        for(k = 0;k < numOutput;k++)
+        for(ALsizei k{0};k < numOutput;k++)
         {
             /* Fourth step, final, do attenuation and perform decimation,
              * storing only one sample out of four.
@@ -155,7 +224,7 @@ void DistortionState::process(ALsizei samplesToDo, const ALfloat (*RESTRICT samp
             if(!(std::fabs(gain) > GAIN_SILENCE_THRESHOLD))
                 continue;
 
-            for(i = 0;i < todo;i++)
+            for(ALsizei i{0};i < todo;i++)
                 samplesOut[k][base+i] += gain * buffer[1][i*4];
         }
 
@@ -253,6 +322,7 @@ struct DistortionStateFactory final : public EffectStateFactory {
     EffectState *create() override { return new DistortionState{}; }
     EffectProps getDefaultProps() const noexcept override;
     const EffectVtable *getEffectVtable() const noexcept override { return &Distortion_vtable; }
+    bool monoInput() const noexcept override { return true; }
 };
 
 EffectProps DistortionStateFactory::getDefaultProps() const noexcept
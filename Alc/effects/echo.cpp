@@ -71,8 +71,8 @@ ALboolean EchoState::deviceUpdate(const ALCdevice *Device)
 
     // Use the next power of 2 for the buffer length, so the tap offsets can be
     // wrapped using a mask instead of a modulo
-    maxlen = float2int(AL_ECHO_MAX_DELAY*Device->Frequency + 0.5f) +
-             float2int(AL_ECHO_MAX_LRDELAY*Device->Frequency + 0.5f);
+    maxlen = float2int(AL_ECHO_MAX_DELAY*Device->MixFrequency + 0.5f) +
+             float2int(AL_ECHO_MAX_LRDELAY*Device->MixFrequency + 0.5f);
     maxlen = NextPowerOf2(maxlen);
     if(maxlen <= 0) return AL_FALSE;
 
@@ -95,7 +95,7 @@ ALboolean EchoState::deviceUpdate(const ALCdevice *Device)
 void EchoState::update(const ALCcontext *context, const ALeffectslot *slot, const EffectProps *props, const EffectTarget target)
 {
     const ALCdevice *device = context->Device;
-    ALuint frequency = device->Frequency;
+    ALuint frequency = device->MixFrequency;
     ALfloat gainhf, lrpan, spread;
 
     mTap[0].delay = maxi(float2int(props->Echo.Delay*frequency + 0.5f), 1);
@@ -112,6 +112,13 @@ void EchoState::update(const ALCcontext *context, const ALeffectslot *slot, cons
 
     mFeedGain = props->Echo.Feedback;
 
+    /* Each repeat of the second tap is attenuated by the feedback gain, so
+     * the output lasts until the repeats fall below the silence threshold.
+     */
+    const ALfloat repeats{(mFeedGain > GAIN_SILENCE_THRESHOLD) ?
+        std::log(GAIN_SILENCE_THRESHOLD) / std::log(minf(mFeedGain, 0.999f)) : 0.0f};
+    mTailSamples = static_cast<ALuint>(mTap[1].delay * (repeats+1.0f));
+
     gainhf = maxf(1.0f - props->Echo.Damping, 0.0625f); /* Limit -24dB */
     mFilter.setParams(BiquadType::HighShelf, gainhf, LOWPASSFREQREF/frequency,
         calc_rcpQ_from_slope(gainhf, 1.0f)
@@ -127,6 +134,78 @@ void EchoState::update(const ALCcontext *context, const ALeffectslot *slot, cons
     ComputePanGains(target.Main, coeffs[1], slot->Params.Gain, mGains[1].Target);
 }
 
+/* The shortest first tap delay to process an echo in blocks, alone or batched
+ * with others. A block can't be longer than the first tap's delay, so the taps
+ * are read before any of the block is written back.
+ */
+constexpr ALsizei MIN_BLOCK_DELAY{32};
+
+/* Copies count samples of the delay line from pos, as up to two contiguous
+ * runs around the end of the buffer.
+ */
+inline void ReadDelay(ALfloat *RESTRICT dst, const ALfloat *RESTRICT delaybuf, const ALsizei mask,
+    ALsizei pos, const ALsizei count)
+{
+    pos &= mask;
+    const ALsizei run{mini(count, mask+1 - pos)};
+    std::copy_n(delaybuf+pos, run, dst);
+    std::copy_n(delaybuf, count-run, dst+run);
+}
+
+/* Writes count samples of input with the damped feedback to the delay line at
+ * pos, likewise as up to two contiguous runs.
+ */
+inline void WriteDelay(ALfloat *RESTRICT delaybuf, const ALsizei mask, ALsizei pos,
+    const ALfloat *RESTRICT input, const ALfloat *RESTRICT damped, const ALfloat feedgain,
+    const ALsizei count)
+{
+    pos &= mask;
+    const ALsizei run{mini(count, mask+1 - pos)};
+    for(ALsizei i{0};i < run;i++)
+        delaybuf[pos+i] = input[i] + damped[i]*feedgain;
+    for(ALsizei i{run};i < count;i++)
+        delaybuf[i-run] = input[i] + damped[i]*feedgain;
+}
+
+/* Runs the damping filter over a block, two samples per step. Each step
+ * advances the filter state by two samples at once, so the state's dependency
+ * chain is half as long as running the filter a sample at a time, which is
+ * what limits its speed.
+ */
+void DampBlock(BiquadFilter &filter, ALfloat *RESTRICT dst, const ALfloat *RESTRICT src,
+    const ALsizei count)
+{
+    const auto coeffs = filter.getCoefficients();
+    const ALfloat b0{coeffs[0]}, b1{coeffs[1]}, b2{coeffs[2]};
+    const ALfloat a1{coeffs[3]}, a2{coeffs[4]};
+    ALfloat z1, z2;
+    std::tie(z1, z2) = filter.getComponents();
+
+    /* With the state s = {z1, z2}, a sample x is s' = A*s + B*x, where
+     * A = {{-a1, 1}, {-a2, 0}} and B = {b1 - a1*b0, b2 - a2*b0}. Two samples
+     * are s'' = A*A*s + A*B*x0 + B*x1.
+     */
+    const ALfloat B0{b1 - a1*b0}, B1{b2 - a2*b0};
+    const ALfloat m00{a1*a1 - a2}, m01{-a1}, m10{a1*a2}, m11{-a2};
+    const ALfloat u00{B1 - a1*B0}, u10{-a2*B0};
+
+    ALsizei i{0};
+    for(;count-i >= 2;i += 2)
+    {
+        const ALfloat x0{src[i]}, x1{src[i+1]};
+        dst[i] = z1 + b0*x0;
+        dst[i+1] = m01*z1 + z2 + B0*x0 + b0*x1;
+        const ALfloat nz1{m00*z1 + m01*z2 + (u00*x0 + B0*x1)};
+        const ALfloat nz2{m10*z1 + m11*z2 + (u10*x0 + B1*x1)};
+        z1 = nz1;
+        z2 = nz2;
+    }
+    if(i < count)
+        dst[i] = filter.processOne(src[i], z1, z2);
+
+    filter.setComponents(z1, z2);
+}
+
 void EchoState::process(ALsizei samplesToDo, const ALfloat (*RESTRICT samplesIn)[BUFFERSIZE], const ALsizei /*numInput*/, ALfloat (*RESTRICT samplesOut)[BUFFERSIZE], const ALsizei numOutput)
 {
     const auto mask = static_cast<ALsizei>(mSampleBuffer.size()-1);
@@ -134,10 +213,39 @@ void EchoState::process(ALsizei samplesToDo, const ALfloat (*RESTRICT samplesIn)
     const ALsizei tap2{mTap[1].delay};
     ALfloat *RESTRICT delaybuf{mSampleBuffer.data()};
     ALsizei offset{mOffset};
-    ALfloat z1, z2;
     ALsizei base;
     ALsizei c, i;
 
+    if(tap1 >= MIN_BLOCK_DELAY)
+    {
+        const ALsizei maxtd{mini(tap1, 128)};
+        for(base = 0;base < samplesToDo;)
+        {
+            alignas(16) ALfloat temps[2][128];
+            alignas(16) ALfloat damped[128];
+            const ALsizei td{mini(maxtd, samplesToDo-base)};
+
+            ReadDelay(temps[0], delaybuf, mask, offset-tap1, td);
+            ReadDelay(temps[1], delaybuf, mask, offset-tap2, td);
+
+            /* Apply damping to the second tap, then add it to the buffer with
+             * feedback attenuation.
+             */
+            DampBlock(mFilter, damped, temps[1], td);
+            WriteDelay(delaybuf, mask, offset, &samplesIn[0][base], damped, mFeedGain, td);
+            offset += td;
+
+            for(c = 0;c < 2;c++)
+                MixSamples(temps[c], numOutput, samplesOut, mGains[c].Current,
+                    mGains[c].Target, samplesToDo-base, base, td);
+
+            base += td;
+        }
+        mOffset = offset;
+        return;
+    }
+
+    ALfloat z1, z2;
     std::tie(z1, z2) = mFilter.getComponents();
     for(base = 0;base < samplesToDo;)
     {
@@ -258,12 +366,103 @@ void Echo_getParamfv(const EffectProps *props, ALCcontext *context, ALenum param
 DEFINE_ALEFFECT_VTABLE(Echo);
 
 
+/* Processes up to four echoes together. The taps are read out in blocks, and
+ * the second taps' damping filters run together, one echo per vector lane.
+ */
+void ProcessEchoGroup(ALsizei samplesToDo, const EffectBatchItem *const *items, const ALsizei count)
+{
+    EchoState *states[4];
+    BiquadFilter *filters[4];
+    ALsizei offsets[4];
+    ALsizei maxtd{128};
+    for(ALsizei l{0};l < count;l++)
+    {
+        states[l] = static_cast<EchoState*>(items[l]->State);
+        filters[l] = &states[l]->mFilter;
+        offsets[l] = states[l]->mOffset;
+        maxtd = mini(maxtd, states[l]->mTap[0].delay);
+    }
+
+    for(ALsizei base{0};base < samplesToDo;)
+    {
+        alignas(16) ALfloat temps[4][2][128];
+        alignas(16) ALfloat damped[4][128];
+        ALfloat *taps2[4], *dampeds[4];
+        const ALsizei td{mini(maxtd, samplesToDo-base)};
+
+        for(ALsizei l{0};l < count;l++)
+        {
+            const EchoState *state{states[l]};
+            const auto mask = static_cast<ALsizei>(state->mSampleBuffer.size()-1);
+            const ALfloat *RESTRICT delaybuf{state->mSampleBuffer.data()};
+            ReadDelay(temps[l][0], delaybuf, mask, offsets[l] - state->mTap[0].delay, td);
+            ReadDelay(temps[l][1], delaybuf, mask, offsets[l] - state->mTap[1].delay, td);
+            taps2[l] = temps[l][1];
+            dampeds[l] = damped[l];
+        }
+
+        FilterMultiSamples(filters, dampeds, taps2, count, td);
+
+        for(ALsizei l{0};l < count;l++)
+        {
+            EchoState *state{states[l]};
+            const auto mask = static_cast<ALsizei>(state->mSampleBuffer.size()-1);
+            const ALfloat *RESTRICT input{&items[l]->SamplesIn[0][base]};
+            WriteDelay(state->mSampleBuffer.data(), mask, offsets[l], input, damped[l],
+                state->mFeedGain, td);
+            offsets[l] += td;
+
+            for(ALsizei c{0};c < 2;c++)
+                MixSamples(temps[l][c], items[l]->NumOutput, items[l]->SamplesOut,
+                    state->mGains[c].Current, state->mGains[c].Target, samplesToDo-base, base,
+                    td);
+        }
+
+        base += td;
+    }
+
+    for(ALsizei l{0};l < count;l++)
+        states[l]->mOffset = offsets[l];
+}
+
+
 struct EchoStateFactory final : public EffectStateFactory {
     EffectState *create() override { return new EchoState{}; }
     EffectProps getDefaultProps() const noexcept override;
     const EffectVtable *getEffectVtable() const noexcept override { return &Echo_vtable; }
+    bool monoInput() const noexcept override { return true; }
+
+    bool canBatch() const noexcept override { return true; }
+    void processBatch(ALsizei samplesToDo, const EffectBatchItem *items, ALsizei count) override;
 };
 
+void EchoStateFactory::processBatch(ALsizei samplesToDo, const EffectBatchItem *items, ALsizei count)
+{
+    const EffectBatchItem *group[4];
+    ALsizei grouped{0};
+    for(ALsizei i{0};i < count;i++)
+    {
+        const auto state = static_cast<const EchoState*>(items[i].State);
+        if(state->mTap[0].delay < MIN_BLOCK_DELAY)
+        {
+            items[i].State->process(samplesToDo, items[i].SamplesIn, items[i].NumInput,
+                items[i].SamplesOut, items[i].NumOutput);
+            continue;
+        }
+        group[grouped++] = &items[i];
+        if(grouped == 4)
+        {
+            ProcessEchoGroup(samplesToDo, group, grouped);
+            grouped = 0;
+        }
+    }
+    if(grouped == 1)
+        group[0]->State->process(samplesToDo, group[0]->SamplesIn, group[0]->NumInput,
+            group[0]->SamplesOut, group[0]->NumOutput);
+    else if(grouped > 1)
+        ProcessEchoGroup(samplesToDo, group, grouped);
+}
+
 EffectProps EchoStateFactory::getDefaultProps() const noexcept
 {
     EffectProps props{};
@@ -79,17 +79,20 @@ namespace {
  * http://www.musicdsp.org/files/Audio-EQ-Cookbook.txt                   */
 
 
+/* The number of input channels filtered together. */
+constexpr ALsizei FILTER_GROUP_SIZE{4};
+
 struct EqualizerState final : public EffectState {
     struct {
         /* Effect parameters */
-        BiquadFilter filter[4];
+        BiquadFilter filter[BIQUAD_CASCADE_STAGES];
 
         /* Effect gains for each channel */
         ALfloat CurrentGains[MAX_OUTPUT_CHANNELS]{};
         ALfloat TargetGains[MAX_OUTPUT_CHANNELS]{};
     } mChans[MAX_AMBI_CHANNELS];
 
-    ALfloat mSampleBuffer[BUFFERSIZE]{};
+    alignas(16) ALfloat mSampleBuffer[FILTER_GROUP_SIZE][BUFFERSIZE]{};
 
 
     ALboolean deviceUpdate(const ALCdevice *device) override;
@@ -113,7 +116,7 @@ ALboolean EqualizerState::deviceUpdate(const ALCdevice *UNUSED(device))
 void EqualizerState::update(const ALCcontext *context, const ALeffectslot *slot, const EffectProps *props, const EffectTarget target)
 {
     const ALCdevice *device = context->Device;
-    auto frequency = static_cast<ALfloat>(device->Frequency);
+    auto frequency = static_cast<ALfloat>(device->MixFrequency);
     ALfloat gain, f0norm;
 
     /* Calculate coefficients for the each type of filter. Note that the shelf
@@ -161,15 +164,24 @@ void EqualizerState::update(const ALCcontext *context, const ALeffectslot *slot,
 void EqualizerState::process(ALsizei samplesToDo, const ALfloat (*RESTRICT samplesIn)[BUFFERSIZE], const ALsizei numInput, ALfloat (*RESTRICT samplesOut)[BUFFERSIZE], const ALsizei numOutput)
 {
     ASSUME(numInput > 0);
-    for(ALsizei c{0};c < numInput;c++)
+    for(ALsizei base{0};base < numInput;base += FILTER_GROUP_SIZE)
     {
-        mChans[c].filter[0].process(mSampleBuffer, samplesIn[c], samplesToDo);
-        mChans[c].filter[1].process(mSampleBuffer, mSampleBuffer, samplesToDo);
-        mChans[c].filter[2].process(mSampleBuffer, mSampleBuffer, samplesToDo);
-        mChans[c].filter[3].process(mSampleBuffer, mSampleBuffer, samplesToDo);
-
-        MixSamples(mSampleBuffer, numOutput, samplesOut, mChans[c].CurrentGains,
-            mChans[c].TargetGains, samplesToDo, 0, samplesToDo);
+        const ALsizei todo{mini(numInput-base, FILTER_GROUP_SIZE)};
+        BiquadFilter *filters[FILTER_GROUP_SIZE];
+        const ALfloat *srcs[FILTER_GROUP_SIZE];
+        ALfloat *dsts[FILTER_GROUP_SIZE];
+        for(ALsizei i{0};i < todo;i++)
+        {
+            filters[i] = mChans[base+i].filter;
+            srcs[i] = samplesIn[base+i];
+            dsts[i] = mSampleBuffer[i];
+        }
+        /* Run the low shelf, both peaking, and high shelf filters together. */
+        FilterCascadeSamples(filters, dsts, srcs, todo, samplesToDo);
+
+        for(ALsizei i{0};i < todo;i++)
+            MixSamples(mSampleBuffer[i], numOutput, samplesOut, mChans[base+i].CurrentGains,
+                mChans[base+i].TargetGains, samplesToDo, 0, samplesToDo);
     }
 }
 
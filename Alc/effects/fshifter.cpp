@@ -23,7 +23,6 @@
 #include <cmath>
 #include <cstdlib>
 #include <array>
-#include <complex>
 #include <algorithm>
 
 #include "alMain.h"
@@ -31,48 +30,37 @@
 #include "alAuxEffectSlot.h"
 #include "alError.h"
 #include "alu.h"
-
-#include "alcomplex.h"
+#include "uhjfilter.h"
 
 namespace {
 
-using complex_d = std::complex<double>;
-
-#define HIL_SIZE 1024
-#define OVERSAMP (1<<2)
+/* The maximum number of samples phase-shifted at a time. */
+#define MAX_UPDATE_SAMPLES 128
 
-#define HIL_STEP     (HIL_SIZE / OVERSAMP)
-#define FIFO_LATENCY (HIL_STEP * (OVERSAMP-1))
+/* The all-pass chains ring for a while at low frequencies. Their impulse
+ * responses fall below -100dB within this many samples.
+ */
+#define HILBERT_TAIL 5200
 
-/* Define a Hann window, used to filter the HIL input and output. */
-/* Making this constexpr seems to require C++14. */
-std::array<ALdouble,HIL_SIZE> InitHannWindow()
-{
-    std::array<ALdouble,HIL_SIZE> ret;
-    /* Create lookup table of the Hann window for the desired size, i.e. HIL_SIZE */
-    for(ALsizei i{0};i < HIL_SIZE>>1;i++)
-    {
-        ALdouble val = std::sin(al::MathDefs<double>::Pi() * i / ALdouble{HIL_SIZE-1});
-        ret[i] = ret[HIL_SIZE-1-i] = val * val;
-    }
-    return ret;
-}
-alignas(16) const std::array<ALdouble,HIL_SIZE> HannWindow = InitHannWindow();
+/* The overlapped windows of the frequency shifter's former FFT-based Hilbert
+ * transform gave it an output gain of 0.75, which is kept so the effect's
+ * level doesn't change.
+ */
+constexpr double OutputGain{0.75};
 
 
 struct FshifterState final : public EffectState {
     /* Effect parameters */
-    ALsizei  mCount{};
     ALsizei  mPhaseStep{};
     ALsizei  mPhase{};
     ALdouble mLdSign{};
 
-    /*Effects buffers*/ 
-    ALfloat   mInFIFO[HIL_SIZE]{};
-    complex_d mOutFIFO[HIL_SIZE]{};
-    complex_d mOutputAccum[HIL_SIZE]{};
-    complex_d mAnalytic[HIL_SIZE]{};
-    complex_d mOutdata[BUFFERSIZE]{};
+    /* The analytic signal is made with the Hilbert transform's all-pass
+     * chains, as for UHJ encoding. The real part is Filter1's output delayed
+     * by a sample, and the imaginary part is Filter2's output.
+     */
+    HilbertAllPass mHilbert;
+    ALfloat mLastReal{};
 
     alignas(16) ALfloat mBufferOut[BUFFERSIZE]{};
 
@@ -91,15 +79,14 @@ struct FshifterState final : public EffectState {
 ALboolean FshifterState::deviceUpdate(const ALCdevice *UNUSED(device))
 {
     /* (Re-)initializing parameters and clear the buffers. */
-    mCount     = FIFO_LATENCY;
     mPhaseStep = 0;
     mPhase     = 0;
     mLdSign    = 1.0;
 
-    std::fill(std::begin(mInFIFO),      std::end(mInFIFO),      0.0f);
-    std::fill(std::begin(mOutFIFO),     std::end(mOutFIFO),     complex_d{});
-    std::fill(std::begin(mOutputAccum), std::end(mOutputAccum), complex_d{});
-    std::fill(std::begin(mAnalytic),    std::end(mAnalytic),    complex_d{});
+    mTailSamples = HILBERT_TAIL;
+
+    mHilbert.clear();
+    mLastReal = 0.0f;
 
     std::fill(std::begin(mCurrentGains), std::end(mCurrentGains), 0.0f);
     std::fill(std::begin(mTargetGains),  std::end(mTargetGains),  0.0f);
@@ -111,7 +98,7 @@ void FshifterState::update(const ALCcontext *context, const ALeffectslot *slot,
 {
     const ALCdevice *device{context->Device};
 
-    ALfloat step{props->Fshifter.Frequency / static_cast<ALfloat>(device->Frequency)};
+    ALfloat step{props->Fshifter.Frequency / static_cast<ALfloat>(device->MixFrequency)};
     mPhaseStep = fastf2i(minf(step, 0.5f) * FRACTIONONE);
 
     switch(props->Fshifter.LeftDirection)
@@ -140,61 +127,46 @@ void FshifterState::update(const ALCcontext *context, const ALeffectslot *slot,
 
 void FshifterState::process(ALsizei samplesToDo, const ALfloat (*RESTRICT samplesIn)[BUFFERSIZE], const ALsizei /*numInput*/, ALfloat (*RESTRICT samplesOut)[BUFFERSIZE], const ALsizei numOutput)
 {
-    static constexpr complex_d complex_zero{0.0, 0.0};
+    alignas(16) ALfloat real[MAX_UPDATE_SAMPLES], imag[MAX_UPDATE_SAMPLES];
+    alignas(16) ALfloat unused[MAX_UPDATE_SAMPLES]{};
     ALfloat *RESTRICT BufferOut = mBufferOut;
-    ALsizei j, k, base;
 
-    for(base = 0;base < samplesToDo;)
+    for(ALsizei base{0};base < samplesToDo;)
     {
-        const ALsizei todo{mini(HIL_SIZE-mCount, samplesToDo-base)};
-
-        ASSUME(todo > 0);
-
-        /* Fill FIFO buffer with samples data */
-        k = mCount;
-        for(j = 0;j < todo;j++,k++)
+        const ALsizei todo{mini(MAX_UPDATE_SAMPLES, samplesToDo-base)};
+
+        /* Processing signal by the Hilbert transform's all-pass chains
+         * (analytical signal).
+         */
+        std::copy_n(&samplesIn[0][base], todo, real);
+        std::copy_n(&samplesIn[0][base], todo, imag);
+        mHilbert.process(real, imag, unused, todo);
+
+        /* Process frequency shifter using the analytic signal obtained. The
+         * oscillator starts each run at the exact phase, and is rotated by
+         * the phase step for each sample.
+         */
+        const double phase{mPhase * ((1.0/FRACTIONONE) * al::MathDefs<double>::Tau())};
+        const double step{mPhaseStep * ((1.0/FRACTIONONE) * al::MathDefs<double>::Tau())};
+        const double stepcos{std::cos(step)}, stepsin{std::sin(step)};
+        double osccos{std::cos(phase)}, oscsin{std::sin(phase) * mLdSign};
+        const double signedstepsin{stepsin * mLdSign};
+
+        ALfloat lastreal{mLastReal};
+        for(ALsizei k{0};k < todo;k++)
         {
-            mInFIFO[k] = samplesIn[0][base+j];
-            mOutdata[base+j]  = mOutFIFO[k-FIFO_LATENCY];
-        }
-        mCount += todo;
-        base += todo;
-
-        /* Check whether FIFO buffer is filled */
-        if(mCount < HIL_SIZE) continue;
-        mCount = FIFO_LATENCY;
+            BufferOut[base+k] = static_cast<float>((lastreal*osccos + imag[k]*oscsin) *
+                OutputGain);
+            lastreal = real[k];
 
-        /* Real signal windowing and store in Analytic buffer */
-        for(k = 0;k < HIL_SIZE;k++)
-        {
-            mAnalytic[k].real(mInFIFO[k] * HannWindow[k]);
-            mAnalytic[k].imag(0.0);
+            const double newcos{osccos*stepcos - oscsin*signedstepsin};
+            oscsin = oscsin*stepcos + osccos*signedstepsin;
+            osccos = newcos;
         }
+        mLastReal = lastreal;
+        mPhase = (mPhase + mPhaseStep*todo) & FRACTIONMASK;
 
-        /* Processing signal by Discrete Hilbert Transform (analytical signal). */
-        complex_hilbert(mAnalytic, HIL_SIZE);
-
-        /* Windowing and add to output accumulator */
-        for(k = 0;k < HIL_SIZE;k++)
-            mOutputAccum[k] += 2.0/OVERSAMP*HannWindow[k]*mAnalytic[k];
-
-        /* Shift accumulator, input & output FIFO */
-        for(k = 0;k < HIL_STEP;k++) mOutFIFO[k] = mOutputAccum[k];
-        for(j = 0;k < HIL_SIZE;k++,j++) mOutputAccum[j] = mOutputAccum[k];
-        for(;j < HIL_SIZE;j++) mOutputAccum[j] = complex_zero;
-        for(k = 0;k < FIFO_LATENCY;k++)
-            mInFIFO[k] = mInFIFO[k+HIL_STEP];
-    }
-
-    /* Process frequency shifter using the analytic signal obtained. */
-    for(k = 0;k < samplesToDo;k++)
-    {
-        double phase = mPhase * ((1.0/FRACTIONONE) * al::MathDefs<double>::Tau());
-        BufferOut[k] = static_cast<float>(mOutdata[k].real()*std::cos(phase) +
-            mOutdata[k].imag()*std::sin(phase)*mLdSign);
-
-        mPhase += mPhaseStep;
-        mPhase &= FRACTIONMASK;
+        base += todo;
     }
 
     /* Now, mix the processed sound data to the output. */
@@ -282,6 +254,7 @@ struct FshifterStateFactory final : public EffectStateFactory {
     EffectState *create() override { return new FshifterState{}; }
     EffectProps getDefaultProps() const noexcept override;
     const EffectVtable *getEffectVtable() const noexcept override { return &Fshifter_vtable; }
+    bool monoInput() const noexcept override { return true; }
 };
 
 EffectProps FshifterStateFactory::getDefaultProps() const noexcept
@@ -23,7 +23,6 @@
 #include <cmath>
 #include <cstdlib>
 
-#include <cmath>
 #include <algorithm>
 
 #include "alMain.h"
@@ -43,10 +42,34 @@ namespace {
 #define WAVEFORM_FRACONE   (1<<WAVEFORM_FRACBITS)
 #define WAVEFORM_FRACMASK  (WAVEFORM_FRACONE-1)
 
+/* The sine wave is looked up from a table of one period, with the remaining
+ * fractional bits of the index linearly interpolating between entries.
+ */
+#define SINTABLE_BITS      10
+#define SINTABLE_SIZE      (1<<SINTABLE_BITS)
+#define SINTABLE_FRACBITS  (WAVEFORM_FRACBITS-SINTABLE_BITS)
+#define SINTABLE_FRACONE   (1<<SINTABLE_FRACBITS)
+#define SINTABLE_FRACMASK  (SINTABLE_FRACONE-1)
+
+struct SinTable {
+    /* One extra entry to interpolate the last toward. */
+    ALfloat mValues[SINTABLE_SIZE+1];
+
+    SinTable()
+    {
+        for(ALsizei i{0};i <= SINTABLE_SIZE;i++)
+            mValues[i] = static_cast<ALfloat>(std::sin(i * (al::MathDefs<double>::Tau() /
+                SINTABLE_SIZE)));
+    }
+};
+const SinTable gSinTable{};
+
 inline ALfloat Sin(ALsizei index)
 {
-    return std::sin(static_cast<ALfloat>(index) *
-        (al::MathDefs<float>::Tau() / ALfloat{WAVEFORM_FRACONE}));
+    const ALsizei pos{index >> SINTABLE_FRACBITS};
+    const ALfloat frac{static_cast<ALfloat>(index&SINTABLE_FRACMASK) *
+        (1.0f/ALfloat{SINTABLE_FRACONE})};
+    return lerp(gSinTable.mValues[pos], gSinTable.mValues[pos+1], frac);
 }
 
 inline ALfloat Saw(ALsizei index)
@@ -112,7 +135,7 @@ void ModulatorState::update(const ALCcontext *context, const ALeffectslot *slot,
 {
     const ALCdevice *device{context->Device};
 
-    const float step{props->Modulator.Frequency / static_cast<ALfloat>(device->Frequency)};
+    const float step{props->Modulator.Frequency / static_cast<ALfloat>(device->MixFrequency)};
     mStep = fastf2i(clampf(step*WAVEFORM_FRACONE, 0.0f, ALfloat{WAVEFORM_FRACONE-1}));
 
     if(mStep == 0)
@@ -124,7 +147,7 @@ void ModulatorState::update(const ALCcontext *context, const ALeffectslot *slot,
     else /*if(Slot->Params.EffectProps.Modulator.Waveform == AL_RING_MODULATOR_SQUARE)*/
         mGetSamples = Modulate<Square>;
 
-    ALfloat f0norm{props->Modulator.HighPassCutoff / static_cast<ALfloat>(device->Frequency)};
+    ALfloat f0norm{props->Modulator.HighPassCutoff / static_cast<ALfloat>(device->MixFrequency)};
     f0norm = clampf(f0norm, 1.0f/512.0f, 0.49f);
     /* Bandwidth value is constant in octaves. */
     mChans[0].Filter.setParams(BiquadType::HighPass, 1.0f, f0norm,
@@ -149,6 +172,7 @@ void ModulatorState::process(ALsizei samplesToDo, const ALfloat (*RESTRICT sampl
     for(base = 0;base < samplesToDo;)
     {
         alignas(16) ALfloat modsamples[MAX_UPDATE_SAMPLES];
+        alignas(16) ALfloat temps[MAX_AMBI_CHANNELS][MAX_UPDATE_SAMPLES];
         ALsizei td = mini(MAX_UPDATE_SAMPLES, samplesToDo-base);
         ALsizei c, i;
 
@@ -156,16 +180,25 @@ void ModulatorState::process(ALsizei samplesToDo, const ALfloat (*RESTRICT sampl
         mIndex += (step*td) & WAVEFORM_FRACMASK;
         mIndex &= WAVEFORM_FRACMASK;
 
+        /* Filter all the channels together, then apply the modulation. */
+        BiquadFilter *filters[MAX_AMBI_CHANNELS];
+        ALfloat *dsts[MAX_AMBI_CHANNELS];
+        const ALfloat *srcs[MAX_AMBI_CHANNELS];
         ASSUME(numInput > 0);
         for(c = 0;c < numInput;c++)
         {
-            alignas(16) ALfloat temps[MAX_UPDATE_SAMPLES];
+            filters[c] = &mChans[c].Filter;
+            dsts[c] = temps[c];
+            srcs[c] = &samplesIn[c][base];
+        }
+        FilterMultiSamples(filters, dsts, srcs, numInput, td);
 
-            mChans[c].Filter.process(temps, &samplesIn[c][base], td);
+        for(c = 0;c < numInput;c++)
+        {
             for(i = 0;i < td;i++)
-                temps[i] *= modsamples[i];
+                temps[c][i] *= modsamples[i];
 
-            MixSamples(temps, numOutput, samplesOut, mChans[c].CurrentGains,
+            MixSamples(temps[c], numOutput, samplesOut, mChans[c].CurrentGains,
                        mChans[c].TargetGains, samplesToDo-base, base, td);
         }
 
@@ -39,18 +39,23 @@
 #include "alcomplex.h"
 
 
-namespace {
+/* This is a user config option for the pitch shifter quality used by effect
+ * slots that don't specify one.
+ */
+ALenum PshifterQuality = AL_QUALITY_HIGH_SOFT;
+
 
-using complex_d = std::complex<double>;
+namespace {
 
 #define STFT_SIZE      1024
 #define STFT_HALF_SIZE (STFT_SIZE>>1)
-#define OVERSAMP       (1<<2)
 
-#define STFT_STEP    (STFT_SIZE / OVERSAMP)
-#define FIFO_LATENCY (STFT_STEP * (OVERSAMP-1))
+/* The high quality tier overlaps four frames, the low quality tier two. */
+#define HIGH_OVERSAMP  (1<<2)
+#define LOW_OVERSAMP   (1<<1)
+#define MAX_STFT_STEP  (STFT_SIZE / LOW_OVERSAMP)
 
-inline int double2int(double d)
+inline int real2int(double d)
 {
 #if defined(HAVE_SSE_INTRINSICS)
     return _mm_cvttsd_si32(_mm_set_sd(d));
@@ -84,6 +89,27 @@ inline int double2int(double d)
 #endif
 }
 
+inline int real2int(float f)
+{
+#if defined(HAVE_SSE_INTRINSICS)
+    return _mm_cvtt_ss2si(_mm_set_ss(f));
+#else
+    return static_cast<int>(f);
+#endif
+}
+
+/* Double precision holds the accumulated synthesis phase well enough to play
+ * for ages, but float quickly loses it as the phase grows, so it's kept within
+ * +/- Pi.
+ */
+inline double wrap_phase(double phase)
+{ return phase; }
+inline float wrap_phase(float phase)
+{
+    constexpr float tau{al::MathDefs<float>::Tau()};
+    return phase - tau*std::round(phase / tau);
+}
+
 /* Define a Hann window, used to filter the STFT input and output. */
 /* Making this constexpr seems to require C++14. */
 std::array<ALdouble,STFT_SIZE> InitHannWindow()
@@ -99,30 +125,239 @@ std::array<ALdouble,STFT_SIZE> InitHannWindow()
 }
 alignas(16) const std::array<ALdouble,STFT_SIZE> HannWindow = InitHannWindow();
 
+/* With only two overlapping frames, the squared Hann window would modulate
+ * the output, so the low quality tier uses the square root of a periodic Hann
+ * window (a sine window). Its square overlaps to a constant.
+ */
+std::array<ALfloat,STFT_SIZE> InitSineWindow()
+{
+    std::array<ALfloat,STFT_SIZE> ret;
+    for(ALsizei i{0};i < STFT_SIZE;i++)
+        ret[i] = static_cast<ALfloat>(std::sin(al::MathDefs<double>::Pi() * (i+0.5) /
+            ALdouble{STFT_SIZE}));
+    return ret;
+}
+alignas(16) const std::array<ALfloat,STFT_SIZE> SineWindow = InitSineWindow();
+
+/* The transform plans for the STFT, shared by all instances. */
+const RealFftPlan<double> StftPlan{STFT_SIZE};
+const RealFftPlan<float> StftPlanF{STFT_SIZE};
+
 
+template<typename Real>
 struct ALphasor {
-    ALdouble Amplitude;
-    ALdouble Phase;
+    Real Amplitude;
+    Real Phase;
 };
 
+template<typename Real>
 struct ALfrequencyDomain {
-    ALdouble Amplitude;
-    ALdouble Frequency;
+    Real Amplitude;
+    Real Frequency;
 };
 
 
 /* Converts complex to ALphasor */
-inline ALphasor rect2polar(const complex_d &number)
+template<typename Real>
+inline ALphasor<Real> rect2polar(const std::complex<Real> &number)
 {
-    ALphasor polar;
+    ALphasor<Real> polar;
     polar.Amplitude = std::abs(number);
     polar.Phase     = std::arg(number);
     return polar;
 }
 
 /* Converts ALphasor to complex */
-inline complex_d polar2rect(const ALphasor &number)
-{ return std::polar<double>(number.Amplitude, number.Phase); }
+template<typename Real>
+inline std::complex<Real> polar2rect(const ALphasor<Real> &number)
+{ return std::polar<Real>(number.Amplitude, number.Phase); }
+
+/* The low quality tier approximates the conversions, which are most of its
+ * cost otherwise. The phase is within about 1e-5 radians, and the sine and
+ * cosine within about 4e-6. Hypot's protection from overflow isn't needed.
+ */
+template<>
+inline ALphasor<float> rect2polar(const std::complex<float> &number)
+{
+    constexpr float pi{al::MathDefs<float>::Pi()};
+    const float x{number.real()}, y{number.imag()};
+    const float ax{std::fabs(x)}, ay{std::fabs(y)};
+    const float mx{maxf(ax, ay)};
+    const float a{(mx > 0.0f) ? minf(ax, ay) / mx : 0.0f};
+    const float s{a * a};
+    float r{((-0.0464964749f*s + 0.15931422f)*s - 0.327622764f)*s*a + a};
+    if(ay > ax) r = pi*0.5f - r;
+    if(x < 0.0f) r = pi - r;
+
+    ALphasor<float> polar;
+    polar.Amplitude = std::sqrt(x*x + y*y);
+    polar.Phase     = std::copysign(r, y);
+    return polar;
+}
+
+/* Sine of a value within +/- Pi. */
+inline float sin_pi_range(float x)
+{
+    constexpr float pi{al::MathDefs<float>::Pi()};
+    /* Fold into +/- Pi/2, where sin(x) = sin(Pi - x). */
+    if(x > pi*0.5f) x = pi - x;
+    else if(x < -pi*0.5f) x = -pi - x;
+    const float s{x * x};
+    return x * (1.0f + s*(-1.0f/6.0f + s*(1.0f/120.0f + s*(-1.0f/5040.0f +
+        s*(1.0f/362880.0f)))));
+}
+
+template<>
+inline std::complex<float> polar2rect(const ALphasor<float> &number)
+{
+    constexpr float pi{al::MathDefs<float>::Pi()};
+    /* cos(x) = sin(x + Pi/2), brought back within +/- Pi. */
+    const float phase{number.Phase};
+    const float cosphase{(phase > pi*0.5f) ? phase - pi*1.5f : phase + pi*0.5f};
+    return std::complex<float>{number.Amplitude * sin_pi_range(cosphase),
+        number.Amplitude * sin_pi_range(phase)};
+}
+
+
+/* The spectral processing of one quality tier, at the given precision. */
+template<typename Real>
+struct PshifterStft {
+    Real mLastPhase[STFT_HALF_SIZE+1];
+    Real mSumPhase[STFT_HALF_SIZE+1];
+    Real mOutputAccum[STFT_SIZE];
+
+    Real mWindowBuffer[STFT_SIZE];
+    std::complex<Real> mFFTbuffer[STFT_HALF_SIZE+1];
+
+    ALfrequencyDomain<Real> mAnalysis_buffer[STFT_HALF_SIZE+1];
+    ALfrequencyDomain<Real> mSyntesis_buffer[STFT_HALF_SIZE+1];
+
+    void clear();
+
+    /* Processes one frame of STFT_SIZE input samples, and writes step samples
+     * of output.
+     */
+    template<ALsizei Oversamp, typename Window>
+    void processFrame(const RealFftPlan<Real> &plan, const Window &window, const Real outscale,
+        const ALfloat *input, ALfloat *output, const Real freq_per_bin, const ALsizei pitchI,
+        const Real pitch);
+};
+
+template<typename Real>
+void PshifterStft<Real>::clear()
+{
+    std::fill(std::begin(mLastPhase),       std::end(mLastPhase),       Real{0});
+    std::fill(std::begin(mSumPhase),        std::end(mSumPhase),        Real{0});
+    std::fill(std::begin(mOutputAccum),     std::end(mOutputAccum),     Real{0});
+    std::fill(std::begin(mFFTbuffer),       std::end(mFFTbuffer),       std::complex<Real>{});
+    std::fill(std::begin(mAnalysis_buffer), std::end(mAnalysis_buffer), ALfrequencyDomain<Real>{});
+    std::fill(std::begin(mSyntesis_buffer), std::end(mSyntesis_buffer), ALfrequencyDomain<Real>{});
+}
+
+template<typename Real>
+template<ALsizei Oversamp, typename Window>
+void PshifterStft<Real>::processFrame(const RealFftPlan<Real> &plan, const Window &window,
+    const Real outscale, const ALfloat *input, ALfloat *output, const Real freq_per_bin,
+    const ALsizei pitchI, const Real pitch)
+{
+    static constexpr ALsizei step{STFT_SIZE / Oversamp};
+    static constexpr Real expected{al::MathDefs<Real>::Tau() / Oversamp};
+    static constexpr Real pi{al::MathDefs<Real>::Pi()};
+
+    /* Real signal windowing and store in WindowBuffer */
+    for(ALsizei k{0};k < STFT_SIZE;k++)
+        mWindowBuffer[k] = input[k] * window[k];
+
+    /* ANALYSIS */
+    /* Apply FFT to the windowed data. Since the real FFT is symmetric, only
+     * STFT_HALF_SIZE+1 samples are produced and needed.
+     */
+    plan.forward(mWindowBuffer, mFFTbuffer);
+
+    /* Analyze the obtained data. */
+    for(ALsizei k{0};k < STFT_HALF_SIZE+1;k++)
+    {
+        /* Compute amplitude and phase */
+        ALphasor<Real> component{rect2polar(mFFTbuffer[k])};
+
+        /* Compute phase difference and subtract expected phase difference */
+        Real tmp{(component.Phase - mLastPhase[k]) - static_cast<Real>(k)*expected};
+
+        /* Map delta phase into +/- Pi interval */
+        int qpd{real2int(tmp / pi)};
+        tmp -= pi * static_cast<Real>(qpd + (qpd%2));
+
+        /* Get deviation from bin frequency from the +/- Pi interval */
+        tmp /= expected;
+
+        /* Compute the k-th partials' true frequency, twice the amplitude for
+         * maintain the gain (because half of bins are used) and store
+         * amplitude and true frequency in analysis buffer.
+         */
+        mAnalysis_buffer[k].Amplitude = Real{2} * component.Amplitude;
+        mAnalysis_buffer[k].Frequency = (static_cast<Real>(k) + tmp) * freq_per_bin;
+
+        /* Store actual phase[k] for the calculations in the next frame*/
+        mLastPhase[k] = component.Phase;
+    }
+
+    /* PROCESSING */
+    /* pitch shifting */
+    for(ALsizei k{0};k < STFT_HALF_SIZE+1;k++)
+    {
+        mSyntesis_buffer[k].Amplitude = Real{0};
+        mSyntesis_buffer[k].Frequency = Real{0};
+    }
+
+    for(ALsizei k{0};k < STFT_HALF_SIZE+1;k++)
+    {
+        ALsizei j{(k*pitchI) >> FRACTIONBITS};
+        if(j >= STFT_HALF_SIZE+1) break;
+
+        mSyntesis_buffer[j].Amplitude += mAnalysis_buffer[k].Amplitude;
+        mSyntesis_buffer[j].Frequency  = mAnalysis_buffer[k].Frequency * pitch;
+    }
+
+    /* SYNTHESIS */
+    /* Synthesis the processing data */
+    for(ALsizei k{0};k < STFT_HALF_SIZE+1;k++)
+    {
+        ALphasor<Real> component;
+        Real tmp;
+
+        /* Compute bin deviation from scaled freq */
+        tmp = mSyntesis_buffer[k].Frequency/freq_per_bin - static_cast<Real>(k);
+
+        /* Calculate actual delta phase and accumulate it to get bin phase */
+        mSumPhase[k] = wrap_phase(mSumPhase[k] + (static_cast<Real>(k) + tmp) * expected);
+
+        component.Amplitude = mSyntesis_buffer[k].Amplitude;
+        component.Phase     = mSumPhase[k];
+
+        /* Compute phasor component to cartesian complex number and storage it into FFTbuffer*/
+        mFFTbuffer[k] = polar2rect(component);
+    }
+    /* The real iFFT treats the bins as half of a symmetric spectrum,
+     * effectively doubling them compared to the real part of a one-sided
+     * spectrum, except for the DC and Nyquist bins which must be real.
+     */
+    mFFTbuffer[0] = std::complex<Real>{mFFTbuffer[0].real()*Real{2}, Real{0}};
+    mFFTbuffer[STFT_HALF_SIZE] = std::complex<Real>{mFFTbuffer[STFT_HALF_SIZE].real()*Real{2},
+        Real{0}};
+
+    /* Apply iFFT to buffer data */
+    plan.inverse(mFFTbuffer, mWindowBuffer);
+
+    /* Windowing and add to output */
+    for(ALsizei k{0};k < STFT_SIZE;k++)
+        mOutputAccum[k] += window[k] * mWindowBuffer[k] / outscale;
+
+    /* Shift accumulator */
+    ALsizei j, k;
+    for(k = 0;k < step;k++) output[k] = static_cast<ALfloat>(mOutputAccum[k]);
+    for(j = 0;k < STFT_SIZE;k++,j++) mOutputAccum[j] = mOutputAccum[k];
+    for(;j < STFT_SIZE;j++) mOutputAccum[j] = Real{0};
+}
 
 
 struct PshifterState final : public EffectState {
@@ -132,17 +367,19 @@ struct PshifterState final : public EffectState {
     ALfloat mPitchShift;
     ALfloat mFreqPerBin;
 
+    /* The low quality tier processes single-precision frames with half the
+     * overlap, for a fraction of the cost.
+     */
+    bool mLowQuality{false};
+    ALsizei mStep;
+    ALsizei mLatency;
+
     /* Effects buffers */
     ALfloat mInFIFO[STFT_SIZE];
-    ALfloat mOutFIFO[STFT_STEP];
-    ALdouble mLastPhase[STFT_HALF_SIZE+1];
-    ALdouble mSumPhase[STFT_HALF_SIZE+1];
-    ALdouble mOutputAccum[STFT_SIZE];
-
-    complex_d mFFTbuffer[STFT_SIZE];
+    ALfloat mOutFIFO[MAX_STFT_STEP];
 
-    ALfrequencyDomain mAnalysis_buffer[STFT_HALF_SIZE+1];
-    ALfrequencyDomain mSyntesis_buffer[STFT_HALF_SIZE+1];
+    PshifterStft<double> mHigh;
+    PshifterStft<float> mLow;
 
     alignas(16) ALfloat mBufferOut[BUFFERSIZE];
 
@@ -151,6 +388,8 @@ struct PshifterState final : public EffectState {
     ALfloat mTargetGains[MAX_OUTPUT_CHANNELS];
 
 
+    void clearFrames();
+
     ALboolean deviceUpdate(const ALCdevice *device) override;
     void update(const ALCcontext *context, const ALeffectslot *slot, const EffectProps *props, const EffectTarget target) override;
     void process(ALsizei samplesToDo, const ALfloat (*RESTRICT samplesIn)[BUFFERSIZE], const ALsizei numInput, ALfloat (*RESTRICT samplesOut)[BUFFERSIZE], const ALsizei numOutput) override;
@@ -158,22 +397,30 @@ struct PshifterState final : public EffectState {
     DEF_NEWDEL(PshifterState)
 };
 
+/* Starts the current tier over, with empty frames. */
+void PshifterState::clearFrames()
+{
+    const ALsizei oversamp{mLowQuality ? LOW_OVERSAMP : HIGH_OVERSAMP};
+    mStep        = STFT_SIZE / oversamp;
+    mLatency     = mStep * (oversamp-1);
+    mCount       = mLatency;
+    mTailSamples = STFT_SIZE + mLatency;
+
+    std::fill(std::begin(mInFIFO),  std::end(mInFIFO),  0.0f);
+    std::fill(std::begin(mOutFIFO), std::end(mOutFIFO), 0.0f);
+    if(mLowQuality)
+        mLow.clear();
+    else
+        mHigh.clear();
+}
+
 ALboolean PshifterState::deviceUpdate(const ALCdevice *device)
 {
     /* (Re-)initializing parameters and clear the buffers. */
-    mCount       = FIFO_LATENCY;
     mPitchShiftI = FRACTIONONE;
     mPitchShift  = 1.0f;
-    mFreqPerBin  = device->Frequency / static_cast<ALfloat>(STFT_SIZE);
-
-    std::fill(std::begin(mInFIFO),          std::end(mInFIFO),          0.0f);
-    std::fill(std::begin(mOutFIFO),         std::end(mOutFIFO),         0.0f);
-    std::fill(std::begin(mLastPhase),       std::end(mLastPhase),       0.0);
-    std::fill(std::begin(mSumPhase),        std::end(mSumPhase),        0.0);
-    std::fill(std::begin(mOutputAccum),     std::end(mOutputAccum),     0.0);
-    std::fill(std::begin(mFFTbuffer),       std::end(mFFTbuffer),       complex_d{});
-    std::fill(std::begin(mAnalysis_buffer), std::end(mAnalysis_buffer), ALfrequencyDomain{});
-    std::fill(std::begin(mSyntesis_buffer), std::end(mSyntesis_buffer), ALfrequencyDomain{});
+    mFreqPerBin  = device->MixFrequency / static_cast<ALfloat>(STFT_SIZE);
+    clearFrames();
 
     std::fill(std::begin(mCurrentGains), std::end(mCurrentGains), 0.0f);
     std::fill(std::begin(mTargetGains),  std::end(mTargetGains),  0.0f);
@@ -181,7 +428,7 @@ ALboolean PshifterState::deviceUpdate(const ALCdevice *device)
     return AL_TRUE;
 }
 
-void PshifterState::update(const ALCcontext* UNUSED(context), const ALeffectslot *slot, const EffectProps *props, const EffectTarget target)
+void PshifterState::update(const ALCcontext *context, const ALeffectslot *slot, const EffectProps *props, const EffectTarget target)
 {
     const float pitch{std::pow(2.0f,
         static_cast<ALfloat>(props->Pshifter.CoarseTune*100 + props->Pshifter.FineTune) / 1200.0f
@@ -189,6 +436,20 @@ void PshifterState::update(const ALCcontext* UNUSED(context), const ALeffectslot
     mPitchShiftI = fastf2i(pitch*FRACTIONONE);
     mPitchShift  = mPitchShiftI * (1.0f/FRACTIONONE);
 
+    /* Slots at default quality drop to low quality while the context's
+     * effects are over budget.
+     */
+    const ALenum quality{(slot->Params.Quality != AL_QUALITY_DEFAULT_SOFT) ? slot->Params.Quality :
+        context->EffectsDowngraded.load(std::memory_order_relaxed) ? AL_QUALITY_LOW_SOFT :
+        PshifterQuality};
+    const bool lowQuality{quality == AL_QUALITY_LOW_SOFT};
+    if(lowQuality != mLowQuality)
+    {
+        /* The tiers use different frame steps, so start over when switching. */
+        mLowQuality = lowQuality;
+        clearFrames();
+    }
+
     ALfloat coeffs[MAX_AMBI_CHANNELS];
     CalcAngleCoeffs(0.0f, 0.0f, 0.0f, coeffs);
 
@@ -203,9 +464,15 @@ void PshifterState::process(ALsizei samplesToDo, const ALfloat (*RESTRICT sample
      * http://blogs.zynaptiq.com/bernsee/pitch-shifting-using-the-ft/
      */
 
-    static constexpr ALdouble expected{al::MathDefs<double>::Tau() / OVERSAMP};
-    const ALdouble freq_per_bin{mFreqPerBin};
+    /* The squared Hann windows of the four high quality frames overlap to
+     * 1.5, while the squared sine windows of the two low quality frames
+     * overlap to 1, so the low quality output is scaled up to match.
+     */
+    static constexpr ALdouble highscale{STFT_HALF_SIZE * HIGH_OVERSAMP};
+    static constexpr ALfloat lowscale{STFT_HALF_SIZE * HIGH_OVERSAMP / 1.5f};
+
     ALfloat *RESTRICT bufferOut{mBufferOut};
+    const ALsizei latency{mLatency};
     ALsizei count{mCount};
 
     for(ALsizei i{0};i < samplesToDo;)
@@ -213,110 +480,24 @@ void PshifterState::process(ALsizei samplesToDo, const ALfloat (*RESTRICT sample
         do {
             /* Fill FIFO buffer with samples data */
             mInFIFO[count] = samplesIn[0][i];
-            bufferOut[i] = mOutFIFO[count - FIFO_LATENCY];
+            bufferOut[i] = mOutFIFO[count - latency];
 
             count++;
         } while(++i < samplesToDo && count < STFT_SIZE);
 
         /* Check whether FIFO buffer is filled */
         if(count < STFT_SIZE) break;
-        count = FIFO_LATENCY;
+        count = latency;
 
-        /* Real signal windowing and store in FFTbuffer */
-        for(ALsizei k{0};k < STFT_SIZE;k++)
-        {
-            mFFTbuffer[k].real(mInFIFO[k] * HannWindow[k]);
-            mFFTbuffer[k].imag(0.0);
-        }
+        if(mLowQuality)
+            mLow.processFrame<LOW_OVERSAMP>(StftPlanF, SineWindow, lowscale, mInFIFO,
+                mOutFIFO, mFreqPerBin, mPitchShiftI, mPitchShift);
+        else
+            mHigh.processFrame<HIGH_OVERSAMP>(StftPlan, HannWindow, highscale, mInFIFO,
+                mOutFIFO, mFreqPerBin, mPitchShiftI, mPitchShift);
 
-        /* ANALYSIS */
-        /* Apply FFT to FFTbuffer data */
-        complex_fft(mFFTbuffer, STFT_SIZE, -1.0);
-
-        /* Analyze the obtained data. Since the real FFT is symmetric, only
-         * STFT_HALF_SIZE+1 samples are needed.
-         */
-        for(ALsizei k{0};k < STFT_HALF_SIZE+1;k++)
-        {
-            /* Compute amplitude and phase */
-            ALphasor component{rect2polar(mFFTbuffer[k])};
-
-            /* Compute phase difference and subtract expected phase difference */
-            double tmp{(component.Phase - mLastPhase[k]) - k*expected};
-
-            /* Map delta phase into +/- Pi interval */
-            int qpd{double2int(tmp / al::MathDefs<double>::Pi())};
-            tmp -= al::MathDefs<double>::Pi() * (qpd + (qpd%2));
-
-            /* Get deviation from bin frequency from the +/- Pi interval */
-            tmp /= expected;
-
-            /* Compute the k-th partials' true frequency, twice the amplitude
-             * for maintain the gain (because half of bins are used) and store
-             * amplitude and true frequency in analysis buffer.
-             */
-            mAnalysis_buffer[k].Amplitude = 2.0 * component.Amplitude;
-            mAnalysis_buffer[k].Frequency = (k + tmp) * freq_per_bin;
-
-            /* Store actual phase[k] for the calculations in the next frame*/
-            mLastPhase[k] = component.Phase;
-        }
-
-        /* PROCESSING */
-        /* pitch shifting */
-        for(ALsizei k{0};k < STFT_HALF_SIZE+1;k++)
-        {
-            mSyntesis_buffer[k].Amplitude = 0.0;
-            mSyntesis_buffer[k].Frequency = 0.0;
-        }
-
-        for(ALsizei k{0};k < STFT_HALF_SIZE+1;k++)
-        {
-            ALsizei j{(k*mPitchShiftI) >> FRACTIONBITS};
-            if(j >= STFT_HALF_SIZE+1) break;
-
-            mSyntesis_buffer[j].Amplitude += mAnalysis_buffer[k].Amplitude;
-            mSyntesis_buffer[j].Frequency  = mAnalysis_buffer[k].Frequency * mPitchShift;
-        }
-
-        /* SYNTHESIS */
-        /* Synthesis the processing data */
-        for(ALsizei k{0};k < STFT_HALF_SIZE+1;k++)
-        {
-            ALphasor component;
-            ALdouble tmp;
-
-            /* Compute bin deviation from scaled freq */
-            tmp = mSyntesis_buffer[k].Frequency/freq_per_bin - k;
-
-            /* Calculate actual delta phase and accumulate it to get bin phase */
-            mSumPhase[k] += (k + tmp) * expected;
-
-            component.Amplitude = mSyntesis_buffer[k].Amplitude;
-            component.Phase     = mSumPhase[k];
-
-            /* Compute phasor component to cartesian complex number and storage it into FFTbuffer*/
-            mFFTbuffer[k] = polar2rect(component);
-        }
-        /* zero negative frequencies for recontruct a real signal */
-        for(ALsizei k{STFT_HALF_SIZE+1};k < STFT_SIZE;k++)
-            mFFTbuffer[k] = complex_d{};
-
-        /* Apply iFFT to buffer data */
-        complex_fft(mFFTbuffer, STFT_SIZE, 1.0);
-
-        /* Windowing and add to output */
-        for(ALsizei k{0};k < STFT_SIZE;k++)
-            mOutputAccum[k] += HannWindow[k] * mFFTbuffer[k].real() /
-                               (0.5 * STFT_HALF_SIZE * OVERSAMP);
-
-        /* Shift accumulator, input & output FIFO */
-        ALsizei j, k;
-        for(k = 0;k < STFT_STEP;k++) mOutFIFO[k] = static_cast<ALfloat>(mOutputAccum[k]);
-        for(j = 0;k < STFT_SIZE;k++,j++) mOutputAccum[j] = mOutputAccum[k];
-        for(;j < STFT_SIZE;j++) mOutputAccum[j] = 0.0;
-        for(k = 0;k < FIFO_LATENCY;k++)
-            mInFIFO[k] = mInFIFO[k+STFT_STEP];
+        /* Shift input FIFO */
+        std::copy_n(mInFIFO+mStep, latency, mInFIFO);
     }
     mCount = count;
 
@@ -384,6 +565,7 @@ struct PshifterStateFactory final : public EffectStateFactory {
     EffectState *create() override;
     EffectProps getDefaultProps() const noexcept override;
     const EffectVtable *getEffectVtable() const noexcept override { return &Pshifter_vtable; }
+    bool monoInput() const noexcept override { return true; }
 };
 
 EffectState *PshifterStateFactory::create()
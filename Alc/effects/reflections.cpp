@@ -0,0 +1,372 @@
+/**
+ * OpenAL cross platform audio library
+ * Copyright (C) 2019 by authors.
+ * This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Library General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ *  License along with this library; if not, write to the
+ *  Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ * Or go to http://www.gnu.org/copyleft/lgpl.html
+ */
+
+#include "config.h"
+
+#include <cmath>
+#include <cstdlib>
+
+#include <array>
+#include <algorithm>
+
+#include "alMain.h"
+#include "alcontext.h"
+#include "alAuxEffectSlot.h"
+#include "alEffect.h"
+#include "alListener.h"
+#include "alu.h"
+#include "vector.h"
+
+
+namespace {
+
+/* An early reflections only reverb, for small spaces that don't need the full
+ * reverb's late reverb network. The input feeds a single delay line, which is
+ * read by a fixed pattern of taps, each with its own gain, direction, and
+ * one-pole damping filter. The taps are encoded to first-order B-Format and
+ * panned to the output like the reverb's lines.
+ *
+ * It takes the EAX reverb's properties. The reflection delay places the first
+ * tap, and the density sets the room size the taps spread over, as with the
+ * reverb's early taps. The taps decay at the decay time's rate, with the HF
+ * damping given by the HF gain, decay HF ratio, and the air absorption over
+ * each tap's path. The reflection gain and pan apply as usual, and the
+ * diffusion widens each tap. The late reverb properties are ignored.
+ */
+
+/* The number of taps. Kept a multiple of 4 so the tap filters run in full
+ * vector lanes.
+ */
+constexpr ALsizei NUM_TAPS{8};
+
+/* The number of B-Format channels the taps are encoded to. */
+constexpr ALsizei NUM_BFORMAT{4};
+
+/* The tap offsets after the first reflection, in seconds for the smallest
+ * room size. These are scaled by the density multiplier.
+ */
+constexpr std::array<ALfloat,NUM_TAPS> TAP_LENGTHS{{
+    0.0000000e+0f, 1.0720356e-4f, 1.6182800e-4f, 2.3417000e-4f,
+    3.1072000e-4f, 4.2531060e-4f, 5.3177900e-4f, 6.7171600e-4f
+}};
+
+/* The direction each tap comes from, in OpenAL coordinates: the front, side,
+ * floor, ceiling, and back walls, then two second-order reflections off the
+ * front corners.
+ */
+constexpr ALfloat TAP_DIRECTIONS[NUM_TAPS][3]{
+    {  0.000000000f,  0.000000000f, -1.000000000f },
+    { -1.000000000f,  0.000000000f,  0.000000000f },
+    {  1.000000000f,  0.000000000f,  0.000000000f },
+    {  0.000000000f, -0.707106781f, -0.707106781f },
+    {  0.000000000f,  0.707106781f, -0.707106781f },
+    {  0.000000000f,  0.000000000f,  1.000000000f },
+    { -0.707106781f,  0.000000000f, -0.707106781f },
+    {  0.707106781f,  0.000000000f, -0.707106781f }
+};
+
+/* The size-to-density conversion, as with the reverb. */
+constexpr ALfloat DENSITY_SCALE{125000.0f};
+
+/* The most samples processed at once. */
+constexpr ALsizei MAX_BLOCK{128};
+
+
+inline ALfloat CalcSizeMult(const ALfloat density)
+{ return maxf(5.0f, std::cbrt(density*DENSITY_SCALE)); }
+
+inline ALfloat CalcDecayCoeff(const ALfloat length, const ALfloat decayTime)
+{ return std::pow(REVERB_DECAY_GAIN, length/decayTime); }
+
+/* Calculates the coefficient for a one-pole low-pass filter (y += a*(x - y))
+ * to have the given gain at the reference frequency, whose normalized cosine
+ * is given.
+ */
+ALfloat CalcOnePoleCoeff(ALfloat gain, const ALfloat cw)
+{
+    if(!(gain < 1.0f))
+        return 1.0f;
+    gain = maxf(gain, 0.001f);
+
+    const ALfloat g2{gain * gain};
+    const ALfloat b{(1.0f - g2*cw) / (1.0f - g2)};
+    return 1.0f - (b - std::sqrt(b*b - 1.0f));
+}
+
+/* Copies count samples of the delay line from pos, as up to two contiguous
+ * runs around the end of the buffer.
+ */
+inline void ReadDelay(ALfloat *RESTRICT dst, const ALfloat *RESTRICT delaybuf, const ALsizei mask,
+    ALsizei pos, const ALsizei count)
+{
+    pos &= mask;
+    const ALsizei run{mini(count, mask+1 - pos)};
+    std::copy_n(delaybuf+pos, run, dst);
+    std::copy_n(delaybuf, count-run, dst+run);
+}
+
+/* Writes count samples of input to the delay line at pos, likewise. */
+inline void WriteDelay(ALfloat *RESTRICT delaybuf, const ALsizei mask, ALsizei pos,
+    const ALfloat *RESTRICT input, const ALsizei count)
+{
+    pos &= mask;
+    const ALsizei run{mini(count, mask+1 - pos)};
+    std::copy_n(input, run, delaybuf+pos);
+    std::copy_n(input+run, count-run, delaybuf);
+}
+
+
+struct ReflectionsState final : public EffectState {
+    al::vector<ALfloat,16> mSampleBuffer;
+    ALsizei mOffset{0};
+
+    /* The delay of each tap, and its damping filter's coefficient and last
+     * output.
+     */
+    ALsizei mDelay[NUM_TAPS]{};
+    ALfloat mDampCoeff[NUM_TAPS]{};
+    ALfloat mDampState[NUM_TAPS]{};
+
+    /* The B-Format encoding of each tap, including its decay. After an
+     * update, the next block fades from the current encoding to the target.
+     */
+    ALfloat mCurrentEncode[NUM_TAPS][NUM_BFORMAT]{};
+    ALfloat mTargetEncode[NUM_TAPS][NUM_BFORMAT]{};
+    bool mEncodeFade{false};
+
+    /* The panning gains for each B-Format channel. */
+    struct {
+        ALfloat Current[MAX_OUTPUT_CHANNELS]{};
+        ALfloat Target[MAX_OUTPUT_CHANNELS]{};
+    } mGains[NUM_BFORMAT];
+
+    alignas(16) ALfloat mTaps[NUM_TAPS][MAX_BLOCK]{};
+    alignas(16) ALfloat mBFormat[NUM_BFORMAT][MAX_BLOCK]{};
+
+
+    ALboolean deviceUpdate(const ALCdevice *device) override;
+    void update(const ALCcontext *context, const ALeffectslot *slot, const EffectProps *props, const EffectTarget target) override;
+    void process(ALsizei samplesToDo, const ALfloat (*RESTRICT samplesIn)[BUFFERSIZE], const ALsizei numInput, ALfloat (*RESTRICT samplesOut)[BUFFERSIZE], const ALsizei numOutput) override;
+
+    DEF_NEWDEL(ReflectionsState)
+};
+
+ALboolean ReflectionsState::deviceUpdate(const ALCdevice *device)
+{
+    const auto frequency = static_cast<ALfloat>(device->MixFrequency);
+
+    /* The delay line fits the longest reflection delay and room size, with a
+     * block written ahead of the reads.
+     */
+    const ALfloat length{AL_EAXREVERB_MAX_REFLECTIONS_DELAY +
+        TAP_LENGTHS.back()*CalcSizeMult(AL_EAXREVERB_MAX_DENSITY)};
+    const auto maxlen = NextPowerOf2(static_cast<ALuint>(float2int(std::ceil(length*frequency))) +
+        MAX_BLOCK);
+    if(maxlen != mSampleBuffer.size())
+    {
+        mSampleBuffer.resize(maxlen);
+        mSampleBuffer.shrink_to_fit();
+    }
+    std::fill(mSampleBuffer.begin(), mSampleBuffer.end(), 0.0f);
+    mOffset = 0;
+
+    std::fill(std::begin(mDampState), std::end(mDampState), 0.0f);
+    for(auto &encode : mCurrentEncode)
+        std::fill(std::begin(encode), std::end(encode), 0.0f);
+    for(auto &encode : mTargetEncode)
+        std::fill(std::begin(encode), std::end(encode), 0.0f);
+    mEncodeFade = false;
+    for(auto &gains : mGains)
+    {
+        std::fill(std::begin(gains.Current), std::end(gains.Current), 0.0f);
+        std::fill(std::begin(gains.Target), std::end(gains.Target), 0.0f);
+    }
+
+    return AL_TRUE;
+}
+
+void ReflectionsState::update(const ALCcontext *context, const ALeffectslot *slot, const EffectProps *props, const EffectTarget target)
+{
+    const ALCdevice *device{context->Device};
+    const auto frequency = static_cast<ALfloat>(device->MixFrequency);
+    const ALfloat speedOfSound{context->Listener.Params.ReverbSpeedOfSound};
+
+    const ALfloat multiplier{CalcSizeMult(props->Reverb.Density)};
+    const ALfloat hfDecayTime{props->Reverb.DecayTime * props->Reverb.DecayHFRatio};
+    const ALfloat hfnorm{minf(props->Reverb.HFReference / frequency, 0.49f)};
+    const ALfloat cw{std::cos(al::MathDefs<float>::Tau() * hfnorm)};
+
+    /* The reflection pan focuses the taps toward its direction, using its
+     * magnitude (up to 1) as the strength. Like the reverb, the pan vector is
+     * left-handed, so Z is negated for OpenAL coordinates.
+     */
+    const ALfloat *pan{props->Reverb.ReflectionsPan};
+    ALfloat panmag{std::sqrt(pan[0]*pan[0] + pan[1]*pan[1] + pan[2]*pan[2])};
+    ALfloat pandir[3]{0.0f, 0.0f, 0.0f};
+    if(panmag > 0.0f)
+    {
+        pandir[0] = pan[0] / panmag;
+        pandir[1] = pan[1] / panmag;
+        pandir[2] = -pan[2] / panmag;
+        panmag = minf(panmag, 1.0f);
+    }
+    const ALfloat spread{props->Reverb.Diffusion * al::MathDefs<float>::Pi()};
+
+    /* Keep the taps' combined energy the same as the input's. */
+    const ALfloat tapscale{1.0f / std::sqrt(static_cast<ALfloat>(NUM_TAPS))};
+
+    bool changed{false};
+    for(ALsizei t{0};t < NUM_TAPS;t++)
+    {
+        const ALfloat length{TAP_LENGTHS[t] * multiplier};
+        const ALfloat delay{props->Reverb.ReflectionsDelay + length};
+        mDelay[t] = float2int(delay * frequency);
+
+        /* The taps decay from the first, with HF decaying faster by the decay
+         * HF ratio, and air absorption over the whole path.
+         */
+        const ALfloat decay{CalcDecayCoeff(length, props->Reverb.DecayTime)};
+        const ALfloat hfgain{props->Reverb.GainHF * CalcDecayCoeff(length, hfDecayTime) / decay *
+            std::pow(props->Reverb.AirAbsorptionGainHF, delay*speedOfSound)};
+        mDampCoeff[t] = CalcOnePoleCoeff(hfgain, cw);
+
+        ALfloat dir[3];
+        for(size_t i{0};i < 3;i++)
+            dir[i] = TAP_DIRECTIONS[t][i]*(1.0f-panmag) + pandir[i]*panmag;
+        const ALfloat dirlen{std::sqrt(dir[0]*dir[0] + dir[1]*dir[1] + dir[2]*dir[2])};
+        if(dirlen > 0.0f)
+        {
+            for(ALfloat &d : dir)
+                d /= dirlen;
+        }
+        else
+            std::copy_n(pandir, 3, dir);
+
+        ALfloat coeffs[MAX_AMBI_CHANNELS];
+        CalcDirectionCoeffs(dir, spread, coeffs);
+        for(ALsizei c{0};c < NUM_BFORMAT;c++)
+        {
+            const ALfloat encode{coeffs[c] * decay * tapscale};
+            changed |= (encode != mTargetEncode[t][c]);
+            mTargetEncode[t][c] = encode;
+        }
+    }
+    mEncodeFade |= changed;
+    mTailSamples = static_cast<ALuint>(*std::max_element(std::begin(mDelay), std::end(mDelay)));
+
+    const ALfloat gain{props->Reverb.Gain * props->Reverb.ReflectionsGain * slot->Params.Gain *
+        ReverbBoost};
+    mOutBuffer = target.Main->Buffer;
+    mOutChannels = target.Main->NumChannels;
+    for(ALsizei c{0};c < NUM_BFORMAT;c++)
+    {
+        const auto coeffs = GetAmbiIdentityRow(static_cast<size_t>(c));
+        ComputePanGains(target.Main, coeffs.data(), gain, mGains[c].Target);
+    }
+}
+
+void ReflectionsState::process(ALsizei samplesToDo, const ALfloat (*RESTRICT samplesIn)[BUFFERSIZE], const ALsizei /*numInput*/, ALfloat (*RESTRICT samplesOut)[BUFFERSIZE], const ALsizei numOutput)
+{
+    const auto mask = static_cast<ALsizei>(mSampleBuffer.size()-1);
+    ALfloat *RESTRICT delaybuf{mSampleBuffer.data()};
+    ALsizei offset{mOffset};
+
+    for(ALsizei base{0};base < samplesToDo;)
+    {
+        const ALsizei td{mini(MAX_BLOCK, samplesToDo-base)};
+
+        /* Feed the delay line first, so taps shorter than the block read the
+         * new input.
+         */
+        WriteDelay(delaybuf, mask, offset, &samplesIn[0][base], td);
+        for(ALsizei t{0};t < NUM_TAPS;t++)
+            ReadDelay(mTaps[t], delaybuf, mask, offset - mDelay[t], td);
+        offset += td;
+
+        /* Damp the taps together, so their independent filters overlap. */
+        ALfloat z[NUM_TAPS];
+        std::copy(std::begin(mDampState), std::end(mDampState), std::begin(z));
+        for(ALsizei i{0};i < td;i++)
+        {
+            for(ALsizei t{0};t < NUM_TAPS;t++)
+            {
+                z[t] += mDampCoeff[t] * (mTaps[t][i] - z[t]);
+                mTaps[t][i] = z[t];
+            }
+        }
+        std::copy(std::begin(z), std::end(z), std::begin(mDampState));
+
+        /* Encode the taps to B-Format, fading the encoding after an update. */
+        for(ALsizei c{0};c < NUM_BFORMAT;c++)
+        {
+            ALfloat *RESTRICT dst{mBFormat[c]};
+            std::fill_n(dst, td, 0.0f);
+            for(ALsizei t{0};t < NUM_TAPS;t++)
+            {
+                const ALfloat *RESTRICT src{mTaps[t]};
+                const ALfloat target{mTargetEncode[t][c]};
+                if(mEncodeFade)
+                {
+                    const ALfloat current{mCurrentEncode[t][c]};
+                    const ALfloat step{(target - current) / static_cast<ALfloat>(td)};
+                    for(ALsizei i{0};i < td;i++)
+                        dst[i] += src[i] * (current + step*static_cast<ALfloat>(i));
+                }
+                else
+                {
+                    for(ALsizei i{0};i < td;i++)
+                        dst[i] += src[i] * target;
+                }
+            }
+        }
+        if(mEncodeFade)
+        {
+            std::copy(&mTargetEncode[0][0], &mTargetEncode[0][0] + NUM_TAPS*NUM_BFORMAT,
+                &mCurrentEncode[0][0]);
+            mEncodeFade = false;
+        }
+
+        for(ALsizei c{0};c < NUM_BFORMAT;c++)
+            MixSamples(mBFormat[c], numOutput, samplesOut, mGains[c].Current, mGains[c].Target,
+                samplesToDo-base, base, td);
+
+        base += td;
+    }
+    mOffset = offset & 0x3fffffff;
+}
+
+
+struct ReflectionsStateFactory final : public EffectStateFactory {
+    EffectState *create() override { return new ReflectionsState{}; }
+    /* The properties are the EAX reverb's. */
+    EffectProps getDefaultProps() const noexcept override
+    { return ReverbStateFactory_getFactory()->getDefaultProps(); }
+    const EffectVtable *getEffectVtable() const noexcept override
+    { return ReverbStateFactory_getFactory()->getEffectVtable(); }
+    bool monoInput() const noexcept override { return true; }
+};
+
+} // namespace
+
+EffectStateFactory *ReflectionsStateFactory_getFactory()
+{
+    static ReflectionsStateFactory ReflectionsFactory{};
+    return &ReflectionsFactory;
+}
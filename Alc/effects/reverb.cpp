@@ -25,6 +25,7 @@
 #include <cmath>
 
 #include <array>
+#include <atomic>
 #include <numeric>
 #include <algorithm>
 #include <functional>
@@ -35,6 +36,7 @@
 #include "alAuxEffectSlot.h"
 #include "alListener.h"
 #include "alError.h"
+#include "atomic.h"
 #include "bformatdec.h"
 #include "filters/biquad.h"
 #include "vector.h"
@@ -45,6 +47,21 @@
  */
 ALfloat ReverbBoost = 1.0f;
 
+/* This is a user config option for the reverb quality used by effect slots
+ * that don't specify one.
+ */
+ALenum ReverbQuality = AL_QUALITY_HIGH_SOFT;
+
+/* This is a user config option for processing new reverb states at half the
+ * mixing rate.
+ */
+bool ReverbHalfRate{false};
+
+/* This is a user config option for sizing delay lines for the properties in
+ * use, rather than the largest allowed.
+ */
+bool ReverbSizedLines{false};
+
 namespace {
 
 using namespace std::placeholders;
@@ -56,6 +73,12 @@ using namespace std::placeholders;
  */
 constexpr int FADE_SAMPLES{128};
 
+/* The number of samples used to interpolate gain coefficient changes, when the
+ * delay line taps stay the same. This spans multiple updates, so parameters
+ * that change with each update move smoothly.
+ */
+constexpr int INTERP_SAMPLES{1024};
+
 /* The number of spatialized lines or channels to process. Four channels allows
  * for a 3D A-Format response. NOTE: This can't be changed without taking care
  * of the conversion matrices, and a few places where the length arrays are
@@ -89,6 +112,13 @@ alignas(16) constexpr ALfloat A2B[NUM_LINES][NUM_LINES]{
 
 constexpr ALfloat FadeStep{1.0f / FADE_SAMPLES};
 
+/* The low quality mode only processes two lines, using the storage of lines 1
+ * and 2. These are spatially opposite in the A-Format arrangement, and their
+ * lengths aren't harmonically related.
+ */
+constexpr ALsizei LOW_LINE0{1};
+constexpr ALsizei LOW_LINE1{2};
+
 /* The all-pass and delay lines have a variable length dependent on the
  * effect's density parameter, which helps alter the perceived environment
  * size. The size-to-density conversion is a cubed scale:
@@ -240,6 +270,38 @@ struct DelayLineI {
     }
 };
 
+/* The property values that determine the delay line lengths. Lines sized for
+ * them fit any properties with no greater values.
+ */
+struct LineSizes {
+    ALfloat Density;
+    ALfloat ReflectionsDelay;
+    ALfloat LateReverbDelay;
+};
+
+constexpr LineSizes MaxLineSizes{AL_EAXREVERB_MAX_DENSITY, AL_EAXREVERB_MAX_REFLECTIONS_DELAY,
+    AL_EAXREVERB_MAX_LATE_REVERB_DELAY};
+
+/* A set of delay lines allocated on the application thread, for update to
+ * swap in. Once swapped, it holds the old sample buffer until it's freed back
+ * on the application thread.
+ */
+struct ReverbLineSet {
+    std::atomic<ReverbLineSet*> next{nullptr};
+
+    LineSizes Sizes{};
+    al::vector<ALfloat,16> Samples;
+
+    DelayLineI Delay;
+    DelayLineI EarlyVecAp;
+    DelayLineI Early;
+    DelayLineI LateVecAp;
+    DelayLineI Late;
+    ALsizei LateFeedTap{0};
+
+    DEF_NEWDEL(ReverbLineSet)
+};
+
 struct VecAllpass {
     DelayLineI Delay;
     ALfloat Coeff{0.0f};
@@ -249,6 +311,8 @@ struct VecAllpass {
         const ALfloat xCoeff, const ALfloat yCoeff, ALfloat fade, const ALsizei todo);
     void processUnfaded(ALfloat (*RESTRICT samples)[BUFFERSIZE], ALsizei offset,
         const ALfloat xCoeff, const ALfloat yCoeff, const ALsizei todo);
+    void processLow(ALfloat (*RESTRICT samples)[BUFFERSIZE], ALsizei offset,
+        const ALfloat xCoeff, const ALfloat yCoeff, const ALsizei todo);
 };
 
 struct T60Filter {
@@ -321,18 +385,19 @@ struct ReverbState final : public EffectState {
      */
     al::vector<ALfloat,16> mSampleBuffer;
 
-    struct {
-        /* Calculated parameters which indicate if cross-fading is needed after
-         * an update.
-         */
-        ALfloat Density{AL_EAXREVERB_DEFAULT_DENSITY};
-        ALfloat Diffusion{AL_EAXREVERB_DEFAULT_DIFFUSION};
-        ALfloat DecayTime{AL_EAXREVERB_DEFAULT_DECAY_TIME};
-        ALfloat HFDecayTime{AL_EAXREVERB_DEFAULT_DECAY_HFRATIO * AL_EAXREVERB_DEFAULT_DECAY_TIME};
-        ALfloat LFDecayTime{AL_EAXREVERB_DEFAULT_DECAY_LFRATIO * AL_EAXREVERB_DEFAULT_DECAY_TIME};
-        ALfloat HFReference{AL_EAXREVERB_DEFAULT_HFREFERENCE};
-        ALfloat LFReference{AL_EAXREVERB_DEFAULT_LFREFERENCE};
-    } mParams;
+    /* The sizes the delay lines fit, which limit the properties used. */
+    LineSizes mLineSizes{MaxLineSizes};
+
+    /* With sized lines, the sizes last allocated for (the current or pending
+     * lines) and the rate they're for, on the application thread. Lines grown
+     * for new properties wait in mPendingLines for update, which swaps them in
+     * and leaves the old buffer in mRetiredLines to be freed.
+     */
+    LineSizes mPreparedSizes{AL_EAXREVERB_DEFAULT_DENSITY, AL_EAXREVERB_DEFAULT_REFLECTIONS_DELAY,
+        AL_EAXREVERB_DEFAULT_LATE_REVERB_DELAY};
+    ALfloat mLineFrequency{0.0f};
+    std::atomic<ReverbLineSet*> mPendingLines{nullptr};
+    std::atomic<ReverbLineSet*> mRetiredLines{nullptr};
 
     /* Master effect filters */
     struct {
@@ -355,6 +420,13 @@ struct ReverbState final : public EffectState {
     ALfloat mMixX{0.0f};
     ALfloat mMixY{0.0f};
 
+    /* Whether the cheaper two-line network is used, and its scattering
+     * coefficients.
+     */
+    bool mLowQuality{false};
+    ALfloat mLowMixX{0.0f};
+    ALfloat mLowMixY{0.0f};
+
     EarlyReflections mEarly;
 
     LateReverb mLate;
@@ -362,6 +434,11 @@ struct ReverbState final : public EffectState {
     /* Indicates the cross-fade point for delay line reads [0,FADE_SAMPLES]. */
     ALsizei mFadeCount{0};
 
+    /* The number of samples left to interpolate the gain coefficients over,
+     * while not cross-fading.
+     */
+    ALsizei mInterpCount{0};
+
     /* Maximum number of samples to process at once. */
     ALsizei mMaxUpdate[2]{BUFFERSIZE, BUFFERSIZE};
 
@@ -437,13 +514,40 @@ struct ReverbState final : public EffectState {
         }
     }
 
-    bool allocLines(const ALfloat frequency);
+    void MixOutLow(const ALsizei numOutput, ALfloat (*samplesOut)[BUFFERSIZE],
+        const ALsizei todo)
+    {
+        ASSUME(todo > 0);
+
+        /* The low quality lines are mixed directly, without conversion. */
+        for(ALsizei c : {LOW_LINE0, LOW_LINE1})
+            MixSamples(mEarlyBuffer[c], numOutput, samplesOut, mEarly.CurrentGain[c],
+                mEarly.PanGain[c], todo, 0, todo);
+        for(ALsizei c : {LOW_LINE0, LOW_LINE1})
+            MixSamples(mLateBuffer[c], numOutput, samplesOut, mLate.CurrentGain[c],
+                mLate.PanGain[c], todo, 0, todo);
+    }
+
+    bool allocLines(const LineSizes &sizes, const ALfloat frequency);
+    void clearLines();
+    void swapLines(ReverbLineSet *lines);
+    void finishFade();
+    bool tapsChanged() const noexcept;
+    bool gainsChanged() const noexcept;
+    void stepGains(const ALfloat interp);
+    void processLow(const ALsizei samplesToDo, const ALfloat *RESTRICT samplesIn,
+        ALfloat (*RESTRICT samplesOut)[BUFFERSIZE], const ALsizei numOutput);
 
     void updateDelayLine(const ALfloat earlyDelay, const ALfloat lateDelay, const ALfloat density,
         const ALfloat decayTime, const ALfloat frequency);
     void update3DPanning(const ALfloat *ReflectionsPan, const ALfloat *LateReverbPan,
         const ALfloat earlyGain, const ALfloat lateGain, const EffectTarget &target);
+    void updateLowPanning(const ALfloat earlyGain, const ALfloat lateGain,
+        const EffectTarget &target);
 
+    ~ReverbState() override;
+
+    void prepare(const EffectProps *props) override;
     ALboolean deviceUpdate(const ALCdevice *device) override;
     void update(const ALCcontext *context, const ALeffectslot *slot, const EffectProps *props, const EffectTarget target) override;
     void process(ALsizei samplesToDo, const ALfloat (*RESTRICT samplesIn)[BUFFERSIZE], const ALsizei numInput, ALfloat (*RESTRICT samplesOut)[BUFFERSIZE], const ALsizei numOutput) override;
@@ -489,49 +593,86 @@ ALuint CalcLineLength(const ALfloat length, const ptrdiff_t offset, const ALfloa
     return samples;
 }
 
-/* Calculates the delay line metrics and allocates the shared sample buffer
- * for all lines given the sample rate (frequency).  If an allocation failure
- * occurs, it returns AL_FALSE.
+/* Calculates the delay line metrics for the given sizes and sample rate
+ * (frequency), returning the number of sample frames for all lines.
  */
-bool ReverbState::allocLines(const ALfloat frequency)
+ALuint CalcLineMetrics(const LineSizes &sizes, const ALfloat frequency, DelayLineI *mainDelay,
+    DelayLineI *earlyVecAp, DelayLineI *earlyDelay, DelayLineI *lateVecAp, DelayLineI *lateDelay)
 {
-    /* All delay line lengths are calculated to accomodate the full range of
-     * lengths given their respective paramters.
-     */
     ALuint totalSamples{0u};
 
-    /* Multiplier for the maximum density value, i.e. density=1, which is
-     * actually the least density...
+    /* Multiplier for the density value. The maximum density, i.e. density=1,
+     * is actually the least density...
      */
-    ALfloat multiplier{CalcDelayLengthMult(AL_EAXREVERB_MAX_DENSITY)};
+    const ALfloat multiplier{CalcDelayLengthMult(sizes.Density)};
 
-    /* The main delay length includes the maximum early reflection delay, the
-     * largest early tap width, the maximum late reverb delay, and the
-     * largest late tap width.  Finally, it must also be extended by the
-     * update size (BUFFERSIZE) for block processing.
+    /* The main delay length includes the early reflection delay, the largest
+     * early tap width, the late reverb delay, and the largest late tap width.
+     * Finally, it must also be extended by the update size (BUFFERSIZE) for
+     * block processing.
      */
-    ALfloat length{AL_EAXREVERB_MAX_REFLECTIONS_DELAY + EARLY_TAP_LENGTHS.back()*multiplier +
-        AL_EAXREVERB_MAX_LATE_REVERB_DELAY +
+    ALfloat length{sizes.ReflectionsDelay + EARLY_TAP_LENGTHS.back()*multiplier +
+        sizes.LateReverbDelay +
         (LATE_LINE_LENGTHS.back() - LATE_LINE_LENGTHS.front())*0.25f*multiplier};
-    totalSamples += CalcLineLength(length, totalSamples, frequency, BUFFERSIZE, &mDelay);
+    totalSamples += CalcLineLength(length, totalSamples, frequency, BUFFERSIZE, mainDelay);
 
     /* The early vector all-pass line. */
     length = EARLY_ALLPASS_LENGTHS.back() * multiplier;
-    totalSamples += CalcLineLength(length, totalSamples, frequency, 0, &mEarly.VecAp.Delay);
+    totalSamples += CalcLineLength(length, totalSamples, frequency, 0, earlyVecAp);
 
     /* The early reflection line. */
     length = EARLY_LINE_LENGTHS.back() * multiplier;
-    totalSamples += CalcLineLength(length, totalSamples, frequency, 0, &mEarly.Delay);
+    totalSamples += CalcLineLength(length, totalSamples, frequency, 0, earlyDelay);
 
     /* The late vector all-pass line. */
     length = LATE_ALLPASS_LENGTHS.back() * multiplier;
-    totalSamples += CalcLineLength(length, totalSamples, frequency, 0, &mLate.VecAp.Delay);
+    totalSamples += CalcLineLength(length, totalSamples, frequency, 0, lateVecAp);
 
-    /* The late delay lines are calculated from the largest maximum density
-     * line length.
-     */
+    /* The late delay lines are calculated from the largest line length. */
     length = LATE_LINE_LENGTHS.back() * multiplier;
-    totalSamples += CalcLineLength(length, totalSamples, frequency, 0, &mLate.Delay);
+    totalSamples += CalcLineLength(length, totalSamples, frequency, 0, lateDelay);
+
+    return totalSamples;
+}
+
+/* The late feed tap is set a fixed position past the latest early reflection
+ * tap the lines fit.
+ */
+ALsizei CalcLateFeedTap(const LineSizes &sizes, const ALfloat frequency)
+{
+    const ALfloat multiplier{CalcDelayLengthMult(sizes.Density)};
+    return float2int((sizes.ReflectionsDelay + EARLY_TAP_LENGTHS.back()*multiplier) * frequency);
+}
+
+/* Copies the history of one delay line to another, from first to last samples
+ * before the offset, moving it shift samples further back.
+ */
+void CopyLineHistory(const DelayLineI &src, const DelayLineI &dst, const ALsizei offset,
+    const ALsizei first, const ALsizei last, const ALsizei shift)
+{
+    for(ALsizei i{first};i <= last;i++)
+        std::copy_n(src.Line[(offset-i) & src.Mask], NUM_LINES,
+            dst.Line[(offset-i-shift) & dst.Mask]);
+}
+
+void FreeLineSets(ReverbLineSet *lines)
+{
+    while(lines)
+    {
+        ReverbLineSet *next{lines->next.load(std::memory_order_relaxed)};
+        delete lines;
+        lines = next;
+    }
+}
+
+/* Calculates the delay line metrics and allocates the shared sample buffer
+ * for all lines given the sizes and sample rate (frequency).  If an
+ * allocation failure occurs, it returns AL_FALSE.
+ */
+bool ReverbState::allocLines(const LineSizes &sizes, const ALfloat frequency)
+{
+    ALuint totalSamples{CalcLineMetrics(sizes, frequency, &mDelay, &mEarly.VecAp.Delay,
+        &mEarly.Delay, &mLate.VecAp.Delay, &mLate.Delay)};
 
     totalSamples *= NUM_LINES;
     if(totalSamples != mSampleBuffer.size())
@@ -540,9 +681,6 @@ bool ReverbState::allocLines(const ALfloat frequency)
         mSampleBuffer.shrink_to_fit();
     }
 
-    /* Clear the sample buffer. */
-    std::fill(mSampleBuffer.begin(), mSampleBuffer.end(), 0.0f);
-
     /* Update all delays to reflect the new sample buffer. */
     RealizeLineOffset(mSampleBuffer.data(), &mDelay);
     RealizeLineOffset(mSampleBuffer.data(), &mEarly.VecAp.Delay);
@@ -550,31 +688,129 @@ bool ReverbState::allocLines(const ALfloat frequency)
     RealizeLineOffset(mSampleBuffer.data(), &mLate.VecAp.Delay);
     RealizeLineOffset(mSampleBuffer.data(), &mLate.Delay);
 
+    mLineSizes = sizes;
     return true;
 }
 
+/* Clears the delay lines and the filter histories that go with them. */
+void ReverbState::clearLines()
+{
+    std::fill(mSampleBuffer.begin(), mSampleBuffer.end(), 0.0f);
+
+    for(auto &filter : mFilter)
+    {
+        filter.Lp.clear();
+        filter.Hp.clear();
+    }
+    for(auto &t60 : mLate.T60)
+    {
+        t60.HFFilter.clear();
+        t60.LFFilter.clear();
+    }
+}
+
+ReverbState::~ReverbState()
+{
+    FreeLineSets(mPendingLines.exchange(nullptr, std::memory_order_acquire));
+    FreeLineSets(mRetiredLines.exchange(nullptr, std::memory_order_acquire));
+}
+
+void ReverbState::prepare(const EffectProps *props)
+{
+    if(!ReverbSizedLines)
+        return;
+
+    /* Free the buffers update swapped out since the last call. */
+    FreeLineSets(mRetiredLines.exchange(nullptr, std::memory_order_acquire));
+
+    if(props->Reverb.Density <= mPreparedSizes.Density
+        && props->Reverb.ReflectionsDelay <= mPreparedSizes.ReflectionsDelay
+        && props->Reverb.LateReverbDelay <= mPreparedSizes.LateReverbDelay)
+        return;
+
+    /* Grow the lines to fit the new properties, without shrinking them for
+     * any others.
+     */
+    std::unique_ptr<ReverbLineSet> lines{new ReverbLineSet{}};
+    lines->Sizes.Density = maxf(mPreparedSizes.Density, props->Reverb.Density);
+    lines->Sizes.ReflectionsDelay = maxf(mPreparedSizes.ReflectionsDelay,
+        props->Reverb.ReflectionsDelay);
+    lines->Sizes.LateReverbDelay = maxf(mPreparedSizes.LateReverbDelay,
+        props->Reverb.LateReverbDelay);
+
+    const ALuint totalSamples{CalcLineMetrics(lines->Sizes, mLineFrequency, &lines->Delay,
+        &lines->EarlyVecAp, &lines->Early, &lines->LateVecAp, &lines->Late)};
+    lines->Samples.resize(totalSamples * NUM_LINES, 0.0f);
+    RealizeLineOffset(lines->Samples.data(), &lines->Delay);
+    RealizeLineOffset(lines->Samples.data(), &lines->EarlyVecAp);
+    RealizeLineOffset(lines->Samples.data(), &lines->Early);
+    RealizeLineOffset(lines->Samples.data(), &lines->LateVecAp);
+    RealizeLineOffset(lines->Samples.data(), &lines->Late);
+    lines->LateFeedTap = CalcLateFeedTap(lines->Sizes, mLineFrequency);
+    mPreparedSizes = lines->Sizes;
+
+    /* Replace any lines update hasn't picked up yet. */
+    FreeLineSets(mPendingLines.exchange(lines.release(), std::memory_order_acq_rel));
+}
+
+/* Swaps in lines prepared on the application thread, copying the history of
+ * the current lines into them. The set is left holding the old buffer.
+ */
+void ReverbState::swapLines(ReverbLineSet *lines)
+{
+    /* Samples past the late feed tap in the main delay are the late reverb
+     * feed, which moves back with the tap. What's nearer is the input for the
+     * early reflection taps.
+     */
+    const ALsizei oldFeedTap{mLateFeedTap};
+    const ALsizei feedShift{lines->LateFeedTap - oldFeedTap};
+    const ALsizei oldLength{mDelay.Mask + 1};
+    CopyLineHistory(mDelay, lines->Delay, mOffset, 1, mini(oldFeedTap, oldLength), 0);
+    CopyLineHistory(mDelay, lines->Delay, mOffset, oldFeedTap+1,
+        mini(oldLength, lines->Delay.Mask+1 - feedShift), feedShift);
+
+    CopyLineHistory(mEarly.VecAp.Delay, lines->EarlyVecAp, mOffset, 1, mEarly.VecAp.Delay.Mask+1,
+        0);
+    CopyLineHistory(mEarly.Delay, lines->Early, mOffset, 1, mEarly.Delay.Mask+1, 0);
+    CopyLineHistory(mLate.VecAp.Delay, lines->LateVecAp, mOffset, 1, mLate.VecAp.Delay.Mask+1, 0);
+    CopyLineHistory(mLate.Delay, lines->Late, mOffset, 1, mLate.Delay.Mask+1, 0);
+
+    std::swap(mSampleBuffer, lines->Samples);
+    mDelay = lines->Delay;
+    mEarly.VecAp.Delay = lines->EarlyVecAp;
+    mEarly.Delay = lines->Early;
+    mLate.VecAp.Delay = lines->LateVecAp;
+    mLate.Delay = lines->Late;
+    mLineSizes = lines->Sizes;
+
+    /* Keep the current late taps reading the same feed. */
+    mLateFeedTap = lines->LateFeedTap;
+    for(auto &tap : mLateDelayTap)
+        tap[0] += feedShift;
+}
+
 ALboolean ReverbState::deviceUpdate(const ALCdevice *device)
 {
-    const auto frequency = static_cast<ALfloat>(device->Frequency);
+    const auto frequency = static_cast<ALfloat>(processRate(device));
+
+    /* Any lines waiting to be swapped in are for the old rate, and the new
+     * ones are sized for everything prepared so far.
+     */
+    FreeLineSets(mPendingLines.exchange(nullptr, std::memory_order_acquire));
+    FreeLineSets(mRetiredLines.exchange(nullptr, std::memory_order_acquire));
+    mLineFrequency = frequency;
+    const LineSizes sizes{ReverbSizedLines ? mPreparedSizes : MaxLineSizes};
 
     /* Allocate the delay lines. */
-    if(!allocLines(frequency))
+    if(!allocLines(sizes, frequency))
         return AL_FALSE;
+    clearLines();
 
-    const ALfloat multiplier{CalcDelayLengthMult(AL_EAXREVERB_MAX_DENSITY)};
+    mLateFeedTap = CalcLateFeedTap(sizes, frequency);
 
-    /* The late feed taps are set a fixed position past the latest delay tap. */
-    mLateFeedTap = float2int(
-        (AL_EAXREVERB_MAX_REFLECTIONS_DELAY + EARLY_TAP_LENGTHS.back()*multiplier) * frequency);
-
-    /* Clear filters and gain coefficients since the delay lines were all just
-     * cleared (if not reallocated).
+    /* Clear gain coefficients since the delay lines were all just cleared (if
+     * not reallocated).
      */
-    for(auto &filter : mFilter)
-    {
-        filter.Lp.clear();
-        filter.Hp.clear();
-    }
 
     for(auto &coeff : mEarlyDelayCoeff)
         std::fill(std::begin(coeff), std::end(coeff), 0.0f);
@@ -587,8 +823,6 @@ ALboolean ReverbState::deviceUpdate(const ALCdevice *device)
     {
         t60.MidGain[0] = 0.0f;
         t60.MidGain[1] = 0.0f;
-        t60.HFFilter.clear();
-        t60.LFFilter.clear();
     }
 
     for(auto &gains : mEarly.CurrentGain)
@@ -602,6 +836,7 @@ ALboolean ReverbState::deviceUpdate(const ALCdevice *device)
 
     /* Reset counters and offset base. */
     mFadeCount = 0;
+    mInterpCount = 0;
     std::fill(std::begin(mMaxUpdate), std::end(mMaxUpdate), BUFFERSIZE);
     mOffset = 0;
 
@@ -903,11 +1138,46 @@ void ReverbState::update3DPanning(const ALfloat *ReflectionsPan, const ALfloat *
     }
 }
 
+/* Update the panning gains for the low quality lines. Without the A-Format
+ * conversion, the two lines are panned left and right with a wide spread.
+ */
+void ReverbState::updateLowPanning(const ALfloat earlyGain, const ALfloat lateGain,
+    const EffectTarget &target)
+{
+    /* Scale up to approximately match the energy of the four full lines. */
+    const ALfloat scale{std::sqrt(3.0f)};
+
+    ALfloat coeffs[2][MAX_AMBI_CHANNELS];
+    CalcAngleCoeffs(al::MathDefs<float>::Pi()* 0.5f, 0.0f, al::MathDefs<float>::Pi(), coeffs[0]);
+    CalcAngleCoeffs(al::MathDefs<float>::Pi()*-0.5f, 0.0f, al::MathDefs<float>::Pi(), coeffs[1]);
+
+    mOutBuffer = target.Main->Buffer;
+    mOutChannels = target.Main->NumChannels;
+    ComputePanGains(target.Main, coeffs[0], earlyGain*scale, mEarly.PanGain[LOW_LINE0]);
+    ComputePanGains(target.Main, coeffs[1], earlyGain*scale, mEarly.PanGain[LOW_LINE1]);
+    ComputePanGains(target.Main, coeffs[0], lateGain*scale, mLate.PanGain[LOW_LINE0]);
+    ComputePanGains(target.Main, coeffs[1], lateGain*scale, mLate.PanGain[LOW_LINE1]);
+}
+
 void ReverbState::update(const ALCcontext *Context, const ALeffectslot *Slot, const EffectProps *props, const EffectTarget target)
 {
     const ALCdevice *Device{Context->Device};
     const ALlistener &Listener = Context->Listener;
-    const auto frequency = static_cast<ALfloat>(Device->Frequency);
+    const auto frequency = static_cast<ALfloat>(processRate(Device));
+
+    /* Pick up any lines grown for these properties. */
+    if(ReverbLineSet *lines{mPendingLines.exchange(nullptr, std::memory_order_acq_rel)})
+    {
+        swapLines(lines);
+        AtomicReplaceHead(mRetiredLines, lines);
+    }
+
+    /* Keep the line lengths within what the lines fit. */
+    const ALfloat density{minf(props->Reverb.Density, mLineSizes.Density)};
+    const ALfloat reflectionsDelay{minf(props->Reverb.ReflectionsDelay,
+        mLineSizes.ReflectionsDelay)};
+    const ALfloat lateReverbDelay{minf(props->Reverb.LateReverbDelay,
+        mLineSizes.LateReverbDelay)};
 
     /* Calculate the master filters */
     ALfloat hf0norm{minf(props->Reverb.HFReference / frequency, 0.49f)};
@@ -928,15 +1198,35 @@ void ReverbState::update(const ALCcontext *Context, const ALeffectslot *Slot, co
     }
 
     /* Update the main effect delay and associated taps. */
-    updateDelayLine(props->Reverb.ReflectionsDelay, props->Reverb.LateReverbDelay,
-                    props->Reverb.Density, props->Reverb.DecayTime, frequency);
+    updateDelayLine(reflectionsDelay, lateReverbDelay, density, props->Reverb.DecayTime,
+        frequency);
 
     /* Update the early lines. */
-    mEarly.updateLines(props->Reverb.Density, props->Reverb.Diffusion, props->Reverb.DecayTime,
-        frequency);
+    mEarly.updateLines(density, props->Reverb.Diffusion, props->Reverb.DecayTime, frequency);
 
     /* Get the mixing matrix coefficients. */
     CalcMatrixCoeffs(props->Reverb.Diffusion, &mMixX, &mMixY);
+    /* The low quality lines use a 2x2 rotation, in place of the 4x4 matrix
+     * (for an order of 2, n = 1).
+     */
+    mLowMixX = std::cos(props->Reverb.Diffusion * al::MathDefs<float>::Pi()*0.25f);
+    mLowMixY = std::sin(props->Reverb.Diffusion * al::MathDefs<float>::Pi()*0.25f);
+
+    /* Slots at default quality drop to low quality while the context's
+     * effects are over budget.
+     */
+    const ALenum quality{(Slot->Params.Quality != AL_QUALITY_DEFAULT_SOFT) ? Slot->Params.Quality :
+        Context->EffectsDowngraded.load(std::memory_order_relaxed) ? AL_QUALITY_LOW_SOFT :
+        ReverbQuality};
+    const bool lowQuality{quality == AL_QUALITY_LOW_SOFT};
+    if(lowQuality != mLowQuality)
+    {
+        /* The two modes use the delay lines differently, so start them over
+         * when switching.
+         */
+        clearLines();
+        mLowQuality = lowQuality;
+    }
 
     /* If the HF limit parameter is flagged, calculate an appropriate limit
      * based on the air absorption parameter.
@@ -954,42 +1244,42 @@ void ReverbState::update(const ALCcontext *Context, const ALeffectslot *Slot, co
         AL_EAXREVERB_MIN_DECAY_TIME, AL_EAXREVERB_MAX_DECAY_TIME)};
 
     /* Update the late lines. */
-    mLate.updateLines(props->Reverb.Density, props->Reverb.Diffusion, lfDecayTime,
+    mLate.updateLines(density, props->Reverb.Diffusion, lfDecayTime,
         props->Reverb.DecayTime, hfDecayTime, lf0norm, hf0norm, frequency);
 
     /* Update early and late 3D panning. */
     const ALfloat gain{props->Reverb.Gain * Slot->Params.Gain * ReverbBoost};
-    update3DPanning(props->Reverb.ReflectionsPan, props->Reverb.LateReverbPan,
-        props->Reverb.ReflectionsGain*gain, props->Reverb.LateReverbGain*gain, target);
+    if(mLowQuality)
+        updateLowPanning(props->Reverb.ReflectionsGain*gain, props->Reverb.LateReverbGain*gain,
+            target);
+    else
+        update3DPanning(props->Reverb.ReflectionsPan, props->Reverb.LateReverbPan,
+            props->Reverb.ReflectionsGain*gain, props->Reverb.LateReverbGain*gain, target);
+
+    /* The decay times are for -60dB, so scale the longest one to reach the
+     * silence threshold, after the signal makes it through the delays.
+     */
+    const ALfloat maxDecayTime{maxf(props->Reverb.DecayTime, maxf(lfDecayTime, hfDecayTime))};
+    const ALfloat tailTime{reflectionsDelay + lateReverbDelay +
+        maxDecayTime * (std::log10(GAIN_SILENCE_THRESHOLD) * -20.0f / 60.0f)};
+    mTailSamples = static_cast<ALuint>(mLateFeedTap + float2int(tailTime*frequency));
 
     /* Calculate the max update size from the smallest relevant delay. */
     mMaxUpdate[1] = mini(BUFFERSIZE, mini(mEarly.Offset[0][1], mLate.Offset[0][1]));
 
-    /* Determine if delay-line cross-fading is required. Density is essentially
-     * a master control for the feedback delays, so changes the offsets of many
-     * delay lines.
+    /* Determine if delay-line cross-fading is required. Density and the
+     * reflection and late reverb delays change the delay line offsets, which
+     * needs a full cross-fade between the old and new taps. Otherwise, only
+     * the gain coefficients changed (from the diffusion, decay times, and
+     * HF/LF references), which can be interpolated on the current taps.
      */
-    if(mParams.Density != props->Reverb.Density ||
-        /* Diffusion and decay times influences the decay rate (gain) of the
-         * late reverb T60 filter.
-         */
-       mParams.Diffusion != props->Reverb.Diffusion ||
-       mParams.DecayTime != props->Reverb.DecayTime ||
-       mParams.HFDecayTime != hfDecayTime ||
-       mParams.LFDecayTime != lfDecayTime ||
-       /* HF/LF References control the weighting used to calculate the density
-        * gain.
-        */
-       mParams.HFReference != props->Reverb.HFReference ||
-       mParams.LFReference != props->Reverb.LFReference)
+    if(tapsChanged())
+    {
         mFadeCount = 0;
-    mParams.Density = props->Reverb.Density;
-    mParams.Diffusion = props->Reverb.Diffusion;
-    mParams.DecayTime = props->Reverb.DecayTime;
-    mParams.HFDecayTime = hfDecayTime;
-    mParams.LFDecayTime = lfDecayTime;
-    mParams.HFReference = props->Reverb.HFReference;
-    mParams.LFReference = props->Reverb.LFReference;
+        mInterpCount = 0;
+    }
+    else if(mFadeCount >= FADE_SAMPLES && gainsChanged())
+        mInterpCount = INTERP_SAMPLES;
 }
 
 
@@ -1069,6 +1359,34 @@ inline void VectorScatterRevDelayIn(const DelayLineI *Delay, ALint offset,
     }
 }
 
+/* Scatters the two low quality lines with a 2x2 rotation, reversing the
+ * inputs the same way as above.
+ */
+inline void LowScatterRevDelayIn(const DelayLineI *Delay, ALint offset,
+    const ALfloat xCoeff, const ALfloat yCoeff, const ALsizei base,
+    const ALfloat (*RESTRICT in)[BUFFERSIZE], const ALsizei count)
+{
+    const DelayLineI delay{*Delay};
+
+    ASSUME(base >= 0);
+    ASSUME(count > 0);
+
+    for(ALsizei i{0};i < count;)
+    {
+        offset &= delay.Mask;
+        ALsizei td{mini(delay.Mask+1 - offset, count-i)};
+        do {
+            const ALfloat f0{in[LOW_LINE1][base+i]};
+            const ALfloat f1{in[LOW_LINE0][base+i]};
+            ++i;
+
+            ALfloat *RESTRICT line{delay.Line[offset++]};
+            line[LOW_LINE0] = xCoeff*f0 + yCoeff*f1;
+            line[LOW_LINE1] = xCoeff*f1 - yCoeff*f0;
+        } while(--td);
+    }
+}
+
 /* This applies a Gerzon multiple-in/multiple-out (MIMO) vector all-pass
  * filter to the 4-line input.
  *
@@ -1168,6 +1486,47 @@ void VecAllpass::processFaded(ALfloat (*RESTRICT samples)[BUFFERSIZE], ALsizei o
     }
 }
 
+/* A two-line version of the above for the low quality mode, which never
+ * cross-fades.
+ */
+void VecAllpass::processLow(ALfloat (*RESTRICT samples)[BUFFERSIZE], ALsizei offset,
+    const ALfloat xCoeff, const ALfloat yCoeff, const ALsizei todo)
+{
+    const DelayLineI delay{Delay};
+    const ALfloat feedCoeff{Coeff};
+
+    ASSUME(todo > 0);
+
+    ALsizei vap_offset0{offset - Offset[LOW_LINE0][0]};
+    ALsizei vap_offset1{offset - Offset[LOW_LINE1][0]};
+    for(ALsizei i{0};i < todo;)
+    {
+        vap_offset0 &= delay.Mask;
+        vap_offset1 &= delay.Mask;
+        offset &= delay.Mask;
+
+        const ALsizei maxoff{maxi(offset, maxi(vap_offset0, vap_offset1))};
+        ALsizei td{mini(delay.Mask+1 - maxoff, todo - i)};
+
+        do {
+            const ALfloat input0{samples[LOW_LINE0][i]};
+            const ALfloat input1{samples[LOW_LINE1][i]};
+            const ALfloat out0{delay.Line[vap_offset0++][LOW_LINE0] - feedCoeff*input0};
+            const ALfloat out1{delay.Line[vap_offset1++][LOW_LINE1] - feedCoeff*input1};
+            const ALfloat f0{input0 + feedCoeff*out0};
+            const ALfloat f1{input1 + feedCoeff*out1};
+
+            samples[LOW_LINE0][i] = out0;
+            samples[LOW_LINE1][i] = out1;
+            ++i;
+
+            ALfloat *RESTRICT line{delay.Line[offset++]};
+            line[LOW_LINE0] = xCoeff*f0 + yCoeff*f1;
+            line[LOW_LINE1] = xCoeff*f1 - yCoeff*f0;
+        } while(--td);
+    }
+}
+
 /* This generates early reflections.
  *
  * This is done by obtaining the primary reflections (those arriving from the
@@ -1185,10 +1544,12 @@ void VecAllpass::processFaded(ALfloat (*RESTRICT samples)[BUFFERSIZE], ALsizei o
  * and fed into the late reverb section of the main delay line.
  *
  * Two static specializations are used for transitional (cross-faded) delay
- * line processing and non-transitional processing.
+ * line processing and non-transitional processing. The latter still
+ * interpolates the gain coefficients by the given amount, for changes that
+ * keep the same delay line taps.
  */
 void EarlyReflection_Unfaded(ReverbState *State, const ALsizei offset, const ALsizei todo,
-    const ALsizei base, ALfloat (*RESTRICT out)[BUFFERSIZE])
+    const ALfloat interp, const ALsizei base, ALfloat (*RESTRICT out)[BUFFERSIZE])
 {
     ALfloat (*RESTRICT temps)[BUFFERSIZE]{State->mTempSamples};
     const DelayLineI early_delay{State->mEarly.Delay};
@@ -1204,12 +1565,15 @@ void EarlyReflection_Unfaded(ReverbState *State, const ALsizei offset, const ALs
     for(ALsizei j{0};j < NUM_LINES;j++)
     {
         ALsizei early_delay_tap{offset - State->mEarlyDelayTap[j][0]};
-        const ALfloat coeff{State->mEarlyDelayCoeff[j][0]};
+        ALfloat coeff{State->mEarlyDelayCoeff[j][0]};
+        const ALfloat coeffStep{(lerp(coeff, State->mEarlyDelayCoeff[j][1], interp) - coeff) /
+            static_cast<ALfloat>(todo)};
         for(ALsizei i{0};i < todo;)
         {
             early_delay_tap &= main_delay.Mask;
             ALsizei td{mini(main_delay.Mask+1 - early_delay_tap, todo - i)};
             do {
+                coeff += coeffStep;
                 temps[j][i++] = main_delay.Line[early_delay_tap++][j] * coeff;
             } while(--td);
         }
@@ -1226,7 +1590,10 @@ void EarlyReflection_Unfaded(ReverbState *State, const ALsizei offset, const ALs
     for(ALsizei j{0};j < NUM_LINES;j++)
     {
         ALint feedb_tap{offset - State->mEarly.Offset[j][0]};
-        const ALfloat feedb_coeff{State->mEarly.Coeff[j][0]};
+        ALfloat feedb_coeff{State->mEarly.Coeff[j][0]};
+        const ALfloat feedb_coeffStep{
+            (lerp(feedb_coeff, State->mEarly.Coeff[j][1], interp) - feedb_coeff) /
+            static_cast<ALfloat>(todo)};
 
         ASSUME(base >= 0);
         for(ALsizei i{0};i < todo;)
@@ -1234,6 +1601,7 @@ void EarlyReflection_Unfaded(ReverbState *State, const ALsizei offset, const ALs
             feedb_tap &= early_delay.Mask;
             ALsizei td{mini(early_delay.Mask+1 - feedb_tap, todo - i)};
             do {
+                feedb_coeff += feedb_coeffStep;
                 out[j][base+i] = temps[j][i] + early_delay.Line[feedb_tap++][j]*feedb_coeff;
                 ++i;
             } while(--td);
@@ -1321,6 +1689,59 @@ void EarlyReflection_Faded(ReverbState *State, const ALsizei offset, const ALsiz
     VectorScatterRevDelayIn(&main_delay, late_feed_tap, mixX, mixY, base, out, todo);
 }
 
+/* The low quality early reflections. These work the same as above, but only
+ * with the two low quality lines.
+ */
+void EarlyReflection_Low(ReverbState *State, const ALsizei offset, const ALsizei todo,
+    const ALsizei base, ALfloat (*RESTRICT out)[BUFFERSIZE])
+{
+    ALfloat (*RESTRICT temps)[BUFFERSIZE]{State->mTempSamples};
+    const DelayLineI early_delay{State->mEarly.Delay};
+    const DelayLineI main_delay{State->mDelay};
+    const ALfloat mixX{State->mLowMixX};
+    const ALfloat mixY{State->mLowMixY};
+
+    ASSUME(todo > 0);
+
+    for(ALsizei j : {LOW_LINE0, LOW_LINE1})
+    {
+        ALsizei early_delay_tap{offset - State->mEarlyDelayTap[j][0]};
+        const ALfloat coeff{State->mEarlyDelayCoeff[j][0]};
+        for(ALsizei i{0};i < todo;)
+        {
+            early_delay_tap &= main_delay.Mask;
+            ALsizei td{mini(main_delay.Mask+1 - early_delay_tap, todo - i)};
+            do {
+                temps[j][i++] = main_delay.Line[early_delay_tap++][j] * coeff;
+            } while(--td);
+        }
+    }
+
+    State->mEarly.VecAp.processLow(temps, offset, mixX, mixY, todo);
+
+    for(ALsizei j : {LOW_LINE0, LOW_LINE1})
+    {
+        ALint feedb_tap{offset - State->mEarly.Offset[j][0]};
+        const ALfloat feedb_coeff{State->mEarly.Coeff[j][0]};
+
+        ASSUME(base >= 0);
+        for(ALsizei i{0};i < todo;)
+        {
+            feedb_tap &= early_delay.Mask;
+            ALsizei td{mini(early_delay.Mask+1 - feedb_tap, todo - i)};
+            do {
+                out[j][base+i] = temps[j][i] + early_delay.Line[feedb_tap++][j]*feedb_coeff;
+                ++i;
+            } while(--td);
+        }
+    }
+    for(ALsizei j : {LOW_LINE0, LOW_LINE1})
+        early_delay.write(offset, NUM_LINES-1-j, temps[j], todo);
+
+    const ALsizei late_feed_tap{offset - State->mLateFeedTap};
+    LowScatterRevDelayIn(&main_delay, late_feed_tap, mixX, mixY, base, out, todo);
+}
+
 /* This generates the reverb tail using a modified feed-back delay network
  * (FDN).
  *
@@ -1333,10 +1754,11 @@ void EarlyReflection_Faded(ReverbState *State, const ALsizei offset, const ALsiz
  * and scattered with the FDN matrix before re-feeding the delay lines.
  *
  * Two variations are made, one for for transitional (cross-faded) delay line
- * processing and one for non-transitional processing.
+ * processing and one for non-transitional processing (which interpolates the
+ * gain coefficients, as with the early reflections).
  */
 void LateReverb_Unfaded(ReverbState *State, const ALsizei offset, const ALsizei todo,
-    const ALsizei base, ALfloat (*RESTRICT out)[BUFFERSIZE])
+    const ALfloat interp, const ALsizei base, ALfloat (*RESTRICT out)[BUFFERSIZE])
 {
     ALfloat (*RESTRICT temps)[BUFFERSIZE]{State->mTempSamples};
     const DelayLineI late_delay{State->mLate.Delay};
@@ -1353,8 +1775,13 @@ void LateReverb_Unfaded(ReverbState *State, const ALsizei offset, const ALsizei
     {
         ALsizei late_delay_tap{offset - State->mLateDelayTap[j][0]};
         ALsizei late_feedb_tap{offset - State->mLate.Offset[j][0]};
-        const ALfloat midGain{State->mLate.T60[j].MidGain[0]};
-        const ALfloat densityGain{State->mLate.DensityGain[0] * midGain};
+        ALfloat midGain{State->mLate.T60[j].MidGain[0]};
+        ALfloat densityGain{State->mLate.DensityGain[0] * midGain};
+        const ALfloat newMidGain{lerp(midGain, State->mLate.T60[j].MidGain[1], interp)};
+        const ALfloat newDensityGain{newMidGain *
+            lerp(State->mLate.DensityGain[0], State->mLate.DensityGain[1], interp)};
+        const ALfloat midStep{(newMidGain - midGain) / static_cast<ALfloat>(todo)};
+        const ALfloat densityStep{(newDensityGain - densityGain) / static_cast<ALfloat>(todo)};
         for(ALsizei i{0};i < todo;)
         {
             late_delay_tap &= main_delay.Mask;
@@ -1363,6 +1790,8 @@ void LateReverb_Unfaded(ReverbState *State, const ALsizei offset, const ALsizei
                 mini(main_delay.Mask+1 - late_delay_tap, late_delay.Mask+1 - late_feedb_tap),
                 todo - i)};
             do {
+                midGain += midStep;
+                densityGain += densityStep;
                 temps[j][i++] =
                     main_delay.Line[late_delay_tap++][j]*densityGain +
                     late_delay.Line[late_feedb_tap++][j]*midGain;
@@ -1443,23 +1872,197 @@ void LateReverb_Faded(ReverbState *State, const ALsizei offset, const ALsizei to
     VectorScatterRevDelayIn(&late_delay, offset, mixX, mixY, base, out, todo);
 }
 
-void ReverbState::process(ALsizei samplesToDo, const ALfloat (*RESTRICT samplesIn)[BUFFERSIZE], const ALsizei numInput, ALfloat (*RESTRICT samplesOut)[BUFFERSIZE], const ALsizei numOutput)
+/* The low quality late reverb. Only the two low quality lines are processed,
+ * and the frequency-dependent decay is skipped, leaving the mid-band decay
+ * for the full range.
+ */
+void LateReverb_Low(ReverbState *State, const ALsizei offset, const ALsizei todo,
+    const ALsizei base, ALfloat (*RESTRICT out)[BUFFERSIZE])
 {
-    ALsizei fadeCount{mFadeCount};
+    ALfloat (*RESTRICT temps)[BUFFERSIZE]{State->mTempSamples};
+    const DelayLineI late_delay{State->mLate.Delay};
+    const DelayLineI main_delay{State->mDelay};
+    const ALfloat mixX{State->mLowMixX};
+    const ALfloat mixY{State->mLowMixY};
 
+    ASSUME(todo > 0);
+
+    for(ALsizei j : {LOW_LINE0, LOW_LINE1})
+    {
+        ALsizei late_delay_tap{offset - State->mLateDelayTap[j][0]};
+        ALsizei late_feedb_tap{offset - State->mLate.Offset[j][0]};
+        const ALfloat midGain{State->mLate.T60[j].MidGain[0]};
+        const ALfloat densityGain{State->mLate.DensityGain[0] * midGain};
+        for(ALsizei i{0};i < todo;)
+        {
+            late_delay_tap &= main_delay.Mask;
+            late_feedb_tap &= late_delay.Mask;
+            ALsizei td{mini(
+                mini(main_delay.Mask+1 - late_delay_tap, late_delay.Mask+1 - late_feedb_tap),
+                todo - i)};
+            do {
+                temps[j][i++] =
+                    main_delay.Line[late_delay_tap++][j]*densityGain +
+                    late_delay.Line[late_feedb_tap++][j]*midGain;
+            } while(--td);
+        }
+    }
+
+    State->mLate.VecAp.processLow(temps, offset, mixX, mixY, todo);
+
+    for(ALsizei j : {LOW_LINE0, LOW_LINE1})
+        std::copy_n(temps[j], todo, out[j]+base);
+
+    LowScatterRevDelayIn(&late_delay, offset, mixX, mixY, base, out, todo);
+}
+
+/* Checks if any of the delay line taps are changing. */
+bool ReverbState::tapsChanged() const noexcept
+{
+    for(ALsizei c{0};c < NUM_LINES;c++)
+    {
+        if(mEarlyDelayTap[c][0] != mEarlyDelayTap[c][1]
+            || mEarly.VecAp.Offset[c][0] != mEarly.VecAp.Offset[c][1]
+            || mEarly.Offset[c][0] != mEarly.Offset[c][1]
+            || mLateDelayTap[c][0] != mLateDelayTap[c][1]
+            || mLate.VecAp.Offset[c][0] != mLate.VecAp.Offset[c][1]
+            || mLate.Offset[c][0] != mLate.Offset[c][1])
+            return true;
+    }
+    return false;
+}
+
+/* Checks if any of the gain coefficients are changing. */
+bool ReverbState::gainsChanged() const noexcept
+{
+    for(ALsizei c{0};c < NUM_LINES;c++)
+    {
+        if(mEarlyDelayCoeff[c][0] != mEarlyDelayCoeff[c][1]
+            || mEarly.Coeff[c][0] != mEarly.Coeff[c][1]
+            || mLate.T60[c].MidGain[0] != mLate.T60[c].MidGain[1])
+            return true;
+    }
+    return mLate.DensityGain[0] != mLate.DensityGain[1];
+}
+
+/* Moves the current gain coefficients toward the new ones by the given
+ * amount, matching the interpolation done when processing.
+ */
+void ReverbState::stepGains(const ALfloat interp)
+{
+    if(interp >= 1.0f)
+    {
+        for(ALsizei c{0};c < NUM_LINES;c++)
+        {
+            mEarlyDelayCoeff[c][0] = mEarlyDelayCoeff[c][1];
+            mEarly.Coeff[c][0] = mEarly.Coeff[c][1];
+            mLate.T60[c].MidGain[0] = mLate.T60[c].MidGain[1];
+        }
+        mLate.DensityGain[0] = mLate.DensityGain[1];
+        return;
+    }
+
+    for(ALsizei c{0};c < NUM_LINES;c++)
+    {
+        mEarlyDelayCoeff[c][0] = lerp(mEarlyDelayCoeff[c][0], mEarlyDelayCoeff[c][1], interp);
+        mEarly.Coeff[c][0] = lerp(mEarly.Coeff[c][0], mEarly.Coeff[c][1], interp);
+        mLate.T60[c].MidGain[0] = lerp(mLate.T60[c].MidGain[0], mLate.T60[c].MidGain[1],
+            interp);
+    }
+    mLate.DensityGain[0] = lerp(mLate.DensityGain[0], mLate.DensityGain[1], interp);
+}
+
+/* Completes any pending cross-fade or interpolation, making the new delay line
+ * taps and gains current.
+ */
+void ReverbState::finishFade()
+{
+    mFadeCount = FADE_SAMPLES;
+    mInterpCount = 0;
+    for(ALsizei c{0};c < NUM_LINES;c++)
+    {
+        mEarlyDelayTap[c][0] = mEarlyDelayTap[c][1];
+        mEarlyDelayCoeff[c][0] = mEarlyDelayCoeff[c][1];
+        mEarly.VecAp.Offset[c][0] = mEarly.VecAp.Offset[c][1];
+        mEarly.Offset[c][0] = mEarly.Offset[c][1];
+        mEarly.Coeff[c][0] = mEarly.Coeff[c][1];
+        mLateDelayTap[c][0] = mLateDelayTap[c][1];
+        mLate.VecAp.Offset[c][0] = mLate.VecAp.Offset[c][1];
+        mLate.Offset[c][0] = mLate.Offset[c][1];
+        mLate.T60[c].MidGain[0] = mLate.T60[c].MidGain[1];
+    }
+    mLate.DensityGain[0] = mLate.DensityGain[1];
+    mMaxUpdate[0] = mMaxUpdate[1];
+}
+
+void ReverbState::processLow(const ALsizei samplesToDo, const ALfloat *RESTRICT samplesIn,
+    ALfloat (*RESTRICT samplesOut)[BUFFERSIZE], const ALsizei numOutput)
+{
+    /* Parameter changes are applied immediately, rather than cross-faded. */
+    if(mFadeCount < FADE_SAMPLES || mInterpCount > 0)
+        finishFade();
+
+    /* Both lines are fed with the band-passed W signal, scaled to A-Format
+     * levels. The differing delay taps decorrelate them.
+     */
+    ALfloat *RESTRICT input{mTempSamples[0]};
+    std::transform(samplesIn, samplesIn+samplesToDo, input,
+        [](const ALfloat s) noexcept -> ALfloat { return s * B2A[0][0]; });
+    mFilter[0].Lp.process(input, input, samplesToDo);
+    mFilter[0].Hp.process(input, input, samplesToDo);
+
+    for(ALsizei base{0};base < samplesToDo;)
+    {
+        const ALsizei todo{mini(samplesToDo - base, mMaxUpdate[1])};
+        ASSUME(todo > 0 && todo <= BUFFERSIZE);
+
+        const ALsizei offset{mOffset + base};
+        ASSUME(offset >= 0);
+
+        for(ALsizei c : {LOW_LINE0, LOW_LINE1})
+            mDelay.write(offset, c, input+base, todo);
+
+        EarlyReflection_Low(this, offset, todo, base, mEarlyBuffer);
+        LateReverb_Low(this, offset, todo, base, mLateBuffer);
+
+        base += todo;
+    }
+    mOffset = (mOffset+samplesToDo) & 0x3fffffff;
+
+    MixOutLow(numOutput, samplesOut, samplesToDo);
+}
+
+void ReverbState::process(ALsizei samplesToDo, const ALfloat (*RESTRICT samplesIn)[BUFFERSIZE], const ALsizei numInput, ALfloat (*RESTRICT samplesOut)[BUFFERSIZE], const ALsizei numOutput)
+{
     ASSUME(samplesToDo > 0);
 
+    if(mLowQuality)
+    {
+        processLow(samplesToDo, samplesIn[0], samplesOut, numOutput);
+        return;
+    }
+
+    ALsizei fadeCount{mFadeCount};
+
     /* Convert B-Format to A-Format for processing. */
     ALfloat (&afmt)[NUM_LINES][BUFFERSIZE] = mTempSamples;
     for(ALsizei c{0};c < NUM_LINES;c++)
     {
         std::fill_n(std::begin(afmt[c]), samplesToDo, 0.0f);
         MixRowSamples(afmt[c], B2A[c], samplesIn, numInput, 0, samplesToDo);
+    }
 
-        /* Band-pass the incoming samples. */
-        mFilter[c].Lp.process(afmt[c], afmt[c], samplesToDo);
-        mFilter[c].Hp.process(afmt[c], afmt[c], samplesToDo);
+    /* Band-pass the incoming samples, with all lines together. */
+    BiquadFilter *lpfilters[NUM_LINES], *hpfilters[NUM_LINES];
+    ALfloat *lines[NUM_LINES];
+    for(ALsizei c{0};c < NUM_LINES;c++)
+    {
+        lpfilters[c] = &mFilter[c].Lp;
+        hpfilters[c] = &mFilter[c].Hp;
+        lines[c] = afmt[c];
     }
+    FilterMultiSamples(lpfilters, lines, lines, NUM_LINES, samplesToDo);
+    FilterMultiSamples(hpfilters, lines, lines, NUM_LINES, samplesToDo);
 
     /* Process reverb for these samples. */
     for(ALsizei base{0};base < samplesToDo;)
@@ -1471,6 +2074,9 @@ void ReverbState::process(ALsizei samplesToDo, const ALfloat (*RESTRICT samplesI
             todo = mini(todo, FADE_SAMPLES-fadeCount);
             todo = mini(todo, mMaxUpdate[0]);
         }
+        /* Similarly when interpolating gains. */
+        else if(mInterpCount > 0)
+            todo = mini(todo, mInterpCount);
         todo = mini(todo, mMaxUpdate[1]);
         ASSUME(todo > 0 && todo <= BUFFERSIZE);
 
@@ -1496,29 +2102,26 @@ void ReverbState::process(ALsizei samplesToDo, const ALfloat (*RESTRICT samplesI
             if(fadeCount >= FADE_SAMPLES)
             {
                 /* Update the cross-fading delay line taps. */
+                finishFade();
                 fadeCount = FADE_SAMPLES;
-                for(ALsizei c{0};c < NUM_LINES;c++)
-                {
-                    mEarlyDelayTap[c][0] = mEarlyDelayTap[c][1];
-                    mEarlyDelayCoeff[c][0] = mEarlyDelayCoeff[c][1];
-                    mEarly.VecAp.Offset[c][0] = mEarly.VecAp.Offset[c][1];
-                    mEarly.Offset[c][0] = mEarly.Offset[c][1];
-                    mEarly.Coeff[c][0] = mEarly.Coeff[c][1];
-                    mLateDelayTap[c][0] = mLateDelayTap[c][1];
-                    mLate.VecAp.Offset[c][0] = mLate.VecAp.Offset[c][1];
-                    mLate.Offset[c][0] = mLate.Offset[c][1];
-                    mLate.T60[c].MidGain[0] = mLate.T60[c].MidGain[1];
-                }
-                mLate.DensityGain[0] = mLate.DensityGain[1];
-                mMaxUpdate[0] = mMaxUpdate[1];
             }
         }
         else
         {
+            /* Get how far to interpolate the gains for these samples. */
+            const ALfloat interp{(mInterpCount > 0) ?
+                static_cast<ALfloat>(todo) / static_cast<ALfloat>(mInterpCount) : 0.0f};
+
             /* Generate early reflections and late reverb. */
-            EarlyReflection_Unfaded(this, offset, todo, base, mEarlyBuffer);
+            EarlyReflection_Unfaded(this, offset, todo, interp, base, mEarlyBuffer);
+
+            LateReverb_Unfaded(this, offset, todo, interp, base, mLateBuffer);
 
-            LateReverb_Unfaded(this, offset, todo, base, mLateBuffer);
+            if(mInterpCount > 0)
+            {
+                stepGains(interp);
+                mInterpCount -= todo;
+            }
         }
 
         base += todo;
@@ -1834,6 +2437,7 @@ struct ReverbStateFactory final : public EffectStateFactory {
     EffectState *create() override { return new ReverbState{}; }
     EffectProps getDefaultProps() const noexcept override;
     const EffectVtable *getEffectVtable() const noexcept override { return &EAXReverb_vtable; }
+    bool useHalfRate() const noexcept override { return ReverbHalfRate; }
 };
 
 EffectProps ReverbStateFactory::getDefaultProps() const noexcept
@@ -2049,6 +2653,7 @@ struct StdReverbStateFactory final : public EffectStateFactory {
     EffectState *create() override { return new ReverbState{}; }
     EffectProps getDefaultProps() const noexcept override;
     const EffectVtable *getEffectVtable() const noexcept override { return &StdReverb_vtable; }
+    bool useHalfRate() const noexcept override { return ReverbHalfRate; }
 };
 
 EffectProps StdReverbStateFactory::getDefaultProps() const noexcept
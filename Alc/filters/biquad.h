@@ -1,6 +1,7 @@
 #ifndef FILTERS_BIQUAD_H
 #define FILTERS_BIQUAD_H
 
+#include <array>
 #include <cmath>
 #include <utility>
 
@@ -62,6 +63,15 @@ public:
      */
     void setParams(BiquadType type, Real gain, Real f0norm, Real rcpQ);
 
+    /* Whether the other filter has the same coefficients and state, so it
+     * would give the same output for the same input.
+     */
+    bool sameAs(const BiquadFilterR &other) const noexcept
+    {
+        return z1 == other.z1 && z2 == other.z2 && b0 == other.b0 && b1 == other.b1 &&
+            b2 == other.b2 && a1 == other.a1 && a2 == other.a2;
+    }
+
     void copyParamsFrom(const BiquadFilterR &other)
     {
         b0 = other.b0;
@@ -100,6 +110,11 @@ public:
         z2_ = in*b2 - out*a2;
         return out;
     }
+    /* For vectorized processing of multiple filters. Returns b0, b1, b2, a1,
+     * and a2, in that order.
+     */
+    std::array<Real,5> getCoefficients() const noexcept
+    { return {{b0, b1, b2, a1, a2}}; }
 };
 
 using BiquadFilter = BiquadFilterR<float>;
@@ -259,6 +259,94 @@ void NfcFilterAdjust4(NfcFilter4 *nfc, const float w0) noexcept
     nfc->b4 = 4.0f * b_01 / g_0;
 }
 
+/* Applies the first- through MaxOrder filters to the same input in one pass.
+ * The filters' recurrences are independent of each other, so they can run
+ * interleaved, and the input is only read once.
+ */
+template<int MaxOrder>
+void NfcProcessOrders(NfcFilter1 &first, NfcFilter2 &second, NfcFilter3 &third,
+    NfcFilter4 &fourth, float *const *dst, const float *RESTRICT src, const int count)
+{
+    static_assert(MaxOrder >= 1 && MaxOrder <= 4, "Invalid NFC order");
+    ASSUME(count > 0);
+
+    float *RESTRICT dst1{dst[0]};
+    float *RESTRICT dst2{(MaxOrder >= 2) ? dst[1] : nullptr};
+    float *RESTRICT dst3{(MaxOrder >= 3) ? dst[2] : nullptr};
+    float *RESTRICT dst4{(MaxOrder >= 4) ? dst[3] : nullptr};
+
+    const NfcFilter1 f1{first};
+    const NfcFilter2 f2{second};
+    const NfcFilter3 f3{third};
+    const NfcFilter4 f4{fourth};
+    float z1_1{f1.z[0]};
+    float z2_1{f2.z[0]}, z2_2{f2.z[1]};
+    float z3_1{f3.z[0]}, z3_2{f3.z[1]}, z3_3{f3.z[2]};
+    float z4_1{f4.z[0]}, z4_2{f4.z[1]}, z4_3{f4.z[2]}, z4_4{f4.z[3]};
+    for(int i{0};i < count;++i)
+    {
+        const float in{src[i]};
+        {
+            const float y{in*f1.gain - f1.a1*z1_1};
+            const float out{y + f1.b1*z1_1};
+            z1_1 += y;
+            dst1[i] = out;
+        }
+        if(MaxOrder >= 2)
+        {
+            const float y{in*f2.gain - f2.a1*z2_1 - f2.a2*z2_2};
+            const float out{y + f2.b1*z2_1 + f2.b2*z2_2};
+            z2_2 += z2_1;
+            z2_1 += y;
+            dst2[i] = out;
+        }
+        if(MaxOrder >= 3)
+        {
+            float y{in*f3.gain - f3.a1*z3_1 - f3.a2*z3_2};
+            float out{y + f3.b1*z3_1 + f3.b2*z3_2};
+            z3_2 += z3_1;
+            z3_1 += y;
+
+            y = out - f3.a3*z3_3;
+            out = y + f3.b3*z3_3;
+            z3_3 += y;
+            dst3[i] = out;
+        }
+        if(MaxOrder >= 4)
+        {
+            float y{in*f4.gain - f4.a1*z4_1 - f4.a2*z4_2};
+            float out{y + f4.b1*z4_1 + f4.b2*z4_2};
+            z4_2 += z4_1;
+            z4_1 += y;
+
+            y = out - f4.a3*z4_3 - f4.a4*z4_4;
+            out = y + f4.b3*z4_3 + f4.b4*z4_4;
+            z4_4 += z4_3;
+            z4_3 += y;
+            dst4[i] = out;
+        }
+    }
+    first.z[0] = z1_1;
+    if(MaxOrder >= 2)
+    {
+        second.z[0] = z2_1;
+        second.z[1] = z2_2;
+    }
+    if(MaxOrder >= 3)
+    {
+        third.z[0] = z3_1;
+        third.z[1] = z3_2;
+        third.z[2] = z3_3;
+    }
+    if(MaxOrder >= 4)
+    {
+        fourth.z[0] = z4_1;
+        fourth.z[1] = z4_2;
+        fourth.z[2] = z4_3;
+        fourth.z[3] = z4_4;
+    }
+}
+
 } // namespace
 
 void NfcFilter::init(const float w1) noexcept
@@ -389,3 +477,15 @@ void NfcFilter::process4(float *RESTRICT dst, const float *RESTRICT src, const i
     fourth.z[2] = z3;
     fourth.z[3] = z4;
 }
+
+void NfcFilter::process(float *const *dst, const float *RESTRICT src, const int count,
+    const int maxorder)
+{
+    switch(maxorder)
+    {
+    case 1: NfcProcessOrders<1>(first, second, third, fourth, dst, src, count); break;
+    case 2: NfcProcessOrders<2>(first, second, third, fourth, dst, src, count); break;
+    case 3: NfcProcessOrders<3>(first, second, third, fourth, dst, src, count); break;
+    case 4: NfcProcessOrders<4>(first, second, third, fourth, dst, src, count); break;
+    }
+}
@@ -53,6 +53,13 @@ public:
 
     /* Near-field control filter for fourth-order ambisonic channels (16-24). */
     void process4(float *RESTRICT dst, const float *RESTRICT src, const int count);
+
+    /* Near-field control filters for first- through maxorder (up to fourth)
+     * ambisonic channels, applied to the same input in one pass. The output
+     * for each order N is written to dst[N-1].
+     */
+    void process(float *const *dst, const float *RESTRICT src, const int count,
+        const int maxorder);
 };
 
 #endif /* FILTER_NFC_H */
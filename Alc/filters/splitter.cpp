@@ -7,6 +7,10 @@
 #include <limits>
 #include <algorithm>
 
+#ifdef HAVE_SSE_INTRINSICS
+#include <xmmintrin.h>
+#endif
+
 #include "math_defs.h"
 
 template<typename Real>
@@ -94,6 +98,103 @@ void BandSplitterR<Real>::applyHfScale(Real *samples, const Real hfscale, const
     this->ap_z1 = ap_z1;
 }
 
+template<typename Real>
+void BandSplitterR<Real>::applyHfScaleMulti(BandSplitterR *splitters, Real *const *samples,
+    const Real *hfscales, const int numchans, const int count)
+{
+    for(int c{0};c < numchans;c++)
+        splitters[c].applyHfScale(samples[c], hfscales[c], count);
+}
+
+#ifdef HAVE_SSE_INTRINSICS
+/* Each sample depends on the last through the filters, so a channel can't be
+ * vectorized on its own. Instead, up to four channels are processed together
+ * with each in a vector lane, transposing blocks of four samples in and out.
+ */
+template<>
+void BandSplitterR<float>::applyHfScaleMulti(BandSplitterR *splitters, float *const *samples,
+    const float *hfscales, const int numchans, const int count)
+{
+    ASSUME(count > 0);
+
+    for(int base{0};base < numchans;base += 4)
+    {
+        const int todo_chans{mini(numchans-base, 4)};
+        if(todo_chans < 2)
+        {
+            splitters[base].applyHfScale(samples[base], hfscales[base], count);
+            break;
+        }
+
+        BandSplitterR *filters{splitters + base};
+        float *const *chans{samples + base};
+        alignas(16) float vals[5][4]{};
+        for(int l{0};l < todo_chans;l++)
+        {
+            vals[0][l] = filters[l].coeff;
+            vals[1][l] = hfscales[base+l];
+            vals[2][l] = filters[l].lp_z1;
+            vals[3][l] = filters[l].lp_z2;
+            vals[4][l] = filters[l].ap_z1;
+        }
+        const __m128 ap_coeff{_mm_load_ps(vals[0])};
+        const __m128 lp_coeff{_mm_add_ps(_mm_mul_ps(ap_coeff, _mm_set1_ps(0.5f)),
+            _mm_set1_ps(0.5f))};
+        const __m128 hfscale{_mm_load_ps(vals[1])};
+        __m128 lp_z1{_mm_load_ps(vals[2])};
+        __m128 lp_z2{_mm_load_ps(vals[3])};
+        __m128 ap_z1{_mm_load_ps(vals[4])};
+        auto proc_frame = [ap_coeff,lp_coeff,hfscale,&lp_z1,&lp_z2,&ap_z1](const __m128 in)
+            noexcept -> __m128
+        {
+            __m128 d{_mm_mul_ps(_mm_sub_ps(in, lp_z1), lp_coeff)};
+            __m128 lp_y{_mm_add_ps(lp_z1, d)};
+            lp_z1 = _mm_add_ps(lp_y, d);
+
+            d = _mm_mul_ps(_mm_sub_ps(lp_y, lp_z2), lp_coeff);
+            lp_y = _mm_add_ps(lp_z2, d);
+            lp_z2 = _mm_add_ps(lp_y, d);
+
+            const __m128 ap_y{_mm_add_ps(_mm_mul_ps(in, ap_coeff), ap_z1)};
+            ap_z1 = _mm_sub_ps(in, _mm_mul_ps(ap_y, ap_coeff));
+
+            return _mm_add_ps(_mm_mul_ps(_mm_sub_ps(ap_y, lp_y), hfscale), lp_y);
+        };
+
+        int i{0};
+        for(;count-i >= 4;i += 4)
+        {
+            __m128 f0{_mm_loadu_ps(&chans[0][i])};
+            __m128 f1{_mm_loadu_ps(&chans[1][i])};
+            __m128 f2{(todo_chans > 2) ? _mm_loadu_ps(&chans[2][i]) : _mm_setzero_ps()};
+            __m128 f3{(todo_chans > 3) ? _mm_loadu_ps(&chans[3][i]) : _mm_setzero_ps()};
+            _MM_TRANSPOSE4_PS(f0, f1, f2, f3);
+            f0 = proc_frame(f0);
+            f1 = proc_frame(f1);
+            f2 = proc_frame(f2);
+            f3 = proc_frame(f3);
+            _MM_TRANSPOSE4_PS(f0, f1, f2, f3);
+            _mm_storeu_ps(&chans[0][i], f0);
+            _mm_storeu_ps(&chans[1][i], f1);
+            if(todo_chans > 2) _mm_storeu_ps(&chans[2][i], f2);
+            if(todo_chans > 3) _mm_storeu_ps(&chans[3][i], f3);
+        }
+
+        _mm_store_ps(vals[2], lp_z1);
+        _mm_store_ps(vals[3], lp_z2);
+        _mm_store_ps(vals[4], ap_z1);
+        for(int l{0};l < todo_chans;l++)
+        {
+            filters[l].lp_z1 = vals[2][l];
+            filters[l].lp_z2 = vals[3][l];
+            filters[l].ap_z1 = vals[4][l];
+            if(i < count)
+                filters[l].applyHfScale(chans[l]+i, hfscales[base+l], count-i);
+        }
+    }
+}
+#endif
+
 template class BandSplitterR<float>;
 template class BandSplitterR<double>;
 
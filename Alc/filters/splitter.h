@@ -18,7 +18,18 @@ public:
     void clear() noexcept { lp_z1 = lp_z2 = ap_z1 = 0.0f; }
     void process(Real *hpout, Real *lpout, const Real *input, const int count);
     void applyHfScale(Real *samples, const Real hfscale, const int count);
+
+    /* Applies each splitter's HF scale to its channel, processing the
+     * channels together.
+     */
+    static void applyHfScaleMulti(BandSplitterR *splitters, Real *const *samples,
+        const Real *hfscales, const int numchans, const int count);
 };
+#ifdef HAVE_SSE_INTRINSICS
+template<>
+void BandSplitterR<float>::applyHfScaleMulti(BandSplitterR *splitters, float *const *samples,
+    const float *hfscales, const int numchans, const int count);
+#endif
 using BandSplitter = BandSplitterR<float>;
 
 /* The all-pass portion of the band splitter. Applies the same phase shift
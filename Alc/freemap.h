@@ -0,0 +1,74 @@
+#ifndef AL_FREEMAP_H
+#define AL_FREEMAP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "alnumeric.h"
+#include "vector.h"
+
+namespace al {
+
+/* A two-level bitmap of which sublists in an object table have a free entry,
+ * so a new object ID can be found without scanning every sublist. The words
+ * are stored in blocks of 65, a summary word followed by 64 words with a bit
+ * per sublist, where each summary bit marks a non-zero word in its block.
+ * Finding a free sublist checks one summary word per 4096 sublists (262144
+ * objects), then does two bit scans.
+ *
+ * Like the tables it indexes, it needs the owner's lock for all access.
+ */
+class sublist_freemap {
+    static constexpr size_t BlockSize{65};
+
+    al::vector<uint64_t> mBits;
+
+public:
+    /* Returns the index of the first sublist with a free entry, or -1 if all
+     * are full.
+     */
+    ptrdiff_t find() const noexcept
+    {
+        for(size_t base{0};base < mBits.size();base += BlockSize)
+        {
+            const uint64_t summary{mBits[base]};
+            if(!summary) continue;
+
+            const auto widx = static_cast<size_t>(CTZ64(summary));
+            const auto bidx = static_cast<size_t>(CTZ64(mBits[base + 1 + widx]));
+            return static_cast<ptrdiff_t>((base/BlockSize)<<12 | widx<<6 | bidx);
+        }
+        return -1;
+    }
+
+    /* Marks whether the given sublist has a free entry. A sublist past the end
+     * grows the map, so this may throw std::bad_alloc when marking it free.
+     */
+    void set(size_t idx, bool hasfree)
+    {
+        const size_t base{(idx>>12) * BlockSize};
+        if(base >= mBits.size())
+        {
+            if(!hasfree) return;
+            mBits.resize(base + BlockSize, 0);
+        }
+
+        const size_t widx{(idx>>6) & 63};
+        uint64_t &bits = mBits[base + 1 + widx];
+        if(hasfree)
+            bits |= 1_u64 << (idx&63);
+        else
+            bits &= ~(1_u64 << (idx&63));
+
+        if(bits)
+            mBits[base] |= 1_u64 << widx;
+        else
+            mBits[base] &= ~(1_u64 << widx);
+    }
+
+    void clear() noexcept { mBits.clear(); }
+};
+
+} // namespace al
+
+#endif /* AL_FREEMAP_H */
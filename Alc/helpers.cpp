@@ -33,6 +33,7 @@
 #include <cerrno>
 #include <cstdarg>
 #include <cctype>
+#include <cstring>
 #ifdef HAVE_MALLOC_H
 #include <malloc.h>
 #endif
@@ -113,7 +114,9 @@ DEFINE_PROPERTYKEY(PKEY_AudioEndpoint_GUID, 0x1da5d803, 0xd492, 0x4edd, 0x8c, 0x
 #endif
 
 #include <mutex>
+#include <atomic>
 #include <vector>
+#include <limits>
 #include <string>
 #include <algorithm>
 
@@ -131,12 +134,24 @@ DEFINE_PROPERTYKEY(PKEY_AudioEndpoint_GUID, 0x1da5d803, 0xd492, 0x4edd, 0x8c, 0x
 using reg_type = unsigned int;
 static inline void get_cpuid(int f, reg_type *regs)
 { __get_cpuid(f, &regs[0], &regs[1], &regs[2], &regs[3]); }
+static inline void get_cpuid_count(int f, int subf, reg_type *regs)
+{ __cpuid_count(f, subf, regs[0], regs[1], regs[2], regs[3]); }
+static inline unsigned long long get_xcr0()
+{
+    reg_type lo, hi;
+    __asm__ __volatile__("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    return (static_cast<unsigned long long>(hi)<<32) | lo;
+}
 #define CAN_GET_CPUID
 #elif defined(HAVE_CPUID_INTRINSIC) && (defined(__i386__) || defined(__x86_64__) || \
                                         defined(_M_IX86) || defined(_M_X64))
 using reg_type = int;
 static inline void get_cpuid(int f, reg_type *regs)
 { (__cpuid)(regs, f); }
+static inline void get_cpuid_count(int f, int subf, reg_type *regs)
+{ (__cpuidex)(regs, f, subf); }
+static inline unsigned long long get_xcr0()
+{ return _xgetbv(0); }
 #define CAN_GET_CPUID
 #endif
 
@@ -187,11 +202,44 @@ void FillCPUCaps(int capfilter)
                 caps |= CPU_CAP_SSE3;
             if((caps&CPU_CAP_SSE3) && (cpuinf[0].regs[2]&(1<<19)))
                 caps |= CPU_CAP_SSE4_1;
+
+            /* AVX is only usable if the OS saves the YMM registers (XCR0 bits
+             * 1 and 2), which is checkable once OSXSAVE is set.
+             */
+            const bool has_fma{(cpuinf[0].regs[2]&(1<<12)) != 0};
+            if((caps&CPU_CAP_SSE4_1) && (cpuinf[0].regs[2]&(1<<27)) &&
+               (cpuinf[0].regs[2]&(1<<28)) && (get_xcr0()&0x6) == 0x6)
+            {
+                /* AVX-512 additionally needs the opmask and upper ZMM state
+                 * saved (XCR0 bits 5 to 7).
+                 */
+                const bool os_avx512{(get_xcr0()&0xe0) == 0xe0};
+                if(has_fma)
+                    caps |= CPU_CAP_FMA;
+                if((cpuinf[0].regs[2]&(1<<29)))
+                    caps |= CPU_CAP_F16C;
+                if(maxfunc >= 7)
+                {
+                    get_cpuid_count(7, 0, cpuinf[0].regs);
+                    if((cpuinf[0].regs[1]&(1<<5)))
+                        caps |= CPU_CAP_AVX2;
+                    if(os_avx512 && (cpuinf[0].regs[1]&(1<<16)))
+                        caps |= CPU_CAP_AVX512F;
+                }
+            }
         }
     }
 #else
     /* Assume support for whatever's supported if we can't check for it */
-#if defined(HAVE_SSE4_1)
+#if defined(HAVE_AVX512)
+#warning "Assuming AVX-512F run-time support!"
+    caps |= CPU_CAP_SSE | CPU_CAP_SSE2 | CPU_CAP_SSE3 | CPU_CAP_SSE4_1 | CPU_CAP_AVX2 |
+        CPU_CAP_FMA | CPU_CAP_AVX512F;
+#elif defined(HAVE_AVX2)
+#warning "Assuming AVX2 and FMA run-time support!"
+    caps |= CPU_CAP_SSE | CPU_CAP_SSE2 | CPU_CAP_SSE3 | CPU_CAP_SSE4_1 | CPU_CAP_AVX2 |
+        CPU_CAP_FMA;
+#elif defined(HAVE_SSE4_1)
 #warning "Assuming SSE 4.1 run-time support!"
     caps |= CPU_CAP_SSE | CPU_CAP_SSE2 | CPU_CAP_SSE3 | CPU_CAP_SSE4_1;
 #elif defined(HAVE_SSE3)
@@ -204,6 +252,9 @@ void FillCPUCaps(int capfilter)
 #warning "Assuming SSE run-time support!"
     caps |= CPU_CAP_SSE;
 #endif
+#if defined(HAVE_F16C)
+    caps |= CPU_CAP_F16C;
+#endif
 #endif
 #ifdef HAVE_NEON
     FILE *file = fopen("/proc/cpuinfo", "rt");
@@ -250,11 +301,15 @@ void FillCPUCaps(int capfilter)
     }
 #endif
 
-    TRACE("Extensions:%s%s%s%s%s%s\n",
+    TRACE("Extensions:%s%s%s%s%s%s%s%s%s%s\n",
         ((capfilter&CPU_CAP_SSE)    ? ((caps&CPU_CAP_SSE)    ? " +SSE"    : " -SSE")    : ""),
         ((capfilter&CPU_CAP_SSE2)   ? ((caps&CPU_CAP_SSE2)   ? " +SSE2"   : " -SSE2")   : ""),
         ((capfilter&CPU_CAP_SSE3)   ? ((caps&CPU_CAP_SSE3)   ? " +SSE3"   : " -SSE3")   : ""),
         ((capfilter&CPU_CAP_SSE4_1) ? ((caps&CPU_CAP_SSE4_1) ? " +SSE4.1" : " -SSE4.1") : ""),
+        ((capfilter&CPU_CAP_AVX2)   ? ((caps&CPU_CAP_AVX2)   ? " +AVX2"   : " -AVX2")   : ""),
+        ((capfilter&CPU_CAP_FMA)    ? ((caps&CPU_CAP_FMA)    ? " +FMA"    : " -FMA")    : ""),
+        ((capfilter&CPU_CAP_AVX512F) ? ((caps&CPU_CAP_AVX512F) ? " +AVX512F" : " -AVX512F") : ""),
+        ((capfilter&CPU_CAP_F16C)   ? ((caps&CPU_CAP_F16C)   ? " +F16C"   : " -F16C")   : ""),
         ((capfilter&CPU_CAP_NEON)   ? ((caps&CPU_CAP_NEON)   ? " +NEON"   : " -NEON")   : ""),
         ((!capfilter) ? " -none-" : "")
     );
@@ -356,6 +411,119 @@ void *GetSymbol(void *handle, const char *name)
 }
 
 
+FileMapping MapFileToMem(const char *fname)
+{
+    std::wstring wname{utf8_to_wstr(fname)};
+    HANDLE file{CreateFileW(wname.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr)};
+    if(file == INVALID_HANDLE_VALUE)
+        return FileMapping{nullptr, 0u};
+
+    LARGE_INTEGER fsize;
+    if(!GetFileSizeEx(file, &fsize) || fsize.QuadPart <= 0 ||
+       static_cast<ULONGLONG>(fsize.QuadPart) > std::numeric_limits<size_t>::max())
+    {
+        CloseHandle(file);
+        return FileMapping{nullptr, 0u};
+    }
+
+    HANDLE fmap{CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr)};
+    CloseHandle(file);
+    if(!fmap)
+    {
+        WARN("Failed to create map for %s: %lu\n", fname, GetLastError());
+        return FileMapping{nullptr, 0u};
+    }
+
+    /* The view keeps the mapping object alive until it's unmapped. */
+    void *ptr{MapViewOfFile(fmap, FILE_MAP_READ, 0, 0, 0)};
+    CloseHandle(fmap);
+    if(!ptr)
+    {
+        WARN("Failed to map %s: %lu\n", fname, GetLastError());
+        return FileMapping{nullptr, 0u};
+    }
+
+    return FileMapping{ptr, static_cast<size_t>(fsize.QuadPart)};
+}
+
+void UnmapFileMem(const FileMapping *mapping)
+{ UnmapViewOfFile(mapping->ptr); }
+
+/* Mapped views already read ahead around page faults. */
+void PrefetchFileMem(const void*, size_t)
+{ }
+
+FileMapping MapSharedMem(const char *name)
+{
+    std::wstring wname{L"Local\\" + utf8_to_wstr(name)};
+    HANDLE fmap{OpenFileMappingW(FILE_MAP_READ, FALSE, wname.c_str())};
+    if(!fmap)
+        return FileMapping{nullptr, 0u};
+
+    void *ptr{MapViewOfFile(fmap, FILE_MAP_READ, 0, 0, 0)};
+    CloseHandle(fmap);
+    MEMORY_BASIC_INFORMATION info;
+    if(ptr && VirtualQuery(ptr, &info, sizeof(info)) != sizeof(info))
+    {
+        UnmapViewOfFile(ptr);
+        ptr = nullptr;
+    }
+    if(!ptr)
+    {
+        WARN("Failed to map %s: %lu\n", name, GetLastError());
+        return FileMapping{nullptr, 0u};
+    }
+
+    return FileMapping{ptr, info.RegionSize};
+}
+
+FileMapping CreateSharedMem(const char *name, const void *data, size_t len)
+{
+    if(len <= 8)
+        return FileMapping{nullptr, 0u};
+
+    std::wstring wname{L"Local\\" + utf8_to_wstr(name)};
+    const auto size = static_cast<ULONGLONG>(len);
+    HANDLE fmap{CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+        static_cast<DWORD>(size>>32), static_cast<DWORD>(size), wname.c_str())};
+    if(fmap && GetLastError() == ERROR_ALREADY_EXISTS)
+    {
+        CloseHandle(fmap);
+        return FileMapping{nullptr, 0u};
+    }
+    if(!fmap)
+    {
+        WARN("Failed to create %s: %lu\n", name, GetLastError());
+        return FileMapping{nullptr, 0u};
+    }
+
+    char *dst{static_cast<char*>(MapViewOfFile(fmap, FILE_MAP_WRITE, 0, 0, len))};
+    if(dst)
+    {
+        const char *src{static_cast<const char*>(data)};
+        std::copy_n(src+8, len-8, dst+8);
+        std::atomic_thread_fence(std::memory_order_release);
+        std::copy_n(src, 8, dst);
+        UnmapViewOfFile(dst);
+    }
+
+    void *ptr{dst ? MapViewOfFile(fmap, FILE_MAP_READ, 0, 0, len) : nullptr};
+    CloseHandle(fmap);
+    if(!ptr)
+    {
+        WARN("Failed to map %s: %lu\n", name, GetLastError());
+        return FileMapping{nullptr, 0u};
+    }
+
+    return FileMapping{ptr, len};
+}
+
+/* Named mappings are destroyed with their last handle or view. */
+void UnlinkSharedMem(const char*)
+{ }
+
+
 void al_print(const char *type, const char *prefix, const char *func, const char *fmt, ...)
 {
     al::vector<char> dynmsg;
@@ -473,14 +641,131 @@ al::vector<std::string> SearchDataFiles(const char *ext, const char *subdir)
     return results;
 }
 
-void SetRTPriority(void)
+std::string GetCachePath(const char *subdir, const char *fname)
+{
+    WCHAR buffer[MAX_PATH];
+    if(SHGetSpecialFolderPathW(nullptr, buffer, CSIDL_LOCAL_APPDATA, FALSE) == FALSE)
+        return std::string{};
+
+    std::string path{wstr_to_utf8(buffer)};
+    if(!is_slash(path.back()))
+        path += '\\';
+    path += subdir;
+    if(!is_slash(path.back()))
+        path += '\\';
+    path += fname;
+    std::replace(path.begin(), path.end(), '/', '\\');
+    return path;
+}
+
+bool CreateParentDirs(const std::string &path)
+{
+    std::wstring wpath{utf8_to_wstr(path.c_str())};
+    for(size_t pos{wpath.find('\\', 3)};pos != std::wstring::npos;pos = wpath.find('\\', pos+1))
+    {
+        std::wstring dir{wpath.substr(0, pos)};
+        if(!CreateDirectoryW(dir.c_str(), nullptr) && GetLastError() != ERROR_ALREADY_EXISTS)
+        {
+            ERR("Failed to create directory %s: error %lu\n", wstr_to_utf8(dir.c_str()).c_str(),
+                GetLastError());
+            return false;
+        }
+    }
+    return true;
+}
+
+bool StoreCacheFile(const std::string &path, const void *data, size_t len)
+{
+    std::wstring wpath{utf8_to_wstr(path.c_str())};
+
+    if(!CreateParentDirs(path))
+        return false;
+
+    /* Write to a temporary file first, and move it into place once complete,
+     * so nothing sees a partially written file.
+     */
+    std::wstring wtmp{wpath + L"." + std::to_wstring(GetCurrentProcessId()) + L".tmp"};
+    HANDLE file{CreateFileW(wtmp.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_NEW,
+        FILE_ATTRIBUTE_NORMAL, nullptr)};
+    if(file == INVALID_HANDLE_VALUE)
+    {
+        ERR("Could not create %s: error %lu\n", wstr_to_utf8(wtmp.c_str()).c_str(),
+            GetLastError());
+        return false;
+    }
+
+    const char *ptr{static_cast<const char*>(data)};
+    bool ok{true};
+    while(ok && len > 0)
+    {
+        DWORD todo{static_cast<DWORD>(minz(len, 1u<<30))};
+        DWORD written{0};
+        ok = WriteFile(file, ptr, todo, &written, nullptr) && written > 0;
+        ptr += written;
+        len -= written;
+    }
+    CloseHandle(file);
+
+    if(!ok || !MoveFileExW(wtmp.c_str(), wpath.c_str(), MOVEFILE_REPLACE_EXISTING))
+    {
+        ERR("Failed to write %s: error %lu\n", path.c_str(), GetLastError());
+        DeleteFileW(wtmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+namespace {
+
+void SetThreadAttribs(const al::vector<unsigned int> &cpus)
 {
     bool failed = false;
     if(RTPrioLevel > 0)
         failed = !SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL);
     if(failed) ERR("Failed to set priority level for thread\n");
+
+    if(!cpus.empty())
+    {
+        DWORD_PTR mask{0};
+        for(unsigned int cpu : cpus)
+        {
+            if(cpu < sizeof(mask)*8)
+                mask |= DWORD_PTR{1} << cpu;
+        }
+        if(!mask || !SetThreadAffinityMask(GetCurrentThread(), mask))
+            ERR("Failed to set thread affinity: error %lu\n", GetLastError());
+    }
+
+    /* Registering with MMCSS lets the system schedule the thread as a
+     * multimedia task (e.g. "Pro Audio"), with a boosted priority that's
+     * still bounded so it can't starve the system.
+     */
+    if(!MMCSSTask.empty())
+    {
+        using AvSetMmThreadCharacteristicsW_t = HANDLE(WINAPI*)(LPCWSTR, LPDWORD);
+        static const auto AvSetMmThreadCharacteristicsW_ = []() -> AvSetMmThreadCharacteristicsW_t
+        {
+            HMODULE avrt{LoadLibraryW(L"avrt.dll")};
+            if(!avrt) return nullptr;
+            return reinterpret_cast<AvSetMmThreadCharacteristicsW_t>(
+                GetProcAddress(avrt, "AvSetMmThreadCharacteristicsW"));
+        }();
+
+        std::wstring task{utf8_to_wstr(MMCSSTask.c_str())};
+        DWORD taskidx{0};
+        if(!AvSetMmThreadCharacteristicsW_ || !AvSetMmThreadCharacteristicsW_(task.c_str(), &taskidx))
+            ERR("Failed to register with MMCSS task \"%s\"\n", MMCSSTask.c_str());
+    }
 }
 
+} // namespace
+
+void SetRTPriority(void)
+{ SetThreadAttribs(MixerCPUs); }
+
+void SetWorkerRTPriority(void)
+{ SetThreadAttribs(WorkerCPUs); }
+
 #else
 
 const PathNamePair &GetProcBinary()
@@ -567,6 +852,135 @@ const PathNamePair &GetProcBinary()
 }
 
 
+FileMapping MapFileToMem(const char *fname)
+{
+    int fd{open(fname, O_RDONLY, 0)};
+    if(fd == -1)
+        return FileMapping{nullptr, 0u};
+
+    struct stat sbuf;
+    if(fstat(fd, &sbuf) == -1 || sbuf.st_size <= 0 ||
+       static_cast<unsigned long long>(sbuf.st_size) > std::numeric_limits<size_t>::max())
+    {
+        close(fd);
+        return FileMapping{nullptr, 0u};
+    }
+
+    /* The mapping remains valid after the descriptor is closed. */
+    const auto len = static_cast<size_t>(sbuf.st_size);
+    void *ptr{mmap(nullptr, len, PROT_READ, MAP_SHARED, fd, 0)};
+    close(fd);
+    if(ptr == MAP_FAILED)
+    {
+        WARN("Failed to map %s: %s (%d)\n", fname, strerror(errno), errno);
+        return FileMapping{nullptr, 0u};
+    }
+
+    return FileMapping{ptr, len};
+}
+
+void UnmapFileMem(const FileMapping *mapping)
+{ munmap(mapping->ptr, mapping->len); }
+
+void PrefetchFileMem(const void *ptr, size_t len)
+{
+#ifdef HAVE_POSIX_MADVISE
+    /* The advised range has to start on a page boundary. */
+    static const auto pagesize = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+    const auto start = reinterpret_cast<uintptr_t>(ptr);
+    const uintptr_t base{start & ~(pagesize-1)};
+    posix_madvise(reinterpret_cast<void*>(base), len + (start-base), POSIX_MADV_WILLNEED);
+#else
+    (void)ptr; (void)len;
+#endif
+}
+
+#ifdef HAVE_SHM_OPEN
+
+FileMapping MapSharedMem(const char *name)
+{
+    const std::string shmname{std::string{"/"} + name};
+    int fd{shm_open(shmname.c_str(), O_RDONLY, 0)};
+    if(fd == -1)
+        return FileMapping{nullptr, 0u};
+
+    struct stat sbuf;
+    if(fstat(fd, &sbuf) == -1 || sbuf.st_size <= 0 ||
+       static_cast<unsigned long long>(sbuf.st_size) > std::numeric_limits<size_t>::max())
+    {
+        close(fd);
+        return FileMapping{nullptr, 0u};
+    }
+
+    const auto len = static_cast<size_t>(sbuf.st_size);
+    void *ptr{mmap(nullptr, len, PROT_READ, MAP_SHARED, fd, 0)};
+    close(fd);
+    if(ptr == MAP_FAILED)
+    {
+        WARN("Failed to map %s: %s (%d)\n", name, strerror(errno), errno);
+        return FileMapping{nullptr, 0u};
+    }
+
+    return FileMapping{ptr, len};
+}
+
+FileMapping CreateSharedMem(const char *name, const void *data, size_t len)
+{
+    if(len <= 8 || static_cast<unsigned long long>(len) >
+        static_cast<unsigned long long>(std::numeric_limits<off_t>::max()))
+        return FileMapping{nullptr, 0u};
+
+    const std::string shmname{std::string{"/"} + name};
+    int fd{shm_open(shmname.c_str(), O_RDWR|O_CREAT|O_EXCL, 0644)};
+    if(fd == -1)
+    {
+        if(errno != EEXIST)
+            WARN("Failed to create %s: %s (%d)\n", name, strerror(errno), errno);
+        return FileMapping{nullptr, 0u};
+    }
+
+    void *ptr{MAP_FAILED};
+    if(ftruncate(fd, static_cast<off_t>(len)) == 0)
+        ptr = mmap(nullptr, len, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if(ptr == MAP_FAILED)
+    {
+        WARN("Failed to map %s: %s (%d)\n", name, strerror(errno), errno);
+        shm_unlink(shmname.c_str());
+        return FileMapping{nullptr, 0u};
+    }
+
+    const char *src{static_cast<const char*>(data)};
+    char *dst{static_cast<char*>(ptr)};
+    std::copy_n(src+8, len-8, dst+8);
+    std::atomic_thread_fence(std::memory_order_release);
+    std::copy_n(src, 8, dst);
+    mprotect(ptr, len, PROT_READ);
+
+    return FileMapping{ptr, len};
+}
+
+void UnlinkSharedMem(const char *name)
+{
+    const std::string shmname{std::string{"/"} + name};
+    if(shm_unlink(shmname.c_str()) == -1 && errno != ENOENT)
+        WARN("Failed to unlink %s: %s (%d)\n", name, strerror(errno), errno);
+}
+
+#else
+
+FileMapping MapSharedMem(const char*)
+{ return FileMapping{nullptr, 0u}; }
+
+FileMapping CreateSharedMem(const char*, const void*, size_t)
+{ return FileMapping{nullptr, 0u}; }
+
+void UnlinkSharedMem(const char*)
+{ }
+
+#endif /* HAVE_SHM_OPEN */
+
+
 #ifdef HAVE_DLFCN_H
 
 void *LoadLib(const char *name)
@@ -719,17 +1133,106 @@ al::vector<std::string> SearchDataFiles(const char *ext, const char *subdir)
     return results;
 }
 
-void SetRTPriority()
+std::string GetCachePath(const char *subdir, const char *fname)
+{
+    std::string path;
+    const char *str{getenv("XDG_CACHE_HOME")};
+    if(str && str[0] != '\0')
+    {
+        path = str;
+        if(path.back() != '/')
+            path += '/';
+    }
+    else if((str=getenv("HOME")) != nullptr && str[0] != '\0')
+    {
+        path = str;
+        if(path.back() == '/')
+            path.pop_back();
+        path += "/.cache/";
+    }
+    else
+        return path;
+
+    path += subdir;
+    if(path.back() != '/')
+        path += '/';
+    path += fname;
+    return path;
+}
+
+bool CreateParentDirs(const std::string &path)
+{
+    for(size_t pos{path.find('/', 1)};pos != std::string::npos;pos = path.find('/', pos+1))
+    {
+        std::string dir{path.substr(0, pos)};
+        if(mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST)
+        {
+            ERR("Failed to create directory %s: %s\n", dir.c_str(), strerror(errno));
+            return false;
+        }
+    }
+    return true;
+}
+
+bool StoreCacheFile(const std::string &path, const void *data, size_t len)
+{
+    if(!CreateParentDirs(path))
+        return false;
+
+    /* Write to a temporary file first, and rename it into place once
+     * complete, so nothing sees a partially written file.
+     */
+    std::string tmppath{path + "." + std::to_string(getpid()) + ".tmp"};
+    int fd{open(tmppath.c_str(), O_WRONLY|O_CREAT|O_EXCL, 0644)};
+    if(fd == -1)
+    {
+        ERR("Could not create %s: %s\n", tmppath.c_str(), strerror(errno));
+        return false;
+    }
+
+    const char *ptr{static_cast<const char*>(data)};
+    bool ok{true};
+    while(ok && len > 0)
+    {
+        ssize_t written{write(fd, ptr, len)};
+        if(written < 0 && errno == EINTR)
+            continue;
+        ok = (written > 0);
+        if(ok)
+        {
+            ptr += written;
+            len -= static_cast<size_t>(written);
+        }
+    }
+    if(close(fd) != 0)
+        ok = false;
+
+    if(!ok || rename(tmppath.c_str(), path.c_str()) != 0)
+    {
+        ERR("Failed to write %s: %s\n", path.c_str(), strerror(errno));
+        unlink(tmppath.c_str());
+        return false;
+    }
+    return true;
+}
+
+namespace {
+
+void SetThreadAttribs(const al::vector<unsigned int> &cpus)
 {
     bool failed = false;
 #if defined(HAVE_PTHREAD_SETSCHEDPARAM) && !defined(__OpenBSD__)
     if(RTPrioLevel > 0)
     {
+        /* Level 1 is the policy's minimum real-time priority (on Linux this
+         * should be 1), with higher levels going up from there.
+         */
+        const int policy{RTPrioFIFO ? SCHED_FIFO : SCHED_RR};
+        const int minprio{sched_get_priority_min(policy)};
+        const int maxprio{sched_get_priority_max(policy)};
         struct sched_param param;
-        /* Use the minimum real-time priority possible for now (on Linux this
-         * should be 1 for SCHED_RR) */
-        param.sched_priority = sched_get_priority_min(SCHED_RR);
-        failed = !!pthread_setschedparam(pthread_self(), SCHED_RR, &param);
+        param.sched_priority = clampi(minprio + RTPrioLevel-1, minprio, maxprio);
+        failed = !!pthread_setschedparam(pthread_self(), policy, &param);
     }
 #else
     /* Real-time priority not available */
@@ -737,6 +1240,31 @@ void SetRTPriority()
 #endif
     if(failed)
         ERR("Failed to set priority level for thread\n");
+
+    if(!cpus.empty())
+    {
+#ifdef HAVE_PTHREAD_SETAFFINITY_NP
+        cpu_set_t cpuset;
+        CPU_ZERO(&cpuset);
+        for(unsigned int cpu : cpus)
+        {
+            if(cpu < CPU_SETSIZE)
+                CPU_SET(cpu, &cpuset);
+        }
+        if(int err{pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset)})
+            ERR("Failed to set thread affinity: %s\n", strerror(err));
+#else
+        ERR("Thread affinity not supported\n");
+#endif
+    }
 }
 
+} // namespace
+
+void SetRTPriority()
+{ SetThreadAttribs(MixerCPUs); }
+
+void SetWorkerRTPriority()
+{ SetThreadAttribs(WorkerCPUs); }
+
 #endif
@@ -23,6 +23,7 @@
 #include <stdlib.h>
 #include <ctype.h>
 
+#include <cmath>
 #include <mutex>
 #include <array>
 #include <vector>
@@ -40,18 +41,44 @@
 #include "hrtf.h"
 #include "alconfig.h"
 #include "filters/splitter.h"
+#include "polyphase_resampler.h"
 
 #include "compat.h"
 #include "almalloc.h"
 
 
 struct HrtfHandle {
-    std::unique_ptr<HrtfEntry> entry;
+    /* The data set is loaded separately for each sample rate it's used at. */
+    struct Loaded {
+        std::unique_ptr<HrtfEntry> entry;
+        /* Set when the entry is the data set at its stored sample rate. */
+        bool native;
+        /* Set when the entry references its data set directly from a mapped
+         * file, which must stay mapped as long as the entry is loaded.
+         */
+        FileMapping mapping;
+        /* The name of the shared memory copy this process created for the
+         * entry, if any, removed when the entry is unloaded.
+         */
+        std::string shmname;
+    };
+    al::vector<Loaded> loaded;
     al::FlexArray<char> filename;
 
     HrtfHandle(size_t fname_len) : filename{fname_len} { }
     HrtfHandle(const HrtfHandle&) = delete;
     HrtfHandle& operator=(const HrtfHandle&) = delete;
+    ~HrtfHandle()
+    {
+        for(Loaded &hrtf : loaded)
+        {
+            hrtf.entry = nullptr;
+            if(hrtf.mapping.ptr)
+                UnmapFileMem(&hrtf.mapping);
+            if(!hrtf.shmname.empty())
+                UnlinkSharedMem(hrtf.shmname.c_str());
+        }
+    }
 
     static std::unique_ptr<HrtfHandle> Create(size_t fname_len);
     static constexpr size_t Sizeof(size_t length) noexcept
@@ -99,11 +126,32 @@ using HrtfHandlePtr = std::unique_ptr<HrtfHandle>;
 constexpr ALchar magicMarker00[8]{'M','i','n','P','H','R','0','0'};
 constexpr ALchar magicMarker01[8]{'M','i','n','P','H','R','0','1'};
 constexpr ALchar magicMarker02[8]{'M','i','n','P','H','R','0','2'};
+constexpr ALchar magicMarker03[8]{'M','i','n','P','H','R','0','3'};
 
 /* First value for pass-through coefficients (remaining are 0), used for omni-
  * directional sounds. */
 constexpr ALfloat PassthruCoeff{0.707106781187f/*sqrt(0.5)*/};
 
+/* B-Format HRTF filters that have been built, so a device reset using the
+ * same HRTF and decoder can copy them instead of building them again. The
+ * decoder's tables are static, so they're identified by address. Entries are
+ * removed when the HRTF they were built from is freed, so this is defined
+ * before LoadedHrtfs to outlive it.
+ */
+struct BFormatHrtfFilters {
+    const HrtfEntry *hrtf;
+    const AngularPoint *points;
+    const ALfloat (*matrix)[MAX_AMBI_CHANNELS];
+    size_t count;
+    const ALfloat *hfgain;
+    ALsizei numchans;
+
+    ALsizei irsize;
+    al::vector<HrirArray<ALfloat>> coeffs;
+};
+std::mutex BFormatFiltersLock;
+al::vector<BFormatHrtfFilters> BFormatFilters;
+
 std::mutex LoadedHrtfLock;
 al::vector<HrtfHandlePtr> LoadedHrtfs;
 
@@ -201,30 +249,77 @@ IdxBlend CalcAzIndex(ALsizei azcount, ALfloat az)
     return IdxBlend{idx%azcount, az-idx};
 }
 
-} // namespace
-
+/* Blending weights of the cached coefficients are quantized to this many
+ * steps between HRIRs, so nearby directions can share them.
+ */
+constexpr ALfloat CacheBlendSteps{32.0f};
 
-/* Calculates static HRIR coefficients and delays for the given polar elevation
- * and azimuth in radians. The coefficients are normalized.
+/* The HRIRs to blend for a given direction, with the elevation and azimuth
+ * blending weights between them.
  */
-void GetHrtfCoeffs(const HrtfEntry *Hrtf, ALfloat elevation, ALfloat azimuth, ALfloat distance,
-    ALfloat spread, HrirArray<ALfloat> &coeffs, ALsizei (&delays)[2])
-{
-    const ALfloat dirfact{1.0f - (spread / al::MathDefs<float>::Tau())};
+struct HrirBlend {
+    ALsizei idx[4];
+    ALfloat evblend;
+    ALfloat azblend[2];
+    ALfloat dirfact;
+
+    void quantize(ALushort (&steps)[3]) noexcept
+    {
+        evblend = std::round(evblend*CacheBlendSteps);
+        azblend[0] = std::round(azblend[0]*CacheBlendSteps);
+        azblend[1] = std::round(azblend[1]*CacheBlendSteps);
+        steps[0] = static_cast<ALushort>(evblend);
+        steps[1] = static_cast<ALushort>(azblend[0]);
+        steps[2] = static_cast<ALushort>(azblend[1]);
+        evblend /= CacheBlendSteps;
+        azblend[0] /= CacheBlendSteps;
+        azblend[1] /= CacheBlendSteps;
+    }
+};
+
+/* The fields to blend for a given distance. */
+struct FieldBlend {
+    /* The farther and nearer field, and the offset of their first elevation. */
+    ALsizei idx[2];
+    ALsizei evbase[2];
+    /* Blending weight of the nearer field. When 0, only the first is used. */
+    ALfloat blend;
+};
 
-    const auto *field = Hrtf->field;
-    const auto *field_end = field + Hrtf->fdCount-1;
+FieldBlend CalcFieldBlend(const HrtfEntry *Hrtf, ALfloat distance)
+{
+    /* Find the farthest field that isn't farther than the given distance, or
+     * the nearest if they all are.
+     */
+    const ALsizei fdlast{Hrtf->fdCount-1};
+    ALsizei fdidx{0};
     ALsizei fdoffset{Hrtf->evFarBase};
-    while(distance < field->distance && field != field_end)
+    while(distance < Hrtf->field[fdidx].distance && fdidx != fdlast)
     {
-        ++field;
-        fdoffset -= field->evCount;
+        ++fdidx;
+        fdoffset -= Hrtf->field[fdidx].evCount;
     }
     assert(fdoffset >= 0);
 
+    /* Beyond the farthest or within the nearest field, only the one is used.
+     * Otherwise blend with the farther field by distance.
+     */
+    if(fdidx == 0 || !(distance > Hrtf->field[fdidx].distance))
+        return FieldBlend{{fdidx, fdidx}, {fdoffset, fdoffset}, 0.0f};
+
+    const HrtfEntry::Field &farfield = Hrtf->field[fdidx-1];
+    const HrtfEntry::Field &nearfield = Hrtf->field[fdidx];
+    const ALfloat blend{(farfield.distance-distance) / (farfield.distance-nearfield.distance)};
+    return FieldBlend{{fdidx-1, fdidx}, {fdoffset + nearfield.evCount, fdoffset},
+        clampf(blend, 0.0f, 1.0f)};
+}
+
+HrirBlend CalcHrirBlend(const HrtfEntry *Hrtf, const ALsizei evcount, const ALsizei fdoffset,
+    ALfloat elevation, ALfloat azimuth, ALfloat spread)
+{
     /* Claculate the elevation indinces. */
-    const auto elev0 = CalcEvIndex(field->evCount, elevation);
-    const ALsizei elev1_idx{mini(elev0.idx+1, field->evCount-1)};
+    const auto elev0 = CalcEvIndex(evcount, elevation);
+    const ALsizei elev1_idx{mini(elev0.idx+1, evcount-1)};
     const ALsizei ev0offset{Hrtf->evOffset[fdoffset + elev0.idx]};
     const ALsizei ev1offset{Hrtf->evOffset[fdoffset + elev1_idx]};
 
@@ -233,22 +328,37 @@ void GetHrtfCoeffs(const HrtfEntry *Hrtf, ALfloat elevation, ALfloat azimuth, AL
     const auto az1 = CalcAzIndex(Hrtf->azCount[fdoffset + elev1_idx], azimuth);
 
     /* Calculate the HRIR indices to blend. */
-    ALsizei idx[4]{
-        ev0offset + az0.idx,
-        ev0offset + ((az0.idx+1) % Hrtf->azCount[fdoffset + elev0.idx]),
-        ev1offset + az1.idx,
-        ev1offset + ((az1.idx+1) % Hrtf->azCount[fdoffset + elev1_idx])
+    return HrirBlend{
+        { ev0offset + az0.idx,
+          ev0offset + ((az0.idx+1) % Hrtf->azCount[fdoffset + elev0.idx]),
+          ev1offset + az1.idx,
+          ev1offset + ((az1.idx+1) % Hrtf->azCount[fdoffset + elev1_idx]) },
+        elev0.blend, { az0.blend, az1.blend },
+        1.0f - (spread / al::MathDefs<float>::Tau())
     };
+}
 
+HrirBlend CalcHrirBlend(const HrtfEntry *Hrtf, const FieldBlend &fields, const size_t which,
+    ALfloat elevation, ALfloat azimuth, ALfloat spread)
+{
+    return CalcHrirBlend(Hrtf, Hrtf->field[fields.idx[which]].evCount, fields.evbase[which],
+        elevation, azimuth, spread);
+}
+
+void BlendHrirs(const HrtfEntry *Hrtf, const HrirBlend &hrir, HrirArray<ALfloat> &coeffs,
+    ALsizei (&delays)[2])
+{
     /* Calculate bilinear blending weights, attenuated according to the
      * directional panning factor.
      */
+    const ALfloat dirfact{hrir.dirfact};
     const ALfloat blend[4]{
-        (1.0f-elev0.blend) * (1.0f-az0.blend) * dirfact,
-        (1.0f-elev0.blend) * (     az0.blend) * dirfact,
-        (     elev0.blend) * (1.0f-az1.blend) * dirfact,
-        (     elev0.blend) * (     az1.blend) * dirfact
+        (1.0f-hrir.evblend) * (1.0f-hrir.azblend[0]) * dirfact,
+        (1.0f-hrir.evblend) * (     hrir.azblend[0]) * dirfact,
+        (     hrir.evblend) * (1.0f-hrir.azblend[1]) * dirfact,
+        (     hrir.evblend) * (     hrir.azblend[1]) * dirfact
     };
+    ALsizei idx[4]{hrir.idx[0], hrir.idx[1], hrir.idx[2], hrir.idx[3]};
 
     /* Calculate the blended HRIR delays. */
     delays[0] = fastf2i(
@@ -274,6 +384,12 @@ void GetHrtfCoeffs(const HrtfEntry *Hrtf, ALfloat elevation, ALfloat azimuth, AL
     coeffout[0] = PassthruCoeff * (1.0f-dirfact);
     coeffout[1] = PassthruCoeff * (1.0f-dirfact);
     std::fill(coeffout+2, coeffout + irSize*2, 0.0f);
+    if(Hrtf->coeffsHalf)
+    {
+        for(ALsizei c{0};c < 4;c++)
+            BlendHalfSamples(coeffout, Hrtf->coeffsHalf[idx[c]], blend[c], irSize*2);
+        return;
+    }
     for(ALsizei c{0};c < 4;c++)
     {
         const ALfloat *srccoeffs{al::assume_aligned<16>(Hrtf->coeffs[idx[c]])};
@@ -285,6 +401,172 @@ void GetHrtfCoeffs(const HrtfEntry *Hrtf, ALfloat elevation, ALfloat azimuth, AL
     }
 }
 
+void CopyHrtfParams(HrtfParams &dst, const HrtfParams &src, const ALsizei irSize)
+{
+    std::copy_n(src.Coeffs.cbegin(), irSize, dst.Coeffs.begin());
+    dst.Delay[0] = src.Delay[0];
+    dst.Delay[1] = src.Delay[1];
+}
+
+/* Blends the farther field's coefficients, already in coeffs, with the nearer
+ * field's.
+ */
+void BlendFieldCoeffs(HrirArray<ALfloat> &coeffs, const HrirArray<ALfloat> &nearcoeffs,
+    const ALsizei irSize, const ALfloat blend)
+{
+    auto blend_coeffs = [blend](const float2 &farval, const float2 &nearval) noexcept -> float2
+    { return float2{{lerp(farval[0], nearval[0], blend), lerp(farval[1], nearval[1], blend)}}; };
+    std::transform(coeffs.cbegin(), coeffs.cbegin()+irSize, nearcoeffs.cbegin(),
+        coeffs.begin(), blend_coeffs);
+}
+
+void BlendFieldDelays(ALsizei (&delays)[2], const ALsizei (&neardelays)[2], const ALfloat blend)
+{
+    delays[0] = fastf2i(lerp(static_cast<ALfloat>(delays[0]),
+        static_cast<ALfloat>(neardelays[0]), blend));
+    delays[1] = fastf2i(lerp(static_cast<ALfloat>(delays[1]),
+        static_cast<ALfloat>(neardelays[1]), blend));
+}
+
+/* Finds the coefficients for the given (quantized) blend in the cache, or
+ * calculates and stores them if they're not there. The cache must be locked.
+ */
+const HrtfParams &GetCachedParams(const HrtfEntry *Hrtf, HrtfCoeffCache *cache,
+    const HrirBlend &hrir, const HrtfCoeffCache::Key &key)
+{
+    auto entry = std::find_if(cache->mEntries.begin(), cache->mEntries.begin()+cache->mNumUsed,
+        [&key](const HrtfCoeffCache::Entry &entry) noexcept -> bool
+        { return entry.mKey == key; });
+    if(entry == cache->mEntries.begin()+cache->mNumUsed)
+    {
+        /* Not cached. Use an unused entry if there is one, otherwise replace
+         * the least recently used. Entries always hold the full HRIRs,
+         * whatever the request needs.
+         */
+        if(static_cast<size_t>(cache->mNumUsed) < cache->mEntries.size())
+            ++cache->mNumUsed;
+        else
+            entry = std::min_element(cache->mEntries.begin(), cache->mEntries.end(),
+                [](const HrtfCoeffCache::Entry &lhs, const HrtfCoeffCache::Entry &rhs) noexcept
+                -> bool { return lhs.mLastUse < rhs.mLastUse; });
+
+        entry->mKey = key;
+        BlendHrirs(Hrtf, hrir, entry->mParams.Coeffs, entry->mParams.Delay);
+    }
+    entry->mLastUse = ++cache->mUseCount;
+    return entry->mParams;
+}
+
+} // namespace
+
+
+/* Calculates static HRIR coefficients and delays for the given polar elevation
+ * and azimuth in radians. The coefficients are normalized.
+ */
+void GetHrtfCoeffs(const HrtfEntry *Hrtf, ALfloat elevation, ALfloat azimuth, ALfloat distance,
+    ALfloat spread, HrirArray<ALfloat> &coeffs, ALsizei (&delays)[2])
+{
+    const FieldBlend fields{CalcFieldBlend(Hrtf, distance)};
+    BlendHrirs(Hrtf, CalcHrirBlend(Hrtf, fields, 0, elevation, azimuth, spread), coeffs,
+        delays);
+    if(fields.blend > 0.0f)
+    {
+        HrirArray<ALfloat> nearcoeffs;
+        ALsizei neardelays[2];
+        BlendHrirs(Hrtf, CalcHrirBlend(Hrtf, fields, 1, elevation, azimuth, spread),
+            nearcoeffs, neardelays);
+        BlendFieldCoeffs(coeffs, nearcoeffs, Hrtf->irSize, fields.blend);
+        BlendFieldDelays(delays, neardelays, fields.blend);
+    }
+}
+
+void GetHrtfParams(const HrtfEntry *Hrtf, HrtfCoeffCache *cache, ALfloat elevation,
+    ALfloat azimuth, ALfloat distance, ALfloat spread, const ALsizei irSize,
+    HrtfParams &params)
+{
+    const bool truncate{irSize < Hrtf->irSize};
+    const ALsizei outsize{truncate ? irSize : Hrtf->irSize};
+
+    /* Between two fields, each field's coefficients are calculated (or looked
+     * up) for the direction on their own and blended by distance. So with the
+     * cache, a change in distance alone only needs the blend redone.
+     */
+    const FieldBlend fields{CalcFieldBlend(Hrtf, distance)};
+    const size_t numfields{(fields.blend > 0.0f) ? 2u : 1u};
+    HrirBlend hrir[2]{
+        CalcHrirBlend(Hrtf, fields, 0, elevation, azimuth, spread),
+        CalcHrirBlend(Hrtf, fields, numfields-1, elevation, azimuth, spread)
+    };
+
+    HrtfCoeffCache::Key keys[2]{};
+    if(cache)
+    {
+        for(size_t i{0};i < numfields;++i)
+        {
+            keys[i] = HrtfCoeffCache::Key{{hrir[i].idx[0], hrir[i].idx[2]}, {},
+                hrir[i].dirfact};
+            hrir[i].quantize(keys[i].Steps);
+        }
+    }
+
+    /* Voices may be updated on multiple mixer threads. Rather than wait for
+     * another to finish with the cache, calculate the coefficients without it.
+     */
+    if(!cache || cache->mLock.test_and_set(std::memory_order_acquire))
+    {
+        BlendHrirs(Hrtf, hrir[0], params.Coeffs, params.Delay);
+        if(numfields > 1)
+        {
+            HrirArray<ALfloat> nearcoeffs;
+            ALsizei neardelays[2];
+            BlendHrirs(Hrtf, hrir[1], nearcoeffs, neardelays);
+            BlendFieldCoeffs(params.Coeffs, nearcoeffs, Hrtf->irSize, fields.blend);
+            BlendFieldDelays(params.Delay, neardelays, fields.blend);
+        }
+    }
+    else
+    {
+        CopyHrtfParams(params, GetCachedParams(Hrtf, cache, hrir[0], keys[0]), outsize);
+        if(numfields > 1)
+        {
+            const HrtfParams &nearparams = GetCachedParams(Hrtf, cache, hrir[1], keys[1]);
+            BlendFieldCoeffs(params.Coeffs, nearparams.Coeffs, outsize, fields.blend);
+            BlendFieldDelays(params.Delay, nearparams.Delay, fields.blend);
+        }
+        cache->mLock.clear(std::memory_order_release);
+    }
+
+    if(!truncate)
+    {
+        params.IrSize = Hrtf->irSize;
+        return;
+    }
+
+    /* The HRIRs are minimum-phase, with most of their energy at the start, so
+     * a shorter filter only loses some of the low-level tail. Taper off the
+     * last quarter of what's kept to avoid an abrupt cutoff.
+     */
+    ASSUME(irSize >= 4 && irSize <= HRTF_LOD_MAX_SIZE);
+    const ALsizei taper{irSize / 4};
+    for(ALsizei i{0};i < taper;++i)
+    {
+        const ALfloat w{0.5f + 0.5f*std::cos(al::MathDefs<float>::Pi() *
+            static_cast<ALfloat>(i+1) / static_cast<ALfloat>(taper+1))};
+        params.Coeffs[irSize-taper+i][0] *= w;
+        params.Coeffs[irSize-taper+i][1] *= w;
+    }
+    std::fill(params.Coeffs.begin()+irSize, params.Coeffs.begin()+Hrtf->irSize, float2{});
+    params.IrSize = irSize;
+}
+
+
+std::unique_ptr<HrtfCoeffCache> HrtfCoeffCache::Create(size_t num_entries)
+{
+    void *ptr{al_calloc(16, HrtfCoeffCache::Sizeof(num_entries))};
+    return std::unique_ptr<HrtfCoeffCache>{new (ptr) HrtfCoeffCache{num_entries}};
+}
+
+
 
 std::unique_ptr<DirectHrtfState> DirectHrtfState::Create(size_t num_chans)
 {
@@ -306,6 +588,25 @@ void BuildBFormatHrtf(const HrtfEntry *Hrtf, DirectHrtfState *state, const ALsiz
     ASSUME(NumChannels > 0);
     ASSUME(AmbiCount > 0);
 
+    auto match_filters = [Hrtf,NumChannels,AmbiPoints,AmbiMatrix,AmbiCount,AmbiOrderHFGain](const BFormatHrtfFilters &filters) noexcept -> bool
+    {
+        return filters.hrtf == Hrtf && filters.numchans == NumChannels &&
+            filters.points == AmbiPoints && filters.matrix == AmbiMatrix &&
+            filters.count == AmbiCount && filters.hfgain == AmbiOrderHFGain;
+    };
+    {
+        std::lock_guard<std::mutex> _{BFormatFiltersLock};
+        auto iter = std::find_if(BFormatFilters.cbegin(), BFormatFilters.cend(), match_filters);
+        if(iter != BFormatFilters.cend())
+        {
+            for(ALsizei i{0};i < NumChannels;++i)
+                state->Chan[i].Coeffs = iter->coeffs[static_cast<size_t>(i)];
+            state->IrSize = iter->irsize;
+            TRACE("Using cached B-Format HRTF filters, FIR length: %d\n", iter->irsize);
+            return;
+        }
+    }
+
     auto &field = Hrtf->field[0];
     const ALsizei ebase{Hrtf->evFarBase};
     ALsizei min_delay{HRTF_HISTORY_LENGTH};
@@ -346,9 +647,22 @@ void BuildBFormatHrtf(const HrtfEntry *Hrtf, DirectHrtfState *state, const ALsiz
 
     auto tmpres = al::vector<HrirArray<ALdouble>>(NumChannels);
     auto tmpfilt = al::vector<std::array<ALdouble,HRIR_LENGTH*4>>(3);
+    HrirArray<ALfloat> tmpfir;
     for(size_t c{0u};c < AmbiCount;++c)
     {
-        const ALfloat (*fir)[2]{&Hrtf->coeffs[idx[c] * Hrtf->irSize]};
+        const ALfloat (*fir)[2]{};
+        if(!Hrtf->coeffsHalf)
+            fir = &Hrtf->coeffs[idx[c] * Hrtf->irSize];
+        else
+        {
+            const ALushort (*src)[2]{&Hrtf->coeffsHalf[idx[c] * Hrtf->irSize]};
+            for(ALsizei i{0};i < Hrtf->irSize;++i)
+            {
+                tmpfir[i][0] = half2float(src[i][0]);
+                tmpfir[i][1] = half2float(src[i][1]);
+            }
+            fir = &reinterpret_cast<ALfloat(&)[2]>(tmpfir[0]);
+        }
         const ALsizei ldelay{Hrtf->delays[idx[c]][0] - min_delay + base_delay};
         const ALsizei rdelay{Hrtf->delays[idx[c]][1] - min_delay + base_delay};
 
@@ -455,6 +769,20 @@ void BuildBFormatHrtf(const HrtfEntry *Hrtf, DirectHrtfState *state, const ALsiz
     TRACE("Skipped delay: %d, max delay: %d, new FIR length: %d\n",
           min_delay, max_delay-min_delay, max_length);
     state->IrSize = max_length;
+
+    try {
+        BFormatHrtfFilters filters{Hrtf, AmbiPoints, AmbiMatrix, AmbiCount, AmbiOrderHFGain,
+            NumChannels, max_length, al::vector<HrirArray<ALfloat>>(NumChannels)};
+        for(ALsizei i{0};i < NumChannels;++i)
+            filters.coeffs[static_cast<size_t>(i)] = state->Chan[i].Coeffs;
+
+        std::lock_guard<std::mutex> _{BFormatFiltersLock};
+        if(std::none_of(BFormatFilters.cbegin(), BFormatFilters.cend(), match_filters))
+            BFormatFilters.emplace_back(std::move(filters));
+    }
+    catch(std::bad_alloc&) {
+        /* Not being able to keep the filters is fine, they'll be rebuilt. */
+    }
 }
 
 
@@ -467,6 +795,10 @@ std::unique_ptr<HrtfEntry> CreateHrtfStore(ALuint rate, ALsizei irSize, const AL
 {
     std::unique_ptr<HrtfEntry> Hrtf;
 
+    /* Half-precision coefficients halve the storage for large data sets. */
+    const bool halfcoeffs{GetConfigValueBool(nullptr, nullptr, "hrtf-half-precision", 0) != 0};
+    const size_t coeffsize{halfcoeffs ? sizeof(Hrtf->coeffsHalf[0]) : sizeof(Hrtf->coeffs[0])};
+
     ALsizei evTotal{std::accumulate(evCount, evCount+fdCount, 0)};
     size_t total{sizeof(HrtfEntry)};
     total  = RoundUp(total, alignof(HrtfEntry::Field)); /* Align for field infos */
@@ -475,7 +807,7 @@ std::unique_ptr<HrtfEntry> CreateHrtfStore(ALuint rate, ALsizei irSize, const AL
     total  = RoundUp(total, sizeof(ALushort)); /* Align for ushort fields */
     total += sizeof(Hrtf->evOffset[0])*evTotal;
     total  = RoundUp(total, 16); /* Align for coefficients using SIMD */
-    total += sizeof(Hrtf->coeffs[0])*irSize*irCount;
+    total += coeffsize*irSize*irCount;
     total += sizeof(Hrtf->delays[0])*irCount;
 
     Hrtf.reset(new (al_calloc(16, total)) HrtfEntry{});
@@ -505,8 +837,9 @@ std::unique_ptr<HrtfEntry> CreateHrtfStore(ALuint rate, ALsizei irSize, const AL
         offset += sizeof(evOffset_[0])*evTotal;
 
         offset = RoundUp(offset, 16); /* Align for coefficients using SIMD */
-        auto coeffs_ = reinterpret_cast<ALfloat(*)[2]>(base + offset);
-        offset += sizeof(coeffs_[0])*irSize*irCount;
+        auto coeffs_ = halfcoeffs ? nullptr : reinterpret_cast<ALfloat(*)[2]>(base + offset);
+        auto coeffsHalf_ = halfcoeffs ? reinterpret_cast<ALushort(*)[2]>(base + offset) : nullptr;
+        offset += coeffsize*irSize*irCount;
 
         auto delays_ = reinterpret_cast<ALubyte(*)[2]>(base + offset);
         offset += sizeof(delays_[0])*irCount;
@@ -521,7 +854,15 @@ std::unique_ptr<HrtfEntry> CreateHrtfStore(ALuint rate, ALsizei irSize, const AL
         }
         for(ALsizei i{0};i < evTotal;i++) azCount_[i] = azCount[i];
         for(ALsizei i{0};i < evTotal;i++) evOffset_[i] = evOffset[i];
-        for(ALsizei i{0};i < irSize*irCount;i++)
+        if(coeffsHalf_)
+        {
+            for(ALsizei i{0};i < irSize*irCount;i++)
+            {
+                coeffsHalf_[i][0] = float2half(coeffs[i][0]);
+                coeffsHalf_[i][1] = float2half(coeffs[i][1]);
+            }
+        }
+        else for(ALsizei i{0};i < irSize*irCount;i++)
         {
             coeffs_[i][0] = coeffs[i][0];
             coeffs_[i][1] = coeffs[i][1];
@@ -537,12 +878,66 @@ std::unique_ptr<HrtfEntry> CreateHrtfStore(ALuint rate, ALsizei irSize, const AL
         Hrtf->azCount = azCount_;
         Hrtf->evOffset = evOffset_;
         Hrtf->coeffs = coeffs_;
+        Hrtf->coeffsHalf = coeffsHalf_;
         Hrtf->delays = delays_;
     }
 
     return Hrtf;
 }
 
+/* Creates an HRTF entry that references externally owned azimuth counts,
+ * elevation offsets, coefficients, and delays (i.e. a mapped native-layout
+ * data set), rather than copying them. Only the field infos are stored with
+ * the entry.
+ */
+std::unique_ptr<HrtfEntry> CreateHrtfRef(ALuint rate, ALsizei irSize, const ALsizei fdCount,
+    const ALubyte *evCount, const ALfloat *distance, const ALubyte *azCount,
+    const ALushort *evOffset, const ALfloat (*coeffs)[2], const ALubyte (*delays)[2],
+    const char *filename)
+{
+    std::unique_ptr<HrtfEntry> Hrtf;
+
+    size_t total{sizeof(HrtfEntry)};
+    total  = RoundUp(total, alignof(HrtfEntry::Field)); /* Align for field infos */
+    total += sizeof(HrtfEntry::Field)*fdCount;
+
+    Hrtf.reset(new (al_calloc(16, total)) HrtfEntry{});
+    if(!Hrtf)
+        ERR("Out of memory allocating storage for %s.\n", filename);
+    else
+    {
+        InitRef(&Hrtf->ref, 1u);
+        Hrtf->sampleRate = rate;
+        Hrtf->irSize = irSize;
+        Hrtf->evFarBase = std::accumulate(evCount+1, evCount+fdCount, 0);
+        Hrtf->fdCount = fdCount;
+
+        char *base = reinterpret_cast<char*>(Hrtf.get());
+        uintptr_t offset = sizeof(HrtfEntry);
+
+        offset = RoundUp(offset, alignof(HrtfEntry::Field)); /* Align for field infos */
+        auto field_ = reinterpret_cast<HrtfEntry::Field*>(base + offset);
+        offset += sizeof(field_[0])*fdCount;
+
+        assert(offset == total);
+
+        for(ALsizei i{0};i < fdCount;i++)
+        {
+            field_[i].evCount = evCount[i];
+            field_[i].distance = distance[i];
+        }
+
+        Hrtf->field = field_;
+        Hrtf->azCount = azCount;
+        Hrtf->evOffset = evOffset;
+        Hrtf->coeffs = coeffs;
+        Hrtf->coeffsHalf = nullptr;
+        Hrtf->delays = delays;
+    }
+
+    return Hrtf;
+}
+
 ALubyte GetLE_ALubyte(std::istream &data)
 {
     return static_cast<ALubyte>(data.get());
@@ -579,6 +974,12 @@ ALuint GetLE_ALuint(std::istream &data)
     return ret;
 }
 
+ALfloat GetLE_ALfloat(std::istream &data)
+{
+    union { ALuint u; ALfloat f; } conv{GetLE_ALuint(data)};
+    return conv.f;
+}
+
 std::unique_ptr<HrtfEntry> LoadHrtf00(std::istream &data, const char *filename)
 {
     ALuint rate{GetLE_ALuint(data)};
@@ -1031,6 +1432,424 @@ std::unique_ptr<HrtfEntry> LoadHrtf02(std::istream &data, const char *filename)
         &reinterpret_cast<ALubyte(&)[2]>(delays[0]), filename);
 }
 
+/* The v3 format stores the data set in the same layout it has in memory, so
+ * when the data is available as mapped memory (or a built-in resource), the
+ * coefficients, delays, and azimuth and elevation indices can be used in
+ * place. Otherwise, mem is null and the data is read from the stream.
+ */
+std::unique_ptr<HrtfEntry> LoadHrtf03(std::istream &data, const char *mem, size_t memsize,
+    const char *filename)
+{
+    ALuint rate{GetLE_ALuint(data)};
+    ALushort irSize{GetLE_ALushort(data)};
+    ALubyte fdCount{GetLE_ALubyte(data)};
+    GetLE_ALubyte(data); /* reserved */
+    ALushort evTotal{GetLE_ALushort(data)};
+    GetLE_ALushort(data); /* reserved */
+    ALuint irCount{GetLE_ALuint(data)};
+    if(!data || data.eof())
+    {
+        ERR("Failed reading %s\n", filename);
+        return nullptr;
+    }
+
+    ALboolean failed{AL_FALSE};
+    if(irSize < MIN_IR_SIZE || irSize > MAX_IR_SIZE || (irSize%MOD_IR_SIZE))
+    {
+        ERR("Unsupported HRIR size: irSize=%d (%d to %d by %d)\n",
+            irSize, MIN_IR_SIZE, MAX_IR_SIZE, MOD_IR_SIZE);
+        failed = AL_TRUE;
+    }
+    if(fdCount < 1 || fdCount > MAX_FD_COUNT)
+    {
+        ERR("Multiple field-depths not supported: fdCount=%d (%d to %d)\n",
+            fdCount, MIN_FD_COUNT, MAX_FD_COUNT);
+        failed = AL_TRUE;
+    }
+    if(failed)
+        return nullptr;
+
+    /* Fields are stored farthest first, as with the HRTF entry. */
+    al::vector<ALfloat> distance(fdCount);
+    al::vector<ALubyte> evCount(fdCount);
+    for(ALsizei f{0};f < fdCount;f++)
+    {
+        distance[f] = GetLE_ALfloat(data);
+        evCount[f] = GetLE_ALubyte(data);
+        data.ignore(3); /* reserved */
+        if(!data || data.eof())
+        {
+            ERR("Failed reading %s\n", filename);
+            return nullptr;
+        }
+
+        if(!(distance[f] >= MIN_FD_DISTANCE && distance[f] <= MAX_FD_DISTANCE))
+        {
+            ERR("Unsupported field distance[%d]=%f (%f to %f meters)\n", f,
+                distance[f], MIN_FD_DISTANCE, MAX_FD_DISTANCE);
+            failed = AL_TRUE;
+        }
+        if(f > 0 && distance[f] >= distance[f-1])
+        {
+            ERR("Field distance[%d] is not before previous (%f < %f)\n", f, distance[f],
+                distance[f-1]);
+            failed = AL_TRUE;
+        }
+        if(evCount[f] < MIN_EV_COUNT || evCount[f] > MAX_EV_COUNT)
+        {
+            ERR("Unsupported elevation count: evCount[%d]=%d (%d to %d)\n", f,
+                evCount[f], MIN_EV_COUNT, MAX_EV_COUNT);
+            failed = AL_TRUE;
+        }
+        if(failed)
+            return nullptr;
+    }
+    if(std::accumulate(evCount.begin(), evCount.end(), 0) != evTotal)
+    {
+        ERR("Mismatched elevation total: evTotal=%d\n", evTotal);
+        return nullptr;
+    }
+
+    al::vector<ALubyte> azCount(evTotal);
+    data.read(reinterpret_cast<char*>(azCount.data()), evTotal);
+    if((evTotal&1))
+        data.ignore(1); /* padding */
+    al::vector<ALushort> evOffset(evTotal);
+    for(auto &val : evOffset)
+        val = GetLE_ALushort(data);
+    if(!data || data.eof())
+    {
+        ERR("Failed reading %s\n", filename);
+        return nullptr;
+    }
+
+    ALuint irTotal{0u};
+    for(ALsizei e{0};e < evTotal;e++)
+    {
+        if(azCount[e] < MIN_AZ_COUNT || azCount[e] > MAX_AZ_COUNT)
+        {
+            ERR("Unsupported azimuth count: azCount[%d]=%d (%d to %d)\n", e, azCount[e],
+                MIN_AZ_COUNT, MAX_AZ_COUNT);
+            return nullptr;
+        }
+        if(evOffset[e] != irTotal)
+        {
+            ERR("Invalid elevation offset: evOffset[%d]=%d (expected %u)\n", e, evOffset[e],
+                irTotal);
+            return nullptr;
+        }
+        irTotal += azCount[e];
+    }
+    if(irTotal != irCount)
+    {
+        ERR("Mismatched HRIR count: irCount=%u (expected %u)\n", irCount, irTotal);
+        return nullptr;
+    }
+
+    size_t offset{sizeof(magicMarker03) + 16};
+    offset += 8*fdCount;
+    const size_t azOffset{offset};
+    offset += evTotal;
+    offset  = RoundUp(offset, sizeof(ALushort));
+    const size_t evOffsetOffset{offset};
+    offset += sizeof(ALushort)*evTotal;
+    const size_t padding{RoundUp(offset, 16) - offset};
+    offset += padding;
+    const size_t coeffsOffset{offset};
+    offset += sizeof(ALfloat)*2*irSize*irCount;
+    const size_t delaysOffset{offset};
+    offset += 2*irCount;
+
+    auto check_delays = [irCount](const ALubyte (*delays)[2]) noexcept -> bool
+    {
+        for(ALuint i{0u};i < irCount;++i)
+        {
+            if(delays[i][0] > MAX_HRIR_DELAY || delays[i][1] > MAX_HRIR_DELAY)
+            {
+                ERR("Invalid delays[%u]: %d, %d (%d)\n", i, delays[i][0], delays[i][1],
+                    MAX_HRIR_DELAY);
+                return false;
+            }
+        }
+        return true;
+    };
+
+    /* Half-precision coefficients, or a big-endian or misaligned source, need
+     * to be converted into separate storage.
+     */
+    const bool halfcoeffs{GetConfigValueBool(nullptr, nullptr, "hrtf-half-precision", 0) != 0};
+    if(mem && IS_LITTLE_ENDIAN && !halfcoeffs &&
+       (reinterpret_cast<uintptr_t>(mem+coeffsOffset)&15) == 0)
+    {
+        if(memsize < offset)
+        {
+            ERR("%s data is too short (%zu bytes, expected %zu)\n", filename, memsize, offset);
+            return nullptr;
+        }
+
+        auto delays = reinterpret_cast<const ALubyte(*)[2]>(mem + delaysOffset);
+        if(!check_delays(delays))
+            return nullptr;
+
+        return CreateHrtfRef(rate, irSize, fdCount, evCount.data(), distance.data(),
+            reinterpret_cast<const ALubyte*>(mem + azOffset),
+            reinterpret_cast<const ALushort*>(mem + evOffsetOffset),
+            reinterpret_cast<const ALfloat(*)[2]>(mem + coeffsOffset), delays, filename);
+    }
+
+    data.ignore(static_cast<std::streamsize>(padding));
+    al::vector<std::array<ALfloat,2>> coeffs(irSize*irCount);
+    al::vector<std::array<ALubyte,2>> delays(irCount);
+    for(auto &val : coeffs)
+    {
+        val[0] = GetLE_ALfloat(data);
+        val[1] = GetLE_ALfloat(data);
+    }
+    for(auto &val : delays)
+    {
+        val[0] = GetLE_ALubyte(data);
+        val[1] = GetLE_ALubyte(data);
+    }
+    if(!data || data.eof())
+    {
+        ERR("Failed reading %s\n", filename);
+        return nullptr;
+    }
+    if(!check_delays(&reinterpret_cast<ALubyte(&)[2]>(delays[0])))
+        return nullptr;
+
+    return CreateHrtfStore(rate, irSize, fdCount, evCount.data(), distance.data(), azCount.data(),
+        evOffset.data(), static_cast<ALsizei>(irCount),
+        &reinterpret_cast<ALfloat(&)[2]>(coeffs[0]),
+        &reinterpret_cast<ALubyte(&)[2]>(delays[0]), filename);
+}
+
+/* Stores the HRTF entry's data set in the native layout, as read by
+ * LoadHrtf03. The entry must have full-precision coefficients.
+ */
+al::vector<char> StoreHrtf03(const HrtfEntry *hrtf)
+{
+    const ALsizei fdCount{hrtf->fdCount};
+    const ALsizei irSize{hrtf->irSize};
+    const ALsizei evTotal{std::accumulate(hrtf->field, hrtf->field+fdCount, 0,
+        [](const ALsizei total, const HrtfEntry::Field &field) noexcept -> ALsizei
+        { return total + field.evCount; })};
+    const ALuint irCount{static_cast<ALuint>(hrtf->evOffset[evTotal-1] +
+        hrtf->azCount[evTotal-1])};
+
+    size_t total{sizeof(magicMarker03) + 16};
+    total += 8*fdCount;
+    total += evTotal;
+    total  = RoundUp(total, sizeof(ALushort));
+    total += sizeof(ALushort)*evTotal;
+    total  = RoundUp(total, 16);
+    total += sizeof(ALfloat)*2*irSize*irCount;
+    total += 2*irCount;
+
+    al::vector<char> data;
+    data.reserve(total);
+    auto put_le = [&data](ALuint val, const int bytes) -> void
+    {
+        for(int i{0};i < bytes;++i)
+        {
+            data.push_back(static_cast<char>(val&0xff));
+            val >>= 8;
+        }
+    };
+    auto put_float = [&put_le](const ALfloat val) -> void
+    {
+        union { ALfloat f; ALuint u; } conv{val};
+        put_le(conv.u, 4);
+    };
+    auto pad_to = [&data](const size_t align) -> void
+    { data.resize(RoundUp(data.size(), align), '\0'); };
+
+    data.insert(data.end(), std::begin(magicMarker03), std::end(magicMarker03));
+    put_le(hrtf->sampleRate, 4);
+    put_le(static_cast<ALuint>(irSize), 2);
+    put_le(static_cast<ALuint>(fdCount), 1);
+    put_le(0, 1); /* reserved */
+    put_le(static_cast<ALuint>(evTotal), 2);
+    put_le(0, 2); /* reserved */
+    put_le(irCount, 4);
+    for(ALsizei f{0};f < fdCount;f++)
+    {
+        put_float(hrtf->field[f].distance);
+        put_le(hrtf->field[f].evCount, 1);
+        put_le(0, 3); /* reserved */
+    }
+    data.insert(data.end(), hrtf->azCount, hrtf->azCount+evTotal);
+    pad_to(sizeof(ALushort));
+    for(ALsizei e{0};e < evTotal;e++)
+        put_le(hrtf->evOffset[e], 2);
+    pad_to(16);
+    for(size_t i{0};i < static_cast<size_t>(irSize)*irCount;i++)
+    {
+        put_float(hrtf->coeffs[i][0]);
+        put_float(hrtf->coeffs[i][1]);
+    }
+    for(ALuint i{0u};i < irCount;i++)
+    {
+        put_le(hrtf->delays[i][0], 1);
+        put_le(hrtf->delays[i][1], 1);
+    }
+    assert(data.size() == total);
+
+    return data;
+}
+
+/* Loads a native-layout data set in place from a mapping. */
+std::unique_ptr<HrtfEntry> LoadMappedHrtf03(const FileMapping &fmap, const char *filename)
+{
+    const char *mem{static_cast<const char*>(fmap.ptr)};
+    if(fmap.len < sizeof(magicMarker03) ||
+       memcmp(mem, magicMarker03, sizeof(magicMarker03)) != 0)
+        return nullptr;
+
+    auto stream = al::make_unique<idstream>(mem+sizeof(magicMarker03), mem+fmap.len);
+    return LoadHrtf03(*stream, mem, fmap.len, filename);
+}
+
+/* Calculates the FNV-1a hash of a data set's contents, to identify copies
+ * derived from it.
+ */
+uint64_t GetHrtfHash(const char *mem, const size_t memsize)
+{
+    uint64_t hash{14695981039346656037u};
+    for(size_t i{0};i < memsize;i++)
+    {
+        hash ^= static_cast<ALubyte>(mem[i]);
+        hash *= 1099511628211u;
+    }
+    return hash;
+}
+
+/* Names the shared memory copy of a data set after the hash of its contents,
+ * along with the copy's sample rate and HRIR size. Only data sets at their
+ * stored rate are shared, so resampled copies never take the name of the
+ * original.
+ */
+std::string GetSharedHrtfName(const uint64_t hash, const ALuint rate, const ALuint irSize)
+{
+    char name[80];
+    snprintf(name, sizeof(name), "alsoft-hrtf03-%016llx-%u-%u",
+        static_cast<unsigned long long>(hash), rate, irSize);
+    return name;
+}
+
+/* Gets the HRIR size from the header of a v0, v1, or v2 data set, which
+ * follows the sample rate. Returns 0 if it's unknown.
+ */
+ALuint GetStoredHrtfSize(const char *mem, const size_t memsize)
+{
+    size_t offset{0};
+    if(memsize >= sizeof(magicMarker00) &&
+        memcmp(mem, magicMarker00, sizeof(magicMarker00)) == 0)
+    {
+        /* irCount precedes a 16-bit irSize. */
+        if(memsize < sizeof(magicMarker00)+8) return 0;
+        return static_cast<ALuint>(static_cast<ALubyte>(mem[14])) |
+            (static_cast<ALuint>(static_cast<ALubyte>(mem[15]))<<8);
+    }
+    if(memsize >= sizeof(magicMarker01) &&
+        memcmp(mem, magicMarker01, sizeof(magicMarker01)) == 0)
+        offset = sizeof(magicMarker01)+4;
+    else if(memsize >= sizeof(magicMarker02) &&
+        memcmp(mem, magicMarker02, sizeof(magicMarker02)) == 0)
+        offset = sizeof(magicMarker02)+6; /* after sampleType and channelType */
+    if(!offset || memsize <= offset) return 0;
+    return static_cast<ALubyte>(mem[offset]);
+}
+
+/* Gets the path of the disk cache copy of a data set resampled to the given
+ * rate, named after the hash of the original data set's contents.
+ */
+std::string GetResampledHrtfPath(const uint64_t hash, const ALuint rate)
+{
+    char name[64];
+    snprintf(name, sizeof(name), "%016llx-%u.mhr", static_cast<unsigned long long>(hash), rate);
+    return GetCachePath("openal/hrtf", name);
+}
+
+/* Creates a copy of the HRTF entry with its HRIRs resampled to the given
+ * rate, and the delays and HRIR size scaled to match.
+ */
+std::unique_ptr<HrtfEntry> ResampleHrtf(const HrtfEntry *hrtf, const ALuint rate,
+    const char *filename)
+{
+    const ALsizei fdCount{hrtf->fdCount};
+    const ALsizei irSize{hrtf->irSize};
+    const ALsizei evTotal{std::accumulate(hrtf->field, hrtf->field+fdCount, 0,
+        [](const ALsizei total, const HrtfEntry::Field &field) noexcept -> ALsizei
+        { return total + field.evCount; })};
+    const ALsizei irCount{hrtf->evOffset[evTotal-1] + hrtf->azCount[evTotal-1]};
+
+    const double rate_scale{static_cast<double>(rate) / hrtf->sampleRate};
+    ALsizei newIrSize{static_cast<ALsizei>(std::round(irSize * rate_scale))};
+    newIrSize = clampi(RoundUp(newIrSize, MOD_IR_SIZE), MIN_IR_SIZE, HRIR_LENGTH);
+
+    TRACE("Resampling %s from %uhz to %uhz (%d -> %d samples)\n", filename, hrtf->sampleRate,
+        rate, irSize, newIrSize);
+
+    al::vector<ALubyte> evCount(fdCount);
+    al::vector<ALfloat> distance(fdCount);
+    for(ALsizei f{0};f < fdCount;f++)
+    {
+        evCount[f] = hrtf->field[f].evCount;
+        distance[f] = hrtf->field[f].distance;
+    }
+
+    /* Resampling the HRIRs as signals scales their response by the rate
+     * change, which is compensated for to keep the same gain.
+     */
+    const double gain{1.0 / rate_scale};
+    al::vector<std::array<ALfloat,2>> coeffs(static_cast<size_t>(newIrSize)*irCount);
+    std::array<al::vector<double>,2> inout{{al::vector<double>(irSize),
+        al::vector<double>(newIrSize)}};
+    PPhaseResampler rs;
+    rs.init(hrtf->sampleRate, rate);
+    for(ALsizei i{0};i < irCount;i++)
+    {
+        for(size_t c{0};c < 2;c++)
+        {
+            for(ALsizei j{0};j < irSize;j++)
+            {
+                const size_t idx{static_cast<size_t>(i*irSize + j)};
+                inout[0][j] = hrtf->coeffsHalf ? half2float(hrtf->coeffsHalf[idx][c]) :
+                    hrtf->coeffs[idx][c];
+            }
+            rs.process(irSize, inout[0].data(), newIrSize, inout[1].data());
+            for(ALsizei j{0};j < newIrSize;j++)
+                coeffs[i*newIrSize + j][c] = static_cast<ALfloat>(inout[1][j] * gain);
+        }
+    }
+
+    /* Scale the delays for the new rate. If they exceed the max, scale them
+     * all down to fit (essentially shrinking the head radius), rather than
+     * clamping individual delays.
+     */
+    double delay_scale{rate_scale};
+    const ALubyte maxdelay{std::accumulate(hrtf->delays, hrtf->delays+irCount, ALubyte{0},
+        [](const ALubyte curmax, const ALubyte (&delays)[2]) noexcept -> ALubyte
+        { return std::max(curmax, std::max(delays[0], delays[1])); })};
+    if(maxdelay*delay_scale > MAX_HRIR_DELAY)
+    {
+        WARN("Resampled delay exceeds max (%.2f > %d)\n", maxdelay*delay_scale,
+            MAX_HRIR_DELAY);
+        delay_scale = static_cast<double>(MAX_HRIR_DELAY) / maxdelay;
+    }
+    al::vector<std::array<ALubyte,2>> delays(irCount);
+    for(ALsizei i{0};i < irCount;i++)
+    {
+        for(size_t c{0};c < 2;c++)
+            delays[i][c] = static_cast<ALubyte>(std::round(hrtf->delays[i][c] * delay_scale));
+    }
+
+    return CreateHrtfStore(rate, newIrSize, fdCount, evCount.data(), distance.data(),
+        hrtf->azCount, hrtf->evOffset, irCount, &reinterpret_cast<ALfloat(&)[2]>(coeffs[0]),
+        &reinterpret_cast<ALubyte(&)[2]>(delays[0]), filename);
+}
+
 
 bool checkName(al::vector<EnumeratedHrtf> &list, const std::string &name)
 {
@@ -1209,6 +2028,10 @@ al::vector<EnumeratedHrtf> EnumerateHrtf(const char *devname)
                 const std::string pname{pathlist, end};
                 for(const auto &fname : SearchDataFiles(".mhr", pname.c_str()))
                     AddFileEntry(list, fname);
+#ifdef ALSOFT_HRTF_SOFA
+                for(const auto &fname : SearchDataFiles(".sofa", pname.c_str()))
+                    AddFileEntry(list, fname);
+#endif
             }
 
             pathlist = next;
@@ -1221,6 +2044,10 @@ al::vector<EnumeratedHrtf> EnumerateHrtf(const char *devname)
     {
         for(const auto &fname : SearchDataFiles(".mhr", "openal/hrtf"))
             AddFileEntry(list, fname);
+#ifdef ALSOFT_HRTF_SOFA
+        for(const auto &fname : SearchDataFiles(".sofa", "openal/hrtf"))
+            AddFileEntry(list, fname);
+#endif
 
         ResData res{GetResource(IDR_DEFAULT_44100_MHR)};
         if(res.data != nullptr && res.size > 0)
@@ -1251,19 +2078,88 @@ al::vector<EnumeratedHrtf> EnumerateHrtf(const char *devname)
     return list;
 }
 
-HrtfEntry *GetLoadedHrtf(HrtfHandle *handle)
+namespace {
+
+#ifdef ALSOFT_HRTF_SOFA
+bool IsSofaFile(const char *filename)
 {
-    std::lock_guard<std::mutex> _{LoadedHrtfLock};
+    const size_t len{strlen(filename)};
+    return len >= 5 && strcasecmp(filename+len-5, ".sofa") == 0;
+}
+
+/* SOFA files are converted to the native layout once, and the result stored
+ * in the disk cache named after the hash of the SOFA file's contents. The
+ * SOFA file's mapping is replaced with the converted data set's, so it loads
+ * like any other native data set (including being resampled and cached for
+ * other rates).
+ */
+FileMapping MapConvertedSofa(FileMapping &sofamap, const char *filename)
+{
+    const uint64_t hash{GetHrtfHash(static_cast<const char*>(sofamap.ptr), sofamap.len)};
+    UnmapFileMem(&sofamap);
 
-    if(handle->entry)
+    char name[64];
+    snprintf(name, sizeof(name), "%016llx-sofa.mhr", static_cast<unsigned long long>(hash));
+    const std::string cachepath{GetCachePath("openal/hrtf", name)};
+    if(cachepath.empty())
     {
-        HrtfEntry *hrtf{handle->entry.get()};
-        hrtf->IncRef();
-        return hrtf;
+        ERR("No cache directory to convert %s to\n", filename);
+        return FileMapping{nullptr, 0u};
     }
 
+    FileMapping cmap{MapFileToMem(cachepath.c_str())};
+    if(cmap.ptr)
+    {
+        if(LoadMappedHrtf03(cmap, filename))
+        {
+            TRACE("Using converted data set %s\n", cachepath.c_str());
+            return cmap;
+        }
+        WARN("Ignoring invalid converted data set %s\n", cachepath.c_str());
+        UnmapFileMem(&cmap);
+    }
+
+    if(!ConvertSofaToMhr(filename, cachepath))
+        return FileMapping{nullptr, 0u};
+    TRACE("Created converted data set %s\n", cachepath.c_str());
+    return MapFileToMem(cachepath.c_str());
+}
+#endif
+
+HrtfEntry *FindLoaded(HrtfHandle *handle, const ALuint devrate)
+{
+    auto loaded = std::find_if(handle->loaded.begin(), handle->loaded.end(),
+        [devrate](const HrtfHandle::Loaded &hrtf) noexcept -> bool
+        { return devrate ? hrtf.entry->sampleRate == devrate : hrtf.native; });
+    if(loaded == handle->loaded.end())
+        return nullptr;
+
+    HrtfEntry *hrtf{loaded->entry.get()};
+    hrtf->IncRef();
+    return hrtf;
+}
+
+} // namespace
+
+HrtfEntry *FindLoadedHrtf(HrtfHandle *handle, const ALuint devrate)
+{
+    std::lock_guard<std::mutex> _{LoadedHrtfLock};
+    return FindLoaded(handle, devrate);
+}
+
+HrtfEntry *GetLoadedHrtf(HrtfHandle *handle, const ALuint devrate)
+{
+    std::lock_guard<std::mutex> _{LoadedHrtfLock};
+
+    if(HrtfEntry *hrtf{FindLoaded(handle, devrate)})
+        return hrtf;
+
     std::unique_ptr<std::istream> stream;
     const char *name{""};
+    /* The data set's memory, if it can be referenced directly. */
+    const char *mem{nullptr};
+    size_t memsize{0u};
+    FileMapping fmap{nullptr, 0u};
     ALuint residx{};
     char ch{};
     if(sscanf(handle->filename.data(), "!%u%c", &residx, &ch) == 2 && ch == '_')
@@ -1278,44 +2174,213 @@ HrtfEntry *GetLoadedHrtf(HrtfHandle *handle)
             return nullptr;
         }
         stream = al::make_unique<idstream>(res.data, res.data+res.size);
+        mem = res.data;
+        memsize = res.size;
     }
     else
     {
         name = handle->filename.data();
 
         TRACE("Loading %s...\n", handle->filename.data());
-        auto fstr = al::make_unique<al::ifstream>(handle->filename.data(), std::ios::binary);
-        if(!fstr->is_open())
+        fmap = MapFileToMem(handle->filename.data());
+#ifdef ALSOFT_HRTF_SOFA
+        if(fmap.ptr && IsSofaFile(handle->filename.data()))
+            fmap = MapConvertedSofa(fmap, handle->filename.data());
+#endif
+        if(fmap.ptr)
         {
-            ERR("Could not open %s\n", handle->filename.data());
-            return nullptr;
+            mem = static_cast<const char*>(fmap.ptr);
+            memsize = fmap.len;
+            stream = al::make_unique<idstream>(mem, mem+memsize);
+        }
+        else
+        {
+            auto fstr = al::make_unique<al::ifstream>(handle->filename.data(), std::ios::binary);
+            if(!fstr->is_open())
+            {
+                ERR("Could not open %s\n", handle->filename.data());
+                return nullptr;
+            }
+            stream = std::move(fstr);
         }
-        stream = std::move(fstr);
     }
 
+    /* Copies derived from the data set, shared with other processes or stored
+     * on disk, are stored in the native layout for them to use in place. This
+     * doesn't apply to half-precision coefficients, which can't be referenced
+     * in place.
+     */
+    const bool canstore{mem && IS_LITTLE_ENDIAN &&
+        !GetConfigValueBool(nullptr, nullptr, "hrtf-half-precision", 0)};
+    const bool sharecache{canstore &&
+        GetConfigValueBool(nullptr, nullptr, "hrtf-shared-cache", 0)};
+    const uint64_t hash{canstore ? GetHrtfHash(mem, memsize) : 0};
+    FileMapping shmap{nullptr, 0u};
+
+    /* All data set formats store the sample rate following the header. Data
+     * sets at a different rate than requested are resampled, which can be
+     * avoided by using a copy resampled by a previous load.
+     */
+    const ALuint srcrate{(mem && memsize >= sizeof(magicMarker03)+4) ?
+        (static_cast<ALuint>(static_cast<ALubyte>(mem[8]))       |
+         (static_cast<ALuint>(static_cast<ALubyte>(mem[9]))<<8)  |
+         (static_cast<ALuint>(static_cast<ALubyte>(mem[10]))<<16)|
+         (static_cast<ALuint>(static_cast<ALubyte>(mem[11]))<<24)) : 0u};
+    const bool diskcache{canstore && devrate && srcrate != devrate &&
+        GetConfigValueBool(nullptr, nullptr, "hrtf-disk-cache", 1)};
+    std::string cachepath;
+    FileMapping cmap{nullptr, 0u};
+
+    std::string shmname;
+    bool shmcreated{false};
+
     std::unique_ptr<HrtfEntry> hrtf;
-    char magic[sizeof(magicMarker02)];
-    stream->read(magic, sizeof(magic));
-    if(stream->gcount() < static_cast<std::streamsize>(sizeof(magicMarker02)))
-        ERR("%s data is too short (%zu bytes)\n", name, stream->gcount());
-    else if(memcmp(magic, magicMarker02, sizeof(magicMarker02)) == 0)
+    bool resampled{false};
+    if(diskcache)
     {
-        TRACE("Detected data set format v2\n");
-        hrtf = LoadHrtf02(*stream, name);
+        cachepath = GetResampledHrtfPath(hash, devrate);
+        if(!cachepath.empty())
+            cmap = MapFileToMem(cachepath.c_str());
+        if(cmap.ptr)
+        {
+            hrtf = LoadMappedHrtf03(cmap, name);
+            if(hrtf && hrtf->sampleRate != devrate)
+                hrtf = nullptr;
+            resampled = static_cast<bool>(hrtf);
+            if(hrtf) TRACE("Using cached data set %s\n", cachepath.c_str());
+            else WARN("Ignoring invalid cached data set %s\n", cachepath.c_str());
+        }
     }
-    else if(memcmp(magic, magicMarker01, sizeof(magicMarker01)) == 0)
+
+    char magic[sizeof(magicMarker02)];
+    if(!hrtf)
     {
-        TRACE("Detected data set format v1\n");
-        hrtf = LoadHrtf01(*stream, name);
+        stream->read(magic, sizeof(magic));
+        if(stream->gcount() < static_cast<std::streamsize>(sizeof(magicMarker02)))
+            ERR("%s data is too short (%zu bytes)\n", name, stream->gcount());
+        else if(memcmp(magic, magicMarker03, sizeof(magicMarker03)) == 0)
+        {
+            TRACE("Detected data set format v3\n");
+            hrtf = LoadHrtf03(*stream, mem, memsize, name);
+        }
+        else
+        {
+            const ALuint srcsize{sharecache ? GetStoredHrtfSize(mem, memsize) : 0u};
+            if(srcsize > 0)
+            {
+                shmname = GetSharedHrtfName(hash, srcrate, srcsize);
+                shmap = MapSharedMem(shmname.c_str());
+                if(shmap.ptr)
+                {
+                    hrtf = LoadMappedHrtf03(shmap, name);
+                    if(hrtf && (hrtf->sampleRate != srcrate ||
+                        static_cast<ALuint>(hrtf->irSize) != srcsize))
+                        hrtf = nullptr;
+                    if(hrtf) TRACE("Using shared data set %s\n", shmname.c_str());
+                    else WARN("Ignoring invalid shared data set %s\n", shmname.c_str());
+                }
+            }
+
+            if(!hrtf)
+            {
+                if(memcmp(magic, magicMarker02, sizeof(magicMarker02)) == 0)
+                {
+                    TRACE("Detected data set format v2\n");
+                    hrtf = LoadHrtf02(*stream, name);
+                }
+                else if(memcmp(magic, magicMarker01, sizeof(magicMarker01)) == 0)
+                {
+                    TRACE("Detected data set format v1\n");
+                    hrtf = LoadHrtf01(*stream, name);
+                }
+                else if(memcmp(magic, magicMarker00, sizeof(magicMarker00)) == 0)
+                {
+                    TRACE("Detected data set format v0\n");
+                    hrtf = LoadHrtf00(*stream, name);
+                }
+                else
+                    ERR("Invalid header in %s: \"%.8s\"\n", name, magic);
+            }
+
+            if(hrtf && !shmname.empty() && !shmap.ptr)
+            {
+                /* Nobody has shared this data set yet, so do it. If another
+                 * process beats us to it, just keep the private copy.
+                 */
+                al::vector<char> data{StoreHrtf03(hrtf.get())};
+                shmap = CreateSharedMem(shmname.c_str(), data.data(), data.size());
+                if(shmap.ptr)
+                {
+                    shmcreated = true;
+                    if(auto shared = LoadMappedHrtf03(shmap, name))
+                    {
+                        TRACE("Created shared data set %s\n", shmname.c_str());
+                        hrtf = std::move(shared);
+                    }
+                }
+            }
+        }
+
+        if(hrtf && devrate && hrtf->sampleRate != devrate)
+        {
+            hrtf = ResampleHrtf(hrtf.get(), devrate, name);
+            resampled = true;
+
+            /* Store the resampled data set to the disk cache, and use the
+             * stored copy in place so later loads (by this process or others)
+             * can share it.
+             */
+            if(hrtf && !cachepath.empty())
+            {
+                al::vector<char> data{StoreHrtf03(hrtf.get())};
+                if(cmap.ptr)
+                    UnmapFileMem(&cmap);
+                cmap = FileMapping{nullptr, 0u};
+                if(StoreCacheFile(cachepath, data.data(), data.size()))
+                {
+                    cmap = MapFileToMem(cachepath.c_str());
+                    if(cmap.ptr)
+                    {
+                        if(auto cached = LoadMappedHrtf03(cmap, name))
+                        {
+                            TRACE("Created cached data set %s\n", cachepath.c_str());
+                            hrtf = std::move(cached);
+                        }
+                    }
+                }
+            }
+        }
     }
-    else if(memcmp(magic, magicMarker00, sizeof(magicMarker00)) == 0)
+    stream.reset();
+
+    /* Keep the file, shared memory, or cache file mapped if the entry uses it
+     * in place.
+     */
+    FileMapping mapping{nullptr, 0u};
+    auto keep_mapping = [&hrtf,&mapping](FileMapping &fmapping) -> void
+    {
+        const char *base{static_cast<const char*>(fmapping.ptr)};
+        const char *coeffs{hrtf ? reinterpret_cast<const char*>(hrtf->coeffs) : nullptr};
+        if(coeffs && coeffs >= base && coeffs < base+fmapping.len)
+            mapping = fmapping;
+        else
+            UnmapFileMem(&fmapping);
+    };
+    if(fmap.ptr) keep_mapping(fmap);
+    if(shmap.ptr)
     {
-        TRACE("Detected data set format v0\n");
-        hrtf = LoadHrtf00(*stream, name);
+        keep_mapping(shmap);
+        /* A shared copy this process created is removed when the entry using
+         * it is unloaded, or now if it isn't used (other processes keep any
+         * mappings they already have).
+         */
+        if(shmcreated && mapping.ptr != shmap.ptr)
+        {
+            UnlinkSharedMem(shmname.c_str());
+            shmcreated = false;
+        }
     }
-    else
-        ERR("Invalid header in %s: \"%.8s\"\n", name, magic);
-    stream.reset();
+    if(cmap.ptr) keep_mapping(cmap);
 
     if(!hrtf)
     {
@@ -1325,11 +2390,89 @@ HrtfEntry *GetLoadedHrtf(HrtfHandle *handle)
 
     TRACE("Loaded HRTF support for format: %s %uhz\n",
         DevFmtChannelsString(DevFmtStereo), hrtf->sampleRate);
-    handle->entry = std::move(hrtf);
+    handle->loaded.emplace_back(HrtfHandle::Loaded{std::move(hrtf), !resampled, mapping,
+        shmcreated ? std::move(shmname) : std::string{}});
+    HrtfEntry *ret{handle->loaded.back().entry.get()};
+
+    /* Keep the data set loaded after the last device is done with it, if
+     * requested, so it doesn't need to be loaded again for the next one.
+     */
+    if(GetConfigValueBool(nullptr, nullptr, "hrtf-keep-loaded", 0))
+    {
+        TRACE("Pinning %s\n", name);
+        ret->IncRef();
+    }
+
+    return ret;
+}
+
+
+namespace {
+
+/* Calls fn with each range of memory holding the HRTF's tables. */
+template<typename F>
+void ForEachHrtfRange(const HrtfEntry *Hrtf, F fn)
+{
+    const ALsizei evTotal{std::accumulate(Hrtf->field, Hrtf->field+Hrtf->fdCount, 0,
+        [](const ALsizei cur, const HrtfEntry::Field &field) noexcept -> ALsizei
+        { return cur + field.evCount; }
+    )};
+    const size_t irCount{size_t{Hrtf->evOffset[evTotal-1]} + Hrtf->azCount[evTotal-1]};
+    const size_t irSize{static_cast<size_t>(Hrtf->irSize)};
+
+    fn(Hrtf, sizeof(*Hrtf));
+    fn(Hrtf->field, sizeof(Hrtf->field[0])*static_cast<size_t>(Hrtf->fdCount));
+    fn(Hrtf->azCount, sizeof(Hrtf->azCount[0])*static_cast<size_t>(evTotal));
+    fn(Hrtf->evOffset, sizeof(Hrtf->evOffset[0])*static_cast<size_t>(evTotal));
+    if(Hrtf->coeffsHalf)
+        fn(Hrtf->coeffsHalf, sizeof(Hrtf->coeffsHalf[0])*irSize*irCount);
+    else
+        fn(Hrtf->coeffs, sizeof(Hrtf->coeffs[0])*irSize*irCount);
+    fn(Hrtf->delays, sizeof(Hrtf->delays[0])*irCount);
+}
+
+} // namespace
+
+size_t LockHrtf(HrtfEntry *Hrtf, al::Arena *arena)
+{
+    size_t total{0u};
+    if(Hrtf->mLocked.exchange(true, std::memory_order_acq_rel))
+    {
+        ForEachHrtfRange(Hrtf, [arena,&total](const void *ptr, size_t size) noexcept -> void
+        {
+            if(!al::ArenaContains(arena, ptr))
+                total += size;
+        });
+        return total;
+    }
 
-    return handle->entry.get();
+    bool failed{false};
+    ForEachHrtfRange(Hrtf, [arena,&total,&failed](const void *ptr, size_t size) noexcept -> void
+    {
+        if(!al::LockMemory(ptr, size))
+            failed = true;
+        else if(!al::ArenaContains(arena, ptr))
+            total += size;
+    });
+    if(failed)
+        WARN("Failed to lock all of the HRTF's tables into memory\n");
+    return total;
 }
 
+HrtfEntry::~HrtfEntry()
+{
+    {
+        std::lock_guard<std::mutex> _{BFormatFiltersLock};
+        auto iter = std::remove_if(BFormatFilters.begin(), BFormatFilters.end(),
+            [this](const BFormatHrtfFilters &filters) noexcept -> bool
+            { return filters.hrtf == this; });
+        BFormatFilters.erase(iter, BFormatFilters.end());
+    }
+
+    if(mLocked.load(std::memory_order_acquire))
+        ForEachHrtfRange(this, [](const void *ptr, size_t size) noexcept -> void
+            { al::UnlockMemory(ptr, size); });
+}
 
 void HrtfEntry::IncRef()
 {
@@ -1349,14 +2492,26 @@ void HrtfEntry::DecRef()
          * could've reacquired this HRTF after its reference went to 0 and
          * before the lock was taken.
          */
-        auto iter = std::find_if(LoadedHrtfs.begin(), LoadedHrtfs.end(),
-            [this](const HrtfHandlePtr &entry) noexcept -> bool
-            { return this == entry->entry.get(); }
-        );
-        if(iter != LoadedHrtfs.end() && ReadRef(&this->ref) == 0)
+        for(HrtfHandlePtr &handle : LoadedHrtfs)
         {
-            (*iter)->entry = nullptr;
-            TRACE("Unloaded unused HRTF %s\n", (*iter)->filename.data());
+            auto iter = std::find_if(handle->loaded.begin(), handle->loaded.end(),
+                [this](const HrtfHandle::Loaded &hrtf) noexcept -> bool
+                { return this == hrtf.entry.get(); }
+            );
+            if(iter == handle->loaded.end())
+                continue;
+
+            if(ReadRef(&this->ref) == 0)
+            {
+                iter->entry = nullptr;
+                if(iter->mapping.ptr)
+                    UnmapFileMem(&iter->mapping);
+                if(!iter->shmname.empty())
+                    UnlinkSharedMem(iter->shmname.c_str());
+                handle->loaded.erase(iter);
+                TRACE("Unloaded unused HRTF %s\n", handle->filename.data());
+            }
+            break;
         }
     }
 }
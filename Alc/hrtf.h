@@ -2,6 +2,7 @@
 #define ALC_HRTF_H
 
 #include <array>
+#include <atomic>
 #include <memory>
 #include <string>
 
@@ -20,6 +21,9 @@
 #define HRIR_LENGTH      (1<<HRIR_BITS)
 #define HRIR_MASK        (HRIR_LENGTH-1)
 
+/* Longest HRIR distant and low priority sources can be cut down to. */
+#define HRTF_LOD_MAX_SIZE (32)
+
 
 struct HrtfHandle;
 
@@ -43,9 +47,20 @@ struct HrtfEntry {
 
     const ALubyte *azCount;
     const ALushort *evOffset;
+    /* Only one of these is set, depending on whether the coefficients are
+     * stored as half-precision (with hrtf-half-precision).
+     */
     const ALfloat (*coeffs)[2];
+    const ALushort (*coeffsHalf)[2];
     const ALubyte (*delays)[2];
 
+    /* Set once a device locks the tables into memory, so they're unlocked
+     * when freed.
+     */
+    std::atomic<bool> mLocked;
+
+    ~HrtfEntry();
+
     void IncRef();
     void DecRef();
 
@@ -73,14 +88,17 @@ struct HrtfState {
 struct HrtfParams {
     alignas(16) HrirArray<ALfloat> Coeffs;
     ALsizei Delay[2];
+    /* Number of coefficients in use. Any after are 0. */
+    ALsizei IrSize;
     ALfloat Gain;
 };
 
 struct DirectHrtfState {
     /* HRTF filter state for dry buffer content */
     ALsizei IrSize{0};
+    /* The filtered values being accumulated, summed over the channels. */
+    alignas(16) HrirArray<ALfloat> Values;
     struct ChanData {
-        alignas(16) HrirArray<ALfloat> Values;
         alignas(16) HrirArray<ALfloat> Coeffs;
     };
     al::FlexArray<ChanData> Chan;
@@ -96,6 +114,48 @@ struct DirectHrtfState {
     DEF_PLACE_NEWDEL()
 };
 
+/* A least-recently-used cache of blended HRIRs, keyed by the HRIRs and the
+ * quantized weights they're blended with. Voices panned in (nearly) the same
+ * direction then share the blended coefficients, instead of each blending
+ * them again.
+ */
+struct HrtfCoeffCache {
+    struct Key {
+        /* First HRIR of the lower and upper elevation. */
+        ALsizei Idx[2];
+        /* Quantized elevation and azimuth blending weights. */
+        ALushort Steps[3];
+        ALfloat DirFact;
+
+        bool operator==(const Key &rhs) const noexcept
+        {
+            return Idx[0] == rhs.Idx[0] && Idx[1] == rhs.Idx[1] && Steps[0] == rhs.Steps[0]
+                && Steps[1] == rhs.Steps[1] && Steps[2] == rhs.Steps[2]
+                && DirFact == rhs.DirFact;
+        }
+    };
+    struct Entry {
+        Key mKey;
+        ALuint mLastUse;
+        HrtfParams mParams;
+    };
+
+    std::atomic_flag mLock = ATOMIC_FLAG_INIT;
+    ALuint mUseCount{0u};
+    ALsizei mNumUsed{0};
+    al::FlexArray<Entry> mEntries;
+
+    HrtfCoeffCache(size_t numentries) : mEntries{numentries} { }
+    HrtfCoeffCache(const HrtfCoeffCache&) = delete;
+    HrtfCoeffCache& operator=(const HrtfCoeffCache&) = delete;
+
+    static std::unique_ptr<HrtfCoeffCache> Create(size_t num_entries);
+    static constexpr size_t Sizeof(size_t numentries) noexcept
+    { return al::FlexArray<Entry>::Sizeof(numentries, offsetof(HrtfCoeffCache, mEntries)); }
+
+    DEF_PLACE_NEWDEL()
+};
+
 struct AngularPoint {
     ALfloat Elev;
     ALfloat Azim;
@@ -103,11 +163,49 @@ struct AngularPoint {
 
 
 al::vector<EnumeratedHrtf> EnumerateHrtf(const char *devname);
-HrtfEntry *GetLoadedHrtf(HrtfHandle *handle);
+/**
+ * Loads the HRTF data set, resampled to the given rate if needed. A rate of 0
+ * gets the data set at its stored rate.
+ */
+HrtfEntry *GetLoadedHrtf(HrtfHandle *handle, const ALuint devrate);
+/**
+ * Gets the HRTF data set like GetLoadedHrtf, but only if it's already loaded
+ * for the given rate. Returns null instead of loading it.
+ */
+HrtfEntry *FindLoadedHrtf(HrtfHandle *handle, const ALuint devrate);
+#ifdef ALSOFT_HRTF_SOFA
+/**
+ * Converts a SOFA file to a native (v3) data set, written to the given path.
+ * The file is replaced atomically, so readers never see it partially written.
+ */
+bool ConvertSofaToMhr(const char *sofaname, const std::string &mhrpath);
+#endif
+/**
+ * Locks the HRTF's tables into memory, faulting them in, so reading them from
+ * the mixer can't cause a page fault. Returns the number of bytes locked,
+ * not counting tables in the given arena, which are already locked with it.
+ */
+size_t LockHrtf(HrtfEntry *Hrtf, al::Arena *arena);
 
+/**
+ * Calculates the HRIR coefficients and delays for the given direction and
+ * distance. Between two fields of a multi-field data set, the fields' HRIRs
+ * are blended by distance.
+ */
 void GetHrtfCoeffs(const HrtfEntry *Hrtf, ALfloat elevation, ALfloat azimuth, ALfloat distance,
     ALfloat spread, HrirArray<ALfloat> &coeffs, ALsizei (&delays)[2]);
 
+/**
+ * Calculates the HRIR coefficients and delays like GetHrtfCoeffs. When a cache
+ * is given, the blending weights are quantized and the results are looked up
+ * in and stored to it. An irSize less than the data set's truncates the HRIRs
+ * to that many coefficients, which must not exceed HRTF_LOD_MAX_SIZE. The gain
+ * is left alone.
+ */
+void GetHrtfParams(const HrtfEntry *Hrtf, HrtfCoeffCache *cache, ALfloat elevation,
+    ALfloat azimuth, ALfloat distance, ALfloat spread, const ALsizei irSize,
+    HrtfParams &params);
+
 /**
  * Produces HRTF filter coefficients for decoding B-Format, given a set of
  * virtual speaker positions, a matching decoding matrix, and per-order high-
@@ -0,0 +1,117 @@
+
+#include "config.h"
+
+#include <cstdio>
+#include <cstdarg>
+#include <cstring>
+#include <mutex>
+#include <string>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "alMain.h"
+#include "hrtf.h"
+#include "logging.h"
+#include "compat.h"
+
+#define MAKEMHR_LIBRARY
+#include "makemhr.h"
+
+/* The log macros need the real functions. */
+#undef printf
+#undef fprintf
+#undef vfprintf
+
+
+namespace {
+
+/* makemhr isn't reentrant, so only one conversion runs at a time. */
+std::mutex ConvertLock;
+
+} // namespace
+
+/* makemhr's console output, sent to the log. Errors go to stderr, and
+ * everything else is traced, except progress updates that overwrite the line
+ * with '\r'.
+ */
+int MhrLogVfprintf(FILE *file, const char *fmt, va_list args)
+{
+    char msg[1024];
+    const int ret{vsnprintf(msg, sizeof(msg), fmt, args)};
+    if(ret <= 0 || msg[0] == '\r')
+        return ret;
+
+    size_t len{strlen(msg)};
+    while(len > 0 && (msg[len-1] == '\n' || msg[len-1] == ' '))
+        msg[--len] = '\0';
+    if(len == 0)
+        return ret;
+
+    if(file == stderr)
+        ERR("%s\n", msg);
+    else
+        TRACE("%s\n", msg);
+    return ret;
+}
+
+int MhrLogFprintf(FILE *file, const char *fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    const int ret{MhrLogVfprintf(file, fmt, args)};
+    va_end(args);
+    return ret;
+}
+
+int MhrLogPrintf(const char *fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    const int ret{MhrLogVfprintf(stdout, fmt, args)};
+    va_end(args);
+    return ret;
+}
+
+
+bool ConvertSofaToMhr(const char *sofaname, const std::string &mhrpath)
+{
+    if(mhrpath.length()+16 >= MAX_PATH_LEN)
+    {
+        ERR("Cache path too long: %s\n", mhrpath.c_str());
+        return false;
+    }
+    if(!CreateParentDirs(mhrpath))
+        return false;
+
+    std::lock_guard<std::mutex> _{ConvertLock};
+#ifdef _WIN32
+    const std::string tmppath{mhrpath + "." + std::to_string(GetCurrentProcessId()) + ".tmp"};
+#else
+    const std::string tmppath{mhrpath + "." + std::to_string(getpid()) + ".tmp"};
+#endif
+    TRACE("Converting %s...\n", sofaname);
+    const bool ok{ConvertSofaHrtf(sofaname, tmppath.c_str()) != 0};
+
+#ifdef _WIN32
+    const std::wstring wtmp{utf8_to_wstr(tmppath.c_str())};
+    if(!ok || !MoveFileExW(wtmp.c_str(), utf8_to_wstr(mhrpath.c_str()).c_str(),
+        MOVEFILE_REPLACE_EXISTING))
+    {
+        ERR("Failed to convert %s\n", sofaname);
+        DeleteFileW(wtmp.c_str());
+        return false;
+    }
+#else
+    if(!ok || rename(tmppath.c_str(), mhrpath.c_str()) != 0)
+    {
+        ERR("Failed to convert %s\n", sofaname);
+        unlink(tmppath.c_str());
+        return false;
+    }
+#endif
+    return true;
+}
@@ -1,6 +1,8 @@
 #ifndef INPROGEXT_H
 #define INPROGEXT_H
 
+#include <stddef.h>
+
 #include "AL/al.h"
 #include "AL/alc.h"
 #include "AL/alext.h"
@@ -85,6 +87,318 @@ AL_API void AL_APIENTRY alSourceQueueBufferLayersSOFT(ALuint src, ALsizei nb, co
 #define AL_EFFECTSLOT_TARGET_SOFT                0xf000
 #endif
 
+#ifndef AL_SOFT_source_priority
+#define AL_SOFT_source_priority
+#define AL_SOURCE_PRIORITY_SOFT                  0xf001
+#endif
+
+#ifndef AL_SOFT_source_full_hrtf
+#define AL_SOFT_source_full_hrtf
+#define AL_SOURCE_FULL_HRTF_SOFT                 0xf002
+#endif
+
+#ifndef AL_SOFT_hrtf_ready_event
+#define AL_SOFT_hrtf_ready_event
+#define AL_EVENT_TYPE_HRTF_READY_SOFT            0xf003
+#endif
+
+#ifndef AL_SOFT_convolution_reverb
+#define AL_SOFT_convolution_reverb
+#define AL_EFFECT_CONVOLUTION_REVERB_SOFT        0xf004
+#endif
+
+#ifndef AL_SOFT_effectslot_quality
+#define AL_SOFT_effectslot_quality
+#define AL_EFFECTSLOT_QUALITY_SOFT               0xf005
+#define AL_QUALITY_DEFAULT_SOFT                  0xf006
+#define AL_QUALITY_LOW_SOFT                      0xf007
+#define AL_QUALITY_HIGH_SOFT                     0xf008
+#endif
+
+#ifndef AL_SOFT_effect_timing
+#define AL_SOFT_effect_timing
+#define AL_EFFECTSLOT_PROCESS_TIME_SOFT          0xf009
+#define AL_EFFECTS_PROCESS_TIME_SOFT             0xf00a
+#define AL_EFFECTS_DOWNGRADED_SOFT               0xf00b
+#endif
+
+#ifndef AL_SOFT_source_batch_update
+#define AL_SOFT_source_batch_update
+typedef struct ALsourceUpdateSOFT {
+    ALfloat Position[3];
+    ALfloat Velocity[3];
+    ALfloat Gain;
+    ALfloat Pitch;
+} ALsourceUpdateSOFT;
+typedef void (AL_APIENTRY*LPALSOURCEUPDATEBATCHSOFT)(ALsizei count, const ALuint *sources, const ALsourceUpdateSOFT *updates);
+#ifdef AL_ALEXT_PROTOTYPES
+AL_API void AL_APIENTRY alSourceUpdateBatchSOFT(ALsizei count, const ALuint *sources, const ALsourceUpdateSOFT *updates);
+#endif
+#endif
+
+#ifndef AL_SOFT_buffer_data_batch
+#define AL_SOFT_buffer_data_batch
+typedef struct ALbufferDataSOFT {
+    ALenum Format;
+    const ALvoid *Data;
+    ALsizei Size;
+    ALsizei Frequency;
+} ALbufferDataSOFT;
+typedef void (AL_APIENTRY*LPALBUFFERDATABATCHSOFT)(ALsizei count, const ALuint *buffers, const ALbufferDataSOFT *descs);
+#ifdef AL_ALEXT_PROTOTYPES
+AL_API void AL_APIENTRY alBufferDataBatchSOFT(ALsizei count, const ALuint *buffers, const ALbufferDataSOFT *descs);
+#endif
+#endif
+
+#ifndef AL_SOFT_callback_buffer
+#define AL_SOFT_callback_buffer
+#define AL_CALLBACK_CONTINUOUS_BIT_SOFT          0x00000001
+typedef ALsizei (AL_APIENTRY*ALBUFFERCALLBACKTYPESOFT)(ALvoid *userptr, ALvoid *sampledata, ALsizei numbytes);
+typedef void (AL_APIENTRY*LPALBUFFERCALLBACKSOFT)(ALuint buffer, ALenum format, ALsizei freq, ALBUFFERCALLBACKTYPESOFT callback, ALvoid *userptr, ALbitfieldSOFT flags);
+#ifdef AL_ALEXT_PROTOTYPES
+AL_API void AL_APIENTRY alBufferCallbackSOFT(ALuint buffer, ALenum format, ALsizei freq, ALBUFFERCALLBACKTYPESOFT callback, ALvoid *userptr, ALbitfieldSOFT flags);
+#endif
+#endif
+
+#ifndef AL_SOFT_external_buffer
+#define AL_SOFT_external_buffer
+typedef void (AL_APIENTRY*ALBUFFERRELEASETYPESOFT)(ALvoid *userptr, ALvoid *data);
+typedef void (AL_APIENTRY*LPALBUFFEREXTERNALSOFT)(ALuint buffer, ALenum format, ALvoid *data, ALsizei size, ALsizei freq, ALBUFFERRELEASETYPESOFT release, ALvoid *userptr);
+#ifdef AL_ALEXT_PROTOTYPES
+AL_API void AL_APIENTRY alBufferExternalSOFT(ALuint buffer, ALenum format, ALvoid *data, ALsizei size, ALsizei freq, ALBUFFERRELEASETYPESOFT release, ALvoid *userptr);
+#endif
+#endif
+
+#ifndef AL_SOFT_file_buffer
+#define AL_SOFT_file_buffer
+typedef void (AL_APIENTRY*LPALBUFFERFILESOFT)(ALuint buffer, const ALchar *path, ALint64SOFT offset, ALint64SOFT size, ALenum format, ALsizei freq);
+#ifdef AL_ALEXT_PROTOTYPES
+AL_API void AL_APIENTRY alBufferFileSOFT(ALuint buffer, const ALchar *path, ALint64SOFT offset, ALint64SOFT size, ALenum format, ALsizei freq);
+#endif
+#endif
+
+#ifndef AL_SOFT_int_formats
+#define AL_SOFT_int_formats
+#define AL_FORMAT_MONO_I24_SOFT                  0xf00c
+#define AL_FORMAT_STEREO_I24_SOFT                0xf00d
+#define AL_FORMAT_QUAD_I24_SOFT                  0xf00e
+#define AL_FORMAT_51CHN_I24_SOFT                 0xf00f
+#define AL_FORMAT_61CHN_I24_SOFT                 0xf010
+#define AL_FORMAT_71CHN_I24_SOFT                 0xf011
+#define AL_FORMAT_MONO_I32_SOFT                  0xf012
+#define AL_FORMAT_STEREO_I32_SOFT                0xf013
+#define AL_FORMAT_QUAD_I32_SOFT                  0xf014
+#define AL_FORMAT_51CHN_I32_SOFT                 0xf015
+#define AL_FORMAT_61CHN_I32_SOFT                 0xf016
+#define AL_FORMAT_71CHN_I32_SOFT                 0xf017
+#endif
+
+#ifndef AL_SOFT_buffer_resample_cache
+#define AL_SOFT_buffer_resample_cache
+#define AL_RESAMPLE_CACHE_SOFT                   0xf018
+#endif
+
+#ifndef AL_SOFT_source_start_delay
+#define AL_SOFT_source_start_delay
+typedef void (AL_APIENTRY*LPALSOURCEPLAYATTIMESOFT)(ALuint source, ALint64SOFT start_time);
+typedef void (AL_APIENTRY*LPALSOURCEPLAYATTIMEVSOFT)(ALsizei n, const ALuint *sources, ALint64SOFT start_time);
+#ifdef AL_ALEXT_PROTOTYPES
+AL_API void AL_APIENTRY alSourcePlayAtTimeSOFT(ALuint source, ALint64SOFT start_time);
+AL_API void AL_APIENTRY alSourcePlayAtTimevSOFT(ALsizei n, const ALuint *sources, ALint64SOFT start_time);
+#endif
+#endif
+
+#ifndef AL_SOFT_source_groups
+#define AL_SOFT_source_groups
+#define AL_SOURCE_GROUP_SOFT                     0xf019
+typedef void (AL_APIENTRY*LPALGENSOURCEGROUPSSOFT)(ALsizei n, ALuint *groups);
+typedef void (AL_APIENTRY*LPALDELETESOURCEGROUPSSOFT)(ALsizei n, const ALuint *groups);
+typedef ALboolean (AL_APIENTRY*LPALISSOURCEGROUPSOFT)(ALuint group);
+typedef void (AL_APIENTRY*LPALSOURCEGROUPFSOFT)(ALuint group, ALenum param, ALfloat value);
+typedef void (AL_APIENTRY*LPALGETSOURCEGROUPFSOFT)(ALuint group, ALenum param, ALfloat *value);
+#ifdef AL_ALEXT_PROTOTYPES
+AL_API void AL_APIENTRY alGenSourceGroupsSOFT(ALsizei n, ALuint *groups);
+AL_API void AL_APIENTRY alDeleteSourceGroupsSOFT(ALsizei n, const ALuint *groups);
+AL_API ALboolean AL_APIENTRY alIsSourceGroupSOFT(ALuint group);
+AL_API void AL_APIENTRY alSourceGroupfSOFT(ALuint group, ALenum param, ALfloat value);
+AL_API void AL_APIENTRY alGetSourceGroupfSOFT(ALuint group, ALenum param, ALfloat *value);
+#endif
+#endif
+
+#ifndef AL_SOFT_buffer_completion_wakeup
+#define AL_SOFT_buffer_completion_wakeup
+#define AL_BUFFERS_COMPLETED_SOFT                0xf01a
+#define AL_BUFFER_COMPLETION_HANDLE_SOFT         0xf01b
+#endif
+
+#ifndef AL_SOFT_source_mix_cost
+#define AL_SOFT_source_mix_cost
+#define AL_SOURCE_MIX_COST_SOFT                  0xf01c
+#endif
+
+#ifndef AL_SOFT_source_state_query
+#define AL_SOFT_source_state_query
+typedef struct ALsourceStateSOFT {
+    ALenum State;
+    ALint SampleOffset;
+    ALint BuffersProcessed;
+} ALsourceStateSOFT;
+typedef void (AL_APIENTRY*LPALGETSOURCESSTATESOFT)(ALsizei count, const ALuint *sources, ALsourceStateSOFT *states);
+#ifdef AL_ALEXT_PROTOTYPES
+AL_API void AL_APIENTRY alGetSourcesStateSOFT(ALsizei count, const ALuint *sources, ALsourceStateSOFT *states);
+#endif
+#endif
+
+#ifndef AL_SOFT_source_instancing
+#define AL_SOFT_source_instancing
+#define AL_SOURCE_INSTANCING_SOFT                0xf01d
+#endif
+
+#ifndef AL_SOFT_event_batch
+#define AL_SOFT_event_batch
+typedef struct ALeventSOFT {
+    ALenum Type;
+    ALuint Object;
+    ALuint Param;
+    ALsizei Length;
+    const ALchar *Message;
+} ALeventSOFT;
+typedef void (AL_APIENTRY*ALEVENTBATCHPROCSOFT)(ALsizei count, const ALeventSOFT *events,
+                                                void *userParam);
+typedef void (AL_APIENTRY*LPALEVENTBATCHCALLBACKSOFT)(ALEVENTBATCHPROCSOFT callback, ALboolean messages, void *userParam);
+#ifdef AL_ALEXT_PROTOTYPES
+AL_API void AL_APIENTRY alEventBatchCallbackSOFT(ALEVENTBATCHPROCSOFT callback, ALboolean messages, void *userParam);
+#endif
+#endif
+
+#ifndef AL_SOFT_multi_listener
+#define AL_SOFT_multi_listener
+#define AL_MAX_LISTENERS_SOFT                    0xf01e
+#define AL_LISTENER_OUTPUT_CHANNEL_SOFT          0xf01f
+typedef void (AL_APIENTRY*LPALLISTENERFINDEXSOFT)(ALuint index, ALenum param, ALfloat value);
+typedef void (AL_APIENTRY*LPALLISTENERFVINDEXSOFT)(ALuint index, ALenum param, const ALfloat *values);
+typedef void (AL_APIENTRY*LPALLISTENERIINDEXSOFT)(ALuint index, ALenum param, ALint value);
+typedef void (AL_APIENTRY*LPALGETLISTENERFVINDEXSOFT)(ALuint index, ALenum param, ALfloat *values);
+typedef void (AL_APIENTRY*LPALGETLISTENERIINDEXSOFT)(ALuint index, ALenum param, ALint *value);
+#ifdef AL_ALEXT_PROTOTYPES
+AL_API void AL_APIENTRY alListenerfIndexSOFT(ALuint index, ALenum param, ALfloat value);
+AL_API void AL_APIENTRY alListenerfvIndexSOFT(ALuint index, ALenum param, const ALfloat *values);
+AL_API void AL_APIENTRY alListeneriIndexSOFT(ALuint index, ALenum param, ALint value);
+AL_API void AL_APIENTRY alGetListenerfvIndexSOFT(ALuint index, ALenum param, ALfloat *values);
+AL_API void AL_APIENTRY alGetListeneriIndexSOFT(ALuint index, ALenum param, ALint *value);
+#endif
+#endif
+
+#ifndef AL_SOFT_source_output_channel
+#define AL_SOFT_source_output_channel
+#define AL_SOURCE_OUTPUT_CHANNEL_SOFT            0xf020
+#define AL_OUTPUT_CHANNEL_FRONT_CENTER_SOFT      0xf021
+#define AL_OUTPUT_CHANNEL_LFE_SOFT               0xf022
+#endif
+
+#ifndef AL_SOFT_linked_filters
+#define AL_SOFT_linked_filters
+#define AL_FILTER_LINKED_SOFT                    0xf023
+#endif
+
+#ifndef AL_SOFT_early_reflections
+#define AL_SOFT_early_reflections
+#define AL_EFFECT_EARLY_REFLECTIONS_SOFT         0xf024
+#endif
+
+#ifndef ALC_SOFT_loopback_planar
+#define ALC_SOFT_loopback_planar
+typedef void (ALC_APIENTRY*LPALCRENDERSAMPLESPLANARSOFT)(ALCdevice *device, ALCvoid **buffers, ALCsizei samples);
+#ifdef AL_ALEXT_PROTOTYPES
+ALC_API void ALC_APIENTRY alcRenderSamplesPlanarSOFT(ALCdevice *device, ALCvoid **buffers, ALCsizei samples);
+#endif
+#endif
+
+#ifndef ALC_SOFT_loopback_sparse
+#define ALC_SOFT_loopback_sparse
+typedef ALCboolean (ALC_APIENTRY*LPALCRENDERSAMPLESSPARSESOFT)(ALCdevice *device, ALCvoid *buffer, ALCsizei samples);
+#ifdef AL_ALEXT_PROTOTYPES
+ALC_API ALCboolean ALC_APIENTRY alcRenderSamplesSparseSOFT(ALCdevice *device, ALCvoid *buffer, ALCsizei samples);
+#endif
+#endif
+
+#ifndef ALC_SOFT_loopback_batch
+#define ALC_SOFT_loopback_batch
+typedef void (ALC_APIENTRY*LPALCRENDERSAMPLESBATCHSOFT)(ALCsizei count, ALCdevice *const *devices, ALCvoid *const *buffers, const ALCsizei *samples);
+#ifdef AL_ALEXT_PROTOTYPES
+ALC_API void ALC_APIENTRY alcRenderSamplesBatchSOFT(ALCsizei count, ALCdevice *const *devices, ALCvoid *const *buffers, const ALCsizei *samples);
+#endif
+#endif
+
+#ifndef ALC_SOFT_allocator_callbacks
+#define ALC_SOFT_allocator_callbacks
+typedef ALCvoid* (ALC_APIENTRY*ALCALLOCPROCSOFT)(ALCvoid *userptr, size_t size, size_t alignment);
+typedef void (ALC_APIENTRY*ALCFREEPROCSOFT)(ALCvoid *userptr, ALCvoid *ptr, size_t size);
+typedef ALCboolean (ALC_APIENTRY*LPALCSETALLOCATORCALLBACKSSOFT)(ALCALLOCPROCSOFT allocfn, ALCFREEPROCSOFT freefn, ALCvoid *userptr);
+#ifdef AL_ALEXT_PROTOTYPES
+ALC_API ALCboolean ALC_APIENTRY alcSetAllocatorCallbacksSOFT(ALCALLOCPROCSOFT allocfn, ALCFREEPROCSOFT freefn, ALCvoid *userptr);
+#endif
+#endif
+
+#ifndef ALC_SOFT_locked_memory
+#define ALC_SOFT_locked_memory
+#define ALC_LOCKED_MEMORY_SIZE_SOFT              0x19A0
+#endif
+
+#ifndef ALC_SOFT_capture_callback
+#define ALC_SOFT_capture_callback
+typedef void (ALC_APIENTRY*ALCCAPTUREPROCSOFT)(ALCvoid *userptr, const ALCvoid *data, ALCsizei frames);
+typedef ALCboolean (ALC_APIENTRY*LPALCCAPTURECALLBACKSOFT)(ALCdevice *device, ALCCAPTUREPROCSOFT callback, ALCvoid *userptr);
+#ifdef AL_ALEXT_PROTOTYPES
+ALC_API ALCboolean ALC_APIENTRY alcCaptureCallbackSOFT(ALCdevice *device, ALCCAPTUREPROCSOFT callback, ALCvoid *userptr);
+#endif
+#endif
+
+#ifndef ALC_SOFT_mixer_stats
+#define ALC_SOFT_mixer_stats
+#define ALC_MIXER_STATS_SOFT                     0x19A1
+#define ALC_MIXER_PARAM_TIME_SOFT                0x19A2
+#define ALC_MIXER_VOICE_TIME_SOFT                0x19A3
+#define ALC_MIXER_VOICE_PLAIN_TIME_SOFT          0x19A4
+#define ALC_MIXER_VOICE_HRTF_TIME_SOFT           0x19A5
+#define ALC_MIXER_VOICE_AMBI_TIME_SOFT           0x19A6
+#define ALC_MIXER_EFFECT_TIME_SOFT               0x19A7
+#define ALC_MIXER_POSTPROCESS_TIME_SOFT          0x19A8
+#define ALC_MIXER_OUTPUT_TIME_SOFT               0x19A9
+#define ALC_MIXER_UPDATE_TIME_SOFT               0x19AA
+#define ALC_MIXER_PEAK_UPDATE_TIME_SOFT          0x19AB
+#define ALC_MIXER_VOICES_MIXED_SOFT              0x19AC
+#define ALC_MIXER_VOICES_SKIPPED_SOFT            0x19AD
+#define ALC_MIXER_UPDATE_COUNT_SOFT              0x19AE
+#define ALC_MIXER_XRUN_COUNT_SOFT                0x19AF
+#endif
+
+#ifndef ALC_SOFT_backend_telemetry
+#define ALC_SOFT_backend_telemetry
+#define ALC_BACKEND_WAKEUP_COUNT_SOFT            0x19B0
+#define ALC_BACKEND_MAX_WAKEUP_GAP_SOFT          0x19B1
+#define ALC_BACKEND_JITTER_HISTOGRAM_SOFT        0x19B2
+#define ALC_BACKEND_LATENCY_SOFT                 0x19B3
+#define ALC_BACKEND_UNDERRUN_COUNT_SOFT          0x19B4
+#endif
+
+#ifndef ALC_SOFT_output_mirror
+#define ALC_SOFT_output_mirror
+#define ALC_OUTPUT_MIRROR_COUNT_SOFT             0x19B5
+typedef ALCboolean (ALC_APIENTRY*LPALCADDOUTPUTMIRRORSOFT)(ALCdevice *device, const ALCchar *deviceName);
+typedef ALCboolean (ALC_APIENTRY*LPALCREMOVEOUTPUTMIRRORSSOFT)(ALCdevice *device);
+#ifdef AL_ALEXT_PROTOTYPES
+ALC_API ALCboolean ALC_APIENTRY alcAddOutputMirrorSOFT(ALCdevice *device, const ALCchar *deviceName);
+ALC_API ALCboolean ALC_APIENTRY alcRemoveOutputMirrorsSOFT(ALCdevice *device);
+#endif
+#endif
+
+#ifndef ALC_SOFT_kernel_info
+#define ALC_SOFT_kernel_info
+#define ALC_CPU_EXTENSIONS_SOFT                  0x19B6
+#define ALC_MIXER_KERNELS_SOFT                   0x19B7
+#endif
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
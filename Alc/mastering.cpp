@@ -95,12 +95,14 @@ void ShiftSlidingHold(SlidingHold *Hold, const ALsizei n)
 
 
 /* Multichannel compression is linked via the absolute maximum of all
- * channels.
+ * channels. The pre-gain is applied to the linked level, rather than to each
+ * channel, and is folded into the output gain later.
  */
 void LinkChannels(Compressor *Comp, const ALsizei SamplesToDo, const ALfloat (*RESTRICT OutBuffer)[BUFFERSIZE])
 {
     const ALsizei index{Comp->mLookAhead};
     const ALsizei numChans{Comp->mNumChans};
+    const ALfloat preGain{Comp->mPreGain};
 
     ASSUME(SamplesToDo > 0);
     ASSUME(numChans > 0);
@@ -116,6 +118,10 @@ void LinkChannels(Compressor *Comp, const ALsizei SamplesToDo, const ALfloat (*R
         std::transform(side_begin, side_begin+SamplesToDo, buffer, side_begin, max_abs);
     };
     std::for_each(OutBuffer, OutBuffer+numChans, fill_max);
+
+    if(preGain != 1.0f)
+        std::transform(side_begin, side_begin+SamplesToDo, side_begin,
+            std::bind(std::multiplies<float>{}, _1, preGain));
 }
 
 /* This calculates the squared crest factor of the control signal for the
@@ -292,13 +298,17 @@ void GainCompressor(Compressor *Comp, const ALsizei SamplesToDo)
  * fast transients by allowing the envelope time to converge prior to
  * reaching the offending impulse.  This is best used when operating as a
  * limiter.
+ *
+ * The delayed output is read straight out of each channel's ring buffer and
+ * has the gain applied as it's written back, so the output only gets one pass.
  */
-void SignalDelay(Compressor *Comp, const ALsizei SamplesToDo, ALfloat (*RESTRICT OutBuffer)[BUFFERSIZE])
+void SignalDelayGain(Compressor *Comp, const ALsizei SamplesToDo, ALfloat (*RESTRICT OutBuffer)[BUFFERSIZE])
 {
     static constexpr ALsizei mask{BUFFERSIZE - 1};
     const ALsizei numChans{Comp->mNumChans};
     const ALsizei indexIn{Comp->mDelayIndex};
     const ALsizei indexOut{Comp->mDelayIndex - Comp->mLookAhead};
+    const ALfloat *RESTRICT gains{al::assume_aligned<16>(&Comp->mSideChain[0])};
 
     ASSUME(SamplesToDo > 0);
     ASSUME(numChans > 0);
@@ -311,7 +321,7 @@ void SignalDelay(Compressor *Comp, const ALsizei SamplesToDo, ALfloat (*RESTRICT
         {
             const ALfloat sig{inout[i]};
 
-            inout[i] = delay[(indexOut + i) & mask];
+            inout[i] = delay[(indexOut + i) & mask] * gains[i];
             delay[(indexIn + i) & mask] = sig;
         }
     }
@@ -432,18 +442,6 @@ void Compressor::process(const ALsizei SamplesToDo, ALfloat (*OutBuffer)[BUFFERS
     ASSUME(SamplesToDo > 0);
     ASSUME(numChans > 0);
 
-    const ALfloat preGain{mPreGain};
-    if(preGain != 1.0f)
-    {
-        auto apply_gain = [SamplesToDo,preGain](ALfloat *input) noexcept -> void
-        {
-            ALfloat *buffer{al::assume_aligned<16>(input)};
-            std::transform(buffer, buffer+SamplesToDo, buffer,
-                std::bind(std::multiplies<float>{}, _1, preGain));
-        };
-        std::for_each(OutBuffer, OutBuffer+numChans, apply_gain);
-    }
-
     LinkChannels(this, SamplesToDo, OutBuffer);
 
     if(mAuto.Attack || mAuto.Release)
@@ -456,22 +454,32 @@ void Compressor::process(const ALsizei SamplesToDo, ALfloat (*OutBuffer)[BUFFERS
 
     GainCompressor(this, SamplesToDo);
 
-    if(mDelay)
-        SignalDelay(this, SamplesToDo, OutBuffer);
+    /* Fold the pre-gain into the output gain, since the channels weren't
+     * scaled by it.
+     */
+    const ALfloat preGain{mPreGain};
+    if(preGain != 1.0f)
+        std::transform(std::begin(mSideChain), std::begin(mSideChain)+SamplesToDo,
+            std::begin(mSideChain), std::bind(std::multiplies<float>{}, _1, preGain));
 
-    const ALfloat (&sideChain)[BUFFERSIZE*2] = mSideChain;
-    auto apply_comp = [SamplesToDo,&sideChain](ALfloat *input) noexcept -> void
+    if(mDelay)
+        SignalDelayGain(this, SamplesToDo, OutBuffer);
+    else
     {
-        ALfloat *buffer{al::assume_aligned<16>(input)};
-        const ALfloat *gains{al::assume_aligned<16>(&sideChain[0])};
-        /* Mark the gains "input-1 type" as restrict, so the compiler can
-         * vectorize this loop (otherwise it assumes a write to buffer[n] can
-         * change gains[n+1]).
-         */
-        std::transform<const ALfloat*RESTRICT>(gains, gains+SamplesToDo, buffer, buffer,
-            std::bind(std::multiplies<float>{}, _1, _2));
-    };
-    std::for_each(OutBuffer, OutBuffer+numChans, apply_comp);
+        const ALfloat (&sideChain)[BUFFERSIZE*2] = mSideChain;
+        auto apply_comp = [SamplesToDo,&sideChain](ALfloat *input) noexcept -> void
+        {
+            ALfloat *buffer{al::assume_aligned<16>(input)};
+            const ALfloat *gains{al::assume_aligned<16>(&sideChain[0])};
+            /* Mark the gains "input-1 type" as restrict, so the compiler can
+             * vectorize this loop (otherwise it assumes a write to buffer[n]
+             * can change gains[n+1]).
+             */
+            std::transform<const ALfloat*RESTRICT>(gains, gains+SamplesToDo, buffer, buffer,
+                std::bind(std::multiplies<float>{}, _1, _2));
+        };
+        std::for_each(OutBuffer, OutBuffer+numChans, apply_comp);
+    }
 
     ASSUME(mLookAhead >= 0);
     auto side_begin = std::begin(mSideChain) + SamplesToDo;
@@ -0,0 +1,244 @@
+/**
+ * OpenAL cross platform audio library
+ * Copyright (C) 2019 by authors.
+ * This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Library General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ *  License along with this library; if not, write to the
+ *  Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ * Or go to http://www.gnu.org/copyleft/lgpl.html
+ */
+
+#include "config.h"
+
+#include "mirror.h"
+
+#include <algorithm>
+#include <exception>
+
+#include "alu.h"
+#include "logging.h"
+
+#include "backends/base.h"
+
+
+namespace {
+
+void WriteSilence(ALvoid *dst, DevFmtType type, ALsizei samples)
+{
+    switch(type)
+    {
+        case DevFmtUByte:
+            std::fill_n(static_cast<ALubyte*>(dst), samples, ALubyte{0x80});
+            break;
+        case DevFmtUShort:
+            std::fill_n(static_cast<ALushort*>(dst), samples, ALushort{0x8000});
+            break;
+        case DevFmtUInt:
+            std::fill_n(static_cast<ALuint*>(dst), samples, 0x80000000u);
+            break;
+        case DevFmtByte:
+        case DevFmtShort:
+        case DevFmtInt:
+        case DevFmtFloat:
+            std::fill_n(static_cast<ALbyte*>(dst), samples*BytesFromDevFmt(type), ALbyte{0});
+            break;
+    }
+}
+
+} // namespace
+
+
+OutputMirror::~OutputMirror()
+{ stop(); }
+
+void OutputMirror::stop()
+{
+    ALCdevice *device{Device.get()};
+    if((device->Flags&DEVICE_RUNNING))
+        device->Backend->stop();
+    device->Flags &= ~DEVICE_RUNNING;
+}
+
+bool OutputMirror::reset(const ALCdevice *main)
+{
+    ALCdevice *device{Device.get()};
+    stop();
+    Ring = nullptr;
+    Converter = nullptr;
+
+    /* Ask for the main device's format, though the backend may give another.
+     * Anything but a mono/stereo difference in channels can't be converted.
+     */
+    device->FmtChans = main->FmtChans;
+    device->FmtType = main->FmtType;
+    device->mAmbiOrder = main->mAmbiOrder;
+    device->mAmbiLayout = main->mAmbiLayout;
+    device->mAmbiScale = main->mAmbiScale;
+    /* A loopback device has no update size of its own, so the mirror gets the
+     * default.
+     */
+    const ALuint mainupdate{main->UpdateSize ? main->UpdateSize : DEFAULT_UPDATE_SIZE};
+    device->Frequency = main->Frequency;
+    device->UpdateSize = mainupdate;
+    device->BufferSize = main->BufferSize ? main->BufferSize : mainupdate*DEFAULT_NUM_UPDATES;
+    try {
+        if(device->Backend->reset() == ALC_FALSE)
+            return false;
+    }
+    catch(std::exception &e) {
+        ERR("Mirror \"%s\" reset failed: %s\n", device->DeviceName.c_str(), e.what());
+        return false;
+    }
+    device->MixFrequency = device->Frequency;
+
+    const ALsizei numchans{main->RealOut.NumChannels};
+    Converter = CreateSampleConverter(DevFmtFloat, device->FmtType, numchans,
+        device->channelsFromFmt(), static_cast<ALsizei>(main->MixFrequency),
+        static_cast<ALsizei>(device->Frequency), BSinc12Resampler);
+    if(!Converter)
+    {
+        ERR("Mirror \"%s\" can't play %s output as %s\n", device->DeviceName.c_str(),
+            DevFmtChannelsString(main->FmtChans), DevFmtChannelsString(device->FmtChans));
+        return false;
+    }
+    NumChannels = numchans;
+
+    /* Keep enough in the ring to cover two updates of each device, measured
+     * at the main device's mix rate.
+     */
+    const uint64_t mixfreq{main->MixFrequency};
+    const uint64_t mainlen{mainupdate*mixfreq / main->Frequency};
+    const uint64_t mirrorlen{device->UpdateSize*mixfreq / device->Frequency};
+    TargetFill = static_cast<ALsizei>((mainlen+mirrorlen) * 2);
+    Ring = CreateRingBuffer(static_cast<size_t>(TargetFill)*4,
+        static_cast<size_t>(NumChannels)*sizeof(ALfloat), false);
+    Converter->enableAdaptiveRate(TargetFill);
+    Primed = false;
+
+    TRACE("Mirror \"%s\": %s, %s, %uhz, %u / %u buffer, %d frame target\n",
+        device->DeviceName.c_str(), DevFmtChannelsString(device->FmtChans),
+        DevFmtTypeString(device->FmtType), device->Frequency, device->UpdateSize,
+        device->BufferSize, TargetFill);
+
+    if(device->Backend->start() == ALC_FALSE)
+    {
+        ERR("Mirror \"%s\" failed to start\n", device->DeviceName.c_str());
+        return false;
+    }
+    device->Flags |= DEVICE_RUNNING;
+    return true;
+}
+
+
+void OutputMirror::write(const ALfloat (*buffer)[BUFFERSIZE], ALsizei samples)
+{
+    RingBuffer *ring{Ring.get()};
+    if(!ring) return;
+
+    /* Whatever doesn't fit is dropped. The mirror's reads will catch up from
+     * the fuller ring.
+     */
+    auto vec = ring->getWriteVector();
+    const auto todo = static_cast<ALsizei>(minz(vec.first.len+vec.second.len,
+        static_cast<size_t>(samples)));
+    const auto first = static_cast<ALsizei>(minz(vec.first.len, static_cast<size_t>(todo)));
+
+    const ALfloat *srcs[MAX_OUTPUT_CHANNELS];
+    for(ALsizei c{0};c < NumChannels;++c)
+        srcs[c] = buffer[c];
+    if(first > 0)
+        StorePCMSamples(vec.first.buf, srcs, NumChannels, NumChannels, DevFmtFloat, first);
+    if(todo > first)
+    {
+        for(ALsizei c{0};c < NumChannels;++c)
+            srcs[c] += first;
+        StorePCMSamples(vec.second.buf, srcs, NumChannels, NumChannels, DevFmtFloat,
+            todo-first);
+    }
+    ring->writeAdvance(static_cast<size_t>(todo));
+}
+
+
+/* Returns the number of frames that may be read from the ring (none if it
+ * isn't primed).
+ */
+ALsizei OutputMirror::prepare()
+{
+    RingBuffer *ring{Ring.get()};
+    if(!ring) return 0;
+
+    const auto fill = static_cast<ALsizei>(ring->readSpace());
+    if(!Primed)
+    {
+        if(fill < TargetFill)
+            return 0;
+        Primed = true;
+    }
+    return fill;
+}
+
+void OutputMirror::read(ALvoid *OutBuffer, ALsizei frames)
+{
+    ALsizei got{0};
+    if(const ALsizei avail{prepare()})
+    {
+        if(OutBuffer)
+            got = ConvertCaptureRing(Ring.get(), nullptr, Converter.get(), OutBuffer, frames);
+        else
+        {
+            /* With no output, skip what would have been converted. */
+            Converter->updateFill(static_cast<size_t>(avail));
+            const uint64_t increment{static_cast<ALuint>(Converter->mIncrement)};
+            const uint64_t needed{(static_cast<uint64_t>(frames)*increment) >> FRACTIONBITS};
+            const auto skip = minu64(needed, static_cast<uint64_t>(avail));
+            Ring->readAdvance(static_cast<size_t>(skip));
+            got = (skip < needed) ? static_cast<ALsizei>((skip<<FRACTIONBITS) / increment) :
+                frames;
+        }
+    }
+
+    if(got < frames)
+    {
+        /* Ran dry, so wait for the ring to fill up again. */
+        Primed = false;
+        if(OutBuffer)
+        {
+            ALCdevice *device{Device.get()};
+            const ALsizei numchans{device->channelsFromFmt()};
+            WriteSilence(static_cast<ALbyte*>(OutBuffer) + got*device->frameSizeFromFmt(),
+                device->FmtType, (frames-got)*numchans);
+        }
+    }
+}
+
+void OutputMirror::readPlanar(ALfloat *const *OutBuffers, ALsizei frames)
+{
+    /* Planar output is always float, so it's read interleaved a block at a
+     * time and split into the channels' buffers.
+     */
+    const ALsizei numchans{Device->channelsFromFmt()};
+    const ALsizei blocksize{(BUFFERSIZE*2) / numchans};
+    alignas(16) ALfloat samples[BUFFERSIZE*2];
+    for(ALsizei done{0};done < frames;)
+    {
+        const ALsizei todo{mini(frames-done, blocksize)};
+        read(samples, todo);
+        for(ALsizei c{0};c < numchans;++c)
+        {
+            ALfloat *RESTRICT dst{OutBuffers[c] + done};
+            for(ALsizei i{0};i < todo;++i)
+                dst[i] = samples[i*numchans + c];
+        }
+        done += todo;
+    }
+}
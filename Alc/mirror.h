@@ -0,0 +1,66 @@
+#ifndef MIRROR_H
+#define MIRROR_H
+
+#include <memory>
+
+#include "alMain.h"
+#include "almalloc.h"
+#include "converter.h"
+#include "ringbuffer.h"
+
+
+/* Another playback device a device's output is mirrored to, so one mix can be
+ * played on several outputs. The mirror's backend runs on a hidden device of
+ * its own, which reads the main device's finished mix from a ring buffer
+ * instead of mixing, converting it to the mirror's rate and format.
+ *
+ * The two devices' clocks aren't synchronized, so the converter's rate adapts
+ * to keep the ring near its target fill, compensating for the drift.
+ */
+struct OutputMirror {
+    /* The hidden device the mirror's backend plays. */
+    std::unique_ptr<ALCdevice> Device;
+
+    /* The main device's output, as interleaved float frames at its mix rate.
+     * Written by the main device's mixer and read by the mirror's. Null until
+     * the mirror is set up for the main device's output.
+     */
+    RingBufferPtr Ring;
+    ALsizei NumChannels{0};
+    SampleConverterPtr Converter;
+
+    /* The number of frames the ring is kept at. Before any output, the ring
+     * is first filled to the target (again after it runs dry).
+     */
+    ALsizei TargetFill{0};
+    bool Primed{false};
+
+    OutputMirror(ALCdevice *device) : Device{device} { }
+    OutputMirror(const OutputMirror&) = delete;
+    OutputMirror& operator=(const OutputMirror&) = delete;
+    ~OutputMirror();
+
+    /* Sets up the mirror for the main device's current output, resetting and
+     * restarting its backend. Returns false if the mirror can't play it. The
+     * main device must not be mixing.
+     */
+    bool reset(const ALCdevice *main);
+    void stop();
+
+    /* Called by the main device's mixer with each update's finished output. */
+    void write(const ALfloat (*buffer)[BUFFERSIZE], ALsizei samples);
+
+    /* Called by the mirror's mixer for its output, instead of mixing. A null
+     * output just consumes the samples.
+     */
+    void read(ALvoid *OutBuffer, ALsizei frames);
+    void readPlanar(ALfloat *const *OutBuffers, ALsizei frames);
+
+    DEF_NEWDEL(OutputMirror)
+
+private:
+    ALsizei prepare();
+};
+using OutputMirrorPtr = std::unique_ptr<OutputMirror>;
+
+#endif /* MIRROR_H */
@@ -18,6 +18,8 @@ struct SSETag { };
 struct SSE2Tag { };
 struct SSE3Tag { };
 struct SSE4Tag { };
+struct AVX2Tag { };
+struct AVX512Tag { };
 struct NEONTag { };
 
 struct CopyTag { };
@@ -25,9 +27,12 @@ struct PointTag { };
 struct LerpTag { };
 struct CubicTag { };
 struct BSincTag { };
+struct FastBSincTag { };
 
 template<typename TypeTag, typename InstTag>
 const ALfloat *Resample_(const InterpState *state, const ALfloat *RESTRICT src, ALsizei frac, ALint increment, ALfloat *RESTRICT dst, ALsizei dstlen);
+template<typename TypeTag, typename InstTag>
+void ResampleMulti_(const InterpState *state, const ALfloat *const *RESTRICT src, const ALsizei numchans, ALsizei frac, ALint increment, ALfloat *const *RESTRICT dst, ALsizei dstlen);
 
 template<typename InstTag>
 void Mix_(const ALfloat *data, const ALsizei OutChans, ALfloat (*OutBuffer)[BUFFERSIZE], ALfloat *CurrentGains, const ALfloat *TargetGains, const ALsizei Counter, const ALsizei OutPos, const ALsizei BufferSize);
@@ -38,6 +43,20 @@ template<typename InstTag>
 void MixHrtf_(ALfloat *RESTRICT LeftOut, ALfloat *RESTRICT RightOut, const ALfloat *data, float2 *RESTRICT AccumSamples, const ALsizei OutPos, const ALsizei IrSize, MixHrtfParams *hrtfparams, const ALsizei BufferSize);
 template<typename InstTag>
 void MixHrtfBlend_(ALfloat *RESTRICT LeftOut, ALfloat *RESTRICT RightOut, const ALfloat *data, float2 *RESTRICT AccumSamples, const ALsizei OutPos, const ALsizei IrSize, const HrtfParams *oldparams, MixHrtfParams *newparams, const ALsizei BufferSize);
+template<typename InstTag>
+void BlendHalf_(ALfloat *RESTRICT dst, const ALushort *RESTRICT src, const ALfloat scale, const ALsizei count);
+template<typename InstTag>
+void LoadSamples_(ALfloat *RESTRICT dst, const ALvoid *RESTRICT src, const ALint srcstep, const FmtType srctype, const ALsizei samples);
+template<typename InstTag>
+void StoreSamples_(ALvoid *RESTRICT dst, const ALfloat *const *RESTRICT src, const ALsizei srcchans, const ALsizei dststep, const DevFmtType dsttype, const ALsizei samples);
+template<typename InstTag>
+void Dither_(ALfloat *RESTRICT buffer, ALuint *RESTRICT seeds, const ALfloat quant_scale, const ALsizei samples);
+
+template<typename InstTag>
+void BiquadMulti_(BiquadFilter *const *filters, ALfloat *const *dst, const ALfloat *const *src, const ALsizei numchans, const ALsizei numsamples);
+template<typename InstTag>
+void BiquadCascade_(BiquadFilter *const *filters, ALfloat *const *dst, const ALfloat *const *src, const ALsizei numchans, const ALsizei numsamples);
+
 template<typename InstTag>
 void MixDirectHrtf_(ALfloat *RESTRICT LeftOut, ALfloat *RESTRICT RightOut, const ALfloat (*data)[BUFFERSIZE], float2 *RESTRICT AccumSamples, DirectHrtfState *State, const ALsizei NumChans, const ALsizei BufferSize);
 
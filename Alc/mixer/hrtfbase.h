@@ -10,6 +10,12 @@
 
 using ApplyCoeffsT = void(ALsizei Offset, float2 *RESTRICT Values, const ALsizei irSize,
     const HrirArray<ALfloat> &Coeffs, const ALfloat left, const ALfloat right);
+/* Applies two sets of coefficients with their own (mono) input sample at once,
+ * for the direct HRTF mix.
+ */
+using ApplyCoeffsPairT = void(ALsizei Offset, float2 *RESTRICT Values, const ALsizei irSize,
+    const HrirArray<ALfloat> &Coeffs0, const HrirArray<ALfloat> &Coeffs1, const ALfloat in0,
+    const ALfloat in1);
 
 template<ApplyCoeffsT &ApplyCoeffs>
 inline void MixHrtfBase(ALfloat *RESTRICT LeftOut, ALfloat *RESTRICT RightOut, const ALfloat *data,
@@ -94,7 +100,7 @@ inline void MixHrtfBlendBase(ALfloat *RESTRICT LeftOut, ALfloat *RESTRICT RightO
     newparams->Gain = newGainStep*stepcount;
 }
 
-template<ApplyCoeffsT &ApplyCoeffs>
+template<ApplyCoeffsT &ApplyCoeffs, ApplyCoeffsPairT &ApplyCoeffsPair>
 inline void MixDirectHrtfBase(ALfloat *RESTRICT LeftOut, ALfloat *RESTRICT RightOut,
     const ALfloat (*data)[BUFFERSIZE], float2 *RESTRICT AccumSamples, DirectHrtfState *State,
     const ALsizei NumChans, const ALsizei BufferSize)
@@ -105,28 +111,42 @@ inline void MixDirectHrtfBase(ALfloat *RESTRICT LeftOut, ALfloat *RESTRICT Right
     const ALsizei IrSize{State->IrSize};
     ASSUME(IrSize >= 4);
 
-    for(ALsizei c{0};c < NumChans;++c)
+    /* Every channel's filter output is summed together, so they all share
+     * one accumulation buffer. Channels are applied two at a time, halving
+     * the reads and writes of the accumulated values.
+     */
+    auto accum_iter = std::copy_n(State->Values.begin(), State->Values.size(), AccumSamples);
+    std::fill_n(accum_iter, BufferSize, float2{});
+
+    ALsizei c{0};
+    for(;c+1 < NumChans;c += 2)
+    {
+        const ALfloat (&input0)[BUFFERSIZE] = data[c];
+        const ALfloat (&input1)[BUFFERSIZE] = data[c+1];
+        const auto &Coeffs0 = State->Chan[c].Coeffs;
+        const auto &Coeffs1 = State->Chan[c+1].Coeffs;
+
+        for(ALsizei i{0};i < BufferSize;++i)
+            ApplyCoeffsPair(i, AccumSamples+i, IrSize, Coeffs0, Coeffs1, input0[i], input1[i]);
+    }
+    if(c < NumChans)
     {
         const ALfloat (&input)[BUFFERSIZE] = data[c];
         const auto &Coeffs = State->Chan[c].Coeffs;
 
-        auto accum_iter = std::copy_n(State->Chan[c].Values.begin(),
-            State->Chan[c].Values.size(), AccumSamples);
-        std::fill_n(accum_iter, BufferSize, float2{});
-
         for(ALsizei i{0};i < BufferSize;++i)
         {
             const ALfloat insample{input[i]};
             ApplyCoeffs(i, AccumSamples+i, IrSize, Coeffs, insample, insample);
         }
-        for(ALsizei i{0};i < BufferSize;++i)
-            LeftOut[i]  += AccumSamples[i][0];
-        for(ALsizei i{0};i < BufferSize;++i)
-            RightOut[i] += AccumSamples[i][1];
-
-        std::copy_n(AccumSamples + BufferSize, State->Chan[c].Values.size(),
-            State->Chan[c].Values.begin());
     }
+
+    for(ALsizei i{0};i < BufferSize;++i)
+        LeftOut[i]  += AccumSamples[i][0];
+    for(ALsizei i{0};i < BufferSize;++i)
+        RightOut[i] += AccumSamples[i][1];
+
+    std::copy_n(AccumSamples + BufferSize, State->Values.size(), State->Values.begin());
 }
 
 #endif /* MIXER_HRTFBASE_H */
@@ -0,0 +1,349 @@
+/**
+ * OpenAL cross platform audio library
+ * Copyright (C) 1999-2007 by authors.
+ * This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Library General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ *  License along with this library; if not, write to the
+ *  Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ * Or go to http://www.gnu.org/copyleft/lgpl.html
+ */
+
+#include "config.h"
+
+#include "mixer/kernels.h"
+
+#include "cpu_caps.h"
+#include "mixer/defs.h"
+
+
+KernelList<MixerFunc> GetMixerOptions()
+{
+    KernelList<MixerFunc> list;
+#ifdef HAVE_NEON
+    if((CPUCapFlags&CPU_CAP_NEON))
+        list.add("neon", Mix_<NEONTag>);
+#endif
+#ifdef HAVE_AVX512
+    if((CPUCapFlags&CPU_CAP_AVX512F))
+        list.add("avx512f", Mix_<AVX512Tag>);
+#endif
+#ifdef HAVE_AVX2
+    if((CPUCapFlags&CPU_CAP_AVX2) && (CPUCapFlags&CPU_CAP_FMA))
+        list.add("avx2", Mix_<AVX2Tag>);
+#endif
+#ifdef HAVE_SSE
+    if((CPUCapFlags&CPU_CAP_SSE))
+        list.add("sse", Mix_<SSETag>);
+#endif
+    list.add("c", Mix_<CTag>);
+    return list;
+}
+
+KernelList<RowMixerFunc> GetRowMixerOptions()
+{
+    KernelList<RowMixerFunc> list;
+#ifdef HAVE_NEON
+    if((CPUCapFlags&CPU_CAP_NEON))
+        list.add("neon", MixRow_<NEONTag>);
+#endif
+#ifdef HAVE_AVX512
+    if((CPUCapFlags&CPU_CAP_AVX512F))
+        list.add("avx512f", MixRow_<AVX512Tag>);
+#endif
+#ifdef HAVE_AVX2
+    if((CPUCapFlags&CPU_CAP_AVX2) && (CPUCapFlags&CPU_CAP_FMA))
+        list.add("avx2", MixRow_<AVX2Tag>);
+#endif
+#ifdef HAVE_SSE
+    if((CPUCapFlags&CPU_CAP_SSE))
+        list.add("sse", MixRow_<SSETag>);
+#endif
+    list.add("c", MixRow_<CTag>);
+    return list;
+}
+
+KernelList<HrtfMixerFunc> GetHrtfMixerOptions()
+{
+    KernelList<HrtfMixerFunc> list;
+#ifdef HAVE_NEON
+    if((CPUCapFlags&CPU_CAP_NEON))
+        list.add("neon", MixHrtf_<NEONTag>);
+#endif
+#ifdef HAVE_AVX512
+    if((CPUCapFlags&CPU_CAP_AVX512F))
+        list.add("avx512f", MixHrtf_<AVX512Tag>);
+#endif
+#ifdef HAVE_AVX2
+    if((CPUCapFlags&CPU_CAP_AVX2) && (CPUCapFlags&CPU_CAP_FMA))
+        list.add("avx2", MixHrtf_<AVX2Tag>);
+#endif
+#ifdef HAVE_SSE
+    if((CPUCapFlags&CPU_CAP_SSE))
+        list.add("sse", MixHrtf_<SSETag>);
+#endif
+    list.add("c", MixHrtf_<CTag>);
+    return list;
+}
+
+KernelList<HrtfMixerBlendFunc> GetHrtfBlendMixerOptions()
+{
+    KernelList<HrtfMixerBlendFunc> list;
+#ifdef HAVE_NEON
+    if((CPUCapFlags&CPU_CAP_NEON))
+        list.add("neon", MixHrtfBlend_<NEONTag>);
+#endif
+#ifdef HAVE_AVX512
+    if((CPUCapFlags&CPU_CAP_AVX512F))
+        list.add("avx512f", MixHrtfBlend_<AVX512Tag>);
+#endif
+#ifdef HAVE_AVX2
+    if((CPUCapFlags&CPU_CAP_AVX2) && (CPUCapFlags&CPU_CAP_FMA))
+        list.add("avx2", MixHrtfBlend_<AVX2Tag>);
+#endif
+#ifdef HAVE_SSE
+    if((CPUCapFlags&CPU_CAP_SSE))
+        list.add("sse", MixHrtfBlend_<SSETag>);
+#endif
+    list.add("c", MixHrtfBlend_<CTag>);
+    return list;
+}
+
+KernelList<HrtfDirectMixerFunc> GetDirectHrtfMixerOptions()
+{
+    KernelList<HrtfDirectMixerFunc> list;
+#ifdef HAVE_NEON
+    if((CPUCapFlags&CPU_CAP_NEON))
+        list.add("neon", MixDirectHrtf_<NEONTag>);
+#endif
+#ifdef HAVE_AVX512
+    if((CPUCapFlags&CPU_CAP_AVX512F))
+        list.add("avx512f", MixDirectHrtf_<AVX512Tag>);
+#endif
+#ifdef HAVE_AVX2
+    if((CPUCapFlags&CPU_CAP_AVX2) && (CPUCapFlags&CPU_CAP_FMA))
+        list.add("avx2", MixDirectHrtf_<AVX2Tag>);
+#endif
+#ifdef HAVE_SSE
+    if((CPUCapFlags&CPU_CAP_SSE))
+        list.add("sse", MixDirectHrtf_<SSETag>);
+#endif
+    list.add("c", MixDirectHrtf_<CTag>);
+    return list;
+}
+
+KernelList<HalfBlendFunc> GetHalfBlendOptions()
+{
+    KernelList<HalfBlendFunc> list;
+#ifdef HAVE_NEON
+    if((CPUCapFlags&CPU_CAP_NEON))
+        list.add("neon", BlendHalf_<NEONTag>);
+#endif
+#ifdef HAVE_F16C
+    if((CPUCapFlags&CPU_CAP_AVX2) && (CPUCapFlags&CPU_CAP_FMA) && (CPUCapFlags&CPU_CAP_F16C))
+        list.add("avx2", BlendHalf_<AVX2Tag>);
+#endif
+    list.add("c", BlendHalf_<CTag>);
+    return list;
+}
+
+KernelList<SampleLoadFunc> GetSampleLoadOptions()
+{
+    KernelList<SampleLoadFunc> list;
+#ifdef HAVE_NEON
+    if((CPUCapFlags&CPU_CAP_NEON))
+        list.add("neon", LoadSamples_<NEONTag>);
+#endif
+#ifdef HAVE_SSE2
+    if((CPUCapFlags&CPU_CAP_SSE2))
+        list.add("sse2", LoadSamples_<SSE2Tag>);
+#endif
+    list.add("c", LoadSamples_<CTag>);
+    return list;
+}
+
+KernelList<SampleStoreFunc> GetSampleStoreOptions()
+{
+    KernelList<SampleStoreFunc> list;
+#ifdef HAVE_NEON
+    if((CPUCapFlags&CPU_CAP_NEON))
+        list.add("neon", StoreSamples_<NEONTag>);
+#endif
+#ifdef HAVE_SSE2
+    if((CPUCapFlags&CPU_CAP_SSE2))
+        list.add("sse2", StoreSamples_<SSE2Tag>);
+#endif
+    list.add("c", StoreSamples_<CTag>);
+    return list;
+}
+
+KernelList<DitherFunc> GetDitherOptions()
+{
+    KernelList<DitherFunc> list;
+#ifdef HAVE_NEON
+    if((CPUCapFlags&CPU_CAP_NEON))
+        list.add("neon", Dither_<NEONTag>);
+#endif
+#ifdef HAVE_SSE2
+    if((CPUCapFlags&CPU_CAP_SSE2))
+        list.add("sse2", Dither_<SSE2Tag>);
+#endif
+    list.add("c", Dither_<CTag>);
+    return list;
+}
+
+KernelList<BiquadMultiFunc> GetBiquadMultiOptions()
+{
+    KernelList<BiquadMultiFunc> list;
+#ifdef HAVE_NEON
+    if((CPUCapFlags&CPU_CAP_NEON))
+        list.add("neon", BiquadMulti_<NEONTag>);
+#endif
+#ifdef HAVE_SSE
+    if((CPUCapFlags&CPU_CAP_SSE))
+        list.add("sse", BiquadMulti_<SSETag>);
+#endif
+    list.add("c", BiquadMulti_<CTag>);
+    return list;
+}
+
+KernelList<BiquadCascadeFunc> GetBiquadCascadeOptions()
+{
+    KernelList<BiquadCascadeFunc> list;
+#ifdef HAVE_NEON
+    if((CPUCapFlags&CPU_CAP_NEON))
+        list.add("neon", BiquadCascade_<NEONTag>);
+#endif
+#ifdef HAVE_SSE
+    if((CPUCapFlags&CPU_CAP_SSE))
+        list.add("sse", BiquadCascade_<SSETag>);
+#endif
+    list.add("c", BiquadCascade_<CTag>);
+    return list;
+}
+
+
+ResamplerKernel GetResamplerKernel(Resampler resampler, ALuint increment)
+{
+    switch(resampler)
+    {
+        case PointResampler: return PointKernel;
+        case LinearResampler: return LerpKernel;
+        case FIR4Resampler: return CubicKernel;
+        case BSinc12Resampler:
+        case BSinc24Resampler:
+        case BSinc32Resampler:
+            /* Not downsampling, so the scale factor is 0 and its coefficients
+             * can be skipped.
+             */
+            return (increment <= FRACTIONONE) ? FastBSincKernel : BSincKernel;
+    }
+    return PointKernel;
+}
+
+KernelList<ResamplerFunc> GetResamplerOptions(ResamplerKernel kernel)
+{
+    KernelList<ResamplerFunc> list;
+    switch(kernel)
+    {
+        case PointKernel:
+#ifdef HAVE_AVX2
+            if((CPUCapFlags&CPU_CAP_AVX2))
+                list.add("avx2", Resample_<PointTag,AVX2Tag>);
+#endif
+#ifdef HAVE_NEON
+            if((CPUCapFlags&CPU_CAP_NEON))
+                list.add("neon", Resample_<PointTag,NEONTag>);
+#endif
+#ifdef HAVE_SSE4_1
+            if((CPUCapFlags&CPU_CAP_SSE4_1))
+                list.add("sse4.1", Resample_<PointTag,SSE4Tag>);
+#endif
+#ifdef HAVE_SSE2
+            if((CPUCapFlags&CPU_CAP_SSE2))
+                list.add("sse2", Resample_<PointTag,SSE2Tag>);
+#endif
+            list.add("c", Resample_<PointTag,CTag>);
+            break;
+        case LerpKernel:
+#ifdef HAVE_NEON
+            if((CPUCapFlags&CPU_CAP_NEON))
+                list.add("neon", Resample_<LerpTag,NEONTag>);
+#endif
+#ifdef HAVE_AVX2
+            if((CPUCapFlags&CPU_CAP_AVX2) && (CPUCapFlags&CPU_CAP_FMA))
+                list.add("avx2", Resample_<LerpTag,AVX2Tag>);
+#endif
+#ifdef HAVE_SSE4_1
+            if((CPUCapFlags&CPU_CAP_SSE4_1))
+                list.add("sse4.1", Resample_<LerpTag,SSE4Tag>);
+#endif
+#ifdef HAVE_SSE2
+            if((CPUCapFlags&CPU_CAP_SSE2))
+                list.add("sse2", Resample_<LerpTag,SSE2Tag>);
+#endif
+            list.add("c", Resample_<LerpTag,CTag>);
+            break;
+        case CubicKernel:
+#ifdef HAVE_AVX2
+            if((CPUCapFlags&CPU_CAP_AVX2))
+                list.add("avx2", Resample_<CubicTag,AVX2Tag>);
+#endif
+#ifdef HAVE_NEON
+            if((CPUCapFlags&CPU_CAP_NEON))
+                list.add("neon", Resample_<CubicTag,NEONTag>);
+#endif
+#ifdef HAVE_SSE4_1
+            if((CPUCapFlags&CPU_CAP_SSE4_1))
+                list.add("sse4.1", Resample_<CubicTag,SSE4Tag>);
+#endif
+#ifdef HAVE_SSE2
+            if((CPUCapFlags&CPU_CAP_SSE2))
+                list.add("sse2", Resample_<CubicTag,SSE2Tag>);
+#endif
+            list.add("c", Resample_<CubicTag,CTag>);
+            break;
+        case BSincKernel:
+#ifdef HAVE_NEON
+            if((CPUCapFlags&CPU_CAP_NEON))
+                list.add("neon", Resample_<BSincTag,NEONTag>);
+#endif
+#ifdef HAVE_AVX2
+            if((CPUCapFlags&CPU_CAP_AVX2) && (CPUCapFlags&CPU_CAP_FMA))
+                list.add("avx2", Resample_<BSincTag,AVX2Tag>);
+#endif
+#ifdef HAVE_SSE
+            if((CPUCapFlags&CPU_CAP_SSE))
+                list.add("sse", Resample_<BSincTag,SSETag>);
+#endif
+            list.add("c", Resample_<BSincTag,CTag>);
+            break;
+        case FastBSincKernel:
+#ifdef HAVE_NEON
+            if((CPUCapFlags&CPU_CAP_NEON))
+                list.add("neon", Resample_<FastBSincTag,NEONTag>);
+#endif
+#ifdef HAVE_AVX2
+            if((CPUCapFlags&CPU_CAP_AVX2) && (CPUCapFlags&CPU_CAP_FMA))
+                list.add("avx2", Resample_<FastBSincTag,AVX2Tag>);
+#endif
+#ifdef HAVE_SSE
+            if((CPUCapFlags&CPU_CAP_SSE))
+                list.add("sse", Resample_<FastBSincTag,SSETag>);
+#endif
+            list.add("c", Resample_<FastBSincTag,CTag>);
+            break;
+        case ResamplerKernelCount:
+            break;
+    }
+    return list;
+}
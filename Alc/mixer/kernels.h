@@ -0,0 +1,58 @@
+#ifndef MIXER_KERNELS_H
+#define MIXER_KERNELS_H
+
+#include <array>
+#include <cstddef>
+
+#include "alu.h"
+
+
+/* The specializations of a kernel that can run on this CPU, in order of
+ * preference. The names match those used by disable-cpu-exts.
+ */
+template<typename T>
+struct KernelList {
+    struct Option {
+        const char *name;
+        T func;
+    };
+    std::array<Option,8> options{};
+    size_t count{0};
+
+    void add(const char *name, T func) noexcept { options[count++] = Option{name, func}; }
+    T best() const noexcept { return options[0].func; }
+
+    const Option *begin() const noexcept { return options.data(); }
+    const Option *end() const noexcept { return options.data() + count; }
+};
+
+/* The distinct single-channel resampler kernels. The bsinc12, bsinc24 and
+ * bsinc32 resamplers share the same kernels.
+ */
+enum ResamplerKernel {
+    PointKernel,
+    LerpKernel,
+    CubicKernel,
+    BSincKernel,
+    FastBSincKernel,
+
+    ResamplerKernelCount
+};
+
+ResamplerKernel GetResamplerKernel(Resampler resampler, ALuint increment);
+
+/* These depend on CPUCapFlags, so must be called after it's filled in. */
+KernelList<MixerFunc> GetMixerOptions();
+KernelList<RowMixerFunc> GetRowMixerOptions();
+KernelList<HrtfMixerFunc> GetHrtfMixerOptions();
+KernelList<HrtfMixerBlendFunc> GetHrtfBlendMixerOptions();
+KernelList<HrtfDirectMixerFunc> GetDirectHrtfMixerOptions();
+KernelList<HalfBlendFunc> GetHalfBlendOptions();
+KernelList<SampleLoadFunc> GetSampleLoadOptions();
+KernelList<SampleStoreFunc> GetSampleStoreOptions();
+KernelList<DitherFunc> GetDitherOptions();
+KernelList<BiquadMultiFunc> GetBiquadMultiOptions();
+KernelList<BiquadCascadeFunc> GetBiquadCascadeOptions();
+KernelList<ResamplerFunc> GetResamplerOptions(ResamplerKernel kernel);
+
+#endif /* MIXER_KERNELS_H */
@@ -0,0 +1,671 @@
+#include "config.h"
+
+#include <immintrin.h>
+
+#include <limits>
+
+#include "AL/al.h"
+#include "AL/alc.h"
+#include "alMain.h"
+#include "alu.h"
+
+#include "alSource.h"
+#include "alAuxEffectSlot.h"
+#include "defs.h"
+#include "hrtfbase.h"
+
+
+/* Adds the four elements of the vector together. */
+static inline ALfloat ReduceAdd4(__m128 r4)
+{
+    r4 = _mm_add_ps(r4, _mm_movehl_ps(r4, r4));
+    r4 = _mm_add_ss(r4, _mm_shuffle_ps(r4, r4, _MM_SHUFFLE(1, 1, 1, 1)));
+    return _mm_cvtss_f32(r4);
+}
+
+/* Vector version of cubic(), with the same order of operations. */
+static inline __m256 Cubic8(const __m256 val1, const __m256 val2, const __m256 val3,
+    const __m256 val4, const __m256 mu)
+{
+    const __m256 mu2{_mm256_mul_ps(mu, mu)};
+    const __m256 mu3{_mm256_mul_ps(mu2, mu)};
+    const __m256 a0{_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(-0.5f), mu3), mu2),
+        _mm256_mul_ps(_mm256_set1_ps(-0.5f), mu))};
+    const __m256 a1{_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(1.5f), mu3),
+        _mm256_mul_ps(_mm256_set1_ps(-2.5f), mu2)), _mm256_set1_ps(1.0f))};
+    const __m256 a2{_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(-1.5f), mu3),
+        _mm256_mul_ps(_mm256_set1_ps(2.0f), mu2)), _mm256_mul_ps(_mm256_set1_ps(0.5f), mu))};
+    const __m256 a3{_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(0.5f), mu3),
+        _mm256_mul_ps(_mm256_set1_ps(-0.5f), mu2))};
+    return _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(val1, a0),
+        _mm256_mul_ps(val2, a1)), _mm256_mul_ps(val3, a2)), _mm256_mul_ps(val4, a3));
+}
+
+
+template<>
+const ALfloat *Resample_<PointTag,AVX2Tag>(const InterpState* UNUSED(state),
+  const ALfloat *RESTRICT src, ALsizei frac, ALint increment,
+  ALfloat *RESTRICT dst, ALsizei dstlen)
+{
+    const __m256i increment8{_mm256_set1_epi32(increment*8)};
+    const __m256i fracMask8{_mm256_set1_epi32(FRACTIONMASK)};
+
+    ASSUME(frac >= 0);
+    ASSUME(increment > 0);
+    ASSUME(dstlen >= 0);
+
+    alignas(32) ALsizei pos_[8], frac_[8];
+    InitiatePositionArrays(frac, increment, frac_, pos_, 8);
+    __m256i frac8{_mm256_load_si256(reinterpret_cast<const __m256i*>(frac_))};
+    __m256i pos8{_mm256_load_si256(reinterpret_cast<const __m256i*>(pos_))};
+
+    const ALsizei todo{dstlen & ~7};
+    for(ALsizei i{0};i < todo;i += 8)
+    {
+        _mm256_storeu_ps(&dst[i], _mm256_i32gather_ps(src, pos8, 4));
+
+        frac8 = _mm256_add_epi32(frac8, increment8);
+        pos8 = _mm256_add_epi32(pos8, _mm256_srli_epi32(frac8, FRACTIONBITS));
+        frac8 = _mm256_and_si256(frac8, fracMask8);
+    }
+
+    ALsizei pos{_mm_cvtsi128_si32(_mm256_castsi256_si128(pos8))};
+    frac = _mm_cvtsi128_si32(_mm256_castsi256_si128(frac8));
+
+    for(ALsizei i{todo};i < dstlen;++i)
+    {
+        dst[i] = src[pos];
+
+        frac += increment;
+        pos  += frac>>FRACTIONBITS;
+        frac &= FRACTIONMASK;
+    }
+    return dst;
+}
+
+template<>
+const ALfloat *Resample_<CubicTag,AVX2Tag>(const InterpState* UNUSED(state),
+  const ALfloat *RESTRICT src, ALsizei frac, ALint increment,
+  ALfloat *RESTRICT dst, ALsizei dstlen)
+{
+    const __m256i increment8{_mm256_set1_epi32(increment*8)};
+    const __m256 fracOne8{_mm256_set1_ps(1.0f/FRACTIONONE)};
+    const __m256i fracMask8{_mm256_set1_epi32(FRACTIONMASK)};
+
+    ASSUME(frac >= 0);
+    ASSUME(increment > 0);
+    ASSUME(dstlen >= 0);
+
+    alignas(32) ALsizei pos_[8], frac_[8];
+    InitiatePositionArrays(frac, increment, frac_, pos_, 8);
+    __m256i frac8{_mm256_load_si256(reinterpret_cast<const __m256i*>(frac_))};
+    __m256i pos8{_mm256_load_si256(reinterpret_cast<const __m256i*>(pos_))};
+
+    /* The four sample points start one before the current position. */
+    src -= 1;
+
+    const ALsizei todo{dstlen & ~7};
+    for(ALsizei i{0};i < todo;i += 8)
+    {
+        const __m256 val1{_mm256_i32gather_ps(src, pos8, 4)};
+        const __m256 val2{_mm256_i32gather_ps(src+1, pos8, 4)};
+        const __m256 val3{_mm256_i32gather_ps(src+2, pos8, 4)};
+        const __m256 val4{_mm256_i32gather_ps(src+3, pos8, 4)};
+
+        const __m256 mu{_mm256_mul_ps(_mm256_cvtepi32_ps(frac8), fracOne8)};
+        _mm256_storeu_ps(&dst[i], Cubic8(val1, val2, val3, val4, mu));
+
+        frac8 = _mm256_add_epi32(frac8, increment8);
+        pos8 = _mm256_add_epi32(pos8, _mm256_srli_epi32(frac8, FRACTIONBITS));
+        frac8 = _mm256_and_si256(frac8, fracMask8);
+    }
+
+    /* NOTE: These eight elements represent the position *after* the last
+     * eight samples, so the lowest element is the next position to resample.
+     */
+    ALsizei pos{_mm_cvtsi128_si32(_mm256_castsi256_si128(pos8))};
+    frac = _mm_cvtsi128_si32(_mm256_castsi256_si128(frac8));
+
+    for(ALsizei i{todo};i < dstlen;++i)
+    {
+        dst[i] = cubic(src[pos], src[pos+1], src[pos+2], src[pos+3], frac * (1.0f/FRACTIONONE));
+
+        frac += increment;
+        pos  += frac>>FRACTIONBITS;
+        frac &= FRACTIONMASK;
+    }
+    return dst;
+}
+
+
+template<>
+const ALfloat *Resample_<LerpTag,AVX2Tag>(const InterpState* UNUSED(state),
+  const ALfloat *RESTRICT src, ALsizei frac, ALint increment,
+  ALfloat *RESTRICT dst, ALsizei dstlen)
+{
+    const __m256i increment8{_mm256_set1_epi32(increment*8)};
+    const __m256 fracOne8{_mm256_set1_ps(1.0f/FRACTIONONE)};
+    const __m256i fracMask8{_mm256_set1_epi32(FRACTIONMASK)};
+
+    ASSUME(frac >= 0);
+    ASSUME(increment > 0);
+    ASSUME(dstlen >= 0);
+
+    alignas(32) ALsizei pos_[8], frac_[8];
+    InitiatePositionArrays(frac, increment, frac_, pos_, 8);
+    __m256i frac8{_mm256_load_si256(reinterpret_cast<const __m256i*>(frac_))};
+    __m256i pos8{_mm256_load_si256(reinterpret_cast<const __m256i*>(pos_))};
+
+    const ALsizei todo{dstlen & ~7};
+    for(ALsizei i{0};i < todo;i += 8)
+    {
+        const __m256 val1{_mm256_i32gather_ps(src, pos8, 4)};
+        const __m256 val2{_mm256_i32gather_ps(src+1, pos8, 4)};
+
+        /* val1 + (val2-val1)*mu */
+        const __m256 r0{_mm256_sub_ps(val2, val1)};
+        const __m256 mu{_mm256_mul_ps(_mm256_cvtepi32_ps(frac8), fracOne8)};
+        const __m256 out{_mm256_fmadd_ps(mu, r0, val1)};
+
+        _mm256_storeu_ps(&dst[i], out);
+
+        frac8 = _mm256_add_epi32(frac8, increment8);
+        pos8 = _mm256_add_epi32(pos8, _mm256_srli_epi32(frac8, FRACTIONBITS));
+        frac8 = _mm256_and_si256(frac8, fracMask8);
+    }
+
+    /* NOTE: These eight elements represent the position *after* the last
+     * eight samples, so the lowest element is the next position to resample.
+     */
+    ALsizei pos{_mm_cvtsi128_si32(_mm256_castsi256_si128(pos8))};
+    frac = _mm_cvtsi128_si32(_mm256_castsi256_si128(frac8));
+
+    for(ALsizei i{todo};i < dstlen;++i)
+    {
+        dst[i] = lerp(src[pos], src[pos+1], frac * (1.0f/FRACTIONONE));
+
+        frac += increment;
+        pos  += frac>>FRACTIONBITS;
+        frac &= FRACTIONMASK;
+    }
+    return dst;
+}
+
+template<>
+const ALfloat *Resample_<BSincTag,AVX2Tag>(const InterpState *state, const ALfloat *RESTRICT src,
+    ALsizei frac, ALint increment, ALfloat *RESTRICT dst, ALsizei dstlen)
+{
+    const ALfloat *const filter{state->bsinc.filter};
+    const __m256 sf8{_mm256_set1_ps(state->bsinc.sf)};
+    const ALsizei m{state->bsinc.m};
+
+    ASSUME(m > 0);
+    ASSUME(dstlen > 0);
+    ASSUME(increment > 0);
+    ASSUME(frac >= 0);
+
+    src -= state->bsinc.l;
+    for(ALsizei i{0};i < dstlen;i++)
+    {
+        // Calculate the phase index and factor.
+#define FRAC_PHASE_BITDIFF (FRACTIONBITS-BSINC_PHASE_BITS)
+        const ALsizei pi{frac >> FRAC_PHASE_BITDIFF};
+        const ALfloat pf{(frac & ((1<<FRAC_PHASE_BITDIFF)-1)) * (1.0f/(1<<FRAC_PHASE_BITDIFF))};
+#undef FRAC_PHASE_BITDIFF
+
+        /* The filter is only guaranteed 16-byte alignment, and its length a
+         * multiple of 4.
+         */
+        ALsizei offset{m*pi*4};
+        const ALfloat *fil{filter + offset}; offset += m;
+        const ALfloat *scd{filter + offset}; offset += m;
+        const ALfloat *phd{filter + offset}; offset += m;
+        const ALfloat *spd{filter + offset};
+
+        // Apply the scale and phase interpolated filter.
+        __m256 r8{_mm256_setzero_ps()};
+        const __m256 pf8{_mm256_set1_ps(pf)};
+        ALsizei j{0};
+        for(;j < (m&~7);j += 8)
+        {
+            /* f = ((fil + sf*scd) + pf*(phd + sf*spd)) */
+            const __m256 f8{_mm256_fmadd_ps(pf8,
+                _mm256_fmadd_ps(sf8, _mm256_loadu_ps(&spd[j]), _mm256_loadu_ps(&phd[j])),
+                _mm256_fmadd_ps(sf8, _mm256_loadu_ps(&scd[j]), _mm256_loadu_ps(&fil[j])))};
+            /* r += f*src */
+            r8 = _mm256_fmadd_ps(f8, _mm256_loadu_ps(&src[j]), r8);
+        }
+        __m128 r4{_mm_add_ps(_mm256_castps256_ps128(r8), _mm256_extractf128_ps(r8, 1))};
+        if(j < m)
+        {
+            const __m128 sf4{_mm256_castps256_ps128(sf8)};
+            const __m128 pf4{_mm256_castps256_ps128(pf8)};
+            const __m128 f4{_mm_fmadd_ps(pf4,
+                _mm_fmadd_ps(sf4, _mm_load_ps(&spd[j]), _mm_load_ps(&phd[j])),
+                _mm_fmadd_ps(sf4, _mm_load_ps(&scd[j]), _mm_load_ps(&fil[j])))};
+            r4 = _mm_fmadd_ps(f4, _mm_loadu_ps(&src[j]), r4);
+        }
+        dst[i] = ReduceAdd4(r4);
+
+        frac += increment;
+        src  += frac>>FRACTIONBITS;
+        frac &= FRACTIONMASK;
+    }
+    return dst;
+}
+
+template<>
+const ALfloat *Resample_<FastBSincTag,AVX2Tag>(const InterpState *state,
+    const ALfloat *RESTRICT src, ALsizei frac, ALint increment, ALfloat *RESTRICT dst,
+    ALsizei dstlen)
+{
+    const ALfloat *const filter{state->bsinc.filter};
+    const ALsizei m{state->bsinc.m};
+
+    ASSUME(m > 0);
+    ASSUME(dstlen > 0);
+    ASSUME(increment > 0);
+    ASSUME(frac >= 0);
+
+    src -= state->bsinc.l;
+    for(ALsizei i{0};i < dstlen;i++)
+    {
+        // Calculate the phase index and factor.
+#define FRAC_PHASE_BITDIFF (FRACTIONBITS-BSINC_PHASE_BITS)
+        const ALsizei pi{frac >> FRAC_PHASE_BITDIFF};
+        const ALfloat pf{(frac & ((1<<FRAC_PHASE_BITDIFF)-1)) * (1.0f/(1<<FRAC_PHASE_BITDIFF))};
+#undef FRAC_PHASE_BITDIFF
+
+        ALsizei offset{m*pi*4};
+        const ALfloat *fil{filter + offset}; offset += m*2;
+        const ALfloat *phd{filter + offset};
+
+        // Apply the phase interpolated filter.
+        __m256 r8{_mm256_setzero_ps()};
+        const __m256 pf8{_mm256_set1_ps(pf)};
+        ALsizei j{0};
+        for(;j < (m&~7);j += 8)
+        {
+            /* f = fil + pf*phd */
+            const __m256 f8{_mm256_fmadd_ps(pf8, _mm256_loadu_ps(&phd[j]),
+                _mm256_loadu_ps(&fil[j]))};
+            /* r += f*src */
+            r8 = _mm256_fmadd_ps(f8, _mm256_loadu_ps(&src[j]), r8);
+        }
+        __m128 r4{_mm_add_ps(_mm256_castps256_ps128(r8), _mm256_extractf128_ps(r8, 1))};
+        if(j < m)
+        {
+            const __m128 pf4{_mm256_castps256_ps128(pf8)};
+            const __m128 f4{_mm_fmadd_ps(pf4, _mm_load_ps(&phd[j]), _mm_load_ps(&fil[j]))};
+            r4 = _mm_fmadd_ps(f4, _mm_loadu_ps(&src[j]), r4);
+        }
+        dst[i] = ReduceAdd4(r4);
+
+        frac += increment;
+        src  += frac>>FRACTIONBITS;
+        frac &= FRACTIONMASK;
+    }
+    return dst;
+}
+
+template<>
+void ResampleMulti_<BSincTag,AVX2Tag>(const InterpState *state,
+    const ALfloat *const *RESTRICT src, const ALsizei numchans, ALsizei frac, ALint increment,
+    ALfloat *const *RESTRICT dst, ALsizei dstlen)
+{
+    const ALfloat *const filter{state->bsinc.filter};
+    const __m256 sf8{_mm256_set1_ps(state->bsinc.sf)};
+    const ALsizei m{state->bsinc.m};
+    const ALsizei l{state->bsinc.l};
+    const ALsizei m8{m&~7};
+
+    ASSUME(m > 0);
+    ASSUME(numchans > 0);
+    ASSUME(dstlen > 0);
+    ASSUME(increment > 0);
+    ASSUME(frac >= 0);
+
+    alignas(32) ALfloat f[MAX_RESAMPLE_PADDING*2];
+    ALsizei pos{0};
+    for(ALsizei i{0};i < dstlen;i++)
+    {
+        // Calculate the phase index and factor.
+#define FRAC_PHASE_BITDIFF (FRACTIONBITS-BSINC_PHASE_BITS)
+        const ALsizei pi{frac >> FRAC_PHASE_BITDIFF};
+        const ALfloat pf{(frac & ((1<<FRAC_PHASE_BITDIFF)-1)) * (1.0f/(1<<FRAC_PHASE_BITDIFF))};
+#undef FRAC_PHASE_BITDIFF
+
+        ALsizei offset{m*pi*4};
+        const ALfloat *fil{filter + offset}; offset += m;
+        const ALfloat *scd{filter + offset}; offset += m;
+        const ALfloat *phd{filter + offset}; offset += m;
+        const ALfloat *spd{filter + offset};
+
+        // Interpolate the filter once, then apply it to each channel.
+        const __m256 pf8{_mm256_set1_ps(pf)};
+        ALsizei j{0};
+        for(;j < m8;j += 8)
+        {
+            /* f = ((fil + sf*scd) + pf*(phd + sf*spd)) */
+            _mm256_store_ps(&f[j], _mm256_fmadd_ps(pf8,
+                _mm256_fmadd_ps(sf8, _mm256_loadu_ps(&spd[j]), _mm256_loadu_ps(&phd[j])),
+                _mm256_fmadd_ps(sf8, _mm256_loadu_ps(&scd[j]), _mm256_loadu_ps(&fil[j]))));
+        }
+        if(j < m)
+        {
+            const __m128 sf4{_mm256_castps256_ps128(sf8)};
+            const __m128 pf4{_mm256_castps256_ps128(pf8)};
+            _mm_store_ps(&f[j], _mm_fmadd_ps(pf4,
+                _mm_fmadd_ps(sf4, _mm_load_ps(&spd[j]), _mm_load_ps(&phd[j])),
+                _mm_fmadd_ps(sf4, _mm_load_ps(&scd[j]), _mm_load_ps(&fil[j]))));
+        }
+        for(ALsizei c{0};c < numchans;c++)
+        {
+            const ALfloat *RESTRICT vals{src[c] + pos - l};
+            /* r += f*src */
+            __m256 r8{_mm256_setzero_ps()};
+            for(j = 0;j < m8;j += 8)
+                r8 = _mm256_fmadd_ps(_mm256_load_ps(&f[j]), _mm256_loadu_ps(&vals[j]), r8);
+            __m128 r4{_mm_add_ps(_mm256_castps256_ps128(r8), _mm256_extractf128_ps(r8, 1))};
+            if(j < m)
+                r4 = _mm_fmadd_ps(_mm_load_ps(&f[j]), _mm_loadu_ps(&vals[j]), r4);
+            dst[c][i] = ReduceAdd4(r4);
+        }
+
+        frac += increment;
+        pos  += frac>>FRACTIONBITS;
+        frac &= FRACTIONMASK;
+    }
+}
+
+template<>
+void ResampleMulti_<FastBSincTag,AVX2Tag>(const InterpState *state,
+    const ALfloat *const *RESTRICT src, const ALsizei numchans, ALsizei frac, ALint increment,
+    ALfloat *const *RESTRICT dst, ALsizei dstlen)
+{
+    const ALfloat *const filter{state->bsinc.filter};
+    const ALsizei m{state->bsinc.m};
+    const ALsizei l{state->bsinc.l};
+    const ALsizei m8{m&~7};
+
+    ASSUME(m > 0);
+    ASSUME(numchans > 0);
+    ASSUME(dstlen > 0);
+    ASSUME(increment > 0);
+    ASSUME(frac >= 0);
+
+    alignas(32) ALfloat f[MAX_RESAMPLE_PADDING*2];
+    ALsizei pos{0};
+    for(ALsizei i{0};i < dstlen;i++)
+    {
+        // Calculate the phase index and factor.
+#define FRAC_PHASE_BITDIFF (FRACTIONBITS-BSINC_PHASE_BITS)
+        const ALsizei pi{frac >> FRAC_PHASE_BITDIFF};
+        const ALfloat pf{(frac & ((1<<FRAC_PHASE_BITDIFF)-1)) * (1.0f/(1<<FRAC_PHASE_BITDIFF))};
+#undef FRAC_PHASE_BITDIFF
+
+        ALsizei offset{m*pi*4};
+        const ALfloat *fil{filter + offset}; offset += m*2;
+        const ALfloat *phd{filter + offset};
+
+        // Interpolate the filter once, then apply it to each channel.
+        const __m256 pf8{_mm256_set1_ps(pf)};
+        ALsizei j{0};
+        for(;j < m8;j += 8)
+        {
+            /* f = fil + pf*phd */
+            _mm256_store_ps(&f[j], _mm256_fmadd_ps(pf8, _mm256_loadu_ps(&phd[j]),
+                _mm256_loadu_ps(&fil[j])));
+        }
+        if(j < m)
+        {
+            const __m128 pf4{_mm256_castps256_ps128(pf8)};
+            _mm_store_ps(&f[j], _mm_fmadd_ps(pf4, _mm_load_ps(&phd[j]), _mm_load_ps(&fil[j])));
+        }
+        for(ALsizei c{0};c < numchans;c++)
+        {
+            const ALfloat *RESTRICT vals{src[c] + pos - l};
+            /* r += f*src */
+            __m256 r8{_mm256_setzero_ps()};
+            for(j = 0;j < m8;j += 8)
+                r8 = _mm256_fmadd_ps(_mm256_load_ps(&f[j]), _mm256_loadu_ps(&vals[j]), r8);
+            __m128 r4{_mm_add_ps(_mm256_castps256_ps128(r8), _mm256_extractf128_ps(r8, 1))};
+            if(j < m)
+                r4 = _mm_fmadd_ps(_mm_load_ps(&f[j]), _mm_loadu_ps(&vals[j]), r4);
+            dst[c][i] = ReduceAdd4(r4);
+        }
+
+        frac += increment;
+        pos  += frac>>FRACTIONBITS;
+        frac &= FRACTIONMASK;
+    }
+}
+
+
+static inline void ApplyCoeffs(ALsizei /*Offset*/, float2 *RESTRICT Values, const ALsizei IrSize,
+    const HrirArray<ALfloat> &Coeffs, const ALfloat left, const ALfloat right)
+{
+    ASSUME(IrSize >= 2);
+
+    /* The accumulation buffer is only aligned to the float pairs, so this
+     * uses unaligned loads and stores, four pairs at a time.
+     */
+    const __m256 lrlr{_mm256_setr_ps(left, right, left, right, left, right, left, right)};
+    ALsizei i{0};
+    for(;i+4 <= IrSize;i += 4)
+    {
+        const __m256 coeffs{_mm256_loadu_ps(&Coeffs[i][0])};
+        const __m256 vals{_mm256_loadu_ps(&Values[i][0])};
+        _mm256_storeu_ps(&Values[i][0], _mm256_fmadd_ps(lrlr, coeffs, vals));
+    }
+    for(;i < IrSize;++i)
+    {
+        Values[i][0] += Coeffs[i][0]*left;
+        Values[i][1] += Coeffs[i][1]*right;
+    }
+}
+
+static inline void ApplyCoeffsPair(ALsizei /*Offset*/, float2 *RESTRICT Values,
+    const ALsizei IrSize, const HrirArray<ALfloat> &Coeffs0, const HrirArray<ALfloat> &Coeffs1,
+    const ALfloat in0, const ALfloat in1)
+{
+    ASSUME(IrSize >= 2);
+
+    const __m256 in0_8{_mm256_set1_ps(in0)};
+    const __m256 in1_8{_mm256_set1_ps(in1)};
+    ALsizei i{0};
+    for(;i+4 <= IrSize;i += 4)
+    {
+        const __m256 coeffs0{_mm256_loadu_ps(&Coeffs0[i][0])};
+        const __m256 coeffs1{_mm256_loadu_ps(&Coeffs1[i][0])};
+        __m256 vals{_mm256_loadu_ps(&Values[i][0])};
+        vals = _mm256_fmadd_ps(in0_8, coeffs0, vals);
+        vals = _mm256_fmadd_ps(in1_8, coeffs1, vals);
+        _mm256_storeu_ps(&Values[i][0], vals);
+    }
+    for(;i < IrSize;++i)
+    {
+        Values[i][0] += Coeffs0[i][0]*in0 + Coeffs1[i][0]*in1;
+        Values[i][1] += Coeffs0[i][1]*in0 + Coeffs1[i][1]*in1;
+    }
+}
+
+template<>
+void MixHrtf_<AVX2Tag>(ALfloat *RESTRICT LeftOut, ALfloat *RESTRICT RightOut, const ALfloat *data,
+    float2 *RESTRICT AccumSamples, const ALsizei OutPos, const ALsizei IrSize,
+    MixHrtfParams *hrtfparams, const ALsizei BufferSize)
+{
+    MixHrtfBase<ApplyCoeffs>(LeftOut, RightOut, data, AccumSamples, OutPos, IrSize, hrtfparams,
+        BufferSize);
+}
+
+template<>
+void MixHrtfBlend_<AVX2Tag>(ALfloat *RESTRICT LeftOut, ALfloat *RESTRICT RightOut,
+    const ALfloat *data, float2 *RESTRICT AccumSamples, const ALsizei OutPos, const ALsizei IrSize,
+    const HrtfParams *oldparams, MixHrtfParams *newparams, const ALsizei BufferSize)
+{
+    MixHrtfBlendBase<ApplyCoeffs>(LeftOut, RightOut, data, AccumSamples, OutPos, IrSize, oldparams,
+        newparams, BufferSize);
+}
+
+template<>
+void MixDirectHrtf_<AVX2Tag>(ALfloat *RESTRICT LeftOut, ALfloat *RESTRICT RightOut,
+    const ALfloat (*data)[BUFFERSIZE], float2 *RESTRICT AccumSamples, DirectHrtfState *State,
+    const ALsizei NumChans, const ALsizei BufferSize)
+{
+    MixDirectHrtfBase<ApplyCoeffs, ApplyCoeffsPair>(LeftOut, RightOut, data, AccumSamples,
+        State, NumChans, BufferSize);
+}
+
+
+template<>
+void Mix_<AVX2Tag>(const ALfloat *data, const ALsizei OutChans, ALfloat (*OutBuffer)[BUFFERSIZE],
+    ALfloat *CurrentGains, const ALfloat *TargetGains, const ALsizei Counter, const ALsizei OutPos,
+    const ALsizei BufferSize)
+{
+    ASSUME(OutChans > 0);
+    ASSUME(BufferSize > 0);
+
+    const ALfloat delta{(Counter > 0) ? 1.0f / static_cast<ALfloat>(Counter) : 0.0f};
+    for(ALsizei c{0};c < OutChans;c++)
+    {
+        ALfloat *RESTRICT dst{al::assume_aligned<16>(&OutBuffer[c][OutPos])};
+        ALsizei pos{0};
+        ALfloat gain{CurrentGains[c]};
+        const ALfloat diff{TargetGains[c] - gain};
+
+        if(std::fabs(diff) > std::numeric_limits<float>::epsilon())
+        {
+            ALsizei minsize{mini(BufferSize, Counter)};
+            const ALfloat step{diff * delta};
+            ALfloat step_count{0.0f};
+            /* Mix with applying gain steps in multiples of 8. */
+            if(LIKELY(minsize > 7))
+            {
+                const __m256 eight8{_mm256_set1_ps(8.0f)};
+                const __m256 step8{_mm256_set1_ps(step)};
+                const __m256 gain8{_mm256_set1_ps(gain)};
+                __m256 step_count8{_mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f)};
+                ALsizei todo{minsize >> 3};
+                do {
+                    const __m256 val8{_mm256_loadu_ps(&data[pos])};
+                    __m256 dry8{_mm256_loadu_ps(&dst[pos])};
+                    /* dry += val * (gain + step*step_count) */
+                    dry8 = _mm256_fmadd_ps(val8, _mm256_fmadd_ps(step8, step_count8, gain8), dry8);
+                    _mm256_storeu_ps(&dst[pos], dry8);
+                    step_count8 = _mm256_add_ps(step_count8, eight8);
+                    pos += 8;
+                } while(--todo);
+                /* NOTE: step_count8 now represents the next eight counts after
+                 * the last eight mixed samples, so the lowest element
+                 * represents the next step count to apply.
+                 */
+                step_count = _mm256_cvtss_f32(step_count8);
+            }
+            /* Mix with applying left over gain steps that aren't multiples of
+             * 8.
+             */
+            for(;pos < minsize;pos++)
+            {
+                dst[pos] += data[pos]*(gain + step*step_count);
+                step_count += 1.0f;
+            }
+            if(pos == Counter)
+                gain = TargetGains[c];
+            else
+                gain += step*step_count;
+            CurrentGains[c] = gain;
+
+            /* Mix until pos is aligned with 4 or the mix is done. */
+            minsize = mini(BufferSize, (pos+3)&~3);
+            for(;pos < minsize;pos++)
+                dst[pos] += data[pos]*gain;
+        }
+
+        if(!(std::fabs(gain) > GAIN_SILENCE_THRESHOLD))
+            continue;
+        if(LIKELY(BufferSize-pos > 7))
+        {
+            ALsizei todo{(BufferSize-pos) >> 3};
+            const __m256 gain8{_mm256_set1_ps(gain)};
+            do {
+                const __m256 val8{_mm256_loadu_ps(&data[pos])};
+                __m256 dry8{_mm256_loadu_ps(&dst[pos])};
+                dry8 = _mm256_fmadd_ps(val8, gain8, dry8);
+                _mm256_storeu_ps(&dst[pos], dry8);
+                pos += 8;
+            } while(--todo);
+        }
+        if(BufferSize-pos > 3)
+        {
+            const __m128 val4{_mm_load_ps(&data[pos])};
+            __m128 dry4{_mm_load_ps(&dst[pos])};
+            dry4 = _mm_fmadd_ps(val4, _mm_set1_ps(gain), dry4);
+            _mm_store_ps(&dst[pos], dry4);
+            pos += 4;
+        }
+        for(;pos < BufferSize;pos++)
+            dst[pos] += data[pos]*gain;
+    }
+}
+
+template<>
+void MixRow_<AVX2Tag>(ALfloat *OutBuffer, const ALfloat *Gains, const ALfloat (*data)[BUFFERSIZE],
+    const ALsizei InChans, const ALsizei InPos, const ALsizei BufferSize)
+{
+    ASSUME(InChans > 0);
+    ASSUME(BufferSize > 0);
+
+    for(ALsizei c{0};c < InChans;c++)
+    {
+        const ALfloat *RESTRICT src{al::assume_aligned<16>(&data[c][InPos])};
+        const ALfloat gain{Gains[c]};
+        if(!(std::fabs(gain) > GAIN_SILENCE_THRESHOLD))
+            continue;
+
+        ALsizei pos{0};
+        if(LIKELY(BufferSize > 7))
+        {
+            ALsizei todo{BufferSize >> 3};
+            const __m256 gain8{_mm256_set1_ps(gain)};
+            do {
+                const __m256 val8{_mm256_loadu_ps(&src[pos])};
+                __m256 dry8{_mm256_loadu_ps(&OutBuffer[pos])};
+                dry8 = _mm256_fmadd_ps(val8, gain8, dry8);
+                _mm256_storeu_ps(&OutBuffer[pos], dry8);
+                pos += 8;
+            } while(--todo);
+        }
+        if(BufferSize-pos > 3)
+        {
+            const __m128 val4{_mm_load_ps(&src[pos])};
+            __m128 dry4{_mm_load_ps(&OutBuffer[pos])};
+            dry4 = _mm_fmadd_ps(val4, _mm_set1_ps(gain), dry4);
+            _mm_store_ps(&OutBuffer[pos], dry4);
+            pos += 4;
+        }
+        for(;pos < BufferSize;pos++)
+            OutBuffer[pos] += src[pos]*gain;
+    }
+}
+
+#ifdef HAVE_F16C
+template<>
+void BlendHalf_<AVX2Tag>(ALfloat *RESTRICT dst, const ALushort *RESTRICT src,
+    const ALfloat scale, const ALsizei count)
+{
+    ASSUME(count > 0);
+
+    const __m256 scale8{_mm256_set1_ps(scale)};
+    ALsizei pos{0};
+    for(;count-pos > 7;pos += 8)
+    {
+        /* Widen eight halfs to floats with F16C. */
+        const __m128i half8{_mm_loadu_si128(reinterpret_cast<const __m128i*>(&src[pos]))};
+        const __m256 vals{_mm256_cvtph_ps(half8)};
+        _mm256_storeu_ps(&dst[pos], _mm256_fmadd_ps(vals, scale8, _mm256_loadu_ps(&dst[pos])));
+    }
+    for(;pos < count;pos++)
+        dst[pos] = half2float(src[pos])*scale + dst[pos];
+}
+#endif
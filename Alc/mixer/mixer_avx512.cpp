@@ -0,0 +1,372 @@
+#include "config.h"
+
+#include <immintrin.h>
+
+#include <limits>
+
+#include "AL/al.h"
+#include "AL/alc.h"
+#include "alMain.h"
+#include "alu.h"
+
+#include "defs.h"
+#include "hrtfbase.h"
+
+
+/* Returns a mask selecting the first min(count, 16) elements. */
+static inline __mmask16 TailMask(const ALsizei count)
+{ return (count >= 16) ? __mmask16(0xffff) : static_cast<__mmask16>((1u<<count) - 1u); }
+
+
+/* The mixing buffers are stored per channel, so each vector holds sixteen
+ * samples of one channel, with its gain broadcast. Any partial set of samples
+ * at the end is handled with masked loads and stores instead of scalar loops.
+ */
+template<>
+void Mix_<AVX512Tag>(const ALfloat *data, const ALsizei OutChans,
+    ALfloat (*OutBuffer)[BUFFERSIZE], ALfloat *CurrentGains, const ALfloat *TargetGains,
+    const ALsizei Counter, const ALsizei OutPos, const ALsizei BufferSize)
+{
+    ASSUME(OutChans > 0);
+    ASSUME(BufferSize > 0);
+
+    const ALfloat delta{(Counter > 0) ? 1.0f / static_cast<ALfloat>(Counter) : 0.0f};
+    for(ALsizei c{0};c < OutChans;c++)
+    {
+        ALfloat *RESTRICT dst{al::assume_aligned<16>(&OutBuffer[c][OutPos])};
+        ALsizei pos{0};
+        ALfloat gain{CurrentGains[c]};
+        const ALfloat diff{TargetGains[c] - gain};
+
+        if(std::fabs(diff) > std::numeric_limits<float>::epsilon())
+        {
+            const ALsizei minsize{mini(BufferSize, Counter)};
+            const ALfloat step{diff * delta};
+            const __m512 sixteen16{_mm512_set1_ps(16.0f)};
+            const __m512 step16{_mm512_set1_ps(step)};
+            const __m512 gain16{_mm512_set1_ps(gain)};
+            __m512 step_count16{_mm512_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f,
+                7.0f, 8.0f, 9.0f, 10.0f, 11.0f, 12.0f, 13.0f, 14.0f, 15.0f)};
+            for(;pos < minsize;pos += 16)
+            {
+                const __mmask16 mask{TailMask(minsize-pos)};
+                const __m512 val16{_mm512_maskz_loadu_ps(mask, &data[pos])};
+                __m512 dry16{_mm512_maskz_loadu_ps(mask, &dst[pos])};
+                /* dry += val * (gain + step*step_count) */
+                dry16 = _mm512_fmadd_ps(val16, _mm512_fmadd_ps(step16, step_count16, gain16),
+                    dry16);
+                _mm512_mask_storeu_ps(&dst[pos], mask, dry16);
+                step_count16 = _mm512_add_ps(step_count16, sixteen16);
+            }
+            pos = minsize;
+            if(pos == Counter)
+                gain = TargetGains[c];
+            else
+                gain += step*static_cast<ALfloat>(pos);
+            CurrentGains[c] = gain;
+        }
+
+        if(!(std::fabs(gain) > GAIN_SILENCE_THRESHOLD))
+            continue;
+        const __m512 gain16{_mm512_set1_ps(gain)};
+        for(;pos < BufferSize;pos += 16)
+        {
+            const __mmask16 mask{TailMask(BufferSize-pos)};
+            const __m512 val16{_mm512_maskz_loadu_ps(mask, &data[pos])};
+            __m512 dry16{_mm512_maskz_loadu_ps(mask, &dst[pos])};
+            dry16 = _mm512_fmadd_ps(val16, gain16, dry16);
+            _mm512_mask_storeu_ps(&dst[pos], mask, dry16);
+        }
+    }
+}
+
+template<>
+void MixRow_<AVX512Tag>(ALfloat *OutBuffer, const ALfloat *Gains,
+    const ALfloat (*data)[BUFFERSIZE], const ALsizei InChans, const ALsizei InPos,
+    const ALsizei BufferSize)
+{
+    ASSUME(InChans > 0);
+    ASSUME(BufferSize > 0);
+
+    for(ALsizei c{0};c < InChans;c++)
+    {
+        const ALfloat *RESTRICT src{al::assume_aligned<16>(&data[c][InPos])};
+        const ALfloat gain{Gains[c]};
+        if(!(std::fabs(gain) > GAIN_SILENCE_THRESHOLD))
+            continue;
+
+        const __m512 gain16{_mm512_set1_ps(gain)};
+        for(ALsizei pos{0};pos < BufferSize;pos += 16)
+        {
+            const __mmask16 mask{TailMask(BufferSize-pos)};
+            const __m512 val16{_mm512_maskz_loadu_ps(mask, &src[pos])};
+            __m512 dry16{_mm512_maskz_loadu_ps(mask, &OutBuffer[pos])};
+            dry16 = _mm512_fmadd_ps(val16, gain16, dry16);
+            _mm512_mask_storeu_ps(&OutBuffer[pos], mask, dry16);
+        }
+    }
+}
+
+
+/* The HRIR coefficients and accumulation buffer are stored as interleaved
+ * left/right pairs, so each vector holds eight pairs. A partial set of pairs
+ * at the end of the IR is handled with a masked load and store.
+ */
+static inline void ApplyCoeffs(ALsizei /*Offset*/, float2 *RESTRICT Values, const ALsizei IrSize,
+    const HrirArray<ALfloat> &Coeffs, const ALfloat left, const ALfloat right)
+{
+    ASSUME(IrSize >= 2);
+
+    const __m512 lrlr{_mm512_setr_ps(left, right, left, right, left, right, left, right,
+        left, right, left, right, left, right, left, right)};
+    for(ALsizei i{0};i < IrSize;i += 8)
+    {
+        const __mmask16 mask{TailMask((IrSize-i)*2)};
+        const __m512 coeffs{_mm512_maskz_loadu_ps(mask, &Coeffs[i][0])};
+        const __m512 vals{_mm512_maskz_loadu_ps(mask, &Values[i][0])};
+        _mm512_mask_storeu_ps(&Values[i][0], mask, _mm512_fmadd_ps(lrlr, coeffs, vals));
+    }
+}
+
+static inline void ApplyCoeffsPair(ALsizei /*Offset*/, float2 *RESTRICT Values,
+    const ALsizei IrSize, const HrirArray<ALfloat> &Coeffs0, const HrirArray<ALfloat> &Coeffs1,
+    const ALfloat in0, const ALfloat in1)
+{
+    ASSUME(IrSize >= 2);
+
+    const __m512 in0_16{_mm512_set1_ps(in0)};
+    const __m512 in1_16{_mm512_set1_ps(in1)};
+    for(ALsizei i{0};i < IrSize;i += 8)
+    {
+        const __mmask16 mask{TailMask((IrSize-i)*2)};
+        const __m512 coeffs0{_mm512_maskz_loadu_ps(mask, &Coeffs0[i][0])};
+        const __m512 coeffs1{_mm512_maskz_loadu_ps(mask, &Coeffs1[i][0])};
+        __m512 vals{_mm512_maskz_loadu_ps(mask, &Values[i][0])};
+        vals = _mm512_fmadd_ps(in0_16, coeffs0, vals);
+        vals = _mm512_fmadd_ps(in1_16, coeffs1, vals);
+        _mm512_mask_storeu_ps(&Values[i][0], mask, vals);
+    }
+}
+
+/* Applies N sets of coefficients for four consecutive input frames, adding
+ * sum(Coeffs[j-b]*in[b]) to each accumulated value j in one pass. Mixing one
+ * frame at a time has each frame's loads depend on the previous frame's
+ * stores one pair over, which stalls on the store forwarding no matter the
+ * vector width. The coefficients for the later frames are instead shifted
+ * into place from the neighboring vectors, and each set is still accumulated
+ * in the same order as one frame at a time.
+ */
+template<size_t N>
+static void ApplyCoeffs4(float2 *RESTRICT Values, const ALsizei IrSize,
+    const HrirArray<ALfloat> *const (&Coeffs)[N], const __m512 (&in)[4][N])
+{
+    ASSUME(IrSize >= 2);
+
+    __m512 prev[N];
+    for(size_t n{0};n < N;n++)
+        prev[n] = _mm512_setzero_ps();
+    const ALsizei total{IrSize + 3};
+    for(ALsizei j{0};j < total;j += 8)
+    {
+        __m512 cur[N];
+        if(j < IrSize)
+        {
+            const __mmask16 cmask{TailMask((IrSize-j)*2)};
+            for(size_t n{0};n < N;n++)
+                cur[n] = _mm512_maskz_loadu_ps(cmask, &(*Coeffs[n])[j][0]);
+        }
+        else for(size_t n{0};n < N;n++)
+            cur[n] = _mm512_setzero_ps();
+
+        const __mmask16 vmask{TailMask((total-j)*2)};
+        __m512 vals{_mm512_maskz_loadu_ps(vmask, &Values[j][0])};
+        for(size_t n{0};n < N;n++)
+            vals = _mm512_fmadd_ps(in[0][n], cur[n], vals);
+        for(size_t n{0};n < N;n++)
+        {
+            const __m512 c{_mm512_castsi512_ps(_mm512_maskz_alignr_epi32(0xffff, _mm512_castps_si512(cur[n]),
+                _mm512_castps_si512(prev[n]), 14))};
+            vals = _mm512_fmadd_ps(in[1][n], c, vals);
+        }
+        for(size_t n{0};n < N;n++)
+        {
+            const __m512 c{_mm512_castsi512_ps(_mm512_maskz_alignr_epi32(0xffff, _mm512_castps_si512(cur[n]),
+                _mm512_castps_si512(prev[n]), 12))};
+            vals = _mm512_fmadd_ps(in[2][n], c, vals);
+        }
+        for(size_t n{0};n < N;n++)
+        {
+            const __m512 c{_mm512_castsi512_ps(_mm512_maskz_alignr_epi32(0xffff, _mm512_castps_si512(cur[n]),
+                _mm512_castps_si512(prev[n]), 10))};
+            vals = _mm512_fmadd_ps(in[3][n], c, vals);
+        }
+        _mm512_mask_storeu_ps(&Values[j][0], vmask, vals);
+
+        for(size_t n{0};n < N;n++)
+            prev[n] = cur[n];
+    }
+}
+
+static inline __m512 BroadcastPair(const ALfloat left, const ALfloat right)
+{ return _mm512_setr4_ps(left, right, left, right); }
+
+template<>
+void MixHrtf_<AVX512Tag>(ALfloat *RESTRICT LeftOut, ALfloat *RESTRICT RightOut,
+    const ALfloat *data, float2 *RESTRICT AccumSamples, const ALsizei OutPos,
+    const ALsizei IrSize, MixHrtfParams *hrtfparams, const ALsizei BufferSize)
+{
+    ASSUME(OutPos >= 0);
+    ASSUME(IrSize >= 4);
+    ASSUME(BufferSize > 0);
+
+    const auto &Coeffs = *hrtfparams->Coeffs;
+    const HrirArray<ALfloat> *const coeffs[1]{&Coeffs};
+    const ALfloat gainstep{hrtfparams->GainStep};
+    const ALfloat gain{hrtfparams->Gain};
+    ALfloat stepcount{0.0f};
+
+    const ALfloat *ldata{data + HRTF_HISTORY_LENGTH - hrtfparams->Delay[0]};
+    const ALfloat *rdata{data + HRTF_HISTORY_LENGTH - hrtfparams->Delay[1]};
+
+    ALsizei i{0};
+    for(;BufferSize-i >= 4;i += 4)
+    {
+        __m512 in[4][1];
+        for(ALsizei b{0};b < 4;++b)
+        {
+            const ALfloat g{gain + gainstep*stepcount};
+            in[b][0] = BroadcastPair(ldata[i+b] * g, rdata[i+b] * g);
+            stepcount += 1.0f;
+        }
+        ApplyCoeffs4(AccumSamples+i, IrSize, coeffs, in);
+    }
+    for(;i < BufferSize;++i)
+    {
+        const ALfloat g{gain + gainstep*stepcount};
+        ApplyCoeffs(i, AccumSamples+i, IrSize, Coeffs, ldata[i] * g, rdata[i] * g);
+        stepcount += 1.0f;
+    }
+    for(i = 0;i < BufferSize;++i)
+        LeftOut[OutPos+i]  += AccumSamples[i][0];
+    for(i = 0;i < BufferSize;++i)
+        RightOut[OutPos+i] += AccumSamples[i][1];
+
+    hrtfparams->Gain = gain + gainstep*stepcount;
+}
+
+template<>
+void MixHrtfBlend_<AVX512Tag>(ALfloat *RESTRICT LeftOut, ALfloat *RESTRICT RightOut,
+    const ALfloat *data, float2 *RESTRICT AccumSamples, const ALsizei OutPos, const ALsizei IrSize,
+    const HrtfParams *oldparams, MixHrtfParams *newparams, const ALsizei BufferSize)
+{
+    ASSUME(OutPos >= 0);
+    ASSUME(IrSize >= 4);
+    ASSUME(BufferSize > 0);
+
+    const auto &OldCoeffs = oldparams->Coeffs;
+    const ALfloat oldGain{oldparams->Gain};
+    const ALfloat oldGainStep{-oldGain / static_cast<ALfloat>(BufferSize)};
+    const auto &NewCoeffs = *newparams->Coeffs;
+    const ALfloat newGainStep{newparams->GainStep};
+    const HrirArray<ALfloat> *const coeffs[2]{&OldCoeffs, &NewCoeffs};
+    ALfloat stepcount{0.0f};
+
+    const ALfloat *oldldata{data + HRTF_HISTORY_LENGTH - oldparams->Delay[0]};
+    const ALfloat *oldrdata{data + HRTF_HISTORY_LENGTH - oldparams->Delay[1]};
+    const ALfloat *newldata{data + HRTF_HISTORY_LENGTH - newparams->Delay[0]};
+    const ALfloat *newrdata{data + HRTF_HISTORY_LENGTH - newparams->Delay[1]};
+
+    ALsizei i{0};
+    for(;BufferSize-i >= 4;i += 4)
+    {
+        __m512 in[4][2];
+        for(ALsizei b{0};b < 4;++b)
+        {
+            const ALfloat oldg{oldGain + oldGainStep*stepcount};
+            in[b][0] = BroadcastPair(oldldata[i+b] * oldg, oldrdata[i+b] * oldg);
+            const ALfloat newg{newGainStep*stepcount};
+            in[b][1] = BroadcastPair(newldata[i+b] * newg, newrdata[i+b] * newg);
+            stepcount += 1.0f;
+        }
+        ApplyCoeffs4(AccumSamples+i, IrSize, coeffs, in);
+    }
+    for(;i < BufferSize;++i)
+    {
+        const ALfloat oldg{oldGain + oldGainStep*stepcount};
+        ApplyCoeffs(i, AccumSamples+i, IrSize, OldCoeffs, oldldata[i] * oldg,
+            oldrdata[i] * oldg);
+        const ALfloat newg{newGainStep*stepcount};
+        ApplyCoeffs(i, AccumSamples+i, IrSize, NewCoeffs, newldata[i] * newg,
+            newrdata[i] * newg);
+        stepcount += 1.0f;
+    }
+    for(i = 0;i < BufferSize;++i)
+        LeftOut[OutPos+i]  += AccumSamples[i][0];
+    for(i = 0;i < BufferSize;++i)
+        RightOut[OutPos+i] += AccumSamples[i][1];
+
+    newparams->Gain = newGainStep*stepcount;
+}
+
+template<>
+void MixDirectHrtf_<AVX512Tag>(ALfloat *RESTRICT LeftOut, ALfloat *RESTRICT RightOut,
+    const ALfloat (*data)[BUFFERSIZE], float2 *RESTRICT AccumSamples, DirectHrtfState *State,
+    const ALsizei NumChans, const ALsizei BufferSize)
+{
+    ASSUME(NumChans > 0);
+    ASSUME(BufferSize > 0);
+
+    const ALsizei IrSize{State->IrSize};
+    ASSUME(IrSize >= 4);
+
+    auto accum_iter = std::copy_n(State->Values.begin(), State->Values.size(), AccumSamples);
+    std::fill_n(accum_iter, BufferSize, float2{});
+
+    ALsizei c{0};
+    for(;c+1 < NumChans;c += 2)
+    {
+        const ALfloat (&input0)[BUFFERSIZE] = data[c];
+        const ALfloat (&input1)[BUFFERSIZE] = data[c+1];
+        const auto &Coeffs0 = State->Chan[c].Coeffs;
+        const auto &Coeffs1 = State->Chan[c+1].Coeffs;
+        const HrirArray<ALfloat> *const coeffs[2]{&Coeffs0, &Coeffs1};
+
+        ALsizei i{0};
+        for(;BufferSize-i >= 4;i += 4)
+        {
+            __m512 in[4][2];
+            for(ALsizei b{0};b < 4;++b)
+            {
+                in[b][0] = _mm512_set1_ps(input0[i+b]);
+                in[b][1] = _mm512_set1_ps(input1[i+b]);
+            }
+            ApplyCoeffs4(AccumSamples+i, IrSize, coeffs, in);
+        }
+        for(;i < BufferSize;++i)
+            ApplyCoeffsPair(i, AccumSamples+i, IrSize, Coeffs0, Coeffs1, input0[i], input1[i]);
+    }
+    if(c < NumChans)
+    {
+        const ALfloat (&input)[BUFFERSIZE] = data[c];
+        const auto &Coeffs = State->Chan[c].Coeffs;
+        const HrirArray<ALfloat> *const coeffs[1]{&Coeffs};
+
+        ALsizei i{0};
+        for(;BufferSize-i >= 4;i += 4)
+        {
+            __m512 in[4][1];
+            for(ALsizei b{0};b < 4;++b)
+                in[b][0] = _mm512_set1_ps(input[i+b]);
+            ApplyCoeffs4(AccumSamples+i, IrSize, coeffs, in);
+        }
+        for(;i < BufferSize;++i)
+            ApplyCoeffs(i, AccumSamples+i, IrSize, Coeffs, input[i], input[i]);
+    }
+
+    for(ALsizei i{0};i < BufferSize;++i)
+        LeftOut[i]  += AccumSamples[i][0];
+    for(ALsizei i{0};i < BufferSize;++i)
+        RightOut[i] += AccumSamples[i][1];
+
+    std::copy_n(AccumSamples + BufferSize, State->Values.size(), State->Values.begin());
+}
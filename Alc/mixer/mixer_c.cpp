@@ -3,6 +3,7 @@
 #include <cassert>
 
 #include <limits>
+#include <tuple>
 
 #include "alMain.h"
 #include "alu.h"
@@ -39,6 +40,25 @@ static inline ALfloat do_bsinc(const InterpState &istate, const ALfloat *RESTRIC
         r += (fil[j_f] + istate.bsinc.sf*scd[j_f] + pf*(phd[j_f] + istate.bsinc.sf*spd[j_f])) * vals[j_f];
     return r;
 }
+static inline ALfloat do_fastbsinc(const InterpState &istate, const ALfloat *RESTRICT vals, const ALsizei frac) noexcept
+{
+    ASSUME(istate.bsinc.m > 0);
+
+    // Calculate the phase index and factor.
+#define FRAC_PHASE_BITDIFF (FRACTIONBITS-BSINC_PHASE_BITS)
+    const ALsizei pi{frac >> FRAC_PHASE_BITDIFF};
+    const ALfloat pf{(frac & ((1<<FRAC_PHASE_BITDIFF)-1)) * (1.0f/(1<<FRAC_PHASE_BITDIFF))};
+#undef FRAC_PHASE_BITDIFF
+
+    const ALfloat *fil{istate.bsinc.filter + istate.bsinc.m*pi*4};
+    const ALfloat *phd{fil + istate.bsinc.m*2};
+
+    // Apply the phase interpolated filter.
+    ALfloat r{0.0f};
+    for(ALsizei j_f{0};j_f < istate.bsinc.m;j_f++)
+        r += (fil[j_f] + pf*phd[j_f]) * vals[j_f];
+    return r;
+}
 
 using SamplerT = ALfloat(const InterpState&, const ALfloat*RESTRICT, const ALsizei);
 template<SamplerT &Sampler>
@@ -102,6 +122,106 @@ const ALfloat *Resample_<BSincTag,CTag>(const InterpState *state, const ALfloat
     ALsizei frac, ALint increment, ALfloat *RESTRICT dst, ALsizei dstlen)
 { return DoResample<do_bsinc>(state, src-state->bsinc.l, frac, increment, dst, dstlen); }
 
+template<>
+const ALfloat *Resample_<FastBSincTag,CTag>(const InterpState *state, const ALfloat *RESTRICT src,
+    ALsizei frac, ALint increment, ALfloat *RESTRICT dst, ALsizei dstlen)
+{ return DoResample<do_fastbsinc>(state, src-state->bsinc.l, frac, increment, dst, dstlen); }
+
+template<>
+void ResampleMulti_<BSincTag,CTag>(const InterpState *state, const ALfloat *const *RESTRICT src,
+    const ALsizei numchans, ALsizei frac, ALint increment, ALfloat *const *RESTRICT dst,
+    ALsizei dstlen)
+{
+    const ALfloat *const filter{state->bsinc.filter};
+    const ALfloat sf{state->bsinc.sf};
+    const ALsizei m{state->bsinc.m};
+    const ALsizei l{state->bsinc.l};
+
+    ASSUME(m > 0);
+    ASSUME(numchans > 0);
+    ASSUME(dstlen > 0);
+    ASSUME(increment > 0);
+    ASSUME(frac >= 0);
+
+    ALfloat f[MAX_RESAMPLE_PADDING*2];
+    ALsizei pos{0};
+    for(ALsizei i{0};i < dstlen;i++)
+    {
+        // Calculate the phase index and factor.
+#define FRAC_PHASE_BITDIFF (FRACTIONBITS-BSINC_PHASE_BITS)
+        const ALsizei pi{frac >> FRAC_PHASE_BITDIFF};
+        const ALfloat pf{(frac & ((1<<FRAC_PHASE_BITDIFF)-1)) * (1.0f/(1<<FRAC_PHASE_BITDIFF))};
+#undef FRAC_PHASE_BITDIFF
+
+        const ALfloat *fil{filter + m*pi*4};
+        const ALfloat *scd{fil + m};
+        const ALfloat *phd{scd + m};
+        const ALfloat *spd{phd + m};
+
+        // Interpolate the filter once, then apply it to each channel.
+        for(ALsizei j_f{0};j_f < m;j_f++)
+            f[j_f] = fil[j_f] + sf*scd[j_f] + pf*(phd[j_f] + sf*spd[j_f]);
+        for(ALsizei c{0};c < numchans;c++)
+        {
+            const ALfloat *RESTRICT vals{src[c] + pos - l};
+            ALfloat r{0.0f};
+            for(ALsizei j_f{0};j_f < m;j_f++)
+                r += f[j_f] * vals[j_f];
+            dst[c][i] = r;
+        }
+
+        frac += increment;
+        pos  += frac>>FRACTIONBITS;
+        frac &= FRACTIONMASK;
+    }
+}
+
+template<>
+void ResampleMulti_<FastBSincTag,CTag>(const InterpState *state,
+    const ALfloat *const *RESTRICT src, const ALsizei numchans, ALsizei frac, ALint increment,
+    ALfloat *const *RESTRICT dst, ALsizei dstlen)
+{
+    const ALfloat *const filter{state->bsinc.filter};
+    const ALsizei m{state->bsinc.m};
+    const ALsizei l{state->bsinc.l};
+
+    ASSUME(m > 0);
+    ASSUME(numchans > 0);
+    ASSUME(dstlen > 0);
+    ASSUME(increment > 0);
+    ASSUME(frac >= 0);
+
+    ALfloat f[MAX_RESAMPLE_PADDING*2];
+    ALsizei pos{0};
+    for(ALsizei i{0};i < dstlen;i++)
+    {
+        // Calculate the phase index and factor.
+#define FRAC_PHASE_BITDIFF (FRACTIONBITS-BSINC_PHASE_BITS)
+        const ALsizei pi{frac >> FRAC_PHASE_BITDIFF};
+        const ALfloat pf{(frac & ((1<<FRAC_PHASE_BITDIFF)-1)) * (1.0f/(1<<FRAC_PHASE_BITDIFF))};
+#undef FRAC_PHASE_BITDIFF
+
+        const ALfloat *fil{filter + m*pi*4};
+        const ALfloat *phd{fil + m*2};
+
+        // Interpolate the filter once, then apply it to each channel.
+        for(ALsizei j_f{0};j_f < m;j_f++)
+            f[j_f] = fil[j_f] + pf*phd[j_f];
+        for(ALsizei c{0};c < numchans;c++)
+        {
+            const ALfloat *RESTRICT vals{src[c] + pos - l};
+            ALfloat r{0.0f};
+            for(ALsizei j_f{0};j_f < m;j_f++)
+                r += f[j_f] * vals[j_f];
+            dst[c][i] = r;
+        }
+
+        frac += increment;
+        pos  += frac>>FRACTIONBITS;
+        frac &= FRACTIONMASK;
+    }
+}
+
 
 static inline void ApplyCoeffs(ALsizei /*Offset*/, float2 *RESTRICT Values, const ALsizei IrSize,
     const HrirArray<ALfloat> &Coeffs, const ALfloat left, const ALfloat right)
@@ -114,6 +234,18 @@ static inline void ApplyCoeffs(ALsizei /*Offset*/, float2 *RESTRICT Values, cons
     }
 }
 
+static inline void ApplyCoeffsPair(ALsizei /*Offset*/, float2 *RESTRICT Values,
+    const ALsizei IrSize, const HrirArray<ALfloat> &Coeffs0, const HrirArray<ALfloat> &Coeffs1,
+    const ALfloat in0, const ALfloat in1)
+{
+    ASSUME(IrSize >= 2);
+    for(ALsizei c{0};c < IrSize;++c)
+    {
+        Values[c][0] += Coeffs0[c][0]*in0 + Coeffs1[c][0]*in1;
+        Values[c][1] += Coeffs0[c][1]*in0 + Coeffs1[c][1]*in1;
+    }
+}
+
 template<>
 void MixHrtf_<CTag>(ALfloat *RESTRICT LeftOut, ALfloat *RESTRICT RightOut, const ALfloat *data,
     float2 *RESTRICT AccumSamples, const ALsizei OutPos, const ALsizei IrSize,
@@ -137,8 +269,8 @@ void MixDirectHrtf_<CTag>(ALfloat *RESTRICT LeftOut, ALfloat *RESTRICT RightOut,
     const ALfloat (*data)[BUFFERSIZE], float2 *RESTRICT AccumSamples, DirectHrtfState *State,
     const ALsizei NumChans, const ALsizei BufferSize)
 {
-    MixDirectHrtfBase<ApplyCoeffs>(LeftOut, RightOut, data, AccumSamples, State, NumChans,
-        BufferSize);
+    MixDirectHrtfBase<ApplyCoeffs, ApplyCoeffsPair>(LeftOut, RightOut, data, AccumSamples,
+        State, NumChans, BufferSize);
 }
 
 
@@ -206,3 +338,178 @@ void MixRow_<CTag>(ALfloat *OutBuffer, const ALfloat *Gains, const ALfloat (*dat
             OutBuffer[i] += src[i] * gain;
     }
 }
+
+template<>
+void BiquadMulti_<CTag>(BiquadFilter *const *filters, ALfloat *const *dst,
+    const ALfloat *const *src, const ALsizei numchans, const ALsizei numsamples)
+{
+    ASSUME(numchans > 0);
+    ASSUME(numsamples > 0);
+
+    for(ALsizei c{0};c < numchans;c++)
+        filters[c]->process(dst[c], src[c], numsamples);
+}
+
+template<>
+void BiquadCascade_<CTag>(BiquadFilter *const *filters, ALfloat *const *dst,
+    const ALfloat *const *src, const ALsizei numchans, const ALsizei numsamples)
+{
+    ASSUME(numchans > 0);
+    ASSUME(numsamples > 0);
+
+    for(ALsizei c{0};c < numchans;c++)
+    {
+        /* Keep every stage's coefficients and state local, so each sample
+         * runs through the whole cascade before the next is loaded.
+         */
+        BiquadFilter *stages{filters[c]};
+        std::array<ALfloat,5> coeffs[BIQUAD_CASCADE_STAGES];
+        ALfloat z1[BIQUAD_CASCADE_STAGES], z2[BIQUAD_CASCADE_STAGES];
+        for(ALsizei s{0};s < BIQUAD_CASCADE_STAGES;s++)
+        {
+            coeffs[s] = stages[s].getCoefficients();
+            std::tie(z1[s], z2[s]) = stages[s].getComponents();
+        }
+
+        const ALfloat *RESTRICT input{src[c]};
+        ALfloat *RESTRICT output{dst[c]};
+        for(ALsizei i{0};i < numsamples;i++)
+        {
+            ALfloat val{input[i]};
+            for(ALsizei s{0};s < BIQUAD_CASCADE_STAGES;s++)
+            {
+                const ALfloat out{val*coeffs[s][0] + z1[s]};
+                z1[s] = val*coeffs[s][1] - out*coeffs[s][3] + z2[s];
+                z2[s] = val*coeffs[s][2] - out*coeffs[s][4];
+                val = out;
+            }
+            output[i] = val;
+        }
+
+        for(ALsizei s{0};s < BIQUAD_CASCADE_STAGES;s++)
+            stages[s].setComponents(z1[s], z2[s]);
+    }
+}
+
+template<>
+void BlendHalf_<CTag>(ALfloat *RESTRICT dst, const ALushort *RESTRICT src, const ALfloat scale,
+    const ALsizei count)
+{
+    ASSUME(count > 0);
+
+    for(ALsizei i{0};i < count;i++)
+        dst[i] = half2float(src[i])*scale + dst[i];
+}
+
+template<>
+void LoadSamples_<CTag>(ALfloat *RESTRICT dst, const ALvoid *RESTRICT src, const ALint srcstep,
+    const FmtType srctype, const ALsizei samples)
+{
+    ASSUME(srcstep > 0);
+    ASSUME(samples >= 0);
+
+    switch(srctype)
+    {
+        case FmtUByte:
+        {
+            const auto *ssrc = static_cast<const ALubyte*>(src);
+            for(ALsizei i{0};i < samples;i++)
+                dst[i] += (ssrc[i*srcstep]-128) * (1.0f/128.0f);
+            break;
+        }
+        case FmtShort:
+        {
+            const auto *ssrc = static_cast<const ALshort*>(src);
+            for(ALsizei i{0};i < samples;i++)
+                dst[i] += ssrc[i*srcstep] * (1.0f/32768.0f);
+            break;
+        }
+        case FmtFloat:
+        {
+            const auto *ssrc = static_cast<const ALfloat*>(src);
+            for(ALsizei i{0};i < samples;i++)
+                dst[i] += ssrc[i*srcstep];
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+template<>
+void StoreSamples_<CTag>(ALvoid *RESTRICT dst, const ALfloat *const *RESTRICT src,
+    const ALsizei srcchans, const ALsizei dststep, const DevFmtType dsttype,
+    const ALsizei samples)
+{
+    ASSUME(srcchans > 0);
+    ASSUME(dststep >= srcchans);
+    ASSUME(samples >= 0);
+
+    switch(dsttype)
+    {
+        case DevFmtShort:
+            for(ALsizei c{0};c < srcchans;c++)
+            {
+                auto *sdst = static_cast<ALshort*>(dst) + c;
+                for(ALsizei i{0};i < samples;i++)
+                    sdst[i*dststep] = static_cast<ALshort>(
+                        fastf2i(clampf(src[c][i]*32768.0f, -32768.0f, 32767.0f)));
+            }
+            break;
+        case DevFmtInt:
+            for(ALsizei c{0};c < srcchans;c++)
+            {
+                auto *sdst = static_cast<ALint*>(dst) + c;
+                for(ALsizei i{0};i < samples;i++)
+                    sdst[i*dststep] = fastf2i(clampf(src[c][i]*2147483648.0f, -2147483648.0f,
+                        2147483520.0f));
+            }
+            break;
+        case DevFmtFloat:
+            for(ALsizei c{0};c < srcchans;c++)
+            {
+                auto *sdst = static_cast<ALfloat*>(dst) + c;
+                for(ALsizei i{0};i < samples;i++)
+                    sdst[i*dststep] = src[c][i];
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+template<>
+void Dither_<CTag>(ALfloat *RESTRICT buffer, ALuint *RESTRICT seeds, const ALfloat quant_scale,
+    const ALsizei samples)
+{
+    ASSUME(samples > 0);
+
+    auto xorshift = [](ALuint x) noexcept -> ALuint
+    {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        return x;
+    };
+
+    /* Each sample's noise is the difference of two uniform 24-bit values from
+     * its lane's generator, scaled to (-1, +1).
+     */
+    const ALfloat invscale{1.0f / quant_scale};
+    for(ALsizei base{0};base < samples;base += DITHER_RNG_LANES)
+    {
+        const ALsizei todo{mini(samples-base, DITHER_RNG_LANES)};
+        for(ALsizei j{0};j < DITHER_RNG_LANES;j++)
+        {
+            const ALuint rng0{xorshift(seeds[j])};
+            const ALuint rng1{xorshift(rng0)};
+            seeds[j] = rng1;
+            if(j >= todo) continue;
+
+            const auto noise = static_cast<ALfloat>(static_cast<ALint>(rng0>>8)) -
+                static_cast<ALfloat>(static_cast<ALint>(rng1>>8));
+            const ALfloat val{buffer[base+j]*quant_scale + noise*(1.0f/16777216.0f)};
+            buffer[base+j] = fast_roundf(val) * invscale;
+        }
+    }
+}
@@ -2,7 +2,9 @@
 
 #include <arm_neon.h>
 
+#include <algorithm>
 #include <limits>
+#include <tuple>
 
 #include "AL/al.h"
 #include "AL/alc.h"
@@ -73,6 +75,131 @@ const ALfloat *Resample_<LerpTag,NEONTag>(const InterpState* UNUSED(state),
     return dst;
 }
 
+static inline float32x4_t Cubic4(const float32x4_t val1, const float32x4_t val2,
+    const float32x4_t val3, const float32x4_t val4, const float32x4_t mu)
+{
+    const float32x4_t mu2 = vmulq_f32(mu, mu);
+    const float32x4_t mu3 = vmulq_f32(mu2, mu);
+    const float32x4_t a0 = vaddq_f32(vaddq_f32(vmulq_n_f32(mu3, -0.5f), mu2),
+        vmulq_n_f32(mu, -0.5f));
+    const float32x4_t a1 = vaddq_f32(vaddq_f32(vmulq_n_f32(mu3, 1.5f), vmulq_n_f32(mu2, -2.5f)),
+        vdupq_n_f32(1.0f));
+    const float32x4_t a2 = vaddq_f32(vaddq_f32(vmulq_n_f32(mu3, -1.5f), vmulq_n_f32(mu2, 2.0f)),
+        vmulq_n_f32(mu, 0.5f));
+    const float32x4_t a3 = vaddq_f32(vmulq_n_f32(mu3, 0.5f), vmulq_n_f32(mu2, -0.5f));
+    return vaddq_f32(vaddq_f32(vaddq_f32(vmulq_f32(val1, a0), vmulq_f32(val2, a1)),
+        vmulq_f32(val3, a2)), vmulq_f32(val4, a3));
+}
+
+template<>
+const ALfloat *Resample_<PointTag,NEONTag>(const InterpState* UNUSED(state),
+  const ALfloat *RESTRICT src, ALsizei frac, ALint increment,
+  ALfloat *RESTRICT dst, ALsizei dstlen)
+{
+    const int32x4_t increment4 = vdupq_n_s32(increment*4);
+    const int32x4_t fracMask4 = vdupq_n_s32(FRACTIONMASK);
+    alignas(16) ALsizei pos_[4], frac_[4];
+    int32x4_t pos4, frac4;
+    ALsizei todo, pos, i;
+
+    ASSUME(frac >= 0);
+    ASSUME(increment > 0);
+    ASSUME(dstlen > 0);
+
+    InitiatePositionArrays(frac, increment, frac_, pos_, 4);
+    frac4 = vld1q_s32(frac_);
+    pos4 = vld1q_s32(pos_);
+
+    todo = dstlen & ~3;
+    for(i = 0;i < todo;i += 4)
+    {
+        const int pos0 = vgetq_lane_s32(pos4, 0);
+        const int pos1 = vgetq_lane_s32(pos4, 1);
+        const int pos2 = vgetq_lane_s32(pos4, 2);
+        const int pos3 = vgetq_lane_s32(pos4, 3);
+        const float32x4_t out = (float32x4_t){src[pos0], src[pos1], src[pos2], src[pos3]};
+
+        vst1q_f32(&dst[i], out);
+
+        frac4 = vaddq_s32(frac4, increment4);
+        pos4 = vaddq_s32(pos4, vshrq_n_s32(frac4, FRACTIONBITS));
+        frac4 = vandq_s32(frac4, fracMask4);
+    }
+
+    pos = vgetq_lane_s32(pos4, 0);
+    frac = vgetq_lane_s32(frac4, 0);
+
+    for(;i < dstlen;++i)
+    {
+        dst[i] = src[pos];
+
+        frac += increment;
+        pos  += frac>>FRACTIONBITS;
+        frac &= FRACTIONMASK;
+    }
+    return dst;
+}
+
+template<>
+const ALfloat *Resample_<CubicTag,NEONTag>(const InterpState* UNUSED(state),
+  const ALfloat *RESTRICT src, ALsizei frac, ALint increment,
+  ALfloat *RESTRICT dst, ALsizei dstlen)
+{
+    const int32x4_t increment4 = vdupq_n_s32(increment*4);
+    const float32x4_t fracOne4 = vdupq_n_f32(1.0f/FRACTIONONE);
+    const int32x4_t fracMask4 = vdupq_n_s32(FRACTIONMASK);
+    alignas(16) ALsizei pos_[4], frac_[4];
+    int32x4_t pos4, frac4;
+    ALsizei todo, pos, i;
+
+    ASSUME(frac >= 0);
+    ASSUME(increment > 0);
+    ASSUME(dstlen > 0);
+
+    InitiatePositionArrays(frac, increment, frac_, pos_, 4);
+    frac4 = vld1q_s32(frac_);
+    pos4 = vld1q_s32(pos_);
+
+    /* The four sample points start one before the current position. */
+    src -= 1;
+
+    todo = dstlen & ~3;
+    for(i = 0;i < todo;i += 4)
+    {
+        const int pos0 = vgetq_lane_s32(pos4, 0);
+        const int pos1 = vgetq_lane_s32(pos4, 1);
+        const int pos2 = vgetq_lane_s32(pos4, 2);
+        const int pos3 = vgetq_lane_s32(pos4, 3);
+        const float32x4_t val1 = (float32x4_t){src[pos0], src[pos1], src[pos2], src[pos3]};
+        const float32x4_t val2 = (float32x4_t){src[pos0+1], src[pos1+1], src[pos2+1], src[pos3+1]};
+        const float32x4_t val3 = (float32x4_t){src[pos0+2], src[pos1+2], src[pos2+2], src[pos3+2]};
+        const float32x4_t val4 = (float32x4_t){src[pos0+3], src[pos1+3], src[pos2+3], src[pos3+3]};
+
+        const float32x4_t mu = vmulq_f32(vcvtq_f32_s32(frac4), fracOne4);
+        vst1q_f32(&dst[i], Cubic4(val1, val2, val3, val4, mu));
+
+        frac4 = vaddq_s32(frac4, increment4);
+        pos4 = vaddq_s32(pos4, vshrq_n_s32(frac4, FRACTIONBITS));
+        frac4 = vandq_s32(frac4, fracMask4);
+    }
+
+    /* NOTE: These four elements represent the position *after* the last four
+     * samples, so the lowest element is the next position to resample.
+     */
+    pos = vgetq_lane_s32(pos4, 0);
+    frac = vgetq_lane_s32(frac4, 0);
+
+    for(;i < dstlen;++i)
+    {
+        dst[i] = cubic(src[pos], src[pos+1], src[pos+2], src[pos+3], frac * (1.0f/FRACTIONONE));
+
+        frac += increment;
+        pos  += frac>>FRACTIONBITS;
+        frac &= FRACTIONMASK;
+    }
+    return dst;
+}
+
 template<>
 const ALfloat *Resample_<BSincTag,NEONTag>(const InterpState *state, const ALfloat *RESTRICT src,
     ALsizei frac, ALint increment, ALfloat *RESTRICT dst, ALsizei dstlen)
@@ -135,6 +262,191 @@ const ALfloat *Resample_<BSincTag,NEONTag>(const InterpState *state, const ALflo
     return dst;
 }
 
+template<>
+const ALfloat *Resample_<FastBSincTag,NEONTag>(const InterpState *state,
+    const ALfloat *RESTRICT src, ALsizei frac, ALint increment, ALfloat *RESTRICT dst,
+    ALsizei dstlen)
+{
+    const ALfloat *const filter = state->bsinc.filter;
+    const ALsizei m = state->bsinc.m;
+    const float32x4_t *fil, *phd;
+    ALsizei pi, i, j, offset;
+    float32x4_t r4;
+    ALfloat pf;
+
+    ASSUME(m > 0);
+    ASSUME(dstlen > 0);
+    ASSUME(increment > 0);
+    ASSUME(frac >= 0);
+
+    src -= state->bsinc.l;
+    for(i = 0;i < dstlen;i++)
+    {
+        // Calculate the phase index and factor.
+#define FRAC_PHASE_BITDIFF (FRACTIONBITS-BSINC_PHASE_BITS)
+        pi = frac >> FRAC_PHASE_BITDIFF;
+        pf = (frac & ((1<<FRAC_PHASE_BITDIFF)-1)) * (1.0f/(1<<FRAC_PHASE_BITDIFF));
+#undef FRAC_PHASE_BITDIFF
+
+        offset = m*pi*4;
+        fil = (const float32x4_t*)(filter + offset); offset += m*2;
+        phd = (const float32x4_t*)(filter + offset);
+
+        // Apply the phase interpolated filter.
+        r4 = vdupq_n_f32(0.0f);
+        {
+            const ALsizei count = m >> 2;
+            const float32x4_t pf4 = vdupq_n_f32(pf);
+
+            ASSUME(count > 0);
+
+            for(j = 0;j < count;j++)
+            {
+                /* f = fil + pf*phd */
+                const float32x4_t f4 = vmlaq_f32(fil[j], pf4, phd[j]);
+                /* r += f*src */
+                r4 = vmlaq_f32(r4, f4, vld1q_f32(&src[j*4]));
+            }
+        }
+        r4 = vaddq_f32(r4, vcombine_f32(vrev64_f32(vget_high_f32(r4)),
+                                        vrev64_f32(vget_low_f32(r4))));
+        dst[i] = vget_lane_f32(vadd_f32(vget_low_f32(r4), vget_high_f32(r4)), 0);
+
+        frac += increment;
+        src  += frac>>FRACTIONBITS;
+        frac &= FRACTIONMASK;
+    }
+    return dst;
+}
+
+template<>
+void ResampleMulti_<BSincTag,NEONTag>(const InterpState *state,
+    const ALfloat *const *RESTRICT src, const ALsizei numchans, ALsizei frac, ALint increment,
+    ALfloat *const *RESTRICT dst, ALsizei dstlen)
+{
+    const ALfloat *const filter = state->bsinc.filter;
+    const float32x4_t sf4 = vdupq_n_f32(state->bsinc.sf);
+    const ALsizei m = state->bsinc.m;
+    const ALsizei l = state->bsinc.l;
+    const ALsizei count = m >> 2;
+    const float32x4_t *fil, *scd, *phd, *spd;
+    float32x4_t f4[MAX_RESAMPLE_PADDING*2 / 4];
+    ALsizei pi, pos, i, j, c, offset;
+    ALfloat pf;
+
+    ASSUME(m > 0);
+    ASSUME(count > 0);
+    ASSUME(numchans > 0);
+    ASSUME(dstlen > 0);
+    ASSUME(increment > 0);
+    ASSUME(frac >= 0);
+
+    pos = 0;
+    for(i = 0;i < dstlen;i++)
+    {
+        // Calculate the phase index and factor.
+#define FRAC_PHASE_BITDIFF (FRACTIONBITS-BSINC_PHASE_BITS)
+        pi = frac >> FRAC_PHASE_BITDIFF;
+        pf = (frac & ((1<<FRAC_PHASE_BITDIFF)-1)) * (1.0f/(1<<FRAC_PHASE_BITDIFF));
+#undef FRAC_PHASE_BITDIFF
+
+        offset = m*pi*4;
+        fil = (const float32x4_t*)(filter + offset); offset += m;
+        scd = (const float32x4_t*)(filter + offset); offset += m;
+        phd = (const float32x4_t*)(filter + offset); offset += m;
+        spd = (const float32x4_t*)(filter + offset);
+
+        // Interpolate the filter once, then apply it to each channel.
+        {
+            const float32x4_t pf4 = vdupq_n_f32(pf);
+            for(j = 0;j < count;j++)
+            {
+                /* f = ((fil + sf*scd) + pf*(phd + sf*spd)) */
+                f4[j] = vmlaq_f32(
+                    vmlaq_f32(fil[j], sf4, scd[j]),
+                    pf4, vmlaq_f32(phd[j], sf4, spd[j])
+                );
+            }
+        }
+        for(c = 0;c < numchans;c++)
+        {
+            const ALfloat *RESTRICT vals = src[c] + pos - l;
+            float32x4_t r4 = vdupq_n_f32(0.0f);
+            /* r += f*src */
+            for(j = 0;j < count;j++)
+                r4 = vmlaq_f32(r4, f4[j], vld1q_f32(&vals[j*4]));
+            r4 = vaddq_f32(r4, vcombine_f32(vrev64_f32(vget_high_f32(r4)),
+                                            vrev64_f32(vget_low_f32(r4))));
+            dst[c][i] = vget_lane_f32(vadd_f32(vget_low_f32(r4), vget_high_f32(r4)), 0);
+        }
+
+        frac += increment;
+        pos  += frac>>FRACTIONBITS;
+        frac &= FRACTIONMASK;
+    }
+}
+
+template<>
+void ResampleMulti_<FastBSincTag,NEONTag>(const InterpState *state,
+    const ALfloat *const *RESTRICT src, const ALsizei numchans, ALsizei frac, ALint increment,
+    ALfloat *const *RESTRICT dst, ALsizei dstlen)
+{
+    const ALfloat *const filter = state->bsinc.filter;
+    const ALsizei m = state->bsinc.m;
+    const ALsizei l = state->bsinc.l;
+    const ALsizei count = m >> 2;
+    const float32x4_t *fil, *phd;
+    float32x4_t f4[MAX_RESAMPLE_PADDING*2 / 4];
+    ALsizei pi, pos, i, j, c, offset;
+    ALfloat pf;
+
+    ASSUME(m > 0);
+    ASSUME(count > 0);
+    ASSUME(numchans > 0);
+    ASSUME(dstlen > 0);
+    ASSUME(increment > 0);
+    ASSUME(frac >= 0);
+
+    pos = 0;
+    for(i = 0;i < dstlen;i++)
+    {
+        // Calculate the phase index and factor.
+#define FRAC_PHASE_BITDIFF (FRACTIONBITS-BSINC_PHASE_BITS)
+        pi = frac >> FRAC_PHASE_BITDIFF;
+        pf = (frac & ((1<<FRAC_PHASE_BITDIFF)-1)) * (1.0f/(1<<FRAC_PHASE_BITDIFF));
+#undef FRAC_PHASE_BITDIFF
+
+        offset = m*pi*4;
+        fil = (const float32x4_t*)(filter + offset); offset += m*2;
+        phd = (const float32x4_t*)(filter + offset);
+
+        // Interpolate the filter once, then apply it to each channel.
+        {
+            const float32x4_t pf4 = vdupq_n_f32(pf);
+            for(j = 0;j < count;j++)
+            {
+                /* f = fil + pf*phd */
+                f4[j] = vmlaq_f32(fil[j], pf4, phd[j]);
+            }
+        }
+        for(c = 0;c < numchans;c++)
+        {
+            const ALfloat *RESTRICT vals = src[c] + pos - l;
+            float32x4_t r4 = vdupq_n_f32(0.0f);
+            /* r += f*src */
+            for(j = 0;j < count;j++)
+                r4 = vmlaq_f32(r4, f4[j], vld1q_f32(&vals[j*4]));
+            r4 = vaddq_f32(r4, vcombine_f32(vrev64_f32(vget_high_f32(r4)),
+                                            vrev64_f32(vget_low_f32(r4))));
+            dst[c][i] = vget_lane_f32(vadd_f32(vget_low_f32(r4), vget_high_f32(r4)), 0);
+        }
+
+        frac += increment;
+        pos  += frac>>FRACTIONBITS;
+        frac &= FRACTIONMASK;
+    }
+}
+
 
 static inline void ApplyCoeffs(ALsizei /*Offset*/, float2 *RESTRICT Values, const ALsizei IrSize,
     const HrirArray<ALfloat> &Coeffs, const ALfloat left, const ALfloat right)
@@ -162,6 +474,29 @@ static inline void ApplyCoeffs(ALsizei /*Offset*/, float2 *RESTRICT Values, cons
     }
 }
 
+static inline void ApplyCoeffsPair(ALsizei /*Offset*/, float2 *RESTRICT Values,
+    const ALsizei IrSize, const HrirArray<ALfloat> &Coeffs0, const HrirArray<ALfloat> &Coeffs1,
+    const ALfloat in0, const ALfloat in1)
+{
+    ASSUME(IrSize >= 2);
+
+    const float32x4_t in0_4 = vdupq_n_f32(in0);
+    const float32x4_t in1_4 = vdupq_n_f32(in1);
+    for(ALsizei c{0};c < IrSize;c += 2)
+    {
+        float32x4_t vals = vcombine_f32(vld1_f32((float32_t*)&Values[c  ][0]),
+                                        vld1_f32((float32_t*)&Values[c+1][0]));
+        float32x4_t coefs0 = vld1q_f32((float32_t*)&Coeffs0[c][0]);
+        float32x4_t coefs1 = vld1q_f32((float32_t*)&Coeffs1[c][0]);
+
+        vals = vmlaq_f32(vals, coefs0, in0_4);
+        vals = vmlaq_f32(vals, coefs1, in1_4);
+
+        vst1_f32((float32_t*)&Values[c  ][0], vget_low_f32(vals));
+        vst1_f32((float32_t*)&Values[c+1][0], vget_high_f32(vals));
+    }
+}
+
 template<>
 void MixHrtf_<NEONTag>(ALfloat *RESTRICT LeftOut, ALfloat *RESTRICT RightOut, const ALfloat *data,
     float2 *RESTRICT AccumSamples, const ALsizei OutPos, const ALsizei IrSize,
@@ -185,8 +520,8 @@ void MixDirectHrtf_<NEONTag>(ALfloat *RESTRICT LeftOut, ALfloat *RESTRICT RightO
     const ALfloat (*data)[BUFFERSIZE], float2 *RESTRICT AccumSamples, DirectHrtfState *State,
     const ALsizei NumChans, const ALsizei BufferSize)
 {
-    MixDirectHrtfBase<ApplyCoeffs>(LeftOut, RightOut, data, AccumSamples, State, NumChans,
-        BufferSize);
+    MixDirectHrtfBase<ApplyCoeffs, ApplyCoeffsPair>(LeftOut, RightOut, data, AccumSamples,
+        State, NumChans, BufferSize);
 }
 
 
@@ -307,3 +642,450 @@ void MixRow_<NEONTag>(ALfloat *OutBuffer, const ALfloat *Gains, const ALfloat (*
             OutBuffer[pos] += src[pos]*gain;
     }
 }
+
+template<>
+void BiquadMulti_<NEONTag>(BiquadFilter *const *filters, ALfloat *const *dst,
+    const ALfloat *const *src, const ALsizei numchans, const ALsizei numsamples)
+{
+    ASSUME(numchans > 0);
+    ASSUME(numsamples > 0);
+
+    /* Each element of the vectors is a separate channel's filter, so up to
+     * four channels run through the (serial) filter recurrence at once.
+     * Unused elements get zeroed coefficients and input, and are never
+     * stored.
+     */
+    for(ALsizei base{0};base < numchans;base += 4)
+    {
+        const ALsizei lanes{mini(numchans-base, 4)};
+        if(lanes == 1)
+        {
+            filters[base]->process(dst[base], src[base], numsamples);
+            break;
+        }
+
+        alignas(16) ALfloat coeffs[5][4]{};
+        alignas(16) ALfloat z[2][4]{};
+        for(ALsizei l{0};l < lanes;l++)
+        {
+            const auto c = filters[base+l]->getCoefficients();
+            for(size_t k{0};k < c.size();k++)
+                coeffs[k][l] = c[k];
+            std::tie(z[0][l], z[1][l]) = filters[base+l]->getComponents();
+        }
+        const float32x4_t b0{vld1q_f32(coeffs[0])};
+        const float32x4_t b1{vld1q_f32(coeffs[1])};
+        const float32x4_t b2{vld1q_f32(coeffs[2])};
+        const float32x4_t a1{vld1q_f32(coeffs[3])};
+        const float32x4_t a2{vld1q_f32(coeffs[4])};
+        float32x4_t z1{vld1q_f32(z[0])};
+        float32x4_t z2{vld1q_f32(z[1])};
+
+        const ALfloat *const *RESTRICT srcs{src + base};
+        ALfloat *const *RESTRICT dsts{dst + base};
+        for(ALsizei pos{0};pos < numsamples;pos++)
+        {
+            alignas(16) ALfloat vals[4]{};
+            for(ALsizei l{0};l < lanes;l++)
+                vals[l] = srcs[l][pos];
+
+            const float32x4_t input{vld1q_f32(vals)};
+            const float32x4_t output{vaddq_f32(vmulq_f32(input, b0), z1)};
+            z1 = vaddq_f32(vsubq_f32(vmulq_f32(input, b1), vmulq_f32(output, a1)), z2);
+            z2 = vsubq_f32(vmulq_f32(input, b2), vmulq_f32(output, a2));
+
+            vst1q_f32(vals, output);
+            for(ALsizei l{0};l < lanes;l++)
+                dsts[l][pos] = vals[l];
+        }
+
+        vst1q_f32(z[0], z1);
+        vst1q_f32(z[1], z2);
+        for(ALsizei l{0};l < lanes;l++)
+            filters[base+l]->setComponents(z[0][l], z[1][l]);
+    }
+}
+
+template<>
+void BiquadCascade_<NEONTag>(BiquadFilter *const *filters, ALfloat *const *dst,
+    const ALfloat *const *src, const ALsizei numchans, const ALsizei numsamples)
+{
+    ASSUME(numchans > 0);
+    ASSUME(numsamples > 0);
+
+    /* As with BiquadMulti_, each element of the vectors is a separate
+     * channel. Every stage's coefficients and state stay in registers, and
+     * each sample runs through all the stages before being stored.
+     */
+    for(ALsizei base{0};base < numchans;base += 4)
+    {
+        const ALsizei lanes{mini(numchans-base, 4)};
+
+        alignas(16) ALfloat coeffs[BIQUAD_CASCADE_STAGES][5][4]{};
+        alignas(16) ALfloat z[BIQUAD_CASCADE_STAGES][2][4]{};
+        for(ALsizei l{0};l < lanes;l++)
+        {
+            const BiquadFilter *stages{filters[base+l]};
+            for(ALsizei s{0};s < BIQUAD_CASCADE_STAGES;s++)
+            {
+                const auto c = stages[s].getCoefficients();
+                for(size_t k{0};k < c.size();k++)
+                    coeffs[s][k][l] = c[k];
+                std::tie(z[s][0][l], z[s][1][l]) = stages[s].getComponents();
+            }
+        }
+        float32x4_t b0[BIQUAD_CASCADE_STAGES], b1[BIQUAD_CASCADE_STAGES];
+        float32x4_t b2[BIQUAD_CASCADE_STAGES], a1[BIQUAD_CASCADE_STAGES];
+        float32x4_t a2[BIQUAD_CASCADE_STAGES];
+        float32x4_t z1[BIQUAD_CASCADE_STAGES], z2[BIQUAD_CASCADE_STAGES];
+        for(ALsizei s{0};s < BIQUAD_CASCADE_STAGES;s++)
+        {
+            b0[s] = vld1q_f32(coeffs[s][0]);
+            b1[s] = vld1q_f32(coeffs[s][1]);
+            b2[s] = vld1q_f32(coeffs[s][2]);
+            a1[s] = vld1q_f32(coeffs[s][3]);
+            a2[s] = vld1q_f32(coeffs[s][4]);
+            z1[s] = vld1q_f32(z[s][0]);
+            z2[s] = vld1q_f32(z[s][1]);
+        }
+
+        const ALfloat *const *RESTRICT srcs{src + base};
+        ALfloat *const *RESTRICT dsts{dst + base};
+        for(ALsizei pos{0};pos < numsamples;pos++)
+        {
+            alignas(16) ALfloat vals[4]{};
+            for(ALsizei l{0};l < lanes;l++)
+                vals[l] = srcs[l][pos];
+
+            float32x4_t val{vld1q_f32(vals)};
+            for(ALsizei s{0};s < BIQUAD_CASCADE_STAGES;s++)
+            {
+                const float32x4_t output{vaddq_f32(vmulq_f32(val, b0[s]), z1[s])};
+                z1[s] = vaddq_f32(vsubq_f32(vmulq_f32(val, b1[s]), vmulq_f32(output, a1[s])),
+                    z2[s]);
+                z2[s] = vsubq_f32(vmulq_f32(val, b2[s]), vmulq_f32(output, a2[s]));
+                val = output;
+            }
+
+            vst1q_f32(vals, val);
+            for(ALsizei l{0};l < lanes;l++)
+                dsts[l][pos] = vals[l];
+        }
+
+        for(ALsizei s{0};s < BIQUAD_CASCADE_STAGES;s++)
+        {
+            vst1q_f32(z[s][0], z1[s]);
+            vst1q_f32(z[s][1], z2[s]);
+        }
+        for(ALsizei l{0};l < lanes;l++)
+        {
+            BiquadFilter *stages{filters[base+l]};
+            for(ALsizei s{0};s < BIQUAD_CASCADE_STAGES;s++)
+                stages[s].setComponents(z[s][0][l], z[s][1][l]);
+        }
+    }
+}
+
+template<>
+void BlendHalf_<NEONTag>(ALfloat *RESTRICT dst, const ALushort *RESTRICT src,
+    const ALfloat scale, const ALsizei count)
+{
+    ASSUME(count > 0);
+
+    ALsizei pos{0};
+#ifdef __aarch64__
+    /* AArch64 always has half-precision conversions. */
+    const float32x4_t scale4{vdupq_n_f32(scale)};
+    for(;count-pos > 3;pos += 4)
+    {
+        const float32x4_t vals{vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(&src[pos])))};
+        vst1q_f32(&dst[pos], vmlaq_f32(vld1q_f32(&dst[pos]), vals, scale4));
+    }
+#endif
+    for(;pos < count;pos++)
+        dst[pos] = half2float(src[pos])*scale + dst[pos];
+}
+
+/* The structured loads read whole frames, so they can read up to srcstep-1
+ * values past the last sample they use. Those are only guaranteed to be in
+ * the buffer if another sample follows, so the loops stop one sample early
+ * and leave it to the scalar tail.
+ */
+static inline void AddUBytes16(ALfloat *RESTRICT dst, const uint8x16_t vals)
+{
+    const int16x8_t bias8{vdupq_n_s16(128)};
+    const float32x4_t scale4{vdupq_n_f32(1.0f/128.0f)};
+    const int16x8_t lo{vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vget_low_u8(vals))), bias8)};
+    const int16x8_t hi{vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vget_high_u8(vals))), bias8)};
+    vst1q_f32(&dst[0], vmlaq_f32(vld1q_f32(&dst[0]),
+        vcvtq_f32_s32(vmovl_s16(vget_low_s16(lo))), scale4));
+    vst1q_f32(&dst[4], vmlaq_f32(vld1q_f32(&dst[4]),
+        vcvtq_f32_s32(vmovl_s16(vget_high_s16(lo))), scale4));
+    vst1q_f32(&dst[8], vmlaq_f32(vld1q_f32(&dst[8]),
+        vcvtq_f32_s32(vmovl_s16(vget_low_s16(hi))), scale4));
+    vst1q_f32(&dst[12], vmlaq_f32(vld1q_f32(&dst[12]),
+        vcvtq_f32_s32(vmovl_s16(vget_high_s16(hi))), scale4));
+}
+
+static inline void AddShorts8(ALfloat *RESTRICT dst, const int16x8_t vals)
+{
+    const float32x4_t scale4{vdupq_n_f32(1.0f/32768.0f)};
+    vst1q_f32(&dst[0], vmlaq_f32(vld1q_f32(&dst[0]),
+        vcvtq_f32_s32(vmovl_s16(vget_low_s16(vals))), scale4));
+    vst1q_f32(&dst[4], vmlaq_f32(vld1q_f32(&dst[4]),
+        vcvtq_f32_s32(vmovl_s16(vget_high_s16(vals))), scale4));
+}
+
+template<>
+void LoadSamples_<NEONTag>(ALfloat *RESTRICT dst, const ALvoid *RESTRICT src,
+    const ALint srcstep, const FmtType srctype, const ALsizei samples)
+{
+    ASSUME(srcstep > 0);
+    ASSUME(samples >= 0);
+
+    ALsizei i{0};
+    switch(srctype)
+    {
+        case FmtUByte:
+        {
+            const auto *ssrc = static_cast<const ALubyte*>(src);
+            if(srcstep == 1)
+            {
+                for(;samples-i > 15;i += 16)
+                    AddUBytes16(&dst[i], vld1q_u8(&ssrc[i]));
+            }
+            else if(srcstep == 2)
+            {
+                for(;samples-i > 16;i += 16)
+                    AddUBytes16(&dst[i], vld2q_u8(&ssrc[i*2]).val[0]);
+            }
+            else if(srcstep == 4)
+            {
+                for(;samples-i > 16;i += 16)
+                    AddUBytes16(&dst[i], vld4q_u8(&ssrc[i*4]).val[0]);
+            }
+            for(;i < samples;i++)
+                dst[i] += (ssrc[i*srcstep]-128) * (1.0f/128.0f);
+            break;
+        }
+        case FmtShort:
+        {
+            const auto *ssrc = static_cast<const ALshort*>(src);
+            if(srcstep == 1)
+            {
+                for(;samples-i > 7;i += 8)
+                    AddShorts8(&dst[i], vld1q_s16(&ssrc[i]));
+            }
+            else if(srcstep == 2)
+            {
+                for(;samples-i > 8;i += 8)
+                    AddShorts8(&dst[i], vld2q_s16(&ssrc[i*2]).val[0]);
+            }
+            else if(srcstep == 4)
+            {
+                for(;samples-i > 8;i += 8)
+                    AddShorts8(&dst[i], vld4q_s16(&ssrc[i*4]).val[0]);
+            }
+            for(;i < samples;i++)
+                dst[i] += ssrc[i*srcstep] * (1.0f/32768.0f);
+            break;
+        }
+        case FmtFloat:
+        {
+            const auto *ssrc = static_cast<const ALfloat*>(src);
+            if(srcstep == 1)
+            {
+                for(;samples-i > 3;i += 4)
+                    vst1q_f32(&dst[i], vaddq_f32(vld1q_f32(&dst[i]), vld1q_f32(&ssrc[i])));
+            }
+            else if(srcstep == 2)
+            {
+                for(;samples-i > 4;i += 4)
+                    vst1q_f32(&dst[i], vaddq_f32(vld1q_f32(&dst[i]), vld2q_f32(&ssrc[i*2]).val[0]));
+            }
+            else if(srcstep == 4)
+            {
+                for(;samples-i > 4;i += 4)
+                    vst1q_f32(&dst[i], vaddq_f32(vld1q_f32(&dst[i]), vld4q_f32(&ssrc[i*4]).val[0]));
+            }
+            for(;i < samples;i++)
+                dst[i] += ssrc[i*srcstep];
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+
+/* Stores with the scalar conversion, for the samples (or layouts) the vector
+ * loops don't handle.
+ */
+static inline ALshort StoreSample(ALshort, const ALfloat val)
+{ return static_cast<ALshort>(fastf2i(clampf(val*32768.0f, -32768.0f, 32767.0f))); }
+static inline ALint StoreSample(ALint, const ALfloat val)
+{ return fastf2i(clampf(val*2147483648.0f, -2147483648.0f, 2147483520.0f)); }
+static inline ALfloat StoreSample(ALfloat, const ALfloat val)
+{ return val; }
+
+template<typename T>
+static inline void StoreSampleTail(T *RESTRICT dst, const ALfloat *const *RESTRICT src,
+    const ALsizei srcchans, const ALsizei dststep, ALsizei i, const ALsizei samples)
+{
+    for(;i < samples;i++)
+    {
+        for(ALsizei c{0};c < srcchans;c++)
+            dst[i*dststep + c] = StoreSample(T{}, src[c][i]);
+    }
+}
+
+#ifdef __aarch64__
+/* Clamps like clampf (including for NaNs), and rounds to nearest like
+ * fastf2i.
+ */
+static inline int32x4_t ConvertStore4(const float32x4_t vals, const ALfloat scale,
+    const ALfloat minval, const ALfloat maxval)
+{
+    const float32x4_t min4{vdupq_n_f32(minval)};
+    const float32x4_t max4{vdupq_n_f32(maxval)};
+    float32x4_t scaled{vmulq_f32(vals, vdupq_n_f32(scale))};
+    scaled = vbslq_f32(vcgtq_f32(min4, scaled), min4, scaled);
+    scaled = vbslq_f32(vcgtq_f32(max4, scaled), scaled, max4);
+    return vcvtnq_s32_f32(scaled);
+}
+#endif
+
+template<>
+void StoreSamples_<NEONTag>(ALvoid *RESTRICT dst, const ALfloat *const *RESTRICT src,
+    const ALsizei srcchans, const ALsizei dststep, const DevFmtType dsttype,
+    const ALsizei samples)
+{
+    ASSUME(srcchans > 0);
+    ASSUME(dststep >= srcchans);
+    ASSUME(samples >= 0);
+
+    /* Only interleaved stereo gets a vector loop, using the structured
+     * stores. Integer output needs AArch64's round-to-nearest conversion.
+     */
+    const bool stereo{srcchans == 2 && dststep == 2};
+    ALsizei i{0};
+    switch(dsttype)
+    {
+        case DevFmtShort:
+        {
+            auto *sdst = static_cast<ALshort*>(dst);
+#ifdef __aarch64__
+            if(stereo)
+            {
+                for(;samples-i > 3;i += 4)
+                {
+                    int16x4x2_t vals;
+                    vals.val[0] = vqmovn_s32(ConvertStore4(vld1q_f32(&src[0][i]), 32768.0f,
+                        -32768.0f, 32767.0f));
+                    vals.val[1] = vqmovn_s32(ConvertStore4(vld1q_f32(&src[1][i]), 32768.0f,
+                        -32768.0f, 32767.0f));
+                    vst2_s16(&sdst[i*2], vals);
+                }
+            }
+#endif
+            StoreSampleTail(sdst, src, srcchans, dststep, i, samples);
+            break;
+        }
+        case DevFmtInt:
+        {
+            auto *sdst = static_cast<ALint*>(dst);
+#ifdef __aarch64__
+            if(stereo)
+            {
+                for(;samples-i > 3;i += 4)
+                {
+                    int32x4x2_t vals;
+                    vals.val[0] = ConvertStore4(vld1q_f32(&src[0][i]), 2147483648.0f,
+                        -2147483648.0f, 2147483520.0f);
+                    vals.val[1] = ConvertStore4(vld1q_f32(&src[1][i]), 2147483648.0f,
+                        -2147483648.0f, 2147483520.0f);
+                    vst2q_s32(&sdst[i*2], vals);
+                }
+            }
+#endif
+            StoreSampleTail(sdst, src, srcchans, dststep, i, samples);
+            break;
+        }
+        case DevFmtFloat:
+        {
+            auto *sdst = static_cast<ALfloat*>(dst);
+            if(stereo)
+            {
+                for(;samples-i > 3;i += 4)
+                {
+                    float32x4x2_t vals;
+                    vals.val[0] = vld1q_f32(&src[0][i]);
+                    vals.val[1] = vld1q_f32(&src[1][i]);
+                    vst2q_f32(&sdst[i*2], vals);
+                }
+            }
+            StoreSampleTail(sdst, src, srcchans, dststep, i, samples);
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+template<>
+void Dither_<NEONTag>(ALfloat *RESTRICT buffer, ALuint *RESTRICT seeds, const ALfloat quant_scale,
+    const ALsizei samples)
+{
+    static_assert(DITHER_RNG_LANES == 4, "Dither lanes must match the vector size");
+    ASSUME(samples > 0);
+
+    auto xorshift4 = [](uint32x4_t x) noexcept -> uint32x4_t
+    {
+        x = veorq_u32(x, vshlq_n_u32(x, 13));
+        x = veorq_u32(x, vshrq_n_u32(x, 17));
+        x = veorq_u32(x, vshlq_n_u32(x, 5));
+        return x;
+    };
+    /* Rounds like fast_roundf, adding and removing 2^23 with the value's
+     * sign, except for values that are already integral.
+     */
+    const uint32x4_t signmask4{vdupq_n_u32(0x80000000u)};
+    const float32x4_t ilim4{vdupq_n_f32(8388608.0f)};
+    auto round4 = [signmask4,ilim4](const float32x4_t vals) noexcept -> float32x4_t
+    {
+        const float32x4_t ilim{vreinterpretq_f32_u32(vorrq_u32(vreinterpretq_u32_f32(ilim4),
+            vandq_u32(vreinterpretq_u32_f32(vals), signmask4)))};
+        const float32x4_t rounded{vsubq_f32(vaddq_f32(vals, ilim), ilim)};
+        return vbslq_f32(vcgeq_f32(vabsq_f32(vals), ilim4), vals, rounded);
+    };
+
+    const float32x4_t scale4{vdupq_n_f32(quant_scale)};
+    const float32x4_t invscale4{vdupq_n_f32(1.0f / quant_scale)};
+    const float32x4_t noisescale4{vdupq_n_f32(1.0f/16777216.0f)};
+    uint32x4_t rng{vld1q_u32(seeds)};
+    for(ALsizei base{0};base < samples;base += 4)
+    {
+        const uint32x4_t rng0{xorshift4(rng)};
+        rng = xorshift4(rng0);
+        const float32x4_t noise{vmulq_f32(vsubq_f32(
+            vcvtq_f32_s32(vreinterpretq_s32_u32(vshrq_n_u32(rng0, 8))),
+            vcvtq_f32_s32(vreinterpretq_s32_u32(vshrq_n_u32(rng, 8)))), noisescale4)};
+
+        if(LIKELY(samples-base >= 4))
+        {
+            float32x4_t vals{vld1q_f32(&buffer[base])};
+            vals = vaddq_f32(vmulq_f32(vals, scale4), noise);
+            vst1q_f32(&buffer[base], vmulq_f32(round4(vals), invscale4));
+        }
+        else
+        {
+            alignas(16) ALfloat tmp[4]{};
+            std::copy(buffer+base, buffer+samples, std::begin(tmp));
+            float32x4_t vals{vld1q_f32(tmp)};
+            vals = vaddq_f32(vmulq_f32(vals, scale4), noise);
+            vst1q_f32(tmp, vmulq_f32(round4(vals), invscale4));
+            std::copy_n(std::begin(tmp), samples-base, buffer+base);
+        }
+    }
+    vst1q_u32(seeds, rng);
+}
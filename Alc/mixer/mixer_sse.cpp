@@ -3,6 +3,7 @@
 #include <xmmintrin.h>
 
 #include <limits>
+#include <tuple>
 
 #include "AL/al.h"
 #include "AL/alc.h"
@@ -75,6 +76,183 @@ const ALfloat *Resample_<BSincTag,SSETag>(const InterpState *state, const ALfloa
     return dst;
 }
 
+template<>
+const ALfloat *Resample_<FastBSincTag,SSETag>(const InterpState *state,
+    const ALfloat *RESTRICT src, ALsizei frac, ALint increment, ALfloat *RESTRICT dst,
+    ALsizei dstlen)
+{
+    const ALfloat *const filter{state->bsinc.filter};
+    const ALsizei m{state->bsinc.m};
+
+    ASSUME(m > 0);
+    ASSUME(dstlen > 0);
+    ASSUME(increment > 0);
+    ASSUME(frac >= 0);
+
+    src -= state->bsinc.l;
+    for(ALsizei i{0};i < dstlen;i++)
+    {
+        // Calculate the phase index and factor.
+#define FRAC_PHASE_BITDIFF (FRACTIONBITS-BSINC_PHASE_BITS)
+        const ALsizei pi{frac >> FRAC_PHASE_BITDIFF};
+        const ALfloat pf{(frac & ((1<<FRAC_PHASE_BITDIFF)-1)) * (1.0f/(1<<FRAC_PHASE_BITDIFF))};
+#undef FRAC_PHASE_BITDIFF
+
+        ALsizei offset{m*pi*4};
+        const __m128 *fil{reinterpret_cast<const __m128*>(filter + offset)}; offset += m*2;
+        const __m128 *phd{reinterpret_cast<const __m128*>(filter + offset)};
+
+        // Apply the phase interpolated filter.
+        __m128 r4{_mm_setzero_ps()};
+        {
+            const ALsizei count{m >> 2};
+            const __m128 pf4{_mm_set1_ps(pf)};
+
+            ASSUME(count > 0);
+
+#define MLA4(x, y, z) _mm_add_ps(x, _mm_mul_ps(y, z))
+            for(ALsizei j{0};j < count;j++)
+            {
+                /* f = fil + pf*phd */
+                const __m128 f4 = MLA4(fil[j], pf4, phd[j]);
+                /* r += f*src */
+                r4 = MLA4(r4, f4, _mm_loadu_ps(&src[j*4]));
+            }
+#undef MLA4
+        }
+        r4 = _mm_add_ps(r4, _mm_shuffle_ps(r4, r4, _MM_SHUFFLE(0, 1, 2, 3)));
+        r4 = _mm_add_ps(r4, _mm_movehl_ps(r4, r4));
+        dst[i] = _mm_cvtss_f32(r4);
+
+        frac += increment;
+        src  += frac>>FRACTIONBITS;
+        frac &= FRACTIONMASK;
+    }
+    return dst;
+}
+
+template<>
+void ResampleMulti_<BSincTag,SSETag>(const InterpState *state, const ALfloat *const *RESTRICT src,
+    const ALsizei numchans, ALsizei frac, ALint increment, ALfloat *const *RESTRICT dst,
+    ALsizei dstlen)
+{
+    const ALfloat *const filter{state->bsinc.filter};
+    const __m128 sf4{_mm_set1_ps(state->bsinc.sf)};
+    const ALsizei m{state->bsinc.m};
+    const ALsizei l{state->bsinc.l};
+    const ALsizei count{m >> 2};
+
+    ASSUME(m > 0);
+    ASSUME(count > 0);
+    ASSUME(numchans > 0);
+    ASSUME(dstlen > 0);
+    ASSUME(increment > 0);
+    ASSUME(frac >= 0);
+
+    __m128 f4[MAX_RESAMPLE_PADDING*2 / 4];
+    ALsizei pos{0};
+    for(ALsizei i{0};i < dstlen;i++)
+    {
+        // Calculate the phase index and factor.
+#define FRAC_PHASE_BITDIFF (FRACTIONBITS-BSINC_PHASE_BITS)
+        const ALsizei pi{frac >> FRAC_PHASE_BITDIFF};
+        const ALfloat pf{(frac & ((1<<FRAC_PHASE_BITDIFF)-1)) * (1.0f/(1<<FRAC_PHASE_BITDIFF))};
+#undef FRAC_PHASE_BITDIFF
+
+        ALsizei offset{m*pi*4};
+        const __m128 *fil{reinterpret_cast<const __m128*>(filter + offset)}; offset += m;
+        const __m128 *scd{reinterpret_cast<const __m128*>(filter + offset)}; offset += m;
+        const __m128 *phd{reinterpret_cast<const __m128*>(filter + offset)}; offset += m;
+        const __m128 *spd{reinterpret_cast<const __m128*>(filter + offset)};
+
+        // Interpolate the filter once, then apply it to each channel.
+#define MLA4(x, y, z) _mm_add_ps(x, _mm_mul_ps(y, z))
+        const __m128 pf4{_mm_set1_ps(pf)};
+        for(ALsizei j{0};j < count;j++)
+        {
+            /* f = ((fil + sf*scd) + pf*(phd + sf*spd)) */
+            f4[j] = MLA4(
+                MLA4(fil[j], sf4, scd[j]),
+                pf4, MLA4(phd[j], sf4, spd[j])
+            );
+        }
+        for(ALsizei c{0};c < numchans;c++)
+        {
+            const ALfloat *RESTRICT vals{src[c] + pos - l};
+            __m128 r4{_mm_setzero_ps()};
+            /* r += f*src */
+            for(ALsizei j{0};j < count;j++)
+                r4 = MLA4(r4, f4[j], _mm_loadu_ps(&vals[j*4]));
+            r4 = _mm_add_ps(r4, _mm_shuffle_ps(r4, r4, _MM_SHUFFLE(0, 1, 2, 3)));
+            r4 = _mm_add_ps(r4, _mm_movehl_ps(r4, r4));
+            dst[c][i] = _mm_cvtss_f32(r4);
+        }
+#undef MLA4
+
+        frac += increment;
+        pos  += frac>>FRACTIONBITS;
+        frac &= FRACTIONMASK;
+    }
+}
+
+template<>
+void ResampleMulti_<FastBSincTag,SSETag>(const InterpState *state,
+    const ALfloat *const *RESTRICT src, const ALsizei numchans, ALsizei frac, ALint increment,
+    ALfloat *const *RESTRICT dst, ALsizei dstlen)
+{
+    const ALfloat *const filter{state->bsinc.filter};
+    const ALsizei m{state->bsinc.m};
+    const ALsizei l{state->bsinc.l};
+    const ALsizei count{m >> 2};
+
+    ASSUME(m > 0);
+    ASSUME(count > 0);
+    ASSUME(numchans > 0);
+    ASSUME(dstlen > 0);
+    ASSUME(increment > 0);
+    ASSUME(frac >= 0);
+
+    __m128 f4[MAX_RESAMPLE_PADDING*2 / 4];
+    ALsizei pos{0};
+    for(ALsizei i{0};i < dstlen;i++)
+    {
+        // Calculate the phase index and factor.
+#define FRAC_PHASE_BITDIFF (FRACTIONBITS-BSINC_PHASE_BITS)
+        const ALsizei pi{frac >> FRAC_PHASE_BITDIFF};
+        const ALfloat pf{(frac & ((1<<FRAC_PHASE_BITDIFF)-1)) * (1.0f/(1<<FRAC_PHASE_BITDIFF))};
+#undef FRAC_PHASE_BITDIFF
+
+        ALsizei offset{m*pi*4};
+        const __m128 *fil{reinterpret_cast<const __m128*>(filter + offset)}; offset += m*2;
+        const __m128 *phd{reinterpret_cast<const __m128*>(filter + offset)};
+
+        // Interpolate the filter once, then apply it to each channel.
+#define MLA4(x, y, z) _mm_add_ps(x, _mm_mul_ps(y, z))
+        const __m128 pf4{_mm_set1_ps(pf)};
+        for(ALsizei j{0};j < count;j++)
+        {
+            /* f = fil + pf*phd */
+            f4[j] = MLA4(fil[j], pf4, phd[j]);
+        }
+        for(ALsizei c{0};c < numchans;c++)
+        {
+            const ALfloat *RESTRICT vals{src[c] + pos - l};
+            __m128 r4{_mm_setzero_ps()};
+            /* r += f*src */
+            for(ALsizei j{0};j < count;j++)
+                r4 = MLA4(r4, f4[j], _mm_loadu_ps(&vals[j*4]));
+            r4 = _mm_add_ps(r4, _mm_shuffle_ps(r4, r4, _MM_SHUFFLE(0, 1, 2, 3)));
+            r4 = _mm_add_ps(r4, _mm_movehl_ps(r4, r4));
+            dst[c][i] = _mm_cvtss_f32(r4);
+        }
+#undef MLA4
+
+        frac += increment;
+        pos  += frac>>FRACTIONBITS;
+        frac &= FRACTIONMASK;
+    }
+}
+
 
 static inline void ApplyCoeffs(ALsizei Offset, float2 *RESTRICT Values, const ALsizei IrSize,
     const HrirArray<ALfloat> &Coeffs, const ALfloat left, const ALfloat right)
@@ -119,6 +297,51 @@ static inline void ApplyCoeffs(ALsizei Offset, float2 *RESTRICT Values, const AL
     }
 }
 
+static inline void ApplyCoeffsPair(ALsizei Offset, float2 *RESTRICT Values,
+    const ALsizei IrSize, const HrirArray<ALfloat> &Coeffs0, const HrirArray<ALfloat> &Coeffs1,
+    const ALfloat in0, const ALfloat in1)
+{
+    const __m128 in0_4{_mm_set1_ps(in0)};
+    const __m128 in1_4{_mm_set1_ps(in1)};
+
+    ASSUME(IrSize >= 2);
+
+    if((Offset&1))
+    {
+        __m128 imp0, imp1;
+        __m128 vals{_mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<__m64*>(&Values[0][0]))};
+        imp0 = _mm_add_ps(_mm_mul_ps(in0_4, _mm_load_ps(&Coeffs0[0][0])),
+            _mm_mul_ps(in1_4, _mm_load_ps(&Coeffs1[0][0])));
+        vals = _mm_add_ps(imp0, vals);
+        _mm_storel_pi(reinterpret_cast<__m64*>(&Values[0][0]), vals);
+        ALsizei i{1};
+        for(;i < IrSize-1;i += 2)
+        {
+            vals = _mm_load_ps(&Values[i][0]);
+            imp1 = _mm_add_ps(_mm_mul_ps(in0_4, _mm_load_ps(&Coeffs0[i+1][0])),
+                _mm_mul_ps(in1_4, _mm_load_ps(&Coeffs1[i+1][0])));
+            imp0 = _mm_shuffle_ps(imp0, imp1, _MM_SHUFFLE(1, 0, 3, 2));
+            vals = _mm_add_ps(imp0, vals);
+            _mm_store_ps(&Values[i][0], vals);
+            imp0 = imp1;
+        }
+        vals = _mm_loadl_pi(vals, reinterpret_cast<__m64*>(&Values[i][0]));
+        imp0 = _mm_movehl_ps(imp0, imp0);
+        vals = _mm_add_ps(imp0, vals);
+        _mm_storel_pi(reinterpret_cast<__m64*>(&Values[i][0]), vals);
+    }
+    else
+    {
+        for(ALsizei i{0};i < IrSize;i += 2)
+        {
+            __m128 vals{_mm_load_ps(&Values[i][0])};
+            vals = _mm_add_ps(vals, _mm_mul_ps(in0_4, _mm_load_ps(&Coeffs0[i][0])));
+            vals = _mm_add_ps(vals, _mm_mul_ps(in1_4, _mm_load_ps(&Coeffs1[i][0])));
+            _mm_store_ps(&Values[i][0], vals);
+        }
+    }
+}
+
 template<>
 void MixHrtf_<SSETag>(ALfloat *RESTRICT LeftOut, ALfloat *RESTRICT RightOut, const ALfloat *data,
     float2 *RESTRICT AccumSamples, const ALsizei OutPos, const ALsizei IrSize,
@@ -142,8 +365,8 @@ void MixDirectHrtf_<SSETag>(ALfloat *RESTRICT LeftOut, ALfloat *RESTRICT RightOu
     const ALfloat (*data)[BUFFERSIZE], float2 *RESTRICT AccumSamples, DirectHrtfState *State,
     const ALsizei NumChans, const ALsizei BufferSize)
 {
-    MixDirectHrtfBase<ApplyCoeffs>(LeftOut, RightOut, data, AccumSamples, State, NumChans,
-        BufferSize);
+    MixDirectHrtfBase<ApplyCoeffs, ApplyCoeffsPair>(LeftOut, RightOut, data, AccumSamples,
+        State, NumChans, BufferSize);
 }
 
 
@@ -261,3 +484,188 @@ void MixRow_<SSETag>(ALfloat *OutBuffer, const ALfloat *Gains, const ALfloat (*d
             OutBuffer[pos] += src[pos]*gain;
     }
 }
+
+template<>
+void BiquadMulti_<SSETag>(BiquadFilter *const *filters, ALfloat *const *dst,
+    const ALfloat *const *src, const ALsizei numchans, const ALsizei numsamples)
+{
+    ASSUME(numchans > 0);
+    ASSUME(numsamples > 0);
+
+    /* Each element of the vectors is a separate channel's filter, so up to
+     * four channels run through the (serial) filter recurrence at once. Four
+     * samples are loaded from each channel and transposed, so each vector
+     * holds the same sample of every channel. Unused elements get zeroed
+     * coefficients and input, and are never stored.
+     */
+    for(ALsizei base{0};base < numchans;base += 4)
+    {
+        const ALsizei lanes{mini(numchans-base, 4)};
+        if(lanes == 1)
+        {
+            filters[base]->process(dst[base], src[base], numsamples);
+            break;
+        }
+
+        alignas(16) ALfloat coeffs[5][4]{};
+        alignas(16) ALfloat z[2][4]{};
+        for(ALsizei l{0};l < lanes;l++)
+        {
+            const auto c = filters[base+l]->getCoefficients();
+            for(size_t k{0};k < c.size();k++)
+                coeffs[k][l] = c[k];
+            std::tie(z[0][l], z[1][l]) = filters[base+l]->getComponents();
+        }
+        const __m128 b0{_mm_load_ps(coeffs[0])};
+        const __m128 b1{_mm_load_ps(coeffs[1])};
+        const __m128 b2{_mm_load_ps(coeffs[2])};
+        const __m128 a1{_mm_load_ps(coeffs[3])};
+        const __m128 a2{_mm_load_ps(coeffs[4])};
+        __m128 z1{_mm_load_ps(z[0])};
+        __m128 z2{_mm_load_ps(z[1])};
+
+        auto proc_sample = [b0,b1,b2,a1,a2,&z1,&z2](const __m128 input) noexcept -> __m128
+        {
+            const __m128 output{_mm_add_ps(_mm_mul_ps(input, b0), z1)};
+            z1 = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(input, b1), _mm_mul_ps(output, a1)), z2);
+            z2 = _mm_sub_ps(_mm_mul_ps(input, b2), _mm_mul_ps(output, a2));
+            return output;
+        };
+
+        const ALfloat *const *RESTRICT srcs{src + base};
+        ALfloat *const *RESTRICT dsts{dst + base};
+        ALsizei pos{0};
+        for(;numsamples-pos > 3;pos += 4)
+        {
+            __m128 vals[4]{_mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps(),
+                _mm_setzero_ps()};
+            for(ALsizei l{0};l < lanes;l++)
+                vals[l] = _mm_loadu_ps(&srcs[l][pos]);
+            _MM_TRANSPOSE4_PS(vals[0], vals[1], vals[2], vals[3]);
+
+            vals[0] = proc_sample(vals[0]);
+            vals[1] = proc_sample(vals[1]);
+            vals[2] = proc_sample(vals[2]);
+            vals[3] = proc_sample(vals[3]);
+
+            _MM_TRANSPOSE4_PS(vals[0], vals[1], vals[2], vals[3]);
+            for(ALsizei l{0};l < lanes;l++)
+                _mm_storeu_ps(&dsts[l][pos], vals[l]);
+        }
+        for(;pos < numsamples;pos++)
+        {
+            alignas(16) ALfloat vals[4]{};
+            for(ALsizei l{0};l < lanes;l++)
+                vals[l] = srcs[l][pos];
+            _mm_store_ps(vals, proc_sample(_mm_load_ps(vals)));
+            for(ALsizei l{0};l < lanes;l++)
+                dsts[l][pos] = vals[l];
+        }
+
+        _mm_store_ps(z[0], z1);
+        _mm_store_ps(z[1], z2);
+        for(ALsizei l{0};l < lanes;l++)
+            filters[base+l]->setComponents(z[0][l], z[1][l]);
+    }
+}
+
+template<>
+void BiquadCascade_<SSETag>(BiquadFilter *const *filters, ALfloat *const *dst,
+    const ALfloat *const *src, const ALsizei numchans, const ALsizei numsamples)
+{
+    ASSUME(numchans > 0);
+    ASSUME(numsamples > 0);
+
+    /* As with BiquadMulti_, each element of the vectors is a separate
+     * channel. Every stage's coefficients and state stay in registers, and
+     * each transposed sample vector runs through all the stages before being
+     * stored, so the cascade takes a single pass over the samples.
+     */
+    for(ALsizei base{0};base < numchans;base += 4)
+    {
+        const ALsizei lanes{mini(numchans-base, 4)};
+
+        alignas(16) ALfloat coeffs[BIQUAD_CASCADE_STAGES][5][4]{};
+        alignas(16) ALfloat z[BIQUAD_CASCADE_STAGES][2][4]{};
+        for(ALsizei l{0};l < lanes;l++)
+        {
+            const BiquadFilter *stages{filters[base+l]};
+            for(ALsizei s{0};s < BIQUAD_CASCADE_STAGES;s++)
+            {
+                const auto c = stages[s].getCoefficients();
+                for(size_t k{0};k < c.size();k++)
+                    coeffs[s][k][l] = c[k];
+                std::tie(z[s][0][l], z[s][1][l]) = stages[s].getComponents();
+            }
+        }
+        __m128 b0[BIQUAD_CASCADE_STAGES], b1[BIQUAD_CASCADE_STAGES];
+        __m128 b2[BIQUAD_CASCADE_STAGES], a1[BIQUAD_CASCADE_STAGES];
+        __m128 a2[BIQUAD_CASCADE_STAGES];
+        __m128 z1[BIQUAD_CASCADE_STAGES], z2[BIQUAD_CASCADE_STAGES];
+        for(ALsizei s{0};s < BIQUAD_CASCADE_STAGES;s++)
+        {
+            b0[s] = _mm_load_ps(coeffs[s][0]);
+            b1[s] = _mm_load_ps(coeffs[s][1]);
+            b2[s] = _mm_load_ps(coeffs[s][2]);
+            a1[s] = _mm_load_ps(coeffs[s][3]);
+            a2[s] = _mm_load_ps(coeffs[s][4]);
+            z1[s] = _mm_load_ps(z[s][0]);
+            z2[s] = _mm_load_ps(z[s][1]);
+        }
+
+        auto proc_sample = [&b0,&b1,&b2,&a1,&a2,&z1,&z2](__m128 val) noexcept -> __m128
+        {
+            for(ALsizei s{0};s < BIQUAD_CASCADE_STAGES;s++)
+            {
+                const __m128 output{_mm_add_ps(_mm_mul_ps(val, b0[s]), z1[s])};
+                z1[s] = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(val, b1[s]), _mm_mul_ps(output, a1[s])),
+                    z2[s]);
+                z2[s] = _mm_sub_ps(_mm_mul_ps(val, b2[s]), _mm_mul_ps(output, a2[s]));
+                val = output;
+            }
+            return val;
+        };
+
+        const ALfloat *const *RESTRICT srcs{src + base};
+        ALfloat *const *RESTRICT dsts{dst + base};
+        ALsizei pos{0};
+        for(;numsamples-pos > 3;pos += 4)
+        {
+            __m128 vals[4]{_mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps(),
+                _mm_setzero_ps()};
+            for(ALsizei l{0};l < lanes;l++)
+                vals[l] = _mm_loadu_ps(&srcs[l][pos]);
+            _MM_TRANSPOSE4_PS(vals[0], vals[1], vals[2], vals[3]);
+
+            vals[0] = proc_sample(vals[0]);
+            vals[1] = proc_sample(vals[1]);
+            vals[2] = proc_sample(vals[2]);
+            vals[3] = proc_sample(vals[3]);
+
+            _MM_TRANSPOSE4_PS(vals[0], vals[1], vals[2], vals[3]);
+            for(ALsizei l{0};l < lanes;l++)
+                _mm_storeu_ps(&dsts[l][pos], vals[l]);
+        }
+        for(;pos < numsamples;pos++)
+        {
+            alignas(16) ALfloat vals[4]{};
+            for(ALsizei l{0};l < lanes;l++)
+                vals[l] = srcs[l][pos];
+            _mm_store_ps(vals, proc_sample(_mm_load_ps(vals)));
+            for(ALsizei l{0};l < lanes;l++)
+                dsts[l][pos] = vals[l];
+        }
+
+        for(ALsizei s{0};s < BIQUAD_CASCADE_STAGES;s++)
+        {
+            _mm_store_ps(z[s][0], z1[s]);
+            _mm_store_ps(z[s][1], z2[s]);
+        }
+        for(ALsizei l{0};l < lanes;l++)
+        {
+            BiquadFilter *stages{filters[base+l]};
+            for(ALsizei s{0};s < BIQUAD_CASCADE_STAGES;s++)
+                stages[s].setComponents(z[s][0][l], z[s][1][l]);
+        }
+    }
+}
@@ -20,6 +20,10 @@
 
 #include "config.h"
 
+#include <string.h>
+
+#include <algorithm>
+
 #include <xmmintrin.h>
 #include <emmintrin.h>
 
@@ -27,6 +31,24 @@
 #include "defs.h"
 
 
+/* Vector version of cubic(), with the same order of operations. */
+static inline __m128 Cubic4(const __m128 val1, const __m128 val2, const __m128 val3,
+    const __m128 val4, const __m128 mu)
+{
+    const __m128 mu2{_mm_mul_ps(mu, mu)};
+    const __m128 mu3{_mm_mul_ps(mu2, mu)};
+    const __m128 a0{_mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(-0.5f), mu3), mu2),
+        _mm_mul_ps(_mm_set1_ps(-0.5f), mu))};
+    const __m128 a1{_mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(1.5f), mu3),
+        _mm_mul_ps(_mm_set1_ps(-2.5f), mu2)), _mm_set1_ps(1.0f))};
+    const __m128 a2{_mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(-1.5f), mu3),
+        _mm_mul_ps(_mm_set1_ps(2.0f), mu2)), _mm_mul_ps(_mm_set1_ps(0.5f), mu))};
+    const __m128 a3{_mm_add_ps(_mm_mul_ps(_mm_set1_ps(0.5f), mu3),
+        _mm_mul_ps(_mm_set1_ps(-0.5f), mu2))};
+    return _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(val1, a0), _mm_mul_ps(val2, a1)),
+        _mm_mul_ps(val3, a2)), _mm_mul_ps(val4, a3));
+}
+
 template<>
 const ALfloat *Resample_<LerpTag,SSE2Tag>(const InterpState* UNUSED(state),
   const ALfloat *RESTRICT src, ALsizei frac, ALint increment,
@@ -83,3 +105,502 @@ const ALfloat *Resample_<LerpTag,SSE2Tag>(const InterpState* UNUSED(state),
     }
     return dst;
 }
+
+template<>
+const ALfloat *Resample_<PointTag,SSE2Tag>(const InterpState* UNUSED(state),
+  const ALfloat *RESTRICT src, ALsizei frac, ALint increment,
+  ALfloat *RESTRICT dst, ALsizei dstlen)
+{
+    const __m128i increment4{_mm_set1_epi32(increment*4)};
+    const __m128i fracMask4{_mm_set1_epi32(FRACTIONMASK)};
+
+    ASSUME(frac >= 0);
+    ASSUME(increment > 0);
+    ASSUME(dstlen >= 0);
+
+    alignas(16) ALsizei pos_[4], frac_[4];
+    InitiatePositionArrays(frac, increment, frac_, pos_, 4);
+    __m128i frac4{_mm_setr_epi32(frac_[0], frac_[1], frac_[2], frac_[3])};
+    __m128i pos4{_mm_setr_epi32(pos_[0], pos_[1], pos_[2], pos_[3])};
+
+    const ALsizei todo{dstlen & ~3};
+    for(ALsizei i{0};i < todo;i += 4)
+    {
+        const int pos0{_mm_cvtsi128_si32(_mm_shuffle_epi32(pos4, _MM_SHUFFLE(0, 0, 0, 0)))};
+        const int pos1{_mm_cvtsi128_si32(_mm_shuffle_epi32(pos4, _MM_SHUFFLE(1, 1, 1, 1)))};
+        const int pos2{_mm_cvtsi128_si32(_mm_shuffle_epi32(pos4, _MM_SHUFFLE(2, 2, 2, 2)))};
+        const int pos3{_mm_cvtsi128_si32(_mm_shuffle_epi32(pos4, _MM_SHUFFLE(3, 3, 3, 3)))};
+        _mm_store_ps(&dst[i], _mm_setr_ps(src[pos0], src[pos1], src[pos2], src[pos3]));
+
+        frac4 = _mm_add_epi32(frac4, increment4);
+        pos4 = _mm_add_epi32(pos4, _mm_srli_epi32(frac4, FRACTIONBITS));
+        frac4 = _mm_and_si128(frac4, fracMask4);
+    }
+
+    ALsizei pos{_mm_cvtsi128_si32(pos4)};
+    frac = _mm_cvtsi128_si32(frac4);
+
+    for(ALsizei i{todo};i < dstlen;++i)
+    {
+        dst[i] = src[pos];
+
+        frac += increment;
+        pos  += frac>>FRACTIONBITS;
+        frac &= FRACTIONMASK;
+    }
+    return dst;
+}
+
+template<>
+const ALfloat *Resample_<CubicTag,SSE2Tag>(const InterpState* UNUSED(state),
+  const ALfloat *RESTRICT src, ALsizei frac, ALint increment,
+  ALfloat *RESTRICT dst, ALsizei dstlen)
+{
+    const __m128i increment4{_mm_set1_epi32(increment*4)};
+    const __m128 fracOne4{_mm_set1_ps(1.0f/FRACTIONONE)};
+    const __m128i fracMask4{_mm_set1_epi32(FRACTIONMASK)};
+
+    ASSUME(frac >= 0);
+    ASSUME(increment > 0);
+    ASSUME(dstlen >= 0);
+
+    alignas(16) ALsizei pos_[4], frac_[4];
+    InitiatePositionArrays(frac, increment, frac_, pos_, 4);
+    __m128i frac4{_mm_setr_epi32(frac_[0], frac_[1], frac_[2], frac_[3])};
+    __m128i pos4{_mm_setr_epi32(pos_[0], pos_[1], pos_[2], pos_[3])};
+
+    /* The four sample points start one before the current position. */
+    src -= 1;
+
+    const ALsizei todo{dstlen & ~3};
+    for(ALsizei i{0};i < todo;i += 4)
+    {
+        const int pos0{_mm_cvtsi128_si32(_mm_shuffle_epi32(pos4, _MM_SHUFFLE(0, 0, 0, 0)))};
+        const int pos1{_mm_cvtsi128_si32(_mm_shuffle_epi32(pos4, _MM_SHUFFLE(1, 1, 1, 1)))};
+        const int pos2{_mm_cvtsi128_si32(_mm_shuffle_epi32(pos4, _MM_SHUFFLE(2, 2, 2, 2)))};
+        const int pos3{_mm_cvtsi128_si32(_mm_shuffle_epi32(pos4, _MM_SHUFFLE(3, 3, 3, 3)))};
+        const __m128 val1{_mm_setr_ps(src[pos0  ], src[pos1  ], src[pos2  ], src[pos3  ])};
+        const __m128 val2{_mm_setr_ps(src[pos0+1], src[pos1+1], src[pos2+1], src[pos3+1])};
+        const __m128 val3{_mm_setr_ps(src[pos0+2], src[pos1+2], src[pos2+2], src[pos3+2])};
+        const __m128 val4{_mm_setr_ps(src[pos0+3], src[pos1+3], src[pos2+3], src[pos3+3])};
+
+        const __m128 mu{_mm_mul_ps(_mm_cvtepi32_ps(frac4), fracOne4)};
+        _mm_store_ps(&dst[i], Cubic4(val1, val2, val3, val4, mu));
+
+        frac4 = _mm_add_epi32(frac4, increment4);
+        pos4 = _mm_add_epi32(pos4, _mm_srli_epi32(frac4, FRACTIONBITS));
+        frac4 = _mm_and_si128(frac4, fracMask4);
+    }
+
+    /* NOTE: These four elements represent the position *after* the last four
+     * samples, so the lowest element is the next position to resample.
+     */
+    ALsizei pos{_mm_cvtsi128_si32(pos4)};
+    frac = _mm_cvtsi128_si32(frac4);
+
+    for(ALsizei i{todo};i < dstlen;++i)
+    {
+        dst[i] = cubic(src[pos], src[pos+1], src[pos+2], src[pos+3], frac * (1.0f/FRACTIONONE));
+
+        frac += increment;
+        pos  += frac>>FRACTIONBITS;
+        frac &= FRACTIONMASK;
+    }
+    return dst;
+}
+
+
+/* Converts four integer samples to float, scales them, and adds them to dst. */
+static inline void AddSamples4(ALfloat *RESTRICT dst, const __m128i ivals, const __m128 scale4)
+{
+    const __m128 vals{_mm_mul_ps(_mm_cvtepi32_ps(ivals), scale4)};
+    _mm_storeu_ps(dst, _mm_add_ps(_mm_loadu_ps(dst), vals));
+}
+
+/* Strided loads read up to srcstep-1 values past the last sample they use,
+ * which are only guaranteed to be in the buffer if another sample follows.
+ * Those loops stop one sample early and leave it to the scalar tail.
+ */
+static void LoadUBytes(ALfloat *RESTRICT dst, const ALubyte *RESTRICT src, const ALint srcstep,
+    const ALsizei samples)
+{
+    const __m128 scale4{_mm_set1_ps(1.0f/128.0f)};
+    const __m128i bias4{_mm_set1_epi32(128)};
+    const __m128i zero{_mm_setzero_si128()};
+
+    ALsizei i{0};
+    if(srcstep == 1)
+    {
+        for(;samples-i > 15;i += 16)
+        {
+            const __m128i vals{_mm_loadu_si128(reinterpret_cast<const __m128i*>(&src[i]))};
+            const __m128i lo{_mm_unpacklo_epi8(vals, zero)};
+            const __m128i hi{_mm_unpackhi_epi8(vals, zero)};
+            AddSamples4(&dst[i   ], _mm_sub_epi32(_mm_unpacklo_epi16(lo, zero), bias4), scale4);
+            AddSamples4(&dst[i+ 4], _mm_sub_epi32(_mm_unpackhi_epi16(lo, zero), bias4), scale4);
+            AddSamples4(&dst[i+ 8], _mm_sub_epi32(_mm_unpacklo_epi16(hi, zero), bias4), scale4);
+            AddSamples4(&dst[i+12], _mm_sub_epi32(_mm_unpackhi_epi16(hi, zero), bias4), scale4);
+        }
+    }
+    else if(srcstep == 2)
+    {
+        const __m128i mask{_mm_set1_epi16(0x00ff)};
+        for(;samples-i > 8;i += 8)
+        {
+            const __m128i vals{_mm_and_si128(
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(&src[i*2])), mask)};
+            AddSamples4(&dst[i  ], _mm_sub_epi32(_mm_unpacklo_epi16(vals, zero), bias4), scale4);
+            AddSamples4(&dst[i+4], _mm_sub_epi32(_mm_unpackhi_epi16(vals, zero), bias4), scale4);
+        }
+    }
+    else if(srcstep == 4)
+    {
+        const __m128i mask{_mm_set1_epi32(0x000000ff)};
+        for(;samples-i > 4;i += 4)
+        {
+            const __m128i vals{_mm_and_si128(
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(&src[i*4])), mask)};
+            AddSamples4(&dst[i], _mm_sub_epi32(vals, bias4), scale4);
+        }
+    }
+    else
+    {
+        for(;samples-i > 3;i += 4)
+        {
+            const ALubyte *s{&src[i*srcstep]};
+            const __m128i vals{_mm_setr_epi32(s[0], s[srcstep], s[srcstep*2], s[srcstep*3])};
+            AddSamples4(&dst[i], _mm_sub_epi32(vals, bias4), scale4);
+        }
+    }
+    for(;i < samples;i++)
+        dst[i] += (src[i*srcstep]-128) * (1.0f/128.0f);
+}
+
+static void LoadShorts(ALfloat *RESTRICT dst, const ALshort *RESTRICT src, const ALint srcstep,
+    const ALsizei samples)
+{
+    const __m128 scale4{_mm_set1_ps(1.0f/32768.0f)};
+
+    ALsizei i{0};
+    if(srcstep == 1)
+    {
+        for(;samples-i > 7;i += 8)
+        {
+            /* Sign-extend by unpacking into the upper halves and shifting
+             * them back down.
+             */
+            const __m128i vals{_mm_loadu_si128(reinterpret_cast<const __m128i*>(&src[i]))};
+            AddSamples4(&dst[i  ], _mm_srai_epi32(_mm_unpacklo_epi16(vals, vals), 16), scale4);
+            AddSamples4(&dst[i+4], _mm_srai_epi32(_mm_unpackhi_epi16(vals, vals), 16), scale4);
+        }
+    }
+    else if(srcstep == 2)
+    {
+        for(;samples-i > 8;i += 8)
+        {
+            /* The wanted samples are the low halves of each 32-bit value. */
+            const __m128i vals0{_mm_loadu_si128(reinterpret_cast<const __m128i*>(&src[i*2]))};
+            const __m128i vals1{_mm_loadu_si128(reinterpret_cast<const __m128i*>(&src[i*2 + 8]))};
+            AddSamples4(&dst[i  ], _mm_srai_epi32(_mm_slli_epi32(vals0, 16), 16), scale4);
+            AddSamples4(&dst[i+4], _mm_srai_epi32(_mm_slli_epi32(vals1, 16), 16), scale4);
+        }
+    }
+    else if(srcstep == 4)
+    {
+        for(;samples-i > 4;i += 4)
+        {
+            /* The wanted samples are the low halves of each 64-bit value. */
+            const __m128i vals0{_mm_loadu_si128(reinterpret_cast<const __m128i*>(&src[i*4]))};
+            const __m128i vals1{_mm_loadu_si128(reinterpret_cast<const __m128i*>(&src[i*4 + 8]))};
+            const __m128 f0{_mm_cvtepi32_ps(_mm_srai_epi32(_mm_slli_epi32(vals0, 16), 16))};
+            const __m128 f1{_mm_cvtepi32_ps(_mm_srai_epi32(_mm_slli_epi32(vals1, 16), 16))};
+            const __m128 vals{_mm_mul_ps(_mm_shuffle_ps(f0, f1, _MM_SHUFFLE(2, 0, 2, 0)), scale4)};
+            _mm_storeu_ps(&dst[i], _mm_add_ps(_mm_loadu_ps(&dst[i]), vals));
+        }
+    }
+    else
+    {
+        for(;samples-i > 3;i += 4)
+        {
+            const ALshort *s{&src[i*srcstep]};
+            const __m128i vals{_mm_setr_epi32(s[0], s[srcstep], s[srcstep*2], s[srcstep*3])};
+            AddSamples4(&dst[i], vals, scale4);
+        }
+    }
+    for(;i < samples;i++)
+        dst[i] += src[i*srcstep] * (1.0f/32768.0f);
+}
+
+static void LoadFloats(ALfloat *RESTRICT dst, const ALfloat *RESTRICT src, const ALint srcstep,
+    const ALsizei samples)
+{
+    ALsizei i{0};
+    if(srcstep == 1)
+    {
+        for(;samples-i > 3;i += 4)
+            _mm_storeu_ps(&dst[i], _mm_add_ps(_mm_loadu_ps(&dst[i]), _mm_loadu_ps(&src[i])));
+    }
+    else if(srcstep == 2)
+    {
+        for(;samples-i > 4;i += 4)
+        {
+            const __m128 vals0{_mm_loadu_ps(&src[i*2])};
+            const __m128 vals1{_mm_loadu_ps(&src[i*2 + 4])};
+            const __m128 vals{_mm_shuffle_ps(vals0, vals1, _MM_SHUFFLE(2, 0, 2, 0))};
+            _mm_storeu_ps(&dst[i], _mm_add_ps(_mm_loadu_ps(&dst[i]), vals));
+        }
+    }
+    else
+    {
+        for(;samples-i > 3;i += 4)
+        {
+            const ALfloat *s{&src[i*srcstep]};
+            const __m128 vals{_mm_setr_ps(s[0], s[srcstep], s[srcstep*2], s[srcstep*3])};
+            _mm_storeu_ps(&dst[i], _mm_add_ps(_mm_loadu_ps(&dst[i]), vals));
+        }
+    }
+    for(;i < samples;i++)
+        dst[i] += src[i*srcstep];
+}
+
+template<>
+void LoadSamples_<SSE2Tag>(ALfloat *RESTRICT dst, const ALvoid *RESTRICT src,
+    const ALint srcstep, const FmtType srctype, const ALsizei samples)
+{
+    ASSUME(srcstep > 0);
+    ASSUME(samples >= 0);
+
+    switch(srctype)
+    {
+        case FmtUByte:
+            LoadUBytes(dst, static_cast<const ALubyte*>(src), srcstep, samples);
+            break;
+        case FmtShort:
+            LoadShorts(dst, static_cast<const ALshort*>(src), srcstep, samples);
+            break;
+        case FmtFloat:
+            LoadFloats(dst, static_cast<const ALfloat*>(src), srcstep, samples);
+            break;
+        default:
+            break;
+    }
+}
+
+
+struct StoreShortTag { using Type = ALshort; };
+struct StoreIntTag { using Type = ALint; };
+struct StoreFloatTag { using Type = ALfloat; };
+
+/* Converts four samples for storing, clamped and rounded like the scalar
+ * conversion (the operand order matches clampf's, for NaNs). Integer results
+ * are kept as the bits of a float vector, so they can be shuffled the same
+ * way.
+ */
+static inline __m128 ConvertStore4(StoreShortTag, const __m128 vals)
+{
+    const __m128 scaled{_mm_mul_ps(vals, _mm_set1_ps(32768.0f))};
+    const __m128 clamped{_mm_min_ps(_mm_max_ps(_mm_set1_ps(-32768.0f), scaled),
+        _mm_set1_ps(32767.0f))};
+    return _mm_castsi128_ps(_mm_cvtps_epi32(clamped));
+}
+static inline __m128 ConvertStore4(StoreIntTag, const __m128 vals)
+{
+    const __m128 scaled{_mm_mul_ps(vals, _mm_set1_ps(2147483648.0f))};
+    const __m128 clamped{_mm_min_ps(_mm_max_ps(_mm_set1_ps(-2147483648.0f), scaled),
+        _mm_set1_ps(2147483520.0f))};
+    return _mm_castsi128_ps(_mm_cvtps_epi32(clamped));
+}
+static inline __m128 ConvertStore4(StoreFloatTag, const __m128 vals)
+{ return vals; }
+
+/* Stores all four converted values, the first two, or the first one. The
+ * shorts saturate when packed, though the values are already clamped.
+ */
+static inline void Store4(ALshort *dst, const __m128 vals)
+{
+    const __m128i ivals{_mm_castps_si128(vals)};
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(dst), _mm_packs_epi32(ivals, ivals));
+}
+static inline void Store4(ALint *dst, const __m128 vals)
+{ _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm_castps_si128(vals)); }
+static inline void Store4(ALfloat *dst, const __m128 vals)
+{ _mm_storeu_ps(dst, vals); }
+
+static inline void Store2(ALshort *dst, const __m128 vals)
+{
+    const __m128i ivals{_mm_castps_si128(vals)};
+    const int pair{_mm_cvtsi128_si32(_mm_packs_epi32(ivals, ivals))};
+    memcpy(dst, &pair, sizeof(pair));
+}
+static inline void Store2(ALint *dst, const __m128 vals)
+{ _mm_storel_epi64(reinterpret_cast<__m128i*>(dst), _mm_castps_si128(vals)); }
+static inline void Store2(ALfloat *dst, const __m128 vals)
+{ _mm_storel_pi(reinterpret_cast<__m64*>(dst), vals); }
+
+static inline void Store1(ALshort *dst, const __m128 vals)
+{ *dst = static_cast<ALshort>(_mm_cvtsi128_si32(_mm_castps_si128(vals))); }
+static inline void Store1(ALint *dst, const __m128 vals)
+{ *dst = _mm_cvtsi128_si32(_mm_castps_si128(vals)); }
+static inline void Store1(ALfloat *dst, const __m128 vals)
+{ _mm_store_ss(dst, vals); }
+
+template<typename TypeTag>
+static void StoreSampleArray(typename TypeTag::Type *RESTRICT dst,
+    const ALfloat *const *RESTRICT src, const ALsizei srcchans, const ALsizei dststep,
+    const ALsizei samples)
+{
+    ALsizei i{0};
+    if(srcchans == 2 && dststep == 2)
+    {
+        /* Interleave pairs of converted samples. */
+        for(;samples-i > 3;i += 4)
+        {
+            const __m128 left{ConvertStore4(TypeTag{}, _mm_loadu_ps(&src[0][i]))};
+            const __m128 right{ConvertStore4(TypeTag{}, _mm_loadu_ps(&src[1][i]))};
+            Store4(&dst[i*2 + 0], _mm_unpacklo_ps(left, right));
+            Store4(&dst[i*2 + 4], _mm_unpackhi_ps(left, right));
+        }
+    }
+    else if(srcchans == dststep && !(srcchans&1))
+    {
+        /* Transpose groups of four channels for four frames, and a remaining
+         * pair (e.g. for 5.1 output), writing whole frames.
+         */
+        for(;samples-i > 3;i += 4)
+        {
+            ALsizei c{0};
+            for(;srcchans-c > 3;c += 4)
+            {
+                __m128 vals0{ConvertStore4(TypeTag{}, _mm_loadu_ps(&src[c+0][i]))};
+                __m128 vals1{ConvertStore4(TypeTag{}, _mm_loadu_ps(&src[c+1][i]))};
+                __m128 vals2{ConvertStore4(TypeTag{}, _mm_loadu_ps(&src[c+2][i]))};
+                __m128 vals3{ConvertStore4(TypeTag{}, _mm_loadu_ps(&src[c+3][i]))};
+                _MM_TRANSPOSE4_PS(vals0, vals1, vals2, vals3);
+                Store4(&dst[(i+0)*dststep + c], vals0);
+                Store4(&dst[(i+1)*dststep + c], vals1);
+                Store4(&dst[(i+2)*dststep + c], vals2);
+                Store4(&dst[(i+3)*dststep + c], vals3);
+            }
+            if(c < srcchans)
+            {
+                const __m128 vals0{ConvertStore4(TypeTag{}, _mm_loadu_ps(&src[c+0][i]))};
+                const __m128 vals1{ConvertStore4(TypeTag{}, _mm_loadu_ps(&src[c+1][i]))};
+                const __m128 lo{_mm_unpacklo_ps(vals0, vals1)};
+                const __m128 hi{_mm_unpackhi_ps(vals0, vals1)};
+                Store2(&dst[(i+0)*dststep + c], lo);
+                Store2(&dst[(i+1)*dststep + c], _mm_movehl_ps(lo, lo));
+                Store2(&dst[(i+2)*dststep + c], hi);
+                Store2(&dst[(i+3)*dststep + c], _mm_movehl_ps(hi, hi));
+            }
+        }
+    }
+    else
+    {
+        /* Convert four samples of each channel at a time, storing each to its
+         * own frame.
+         */
+        for(;samples-i > 3;i += 4)
+        {
+            for(ALsizei c{0};c < srcchans;c++)
+            {
+                const __m128 vals{ConvertStore4(TypeTag{}, _mm_loadu_ps(&src[c][i]))};
+                typename TypeTag::Type *out{&dst[i*dststep + c]};
+                Store1(out, vals);
+                Store1(out+dststep, _mm_shuffle_ps(vals, vals, _MM_SHUFFLE(1,1,1,1)));
+                Store1(out+dststep*2, _mm_movehl_ps(vals, vals));
+                Store1(out+dststep*3, _mm_shuffle_ps(vals, vals, _MM_SHUFFLE(3,3,3,3)));
+            }
+        }
+    }
+    for(;i < samples;i++)
+    {
+        for(ALsizei c{0};c < srcchans;c++)
+            Store1(&dst[i*dststep + c], ConvertStore4(TypeTag{}, _mm_set_ss(src[c][i])));
+    }
+}
+
+template<>
+void StoreSamples_<SSE2Tag>(ALvoid *RESTRICT dst, const ALfloat *const *RESTRICT src,
+    const ALsizei srcchans, const ALsizei dststep, const DevFmtType dsttype,
+    const ALsizei samples)
+{
+    ASSUME(srcchans > 0);
+    ASSUME(dststep >= srcchans);
+    ASSUME(samples >= 0);
+
+    switch(dsttype)
+    {
+        case DevFmtShort:
+            StoreSampleArray<StoreShortTag>(static_cast<ALshort*>(dst), src, srcchans, dststep,
+                samples);
+            break;
+        case DevFmtInt:
+            StoreSampleArray<StoreIntTag>(static_cast<ALint*>(dst), src, srcchans, dststep,
+                samples);
+            break;
+        case DevFmtFloat:
+            StoreSampleArray<StoreFloatTag>(static_cast<ALfloat*>(dst), src, srcchans, dststep,
+                samples);
+            break;
+        default:
+            break;
+    }
+}
+
+template<>
+void Dither_<SSE2Tag>(ALfloat *RESTRICT buffer, ALuint *RESTRICT seeds, const ALfloat quant_scale,
+    const ALsizei samples)
+{
+    static_assert(DITHER_RNG_LANES == 4, "Dither lanes must match the vector size");
+    ASSUME(samples > 0);
+
+    auto xorshift4 = [](__m128i x) noexcept -> __m128i
+    {
+        x = _mm_xor_si128(x, _mm_slli_epi32(x, 13));
+        x = _mm_xor_si128(x, _mm_srli_epi32(x, 17));
+        x = _mm_xor_si128(x, _mm_slli_epi32(x, 5));
+        return x;
+    };
+    /* Rounds like fast_roundf, adding and removing 2^23 with the value's
+     * sign, except for values that are already integral.
+     */
+    const __m128 signmask4{_mm_castsi128_ps(_mm_set1_epi32(static_cast<int>(0x80000000u)))};
+    const __m128 ilim4{_mm_set1_ps(8388608.0f)};
+    auto round4 = [signmask4,ilim4](const __m128 vals) noexcept -> __m128
+    {
+        const __m128 ilim{_mm_or_ps(ilim4, _mm_and_ps(vals, signmask4))};
+        const __m128 rounded{_mm_sub_ps(_mm_add_ps(vals, ilim), ilim)};
+        const __m128 integral{_mm_cmpge_ps(_mm_andnot_ps(signmask4, vals), ilim4)};
+        return _mm_or_ps(_mm_and_ps(integral, vals), _mm_andnot_ps(integral, rounded));
+    };
+
+    const __m128 scale4{_mm_set1_ps(quant_scale)};
+    const __m128 invscale4{_mm_set1_ps(1.0f / quant_scale)};
+    const __m128 noisescale4{_mm_set1_ps(1.0f/16777216.0f)};
+    __m128i rng{_mm_loadu_si128(reinterpret_cast<const __m128i*>(seeds))};
+    for(ALsizei base{0};base < samples;base += 4)
+    {
+        const __m128i rng0{xorshift4(rng)};
+        rng = xorshift4(rng0);
+        const __m128 noise{_mm_mul_ps(_mm_sub_ps(
+            _mm_cvtepi32_ps(_mm_srli_epi32(rng0, 8)), _mm_cvtepi32_ps(_mm_srli_epi32(rng, 8))),
+            noisescale4)};
+
+        if(LIKELY(samples-base >= 4))
+        {
+            __m128 vals{_mm_loadu_ps(&buffer[base])};
+            vals = _mm_add_ps(_mm_mul_ps(vals, scale4), noise);
+            _mm_storeu_ps(&buffer[base], _mm_mul_ps(round4(vals), invscale4));
+        }
+        else
+        {
+            alignas(16) ALfloat tmp[4]{};
+            std::copy(buffer+base, buffer+samples, std::begin(tmp));
+            __m128 vals{_mm_load_ps(tmp)};
+            vals = _mm_add_ps(_mm_mul_ps(vals, scale4), noise);
+            _mm_store_ps(tmp, _mm_mul_ps(round4(vals), invscale4));
+            std::copy_n(std::begin(tmp), samples-base, buffer+base);
+        }
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(seeds), rng);
+}
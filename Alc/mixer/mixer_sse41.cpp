@@ -28,6 +28,24 @@
 #include "defs.h"
 
 
+/* Vector version of cubic(), with the same order of operations. */
+static inline __m128 Cubic4(const __m128 val1, const __m128 val2, const __m128 val3,
+    const __m128 val4, const __m128 mu)
+{
+    const __m128 mu2{_mm_mul_ps(mu, mu)};
+    const __m128 mu3{_mm_mul_ps(mu2, mu)};
+    const __m128 a0{_mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(-0.5f), mu3), mu2),
+        _mm_mul_ps(_mm_set1_ps(-0.5f), mu))};
+    const __m128 a1{_mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(1.5f), mu3),
+        _mm_mul_ps(_mm_set1_ps(-2.5f), mu2)), _mm_set1_ps(1.0f))};
+    const __m128 a2{_mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(-1.5f), mu3),
+        _mm_mul_ps(_mm_set1_ps(2.0f), mu2)), _mm_mul_ps(_mm_set1_ps(0.5f), mu))};
+    const __m128 a3{_mm_add_ps(_mm_mul_ps(_mm_set1_ps(0.5f), mu3),
+        _mm_mul_ps(_mm_set1_ps(-0.5f), mu2))};
+    return _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(val1, a0), _mm_mul_ps(val2, a1)),
+        _mm_mul_ps(val3, a2)), _mm_mul_ps(val4, a3));
+}
+
 template<>
 const ALfloat *Resample_<LerpTag,SSE4Tag>(const InterpState* UNUSED(state),
   const ALfloat *RESTRICT src, ALsizei frac, ALint increment,
@@ -84,3 +102,106 @@ const ALfloat *Resample_<LerpTag,SSE4Tag>(const InterpState* UNUSED(state),
     }
     return dst;
 }
+
+template<>
+const ALfloat *Resample_<PointTag,SSE4Tag>(const InterpState* UNUSED(state),
+  const ALfloat *RESTRICT src, ALsizei frac, ALint increment,
+  ALfloat *RESTRICT dst, ALsizei dstlen)
+{
+    const __m128i increment4{_mm_set1_epi32(increment*4)};
+    const __m128i fracMask4{_mm_set1_epi32(FRACTIONMASK)};
+
+    ASSUME(frac >= 0);
+    ASSUME(increment > 0);
+    ASSUME(dstlen >= 0);
+
+    alignas(16) ALsizei pos_[4], frac_[4];
+    InitiatePositionArrays(frac, increment, frac_, pos_, 4);
+    __m128i frac4{_mm_setr_epi32(frac_[0], frac_[1], frac_[2], frac_[3])};
+    __m128i pos4{_mm_setr_epi32(pos_[0], pos_[1], pos_[2], pos_[3])};
+
+    const ALsizei todo{dstlen & ~3};
+    for(ALsizei i{0};i < todo;i += 4)
+    {
+        const int pos0{_mm_extract_epi32(pos4, 0)};
+        const int pos1{_mm_extract_epi32(pos4, 1)};
+        const int pos2{_mm_extract_epi32(pos4, 2)};
+        const int pos3{_mm_extract_epi32(pos4, 3)};
+        _mm_store_ps(&dst[i], _mm_setr_ps(src[pos0], src[pos1], src[pos2], src[pos3]));
+
+        frac4 = _mm_add_epi32(frac4, increment4);
+        pos4 = _mm_add_epi32(pos4, _mm_srli_epi32(frac4, FRACTIONBITS));
+        frac4 = _mm_and_si128(frac4, fracMask4);
+    }
+
+    ALsizei pos{_mm_cvtsi128_si32(pos4)};
+    frac = _mm_cvtsi128_si32(frac4);
+
+    for(ALsizei i{todo};i < dstlen;++i)
+    {
+        dst[i] = src[pos];
+
+        frac += increment;
+        pos  += frac>>FRACTIONBITS;
+        frac &= FRACTIONMASK;
+    }
+    return dst;
+}
+
+template<>
+const ALfloat *Resample_<CubicTag,SSE4Tag>(const InterpState* UNUSED(state),
+  const ALfloat *RESTRICT src, ALsizei frac, ALint increment,
+  ALfloat *RESTRICT dst, ALsizei dstlen)
+{
+    const __m128i increment4{_mm_set1_epi32(increment*4)};
+    const __m128 fracOne4{_mm_set1_ps(1.0f/FRACTIONONE)};
+    const __m128i fracMask4{_mm_set1_epi32(FRACTIONMASK)};
+
+    ASSUME(frac >= 0);
+    ASSUME(increment > 0);
+    ASSUME(dstlen >= 0);
+
+    alignas(16) ALsizei pos_[4], frac_[4];
+    InitiatePositionArrays(frac, increment, frac_, pos_, 4);
+    __m128i frac4{_mm_setr_epi32(frac_[0], frac_[1], frac_[2], frac_[3])};
+    __m128i pos4{_mm_setr_epi32(pos_[0], pos_[1], pos_[2], pos_[3])};
+
+    /* The four sample points start one before the current position. */
+    src -= 1;
+
+    const ALsizei todo{dstlen & ~3};
+    for(ALsizei i{0};i < todo;i += 4)
+    {
+        const int pos0{_mm_extract_epi32(pos4, 0)};
+        const int pos1{_mm_extract_epi32(pos4, 1)};
+        const int pos2{_mm_extract_epi32(pos4, 2)};
+        const int pos3{_mm_extract_epi32(pos4, 3)};
+        const __m128 val1{_mm_setr_ps(src[pos0  ], src[pos1  ], src[pos2  ], src[pos3  ])};
+        const __m128 val2{_mm_setr_ps(src[pos0+1], src[pos1+1], src[pos2+1], src[pos3+1])};
+        const __m128 val3{_mm_setr_ps(src[pos0+2], src[pos1+2], src[pos2+2], src[pos3+2])};
+        const __m128 val4{_mm_setr_ps(src[pos0+3], src[pos1+3], src[pos2+3], src[pos3+3])};
+
+        const __m128 mu{_mm_mul_ps(_mm_cvtepi32_ps(frac4), fracOne4)};
+        _mm_store_ps(&dst[i], Cubic4(val1, val2, val3, val4, mu));
+
+        frac4 = _mm_add_epi32(frac4, increment4);
+        pos4 = _mm_add_epi32(pos4, _mm_srli_epi32(frac4, FRACTIONBITS));
+        frac4 = _mm_and_si128(frac4, fracMask4);
+    }
+
+    /* NOTE: These four elements represent the position *after* the last four
+     * samples, so the lowest element is the next position to resample.
+     */
+    ALsizei pos{_mm_cvtsi128_si32(pos4)};
+    frac = _mm_cvtsi128_si32(frac4);
+
+    for(ALsizei i{todo};i < dstlen;++i)
+    {
+        dst[i] = cubic(src[pos], src[pos+1], src[pos+2], src[pos+3], frac * (1.0f/FRACTIONONE));
+
+        frac += increment;
+        pos  += frac>>FRACTIONBITS;
+        frac &= FRACTIONMASK;
+    }
+    return dst;
+}
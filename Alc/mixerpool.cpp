@@ -0,0 +1,213 @@
+/**
+ * OpenAL cross platform audio library
+ * Copyright (C) 2019 by authors.
+ * This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Library General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ *  License along with this library; if not, write to the
+ *  Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ * Or go to http://www.gnu.org/copyleft/lgpl.html
+ */
+
+#include "config.h"
+
+#include "mixerpool.h"
+
+#include <algorithm>
+
+#include "alMain.h"
+#include "fpu_modes.h"
+#include "logging.h"
+#include "altrace.h"
+
+
+MixerPool::MixerPool(size_t numworkers, std::chrono::microseconds spintime,
+    ThreadGroup *group)
+  : mRanges(numworkers+1), mSpinTime{spintime}, mGroup{group}
+{
+    mWorkers.reserve(numworkers);
+    try {
+        for(size_t i{0};i < numworkers;++i)
+        {
+            mWorkers.emplace_back(std::unique_ptr<Worker>{new Worker{}});
+            Worker *worker{mWorkers.back().get()};
+            worker->mThread = std::thread{&MixerPool::workerProc, this, worker, i+1};
+        }
+    }
+    catch(...) {
+        mQuit.store(true, std::memory_order_release);
+        for(auto &worker : mWorkers)
+        {
+            if(!worker->mThread.joinable()) continue;
+            wakeWorker(worker.get());
+            worker->mThread.join();
+        }
+        throw;
+    }
+}
+
+MixerPool::~MixerPool()
+{
+    mQuit.store(true, std::memory_order_release);
+    for(auto &worker : mWorkers)
+        wakeWorker(worker.get());
+    for(auto &worker : mWorkers)
+        worker->mThread.join();
+}
+
+
+void MixerPool::wakeWorker(Worker *worker)
+{
+    /* A spinning worker just needs its flag cleared. */
+    if(!worker->mSpinning.exchange(false, std::memory_order_acq_rel))
+        worker->mSem.post();
+}
+
+/* Spins for up to the spin time, returning true if the worker was woken. If
+ * not, it'll need to wait on its semaphore.
+ */
+bool MixerPool::spinForJobs(Worker *self) noexcept
+{
+    if(mSpinTime.count() <= 0)
+        return false;
+
+    self->mSpinning.store(true, std::memory_order_release);
+    const auto timeout = std::chrono::steady_clock::now() + mSpinTime;
+    do {
+        if(!self->mSpinning.load(std::memory_order_acquire))
+            return true;
+    } while(std::chrono::steady_clock::now() < timeout);
+
+    /* Stop spinning, unless it was just woken. */
+    return !self->mSpinning.exchange(false, std::memory_order_acq_rel);
+}
+
+
+void MixerPool::workerProc(Worker *self, size_t thread)
+{
+    SetWorkerRTPriority();
+    althrd_setname(MIXER_WORKER_THREAD_NAME);
+
+    void *group_token{mGroup ? mGroup->join() : nullptr};
+    if(mGroup && !group_token)
+        WARN("Mixer worker %zu failed to join the audio thread group\n", thread);
+
+    FPUCtl mixer_mode{};
+    while(1)
+    {
+        if(!spinForJobs(self))
+            self->mSem.wait();
+        if(mQuit.load(std::memory_order_acquire))
+            break;
+        processJobs(thread);
+    }
+
+    if(group_token)
+        mGroup->leave(group_token);
+}
+
+bool MixerPool::takeFront(JobRange &range, size_t &idx) noexcept
+{
+    uint64_t jobs{range.mJobs.load(std::memory_order_acquire)};
+    do {
+        if(static_cast<uint32_t>(jobs) >= (jobs>>32))
+            return false;
+    } while(!range.mJobs.compare_exchange_weak(jobs, jobs+1, std::memory_order_acq_rel,
+        std::memory_order_acquire));
+    idx = static_cast<uint32_t>(jobs);
+    return true;
+}
+
+bool MixerPool::takeBack(JobRange &range, size_t &idx) noexcept
+{
+    uint64_t jobs{range.mJobs.load(std::memory_order_acquire)};
+    do {
+        if(static_cast<uint32_t>(jobs) >= (jobs>>32))
+            return false;
+    } while(!range.mJobs.compare_exchange_weak(jobs, jobs - (uint64_t{1}<<32),
+        std::memory_order_acq_rel, std::memory_order_acquire));
+    idx = static_cast<size_t>(jobs>>32) - 1;
+    return true;
+}
+
+void MixerPool::processJobs(size_t thread) noexcept
+{
+    al::RTSection rt_section{};
+    auto run_job = [this,thread](size_t idx) -> void
+    {
+        AL_TRACE_SCOPE("MixerJob");
+        mFunc(mUserData, thread, idx);
+    };
+
+    const size_t numranges{mNumRanges};
+    size_t idx;
+    while(takeFront(mRanges[thread], idx))
+        run_job(idx);
+    for(size_t i{1};i < numranges;++i)
+    {
+        JobRange &other = mRanges[(thread+i) % numranges];
+        while(takeBack(other, idx))
+            run_job(idx);
+    }
+
+    /* The last thread to finish signals the thread that started the batch.
+     * Waiting for the threads rather than the jobs means no thread is still
+     * looking through the ranges when the next batch sets them.
+     */
+    if(mThreadsDone.fetch_add(1, std::memory_order_acq_rel)+1 == numranges)
+        mDoneSem.post();
+}
+
+void MixerPool::runJobs(size_t count, JobFunc func, void *userdata)
+{
+    if(count < 1) return;
+    if(count == 1 || mWorkers.empty())
+    {
+        for(size_t i{0};i < count;++i)
+            func(userdata, 0, i);
+        return;
+    }
+
+    /* The calling thread handles jobs too, so only wake as many workers as
+     * there are other jobs.
+     */
+    const size_t numthreads{std::min(mRanges.size(), count)};
+    mFunc = func;
+    mUserData = userdata;
+    mNumRanges = numthreads;
+    mThreadsDone.store(0u, std::memory_order_relaxed);
+    for(size_t i{0};i < numthreads;++i)
+    {
+        const uint64_t begin{count * i / numthreads};
+        const uint64_t end{count * (i+1) / numthreads};
+        mRanges[i].mJobs.store((end<<32) | begin, std::memory_order_release);
+    }
+
+    std::for_each(mWorkers.begin(), mWorkers.begin()+static_cast<ptrdiff_t>(numthreads-1),
+        [](std::unique_ptr<Worker> &worker) -> void { wakeWorker(worker.get()); });
+
+    processJobs(0);
+    if(mSpinTime.count() > 0)
+    {
+        const auto timeout = std::chrono::steady_clock::now() + mSpinTime;
+        while(!mDoneSem.try_wait())
+        {
+            if(std::chrono::steady_clock::now() >= timeout)
+            {
+                mDoneSem.wait();
+                break;
+            }
+        }
+    }
+    else
+        mDoneSem.wait();
+}
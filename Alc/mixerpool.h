@@ -0,0 +1,146 @@
+#ifndef MIXERPOOL_H
+#define MIXERPOOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <type_traits>
+
+#include "almalloc.h"
+#include "threads.h"
+#include "vector.h"
+
+
+/* An OS scheduling group for threads that share a real-time deadline, such as
+ * the one a backend's audio thread belongs to. Threads doing work for that
+ * thread join it, so they're scheduled with the same guarantees.
+ */
+struct ThreadGroup {
+    virtual ~ThreadGroup() = default;
+
+    /* Adds the calling thread to the group. Returns a token to pass to leave
+     * from the same thread, or nullptr if it couldn't join.
+     */
+    virtual void *join() = 0;
+    virtual void leave(void *token) = 0;
+};
+
+
+/* A small pool of worker threads used by the mixer to process independent
+ * jobs in parallel. A batch of jobs is started from the mixer thread, which
+ * also takes part in processing them, and returns once every job in the batch
+ * has completed. Jobs are identified only by their index, so any per-job
+ * output should go to storage reserved for that index to keep results
+ * independent of which thread ran it.
+ *
+ * Each thread in a batch gets a contiguous range of the jobs, which it takes
+ * from the front. Once its own range is done, it takes the remaining jobs
+ * from the back of the other threads' ranges. Threads only touch another's
+ * range once they run out of work, so the ranges' cache lines aren't passed
+ * around for every job.
+ *
+ * Between batches, workers spin for a short while before sleeping on their
+ * semaphore, as does the starting thread waiting for a batch to finish. With
+ * batches started every update, that usually avoids waiting on the scheduler
+ * to wake a thread.
+ */
+class MixerPool {
+    using JobFunc = void(*)(void *userdata, size_t thread, size_t idx);
+
+    /* The jobs left in a thread's range, as the end index in the upper 32
+     * bits and the next index in the lower 32 bits.
+     */
+    struct alignas(64) JobRange {
+        std::atomic<uint64_t> mJobs{0u};
+    };
+
+    struct Worker {
+        std::thread mThread;
+        al::semaphore mSem;
+        /* Set by the worker while spinning. Clearing it hands the worker a
+         * batch without posting its semaphore.
+         */
+        std::atomic<bool> mSpinning{false};
+    };
+
+    al::vector<std::unique_ptr<Worker>> mWorkers;
+
+    JobFunc mFunc{nullptr};
+    void *mUserData{nullptr};
+    /* One range for each thread, including the calling thread. */
+    al::vector<JobRange,64> mRanges;
+    size_t mNumRanges{0u};
+    /* Threads of the current batch that have finished taking jobs. */
+    std::atomic<size_t> mThreadsDone{0u};
+    al::semaphore mDoneSem;
+
+    std::atomic<bool> mQuit{false};
+
+    std::chrono::microseconds mSpinTime;
+
+    ThreadGroup *mGroup;
+
+    void workerProc(Worker *self, size_t thread);
+    bool spinForJobs(Worker *self) noexcept;
+    static void wakeWorker(Worker *worker);
+    static bool takeFront(JobRange &range, size_t &idx) noexcept;
+    static bool takeBack(JobRange &range, size_t &idx) noexcept;
+    void processJobs(size_t thread) noexcept;
+    void runJobs(size_t count, JobFunc func, void *userdata);
+
+public:
+    /* Creates a pool with the given number of extra worker threads (the
+     * calling thread is not counted), which spin for up to spintime waiting
+     * for jobs before sleeping. If group is given, the workers join it for
+     * their lifetime, so it must outlive the pool.
+     */
+    MixerPool(size_t numworkers, std::chrono::microseconds spintime,
+        ThreadGroup *group=nullptr);
+    MixerPool(const MixerPool&) = delete;
+    ~MixerPool();
+
+    MixerPool& operator=(const MixerPool&) = delete;
+
+    /** Returns the total number of threads that process jobs, including the
+     * calling thread.
+     */
+    size_t threadCount() const noexcept { return mWorkers.size() + 1; }
+
+    std::chrono::microseconds spinTime() const noexcept { return mSpinTime; }
+
+    ThreadGroup *threadGroup() const noexcept { return mGroup; }
+
+    /**
+     * Calls func(idx) for each idx in [0...count), distributed between the
+     * worker threads and the calling thread. Returns once all calls have
+     * finished. Not reentrant; only one thread may start jobs at a time.
+     */
+    template<typename F>
+    void run(size_t count, F&& func)
+    {
+        auto invoker = [](void *userdata, size_t, size_t idx) -> void
+        { (*static_cast<typename std::remove_reference<F>::type*>(userdata))(idx); };
+        runJobs(count, invoker, &func);
+    }
+
+    /**
+     * Same as run, except calls func(thread, idx), where thread is the index
+     * of the thread running the job, in [0...threadCount()). The calling
+     * thread is always index 0.
+     */
+    template<typename F>
+    void runWithThreadIdx(size_t count, F&& func)
+    {
+        auto invoker = [](void *userdata, size_t thread, size_t idx) -> void
+        { (*static_cast<typename std::remove_reference<F>::type*>(userdata))(thread, idx); };
+        runJobs(count, invoker, &func);
+    }
+
+    DEF_NEWDEL(MixerPool)
+};
+
+#endif /* MIXERPOOL_H */
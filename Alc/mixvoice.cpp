@@ -28,6 +28,12 @@
 
 #include <numeric>
 #include <algorithm>
+#include <atomic>
+#include <thread>
+#include <array>
+#include <chrono>
+#include <memory>
+#include <string>
 
 #include "AL/al.h"
 #include "AL/alc.h"
@@ -42,116 +48,418 @@
 #include "alu.h"
 #include "alconfig.h"
 #include "ringbuffer.h"
+#include "compat.h"
+#include "fpu_modes.h"
 
 #include "cpu_caps.h"
 #include "mixer/defs.h"
+#include "mixer/kernels.h"
 
 
 static_assert((INT_MAX>>FRACTIONBITS)/MAX_PITCH > BUFFERSIZE,
               "MAX_PITCH and/or BUFFERSIZE are too large for FRACTIONBITS!");
 
-/* BSinc24 requires up to 23 extra samples before the current position, and 24 after. */
-static_assert(MAX_RESAMPLE_PADDING >= 24, "MAX_RESAMPLE_PADDING must be at least 24!");
+/* BSinc32 requires up to 31 extra samples before the current position, and 32 after. */
+static_assert(MAX_RESAMPLE_PADDING >= 32, "MAX_RESAMPLE_PADDING must be at least 32!");
 
 
 Resampler ResamplerDefault = LinearResampler;
 
 MixerFunc MixSamples = Mix_<CTag>;
 RowMixerFunc MixRowSamples = MixRow_<CTag>;
+BiquadMultiFunc FilterMultiSamples = BiquadMulti_<CTag>;
+BiquadCascadeFunc FilterCascadeSamples = BiquadCascade_<CTag>;
+HalfBlendFunc BlendHalfSamples = BlendHalf_<CTag>;
+SampleLoadFunc LoadPCMSamples = LoadSamples_<CTag>;
+SampleStoreFunc StorePCMSamples = StoreSamples_<CTag>;
+DitherFunc DitherSamples = Dither_<CTag>;
 static HrtfMixerFunc MixHrtfSamples = MixHrtf_<CTag>;
 static HrtfMixerBlendFunc MixHrtfBlendSamples = MixHrtfBlend_<CTag>;
 
-static MixerFunc SelectMixer()
-{
-#ifdef HAVE_NEON
-    if((CPUCapFlags&CPU_CAP_NEON))
-        return Mix_<NEONTag>;
-#endif
-#ifdef HAVE_SSE
-    if((CPUCapFlags&CPU_CAP_SSE))
-        return Mix_<SSETag>;
-#endif
-    return Mix_<CTag>;
-}
+namespace {
 
-static RowMixerFunc SelectRowMixer()
-{
-#ifdef HAVE_NEON
-    if((CPUCapFlags&CPU_CAP_NEON))
-        return MixRow_<NEONTag>;
-#endif
-#ifdef HAVE_SSE
-    if((CPUCapFlags&CPU_CAP_SSE))
-        return MixRow_<SSETag>;
-#endif
-    return MixRow_<CTag>;
-}
+/* Resampler kernels picked by the mixer autotune, if any. */
+std::array<ResamplerFunc,ResamplerKernelCount> TunedResamplers{};
 
-static inline HrtfMixerFunc SelectHrtfMixer()
-{
-#ifdef HAVE_NEON
-    if((CPUCapFlags&CPU_CAP_NEON))
-        return MixHrtf_<NEONTag>;
-#endif
-#ifdef HAVE_SSE
-    if((CPUCapFlags&CPU_CAP_SSE))
-        return MixHrtf_<SSETag>;
-#endif
-    return MixHrtf_<CTag>;
-}
+std::string MixerKernelList;
+
+} // namespace
 
-static inline HrtfMixerBlendFunc SelectHrtfBlendMixer()
+ResamplerFunc SelectResampler(Resampler resampler, ALuint increment)
 {
-#ifdef HAVE_NEON
-    if((CPUCapFlags&CPU_CAP_NEON))
-        return MixHrtfBlend_<NEONTag>;
-#endif
-#ifdef HAVE_SSE
-    if((CPUCapFlags&CPU_CAP_SSE))
-        return MixHrtfBlend_<SSETag>;
-#endif
-    return MixHrtfBlend_<CTag>;
+    const ResamplerKernel kernel{GetResamplerKernel(resampler, increment)};
+    if(ResamplerFunc tuned{TunedResamplers[kernel]})
+        return tuned;
+    return GetResamplerOptions(kernel).best();
 }
 
-ResamplerFunc SelectResampler(Resampler resampler)
+/* Only the bsinc resamplers spend enough time calculating the filter for each
+ * sample to gain from sharing it between channels. The others are resampled
+ * one channel at a time.
+ */
+ResamplerMultiFunc SelectMultiResampler(Resampler resampler, ALuint increment)
 {
     switch(resampler)
     {
         case PointResampler:
-            return Resample_<PointTag,CTag>;
         case LinearResampler:
+        case FIR4Resampler:
+            break;
+        case BSinc12Resampler:
+        case BSinc24Resampler:
+        case BSinc32Resampler:
+            if(increment <= FRACTIONONE)
+            {
 #ifdef HAVE_NEON
-            if((CPUCapFlags&CPU_CAP_NEON))
-                return Resample_<LerpTag,NEONTag>;
+                if((CPUCapFlags&CPU_CAP_NEON))
+                    return ResampleMulti_<FastBSincTag,NEONTag>;
 #endif
-#ifdef HAVE_SSE4_1
-            if((CPUCapFlags&CPU_CAP_SSE4_1))
-                return Resample_<LerpTag,SSE4Tag>;
+#ifdef HAVE_AVX2
+                if((CPUCapFlags&CPU_CAP_AVX2) && (CPUCapFlags&CPU_CAP_FMA))
+                    return ResampleMulti_<FastBSincTag,AVX2Tag>;
 #endif
-#ifdef HAVE_SSE2
-            if((CPUCapFlags&CPU_CAP_SSE2))
-                return Resample_<LerpTag,SSE2Tag>;
+#ifdef HAVE_SSE
+                if((CPUCapFlags&CPU_CAP_SSE))
+                    return ResampleMulti_<FastBSincTag,SSETag>;
 #endif
-            return Resample_<LerpTag,CTag>;
-        case FIR4Resampler:
-            return Resample_<CubicTag,CTag>;
-        case BSinc12Resampler:
-        case BSinc24Resampler:
+                return ResampleMulti_<FastBSincTag,CTag>;
+            }
 #ifdef HAVE_NEON
             if((CPUCapFlags&CPU_CAP_NEON))
-                return Resample_<BSincTag,NEONTag>;
+                return ResampleMulti_<BSincTag,NEONTag>;
+#endif
+#ifdef HAVE_AVX2
+            if((CPUCapFlags&CPU_CAP_AVX2) && (CPUCapFlags&CPU_CAP_FMA))
+                return ResampleMulti_<BSincTag,AVX2Tag>;
 #endif
 #ifdef HAVE_SSE
             if((CPUCapFlags&CPU_CAP_SSE))
-                return Resample_<BSincTag,SSETag>;
+                return ResampleMulti_<BSincTag,SSETag>;
 #endif
-            return Resample_<BSincTag,CTag>;
+            return ResampleMulti_<BSincTag,CTag>;
     }
 
-    return Resample_<PointTag,CTag>;
+    return nullptr;
 }
 
 
+namespace {
+
+/* Returns the best time of several runs of func. */
+template<typename F>
+std::chrono::steady_clock::duration TimeKernel(F func)
+{
+    using clock = std::chrono::steady_clock;
+    auto best = clock::duration::max();
+    for(int trial{0};trial < 5;++trial)
+    {
+        const auto start = clock::now();
+        for(int i{0};i < 32;++i)
+            func();
+        best = std::min(best, clock::now() - start);
+    }
+    return best;
+}
+
+template<typename T, typename F>
+const typename KernelList<T>::Option *TuneKernel(const KernelList<T> &list, F&& run)
+{
+    const typename KernelList<T>::Option *best{list.begin()};
+    auto besttime = std::chrono::steady_clock::duration::max();
+    for(const auto &option : list)
+    {
+        const auto dur = TimeKernel([&option,&run]() -> void { run(option.func); });
+        if(dur < besttime)
+        {
+            best = &option;
+            besttime = dur;
+        }
+    }
+    return best;
+}
+
+/* Synthetic buffers to time the kernels with. */
+struct AutotuneData {
+    alignas(16) ALfloat Source[BUFFERSIZE + MAX_RESAMPLE_PADDING*2];
+    alignas(16) ALfloat Output[4][BUFFERSIZE];
+    alignas(16) ALfloat HrtfSource[BUFFERSIZE + HRTF_HISTORY_LENGTH];
+    alignas(16) float2 Accum[BUFFERSIZE + HRIR_LENGTH];
+    HrtfParams OldParams;
+    alignas(16) HrirArray<ALfloat> Coeffs;
+    alignas(16) ALshort PCMSource[BUFFERSIZE*2];
+
+    DEF_NEWDEL(AutotuneData)
+};
+
+/* Each line of the cache is a kernel name and the chosen specialization. The
+ * first records the CPU capabilities the results are valid for.
+ */
+struct AutotuneResults {
+    std::array<std::pair<const char*,std::string>,9+ResamplerKernelCount> entries{{
+        {"mix", {}}, {"row", {}}, {"hrtf", {}}, {"hrtfblend", {}},
+        {"point", {}}, {"linear", {}}, {"cubic", {}}, {"bsinc", {}}, {"fastbsinc", {}},
+        {"biquad", {}}, {"biquadcascade", {}}, {"load", {}}, {"store", {}},
+        {"dither", {}}
+    }};
+
+    std::string &operator[](size_t idx) noexcept { return entries[idx].second; }
+};
+
+std::string GetAutotuneCachePath()
+{
+    const char *str;
+    if(ConfigValueStr(nullptr, nullptr, "mixer-autotune-cache", &str))
+        return str;
+
+    std::string fname;
+#ifdef _WIN32
+    const WCHAR *wstr{_wgetenv(L"LOCALAPPDATA")};
+    if(wstr && wstr[0] != 0)
+    {
+        fname = wstr_to_utf8(wstr);
+        if(fname.back() != '\\') fname += '\\';
+    }
+#else
+    if((str=getenv("XDG_CACHE_HOME")) != nullptr && str[0] != 0)
+    {
+        fname = str;
+        if(fname.back() != '/') fname += '/';
+    }
+    else if((str=getenv("HOME")) != nullptr && str[0] != 0)
+    {
+        fname = str;
+        if(fname.back() != '/') fname += '/';
+        fname += ".cache/";
+    }
+#endif
+    if(!fname.empty())
+        fname += "alsoft-mixer.cache";
+    return fname;
+}
+
+FILE *OpenAutotuneCache(const std::string &fname, const char *mode)
+{
+#ifdef _WIN32
+    std::wstring wname{utf8_to_wstr(fname.c_str())};
+    std::wstring wmode{utf8_to_wstr(mode)};
+    return _wfopen(wname.c_str(), wmode.c_str());
+#else
+    return fopen(fname.c_str(), mode);
+#endif
+}
+
+bool LoadAutotuneCache(const std::string &fname, AutotuneResults &results)
+{
+    FILE *f{OpenAutotuneCache(fname, "r")};
+    if(!f) return false;
+
+    bool capsmatch{false};
+    char line[128];
+    while(fgets(line, sizeof(line), f))
+    {
+        char *sep{strchr(line, '=')};
+        if(!sep) continue;
+        *(sep++) = '\0';
+        sep[strcspn(sep, "\r\n")] = '\0';
+
+        if(strcmp(line, "caps") == 0)
+            capsmatch = (strtol(sep, nullptr, 0) == CPUCapFlags);
+        for(auto &entry : results.entries)
+        {
+            if(strcmp(line, entry.first) == 0)
+                entry.second = sep;
+        }
+    }
+    fclose(f);
+
+    if(!capsmatch)
+        TRACE("Ignoring mixer autotune cache %s for different CPU capabilities\n",
+            fname.c_str());
+    return capsmatch;
+}
+
+void SaveAutotuneCache(const std::string &fname, AutotuneResults &results)
+{
+    FILE *f{OpenAutotuneCache(fname, "w")};
+    if(!f)
+    {
+        WARN("Failed to write mixer autotune cache %s\n", fname.c_str());
+        return;
+    }
+    fprintf(f, "caps=0x%x\n", CPUCapFlags);
+    for(auto &entry : results.entries)
+        fprintf(f, "%s=%s\n", entry.first, entry.second.c_str());
+    fclose(f);
+}
+
+/* Returns the named option from the list, or null if it's unavailable. */
+template<typename T>
+const typename KernelList<T>::Option *FindKernel(const KernelList<T> &list,
+    const std::string &name)
+{
+    auto iter = std::find_if(list.begin(), list.end(),
+        [&name](const typename KernelList<T>::Option &option) -> bool
+        { return name == option.name; });
+    return (iter != list.end()) ? iter : nullptr;
+}
+
+/* Uses the cached choice for the kernel if it's available, otherwise times
+ * each option with run.
+ */
+template<typename T, typename F>
+T PickKernel(AutotuneResults &results, const size_t idx, const bool cached, bool &changed,
+    const KernelList<T> &list, F&& run)
+{
+    const typename KernelList<T>::Option *option{cached ? FindKernel(list, results[idx]) :
+        nullptr};
+    if(!option)
+    {
+        option = TuneKernel(list, std::forward<F>(run));
+        results[idx] = option->name;
+        changed = true;
+    }
+    TRACE("Autotuned %s kernel: %s\n", results.entries[idx].first, option->name);
+    return option->func;
+}
+
+/* Picks the fastest specialization of the mixer and resampler kernels, by
+ * either loading a previous result from the cache or timing each on synthetic
+ * buffers.
+ */
+void AutotuneMixers(AutotuneResults &results)
+{
+    const std::string cachename{GetAutotuneCachePath()};
+    const bool cached{!cachename.empty() && LoadAutotuneCache(cachename, results)};
+
+    std::unique_ptr<AutotuneData> data{new AutotuneData{}};
+    for(size_t i{0};i < COUNTOF(data->Source);i++)
+        data->Source[i] = std::sin(static_cast<ALfloat>(i) * 0.1f) * 0.5f;
+    std::copy_n(std::begin(data->Source), COUNTOF(data->HrtfSource),
+        std::begin(data->HrtfSource));
+    for(size_t i{0};i < data->Coeffs.size();i++)
+    {
+        data->Coeffs[i][0] = 1.0f / static_cast<ALfloat>(i+1);
+        data->Coeffs[i][1] = -1.0f / static_cast<ALfloat>(i+1);
+    }
+    data->OldParams.Coeffs = data->Coeffs;
+    data->OldParams.Delay[0] = 4;
+    data->OldParams.Delay[1] = 12;
+    data->OldParams.Gain = 0.5f;
+
+    /* The kernels expect the mixer's FPU mode. */
+    FPUCtl mixer_mode{};
+    bool changed{false};
+
+    const ALsizei todo{BUFFERSIZE};
+    AutotuneData *d{data.get()};
+    MixSamples = PickKernel(results, 0, cached, changed, GetMixerOptions(),
+        [d,todo](MixerFunc func) -> void
+    {
+        ALfloat current[2]{0.5f, 0.25f};
+        const ALfloat target[2]{0.25f, 0.5f};
+        func(d->Source, 2, d->Output, current, target, todo/2, 0, todo);
+    });
+    MixRowSamples = PickKernel(results, 1, cached, changed, GetRowMixerOptions(),
+        [d,todo](RowMixerFunc func) -> void
+    {
+        const ALfloat gains[2]{0.5f, 0.25f};
+        func(d->Source, gains, d->Output, 2, 0, todo);
+    });
+
+    MixHrtfParams hrtfparams{};
+    hrtfparams.Coeffs = &d->Coeffs;
+    hrtfparams.Delay[0] = 8;
+    hrtfparams.Delay[1] = 2;
+    MixHrtfSamples = PickKernel(results, 2, cached, changed, GetHrtfMixerOptions(),
+        [d,todo,&hrtfparams](HrtfMixerFunc func) -> void
+    {
+        hrtfparams.Gain = 0.25f;
+        hrtfparams.GainStep = 0.5f / static_cast<ALfloat>(todo);
+        func(d->Output[0], d->Output[1], d->HrtfSource, d->Accum, 0, HRIR_LENGTH/2,
+            &hrtfparams, todo);
+    });
+    MixHrtfBlendSamples = PickKernel(results, 3, cached, changed, GetHrtfBlendMixerOptions(),
+        [d,todo,&hrtfparams](HrtfMixerBlendFunc func) -> void
+    {
+        hrtfparams.Gain = 0.0f;
+        hrtfparams.GainStep = 0.5f / static_cast<ALfloat>(todo);
+        func(d->Output[0], d->Output[1], d->HrtfSource, d->Accum, 0, HRIR_LENGTH/2,
+            &d->OldParams, &hrtfparams, todo);
+    });
+
+    /* Time the resamplers upsampling 44.1khz to 48khz, except for the scaled
+     * bsinc kernel which is only used for downsampling.
+     */
+    const ALuint upinc{static_cast<ALuint>(44100.0 / 48000.0 * FRACTIONONE)};
+    const ALuint downinc{FRACTIONONE*3/2};
+    for(size_t kernel{0};kernel < ResamplerKernelCount;kernel++)
+    {
+        const ALuint increment{(kernel == BSincKernel) ? downinc : upinc};
+        InterpState state{};
+        BsincPrepare(increment, &state.bsinc, &bsinc24);
+
+        TunedResamplers[kernel] = PickKernel(results, 4+kernel, cached, changed,
+            GetResamplerOptions(static_cast<ResamplerKernel>(kernel)),
+            [d,todo,increment,&state](ResamplerFunc func) -> void
+            {
+                func(&state, &d->Source[MAX_RESAMPLE_PADDING], 0, static_cast<ALint>(increment),
+                    d->Output[0], todo/2);
+            });
+    }
+
+    BiquadFilter filters[4];
+    filters[0].setParams(BiquadType::HighShelf, 0.5f, 5000.0f/44100.0f,
+        calc_rcpQ_from_slope(0.5f, 1.0f));
+    for(size_t i{1};i < COUNTOF(filters);i++)
+        filters[i].copyParamsFrom(filters[0]);
+    FilterMultiSamples = PickKernel(results, 4+ResamplerKernelCount, cached, changed,
+        GetBiquadMultiOptions(), [d,todo,&filters](BiquadMultiFunc func) -> void
+    {
+        BiquadFilter *filts[4]{&filters[0], &filters[1], &filters[2], &filters[3]};
+        const ALfloat *srcs[4]{d->Output[0], d->Output[1], d->Output[2], d->Output[3]};
+        ALfloat *dsts[4]{d->Output[0], d->Output[1], d->Output[2], d->Output[3]};
+        func(filts, dsts, srcs, 4, todo);
+    });
+
+    BiquadFilter cascades[4][BIQUAD_CASCADE_STAGES];
+    for(auto &stages : cascades)
+        std::fill(std::begin(stages), std::end(stages), filters[0]);
+    FilterCascadeSamples = PickKernel(results, 5+ResamplerKernelCount, cached, changed,
+        GetBiquadCascadeOptions(), [d,todo,&cascades](BiquadCascadeFunc func) -> void
+    {
+        BiquadFilter *filts[4]{cascades[0], cascades[1], cascades[2], cascades[3]};
+        const ALfloat *srcs[4]{d->Output[0], d->Output[1], d->Output[2], d->Output[3]};
+        ALfloat *dsts[4]{d->Output[0], d->Output[1], d->Output[2], d->Output[3]};
+        func(filts, dsts, srcs, 4, todo);
+    });
+
+    /* Time loading one channel of a stereo 16-bit buffer, the most common. */
+    LoadPCMSamples = PickKernel(results, 6+ResamplerKernelCount, cached, changed,
+        GetSampleLoadOptions(), [d,todo](SampleLoadFunc func) -> void
+    { func(d->Output[0], d->PCMSource, 2, FmtShort, todo); });
+
+    /* Time writing stereo 16-bit output, likewise the most common. */
+    StorePCMSamples = PickKernel(results, 7+ResamplerKernelCount, cached, changed,
+        GetSampleStoreOptions(), [d,todo](SampleStoreFunc func) -> void
+    {
+        const ALfloat *srcs[2]{d->Output[0], d->Output[1]};
+        func(d->PCMSource, srcs, 2, 2, DevFmtShort, todo);
+    });
+
+    DitherSamples = PickKernel(results, 8+ResamplerKernelCount, cached, changed,
+        GetDitherOptions(), [d,todo](DitherFunc func) -> void
+    {
+        alignas(16) ALuint seeds[DITHER_RNG_LANES]{1u, 2u, 3u, 4u};
+        func(d->Output[0], seeds, 32768.0f, todo);
+    });
+
+    if(changed && !cachename.empty())
+        SaveAutotuneCache(cachename, results);
+}
+
+} // namespace
+
+
 void aluInitMixer()
 {
     const char *str;
@@ -168,6 +476,8 @@ void aluInitMixer()
             ResamplerDefault = BSinc12Resampler;
         else if(strcasecmp(str, "bsinc24") == 0)
             ResamplerDefault = BSinc24Resampler;
+        else if(strcasecmp(str, "bsinc32") == 0)
+            ResamplerDefault = BSinc32Resampler;
         else if(strcasecmp(str, "bsinc") == 0)
         {
             WARN("Resampler option \"%s\" is deprecated, using bsinc12\n", str);
@@ -189,20 +499,85 @@ void aluInitMixer()
         }
     }
 
-    MixHrtfBlendSamples = SelectHrtfBlendMixer();
-    MixHrtfSamples = SelectHrtfMixer();
-    MixSamples = SelectMixer();
-    MixRowSamples = SelectRowMixer();
+    MixHrtfBlendSamples = GetHrtfBlendMixerOptions().best();
+    MixHrtfSamples = GetHrtfMixerOptions().best();
+    MixSamples = GetMixerOptions().best();
+    MixRowSamples = GetRowMixerOptions().best();
+    FilterMultiSamples = GetBiquadMultiOptions().best();
+    FilterCascadeSamples = GetBiquadCascadeOptions().best();
+    BlendHalfSamples = GetHalfBlendOptions().best();
+    LoadPCMSamples = GetSampleLoadOptions().best();
+    StorePCMSamples = GetSampleStoreOptions().best();
+    DitherSamples = GetDitherOptions().best();
+
+    AutotuneResults results;
+    if(GetConfigValueBool(nullptr, nullptr, "mixer-autotune", 0))
+        AutotuneMixers(results);
+    else
+    {
+        /* Without the autotune, each uses the first specialization this CPU
+         * can run.
+         */
+        results[0] = GetMixerOptions().begin()->name;
+        results[1] = GetRowMixerOptions().begin()->name;
+        results[2] = GetHrtfMixerOptions().begin()->name;
+        results[3] = GetHrtfBlendMixerOptions().begin()->name;
+        for(size_t kernel{0};kernel < ResamplerKernelCount;kernel++)
+            results[4+kernel] =
+                GetResamplerOptions(static_cast<ResamplerKernel>(kernel)).begin()->name;
+        results[4+ResamplerKernelCount] = GetBiquadMultiOptions().begin()->name;
+        results[5+ResamplerKernelCount] = GetBiquadCascadeOptions().begin()->name;
+        results[6+ResamplerKernelCount] = GetSampleLoadOptions().begin()->name;
+        results[7+ResamplerKernelCount] = GetSampleStoreOptions().begin()->name;
+        results[8+ResamplerKernelCount] = GetDitherOptions().begin()->name;
+    }
+
+    MixerKernelList.clear();
+    for(const auto &entry : results.entries)
+    {
+        MixerKernelList += entry.first;
+        MixerKernelList += '=';
+        MixerKernelList += entry.second;
+        MixerKernelList += ' ';
+    }
+    MixerKernelList += "hrtfdirect=";
+    MixerKernelList += GetDirectHrtfMixerOptions().begin()->name;
+    MixerKernelList += " halfblend=";
+    MixerKernelList += GetHalfBlendOptions().begin()->name;
+    TRACE("Mixer kernels: %s\n", MixerKernelList.c_str());
 }
 
+const char *aluGetMixerKernels(void)
+{ return MixerKernelList.c_str(); }
+
 
 namespace {
 
+/* The event ring only supports a single writer, but a context's voices may be
+ * mixed on multiple threads. Events are rare and quick to write, so simply
+ * spin while another voice is writing one.
+ */
+class EventWriteLock {
+    std::atomic_flag &mFlag;
+
+public:
+    EventWriteLock(ALCcontext *context) noexcept : mFlag(context->EventWriteLock)
+    {
+        while(mFlag.test_and_set(std::memory_order_acquire))
+            std::this_thread::yield();
+    }
+    ~EventWriteLock() { mFlag.clear(std::memory_order_release); }
+
+    EventWriteLock(const EventWriteLock&) = delete;
+    EventWriteLock& operator=(const EventWriteLock&) = delete;
+};
+
 void SendSourceStoppedEvent(ALCcontext *context, ALuint id)
 {
     ALbitfieldSOFT enabledevt{context->EnabledEvts.load(std::memory_order_acquire)};
     if(!(enabledevt&EventType_SourceStateChange)) return;
 
+    EventWriteLock evtlock{context};
     RingBuffer *ring{context->AsyncEvents.get()};
     auto evt_vec = ring->getWriteVector();
     if(evt_vec.first.len < 1) return;
@@ -212,7 +587,25 @@ void SendSourceStoppedEvent(ALCcontext *context, ALuint id)
     evt->u.srcstate.state = AL_STOPPED;
 
     ring->writeAdvance(1);
-    context->EventSem.post();
+    WakeEventThrd();
+}
+
+/* Crossfades the newly resampled samples in dst from what the voice's
+ * previous resampler gives for the same source samples. The fade runs over
+ * the whole mix, of which dst starts at fadepos.
+ */
+void CrossfadeResampler(const ALvoice *voice, const ALfloat *RESTRICT src, ALsizei frac,
+    ALint increment, ALfloat *RESTRICT dst, ALsizei dstlen, ALsizei fadepos, ALsizei fadelen,
+    ALfloat *RESTRICT scratch)
+{
+    const ALfloat *prev{voice->mPrevResampler(&voice->mPrevResampleState, src, frac, increment,
+        scratch, dstlen)};
+    const ALfloat step{1.0f / static_cast<ALfloat>(fadelen)};
+    for(ALsizei i{0};i < dstlen;i++)
+    {
+        const ALfloat t{static_cast<ALfloat>(fadepos+i) * step};
+        dst[i] = prev[i] + (dst[i]-prev[i])*t;
+    }
 }
 
 
@@ -250,6 +643,343 @@ const ALfloat *DoFilters(BiquadFilter *lpfilter, BiquadFilter *hpfilter,
     return src;
 }
 
+/* Applies the filters to all of a voice's channels together, using the
+ * vectorized multi-channel filter.
+ */
+void DoFiltersMulti(DirectParams *params, ALfloat (*dst)[BUFFERSIZE],
+    const ALfloat (*src)[BUFFERSIZE], const ALsizei numchans, const ALsizei numsamples,
+    const int type)
+{
+    BiquadFilter *lpfilters[MAX_INPUT_CHANNELS], *hpfilters[MAX_INPUT_CHANNELS];
+    const ALfloat *srcs[MAX_INPUT_CHANNELS];
+    ALfloat *dsts[MAX_INPUT_CHANNELS];
+    for(ALsizei chan{0};chan < numchans;chan++)
+    {
+        lpfilters[chan] = &params[chan].LowPass;
+        hpfilters[chan] = &params[chan].HighPass;
+        srcs[chan] = src[chan];
+        dsts[chan] = dst[chan];
+    }
+
+    switch(type)
+    {
+        case AF_None:
+            for(ALsizei chan{0};chan < numchans;chan++)
+            {
+                lpfilters[chan]->passthru(numsamples);
+                hpfilters[chan]->passthru(numsamples);
+            }
+            break;
+
+        case AF_LowPass:
+            FilterMultiSamples(lpfilters, dsts, srcs, numchans, numsamples);
+            for(ALsizei chan{0};chan < numchans;chan++)
+                hpfilters[chan]->passthru(numsamples);
+            break;
+        case AF_HighPass:
+            for(ALsizei chan{0};chan < numchans;chan++)
+                lpfilters[chan]->passthru(numsamples);
+            FilterMultiSamples(hpfilters, dsts, srcs, numchans, numsamples);
+            break;
+
+        case AF_BandPass:
+            FilterMultiSamples(lpfilters, dsts, srcs, numchans, numsamples);
+            std::copy_n(std::begin(dsts), numchans, std::begin(srcs));
+            FilterMultiSamples(hpfilters, dsts, srcs, numchans, numsamples);
+            break;
+    }
+}
+
+/* The most output channels MixFilteredSamples will handle. With more, it's
+ * faster to filter once into a buffer and use the vectorized mixer for each
+ * channel.
+ */
+constexpr ALsizei MAX_FUSED_MIX_CHANNELS{4};
+
+/* MixFilteredSamples mixes with scalar code, so it only replaces the C mixer.
+ * When a SIMD mixer is selected, filtering to a buffer and mixing that with
+ * the SIMD kernel is faster.
+ */
+inline bool UseFusedMix(const int filtertype, const ALsizei channels) noexcept
+{
+    return filtertype != AF_None && channels <= MAX_FUSED_MIX_CHANNELS &&
+        MixSamples == Mix_<CTag>;
+}
+
+/* Whether two of a voice's paths have the same filters in the same state, so
+ * they'd give the same output for the same samples.
+ */
+bool SameFilters(const int type, const BiquadFilter &lpfilter, const BiquadFilter &hpfilter,
+    const int othertype, const BiquadFilter &otherlp, const BiquadFilter &otherhp) noexcept
+{
+    if(type != othertype || type == AF_None)
+        return false;
+    return (!(type&AF_LowPass) || lpfilter.sameAs(otherlp)) &&
+        (!(type&AF_HighPass) || hpfilter.sameAs(otherhp));
+}
+
+/* Tracks which filters a voice channel's filtered samples were made with, so
+ * the channel's other paths with matching filters can reuse them instead of
+ * filtering again.
+ */
+struct FilteredSamples {
+    const ALfloat *Samples{nullptr};
+
+    /* The filters as they were before filtering, and the filters that did it
+     * (as they are after).
+     */
+    int Type{AF_None};
+    BiquadFilter LowPass, HighPass;
+    const BiquadFilter *LowPassOut{nullptr}, *HighPassOut{nullptr};
+
+    bool matches(const int type, const BiquadFilter &lpfilter,
+        const BiquadFilter &hpfilter) const noexcept
+    { return Samples && SameFilters(type, lpfilter, hpfilter, Type, LowPass, HighPass); }
+
+    /* Filters src into dst like DoFilters, unless dst already holds src with
+     * the same filtering. Either way, the filters are left in the state
+     * they'd be after filtering.
+     */
+    const ALfloat *filter(BiquadFilter *lpfilter, BiquadFilter *hpfilter,
+        ALfloat *RESTRICT dst, const ALfloat *RESTRICT src, const ALsizei numsamples,
+        const int type)
+    {
+        if(type == AF_None)
+            return DoFilters(lpfilter, hpfilter, dst, src, numsamples, type);
+        if(Samples == dst && matches(type, *lpfilter, *hpfilter))
+        {
+            if((type&AF_LowPass)) *lpfilter = *LowPassOut;
+            else lpfilter->passthru(numsamples);
+            if((type&AF_HighPass)) *hpfilter = *HighPassOut;
+            else hpfilter->passthru(numsamples);
+            return dst;
+        }
+
+        Type = type;
+        LowPass = *lpfilter;
+        HighPass = *hpfilter;
+        LowPassOut = lpfilter;
+        HighPassOut = hpfilter;
+        Samples = DoFilters(lpfilter, hpfilter, dst, src, numsamples, type);
+        return Samples;
+    }
+};
+
+/* Filters the samples and mixes them to the outputs in one pass, instead of
+ * writing the filtered samples to a buffer first. The gains are applied the
+ * same as Mix_<CTag>. With a null OutBuffer, the filters are only run, leaving
+ * them as mixing would.
+ */
+void MixFilteredSamples(BiquadFilter *lpfilter, BiquadFilter *hpfilter, const int type,
+    const ALfloat *RESTRICT src, const ALsizei OutChans, ALfloat (*OutBuffer)[BUFFERSIZE],
+    ALfloat *CurrentGains, const ALfloat *TargetGains, const ALsizei Counter,
+    const ALsizei OutPos, const ALsizei BufferSize)
+{
+    ASSUME(OutChans > 0 && OutChans <= MAX_FUSED_MIX_CHANNELS);
+    ASSUME(BufferSize > 0);
+
+    const bool lowpass{type == AF_LowPass || type == AF_BandPass};
+    const bool highpass{type == AF_HighPass || type == AF_BandPass};
+    if(!lowpass) lpfilter->passthru(BufferSize);
+    if(!highpass) hpfilter->passthru(BufferSize);
+
+    /* Channels that are fading have a gain step until the fade ends. After
+     * that, each uses its final gain, and silent channels are skipped (as are
+     * silent channels that aren't fading during the fade).
+     */
+    const ALsizei numouts{OutBuffer ? OutChans : 0};
+    const ALsizei fadelen{mini(BufferSize, Counter)};
+    const ALfloat delta{(Counter > 0) ? 1.0f / static_cast<ALfloat>(Counter) : 0.0f};
+    ALfloat *RESTRICT dst[MAX_FUSED_MIX_CHANNELS];
+    ALfloat gains[MAX_FUSED_MIX_CHANNELS], steps[MAX_FUSED_MIX_CHANNELS];
+    bool fades[MAX_FUSED_MIX_CHANNELS];
+    ALsizei fadechans[MAX_FUSED_MIX_CHANNELS];
+    ALsizei numfades{0};
+    bool fading{false};
+    for(ALsizei c{0};c < numouts;c++)
+    {
+        dst[c] = &OutBuffer[c][OutPos];
+        gains[c] = CurrentGains[c];
+        steps[c] = 0.0f;
+
+        const ALfloat diff{TargetGains[c] - gains[c]};
+        fades[c] = std::fabs(diff) > std::numeric_limits<float>::epsilon();
+        if(fades[c])
+        {
+            steps[c] = diff * delta;
+            fading = true;
+        }
+        if(fades[c] || std::fabs(gains[c]) > GAIN_SILENCE_THRESHOLD)
+            fadechans[numfades++] = c;
+    }
+
+    auto z = lpfilter->getComponents();
+    ALfloat lpz1{z.first}, lpz2{z.second};
+    z = hpfilter->getComponents();
+    ALfloat hpz1{z.first}, hpz2{z.second};
+    auto filter_sample = [lowpass,highpass,lpfilter,hpfilter,&lpz1,&lpz2,&hpz1,&hpz2](ALfloat sample) noexcept -> ALfloat
+    {
+        if(lowpass) sample = lpfilter->processOne(sample, lpz1, lpz2);
+        if(highpass) sample = hpfilter->processOne(sample, hpz1, hpz2);
+        return sample;
+    };
+
+    ALsizei pos{0};
+    if(fading)
+    {
+        ALfloat step_count{0.0f};
+        for(;pos < fadelen;pos++)
+        {
+            const ALfloat sample{filter_sample(src[pos])};
+            for(ALsizei i{0};i < numfades;i++)
+            {
+                const ALsizei c{fadechans[i]};
+                dst[c][pos] += sample * (gains[c] + steps[c]*step_count);
+            }
+            step_count += 1.0f;
+        }
+
+        /* Store the gains reached by the fade. */
+        for(ALsizei c{0};c < numouts;c++)
+        {
+            if(!fades[c])
+                continue;
+            if(pos == Counter)
+                gains[c] = TargetGains[c];
+            else
+                gains[c] += steps[c]*step_count;
+            CurrentGains[c] = gains[c];
+        }
+    }
+
+    ALsizei numchans{0};
+    for(ALsizei c{0};c < numouts;c++)
+    {
+        if(!(std::fabs(gains[c]) > GAIN_SILENCE_THRESHOLD))
+            continue;
+        dst[numchans] = dst[c];
+        gains[numchans] = gains[c];
+        ++numchans;
+    }
+    if(numchans == 0)
+    {
+        /* Nothing left to mix, but keep the filters running. */
+        for(;pos < BufferSize;pos++)
+            filter_sample(src[pos]);
+    }
+    else for(;pos < BufferSize;pos++)
+    {
+        const ALfloat sample{filter_sample(src[pos])};
+        for(ALsizei c{0};c < numchans;c++)
+            dst[c][pos] += sample * gains[c];
+    }
+
+    if(lowpass) lpfilter->setComponents(lpz1, lpz2);
+    if(highpass) hpfilter->setComponents(hpz1, hpz2);
+}
+
+/* Mixes the samples to only the channels with an audible current or target
+ * gain. Panning a point source into an ambisonic buffer leaves many of the
+ * higher-order gains negligible, so the audible channels are collected into
+ * an index list first, then mixed as runs of adjacent channels so each run is
+ * still one call to the (vectorized) mixer. Channels with neither gain
+ * audible are skipped, and just take their target gain.
+ */
+void MixSparseSamples(const ALfloat *data, const ALsizei OutChans,
+    ALfloat (*OutBuffer)[BUFFERSIZE], ALfloat *CurrentGains, const ALfloat *TargetGains,
+    const ALsizei Counter, const ALsizei OutPos, const ALsizei BufferSize)
+{
+    ASSUME(OutChans > 0 && OutChans <= MAX_OUTPUT_CHANNELS);
+
+    ALsizei active[MAX_OUTPUT_CHANNELS];
+    ALsizei numactive{0};
+    for(ALsizei c{0};c < OutChans;c++)
+    {
+        if(std::fabs(CurrentGains[c]) > GAIN_SILENCE_THRESHOLD
+            || std::fabs(TargetGains[c]) > GAIN_SILENCE_THRESHOLD)
+            active[numactive++] = c;
+        else
+            CurrentGains[c] = TargetGains[c];
+    }
+    if(numactive == OutChans)
+    {
+        MixSamples(data, OutChans, OutBuffer, CurrentGains, TargetGains, Counter, OutPos,
+            BufferSize);
+        return;
+    }
+
+    ALsizei idx{0};
+    while(idx < numactive)
+    {
+        const ALsizei start{active[idx]};
+        ALsizei end{start + 1};
+        while(++idx < numactive && active[idx] == end)
+            ++end;
+        MixSamples(data, end-start, OutBuffer+start, CurrentGains+start, TargetGains+start,
+            Counter, OutPos, BufferSize);
+    }
+}
+
+/* A voice's writes to its outputs, which get recorded instead when its scratch
+ * storage has a log.
+ */
+void OutputMark(MixerScratch &Scratch, ChannelMask *touched, const ALsizei count)
+{
+    if(VoiceMixLog *log{Scratch.Log})
+        log->mark(touched, count);
+    else
+        MarkChannels(touched, count);
+}
+
+void OutputSamples(MixerScratch &Scratch, const ALfloat *data, const ALsizei OutChans,
+    ALfloat (*OutBuffer)[BUFFERSIZE], ALfloat *CurrentGains, const ALfloat *TargetGains,
+    const ALsizei Counter, const ALsizei OutPos, const ALsizei BufferSize)
+{
+    if(VoiceMixLog *log{Scratch.Log})
+        log->mix(VoiceMixLog::MixCmd, data, OutChans, OutBuffer, CurrentGains, TargetGains,
+            Counter, OutPos, BufferSize);
+    else
+        MixSamples(data, OutChans, OutBuffer, CurrentGains, TargetGains, Counter, OutPos,
+            BufferSize);
+}
+
+void OutputSparseSamples(MixerScratch &Scratch, const ALfloat *data, const ALsizei OutChans,
+    ALfloat (*OutBuffer)[BUFFERSIZE], ALfloat *CurrentGains, const ALfloat *TargetGains,
+    const ALsizei Counter, const ALsizei OutPos, const ALsizei BufferSize)
+{
+    if(VoiceMixLog *log{Scratch.Log})
+        log->mix(VoiceMixLog::SparseCmd, data, OutChans, OutBuffer, CurrentGains, TargetGains,
+            Counter, OutPos, BufferSize);
+    else
+        MixSparseSamples(data, OutChans, OutBuffer, CurrentGains, TargetGains, Counter,
+            OutPos, BufferSize);
+}
+
+/* The filters are still run here when recording, so the voice's later paths
+ * see them as they'd be after mixing. The log keeps them as they were before.
+ */
+void OutputFilteredSamples(MixerScratch &Scratch, BiquadFilter *lpfilter,
+    BiquadFilter *hpfilter, const int type, const ALfloat *RESTRICT src, const ALsizei OutChans,
+    ALfloat (*OutBuffer)[BUFFERSIZE], ALfloat *CurrentGains, const ALfloat *TargetGains,
+    const ALsizei Counter, const ALsizei OutPos, const ALsizei BufferSize)
+{
+    VoiceMixLog *log{Scratch.Log};
+    if(!log)
+    {
+        MixFilteredSamples(lpfilter, hpfilter, type, src, OutChans, OutBuffer, CurrentGains,
+            TargetGains, Counter, OutPos, BufferSize);
+        return;
+    }
+
+    VoiceMixLog::Command &cmd = log->mix(VoiceMixLog::FilteredCmd, src, OutChans, OutBuffer,
+        CurrentGains, TargetGains, Counter, OutPos, BufferSize);
+    cmd.FilterType = type;
+    cmd.LowPass = *lpfilter;
+    cmd.HighPass = *hpfilter;
+    MixFilteredSamples(lpfilter, hpfilter, type, src, OutChans, nullptr, CurrentGains,
+        TargetGains, Counter, OutPos, BufferSize);
+}
+
 
 /* Base template left undefined. Should be marked =delete, but Clang 3.8.1
  * chokes on that given the inline specializations.
@@ -257,19 +987,20 @@ const ALfloat *DoFilters(BiquadFilter *lpfilter, BiquadFilter *hpfilter,
 template<FmtType T>
 inline ALfloat LoadSample(typename FmtTypeTraits<T>::Type val);
 
-template<> inline ALfloat LoadSample<FmtUByte>(FmtTypeTraits<FmtUByte>::Type val)
-{ return (val-128) * (1.0f/128.0f); }
-template<> inline ALfloat LoadSample<FmtShort>(FmtTypeTraits<FmtShort>::Type val)
-{ return val * (1.0f/32768.0f); }
-template<> inline ALfloat LoadSample<FmtFloat>(FmtTypeTraits<FmtFloat>::Type val)
-{ return val; }
 template<> inline ALfloat LoadSample<FmtDouble>(FmtTypeTraits<FmtDouble>::Type val)
 { return static_cast<ALfloat>(val); }
 template<> inline ALfloat LoadSample<FmtMulaw>(FmtTypeTraits<FmtMulaw>::Type val)
 { return muLawDecompressionTable[val] * (1.0f/32768.0f); }
 template<> inline ALfloat LoadSample<FmtAlaw>(FmtTypeTraits<FmtAlaw>::Type val)
 { return aLawDecompressionTable[val] * (1.0f/32768.0f); }
+template<> inline ALfloat LoadSample<FmtInt24>(FmtTypeTraits<FmtInt24>::Type val)
+{ return static_cast<ALfloat>(val.lo | (val.mid<<8) | (val.hi<<16)) * (1.0f/8388608.0f); }
+template<> inline ALfloat LoadSample<FmtInt>(FmtTypeTraits<FmtInt>::Type val)
+{ return static_cast<ALfloat>(val) * (1.0f/2147483648.0f); }
 
+/* UByte, Short, and Float samples go through the vectorized LoadPCMSamples
+ * kernel instead.
+ */
 template<FmtType T>
 inline void LoadSampleArray(ALfloat *RESTRICT dst, const void *src, ALint srcstep,
     const ptrdiff_t samples)
@@ -287,26 +1018,54 @@ void LoadSamples(ALfloat *RESTRICT dst, const ALvoid *RESTRICT src, ALint srcste
 #define HANDLE_FMT(T)  case T: LoadSampleArray<T>(dst, src, srcstep, samples); break
     switch(srctype)
     {
-        HANDLE_FMT(FmtUByte);
-        HANDLE_FMT(FmtShort);
-        HANDLE_FMT(FmtFloat);
+        case FmtUByte: case FmtShort: case FmtFloat:
+            LoadPCMSamples(dst, src, srcstep, srctype, static_cast<ALsizei>(samples));
+            break;
         HANDLE_FMT(FmtDouble);
         HANDLE_FMT(FmtMulaw);
         HANDLE_FMT(FmtAlaw);
+        HANDLE_FMT(FmtInt24);
+        HANDLE_FMT(FmtInt);
+        /* ADPCM needs per-block decoding, which is handled by the caller. */
+        case FmtIMA4: case FmtMSADPCM: break;
     }
 #undef HANDLE_FMT
 }
 
+/* Loads size samples of the given channel from the buffer, starting at pos.
+ * ADPCM buffers are decoded from the channel's decoder state.
+ */
+void LoadBufferSamples(ALfloat *RESTRICT dst, const ALbuffer *buffer, const ALsizei NumChannels,
+    const ALsizei SampleSize, const ALsizei chan, const int64_t pos, const ptrdiff_t size,
+    ADPCMState &adpcm)
+{
+    if(IsADPCMFmt(buffer->mFmtType))
+    {
+        /* The next update starts a bit before where this one ends, since the
+         * resampler needs some samples past the end. Keep the decoder state
+         * from before that so the next update can resume decoding from it.
+         */
+        const auto count = static_cast<ALsizei>(size);
+        const int64_t checkpoint{maxi64(pos, pos + count - MAX_RESAMPLE_PADDING*2 - 1)};
+        DecodeADPCMSamples(dst, buffer, chan, pos, count, adpcm, checkpoint);
+        return;
+    }
+
+    const ALbyte *Data{buffer->samples()};
+    Data += (pos*NumChannels + chan)*SampleSize;
+    LoadSamples(dst, Data, NumChannels, buffer->mFmtType, size);
+}
+
 ALfloat *LoadBufferStatic(ALbufferlistitem *BufferListItem, ALbufferlistitem *&BufferLoopItem,
-    const ALsizei NumChannels, const ALsizei SampleSize, const ALsizei chan, ALsizei DataPosInt,
-    ALfloat *SrcData, const ALfloat *const SrcDataEnd)
+    const ALsizei NumChannels, const ALsizei SampleSize, const ALsizei chan, int64_t DataPosInt,
+    ALfloat *SrcData, const ALfloat *const SrcDataEnd, ADPCMState &adpcm)
 {
     /* TODO: For static sources, loop points are taken from the first buffer
      * (should be adjusted by any buffer offset, to possibly be added later).
      */
     const ALbuffer *Buffer0{BufferListItem->buffers[0]};
-    const ALsizei LoopStart{Buffer0->LoopStart};
-    const ALsizei LoopEnd{Buffer0->LoopEnd};
+    const int64_t LoopStart{Buffer0->LoopStart};
+    const int64_t LoopEnd{Buffer0->LoopEnd};
     ASSUME(LoopStart >= 0);
     ASSUME(LoopEnd > LoopStart);
 
@@ -318,19 +1077,18 @@ ALfloat *LoadBufferStatic(ALbufferlistitem *BufferListItem, ALbufferlistitem *&B
 
         BufferLoopItem = nullptr;
 
-        auto load_buffer = [DataPosInt,SrcData,NumChannels,SampleSize,chan,SizeToDo](ptrdiff_t CompLen, const ALbuffer *buffer) -> ptrdiff_t
+        auto load_buffer = [DataPosInt,SrcData,NumChannels,SampleSize,chan,SizeToDo,&adpcm](ptrdiff_t CompLen, const ALbuffer *buffer) -> ptrdiff_t
         {
             if(DataPosInt >= buffer->SampleLen)
                 return CompLen;
 
             /* Load what's left to play from the buffer */
-            const ptrdiff_t DataSize{std::min<ptrdiff_t>(SizeToDo, buffer->SampleLen-DataPosInt)};
+            const auto DataSize = static_cast<ptrdiff_t>(std::min<int64_t>(SizeToDo,
+                buffer->SampleLen-DataPosInt));
             CompLen = std::max<ptrdiff_t>(CompLen, DataSize);
 
-            const ALbyte *Data{buffer->mData.data()};
-            Data += (DataPosInt*NumChannels + chan)*SampleSize;
-
-            LoadSamples(SrcData, Data, NumChannels, buffer->mFmtType, DataSize);
+            LoadBufferSamples(SrcData, buffer, NumChannels, SampleSize, chan, DataPosInt, DataSize,
+                adpcm);
             return CompLen;
         };
         /* It's impossible to have a buffer list item with no entries. */
@@ -339,24 +1097,35 @@ ALfloat *LoadBufferStatic(ALbufferlistitem *BufferListItem, ALbufferlistitem *&B
         SrcData += std::accumulate(BufferListItem->buffers, buffers_end, ptrdiff_t{0},
             load_buffer);
     }
+    else if(BufferListItem->num_buffers == 1 && LoopEnd == Buffer0->SampleLen &&
+        SrcDataEnd-SrcData <= LoopEnd+Buffer0->LoopPadding-DataPosInt)
+    {
+        /* The buffer's padding past the loop end holds the samples from the
+         * loop start, so it can be loaded across the loop end in one run.
+         */
+        const ptrdiff_t SizeToDo{SrcDataEnd - SrcData};
+        LoadBufferSamples(SrcData, Buffer0, NumChannels, SampleSize, chan, DataPosInt, SizeToDo,
+            adpcm);
+        SrcData += SizeToDo;
+    }
     else
     {
-        const ptrdiff_t SizeToDo{std::min<ptrdiff_t>(SrcDataEnd-SrcData, LoopEnd-DataPosInt)};
+        const auto SizeToDo = static_cast<ptrdiff_t>(std::min<int64_t>(SrcDataEnd-SrcData,
+            LoopEnd-DataPosInt));
         ASSUME(SizeToDo > 0);
 
-        auto load_buffer = [DataPosInt,SrcData,NumChannels,SampleSize,chan,SizeToDo](ptrdiff_t CompLen, const ALbuffer *buffer) -> ptrdiff_t
+        auto load_buffer = [DataPosInt,SrcData,NumChannels,SampleSize,chan,SizeToDo,&adpcm](ptrdiff_t CompLen, const ALbuffer *buffer) -> ptrdiff_t
         {
             if(DataPosInt >= buffer->SampleLen)
                 return CompLen;
 
             /* Load what's left of this loop iteration */
-            const ptrdiff_t DataSize{std::min<ptrdiff_t>(SizeToDo, buffer->SampleLen-DataPosInt)};
+            const auto DataSize = static_cast<ptrdiff_t>(std::min<int64_t>(SizeToDo,
+                buffer->SampleLen-DataPosInt));
             CompLen = std::max<ptrdiff_t>(CompLen, DataSize);
 
-            const ALbyte *Data{buffer->mData.data()};
-            Data += (DataPosInt*NumChannels + chan)*SampleSize;
-
-            LoadSamples(SrcData, Data, NumChannels, buffer->mFmtType, DataSize);
+            LoadBufferSamples(SrcData, buffer, NumChannels, SampleSize, chan, DataPosInt, DataSize,
+                adpcm);
             return CompLen;
         };
         ASSUME(BufferListItem->num_buffers > 0);
@@ -364,25 +1133,24 @@ ALfloat *LoadBufferStatic(ALbufferlistitem *BufferListItem, ALbufferlistitem *&B
         SrcData += std::accumulate(BufferListItem->buffers, buffers_end, ptrdiff_t{0},
             load_buffer);
 
-        const auto LoopSize = static_cast<ptrdiff_t>(LoopEnd - LoopStart);
+        const int64_t LoopSize{LoopEnd - LoopStart};
         while(SrcData != SrcDataEnd)
         {
-            const ptrdiff_t SizeToDo{std::min<ptrdiff_t>(SrcDataEnd-SrcData, LoopSize)};
+            const auto SizeToDo = static_cast<ptrdiff_t>(std::min<int64_t>(SrcDataEnd-SrcData,
+                LoopSize));
             ASSUME(SizeToDo > 0);
 
-            auto load_buffer_loop = [LoopStart,SrcData,NumChannels,SampleSize,chan,SizeToDo](ptrdiff_t CompLen, const ALbuffer *buffer) -> ptrdiff_t
+            auto load_buffer_loop = [LoopStart,SrcData,NumChannels,SampleSize,chan,SizeToDo,&adpcm](ptrdiff_t CompLen, const ALbuffer *buffer) -> ptrdiff_t
             {
                 if(LoopStart >= buffer->SampleLen)
                     return CompLen;
 
-                const ptrdiff_t DataSize{std::min<ptrdiff_t>(SizeToDo,
-                    buffer->SampleLen-LoopStart)};
+                const auto DataSize = static_cast<ptrdiff_t>(std::min<int64_t>(SizeToDo,
+                    buffer->SampleLen-LoopStart));
                 CompLen = std::max<ptrdiff_t>(CompLen, DataSize);
 
-                const ALbyte *Data{buffer->mData.data()};
-                Data += (LoopStart*NumChannels + chan)*SampleSize;
-
-                LoadSamples(SrcData, Data, NumChannels, buffer->mFmtType, DataSize);
+                LoadBufferSamples(SrcData, buffer, NumChannels, SampleSize, chan, LoopStart,
+                    DataSize, adpcm);
                 return CompLen;
             };
             SrcData += std::accumulate(BufferListItem->buffers, buffers_end, ptrdiff_t{0},
@@ -393,8 +1161,8 @@ ALfloat *LoadBufferStatic(ALbufferlistitem *BufferListItem, ALbufferlistitem *&B
 }
 
 ALfloat *LoadBufferQueue(ALbufferlistitem *BufferListItem, ALbufferlistitem *BufferLoopItem,
-    const ALsizei NumChannels, const ALsizei SampleSize, const ALsizei chan, ALsizei DataPosInt,
-    ALfloat *SrcData, const ALfloat *const SrcDataEnd)
+    const ALsizei NumChannels, const ALsizei SampleSize, const ALsizei chan, int64_t DataPosInt,
+    ALfloat *SrcData, const ALfloat *const SrcDataEnd, ADPCMState &adpcm)
 {
     /* Crawl the buffer queue to fill in the temp buffer */
     while(BufferListItem && SrcData != SrcDataEnd)
@@ -409,19 +1177,18 @@ ALfloat *LoadBufferQueue(ALbufferlistitem *BufferListItem, ALbufferlistitem *Buf
 
         const ptrdiff_t SizeToDo{SrcDataEnd - SrcData};
         ASSUME(SizeToDo > 0);
-        auto load_buffer = [DataPosInt,SrcData,NumChannels,SampleSize,chan,SizeToDo](ptrdiff_t CompLen, const ALbuffer *buffer) -> ptrdiff_t
+        auto load_buffer = [DataPosInt,SrcData,NumChannels,SampleSize,chan,SizeToDo,&adpcm](ptrdiff_t CompLen, const ALbuffer *buffer) -> ptrdiff_t
         {
             if(!buffer) return CompLen;
             if(DataPosInt >= buffer->SampleLen)
                 return CompLen;
 
-            const ptrdiff_t DataSize{std::min<ptrdiff_t>(SizeToDo, buffer->SampleLen-DataPosInt)};
+            const auto DataSize = static_cast<ptrdiff_t>(std::min<int64_t>(SizeToDo,
+                buffer->SampleLen-DataPosInt));
             CompLen = std::max<ptrdiff_t>(CompLen, DataSize);
 
-            const ALbyte *Data{buffer->mData.data()};
-            Data += (DataPosInt*NumChannels + chan)*SampleSize;
-
-            LoadSamples(SrcData, Data, NumChannels, buffer->mFmtType, DataSize);
+            LoadBufferSamples(SrcData, buffer, NumChannels, SampleSize, chan, DataPosInt, DataSize,
+                adpcm);
             return CompLen;
         };
         ASSUME(BufferListItem->num_buffers > 0);
@@ -439,9 +1206,290 @@ ALfloat *LoadBufferQueue(ALbufferlistitem *BufferListItem, ALbufferlistitem *Buf
     return SrcData;
 }
 
+/* Asks for the next stretch of a file-backed buffer to be paged in, so the
+ * mixer doesn't stall on reading the file when the voice gets there.
+ */
+void ReadAheadBuffer(ALvoice *voice, const ALbuffer *buffer, const int64_t DataPosInt)
+{
+    const ALsizei len{buffer->FileReadAhead};
+    int64_t start{voice->mReadAheadPos};
+    if(DataPosInt < start-len*2 || DataPosInt > start)
+    {
+        /* The voice looped or was moved outside of what was requested. */
+        start = DataPosInt;
+    }
+    else if(DataPosInt+len <= start)
+        return;
+
+    const int64_t end{DataPosInt + len*2};
+    PrefetchBufferData(buffer, start, static_cast<ALsizei>(end-start));
+    voice->mReadAheadPos = end;
+}
+
+/* Drops the frames before the current position from the voice's callback
+ * block, then pulls more from the buffer's callback until there's enough for
+ * an update needing the given number of frames.
+ */
+void PullCallbackSamples(ALvoice *voice, const ALbuffer *buffer, int64_t &DataPosInt,
+    const ALsizei needed)
+{
+    const ALsizei FrameSize{voice->mNumChannels * voice->mSampleSize};
+    ALbyte *block{voice->mCallbackBlock.data()};
+    if(DataPosInt > 0)
+    {
+        const auto drop = static_cast<ALsizei>(mini64(DataPosInt, voice->mCallbackBlockLen));
+        std::copy(block + drop*FrameSize, block + voice->mCallbackBlockLen*FrameSize, block);
+        voice->mCallbackBlockLen -= drop;
+        DataPosInt -= drop;
+    }
+    const bool continuous{(buffer->CallbackFlags&AL_CALLBACK_CONTINUOUS_BIT_SOFT) != 0};
+    /* A continuous callback that underran skips the time it was silent for,
+     * and picks up with the next samples it gives.
+     */
+    if(continuous && DataPosInt > 0)
+        DataPosInt = 0;
+    if(voice->mCallbackBlockLen >= needed || (voice->mFlags&VOICE_CALLBACK_STOPPED))
+        return;
+
+    /* A short read means the callback has ended, unless it's continuous, in
+     * which case it ends with a negative return.
+     */
+    const ALsizei todo{needed - voice->mCallbackBlockLen};
+    const ALsizei got{buffer->Callback(buffer->UserData,
+        block + voice->mCallbackBlockLen*FrameSize, todo*FrameSize)};
+    const ALsizei frames{clampi(got, 0, todo*FrameSize) / FrameSize};
+    voice->mCallbackBlockLen += frames;
+    if(continuous ? (got < 0) : (frames < todo))
+        voice->mFlags |= VOICE_CALLBACK_STOPPED;
+}
+
+ALfloat *LoadBufferCallback(const ALvoice *voice, const ALbuffer *buffer, const ALsizei chan,
+    const int64_t DataPosInt, ALfloat *SrcData, const ALfloat *const SrcDataEnd)
+{
+    if(DataPosInt >= voice->mCallbackBlockLen)
+        return SrcData;
+
+    const ALsizei NumChannels{voice->mNumChannels};
+    const auto DataSize = static_cast<ptrdiff_t>(std::min<int64_t>(SrcDataEnd-SrcData,
+        voice->mCallbackBlockLen-DataPosInt));
+    const ALbyte *Data{voice->mCallbackBlock.data()};
+    Data += (DataPosInt*NumChannels + chan)*voice->mSampleSize;
+    LoadSamples(SrcData, Data, NumChannels, buffer->mFmtType, DataSize);
+    return SrcData + DataSize;
+}
+
+/* Checks if a voice's current and target gains are silent for all of its
+ * outputs, in which case it won't be audible for this mix. The target gains
+ * are ignored when stopping, since the voice fades to silence regardless.
+ */
+bool IsVoiceSilent(const ALvoice *voice, const bool stopping, const ALsizei NumChannels)
+{
+    auto is_silent = [](const ALfloat gain) noexcept -> bool
+    { return !(std::fabs(gain) > GAIN_SILENCE_THRESHOLD); };
+
+    for(ALsizei chan{0};chan < NumChannels;chan++)
+    {
+        if((voice->mFlags&VOICE_HAS_HRTF))
+        {
+            const DirectHrtfParams &parms = voice->mDirectHrtf[chan];
+            if(!is_silent(parms.Old.Gain) || (!stopping && !is_silent(parms.Target.Gain)))
+                return false;
+        }
+        else
+        {
+            const DirectParams &parms = voice->mDirect.Params[chan];
+            const ALsizei numchans{voice->mDirect.Channels};
+            if(!std::all_of(parms.Gains.Current, parms.Gains.Current+numchans, is_silent)
+                || (!stopping && !std::all_of(parms.Gains.Target, parms.Gains.Target+numchans,
+                    is_silent)))
+                return false;
+        }
+
+        auto send_silent = [chan,stopping,&is_silent](const ALvoice::SendData &send) -> bool
+        {
+            if(!send.Buffer) return true;
+            const SendParams &sparms = send.Params[chan];
+            return std::all_of(sparms.Gains.Current, sparms.Gains.Current+send.Channels, is_silent)
+                && (stopping || std::all_of(sparms.Gains.Target,
+                    sparms.Gains.Target+send.Channels, is_silent));
+        };
+        if(!std::all_of(voice->mSend.begin(), voice->mSend.end(), send_silent))
+            return false;
+
+        auto listener_silent = [chan,stopping,&is_silent](const ALvoice::ListenerMixData &lmix) -> bool
+        {
+            if(!lmix.Buffer) return true;
+            const auto &gains = lmix.Gains[chan];
+            return std::all_of(std::begin(gains.Current), std::end(gains.Current), is_silent)
+                && (stopping || std::all_of(std::begin(gains.Target), std::end(gains.Target),
+                    is_silent));
+        };
+        if(voice->mHasListenerMix && !std::all_of(voice->mListenerMix.begin(),
+            voice->mListenerMix.end(), listener_silent))
+            return false;
+    }
+    return true;
+}
+
+/* Returns where a static mono float voice's samples for the update can be
+ * resampled straight from its buffer's storage, or null if they need to be
+ * loaded. That needs the whole range to be contiguous in the storage, without
+ * a loop wrap (unless the buffer is padded past its loop end), and the voice's
+ * history to match the samples before it.
+ */
+const ALfloat *GetInPlaceSamples(const ALvoice *voice, const ALbufferlistitem *DataItem,
+    const ALbufferlistitem *BufferLoopItem, const int64_t DataPosInt,
+    const ALsizei SrcBufferSize)
+{
+    if(DataItem->num_buffers != 1 || DataPosInt < MAX_RESAMPLE_PADDING)
+        return nullptr;
+    const ALbuffer *buffer{DataItem->buffers[0]};
+    if(buffer->mFmtType != FmtFloat || buffer->mFmtChannels != FmtMono)
+        return nullptr;
+
+    int64_t end{buffer->SampleLen};
+    if(BufferLoopItem)
+    {
+        if(DataPosInt >= buffer->LoopEnd)
+            return nullptr;
+        end = buffer->LoopEnd;
+        if(end == buffer->SampleLen)
+            end += buffer->LoopPadding;
+    }
+    if(SrcBufferSize-MAX_RESAMPLE_PADDING > end-DataPosInt)
+        return nullptr;
+
+    const ALfloat *src{reinterpret_cast<const ALfloat*>(buffer->samples()) + DataPosInt};
+    if(std::memcmp(voice->mPrevSamples[0].data(), src-MAX_RESAMPLE_PADDING,
+        MAX_RESAMPLE_PADDING*sizeof(ALfloat)) != 0)
+        return nullptr;
+    return src;
+}
+
 } // namespace
 
-void MixVoice(ALvoice *voice, ALvoice::State vstate, const ALuint SourceID, ALCcontext *Context, const ALsizei SamplesToDo)
+void VoiceMixLog::resize(size_t numcmds, size_t numsamples)
+{
+    Commands.resize(numcmds);
+    Data.resize(numsamples);
+    clear();
+}
+
+bool VoiceMixLog::canRecord(const ALvoice *voice, const ALsizei SamplesToDo) const noexcept
+{
+    /* An update is only split into more blocks when the source samples for
+     * it don't fit the scratch storage, and each block before the last then
+     * has at least 4 samples.
+     */
+    const int64_t blocklen{(int64_t{BUFFERSIZE-1}<<FRACTIONBITS)/maxi(voice->mStep, 1) - 4};
+    const auto numblocks = static_cast<size_t>(1 + SamplesToDo/maxi64(blocklen, 4));
+
+    /* Each channel of a block makes one write to each output, except NFC
+     * makes one for each order (up to 5), and HRTF two blended and two mixed.
+     * Each command's samples are padded to a multiple of 4.
+     */
+    size_t numouts{(voice->mFlags&VOICE_HAS_HRTF) ? 4u : (voice->mFlags&VOICE_HAS_NFC) ? 5u : 1u};
+    numouts += static_cast<size_t>(std::count_if(voice->mSend.begin(), voice->mSend.end(),
+        [](const ALvoice::SendData &send) noexcept -> bool { return send.Buffer != nullptr; }));
+    numouts += static_cast<size_t>(std::count_if(voice->mListenerMix.begin(),
+        voice->mListenerMix.end(),
+        [](const ALvoice::ListenerMixData &lmix) noexcept -> bool
+        { return lmix.Buffer != nullptr; }));
+    const auto numchans = static_cast<size_t>(voice->mNumChannels);
+    const size_t numcmds{numouts + numblocks*numchans*numouts};
+    const size_t numsamples{numchans*numouts*(static_cast<size_t>(SamplesToDo) + numblocks*3)};
+    return numcmds <= Commands.size()-NumCommands && numsamples <= Data.size()-DataUsed;
+}
+
+void VoiceMixLog::mark(ChannelMask *touched, const ALsizei count)
+{
+    if(!touched) return;
+
+    Command &cmd = Commands[NumCommands++];
+    cmd.Type = MarkCmd;
+    cmd.Touched = touched;
+    cmd.OutChans = count;
+}
+
+VoiceMixLog::Command &VoiceMixLog::mix(const CommandType type, const ALfloat *data,
+    const ALsizei OutChans, ALfloat (*OutBuffer)[BUFFERSIZE], ALfloat *CurrentGains,
+    const ALfloat *TargetGains, const ALsizei Counter, const ALsizei OutPos,
+    const ALsizei BufferSize)
+{
+    Command &cmd = Commands[NumCommands++];
+    cmd.Type = type;
+    cmd.OutChans = OutChans;
+    cmd.Counter = Counter;
+    cmd.OutPos = OutPos;
+    cmd.BufferSize = BufferSize;
+    cmd.Samples = DataUsed;
+    cmd.OutBuffer = OutBuffer;
+    cmd.CurrentGains = CurrentGains;
+    cmd.TargetGains = TargetGains;
+    std::copy_n(data, BufferSize, Data.begin()+static_cast<ptrdiff_t>(DataUsed));
+    DataUsed += static_cast<size_t>((BufferSize+3)&~3);
+    return cmd;
+}
+
+ALfloat *VoiceMixLog::add(ALfloat (*OutRow)[BUFFERSIZE], const ALsizei OutPos,
+    const ALsizei BufferSize)
+{
+    Command &cmd = Commands[NumCommands++];
+    cmd.Type = AddCmd;
+    cmd.OutChans = 1;
+    cmd.OutPos = OutPos;
+    cmd.BufferSize = BufferSize;
+    cmd.Samples = DataUsed;
+    cmd.OutBuffer = OutRow;
+    ALfloat *row{&Data[DataUsed]};
+    std::fill_n(row, BufferSize, -0.0f);
+    DataUsed += static_cast<size_t>((BufferSize+3)&~3);
+    return row;
+}
+
+void VoiceMixLog::replay(const size_t begin, const size_t end) const
+{
+    auto cmds_begin = Commands.cbegin() + static_cast<ptrdiff_t>(begin);
+    auto cmds_end = Commands.cbegin() + static_cast<ptrdiff_t>(end);
+    std::for_each(cmds_begin, cmds_end,
+        [this](const Command &cmd) -> void
+        {
+            const ALfloat *samples{&Data[cmd.Samples]};
+            switch(cmd.Type)
+            {
+            case MarkCmd:
+                MarkChannels(cmd.Touched, cmd.OutChans);
+                break;
+            case MixCmd:
+                MixSamples(samples, cmd.OutChans, cmd.OutBuffer, cmd.CurrentGains,
+                    cmd.TargetGains, cmd.Counter, cmd.OutPos, cmd.BufferSize);
+                break;
+            case SparseCmd:
+                MixSparseSamples(samples, cmd.OutChans, cmd.OutBuffer, cmd.CurrentGains,
+                    cmd.TargetGains, cmd.Counter, cmd.OutPos, cmd.BufferSize);
+                break;
+            case FilteredCmd:
+            {
+                BiquadFilter lpfilter{cmd.LowPass}, hpfilter{cmd.HighPass};
+                MixFilteredSamples(&lpfilter, &hpfilter, cmd.FilterType, samples,
+                    cmd.OutChans, cmd.OutBuffer, cmd.CurrentGains, cmd.TargetGains,
+                    cmd.Counter, cmd.OutPos, cmd.BufferSize);
+                break;
+            }
+            case AddCmd:
+            {
+                ALfloat *dst{&cmd.OutBuffer[0][cmd.OutPos]};
+                std::transform(samples, samples+cmd.BufferSize, dst, dst,
+                    std::plus<ALfloat>{});
+                break;
+            }
+            }
+        }
+    );
+}
+
+void MixVoice(ALvoice *voice, ALvoice::State vstate, const ALuint SourceID, ALCcontext *Context,
+    MixerScratch &Scratch, const ALsizei SamplesToDo)
 {
     static constexpr ALfloat SilentTarget[MAX_OUTPUT_CHANNELS]{};
 
@@ -449,13 +1497,23 @@ void MixVoice(ALvoice *voice, ALvoice::State vstate, const ALuint SourceID, ALCc
 
     /* Get voice info */
     const bool isstatic{(voice->mFlags&VOICE_IS_STATIC) != 0};
-    ALsizei DataPosInt{static_cast<ALsizei>(voice->mPosition.load(std::memory_order_relaxed))};
+    int64_t DataPosInt{static_cast<int64_t>(voice->mPosition.load(std::memory_order_relaxed))};
     ALsizei DataPosFrac{voice->mPositionFrac.load(std::memory_order_relaxed)};
     ALbufferlistitem *BufferListItem{voice->mCurrentBuffer.load(std::memory_order_relaxed)};
     ALbufferlistitem *BufferLoopItem{voice->mLoopBuffer.load(std::memory_order_relaxed)};
+    /* A static voice playing a resample cache gets its samples, length, and
+     * loop points from the cache, while still tracking the source's buffer.
+     */
+    ALbufferlistitem *DataItem{(BufferListItem && voice->mResampled) ?
+        voice->mResampled->Item : BufferListItem};
     const ALsizei NumChannels{voice->mNumChannels};
     const ALsizei SampleSize{voice->mSampleSize};
     const ALint increment{voice->mStep};
+    /* An instanced voice gets its resampled samples from the instance, which
+     * its leader (mixed first) resamples even when it's silent itself.
+     */
+    VoiceInstance *const Instance{voice->mInstance};
+    const bool leader{Instance && Instance->Leader == voice};
 
     ASSUME(DataPosInt >= 0);
     ASSUME(DataPosFrac >= 0);
@@ -468,52 +1526,149 @@ void MixVoice(ALvoice *voice, ALvoice::State vstate, const ALuint SourceID, ALCc
 
     ASSUME(IrSize >= 0);
 
+    /* A delayed voice starts on the sample its start time falls on, which may
+     * be in a later update. Stopping it before then stops it right away.
+     */
+    ALsizei StartOffset{0};
+    if(UNLIKELY(voice->mFlags&VOICE_IS_DELAYED))
+    {
+        using std::chrono::seconds;
+        using std::chrono::nanoseconds;
+
+        if(vstate == ALvoice::Stopping)
+        {
+            voice->mFlags &= ~VOICE_IS_DELAYED;
+            voice->mPlayState.store(ALvoice::Stopped, std::memory_order_release);
+            return;
+        }
+
+        const nanoseconds curtime{Device->ClockBase +
+            nanoseconds{seconds{Device->SamplesDone}}/Device->MixFrequency};
+        const nanoseconds delay{voice->mStartTime - curtime};
+        if(delay >= seconds{1})
+            return;
+        const int64_t frames{(delay.count()*Device->MixFrequency + 500000000) / 1000000000};
+        if(frames >= SamplesToDo)
+            return;
+        StartOffset = static_cast<ALsizei>(maxi64(frames, 0));
+        voice->mFlags &= ~VOICE_IS_DELAYED;
+    }
+
     ResamplerFunc Resample{(increment == FRACTIONONE && DataPosFrac == 0) ?
                            Resample_<CopyTag,CTag> : voice->mResampler};
 
-    ALsizei Counter{(voice->mFlags&VOICE_IS_FADING) ? SamplesToDo : 0};
-    if(!Counter)
+    /* An inaudible voice only needs its position advanced. It'll fade in from
+     * silence once it becomes audible again, so any stale history or filter
+     * state by then will be negligible.
+     */
+    const bool culled{(voice->mFlags&VOICE_IS_CULLED) != 0};
+    const bool fadeout{vstate == ALvoice::Stopping || culled};
+    const bool silent{IsVoiceSilent(voice, fadeout, NumChannels)};
+    if(silent)
+        ++Scratch.Stats.VoicesSkipped;
+    else
+    {
+        ++Scratch.Stats.VoicesMixed;
+
+        /* Note the outputs getting mixed to, so their unused channels don't
+         * have to be cleared or processed.
+         */
+        OutputMark(Scratch, voice->mDirect.Touched, voice->mDirect.Channels);
+        for(const ALvoice::SendData &send : voice->mSend)
+        {
+            if(send.Buffer)
+                OutputMark(Scratch, send.Touched, send.Channels);
+        }
+        for(const ALvoice::ListenerMixData &lmix : voice->mListenerMix)
+        {
+            if(lmix.Buffer)
+                OutputMark(Scratch, lmix.Touched, lmix.Channels);
+        }
+    }
+
+    ALsizei Counter{0};
+    if((voice->mFlags&VOICE_IS_FADING))
     {
-        /* No fading, just overwrite the old/current params. */
+        /* Parameter changes may fade over a limited number of samples, after
+         * which the gains stay constant for the rest of the update. Fading
+         * out always takes the whole update, to avoid clicks.
+         */
+        Counter = SamplesToDo - StartOffset;
+        if(Device->GainRampLength > 0 && !fadeout)
+            Counter = mini(Counter, Device->GainRampLength);
+    }
+    if(!Counter || silent)
+    {
+        /* No fading, just overwrite the old/current params. Culled voices are
+         * kept silent, so they fade in when they're no longer culled.
+         */
         for(ALsizei chan{0};chan < NumChannels;chan++)
         {
-            DirectParams &parms = voice->mDirect.Params[chan];
             if(!(voice->mFlags&VOICE_HAS_HRTF))
-                std::copy(std::begin(parms.Gains.Target), std::end(parms.Gains.Target),
-                    std::begin(parms.Gains.Current));
+            {
+                DirectParams &parms = voice->mDirect.Params[chan];
+                if(culled)
+                    std::fill_n(parms.Gains.Current, voice->mNumGains, 0.0f);
+                else
+                    std::copy_n(parms.Gains.Target, voice->mNumGains, parms.Gains.Current);
+            }
             else
-                parms.Hrtf.Old = parms.Hrtf.Target;
-            auto set_current = [chan](ALvoice::SendData &send) -> void
+            {
+                DirectHrtfParams &parms = voice->mDirectHrtf[chan];
+                parms.Old = parms.Target;
+                if(culled) parms.Old.Gain = 0.0f;
+            }
+            auto set_current = [voice,chan,culled](ALvoice::SendData &send) -> void
             {
                 if(!send.Buffer)
                     return;
 
                 SendParams &parms = send.Params[chan];
-                std::copy(std::begin(parms.Gains.Target), std::end(parms.Gains.Target),
-                    std::begin(parms.Gains.Current));
+                if(culled)
+                    std::fill_n(parms.Gains.Current, voice->mNumGains, 0.0f);
+                else
+                    std::copy_n(parms.Gains.Target, voice->mNumGains, parms.Gains.Current);
             };
             std::for_each(voice->mSend.begin(), voice->mSend.end(), set_current);
+
+            for(ALvoice::ListenerMixData &lmix : voice->mListenerMix)
+            {
+                auto &gains = lmix.Gains[chan];
+                if(culled)
+                    std::fill(std::begin(gains.Current), std::end(gains.Current), 0.0f);
+                else
+                    std::copy(std::begin(gains.Target), std::end(gains.Target),
+                        std::begin(gains.Current));
+            }
         }
+        voice->mClusterGain.Current = culled ? 0.0f : voice->mClusterGain.Target;
     }
     else if((voice->mFlags&VOICE_HAS_HRTF))
     {
         for(ALsizei chan{0};chan < NumChannels;chan++)
         {
-            DirectParams &parms = voice->mDirect.Params[chan];
-            if(!(parms.Hrtf.Old.Gain > GAIN_SILENCE_THRESHOLD))
+            DirectHrtfParams &parms = voice->mDirectHrtf[chan];
+            if(!(parms.Old.Gain > GAIN_SILENCE_THRESHOLD))
             {
                 /* The old HRTF params are silent, so overwrite the old
                  * coefficients with the new, and reset the old gain to 0. The
                  * future mix will then fade from silence.
                  */
-                parms.Hrtf.Old = parms.Hrtf.Target;
-                parms.Hrtf.Old.Gain = 0.0f;
+                parms.Old = parms.Target;
+                parms.Old.Gain = 0.0f;
             }
         }
     }
 
+    if(isstatic && BufferListItem)
+    {
+        const ALbuffer *Buffer0{DataItem->buffers[0]};
+        if(UNLIKELY(Buffer0 && Buffer0->FileReadAhead > 0))
+            ReadAheadBuffer(voice, Buffer0, DataPosInt);
+    }
+
     ALsizei buffers_done{0};
-    ALsizei OutPos{0};
+    ALsizei OutPos{StartOffset};
     do {
         /* Figure out how many buffer samples will be needed */
         ALsizei DstBufferSize{SamplesToDo - OutPos};
@@ -545,9 +1700,16 @@ void MixVoice(ALvoice *voice, ALvoice::State vstate, const ALuint SourceID, ALCc
                 DstBufferSize &= ~3;
         }
 
-        for(ALsizei chan{0};chan < NumChannels;chan++)
+        /* Callback buffers need their samples pulled for the update before
+         * they can be loaded, even if the voice is silent.
+         */
+        if(UNLIKELY(voice->mFlags&VOICE_IS_CALLBACK) && BufferListItem)
+            PullCallbackSamples(voice, BufferListItem->buffers[0], DataPosInt,
+                SrcBufferSize - MAX_RESAMPLE_PADDING);
+
+        using SourceRow = ALfloat[BUFFERSIZE + MAX_RESAMPLE_PADDING*2];
+        auto load_samples = [voice,isstatic,BufferListItem,DataItem,&BufferLoopItem,NumChannels,SampleSize,DataPosInt,DataPosFrac,increment,SrcBufferSize,DstBufferSize](const ALsizei chan, SourceRow &SrcData) -> void
         {
-            auto &SrcData = Device->SourceData;
 
             /* Load the previous samples into the source data first, and clear the rest. */
             auto srciter = std::copy_n(voice->mPrevSamples[chan].begin(), MAX_RESAMPLE_PADDING,
@@ -558,12 +1720,17 @@ void MixVoice(ALvoice *voice, ALvoice::State vstate, const ALuint SourceID, ALCc
             if(!BufferListItem)
                 srciter = std::copy(voice->mPrevSamples[chan].begin()+MAX_RESAMPLE_PADDING,
                     voice->mPrevSamples[chan].end(), srciter);
+            else if((voice->mFlags&VOICE_IS_CALLBACK))
+                srciter = LoadBufferCallback(voice, BufferListItem->buffers[0], chan, DataPosInt,
+                    srciter, srcdata_end);
             else if(isstatic)
-                srciter = LoadBufferStatic(BufferListItem, BufferLoopItem, NumChannels,
-                    SampleSize, chan, DataPosInt, srciter, srcdata_end);
+                srciter = LoadBufferStatic(DataItem, BufferLoopItem, NumChannels,
+                    SampleSize, chan, DataPosInt, srciter, srcdata_end,
+                    voice->mADPCMState[chan]);
             else
                 srciter = LoadBufferQueue(BufferListItem, BufferLoopItem, NumChannels,
-                    SampleSize, chan, DataPosInt, srciter, srcdata_end);
+                    SampleSize, chan, DataPosInt, srciter, srcdata_end,
+                    voice->mADPCMState[chan]);
 
             if(UNLIKELY(srciter != srcdata_end))
             {
@@ -586,16 +1753,134 @@ void MixVoice(ALvoice *voice, ALvoice::State vstate, const ALuint SourceID, ALCc
             /* Store the last source samples used for next time. */
             std::copy_n(&SrcData[(increment*DstBufferSize + DataPosFrac)>>FRACTIONBITS],
                 voice->mPrevSamples[chan].size(), std::begin(voice->mPrevSamples[chan]));
+        };
+
+        /* When there's more than one channel and the resampler can handle them
+         * together, load every channel first and resample them all at once.
+         */
+        const bool multi{NumChannels > 1 && voice->mMultiResampler &&
+            Resample != Resample_<CopyTag,CTag>};
+        /* Ambisonic upsampling also handles the channels together, so those
+         * voices are always loaded first.
+         */
+        const bool ambisonic{(voice->mFlags&VOICE_IS_AMBISONIC) != 0};
+        if(leader)
+        {
+            const ALfloat *srcs[MAX_INSTANCE_CHANNELS];
+            ALfloat *dsts[MAX_INSTANCE_CHANNELS];
+            for(ALsizei chan{0};chan < NumChannels;chan++)
+            {
+                load_samples(chan, Scratch.SourceData[chan]);
+                srcs[chan] = &Scratch.SourceData[chan][MAX_RESAMPLE_PADDING];
+                dsts[chan] = Scratch.ResampledData[chan];
+            }
+            if(multi)
+                voice->mMultiResampler(&voice->mResampleState, srcs, NumChannels, DataPosFrac,
+                    increment, dsts, DstBufferSize);
+            else for(ALsizei chan{0};chan < NumChannels;chan++)
+            {
+                const ALfloat *resampled{Resample(&voice->mResampleState, srcs[chan],
+                    DataPosFrac, increment, dsts[chan], DstBufferSize)};
+                if(resampled != dsts[chan])
+                    std::copy_n(resampled, DstBufferSize, dsts[chan]);
+            }
+            for(ALsizei chan{0};chan < NumChannels;chan++)
+                std::copy_n(dsts[chan], DstBufferSize, Instance->Samples[chan] + OutPos);
+        }
+        else if(Instance)
+        {
+            for(ALsizei chan{0};chan < NumChannels && !silent;chan++)
+                std::copy_n(Instance->Samples[chan] + OutPos, DstBufferSize,
+                    Scratch.ResampledData[chan]);
+        }
+        else if((multi || ambisonic) && !silent)
+        {
+            const ALfloat *srcs[MAX_INPUT_CHANNELS];
+            ALfloat *dsts[MAX_INPUT_CHANNELS];
+            for(ALsizei chan{0};chan < NumChannels;chan++)
+            {
+                load_samples(chan, Scratch.SourceData[chan]);
+                srcs[chan] = &Scratch.SourceData[chan][MAX_RESAMPLE_PADDING];
+                dsts[chan] = Scratch.ResampledData[chan];
+            }
+            if(multi)
+                voice->mMultiResampler(&voice->mResampleState, srcs, NumChannels, DataPosFrac,
+                    increment, dsts, DstBufferSize);
+            else for(ALsizei chan{0};chan < NumChannels;chan++)
+            {
+                const ALfloat *resampled{Resample(&voice->mResampleState, srcs[chan],
+                    DataPosFrac, increment, dsts[chan], DstBufferSize)};
+                if(resampled != dsts[chan])
+                    std::copy_n(resampled, DstBufferSize, dsts[chan]);
+            }
+            if(UNLIKELY(voice->mPrevResampler))
+            {
+                for(ALsizei chan{0};chan < NumChannels;chan++)
+                    CrossfadeResampler(voice, srcs[chan], DataPosFrac, increment, dsts[chan],
+                        DstBufferSize, OutPos-StartOffset, SamplesToDo-StartOffset,
+                        Scratch.FilteredData[chan]);
+            }
+
+            if(ambisonic)
+                BandSplitter::applyHfScaleMulti(voice->mAmbiSplitter.data(), dsts,
+                    voice->mAmbiScales.data(), NumChannels, DstBufferSize);
+        }
+        /* The direct path filters can then also handle all the channels
+         * together.
+         */
+        const bool loaded{multi || ambisonic || Instance};
+        const bool prefiltered{loaded && voice->mDirect.FilterType != AF_None};
+        if(prefiltered && !silent)
+            DoFiltersMulti(voice->mDirect.Params, Scratch.FilteredData, Scratch.ResampledData,
+                NumChannels, DstBufferSize, voice->mDirect.FilterType);
 
+        for(ALsizei chan{0};chan < NumChannels && !silent;chan++)
+        {
             /* Resample, then apply ambisonic upsampling as needed. */
-            const ALfloat *ResampledData{Resample(&voice->mResampleState,
-                &SrcData[MAX_RESAMPLE_PADDING], DataPosFrac, increment,
-                Device->ResampledData, DstBufferSize)};
-            if((voice->mFlags&VOICE_IS_AMBISONIC))
+            const ALfloat *ResampledData{Scratch.ResampledData[chan]};
+            if(!loaded)
+            {
+                /* Mono float samples may be resampled where they are, with the
+                 * history kept as if they were loaded.
+                 */
+                const ALfloat *src{(isstatic && NumChannels == 1 && BufferListItem &&
+                    !(voice->mFlags&VOICE_IS_CALLBACK)) ?
+                    GetInPlaceSamples(voice, DataItem, BufferLoopItem, DataPosInt,
+                        SrcBufferSize) : nullptr};
+                if(src)
+                {
+                    const ptrdiff_t prevpos{
+                        ((increment*DstBufferSize + DataPosFrac)>>FRACTIONBITS) -
+                        MAX_RESAMPLE_PADDING};
+                    auto &prev = voice->mPrevSamples[chan];
+                    const ptrdiff_t prevlen{clampi(SrcBufferSize-MAX_RESAMPLE_PADDING -
+                        static_cast<ALsizei>(prevpos), 0, static_cast<ALsizei>(prev.size()))};
+                    std::fill(std::copy_n(src+prevpos, prevlen, prev.begin()), prev.end(),
+                        0.0f);
+                }
+                else
+                {
+                    auto &SrcData = Scratch.SourceData[0];
+                    load_samples(chan, SrcData);
+                    src = &SrcData[MAX_RESAMPLE_PADDING];
+                }
+                ResampledData = Resample(&voice->mResampleState, src, DataPosFrac, increment,
+                    Scratch.ResampledData[0], DstBufferSize);
+                if(UNLIKELY(voice->mPrevResampler))
+                {
+                    if(ResampledData != Scratch.ResampledData[0])
+                        std::copy_n(ResampledData, DstBufferSize, Scratch.ResampledData[0]);
+                    CrossfadeResampler(voice, src, DataPosFrac, increment,
+                        Scratch.ResampledData[0], DstBufferSize, OutPos-StartOffset,
+                        SamplesToDo-StartOffset, Scratch.FilteredData[chan]);
+                    ResampledData = Scratch.ResampledData[0];
+                }
+            }
+            if(!loaded && (voice->mFlags&VOICE_IS_AMBISONIC))
             {
                 const ALfloat hfscale{voice->mAmbiScales[chan]};
                 /* Beware the evil const_cast. It's safe since it's pointing to
-                 * either SrcData or Device->ResampledData (both non-const),
+                 * either SrcData or Scratch.ResampledData (both non-const),
                  * but the resample method takes its input as const float* and
                  * may return it without copying to output, making it currently
                  * unavoidable.
@@ -604,42 +1889,88 @@ void MixVoice(ALvoice *voice, ALvoice::State vstate, const ALuint SourceID, ALCc
                     hfscale, DstBufferSize);
             }
 
-            /* Now filter and mix to the appropriate outputs. */
+            /* Now filter and mix to the appropriate outputs. Paths with the
+             * same filters in the same state (commonly sends to similar
+             * effects) share the filtered samples. Paths a later one shares
+             * with are filtered to the buffer rather than fused with the mix.
+             */
+            FilteredSamples filtered;
+            auto shared_later = [chan](const int type, const BiquadFilter &lpfilter,
+                const BiquadFilter &hpfilter, const ALvoice::SendData *begin,
+                const ALvoice::SendData *end) noexcept -> bool
+            {
+                return std::any_of(begin, end,
+                    [chan,type,&lpfilter,&hpfilter](const ALvoice::SendData &send) -> bool
+                    {
+                        const SendParams &parms = send.Params[chan];
+                        return send.Buffer && SameFilters(type, lpfilter, hpfilter,
+                            send.FilterType, parms.LowPass, parms.HighPass);
+                    });
+            };
             {
                 DirectParams &parms = voice->mDirect.Params[chan];
-                const ALfloat *samples{DoFilters(&parms.LowPass, &parms.HighPass,
-                    Device->FilteredData, ResampledData, DstBufferSize,
-                    voice->mDirect.FilterType)};
+                const bool fused{!prefiltered && !voice->mClusterBuffer &&
+                    !voice->mHasListenerMix &&
+                    !(voice->mFlags&(VOICE_HAS_HRTF|VOICE_HAS_NFC)) &&
+                    UseFusedMix(voice->mDirect.FilterType, voice->mDirect.Channels) &&
+                    !shared_later(voice->mDirect.FilterType, parms.LowPass, parms.HighPass,
+                        voice->mSend.begin(), voice->mSend.end())};
+                const ALfloat *samples{ResampledData};
+                if(prefiltered)
+                    samples = Scratch.FilteredData[chan];
+                else if(!fused)
+                    samples = filtered.filter(&parms.LowPass, &parms.HighPass,
+                        Scratch.FilteredData[chan], ResampledData, DstBufferSize,
+                        voice->mDirect.FilterType);
 
                 if((voice->mFlags&VOICE_HAS_HRTF))
                 {
+                    DirectHrtfParams &hparms = voice->mDirectHrtf[chan];
                     const int OutLIdx{GetChannelIdxByName(Device->RealOut, FrontLeft)};
                     const int OutRIdx{GetChannelIdxByName(Device->RealOut, FrontRight)};
                     ASSUME(OutLIdx >= 0 && OutRIdx >= 0);
 
-                    auto &HrtfSamples = Device->HrtfSourceData;
-                    auto &AccumSamples = Device->HrtfAccumData;
-                    const ALfloat TargetGain{UNLIKELY(vstate == ALvoice::Stopping) ? 0.0f :
-                        parms.Hrtf.Target.Gain};
+                    auto &HrtfSamples = Scratch.HrtfSourceData;
+                    auto &AccumSamples = Scratch.HrtfAccumData;
+
+                    /* When recording, the HRTF output goes to rows in the log
+                     * to be added to the outputs later.
+                     */
+                    struct HrtfOutput { ALfloat *Left, *Right; ALsizei Pos; };
+                    auto get_hrtf_output = [voice,OutLIdx,OutRIdx,&Scratch](const ALsizei pos,
+                        const ALsizei todo) -> HrtfOutput
+                    {
+                        ALfloat (*outbuf)[BUFFERSIZE]{voice->mDirect.Buffer};
+                        if(VoiceMixLog *log{Scratch.Log})
+                            return HrtfOutput{log->add(outbuf+OutLIdx, pos, todo),
+                                log->add(outbuf+OutRIdx, pos, todo), 0};
+                        return HrtfOutput{outbuf[OutLIdx], outbuf[OutRIdx], pos};
+                    };
+                    const ALfloat TargetGain{UNLIKELY(fadeout) ? 0.0f :
+                        hparms.Target.Gain};
                     ALsizei fademix{0};
 
+                    /* Voices may use shorter HRIRs than the device's. */
+                    const ALsizei VoiceIrSize{clampi(
+                        maxi(hparms.Old.IrSize, hparms.Target.IrSize), 4, IrSize)};
+
                     /* Copy the HRTF history and new input samples into a temp
                      * buffer.
                      */
-                    auto src_iter = std::copy(parms.Hrtf.State.History.begin(),
-                        parms.Hrtf.State.History.end(), std::begin(HrtfSamples));
+                    auto src_iter = std::copy(hparms.State.History.begin(),
+                        hparms.State.History.end(), std::begin(HrtfSamples));
                     std::copy_n(samples, DstBufferSize, src_iter);
                     /* Copy the last used samples back into the history buffer
                      * for later.
                      */
                     std::copy_n(std::begin(HrtfSamples) + DstBufferSize,
-                        parms.Hrtf.State.History.size(), parms.Hrtf.State.History.begin());
+                        hparms.State.History.size(), hparms.State.History.begin());
 
                     /* Copy the current filtered values being accumulated into
                      * the temp buffer.
                      */
-                    auto accum_iter = std::copy_n(parms.Hrtf.State.Values.begin(),
-                        parms.Hrtf.State.Values.size(), std::begin(AccumSamples));
+                    auto accum_iter = std::copy_n(hparms.State.Values.begin(),
+                        hparms.State.Values.size(), std::begin(AccumSamples));
 
                     /* Clear the accumulation buffer that will start getting
                      * filled in.
@@ -649,7 +1980,7 @@ void MixVoice(ALvoice *voice, ALvoice::State vstate, const ALuint SourceID, ALCc
                     /* If fading, the old gain is not silence, and this is the
                      * first mixing pass, fade between the IRs.
                      */
-                    if(Counter && (parms.Hrtf.Old.Gain > GAIN_SILENCE_THRESHOLD) && OutPos == 0)
+                    if(Counter && (hparms.Old.Gain > GAIN_SILENCE_THRESHOLD) && OutPos == 0)
                     {
                         fademix = mini(DstBufferSize, 128);
 
@@ -665,25 +1996,24 @@ void MixVoice(ALvoice *voice, ALvoice::State vstate, const ALuint SourceID, ALCc
                         {
                             const ALfloat a{static_cast<ALfloat>(fademix) /
                                 static_cast<ALfloat>(Counter)};
-                            gain = lerp(parms.Hrtf.Old.Gain, TargetGain, a);
+                            gain = lerp(hparms.Old.Gain, TargetGain, a);
                         }
                         MixHrtfParams hrtfparams;
-                        hrtfparams.Coeffs = &parms.Hrtf.Target.Coeffs;
-                        hrtfparams.Delay[0] = parms.Hrtf.Target.Delay[0];
-                        hrtfparams.Delay[1] = parms.Hrtf.Target.Delay[1];
+                        hrtfparams.Coeffs = &hparms.Target.Coeffs;
+                        hrtfparams.Delay[0] = hparms.Target.Delay[0];
+                        hrtfparams.Delay[1] = hparms.Target.Delay[1];
                         hrtfparams.Gain = 0.0f;
                         hrtfparams.GainStep = gain / static_cast<ALfloat>(fademix);
 
-                        MixHrtfBlendSamples(
-                            voice->mDirect.Buffer[OutLIdx], voice->mDirect.Buffer[OutRIdx],
-                            HrtfSamples, AccumSamples, OutPos, IrSize, &parms.Hrtf.Old,
-                            &hrtfparams, fademix);
+                        const HrtfOutput out{get_hrtf_output(OutPos, fademix)};
+                        MixHrtfBlendSamples(out.Left, out.Right, HrtfSamples, AccumSamples,
+                            out.Pos, VoiceIrSize, &hparms.Old, &hrtfparams, fademix);
                         /* Update the old parameters with the result. */
-                        parms.Hrtf.Old = parms.Hrtf.Target;
+                        hparms.Old = hparms.Target;
                         if(fademix < Counter)
-                            parms.Hrtf.Old.Gain = hrtfparams.Gain;
+                            hparms.Old.Gain = hrtfparams.Gain;
                         else
-                            parms.Hrtf.Old.Gain = TargetGain;
+                            hparms.Old.Gain = TargetGain;
                     }
 
                     if(LIKELY(fademix < DstBufferSize))
@@ -698,84 +2028,142 @@ void MixVoice(ALvoice *voice, ALvoice::State vstate, const ALuint SourceID, ALCc
                         {
                             const ALfloat a{static_cast<ALfloat>(todo) /
                                 static_cast<ALfloat>(Counter-fademix)};
-                            gain = lerp(parms.Hrtf.Old.Gain, TargetGain, a);
+                            gain = lerp(hparms.Old.Gain, TargetGain, a);
                         }
 
                         MixHrtfParams hrtfparams;
-                        hrtfparams.Coeffs = &parms.Hrtf.Target.Coeffs;
-                        hrtfparams.Delay[0] = parms.Hrtf.Target.Delay[0];
-                        hrtfparams.Delay[1] = parms.Hrtf.Target.Delay[1];
-                        hrtfparams.Gain = parms.Hrtf.Old.Gain;
-                        hrtfparams.GainStep = (gain - parms.Hrtf.Old.Gain) /
+                        hrtfparams.Coeffs = &hparms.Target.Coeffs;
+                        hrtfparams.Delay[0] = hparms.Target.Delay[0];
+                        hrtfparams.Delay[1] = hparms.Target.Delay[1];
+                        hrtfparams.Gain = hparms.Old.Gain;
+                        hrtfparams.GainStep = (gain - hparms.Old.Gain) /
                             static_cast<ALfloat>(todo);
-                        MixHrtfSamples(
-                            voice->mDirect.Buffer[OutLIdx], voice->mDirect.Buffer[OutRIdx],
-                            HrtfSamples+fademix, AccumSamples+fademix, OutPos+fademix, IrSize,
-                            &hrtfparams, todo);
+                        const HrtfOutput out{get_hrtf_output(OutPos+fademix, todo)};
+                        MixHrtfSamples(out.Left, out.Right, HrtfSamples+fademix,
+                            AccumSamples+fademix, out.Pos, VoiceIrSize, &hrtfparams, todo);
                         /* Store the interpolated gain or the final target gain
                          * depending if the fade is done.
                          */
                         if(DstBufferSize < Counter)
-                            parms.Hrtf.Old.Gain = gain;
+                            hparms.Old.Gain = gain;
                         else
-                            parms.Hrtf.Old.Gain = TargetGain;
+                            hparms.Old.Gain = TargetGain;
                     }
 
                     /* Copy the new in-progress accumulation values back for
                      * the next mix.
                      */
                     std::copy_n(std::begin(AccumSamples) + DstBufferSize,
-                        parms.Hrtf.State.Values.size(), parms.Hrtf.State.Values.begin());
+                        hparms.State.Values.size(), hparms.State.Values.begin());
                 }
                 else if((voice->mFlags&VOICE_HAS_NFC))
                 {
-                    const ALfloat *TargetGains{UNLIKELY(vstate == ALvoice::Stopping) ?
+                    const ALfloat *TargetGains{UNLIKELY(fadeout) ?
                         SilentTarget : parms.Gains.Target};
 
-                    MixSamples(samples, voice->mDirect.ChannelsPerOrder[0],
+                    OutputSparseSamples(Scratch, samples, voice->mDirect.ChannelsPerOrder[0],
                         voice->mDirect.Buffer, parms.Gains.Current, TargetGains, Counter,
                         OutPos, DstBufferSize);
 
-                    ALfloat (&nfcsamples)[BUFFERSIZE] = Device->NfcSampleData;
+                    /* Run the filters for each order with channels in one
+                     * pass, then mix each order's output.
+                     */
+                    ALsizei maxorder{0};
+                    for(ALsizei order{1};order <= 4;++order)
+                    {
+                        if(voice->mDirect.ChannelsPerOrder[order] > 0)
+                            maxorder = order;
+                    }
+                    if(maxorder > 0)
+                    {
+                        float *nfcsamples[4]{Scratch.NfcSampleData[0], Scratch.NfcSampleData[1],
+                            Scratch.NfcSampleData[2], Scratch.NfcSampleData[3]};
+                        voice->mDirectNfc[chan].process(nfcsamples, samples, DstBufferSize,
+                            maxorder);
+                    }
+
                     ALsizei chanoffset{voice->mDirect.ChannelsPerOrder[0]};
-                    using FilterProc = void (NfcFilter::*)(float*,const float*,int);
-                    auto apply_nfc = [voice,&parms,samples,TargetGains,DstBufferSize,Counter,OutPos,&chanoffset,&nfcsamples](FilterProc process, ALsizei order) -> void
+                    for(ALsizei order{1};order <= maxorder;++order)
                     {
-                        if(voice->mDirect.ChannelsPerOrder[order] < 1)
-                            return;
-                        (parms.NFCtrlFilter.*process)(nfcsamples, samples, DstBufferSize);
-                        MixSamples(nfcsamples, voice->mDirect.ChannelsPerOrder[order],
+                        const ALsizei numchans{voice->mDirect.ChannelsPerOrder[order]};
+                        if(numchans < 1)
+                            continue;
+                        OutputSparseSamples(Scratch, Scratch.NfcSampleData[order-1], numchans,
                             voice->mDirect.Buffer+chanoffset, parms.Gains.Current+chanoffset,
                             TargetGains+chanoffset, Counter, OutPos, DstBufferSize);
-                        chanoffset += voice->mDirect.ChannelsPerOrder[order];
-                    };
-                    apply_nfc(&NfcFilter::process1, 1);
-                    apply_nfc(&NfcFilter::process2, 2);
-                    apply_nfc(&NfcFilter::process3, 3);
+                        chanoffset += numchans;
+                    }
+                }
+                else if(voice->mClusterBuffer)
+                {
+                    /* Mix to the voice's cluster, which gets panned for all
+                     * its voices after they're mixed. Keep the voice's own
+                     * gains current for if it's mixed alone later.
+                     */
+                    const ALfloat *target{UNLIKELY(fadeout) ? SilentTarget :
+                        &voice->mClusterGain.Target};
+                    OutputSamples(Scratch, samples, 1, voice->mClusterBuffer,
+                        &voice->mClusterGain.Current, target, Counter, OutPos, DstBufferSize);
+
+                    const ALfloat *TargetGains{UNLIKELY(fadeout) ?
+                        SilentTarget : parms.Gains.Target};
+                    std::copy_n(TargetGains, voice->mNumGains, parms.Gains.Current);
                 }
                 else
                 {
-                    const ALfloat *TargetGains{UNLIKELY(vstate == ALvoice::Stopping) ?
+                    const ALfloat *TargetGains{UNLIKELY(fadeout) ?
                         SilentTarget : parms.Gains.Target};
-                    MixSamples(samples, voice->mDirect.Channels, voice->mDirect.Buffer,
-                        parms.Gains.Current, TargetGains, Counter, OutPos, DstBufferSize);
+                    voice->mClusterGain.Current = UNLIKELY(fadeout) ? 0.0f :
+                        voice->mClusterGain.Target;
+                    if(fused)
+                        OutputFilteredSamples(Scratch, &parms.LowPass, &parms.HighPass,
+                            voice->mDirect.FilterType, samples, voice->mDirect.Channels,
+                            voice->mDirect.Buffer, parms.Gains.Current, TargetGains, Counter,
+                            OutPos, DstBufferSize);
+                    else
+                        OutputSparseSamples(Scratch, samples, voice->mDirect.Channels,
+                            voice->mDirect.Buffer, parms.Gains.Current, TargetGains, Counter,
+                            OutPos, DstBufferSize);
+                }
+
+                /* The other listeners get the same filtered samples. */
+                for(ALvoice::ListenerMixData &lmix : voice->mListenerMix)
+                {
+                    if(!lmix.Buffer) continue;
+                    auto &gains = lmix.Gains[chan];
+                    const ALfloat *TargetGains{UNLIKELY(fadeout) ? SilentTarget : gains.Target};
+                    OutputSamples(Scratch, samples, 2, lmix.Buffer, gains.Current, TargetGains,
+                        Counter, OutPos, DstBufferSize);
                 }
             }
 
-            ALfloat (&FilterBuf)[BUFFERSIZE] = Device->FilteredData;
-            auto mix_send = [vstate,Counter,OutPos,DstBufferSize,chan,ResampledData,&FilterBuf](ALvoice::SendData &send) -> void
+            /* The direct path is done with this channel's filtered data, so the
+             * sends can reuse its buffer.
+             */
+            ALfloat (&FilterBuf)[BUFFERSIZE] = Scratch.FilteredData[chan];
+            auto mix_send = [voice,fadeout,Counter,OutPos,DstBufferSize,chan,ResampledData,&Scratch,&FilterBuf,&filtered,&shared_later](ALvoice::SendData &send) -> void
             {
                 if(!send.Buffer)
                     return;
 
                 SendParams &parms = send.Params[chan];
-                const ALfloat *samples{DoFilters(&parms.LowPass, &parms.HighPass,
-                    FilterBuf, ResampledData, DstBufferSize, send.FilterType)};
-
-                const ALfloat *TargetGains{UNLIKELY(vstate==ALvoice::Stopping) ? SilentTarget :
+                const ALfloat *TargetGains{UNLIKELY(fadeout) ? SilentTarget :
                     parms.Gains.Target};
-                MixSamples(samples, send.Channels, send.Buffer, parms.Gains.Current,
-                    TargetGains, Counter, OutPos, DstBufferSize);
+                if(UseFusedMix(send.FilterType, send.Channels) &&
+                    !filtered.matches(send.FilterType, parms.LowPass, parms.HighPass) &&
+                    !shared_later(send.FilterType, parms.LowPass, parms.HighPass, &send+1,
+                        voice->mSend.end()))
+                {
+                    OutputFilteredSamples(Scratch, &parms.LowPass, &parms.HighPass,
+                        send.FilterType, ResampledData, send.Channels, send.Buffer,
+                        parms.Gains.Current, TargetGains, Counter, OutPos, DstBufferSize);
+                    return;
+                }
+
+                const ALfloat *samples{filtered.filter(&parms.LowPass, &parms.HighPass,
+                    FilterBuf, ResampledData, DstBufferSize, send.FilterType)};
+                OutputSparseSamples(Scratch, samples, send.Channels, send.Buffer,
+                    parms.Gains.Current, TargetGains, Counter, OutPos, DstBufferSize);
             };
             std::for_each(voice->mSend.begin(), voice->mSend.end(), mix_send);
         }
@@ -791,14 +2179,27 @@ void MixVoice(ALvoice *voice, ALvoice::State vstate, const ALuint SourceID, ALCc
         {
             /* Do nothing extra when there's no buffers. */
         }
+        else if((voice->mFlags&VOICE_IS_CALLBACK))
+        {
+            /* Handle callback source, which ends once the callback has run
+             * out and its last samples were played.
+             */
+            if((voice->mFlags&VOICE_CALLBACK_STOPPED) && DataPosInt >= voice->mCallbackBlockLen)
+            {
+                if(LIKELY(vstate == ALvoice::Playing))
+                    vstate = ALvoice::Stopped;
+                BufferListItem = nullptr;
+                break;
+            }
+        }
         else if(isstatic)
         {
             if(BufferLoopItem)
             {
                 /* Handle looping static source */
-                const ALbuffer *Buffer{BufferListItem->buffers[0]};
-                const ALsizei LoopStart{Buffer->LoopStart};
-                const ALsizei LoopEnd{Buffer->LoopEnd};
+                const ALbuffer *Buffer{DataItem->buffers[0]};
+                const int64_t LoopStart{Buffer->LoopStart};
+                const int64_t LoopEnd{Buffer->LoopEnd};
                 if(DataPosInt >= LoopEnd)
                 {
                     assert(LoopEnd > LoopStart);
@@ -808,7 +2209,7 @@ void MixVoice(ALvoice *voice, ALvoice::State vstate, const ALuint SourceID, ALCc
             else
             {
                 /* Handle non-looping static source */
-                if(DataPosInt >= BufferListItem->max_samples)
+                if(DataPosInt >= DataItem->max_samples)
                 {
                     if(LIKELY(vstate == ALvoice::Playing))
                         vstate = ALvoice::Stopped;
@@ -837,6 +2238,12 @@ void MixVoice(ALvoice *voice, ALvoice::State vstate, const ALuint SourceID, ALCc
     } while(OutPos < SamplesToDo);
 
     voice->mFlags |= VOICE_IS_FADING;
+    voice->mPrevResampler = nullptr;
+
+    /* Keep the leader's history in case the voice is mixed alone later. */
+    if(Instance && !leader)
+        std::copy_n(Instance->Leader->mPrevSamples.begin(), NumChannels,
+            voice->mPrevSamples.begin());
 
     /* Don't update positions and buffers if we were stopping. */
     if(UNLIKELY(vstate == ALvoice::Stopping))
@@ -846,7 +2253,7 @@ void MixVoice(ALvoice *voice, ALvoice::State vstate, const ALuint SourceID, ALCc
     }
 
     /* Update voice info */
-    voice->mPosition.store(DataPosInt, std::memory_order_relaxed);
+    voice->mPosition.store(static_cast<uint64_t>(DataPosInt), std::memory_order_relaxed);
     voice->mPositionFrac.store(DataPosFrac, std::memory_order_relaxed);
     voice->mCurrentBuffer.store(BufferListItem, std::memory_order_relaxed);
     if(vstate == ALvoice::Stopped)
@@ -856,10 +2263,23 @@ void MixVoice(ALvoice *voice, ALvoice::State vstate, const ALuint SourceID, ALCc
     }
     std::atomic_thread_fence(std::memory_order_release);
 
+    if(buffers_done > 0)
+    {
+        /* Count the completed buffers for the source, and wake anything the
+         * application has waiting on them.
+         */
+        if(voice->mCompletedCount)
+            voice->mCompletedCount->fetch_add(static_cast<ALuint>(buffers_done),
+                std::memory_order_release);
+        if(al::wakeup_handle *wakeup{Context->CompletionWakeup.load(std::memory_order_acquire)})
+            wakeup->signal();
+    }
+
     /* Send any events now, after the position/buffer info was updated. */
     ALbitfieldSOFT enabledevt{Context->EnabledEvts.load(std::memory_order_acquire)};
     if(buffers_done > 0 && (enabledevt&EventType_BufferCompleted))
     {
+        EventWriteLock evtlock{Context};
         RingBuffer *ring{Context->AsyncEvents.get()};
         auto evt_vec = ring->getWriteVector();
         if(evt_vec.first.len > 0)
@@ -868,7 +2288,7 @@ void MixVoice(ALvoice *voice, ALvoice::State vstate, const ALuint SourceID, ALCc
             evt->u.bufcomp.id = SourceID;
             evt->u.bufcomp.count = buffers_done;
             ring->writeAdvance(1);
-            Context->EventSem.post();
+            WakeEventThrd();
         }
     }
 
@@ -881,3 +2301,50 @@ void MixVoice(ALvoice *voice, ALvoice::State vstate, const ALuint SourceID, ALCc
         SendSourceStoppedEvent(Context, SourceID);
     }
 }
+
+
+void ResampleBufferData(const ALbuffer *buffer, const ALint increment, ALfloat *dst,
+    const ALsizei dstframes)
+{
+    const ALsizei NumChannels{ChannelsFromFmt(buffer->mFmtChannels)};
+    const ALsizei SampleSize{BytesFromFmt(buffer->mFmtType)};
+    const auto SampleLen = static_cast<ALsizei>(buffer->SampleLen);
+
+    /* This is done once per buffer, so always use a high quality resampler. */
+    InterpState state{};
+    BsincPrepare(static_cast<ALuint>(increment), &state.bsinc, &bsinc24);
+    const ResamplerFunc Resample{SelectResampler(BSinc24Resampler,
+        static_cast<ALuint>(increment))};
+
+    /* The kernels expect the mixer's FPU mode. */
+    FPUCtl mixer_mode{};
+
+    /* Load each channel whole, with silence before it. The end is extended
+     * with the last sample fading out, as the mixer does when a buffer stops.
+     */
+    al::vector<ALfloat,16> srcdata(static_cast<size_t>(SampleLen + MAX_RESAMPLE_PADDING*2));
+    al::vector<ALfloat,16> dstdata(static_cast<size_t>(dstframes));
+    for(ALsizei chan{0};chan < NumChannels;chan++)
+    {
+        std::fill(srcdata.begin(), srcdata.end(), 0.0f);
+        ADPCMState adpcm{};
+        LoadBufferSamples(&srcdata[MAX_RESAMPLE_PADDING], buffer, NumChannels, SampleSize, chan,
+            0, SampleLen, adpcm);
+
+        const ALfloat sample{srcdata[MAX_RESAMPLE_PADDING + SampleLen - 1]};
+        const ALfloat gainstep{1.0f / (BUFFERSIZE*2)};
+        ALfloat step{BUFFERSIZE*2};
+        std::for_each(srcdata.end()-MAX_RESAMPLE_PADDING, srcdata.end(),
+            [sample,gainstep,&step](ALfloat &val) noexcept -> void
+            {
+                step -= 1.0f;
+                val = sample * gainstep*step;
+            }
+        );
+
+        const ALfloat *samples{Resample(&state, &srcdata[MAX_RESAMPLE_PADDING], 0, increment,
+            dstdata.data(), dstframes)};
+        for(ALsizei i{0};i < dstframes;i++)
+            dst[i*NumChannels + chan] = samples[i];
+    }
+}
@@ -39,8 +39,12 @@
 #include "ambdec.h"
 #include "bformatdec.h"
 #include "filters/splitter.h"
+#ifdef ALSOFT_UHJ
 #include "uhjfilter.h"
+#endif
+#ifdef ALSOFT_BS2B
 #include "bs2b.h"
+#endif
 
 
 constexpr std::array<float,MAX_AMBI_CHANNELS> AmbiScale::FromN3D;
@@ -237,6 +241,12 @@ void InitNearFieldCtrl(ALCdevice *device, ALfloat ctrl_dist, ALsizei order, cons
     const char *devname{device->DeviceName.c_str()};
     if(!GetConfigValueBool(devname, "decoder", "nfc", 0) || !(ctrl_dist > 0.0f))
         return;
+    /* The near-field filters only go up to fourth-order. */
+    if(order > 4)
+    {
+        WARN("Near-field control is unavailable for order %d output\n", order);
+        return;
+    }
 
     device->AvgSpeakerDist = minf(ctrl_dist, 10.0f);
     TRACE("Using near-field reference distance: %.2f meters\n", device->AvgSpeakerDist);
@@ -258,7 +268,7 @@ void InitDistanceComp(ALCdevice *device, const AmbDecConf *conf, const ALsizei (
     if(!GetConfigValueBool(devname, "decoder", "distance-comp", 1) || !(maxdist > 0.0f))
         return;
 
-    auto srate = static_cast<ALfloat>(device->Frequency);
+    auto srate = static_cast<ALfloat>(device->MixFrequency);
     size_t total{0u};
     for(size_t i{0u};i < conf->Speakers.size();i++)
     {
@@ -394,7 +404,9 @@ void InitPanning(ALCdevice *device)
         ALfloat nfc_delay{0.0f};
         if(ConfigValueFloat(devname, "decoder", "nfc-ref-delay", &nfc_delay) && nfc_delay > 0.0f)
         {
-            static constexpr ALsizei chans_per_order[MAX_AMBI_ORDER+1]{ 1, 3, 5, 7 };
+            static constexpr ALsizei chans_per_order[MAX_AMBI_ORDER+1]{
+                1, 3, 5, 7, 9, 11, 13, 15
+            };
             nfc_delay = clampf(nfc_delay, 0.001f, 1000.0f);
             InitNearFieldCtrl(device, nfc_delay * SPEEDOFSOUNDMETRESPERSEC,
                               device->mAmbiOrder, chans_per_order);
@@ -431,6 +443,31 @@ void InitPanning(ALCdevice *device)
         );
         device->Dry.NumChannels = coeffcount;
 
+        /* Low-end systems can skip the ambisonic mix and decode, folding the
+         * decoder into the panning gains instead. The decoder is single-band,
+         * so the result is the same, except that the mix costs one channel
+         * per speaker rather than per ambisonic channel.
+         */
+        if(GetConfigValueBool(device->DeviceName.c_str(), nullptr, "speaker-panning", 0))
+        {
+            auto panning = al::make_unique<SpeakerPanMatrix>();
+            panning->NumCoeffs = coeffcount;
+            for(ALsizei i{0};i < count;++i)
+            {
+                ALfloat (&row)[MAX_AMBI2D_CHANNELS] = panning->Rows[idxmap[i]];
+                std::transform(std::begin(row), std::begin(row)+coeffcount,
+                    std::begin(chancoeffs[i]), std::begin(row), std::plus<ALfloat>{});
+            }
+
+            device->Dry.PanMatrix = panning.get();
+            device->Dry.NumChannels = device->channelsFromFmt();
+            device->SpeakerPanning = std::move(panning);
+            device->RealOut.NumChannels = 0;
+
+            TRACE("Panning directly to %d speakers\n", device->Dry.NumChannels);
+            return;
+        }
+
         TRACE("Enabling %s-order%s ambisonic decoder\n",
             (coeffcount > 5) ? "third" :
             (coeffcount > 3) ? "second" : "first",
@@ -444,8 +481,8 @@ void InitPanning(ALCdevice *device)
 
 void InitCustomPanning(ALCdevice *device, bool hqdec, const AmbDecConf *conf, const ALsizei (&speakermap)[MAX_OUTPUT_CHANNELS])
 {
-    static constexpr ALsizei chans_per_order2d[MAX_AMBI_ORDER+1] = { 1, 2, 2, 2 };
-    static constexpr ALsizei chans_per_order3d[MAX_AMBI_ORDER+1] = { 1, 3, 5, 7 };
+    static constexpr ALsizei chans_per_order2d[MAX_AMBI_ORDER+1] = { 1, 2, 2, 2, 2, 2, 2, 2 };
+    static constexpr ALsizei chans_per_order3d[MAX_AMBI_ORDER+1] = { 1, 3, 5, 7, 9, 11, 13, 15 };
 
     if(!hqdec && conf->FreqBands != 1)
         ERR("Basic renderer uses the high-frequency matrix as single-band (xover_freq = %.0fhz)\n",
@@ -480,7 +517,7 @@ void InitCustomPanning(ALCdevice *device, bool hqdec, const AmbDecConf *conf, co
         (conf->ChanMask > AMBI_1ORDER_MASK) ? "second" : "first",
         (conf->ChanMask&AMBI_PERIPHONIC_MASK) ? " periphonic" : ""
     );
-    device->AmbiDecoder = al::make_unique<BFormatDec>(conf, hqdec, count, device->Frequency,
+    device->AmbiDecoder = al::make_unique<BFormatDec>(conf, hqdec, count, device->MixFrequency,
         speakermap);
 
     device->RealOut.NumChannels = device->channelsFromFmt();
@@ -497,7 +534,7 @@ void InitCustomPanning(ALCdevice *device, bool hqdec, const AmbDecConf *conf, co
     InitDistanceComp(device, conf, speakermap);
 }
 
-void InitHrtfPanning(ALCdevice *device)
+void InitHrtfPanning(ALCdevice *device, const ALsizei ambi_order)
 {
     /* NOTE: In degrees, and azimuth goes clockwise. */
     static constexpr AngularPoint AmbiPoints[]{
@@ -544,26 +581,16 @@ void InitHrtfPanning(ALCdevice *device)
         { 5.00000000e-02f,  0.00000000e+00f, -8.09016994e-02f, -3.09016994e-02f,  0.00000000e+00f,  0.00000000e+00f,  9.04508497e-02f,  6.45497224e-02f,  1.23279000e-02f,  0.00000000e+00f,  0.00000000e+00f,  0.00000000e+00f, -7.94438918e-02f, -1.12611206e-01f,  2.42115150e-02f, -1.25611822e-01f },
         { 5.00000000e-02f,  0.00000000e+00f,  8.09016994e-02f, -3.09016994e-02f,  0.00000000e+00f,  0.00000000e+00f,  9.04508497e-02f, -6.45497224e-02f,  1.23279000e-02f,  0.00000000e+00f,  0.00000000e+00f,  0.00000000e+00f,  7.94438918e-02f, -1.12611206e-01f, -2.42115150e-02f, -1.25611822e-01f }
     };
-    static constexpr ALfloat AmbiOrderHFGainFOA[MAX_AMBI_ORDER+1]{
-        3.16227766e+00f, 1.82574186e+00f
-    }, AmbiOrderHFGainHOA[MAX_AMBI_ORDER+1]{
-        2.35702260e+00f, 1.82574186e+00f, 9.42809042e-01f
-        /*1.86508671e+00f, 1.60609389e+00f, 1.14205530e+00f, 5.68379553e-01f*/
+    static constexpr ALfloat AmbiOrderHFGain[MAX_AMBI_ORDER][MAX_AMBI_ORDER+1]{
+        { 3.16227766e+00f, 1.82574186e+00f },
+        { 2.35702260e+00f, 1.82574186e+00f, 9.42809042e-01f },
+        { 1.86508671e+00f, 1.60609389e+00f, 1.14205530e+00f, 5.68379553e-01f }
     };
     static constexpr ALsizei ChansPerOrder[MAX_AMBI_ORDER+1]{ 1, 3, 5, 7 };
-    const ALfloat *AmbiOrderHFGain{AmbiOrderHFGainFOA};
 
     static_assert(COUNTOF(AmbiPoints) == COUNTOF(AmbiMatrix), "Ambisonic HRTF mismatch");
 
-    /* Don't bother with HOA when using full HRTF rendering. Nothing needs it,
-     * and it eases the CPU/memory load.
-     */
-    ALsizei ambi_order{1};
-    if(device->mRenderMode != HrtfRender)
-    {
-        ambi_order = 2;
-        AmbiOrderHFGain = AmbiOrderHFGainHOA;
-    }
+    ASSUME(ambi_order >= 1 && ambi_order <= MAX_AMBI_ORDER);
     device->mAmbiOrder = ambi_order;
 
     const size_t count{AmbiChannelsFromOrder(ambi_order)};
@@ -578,12 +605,13 @@ void InitHrtfPanning(ALCdevice *device)
     device->RealOut.NumChannels = device->channelsFromFmt();
 
     BuildBFormatHrtf(device->mHrtf, device->mHrtfState.get(), device->Dry.NumChannels, AmbiPoints,
-        AmbiMatrix, COUNTOF(AmbiPoints), AmbiOrderHFGain);
+        AmbiMatrix, COUNTOF(AmbiPoints), AmbiOrderHFGain[ambi_order-1]);
 
     HrtfEntry *Hrtf{device->mHrtf};
     InitNearFieldCtrl(device, Hrtf->field[0].distance, ambi_order, ChansPerOrder);
 }
 
+#ifdef ALSOFT_UHJ
 void InitUhjPanning(ALCdevice *device)
 {
     /* UHJ is always 2D first-order. */
@@ -600,33 +628,52 @@ void InitUhjPanning(ALCdevice *device)
 
     device->RealOut.NumChannels = device->channelsFromFmt();
 }
+#endif
 
-} // namespace
 
+/* N3D normalization for the fourth-order and up coefficients, indexed by
+ * [order-4][|degree|]. For order l and degree m, this is:
+ *
+ * sqrt((2*l + 1) * (m ? 2 : 1) * (l-m)! / (l+m)!)
+ */
+constexpr ALfloat AmbiHONorm[MAX_AMBI_ORDER-3][MAX_AMBI_ORDER+1]{
+    { 3.000000000e+00f, 9.486832981e-01f, 2.236067977e-01f, 5.976143047e-02f, 2.112885637e-02f },
+    { 3.316624790e+00f, 8.563488386e-01f, 1.618347187e-01f, 3.303437363e-02f, 7.786276536e-03f, 2.462236835e-03f },
+    { 3.605551275e+00f, 7.867957925e-01f, 1.244033379e-01f, 2.073388965e-02f, 3.785473021e-03f, 8.070655599e-04f, 2.329797591e-04f },
+    { 3.872983346e+00f, 7.319250547e-01f, 9.960238411e-02f, 1.408590425e-02f, 2.123529964e-03f, 3.539216607e-04f, 6.940974824e-05f, 1.855053552e-05f },
+};
 
-void CalcAmbiCoeffs(const ALfloat y, const ALfloat z, const ALfloat x, const ALfloat spread,
-                    ALfloat (&coeffs)[MAX_AMBI_CHANNELS])
+/* Calculates the unscaled N3D coefficients for N directions at once. The
+ * output is stored by channel, with the N lanes for each channel together, so
+ * each term can be computed for all the lanes in a row.
+ */
+template<size_t N>
+void CalcAmbiCoeffsLanes(const ALfloat *RESTRICT y, const ALfloat *RESTRICT z,
+    const ALfloat *RESTRICT x, ALfloat *RESTRICT out)
 {
-    /* Zeroth-order */
-    coeffs[0]  = 1.0f; /* ACN 0 = 1 */
-    /* First-order */
-    coeffs[1]  = 1.732050808f * y; /* ACN 1 = sqrt(3) * Y */
-    coeffs[2]  = 1.732050808f * z; /* ACN 2 = sqrt(3) * Z */
-    coeffs[3]  = 1.732050808f * x; /* ACN 3 = sqrt(3) * X */
-    /* Second-order */
-    coeffs[4]  = 3.872983346f * x * y;             /* ACN 4 = sqrt(15) * X * Y */
-    coeffs[5]  = 3.872983346f * y * z;             /* ACN 5 = sqrt(15) * Y * Z */
-    coeffs[6]  = 1.118033989f * (z*z*3.0f - 1.0f); /* ACN 6 = sqrt(5)/2 * (3*Z*Z - 1) */
-    coeffs[7]  = 3.872983346f * x * z;             /* ACN 7 = sqrt(15) * X * Z */
-    coeffs[8]  = 1.936491673f * (x*x - y*y);       /* ACN 8 = sqrt(15)/2 * (X*X - Y*Y) */
-    /* Third-order */
-    coeffs[9]  =  2.091650066f * y * (x*x*3.0f - y*y);  /* ACN  9 = sqrt(35/8) * Y * (3*X*X - Y*Y) */
-    coeffs[10] = 10.246950766f * z * x * y;             /* ACN 10 = sqrt(105) * Z * X * Y */
-    coeffs[11] =  1.620185175f * y * (z*z*5.0f - 1.0f); /* ACN 11 = sqrt(21/8) * Y * (5*Z*Z - 1) */
-    coeffs[12] =  1.322875656f * z * (z*z*5.0f - 3.0f); /* ACN 12 = sqrt(7)/2 * Z * (5*Z*Z - 3) */
-    coeffs[13] =  1.620185175f * x * (z*z*5.0f - 1.0f); /* ACN 13 = sqrt(21/8) * X * (5*Z*Z - 1) */
-    coeffs[14] =  5.123475383f * z * (x*x - y*y);       /* ACN 14 = sqrt(105)/2 * Z * (X*X - Y*Y) */
-    coeffs[15] =  2.091650066f * x * (x*x - y*y*3.0f);  /* ACN 15 = sqrt(35/8) * X * (X*X - 3*Y*Y) */
+    for(size_t i{0};i < N;++i)
+    {
+        /* Zeroth-order */
+        out[ 0*N + i] = 1.0f; /* ACN 0 = 1 */
+        /* First-order */
+        out[ 1*N + i] = 1.732050808f * y[i]; /* ACN 1 = sqrt(3) * Y */
+        out[ 2*N + i] = 1.732050808f * z[i]; /* ACN 2 = sqrt(3) * Z */
+        out[ 3*N + i] = 1.732050808f * x[i]; /* ACN 3 = sqrt(3) * X */
+        /* Second-order */
+        out[ 4*N + i] = 3.872983346f * x[i] * y[i];                /* ACN 4 = sqrt(15) * X * Y */
+        out[ 5*N + i] = 3.872983346f * y[i] * z[i];                /* ACN 5 = sqrt(15) * Y * Z */
+        out[ 6*N + i] = 1.118033989f * (z[i]*z[i]*3.0f - 1.0f);    /* ACN 6 = sqrt(5)/2 * (3*Z*Z - 1) */
+        out[ 7*N + i] = 3.872983346f * x[i] * z[i];                /* ACN 7 = sqrt(15) * X * Z */
+        out[ 8*N + i] = 1.936491673f * (x[i]*x[i] - y[i]*y[i]);    /* ACN 8 = sqrt(15)/2 * (X*X - Y*Y) */
+        /* Third-order */
+        out[ 9*N + i] =  2.091650066f * y[i] * (x[i]*x[i]*3.0f - y[i]*y[i]); /* ACN  9 = sqrt(35/8) * Y * (3*X*X - Y*Y) */
+        out[10*N + i] = 10.246950766f * z[i] * x[i] * y[i];                  /* ACN 10 = sqrt(105) * Z * X * Y */
+        out[11*N + i] =  1.620185175f * y[i] * (z[i]*z[i]*5.0f - 1.0f);      /* ACN 11 = sqrt(21/8) * Y * (5*Z*Z - 1) */
+        out[12*N + i] =  1.322875656f * z[i] * (z[i]*z[i]*5.0f - 3.0f);      /* ACN 12 = sqrt(7)/2 * Z * (5*Z*Z - 3) */
+        out[13*N + i] =  1.620185175f * x[i] * (z[i]*z[i]*5.0f - 1.0f);      /* ACN 13 = sqrt(21/8) * X * (5*Z*Z - 1) */
+        out[14*N + i] =  5.123475383f * z[i] * (x[i]*x[i] - y[i]*y[i]);      /* ACN 14 = sqrt(105)/2 * Z * (X*X - Y*Y) */
+        out[15*N + i] =  2.091650066f * x[i] * (x[i]*x[i] - y[i]*y[i]*3.0f); /* ACN 15 = sqrt(35/8) * X * (X*X - 3*Y*Y) */
+    }
     /* Fourth-order */
     /* ACN 16 = sqrt(35)*3/2 * X * Y * (X*X - Y*Y) */
     /* ACN 17 = sqrt(35/2)*3/2 * (3*X*X - Y*Y) * Y * Z */
@@ -637,79 +684,224 @@ void CalcAmbiCoeffs(const ALfloat y, const ALfloat z, const ALfloat x, const ALf
     /* ACN 22 = sqrt(5)*3/4 * (X*X - Y*Y) * (7*Z*Z - 1) */
     /* ACN 23 = sqrt(35/2)*3/2 * (X*X - 3*Y*Y) * X * Z */
     /* ACN 24 = sqrt(35)*3/8 * (X*X*X*X - 6*X*X*Y*Y + Y*Y*Y*Y) */
+    /* Rather than spelling out each of the higher-order terms, they're built
+     * from recurrences. For degree m, the polynomial in Z starts with
+     * Q(m,m) = (2m-1)!!, then each order after is:
+     *
+     * Q(l,m) = ((2l-1)*Z*Q(l-1,m) - (l+m-1)*Q(l-2,m)) / (l-m)
+     *
+     * and gets multiplied by the real (m > 0) or imaginary (m < 0) part of
+     * (X + iY)**|m|, which is also built up one degree at a time. These are
+     * the same as the terms above, e.g. ACN 20 = 3 * Q(4,0).
+     */
+    ALfloat cosm[N], sinm[N];
+    std::fill_n(cosm, N, 1.0f);
+    std::fill_n(sinm, N, 0.0f);
+    ALfloat qmm{1.0f};
+    for(int m{0};m <= MAX_AMBI_ORDER;++m)
+    {
+        if(m > 0)
+        {
+            for(size_t i{0};i < N;++i)
+            {
+                const ALfloat c{cosm[i]*x[i] - sinm[i]*y[i]};
+                sinm[i] = sinm[i]*x[i] + cosm[i]*y[i];
+                cosm[i] = c;
+            }
+            qmm *= static_cast<ALfloat>(m*2 - 1);
+        }
 
-    if(spread > 0.0f)
+        ALfloat q2[N], q1[N];
+        for(int l{m};l <= MAX_AMBI_ORDER;++l)
+        {
+            if(l == m)
+            {
+                std::fill_n(q2, N, 0.0f);
+                std::fill_n(q1, N, qmm);
+            }
+            else
+            {
+                const ALfloat a{static_cast<ALfloat>(l*2 - 1)};
+                const ALfloat b{static_cast<ALfloat>(l+m - 1)};
+                const ALfloat d{static_cast<ALfloat>(l - m)};
+                for(size_t i{0};i < N;++i)
+                {
+                    const ALfloat q{(a*z[i]*q1[i] - b*q2[i]) / d};
+                    q2[i] = q1[i];
+                    q1[i] = q;
+                }
+            }
+            if(l < 4) continue;
+
+            const ALfloat norm{AmbiHONorm[l-4][m]};
+            ALfloat *RESTRICT cpos{out + (l*l + l + m)*N};
+            for(size_t i{0};i < N;++i)
+                cpos[i] = q1[i]*norm * cosm[i];
+            if(m > 0)
+            {
+                ALfloat *RESTRICT spos{out + (l*l + l - m)*N};
+                for(size_t i{0};i < N;++i)
+                    spos[i] = q1[i]*norm * sinm[i];
+            }
+        }
+    }
+}
+
+/* Calculates the per-order scaling for a source with the given spread,
+ * returning false if the coefficients are left as-is.
+ */
+bool CalcSpreadScales(const ALfloat spread, ALfloat (&scales)[MAX_AMBI_ORDER+1])
+{
+    if(!(spread > 0.0f))
+        return false;
+
+    /* Implement the spread by using a spherical source that subtends the
+     * angle spread. See:
+     * http://www.ppsloan.org/publications/StupidSH36.pdf - Appendix A3
+     *
+     * When adjusted for N3D normalization instead of SN3D, these
+     * calculations are:
+     *
+     * ZH0 = -sqrt(pi) * (-1+ca);
+     * ZH1 =  0.5*sqrt(pi) * sa*sa;
+     * ZH2 = -0.5*sqrt(pi) * ca*(-1+ca)*(ca+1);
+     * ZH3 = -0.125*sqrt(pi) * (-1+ca)*(ca+1)*(5*ca*ca - 1);
+     * ZH4 = -0.125*sqrt(pi) * ca*(-1+ca)*(ca+1)*(7*ca*ca - 3);
+     * ZH5 = -0.0625*sqrt(pi) * (-1+ca)*(ca+1)*(21*ca*ca*ca*ca - 14*ca*ca + 1);
+     *
+     * The gain of the source is compensated for size, so that the
+     * loudness doesn't depend on the spread. Thus:
+     *
+     * ZH0 = 1.0f;
+     * ZH1 = 0.5f * (ca+1.0f);
+     * ZH2 = 0.5f * (ca+1.0f)*ca;
+     * ZH3 = 0.125f * (ca+1.0f)*(5.0f*ca*ca - 1.0f);
+     * ZH4 = 0.125f * (ca+1.0f)*(7.0f*ca*ca - 3.0f)*ca;
+     * ZH5 = 0.0625f * (ca+1.0f)*(21.0f*ca*ca*ca*ca - 14.0f*ca*ca + 1.0f);
+     */
+    ALfloat ca = std::cos(spread * 0.5f);
+    /* Increase the source volume by up to +3dB for a full spread. */
+    ALfloat scale = std::sqrt(1.0f + spread/al::MathDefs<float>::Tau());
+
+    scales[0] = scale;
+    scales[1] = 0.5f * (ca+1.f) * scale;
+    scales[2] = 0.5f * (ca+1.f)*ca * scale;
+    scales[3] = 0.125f * (ca+1.f)*(5.f*ca*ca-1.f) * scale;
+
+    /* The general form of the above, relative to ZH0, is:
+     *
+     * ZHl = (P(l-1, ca) - P(l+1, ca)) / ((2l+1) * (1-ca))
+     *
+     * using the Legendre polynomials P(n, ca). The subtraction loses
+     * precision as ca approaches 1, so it's done in double precision, and
+     * a small enough spread is left unscaled.
+     */
+    const double dca{std::cos(spread * 0.5)};
+    if(1.0 - dca > 1e-12)
     {
-        /* Implement the spread by using a spherical source that subtends the
-         * angle spread. See:
-         * http://www.ppsloan.org/publications/StupidSH36.pdf - Appendix A3
-         *
-         * When adjusted for N3D normalization instead of SN3D, these
-         * calculations are:
-         *
-         * ZH0 = -sqrt(pi) * (-1+ca);
-         * ZH1 =  0.5*sqrt(pi) * sa*sa;
-         * ZH2 = -0.5*sqrt(pi) * ca*(-1+ca)*(ca+1);
-         * ZH3 = -0.125*sqrt(pi) * (-1+ca)*(ca+1)*(5*ca*ca - 1);
-         * ZH4 = -0.125*sqrt(pi) * ca*(-1+ca)*(ca+1)*(7*ca*ca - 3);
-         * ZH5 = -0.0625*sqrt(pi) * (-1+ca)*(ca+1)*(21*ca*ca*ca*ca - 14*ca*ca + 1);
-         *
-         * The gain of the source is compensated for size, so that the
-         * loudness doesn't depend on the spread. Thus:
-         *
-         * ZH0 = 1.0f;
-         * ZH1 = 0.5f * (ca+1.0f);
-         * ZH2 = 0.5f * (ca+1.0f)*ca;
-         * ZH3 = 0.125f * (ca+1.0f)*(5.0f*ca*ca - 1.0f);
-         * ZH4 = 0.125f * (ca+1.0f)*(7.0f*ca*ca - 3.0f)*ca;
-         * ZH5 = 0.0625f * (ca+1.0f)*(21.0f*ca*ca*ca*ca - 14.0f*ca*ca + 1.0f);
-         */
-        ALfloat ca = std::cos(spread * 0.5f);
-        /* Increase the source volume by up to +3dB for a full spread. */
-        ALfloat scale = std::sqrt(1.0f + spread/al::MathDefs<float>::Tau());
+        double legendre[MAX_AMBI_ORDER+2]{1.0, dca};
+        for(int n{2};n <= MAX_AMBI_ORDER+1;++n)
+            legendre[n] = ((n*2 - 1)*dca*legendre[n-1] - (n-1)*legendre[n-2]) / n;
+        for(int l{4};l <= MAX_AMBI_ORDER;++l)
+        {
+            const double zh{(legendre[l-1] - legendre[l+1]) / ((l*2 + 1) * (1.0-dca))};
+            scales[l] = static_cast<ALfloat>(zh) * scale;
+        }
+    }
+    else
+        std::fill(std::begin(scales)+4, std::end(scales), scale);
+    return true;
+}
 
-        ALfloat ZH0_norm = scale;
-        ALfloat ZH1_norm = 0.5f * (ca+1.f) * scale;
-        ALfloat ZH2_norm = 0.5f * (ca+1.f)*ca * scale;
-        ALfloat ZH3_norm = 0.125f * (ca+1.f)*(5.f*ca*ca-1.f) * scale;
+} // namespace
 
-        /* Zeroth-order */
-        coeffs[0]  *= ZH0_norm;
-        /* First-order */
-        coeffs[1]  *= ZH1_norm;
-        coeffs[2]  *= ZH1_norm;
-        coeffs[3]  *= ZH1_norm;
-        /* Second-order */
-        coeffs[4]  *= ZH2_norm;
-        coeffs[5]  *= ZH2_norm;
-        coeffs[6]  *= ZH2_norm;
-        coeffs[7]  *= ZH2_norm;
-        coeffs[8]  *= ZH2_norm;
-        /* Third-order */
-        coeffs[9]  *= ZH3_norm;
-        coeffs[10] *= ZH3_norm;
-        coeffs[11] *= ZH3_norm;
-        coeffs[12] *= ZH3_norm;
-        coeffs[13] *= ZH3_norm;
-        coeffs[14] *= ZH3_norm;
-        coeffs[15] *= ZH3_norm;
+
+void CalcAmbiCoeffs(const ALfloat y, const ALfloat z, const ALfloat x, const ALfloat spread,
+                    ALfloat (&coeffs)[MAX_AMBI_CHANNELS])
+{
+    CalcAmbiCoeffsLanes<1>(&y, &z, &x, coeffs);
+
+    ALfloat scales[MAX_AMBI_ORDER+1];
+    if(CalcSpreadScales(spread, scales))
+    {
+        for(int l{0};l <= MAX_AMBI_ORDER;++l)
+        {
+            const ALfloat scale{scales[l]};
+            std::for_each(coeffs+l*l, coeffs+(l+1)*(l+1),
+                [scale](ALfloat &coeff) noexcept -> void { coeff *= scale; });
+        }
     }
 }
 
-void ComputePanGains(const MixParams *mix, const ALfloat *RESTRICT coeffs, ALfloat ingain, ALfloat (&gains)[MAX_OUTPUT_CHANNELS])
+void CalcAmbiCoeffsMulti(const ALfloat *y, const ALfloat *z, const ALfloat *x, const ALfloat spread,
+    const ALsizei count, ALfloat (*coeffs)[MAX_AMBI_CHANNELS])
+{
+    static constexpr size_t Lanes{4};
+
+    ALfloat scales[MAX_AMBI_ORDER+1];
+    if(!CalcSpreadScales(spread, scales))
+        std::fill(std::begin(scales), std::end(scales), 1.0f);
+
+    ASSUME(count >= 0);
+    for(ALsizei base{0};base < count;base += static_cast<ALsizei>(Lanes))
+    {
+        const auto todo = static_cast<size_t>(mini(count-base, static_cast<ALsizei>(Lanes)));
+
+        /* A partial block is zero-padded, and the extra lanes are discarded. */
+        alignas(16) ALfloat ly[Lanes]{}, lz[Lanes]{}, lx[Lanes]{};
+        std::copy_n(y+base, todo, ly);
+        std::copy_n(z+base, todo, lz);
+        std::copy_n(x+base, todo, lx);
+
+        alignas(16) ALfloat block[MAX_AMBI_CHANNELS*Lanes];
+        CalcAmbiCoeffsLanes<Lanes>(ly, lz, lx, block);
+
+        for(int l{0};l <= MAX_AMBI_ORDER;++l)
+        {
+            const ALfloat scale{scales[l]};
+            for(int c{l*l};c < (l+1)*(l+1);++c)
+            {
+                for(size_t i{0};i < todo;++i)
+                    coeffs[static_cast<size_t>(base)+i][c] = block[static_cast<size_t>(c)*Lanes + i] * scale;
+            }
+        }
+    }
+}
+
+void ComputePanGains(const MixParams *mix, const ALfloat *RESTRICT coeffs, ALfloat ingain, ALfloat *gains, ALsizei numgains)
 {
     auto ambimap = mix->AmbiMap.cbegin();
     const ALsizei numchans{mix->NumChannels};
 
     ASSUME(numchans > 0);
-    auto iter = std::transform(ambimap, ambimap+numchans, std::begin(gains),
+    ASSUME(numgains >= numchans);
+    if(const SpeakerPanMatrix *panning{mix->PanMatrix})
+    {
+        /* Decode the ambisonic channels' gains to each speaker. */
+        const ALsizei numcoeffs{panning->NumCoeffs};
+        ASSUME(numcoeffs > 0);
+        auto iter = std::transform(std::begin(panning->Rows), std::begin(panning->Rows)+numchans,
+            gains,
+            [ambimap,numcoeffs,coeffs,ingain](const ALfloat (&row)[MAX_AMBI2D_CHANNELS]) noexcept -> ALfloat
+            {
+                ALfloat gain{0.0f};
+                for(ALsizei j{0};j < numcoeffs;++j)
+                    gain += row[j] * ambimap[j].Scale * coeffs[ambimap[j].Index];
+                return gain * ingain;
+            }
+        );
+        std::fill(iter, gains+numgains, 0.0f);
+        return;
+    }
+
+    auto iter = std::transform(ambimap, ambimap+numchans, gains,
         [coeffs,ingain](const BFChannelConfig &chanmap) noexcept -> ALfloat
         {
             ASSUME(chanmap.Index >= 0);
             return chanmap.Scale * coeffs[chanmap.Index] * ingain;
         }
     );
-    std::fill(iter, std::end(gains), 0.0f);
+    std::fill(iter, gains+numgains, 0.0f);
 }
 
 
@@ -720,6 +912,9 @@ void aluInitRenderer(ALCdevice *device, ALint hrtf_id, HrtfRequestMode hrtf_appr
 
     device->mHrtfState = nullptr;
     device->mHrtf = nullptr;
+    device->mHrtfCache = nullptr;
+    device->mHrtfLodSize = 0;
+    device->mHrtfLoadPending = false;
     device->HrtfName.clear();
     device->mRenderMode = NormalRender;
 
@@ -731,6 +926,8 @@ void aluInitRenderer(ALCdevice *device, ALint hrtf_id, HrtfRequestMode hrtf_appr
     device->ChannelDelay.clear();
 
     device->AmbiDecoder = nullptr;
+    device->Dry.PanMatrix = nullptr;
+    device->SpeakerPanning = nullptr;
     device->Stablizer = nullptr;
 
     if(device->FmtChans != DevFmtStereo)
@@ -802,7 +999,7 @@ void aluInitRenderer(ALCdevice *device, ALint hrtf_id, HrtfRequestMode hrtf_appr
                  * front-right channels, with a crossover at 5khz (could be
                  * higher).
                  */
-                const ALfloat scale{static_cast<ALfloat>(5000.0 / device->Frequency)};
+                const ALfloat scale{static_cast<ALfloat>(5000.0 / device->MixFrequency)};
 
                 stablizer->LFilter.init(scale);
                 stablizer->RFilter = stablizer->LFilter;
@@ -816,7 +1013,7 @@ void aluInitRenderer(ALCdevice *device, ALint hrtf_id, HrtfRequestMode hrtf_appr
                  * FrontStablizer::DelayLength...
                  */
                 static constexpr size_t StablizerDelay{FrontStablizer::DelayLength};
-                device->FixedLatency += nanoseconds{seconds{StablizerDelay}} / device->Frequency;
+                device->FixedLatency += nanoseconds{seconds{StablizerDelay}} / device->MixFrequency;
             }
             break;
         case DevFmtMono:
@@ -868,38 +1065,48 @@ void aluInitRenderer(ALCdevice *device, ALint hrtf_id, HrtfRequestMode hrtf_appr
         device->HrtfStatus = ALC_HRTF_REQUIRED_SOFT;
     }
 
-    if(device->HrtfList.empty())
-        device->HrtfList = EnumerateHrtf(device->DeviceName.c_str());
-
-    if(hrtf_id >= 0 && static_cast<size_t>(hrtf_id) < device->HrtfList.size())
     {
-        const EnumeratedHrtf &entry = device->HrtfList[hrtf_id];
-        HrtfEntry *hrtf{GetLoadedHrtf(entry.hrtf)};
-        if(hrtf && hrtf->sampleRate == device->Frequency)
+        /* With hrtf-async, only use an HRTF that's already loaded. Otherwise,
+         * render without one for now, and have the device load it in the
+         * background to switch to it once it's ready.
+         */
+        const bool async{device->Type == Playback && !device->mHrtfLoadSync &&
+            GetConfigValueBool(device->DeviceName.c_str(), nullptr, "hrtf-async", 0)};
+        auto get_hrtf = async ? FindLoadedHrtf : GetLoadedHrtf;
+
+        if(device->HrtfList.empty() && !async)
+            device->HrtfList = EnumerateHrtf(device->DeviceName.c_str());
+
+        if(hrtf_id >= 0 && static_cast<size_t>(hrtf_id) < device->HrtfList.size())
         {
-            device->mHrtf = hrtf;
-            device->HrtfName = entry.name;
+            const EnumeratedHrtf &entry = device->HrtfList[hrtf_id];
+            if(HrtfEntry *hrtf{get_hrtf(entry.hrtf, device->MixFrequency)})
+            {
+                device->mHrtf = hrtf;
+                device->HrtfName = entry.name;
+            }
         }
-        else if(hrtf)
-            hrtf->DecRef();
-    }
 
-    if(!device->mHrtf)
-    {
-        auto find_hrtf = [device](const EnumeratedHrtf &entry) -> bool
+        if(!device->mHrtf)
         {
-            HrtfEntry *hrtf{GetLoadedHrtf(entry.hrtf)};
-            if(!hrtf) return false;
-            if(hrtf->sampleRate != device->Frequency)
+            auto find_hrtf = [device,get_hrtf](const EnumeratedHrtf &entry) -> bool
             {
-                hrtf->DecRef();
-                return false;
-            }
-            device->mHrtf = hrtf;
-            device->HrtfName = entry.name;
-            return true;
-        };
-        std::find_if(device->HrtfList.cbegin(), device->HrtfList.cend(), find_hrtf);
+                HrtfEntry *hrtf{get_hrtf(entry.hrtf, device->MixFrequency)};
+                if(!hrtf) return false;
+                device->mHrtf = hrtf;
+                device->HrtfName = entry.name;
+                return true;
+            };
+            std::find_if(device->HrtfList.cbegin(), device->HrtfList.cend(), find_hrtf);
+        }
+
+        if(!device->mHrtf && async)
+        {
+            TRACE("Loading HRTF in the background\n");
+            device->mHrtfLoadPending = true;
+            device->HrtfStatus = ALC_HRTF_DISABLED_SOFT;
+            goto no_hrtf;
+        }
     }
 
     if(device->mHrtf)
@@ -908,22 +1115,67 @@ void aluInitRenderer(ALCdevice *device, ALint hrtf_id, HrtfRequestMode hrtf_appr
             old_hrtf->DecRef();
         old_hrtf = nullptr;
 
+        /* Full HRTF rendering doesn't bother with HOA for the ambisonic mix.
+         * Nothing needs it, and it eases the CPU/memory load. Otherwise, the
+         * sources are panned into an ambisonic mix of the given order, with
+         * only the ambisonic channels being convolved.
+         */
         device->mRenderMode = HrtfRender;
+        ALsizei ambi_order{1};
         const char *mode;
         if(ConfigValueStr(device->DeviceName.c_str(), nullptr, "hrtf-mode", &mode))
         {
             if(strcasecmp(mode, "full") == 0)
                 device->mRenderMode = HrtfRender;
-            else if(strcasecmp(mode, "basic") == 0)
+            else if(strcasecmp(mode, "ambi1") == 0)
+            {
+                device->mRenderMode = NormalRender;
+                ambi_order = 1;
+            }
+            else if(strcasecmp(mode, "ambi2") == 0 || strcasecmp(mode, "basic") == 0)
+            {
                 device->mRenderMode = NormalRender;
+                ambi_order = 2;
+            }
+            else if(strcasecmp(mode, "ambi3") == 0)
+            {
+                device->mRenderMode = NormalRender;
+                ambi_order = 3;
+            }
             else
                 ERR("Unexpected hrtf-mode: %s\n", mode);
         }
 
-        TRACE("%s HRTF rendering enabled, using \"%s\"\n",
-            ((device->mRenderMode == HrtfRender) ? "Full" : "Basic"), device->HrtfName.c_str()
-        );
-        InitHrtfPanning(device);
+        if(device->mRenderMode == HrtfRender)
+            TRACE("Full HRTF rendering enabled, using \"%s\"\n", device->HrtfName.c_str());
+        else
+            TRACE("Order %d ambisonic HRTF rendering enabled, using \"%s\"\n", ambi_order,
+                device->HrtfName.c_str());
+
+        ALint cachesize{64};
+        ConfigValueInt(device->DeviceName.c_str(), nullptr, "hrtf-cache-size", &cachesize);
+        if(cachesize > 0)
+        {
+            device->mHrtfCache = HrtfCoeffCache::Create(static_cast<size_t>(cachesize));
+            TRACE("Caching up to %d HRIR coefficient sets\n", cachesize);
+        }
+
+        ALint lodsize{0};
+        ConfigValueInt(device->DeviceName.c_str(), nullptr, "hrtf-lod-size", &lodsize);
+        if(lodsize > 0)
+        {
+            lodsize = clampi(lodsize, 8, HRTF_LOD_MAX_SIZE) & ~1;
+            if(lodsize < device->mHrtf->irSize)
+            {
+                device->mHrtfLodSize = lodsize;
+                device->mHrtfLodDistance = 10.0f;
+                ConfigValueFloat(device->DeviceName.c_str(), nullptr, "hrtf-lod-distance",
+                    &device->mHrtfLodDistance);
+                TRACE("Using %d-sample HRIRs for sources from %.2fm\n", lodsize,
+                    device->mHrtfLodDistance);
+            }
+        }
+        InitHrtfPanning(device, ambi_order);
         return;
     }
     device->HrtfStatus = ALC_HRTF_UNSUPPORTED_FORMAT_SOFT;
@@ -935,6 +1187,7 @@ no_hrtf:
 
     device->mRenderMode = StereoPair;
 
+#ifdef ALSOFT_BS2B
     int bs2blevel{((headphones && hrtf_appreq != Hrtf_Disable) ||
                    (hrtf_appreq == Hrtf_Enable)) ? 5 : 0};
     if(device->Type != Loopback)
@@ -942,11 +1195,12 @@ no_hrtf:
     if(bs2blevel > 0 && bs2blevel <= 6)
     {
         device->Bs2b = al::make_unique<bs2b>();
-        bs2b_set_params(device->Bs2b.get(), bs2blevel, device->Frequency);
+        bs2b_set_params(device->Bs2b.get(), bs2blevel, device->MixFrequency);
         TRACE("BS2B enabled\n");
         InitPanning(device);
         return;
     }
+#endif
 
     const char *mode;
     if(ConfigValueStr(device->DeviceName.c_str(), nullptr, "stereo-encoding", &mode))
@@ -958,10 +1212,15 @@ no_hrtf:
     }
     if(device->mRenderMode == NormalRender)
     {
+#ifdef ALSOFT_UHJ
         device->Uhj_Encoder = al::make_unique<Uhj2Encoder>();
         TRACE("UHJ enabled\n");
         InitUhjPanning(device);
         return;
+#else
+        WARN("UHJ encoding not built, using pan-pot\n");
+        device->mRenderMode = StereoPair;
+#endif
     }
 
     TRACE("Stereo rendering\n");
@@ -972,8 +1231,6 @@ no_hrtf:
 void aluInitEffectPanning(ALeffectslot *slot, ALCdevice *device)
 {
     const size_t count{AmbiChannelsFromOrder(device->mAmbiOrder)};
-    slot->MixBuffer.resize(count);
-    slot->MixBuffer.shrink_to_fit();
 
     auto acnmap_end = AmbiIndex::From3D.begin() + count;
     auto iter = std::transform(AmbiIndex::From3D.begin(), acnmap_end, slot->Wet.AmbiMap.begin(),
@@ -981,6 +1238,17 @@ void aluInitEffectPanning(ALeffectslot *slot, ALCdevice *device)
         { return BFChannelConfig{1.0f, acn}; }
     );
     std::fill(iter, slot->Wet.AmbiMap.end(), BFChannelConfig{});
-    slot->Wet.Buffer = &reinterpret_cast<ALfloat(&)[BUFFERSIZE]>(slot->MixBuffer[0]);
-    slot->Wet.NumChannels = static_cast<ALsizei>(count);
+    slot->Wet.NumChannels = GetEffectSlotInputChannels(slot->Params.mFactory, device);
+    slot->Wet.Touched = &slot->WetTouched;
+    slot->WetTouched = 0u;
+
+    /* A slot that already has a buffer needs one sized for the device's
+     * current channel count. The device's pool will have been reset for it.
+     */
+    if(slot->Wet.Buffer)
+    {
+        al_free(slot->Wet.Buffer);
+        slot->Wet.Buffer = nullptr;
+        AllocEffectSlotBuffer(slot, device);
+    }
 }
@@ -51,7 +51,8 @@ RingBufferPtr CreateRingBuffer(size_t sz, size_t elem_sz, int limit_writes)
     ++power_of_two;
     if(power_of_two < sz) return nullptr;
 
-    RingBufferPtr rb{new (al_malloc(16, sizeof(*rb) + power_of_two*elem_sz)) RingBuffer{}};
+    RingBufferPtr rb{new (al_malloc(alignof(RingBuffer), sizeof(*rb) + power_of_two*elem_sz))
+        RingBuffer{}};
     rb->mWriteSize = limit_writes ? sz : (power_of_two-1);
     rb->mSizeMask = power_of_two - 1;
     rb->mElemSize = elem_sz;
@@ -63,6 +64,8 @@ void RingBuffer::reset() noexcept
 {
     mWritePtr.store(0, std::memory_order_relaxed);
     mReadPtr.store(0, std::memory_order_relaxed);
+    mCachedReadPtr = 0;
+    mCachedWritePtr = 0;
     std::fill_n(mBuffer, (mSizeMask+1)*mElemSize, 0);
 }
 
@@ -82,13 +85,42 @@ size_t RingBuffer::writeSpace() const noexcept
 }
 
 
+size_t RingBuffer::readSpaceCached(size_t cnt) const noexcept
+{
+    const size_t r{mReadPtr.load(std::memory_order_relaxed)};
+    /* The cached write pointer is stale if the read pointer was advanced past
+     * it, which shows up as a count larger than the buffer.
+     */
+    size_t avail{mCachedWritePtr - r};
+    if(avail < cnt || avail > mSizeMask)
+    {
+        mCachedWritePtr = mWritePtr.load(std::memory_order_acquire);
+        avail = mCachedWritePtr - r;
+    }
+    return avail;
+}
+
+size_t RingBuffer::writeSpaceCached(size_t cnt) const noexcept
+{
+    const size_t w{mWritePtr.load(std::memory_order_relaxed)};
+    size_t avail{mCachedReadPtr + mWriteSize - w};
+    if(avail < cnt || avail > mWriteSize)
+    {
+        mCachedReadPtr = mReadPtr.load(std::memory_order_acquire);
+        avail = mCachedReadPtr + mWriteSize - w;
+    }
+    return avail;
+}
+
+
 size_t RingBuffer::read(void *dest, size_t cnt) noexcept
 {
-    const size_t free_cnt{readSpace()};
+    const size_t free_cnt{readSpaceCached(cnt)};
     if(free_cnt == 0) return 0;
 
     const size_t to_read{std::min(cnt, free_cnt)};
-    size_t read_ptr{mReadPtr.load(std::memory_order_relaxed) & mSizeMask};
+    const size_t start_ptr{mReadPtr.load(std::memory_order_relaxed)};
+    size_t read_ptr{start_ptr & mSizeMask};
 
     size_t n1, n2;
     const size_t cnt2{read_ptr + to_read};
@@ -104,13 +136,9 @@ size_t RingBuffer::read(void *dest, size_t cnt) noexcept
     }
 
     memcpy(dest, mBuffer + read_ptr*mElemSize, n1*mElemSize);
-    read_ptr += n1;
     if(n2 > 0)
-    {
         memcpy(static_cast<char*>(dest) + n1*mElemSize, mBuffer, n2*mElemSize);
-        read_ptr += n2;
-    }
-    mReadPtr.store(read_ptr, std::memory_order_release);
+    mReadPtr.store(start_ptr + to_read, std::memory_order_release);
     return to_read;
 }
 
@@ -143,11 +171,12 @@ size_t RingBuffer::peek(void *dest, size_t cnt) const noexcept
 
 size_t RingBuffer::write(const void *src, size_t cnt) noexcept
 {
-    const size_t free_cnt{writeSpace()};
+    const size_t free_cnt{writeSpaceCached(cnt)};
     if(free_cnt == 0) return 0;
 
     const size_t to_write{std::min(cnt, free_cnt)};
-    size_t write_ptr{mWritePtr.load(std::memory_order_relaxed) & mSizeMask};
+    const size_t start_ptr{mWritePtr.load(std::memory_order_relaxed)};
+    size_t write_ptr{start_ptr & mSizeMask};
 
     size_t n1, n2;
     const size_t cnt2{write_ptr + to_write};
@@ -163,25 +192,26 @@ size_t RingBuffer::write(const void *src, size_t cnt) noexcept
     }
 
     memcpy(mBuffer + write_ptr*mElemSize, src, n1*mElemSize);
-    write_ptr += n1;
     if(n2 > 0)
-    {
         memcpy(mBuffer, static_cast<const char*>(src) + n1*mElemSize, n2*mElemSize);
-        write_ptr += n2;
-    }
-    mWritePtr.store(write_ptr, std::memory_order_release);
+    mWritePtr.store(start_ptr + to_write, std::memory_order_release);
     return to_write;
 }
 
 
+/* Only the consumer modifies the read pointer and only the producer modifies
+ * the write pointer, so these don't need an atomic read-modify-write.
+ */
 void RingBuffer::readAdvance(size_t cnt) noexcept
 {
-    mReadPtr.fetch_add(cnt, std::memory_order_acq_rel);
+    const size_t r{mReadPtr.load(std::memory_order_relaxed)};
+    mReadPtr.store(r+cnt, std::memory_order_release);
 }
 
 void RingBuffer::writeAdvance(size_t cnt) noexcept
 {
-    mWritePtr.fetch_add(cnt, std::memory_order_acq_rel);
+    const size_t w{mWritePtr.load(std::memory_order_relaxed)};
+    mWritePtr.store(w+cnt, std::memory_order_release);
 }
 
 
@@ -191,6 +221,7 @@ ll_ringbuffer_data_pair RingBuffer::getReadVector() const noexcept
 
     size_t w{mWritePtr.load(std::memory_order_acquire)};
     size_t r{mReadPtr.load(std::memory_order_acquire)};
+    mCachedWritePtr = w;
     w &= mSizeMask;
     r &= mSizeMask;
     const size_t free_cnt{(w-r) & mSizeMask};
@@ -222,7 +253,9 @@ ll_ringbuffer_data_pair RingBuffer::getWriteVector() const noexcept
     ll_ringbuffer_data_pair ret;
 
     size_t w{mWritePtr.load(std::memory_order_acquire)};
-    size_t r{mReadPtr.load(std::memory_order_acquire) + mWriteSize - mSizeMask};
+    size_t r{mReadPtr.load(std::memory_order_acquire)};
+    mCachedReadPtr = r;
+    r += mWriteSize - mSizeMask;
     w &= mSizeMask;
     r &= mSizeMask;
     const size_t free_cnt{(r-w-1) & mSizeMask};
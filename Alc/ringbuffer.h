@@ -23,10 +23,24 @@ struct ll_ringbuffer_data {
 using ll_ringbuffer_data_pair = std::pair<ll_ringbuffer_data,ll_ringbuffer_data>;
 
 
+/* Assumed cache line size, used to keep the producer's and consumer's data
+ * from sharing a line.
+ */
+#define RB_CACHE_LINE_SIZE 64
+
 struct RingBuffer {
-    std::atomic<size_t> mWritePtr{0u};
-    std::atomic<size_t> mReadPtr{0u};
-    size_t mWriteSize{0u};
+    /* The read and write pointers are free-running counters, only masked when
+     * indexing the buffer. Each is kept on its own cache line along with the
+     * owning side's last-seen copy of the other pointer, so the producer and
+     * consumer only touch each other's line when the cached value runs out.
+     */
+    alignas(RB_CACHE_LINE_SIZE) std::atomic<size_t> mWritePtr{0u};
+    mutable size_t mCachedReadPtr{0u};
+
+    alignas(RB_CACHE_LINE_SIZE) std::atomic<size_t> mReadPtr{0u};
+    mutable size_t mCachedWritePtr{0u};
+
+    alignas(RB_CACHE_LINE_SIZE) size_t mWriteSize{0u};
     size_t mSizeMask{0u};
     size_t mElemSize{0u};
 
@@ -53,6 +67,12 @@ struct RingBuffer {
      * of elements in front of the read pointer and behind the write pointer.
      */
     size_t readSpace() const noexcept;
+    /**
+     * Return the number of elements available for reading, only reloading the
+     * write pointer if the cached copy shows fewer than `cnt'. Must only be
+     * called by the consumer.
+     */
+    size_t readSpaceCached(size_t cnt) const noexcept;
     /**
      * The copying data reader. Copy at most `cnt' elements into `dest'.
      * Returns the actual number of elements copied.
@@ -71,6 +91,12 @@ struct RingBuffer {
      * of elements in front of the write pointer and behind the read pointer.
      */
     size_t writeSpace() const noexcept;
+    /**
+     * Return the number of elements available for writing, only reloading the
+     * read pointer if the cached copy shows fewer than `cnt'. Must only be
+     * called by the producer.
+     */
+    size_t writeSpaceCached(size_t cnt) const noexcept;
     /**
      * The copying data writer. Copy at most `cnt' elements from `src'. Returns
      * the actual number of elements copied.
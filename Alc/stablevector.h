@@ -0,0 +1,174 @@
+#ifndef AL_STABLEVECTOR_H
+#define AL_STABLEVECTOR_H
+
+#include <stddef.h>
+
+#include <algorithm>
+#include <atomic>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <utility>
+
+#include "almalloc.h"
+#include "vector.h"
+
+namespace al {
+
+/* An append-only vector whose elements never move, so that an element may be
+ * looked up by index from any thread without holding the lock that guards
+ * adding and removing them. Only lookup() is safe to call concurrently; all
+ * other methods need the owner's lock.
+ *
+ * Each element is allocated separately, and the array of pointers to them is
+ * replaced by a larger copy when it fills up. Replaced arrays are retired
+ * rather than freed, since a reader may still be looking in one, and they're
+ * only freed along with the container (their total size is less than that of
+ * the current array).
+ */
+template<typename T>
+class stable_vector {
+    template<typename U>
+    class iter_t {
+        T *const *mPtr{nullptr};
+
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = T;
+        using difference_type = ptrdiff_t;
+        using pointer = U*;
+        using reference = U&;
+
+        iter_t() noexcept = default;
+        explicit iter_t(T *const *ptr) noexcept : mPtr{ptr} { }
+        template<typename V>
+        iter_t(const iter_t<V> &rhs) noexcept : mPtr{rhs.base()} { }
+
+        T *const *base() const noexcept { return mPtr; }
+
+        reference operator*() const noexcept { return **mPtr; }
+        pointer operator->() const noexcept { return *mPtr; }
+        reference operator[](difference_type n) const noexcept { return *mPtr[n]; }
+
+        iter_t& operator++() noexcept { ++mPtr; return *this; }
+        iter_t& operator--() noexcept { --mPtr; return *this; }
+        iter_t operator++(int) noexcept { iter_t ret{*this}; ++mPtr; return ret; }
+        iter_t operator--(int) noexcept { iter_t ret{*this}; --mPtr; return ret; }
+        iter_t& operator+=(difference_type n) noexcept { mPtr += n; return *this; }
+        iter_t& operator-=(difference_type n) noexcept { mPtr -= n; return *this; }
+        iter_t operator+(difference_type n) const noexcept { return iter_t{mPtr + n}; }
+        iter_t operator-(difference_type n) const noexcept { return iter_t{mPtr - n}; }
+        friend iter_t operator+(difference_type n, const iter_t &rhs) noexcept
+        { return iter_t{rhs.mPtr + n}; }
+        difference_type operator-(const iter_t &rhs) const noexcept { return mPtr - rhs.mPtr; }
+
+        bool operator==(const iter_t &rhs) const noexcept { return mPtr == rhs.mPtr; }
+        bool operator!=(const iter_t &rhs) const noexcept { return mPtr != rhs.mPtr; }
+        bool operator<(const iter_t &rhs) const noexcept { return mPtr < rhs.mPtr; }
+        bool operator>(const iter_t &rhs) const noexcept { return mPtr > rhs.mPtr; }
+        bool operator<=(const iter_t &rhs) const noexcept { return mPtr <= rhs.mPtr; }
+        bool operator>=(const iter_t &rhs) const noexcept { return mPtr >= rhs.mPtr; }
+    };
+
+    al::vector<std::unique_ptr<T*[]>> mArrays;
+    std::atomic<T**> mEntries{nullptr};
+    std::atomic<size_t> mSize{0u};
+    size_t mCapacity{0u};
+
+    T **entries() const noexcept { return mEntries.load(std::memory_order_relaxed); }
+
+public:
+    using value_type = T;
+    using size_type = size_t;
+    using reference = T&;
+    using const_reference = const T&;
+    using iterator = iter_t<T>;
+    using const_iterator = iter_t<const T>;
+
+    stable_vector() noexcept = default;
+    stable_vector(const stable_vector&) = delete;
+    ~stable_vector() { clear(); }
+
+    stable_vector& operator=(const stable_vector&) = delete;
+
+    size_t size() const noexcept { return mSize.load(std::memory_order_relaxed); }
+    bool empty() const noexcept { return size() == 0; }
+
+    T& operator[](size_t idx) noexcept { return *entries()[idx]; }
+    const T& operator[](size_t idx) const noexcept { return *entries()[idx]; }
+
+    iterator begin() noexcept { return iterator{entries()}; }
+    iterator end() noexcept { return iterator{entries() + size()}; }
+    const_iterator begin() const noexcept { return const_iterator{entries()}; }
+    const_iterator end() const noexcept { return const_iterator{entries() + size()}; }
+    const_iterator cbegin() const noexcept { return begin(); }
+    const_iterator cend() const noexcept { return end(); }
+
+    /* Returns the element at idx, or nullptr if there isn't one. Safe to call
+     * without the owner's lock. The element is only published once it's fully
+     * constructed, and the array holding it is published before that.
+     */
+    T *lookup(size_t idx) const noexcept
+    {
+        if(idx >= mSize.load(std::memory_order_acquire))
+            return nullptr;
+        return mEntries.load(std::memory_order_acquire)[idx];
+    }
+
+    template<typename ...Args>
+    T& emplace_back(Args&& ...args)
+    {
+        const size_t count{size()};
+        if(count == mCapacity)
+        {
+            const size_t newcap{mCapacity ? mCapacity*2 : 4};
+            std::unique_ptr<T*[]> newarr{new T*[newcap]};
+            std::copy_n(entries(), count, newarr.get());
+            std::fill_n(newarr.get()+count, newcap-count, nullptr);
+            mArrays.emplace_back(std::move(newarr));
+            mEntries.store(mArrays.back().get(), std::memory_order_release);
+            mCapacity = newcap;
+        }
+        T **arr{entries()};
+        if(!arr[count])
+            arr[count] = new T{std::forward<Args>(args)...};
+        else
+        {
+            arr[count]->~T();
+            new (arr[count]) T{std::forward<Args>(args)...};
+        }
+        mSize.store(count+1, std::memory_order_release);
+        return *arr[count];
+    }
+
+    /* Removes the last element. It's kept allocated since a reader may still
+     * be looking at it, and is reset to a default-constructed state until it's
+     * reused by the next emplace_back.
+     */
+    void pop_back()
+    {
+        const size_t count{size() - 1};
+        mSize.store(count, std::memory_order_release);
+        T *elem{entries()[count]};
+        elem->~T();
+        new (elem) T{};
+    }
+
+    void clear()
+    {
+        T **arr{entries()};
+        for(size_t i{mCapacity};i > 0;)
+        {
+            delete arr[--i];
+            arr[i] = nullptr;
+        }
+        mSize.store(0u, std::memory_order_relaxed);
+        mEntries.store(nullptr, std::memory_order_relaxed);
+        mArrays.clear();
+        mCapacity = 0;
+    }
+};
+
+} // namespace al
+
+#endif /* AL_STABLEVECTOR_H */
@@ -3,6 +3,13 @@
 
 #include "uhjfilter.h"
 
+#if defined(HAVE_SSE_INTRINSICS)
+#include <xmmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define HAVE_NEON_INTRINSICS
+#endif
+
 #include <algorithm>
 
 #include "alu.h"
@@ -14,31 +21,159 @@ namespace {
 #define MAX_UPDATE_SAMPLES  128
 
 
-constexpr ALfloat Filter1CoeffSqr[4] = {
-    0.479400865589f, 0.876218493539f, 0.976597589508f, 0.997499255936f
-};
-constexpr ALfloat Filter2CoeffSqr[4] = {
-    0.161758498368f, 0.733028932341f, 0.945349700329f, 0.990599156685f
+/* The all-pass coefficients for each section of the three filter chains, by
+ * [section][lane]. Filter1 is used for the Y and S paths, and Filter2 for the
+ * phase-shifted W and X mix of the D path.
+ */
+alignas(16) constexpr ALfloat AllPassCoeffSqr[4][4]{
+    { 0.479400865589f, 0.161758498368f, 0.479400865589f, 0.0f },
+    { 0.876218493539f, 0.733028932341f, 0.876218493539f, 0.0f },
+    { 0.976597589508f, 0.945349700329f, 0.976597589508f, 0.0f },
+    { 0.997499255936f, 0.990599156685f, 0.997499255936f, 0.0f }
 };
 
-void allpass_process(AllPassState *state, ALfloat *dst, const ALfloat *src, const ALfloat aa, ALsizei todo)
+/* Runs the three filter chains on one sample each, in lanes 0 to 2 of the
+ * given sample frame.
+ */
+inline void allpass_frame(ALfloat (&frame)[4], ALfloat (*z)[2][4])
 {
-    ALfloat z1{state->z[0]};
-    ALfloat z2{state->z[1]};
-    auto proc_sample = [aa,&z1,&z2](ALfloat input) noexcept -> ALfloat
+    for(size_t sec{0};sec < 4;++sec)
     {
-        ALfloat output = input*aa + z1;
-        z1 = z2; z2 = output*aa - input;
-        return output;
+        for(size_t l{0};l < 4;++l)
+        {
+            const ALfloat aa{AllPassCoeffSqr[sec][l]};
+            const ALfloat input{frame[l]};
+            const ALfloat output{input*aa + z[sec][0][l]};
+            z[sec][0][l] = z[sec][1][l];
+            z[sec][1][l] = output*aa - input;
+            frame[l] = output;
+        }
+    }
+}
+
+/* Runs the three filter chains over the Y, D, and S paths in place. */
+void allpass_process(ALfloat (*z)[2][4], ALfloat *RESTRICT y, ALfloat *RESTRICT d,
+    ALfloat *RESTRICT s, const ALsizei todo)
+{
+    ALsizei i{0};
+#if defined(HAVE_SSE_INTRINSICS)
+    /* Four samples of each path are loaded and transposed, so each vector
+     * holds one sample frame to pass through the four sections.
+     */
+    __m128 aa[4], z1[4], z2[4];
+    for(size_t sec{0};sec < 4;++sec)
+    {
+        aa[sec] = _mm_load_ps(AllPassCoeffSqr[sec]);
+        z1[sec] = _mm_load_ps(z[sec][0]);
+        z2[sec] = _mm_load_ps(z[sec][1]);
+    }
+    auto proc_frame = [&aa,&z1,&z2](__m128 input) noexcept -> __m128
+    {
+        for(size_t sec{0};sec < 4;++sec)
+        {
+            const __m128 output{_mm_add_ps(_mm_mul_ps(input, aa[sec]), z1[sec])};
+            z1[sec] = z2[sec];
+            z2[sec] = _mm_sub_ps(_mm_mul_ps(output, aa[sec]), input);
+            input = output;
+        }
+        return input;
     };
-    std::transform(src, src+todo, dst, proc_sample);
-    state->z[0] = z1;
-    state->z[1] = z2;
+    for(;todo-i >= 4;i += 4)
+    {
+        __m128 f0{_mm_load_ps(&y[i])};
+        __m128 f1{_mm_load_ps(&d[i])};
+        __m128 f2{_mm_load_ps(&s[i])};
+        __m128 f3{_mm_setzero_ps()};
+        _MM_TRANSPOSE4_PS(f0, f1, f2, f3);
+        f0 = proc_frame(f0);
+        f1 = proc_frame(f1);
+        f2 = proc_frame(f2);
+        f3 = proc_frame(f3);
+        _MM_TRANSPOSE4_PS(f0, f1, f2, f3);
+        _mm_store_ps(&y[i], f0);
+        _mm_store_ps(&d[i], f1);
+        _mm_store_ps(&s[i], f2);
+    }
+    for(size_t sec{0};sec < 4;++sec)
+    {
+        _mm_store_ps(z[sec][0], z1[sec]);
+        _mm_store_ps(z[sec][1], z2[sec]);
+    }
+
+#elif defined(HAVE_NEON_INTRINSICS)
+
+    float32x4_t aa[4], z1[4], z2[4];
+    for(size_t sec{0};sec < 4;++sec)
+    {
+        aa[sec] = vld1q_f32(AllPassCoeffSqr[sec]);
+        z1[sec] = vld1q_f32(z[sec][0]);
+        z2[sec] = vld1q_f32(z[sec][1]);
+    }
+    /* The multiplies and adds are kept separate (not fused), to give the
+     * same results as the scalar frames.
+     */
+    auto proc_frame = [&aa,&z1,&z2](float32x4_t input) noexcept -> float32x4_t
+    {
+        for(size_t sec{0};sec < 4;++sec)
+        {
+            const float32x4_t output{vaddq_f32(vmulq_f32(input, aa[sec]), z1[sec])};
+            z1[sec] = z2[sec];
+            z2[sec] = vsubq_f32(vmulq_f32(output, aa[sec]), input);
+            input = output;
+        }
+        return input;
+    };
+    for(;todo-i >= 4;i += 4)
+    {
+        /* Load each path's samples de-interleaved as sample frames. */
+        float32x4x4_t frames;
+        frames.val[0] = vld1q_f32(&y[i]);
+        frames.val[1] = vld1q_f32(&d[i]);
+        frames.val[2] = vld1q_f32(&s[i]);
+        frames.val[3] = vdupq_n_f32(0.0f);
+        alignas(16) ALfloat tmp[16];
+        vst4q_f32(tmp, frames);
+        for(size_t j{0};j < 4;++j)
+            vst1q_f32(&tmp[j*4], proc_frame(vld1q_f32(&tmp[j*4])));
+        frames = vld4q_f32(tmp);
+        vst1q_f32(&y[i], frames.val[0]);
+        vst1q_f32(&d[i], frames.val[1]);
+        vst1q_f32(&s[i], frames.val[2]);
+    }
+    for(size_t sec{0};sec < 4;++sec)
+    {
+        vst1q_f32(z[sec][0], z1[sec]);
+        vst1q_f32(z[sec][1], z2[sec]);
+    }
+#endif
+
+    for(;i < todo;++i)
+    {
+        ALfloat frame[4]{y[i], d[i], s[i], 0.0f};
+        allpass_frame(frame, z);
+        y[i] = frame[0];
+        d[i] = frame[1];
+        s[i] = frame[2];
+    }
 }
 
 } // namespace
 
 
+void HilbertAllPass::clear() noexcept
+{
+    for(auto &sec : mZ)
+    {
+        for(auto &z : sec)
+            std::fill(std::begin(z), std::end(z), 0.0f);
+    }
+}
+
+void HilbertAllPass::process(ALfloat *RESTRICT a, ALfloat *RESTRICT b, ALfloat *RESTRICT c,
+    const ALsizei todo)
+{ allpass_process(mZ, a, b, c, todo); }
+
+
 /* NOTE: There seems to be a bit of an inconsistency in how this encoding is
  * supposed to work. Some references, such as
  *
@@ -62,7 +197,8 @@ void allpass_process(AllPassState *state, ALfloat *dst, const ALfloat *src, cons
 void Uhj2Encoder::encode(ALfloat *LeftOut, ALfloat *RightOut, ALfloat (*InSamples)[BUFFERSIZE], const ALsizei SamplesToDo)
 {
     alignas(16) ALfloat D[MAX_UPDATE_SAMPLES], S[MAX_UPDATE_SAMPLES];
-    alignas(16) ALfloat temp[MAX_UPDATE_SAMPLES];
+    alignas(16) ALfloat tempY[MAX_UPDATE_SAMPLES], tempD[MAX_UPDATE_SAMPLES];
+    alignas(16) ALfloat tempS[MAX_UPDATE_SAMPLES];
 
     ASSUME(SamplesToDo > 0);
 
@@ -74,43 +210,33 @@ void Uhj2Encoder::encode(ALfloat *LeftOut, ALfloat *RightOut, ALfloat (*InSample
         /* D = 0.6554516*Y */
         const ALfloat *RESTRICT input{al::assume_aligned<16>(InSamples[2]+base)};
         for(ALsizei i{0};i < todo;i++)
-            temp[i] = 0.6554516f*input[i];
-        allpass_process(&mFilter1_Y[0], temp, temp, Filter1CoeffSqr[0], todo);
-        allpass_process(&mFilter1_Y[1], temp, temp, Filter1CoeffSqr[1], todo);
-        allpass_process(&mFilter1_Y[2], temp, temp, Filter1CoeffSqr[2], todo);
-        allpass_process(&mFilter1_Y[3], temp, temp, Filter1CoeffSqr[3], todo);
+            tempY[i] = 0.6554516f*input[i];
+        /* D += j(-0.3420201*W + 0.5098604*X) */
+        const ALfloat *RESTRICT input0{al::assume_aligned<16>(InSamples[0]+base)};
+        const ALfloat *RESTRICT input1{al::assume_aligned<16>(InSamples[1]+base)};
+        for(ALsizei i{0};i < todo;i++)
+            tempD[i] = -0.3420201f*input0[i] + 0.5098604f*input1[i];
+        /* S = 0.9396926*W + 0.1855740*X */
+        for(ALsizei i{0};i < todo;i++)
+            tempS[i] = 0.9396926f*input0[i] + 0.1855740f*input1[i];
+
+        mAllPass.process(tempY, tempD, tempS, todo);
+
         /* NOTE: Filter1 requires a 1 sample delay for the final output, so
          * take the last processed sample from the previous run as the first
          * output sample.
          */
         D[0] = mLastY;
         for(ALsizei i{1};i < todo;i++)
-            D[i] = temp[i-1];
-        mLastY = temp[todo-1];
-
-        /* D += j(-0.3420201*W + 0.5098604*X) */
-        const ALfloat *RESTRICT input0{al::assume_aligned<16>(InSamples[0]+base)};
-        const ALfloat *RESTRICT input1{al::assume_aligned<16>(InSamples[1]+base)};
+            D[i] = tempY[i-1];
+        mLastY = tempY[todo-1];
         for(ALsizei i{0};i < todo;i++)
-            temp[i] = -0.3420201f*input0[i] + 0.5098604f*input1[i];
-        allpass_process(&mFilter2_WX[0], temp, temp, Filter2CoeffSqr[0], todo);
-        allpass_process(&mFilter2_WX[1], temp, temp, Filter2CoeffSqr[1], todo);
-        allpass_process(&mFilter2_WX[2], temp, temp, Filter2CoeffSqr[2], todo);
-        allpass_process(&mFilter2_WX[3], temp, temp, Filter2CoeffSqr[3], todo);
-        for(ALsizei i{0};i < todo;i++)
-            D[i] += temp[i];
+            D[i] += tempD[i];
 
-        /* S = 0.9396926*W + 0.1855740*X */
-        for(ALsizei i{0};i < todo;i++)
-            temp[i] = 0.9396926f*input0[i] + 0.1855740f*input1[i];
-        allpass_process(&mFilter1_WX[0], temp, temp, Filter1CoeffSqr[0], todo);
-        allpass_process(&mFilter1_WX[1], temp, temp, Filter1CoeffSqr[1], todo);
-        allpass_process(&mFilter1_WX[2], temp, temp, Filter1CoeffSqr[2], todo);
-        allpass_process(&mFilter1_WX[3], temp, temp, Filter1CoeffSqr[3], todo);
         S[0] = mLastWX;
         for(ALsizei i{1};i < todo;i++)
-            S[i] = temp[i-1];
-        mLastWX = temp[todo-1];
+            S[i] = tempS[i-1];
+        mLastWX = tempS[todo-1];
 
         /* Left = (S + D)/2.0 */
         ALfloat *RESTRICT left = al::assume_aligned<16>(LeftOut+base);
@@ -7,10 +7,6 @@
 #include "almalloc.h"
 
 
-struct AllPassState {
-    ALfloat z[2]{0.0f, 0.0f};
-};
-
 /* Encoding 2-channel UHJ from B-Format is done as:
  *
  * S = 0.9396926*W + 0.1855740*X
@@ -36,10 +32,28 @@ struct AllPassState {
  * other inputs.
  */
 
+/* The filter chains of the Hilbert transform, also usable on their own for a
+ * wide-band phase shift. Three chains run together, each as a lane of a
+ * 4-element vector: Filter1 in the first and third, and Filter2 in the
+ * second (the last lane is unused). Filter2's output leads Filter1's, delayed
+ * by one sample, by 90 degrees.
+ */
+struct HilbertAllPass {
+    /* The all-pass state, stored by [section][z1/z2][lane]. */
+    alignas(16) ALfloat mZ[4][2][4]{};
+
+    void clear() noexcept;
+
+    /* Runs Filter1 over a and c, and Filter2 over b, in place. */
+    void process(ALfloat *RESTRICT a, ALfloat *RESTRICT b, ALfloat *RESTRICT c,
+        const ALsizei todo);
+};
+
 struct Uhj2Encoder {
-    AllPassState mFilter1_Y[4];
-    AllPassState mFilter2_WX[4];
-    AllPassState mFilter1_WX[4];
+    /* Filter1 on Y, Filter2 on the W and X mix, and Filter1 on the W and X
+     * mix.
+     */
+    HilbertAllPass mAllPass;
     ALfloat mLastY{0.0f}, mLastWX{0.0f};
 
     /* Encodes a 2-channel UHJ (stereo-compatible) signal from a B-Format input
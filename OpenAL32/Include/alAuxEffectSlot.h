@@ -13,6 +13,7 @@
 
 
 struct ALeffectslot;
+struct ALbuffer;
 
 
 using ALeffectslotArray = al::FlexArray<ALeffectslot*>;
@@ -22,12 +23,15 @@ struct ALeffectslotProps {
     ALfloat   Gain;
     ALboolean AuxSendAuto;
     ALeffectslot *Target;
+    ALenum Quality;
 
     ALenum Type;
     EffectProps Props;
 
     EffectState *State;
 
+    ALuint Batch;
+
     std::atomic<ALeffectslotProps*> next;
 };
 
@@ -36,6 +40,10 @@ struct ALeffectslot {
     ALfloat   Gain{1.0f};
     ALboolean AuxSendAuto{AL_TRUE};
     ALeffectslot *Target{nullptr};
+    /* Sample data used by the effect (e.g. a convolution response). */
+    ALbuffer *Buffer{nullptr};
+    /* Processing quality hint for effects that support it. */
+    ALenum Quality{AL_QUALITY_DEFAULT_SOFT};
 
     struct {
         ALenum Type{AL_EFFECT_NULL};
@@ -54,10 +62,12 @@ struct ALeffectslot {
         ALfloat   Gain{1.0f};
         ALboolean AuxSendAuto{AL_TRUE};
         ALeffectslot *Target{nullptr};
+        ALenum Quality{AL_QUALITY_DEFAULT_SOFT};
 
         ALenum EffectType{AL_EFFECT_NULL};
         EffectProps mEffectProps{};
         EffectState *mEffectState{nullptr};
+        EffectStateFactory *mFactory{nullptr};
 
         ALfloat RoomRolloff{0.0f}; /* Added to the source's room rolloff, not multiplied. */
         ALfloat DecayTime{0.0f};
@@ -65,20 +75,31 @@ struct ALeffectslot {
         ALfloat DecayHFRatio{0.0f};
         ALboolean DecayHFLimit{AL_FALSE};
         ALfloat AirAbsorptionGainHF{1.0f};
+
+        /* Number of samples the input has been silent for. */
+        ALuint IdleSamples{0u};
     } Params;
 
+    /* Time spent in the effect's process call, for each quantum it wasn't
+     * idle.
+     */
+    ProcessTimeStats ProcessTime;
+
     /* Self ID */
     ALuint id{};
 
-    /* Mixing buffer used by the Wet mix. */
-    al::vector<std::array<ALfloat,BUFFERSIZE>,16> MixBuffer;
-
     /* Wet buffer configuration is ACN channel order with N3D scaling.
      * Consequently, effects that only want to work with mono input can use
      * channel 0 by itself. Effects that want multichannel can process the
      * ambisonics signal and make a B-Format source pan.
+     *
+     * The buffer comes from the device's pool, and is null until the slot
+     * gets an effect or becomes another slot's target. Once set, it's kept
+     * until the slot is deleted.
      */
     MixParams Wet;
+    /* Wet channels written this update, cleared after the effects run. */
+    ChannelMask WetTouched{0u};
 
     ALeffectslot() { PropsClean.test_and_set(std::memory_order_relaxed); }
     ALeffectslot(const ALeffectslot&) = delete;
@@ -91,6 +112,26 @@ struct ALeffectslot {
 };
 
 ALenum InitEffectSlot(ALeffectslot *slot);
+/* The number of wet buffer channels sends to the slot mix to, for the given
+ * effect's factory. Effects that only use mono input just get the W channel.
+ */
+inline ALsizei GetEffectSlotInputChannels(const EffectStateFactory *factory,
+    const ALCdevice *device) noexcept
+{
+    if(factory && factory->monoInput())
+        return 1;
+    return static_cast<ALsizei>(AmbiChannelsFromOrder(device->mAmbiOrder));
+}
+/* Gives the slot a wet mixing buffer from the device's pool, if it doesn't
+ * have one. Throws std::bad_alloc if a new buffer can't be allocated.
+ */
+void AllocEffectSlotBuffer(ALeffectslot *slot, ALCdevice *device);
+/* Returns the slot's wet mixing buffer to the device's pool. */
+void FreeEffectSlotBuffer(ALeffectslot *slot, ALCdevice *device);
+/* Frees the device's pooled slot buffers, and sets the channel count for new
+ * ones.
+ */
+void ResetEffectSlotBuffers(ALCdevice *device, const ALsizei channels);
 void UpdateEffectSlotProps(ALeffectslot *slot, ALCcontext *context);
 void UpdateAllEffectSlotProps(ALCcontext *context);
 
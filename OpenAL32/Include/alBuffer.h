@@ -1,6 +1,8 @@
 #ifndef _AL_BUFFER_H_
 #define _AL_BUFFER_H_
 
+#include <cstdint>
+
 #include "AL/alc.h"
 #include "AL/al.h"
 #include "AL/alext.h"
@@ -8,6 +10,7 @@
 #include "inprogext.h"
 #include "atomic.h"
 #include "vector.h"
+#include "almalloc.h"
 
 
 /* User formats */
@@ -18,6 +21,8 @@ enum UserFmtType {
     UserFmtDouble,
     UserFmtMulaw,
     UserFmtAlaw,
+    UserFmtInt24,
+    UserFmtInt,
     UserFmtIMA4,
     UserFmtMSADPCM,
 };
@@ -47,6 +52,13 @@ enum FmtType {
     FmtDouble = UserFmtDouble,
     FmtMulaw  = UserFmtMulaw,
     FmtAlaw   = UserFmtAlaw,
+    FmtInt24  = UserFmtInt24,
+    FmtInt    = UserFmtInt,
+    /* ADPCM is stored compressed, in blocks of OriginalAlign sample frames,
+     * and decoded as it's mixed.
+     */
+    FmtIMA4    = UserFmtIMA4,
+    FmtMSADPCM = UserFmtMSADPCM,
 };
 enum FmtChannels {
     FmtMono   = UserFmtMono,
@@ -61,6 +73,13 @@ enum FmtChannels {
 };
 #define MAX_INPUT_CHANNELS  (8)
 
+/* A packed, little-endian, signed 24-bit sample. */
+struct ALbyte3 {
+    ALubyte lo, mid;
+    ALbyte hi;
+};
+static_assert(sizeof(ALbyte3) == 3, "ALbyte3 is not packed");
+
 /* DevFmtType traits, providing the type, etc given a DevFmtType. */
 template<FmtType T>
 struct FmtTypeTraits { };
@@ -77,44 +96,177 @@ template<>
 struct FmtTypeTraits<FmtMulaw> { using Type = ALubyte; };
 template<>
 struct FmtTypeTraits<FmtAlaw> { using Type = ALubyte; };
+template<>
+struct FmtTypeTraits<FmtInt24> { using Type = ALbyte3; };
+template<>
+struct FmtTypeTraits<FmtInt> { using Type = ALint; };
+
 
+struct ALbuffer;
 
+/* ADPCM types report the size of their decoded 16-bit samples. */
 ALsizei BytesFromFmt(FmtType type);
 ALsizei ChannelsFromFmt(FmtChannels chans);
 inline ALsizei FrameSizeFromFmt(FmtChannels chans, FmtType type)
 { return ChannelsFromFmt(chans) * BytesFromFmt(type); }
 
+inline bool IsADPCMFmt(FmtType type) noexcept
+{ return type == FmtIMA4 || type == FmtMSADPCM; }
+
+/* Decoder state for one channel of an ADPCM buffer. It holds the decoded
+ * sample at frame Pos, so decoding can resume from there instead of starting
+ * over at the beginning of the block.
+ */
+struct ADPCMState {
+    const ALbuffer *Buffer{nullptr};
+    int64_t Pos{0};
+    ALint Sample{0};
+    /* The sample before Pos (MSADPCM only). */
+    ALint Sample2{0};
+    /* The step index (IMA4), or the block predictor (MSADPCM). */
+    ALint Index{0};
+    /* The quantization delta (MSADPCM only). */
+    ALint Delta{0};
+};
+
+
+struct ResampleCache;
+
+/* Set in a buffer's ref count while the buffer is claimed, with BufferLock
+ * held, to be modified or deleted. Sources attach buffers without the lock by
+ * incrementing the count when this isn't set, and otherwise wait on the lock
+ * for the claim to end.
+ */
+constexpr unsigned int BUFFER_REF_CLAIMED{0x80000000u};
 
 struct ALbuffer {
     al::vector<ALbyte,16> mData;
 
+    /* App-owned storage used in place of mData, which is given back with the
+     * release callback once the buffer stops using it.
+     */
+    ALbyte *ExternalData{nullptr};
+    ALBUFFERRELEASETYPESOFT ExternalRelease{nullptr};
+    ALvoid *ExternalUserPtr{nullptr};
+    /* Nonzero for read-only, file-backed external storage, giving the number
+     * of sample frames to page in ahead of a playing voice.
+     */
+    ALsizei FileReadAhead{0};
+
     ALsizei Frequency{0};
     ALbitfieldSOFT Access{0u};
-    ALsizei SampleLen{0};
+    /* Sample frames and positions are 64-bit, since file-backed buffers can
+     * be larger than 32-bit sizes can hold.
+     */
+    int64_t SampleLen{0};
 
     FmtChannels mFmtChannels{};
     FmtType     mFmtType{};
     ALsizei BytesAlloc{0};
 
     UserFmtType OriginalType{};
-    ALsizei OriginalSize{0};
+    int64_t OriginalSize{0};
     ALsizei OriginalAlign{0};
 
-    ALsizei LoopStart{0};
-    ALsizei LoopEnd{0};
+    int64_t LoopStart{0};
+    int64_t LoopEnd{0};
+    /* Sample frames stored after the end, holding a copy of the samples from
+     * the loop start. While the loop ends at the end of the buffer, a voice
+     * can then load across the loop end in one run.
+     */
+    ALsizei LoopPadding{0};
+
+    /* Provides the samples as they're played, for buffers with no storage.
+     * With AL_CALLBACK_CONTINUOUS_BIT_SOFT, a short read is an underrun that
+     * plays as silence, and only a negative return ends the samples.
+     */
+    ALBUFFERCALLBACKTYPESOFT Callback{nullptr};
+    ALvoid *UserData{nullptr};
+    ALbitfieldSOFT CallbackFlags{0u};
+
+    /* A copy of the samples at the device's rate, if the app asked for one
+     * with AL_RESAMPLE_CACHE_SOFT (or the device caches every buffer). Guarded
+     * by the device's ResampleCacheLock.
+     */
+    ResampleCache *Resampled{nullptr};
+    ALboolean WantResampleCache{AL_FALSE};
 
     std::atomic<ALsizei> UnpackAlign{0};
     std::atomic<ALsizei> PackAlign{0};
 
-    ALbitfieldSOFT MappedAccess{0u};
+    /* Atomic since sources check it when attaching the buffer, which they do
+     * without BufferLock.
+     */
+    std::atomic<ALbitfieldSOFT> MappedAccess{0u};
     ALsizei MappedOffset{0};
     ALsizei MappedSize{0};
 
-    /* Number of times buffer was attached to a source (deletion can only occur when 0) */
-    RefCount ref{0u};
+    /* Number of times buffer was attached to a source (deletion can only occur
+     * when 0), or BUFFER_REF_CLAIMED while it's being modified or deleted. This
+     * is left alone when a buffer is constructed, so a source attaching a
+     * deleted buffer's ID can't race a constructor's store. AllocBuffer resets
+     * it once the new buffer is ready.
+     */
+    RefCount ref;
 
     /* Self ID */
     ALuint id{0};
+
+    ~ALbuffer();
+
+    ALbyte *samples() noexcept { return ExternalData ? ExternalData : mData.data(); }
+    const ALbyte *samples() const noexcept
+    { return ExternalData ? ExternalData : mData.data(); }
+};
+
+/* Hints that the given range of sample frames from a file-backed buffer will
+ * be played soon.
+ */
+void PrefetchBufferData(const ALbuffer *buffer, int64_t start, ALsizei count);
+
+
+struct ALbufferlistitem;
+
+/* A buffer's samples resampled to the device's rate, which static sources
+ * play instead of the buffer so a pitch of 1 mixes with a plain copy. Voices
+ * using it count their position in its sample frames.
+ */
+struct ResampleCache {
+    /* The resampled float samples, along with a one-item list holding it for
+     * the mixer.
+     */
+    ALbuffer Buffer;
+    ALbufferlistitem *Item{nullptr};
+
+    /* The buffer the cache was made from, or null once the buffer changed or
+     * went away. Frame f of the cache is at Owner's fixed-point position
+     * f*Increment.
+     */
+    ALbuffer *Owner{nullptr};
+    ALint Increment{0};
+
+    ~ResampleCache();
+
+    DEF_NEWDEL(ResampleCache)
 };
 
+/* Makes the buffer's resample cache for the device's current rate, if it
+ * wants one and doesn't have it. Resampling can take a while, so this should
+ * be called without the backend lock.
+ */
+void PrepareResampleCache(ALCdevice *device, ALbuffer *buffer);
+/* Returns the buffer's resample cache if it can be played on the device, and
+ * marks it as the most recently used. Must be called with the backend lock.
+ */
+ResampleCache *UseResampleCache(ALCdevice *device, ALbuffer *buffer);
+/* Stops the buffer from using its resample cache, after its samples changed.
+ * The cache is freed once no voices are playing it.
+ */
+void DetachResampleCache(ALCdevice *device, ALbuffer *buffer);
+/* Frees the least recently used resample caches to keep the device under its
+ * limit, as well as those no longer used by their buffers, skipping any still
+ * being played. Must be called with the backend lock.
+ */
+void TrimResampleCaches(ALCdevice *device);
+
 #endif
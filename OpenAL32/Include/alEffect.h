@@ -18,6 +18,8 @@ enum {
     FSHIFTER_EFFECT,
     MODULATOR_EFFECT,
     PSHIFTER_EFFECT,
+    CONVOLUTION_EFFECT,
+    REFLECTIONS_EFFECT,
     DEDICATED_EFFECT,
 
     MAX_EFFECTS
@@ -25,13 +27,18 @@ enum {
 extern ALboolean DisabledEffects[MAX_EFFECTS];
 
 extern ALfloat ReverbBoost;
+extern ALenum ReverbQuality;
+extern bool ReverbHalfRate;
+extern bool ReverbSizedLines;
+extern bool ChorusHalfRate;
+extern ALenum PshifterQuality;
 
 struct EffectList {
     const char name[16];
     int type;
     ALenum val;
 };
-extern const EffectList gEffectList[14];
+extern const EffectList gEffectList[16];
 
 
 struct ALeffect {
@@ -47,7 +54,10 @@ struct ALeffect {
 };
 
 inline ALboolean IsReverbEffect(ALenum type)
-{ return type == AL_EFFECT_REVERB || type == AL_EFFECT_EAXREVERB; }
+{
+    return type == AL_EFFECT_REVERB || type == AL_EFFECT_EAXREVERB ||
+        type == AL_EFFECT_EARLY_REFLECTIONS_SOFT;
+}
 
 EffectStateFactory *getFactoryByType(ALenum type);
 
@@ -4,6 +4,8 @@
 #include "AL/alc.h"
 #include "AL/al.h"
 
+#include "atomic.h"
+
 
 #define LOWPASSFREQREF  (5000.0f)
 #define HIGHPASSFREQREF  (250.0f)
@@ -39,6 +41,26 @@ struct ALfilter {
     ALfloat GainLF;
     ALfloat LFReference;
 
+    /* Whether sources link to the filter, instead of taking a copy of its
+     * properties when it's set on them.
+     */
+    ALboolean Linked;
+
+    /* Number of source filters linked to it. */
+    RefCount ref;
+
+    /* The properties the mixer applies to linked sources, set whenever a
+     * linked filter changes. They remain valid after the filter is deleted
+     * until the device is.
+     */
+    struct {
+        std::atomic<ALfloat> Gain;
+        std::atomic<ALfloat> GainHF;
+        std::atomic<ALfloat> HFReference;
+        std::atomic<ALfloat> GainLF;
+        std::atomic<ALfloat> LFReference;
+    } Params;
+
     const ALfilterVtable *vtab;
 
     /* Self ID */
@@ -12,6 +12,9 @@
 
 enum class DistanceModel;
 
+/* The most listeners a context can have, including its main listener. */
+#define MAX_LISTENERS 4
+
 
 struct ALlistenerProps {
     std::array<ALfloat,3> Position;
@@ -19,6 +22,9 @@ struct ALlistenerProps {
     std::array<ALfloat,3> OrientAt;
     std::array<ALfloat,3> OrientUp;
     ALfloat Gain;
+    ALint OutputChannel;
+
+    ALuint Batch;
 
     std::atomic<ALlistenerProps*> next;
 };
@@ -29,6 +35,11 @@ struct ALlistener {
     std::array<ALfloat,3> OrientAt{{0.0f, 0.0f, -1.0f}};
     std::array<ALfloat,3> OrientUp{{0.0f, 1.0f, 0.0f}};
     ALfloat Gain{1.0f};
+    /* The first of the pair of output channels another listener's mix is
+     * added to, or -1 if it's disabled. The main listener always mixes to the
+     * whole output.
+     */
+    ALint OutputChannel{-1};
 
     std::atomic_flag PropsClean;
 
@@ -37,10 +48,13 @@ struct ALlistener {
     std::atomic<ALlistenerProps*> Update{nullptr};
 
     struct {
-        alu::Matrix Matrix;
+        alu::Matrix Matrix{alu::Matrix::Identity()};
+        alu::Vector Position; /* Untransformed */
         alu::Vector Velocity;
+        alu::Vector WorldVelocity; /* Untransformed */
 
         ALfloat Gain;
+        ALint OutputChannel;
         ALfloat MetersPerUnit;
 
         ALfloat DopplerFactor;
@@ -54,6 +68,6 @@ struct ALlistener {
     ALlistener() { PropsClean.test_and_set(std::memory_order_relaxed); }
 };
 
-void UpdateListenerProps(ALCcontext *context);
+void UpdateListenerProps(ALCcontext *context, ALlistener &listener);
 
 #endif
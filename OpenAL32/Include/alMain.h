@@ -17,7 +17,9 @@
 #include <vector>
 #include <string>
 #include <chrono>
+#include <thread>
 #include <algorithm>
+#include <limits>
 
 #include "AL/al.h"
 #include "AL/alc.h"
@@ -26,11 +28,14 @@
 #include "inprogext.h"
 #include "atomic.h"
 #include "vector.h"
+#include "stablevector.h"
+#include "freemap.h"
 #include "almalloc.h"
 #include "alnumeric.h"
 #include "threads.h"
 #include "ambidefs.h"
 #include "hrtf.h"
+#include "alBuffer.h"
 
 
 template<typename T, size_t N>
@@ -67,6 +72,7 @@ struct HrtfEntry;
 struct HrtfHandle;
 struct EnumeratedHrtf;
 struct DirectHrtfState;
+struct HrtfCoeffCache;
 struct FrontStablizer;
 struct Compressor;
 struct BackendBase;
@@ -77,6 +83,10 @@ struct EffectState;
 struct Uhj2Encoder;
 class BFormatDec;
 class AmbiUpsampler;
+class MixerPool;
+struct VoiceMixLog;
+struct SampleConverter;
+struct OutputMirror;
 struct bs2b;
 
 
@@ -137,7 +147,11 @@ enum DevFmtType {
     DevFmtUInt   = ALC_UNSIGNED_INT_SOFT,
     DevFmtFloat  = ALC_FLOAT_SOFT,
 
+#ifdef ALSOFT_FIXED_TYPE
+    DevFmtTypeDefault = ALSOFT_FIXED_TYPE
+#else
     DevFmtTypeDefault = DevFmtFloat
+#endif
 };
 enum DevFmtChannels {
     DevFmtMono   = ALC_MONO_SOFT,
@@ -151,9 +165,14 @@ enum DevFmtChannels {
     /* Similar to 5.1, except using rear channels instead of sides */
     DevFmtX51Rear = 0x80000000,
 
+#ifdef ALSOFT_FIXED_CHANNELS
+    DevFmtChannelsDefault = ALSOFT_FIXED_CHANNELS
+#else
     DevFmtChannelsDefault = DevFmtStereo
+#endif
 };
-#define MAX_OUTPUT_CHANNELS  (16)
+/* Enough for a seventh-order ambisonic loopback device. */
+#define MAX_OUTPUT_CHANNELS  (64)
 
 /* DevFmtType traits, providing the type, etc given a DevFmtType. */
 template<DevFmtType T>
@@ -209,62 +228,99 @@ enum RenderMode {
     HrtfRender
 };
 
+/* Stages of the output fade around a reset that keeps the device running. */
+enum OutputFade : ALuint {
+    OutputFadeNone,
+    OutputFadeOut,
+    OutputFadeSilent,
+    OutputFadeIn
+};
+
+/* The output format asked of a backend, with the DEVICE_*_REQUEST flags for
+ * which parts it has to honor.
+ */
+struct DevFmtRequest {
+    ALuint Frequency{0u};
+    ALuint UpdateSize{0u};
+    ALuint BufferSize{0u};
+    DevFmtChannels FmtChans{};
+    DevFmtType FmtType{};
+    ALuint Flags{0u};
+};
+
+
+/* The buffer properties the alGetBuffer* functions return, copied out of the
+ * buffer under BufferLock whenever they change. They're kept with the sublist
+ * rather than the buffer, so the getters can read them without the lock while
+ * the buffer is respecified, deleted, or its slot reused. Seq is odd while an
+ * update is in progress.
+ */
+struct BufferInfo {
+    std::atomic<ALuint> Seq{0u};
+    std::atomic<ALint> Frequency{0};
+    std::atomic<ALint> Bits{0};
+    std::atomic<ALint> Channels{0};
+    std::atomic<ALint> Size{0};
+    std::atomic<ALint> LoopStart{0};
+    std::atomic<ALint> LoopEnd{0};
+    std::atomic<ALint> UnpackAlign{0};
+    std::atomic<ALint> PackAlign{0};
+    std::atomic<ALint> WantResampleCache{0};
+};
 
 struct BufferSubList {
-    uint64_t FreeMask{~0_u64};
+    std::atomic<uint64_t> FreeMask{~0_u64};
     ALbuffer *Buffers{nullptr}; /* 64 */
+    BufferInfo *Infos{nullptr}; /* 64 */
 
     BufferSubList() noexcept = default;
     BufferSubList(const BufferSubList&) = delete;
-    BufferSubList(BufferSubList&& rhs) noexcept : FreeMask{rhs.FreeMask}, Buffers{rhs.Buffers}
-    { rhs.FreeMask = ~0_u64; rhs.Buffers = nullptr; }
     ~BufferSubList();
 
     BufferSubList& operator=(const BufferSubList&) = delete;
-    BufferSubList& operator=(BufferSubList&& rhs) noexcept
-    { std::swap(FreeMask, rhs.FreeMask); std::swap(Buffers, rhs.Buffers); return *this; }
 };
 
 struct EffectSubList {
-    uint64_t FreeMask{~0_u64};
+    std::atomic<uint64_t> FreeMask{~0_u64};
     ALeffect *Effects{nullptr}; /* 64 */
 
     EffectSubList() noexcept = default;
     EffectSubList(const EffectSubList&) = delete;
-    EffectSubList(EffectSubList&& rhs) noexcept : FreeMask{rhs.FreeMask}, Effects{rhs.Effects}
-    { rhs.FreeMask = ~0_u64; rhs.Effects = nullptr; }
     ~EffectSubList();
 
     EffectSubList& operator=(const EffectSubList&) = delete;
-    EffectSubList& operator=(EffectSubList&& rhs) noexcept
-    { std::swap(FreeMask, rhs.FreeMask); std::swap(Effects, rhs.Effects); return *this; }
 };
 
 struct FilterSubList {
-    uint64_t FreeMask{~0_u64};
+    std::atomic<uint64_t> FreeMask{~0_u64};
     ALfilter *Filters{nullptr}; /* 64 */
 
     FilterSubList() noexcept = default;
     FilterSubList(const FilterSubList&) = delete;
-    FilterSubList(FilterSubList&& rhs) noexcept : FreeMask{rhs.FreeMask}, Filters{rhs.Filters}
-    { rhs.FreeMask = ~0_u64; rhs.Filters = nullptr; }
     ~FilterSubList();
 
     FilterSubList& operator=(const FilterSubList&) = delete;
-    FilterSubList& operator=(FilterSubList&& rhs) noexcept
-    { std::swap(FreeMask, rhs.FreeMask); std::swap(Filters, rhs.Filters); return *this; }
 };
 
 
 /* Maximum delay in samples for speaker distance compensation. */
 #define MAX_DELAY_LENGTH 1024
 
+/* Number of independent random number generators for dithering, so it can
+ * be done a vector at a time.
+ */
+#define DITHER_RNG_LANES 4
+
 class DistanceComp {
 public:
     struct DistData {
         ALfloat Gain{1.0f};
         ALsizei Length{0}; /* Valid range is [0...MAX_DELAY_LENGTH). */
+        /* Length samples of delay history, used as a ring buffer with Pos at
+         * the oldest sample.
+         */
         ALfloat *Buffer{nullptr};
+        ALsizei Pos{0};
     };
 
 private:
@@ -281,6 +337,7 @@ public:
             chan.Gain = 1.0f;
             chan.Length = 0;
             chan.Buffer = nullptr;
+            chan.Pos = 0;
         }
         mSamples.clear();
     }
@@ -311,18 +368,64 @@ struct BFChannelConfig {
  */
 #define BUFFERSIZE 1024
 
+/* Smallest number of samples a device can be configured to mix per iteration.
+ */
+#define MIN_MIX_QUANTUM 16
+
+/* The most sample points any of the bsinc tables use. This includes the
+ * doubling for downsampling, so bsinc32 needs 64. Must be the same as in
+ * bsincgen!
+ */
+#define BSINC_POINTS_MAX 64
+
 /* Maximum number of samples to pad on either end of a buffer for resampling.
  * Note that both the beginning and end need padding!
  */
-#define MAX_RESAMPLE_PADDING 24
+#define MAX_RESAMPLE_PADDING (BSINC_POINTS_MAX/2)
+
 
+/* Bit mask of a mixing buffer's channels that were written since the buffer
+ * was last cleared. Channels without their bit set are known to be silent, so
+ * they don't need clearing again, and consumers may skip them.
+ */
+using ChannelMask = uint64_t;
+static_assert(MAX_OUTPUT_CHANNELS <= sizeof(ChannelMask)*8, "ChannelMask too small");
+
+inline ChannelMask ChannelMaskFor(const ALsizei count) noexcept
+{
+    return (count >= static_cast<ALsizei>(sizeof(ChannelMask)*8)) ? ~ChannelMask{0u} :
+        ((ChannelMask{1u}<<count) - 1u);
+}
+
+inline void MarkChannels(ChannelMask *touched, const ALsizei count) noexcept
+{
+    if(touched) *touched |= ChannelMaskFor(count);
+}
+
+/* Clears the written channels of the buffer and resets its mask. */
+void ClearTouchedChannels(ALfloat (*Buffer)[BUFFERSIZE], ChannelMask *touched,
+    const ALsizei SamplesToDo);
+
+/* A built-in speaker decoder folded into the panning gains, so sounds are
+ * mixed straight to the output speakers. Each output has a row of decoder
+ * coefficients for the first NumCoeffs channels of the mix's AmbiMap.
+ */
+struct SpeakerPanMatrix {
+    ALsizei NumCoeffs{0};
+    ALfloat Rows[MAX_OUTPUT_CHANNELS][MAX_AMBI2D_CHANNELS]{};
+};
 
 struct MixParams {
     /* Coefficient channel mapping for mixing to the buffer. */
     std::array<BFChannelConfig,MAX_OUTPUT_CHANNELS> AmbiMap;
+    /* When set, the buffer's channels are the output speakers and AmbiMap
+     * describes the ambisonic channels decoded through this matrix.
+     */
+    const SpeakerPanMatrix *PanMatrix{nullptr};
 
     ALfloat (*Buffer)[BUFFERSIZE]{nullptr};
     ALsizei NumChannels{0};
+    ChannelMask *Touched{nullptr};
 };
 
 struct RealMixParams {
@@ -330,6 +433,135 @@ struct RealMixParams {
 
     ALfloat (*Buffer)[BUFFERSIZE]{nullptr};
     ALsizei NumChannels{0};
+    ChannelMask *Touched{nullptr};
+};
+
+/* Temp storage used for mixing voices. Each thread that mixes voices needs its
+ * own set.
+ */
+/* Times (in nanoseconds) and counts gathered by one mixing thread over an
+ * update. They're kept with the thread's scratch storage, so the thread can
+ * add to them without atomics, and the device's mixer thread collects them
+ * into the device's MixerStats after each update.
+ */
+struct MixerThreadStats {
+    enum VoiceType { PlainVoice, HrtfVoice, AmbiVoice, VoiceTypeCount };
+
+    uint64_t ParamTime{0u};
+    uint64_t VoiceTime[VoiceTypeCount]{};
+    uint64_t EffectTime{0u};
+    uint64_t VoicesMixed{0u};
+    uint64_t VoicesSkipped{0u};
+};
+
+struct MixerScratch {
+    /* One row per input channel, so a multi-channel resampler and filter can
+     * handle all of a voice's channels together. Otherwise only the first is
+     * used.
+     */
+    alignas(16) ALfloat SourceData[MAX_INPUT_CHANNELS][BUFFERSIZE + MAX_RESAMPLE_PADDING*2];
+    alignas(16) ALfloat ResampledData[MAX_INPUT_CHANNELS][BUFFERSIZE];
+    alignas(16) ALfloat FilteredData[MAX_INPUT_CHANNELS][BUFFERSIZE];
+    union {
+        alignas(16) ALfloat HrtfSourceData[BUFFERSIZE + HRTF_HISTORY_LENGTH];
+        /* One row per NFC filter order, from first to fourth. */
+        alignas(16) ALfloat NfcSampleData[4][BUFFERSIZE];
+    };
+    alignas(16) float2 HrtfAccumData[BUFFERSIZE + HRIR_LENGTH];
+
+    MixerThreadStats Stats;
+
+    /* When set, voices mixed with this scratch storage record their writes to
+     * the outputs here instead of making them.
+     */
+    VoiceMixLog *Log{nullptr};
+
+    DEF_NEWDEL(MixerScratch)
+};
+
+/* Accumulated processing times, in nanoseconds per mixed quantum. Only one
+ * thread adds to it at a time, while the app may read it at any time, so the
+ * values are not guaranteed to be consistent with each other.
+ */
+struct ProcessTimeStats {
+    std::atomic<uint64_t> Total{0u};
+    std::atomic<uint64_t> Count{0u};
+    std::atomic<uint64_t> Min{std::numeric_limits<uint64_t>::max()};
+    std::atomic<uint64_t> Max{0u};
+
+    void add(const uint64_t ns) noexcept
+    {
+        Total.store(Total.load(std::memory_order_relaxed)+ns, std::memory_order_relaxed);
+        Count.store(Count.load(std::memory_order_relaxed)+1, std::memory_order_relaxed);
+        if(ns < Min.load(std::memory_order_relaxed))
+            Min.store(ns, std::memory_order_relaxed);
+        if(ns > Max.load(std::memory_order_relaxed))
+            Max.store(ns, std::memory_order_relaxed);
+    }
+
+    /* Gets the minimum, average, and maximum times. All 0 if nothing was
+     * processed yet.
+     */
+    void get(ALfloat *values) const noexcept
+    {
+        const uint64_t count{Count.load(std::memory_order_relaxed)};
+        if(count == 0)
+        {
+            std::fill_n(values, 3, 0.0f);
+            return;
+        }
+        values[0] = static_cast<ALfloat>(Min.load(std::memory_order_relaxed));
+        values[1] = static_cast<ALfloat>(Total.load(std::memory_order_relaxed)) /
+            static_cast<ALfloat>(count);
+        values[2] = static_cast<ALfloat>(Max.load(std::memory_order_relaxed));
+    }
+};
+
+/* A mixer statistic's accumulated total, and its value for the last update.
+ * Only the mixer thread adds to it, while the app may read it at any time.
+ */
+struct MixerStat {
+    std::atomic<uint64_t> Total{0u};
+    std::atomic<uint64_t> Last{0u};
+
+    void add(const uint64_t val) noexcept
+    {
+        Total.store(Total.load(std::memory_order_relaxed)+val, std::memory_order_relaxed);
+        Last.store(val, std::memory_order_relaxed);
+    }
+};
+
+/* Where the device's mixer spends its time, for ALC_SOFT_mixer_stats. Times
+ * are in nanoseconds, with those of the voices and effects summed over the
+ * threads mixing them. The times are only measured with MixerStatsEnabled, or
+ * while a context is listening for performance events.
+ */
+struct MixerStats {
+    MixerStat ParamTime;
+    MixerStat VoiceTime;
+    MixerStat VoiceTypeTime[MixerThreadStats::VoiceTypeCount];
+    MixerStat EffectTime;
+    MixerStat PostProcessTime;
+    MixerStat OutputTime;
+    MixerStat UpdateTime;
+    MixerStat VoicesMixed;
+    MixerStat VoicesSkipped;
+
+    /* The longest update, and the length of its samples at the mixing rate. */
+    std::atomic<uint64_t> PeakUpdateTime{0u};
+    std::atomic<uint64_t> PeakUpdatePeriod{0u};
+
+    /* The number of updates, and those that took longer than their samples
+     * last.
+     */
+    std::atomic<uint64_t> Updates{0u};
+    std::atomic<uint64_t> LateUpdates{0u};
+
+    /* When the current update started, and when its post-process was done.
+     * Only used by the mixer thread.
+     */
+    std::chrono::steady_clock::time_point UpdateStart;
+    std::chrono::steady_clock::time_point PostProcessEnd;
 };
 
 using POSTPROCESS = void(*)(ALCdevice *device, const ALsizei SamplesToDo);
@@ -341,9 +573,18 @@ struct ALCdevice {
     const DeviceType Type{};
 
     ALuint Frequency{};
+    /* Rate voices and effects are mixed at. Normally the same as Frequency,
+     * but may be lower with the mix upsampled to Frequency for output.
+     */
+    ALuint MixFrequency{};
     ALuint UpdateSize{};
     ALuint BufferSize{};
 
+    /* Maximum number of samples mixed per iteration. Never more than
+     * BUFFERSIZE, which sets the size of the temporary mixing storage.
+     */
+    ALsizei MixQuantum{BUFFERSIZE};
+
     DevFmtChannels FmtChans{};
     DevFmtType     FmtType{};
     ALboolean IsHeadphones{AL_FALSE};
@@ -361,6 +602,13 @@ struct ALCdevice {
     // Device flags
     ALuint Flags{0u};
 
+    /* Capture callback set by the app, called from the backend's capture
+     * thread with each period of captured audio. Only changed while capture
+     * is stopped.
+     */
+    ALCCAPTUREPROCSOFT CaptureCallback{nullptr};
+    void *CaptureUserPtr{nullptr};
+
     std::string HrtfName;
     al::vector<EnumeratedHrtf> HrtfList;
     ALCenum HrtfStatus{ALC_FALSE};
@@ -376,17 +624,113 @@ struct ALCdevice {
     ALCuint NumStereoSources{};
     ALsizei NumAuxSends{};
 
+    // Maximum number of voices each context mixes at once (0 = unlimited)
+    ALsizei VoiceBudget{0};
+
+    /* Size of the direction buckets that nearby mono voices are clustered in,
+     * in radians (0 = no clustering).
+     */
+    ALfloat ClusterAngle{0.0f};
+
+    /* Whether contexts pan voices in world space and rotate their mix to the
+     * listener's orientation, when the dry mix allows it.
+     */
+    bool WorldPanning{false};
+
+    /* Number of samples voices fade their gains over when their parameters
+     * change (0 = the whole update).
+     */
+    ALsizei GainRampLength{0};
+
+    /* Gain below which voices drop to a cheaper resampler and skip nearly
+     * flat filters (0 = never).
+     */
+    ALfloat VoiceLodGain{0.0f};
+
+    /* Fraction of each quantum's period a context's effects may take before
+     * their quality is lowered (0 = unlimited).
+     */
+    ALfloat EffectsBudget{0.0f};
+
+    /* Whether the mixer measures the times in MixStats. */
+    bool MixerStatsEnabled{false};
+    MixerStats MixStats;
+
+    /* Fraction of an update's period it may take before contexts listening
+     * for performance events are sent one (0 = never).
+     */
+    ALfloat PerfEventThreshold{0.8f};
+
+    /* Whether the current update's stage times are being measured, for the
+     * mixer stats or performance events. Only set by the mixer thread.
+     */
+    bool MixerTimed{false};
+
+    /* Samples of silence, with nothing playing, after which updates skip
+     * mixing and just output silence until something plays (0 = never).
+     * SilentSamples counts them, and IdleOutput is set once the output buffer
+     * is cleared for idling. Only changed by the mixer thread while running.
+     */
+    ALuint IdleTimeout{0u};
+    ALuint SilentSamples{0u};
+    bool IdleOutput{false};
+
+    /* When a reset keeps the device running, the resetting thread asks the
+     * mixer to fade the output out and waits for it to go silent. The output
+     * stays silent until the thread asks for it to fade back in, after the
+     * new renderer state is in place.
+     */
+    std::atomic<OutputFade> OutputFadeState{OutputFadeNone};
+
+    /* The format asked of the backend at its last reset. */
+    DevFmtRequest LastRequest;
+
     // Map of Buffers for this device
     std::mutex BufferLock;
-    al::vector<BufferSubList> BufferList;
+    al::stable_vector<BufferSubList> BufferList;
+    al::sublist_freemap BufferFreeMap;
+    /* Storage from deleted or resized buffers, kept for new buffers of about
+     * the same size, with the total bytes held and the most it may hold.
+     * Guarded by BufferLock.
+     */
+    al::vector<al::vector<ALbyte,16>> BufferPool;
+    size_t BufferPoolSize{0u};
+    size_t BufferPoolLimit{0u};
+
+    /* Buffers' samples resampled to the device rate, least recently played
+     * first, with the total bytes they use and the most they may use.
+     */
+    std::mutex ResampleCacheLock;
+    al::vector<ResampleCache*> ResampleCaches;
+    size_t ResampleCacheSize{0u};
+    size_t ResampleCacheLimit{0u};
+    /* Whether every static buffer gets a resample cache when played. */
+    bool ResampleCacheAll{false};
+    /* Whether new buffers store the start of their loop past their end. */
+    bool LoopPadding{false};
+
+    /* Wet mixing buffers for the contexts' effect slots, which a slot only
+     * takes once it has an effect or is targeted by another. Buffers of
+     * deleted slots are kept here for reuse. Each has SlotBufferChannels
+     * channels.
+     */
+    std::mutex SlotBufferLock;
+    al::vector<ALfloat(*)[BUFFERSIZE]> FreeSlotBuffers;
+    ALsizei SlotBufferChannels{0};
 
     // Map of Effects for this device
     std::mutex EffectLock;
-    al::vector<EffectSubList> EffectList;
+    al::stable_vector<EffectSubList> EffectList;
+    al::sublist_freemap EffectFreeMap;
 
     // Map of Filters for this device
     std::mutex FilterLock;
-    al::vector<FilterSubList> FilterList;
+    al::stable_vector<FilterSubList> FilterList;
+    al::sublist_freemap FilterFreeMap;
+    /* Incremented when a linked filter changes, so each context's mixer
+     * updates the voices linked to filters.
+     */
+    std::atomic<ALuint> LinkedFilterGen{0u};
 
     /* Rendering mode. */
     RenderMode mRenderMode{NormalRender};
@@ -401,14 +745,7 @@ struct ALCdevice {
     std::chrono::nanoseconds FixedLatency{0};
 
     /* Temp storage used for mixer processing. */
-    alignas(16) ALfloat SourceData[BUFFERSIZE + MAX_RESAMPLE_PADDING*2];
-    alignas(16) ALfloat ResampledData[BUFFERSIZE];
-    alignas(16) ALfloat FilteredData[BUFFERSIZE];
-    union {
-        alignas(16) ALfloat HrtfSourceData[BUFFERSIZE + HRTF_HISTORY_LENGTH];
-        alignas(16) ALfloat NfcSampleData[BUFFERSIZE];
-    };
-    alignas(16) float2 HrtfAccumData[BUFFERSIZE + HRIR_LENGTH];
+    MixerScratch Scratch;
 
     /* Mixing buffer used by the Dry mix and Real output. */
     al::vector<std::array<ALfloat,BUFFERSIZE>, 16> MixBuffer;
@@ -416,6 +753,10 @@ struct ALCdevice {
     /* The "dry" path corresponds to the main output. */
     MixParams Dry;
     ALsizei NumChannelsPerOrder[MAX_AMBI_ORDER+1]{};
+    /* Dry channels written this update, when separate from the real output.
+     * The post-process clears them after use.
+     */
+    ChannelMask DryTouched{0u};
 
     /* "Real" output, which will be written to the device buffer. May alias the
      * dry buffer.
@@ -425,15 +766,37 @@ struct ALCdevice {
     /* HRTF state and info */
     std::unique_ptr<DirectHrtfState> mHrtfState;
     HrtfEntry *mHrtf{nullptr};
+    std::unique_ptr<HrtfCoeffCache> mHrtfCache;
+    /* Shorter HRIR size for distant and background sources (0 if disabled),
+     * and the distance in meters they're used from.
+     */
+    ALsizei mHrtfLodSize{0};
+    ALfloat mHrtfLodDistance{0.0f};
+
+    /* Background HRTF loading, with hrtf-async. A pending load is started
+     * after the renderer is set up without the HRTF, and the loader resets
+     * the device with the attributes it was last reset with once it's done.
+     */
+    std::thread mHrtfLoader;
+    std::atomic<bool> mHrtfLoading{false};
+    bool mHrtfLoadPending{false};
+    bool mHrtfLoadSync{false};
+    al::vector<ALCint> mHrtfLoadAttrs;
 
+#ifdef ALSOFT_UHJ
     /* Ambisonic-to-UHJ encoder */
     std::unique_ptr<Uhj2Encoder> Uhj_Encoder;
+#endif
 
     /* Ambisonic decoder for speakers */
     std::unique_ptr<BFormatDec> AmbiDecoder;
+    /* Decoder for panning straight to the speakers, used instead. */
+    std::unique_ptr<SpeakerPanMatrix> SpeakerPanning;
 
+#ifdef ALSOFT_BS2B
     /* Stereo-to-binaural filter */
     std::unique_ptr<bs2b> Bs2b;
+#endif
 
     POSTPROCESS PostProcess{};
 
@@ -444,9 +807,20 @@ struct ALCdevice {
     /* Delay buffers used to compensate for speaker distances. */
     DistanceComp ChannelDelay;
 
+    /* Converter upsampling the finished mix to the output rate and format,
+     * when mixing at a lower rate, and the interleaved mix still waiting to be
+     * converted. With dithering, the converter outputs float samples to
+     * OutputConverted, which are dithered before they're written.
+     */
+    std::unique_ptr<SampleConverter> OutputConverter;
+    al::vector<ALfloat,16> OutputMix;
+    al::vector<ALfloat,16> OutputConverted;
+    ALsizei OutputMixPos{0};
+    ALsizei OutputMixCount{0};
+
     /* Dithering control. */
     ALfloat DitherDepth{0.0f};
-    ALuint DitherSeed{0u};
+    alignas(16) ALuint DitherSeeds[DITHER_RNG_LANES]{};
 
     /* Running count of the mixer invocations, in 31.1 fixed point. This
      * actually increments *twice* when mixing, first at the start and then at
@@ -455,6 +829,20 @@ struct ALCdevice {
      */
     RefCount MixCount{0u};
 
+    /* Worker threads for mixing multiple contexts in parallel. Null when
+     * contexts are mixed serially on the mixer thread.
+     */
+    std::unique_ptr<MixerPool> MixThreads;
+
+    /* Other playback devices this device's output is mirrored to. Only
+     * changed with the backend locked, or while not mixing.
+     */
+    al::vector<std::unique_ptr<OutputMirror>> Mirrors;
+    /* Set on a mirror's hidden device, which plays what the mirror reads from
+     * the main device instead of mixing.
+     */
+    OutputMirror *Mirror{nullptr};
+
     // Contexts created on this device
     std::atomic<ALCcontext*> ContextList{nullptr};
 
@@ -465,6 +853,15 @@ struct ALCdevice {
     std::mutex StateLock;
     std::unique_ptr<BackendBase> Backend;
 
+    /* Pool for the small objects the mixer uses over the device's lifetime
+     * (effect states, property containers, effect slot arrays, etc).
+     */
+    al::Arena *mArena{al::CreateArena()};
+    /* With lock-memory, the bytes of the device's HRTF tables locked into
+     * memory. They aren't in the arena, since HRTFs are shared by devices.
+     */
+    size_t HrtfLockedSize{0u};
+
 
     ALCdevice(DeviceType type);
     ALCdevice(const ALCdevice&) = delete;
@@ -497,8 +894,22 @@ struct ALCdevice {
  * compatibility with pthread_setname_np limitations. */
 #define MIXER_THREAD_NAME "alsoft-mixer"
 
+#define MIXER_WORKER_THREAD_NAME "alsoft-mixwork"
+
+/* Maximum number of threads used to mix a device's contexts. */
+#define MAX_MIX_THREADS 16
+
+/* Microseconds mixer worker threads spin waiting for jobs before sleeping. */
+#define DEFAULT_MIX_THREAD_SPIN 50
+
 #define RECORD_THREAD_NAME "alsoft-record"
 
+#define HRTF_LOADER_THREAD_NAME "alsoft-hrtfload"
+
+#define CONVOLUTION_THREAD_NAME "alsoft-convolve"
+
+#define EVENT_THREAD_NAME "alsoft-event"
+
 
 enum {
     /* End event thread processing. */
@@ -511,9 +922,7 @@ enum {
     EventType_Performance       = 1<<3,
     EventType_Deprecated        = 1<<4,
     EventType_Disconnected      = 1<<5,
-
-    /* Internal events. */
-    EventType_ReleaseEffectState = 65536,
+    EventType_HrtfReady         = 1<<6,
 };
 
 struct AsyncEvent {
@@ -534,7 +943,6 @@ struct AsyncEvent {
             ALuint param;
             ALchar msg[1008];
         } user;
-        EffectState *mEffectState;
     } u{};
 
     AsyncEvent() noexcept = default;
@@ -542,11 +950,29 @@ struct AsyncEvent {
 };
 
 
+/* The number of voices added at a time when a context runs out. */
+#define VOICE_CHUNK_SIZE 64
+
 void AllocateVoices(ALCcontext *context, ALsizei num_voices, ALsizei old_sends);
 
 
 extern ALint RTPrioLevel;
+/* Use SCHED_FIFO instead of SCHED_RR for real-time threads. */
+extern bool RTPrioFIFO;
+/* CPUs the mixing and mixer pool worker threads are restricted to. Empty
+ * means no restriction.
+ */
+extern al::vector<unsigned int> MixerCPUs;
+extern al::vector<unsigned int> WorkerCPUs;
+/* MMCSS task the mixing threads register with (Windows only). */
+extern std::string MMCSSTask;
+
+/* Applies the configured priority, scheduling policy, and CPU affinity to the
+ * calling thread. SetRTPriority is for a device's mixing thread, and
+ * SetWorkerRTPriority for mixer pool workers.
+ */
 void SetRTPriority(void);
+void SetWorkerRTPriority(void);
 
 void SetDefaultChannelOrder(ALCdevice *device);
 void SetDefaultWFXChannelOrder(ALCdevice *device);
@@ -564,10 +990,31 @@ inline ALint GetChannelIdxByName(const RealMixParams &real, Channel chan) noexce
 { return real.ChannelIndex[chan]; }
 
 
-void StartEventThrd(ALCcontext *ctx);
+/* Creates the context's event ring and adds it to the shared event thread,
+ * starting the thread if needed. Returns false on failure. The context's
+ * PropLock must be held.
+ */
+bool StartEventThrd(ALCcontext *ctx);
 void StopEventThrd(ALCcontext *ctx);
+/* Wakes the event thread after writing to a context's event ring. */
+void WakeEventThrd();
+/* Returns the context's buffer completion wakeup handle, creating it if
+ * needed, or nullptr if it's unavailable. The context's PropLock must be held.
+ */
+al::wakeup_handle *GetCompletionWakeup(ALCcontext *context);
 
 
 al::vector<std::string> SearchDataFiles(const char *match, const char *subdir);
 
+/* Returns the full path of the named file in the given subdirectory of the
+ * user's cache directory, or an empty string if there isn't one.
+ */
+std::string GetCachePath(const char *subdir, const char *fname);
+/* Creates any missing directories leading up to the given file path. */
+bool CreateParentDirs(const std::string &path);
+/* Stores the data to the given file, creating any missing directories. The
+ * file is replaced atomically, so readers never see it partially written.
+ */
+bool StoreCacheFile(const std::string &path, const void *data, size_t len);
+
 #endif
@@ -14,12 +14,18 @@
 struct ALbuffer;
 struct ALsource;
 struct ALeffectslot;
+struct ALsourceGroup;
+struct ALfilter;
 
 
 struct ALbufferlistitem {
     std::atomic<ALbufferlistitem*> next;
-    ALsizei max_samples;
+    int64_t max_samples;
     ALsizei num_buffers;
+    /* Number of buffers the item was allocated to hold, which stays the same
+     * when unqueueing some of a layered item's buffers.
+     */
+    ALsizei capacity;
     ALbuffer *buffers[];
 
     static constexpr size_t Sizeof(size_t num_buffers) noexcept
@@ -30,6 +36,20 @@ struct ALbufferlistitem {
 };
 
 
+/* Per-send properties of a source. These live in storage owned by the
+ * source's sublist rather than in the source itself, so each batch of 64
+ * sources makes one allocation sized for the device's send count.
+ */
+struct ALsourceSend {
+    ALeffectslot *Slot;
+    ALfilter *Link;
+    ALfloat Gain;
+    ALfloat GainHF;
+    ALfloat HFReference;
+    ALfloat GainLF;
+    ALfloat LFReference;
+};
+
 struct ALsource {
     /** Source properties. */
     ALfloat   Pitch;
@@ -53,6 +73,10 @@ struct ALsource {
     Resampler mResampler;
     ALboolean DirectChannels;
     SpatializeMode mSpatialize;
+    ALint Priority;
+    ALboolean FullHrtf;
+    ALenum OutputChannel;
+    ALboolean Instancing;
 
     ALboolean DryGainHFAuto;
     ALboolean WetGainAuto;
@@ -70,23 +94,24 @@ struct ALsource {
 
     ALfloat Radius;
 
-    /** Direct filter and auxiliary send info. */
+    /** The source group this source is in, if any. */
+    ALsourceGroup *Group;
+
+    /**
+     * Direct filter and auxiliary send info. Link is set to a linked filter
+     * the properties are taken from.
+     */
     struct {
+        ALfilter *Link;
         ALfloat Gain;
         ALfloat GainHF;
         ALfloat HFReference;
         ALfloat GainLF;
         ALfloat LFReference;
     } Direct;
-    struct SendData {
-        ALeffectslot *Slot;
-        ALfloat Gain;
-        ALfloat GainHF;
-        ALfloat HFReference;
-        ALfloat GainLF;
-        ALfloat LFReference;
-    };
-    al::vector<SendData> Send;
+    using SendData = ALsourceSend;
+    SendData *Send;
+    ALsizei NumSends;
 
     /**
      * Last user-specified offset, and the offset type (bytes, samples, or
@@ -105,6 +130,15 @@ struct ALsource {
     ALbufferlistitem *queue;
 
     std::atomic_flag PropsClean;
+    /* The groups of voice properties (VPROPS_*) changed since the last update
+     * sent to the voice.
+     */
+    std::atomic<ALuint> DirtyProps;
+
+    /* Total number of buffers the source has finished playing, counted by the
+     * mixer through the source's voice.
+     */
+    std::atomic<ALuint> BuffersCompleted;
 
     /* Index into the context's Voices array. Lazily updated, only checked and
      * reset when looking up the voice.
@@ -115,13 +149,21 @@ struct ALsource {
     ALuint id;
 
 
-    ALsource(ALsizei num_sends);
+    ALsource(SendData *sends, ALsizei num_sends);
     ~ALsource();
 
     ALsource(const ALsource&) = delete;
     ALsource& operator=(const ALsource&) = delete;
 };
 
+/* Voice property containers are added to the pool in chunks of this many,
+ * when the freelist runs dry.
+ */
+constexpr size_t VoicePropChunkSize{32};
+/* The most voice property containers to preallocate for a new context. */
+constexpr ALuint MaxPreallocVoiceProps{1024};
+
+void ReserveVoiceProps(ALCcontext *context, size_t count);
 void UpdateAllSourceProps(ALCcontext *context);
 
 #endif
@@ -0,0 +1,59 @@
+#ifndef _AL_SOURCEGROUP_H_
+#define _AL_SOURCEGROUP_H_
+
+#include "AL/alc.h"
+#include "AL/al.h"
+
+#include "atomic.h"
+#include "almalloc.h"
+
+
+struct ALsourceGroupProps {
+    ALfloat Gain;
+    ALfloat Pitch;
+
+    ALuint Batch;
+
+    std::atomic<ALsourceGroupProps*> next;
+};
+
+/* A group of sources sharing a gain and pitch, which are applied on top of
+ * each member's own. Changing them updates every playing member at once,
+ * without any per-source property updates.
+ */
+struct ALsourceGroup {
+    ALfloat Gain{1.0f};
+    ALfloat Pitch{1.0f};
+
+    /* Number of sources in the group. */
+    RefCount ref{0u};
+
+    std::atomic_flag PropsClean;
+
+    std::atomic<ALsourceGroupProps*> Update{nullptr};
+
+    /* The values the mixer uses, set from the group's updates. Only the mixer
+     * accesses them. They're read when the members' parameters are
+     * calculated, so they remain valid after the group is deleted until the
+     * context is.
+     */
+    struct {
+        ALfloat Gain{1.0f};
+        ALfloat Pitch{1.0f};
+    } Params;
+
+    /* Self ID */
+    ALuint id{0u};
+
+    ALsourceGroup() { PropsClean.test_and_set(std::memory_order_relaxed); }
+    ~ALsourceGroup() { al_free(Update.exchange(nullptr, std::memory_order_relaxed)); }
+    ALsourceGroup(const ALsourceGroup&) = delete;
+    ALsourceGroup& operator=(const ALsourceGroup&) = delete;
+};
+
+ALsourceGroup *LookupSourceGroup(ALCcontext *context, ALuint id) noexcept;
+
+void UpdateSourceGroupProps(ALsourceGroup *group, ALCcontext *context);
+void UpdateAllSourceGroupProps(ALCcontext *context);
+
+#endif
@@ -15,6 +15,7 @@
 
 #include "alMain.h"
 #include "alBuffer.h"
+#include "alListener.h"
 
 #include "hrtf.h"
 #include "logging.h"
@@ -37,6 +38,10 @@ struct ALsource;
 struct ALbufferlistitem;
 struct ALvoice;
 struct ALeffectslot;
+struct ALsourceGroup;
+struct ALfilter;
+struct VoiceInstance;
+struct VoiceMixLog;
 
 
 #define DITHER_RNG_SEED 22222
@@ -54,8 +59,9 @@ enum Resampler {
     FIR4Resampler,
     BSinc12Resampler,
     BSinc24Resampler,
+    BSinc32Resampler,
 
-    ResamplerMax = BSinc24Resampler
+    ResamplerMax = BSinc32Resampler
 };
 extern Resampler ResamplerDefault;
 
@@ -89,11 +95,19 @@ union InterpState {
 using ResamplerFunc = const ALfloat*(*)(const InterpState *state,
     const ALfloat *RESTRICT src, ALsizei frac, ALint increment,
     ALfloat *RESTRICT dst, ALsizei dstlen);
+/* Resamples each of numchans source rows into the matching destination row.
+ * All channels share the same position and step, so the per-sample phase and
+ * filter only need to be calculated once.
+ */
+using ResamplerMultiFunc = void(*)(const InterpState *state,
+    const ALfloat *const *RESTRICT src, const ALsizei numchans, ALsizei frac, ALint increment,
+    ALfloat *const *RESTRICT dst, ALsizei dstlen);
 
 void BsincPrepare(const ALuint increment, BsincState *state, const BSincTable *table);
 
 extern const BSincTable bsinc12;
 extern const BSincTable bsinc24;
+extern const BSincTable bsinc32;
 
 
 enum {
@@ -112,32 +126,51 @@ struct MixHrtfParams {
 };
 
 
+/* HRTF state for a voice channel. This is kept apart from the other direct
+ * params since it's large, and only needed when the device renders with HRTF.
+ */
+struct DirectHrtfParams {
+    HrtfParams Old;
+    HrtfParams Target;
+    HrtfState State;
+};
+
 struct DirectParams {
     BiquadFilter LowPass;
     BiquadFilter HighPass;
 
-    NfcFilter NFCtrlFilter;
-
+    /* Each holds the voice's mNumGains values, stored in its chunk. */
     struct {
-        HrtfParams Old;
-        HrtfParams Target;
-        HrtfState State;
-    } Hrtf;
-
-    struct {
-        ALfloat Current[MAX_OUTPUT_CHANNELS];
-        ALfloat Target[MAX_OUTPUT_CHANNELS];
+        ALfloat *Current;
+        ALfloat *Target;
     } Gains;
+
+    void clear(const ALsizei numgains) noexcept
+    {
+        LowPass = BiquadFilter{};
+        HighPass = BiquadFilter{};
+        std::fill_n(Gains.Current, numgains, 0.0f);
+        std::fill_n(Gains.Target, numgains, 0.0f);
+    }
 };
 
 struct SendParams {
     BiquadFilter LowPass;
     BiquadFilter HighPass;
 
+    /* Each holds the voice's mNumGains values, stored in its chunk. */
     struct {
-        ALfloat Current[MAX_OUTPUT_CHANNELS];
-        ALfloat Target[MAX_OUTPUT_CHANNELS];
+        ALfloat *Current;
+        ALfloat *Target;
     } Gains;
+
+    void clear(const ALsizei numgains) noexcept
+    {
+        LowPass = BiquadFilter{};
+        HighPass = BiquadFilter{};
+        std::fill_n(Gains.Current, numgains, 0.0f);
+        std::fill_n(Gains.Target, numgains, 0.0f);
+    }
 };
 
 
@@ -162,6 +195,10 @@ struct ALvoicePropsBase {
     Resampler mResampler;
     ALboolean DirectChannels;
     SpatializeMode mSpatializeMode;
+    ALint Priority;
+    ALboolean FullHrtf;
+    ALenum OutputChannel;
+    ALboolean Instancing;
 
     ALboolean DryGainHFAuto;
     ALboolean WetGainAuto;
@@ -176,8 +213,11 @@ struct ALvoicePropsBase {
 
     ALfloat Radius;
 
+    ALsourceGroup *Group;
+
     /** Direct filter and auxiliary send info. */
     struct {
+        ALfilter *Link;
         ALfloat Gain;
         ALfloat GainHF;
         ALfloat HFReference;
@@ -186,6 +226,7 @@ struct ALvoicePropsBase {
     } Direct;
     struct SendData {
         ALeffectslot *Slot;
+        ALfilter *Link;
         ALfloat Gain;
         ALfloat GainHF;
         ALfloat HFReference;
@@ -194,7 +235,19 @@ struct ALvoicePropsBase {
     } Send[MAX_SENDS];
 };
 
+/* Groups of voice properties, marking which ones an update changed. */
+#define VPROPS_POSE   (1u<<0) /* Position, velocity, direction and orientation. */
+#define VPROPS_PARAMS (1u<<1) /* Everything besides the pose and sends. */
+#define VPROPS_SENDS  (1u<<2)
+#define VPROPS_ALL    (VPROPS_POSE | VPROPS_PARAMS | VPROPS_SENDS)
+
+/* An update for a voice's properties. Only the groups set in mChanged are
+ * filled in, and the mixer merges those into its own copy.
+ */
 struct ALvoiceProps : public ALvoicePropsBase {
+    ALuint mChanged{0u};
+    ALuint mBatch{0u};
+
     std::atomic<ALvoiceProps*> next{nullptr};
 
     DEF_NEWDEL(ALvoiceProps)
@@ -205,6 +258,38 @@ struct ALvoiceProps : public ALvoicePropsBase {
 #define VOICE_IS_AMBISONIC (1u<<2) /* Voice needs HF scaling for ambisonic upsampling. */
 #define VOICE_HAS_HRTF     (1u<<3)
 #define VOICE_HAS_NFC      (1u<<4)
+#define VOICE_ATTN_CACHED  (1u<<5) /* mAttn holds valid results for mProps. */
+#define VOICE_IS_CULLED    (1u<<6) /* Voice is over the voice budget, so it's faded out. */
+#define VOICE_IS_CALLBACK  (1u<<7) /* Voice pulls samples from a buffer callback. */
+#define VOICE_CALLBACK_STOPPED (1u<<8) /* The buffer callback has no more samples. */
+#define VOICE_IS_DELAYED   (1u<<9) /* Voice waits until mStartTime to start mixing. */
+
+/* The number of levels voices can have their quality lowered by. */
+#define VOICE_LOD_LEVELS 2u
+
+/* Layout of ALvoice::mMixCostPath. The resampler is stored as its index + 1,
+ * or 0 when the voice isn't resampled.
+ */
+#define VOICE_COST_RESAMPLER_MASK  0xffu
+#define VOICE_COST_HRTF            (1u<<8)
+#define VOICE_COST_NFC             (1u<<9)
+#define VOICE_COST_AMBISONIC       (1u<<10)
+#define VOICE_COST_CHANNELS_SHIFT  16
+#define VOICE_COST_SENDS_SHIFT     24
+
+/* Distance and cone attenuation results for a voice. These only depend on the
+ * source's distance and cone angle relative to the listener (and the source,
+ * listener, context, and effect slot properties), so they can be reused when
+ * only the source direction relative to the listener changes.
+ */
+struct VoiceAttenuation {
+    ALfloat Distance;
+    bool Directional;
+    ALfloat ConeDot;
+
+    ALfloat DryGain, DryGainHF, DryGainLF;
+    ALfloat WetGain[MAX_SENDS], WetGainHF[MAX_SENDS], WetGainLF[MAX_SENDS];
+};
 
 struct ALvoice {
     enum State {
@@ -217,14 +302,18 @@ struct ALvoice {
 
     std::atomic<ALuint> mSourceID{0u};
     std::atomic<State> mPlayState{Stopped};
+    /* The playing source's completed buffer count. Only changed while the
+     * mixer isn't running.
+     */
+    std::atomic<ALuint> *mCompletedCount{nullptr};
 
     ALvoicePropsBase mProps;
 
     /**
      * Source offset in samples, relative to the currently playing buffer, NOT
-     * the whole queue.
+     * the whole queue. 64-bit so large buffers can be played through.
      */
-    std::atomic<ALuint> mPosition;
+    std::atomic<uint64_t> mPosition;
     /** Fractional (fixed-point) offset to the next sample. */
     std::atomic<ALsizei> mPositionFrac;
 
@@ -246,32 +335,134 @@ struct ALvoice {
     ALint mStep;
 
     ResamplerFunc mResampler;
+    /* Null if the resampler has no multi-channel version. */
+    ResamplerMultiFunc mMultiResampler;
+    /* The resampler used, which is cheaper than the source's when the voice's
+     * quality is lowered.
+     */
+    Resampler mActiveResampler;
+    /* The level the voice's quality is lowered by for being quiet (0 = full
+     * quality), see VOICE_LOD_LEVELS.
+     */
+    ALuint mQuality{0u};
+    /* The resampler the next mix crossfades from, after the voice switched
+     * resamplers (null if it didn't).
+     */
+    ResamplerFunc mPrevResampler{nullptr};
+    InterpState mPrevResampleState;
 
     ALuint mFlags;
+    /* Device clock time a delayed voice starts at. */
+    std::chrono::nanoseconds mStartTime;
+
+    VoiceAttenuation mAttn;
+    /* Largest target gain of the voice's outputs, for ranking voices when
+     * there's a voice budget.
+     */
+    ALfloat mAudibility;
+
+    /* The voice's sampled mixing cost, for AL_SOURCE_MIX_COST_SOFT. The mixer
+     * times one of every few quanta it mixes the voice (or every one while
+     * it's timing the update anyway), keeping a running average of the time
+     * in nanoseconds, and the path it was mixed with.
+     */
+    ALuint mMixCostCounter{0u};
+    std::atomic<ALuint> mMixCostNs{0u};
+    std::atomic<ALuint> mMixCostPath{0u};
 
     using ResamplePaddingArray = std::array<ALfloat,MAX_RESAMPLE_PADDING*2>;
     alignas(16) std::array<ResamplePaddingArray,MAX_INPUT_CHANNELS> mPrevSamples;
+    /* Decoder state for each channel of ADPCM buffers. */
+    std::array<ADPCMState,MAX_INPUT_CHANNELS> mADPCMState;
+
+    /* Sample frames pulled from a callback buffer, starting at mPosition. */
+    al::vector<ALbyte,16> mCallbackBlock;
+    ALsizei mCallbackBlockLen{0};
+
+    /* End of the file-backed buffer's frames last asked to be paged in. */
+    int64_t mReadAheadPos{0};
+
+    /* The buffer's resample cache the voice plays instead, if any. */
+    ResampleCache *mResampled{nullptr};
 
     InterpState mResampleState;
 
     std::array<ALfloat,MAX_INPUT_CHANNELS> mAmbiScales;
     std::array<BandSplitter,MAX_INPUT_CHANNELS> mAmbiSplitter;
 
+    /* Per-channel HRTF and near-field control state for the direct path,
+     * stored after the voice in its chunk. These are only allocated when the
+     * device uses HRTF or NFC, respectively, and are null otherwise.
+     */
+    DirectHrtfParams *mDirectHrtf{nullptr};
+    NfcFilter *mDirectNfc{nullptr};
+
+    /* The number of gains in each of the direct and send parameters, which
+     * are also stored in the voice's chunk. This covers the largest of the
+     * device's mixing buffers, so it grows with the ambisonic order.
+     */
+    ALsizei mNumGains{0};
+
+    /* The direction bucket the voice can be clustered in (0 = none), and its
+     * gain when mixed to the cluster. When the mixer finds other voices in
+     * the same bucket, the voice is mixed to mClusterBuffer instead of being
+     * panned itself.
+     */
+    ALuint mClusterKey{0};
+    struct {
+        ALfloat Current;
+        ALfloat Target;
+    } mClusterGain{0.0f, 0.0f};
+    ALfloat (*mClusterBuffer)[BUFFERSIZE]{nullptr};
+
+    /* The instance the voice shares its resampled samples with, when the
+     * mixer finds other voices playing the same buffer in step with it. Only
+     * the instance's leader loads and resamples.
+     */
+    VoiceInstance *mInstance{nullptr};
+
+    /* The log holding the voice's mix from its last update, if it was mixed
+     * on a pool thread, and the range of its commands there.
+     */
+    VoiceMixLog *mMixLog{nullptr};
+    size_t mMixLogBegin{0u}, mMixLogEnd{0u};
+
     struct {
         int FilterType;
         DirectParams Params[MAX_INPUT_CHANNELS];
 
         ALfloat (*Buffer)[BUFFERSIZE];
         ALsizei Channels;
+        ChannelMask *Touched;
         ALsizei ChannelsPerOrder[MAX_AMBI_ORDER+1];
     } mDirect;
 
+    /* The voice's mix for each of the context's other listeners, panned to
+     * the listener's pair of output channels (a null Buffer if the listener is
+     * disabled). They get the direct path's filtered samples, with their own
+     * gains.
+     */
+    struct ListenerMixData {
+        struct {
+            ALfloat Current[2];
+            ALfloat Target[2];
+        } Gains[MAX_INPUT_CHANNELS];
+
+        ALfloat (*Buffer)[BUFFERSIZE];
+        /* The output channels to mark as written, up to the end of the pair. */
+        ALsizei Channels;
+        ChannelMask *Touched;
+    };
+    std::array<ListenerMixData,MAX_LISTENERS-1> mListenerMix{};
+    bool mHasListenerMix{false};
+
     struct SendData {
         int FilterType;
         SendParams Params[MAX_INPUT_CHANNELS];
 
         ALfloat (*Buffer)[BUFFERSIZE];
         ALsizei Channels;
+        ChannelMask *Touched;
     };
     al::FlexArray<SendData> mSend;
 
@@ -304,6 +495,44 @@ using HrtfMixerBlendFunc = void(*)(ALfloat *RESTRICT LeftOut, ALfloat *RESTRICT
 using HrtfDirectMixerFunc = void(*)(ALfloat *RESTRICT LeftOut, ALfloat *RESTRICT RightOut,
     const ALfloat (*data)[BUFFERSIZE], float2 *RESTRICT AccumSamples, DirectHrtfState *State,
     const ALsizei NumChans, const ALsizei BufferSize);
+/* Adds count half-precision values (e.g. HRIR coefficients) from src, scaled,
+ * to dst.
+ */
+using HalfBlendFunc = void(*)(ALfloat *RESTRICT dst, const ALushort *RESTRICT src,
+    const ALfloat scale, const ALsizei count);
+/* Adds samples of an interleaved UByte, Short, or Float buffer to dst as
+ * floats, taking every srcstep'th value from src. Other sample types are left
+ * to the caller.
+ */
+using SampleLoadFunc = void(*)(ALfloat *RESTRICT dst, const ALvoid *RESTRICT src,
+    const ALint srcstep, const FmtType srctype, const ALsizei samples);
+/* Stores srcchans channels of samples to a Short, Int, or Float buffer,
+ * converting and clamping them, with dststep values between each of a
+ * channel's samples (so srcchans == dststep writes whole interleaved frames).
+ * Other sample types are left to the caller.
+ */
+using SampleStoreFunc = void(*)(ALvoid *RESTRICT dst, const ALfloat *const *RESTRICT src,
+    const ALsizei srcchans, const ALsizei dststep, const DevFmtType dsttype,
+    const ALsizei samples);
+/* Dithers and quantizes samples in place to steps of 1/quant_scale, adding
+ * triangular (TPDF) noise from DITHER_RNG_LANES xorshift generators. Sample i
+ * uses lane i%DITHER_RNG_LANES, so the result only depends on the seeds.
+ */
+using DitherFunc = void(*)(ALfloat *RESTRICT buffer, ALuint *RESTRICT seeds,
+    const ALfloat quant_scale, const ALsizei samples);
+/* Applies a separate filter to each of numchans channels. The destination may
+ * be the same as the source.
+ */
+using BiquadMultiFunc = void(*)(BiquadFilter *const *filters, ALfloat *const *dst,
+    const ALfloat *const *src, const ALsizei numchans, const ALsizei numsamples);
+/* Applies a cascade of BIQUAD_CASCADE_STAGES filters to each of numchans
+ * channels in a single pass. filters[c] points to the channel's filters, in
+ * the order they're applied. The destination may be the same as the source.
+ */
+using BiquadCascadeFunc = void(*)(BiquadFilter *const *filters, ALfloat *const *dst,
+    const ALfloat *const *src, const ALsizei numchans, const ALsizei numsamples);
+
+#define BIQUAD_CASCADE_STAGES  4
 
 
 #define GAIN_MIX_MAX  (1000.0f) /* +60dB */
@@ -343,8 +572,16 @@ enum HrtfRequestMode {
 void aluInit(void);
 
 void aluInitMixer(void);
+/* Lists the kernel specialization aluInitMixer chose for each mixing
+ * function, as space-separated "function=specialization" pairs.
+ */
+const char *aluGetMixerKernels(void);
 
-ResamplerFunc SelectResampler(Resampler resampler);
+/* The increment selects a faster bsinc resampler when it isn't downsampling,
+ * so these need to be called again whenever it changes.
+ */
+ResamplerFunc SelectResampler(Resampler resampler, ALuint increment);
+ResamplerMultiFunc SelectMultiResampler(Resampler resampler, ALuint increment);
 
 /* aluInitRenderer
  *
@@ -374,6 +611,15 @@ void aluSelectPostProcess(ALCdevice *device);
 void CalcAmbiCoeffs(const ALfloat y, const ALfloat z, const ALfloat x, const ALfloat spread,
                     ALfloat (&coeffs)[MAX_AMBI_CHANNELS]);
 
+/**
+ * Calculates ambisonic encoder coefficients for count directions with the same
+ * spread, given as separate arrays of ambisonic Y, Z, and X components. The
+ * directions are processed in blocks so the compiler can vectorize across
+ * them.
+ */
+void CalcAmbiCoeffsMulti(const ALfloat *y, const ALfloat *z, const ALfloat *x, const ALfloat spread,
+    const ALsizei count, ALfloat (*coeffs)[MAX_AMBI_CHANNELS]);
+
 /**
  * CalcDirectionCoeffs
  *
@@ -403,6 +649,28 @@ inline void CalcAngleCoeffs(ALfloat azimuth, ALfloat elevation, ALfloat spread,
     CalcAmbiCoeffs(x, y, z, spread, coeffs);
 }
 
+/**
+ * CalcAngleCoeffsMulti
+ *
+ * Calculates ambisonic coefficients for count pairs of azimuth and elevation,
+ * all with the same spread.
+ */
+inline void CalcAngleCoeffsMulti(const ALfloat *azimuth, const ALfloat *elevation, ALfloat spread,
+    const ALsizei count, ALfloat (*coeffs)[MAX_AMBI_CHANNELS])
+{
+    ALfloat x[MAX_INPUT_CHANNELS], y[MAX_INPUT_CHANNELS], z[MAX_INPUT_CHANNELS];
+
+    ASSUME(count >= 0 && count <= MAX_INPUT_CHANNELS);
+    for(ALsizei i{0};i < count;++i)
+    {
+        x[i] = -std::sin(azimuth[i]) * std::cos(elevation[i]);
+        y[i] = std::sin(elevation[i]);
+        z[i] = std::cos(azimuth[i]) * std::cos(elevation[i]);
+    }
+
+    CalcAmbiCoeffsMulti(x, y, z, spread, count, coeffs);
+}
+
 
 /**
  * ComputePanGains
@@ -412,7 +680,9 @@ inline void CalcAngleCoeffs(ALfloat azimuth, ALfloat elevation, ALfloat spread,
  * coeffs are a 'slice' of a transform matrix for the input channel, used to
  * scale and orient the sound samples.
  */
-void ComputePanGains(const MixParams *mix, const ALfloat*RESTRICT coeffs, ALfloat ingain, ALfloat (&gains)[MAX_OUTPUT_CHANNELS]);
+void ComputePanGains(const MixParams *mix, const ALfloat*RESTRICT coeffs, ALfloat ingain, ALfloat *gains, ALsizei numgains);
+inline void ComputePanGains(const MixParams *mix, const ALfloat*RESTRICT coeffs, ALfloat ingain, ALfloat (&gains)[MAX_OUTPUT_CHANNELS])
+{ ComputePanGains(mix, coeffs, ingain, gains, MAX_OUTPUT_CHANNELS); }
 
 
 inline std::array<ALfloat,MAX_AMBI_CHANNELS> GetAmbiIdentityRow(size_t i) noexcept
@@ -423,14 +693,95 @@ inline std::array<ALfloat,MAX_AMBI_CHANNELS> GetAmbiIdentityRow(size_t i) noexce
 }
 
 
-void MixVoice(ALvoice *voice, ALvoice::State vstate, const ALuint SourceID, ALCcontext *Context, const ALsizei SamplesToDo);
+/* The writes a voice makes to its outputs, recorded when it's mixed on a pool
+ * thread. The threads only resample, filter, and run the HRTF filters, while
+ * the updates to the shared outputs get replayed afterward in voice order, so
+ * the result is the same as mixing the voices one after another on one
+ * thread. The storage is allocated up front, and never grows while mixing.
+ */
+struct VoiceMixLog {
+    enum CommandType : ALubyte {
+        MarkCmd,     /* MarkChannels on Touched */
+        MixCmd,      /* MixSamples */
+        SparseCmd,   /* MixSparseSamples */
+        FilteredCmd, /* MixFilteredSamples, with copies of the filters */
+        AddCmd       /* Adds HRTF output to the one channel */
+    };
+    struct Command {
+        CommandType Type;
+        int FilterType;
+        ALsizei OutChans;
+        ALsizei Counter;
+        ALsizei OutPos;
+        ALsizei BufferSize;
+        /* Offset of the command's samples in Data. */
+        size_t Samples;
+        ALfloat (*OutBuffer)[BUFFERSIZE];
+        ChannelMask *Touched;
+        /* The gains are the voice's own, which nothing else changes until
+         * the command is replayed.
+         */
+        ALfloat *CurrentGains;
+        const ALfloat *TargetGains;
+        BiquadFilter LowPass, HighPass;
+    };
+
+    al::vector<Command> Commands;
+    size_t NumCommands{0u};
+    al::vector<ALfloat,16> Data;
+    size_t DataUsed{0u};
+
+    void resize(size_t numcmds, size_t numsamples);
+    void clear() noexcept { NumCommands = 0u; DataUsed = 0u; }
+
+    /* Returns whether there's room left to record the voice's mix for an
+     * update of SamplesToDo samples. This is an upper bound, counting every
+     * output the voice could write for every block it could be split into.
+     */
+    bool canRecord(const ALvoice *voice, const ALsizei SamplesToDo) const noexcept;
+
+    void mark(ChannelMask *touched, const ALsizei count);
+    Command &mix(const CommandType type, const ALfloat *data, const ALsizei OutChans,
+        ALfloat (*OutBuffer)[BUFFERSIZE], ALfloat *CurrentGains, const ALfloat *TargetGains,
+        const ALsizei Counter, const ALsizei OutPos, const ALsizei BufferSize);
+    /* Returns a row of BufferSize samples, set to -0 so that adding to it is
+     * exact, to be added to the output row at OutPos.
+     */
+    ALfloat *add(ALfloat (*OutRow)[BUFFERSIZE], const ALsizei OutPos, const ALsizei BufferSize);
+
+    /* Carries out the given range of commands. */
+    void replay(const size_t begin, const size_t end) const;
+};
+
+void MixVoice(ALvoice *voice, ALvoice::State vstate, const ALuint SourceID, ALCcontext *Context,
+    MixerScratch &Scratch, const ALsizei SamplesToDo);
+/* Resamples all of the buffer's samples with the given fixed-point step,
+ * writing dstframes interleaved float frames to dst.
+ */
+void ResampleBufferData(const ALbuffer *buffer, const ALint increment, ALfloat *dst,
+    const ALsizei dstframes);
 
 void aluMixData(ALCdevice *device, ALvoid *OutBuffer, ALsizei NumSamples);
+/* Same as aluMixData, except the output is left unwritten and false is
+ * returned when it would be silent (below GAIN_SILENCE_THRESHOLD, ignoring
+ * dither) for all NumSamples samples.
+ */
+bool aluMixDataSparse(ALCdevice *device, ALvoid *OutBuffer, ALsizei NumSamples);
+/* Mixes NumSamples samples to separate float buffers, one for each output
+ * channel, instead of interleaving and converting to the device format.
+ */
+void aluMixDataPlanar(ALCdevice *device, ALfloat *const *OutBuffers, ALsizei NumSamples);
 /* Caller must lock the device state, and the mixer must not be running. */
 void aluHandleDisconnect(ALCdevice *device, const char *msg, ...) DECL_FORMAT(printf, 2, 3);
 
 extern MixerFunc MixSamples;
 extern RowMixerFunc MixRowSamples;
+extern BiquadMultiFunc FilterMultiSamples;
+extern BiquadCascadeFunc FilterCascadeSamples;
+extern HalfBlendFunc BlendHalfSamples;
+extern SampleLoadFunc LoadPCMSamples;
+extern SampleStoreFunc StorePCMSamples;
+extern DitherFunc DitherSamples;
 
 extern const ALfloat ConeScale;
 extern const ALfloat ZScale;
@@ -11,13 +11,17 @@ extern "C" {
 extern const ALshort muLawDecompressionTable[256];
 extern const ALshort aLawDecompressionTable[256];
 
-void Convert_ALshort_ALima4(ALshort *dst, const ALubyte *src, ALsizei numchans, ALsizei len,
-                            ALsizei align);
-void Convert_ALshort_ALmsadpcm(ALshort *dst, const ALubyte *src, ALsizei numchans, ALsizei len,
-                               ALsizei align);
-
 #ifdef __cplusplus
 } // extern "C"
 #endif
 
+/* Decodes count samples of channel chan from an IMA4 or MSADPCM buffer,
+ * starting at frame pos, and adds them to dst. The decoder resumes from state
+ * when it's for this buffer at or before pos in the same block. The state kept
+ * for next time is the one at frame checkpoint, if it was passed, or else the
+ * last decoded frame.
+ */
+void DecodeADPCMSamples(ALfloat *dst, const ALbuffer *buffer, ALsizei chan, int64_t pos,
+    ALsizei count, ADPCMState &state, int64_t checkpoint);
+
 #endif /* SAMPLE_CVT_H */
@@ -32,9 +32,11 @@
 #include "alMain.h"
 #include "alcontext.h"
 #include "alAuxEffectSlot.h"
+#include "alBuffer.h"
 #include "alError.h"
 #include "alListener.h"
 #include "alSource.h"
+#include "callrecord.h"
 
 #include "fpu_modes.h"
 #include "alexcpt.h"
@@ -48,12 +50,12 @@ inline ALeffectslot *LookupEffectSlot(ALCcontext *context, ALuint id) noexcept
     ALuint lidx = (id-1) >> 6;
     ALsizei slidx = (id-1) & 0x3f;
 
-    if(UNLIKELY(lidx >= context->EffectSlotList.size()))
+    EffectSlotSubList *sublist{context->EffectSlotList.lookup(lidx)};
+    if(UNLIKELY(!sublist))
         return nullptr;
-    EffectSlotSubList &sublist{context->EffectSlotList[lidx]};
-    if(UNLIKELY(sublist.FreeMask & (1_u64 << slidx)))
+    if(UNLIKELY(sublist->FreeMask.load(std::memory_order_acquire) & (1_u64 << slidx)))
         return nullptr;
-    return sublist.EffectSlots + slidx;
+    return sublist->EffectSlots + slidx;
 }
 
 inline ALeffect *LookupEffect(ALCdevice *device, ALuint id) noexcept
@@ -61,18 +63,49 @@ inline ALeffect *LookupEffect(ALCdevice *device, ALuint id) noexcept
     ALuint lidx = (id-1) >> 6;
     ALsizei slidx = (id-1) & 0x3f;
 
-    if(UNLIKELY(lidx >= device->EffectList.size()))
+    EffectSubList *sublist{device->EffectList.lookup(lidx)};
+    if(UNLIKELY(!sublist))
         return nullptr;
-    EffectSubList &sublist = device->EffectList[lidx];
-    if(UNLIKELY(sublist.FreeMask & (1_u64 << slidx)))
+    if(UNLIKELY(sublist->FreeMask.load(std::memory_order_acquire) & (1_u64 << slidx)))
         return nullptr;
-    return sublist.Effects + slidx;
+    return sublist->Effects + slidx;
+}
+
+inline ALbuffer *LookupBuffer(ALCdevice *device, ALuint id) noexcept
+{
+    ALuint lidx = (id-1) >> 6;
+    ALsizei slidx = (id-1) & 0x3f;
+
+    BufferSubList *sublist{device->BufferList.lookup(lidx)};
+    if(UNLIKELY(!sublist))
+        return nullptr;
+    if(UNLIKELY(sublist->FreeMask.load(std::memory_order_acquire) & (1_u64 << slidx)))
+        return nullptr;
+    return sublist->Buffers + slidx;
+}
+
+
+void FreeSlotArray(void *ptr)
+{ delete static_cast<ALeffectslotArray*>(ptr); }
+
+/* Releases the effect states left in freelisted property objects. */
+void ReleaseRetiredEffectStates(ALCcontext *context)
+{
+    ALeffectslotProps *props{context->FreeEffectslotProps.load()};
+    while(props)
+    {
+        if(props->State)
+            props->State->DecRef();
+        props->State = nullptr;
+        props = props->next.load(std::memory_order_relaxed);
+    }
 }
 
 
 void AddActiveEffectSlots(const ALuint *slotids, ALsizei count, ALCcontext *context)
 {
     if(count < 1) return;
+    al::ArenaScope arena_scope{context->Device->mArena};
     ALeffectslotArray *curarray{context->ActiveAuxSlots.load(std::memory_order_acquire)};
     size_t newcount{curarray->size() + count};
 
@@ -109,15 +142,13 @@ void AddActiveEffectSlots(const ALuint *slotids, ALsizei count, ALCcontext *cont
     }
 
     curarray = context->ActiveAuxSlots.exchange(newarray, std::memory_order_acq_rel);
-    ALCdevice *device{context->Device};
-    while((device->MixCount.load(std::memory_order_acquire)&1))
-        std::this_thread::yield();
-    delete curarray;
+    RetireObject(context, curarray, FreeSlotArray);
 }
 
 void RemoveActiveEffectSlots(const ALuint *slotids, ALsizei count, ALCcontext *context)
 {
     if(count < 1) return;
+    al::ArenaScope arena_scope{context->Device->mArena};
     ALeffectslotArray *curarray{context->ActiveAuxSlots.load(std::memory_order_acquire)};
 
     /* Don't shrink the allocated array size since we don't know how many (if
@@ -145,10 +176,7 @@ void RemoveActiveEffectSlots(const ALuint *slotids, ALsizei count, ALCcontext *c
     }
 
     curarray = context->ActiveAuxSlots.exchange(newarray, std::memory_order_acq_rel);
-    ALCdevice *device{context->Device};
-    while((device->MixCount.load(std::memory_order_acquire)&1))
-        std::this_thread::yield();
-    delete curarray;
+    RetireObject(context, curarray, FreeSlotArray);
 }
 
 
@@ -156,16 +184,16 @@ ALeffectslot *AllocEffectSlot(ALCcontext *context)
 {
     ALCdevice *device{context->Device};
     std::lock_guard<std::mutex> _{context->EffectSlotLock};
+    /* The slot's effect state is created with it. */
+    al::ArenaScope arena_scope{device->mArena};
     if(context->NumEffectSlots >= device->AuxiliaryEffectSlotMax)
     {
         alSetError(context, AL_OUT_OF_MEMORY, "Exceeding %u effect slot limit",
             device->AuxiliaryEffectSlotMax);
         return nullptr;
     }
-    auto sublist = std::find_if(context->EffectSlotList.begin(), context->EffectSlotList.end(),
-        [](const EffectSlotSubList &entry) noexcept -> bool
-        { return entry.FreeMask != 0; }
-    );
+    const ptrdiff_t freelist{context->EffectSlotFreeMap.find()};
+    auto sublist = (freelist < 0) ? context->EffectSlotList.end() : (context->EffectSlotList.begin() + freelist);
     auto lidx = static_cast<ALsizei>(std::distance(context->EffectSlotList.begin(), sublist));
     ALeffectslot *slot;
     ALsizei slidx;
@@ -215,6 +243,7 @@ ALeffectslot *AllocEffectSlot(ALCcontext *context)
 
     context->NumEffectSlots += 1;
     sublist->FreeMask &= ~(1_u64 << slidx);
+    context->EffectSlotFreeMap.set(static_cast<size_t>(lidx), sublist->FreeMask != 0);
 
     return slot;
 }
@@ -225,13 +254,60 @@ void FreeEffectSlot(ALCcontext *context, ALeffectslot *slot)
     ALsizei lidx = id >> 6;
     ALsizei slidx = id & 0x3f;
 
+    FreeEffectSlotBuffer(slot, context->Device);
     slot->~ALeffectslot();
 
     context->EffectSlotList[lidx].FreeMask |= 1_u64 << slidx;
+    context->EffectSlotFreeMap.set(static_cast<size_t>(lidx), true);
     context->NumEffectSlots--;
 }
 
 
+/* Creates a new state of the given effect type for the slot, using the slot's
+ * buffer, and replaces the slot's current state with it.
+ */
+ALenum ReplaceEffectState(ALCcontext *Context, ALeffectslot *EffectSlot, ALenum newtype)
+{
+    EffectStateFactory *factory{getFactoryByType(newtype)};
+    if(!factory)
+    {
+        ERR("Failed to find factory for effect type 0x%04x\n", newtype);
+        return AL_INVALID_ENUM;
+    }
+    EffectState *State{factory->create()};
+    if(!State) return AL_OUT_OF_MEMORY;
+
+    FPUCtl mixer_mode{};
+    ALCdevice *Device{Context->Device};
+    std::unique_lock<std::mutex> statelock{Device->StateLock};
+    State->mOutBuffer = Context->Dry.Buffer;
+    State->mOutChannels = Device->Dry.NumChannels;
+    if(factory->useHalfRate())
+    {
+        State->mHalfRate.reset(new EffectHalfRate{});
+        State->mHalfRate->reset(Device->SlotBufferChannels, State->mOutChannels);
+    }
+    State->setBuffer(EffectSlot->Buffer);
+    if(State->deviceUpdate(Device) == AL_FALSE)
+    {
+        statelock.unlock();
+        mixer_mode.leave();
+        State->DecRef();
+        return AL_OUT_OF_MEMORY;
+    }
+    mixer_mode.leave();
+
+    EffectSlot->Effect.State->DecRef();
+    EffectSlot->Effect.State = State;
+
+    /* Remove state references from old effect slot property updates. */
+    Context->EffectStatesRetired.store(false, std::memory_order_relaxed);
+    ReleaseRetiredEffectStates(Context);
+
+    return AL_NO_ERROR;
+}
+
+
 #define DO_UPDATEPROPS() do {                                                 \
     if(!context->DeferUpdates.load(std::memory_order_acquire))                \
         UpdateEffectSlotProps(slot, context.get());                           \
@@ -244,7 +320,8 @@ void FreeEffectSlot(ALCcontext *context, ALeffectslot *slot)
 ALeffectslotArray *ALeffectslot::CreatePtrArray(size_t count) noexcept
 {
     /* Allocate space for twice as many pointers, so the mixer has scratch
-     * space to store a sorted list during mixing.
+     * space to store a sorted list during mixing. It's kept between updates,
+     * and zeroed here to indicate it still needs sorting.
      */
     void *ptr{al_calloc(DEF_ALIGN, ALeffectslotArray::Sizeof(count*2))};
     return new (ptr) ALeffectslotArray{count};
@@ -288,6 +365,8 @@ START_API_FUNC
 
         std::copy(tempids.cbegin(), tempids.cend(), effectslots);
     }
+    if(UNLIKELY(RecordEnabled))
+        RecordGen(context.get(), RecordObject::EffectSlot, n, effectslots);
 
     std::unique_lock<std::mutex> slotlock{context->EffectSlotLock};
     AddActiveEffectSlots(effectslots, n, context.get());
@@ -326,6 +405,9 @@ START_API_FUNC
     if(bad_slot != effectslots_end)
         return;
 
+    if(UNLIKELY(RecordEnabled))
+        RecordDelete(context.get(), RecordObject::EffectSlot, n, effectslots);
+
     // All effectslots are valid, remove and delete them
     RemoveActiveEffectSlots(effectslots, n, context.get());
     std::for_each(effectslots, effectslots_end,
@@ -344,7 +426,6 @@ START_API_FUNC
     ContextRef context{GetContextRef()};
     if(LIKELY(context))
     {
-        std::lock_guard<std::mutex> _{context->EffectSlotLock};
         if(LookupEffectSlot(context.get(), effectslot) != nullptr)
             return AL_TRUE;
     }
@@ -364,6 +445,8 @@ START_API_FUNC
     ALeffectslot *slot = LookupEffectSlot(context.get(), effectslot);
     if(UNLIKELY(!slot))
         SETERR_RETURN(context.get(), AL_INVALID_NAME,, "Invalid effect slot ID %u", effectslot);
+    if(UNLIKELY(RecordEnabled))
+        RecordParamiv(context.get(), RecordObject::EffectSlot, effectslot, param, 1, &value);
 
     ALeffectslot *target{};
     ALCdevice *device{};
@@ -406,6 +489,15 @@ START_API_FUNC
                 SETERR_RETURN(context.get(), AL_INVALID_OPERATION,,
                     "Setting target of effect slot ID %u to %u creates circular chain", slot->id,
                     target->id);
+
+            /* The target needs a buffer to mix into, even without an effect. */
+            try {
+                AllocEffectSlotBuffer(target, context->Device);
+            }
+            catch(std::bad_alloc&) {
+                SETERR_RETURN(context.get(), AL_OUT_OF_MEMORY,,
+                    "Failed to allocate effect slot ID %u's buffer", target->id);
+            }
         }
 
         if(ALeffectslot *oldtarget{slot->Target})
@@ -424,6 +516,40 @@ START_API_FUNC
         slot->Target = target;
         break;
 
+    case AL_EFFECTSLOT_QUALITY_SOFT:
+        if(!(value == AL_QUALITY_DEFAULT_SOFT || value == AL_QUALITY_LOW_SOFT ||
+             value == AL_QUALITY_HIGH_SOFT))
+            SETERR_RETURN(context.get(), AL_INVALID_VALUE,, "Invalid effect slot quality 0x%04x",
+                value);
+        slot->Quality = value;
+        break;
+
+    case AL_BUFFER:
+        device = context->Device;
+
+        { std::lock_guard<std::mutex> ___{device->BufferLock};
+            ALbuffer *buffer{value ? LookupBuffer(device, value) : nullptr};
+            if(value && !buffer)
+                SETERR_RETURN(context.get(), AL_INVALID_VALUE,, "Invalid buffer ID %u", value);
+
+            if(buffer) IncrementRef(&buffer->ref);
+            if(ALbuffer *oldbuffer{slot->Buffer})
+                DecrementRef(&oldbuffer->ref);
+            slot->Buffer = buffer;
+
+            /* Only the convolution effect uses a buffer, so its state needs
+             * to be recreated with the new data.
+             */
+            if(slot->Effect.Type == AL_EFFECT_CONVOLUTION_REVERB_SOFT)
+                err = ReplaceEffectState(context.get(), slot, slot->Effect.Type);
+        }
+        if(err != AL_NO_ERROR)
+        {
+            alSetError(context.get(), err, "Effect state update failed");
+            return;
+        }
+        break;
+
     default:
         SETERR_RETURN(context.get(), AL_INVALID_ENUM,,
                       "Invalid effect slot integer property 0x%04x", param);
@@ -440,6 +566,8 @@ START_API_FUNC
     case AL_EFFECTSLOT_EFFECT:
     case AL_EFFECTSLOT_AUXILIARY_SEND_AUTO:
     case AL_EFFECTSLOT_TARGET_SOFT:
+    case AL_EFFECTSLOT_QUALITY_SOFT:
+    case AL_BUFFER:
         alAuxiliaryEffectSloti(effectslot, param, values[0]);
         return;
     }
@@ -451,6 +579,8 @@ START_API_FUNC
     ALeffectslot *slot = LookupEffectSlot(context.get(), effectslot);
     if(UNLIKELY(!slot))
         SETERR_RETURN(context.get(), AL_INVALID_NAME,, "Invalid effect slot ID %u", effectslot);
+    if(UNLIKELY(RecordEnabled))
+        RecordParamiv(context.get(), RecordObject::EffectSlot, effectslot, param, 1, values);
 
     switch(param)
     {
@@ -472,6 +602,8 @@ START_API_FUNC
     ALeffectslot *slot = LookupEffectSlot(context.get(), effectslot);
     if(UNLIKELY(!slot))
         SETERR_RETURN(context.get(), AL_INVALID_NAME,, "Invalid effect slot ID %u", effectslot);
+    if(UNLIKELY(RecordEnabled))
+        RecordParamfv(context.get(), RecordObject::EffectSlot, effectslot, param, 1, &value);
 
     switch(param)
     {
@@ -506,6 +638,8 @@ START_API_FUNC
     ALeffectslot *slot = LookupEffectSlot(context.get(), effectslot);
     if(UNLIKELY(!slot))
         SETERR_RETURN(context.get(), AL_INVALID_NAME,, "Invalid effect slot ID %u", effectslot);
+    if(UNLIKELY(RecordEnabled))
+        RecordParamfv(context.get(), RecordObject::EffectSlot, effectslot, param, 1, values);
 
     switch(param)
     {
@@ -538,6 +672,14 @@ START_API_FUNC
         *value = slot->Target ? slot->Target->id : 0;
         break;
 
+    case AL_EFFECTSLOT_QUALITY_SOFT:
+        *value = slot->Quality;
+        break;
+
+    case AL_BUFFER:
+        *value = slot->Buffer ? slot->Buffer->id : 0;
+        break;
+
     default:
         SETERR_RETURN(context.get(), AL_INVALID_ENUM,,
                       "Invalid effect slot integer property 0x%04x", param);
@@ -553,6 +695,8 @@ START_API_FUNC
     case AL_EFFECTSLOT_EFFECT:
     case AL_EFFECTSLOT_AUXILIARY_SEND_AUTO:
     case AL_EFFECTSLOT_TARGET_SOFT:
+    case AL_EFFECTSLOT_QUALITY_SOFT:
+    case AL_BUFFER:
         alGetAuxiliaryEffectSloti(effectslot, param, values);
         return;
     }
@@ -618,6 +762,10 @@ START_API_FUNC
 
     switch(param)
     {
+    case AL_EFFECTSLOT_PROCESS_TIME_SOFT:
+        slot->ProcessTime.get(values);
+        break;
+
     default:
         SETERR_RETURN(context.get(), AL_INVALID_ENUM,,
                       "Invalid effect slot float-vector property 0x%04x", param);
@@ -628,31 +776,26 @@ END_API_FUNC
 
 ALenum InitializeEffect(ALCcontext *Context, ALeffectslot *EffectSlot, ALeffect *effect)
 {
+    al::ArenaScope arena_scope{Context->Device->mArena};
     ALenum newtype{effect ? effect->type : AL_EFFECT_NULL};
     if(newtype != EffectSlot->Effect.Type)
     {
-        EffectStateFactory *factory{getFactoryByType(newtype)};
-        if(!factory)
-        {
-            ERR("Failed to find factory for effect type 0x%04x\n", newtype);
-            return AL_INVALID_ENUM;
-        }
-        EffectState *State{factory->create()};
-        if(!State) return AL_OUT_OF_MEMORY;
-
-        FPUCtl mixer_mode{};
-        ALCdevice *Device{Context->Device};
-        std::unique_lock<std::mutex> statelock{Device->StateLock};
-        State->mOutBuffer = Device->Dry.Buffer;
-        State->mOutChannels = Device->Dry.NumChannels;
-        if(State->deviceUpdate(Device) == AL_FALSE)
+        /* The slot needs its mixing buffer before the mixer sees it has an
+         * effect.
+         */
+        if(newtype != AL_EFFECT_NULL)
         {
-            statelock.unlock();
-            mixer_mode.leave();
-            State->DecRef();
-            return AL_OUT_OF_MEMORY;
+            try {
+                AllocEffectSlotBuffer(EffectSlot, Context->Device);
+            }
+            catch(std::bad_alloc&) {
+                return AL_OUT_OF_MEMORY;
+            }
         }
-        mixer_mode.leave();
+
+        ALenum err{ReplaceEffectState(Context, EffectSlot, newtype)};
+        if(err != AL_NO_ERROR)
+            return err;
 
         if(!effect)
         {
@@ -664,23 +807,10 @@ ALenum InitializeEffect(ALCcontext *Context, ALeffectslot *EffectSlot, ALeffect
             EffectSlot->Effect.Type = effect->type;
             EffectSlot->Effect.Props = effect->Props;
         }
-
-        EffectSlot->Effect.State->DecRef();
-        EffectSlot->Effect.State = State;
     }
     else if(effect)
         EffectSlot->Effect.Props = effect->Props;
 
-    /* Remove state references from old effect slot property updates. */
-    ALeffectslotProps *props{Context->FreeEffectslotProps.load()};
-    while(props)
-    {
-        if(props->State)
-            props->State->DecRef();
-        props->State = nullptr;
-        props = props->next.load(std::memory_order_relaxed);
-    }
-
     return AL_NO_ERROR;
 }
 
@@ -699,6 +829,121 @@ void EffectState::DecRef() noexcept
 }
 
 
+namespace {
+
+/* The odd taps on one side of a half-band lowpass filter, from a sinc with a
+ * Kaiser window (beta=8). The even taps are 0, except the center tap of 0.5.
+ * It's flat up to 0.2x the sample rate and over 80dB down past 0.3x.
+ */
+constexpr ALfloat HalfBandCoeffs[EffectHalfRate::FilterTaps]{
+     3.170728513e-01f, -1.024425021e-01f,  5.772404061e-02f, -3.748937911e-02f,
+     2.563768360e-02f, -1.780469905e-02f,  1.231558223e-02f, -8.376209881e-03f,
+     5.543646654e-03f, -3.534414071e-03f,  2.145908431e-03f, -1.222075923e-03f,
+     6.381063336e-04f, -2.935600618e-04f,  1.090362234e-04f, -2.401525086e-05f
+};
+
+} // namespace
+
+constexpr ALsizei EffectHalfRate::FilterTaps;
+constexpr ALsizei EffectHalfRate::InHistory;
+constexpr ALsizei EffectHalfRate::OutHistory;
+constexpr ALuint EffectHalfRate::Latency;
+
+void EffectHalfRate::reset(const ALsizei numInput, const ALsizei numOutput)
+{
+    mSamplesIn.resize(static_cast<size_t>(numInput));
+    mSamplesOut.resize(static_cast<size_t>(numOutput));
+    for(auto &chan : mSamplesOut)
+        chan.fill(0.0f);
+
+    mInLines.resize(static_cast<size_t>(numInput));
+    for(auto &line : mInLines)
+        std::fill_n(line.begin(), InHistory, 0.0f);
+    mInCount = InHistory;
+
+    mOutLines.resize(static_cast<size_t>(numOutput));
+    for(auto &line : mOutLines)
+        std::fill_n(line.begin(), OutHistory, 0.0f);
+    mCarry.assign(static_cast<size_t>(numOutput), 0.0f);
+    mHasCarry = false;
+}
+
+ALsizei EffectHalfRate::decimate(const ALfloat (*RESTRICT samplesIn)[BUFFERSIZE],
+    const ALsizei numInput, const ALsizei samplesToDo)
+{
+    ASSUME(numInput > 0);
+    ASSUME(samplesToDo > 0);
+
+    /* Each half-rate sample is filtered from the full-rate sample at its
+     * center and FilterTaps*2-1 on either side. An odd sample left over stays
+     * in the history for the next update.
+     */
+    const ALsizei total{mInCount + samplesToDo};
+    const ALsizei halfToDo{(total - InHistory + 1) / 2};
+    for(ALsizei c{0};c < numInput;c++)
+    {
+        ALfloat *RESTRICT line{mInLines[static_cast<size_t>(c)].data()};
+        std::copy_n(samplesIn[c], samplesToDo, line+mInCount);
+
+        ALfloat *RESTRICT dst{mSamplesIn[static_cast<size_t>(c)].data()};
+        for(ALsizei i{0};i < halfToDo;i++)
+        {
+            const ALfloat *src{line + FilterTaps*2-1 + i*2};
+            ALfloat sample{src[0] * 0.5f};
+            for(ALsizei j{0};j < FilterTaps;j++)
+                sample += HalfBandCoeffs[j] * (src[-(j*2+1)] + src[j*2+1]);
+            dst[i] = sample;
+        }
+        std::copy(line+halfToDo*2, line+total, line);
+    }
+    mInCount = total - halfToDo*2;
+
+    for(auto &chan : mSamplesOut)
+        std::fill_n(chan.begin(), halfToDo, 0.0f);
+    return halfToDo;
+}
+
+void EffectHalfRate::interpolate(ALfloat (*RESTRICT samplesOut)[BUFFERSIZE],
+    const ALsizei numOutput, const ALsizei samplesToDo, const ALsizei halfToDo)
+{
+    ASSUME(numOutput > 0);
+    ASSUME(samplesToDo > 0);
+
+    /* Each half-rate sample gives a full-rate sample as-is, followed by one
+     * filtered from the FilterTaps samples on either side. Along with the
+     * sample carried over, this makes either samplesToDo or one more; the
+     * extra one gets carried over to the next update.
+     */
+    const ALsizei total{(mHasCarry ? 1 : 0) + halfToDo*2};
+    for(ALsizei c{0};c < numOutput;c++)
+    {
+        ALfloat *RESTRICT line{mOutLines[static_cast<size_t>(c)].data()};
+        std::copy_n(mSamplesOut[static_cast<size_t>(c)].cbegin(), halfToDo, line+OutHistory);
+
+        ALfloat *RESTRICT dst{samplesOut[c]};
+        ALsizei pos{0};
+        if(mHasCarry)
+            dst[pos++] += mCarry[static_cast<size_t>(c)];
+        for(ALsizei i{0};i < halfToDo;i++)
+        {
+            const ALfloat *src{line + FilterTaps-1 + i};
+            ALfloat sample{0.0f};
+            for(ALsizei j{0};j < FilterTaps;j++)
+                sample += HalfBandCoeffs[j] * (src[-j] + src[j+1]);
+            sample *= 2.0f;
+
+            dst[pos++] += src[0];
+            if(pos < samplesToDo)
+                dst[pos++] += sample;
+            else
+                mCarry[static_cast<size_t>(c)] = sample;
+        }
+        std::copy_n(line+halfToDo, OutHistory, line);
+    }
+    mHasCarry = total > samplesToDo;
+}
+
+
 ALenum InitEffectSlot(ALeffectslot *slot)
 {
     EffectStateFactory *factory{getFactoryByType(slot->Effect.Type)};
@@ -711,11 +956,55 @@ ALenum InitEffectSlot(ALeffectslot *slot)
     return AL_NO_ERROR;
 }
 
+void AllocEffectSlotBuffer(ALeffectslot *slot, ALCdevice *device)
+{
+    if(slot->Wet.Buffer) return;
+
+    std::lock_guard<std::mutex> _{device->SlotBufferLock};
+    if(!device->FreeSlotBuffers.empty())
+    {
+        /* Pooled buffers are left silent by the mixer. */
+        slot->Wet.Buffer = device->FreeSlotBuffers.back();
+        device->FreeSlotBuffers.pop_back();
+        return;
+    }
+
+    const size_t count{static_cast<size_t>(device->SlotBufferChannels)};
+    al::ArenaScope arena_scope{device->mArena};
+    void *ptr{al_calloc(16, sizeof(ALfloat[BUFFERSIZE])*count)};
+    if(!ptr) throw std::bad_alloc();
+    slot->Wet.Buffer = static_cast<ALfloat(*)[BUFFERSIZE]>(ptr);
+}
+
+void FreeEffectSlotBuffer(ALeffectslot *slot, ALCdevice *device)
+{
+    if(!slot->Wet.Buffer) return;
+
+    std::lock_guard<std::mutex> _{device->SlotBufferLock};
+    device->FreeSlotBuffers.emplace_back(slot->Wet.Buffer);
+    slot->Wet.Buffer = nullptr;
+}
+
+void ResetEffectSlotBuffers(ALCdevice *device, const ALsizei channels)
+{
+    std::lock_guard<std::mutex> _{device->SlotBufferLock};
+    std::for_each(device->FreeSlotBuffers.begin(), device->FreeSlotBuffers.end(),
+        [](ALfloat (*buffer)[BUFFERSIZE]) noexcept -> void { al_free(buffer); });
+    device->FreeSlotBuffers.clear();
+    device->SlotBufferChannels = channels;
+}
+
 ALeffectslot::~ALeffectslot()
 {
+    al_free(Wet.Buffer);
+    Wet.Buffer = nullptr;
+
     if(Target)
         DecrementRef(&Target->ref);
     Target = nullptr;
+    if(Buffer)
+        DecrementRef(&Buffer->ref);
+    Buffer = nullptr;
 
     ALeffectslotProps *props{Update.load()};
     if(props)
@@ -733,6 +1022,11 @@ ALeffectslot::~ALeffectslot()
 
 void UpdateEffectSlotProps(ALeffectslot *slot, ALCcontext *context)
 {
+    al::ArenaScope arena_scope{context->Device->mArena};
+    /* Release any effect states the mixer replaced since the last update. */
+    if(context->EffectStatesRetired.exchange(false, std::memory_order_acquire))
+        ReleaseRetiredEffectStates(context);
+
     /* Get an unused property container, or allocate a new one as needed. */
     ALeffectslotProps *props{context->FreeEffectslotProps.load(std::memory_order_relaxed)};
     if(!props)
@@ -750,9 +1044,11 @@ void UpdateEffectSlotProps(ALeffectslot *slot, ALCcontext *context)
     props->Gain = slot->Gain;
     props->AuxSendAuto = slot->AuxSendAuto;
     props->Target = slot->Target;
+    props->Quality = slot->Quality;
 
     props->Type = slot->Effect.Type;
     props->Props = slot->Effect.Props;
+    slot->Effect.State->prepare(&props->Props);
     /* Swap out any stale effect state object there may be in the container, to
      * delete it.
      */
@@ -760,6 +1056,8 @@ void UpdateEffectSlotProps(ALeffectslot *slot, ALCcontext *context)
     slot->Effect.State->IncRef();
     props->State = slot->Effect.State;
 
+    props->Batch = context->PublishBatch.load(std::memory_order_relaxed);
+
     /* Set the new container for updating internal parameters. */
     props = slot->Update.exchange(props, std::memory_order_acq_rel);
     if(props)
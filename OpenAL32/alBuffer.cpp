@@ -28,18 +28,29 @@
 #endif
 
 #include <tuple>
+#include <cinttypes>
 #include <array>
 #include <vector>
 #include <limits>
 #include <algorithm>
+#include <chrono>
+#include <exception>
+#include <mutex>
+#include <thread>
 
 #include "alMain.h"
 #include "alcontext.h"
 #include "alu.h"
 #include "alError.h"
 #include "alBuffer.h"
+#include "callrecord.h"
+#include "alSource.h"
 #include "sample_cvt.h"
 #include "alexcpt.h"
+#include "alconfig.h"
+#include "compat.h"
+#include "mixerpool.h"
+#include "backends/base.h"
 
 
 namespace {
@@ -50,15 +61,48 @@ constexpr ALbitfieldSOFT MAP_READ_WRITE_FLAGS{AL_MAP_READ_BIT_SOFT | AL_MAP_WRIT
 constexpr ALbitfieldSOFT INVALID_MAP_FLAGS{~unsigned(AL_MAP_READ_BIT_SOFT | AL_MAP_WRITE_BIT_SOFT |
     AL_MAP_PERSISTENT_BIT_SOFT)};
 
+/* Sample frames stored past the end of padded buffers. A mix loads at most
+ * this many frames, so it can always load across the loop end in one run.
+ */
+constexpr ALsizei LoopPaddingFrames{BUFFERSIZE + MAX_RESAMPLE_PADDING*2};
+
+
+/* Copies the buffer's properties to its info block for the getters. Must be
+ * called with BufferLock held after any of them change.
+ */
+void PublishBufferInfo(ALCdevice *device, const ALbuffer *buffer)
+{
+    const ALuint id{buffer->id - 1};
+    BufferInfo &info = device->BufferList[id >> 6].Infos[id & 0x3f];
+
+    const ALuint seq{info.Seq.load(std::memory_order_relaxed)};
+    info.Seq.store(seq+1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    constexpr int64_t maxint{std::numeric_limits<ALint>::max()};
+    info.Frequency.store(buffer->Frequency, std::memory_order_relaxed);
+    info.Bits.store(BytesFromFmt(buffer->mFmtType) * 8, std::memory_order_relaxed);
+    info.Channels.store(ChannelsFromFmt(buffer->mFmtChannels), std::memory_order_relaxed);
+    info.Size.store(static_cast<ALint>(mini64(
+        buffer->SampleLen * FrameSizeFromFmt(buffer->mFmtChannels, buffer->mFmtType), maxint)),
+        std::memory_order_relaxed);
+    info.LoopStart.store(static_cast<ALint>(mini64(buffer->LoopStart, maxint)),
+        std::memory_order_relaxed);
+    info.LoopEnd.store(static_cast<ALint>(mini64(buffer->LoopEnd, maxint)),
+        std::memory_order_relaxed);
+    info.UnpackAlign.store(buffer->UnpackAlign.load(), std::memory_order_relaxed);
+    info.PackAlign.store(buffer->PackAlign.load(), std::memory_order_relaxed);
+    info.WantResampleCache.store(buffer->WantResampleCache, std::memory_order_relaxed);
+
+    info.Seq.store(seq+2, std::memory_order_release);
+}
 
 ALbuffer *AllocBuffer(ALCcontext *context)
 {
     ALCdevice *device{context->Device};
     std::lock_guard<std::mutex> _{device->BufferLock};
-    auto sublist = std::find_if(device->BufferList.begin(), device->BufferList.end(),
-        [](const BufferSubList &entry) noexcept -> bool
-        { return entry.FreeMask != 0; }
-    );
+    const ptrdiff_t freelist{device->BufferFreeMap.find()};
+    auto sublist = (freelist < 0) ? device->BufferList.end() : (device->BufferList.begin() + freelist);
 
     auto lidx = static_cast<ALsizei>(std::distance(device->BufferList.begin(), sublist));
     ALbuffer *buffer{nullptr};
@@ -82,48 +126,170 @@ ALbuffer *AllocBuffer(ALCcontext *context)
         sublist = device->BufferList.end() - 1;
         sublist->FreeMask = ~0_u64;
         sublist->Buffers = reinterpret_cast<ALbuffer*>(al_calloc(16, sizeof(ALbuffer)*64));
-        if(UNLIKELY(!sublist->Buffers))
+        sublist->Infos = reinterpret_cast<BufferInfo*>(al_calloc(16, sizeof(BufferInfo)*64));
+        if(UNLIKELY(!sublist->Buffers || !sublist->Infos))
         {
             device->BufferList.pop_back();
             alSetError(context, AL_OUT_OF_MEMORY, "Failed to allocate buffer batch");
             return nullptr;
         }
+        for(ALsizei i{0};i < 64;i++)
+            new (sublist->Infos + i) BufferInfo{};
 
         slidx = 0;
         buffer = sublist->Buffers + slidx;
     }
 
-    buffer = new (buffer) ALbuffer{};
+    /* The ref count keeps the deleted buffer's claim until the new buffer is
+     * ready, so a source still attaching the old one waits on BufferLock.
+     */
+    buffer = new (buffer) ALbuffer;
     /* Add 1 to avoid buffer ID 0. */
     buffer->id = ((lidx<<6) | slidx) + 1;
+    PublishBufferInfo(device, buffer);
 
     sublist->FreeMask &= ~(1_u64 << slidx);
+    device->BufferFreeMap.set(static_cast<size_t>(lidx), sublist->FreeMask != 0);
+    buffer->ref.store(0u, std::memory_order_release);
 
     return buffer;
 }
 
+/* Takes storage for size bytes from the device's buffer pool, or allocates it
+ * if none fits. Pooled storage over twice the size is left for bigger buffers.
+ */
+al::vector<ALbyte,16> AcquireBufferStorage(ALCdevice *device, ALsizei size)
+{
+    const auto needed = static_cast<size_t>(size);
+    auto iter = std::find_if(device->BufferPool.begin(), device->BufferPool.end(),
+        [needed](const al::vector<ALbyte,16> &data) noexcept -> bool
+        { return data.capacity() >= needed && data.capacity()/2 <= needed; }
+    );
+    if(iter == device->BufferPool.end())
+        return al::vector<ALbyte,16>(needed);
+
+    al::vector<ALbyte,16> data{std::move(*iter)};
+    device->BufferPool.erase(iter);
+    device->BufferPoolSize -= data.capacity();
+    data.resize(needed);
+    return data;
+}
+
+/* Gives the storage to the device's buffer pool if there's room, otherwise
+ * frees it. The storage is left empty either way.
+ */
+void ReleaseBufferStorage(ALCdevice *device, al::vector<ALbyte,16> &data)
+{
+    const size_t size{data.capacity()};
+    if(size > 0 && size <= device->BufferPoolLimit - device->BufferPoolSize)
+    {
+        device->BufferPool.emplace_back(std::move(data));
+        device->BufferPoolSize += size;
+    }
+    al::vector<ALbyte,16>{}.swap(data);
+}
+
 void FreeBuffer(ALCdevice *device, ALbuffer *buffer)
 {
     ALuint id{buffer->id - 1};
     ALsizei lidx = id >> 6;
     ALsizei slidx = id & 0x3f;
 
-    buffer->~ALbuffer();
-
+    /* The buffer is freed in the list before it's destroyed, so a lookup
+     * can't find it partly destroyed.
+     */
     device->BufferList[lidx].FreeMask |= 1_u64 << slidx;
+    device->BufferFreeMap.set(static_cast<size_t>(lidx), true);
+
+    DetachResampleCache(device, buffer);
+    ReleaseBufferStorage(device, buffer->mData);
+    buffer->~ALbuffer();
 }
 
+/* Claims an unattached buffer for as long as this is held, so sources can't
+ * attach it while it's modified. BufferLock must be held for longer, since
+ * sources that find the buffer claimed wait on the lock.
+ */
+class BufferClaim {
+    ALbuffer *mBuffer{nullptr};
+
+public:
+    BufferClaim() noexcept = default;
+    explicit BufferClaim(ALbuffer *buffer) noexcept
+    {
+        unsigned int expected{0u};
+        if(buffer->ref.compare_exchange_strong(expected, BUFFER_REF_CLAIMED,
+            std::memory_order_acq_rel))
+            mBuffer = buffer;
+    }
+    BufferClaim(BufferClaim&& rhs) noexcept : mBuffer{rhs.mBuffer} { rhs.mBuffer = nullptr; }
+    ~BufferClaim() { if(mBuffer) mBuffer->ref.store(0u, std::memory_order_release); }
+
+    BufferClaim& operator=(BufferClaim&& rhs) noexcept
+    { std::swap(mBuffer, rhs.mBuffer); return *this; }
+
+    explicit operator bool() const noexcept { return mBuffer != nullptr; }
+
+    /* Leaves the buffer claimed, for it to be deleted. */
+    void keep() noexcept { mBuffer = nullptr; }
+};
+
+/* Sublists are never moved or freed while the device is open, so this may be
+ * called without BufferLock. Callers without the lock must only use the
+ * result to check the ID, and read the properties from LookupBufferInfo,
+ * since the buffer may be respecified or deleted while it's being read.
+ */
 inline ALbuffer *LookupBuffer(ALCdevice *device, ALuint id)
 {
     ALuint lidx = (id-1) >> 6;
     ALsizei slidx = (id-1) & 0x3f;
 
-    if(UNLIKELY(lidx >= device->BufferList.size()))
+    BufferSubList *sublist{device->BufferList.lookup(lidx)};
+    if(UNLIKELY(!sublist))
         return nullptr;
-    BufferSubList &sublist = device->BufferList[lidx];
-    if(UNLIKELY(sublist.FreeMask & (1_u64 << slidx)))
+    if(UNLIKELY(sublist->FreeMask.load(std::memory_order_acquire) & (1_u64 << slidx)))
         return nullptr;
-    return sublist.Buffers + slidx;
+    return sublist->Buffers + slidx;
+}
+
+/* Copy of a buffer's published properties, for the getters. */
+struct BufferProps {
+    ALint Frequency, Bits, Channels, Size;
+    ALint LoopStart, LoopEnd;
+    ALint UnpackAlign, PackAlign;
+    ALint WantResampleCache;
+};
+
+/* Reads the buffer's published properties without BufferLock. Retries if the
+ * properties are updated while being copied, so the copy is consistent.
+ */
+bool LookupBufferInfo(ALCdevice *device, ALuint id, BufferProps *props)
+{
+    ALuint lidx = (id-1) >> 6;
+    ALsizei slidx = (id-1) & 0x3f;
+
+    BufferSubList *sublist{device->BufferList.lookup(lidx)};
+    if(UNLIKELY(!sublist))
+        return false;
+    if(UNLIKELY(sublist->FreeMask.load(std::memory_order_acquire) & (1_u64 << slidx)))
+        return false;
+
+    const BufferInfo &info = sublist->Infos[slidx];
+    ALuint seq;
+    do {
+        seq = info.Seq.load(std::memory_order_acquire);
+        props->Frequency = info.Frequency.load(std::memory_order_relaxed);
+        props->Bits = info.Bits.load(std::memory_order_relaxed);
+        props->Channels = info.Channels.load(std::memory_order_relaxed);
+        props->Size = info.Size.load(std::memory_order_relaxed);
+        props->LoopStart = info.LoopStart.load(std::memory_order_relaxed);
+        props->LoopEnd = info.LoopEnd.load(std::memory_order_relaxed);
+        props->UnpackAlign = info.UnpackAlign.load(std::memory_order_relaxed);
+        props->PackAlign = info.PackAlign.load(std::memory_order_relaxed);
+        props->WantResampleCache = info.WantResampleCache.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } while(UNLIKELY((seq&1) || seq != info.Seq.load(std::memory_order_relaxed)));
+    return true;
 }
 
 
@@ -174,22 +340,141 @@ const ALchar *NameFromUserFmtType(UserFmtType type)
     case UserFmtDouble: return "Float64";
     case UserFmtMulaw: return "muLaw";
     case UserFmtAlaw: return "aLaw";
+    case UserFmtInt24: return "Signed Int24";
+    case UserFmtInt: return "Signed Int";
     case UserFmtIMA4: return "IMA4 ADPCM";
     case UserFmtMSADPCM: return "MSADPCM";
     }
     return "<internal type error>";
 }
 
+/* Gives any app-owned storage back to the app. */
+void ReleaseExternalData(ALbuffer *ALBuf)
+{
+    if(ALBuf->ExternalRelease)
+        ALBuf->ExternalRelease(ALBuf->ExternalUserPtr, ALBuf->ExternalData);
+    ALBuf->ExternalData = nullptr;
+    ALBuf->ExternalRelease = nullptr;
+    ALBuf->ExternalUserPtr = nullptr;
+    ALBuf->FileReadAhead = 0;
+}
+
+void AL_APIENTRY UnmapBufferFile(ALvoid *userptr, ALvoid*)
+{
+    auto mapping = static_cast<FileMapping*>(userptr);
+    UnmapFileMem(mapping);
+    delete mapping;
+}
+
+/* App-owned memory for a buffer to use as its storage. */
+struct ExternalStorage {
+    ALvoid *data;
+    ALBUFFERRELEASETYPESOFT release;
+    ALvoid *userptr;
+};
+
+/* A copy of an upload's samples into a buffer's storage, which may be deferred
+ * to run with others in parallel.
+ */
+struct BufferCopy {
+    ALbyte *dst;
+    const ALbyte *src;
+    size_t size;
+};
+
+/* Uploads smaller than this in total are copied on the calling thread, while
+ * larger ones are split into chunks of this size to copy in parallel.
+ */
+constexpr size_t ParallelCopyChunk{256u * 1024u};
+
+std::mutex BufferCopyLock;
+std::unique_ptr<MixerPool> BufferCopyPool;
+bool BufferCopyPoolInit{false};
+
+/* Runs the given copies, spread across the buffer copy threads when they're
+ * large enough to be worth it. If another thread is using the pool, they're
+ * done on the calling thread instead of waiting.
+ */
+void RunBufferCopies(const al::vector<BufferCopy> &copies)
+{
+    size_t total{0u};
+    for(const BufferCopy &copy : copies)
+        total += copy.size;
+
+    std::unique_lock<std::mutex> poollock;
+    if(total >= ParallelCopyChunk*2)
+    {
+        poollock = std::unique_lock<std::mutex>{BufferCopyLock, std::try_to_lock};
+        if(poollock && !BufferCopyPoolInit)
+        {
+            BufferCopyPoolInit = true;
+
+            ALint numthreads{static_cast<ALint>(std::thread::hardware_concurrency())};
+            ConfigValueInt(nullptr, nullptr, "buffer-load-threads", &numthreads);
+            numthreads = clampi(numthreads, 1, MAX_MIX_THREADS);
+            if(numthreads > 1)
+            {
+                try {
+                    BufferCopyPool = std::unique_ptr<MixerPool>{
+                        new MixerPool{static_cast<size_t>(numthreads-1),
+                            std::chrono::microseconds{0}}};
+                    TRACE("Loading buffer data with %d threads\n", numthreads);
+                }
+                catch(std::exception &e) {
+                    ERR("Failed to start buffer load threads: %s\n", e.what());
+                }
+            }
+        }
+    }
+    if(!poollock || !BufferCopyPool)
+    {
+        for(const BufferCopy &copy : copies)
+            std::copy_n(copy.src, copy.size, copy.dst);
+        return;
+    }
+
+    al::vector<BufferCopy> chunks;
+    chunks.reserve(total/ParallelCopyChunk + copies.size());
+    for(const BufferCopy &copy : copies)
+    {
+        for(size_t offset{0u};offset < copy.size;offset += ParallelCopyChunk)
+            chunks.emplace_back(BufferCopy{copy.dst+offset, copy.src+offset,
+                minz(copy.size-offset, ParallelCopyChunk)});
+    }
+    BufferCopyPool->run(chunks.size(),
+        [&chunks](size_t idx) -> void
+        {
+            const BufferCopy &chunk = chunks[idx];
+            std::copy_n(chunk.src, chunk.size, chunk.dst);
+        });
+}
+
+
+/* The layout of samples to be stored in a buffer, as worked out by
+ * CheckLoadData.
+ */
+struct LoadLayout {
+    FmtChannels DstChannels;
+    FmtType DstType;
+    ALsizei Align;
+    int64_t Frames;
+    int64_t DataSize;
+};
+
 /*
- * LoadData
+ * CheckLoadData
  *
- * Loads the specified data into the buffer, using the specified format.
+ * Checks that the specified data can be loaded into the buffer, and works out
+ * how it will be stored. Sets an error and returns false if it can't, without
+ * modifying the buffer. The buffer is claimed with claim, which the caller
+ * holds until the data is stored.
  */
-void LoadData(ALCcontext *context, ALbuffer *ALBuf, ALuint freq, ALsizei size, UserFmtChannels SrcChannels, UserFmtType SrcType, const ALvoid *data, ALbitfieldSOFT access)
+bool CheckLoadData(ALCcontext *context, ALbuffer *ALBuf, int64_t size, UserFmtChannels SrcChannels, UserFmtType SrcType, ALbitfieldSOFT access, const ExternalStorage *ext, BufferClaim *claim, LoadLayout *layout)
 {
-    if(UNLIKELY(ReadRef(&ALBuf->ref) != 0 || ALBuf->MappedAccess != 0))
-        SETERR_RETURN(context, AL_INVALID_OPERATION,, "Modifying storage for in-use buffer %u",
-                      ALBuf->id);
+    *claim = BufferClaim{ALBuf};
+    if(UNLIKELY(!*claim || ALBuf->MappedAccess != 0))
+        SETERR_RETURN(context, AL_INVALID_OPERATION, false,
+            "Modifying storage for in-use buffer %u", ALBuf->id);
 
     /* Currently no channel configurations need to be converted. */
     FmtChannels DstChannels{FmtMono};
@@ -207,9 +492,9 @@ void LoadData(ALCcontext *context, ALbuffer *ALBuf, ALuint freq, ALsizei size, U
     }
     if (UNLIKELY(static_cast<long>(SrcChannels) !=
                  static_cast<long>(DstChannels)))
-        SETERR_RETURN(context, AL_INVALID_ENUM, , "Invalid format");
+        SETERR_RETURN(context, AL_INVALID_ENUM, false, "Invalid format");
 
-    /* IMA4 and MSADPCM convert to 16-bit short. */
+    /* IMA4 and MSADPCM are kept compressed. */
     FmtType DstType{FmtUByte};
     switch(SrcType)
     {
@@ -219,18 +504,22 @@ void LoadData(ALCcontext *context, ALbuffer *ALBuf, ALuint freq, ALsizei size, U
     case UserFmtDouble: DstType = FmtDouble; break;
     case UserFmtAlaw: DstType = FmtAlaw; break;
     case UserFmtMulaw: DstType = FmtMulaw; break;
-    case UserFmtIMA4: DstType = FmtShort; break;
-    case UserFmtMSADPCM: DstType = FmtShort; break;
+    case UserFmtInt24: DstType = FmtInt24; break;
+    case UserFmtInt: DstType = FmtInt; break;
+    case UserFmtIMA4: DstType = FmtIMA4; break;
+    case UserFmtMSADPCM: DstType = FmtMSADPCM; break;
     }
 
     /* TODO: Currently we can only map samples when they're not converted. To
      * allow it would need some kind of double-buffering to hold onto a copy of
-     * the original data.
+     * the original data. ADPCM samples can't be mapped either, since they're
+     * not stored as individual samples.
      */
     if((access&MAP_READ_WRITE_FLAGS))
     {
-        if (UNLIKELY(static_cast<long>(SrcType) != static_cast<long>(DstType)))
-          SETERR_RETURN(context, AL_INVALID_VALUE, ,
+        if(UNLIKELY(static_cast<long>(SrcType) != static_cast<long>(DstType) ||
+            IsADPCMFmt(DstType)))
+          SETERR_RETURN(context, AL_INVALID_VALUE, false,
                         "%s samples cannot be mapped",
                         NameFromUserFmtType(SrcType));
     }
@@ -238,88 +527,168 @@ void LoadData(ALCcontext *context, ALbuffer *ALBuf, ALuint freq, ALsizei size, U
     ALsizei unpackalign{ALBuf->UnpackAlign.load()};
     ALsizei align{SanitizeAlignment(SrcType, unpackalign)};
     if(UNLIKELY(align < 1))
-        SETERR_RETURN(context, AL_INVALID_VALUE,, "Invalid unpack alignment %d for %s samples",
+        SETERR_RETURN(context, AL_INVALID_VALUE, false, "Invalid unpack alignment %d for %s samples",
                       unpackalign, NameFromUserFmtType(SrcType));
 
     if((access&AL_PRESERVE_DATA_BIT_SOFT))
     {
         /* Can only preserve data with the same format and alignment. */
         if(UNLIKELY(ALBuf->mFmtChannels != DstChannels || ALBuf->OriginalType != SrcType))
-            SETERR_RETURN(context, AL_INVALID_VALUE,, "Preserving data of mismatched format");
+            SETERR_RETURN(context, AL_INVALID_VALUE, false, "Preserving data of mismatched format");
         if(UNLIKELY(ALBuf->OriginalAlign != align))
-            SETERR_RETURN(context, AL_INVALID_VALUE,, "Preserving data of mismatched alignment");
+            SETERR_RETURN(context, AL_INVALID_VALUE, false, "Preserving data of mismatched alignment");
+        if(UNLIKELY(ALBuf->ExternalData != nullptr))
+            SETERR_RETURN(context, AL_INVALID_VALUE, false, "Preserving data of external storage");
     }
 
     /* Convert the input/source size in bytes to sample frames using the unpack
      * block alignment.
      */
-    ALsizei SrcByteAlign{
+    const ALsizei SrcByteAlign{
         (SrcType == UserFmtIMA4) ? ((align-1)/2 + 4) * ChannelsFromUserFmt(SrcChannels) :
         (SrcType == UserFmtMSADPCM) ? ((align-2)/2 + 7) * ChannelsFromUserFmt(SrcChannels) :
         (align * FrameSizeFromUserFmt(SrcChannels, SrcType))
     };
     if(UNLIKELY((size%SrcByteAlign) != 0))
-        SETERR_RETURN(context, AL_INVALID_VALUE,,
-            "Data size %d is not a multiple of frame size %d (%d unpack alignment)",
+        SETERR_RETURN(context, AL_INVALID_VALUE, false,
+            "Data size %" PRId64 " is not a multiple of frame size %d (%d unpack alignment)",
             size, SrcByteAlign, align);
 
-    if(UNLIKELY(size/SrcByteAlign > std::numeric_limits<ALsizei>::max()/align))
-        SETERR_RETURN(context, AL_OUT_OF_MEMORY,,
-            "Buffer size overflow, %d blocks x %d samples per block", size/SrcByteAlign, align);
-    ALsizei frames{size / SrcByteAlign * align};
+    /* Only external storage can be larger than 32-bit sizes allow. */
+    const int64_t maxsize{ext ? std::numeric_limits<int64_t>::max() :
+        int64_t{std::numeric_limits<ALsizei>::max()}};
+    if(UNLIKELY(size/SrcByteAlign > maxsize/align))
+        SETERR_RETURN(context, AL_OUT_OF_MEMORY, false,
+            "Buffer size overflow, %" PRId64 " blocks x %d samples per block",
+            size/SrcByteAlign, align);
+    const int64_t frames{size / SrcByteAlign * align};
 
     /* Convert the sample frames to the number of bytes needed for internal
-     * storage.
+     * storage. ADPCM blocks are stored as given.
      */
     ALsizei NumChannels{ChannelsFromFmt(DstChannels)};
     ALsizei FrameSize{NumChannels * BytesFromFmt(DstType)};
-    if(UNLIKELY(frames > std::numeric_limits<ALsizei>::max()/FrameSize))
-        SETERR_RETURN(context, AL_OUT_OF_MEMORY,,
-            "Buffer size overflow, %d frames x %d bytes per frame", frames, FrameSize);
-    ALsizei newsize{frames*FrameSize};
-
-    /* Round up to the next 16-byte multiple. This could reallocate only when
-     * increasing or the new size is less than half the current, but then the
-     * buffer's AL_SIZE would not be very reliable for accounting buffer memory
-     * usage, and reporting the real size could cause problems for apps that
-     * use AL_SIZE to try to get the buffer's play length.
-     */
-    if(LIKELY(newsize <= std::numeric_limits<ALsizei>::max()-15))
-        newsize = (newsize+15) & ~0xf;
-    if(newsize != ALBuf->BytesAlloc)
-    {
-        al::vector<ALbyte,16> newdata(newsize);
-        if((access&AL_PRESERVE_DATA_BIT_SOFT))
-        {
-            ALsizei tocopy{std::min(newsize, ALBuf->BytesAlloc)};
-            std::copy_n(ALBuf->mData.begin(), tocopy, newdata.begin());
-        }
-        ALBuf->mData = std::move(newdata);
-        ALBuf->BytesAlloc = newsize;
-    }
+    if(UNLIKELY(!IsADPCMFmt(DstType) && frames > maxsize/FrameSize))
+        SETERR_RETURN(context, AL_OUT_OF_MEMORY, false,
+            "Buffer size overflow, %" PRId64 " frames x %d bytes per frame", frames, FrameSize);
+    const int64_t datasize{IsADPCMFmt(DstType) ? size : frames*FrameSize};
+
+    layout->DstChannels = DstChannels;
+    layout->DstType = DstType;
+    layout->Align = align;
+    layout->Frames = frames;
+    layout->DataSize = datasize;
+    return true;
+}
 
-    if(SrcType == UserFmtIMA4)
+/*
+ * FillLoopPadding
+ *
+ * Copies the samples from the buffer's loop start into the padding past its
+ * end, repeating them for loops shorter than the padding. Must be called after
+ * the samples or loop points change.
+ */
+void FillLoopPadding(ALbuffer *ALBuf)
+{
+    if(ALBuf->LoopPadding == 0 || ALBuf->LoopEnd != ALBuf->SampleLen)
+        return;
+
+    const auto FrameSize = static_cast<size_t>(ChannelsFromFmt(ALBuf->mFmtChannels) *
+        BytesFromFmt(ALBuf->mFmtType));
+    const ALbyte *loopstart{ALBuf->mData.data() + ALBuf->LoopStart*FrameSize};
+    const auto loopsize = static_cast<size_t>(ALBuf->LoopEnd - ALBuf->LoopStart) * FrameSize;
+
+    ALbyte *dst{ALBuf->mData.data() + ALBuf->LoopEnd*FrameSize};
+    size_t todo{static_cast<size_t>(ALBuf->LoopPadding) * FrameSize};
+    while(todo > 0)
     {
-        assert(DstType == FmtShort);
-        if(data != nullptr && !ALBuf->mData.empty())
-            Convert_ALshort_ALima4(reinterpret_cast<ALshort*>(ALBuf->mData.data()),
-                static_cast<const ALubyte*>(data), NumChannels, frames, align);
-        ALBuf->OriginalAlign = align;
+        const size_t count{std::min(todo, loopsize)};
+        dst = std::copy_n(loopstart, count, dst);
+        todo -= count;
     }
-    else if(SrcType == UserFmtMSADPCM)
+}
+
+/*
+ * StoreData
+ *
+ * Sets the buffer's storage for data checked by CheckLoadData. The copy of the
+ * samples, if any, is added to copies for the caller to run.
+ */
+void StoreData(ALCcontext *context, ALbuffer *ALBuf, ALuint freq, int64_t size, UserFmtType SrcType, const ALvoid *data, ALbitfieldSOFT access, const ExternalStorage *ext, const LoadLayout &layout, al::vector<BufferCopy> *copies)
+{
+    const FmtChannels DstChannels{layout.DstChannels};
+    const FmtType DstType{layout.DstType};
+    const ALsizei align{layout.Align};
+    const int64_t datasize{layout.DataSize};
+    assert(static_cast<long>(SrcType) == static_cast<long>(DstType));
+
+    DetachResampleCache(context->Device, ALBuf);
+    if(ext)
     {
-        assert(DstType == FmtShort);
-        if(data != nullptr && !ALBuf->mData.empty())
-            Convert_ALshort_ALmsadpcm(reinterpret_cast<ALshort*>(ALBuf->mData.data()),
-                static_cast<const ALubyte*>(data), NumChannels, frames, align);
-        ALBuf->OriginalAlign = align;
+        /* Every format is stored as given, so external storage can be used
+         * directly.
+         */
+        ReleaseExternalData(ALBuf);
+        ReleaseBufferStorage(context->Device, ALBuf->mData);
+        ALBuf->BytesAlloc = 0;
+
+        ALBuf->ExternalData = static_cast<ALbyte*>(ext->data);
+        ALBuf->ExternalRelease = ext->release;
+        ALBuf->ExternalUserPtr = ext->userptr;
+        ALBuf->OriginalAlign = IsADPCMFmt(DstType) ? align : 1;
+        ALBuf->LoopPadding = 0;
     }
     else
     {
-        assert(static_cast<long>(SrcType) == static_cast<long>(DstType));
+        /* Buffers that can't change while playing may be padded to loop
+         * without stitching.
+         */
+        const ALsizei FrameSize{ChannelsFromFmt(DstChannels) * BytesFromFmt(DstType)};
+        const bool padded{context->Device->LoopPadding && layout.Frames > 0 &&
+            !IsADPCMFmt(DstType) && !(access&AL_MAP_WRITE_BIT_SOFT) &&
+            datasize <= std::numeric_limits<ALsizei>::max()-15 - LoopPaddingFrames*FrameSize};
+        ALBuf->LoopPadding = padded ? LoopPaddingFrames : 0;
+
+        ALsizei newsize{static_cast<ALsizei>(datasize + ALBuf->LoopPadding*FrameSize)};
+        /* Round up to the next 16-byte multiple. This could reallocate only
+         * when increasing or the new size is less than half the current, but
+         * then the buffer's AL_SIZE would not be very reliable for accounting
+         * buffer memory usage, and reporting the real size could cause
+         * problems for apps that use AL_SIZE to try to get the buffer's play
+         * length.
+         */
+        if(LIKELY(newsize <= std::numeric_limits<ALsizei>::max()-15))
+            newsize = (newsize+15) & ~0xf;
+        if(newsize != ALBuf->BytesAlloc)
+        {
+            /* Resize the current storage in place if it has the capacity and
+             * wouldn't be left mostly unused, which also keeps its contents.
+             * Otherwise swap in storage from the device's pool.
+             */
+            const size_t capacity{ALBuf->mData.capacity()};
+            if(static_cast<size_t>(newsize) <= capacity &&
+                static_cast<size_t>(newsize) >= capacity/2)
+                ALBuf->mData.resize(static_cast<size_t>(newsize));
+            else
+            {
+                al::vector<ALbyte,16> newdata{AcquireBufferStorage(context->Device, newsize)};
+                if((access&AL_PRESERVE_DATA_BIT_SOFT))
+                {
+                    ALsizei tocopy{std::min(newsize, ALBuf->BytesAlloc)};
+                    std::copy_n(ALBuf->mData.begin(), tocopy, newdata.begin());
+                }
+                ReleaseBufferStorage(context->Device, ALBuf->mData);
+                ALBuf->mData = std::move(newdata);
+            }
+            ALBuf->BytesAlloc = newsize;
+        }
+
+        ReleaseExternalData(ALBuf);
+
         if(data != nullptr && !ALBuf->mData.empty())
-            std::copy_n(static_cast<const ALbyte*>(data), frames*FrameSize, ALBuf->mData.begin());
-        ALBuf->OriginalAlign = 1;
+            copies->emplace_back(BufferCopy{ALBuf->mData.data(),
+                static_cast<const ALbyte*>(data), static_cast<size_t>(datasize)});
+        ALBuf->OriginalAlign = IsADPCMFmt(DstType) ? align : 1;
     }
     ALBuf->OriginalSize = size;
     ALBuf->OriginalType = SrcType;
@@ -329,9 +698,76 @@ void LoadData(ALCcontext *context, ALbuffer *ALBuf, ALuint freq, ALsizei size, U
     ALBuf->mFmtType = DstType;
     ALBuf->Access = access;
 
-    ALBuf->SampleLen = frames;
+    ALBuf->SampleLen = layout.Frames;
     ALBuf->LoopStart = 0;
     ALBuf->LoopEnd = ALBuf->SampleLen;
+
+    ALBuf->Callback = nullptr;
+    ALBuf->UserData = nullptr;
+    PublishBufferInfo(context->Device, ALBuf);
+}
+
+
+/*
+ * LoadData
+ *
+ * Loads the specified data into the buffer, using the specified format. With
+ * external storage, the buffer uses the app's memory instead of a copy.
+ */
+void LoadData(ALCcontext *context, ALbuffer *ALBuf, ALuint freq, int64_t size, UserFmtChannels SrcChannels, UserFmtType SrcType, const ALvoid *data, ALbitfieldSOFT access, const ExternalStorage *ext)
+{
+    BufferClaim claim;
+    LoadLayout layout;
+    if(!CheckLoadData(context, ALBuf, size, SrcChannels, SrcType, access, ext, &claim, &layout))
+        return;
+
+    al::vector<BufferCopy> copies;
+    StoreData(context, ALBuf, freq, size, SrcType, data, access, ext, layout, &copies);
+    RunBufferCopies(copies);
+    FillLoopPadding(ALBuf);
+}
+
+/*
+ * PrepareCallback
+ *
+ * Sets the buffer to get its samples from the callback as it's played,
+ * instead of storing them.
+ */
+void PrepareCallback(ALCcontext *context, ALbuffer *ALBuf, ALsizei freq, UserFmtChannels SrcChannels, UserFmtType SrcType, ALBUFFERCALLBACKTYPESOFT callback, ALvoid *userptr, ALbitfieldSOFT flags)
+{
+    BufferClaim claim{ALBuf};
+    if(UNLIKELY(!claim || ALBuf->MappedAccess != 0))
+        SETERR_RETURN(context, AL_INVALID_OPERATION,, "Modifying callback for in-use buffer %u",
+                      ALBuf->id);
+    DetachResampleCache(context->Device, ALBuf);
+
+    /* ADPCM blocks can't be pulled in arbitrary sample counts. */
+    if(UNLIKELY(SrcType == UserFmtIMA4 || SrcType == UserFmtMSADPCM))
+        SETERR_RETURN(context, AL_INVALID_ENUM,, "Unsupported callback format %s",
+                      NameFromUserFmtType(SrcType));
+
+    ReleaseExternalData(ALBuf);
+    ReleaseBufferStorage(context->Device, ALBuf->mData);
+    ALBuf->BytesAlloc = 0;
+
+    ALBuf->OriginalSize = 0;
+    ALBuf->OriginalType = SrcType;
+    ALBuf->OriginalAlign = 1;
+
+    ALBuf->Frequency = freq;
+    ALBuf->mFmtChannels = static_cast<FmtChannels>(SrcChannels);
+    ALBuf->mFmtType = static_cast<FmtType>(SrcType);
+    ALBuf->Access = 0;
+
+    ALBuf->SampleLen = 0;
+    ALBuf->LoopStart = 0;
+    ALBuf->LoopEnd = 0;
+    ALBuf->LoopPadding = 0;
+
+    ALBuf->Callback = callback;
+    ALBuf->UserData = userptr;
+    ALBuf->CallbackFlags = flags;
+    PublishBufferInfo(context->Device, ALBuf);
 }
 
 using DecompResult = std::tuple<bool, UserFmtChannels, UserFmtType>;
@@ -342,7 +778,7 @@ DecompResult DecomposeUserFormat(ALenum format)
         UserFmtChannels channels;
         UserFmtType type;
     };
-    static constexpr std::array<FormatMap,46> UserFmtList{{
+    static constexpr std::array<FormatMap,58> UserFmtList{{
         { AL_FORMAT_MONO8,             UserFmtMono, UserFmtUByte   },
         { AL_FORMAT_MONO16,            UserFmtMono, UserFmtShort   },
         { AL_FORMAT_MONO_FLOAT32,      UserFmtMono, UserFmtFloat   },
@@ -351,6 +787,8 @@ DecompResult DecomposeUserFormat(ALenum format)
         { AL_FORMAT_MONO_MSADPCM_SOFT, UserFmtMono, UserFmtMSADPCM },
         { AL_FORMAT_MONO_MULAW,        UserFmtMono, UserFmtMulaw   },
         { AL_FORMAT_MONO_ALAW_EXT,     UserFmtMono, UserFmtAlaw    },
+        { AL_FORMAT_MONO_I24_SOFT,     UserFmtMono, UserFmtInt24   },
+        { AL_FORMAT_MONO_I32_SOFT,     UserFmtMono, UserFmtInt     },
 
         { AL_FORMAT_STEREO8,             UserFmtStereo, UserFmtUByte   },
         { AL_FORMAT_STEREO16,            UserFmtStereo, UserFmtShort   },
@@ -360,6 +798,8 @@ DecompResult DecomposeUserFormat(ALenum format)
         { AL_FORMAT_STEREO_MSADPCM_SOFT, UserFmtStereo, UserFmtMSADPCM },
         { AL_FORMAT_STEREO_MULAW,        UserFmtStereo, UserFmtMulaw   },
         { AL_FORMAT_STEREO_ALAW_EXT,     UserFmtStereo, UserFmtAlaw    },
+        { AL_FORMAT_STEREO_I24_SOFT,     UserFmtStereo, UserFmtInt24   },
+        { AL_FORMAT_STEREO_I32_SOFT,     UserFmtStereo, UserFmtInt     },
 
         { AL_FORMAT_REAR8,      UserFmtRear, UserFmtUByte },
         { AL_FORMAT_REAR16,     UserFmtRear, UserFmtShort },
@@ -373,21 +813,29 @@ DecompResult DecomposeUserFormat(ALenum format)
         { AL_FORMAT_QUAD16,     UserFmtQuad, UserFmtShort },
         { AL_FORMAT_QUAD32,     UserFmtQuad, UserFmtFloat },
         { AL_FORMAT_QUAD_MULAW, UserFmtQuad, UserFmtMulaw },
+        { AL_FORMAT_QUAD_I24_SOFT, UserFmtQuad, UserFmtInt24 },
+        { AL_FORMAT_QUAD_I32_SOFT, UserFmtQuad, UserFmtInt   },
 
         { AL_FORMAT_51CHN8,      UserFmtX51, UserFmtUByte },
         { AL_FORMAT_51CHN16,     UserFmtX51, UserFmtShort },
         { AL_FORMAT_51CHN32,     UserFmtX51, UserFmtFloat },
         { AL_FORMAT_51CHN_MULAW, UserFmtX51, UserFmtMulaw },
+        { AL_FORMAT_51CHN_I24_SOFT, UserFmtX51, UserFmtInt24 },
+        { AL_FORMAT_51CHN_I32_SOFT, UserFmtX51, UserFmtInt   },
 
         { AL_FORMAT_61CHN8,      UserFmtX61, UserFmtUByte },
         { AL_FORMAT_61CHN16,     UserFmtX61, UserFmtShort },
         { AL_FORMAT_61CHN32,     UserFmtX61, UserFmtFloat },
         { AL_FORMAT_61CHN_MULAW, UserFmtX61, UserFmtMulaw },
+        { AL_FORMAT_61CHN_I24_SOFT, UserFmtX61, UserFmtInt24 },
+        { AL_FORMAT_61CHN_I32_SOFT, UserFmtX61, UserFmtInt   },
 
         { AL_FORMAT_71CHN8,      UserFmtX71, UserFmtUByte },
         { AL_FORMAT_71CHN16,     UserFmtX71, UserFmtShort },
         { AL_FORMAT_71CHN32,     UserFmtX71, UserFmtFloat },
         { AL_FORMAT_71CHN_MULAW, UserFmtX71, UserFmtMulaw },
+        { AL_FORMAT_71CHN_I24_SOFT, UserFmtX71, UserFmtInt24 },
+        { AL_FORMAT_71CHN_I32_SOFT, UserFmtX71, UserFmtInt   },
 
         { AL_FORMAT_BFORMAT2D_8,       UserFmtBFormat2D, UserFmtUByte },
         { AL_FORMAT_BFORMAT2D_16,      UserFmtBFormat2D, UserFmtShort },
@@ -414,6 +862,101 @@ DecompResult DecomposeUserFormat(ALenum format)
     return ret;
 }
 
+
+/* Returns whether the buffer should have a resample cache on the device.
+ * Callback buffers have nothing to cache, and writable buffers could change
+ * under it.
+ */
+bool WantsResampleCache(const ALCdevice *device, const ALbuffer *buffer)
+{
+    if(!buffer->WantResampleCache && !device->ResampleCacheAll)
+        return false;
+    if(device->ResampleCacheLimit == 0 || buffer->SampleLen == 0 || buffer->Callback ||
+        (buffer->Access&AL_MAP_WRITE_BIT_SOFT))
+        return false;
+    return static_cast<ALuint>(buffer->Frequency) != device->MixFrequency;
+}
+
+std::unique_ptr<ResampleCache> CreateResampleCache(const ALCdevice *device,
+    const ALbuffer *buffer)
+{
+    /* Step through the buffer like a voice playing it with a pitch of 1. */
+    const ALfloat pitch{static_cast<ALfloat>(buffer->Frequency) /
+        static_cast<ALfloat>(device->MixFrequency)};
+    if(pitch > static_cast<ALfloat>(MAX_PITCH))
+        return nullptr;
+    const ALint increment{maxi(fastf2i(pitch * FRACTIONONE), 1)};
+    const auto step = static_cast<uint64_t>(increment);
+
+    /* The whole buffer gets loaded to resample it. */
+    if(buffer->SampleLen > std::numeric_limits<ALsizei>::max() - MAX_RESAMPLE_PADDING*2)
+        return nullptr;
+    const uint64_t frames{((static_cast<uint64_t>(buffer->SampleLen)<<FRACTIONBITS) +
+        step-1) / step};
+    const auto NumChannels = static_cast<uint64_t>(ChannelsFromFmt(buffer->mFmtChannels));
+    const uint64_t size{frames * NumChannels * sizeof(ALfloat)};
+    if(size > device->ResampleCacheLimit ||
+        size > static_cast<uint64_t>(std::numeric_limits<ALsizei>::max()))
+        return nullptr;
+
+    std::unique_ptr<ResampleCache> cache{new ResampleCache{}};
+    cache->Increment = increment;
+
+    ALbuffer &cbuf = cache->Buffer;
+    cbuf.mData.resize(static_cast<size_t>(size));
+    cbuf.BytesAlloc = static_cast<ALsizei>(size);
+    cbuf.Frequency = static_cast<ALsizei>(device->MixFrequency);
+    cbuf.mFmtChannels = buffer->mFmtChannels;
+    cbuf.mFmtType = FmtFloat;
+    cbuf.OriginalType = UserFmtFloat;
+    cbuf.OriginalSize = static_cast<int64_t>(size);
+    cbuf.OriginalAlign = 1;
+    cbuf.SampleLen = static_cast<int64_t>(frames);
+
+    /* Loop points go to the nearest frame of the cache. */
+    auto scale_pos = [step,frames](const int64_t pos) -> int64_t
+    {
+        const uint64_t fpos{(static_cast<uint64_t>(pos)<<FRACTIONBITS) + step/2};
+        return static_cast<int64_t>(minu64(fpos/step, frames));
+    };
+    cbuf.LoopStart = mini64(scale_pos(buffer->LoopStart), cbuf.SampleLen-1);
+    cbuf.LoopEnd = maxi64(scale_pos(buffer->LoopEnd), cbuf.LoopStart+1);
+
+    ResampleBufferData(buffer, increment, reinterpret_cast<ALfloat*>(cbuf.mData.data()),
+        static_cast<ALsizei>(frames));
+
+    cache->Item = static_cast<ALbufferlistitem*>(al_calloc(DEF_ALIGN,
+        ALbufferlistitem::Sizeof(1u)));
+    cache->Item->next.store(nullptr, std::memory_order_relaxed);
+    cache->Item->max_samples = cbuf.SampleLen;
+    cache->Item->num_buffers = 1;
+    cache->Item->capacity = 1;
+    cache->Item->buffers[0] = &cbuf;
+
+    return cache;
+}
+
+/* Returns whether any of the device's voices may be playing from the cache.
+ * Must be called with the backend lock so voices don't start or stop.
+ */
+bool IsResampleCacheInUse(ALCdevice *device, const ResampleCache *cache)
+{
+    ALCcontext *ctx{device->ContextList.load(std::memory_order_acquire)};
+    for(;ctx;ctx = ctx->next.load(std::memory_order_relaxed))
+    {
+        auto voices_end = ctx->Voices + ctx->VoiceCount.load(std::memory_order_acquire);
+        auto in_use = std::any_of(ctx->Voices, voices_end,
+            [cache](const ALvoice *voice) noexcept -> bool
+            {
+                return voice->mResampled == cache &&
+                    voice->mPlayState.load(std::memory_order_acquire) != ALvoice::Stopped;
+            }
+        );
+        if(in_use) return true;
+    }
+    return false;
+}
+
 } // namespace
 
 
@@ -433,7 +976,12 @@ START_API_FUNC
     {
         /* Special handling for the easy and normal case. */
         ALbuffer *buffer = AllocBuffer(context.get());
-        if(buffer) buffers[0] = buffer->id;
+        if(buffer)
+        {
+            buffers[0] = buffer->id;
+            if(UNLIKELY(RecordEnabled))
+                RecordGen(context.get(), RecordObject::Buffer, 1, buffers);
+        }
     }
     else if(n > 1)
     {
@@ -453,6 +1001,9 @@ START_API_FUNC
             ids.emplace_back(buffer->id);
         } while(--n);
         std::copy(ids.begin(), ids.end(), buffers);
+        if(UNLIKELY(RecordEnabled))
+            RecordGen(context.get(), RecordObject::Buffer, static_cast<ALsizei>(ids.size()),
+                buffers);
     }
 }
 END_API_FUNC
@@ -474,10 +1025,14 @@ START_API_FUNC
     ALCdevice *device = context->Device;
     std::lock_guard<std::mutex> _{device->BufferLock};
 
-    /* First try to find any buffers that are invalid or in-use. */
+    /* First try to find any buffers that are invalid or in-use, claiming the
+     * rest so sources can't attach them.
+     */
+    al::vector<BufferClaim> claims;
+    claims.reserve(static_cast<size_t>(n));
     const ALuint *buffers_end = buffers + n;
     auto invbuf = std::find_if(buffers, buffers_end,
-        [device, &context](ALuint bid) -> bool
+        [device, &context, &claims](ALuint bid) -> bool
         {
             if(!bid) return false;
             ALbuffer *ALBuf = LookupBuffer(device, bid);
@@ -486,16 +1041,27 @@ START_API_FUNC
                 alSetError(context.get(), AL_INVALID_NAME, "Invalid buffer ID %u", bid);
                 return true;
             }
-            if(UNLIKELY(ReadRef(&ALBuf->ref) != 0))
+            /* With the lock held, only this call can have it claimed. */
+            if(ReadRef(&ALBuf->ref) == BUFFER_REF_CLAIMED)
+                return false;
+            BufferClaim claim{ALBuf};
+            if(UNLIKELY(!claim))
             {
                 alSetError(context.get(), AL_INVALID_OPERATION, "Deleting in-use buffer %u", bid);
                 return true;
             }
+            claims.emplace_back(std::move(claim));
             return false;
         }
     );
     if(LIKELY(invbuf == buffers_end))
     {
+        if(UNLIKELY(RecordEnabled))
+            RecordDelete(context.get(), RecordObject::Buffer, n, buffers);
+
+        for(BufferClaim &claim : claims)
+            claim.keep();
+
         /* All good. Delete non-0 buffer IDs. */
         std::for_each(buffers, buffers_end,
             [device](ALuint bid) -> void
@@ -515,7 +1081,6 @@ START_API_FUNC
     if(LIKELY(context))
     {
         ALCdevice *device = context->Device;
-        std::lock_guard<std::mutex> _{device->BufferLock};
         if(!buffer || LookupBuffer(device, buffer))
             return AL_TRUE;
     }
@@ -552,6 +1117,223 @@ START_API_FUNC
         alSetError(context.get(), AL_INVALID_VALUE,
                    "Declaring persistently mapped storage without read or write access");
     else
+    {
+        if(UNLIKELY(RecordEnabled))
+            RecordBufferData(context.get(), buffer, format, data, size, freq);
+
+        UserFmtType srctype{UserFmtUByte};
+        UserFmtChannels srcchannels{UserFmtMono};
+        bool success;
+
+        std::tie(success, srcchannels, srctype) = DecomposeUserFormat(format);
+        if(UNLIKELY(!success))
+            alSetError(context.get(), AL_INVALID_ENUM, "Invalid format 0x%04x", format);
+        else
+            LoadData(context.get(), albuf, freq, size, srcchannels, srctype, data, flags, nullptr);
+    }
+}
+END_API_FUNC
+
+/* Loads data into several buffers, like calling alBufferData for each, except
+ * everything is checked first so an error leaves all the buffers unchanged,
+ * and the samples are copied in parallel.
+ */
+AL_API void AL_APIENTRY alBufferDataBatchSOFT(ALsizei count, const ALuint *buffers, const ALbufferDataSOFT *descs)
+START_API_FUNC
+{
+    ContextRef context{GetContextRef()};
+    if(UNLIKELY(!context)) return;
+
+    if(UNLIKELY(count < 0))
+        SETERR_RETURN(context.get(), AL_INVALID_VALUE,, "Loading %d buffers", count);
+    if(count == 0) return;
+    if(UNLIKELY(!buffers || !descs))
+        SETERR_RETURN(context.get(), AL_INVALID_VALUE,, "NULL pointer");
+
+    /* A buffer's storage may be replaced when it's loaded, so each may only be
+     * given once.
+     */
+    al::vector<ALuint> ids(buffers, buffers+count);
+    std::sort(ids.begin(), ids.end());
+    auto dup = std::adjacent_find(ids.begin(), ids.end());
+    if(UNLIKELY(dup != ids.end()))
+        SETERR_RETURN(context.get(), AL_INVALID_VALUE,, "Buffer %u given more than once", *dup);
+
+    struct BufferLoad {
+        ALbuffer *Buffer;
+        BufferClaim Claim;
+        UserFmtChannels Channels;
+        UserFmtType Type;
+        LoadLayout Layout;
+    };
+
+    /* The claims are released before the lock. */
+    ALCdevice *device = context->Device;
+    std::lock_guard<std::mutex> _{device->BufferLock};
+    al::vector<BufferLoad> loads(static_cast<size_t>(count));
+    for(ALsizei i{0};i < count;i++)
+    {
+        const ALbufferDataSOFT &desc = descs[i];
+        BufferLoad &load = loads[i];
+
+        load.Buffer = LookupBuffer(device, buffers[i]);
+        if(UNLIKELY(!load.Buffer))
+            SETERR_RETURN(context.get(), AL_INVALID_NAME,, "Invalid buffer ID %u", buffers[i]);
+        if(UNLIKELY(desc.Size < 0))
+            SETERR_RETURN(context.get(), AL_INVALID_VALUE,, "Negative storage size %d",
+                desc.Size);
+        if(UNLIKELY(desc.Frequency < 1))
+            SETERR_RETURN(context.get(), AL_INVALID_VALUE,, "Invalid sample rate %d",
+                desc.Frequency);
+
+        bool success;
+        std::tie(success, load.Channels, load.Type) = DecomposeUserFormat(desc.Format);
+        if(UNLIKELY(!success))
+            SETERR_RETURN(context.get(), AL_INVALID_ENUM,, "Invalid format 0x%04x",
+                desc.Format);
+        if(!CheckLoadData(context.get(), load.Buffer, desc.Size, load.Channels, load.Type, 0,
+            nullptr, &load.Claim, &load.Layout))
+            return;
+    }
+
+    if(UNLIKELY(RecordEnabled))
+    {
+        for(ALsizei i{0};i < count;i++)
+            RecordBufferData(context.get(), buffers[i], descs[i].Format, descs[i].Data,
+                descs[i].Size, descs[i].Frequency);
+    }
+
+    al::vector<BufferCopy> copies;
+    copies.reserve(static_cast<size_t>(count));
+    for(ALsizei i{0};i < count;i++)
+    {
+        const BufferLoad &load = loads[i];
+        StoreData(context.get(), load.Buffer, static_cast<ALuint>(descs[i].Frequency),
+            descs[i].Size, load.Type, descs[i].Data, 0, nullptr, load.Layout, &copies);
+    }
+    RunBufferCopies(copies);
+    for(ALsizei i{0};i < count;i++)
+        FillLoopPadding(loads[i].Buffer);
+}
+END_API_FUNC
+
+AL_API void AL_APIENTRY alBufferExternalSOFT(ALuint buffer, ALenum format, ALvoid *data, ALsizei size, ALsizei freq, ALBUFFERRELEASETYPESOFT release, ALvoid *userptr)
+START_API_FUNC
+{
+    ContextRef context{GetContextRef()};
+    if(UNLIKELY(!context)) return;
+
+    ALCdevice *device = context->Device;
+    std::lock_guard<std::mutex> _{device->BufferLock};
+
+    ALbuffer *albuf = LookupBuffer(device, buffer);
+    if(UNLIKELY(!albuf))
+        alSetError(context.get(), AL_INVALID_NAME, "Invalid buffer ID %u", buffer);
+    else if(UNLIKELY(size < 0))
+        alSetError(context.get(), AL_INVALID_VALUE, "Negative storage size %d", size);
+    else if(UNLIKELY(freq < 1))
+        alSetError(context.get(), AL_INVALID_VALUE, "Invalid sample rate %d", freq);
+    else if(UNLIKELY(!data && size > 0))
+        alSetError(context.get(), AL_INVALID_VALUE, "NULL external storage");
+    else
+    {
+        UserFmtType srctype{UserFmtUByte};
+        UserFmtChannels srcchannels{UserFmtMono};
+        bool success;
+
+        std::tie(success, srcchannels, srctype) = DecomposeUserFormat(format);
+        if(UNLIKELY(!success))
+            alSetError(context.get(), AL_INVALID_ENUM, "Invalid format 0x%04x", format);
+        else
+        {
+            const ExternalStorage ext{data, release, userptr};
+            LoadData(context.get(), albuf, freq, size, srcchannels, srctype, data, 0, &ext);
+        }
+    }
+}
+END_API_FUNC
+
+AL_API void AL_APIENTRY alBufferFileSOFT(ALuint buffer, const ALchar *path, ALint64SOFT offset, ALint64SOFT size, ALenum format, ALsizei freq)
+START_API_FUNC
+{
+    ContextRef context{GetContextRef()};
+    if(UNLIKELY(!context)) return;
+
+    ALCdevice *device = context->Device;
+    std::lock_guard<std::mutex> _{device->BufferLock};
+
+    ALbuffer *albuf = LookupBuffer(device, buffer);
+    if(UNLIKELY(!albuf))
+        alSetError(context.get(), AL_INVALID_NAME, "Invalid buffer ID %u", buffer);
+    else if(UNLIKELY(!path))
+        alSetError(context.get(), AL_INVALID_VALUE, "NULL file path");
+    else if(UNLIKELY(offset < 0 || size < 0))
+        alSetError(context.get(), AL_INVALID_VALUE, "Invalid file range %" PRId64 "+%" PRId64,
+            offset, size);
+    else if(UNLIKELY(freq < 1))
+        alSetError(context.get(), AL_INVALID_VALUE, "Invalid sample rate %d", freq);
+    else
+    {
+        UserFmtType srctype{UserFmtUByte};
+        UserFmtChannels srcchannels{UserFmtMono};
+        bool success;
+
+        std::tie(success, srcchannels, srctype) = DecomposeUserFormat(format);
+        if(UNLIKELY(!success))
+        {
+            alSetError(context.get(), AL_INVALID_ENUM, "Invalid format 0x%04x", format);
+            return;
+        }
+
+        FileMapping fmap{MapFileToMem(path)};
+        if(UNLIKELY(!fmap.ptr))
+        {
+            alSetError(context.get(), AL_INVALID_VALUE, "Failed to map file %s", path);
+            return;
+        }
+        if(UNLIKELY(static_cast<uint64_t>(offset) > fmap.len ||
+            static_cast<uint64_t>(size) > fmap.len-static_cast<uint64_t>(offset)))
+        {
+            UnmapFileMem(&fmap);
+            alSetError(context.get(), AL_INVALID_VALUE, "File range %" PRId64 "+%" PRId64
+                " exceeds %s", offset, size, path);
+            return;
+        }
+
+        /* The file is kept mapped until the buffer's storage is released. Only
+         * what's played gets paged in, starting when a source plays it.
+         */
+        auto mapping = new FileMapping{fmap};
+        const ExternalStorage ext{static_cast<ALbyte*>(fmap.ptr)+offset, UnmapBufferFile,
+            mapping};
+        LoadData(context.get(), albuf, freq, size, srcchannels, srctype, ext.data, 0, &ext);
+        if(UNLIKELY(albuf->ExternalUserPtr != mapping))
+            UnmapBufferFile(mapping, nullptr);
+        else
+            albuf->FileReadAhead = maxi(freq/2, 1);
+    }
+}
+END_API_FUNC
+
+AL_API void AL_APIENTRY alBufferCallbackSOFT(ALuint buffer, ALenum format, ALsizei freq, ALBUFFERCALLBACKTYPESOFT callback, ALvoid *userptr, ALbitfieldSOFT flags)
+START_API_FUNC
+{
+    ContextRef context{GetContextRef()};
+    if(UNLIKELY(!context)) return;
+
+    ALCdevice *device = context->Device;
+    std::lock_guard<std::mutex> _{device->BufferLock};
+
+    ALbuffer *albuf = LookupBuffer(device, buffer);
+    if(UNLIKELY(!albuf))
+        alSetError(context.get(), AL_INVALID_NAME, "Invalid buffer ID %u", buffer);
+    else if(UNLIKELY(freq < 1))
+        alSetError(context.get(), AL_INVALID_VALUE, "Invalid sample rate %d", freq);
+    else if(UNLIKELY(callback == nullptr))
+        alSetError(context.get(), AL_INVALID_VALUE, "NULL callback");
+    else if(UNLIKELY((flags&~AL_CALLBACK_CONTINUOUS_BIT_SOFT) != 0))
+        alSetError(context.get(), AL_INVALID_VALUE, "Invalid callback flags 0x%x", flags);
+    else
     {
         UserFmtType srctype{UserFmtUByte};
         UserFmtChannels srcchannels{UserFmtMono};
@@ -561,7 +1343,8 @@ START_API_FUNC
         if(UNLIKELY(!success))
             alSetError(context.get(), AL_INVALID_ENUM, "Invalid format 0x%04x", format);
         else
-            LoadData(context.get(), albuf, freq, size, srcchannels, srctype, data, flags);
+            PrepareCallback(context.get(), albuf, freq, srcchannels, srctype, callback, userptr,
+                flags);
     }
 }
 END_API_FUNC
@@ -585,8 +1368,14 @@ START_API_FUNC
                    buffer);
     else
     {
+        /* Sources may attach a buffer while it's persistently mapped, so
+         * others are claimed while the mapping is set.
+         */
         ALbitfieldSOFT unavailable = (albuf->Access^access) & access;
-        if(UNLIKELY(ReadRef(&albuf->ref) != 0 && !(access&AL_MAP_PERSISTENT_BIT_SOFT)))
+        BufferClaim claim;
+        if(!(access&AL_MAP_PERSISTENT_BIT_SOFT))
+            claim = BufferClaim{albuf};
+        if(UNLIKELY(!claim && !(access&AL_MAP_PERSISTENT_BIT_SOFT)))
             alSetError(context.get(), AL_INVALID_OPERATION,
                        "Mapping in-use buffer %u without persistent mapping", buffer);
         else if(UNLIKELY(albuf->MappedAccess != 0))
@@ -606,7 +1395,7 @@ START_API_FUNC
                        offset, length, buffer);
         else
         {
-            void *retval = albuf->mData.data() + offset;
+            void *retval = albuf->samples() + offset;
             albuf->MappedAccess = access;
             albuf->MappedOffset = offset;
             albuf->MappedSize = length;
@@ -715,6 +1504,9 @@ START_API_FUNC
     else if(UNLIKELY(albuf->MappedAccess != 0))
         alSetError(context.get(), AL_INVALID_OPERATION, "Unpacking data into mapped buffer %u",
                 buffer);
+    else if(UNLIKELY(albuf->FileReadAhead > 0))
+        alSetError(context.get(), AL_INVALID_OPERATION, "Unpacking data into file buffer %u",
+                buffer);
     else
     {
         ALsizei num_chans{ChannelsFromFmt(albuf->mFmtChannels)};
@@ -737,25 +1529,23 @@ START_API_FUNC
             alSetError(context.get(), AL_INVALID_VALUE,
                 "Sub-range length %d is not a multiple of frame size %d (%d unpack alignment)",
                 length, byte_align, align);
+        else if(IsADPCMFmt(albuf->mFmtType))
+        {
+            /* ADPCM blocks are stored as given. */
+            memcpy(albuf->samples() + offset, data, length);
+            DetachResampleCache(device, albuf);
+        }
         else
         {
             /* offset -> byte offset, length -> sample count */
             offset = offset/byte_align * align * frame_size;
             length = length/byte_align * align;
 
-            void *dst = albuf->mData.data() + offset;
-            if(srctype == UserFmtIMA4 && albuf->mFmtType == FmtShort)
-                Convert_ALshort_ALima4(static_cast<ALshort*>(dst),
-                    static_cast<const ALubyte*>(data), num_chans, length, align);
-            else if(srctype == UserFmtMSADPCM && albuf->mFmtType == FmtShort)
-                Convert_ALshort_ALmsadpcm(static_cast<ALshort*>(dst),
-                    static_cast<const ALubyte*>(data), num_chans, length, align);
-            else
-            {
-                assert(static_cast<long>(srctype) ==
-                       static_cast<long>(albuf->mFmtType));
-                memcpy(dst, data, length * frame_size);
-            }
+            void *dst = albuf->samples() + offset;
+            assert(static_cast<long>(srctype) == static_cast<long>(albuf->mFmtType));
+            memcpy(dst, data, length * frame_size);
+            FillLoopPadding(albuf);
+            DetachResampleCache(device, albuf);
         }
     }
 }
@@ -888,14 +1678,40 @@ START_API_FUNC
         if(UNLIKELY(value < 0))
             alSetError(context.get(), AL_INVALID_VALUE, "Invalid unpack block alignment %d", value);
         else
+        {
             albuf->UnpackAlign.store(value);
+            PublishBufferInfo(device, albuf);
+        }
         break;
 
     case AL_PACK_BLOCK_ALIGNMENT_SOFT:
         if(UNLIKELY(value < 0))
             alSetError(context.get(), AL_INVALID_VALUE, "Invalid pack block alignment %d", value);
         else
+        {
             albuf->PackAlign.store(value);
+            PublishBufferInfo(device, albuf);
+        }
+        break;
+
+    case AL_RESAMPLE_CACHE_SOFT:
+        if(UNLIKELY(value != AL_FALSE && value != AL_TRUE))
+            alSetError(context.get(), AL_INVALID_VALUE, "Invalid resample cache value %d", value);
+        else if(!value)
+        {
+            albuf->WantResampleCache = AL_FALSE;
+            PublishBufferInfo(device, albuf);
+            DetachResampleCache(device, albuf);
+        }
+        else
+        {
+            /* Make the cache now instead of when it first plays. */
+            albuf->WantResampleCache = AL_TRUE;
+            PublishBufferInfo(device, albuf);
+            PrepareResampleCache(device, albuf);
+            BackendLockGuard __{*device->Backend};
+            TrimResampleCaches(device);
+        }
         break;
 
     default:
@@ -932,6 +1748,7 @@ START_API_FUNC
         {
         case AL_UNPACK_BLOCK_ALIGNMENT_SOFT:
         case AL_PACK_BLOCK_ALIGNMENT_SOFT:
+        case AL_RESAMPLE_CACHE_SOFT:
             alBufferi(buffer, param, values[0]);
             return;
         }
@@ -951,18 +1768,24 @@ START_API_FUNC
     else switch(param)
     {
     case AL_LOOP_POINTS_SOFT:
-        if(UNLIKELY(ReadRef(&albuf->ref) != 0))
+    {
+        BufferClaim claim{albuf};
+        if(UNLIKELY(!claim))
             alSetError(context.get(), AL_INVALID_OPERATION, "Modifying in-use buffer %u's loop points",
                        buffer);
-        else if(UNLIKELY(values[0] >= values[1] || values[0] < 0 || values[1] > albuf->SampleLen))
+        else if(UNLIKELY(values[0] >= values[1] || values[0] < 0 || int64_t{values[1]} > albuf->SampleLen))
             alSetError(context.get(), AL_INVALID_VALUE, "Invalid loop point range %d -> %d o buffer %u",
                        values[0], values[1], buffer);
         else
         {
+            DetachResampleCache(device, albuf);
             albuf->LoopStart = values[0];
             albuf->LoopEnd = values[1];
+            FillLoopPadding(albuf);
+            PublishBufferInfo(device, albuf);
         }
         break;
+    }
 
     default:
         alSetError(context.get(), AL_INVALID_ENUM, "Invalid buffer integer-vector property 0x%04x",
@@ -979,8 +1802,6 @@ START_API_FUNC
     if(UNLIKELY(!context)) return;
 
     ALCdevice *device = context->Device;
-    std::lock_guard<std::mutex> _{device->BufferLock};
-
     ALbuffer *albuf = LookupBuffer(device, buffer);
     if(UNLIKELY(!albuf))
         alSetError(context.get(), AL_INVALID_NAME, "Invalid buffer ID %u", buffer);
@@ -1001,8 +1822,6 @@ START_API_FUNC
     if(UNLIKELY(!context)) return;
 
     ALCdevice *device = context->Device;
-    std::lock_guard<std::mutex> _{device->BufferLock};
-
     if(UNLIKELY(LookupBuffer(device, buffer) == nullptr))
         alSetError(context.get(), AL_INVALID_NAME, "Invalid buffer ID %u", buffer);
     else if(UNLIKELY(!value1 || !value2 || !value3))
@@ -1029,8 +1848,6 @@ START_API_FUNC
     if(UNLIKELY(!context)) return;
 
     ALCdevice *device = context->Device;
-    std::lock_guard<std::mutex> _{device->BufferLock};
-
     if(UNLIKELY(LookupBuffer(device, buffer) == nullptr))
         alSetError(context.get(), AL_INVALID_NAME, "Invalid buffer ID %u", buffer);
     else if(UNLIKELY(!values))
@@ -1051,36 +1868,39 @@ START_API_FUNC
     if(UNLIKELY(!context)) return;
 
     ALCdevice *device = context->Device;
-    std::lock_guard<std::mutex> _{device->BufferLock};
-    ALbuffer *albuf = LookupBuffer(device, buffer);
-    if(UNLIKELY(!albuf))
+    BufferProps props;
+    if(UNLIKELY(!LookupBufferInfo(device, buffer, &props)))
         alSetError(context.get(), AL_INVALID_NAME, "Invalid buffer ID %u", buffer);
     else if(UNLIKELY(!value))
         alSetError(context.get(), AL_INVALID_VALUE, "NULL pointer");
     else switch(param)
     {
     case AL_FREQUENCY:
-        *value = albuf->Frequency;
+        *value = props.Frequency;
         break;
 
     case AL_BITS:
-        *value = BytesFromFmt(albuf->mFmtType) * 8;
+        *value = props.Bits;
         break;
 
     case AL_CHANNELS:
-        *value = ChannelsFromFmt(albuf->mFmtChannels);
+        *value = props.Channels;
         break;
 
     case AL_SIZE:
-        *value = albuf->SampleLen * FrameSizeFromFmt(albuf->mFmtChannels, albuf->mFmtType);
+        *value = props.Size;
         break;
 
     case AL_UNPACK_BLOCK_ALIGNMENT_SOFT:
-        *value = albuf->UnpackAlign.load();
+        *value = props.UnpackAlign;
         break;
 
     case AL_PACK_BLOCK_ALIGNMENT_SOFT:
-        *value = albuf->PackAlign.load();
+        *value = props.PackAlign;
+        break;
+
+    case AL_RESAMPLE_CACHE_SOFT:
+        *value = props.WantResampleCache;
         break;
 
     default:
@@ -1096,7 +1916,6 @@ START_API_FUNC
     if(UNLIKELY(!context)) return;
 
     ALCdevice *device = context->Device;
-    std::lock_guard<std::mutex> _{device->BufferLock};
     if(UNLIKELY(LookupBuffer(device, buffer) == nullptr))
         alSetError(context.get(), AL_INVALID_NAME, "Invalid buffer ID %u", buffer);
     else if(UNLIKELY(!value1 || !value2 || !value3))
@@ -1123,6 +1942,7 @@ START_API_FUNC
     case AL_SAMPLE_LENGTH_SOFT:
     case AL_UNPACK_BLOCK_ALIGNMENT_SOFT:
     case AL_PACK_BLOCK_ALIGNMENT_SOFT:
+    case AL_RESAMPLE_CACHE_SOFT:
         alGetBufferi(buffer, param, values);
         return;
     }
@@ -1131,17 +1951,16 @@ START_API_FUNC
     if(UNLIKELY(!context)) return;
 
     ALCdevice *device = context->Device;
-    std::lock_guard<std::mutex> _{device->BufferLock};
-    ALbuffer *albuf = LookupBuffer(device, buffer);
-    if(UNLIKELY(!albuf))
+    BufferProps props;
+    if(UNLIKELY(!LookupBufferInfo(device, buffer, &props)))
         alSetError(context.get(), AL_INVALID_NAME, "Invalid buffer ID %u", buffer);
     else if(UNLIKELY(!values))
         alSetError(context.get(), AL_INVALID_VALUE, "NULL pointer");
     else switch(param)
     {
     case AL_LOOP_POINTS_SOFT:
-        values[0] = albuf->LoopStart;
-        values[1] = albuf->LoopEnd;
+        values[0] = props.LoopStart;
+        values[1] = props.LoopEnd;
         break;
 
     default:
@@ -1162,6 +1981,8 @@ ALsizei BytesFromUserFmt(UserFmtType type)
     case UserFmtDouble: return sizeof(ALdouble);
     case UserFmtMulaw: return sizeof(ALubyte);
     case UserFmtAlaw: return sizeof(ALubyte);
+    case UserFmtInt24: return sizeof(ALbyte3);
+    case UserFmtInt: return sizeof(ALint);
     case UserFmtIMA4: break; /* not handled here */
     case UserFmtMSADPCM: break; /* not handled here */
     }
@@ -1194,6 +2015,10 @@ ALsizei BytesFromFmt(FmtType type)
     case FmtDouble: return sizeof(ALdouble);
     case FmtMulaw: return sizeof(ALubyte);
     case FmtAlaw: return sizeof(ALubyte);
+    case FmtInt24: return sizeof(ALbyte3);
+    case FmtInt: return sizeof(ALint);
+    case FmtIMA4: return sizeof(ALshort);
+    case FmtMSADPCM: return sizeof(ALshort);
     }
     return 0;
 }
@@ -1215,6 +2040,130 @@ ALsizei ChannelsFromFmt(FmtChannels chans)
 }
 
 
+void PrefetchBufferData(const ALbuffer *buffer, int64_t start, ALsizei count)
+{
+    start = clampi64(start, 0, buffer->SampleLen);
+    count = static_cast<ALsizei>(mini64(count, buffer->SampleLen-start));
+    if(buffer->FileReadAhead < 1 || count < 1)
+        return;
+
+    const ALsizei NumChannels{ChannelsFromFmt(buffer->mFmtChannels)};
+    const ALsizei align{buffer->OriginalAlign};
+    int64_t begin, end;
+    if(IsADPCMFmt(buffer->mFmtType))
+    {
+        /* Cover the whole blocks holding the frames. */
+        const ALsizei BlockSize{(buffer->mFmtType == FmtIMA4) ?
+            ((align-1)/2 + 4) * NumChannels : ((align-2)/2 + 7) * NumChannels};
+        begin = start/align * BlockSize;
+        end = (start+count + align-1)/align * BlockSize;
+    }
+    else
+    {
+        const ALsizei FrameSize{NumChannels * BytesFromFmt(buffer->mFmtType)};
+        begin = start * FrameSize;
+        end = (start+count) * FrameSize;
+    }
+    end = mini64(end, buffer->OriginalSize);
+
+    PrefetchFileMem(buffer->ExternalData+begin, static_cast<size_t>(end-begin));
+}
+
+
+void PrepareResampleCache(ALCdevice *device, ALbuffer *buffer)
+{
+    if(!WantsResampleCache(device, buffer))
+        return;
+    {
+        std::lock_guard<std::mutex> _{device->ResampleCacheLock};
+        ResampleCache *cache{buffer->Resampled};
+        if(cache && static_cast<ALuint>(cache->Buffer.Frequency) == device->MixFrequency)
+            return;
+    }
+
+    std::unique_ptr<ResampleCache> cache{CreateResampleCache(device, buffer)};
+    if(!cache) return;
+
+    std::lock_guard<std::mutex> _{device->ResampleCacheLock};
+    if(ResampleCache *oldcache{buffer->Resampled})
+    {
+        /* Another source may have made one for this rate in the meantime. */
+        if(oldcache->Buffer.Frequency == cache->Buffer.Frequency)
+            return;
+        oldcache->Owner = nullptr;
+    }
+    cache->Owner = buffer;
+    buffer->Resampled = cache.get();
+    device->ResampleCacheSize += cache->Buffer.mData.size();
+    device->ResampleCaches.emplace_back(cache.release());
+}
+
+ResampleCache *UseResampleCache(ALCdevice *device, ALbuffer *buffer)
+{
+    std::lock_guard<std::mutex> _{device->ResampleCacheLock};
+    ResampleCache *cache{buffer->Resampled};
+    if(!cache || static_cast<ALuint>(cache->Buffer.Frequency) != device->MixFrequency)
+        return nullptr;
+
+    auto iter = std::find(device->ResampleCaches.begin(), device->ResampleCaches.end(), cache);
+    std::rotate(iter, iter+1, device->ResampleCaches.end());
+    return cache;
+}
+
+void DetachResampleCache(ALCdevice *device, ALbuffer *buffer)
+{
+    std::lock_guard<std::mutex> _{device->ResampleCacheLock};
+    ResampleCache *cache{buffer->Resampled};
+    if(!cache) return;
+
+    cache->Owner = nullptr;
+    buffer->Resampled = nullptr;
+
+    /* Only voices for sources with the buffer can be playing the cache, so it
+     * can go right away if there aren't any.
+     */
+    if((ReadRef(&buffer->ref)&~BUFFER_REF_CLAIMED) == 0)
+    {
+        auto iter = std::find(device->ResampleCaches.begin(), device->ResampleCaches.end(),
+            cache);
+        device->ResampleCaches.erase(iter);
+        device->ResampleCacheSize -= cache->Buffer.mData.size();
+        delete cache;
+    }
+}
+
+void TrimResampleCaches(ALCdevice *device)
+{
+    std::lock_guard<std::mutex> _{device->ResampleCacheLock};
+    auto iter = device->ResampleCaches.begin();
+    while(iter != device->ResampleCaches.end())
+    {
+        ResampleCache *cache{*iter};
+        const bool unwanted{!cache->Owner ||
+            static_cast<ALuint>(cache->Buffer.Frequency) != device->MixFrequency ||
+            device->ResampleCacheSize > device->ResampleCacheLimit};
+        if(!unwanted || IsResampleCacheInUse(device, cache))
+        {
+            ++iter;
+            continue;
+        }
+
+        if(cache->Owner)
+            cache->Owner->Resampled = nullptr;
+        device->ResampleCacheSize -= cache->Buffer.mData.size();
+        delete cache;
+        iter = device->ResampleCaches.erase(iter);
+    }
+}
+
+ResampleCache::~ResampleCache()
+{ al_free(Item); }
+
+
+ALbuffer::~ALbuffer()
+{ ReleaseExternalData(this); }
+
+
 BufferSubList::~BufferSubList()
 {
     uint64_t usemask{~FreeMask};
@@ -1227,4 +2176,6 @@ BufferSubList::~BufferSubList()
     FreeMask = ~usemask;
     al_free(Buffers);
     Buffers = nullptr;
+    al_free(Infos);
+    Infos = nullptr;
 }
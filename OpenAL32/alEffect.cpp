@@ -33,12 +33,13 @@
 #include "alcontext.h"
 #include "alEffect.h"
 #include "alError.h"
+#include "callrecord.h"
 #include "alexcpt.h"
 
 #include "effects/base.h"
 
 
-const EffectList gEffectList[14]{
+const EffectList gEffectList[16]{
     { "eaxreverb",  EAXREVERB_EFFECT,  AL_EFFECT_EAXREVERB },
     { "reverb",     REVERB_EFFECT,     AL_EFFECT_REVERB },
     { "autowah",    AUTOWAH_EFFECT,    AL_EFFECT_AUTOWAH },
@@ -51,6 +52,8 @@ const EffectList gEffectList[14]{
     { "fshifter",   FSHIFTER_EFFECT,   AL_EFFECT_FREQUENCY_SHIFTER },
     { "modulator",  MODULATOR_EFFECT,  AL_EFFECT_RING_MODULATOR },
     { "pshifter",   PSHIFTER_EFFECT,   AL_EFFECT_PITCH_SHIFTER },
+    { "convolution", CONVOLUTION_EFFECT, AL_EFFECT_CONVOLUTION_REVERB_SOFT },
+    { "reflections", REFLECTIONS_EFFECT, AL_EFFECT_EARLY_REFLECTIONS_SOFT },
     { "dedicated",  DEDICATED_EFFECT,  AL_EFFECT_DEDICATED_LOW_FREQUENCY_EFFECT },
     { "dedicated",  DEDICATED_EFFECT,  AL_EFFECT_DEDICATED_DIALOGUE },
 };
@@ -64,6 +67,7 @@ constexpr struct FactoryItem {
     EffectStateFactory* (&GetFactory)(void);
 } FactoryList[] = {
     { AL_EFFECT_NULL, NullStateFactory_getFactory },
+#ifdef ALSOFT_EFFECTS
     { AL_EFFECT_EAXREVERB, ReverbStateFactory_getFactory },
     { AL_EFFECT_REVERB, StdReverbStateFactory_getFactory },
     { AL_EFFECT_AUTOWAH, AutowahStateFactory_getFactory },
@@ -76,6 +80,9 @@ constexpr struct FactoryItem {
     { AL_EFFECT_FREQUENCY_SHIFTER, FshifterStateFactory_getFactory },
     { AL_EFFECT_RING_MODULATOR, ModulatorStateFactory_getFactory },
     { AL_EFFECT_PITCH_SHIFTER, PshifterStateFactory_getFactory},
+    { AL_EFFECT_CONVOLUTION_REVERB_SOFT, ConvolutionStateFactory_getFactory },
+    { AL_EFFECT_EARLY_REFLECTIONS_SOFT, ReflectionsStateFactory_getFactory },
+#endif
     { AL_EFFECT_DEDICATED_DIALOGUE, DedicatedStateFactory_getFactory },
     { AL_EFFECT_DEDICATED_LOW_FREQUENCY_EFFECT, DedicatedStateFactory_getFactory }
 };
@@ -128,10 +135,8 @@ ALeffect *AllocEffect(ALCcontext *context)
 {
     ALCdevice *device{context->Device};
     std::lock_guard<std::mutex> _{device->EffectLock};
-    auto sublist = std::find_if(device->EffectList.begin(), device->EffectList.end(),
-        [](const EffectSubList &entry) noexcept -> bool
-        { return entry.FreeMask != 0; }
-    );
+    const ptrdiff_t freelist{device->EffectFreeMap.find()};
+    auto sublist = (freelist < 0) ? device->EffectList.end() : (device->EffectList.begin() + freelist);
 
     auto lidx = static_cast<ALsizei>(std::distance(device->EffectList.begin(), sublist));
     ALeffect *effect{nullptr};
@@ -173,6 +178,7 @@ ALeffect *AllocEffect(ALCcontext *context)
     effect->id = ((lidx<<6) | slidx) + 1;
 
     sublist->FreeMask &= ~(1_u64 << slidx);
+    device->EffectFreeMap.set(static_cast<size_t>(lidx), sublist->FreeMask != 0);
 
     return effect;
 }
@@ -186,6 +192,7 @@ void FreeEffect(ALCdevice *device, ALeffect *effect)
     effect->~ALeffect();
 
     device->EffectList[lidx].FreeMask |= 1_u64 << slidx;
+    device->EffectFreeMap.set(static_cast<size_t>(lidx), true);
 }
 
 inline ALeffect *LookupEffect(ALCdevice *device, ALuint id)
@@ -193,12 +200,26 @@ inline ALeffect *LookupEffect(ALCdevice *device, ALuint id)
     ALuint lidx = (id-1) >> 6;
     ALsizei slidx = (id-1) & 0x3f;
 
-    if(UNLIKELY(lidx >= device->EffectList.size()))
+    EffectSubList *sublist{device->EffectList.lookup(lidx)};
+    if(UNLIKELY(!sublist))
         return nullptr;
-    EffectSubList &sublist = device->EffectList[lidx];
-    if(UNLIKELY(sublist.FreeMask & (1_u64 << slidx)))
+    if(UNLIKELY(sublist->FreeMask.load(std::memory_order_acquire) & (1_u64 << slidx)))
         return nullptr;
-    return sublist.Effects + slidx;
+    return sublist->Effects + slidx;
+}
+
+/* The number of values a float-vector effect property takes. Only the EAX
+ * reverb's panning vectors have more than one.
+ */
+inline ALsizei EffectFloatValsByParam(ALenum param)
+{
+    switch(param)
+    {
+    case AL_EAXREVERB_REFLECTIONS_PAN:
+    case AL_EAXREVERB_LATE_REVERB_PAN:
+        return 3;
+    }
+    return 1;
 }
 
 } // namespace
@@ -219,7 +240,12 @@ START_API_FUNC
     {
         /* Special handling for the easy and normal case. */
         ALeffect *effect = AllocEffect(context.get());
-        if(effect) effects[0] = effect->id;
+        if(effect)
+        {
+            effects[0] = effect->id;
+            if(UNLIKELY(RecordEnabled))
+                RecordGen(context.get(), RecordObject::Effect, 1, effects);
+        }
     }
     else if(n > 1)
     {
@@ -239,6 +265,9 @@ START_API_FUNC
             ids.emplace_back(effect->id);
         } while(--n);
         std::copy(ids.begin(), ids.end(), effects);
+        if(UNLIKELY(RecordEnabled))
+            RecordGen(context.get(), RecordObject::Effect, static_cast<ALsizei>(ids.size()),
+                effects);
     }
 }
 END_API_FUNC
@@ -277,6 +306,9 @@ START_API_FUNC
     );
     if(LIKELY(inveffect == effects_end))
     {
+        if(UNLIKELY(RecordEnabled))
+            RecordDelete(context.get(), RecordObject::Effect, n, effects);
+
         /* All good. Delete non-0 effect IDs. */
         std::for_each(effects, effects_end,
             [device](ALuint eid) -> void
@@ -296,7 +328,6 @@ START_API_FUNC
     if(LIKELY(context))
     {
         ALCdevice *device{context->Device};
-        std::lock_guard<std::mutex> _{device->EffectLock};
         if(!effect || LookupEffect(device, effect))
             return AL_TRUE;
     }
@@ -318,6 +349,9 @@ START_API_FUNC
         alSetError(context.get(), AL_INVALID_NAME, "Invalid effect ID %u", effect);
     else
     {
+        if(UNLIKELY(RecordEnabled))
+            RecordParamiv(context.get(), RecordObject::Effect, effect, param, 1, &value);
+
         if(param == AL_EFFECT_TYPE)
         {
             ALboolean isOk = (value == AL_EFFECT_NULL);
@@ -362,6 +396,9 @@ START_API_FUNC
         alSetError(context.get(), AL_INVALID_NAME, "Invalid effect ID %u", effect);
     else
     {
+        if(UNLIKELY(RecordEnabled))
+            RecordParamiv(context.get(), RecordObject::Effect, effect, param, 1, values);
+
         /* Call the appropriate handler */
         ALeffect_setParamiv(aleffect, context.get(), param, values);
     }
@@ -382,6 +419,9 @@ START_API_FUNC
         alSetError(context.get(), AL_INVALID_NAME, "Invalid effect ID %u", effect);
     else
     {
+        if(UNLIKELY(RecordEnabled))
+            RecordParamfv(context.get(), RecordObject::Effect, effect, param, 1, &value);
+
         /* Call the appropriate handler */
         ALeffect_setParamf(aleffect, context.get(), param, value);
     }
@@ -402,6 +442,10 @@ START_API_FUNC
         alSetError(context.get(), AL_INVALID_NAME, "Invalid effect ID %u", effect);
     else
     {
+        if(UNLIKELY(RecordEnabled))
+            RecordParamfv(context.get(), RecordObject::Effect, effect, param,
+                EffectFloatValsByParam(param), values);
+
         /* Call the appropriate handler */
         ALeffect_setParamfv(aleffect, context.get(), param, values);
     }
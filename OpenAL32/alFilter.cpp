@@ -29,6 +29,7 @@
 #include "alu.h"
 #include "alFilter.h"
 #include "alError.h"
+#include "callrecord.h"
 #include "alexcpt.h"
 
 
@@ -272,10 +273,8 @@ ALfilter *AllocFilter(ALCcontext *context)
 {
     ALCdevice *device{context->Device};
     std::lock_guard<std::mutex> _{device->FilterLock};
-    auto sublist = std::find_if(device->FilterList.begin(), device->FilterList.end(),
-        [](const FilterSubList &entry) noexcept -> bool
-        { return entry.FreeMask != 0; }
-    );
+    const ptrdiff_t freelist{device->FilterFreeMap.find()};
+    auto sublist = (freelist < 0) ? device->FilterList.end() : (device->FilterList.begin() + freelist);
 
     auto lidx = static_cast<ALsizei>(std::distance(device->FilterList.begin(), sublist));
     ALfilter *filter{nullptr};
@@ -317,6 +316,7 @@ ALfilter *AllocFilter(ALCcontext *context)
     filter->id = ((lidx<<6) | slidx) + 1;
 
     sublist->FreeMask &= ~(1_u64 << slidx);
+    device->FilterFreeMap.set(static_cast<size_t>(lidx), sublist->FreeMask != 0);
 
     return filter;
 }
@@ -330,6 +330,23 @@ void FreeFilter(ALCdevice *device, ALfilter *filter)
     filter->~ALfilter();
 
     device->FilterList[lidx].FreeMask |= 1_u64 << slidx;
+    device->FilterFreeMap.set(static_cast<size_t>(lidx), true);
+}
+
+
+/* Publishes a linked filter's properties for the mixer, which applies them to
+ * the voices linked to it.
+ */
+void UpdateLinkedFilter(ALCdevice *device, ALfilter *filter)
+{
+    if(!filter->Linked) return;
+
+    filter->Params.Gain.store(filter->Gain, std::memory_order_relaxed);
+    filter->Params.GainHF.store(filter->GainHF, std::memory_order_relaxed);
+    filter->Params.HFReference.store(filter->HFReference, std::memory_order_relaxed);
+    filter->Params.GainLF.store(filter->GainLF, std::memory_order_relaxed);
+    filter->Params.LFReference.store(filter->LFReference, std::memory_order_relaxed);
+    device->LinkedFilterGen.fetch_add(1u, std::memory_order_release);
 }
 
 
@@ -338,12 +355,12 @@ inline ALfilter *LookupFilter(ALCdevice *device, ALuint id)
     ALuint lidx = (id-1) >> 6;
     ALsizei slidx = (id-1) & 0x3f;
 
-    if(UNLIKELY(lidx >= device->FilterList.size()))
+    FilterSubList *sublist{device->FilterList.lookup(lidx)};
+    if(UNLIKELY(!sublist))
         return nullptr;
-    FilterSubList &sublist = device->FilterList[lidx];
-    if(UNLIKELY(sublist.FreeMask & (1_u64 << slidx)))
+    if(UNLIKELY(sublist->FreeMask.load(std::memory_order_acquire) & (1_u64 << slidx)))
         return nullptr;
-    return sublist.Filters + slidx;
+    return sublist->Filters + slidx;
 }
 
 } // namespace
@@ -364,7 +381,12 @@ START_API_FUNC
     {
         /* Special handling for the easy and normal case. */
         ALfilter *filter = AllocFilter(context.get());
-        if(filter) filters[0] = filter->id;
+        if(filter)
+        {
+            filters[0] = filter->id;
+            if(UNLIKELY(RecordEnabled))
+                RecordGen(context.get(), RecordObject::Filter, 1, filters);
+        }
     }
     else if(n > 1)
     {
@@ -384,6 +406,9 @@ START_API_FUNC
             ids.emplace_back(filter->id);
         } while(--n);
         std::copy(ids.begin(), ids.end(), filters);
+        if(UNLIKELY(RecordEnabled))
+            RecordGen(context.get(), RecordObject::Filter, static_cast<ALsizei>(ids.size()),
+                filters);
     }
 }
 END_API_FUNC
@@ -417,11 +442,20 @@ START_API_FUNC
                 alSetError(context.get(), AL_INVALID_NAME, "Invalid filter ID %u", fid);
                 return true;
             }
+            if(UNLIKELY(ReadRef(&filter->ref) != 0))
+            {
+                alSetError(context.get(), AL_INVALID_OPERATION, "Deleting in-use filter %u",
+                    fid);
+                return true;
+            }
             return false;
         }
     );
     if(LIKELY(invflt == filters_end))
     {
+        if(UNLIKELY(RecordEnabled))
+            RecordDelete(context.get(), RecordObject::Filter, n, filters);
+
         /* All good. Delete non-0 filter IDs. */
         std::for_each(filters, filters_end,
             [device](ALuint fid) -> void
@@ -441,7 +475,6 @@ START_API_FUNC
     if(LIKELY(context))
     {
         ALCdevice *device{context->Device};
-        std::lock_guard<std::mutex> _{device->FilterLock};
         if(!filter || LookupFilter(device, filter))
             return AL_TRUE;
     }
@@ -464,6 +497,9 @@ START_API_FUNC
         alSetError(context.get(), AL_INVALID_NAME, "Invalid filter ID %u", filter);
     else
     {
+        if(UNLIKELY(RecordEnabled))
+            RecordParamiv(context.get(), RecordObject::Filter, filter, param, 1, &value);
+
         if(param == AL_FILTER_TYPE)
         {
             if(value == AL_FILTER_NULL || value == AL_FILTER_LOWPASS ||
@@ -472,11 +508,22 @@ START_API_FUNC
             else
                 alSetError(context.get(), AL_INVALID_VALUE, "Invalid filter type 0x%04x", value);
         }
+        else if(param == AL_FILTER_LINKED_SOFT)
+        {
+            if(!(value == AL_FALSE || value == AL_TRUE))
+                SETERR_RETURN(context.get(), AL_INVALID_VALUE,, "Invalid linked state %d",
+                    value);
+            if(ReadRef(&alfilt->ref) != 0)
+                SETERR_RETURN(context.get(), AL_INVALID_OPERATION,,
+                    "Changing linked state of in-use filter %u", filter);
+            alfilt->Linked = value;
+        }
         else
         {
             /* Call the appropriate handler */
             ALfilter_setParami(alfilt, context.get(), param, value);
         }
+        UpdateLinkedFilter(device, alfilt);
     }
 }
 END_API_FUNC
@@ -487,6 +534,7 @@ START_API_FUNC
     switch(param)
     {
         case AL_FILTER_TYPE:
+        case AL_FILTER_LINKED_SOFT:
             alFilteri(filter, param, values[0]);
             return;
     }
@@ -502,8 +550,12 @@ START_API_FUNC
         alSetError(context.get(), AL_INVALID_NAME, "Invalid filter ID %u", filter);
     else
     {
+        if(UNLIKELY(RecordEnabled))
+            RecordParamiv(context.get(), RecordObject::Filter, filter, param, 1, values);
+
         /* Call the appropriate handler */
         ALfilter_setParamiv(alfilt, context.get(), param, values);
+        UpdateLinkedFilter(device, alfilt);
     }
 }
 END_API_FUNC
@@ -522,8 +574,12 @@ START_API_FUNC
         alSetError(context.get(), AL_INVALID_NAME, "Invalid filter ID %u", filter);
     else
     {
+        if(UNLIKELY(RecordEnabled))
+            RecordParamfv(context.get(), RecordObject::Filter, filter, param, 1, &value);
+
         /* Call the appropriate handler */
         ALfilter_setParamf(alfilt, context.get(), param, value);
+        UpdateLinkedFilter(device, alfilt);
     }
 }
 END_API_FUNC
@@ -542,8 +598,12 @@ START_API_FUNC
         alSetError(context.get(), AL_INVALID_NAME, "Invalid filter ID %u", filter);
     else
     {
+        if(UNLIKELY(RecordEnabled))
+            RecordParamfv(context.get(), RecordObject::Filter, filter, param, 1, values);
+
         /* Call the appropriate handler */
         ALfilter_setParamfv(alfilt, context.get(), param, values);
+        UpdateLinkedFilter(device, alfilt);
     }
 }
 END_API_FUNC
@@ -564,6 +624,8 @@ START_API_FUNC
     {
         if(param == AL_FILTER_TYPE)
             *value = alfilt->type;
+        else if(param == AL_FILTER_LINKED_SOFT)
+            *value = alfilt->Linked;
         else
         {
             /* Call the appropriate handler */
@@ -579,6 +641,7 @@ START_API_FUNC
     switch(param)
     {
         case AL_FILTER_TYPE:
+        case AL_FILTER_LINKED_SOFT:
             alGetFilteri(filter, param, values);
             return;
     }
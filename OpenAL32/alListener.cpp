@@ -28,11 +28,12 @@
 #include "alError.h"
 #include "alListener.h"
 #include "alSource.h"
+#include "callrecord.h"
 #include "alexcpt.h"
 
 #define DO_UPDATEPROPS() do {                                                 \
     if(!context->DeferUpdates.load(std::memory_order_acquire))                \
-        UpdateListenerProps(context.get());                                   \
+        UpdateListenerProps(context.get(), listener);                         \
     else                                                                      \
         listener.PropsClean.clear(std::memory_order_release);                 \
 } while(0)
@@ -46,6 +47,8 @@ START_API_FUNC
 
     ALlistener &listener = context->Listener;
     std::lock_guard<std::mutex> _{context->PropLock};
+    if(UNLIKELY(RecordEnabled))
+        RecordParamfv(context.get(), RecordObject::Listener, 0, param, 1, &value);
     switch(param)
     {
     case AL_GAIN:
@@ -80,6 +83,11 @@ START_API_FUNC
 
     ALlistener &listener = context->Listener;
     std::lock_guard<std::mutex> _{context->PropLock};
+    if(UNLIKELY(RecordEnabled))
+    {
+        const ALfloat fvals[3]{value1, value2, value3};
+        RecordParamfv(context.get(), RecordObject::Listener, 0, param, 3, fvals);
+    }
     switch(param)
     {
     case AL_POSITION:
@@ -137,6 +145,8 @@ START_API_FUNC
         if(!(std::isfinite(values[0]) && std::isfinite(values[1]) && std::isfinite(values[2]) &&
              std::isfinite(values[3]) && std::isfinite(values[4]) && std::isfinite(values[5])))
             SETERR_RETURN(context.get(), AL_INVALID_VALUE,, "Listener orientation out of range");
+        if(UNLIKELY(RecordEnabled))
+            RecordParamfv(context.get(), RecordObject::Listener, 0, param, 6, values);
         /* AT then UP */
         listener.OrientAt[0] = values[0];
         listener.OrientAt[1] = values[1];
@@ -414,8 +424,213 @@ START_API_FUNC
 END_API_FUNC
 
 
-void UpdateListenerProps(ALCcontext *context)
+namespace {
+
+/* Gets one of the context's other listeners, by its index (0 being the main
+ * listener).
+ */
+inline ALlistener *LookupExtraListener(ALCcontext *context, ALuint index) noexcept
+{
+    if(index < 1 || index >= MAX_LISTENERS)
+        return nullptr;
+    return &context->ExtraListeners[index-1];
+}
+
+} // namespace
+
+AL_API void AL_APIENTRY alListenerfIndexSOFT(ALuint index, ALenum param, ALfloat value)
+START_API_FUNC
 {
+    if(index == 0)
+    {
+        alListenerf(param, value);
+        return;
+    }
+    if(param == AL_GAIN)
+    {
+        alListenerfvIndexSOFT(index, param, &value);
+        return;
+    }
+
+    ContextRef context{GetContextRef()};
+    if(UNLIKELY(!context)) return;
+    alSetError(context.get(), AL_INVALID_ENUM, "Invalid indexed listener float property");
+}
+END_API_FUNC
+
+AL_API void AL_APIENTRY alListenerfvIndexSOFT(ALuint index, ALenum param, const ALfloat *values)
+START_API_FUNC
+{
+    if(index == 0)
+    {
+        alListenerfv(param, values);
+        return;
+    }
+
+    ContextRef context{GetContextRef()};
+    if(UNLIKELY(!context)) return;
+
+    std::lock_guard<std::mutex> _{context->PropLock};
+    ALlistener *plistener{LookupExtraListener(context.get(), index)};
+    if(UNLIKELY(!plistener))
+        SETERR_RETURN(context.get(), AL_INVALID_VALUE,, "Invalid listener index %u", index);
+    ALlistener &listener = *plistener;
+    if(!values) SETERR_RETURN(context.get(), AL_INVALID_VALUE,, "NULL pointer");
+    switch(param)
+    {
+    case AL_GAIN:
+        if(!(values[0] >= 0.0f && std::isfinite(values[0])))
+            SETERR_RETURN(context.get(), AL_INVALID_VALUE,, "Listener gain out of range");
+        listener.Gain = values[0];
+        DO_UPDATEPROPS();
+        break;
+
+    case AL_POSITION:
+        if(!(std::isfinite(values[0]) && std::isfinite(values[1]) && std::isfinite(values[2])))
+            SETERR_RETURN(context.get(), AL_INVALID_VALUE,, "Listener position out of range");
+        listener.Position[0] = values[0];
+        listener.Position[1] = values[1];
+        listener.Position[2] = values[2];
+        DO_UPDATEPROPS();
+        break;
+
+    case AL_ORIENTATION:
+        if(!(std::isfinite(values[0]) && std::isfinite(values[1]) && std::isfinite(values[2]) &&
+             std::isfinite(values[3]) && std::isfinite(values[4]) && std::isfinite(values[5])))
+            SETERR_RETURN(context.get(), AL_INVALID_VALUE,, "Listener orientation out of range");
+        /* AT then UP */
+        listener.OrientAt[0] = values[0];
+        listener.OrientAt[1] = values[1];
+        listener.OrientAt[2] = values[2];
+        listener.OrientUp[0] = values[3];
+        listener.OrientUp[1] = values[4];
+        listener.OrientUp[2] = values[5];
+        DO_UPDATEPROPS();
+        break;
+
+    default:
+        alSetError(context.get(), AL_INVALID_ENUM, "Invalid indexed listener float property");
+    }
+}
+END_API_FUNC
+
+AL_API void AL_APIENTRY alListeneriIndexSOFT(ALuint index, ALenum param, ALint value)
+START_API_FUNC
+{
+    if(index == 0)
+    {
+        alListeneri(param, value);
+        return;
+    }
+
+    ContextRef context{GetContextRef()};
+    if(UNLIKELY(!context)) return;
+
+    std::lock_guard<std::mutex> _{context->PropLock};
+    ALlistener *plistener{LookupExtraListener(context.get(), index)};
+    if(UNLIKELY(!plistener))
+        SETERR_RETURN(context.get(), AL_INVALID_VALUE,, "Invalid listener index %u", index);
+    ALlistener &listener = *plistener;
+    switch(param)
+    {
+    case AL_LISTENER_OUTPUT_CHANNEL_SOFT:
+        /* The device's channel count can change, so a pair past its last
+         * channel is only skipped when mixing.
+         */
+        if(!(value >= -1 && value < MAX_OUTPUT_CHANNELS-1))
+            SETERR_RETURN(context.get(), AL_INVALID_VALUE,,
+                "Listener output channel out of range");
+        listener.OutputChannel = value;
+        DO_UPDATEPROPS();
+        break;
+
+    default:
+        alSetError(context.get(), AL_INVALID_ENUM, "Invalid indexed listener integer property");
+    }
+}
+END_API_FUNC
+
+AL_API void AL_APIENTRY alGetListenerfvIndexSOFT(ALuint index, ALenum param, ALfloat *values)
+START_API_FUNC
+{
+    if(index == 0)
+    {
+        alGetListenerfv(param, values);
+        return;
+    }
+
+    ContextRef context{GetContextRef()};
+    if(UNLIKELY(!context)) return;
+
+    std::lock_guard<std::mutex> _{context->PropLock};
+    ALlistener *plistener{LookupExtraListener(context.get(), index)};
+    if(UNLIKELY(!plistener))
+        SETERR_RETURN(context.get(), AL_INVALID_VALUE,, "Invalid listener index %u", index);
+    const ALlistener &listener = *plistener;
+    if(!values)
+        alSetError(context.get(), AL_INVALID_VALUE, "NULL pointer");
+    else switch(param)
+    {
+    case AL_GAIN:
+        values[0] = listener.Gain;
+        break;
+
+    case AL_POSITION:
+        values[0] = listener.Position[0];
+        values[1] = listener.Position[1];
+        values[2] = listener.Position[2];
+        break;
+
+    case AL_ORIENTATION:
+        // AT then UP
+        values[0] = listener.OrientAt[0];
+        values[1] = listener.OrientAt[1];
+        values[2] = listener.OrientAt[2];
+        values[3] = listener.OrientUp[0];
+        values[4] = listener.OrientUp[1];
+        values[5] = listener.OrientUp[2];
+        break;
+
+    default:
+        alSetError(context.get(), AL_INVALID_ENUM, "Invalid indexed listener float property");
+    }
+}
+END_API_FUNC
+
+AL_API void AL_APIENTRY alGetListeneriIndexSOFT(ALuint index, ALenum param, ALint *value)
+START_API_FUNC
+{
+    if(index == 0)
+    {
+        alGetListeneri(param, value);
+        return;
+    }
+
+    ContextRef context{GetContextRef()};
+    if(UNLIKELY(!context)) return;
+
+    std::lock_guard<std::mutex> _{context->PropLock};
+    ALlistener *plistener{LookupExtraListener(context.get(), index)};
+    if(UNLIKELY(!plistener))
+        SETERR_RETURN(context.get(), AL_INVALID_VALUE,, "Invalid listener index %u", index);
+    if(!value)
+        alSetError(context.get(), AL_INVALID_VALUE, "NULL pointer");
+    else switch(param)
+    {
+    case AL_LISTENER_OUTPUT_CHANNEL_SOFT:
+        *value = plistener->OutputChannel;
+        break;
+
+    default:
+        alSetError(context.get(), AL_INVALID_ENUM, "Invalid indexed listener integer property");
+    }
+}
+END_API_FUNC
+
+
+void UpdateListenerProps(ALCcontext *context, ALlistener &listener)
+{
+    al::ArenaScope arena_scope{context->Device->mArena};
     /* Get an unused proprty container, or allocate a new one as needed. */
     ALlistenerProps *props{context->FreeListenerProps.load(std::memory_order_acquire)};
     if(!props)
@@ -430,12 +645,14 @@ void UpdateListenerProps(ALCcontext *context)
     }
 
     /* Copy in current property values. */
-    ALlistener &listener = context->Listener;
     props->Position = listener.Position;
     props->Velocity = listener.Velocity;
     props->OrientAt = listener.OrientAt;
     props->OrientUp = listener.OrientUp;
     props->Gain = listener.Gain;
+    props->OutputChannel = listener.OutputChannel;
+
+    props->Batch = context->PublishBatch.load(std::memory_order_relaxed);
 
     /* Set the new container for updating internal parameters. */
     props = listener.Update.exchange(props, std::memory_order_acq_rel);
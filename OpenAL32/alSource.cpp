@@ -22,14 +22,15 @@
 
 #include <cstdlib>
 #include <climits>
+#include <cinttypes>
 #include <cfloat>
 
 #include <cmath>
 #include <thread>
 #include <limits>
-#include <numeric>
 #include <algorithm>
 #include <functional>
+#include <new>
 
 #include "AL/al.h"
 #include "AL/alc.h"
@@ -41,7 +42,9 @@
 #include "alBuffer.h"
 #include "alFilter.h"
 #include "alAuxEffectSlot.h"
+#include "alSourceGroup.h"
 #include "ringbuffer.h"
+#include "callrecord.h"
 #include "bformatdec.h"
 
 #include "backends/base.h"
@@ -69,86 +72,251 @@ inline ALvoice *GetSourceVoice(ALsource *source, ALCcontext *context)
     return nullptr;
 }
 
-void UpdateSourceProps(const ALsource *source, ALvoice *voice, ALCcontext *context)
+/* Finds an unused voice, resuming from just past the last one taken so that
+ * starting a run of sources doesn't rescan the voices it already took. Voices
+ * that haven't been used yet are taken before wrapping around to the start,
+ * and more are added once they're all in use. Returns nullptr if the voice
+ * count can't grow. The backend lock must be held.
+ */
+ALvoice *GetFreeVoice(ALCcontext *context, ALsizei want, ALint *vidx)
 {
-    /* Get an unused property container, or allocate a new one as needed. */
-    ALvoiceProps *props{context->FreeVoiceProps.load(std::memory_order_acquire)};
-    if(!props)
-        props = new ALvoiceProps{};
-    else
+    auto is_free = [](const ALvoice *voice) noexcept -> bool
     {
-        ALvoiceProps *next;
-        do {
-            next = props->next.load(std::memory_order_relaxed);
-        } while(context->FreeVoiceProps.compare_exchange_weak(props, next,
-                std::memory_order_acq_rel, std::memory_order_acquire) == 0);
-    }
-
-    /* Copy in current property values. */
-    props->Pitch = source->Pitch;
-    props->Gain = source->Gain;
-    props->OuterGain = source->OuterGain;
-    props->MinGain = source->MinGain;
-    props->MaxGain = source->MaxGain;
-    props->InnerAngle = source->InnerAngle;
-    props->OuterAngle = source->OuterAngle;
-    props->RefDistance = source->RefDistance;
-    props->MaxDistance = source->MaxDistance;
-    props->RolloffFactor = source->RolloffFactor;
-    props->Position = source->Position;
-    props->Velocity = source->Velocity;
-    props->Direction = source->Direction;
-    props->OrientAt = source->OrientAt;
-    props->OrientUp = source->OrientUp;
-    props->HeadRelative = source->HeadRelative;
-    props->mDistanceModel = source->mDistanceModel;
-    props->mResampler = source->mResampler;
-    props->DirectChannels = source->DirectChannels;
-    props->mSpatializeMode = source->mSpatialize;
-
-    props->DryGainHFAuto = source->DryGainHFAuto;
-    props->WetGainAuto = source->WetGainAuto;
-    props->WetGainHFAuto = source->WetGainHFAuto;
-    props->OuterGainHF = source->OuterGainHF;
-
-    props->AirAbsorptionFactor = source->AirAbsorptionFactor;
-    props->RoomRolloffFactor = source->RoomRolloffFactor;
-    props->DopplerFactor = source->DopplerFactor;
-
-    props->StereoPan = source->StereoPan;
-
-    props->Radius = source->Radius;
-
-    props->Direct.Gain = source->Direct.Gain;
-    props->Direct.GainHF = source->Direct.GainHF;
-    props->Direct.HFReference = source->Direct.HFReference;
-    props->Direct.GainLF = source->Direct.GainLF;
-    props->Direct.LFReference = source->Direct.LFReference;
-
-    auto copy_send = [](const ALsource::SendData &srcsend) noexcept -> ALvoicePropsBase::SendData
-    {
-        ALvoicePropsBase::SendData ret;
-        ret.Slot = srcsend.Slot;
-        ret.Gain = srcsend.Gain;
-        ret.GainHF = srcsend.GainHF;
-        ret.HFReference = srcsend.HFReference;
-        ret.GainLF = srcsend.GainLF;
-        ret.LFReference = srcsend.LFReference;
-        return ret;
+        return voice->mPlayState.load(std::memory_order_acquire) == ALvoice::Stopped &&
+            voice->mSourceID.load(std::memory_order_relaxed) == 0u;
     };
-    std::transform(source->Send.cbegin(), source->Send.cend(), props->Send, copy_send);
 
-    /* Set the new container for updating internal parameters. */
-    props = voice->mUpdate.exchange(props, std::memory_order_acq_rel);
-    if(props)
+    const ALsizei count{context->VoiceCount.load(std::memory_order_relaxed)};
+    const ALsizei start{mini(context->NextVoiceIdx, count)};
+    ALvoice **voices{context->Voices};
+    ALvoice **voice_iter{std::find_if(voices+start, voices+count, is_free)};
+    if(voice_iter == voices+count && count == context->MaxVoices)
+    {
+        voice_iter = std::find_if(voices, voices+start, is_free);
+        if(voice_iter == voices+start)
+        {
+            /* Add a fixed-size chunk (or enough for the wanted voices), so
+             * growing costs the same however many voices there already are.
+             */
+            const ALsizei alloc_count{maxi(want, VOICE_CHUNK_SIZE)};
+            if(UNLIKELY(context->MaxVoices > std::numeric_limits<ALsizei>::max()-alloc_count))
+                return nullptr;
+            AllocateVoices(context, context->MaxVoices+alloc_count, context->Device->NumAuxSends);
+            voices = context->Voices;
+            voice_iter = voices+count;
+        }
+    }
+    /* Taking a voice past the current count makes it visible to the mixer. */
+    if(voice_iter == voices+count)
+        context->VoiceCount.store(count+1, std::memory_order_relaxed);
+
+    *vidx = static_cast<ALint>(std::distance(voices, voice_iter));
+    context->NextVoiceIdx = *vidx + 1;
+    return *voice_iter;
+}
+
+/* Gets a queue item that can hold count buffers, reusing one unqueued earlier
+ * from the context's pool if there is one, so a running stream doesn't
+ * allocate as it requeues buffers. Must be called with the context's source
+ * lock held.
+ */
+ALbufferlistitem *GetQueueItem(ALCcontext *context, ALsizei count)
+{
+    ALbufferlistitem *item{nullptr};
+    if(count <= MAX_POOLED_QUEUE_BUFFERS)
+    {
+        ALbufferlistitem *&freelist = context->FreeQueueItems[count-1];
+        if((item=freelist) != nullptr)
+            freelist = item->next.load(std::memory_order_relaxed);
+    }
+    if(!item)
+    {
+        item = static_cast<ALbufferlistitem*>(al_calloc(DEF_ALIGN,
+            ALbufferlistitem::Sizeof(static_cast<size_t>(count))));
+        if(!item) throw std::bad_alloc();
+        item->capacity = count;
+    }
+    item->next.store(nullptr, std::memory_order_relaxed);
+    item->max_samples = 0;
+    item->num_buffers = 0;
+    return item;
+}
+
+/* Returns an item the mixer is done with to the context's pool, or frees it
+ * if it's too big to keep. Its buffers must already be released.
+ */
+void ReleaseQueueItem(ALCcontext *context, ALbufferlistitem *item)
+{
+    if(item->capacity > MAX_POOLED_QUEUE_BUFFERS)
+    {
+        al_free(item);
+        return;
+    }
+    ALbufferlistitem *&freelist = context->FreeQueueItems[item->capacity-1];
+    item->next.store(freelist, std::memory_order_relaxed);
+    freelist = item;
+}
+
+/* Releases each buffer in a queue and returns its items to the context's
+ * pool.
+ */
+void ReleaseQueue(ALCcontext *context, ALbufferlistitem *queue)
+{
+    while(queue)
+    {
+        ALbufferlistitem *next{queue->next.load(std::memory_order_relaxed)};
+        std::for_each(queue->buffers, queue->buffers+queue->num_buffers,
+            [](ALbuffer *buffer) -> void
+            { if(buffer) DecrementRef(&buffer->ref); });
+        ReleaseQueueItem(context, queue);
+        queue = next;
+    }
+}
+
+/* Scales a fixed-point position by mul/div. Voices playing a resample cache
+ * step through its frames, each of which is a cache Increment of the buffer's
+ * fixed-point samples.
+ */
+inline uint64_t ScaleFixedPos(uint64_t pos, uint64_t mul, uint64_t div) noexcept
+{ return pos/div*mul + pos%div*mul/div; }
+
+/* Copies the source's current values for the given groups of properties
+ * into the container.
+ */
+void FillVoiceProps(ALvoiceProps *props, const ALsource *source, const ALuint groups)
+{
+    if((groups&VPROPS_POSE))
+    {
+        props->Position = source->Position;
+        props->Velocity = source->Velocity;
+        props->Direction = source->Direction;
+        props->OrientAt = source->OrientAt;
+        props->OrientUp = source->OrientUp;
+    }
+
+    if((groups&VPROPS_PARAMS))
+    {
+        props->Pitch = source->Pitch;
+        props->Gain = source->Gain;
+        props->OuterGain = source->OuterGain;
+        props->MinGain = source->MinGain;
+        props->MaxGain = source->MaxGain;
+        props->InnerAngle = source->InnerAngle;
+        props->OuterAngle = source->OuterAngle;
+        props->RefDistance = source->RefDistance;
+        props->MaxDistance = source->MaxDistance;
+        props->RolloffFactor = source->RolloffFactor;
+        props->HeadRelative = source->HeadRelative;
+        props->mDistanceModel = source->mDistanceModel;
+        props->mResampler = source->mResampler;
+        props->DirectChannels = source->DirectChannels;
+        props->mSpatializeMode = source->mSpatialize;
+        props->Priority = source->Priority;
+        props->FullHrtf = source->FullHrtf;
+        props->OutputChannel = source->OutputChannel;
+        props->Instancing = source->Instancing;
+
+        props->DryGainHFAuto = source->DryGainHFAuto;
+        props->WetGainAuto = source->WetGainAuto;
+        props->WetGainHFAuto = source->WetGainHFAuto;
+        props->OuterGainHF = source->OuterGainHF;
+
+        props->AirAbsorptionFactor = source->AirAbsorptionFactor;
+        props->RoomRolloffFactor = source->RoomRolloffFactor;
+        props->DopplerFactor = source->DopplerFactor;
+
+        props->StereoPan = source->StereoPan;
+
+        props->Radius = source->Radius;
+
+        props->Group = source->Group;
+
+        props->Direct.Link = source->Direct.Link;
+        props->Direct.Gain = source->Direct.Gain;
+        props->Direct.GainHF = source->Direct.GainHF;
+        props->Direct.HFReference = source->Direct.HFReference;
+        props->Direct.GainLF = source->Direct.GainLF;
+        props->Direct.LFReference = source->Direct.LFReference;
+    }
+
+    if((groups&VPROPS_SENDS))
+    {
+        auto copy_send = [](const ALsource::SendData &srcsend) noexcept -> ALvoicePropsBase::SendData
+        {
+            ALvoicePropsBase::SendData ret;
+            ret.Slot = srcsend.Slot;
+            ret.Link = srcsend.Link;
+            ret.Gain = srcsend.Gain;
+            ret.GainHF = srcsend.GainHF;
+            ret.HFReference = srcsend.HFReference;
+            ret.GainLF = srcsend.GainLF;
+            ret.LFReference = srcsend.LFReference;
+            return ret;
+        };
+        std::transform(source->Send, source->Send+source->NumSends, props->Send, copy_send);
+    }
+}
+
+/* Fills the given container with the source's changed properties, and sets
+ * it as the voice's next update. An update the mixer hasn't applied yet is
+ * taken back and put in the freelist, with its changes carried into the new
+ * one.
+ */
+void PublishSourceProps(ALsource *source, ALvoice *voice, ALvoiceProps *props,
+    ALCcontext *context)
+{
+    ALuint changed{source->DirtyProps.exchange(0u, std::memory_order_acq_rel)};
+    ALvoiceProps *pending{voice->mUpdate.exchange(nullptr, std::memory_order_acq_rel)};
+    ALuint filled{0u};
+    while(true)
     {
-        /* If there was an unused update container, put it back in the
-         * freelist.
+        if(pending)
+        {
+            changed |= pending->mChanged;
+            AtomicReplaceHead(context->FreeVoiceProps, pending);
+        }
+        FillVoiceProps(props, source, changed & ~filled);
+        filled = changed;
+        props->mChanged = changed;
+        props->mBatch = context->PublishBatch.load(std::memory_order_relaxed);
+
+        /* Set the new container for updating internal parameters, unless an
+         * update was set from elsewhere in the meantime, in which case that
+         * one needs to be merged in too.
          */
-        AtomicReplaceHead(context->FreeVoiceProps, props);
+        ALvoiceProps *expected{nullptr};
+        if(voice->mUpdate.compare_exchange_strong(expected, props, std::memory_order_acq_rel,
+            std::memory_order_acquire))
+            break;
+        pending = voice->mUpdate.exchange(nullptr, std::memory_order_acq_rel);
+    }
+}
+
+/* Get an unused property container, adding another chunk to the pool if the
+ * freelist is empty.
+ */
+ALvoiceProps *AcquireVoiceProps(ALCcontext *context)
+{
+    ALvoiceProps *props{context->FreeVoiceProps.load(std::memory_order_acquire)};
+    while(true)
+    {
+        if(!props)
+        {
+            context->VoicePropMisses.fetch_add(1u, std::memory_order_relaxed);
+            ReserveVoiceProps(context, VoicePropChunkSize);
+            props = context->FreeVoiceProps.load(std::memory_order_acquire);
+            continue;
+        }
+        ALvoiceProps *next{props->next.load(std::memory_order_relaxed)};
+        if(context->FreeVoiceProps.compare_exchange_weak(props, next, std::memory_order_acq_rel,
+            std::memory_order_acquire))
+            return props;
     }
 }
 
+void UpdateSourceProps(ALsource *source, ALvoice *voice, ALCcontext *context)
+{ PublishSourceProps(source, voice, AcquireVoiceProps(context), context); }
+
 
 /* GetSourceSampleOffset
  *
@@ -161,12 +329,14 @@ int64_t GetSourceSampleOffset(ALsource *Source, ALCcontext *context, std::chrono
     ALCdevice *device{context->Device};
     const ALbufferlistitem *Current;
     uint64_t readPos;
+    ALint increment;
     ALuint refcount;
     ALvoice *voice;
 
     do {
         Current = nullptr;
         readPos = 0;
+        increment = 0;
         while(((refcount=device->MixCount.load(std::memory_order_acquire))&1))
             std::this_thread::yield();
         *clocktime = GetDeviceClockTime(device);
@@ -176,22 +346,27 @@ int64_t GetSourceSampleOffset(ALsource *Source, ALCcontext *context, std::chrono
         {
             Current = voice->mCurrentBuffer.load(std::memory_order_relaxed);
 
-            readPos  = uint64_t{voice->mPosition.load(std::memory_order_relaxed)} << 32;
-            readPos |= int64_t{voice->mPositionFrac.load(std::memory_order_relaxed)} <<
-                       (32-FRACTIONBITS);
+            readPos  = voice->mPosition.load(std::memory_order_relaxed) << FRACTIONBITS;
+            readPos |= static_cast<ALuint>(voice->mPositionFrac.load(std::memory_order_relaxed));
+            if(voice->mResampled)
+                increment = voice->mResampled->Increment;
         }
         std::atomic_thread_fence(std::memory_order_acquire);
     } while(refcount != device->MixCount.load(std::memory_order_relaxed));
 
     if(voice)
     {
+        if(increment > 0)
+            readPos = ScaleFixedPos(readPos, static_cast<ALuint>(increment), FRACTIONONE);
         const ALbufferlistitem *BufferList{Source->queue};
         while(BufferList && BufferList != Current)
         {
-            readPos += int64_t{BufferList->max_samples} << 32;
+            readPos += static_cast<uint64_t>(BufferList->max_samples) << FRACTIONBITS;
             BufferList = BufferList->next.load(std::memory_order_relaxed);
         }
-        readPos = minu64(readPos, 0x7fffffffffffffff_u64);
+        /* Positions past 2^31 samples saturate in 32.32 fixed-point. */
+        readPos = minu64(readPos, (0x7fffffff_u64<<FRACTIONBITS) | FRACTIONMASK) <<
+            (32-FRACTIONBITS);
     }
 
     return static_cast<int64_t>(readPos);
@@ -207,12 +382,14 @@ ALdouble GetSourceSecOffset(ALsource *Source, ALCcontext *context, std::chrono::
     ALCdevice *device{context->Device};
     const ALbufferlistitem *Current;
     uint64_t readPos;
+    ALint increment;
     ALuint refcount;
     ALvoice *voice;
 
     do {
         Current = nullptr;
         readPos = 0;
+        increment = 0;
         while(((refcount=device->MixCount.load(std::memory_order_acquire))&1))
             std::this_thread::yield();
         *clocktime = GetDeviceClockTime(device);
@@ -222,8 +399,10 @@ ALdouble GetSourceSecOffset(ALsource *Source, ALCcontext *context, std::chrono::
         {
             Current = voice->mCurrentBuffer.load(std::memory_order_relaxed);
 
-            readPos  = uint64_t{voice->mPosition.load(std::memory_order_relaxed)} << FRACTIONBITS;
-            readPos |= voice->mPositionFrac.load(std::memory_order_relaxed);
+            readPos  = voice->mPosition.load(std::memory_order_relaxed) << FRACTIONBITS;
+            readPos |= static_cast<ALuint>(voice->mPositionFrac.load(std::memory_order_relaxed));
+            if(voice->mResampled)
+                increment = voice->mResampled->Increment;
         }
         std::atomic_thread_fence(std::memory_order_acquire);
     } while(refcount != device->MixCount.load(std::memory_order_relaxed));
@@ -231,13 +410,15 @@ ALdouble GetSourceSecOffset(ALsource *Source, ALCcontext *context, std::chrono::
     ALdouble offset{0.0};
     if(voice)
     {
+        if(increment > 0)
+            readPos = ScaleFixedPos(readPos, static_cast<ALuint>(increment), FRACTIONONE);
         const ALbufferlistitem *BufferList{Source->queue};
         const ALbuffer *BufferFmt{nullptr};
         while(BufferList && BufferList != Current)
         {
             for(ALsizei i{0};!BufferFmt && i < BufferList->num_buffers;++i)
                 BufferFmt = BufferList->buffers[i];
-            readPos += int64_t{BufferList->max_samples} << FRACTIONBITS;
+            readPos += static_cast<uint64_t>(BufferList->max_samples) << FRACTIONBITS;
             BufferList = BufferList->next.load(std::memory_order_relaxed);
         }
 
@@ -256,6 +437,91 @@ ALdouble GetSourceSecOffset(ALsource *Source, ALCcontext *context, std::chrono::
     return offset;
 }
 
+/* CalcSourceOffset
+ *
+ * Calculates the read offset for the given Source from its voice's position,
+ * in the appropriate format (Bytes, Samples or Seconds). The position must
+ * have been read consistently with the voice's current buffer.
+ */
+ALdouble CalcSourceOffset(const ALsource *Source, ALenum name, const ALbufferlistitem *Current,
+    uint64_t readPos, ALsizei readPosFrac, ALint increment)
+{
+    if(increment > 0)
+    {
+        uint64_t pos{(readPos<<FRACTIONBITS) | static_cast<ALuint>(readPosFrac)};
+        pos = ScaleFixedPos(pos, static_cast<ALuint>(increment), FRACTIONONE);
+        readPos = pos >> FRACTIONBITS;
+        readPosFrac = static_cast<ALsizei>(pos & FRACTIONMASK);
+    }
+    const ALbufferlistitem *BufferList{Source->queue};
+    const ALbuffer *BufferFmt{nullptr};
+    ALboolean readFin{AL_FALSE};
+    uint64_t totalBufferLen{0u};
+
+    while(BufferList)
+    {
+        for(ALsizei i{0};!BufferFmt && i < BufferList->num_buffers;++i)
+            BufferFmt = BufferList->buffers[i];
+
+        readFin |= (BufferList == Current);
+        totalBufferLen += static_cast<uint64_t>(BufferList->max_samples);
+        if(!readFin) readPos += static_cast<uint64_t>(BufferList->max_samples);
+
+        BufferList = BufferList->next.load(std::memory_order_relaxed);
+    }
+    assert(BufferFmt != nullptr);
+
+    if(Source->Looping)
+        readPos %= totalBufferLen;
+    else
+    {
+        /* Wrap back to 0 */
+        if(readPos >= totalBufferLen)
+            readPos = readPosFrac = 0;
+    }
+
+    ALdouble offset{0.0};
+    switch(name)
+    {
+        case AL_SEC_OFFSET:
+            offset = (readPos + static_cast<ALdouble>(readPosFrac)/FRACTIONONE) / BufferFmt->Frequency;
+            break;
+
+        case AL_SAMPLE_OFFSET:
+            offset = readPos + static_cast<ALdouble>(readPosFrac)/FRACTIONONE;
+            break;
+
+        case AL_BYTE_OFFSET:
+            if(BufferFmt->OriginalType == UserFmtIMA4)
+            {
+                ALsizei align = (BufferFmt->OriginalAlign-1)/2 + 4;
+                ALuint BlockSize = align * ChannelsFromFmt(BufferFmt->mFmtChannels);
+                ALuint FrameBlockSize = BufferFmt->OriginalAlign;
+
+                /* Round down to nearest ADPCM block */
+                offset = static_cast<ALdouble>(readPos / FrameBlockSize * BlockSize);
+            }
+            else if(BufferFmt->OriginalType == UserFmtMSADPCM)
+            {
+                ALsizei align = (BufferFmt->OriginalAlign-2)/2 + 7;
+                ALuint BlockSize = align * ChannelsFromFmt(BufferFmt->mFmtChannels);
+                ALuint FrameBlockSize = BufferFmt->OriginalAlign;
+
+                /* Round down to nearest ADPCM block */
+                offset = static_cast<ALdouble>(readPos / FrameBlockSize * BlockSize);
+            }
+            else
+            {
+                const ALsizei FrameSize{FrameSizeFromFmt(BufferFmt->mFmtChannels,
+                    BufferFmt->mFmtType)};
+                offset = static_cast<ALdouble>(readPos * FrameSize);
+            }
+            break;
+    }
+
+    return offset;
+}
+
 /* GetSourceOffset
  *
  * Gets the current read offset for the given Source, in the appropriate format
@@ -266,14 +532,16 @@ ALdouble GetSourceOffset(ALsource *Source, ALenum name, ALCcontext *context)
 {
     ALCdevice *device{context->Device};
     const ALbufferlistitem *Current;
-    ALuint readPos;
+    uint64_t readPos;
     ALsizei readPosFrac;
+    ALint increment;
     ALuint refcount;
     ALvoice *voice;
 
     do {
         Current = nullptr;
         readPos = readPosFrac = 0;
+        increment = 0;
         while(((refcount=device->MixCount.load(std::memory_order_acquire))&1))
             std::this_thread::yield();
         voice = GetSourceVoice(Source, context);
@@ -283,91 +551,23 @@ ALdouble GetSourceOffset(ALsource *Source, ALenum name, ALCcontext *context)
 
             readPos = voice->mPosition.load(std::memory_order_relaxed);
             readPosFrac = voice->mPositionFrac.load(std::memory_order_relaxed);
+            if(voice->mResampled)
+                increment = voice->mResampled->Increment;
         }
         std::atomic_thread_fence(std::memory_order_acquire);
     } while(refcount != device->MixCount.load(std::memory_order_relaxed));
 
-    ALdouble offset{0.0};
-    if(voice)
-    {
-        const ALbufferlistitem *BufferList{Source->queue};
-        const ALbuffer *BufferFmt{nullptr};
-        ALboolean readFin{AL_FALSE};
-        ALuint totalBufferLen{0u};
-
-        while(BufferList)
-        {
-            for(ALsizei i{0};!BufferFmt && i < BufferList->num_buffers;++i)
-                BufferFmt = BufferList->buffers[i];
-
-            readFin |= (BufferList == Current);
-            totalBufferLen += BufferList->max_samples;
-            if(!readFin) readPos += BufferList->max_samples;
-
-            BufferList = BufferList->next.load(std::memory_order_relaxed);
-        }
-        assert(BufferFmt != nullptr);
-
-        if(Source->Looping)
-            readPos %= totalBufferLen;
-        else
-        {
-            /* Wrap back to 0 */
-            if(readPos >= totalBufferLen)
-                readPos = readPosFrac = 0;
-        }
-
-        offset = 0.0;
-        switch(name)
-        {
-            case AL_SEC_OFFSET:
-                offset = (readPos + static_cast<ALdouble>(readPosFrac)/FRACTIONONE) / BufferFmt->Frequency;
-                break;
-
-            case AL_SAMPLE_OFFSET:
-                offset = readPos + static_cast<ALdouble>(readPosFrac)/FRACTIONONE;
-                break;
-
-            case AL_BYTE_OFFSET:
-                if(BufferFmt->OriginalType == UserFmtIMA4)
-                {
-                    ALsizei align = (BufferFmt->OriginalAlign-1)/2 + 4;
-                    ALuint BlockSize = align * ChannelsFromFmt(BufferFmt->mFmtChannels);
-                    ALuint FrameBlockSize = BufferFmt->OriginalAlign;
-
-                    /* Round down to nearest ADPCM block */
-                    offset = static_cast<ALdouble>(readPos / FrameBlockSize * BlockSize);
-                }
-                else if(BufferFmt->OriginalType == UserFmtMSADPCM)
-                {
-                    ALsizei align = (BufferFmt->OriginalAlign-2)/2 + 7;
-                    ALuint BlockSize = align * ChannelsFromFmt(BufferFmt->mFmtChannels);
-                    ALuint FrameBlockSize = BufferFmt->OriginalAlign;
-
-                    /* Round down to nearest ADPCM block */
-                    offset = static_cast<ALdouble>(readPos / FrameBlockSize * BlockSize);
-                }
-                else
-                {
-                    const ALsizei FrameSize{FrameSizeFromFmt(BufferFmt->mFmtChannels,
-                        BufferFmt->mFmtType)};
-                    offset = static_cast<ALdouble>(readPos * FrameSize);
-                }
-                break;
-        }
-    }
-
-    return offset;
+    if(!voice) return 0.0;
+    return CalcSourceOffset(Source, name, Current, readPos, readPosFrac, increment);
 }
 
-
 /* GetSampleOffset
  *
  * Retrieves the sample offset into the Source's queue (from the Sample, Byte
  * or Second offset supplied by the application). This takes into account the
  * fact that the buffer format may have been modifed since.
  */
-ALboolean GetSampleOffset(ALsource *Source, ALuint *offset, ALsizei *frac)
+ALboolean GetSampleOffset(ALsource *Source, uint64_t *offset, ALsizei *frac)
 {
     const ALbuffer *BufferFmt{nullptr};
     const ALbufferlistitem *BufferList;
@@ -393,7 +593,7 @@ ALboolean GetSampleOffset(ALsource *Source, ALuint *offset, ALsizei *frac)
     {
     case AL_BYTE_OFFSET:
         /* Determine the ByteOffset (and ensure it is block aligned) */
-        *offset = static_cast<ALuint>(Source->Offset);
+        *offset = static_cast<uint64_t>(Source->Offset);
         if(BufferFmt->OriginalType == UserFmtIMA4)
         {
             ALsizei align = (BufferFmt->OriginalAlign-1)/2 + 4;
@@ -413,13 +613,15 @@ ALboolean GetSampleOffset(ALsource *Source, ALuint *offset, ALsizei *frac)
 
     case AL_SAMPLE_OFFSET:
         dblfrac = modf(Source->Offset, &dbloff);
-        *offset = static_cast<ALuint>(mind(dbloff, std::numeric_limits<unsigned int>::max()));
+        *offset = static_cast<uint64_t>(mind(dbloff,
+            static_cast<ALdouble>(std::numeric_limits<int64_t>::max())));
         *frac = static_cast<ALsizei>(mind(dblfrac*FRACTIONONE, FRACTIONONE-1.0));
         break;
 
     case AL_SEC_OFFSET:
         dblfrac = modf(Source->Offset*BufferFmt->Frequency, &dbloff);
-        *offset = static_cast<ALuint>(mind(dbloff, std::numeric_limits<unsigned int>::max()));
+        *offset = static_cast<uint64_t>(mind(dbloff,
+            static_cast<ALdouble>(std::numeric_limits<int64_t>::max())));
         *frac = static_cast<ALsizei>(mind(dblfrac*FRACTIONONE, FRACTIONONE-1.0));
         break;
     }
@@ -437,24 +639,32 @@ ALboolean GetSampleOffset(ALsource *Source, ALuint *offset, ALsizei *frac)
 ALboolean ApplyOffset(ALsource *Source, ALvoice *voice)
 {
     /* Get sample frame offset */
-    ALuint offset{0u};
+    uint64_t offset{0u};
     ALsizei frac{0};
     if(!GetSampleOffset(Source, &offset, &frac))
         return AL_FALSE;
 
-    ALuint totalBufferLen{0u};
+    uint64_t totalBufferLen{0u};
     ALbufferlistitem *BufferList{Source->queue};
     while(BufferList && totalBufferLen <= offset)
     {
-        if(static_cast<ALuint>(BufferList->max_samples) > offset-totalBufferLen)
+        if(static_cast<uint64_t>(BufferList->max_samples) > offset-totalBufferLen)
         {
             /* Offset is in this buffer */
-            voice->mPosition.store(offset - totalBufferLen, std::memory_order_relaxed);
+            uint64_t pos{offset - totalBufferLen};
+            if(const ResampleCache *cache{voice->mResampled})
+            {
+                uint64_t fpos{(pos<<FRACTIONBITS) | static_cast<ALuint>(frac)};
+                fpos = ScaleFixedPos(fpos, FRACTIONONE, static_cast<ALuint>(cache->Increment));
+                pos = fpos >> FRACTIONBITS;
+                frac = static_cast<ALsizei>(fpos & FRACTIONMASK);
+            }
+            voice->mPosition.store(pos, std::memory_order_relaxed);
             voice->mPositionFrac.store(frac, std::memory_order_relaxed);
             voice->mCurrentBuffer.store(BufferList, std::memory_order_release);
             return AL_TRUE;
         }
-        totalBufferLen += BufferList->max_samples;
+        totalBufferLen += static_cast<uint64_t>(BufferList->max_samples);
 
         BufferList = BufferList->next.load(std::memory_order_relaxed);
     }
@@ -473,10 +683,8 @@ ALsource *AllocSource(ALCcontext *context)
         alSetError(context, AL_OUT_OF_MEMORY, "Exceeding %u source limit", device->SourcesMax);
         return nullptr;
     }
-    auto sublist = std::find_if(context->SourceList.begin(), context->SourceList.end(),
-        [](const SourceSubList &entry) noexcept -> bool
-        { return entry.FreeMask != 0; }
-    );
+    const ptrdiff_t freelist{context->SourceFreeMap.find()};
+    auto sublist = (freelist < 0) ? context->SourceList.end() : (context->SourceList.begin() + freelist);
     auto lidx = static_cast<ALsizei>(std::distance(context->SourceList.begin(), sublist));
     ALsource *source;
     ALsizei slidx;
@@ -506,18 +714,31 @@ ALsource *AllocSource(ALCcontext *context)
             alSetError(context, AL_OUT_OF_MEMORY, "Failed to allocate source batch");
             return nullptr;
         }
+        if(device->NumAuxSends > 0)
+        {
+            sublist->Sends = static_cast<ALsource::SendData*>(al_calloc(16,
+                sizeof(ALsource::SendData)*64*device->NumAuxSends));
+            if(UNLIKELY(!sublist->Sends))
+            {
+                context->SourceList.pop_back();
+                alSetError(context, AL_OUT_OF_MEMORY, "Failed to allocate source send batch");
+                return nullptr;
+            }
+        }
 
         slidx = 0;
         source = sublist->Sources + slidx;
     }
 
-    source = new (source) ALsource{device->NumAuxSends};
+    ALsource::SendData *sends{sublist->Sends ? sublist->Sends + slidx*device->NumAuxSends : nullptr};
+    source = new (source) ALsource{sends, device->NumAuxSends};
 
     /* Add 1 to avoid source ID 0. */
     source->id = ((lidx<<6) | slidx) + 1;
 
     context->NumSources += 1;
     sublist->FreeMask &= ~(1_u64 << slidx);
+    context->SourceFreeMap.set(static_cast<size_t>(lidx), sublist->FreeMask != 0);
 
     return source;
 }
@@ -535,6 +756,7 @@ void FreeSource(ALCcontext *context, ALsource *source)
         voice->mCurrentBuffer.store(nullptr, std::memory_order_relaxed);
         voice->mLoopBuffer.store(nullptr, std::memory_order_relaxed);
         voice->mSourceID.store(0u, std::memory_order_relaxed);
+        voice->mCompletedCount = nullptr;
         std::atomic_thread_fence(std::memory_order_release);
         /* Don't set the voice to stopping if it was already stopped or
          * stopping.
@@ -545,9 +767,12 @@ void FreeSource(ALCcontext *context, ALsource *source)
     }
     backlock.unlock();
 
+    ReleaseQueue(context, source->queue);
+    source->queue = nullptr;
     source->~ALsource();
 
     context->SourceList[lidx].FreeMask |= 1_u64 << slidx;
+    context->SourceFreeMap.set(static_cast<size_t>(lidx), true);
     context->NumSources--;
 }
 
@@ -557,12 +782,12 @@ inline ALsource *LookupSource(ALCcontext *context, ALuint id) noexcept
     ALuint lidx = (id-1) >> 6;
     ALsizei slidx = (id-1) & 0x3f;
 
-    if(UNLIKELY(lidx >= context->SourceList.size()))
+    SourceSubList *sublist{context->SourceList.lookup(lidx)};
+    if(UNLIKELY(!sublist))
         return nullptr;
-    SourceSubList &sublist{context->SourceList[lidx]};
-    if(UNLIKELY(sublist.FreeMask & (1_u64 << slidx)))
+    if(UNLIKELY(sublist->FreeMask.load(std::memory_order_acquire) & (1_u64 << slidx)))
         return nullptr;
-    return sublist.Sources + slidx;
+    return sublist->Sources + slidx;
 }
 
 inline ALbuffer *LookupBuffer(ALCdevice *device, ALuint id) noexcept
@@ -570,12 +795,45 @@ inline ALbuffer *LookupBuffer(ALCdevice *device, ALuint id) noexcept
     ALuint lidx = (id-1) >> 6;
     ALsizei slidx = (id-1) & 0x3f;
 
-    if(UNLIKELY(lidx >= device->BufferList.size()))
+    BufferSubList *sublist{device->BufferList.lookup(lidx)};
+    if(UNLIKELY(!sublist))
         return nullptr;
-    BufferSubList &sublist = device->BufferList[lidx];
-    if(UNLIKELY(sublist.FreeMask & (1_u64 << slidx)))
+    if(UNLIKELY(sublist->FreeMask.load(std::memory_order_acquire) & (1_u64 << slidx)))
         return nullptr;
-    return sublist.Buffers + slidx;
+    return sublist->Buffers + slidx;
+}
+
+/* Looks up a buffer and adds a reference to it for a source, without taking
+ * BufferLock. If the buffer is claimed, it waits on the lock for the claim to
+ * end and looks the buffer up again, in case it was deleted.
+ */
+ALbuffer *AttachBuffer(ALCdevice *device, ALuint id)
+{
+    ALbuffer *buffer{LookupBuffer(device, id)};
+    if(UNLIKELY(!buffer)) return nullptr;
+
+    unsigned int ref{buffer->ref.load(std::memory_order_relaxed)};
+    do {
+        if(UNLIKELY(ref&BUFFER_REF_CLAIMED))
+        {
+            /* Claims are only held with the lock. */
+            std::lock_guard<std::mutex> _{device->BufferLock};
+            if((buffer=LookupBuffer(device, id)) != nullptr)
+                IncrementRef(&buffer->ref);
+            return buffer;
+        }
+    } while(!buffer->ref.compare_exchange_weak(ref, ref+1, std::memory_order_acquire,
+        std::memory_order_relaxed));
+    return buffer;
+}
+
+/* Checks if a buffer is mapped without persistence, which stops sources from
+ * using it.
+ */
+inline bool IsMappedUnattachable(const ALbuffer *buffer) noexcept
+{
+    const ALbitfieldSOFT mapped{buffer->MappedAccess.load(std::memory_order_relaxed)};
+    return mapped != 0 && !(mapped&AL_MAP_PERSISTENT_BIT_SOFT);
 }
 
 inline ALfilter *LookupFilter(ALCdevice *device, ALuint id) noexcept
@@ -583,12 +841,23 @@ inline ALfilter *LookupFilter(ALCdevice *device, ALuint id) noexcept
     ALuint lidx = (id-1) >> 6;
     ALsizei slidx = (id-1) & 0x3f;
 
-    if(UNLIKELY(lidx >= device->FilterList.size()))
+    FilterSubList *sublist{device->FilterList.lookup(lidx)};
+    if(UNLIKELY(!sublist))
         return nullptr;
-    FilterSubList &sublist = device->FilterList[lidx];
-    if(UNLIKELY(sublist.FreeMask & (1_u64 << slidx)))
+    if(UNLIKELY(sublist->FreeMask.load(std::memory_order_acquire) & (1_u64 << slidx)))
         return nullptr;
-    return sublist.Filters + slidx;
+    return sublist->Filters + slidx;
+}
+
+/* Sets a source filter's link to the given filter if it's linked, or clears
+ * it, keeping the filters' link counts.
+ */
+void SetFilterLink(ALfilter *&link, ALfilter *filter) noexcept
+{
+    ALfilter *newlink{(filter && filter->Linked) ? filter : nullptr};
+    if(newlink) IncrementRef(&newlink->ref);
+    if(link) DecrementRef(&link->ref);
+    link = newlink;
 }
 
 inline ALeffectslot *LookupEffectSlot(ALCcontext *context, ALuint id) noexcept
@@ -596,12 +865,12 @@ inline ALeffectslot *LookupEffectSlot(ALCcontext *context, ALuint id) noexcept
     ALuint lidx = (id-1) >> 6;
     ALsizei slidx = (id-1) & 0x3f;
 
-    if(UNLIKELY(lidx >= context->EffectSlotList.size()))
+    EffectSlotSubList *sublist{context->EffectSlotList.lookup(lidx)};
+    if(UNLIKELY(!sublist))
         return nullptr;
-    EffectSlotSubList &sublist{context->EffectSlotList[lidx]};
-    if(UNLIKELY(sublist.FreeMask & (1_u64 << slidx)))
+    if(UNLIKELY(sublist->FreeMask.load(std::memory_order_acquire) & (1_u64 << slidx)))
         return nullptr;
-    return sublist.EffectSlots + slidx;
+    return sublist->EffectSlots + slidx;
 }
 
 
@@ -668,11 +937,50 @@ enum SourceProp : ALenum {
     /* AL_SOFT_source_spatialize */
     srcSpatialize = AL_SOURCE_SPATIALIZE_SOFT,
 
+    /* AL_SOFT_source_priority */
+    srcPriority = AL_SOURCE_PRIORITY_SOFT,
+
+    /* AL_SOFT_source_full_hrtf */
+    srcFullHrtf = AL_SOURCE_FULL_HRTF_SOFT,
+
+    /* AL_SOFT_source_output_channel */
+    srcOutputChannel = AL_SOURCE_OUTPUT_CHANNEL_SOFT,
+
+    /* AL_SOFT_source_instancing */
+    srcInstancing = AL_SOURCE_INSTANCING_SOFT,
+
+    /* AL_SOFT_source_groups */
+    srcSourceGroup = AL_SOURCE_GROUP_SOFT,
+
+    /* AL_SOFT_buffer_completion_wakeup */
+    srcBuffersCompleted = AL_BUFFERS_COMPLETED_SOFT,
+
+    /* AL_SOFT_source_mix_cost */
+    srcMixCost = AL_SOURCE_MIX_COST_SOFT,
+
     /* ALC_SOFT_device_clock */
     srcSampleOffsetClockSOFT = AL_SAMPLE_OFFSET_CLOCK_SOFT,
     srcSecOffsetClockSOFT = AL_SEC_OFFSET_CLOCK_SOFT,
 };
 
+/* Returns the group of voice properties a source property is sent with. */
+inline ALuint SourcePropGroup(SourceProp prop) noexcept
+{
+    switch(prop)
+    {
+    case srcPosition:
+    case srcVelocity:
+    case srcDirection:
+    case srcOrientation:
+        return VPROPS_POSE;
+    case srcAuxSendFilter:
+        return VPROPS_SENDS;
+    default:
+        break;
+    }
+    return VPROPS_PARAMS;
+}
+
 /**
  * Returns if the last known state for the source was playing or paused. Does
  * not sync with the mixer voice.
@@ -691,6 +999,38 @@ inline ALenum GetSourceState(ALsource *source, ALvoice *voice)
     return source->state;
 }
 
+/**
+ * Returns the number of buffers the source has finished playing, given the
+ * buffer its voice is on (or null if it has no voice).
+ */
+ALsizei GetProcessedBufferCount(const ALsource *source, const ALbufferlistitem *current)
+{
+    /* Buffers on a looping source are in a perpetual state of PENDING, so
+     * don't report any as PROCESSED.
+     */
+    if(source->Looping || source->SourceType != AL_STREAMING)
+        return 0;
+
+    const ALbufferlistitem *BufferList{source->queue};
+    if(!current && source->state == AL_INITIAL)
+        current = BufferList;
+
+    ALsizei played{0};
+    while(BufferList && BufferList != current)
+    {
+        played += BufferList->num_buffers;
+        BufferList = BufferList->next.load(std::memory_order_relaxed);
+    }
+    return played;
+}
+
+/**
+ * Returns if the buffer list item holds a callback buffer, which is playable
+ * despite having no stored samples.
+ */
+inline bool HasCallbackBuffer(const ALbufferlistitem *item) noexcept
+{ return item->num_buffers > 0 && item->buffers[0] && item->buffers[0]->Callback; }
+
 /**
  * Returns if the source should specify an update, given the context's
  * deferring state and the source's last known state.
@@ -720,7 +1060,30 @@ void SendStateChangeEvent(ALCcontext *context, ALuint id, ALenum state)
     evt->u.srcstate.id = id;
     evt->u.srcstate.state = state;
     ring->writeAdvance(1);
-    context->EventSem.post();
+    WakeEventThrd();
+}
+
+
+/* Gets the source's mixing cost, as sampled by the mixer for its voice: the
+ * resampler index in use (-1 if not resampling), whether it's mixed with HRTF,
+ * near-field control, and ambisonic upsampling, its channel count, the number
+ * of sends it feeds, and its average time to mix a quantum in nanoseconds.
+ * All 0, with the resampler as -1, for a source without a voice or one that
+ * hasn't been mixed yet.
+ */
+void GetSourceMixCost(ALsource *source, ALCcontext *context, ALint *values)
+{
+    ALvoice *voice{GetSourceVoice(source, context)};
+    const ALuint path{voice ? voice->mMixCostPath.load(std::memory_order_relaxed) : 0u};
+    const ALuint costns{voice ? voice->mMixCostNs.load(std::memory_order_relaxed) : 0u};
+
+    values[0] = static_cast<ALint>(path&VOICE_COST_RESAMPLER_MASK) - 1;
+    values[1] = (path&VOICE_COST_HRTF) ? AL_TRUE : AL_FALSE;
+    values[2] = (path&VOICE_COST_NFC) ? AL_TRUE : AL_FALSE;
+    values[3] = (path&VOICE_COST_AMBISONIC) ? AL_TRUE : AL_FALSE;
+    values[4] = static_cast<ALint>((path>>VOICE_COST_CHANNELS_SHIFT) & 0xff);
+    values[5] = static_cast<ALint>((path>>VOICE_COST_SENDS_SHIFT) & 0xff);
+    values[6] = static_cast<ALint>(minu(costns, INT_MAX));
 }
 
 
@@ -755,10 +1118,15 @@ ALint FloatValsByProp(ALenum prop)
         case AL_SOURCE_STATE:
         case AL_BUFFERS_QUEUED:
         case AL_BUFFERS_PROCESSED:
+        case AL_BUFFERS_COMPLETED_SOFT:
         case AL_SOURCE_TYPE:
         case AL_SOURCE_RADIUS:
         case AL_SOURCE_RESAMPLER_SOFT:
         case AL_SOURCE_SPATIALIZE_SOFT:
+        case AL_SOURCE_PRIORITY_SOFT:
+        case AL_SOURCE_FULL_HRTF_SOFT:
+        case AL_SOURCE_OUTPUT_CHANNEL_SOFT:
+        case AL_SOURCE_INSTANCING_SOFT:
             return 1;
 
         case AL_STEREO_ANGLES:
@@ -779,10 +1147,13 @@ ALint FloatValsByProp(ALenum prop)
         case AL_BUFFER:
         case AL_DIRECT_FILTER:
         case AL_AUXILIARY_SEND_FILTER:
+        case AL_SOURCE_GROUP_SOFT:
             break; /* i/i64 only */
         case AL_SAMPLE_OFFSET_LATENCY_SOFT:
         case AL_SAMPLE_OFFSET_CLOCK_SOFT:
             break; /* i64 only */
+        case AL_SOURCE_MIX_COST_SOFT:
+            break; /* i/i64 only */
     }
     return 0;
 }
@@ -817,10 +1188,15 @@ ALint DoubleValsByProp(ALenum prop)
         case AL_SOURCE_STATE:
         case AL_BUFFERS_QUEUED:
         case AL_BUFFERS_PROCESSED:
+        case AL_BUFFERS_COMPLETED_SOFT:
         case AL_SOURCE_TYPE:
         case AL_SOURCE_RADIUS:
         case AL_SOURCE_RESAMPLER_SOFT:
         case AL_SOURCE_SPATIALIZE_SOFT:
+        case AL_SOURCE_PRIORITY_SOFT:
+        case AL_SOURCE_FULL_HRTF_SOFT:
+        case AL_SOURCE_OUTPUT_CHANNEL_SOFT:
+        case AL_SOURCE_INSTANCING_SOFT:
             return 1;
 
         case AL_SEC_OFFSET_LATENCY_SOFT:
@@ -839,10 +1215,13 @@ ALint DoubleValsByProp(ALenum prop)
         case AL_BUFFER:
         case AL_DIRECT_FILTER:
         case AL_AUXILIARY_SEND_FILTER:
+        case AL_SOURCE_GROUP_SOFT:
             break; /* i/i64 only */
         case AL_SAMPLE_OFFSET_LATENCY_SOFT:
         case AL_SAMPLE_OFFSET_CLOCK_SOFT:
             break; /* i64 only */
+        case AL_SOURCE_MIX_COST_SOFT:
+            break; /* i/i64 only */
     }
     return 0;
 }
@@ -879,11 +1258,17 @@ ALint IntValsByProp(ALenum prop)
         case AL_SOURCE_STATE:
         case AL_BUFFERS_QUEUED:
         case AL_BUFFERS_PROCESSED:
+        case AL_BUFFERS_COMPLETED_SOFT:
         case AL_SOURCE_TYPE:
         case AL_DIRECT_FILTER:
         case AL_SOURCE_RADIUS:
         case AL_SOURCE_RESAMPLER_SOFT:
         case AL_SOURCE_SPATIALIZE_SOFT:
+        case AL_SOURCE_PRIORITY_SOFT:
+        case AL_SOURCE_FULL_HRTF_SOFT:
+        case AL_SOURCE_OUTPUT_CHANNEL_SOFT:
+        case AL_SOURCE_INSTANCING_SOFT:
+        case AL_SOURCE_GROUP_SOFT:
             return 1;
 
         case AL_POSITION:
@@ -895,6 +1280,9 @@ ALint IntValsByProp(ALenum prop)
         case AL_ORIENTATION:
             return 6;
 
+        case AL_SOURCE_MIX_COST_SOFT:
+            return 7;
+
         case AL_SAMPLE_OFFSET_LATENCY_SOFT:
         case AL_SAMPLE_OFFSET_CLOCK_SOFT:
             break; /* i64 only */
@@ -938,11 +1326,17 @@ ALint Int64ValsByProp(ALenum prop)
         case AL_SOURCE_STATE:
         case AL_BUFFERS_QUEUED:
         case AL_BUFFERS_PROCESSED:
+        case AL_BUFFERS_COMPLETED_SOFT:
         case AL_SOURCE_TYPE:
         case AL_DIRECT_FILTER:
         case AL_SOURCE_RADIUS:
         case AL_SOURCE_RESAMPLER_SOFT:
         case AL_SOURCE_SPATIALIZE_SOFT:
+        case AL_SOURCE_PRIORITY_SOFT:
+        case AL_SOURCE_FULL_HRTF_SOFT:
+        case AL_SOURCE_OUTPUT_CHANNEL_SOFT:
+        case AL_SOURCE_INSTANCING_SOFT:
+        case AL_SOURCE_GROUP_SOFT:
             return 1;
 
         case AL_SAMPLE_OFFSET_LATENCY_SOFT:
@@ -958,6 +1352,9 @@ ALint Int64ValsByProp(ALenum prop)
         case AL_ORIENTATION:
             return 6;
 
+        case AL_SOURCE_MIX_COST_SOFT:
+            return 7;
+
         case AL_SEC_OFFSET_LATENCY_SOFT:
         case AL_SEC_OFFSET_CLOCK_SOFT:
             break; /* Double only */
@@ -982,6 +1379,7 @@ ALboolean SetSourcei64v(ALsource *Source, ALCcontext *Context, SourceProp prop,
 
 #define DO_UPDATEPROPS() do {                                                 \
     ALvoice *voice;                                                           \
+    Source->DirtyProps.fetch_or(SourcePropGroup(prop));                       \
     if(SourceShouldUpdate(Source, Context) &&                                 \
        (voice=GetSourceVoice(Source, Context)) != nullptr)                       \
         UpdateSourceProps(Source, voice, Context);                            \
@@ -1190,19 +1588,26 @@ ALboolean SetSourcefv(ALsource *Source, ALCcontext *Context, SourceProp prop, co
         case AL_DIRECT_CHANNELS_SOFT:
         case AL_SOURCE_RESAMPLER_SOFT:
         case AL_SOURCE_SPATIALIZE_SOFT:
+        case AL_SOURCE_PRIORITY_SOFT:
+        case AL_SOURCE_FULL_HRTF_SOFT:
+        case AL_SOURCE_OUTPUT_CHANNEL_SOFT:
+        case AL_SOURCE_INSTANCING_SOFT:
             ival = static_cast<ALint>(values[0]);
             return SetSourceiv(Source, Context, prop, &ival);
 
         case AL_BUFFERS_QUEUED:
         case AL_BUFFERS_PROCESSED:
+        case AL_BUFFERS_COMPLETED_SOFT:
             ival = static_cast<ALint>(static_cast<ALuint>(values[0]));
             return SetSourceiv(Source, Context, prop, &ival);
 
         case AL_BUFFER:
         case AL_DIRECT_FILTER:
         case AL_AUXILIARY_SEND_FILTER:
+        case AL_SOURCE_GROUP_SOFT:
         case AL_SAMPLE_OFFSET_LATENCY_SOFT:
         case AL_SAMPLE_OFFSET_CLOCK_SOFT:
+        case AL_SOURCE_MIX_COST_SOFT:
             break;
     }
 
@@ -1219,7 +1624,6 @@ ALboolean SetSourceiv(ALsource *Source, ALCcontext *Context, SourceProp prop, co
     ALbufferlistitem *oldlist{nullptr};
     std::unique_lock<std::mutex> slotlock;
     std::unique_lock<std::mutex> filtlock;
-    std::unique_lock<std::mutex> buflock;
     ALfloat fvals[6];
 
     switch(prop)
@@ -1228,6 +1632,8 @@ ALboolean SetSourceiv(ALsource *Source, ALCcontext *Context, SourceProp prop, co
         case AL_SOURCE_TYPE:
         case AL_BUFFERS_QUEUED:
         case AL_BUFFERS_PROCESSED:
+        case AL_BUFFERS_COMPLETED_SOFT:
+        case AL_SOURCE_MIX_COST_SOFT:
             /* Query only */
             SETERR_RETURN(Context, AL_INVALID_OPERATION, AL_FALSE,
                           "Setting read-only source property 0x%04x", prop);
@@ -1264,34 +1670,35 @@ ALboolean SetSourceiv(ALsource *Source, ALCcontext *Context, SourceProp prop, co
             return AL_TRUE;
 
         case AL_BUFFER:
-            buflock = std::unique_lock<std::mutex>{device->BufferLock};
-            if(!(*values == 0 || (buffer=LookupBuffer(device, *values)) != nullptr))
+            if(!(*values == 0 || (buffer=AttachBuffer(device, *values)) != nullptr))
                 SETERR_RETURN(Context, AL_INVALID_VALUE, AL_FALSE, "Invalid buffer ID %u",
                               *values);
 
-            if(buffer && buffer->MappedAccess != 0 &&
-               !(buffer->MappedAccess&AL_MAP_PERSISTENT_BIT_SOFT))
+            if(buffer && IsMappedUnattachable(buffer))
+            {
+                DecrementRef(&buffer->ref);
                 SETERR_RETURN(Context, AL_INVALID_OPERATION, AL_FALSE,
                               "Setting non-persistently mapped buffer %u", buffer->id);
+            }
             else
             {
                 ALenum state = GetSourceState(Source, GetSourceVoice(Source, Context));
                 if(state == AL_PLAYING || state == AL_PAUSED)
+                {
+                    if(buffer) DecrementRef(&buffer->ref);
                     SETERR_RETURN(Context, AL_INVALID_OPERATION, AL_FALSE,
                                   "Setting buffer on playing or paused source %u", Source->id);
+                }
             }
 
             oldlist = Source->queue;
             if(buffer != nullptr)
             {
                 /* Add the selected buffer to a one-item queue */
-                auto newlist = static_cast<ALbufferlistitem*>(al_calloc(DEF_ALIGN,
-                    ALbufferlistitem::Sizeof(1u)));
-                newlist->next.store(nullptr, std::memory_order_relaxed);
+                ALbufferlistitem *newlist{GetQueueItem(Context, 1)};
                 newlist->max_samples = buffer->SampleLen;
                 newlist->num_buffers = 1;
                 newlist->buffers[0] = buffer;
-                IncrementRef(&buffer->ref);
 
                 /* Source is now Static */
                 Source->SourceType = AL_STATIC;
@@ -1303,21 +1710,9 @@ ALboolean SetSourceiv(ALsource *Source, ALCcontext *Context, SourceProp prop, co
                 Source->SourceType = AL_UNDETERMINED;
                 Source->queue = nullptr;
             }
-            buflock.unlock();
-
-            /* Delete all elements in the previous queue */
-            while(oldlist != nullptr)
-            {
-                ALbufferlistitem *temp{oldlist};
-                oldlist = temp->next.load(std::memory_order_relaxed);
 
-                for(ALsizei i{0};i < temp->num_buffers;i++)
-                {
-                    if(temp->buffers[i])
-                        DecrementRef(&temp->buffers[i]->ref);
-                }
-                al_free(temp);
-            }
+            /* Release all elements in the previous queue */
+            ReleaseQueue(Context, oldlist);
             return AL_TRUE;
 
         case AL_SEC_OFFSET:
@@ -1363,10 +1758,34 @@ ALboolean SetSourceiv(ALsource *Source, ALCcontext *Context, SourceProp prop, co
                 Source->Direct.GainLF = filter->GainLF;
                 Source->Direct.LFReference = filter->LFReference;
             }
+            SetFilterLink(Source->Direct.Link, filter);
             filtlock.unlock();
             DO_UPDATEPROPS();
             return AL_TRUE;
 
+        case AL_SOURCE_GROUP_SOFT:
+        {
+            std::lock_guard<std::mutex> _{Context->SourceGroupLock};
+            ALsourceGroup *group{nullptr};
+            if(!(*values == 0 || (group=LookupSourceGroup(Context, *values)) != nullptr))
+                SETERR_RETURN(Context, AL_INVALID_VALUE, AL_FALSE, "Invalid source group ID %u",
+                    *values);
+
+            if(group) IncrementRef(&group->ref);
+            if(Source->Group)
+                DecrementRef(&Source->Group->ref);
+            Source->Group = group;
+
+            /* Force an update if the source is active, in case the previous
+             * group is about to be deleted.
+             */
+            Source->DirtyProps.fetch_or(VPROPS_PARAMS, std::memory_order_relaxed);
+            ALvoice *voice{GetSourceVoice(Source, Context)};
+            if(voice) UpdateSourceProps(Source, voice, Context);
+            else Source->PropsClean.clear(std::memory_order_release);
+            return AL_TRUE;
+        }
+
         case AL_DIRECT_FILTER_GAINHF_AUTO:
             CHECKVAL(*values == AL_FALSE || *values == AL_TRUE);
 
@@ -1423,6 +1842,46 @@ ALboolean SetSourceiv(ALsource *Source, ALCcontext *Context, SourceProp prop, co
             DO_UPDATEPROPS();
             return AL_TRUE;
 
+        case AL_SOURCE_PRIORITY_SOFT:
+            Source->Priority = *values;
+            DO_UPDATEPROPS();
+            return AL_TRUE;
+
+        case AL_SOURCE_FULL_HRTF_SOFT:
+            CHECKVAL(*values == AL_FALSE || *values == AL_TRUE);
+
+            Source->FullHrtf = *values;
+            DO_UPDATEPROPS();
+            return AL_TRUE;
+
+        case AL_SOURCE_OUTPUT_CHANNEL_SOFT:
+            CHECKVAL(*values == AL_NONE || *values == AL_OUTPUT_CHANNEL_FRONT_CENTER_SOFT ||
+                *values == AL_OUTPUT_CHANNEL_LFE_SOFT);
+
+            Source->OutputChannel = *values;
+            DO_UPDATEPROPS();
+            return AL_TRUE;
+
+        case AL_SOURCE_INSTANCING_SOFT:
+            CHECKVAL(*values == AL_FALSE || *values == AL_TRUE);
+
+            /* The mixer can't allocate the instances' storage itself, so it's
+             * made when the first source allows instancing.
+             */
+            if(*values && !Context->Instances.load(std::memory_order_relaxed))
+            {
+                try {
+                    Context->Instances.store(new VoiceInstanceArray{}, std::memory_order_release);
+                }
+                catch(std::bad_alloc&) {
+                    alSetError(Context, AL_OUT_OF_MEMORY, "Failed to allocate voice instances");
+                    return AL_FALSE;
+                }
+            }
+            Source->Instancing = *values;
+            DO_UPDATEPROPS();
+            return AL_TRUE;
+
 
         case AL_AUXILIARY_SEND_FILTER:
             slotlock = std::unique_lock<std::mutex>{Context->EffectSlotLock};
@@ -1454,6 +1913,7 @@ ALboolean SetSourceiv(ALsource *Source, ALCcontext *Context, SourceProp prop, co
                 Source->Send[values[1]].GainLF = filter->GainLF;
                 Source->Send[values[1]].LFReference = filter->LFReference;
             }
+            SetFilterLink(Source->Send[values[1]].Link, filter);
             filtlock.unlock();
 
             if(slot != Source->Send[values[1]].Slot && IsPlayingOrPaused(Source))
@@ -1467,6 +1927,7 @@ ALboolean SetSourceiv(ALsource *Source, ALCcontext *Context, SourceProp prop, co
                 /* We must force an update if the auxiliary slot changed on an
                  * active source, in case the slot is about to be deleted.
                  */
+                Source->DirtyProps.fetch_or(VPROPS_SENDS, std::memory_order_relaxed);
                 ALvoice *voice{GetSourceVoice(Source, Context)};
                 if(voice) UpdateSourceProps(Source, voice, Context);
                 else Source->PropsClean.clear(std::memory_order_release);
@@ -1544,9 +2005,11 @@ ALboolean SetSourcei64v(ALsource *Source, ALCcontext *Context, SourceProp prop,
         case AL_SOURCE_TYPE:
         case AL_BUFFERS_QUEUED:
         case AL_BUFFERS_PROCESSED:
+        case AL_BUFFERS_COMPLETED_SOFT:
         case AL_SOURCE_STATE:
         case AL_SAMPLE_OFFSET_LATENCY_SOFT:
         case AL_SAMPLE_OFFSET_CLOCK_SOFT:
+        case AL_SOURCE_MIX_COST_SOFT:
             /* Query only */
             SETERR_RETURN(Context, AL_INVALID_OPERATION, AL_FALSE,
                           "Setting read-only source property 0x%04x", prop);
@@ -1564,6 +2027,10 @@ ALboolean SetSourcei64v(ALsource *Source, ALCcontext *Context, SourceProp prop,
         case AL_DISTANCE_MODEL:
         case AL_SOURCE_RESAMPLER_SOFT:
         case AL_SOURCE_SPATIALIZE_SOFT:
+        case AL_SOURCE_PRIORITY_SOFT:
+        case AL_SOURCE_FULL_HRTF_SOFT:
+        case AL_SOURCE_OUTPUT_CHANNEL_SOFT:
+        case AL_SOURCE_INSTANCING_SOFT:
             CHECKVAL(*values <= INT_MAX && *values >= INT_MIN);
 
             ivals[0] = static_cast<ALint>(*values);
@@ -1572,6 +2039,7 @@ ALboolean SetSourcei64v(ALsource *Source, ALCcontext *Context, SourceProp prop,
         /* 1x uint */
         case AL_BUFFER:
         case AL_DIRECT_FILTER:
+        case AL_SOURCE_GROUP_SOFT:
             CHECKVAL(*values <= UINT_MAX && *values >= 0);
 
             ivals[0] = static_cast<ALuint>(*values);
@@ -1785,6 +2253,7 @@ ALboolean GetSourcedv(ALsource *Source, ALCcontext *Context, SourceProp prop, AL
         case AL_SOURCE_STATE:
         case AL_BUFFERS_QUEUED:
         case AL_BUFFERS_PROCESSED:
+        case AL_BUFFERS_COMPLETED_SOFT:
         case AL_SOURCE_TYPE:
         case AL_DIRECT_FILTER_GAINHF_AUTO:
         case AL_AUXILIARY_SEND_FILTER_GAIN_AUTO:
@@ -1793,6 +2262,10 @@ ALboolean GetSourcedv(ALsource *Source, ALCcontext *Context, SourceProp prop, AL
         case AL_DISTANCE_MODEL:
         case AL_SOURCE_RESAMPLER_SOFT:
         case AL_SOURCE_SPATIALIZE_SOFT:
+        case AL_SOURCE_PRIORITY_SOFT:
+        case AL_SOURCE_FULL_HRTF_SOFT:
+        case AL_SOURCE_OUTPUT_CHANNEL_SOFT:
+        case AL_SOURCE_INSTANCING_SOFT:
             if((err=GetSourceiv(Source, Context, prop, ivals)) != AL_FALSE)
                 *values = static_cast<ALdouble>(ivals[0]);
             return err;
@@ -1800,8 +2273,10 @@ ALboolean GetSourcedv(ALsource *Source, ALCcontext *Context, SourceProp prop, AL
         case AL_BUFFER:
         case AL_DIRECT_FILTER:
         case AL_AUXILIARY_SEND_FILTER:
+        case AL_SOURCE_GROUP_SOFT:
         case AL_SAMPLE_OFFSET_LATENCY_SOFT:
         case AL_SAMPLE_OFFSET_CLOCK_SOFT:
+        case AL_SOURCE_MIX_COST_SOFT:
             break;
     }
 
@@ -1851,33 +2326,17 @@ ALboolean GetSourceiv(ALsource *Source, ALCcontext *Context, SourceProp prop, AL
             return AL_TRUE;
 
         case AL_BUFFERS_PROCESSED:
-            if(Source->Looping || Source->SourceType != AL_STREAMING)
-            {
-                /* Buffers on a looping source are in a perpetual state of
-                 * PENDING, so don't report any as PROCESSED */
-                *values = 0;
-            }
-            else
             {
-                const ALbufferlistitem *BufferList{Source->queue};
-                const ALbufferlistitem *Current{nullptr};
-                ALsizei played{0};
-
                 ALvoice *voice{GetSourceVoice(Source, Context)};
-                if(voice != nullptr)
-                    Current = voice->mCurrentBuffer.load(std::memory_order_relaxed);
-                else if(Source->state == AL_INITIAL)
-                    Current = BufferList;
-
-                while(BufferList && BufferList != Current)
-                {
-                    played += BufferList->num_buffers;
-                    BufferList = BufferList->next.load(std::memory_order_relaxed);
-                }
-                *values = played;
+                *values = GetProcessedBufferCount(Source, voice ?
+                    voice->mCurrentBuffer.load(std::memory_order_relaxed) : nullptr);
             }
             return AL_TRUE;
 
+        case AL_BUFFERS_COMPLETED_SOFT:
+            *values = static_cast<ALint>(Source->BuffersCompleted.load(std::memory_order_acquire));
+            return AL_TRUE;
+
         case AL_SOURCE_TYPE:
             *values = Source->SourceType;
             return AL_TRUE;
@@ -1910,6 +2369,30 @@ ALboolean GetSourceiv(ALsource *Source, ALCcontext *Context, SourceProp prop, AL
             *values = Source->mSpatialize;
             return AL_TRUE;
 
+        case AL_SOURCE_PRIORITY_SOFT:
+            *values = Source->Priority;
+            return AL_TRUE;
+
+        case AL_SOURCE_GROUP_SOFT:
+            *values = Source->Group ? Source->Group->id : 0;
+            return AL_TRUE;
+
+        case AL_SOURCE_FULL_HRTF_SOFT:
+            *values = Source->FullHrtf;
+            return AL_TRUE;
+
+        case AL_SOURCE_OUTPUT_CHANNEL_SOFT:
+            *values = Source->OutputChannel;
+            return AL_TRUE;
+
+        case AL_SOURCE_INSTANCING_SOFT:
+            *values = Source->Instancing;
+            return AL_TRUE;
+
+        case AL_SOURCE_MIX_COST_SOFT:
+            GetSourceMixCost(Source, Context, values);
+            return AL_TRUE;
+
         /* 1x float/double */
         case AL_CONE_INNER_ANGLE:
         case AL_CONE_OUTER_ANGLE:
@@ -2068,6 +2551,7 @@ ALboolean GetSourcei64v(ALsource *Source, ALCcontext *Context, SourceProp prop,
         case AL_SOURCE_STATE:
         case AL_BUFFERS_QUEUED:
         case AL_BUFFERS_PROCESSED:
+        case AL_BUFFERS_COMPLETED_SOFT:
         case AL_SOURCE_TYPE:
         case AL_DIRECT_FILTER_GAINHF_AUTO:
         case AL_AUXILIARY_SEND_FILTER_GAIN_AUTO:
@@ -2076,6 +2560,10 @@ ALboolean GetSourcei64v(ALsource *Source, ALCcontext *Context, SourceProp prop,
         case AL_DISTANCE_MODEL:
         case AL_SOURCE_RESAMPLER_SOFT:
         case AL_SOURCE_SPATIALIZE_SOFT:
+        case AL_SOURCE_PRIORITY_SOFT:
+        case AL_SOURCE_FULL_HRTF_SOFT:
+        case AL_SOURCE_OUTPUT_CHANNEL_SOFT:
+        case AL_SOURCE_INSTANCING_SOFT:
             if((err=GetSourceiv(Source, Context, prop, ivals)) != AL_FALSE)
                 *values = ivals[0];
             return err;
@@ -2083,6 +2571,7 @@ ALboolean GetSourcei64v(ALsource *Source, ALCcontext *Context, SourceProp prop,
         /* 1x uint */
         case AL_BUFFER:
         case AL_DIRECT_FILTER:
+        case AL_SOURCE_GROUP_SOFT:
             if((err=GetSourceiv(Source, Context, prop, ivals)) != AL_FALSE)
                 *values = static_cast<ALuint>(ivals[0]);
             return err;
@@ -2097,6 +2586,14 @@ ALboolean GetSourcei64v(ALsource *Source, ALCcontext *Context, SourceProp prop,
             }
             return err;
 
+        case AL_SOURCE_MIX_COST_SOFT:
+            {
+                ALint costvals[7];
+                GetSourceMixCost(Source, Context, costvals);
+                std::copy(std::begin(costvals), std::end(costvals), values);
+            }
+            return AL_TRUE;
+
         case AL_SEC_OFFSET_LATENCY_SOFT:
         case AL_SEC_OFFSET_CLOCK_SOFT:
             break; /* Double only */
@@ -2109,6 +2606,304 @@ ALboolean GetSourcei64v(ALsource *Source, ALCcontext *Context, SourceProp prop,
                   prop);
 }
 
+/* Starts playing the given sources. A start time past the device clock's
+ * current time delays the new voices until the sample it falls on.
+ */
+void StartSources(ALCcontext *context, const ALuint *sources, const ALsizei n,
+    const std::chrono::nanoseconds start_time)
+{
+    std::lock_guard<std::mutex> _{context->SourceLock};
+    auto sources_end = sources+n;
+    auto bad_sid = std::find_if_not(sources, sources_end,
+        [context](ALuint sid) -> bool
+        {
+            ALsource *source{LookupSource(context, sid)};
+            return LIKELY(source != nullptr);
+        }
+    );
+    if(UNLIKELY(bad_sid != sources+n))
+        SETERR_RETURN(context, AL_INVALID_NAME,, "Invalid source ID %u", *bad_sid);
+
+    ALCdevice *device{context->Device};
+    /* Resample any static buffers that want it before locking out the mixer,
+     * since it can take a while.
+     */
+    std::for_each(sources, sources_end,
+        [context,device](ALuint sid) -> void
+        {
+            ALsource *source{LookupSource(context, sid)};
+            ALbufferlistitem *BufferList{source->queue};
+            if(source->SourceType == AL_STATIC && BufferList && BufferList->num_buffers == 1
+                && BufferList->buffers[0])
+                PrepareResampleCache(device, BufferList->buffers[0]);
+        }
+    );
+
+    BackendLockGuard __{*device->Backend};
+    /* If the device is disconnected, go right to stopped. */
+    if(UNLIKELY(!device->Connected.load(std::memory_order_acquire)))
+    {
+        /* TODO: Send state change event? */
+        std::for_each(sources, sources_end,
+            [context](ALuint sid) -> void
+            {
+                ALsource *source{LookupSource(context, sid)};
+                source->OffsetType = AL_NONE;
+                source->Offset = 0.0;
+                source->state = AL_STOPPED;
+            }
+        );
+        return;
+    }
+
+    /* The number of sources left to start, for how many voices to add if
+     * they run out.
+     */
+    ALsizei remaining{n};
+    /* Voices wait for a start time the device clock hasn't reached yet. */
+    const bool delayed{start_time > GetDeviceClockTime(device)};
+    auto start_source = [context,device,&remaining,start_time,delayed](ALuint sid) -> void
+    {
+        const ALsizei want{remaining--};
+        ALsource *source{LookupSource(context, sid)};
+        /* Check that there is a queue containing at least one valid, non zero
+         * length buffer.
+         */
+        ALbufferlistitem *BufferList{source->queue};
+        while(BufferList && BufferList->max_samples == 0 && !HasCallbackBuffer(BufferList))
+            BufferList = BufferList->next.load(std::memory_order_relaxed);
+
+        /* If there's nothing to play, go right to stopped. */
+        if(UNLIKELY(!BufferList))
+        {
+            /* NOTE: A source without any playable buffers should not have an
+             * ALvoice since it shouldn't be in a playing or paused state. So
+             * there's no need to look up its voice and clear the source.
+             */
+            ALenum oldstate{GetSourceState(source, nullptr)};
+            source->OffsetType = AL_NONE;
+            source->Offset = 0.0;
+            if(oldstate != AL_STOPPED)
+            {
+                source->state = AL_STOPPED;
+                SendStateChangeEvent(context, source->id, AL_STOPPED);
+            }
+            return;
+        }
+
+        ALvoice *voice{GetSourceVoice(source, context)};
+        switch(GetSourceState(source, voice))
+        {
+        case AL_PLAYING:
+            assert(voice != nullptr);
+            /* A source that's already playing is restarted from the beginning. */
+            voice->mCurrentBuffer.store(BufferList, std::memory_order_relaxed);
+            voice->mPosition.store(0u, std::memory_order_relaxed);
+            voice->mPositionFrac.store(0, std::memory_order_release);
+            if(delayed)
+            {
+                voice->mStartTime = start_time;
+                voice->mFlags |= VOICE_IS_DELAYED;
+            }
+            return;
+
+        case AL_PAUSED:
+            assert(voice != nullptr);
+            /* A source that's paused simply resumes. */
+            if(delayed)
+            {
+                voice->mStartTime = start_time;
+                voice->mFlags |= VOICE_IS_DELAYED;
+            }
+            voice->mPlayState.store(ALvoice::Playing, std::memory_order_release);
+            source->state = AL_PLAYING;
+            SendStateChangeEvent(context, source->id, AL_PLAYING);
+            return;
+
+        default:
+            assert(voice == nullptr);
+            break;
+        }
+
+        /* Look for an unused voice to play this source with. */
+        ALint vidx{-1};
+        voice = GetFreeVoice(context, want, &vidx);
+        if(UNLIKELY(!voice))
+        {
+            alSetError(context, AL_OUT_OF_MEMORY, "Overflow increasing voice count to %d + %d",
+                context->MaxVoices, want);
+            return;
+        }
+        voice->mPlayState.store(ALvoice::Stopped, std::memory_order_release);
+
+        /* The voice may have last played a different source, so it needs all
+         * of the properties.
+         */
+        source->PropsClean.test_and_set(std::memory_order_acquire);
+        source->DirtyProps.store(VPROPS_ALL, std::memory_order_relaxed);
+        UpdateSourceProps(source, voice, context);
+
+        /* A source that's not playing or paused has any offset applied when it
+         * starts playing.
+         */
+        if(source->Looping)
+            voice->mLoopBuffer.store(source->queue, std::memory_order_relaxed);
+        else
+            voice->mLoopBuffer.store(nullptr, std::memory_order_relaxed);
+        voice->mCurrentBuffer.store(BufferList, std::memory_order_relaxed);
+        voice->mPosition.store(0u, std::memory_order_relaxed);
+        voice->mPositionFrac.store(0, std::memory_order_relaxed);
+        voice->mResampled = nullptr;
+        if(source->SourceType == AL_STATIC && BufferList->num_buffers == 1 &&
+            BufferList->buffers[0])
+            voice->mResampled = UseResampleCache(device, BufferList->buffers[0]);
+        bool start_fading{false};
+        if(ApplyOffset(source, voice) != AL_FALSE)
+            start_fading = voice->mPosition.load(std::memory_order_relaxed) != 0 ||
+                voice->mPositionFrac.load(std::memory_order_relaxed) != 0 ||
+                voice->mCurrentBuffer.load(std::memory_order_relaxed) != BufferList;
+
+        auto buffers_end = BufferList->buffers + BufferList->num_buffers;
+        auto buffer = std::find_if(BufferList->buffers, buffers_end,
+            std::bind(std::not_equal_to<const ALbuffer*>{}, _1, nullptr));
+        if(buffer != buffers_end)
+        {
+            voice->mFrequency = (*buffer)->Frequency;
+            voice->mFmtChannels = (*buffer)->mFmtChannels;
+            voice->mNumChannels = ChannelsFromFmt((*buffer)->mFmtChannels);
+            voice->mSampleSize  = BytesFromFmt((*buffer)->mFmtType);
+        }
+        /* A resample cache holds float samples at the device's rate. */
+        if(voice->mResampled)
+        {
+            voice->mFrequency = voice->mResampled->Buffer.Frequency;
+            voice->mSampleSize  = sizeof(ALfloat);
+        }
+
+        /* Clear previous samples. */
+        std::for_each(voice->mPrevSamples.begin(), voice->mPrevSamples.begin()+voice->mNumChannels,
+            [](std::array<ALfloat,MAX_RESAMPLE_PADDING*2> &samples) -> void
+            { std::fill(std::begin(samples), std::end(samples), 0.0f); });
+        std::fill(voice->mADPCMState.begin(), voice->mADPCMState.end(), ADPCMState{});
+
+        /* Clear the stepping value so the mixer knows not to mix this until
+         * the update gets applied.
+         */
+        voice->mStep = 0;
+        voice->mResampler = nullptr;
+        voice->mQuality = 0;
+        voice->mPrevResampler = nullptr;
+
+        voice->mClusterKey = 0;
+        voice->mClusterGain.Current = 0.0f;
+        voice->mClusterGain.Target = 0.0f;
+
+        voice->mMixCostCounter = 0;
+        voice->mMixCostNs.store(0u, std::memory_order_relaxed);
+        voice->mMixCostPath.store(0u, std::memory_order_relaxed);
+
+        voice->mFlags = start_fading ? VOICE_IS_FADING : 0;
+        if(source->SourceType == AL_STATIC) voice->mFlags |= VOICE_IS_STATIC;
+        if(delayed)
+        {
+            voice->mStartTime = start_time;
+            voice->mFlags |= VOICE_IS_DELAYED;
+        }
+
+        /* File-backed buffers start paging in from where the voice will start,
+         * ahead of its first mix.
+         */
+        voice->mReadAheadPos = 0;
+        if(source->SourceType == AL_STATIC && buffer != buffers_end && !voice->mResampled &&
+            (*buffer)->FileReadAhead > 0)
+        {
+            const auto pos = static_cast<int64_t>(voice->mPosition.load(std::memory_order_relaxed));
+            voice->mReadAheadPos = pos + (*buffer)->FileReadAhead*2;
+            PrefetchBufferData(*buffer, pos, (*buffer)->FileReadAhead*2);
+        }
+
+        /* Callback buffers are pulled into a block on the voice, which needs
+         * room for a full update with the resampler padding.
+         */
+        if(HasCallbackBuffer(BufferList))
+        {
+            voice->mFlags |= VOICE_IS_CALLBACK;
+            voice->mCallbackBlock.resize(static_cast<size_t>(
+                (BUFFERSIZE + MAX_RESAMPLE_PADDING*2) * voice->mNumChannels*voice->mSampleSize));
+            voice->mCallbackBlockLen = 0;
+        }
+
+        /* Don't need to set the VOICE_IS_AMBISONIC flag if the device is
+         * mixing in first order. No HF scaling is necessary to mix it.
+         */
+        if((voice->mFmtChannels == FmtBFormat2D || voice->mFmtChannels == FmtBFormat3D) &&
+           device->mAmbiOrder > 1)
+        {
+            auto scales = BFormatDec::GetHFOrderScales(1, device->mAmbiOrder);
+            if(voice->mFmtChannels == FmtBFormat2D)
+            {
+                static constexpr int Order2DFromChan[MAX_AMBI2D_CHANNELS]{
+                    0, 1,1, 2,2, 3,3
+                };
+                const size_t count{Ambi2DChannelsFromOrder(1u)};
+                std::transform(Order2DFromChan, Order2DFromChan+count, voice->mAmbiScales.begin(),
+                    [&scales](size_t idx) -> ALfloat { return scales[idx]; });
+            }
+            else
+            {
+                static constexpr int OrderFromChan[MAX_AMBI_CHANNELS]{
+                    0, 1,1,1, 2,2,2,2,2, 3,3,3,3,3,3,3,
+                };
+                const size_t count{Ambi2DChannelsFromOrder(1u)};
+                std::transform(OrderFromChan, OrderFromChan+count, voice->mAmbiScales.begin(),
+                    [&scales](size_t idx) -> ALfloat { return scales[idx]; });
+            }
+
+            voice->mAmbiSplitter[0].init(400.0f / static_cast<ALfloat>(device->MixFrequency));
+            std::fill_n(voice->mAmbiSplitter.begin()+1, voice->mNumChannels-1,
+                voice->mAmbiSplitter[0]);
+            voice->mFlags |= VOICE_IS_AMBISONIC;
+        }
+
+        std::for_each(std::begin(voice->mDirect.Params),
+            std::begin(voice->mDirect.Params)+voice->mNumChannels,
+            [voice](DirectParams &params) -> void { params.clear(voice->mNumGains); }
+        );
+        std::for_each(voice->mSend.begin(), voice->mSend.end(),
+            [voice](ALvoice::SendData &send) -> void
+            {
+                std::for_each(std::begin(send.Params), std::begin(send.Params)+voice->mNumChannels,
+                    [voice](SendParams &params) -> void { params.clear(voice->mNumGains); });
+            }
+        );
+        if(voice->mDirectHrtf)
+            std::fill_n(voice->mDirectHrtf, voice->mNumChannels, DirectHrtfParams{});
+
+        if(voice->mDirectNfc)
+        {
+            ALfloat w1 = SPEEDOFSOUNDMETRESPERSEC /
+                         (device->AvgSpeakerDist * device->MixFrequency);
+            std::for_each(voice->mDirectNfc, voice->mDirectNfc+voice->mNumChannels,
+                [w1](NfcFilter &filter) noexcept -> void { filter.init(w1); }
+            );
+        }
+
+        voice->mCompletedCount = &source->BuffersCompleted;
+        voice->mSourceID.store(source->id, std::memory_order_relaxed);
+        voice->mPlayState.store(ALvoice::Playing, std::memory_order_release);
+        source->state = AL_PLAYING;
+        source->VoiceIdx = vidx;
+
+        SendStateChangeEvent(context, source->id, AL_PLAYING);
+    };
+    std::for_each(sources, sources_end, start_source);
+
+    /* Make room for any new resample caches now that the voices using them
+     * are set.
+     */
+    TrimResampleCaches(device);
+}
+
 } // namespace
 
 AL_API ALvoid AL_APIENTRY alGenSources(ALsizei n, ALuint *sources)
@@ -2122,7 +2917,12 @@ START_API_FUNC
     else if(n == 1)
     {
         ALsource *source = AllocSource(context.get());
-        if(source) sources[0] = source->id;
+        if(source)
+        {
+            sources[0] = source->id;
+            if(UNLIKELY(RecordEnabled))
+                RecordGen(context.get(), RecordObject::Source, 1, sources);
+        }
     }
     else
     {
@@ -2140,7 +2940,11 @@ START_API_FUNC
             alDeleteSources(static_cast<ALsizei>(std::distance(tempids.begin(), alloc_end)),
                 tempids.data());
         else
+        {
             std::copy(tempids.cbegin(), tempids.cend(), sources);
+            if(UNLIKELY(RecordEnabled))
+                RecordGen(context.get(), RecordObject::Source, n, sources);
+        }
     }
 }
 END_API_FUNC
@@ -2171,6 +2975,9 @@ START_API_FUNC
     );
     if(LIKELY(invsrc == sources_end))
     {
+        if(UNLIKELY(RecordEnabled))
+            RecordDelete(context.get(), RecordObject::Source, n, sources);
+
         /* All good. Delete source IDs. */
         std::for_each(sources, sources_end,
             [&context](ALuint sid) -> void
@@ -2189,7 +2996,6 @@ START_API_FUNC
     ContextRef context{GetContextRef()};
     if(LIKELY(context))
     {
-        std::lock_guard<std::mutex> _{context->SourceLock};
         if(LookupSource(context.get(), source) != nullptr)
             return AL_TRUE;
     }
@@ -2212,7 +3018,11 @@ START_API_FUNC
     else if(FloatValsByProp(param) != 1)
         alSetError(context.get(), AL_INVALID_ENUM, "Invalid float property 0x%04x", param);
     else
+    {
+        if(UNLIKELY(RecordEnabled))
+            RecordParamfv(context.get(), RecordObject::Source, source, param, 1, &value);
         SetSourcefv(Source, context.get(), static_cast<SourceProp>(param), &value);
+    }
 }
 END_API_FUNC
 
@@ -2232,6 +3042,8 @@ START_API_FUNC
     else
     {
         ALfloat fvals[3] = { value1, value2, value3 };
+        if(UNLIKELY(RecordEnabled))
+            RecordParamfv(context.get(), RecordObject::Source, source, param, 3, fvals);
         SetSourcefv(Source, context.get(), static_cast<SourceProp>(param), fvals);
     }
 }
@@ -2253,7 +3065,12 @@ START_API_FUNC
     else if(FloatValsByProp(param) < 1)
         alSetError(context.get(), AL_INVALID_ENUM, "Invalid float-vector property 0x%04x", param);
     else
+    {
+        if(UNLIKELY(RecordEnabled))
+            RecordParamfv(context.get(), RecordObject::Source, source, param, FloatValsByProp(param),
+                values);
         SetSourcefv(Source, context.get(), static_cast<SourceProp>(param), values);
+    }
 }
 END_API_FUNC
 
@@ -2274,6 +3091,8 @@ START_API_FUNC
     else
     {
         ALfloat fval = static_cast<ALfloat>(value);
+        if(UNLIKELY(RecordEnabled))
+            RecordParamfv(context.get(), RecordObject::Source, source, param, 1, &fval);
         SetSourcefv(Source, context.get(), static_cast<SourceProp>(param), &fval);
     }
 }
@@ -2296,6 +3115,8 @@ START_API_FUNC
         ALfloat fvals[3] = {static_cast<ALfloat>(value1),
                             static_cast<ALfloat>(value2),
                             static_cast<ALfloat>(value3)};
+        if(UNLIKELY(RecordEnabled))
+            RecordParamfv(context.get(), RecordObject::Source, source, param, 3, fvals);
         SetSourcefv(Source, context.get(), static_cast<SourceProp>(param), fvals);
     }
 }
@@ -2326,6 +3147,8 @@ START_API_FUNC
 
             for(i = 0;i < count;i++)
                 fvals[i] = static_cast<ALfloat>(values[i]);
+            if(UNLIKELY(RecordEnabled))
+                RecordParamfv(context.get(), RecordObject::Source, source, param, count, fvals);
             SetSourcefv(Source, context.get(), static_cast<SourceProp>(param), fvals);
         }
     }
@@ -2347,7 +3170,11 @@ START_API_FUNC
     else if(IntValsByProp(param) != 1)
         alSetError(context.get(), AL_INVALID_ENUM, "Invalid integer property 0x%04x", param);
     else
+    {
+        if(UNLIKELY(RecordEnabled))
+            RecordParamiv(context.get(), RecordObject::Source, source, param, 1, &value);
         SetSourceiv(Source, context.get(), static_cast<SourceProp>(param), &value);
+    }
 }
 END_API_FUNC
 
@@ -2367,6 +3194,8 @@ START_API_FUNC
     else
     {
         ALint ivals[3] = { value1, value2, value3 };
+        if(UNLIKELY(RecordEnabled))
+            RecordParamiv(context.get(), RecordObject::Source, source, param, 3, ivals);
         SetSourceiv(Source, context.get(), static_cast<SourceProp>(param), ivals);
     }
 }
@@ -2388,7 +3217,12 @@ START_API_FUNC
     else if(IntValsByProp(param) < 1)
         alSetError(context.get(), AL_INVALID_ENUM, "Invalid integer-vector property 0x%04x", param);
     else
+    {
+        if(UNLIKELY(RecordEnabled))
+            RecordParamiv(context.get(), RecordObject::Source, source, param, IntValsByProp(param),
+                values);
         SetSourceiv(Source, context.get(), static_cast<SourceProp>(param), values);
+    }
 }
 END_API_FUNC
 
@@ -2407,7 +3241,11 @@ START_API_FUNC
     else if(Int64ValsByProp(param) != 1)
         alSetError(context.get(), AL_INVALID_ENUM, "Invalid integer64 property 0x%04x", param);
     else
+    {
+        if(UNLIKELY(RecordEnabled))
+            RecordParami64v(context.get(), RecordObject::Source, source, param, 1, &value);
         SetSourcei64v(Source, context.get(), static_cast<SourceProp>(param), &value);
+    }
 }
 END_API_FUNC
 
@@ -2427,6 +3265,8 @@ START_API_FUNC
     else
     {
         ALint64SOFT i64vals[3] = { value1, value2, value3 };
+        if(UNLIKELY(RecordEnabled))
+            RecordParami64v(context.get(), RecordObject::Source, source, param, 3, i64vals);
         SetSourcei64v(Source, context.get(), static_cast<SourceProp>(param), i64vals);
     }
 }
@@ -2448,7 +3288,12 @@ START_API_FUNC
     else if(Int64ValsByProp(param) < 1)
         alSetError(context.get(), AL_INVALID_ENUM, "Invalid integer64-vector property 0x%04x", param);
     else
+    {
+        if(UNLIKELY(RecordEnabled))
+            RecordParami64v(context.get(), RecordObject::Source, source, param, Int64ValsByProp(param),
+                values);
         SetSourcei64v(Source, context.get(), static_cast<SourceProp>(param), values);
+    }
 }
 END_API_FUNC
 
@@ -2732,253 +3577,213 @@ START_API_FUNC
 END_API_FUNC
 
 
-AL_API ALvoid AL_APIENTRY alSourcePlay(ALuint source)
-START_API_FUNC
-{ alSourcePlayv(1, &source); }
-END_API_FUNC
-
-AL_API ALvoid AL_APIENTRY alSourcePlayv(ALsizei n, const ALuint *sources)
+AL_API void AL_APIENTRY alSourceUpdateBatchSOFT(ALsizei count, const ALuint *sources,
+    const ALsourceUpdateSOFT *updates)
 START_API_FUNC
 {
     ContextRef context{GetContextRef()};
     if(UNLIKELY(!context)) return;
 
-    if(n < 0)
-        SETERR_RETURN(context.get(), AL_INVALID_VALUE,, "Playing %d sources", n);
-    if(n == 0) return;
+    if(UNLIKELY(count < 0))
+        SETERR_RETURN(context.get(), AL_INVALID_VALUE,, "Updating %d sources", count);
+    if(count == 0) return;
+    if(UNLIKELY(!sources || !updates))
+        SETERR_RETURN(context.get(), AL_INVALID_VALUE,, "NULL pointer");
 
-    std::lock_guard<std::mutex> _{context->SourceLock};
-    auto sources_end = sources+n;
-    auto bad_sid = std::find_if_not(sources, sources_end,
-        [&context](ALuint sid) -> bool
-        {
-            ALsource *source{LookupSource(context.get(), sid)};
-            return LIKELY(source != nullptr);
-        }
-    );
-    if(UNLIKELY(bad_sid != sources+n))
-        SETERR_RETURN(context.get(), AL_INVALID_NAME,, "Invalid source ID %u", *bad_sid);
+    std::lock_guard<std::mutex> _{context->PropLock};
+    std::lock_guard<std::mutex> __{context->SourceLock};
 
-    ALCdevice *device{context->Device};
-    BackendLockGuard __{*device->Backend};
-    /* If the device is disconnected, go right to stopped. */
-    if(UNLIKELY(!device->Connected.load(std::memory_order_acquire)))
+    /* Validate everything first, so an error leaves all sources unchanged. */
+    for(ALsizei i{0};i < count;i++)
     {
-        /* TODO: Send state change event? */
-        std::for_each(sources, sources_end,
-            [&context](ALuint sid) -> void
-            {
-                ALsource *source{LookupSource(context.get(), sid)};
-                source->OffsetType = AL_NONE;
-                source->Offset = 0.0;
-                source->state = AL_STOPPED;
-            }
-        );
-        return;
+        if(UNLIKELY(!LookupSource(context.get(), sources[i])))
+            SETERR_RETURN(context.get(), AL_INVALID_NAME,, "Invalid source ID %u", sources[i]);
+
+        const ALsourceUpdateSOFT &update = updates[i];
+        if(UNLIKELY(!(std::isfinite(update.Position[0]) && std::isfinite(update.Position[1])
+            && std::isfinite(update.Position[2]))))
+            SETERR_RETURN(context.get(), AL_INVALID_VALUE,, "Source %u position out of range",
+                sources[i]);
+        if(UNLIKELY(!(std::isfinite(update.Velocity[0]) && std::isfinite(update.Velocity[1])
+            && std::isfinite(update.Velocity[2]))))
+            SETERR_RETURN(context.get(), AL_INVALID_VALUE,, "Source %u velocity out of range",
+                sources[i]);
+        if(UNLIKELY(!(update.Gain >= 0.0f && std::isfinite(update.Gain))))
+            SETERR_RETURN(context.get(), AL_INVALID_VALUE,, "Source %u gain out of range",
+                sources[i]);
+        if(UNLIKELY(!(update.Pitch >= 0.0f && std::isfinite(update.Pitch))))
+            SETERR_RETURN(context.get(), AL_INVALID_VALUE,, "Source %u pitch out of range",
+                sources[i]);
     }
 
-    /* Count the number of reusable voices. */
-    auto voices_end = context->Voices + context->VoiceCount.load(std::memory_order_relaxed);
-    auto free_voices = std::accumulate(context->Voices, voices_end, ALsizei{0},
-        [](const ALsizei count, const ALvoice *voice) noexcept -> ALsizei
-        {
-            if(voice->mPlayState.load(std::memory_order_acquire) == ALvoice::Stopped &&
-                voice->mSourceID.load(std::memory_order_relaxed) == 0u)
-                return count + 1;
-            return count;
-        }
-    );
-    if(UNLIKELY(n > free_voices))
-    {
-        /* Increment the number of voices to handle the request. */
-        const ALsizei need_voices{n - free_voices};
-        const ALsizei rem_voices{context->MaxVoices -
-            context->VoiceCount.load(std::memory_order_relaxed)};
+    if(UNLIKELY(RecordEnabled))
+        RecordSourceUpdateBatch(context.get(), count, sources, updates);
 
-        if(UNLIKELY(need_voices > rem_voices))
-        {
-            /* Allocate more voices to get enough. */
-            const ALsizei alloc_count{need_voices - rem_voices};
-            if(UNLIKELY(context->MaxVoices > std::numeric_limits<ALsizei>::max()-alloc_count))
-                SETERR_RETURN(context.get(), AL_OUT_OF_MEMORY,,
-                    "Overflow increasing voice count to %d + %d", context->MaxVoices, alloc_count);
+    /* Publish the updates in a new batch, which the mixer leaves pending until
+     * it's committed, so they're all applied in the same update.
+     */
+    const bool deferred{context->DeferUpdates.load(std::memory_order_acquire)};
+    const ALuint batch{context->CommittedBatch.load(std::memory_order_relaxed) + 1u};
+    if(!deferred)
+        context->PublishBatch.store(batch, std::memory_order_relaxed);
 
-            const ALsizei newcount{context->MaxVoices + alloc_count};
-            AllocateVoices(context.get(), newcount, device->NumAuxSends);
+    /* Take the whole freelist at once, rather than one container at a time,
+     * and put back what's left at the end.
+     */
+    ALvoiceProps *freelist{context->FreeVoiceProps.exchange(nullptr, std::memory_order_acq_rel)};
+    for(ALsizei i{0};i < count;i++)
+    {
+        ALsource *source{LookupSource(context.get(), sources[i])};
+        const ALsourceUpdateSOFT &update = updates[i];
+
+        source->Position[0] = update.Position[0];
+        source->Position[1] = update.Position[1];
+        source->Position[2] = update.Position[2];
+        source->Velocity[0] = update.Velocity[0];
+        source->Velocity[1] = update.Velocity[1];
+        source->Velocity[2] = update.Velocity[2];
+        source->Gain = update.Gain;
+        source->Pitch = update.Pitch;
+        source->DirtyProps.fetch_or(VPROPS_POSE|VPROPS_PARAMS, std::memory_order_relaxed);
+
+        ALvoice *voice;
+        if(deferred || !IsPlayingOrPaused(source) ||
+           (voice=GetSourceVoice(source, context.get())) == nullptr)
+        {
+            source->PropsClean.clear(std::memory_order_release);
+            continue;
         }
 
-        context->VoiceCount.fetch_add(need_voices, std::memory_order_relaxed);
+        ALvoiceProps *props{freelist};
+        if(!props)
+            props = AcquireVoiceProps(context.get());
+        else
+            freelist = props->next.load(std::memory_order_relaxed);
+        PublishSourceProps(source, voice, props, context.get());
     }
-
-    auto start_source = [&context,device](ALuint sid) -> void
+    if(freelist)
     {
-        ALsource *source{LookupSource(context.get(), sid)};
-        /* Check that there is a queue containing at least one valid, non zero
-         * length buffer.
-         */
-        ALbufferlistitem *BufferList{source->queue};
-        while(BufferList && BufferList->max_samples == 0)
-            BufferList = BufferList->next.load(std::memory_order_relaxed);
+        ALvoiceProps *last{freelist};
+        while(ALvoiceProps *next{last->next.load(std::memory_order_relaxed)})
+            last = next;
+        ALvoiceProps *first{context->FreeVoiceProps.load(std::memory_order_acquire)};
+        do {
+            last->next.store(first, std::memory_order_relaxed);
+        } while(!context->FreeVoiceProps.compare_exchange_weak(first, freelist,
+                std::memory_order_acq_rel, std::memory_order_acquire));
+    }
 
-        /* If there's nothing to play, go right to stopped. */
-        if(UNLIKELY(!BufferList))
-        {
-            /* NOTE: A source without any playable buffers should not have an
-             * ALvoice since it shouldn't be in a playing or paused state. So
-             * there's no need to look up its voice and clear the source.
-             */
-            ALenum oldstate{GetSourceState(source, nullptr)};
-            source->OffsetType = AL_NONE;
-            source->Offset = 0.0;
-            if(oldstate != AL_STOPPED)
-            {
-                source->state = AL_STOPPED;
-                SendStateChangeEvent(context.get(), source->id, AL_STOPPED);
-            }
-            return;
-        }
+    if(!deferred)
+        context->CommittedBatch.store(batch, std::memory_order_release);
+}
+END_API_FUNC
 
-        ALvoice *voice{GetSourceVoice(source, context.get())};
-        switch(GetSourceState(source, voice))
-        {
-        case AL_PLAYING:
-            assert(voice != nullptr);
-            /* A source that's already playing is restarted from the beginning. */
-            voice->mCurrentBuffer.store(BufferList, std::memory_order_relaxed);
-            voice->mPosition.store(0u, std::memory_order_relaxed);
-            voice->mPositionFrac.store(0, std::memory_order_release);
-            return;
+AL_API void AL_APIENTRY alGetSourcesStateSOFT(ALsizei count, const ALuint *sources,
+    ALsourceStateSOFT *states)
+START_API_FUNC
+{
+    ContextRef context{GetContextRef()};
+    if(UNLIKELY(!context)) return;
 
-        case AL_PAUSED:
-            assert(voice != nullptr);
-            /* A source that's paused simply resumes. */
-            voice->mPlayState.store(ALvoice::Playing, std::memory_order_release);
-            source->state = AL_PLAYING;
-            SendStateChangeEvent(context.get(), source->id, AL_PLAYING);
-            return;
+    if(UNLIKELY(count < 0))
+        SETERR_RETURN(context.get(), AL_INVALID_VALUE,, "Querying %d sources", count);
+    if(count == 0) return;
+    if(UNLIKELY(!sources || !states))
+        SETERR_RETURN(context.get(), AL_INVALID_VALUE,, "NULL pointer");
 
-        default:
-            assert(voice == nullptr);
-            break;
-        }
+    std::lock_guard<std::mutex> _{context->SourceLock};
+    for(ALsizei i{0};i < count;i++)
+    {
+        if(UNLIKELY(!LookupSource(context.get(), sources[i])))
+            SETERR_RETURN(context.get(), AL_INVALID_NAME,, "Invalid source ID %u", sources[i]);
+    }
 
-        /* Look for an unused voice to play this source with. */
-        auto voices_end = context->Voices + context->VoiceCount.load(std::memory_order_relaxed);
-        auto voice_iter = std::find_if(context->Voices, voices_end,
-            [](const ALvoice *voice) noexcept -> bool
+    /* Snapshot every source within the same mix, so the states and offsets
+     * are all consistent with each other.
+     */
+    ALCdevice *device{context->Device};
+    ALuint refcount;
+    do {
+        while(((refcount=device->MixCount.load(std::memory_order_acquire))&1))
+            std::this_thread::yield();
+        for(ALsizei i{0};i < count;i++)
+        {
+            ALsource *source{LookupSource(context.get(), sources[i])};
+            ALvoice *voice{GetSourceVoice(source, context.get())};
+            ALsourceStateSOFT &state = states[i];
+
+            state.State = GetSourceState(source, voice);
+            if(!voice)
             {
-                return voice->mPlayState.load(std::memory_order_acquire) == ALvoice::Stopped &&
-                    voice->mSourceID.load(std::memory_order_relaxed) == 0u;
+                state.SampleOffset = 0;
+                state.BuffersProcessed = GetProcessedBufferCount(source, nullptr);
+                continue;
             }
-        );
-        assert(voice_iter != voices_end);
-        auto vidx = static_cast<ALint>(std::distance(context->Voices, voice_iter));
-        voice = *voice_iter;
-        voice->mPlayState.store(ALvoice::Stopped, std::memory_order_release);
 
-        source->PropsClean.test_and_set(std::memory_order_acquire);
-        UpdateSourceProps(source, voice, context.get());
-
-        /* A source that's not playing or paused has any offset applied when it
-         * starts playing.
-         */
-        if(source->Looping)
-            voice->mLoopBuffer.store(source->queue, std::memory_order_relaxed);
-        else
-            voice->mLoopBuffer.store(nullptr, std::memory_order_relaxed);
-        voice->mCurrentBuffer.store(BufferList, std::memory_order_relaxed);
-        voice->mPosition.store(0u, std::memory_order_relaxed);
-        voice->mPositionFrac.store(0, std::memory_order_relaxed);
-        bool start_fading{false};
-        if(ApplyOffset(source, voice) != AL_FALSE)
-            start_fading = voice->mPosition.load(std::memory_order_relaxed) != 0 ||
-                voice->mPositionFrac.load(std::memory_order_relaxed) != 0 ||
-                voice->mCurrentBuffer.load(std::memory_order_relaxed) != BufferList;
+            const ALbufferlistitem *Current{voice->mCurrentBuffer.load(std::memory_order_relaxed)};
+            const uint64_t readPos{voice->mPosition.load(std::memory_order_relaxed)};
+            const ALsizei readPosFrac{voice->mPositionFrac.load(std::memory_order_relaxed)};
+            const ALint increment{voice->mResampled ? voice->mResampled->Increment : 0};
+            std::atomic_thread_fence(std::memory_order_acquire);
 
-        auto buffers_end = BufferList->buffers + BufferList->num_buffers;
-        auto buffer = std::find_if(BufferList->buffers, buffers_end,
-            std::bind(std::not_equal_to<const ALbuffer*>{}, _1, nullptr));
-        if(buffer != buffers_end)
-        {
-            voice->mFrequency = (*buffer)->Frequency;
-            voice->mFmtChannels = (*buffer)->mFmtChannels;
-            voice->mNumChannels = ChannelsFromFmt((*buffer)->mFmtChannels);
-            voice->mSampleSize  = BytesFromFmt((*buffer)->mFmtType);
+            state.SampleOffset = static_cast<ALint>(CalcSourceOffset(source, AL_SAMPLE_OFFSET,
+                Current, readPos, readPosFrac, increment));
+            state.BuffersProcessed = GetProcessedBufferCount(source, Current);
         }
+    } while(refcount != device->MixCount.load(std::memory_order_relaxed));
+}
+END_API_FUNC
 
-        /* Clear previous samples. */
-        std::for_each(voice->mPrevSamples.begin(), voice->mPrevSamples.begin()+voice->mNumChannels,
-            [](std::array<ALfloat,MAX_RESAMPLE_PADDING*2> &samples) -> void
-            { std::fill(std::begin(samples), std::end(samples), 0.0f); });
 
-        /* Clear the stepping value so the mixer knows not to mix this until
-         * the update gets applied.
-         */
-        voice->mStep = 0;
+AL_API ALvoid AL_APIENTRY alSourcePlay(ALuint source)
+START_API_FUNC
+{ alSourcePlayv(1, &source); }
+END_API_FUNC
 
-        voice->mFlags = start_fading ? VOICE_IS_FADING : 0;
-        if(source->SourceType == AL_STATIC) voice->mFlags |= VOICE_IS_STATIC;
+AL_API ALvoid AL_APIENTRY alSourcePlayv(ALsizei n, const ALuint *sources)
+START_API_FUNC
+{
+    ContextRef context{GetContextRef()};
+    if(UNLIKELY(!context)) return;
 
-        /* Don't need to set the VOICE_IS_AMBISONIC flag if the device is
-         * mixing in first order. No HF scaling is necessary to mix it.
-         */
-        if((voice->mFmtChannels == FmtBFormat2D || voice->mFmtChannels == FmtBFormat3D) &&
-           device->mAmbiOrder > 1)
-        {
-            auto scales = BFormatDec::GetHFOrderScales(1, device->mAmbiOrder);
-            if(voice->mFmtChannels == FmtBFormat2D)
-            {
-                static constexpr int Order2DFromChan[MAX_AMBI2D_CHANNELS]{
-                    0, 1,1, 2,2, 3,3
-                };
-                const size_t count{Ambi2DChannelsFromOrder(1u)};
-                std::transform(Order2DFromChan, Order2DFromChan+count, voice->mAmbiScales.begin(),
-                    [&scales](size_t idx) -> ALfloat { return scales[idx]; });
-            }
-            else
-            {
-                static constexpr int OrderFromChan[MAX_AMBI_CHANNELS]{
-                    0, 1,1,1, 2,2,2,2,2, 3,3,3,3,3,3,3,
-                };
-                const size_t count{Ambi2DChannelsFromOrder(1u)};
-                std::transform(OrderFromChan, OrderFromChan+count, voice->mAmbiScales.begin(),
-                    [&scales](size_t idx) -> ALfloat { return scales[idx]; });
-            }
+    if(n < 0)
+        SETERR_RETURN(context.get(), AL_INVALID_VALUE,, "Playing %d sources", n);
+    if(n == 0) return;
 
-            voice->mAmbiSplitter[0].init(400.0f / static_cast<ALfloat>(device->Frequency));
-            std::fill_n(voice->mAmbiSplitter.begin()+1, voice->mNumChannels-1,
-                voice->mAmbiSplitter[0]);
-            voice->mFlags |= VOICE_IS_AMBISONIC;
-        }
+    if(UNLIKELY(RecordEnabled))
+        RecordSourceOp(context.get(), RecordCall::SourcePlay, n, sources);
+    StartSources(context.get(), sources, n, std::chrono::nanoseconds::min());
+}
+END_API_FUNC
 
-        std::fill_n(std::begin(voice->mDirect.Params), voice->mNumChannels, DirectParams{});
-        std::for_each(voice->mSend.begin(), voice->mSend.end(),
-            [voice](ALvoice::SendData &send) -> void
-            { std::fill_n(std::begin(send.Params), voice->mNumChannels, SendParams{}); }
-        );
 
-        if(device->AvgSpeakerDist > 0.0f)
-        {
-            ALfloat w1 = SPEEDOFSOUNDMETRESPERSEC /
-                         (device->AvgSpeakerDist * device->Frequency);
-            std::for_each(voice->mDirect.Params+0, voice->mDirect.Params+voice->mNumChannels,
-                [w1](DirectParams &parms) noexcept -> void
-                { parms.NFCtrlFilter.init(w1); }
-            );
-        }
+AL_API void AL_APIENTRY alSourcePlayAtTimeSOFT(ALuint source, ALint64SOFT start_time)
+START_API_FUNC
+{ alSourcePlayAtTimevSOFT(1, &source, start_time); }
+END_API_FUNC
 
-        voice->mSourceID.store(source->id, std::memory_order_relaxed);
-        voice->mPlayState.store(ALvoice::Playing, std::memory_order_release);
-        source->state = AL_PLAYING;
-        source->VoiceIdx = vidx;
+AL_API void AL_APIENTRY alSourcePlayAtTimevSOFT(ALsizei n, const ALuint *sources, ALint64SOFT start_time)
+START_API_FUNC
+{
+    ContextRef context{GetContextRef()};
+    if(UNLIKELY(!context)) return;
 
-        SendStateChangeEvent(context.get(), source->id, AL_PLAYING);
-    };
-    std::for_each(sources, sources_end, start_source);
+    if(n < 0)
+        SETERR_RETURN(context.get(), AL_INVALID_VALUE,, "Playing %d sources", n);
+    if(UNLIKELY(start_time < 0))
+        SETERR_RETURN(context.get(), AL_INVALID_VALUE,, "Invalid time point %" PRId64,
+            start_time);
+    if(n == 0) return;
+
+    /* Recorded as a plain play, since the replay's clock only follows the
+     * mix and not the app's own time base.
+     */
+    if(UNLIKELY(RecordEnabled))
+        RecordSourceOp(context.get(), RecordCall::SourcePlay, n, sources);
+    StartSources(context.get(), sources, n, std::chrono::nanoseconds{start_time});
 }
 END_API_FUNC
 
-
 AL_API ALvoid AL_APIENTRY alSourcePause(ALuint source)
 START_API_FUNC
 { alSourcePausev(1, &source); }
@@ -3000,6 +3805,8 @@ START_API_FUNC
         if(!LookupSource(context.get(), sources[i]))
             SETERR_RETURN(context.get(), AL_INVALID_NAME,, "Invalid source ID %u", sources[i]);
     }
+    if(UNLIKELY(RecordEnabled))
+        RecordSourceOp(context.get(), RecordCall::SourcePause, n, sources);
 
     ALCdevice *device{context->Device};
     BackendLockGuard __{*device->Backend};
@@ -3045,6 +3852,8 @@ START_API_FUNC
         if(!LookupSource(context.get(), sources[i]))
             SETERR_RETURN(context.get(), AL_INVALID_NAME,, "Invalid source ID %u", sources[i]);
     }
+    if(UNLIKELY(RecordEnabled))
+        RecordSourceOp(context.get(), RecordCall::SourceStop, n, sources);
 
     ALCdevice *device{context->Device};
     BackendLockGuard __{*device->Backend};
@@ -3097,6 +3906,8 @@ START_API_FUNC
         if(!LookupSource(context.get(), sources[i]))
             SETERR_RETURN(context.get(), AL_INVALID_NAME,, "Invalid source ID %u", sources[i]);
     }
+    if(UNLIKELY(RecordEnabled))
+        RecordSourceOp(context.get(), RecordCall::SourceRewind, n, sources);
 
     ALCdevice *device{context->Device};
     BackendLockGuard __{*device->Backend};
@@ -3161,13 +3972,12 @@ START_API_FUNC
         BufferList = BufferList->next.load(std::memory_order_relaxed);
     }
 
-    std::unique_lock<std::mutex> buflock{device->BufferLock};
     ALbufferlistitem *BufferListStart{nullptr};
     BufferList = nullptr;
     for(ALsizei i{0};i < nb;i++)
     {
         ALbuffer *buffer{nullptr};
-        if(buffers[i] && (buffer=LookupBuffer(device, buffers[i])) == nullptr)
+        if(buffers[i] && (buffer=AttachBuffer(device, buffers[i])) == nullptr)
         {
             alSetError(context.get(), AL_INVALID_NAME, "Queueing invalid buffer ID %u",
                        buffers[i]);
@@ -3176,31 +3986,32 @@ START_API_FUNC
 
         if(!BufferListStart)
         {
-            BufferListStart = static_cast<ALbufferlistitem*>(al_calloc(DEF_ALIGN,
-                ALbufferlistitem::Sizeof(1u)));
+            BufferListStart = GetQueueItem(context.get(), 1);
             BufferList = BufferListStart;
         }
         else
         {
-            auto item = static_cast<ALbufferlistitem*>(al_calloc(DEF_ALIGN,
-                ALbufferlistitem::Sizeof(1u)));
+            ALbufferlistitem *item{GetQueueItem(context.get(), 1)};
             BufferList->next.store(item, std::memory_order_relaxed);
             BufferList = item;
         }
-        BufferList->next.store(nullptr, std::memory_order_relaxed);
         BufferList->max_samples = buffer ? buffer->SampleLen : 0;
         BufferList->num_buffers = 1;
         BufferList->buffers[0] = buffer;
         if(!buffer) continue;
 
-        IncrementRef(&buffer->ref);
-
-        if(buffer->MappedAccess != 0 && !(buffer->MappedAccess&AL_MAP_PERSISTENT_BIT_SOFT))
+        if(IsMappedUnattachable(buffer))
         {
             alSetError(context.get(), AL_INVALID_OPERATION,
                        "Queueing non-persistently mapped buffer %u", buffer->id);
             goto buffer_error;
         }
+        if(buffer->Callback)
+        {
+            alSetError(context.get(), AL_INVALID_OPERATION, "Queueing callback buffer %u",
+                       buffer->id);
+            goto buffer_error;
+        }
 
         if(BufferFmt == nullptr)
             BufferFmt = buffer;
@@ -3212,24 +4023,16 @@ START_API_FUNC
                        "Queueing buffer with mismatched format");
 
         buffer_error:
-            /* A buffer failed (invalid ID or format), so unlock and release
-             * each buffer we had. */
-            while(BufferListStart)
-            {
-                ALbufferlistitem *next = BufferListStart->next.load(std::memory_order_relaxed);
-                for(i = 0;i < BufferListStart->num_buffers;i++)
-                {
-                    if((buffer=BufferListStart->buffers[i]) != nullptr)
-                        DecrementRef(&buffer->ref);
-                }
-                al_free(BufferListStart);
-                BufferListStart = next;
-            }
+            /* A buffer failed (invalid ID or format), so release each buffer
+             * we had. */
+            ReleaseQueue(context.get(), BufferListStart);
             return;
         }
     }
     /* All buffers good. */
-    buflock.unlock();
+
+    if(UNLIKELY(RecordEnabled))
+        RecordSourceQueue(context.get(), src, nb, buffers);
 
     /* Source is now streaming */
     source->SourceType = AL_STREAMING;
@@ -3280,18 +4083,13 @@ START_API_FUNC
         BufferList = BufferList->next.load(std::memory_order_relaxed);
     }
 
-    std::unique_lock<std::mutex> buflock{device->BufferLock};
-    auto BufferListStart = static_cast<ALbufferlistitem*>(al_calloc(DEF_ALIGN,
-        ALbufferlistitem::Sizeof(nb)));
+    ALbufferlistitem *BufferListStart{GetQueueItem(context.get(), nb)};
     BufferList = BufferListStart;
-    BufferList->next.store(nullptr, std::memory_order_relaxed);
-    BufferList->max_samples = 0;
-    BufferList->num_buffers = 0;
 
     for(ALsizei i{0};i < nb;i++)
     {
         ALbuffer *buffer{nullptr};
-        if(buffers[i] && (buffer=LookupBuffer(device, buffers[i])) == nullptr)
+        if(buffers[i] && (buffer=AttachBuffer(device, buffers[i])) == nullptr)
         {
             alSetError(context.get(), AL_INVALID_NAME, "Queueing invalid buffer ID %u",
                        buffers[i]);
@@ -3301,16 +4099,20 @@ START_API_FUNC
         BufferList->buffers[BufferList->num_buffers++] = buffer;
         if(!buffer) continue;
 
-        IncrementRef(&buffer->ref);
-
-        BufferList->max_samples = maxi(BufferList->max_samples, buffer->SampleLen);
+        BufferList->max_samples = maxi64(BufferList->max_samples, buffer->SampleLen);
 
-        if(buffer->MappedAccess != 0 && !(buffer->MappedAccess&AL_MAP_PERSISTENT_BIT_SOFT))
+        if(IsMappedUnattachable(buffer))
         {
             alSetError(context.get(), AL_INVALID_OPERATION,
                        "Queueing non-persistently mapped buffer %u", buffer->id);
             goto buffer_error;
         }
+        if(buffer->Callback)
+        {
+            alSetError(context.get(), AL_INVALID_OPERATION, "Queueing callback buffer %u",
+                       buffer->id);
+            goto buffer_error;
+        }
 
         if(BufferFmt == nullptr)
             BufferFmt = buffer;
@@ -3322,24 +4124,13 @@ START_API_FUNC
                        "Queueing buffer with mismatched format");
 
         buffer_error:
-            /* A buffer failed (invalid ID or format), so unlock and release
-             * each buffer we had. */
-            while(BufferListStart)
-            {
-                ALbufferlistitem *next{BufferListStart->next.load(std::memory_order_relaxed)};
-                for(i = 0;i < BufferListStart->num_buffers;i++)
-                {
-                    if((buffer=BufferListStart->buffers[i]) != nullptr)
-                        DecrementRef(&buffer->ref);
-                }
-                al_free(BufferListStart);
-                BufferListStart = next;
-            }
+            /* A buffer failed (invalid ID or format), so release each buffer
+             * we had. */
+            ReleaseQueue(context.get(), BufferListStart);
             return;
         }
     }
     /* All buffers good. */
-    buflock.unlock();
 
     /* Source is now streaming */
     source->SourceType = AL_STREAMING;
@@ -3402,6 +4193,9 @@ START_API_FUNC
         i += BufferList->num_buffers;
     }
 
+    if(UNLIKELY(RecordEnabled))
+        RecordSourceUnqueue(context.get(), src, nb);
+
     while(nb > 0)
     {
         ALbufferlistitem *head{source->queue};
@@ -3422,12 +4216,12 @@ START_API_FUNC
             /* This head has some buffers left over, so move them to the front
              * and update the sample and buffer count.
              */
-            ALsizei max_length{0};
+            int64_t max_length{0};
             ALsizei j{0};
             while(i < head->num_buffers)
             {
                 ALbuffer *buffer{head->buffers[i++]};
-                if(buffer) max_length = maxi(max_length, buffer->SampleLen);
+                if(buffer) max_length = maxi64(max_length, buffer->SampleLen);
                 head->buffers[j++] = buffer;
             }
             head->max_samples = max_length;
@@ -3435,17 +4229,17 @@ START_API_FUNC
             break;
         }
 
-        /* Otherwise, free this item and set the source queue head to the next
-         * one.
+        /* Otherwise, release this item and set the source queue head to the
+         * next one.
          */
-        al_free(head);
+        ReleaseQueueItem(context.get(), head);
         source->queue = next;
     }
 }
 END_API_FUNC
 
 
-ALsource::ALsource(ALsizei num_sends)
+ALsource::ALsource(SendData *sends, ALsizei num_sends)
 {
     InnerAngle = 360.0f;
     OuterAngle = 360.0f;
@@ -3486,27 +4280,36 @@ ALsource::ALsource(ALsizei num_sends)
     mResampler = ResamplerDefault;
     DirectChannels = AL_FALSE;
     mSpatialize = SpatializeAuto;
+    Priority = 0;
+    FullHrtf = AL_FALSE;
+    OutputChannel = AL_NONE;
+    Instancing = AL_FALSE;
 
     StereoPan[0] = Deg2Rad( 30.0f);
     StereoPan[1] = Deg2Rad(-30.0f);
 
     Radius = 0.0f;
 
+    Group = nullptr;
+
+    Direct.Link = nullptr;
     Direct.Gain = 1.0f;
     Direct.GainHF = 1.0f;
     Direct.HFReference = LOWPASSFREQREF;
     Direct.GainLF = 1.0f;
     Direct.LFReference = HIGHPASSFREQREF;
-    Send.resize(num_sends);
-    for(auto &send : Send)
+    Send = sends;
+    NumSends = num_sends;
+    std::for_each(Send, Send+NumSends, [](SendData &send) -> void
     {
         send.Slot = nullptr;
+        send.Link = nullptr;
         send.Gain = 1.0f;
         send.GainHF = 1.0f;
         send.HFReference = LOWPASSFREQREF;
         send.GainLF = 1.0f;
         send.LFReference = HIGHPASSFREQREF;
-    }
+    });
 
     Offset = 0.0;
     OffsetType = AL_NONE;
@@ -3516,6 +4319,8 @@ ALsource::ALsource(ALsizei num_sends)
     queue = nullptr;
 
     PropsClean.test_and_set(std::memory_order_relaxed);
+    DirtyProps.store(VPROPS_ALL, std::memory_order_relaxed);
+    BuffersCompleted.store(0u, std::memory_order_relaxed);
 
     VoiceIdx = -1;
 }
@@ -3536,16 +4341,57 @@ ALsource::~ALsource()
     }
     queue = nullptr;
 
-    std::for_each(Send.begin(), Send.end(),
+    if(Group)
+        DecrementRef(&Group->ref);
+    Group = nullptr;
+
+    if(Direct.Link)
+        DecrementRef(&Direct.Link->ref);
+    Direct.Link = nullptr;
+
+    std::for_each(Send, Send+NumSends,
         [](ALsource::SendData &send) -> void
         {
             if(send.Slot)
                 DecrementRef(&send.Slot->ref);
             send.Slot = nullptr;
+            if(send.Link)
+                DecrementRef(&send.Link->ref);
+            send.Link = nullptr;
         }
     );
 }
 
+void ReserveVoiceProps(ALCcontext *context, size_t count)
+{
+    if(count < 1) return;
+    al::ArenaScope arena_scope{context->Device->mArena};
+
+    void *ptr{al_calloc(alignof(ALvoiceProps), sizeof(ALvoiceProps)*count)};
+    if(!ptr) throw std::bad_alloc();
+
+    ALvoiceProps *first{::new (ptr) ALvoiceProps{}};
+    ALvoiceProps *last{first};
+    for(size_t i{1};i < count;i++)
+    {
+        ALvoiceProps *props{::new (first+i) ALvoiceProps{}};
+        last->next.store(props, std::memory_order_relaxed);
+        last = props;
+    }
+
+    {
+        std::lock_guard<std::mutex> _{context->VoicePropLock};
+        context->VoicePropChunks.emplace_back(ptr);
+        context->NumVoiceProps += count;
+    }
+
+    ALvoiceProps *head{context->FreeVoiceProps.load(std::memory_order_acquire)};
+    do {
+        last->next.store(head, std::memory_order_relaxed);
+    } while(!context->FreeVoiceProps.compare_exchange_weak(head, first,
+            std::memory_order_acq_rel, std::memory_order_acquire));
+}
+
 void UpdateAllSourceProps(ALCcontext *context)
 {
     auto voices_end = context->Voices + context->VoiceCount.load(std::memory_order_relaxed);
@@ -3572,4 +4418,6 @@ SourceSubList::~SourceSubList()
     FreeMask = ~usemask;
     al_free(Sources);
     Sources = nullptr;
+    al_free(Sends);
+    Sends = nullptr;
 }
@@ -0,0 +1,360 @@
+/**
+ * OpenAL cross platform audio library
+ * Copyright (C) 1999-2007 by authors.
+ * This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Library General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ *  License along with this library; if not, write to the
+ *  Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ * Or go to http://www.gnu.org/copyleft/lgpl.html
+ */
+
+#include "config.h"
+
+#include <cmath>
+
+#include <algorithm>
+
+#include "AL/al.h"
+#include "AL/alc.h"
+
+#include "alMain.h"
+#include "alcontext.h"
+#include "alSourceGroup.h"
+#include "alError.h"
+
+#include "alexcpt.h"
+#include "almalloc.h"
+
+
+namespace {
+
+ALsourceGroup *AllocSourceGroup(ALCcontext *context)
+{
+    std::lock_guard<std::mutex> _{context->SourceGroupLock};
+    const ptrdiff_t freelist{context->SourceGroupFreeMap.find()};
+    auto sublist = (freelist < 0) ? context->SourceGroupList.end() : (context->SourceGroupList.begin() + freelist);
+    auto lidx = static_cast<ALsizei>(std::distance(context->SourceGroupList.begin(), sublist));
+    ALsizei slidx;
+    if(LIKELY(sublist != context->SourceGroupList.end()))
+        slidx = CTZ64(sublist->FreeMask);
+    else
+    {
+        /* Don't allocate so many list entries that the 32-bit ID could
+         * overflow...
+         */
+        if(UNLIKELY(context->SourceGroupList.size() >= 1<<25))
+        {
+            alSetError(context, AL_OUT_OF_MEMORY, "Too many source groups allocated");
+            return nullptr;
+        }
+        context->SourceGroupList.emplace_back();
+        sublist = context->SourceGroupList.end() - 1;
+
+        sublist->FreeMask = ~0_u64;
+        sublist->Groups = static_cast<ALsourceGroup*>(al_calloc(16, sizeof(ALsourceGroup)*64));
+        if(UNLIKELY(!sublist->Groups))
+        {
+            context->SourceGroupList.pop_back();
+            alSetError(context, AL_OUT_OF_MEMORY, "Failed to allocate source group batch");
+            return nullptr;
+        }
+
+        slidx = 0;
+    }
+
+    ALsourceGroup *group{new (sublist->Groups + slidx) ALsourceGroup{}};
+
+    /* Add 1 to avoid group ID 0. */
+    group->id = ((lidx<<6) | slidx) + 1;
+
+    context->NumSourceGroups += 1;
+    sublist->FreeMask &= ~(1_u64 << slidx);
+    context->SourceGroupFreeMap.set(static_cast<size_t>(lidx), sublist->FreeMask != 0);
+
+    return group;
+}
+
+void FreeSourceGroup(ALCcontext *context, ALsourceGroup *group)
+{
+    ALuint id = group->id - 1;
+    ALsizei lidx = id >> 6;
+    ALsizei slidx = id & 0x3f;
+
+    /* The mixer may still be checking the group for updates, so an unapplied
+     * one goes back to the freelist for reuse.
+     */
+    if(ALsourceGroupProps *props{group->Update.exchange(nullptr, std::memory_order_acq_rel)})
+        AtomicReplaceHead(context->FreeSourceGroupProps, props);
+    group->~ALsourceGroup();
+
+    context->SourceGroupList[lidx].FreeMask |= 1_u64 << slidx;
+    context->SourceGroupFreeMap.set(static_cast<size_t>(lidx), true);
+    context->NumSourceGroups--;
+}
+
+
+#define DO_UPDATEPROPS() do {                                                 \
+    if(!context->DeferUpdates.load(std::memory_order_acquire))                \
+        UpdateSourceGroupProps(group, context.get());                         \
+    else                                                                      \
+        group->PropsClean.clear(std::memory_order_release);                   \
+} while(0)
+
+} // namespace
+
+ALsourceGroup *LookupSourceGroup(ALCcontext *context, ALuint id) noexcept
+{
+    ALuint lidx = (id-1) >> 6;
+    ALsizei slidx = (id-1) & 0x3f;
+
+    SourceGroupSubList *sublist{context->SourceGroupList.lookup(lidx)};
+    if(UNLIKELY(!sublist))
+        return nullptr;
+    if(UNLIKELY(sublist->FreeMask.load(std::memory_order_acquire) & (1_u64 << slidx)))
+        return nullptr;
+    return sublist->Groups + slidx;
+}
+
+
+AL_API ALvoid AL_APIENTRY alGenSourceGroupsSOFT(ALsizei n, ALuint *groups)
+START_API_FUNC
+{
+    ContextRef context{GetContextRef()};
+    if(UNLIKELY(!context)) return;
+
+    if(n < 0)
+        SETERR_RETURN(context.get(), AL_INVALID_VALUE,, "Generating %d source groups", n);
+    if(n == 0) return;
+
+    if(n == 1)
+    {
+        ALsourceGroup *group{AllocSourceGroup(context.get())};
+        if(group) groups[0] = group->id;
+    }
+    else
+    {
+        auto tempids = al::vector<ALuint>(n);
+        auto alloc_end = std::find_if_not(tempids.begin(), tempids.end(),
+            [&context](ALuint &id) -> bool
+            {
+                ALsourceGroup *group{AllocSourceGroup(context.get())};
+                if(!group) return false;
+                id = group->id;
+                return true;
+            }
+        );
+        if(alloc_end != tempids.end())
+        {
+            auto count = static_cast<ALsizei>(std::distance(tempids.begin(), alloc_end));
+            alDeleteSourceGroupsSOFT(count, tempids.data());
+            return;
+        }
+
+        std::copy(tempids.cbegin(), tempids.cend(), groups);
+    }
+}
+END_API_FUNC
+
+AL_API ALvoid AL_APIENTRY alDeleteSourceGroupsSOFT(ALsizei n, const ALuint *groups)
+START_API_FUNC
+{
+    ContextRef context{GetContextRef()};
+    if(UNLIKELY(!context)) return;
+
+    if(n < 0)
+        SETERR_RETURN(context.get(), AL_INVALID_VALUE,, "Deleting %d source groups", n);
+    if(n == 0) return;
+
+    std::lock_guard<std::mutex> _{context->SourceGroupLock};
+    auto groups_end = groups + n;
+    auto bad_group = std::find_if(groups, groups_end,
+        [&context](ALuint id) -> bool
+        {
+            if(!id) return false;
+            ALsourceGroup *group{LookupSourceGroup(context.get(), id)};
+            if(!group)
+            {
+                alSetError(context.get(), AL_INVALID_NAME, "Invalid source group ID %u", id);
+                return true;
+            }
+            if(ReadRef(&group->ref) != 0)
+            {
+                alSetError(context.get(), AL_INVALID_OPERATION, "Deleting in-use source group %u",
+                    id);
+                return true;
+            }
+            return false;
+        }
+    );
+    if(bad_group != groups_end)
+        return;
+
+    /* All groups are valid and unused, delete them. */
+    std::for_each(groups, groups_end,
+        [&context](ALuint id) -> void
+        {
+            ALsourceGroup *group{id ? LookupSourceGroup(context.get(), id) : nullptr};
+            if(group) FreeSourceGroup(context.get(), group);
+        }
+    );
+}
+END_API_FUNC
+
+AL_API ALboolean AL_APIENTRY alIsSourceGroupSOFT(ALuint group)
+START_API_FUNC
+{
+    ContextRef context{GetContextRef()};
+    if(LIKELY(context))
+    {
+        if(LookupSourceGroup(context.get(), group) != nullptr)
+            return AL_TRUE;
+    }
+    return AL_FALSE;
+}
+END_API_FUNC
+
+
+AL_API ALvoid AL_APIENTRY alSourceGroupfSOFT(ALuint id, ALenum param, ALfloat value)
+START_API_FUNC
+{
+    ContextRef context{GetContextRef()};
+    if(UNLIKELY(!context)) return;
+
+    std::lock_guard<std::mutex> _{context->PropLock};
+    std::lock_guard<std::mutex> __{context->SourceGroupLock};
+    ALsourceGroup *group{LookupSourceGroup(context.get(), id)};
+    if(UNLIKELY(!group))
+        SETERR_RETURN(context.get(), AL_INVALID_NAME,, "Invalid source group ID %u", id);
+
+    switch(param)
+    {
+    case AL_GAIN:
+        if(!(value >= 0.0f && std::isfinite(value)))
+            SETERR_RETURN(context.get(), AL_INVALID_VALUE,, "Source group gain out of range");
+        group->Gain = value;
+        break;
+
+    case AL_PITCH:
+        if(!(value >= 0.0f && std::isfinite(value)))
+            SETERR_RETURN(context.get(), AL_INVALID_VALUE,, "Source group pitch out of range");
+        group->Pitch = value;
+        break;
+
+    default:
+        SETERR_RETURN(context.get(), AL_INVALID_ENUM,, "Invalid source group float property 0x%04x",
+            param);
+    }
+    DO_UPDATEPROPS();
+}
+END_API_FUNC
+
+AL_API ALvoid AL_APIENTRY alGetSourceGroupfSOFT(ALuint id, ALenum param, ALfloat *value)
+START_API_FUNC
+{
+    ContextRef context{GetContextRef()};
+    if(UNLIKELY(!context)) return;
+
+    std::lock_guard<std::mutex> _{context->SourceGroupLock};
+    ALsourceGroup *group{LookupSourceGroup(context.get(), id)};
+    if(UNLIKELY(!group))
+        SETERR_RETURN(context.get(), AL_INVALID_NAME,, "Invalid source group ID %u", id);
+
+    if(UNLIKELY(!value))
+        SETERR_RETURN(context.get(), AL_INVALID_VALUE,, "NULL pointer");
+    switch(param)
+    {
+    case AL_GAIN:
+        *value = group->Gain;
+        break;
+
+    case AL_PITCH:
+        *value = group->Pitch;
+        break;
+
+    default:
+        SETERR_RETURN(context.get(), AL_INVALID_ENUM,, "Invalid source group float property 0x%04x",
+            param);
+    }
+}
+END_API_FUNC
+
+
+void UpdateSourceGroupProps(ALsourceGroup *group, ALCcontext *context)
+{
+    al::ArenaScope arena_scope{context->Device->mArena};
+    /* Get an unused property container, or allocate a new one as needed. */
+    ALsourceGroupProps *props{context->FreeSourceGroupProps.load(std::memory_order_acquire)};
+    if(!props)
+        props = static_cast<ALsourceGroupProps*>(al_calloc(16, sizeof(*props)));
+    else
+    {
+        ALsourceGroupProps *next;
+        do {
+            next = props->next.load(std::memory_order_relaxed);
+        } while(context->FreeSourceGroupProps.compare_exchange_weak(props, next,
+                std::memory_order_seq_cst, std::memory_order_acquire) == 0);
+    }
+
+    /* Copy in current property values. */
+    props->Gain = group->Gain;
+    props->Pitch = group->Pitch;
+
+    props->Batch = context->PublishBatch.load(std::memory_order_relaxed);
+
+    /* Set the new container for updating internal parameters. */
+    props = group->Update.exchange(props, std::memory_order_acq_rel);
+    if(props)
+    {
+        /* If there was an unused update container, put it back in the
+         * freelist.
+         */
+        AtomicReplaceHead(context->FreeSourceGroupProps, props);
+    }
+
+    /* Tell the mixer to apply it and recalculate the parameters of the
+     * grouped voices.
+     */
+    context->SourceGroupsChanged.store(true, std::memory_order_release);
+}
+
+void UpdateAllSourceGroupProps(ALCcontext *context)
+{
+    std::lock_guard<std::mutex> _{context->SourceGroupLock};
+    for(SourceGroupSubList &sublist : context->SourceGroupList)
+    {
+        uint64_t usemask{~sublist.FreeMask.load(std::memory_order_relaxed)};
+        while(usemask)
+        {
+            ALsizei idx{CTZ64(usemask)};
+            ALsourceGroup *group{sublist.Groups + idx};
+            usemask &= ~(1_u64 << idx);
+
+            if(!group->PropsClean.test_and_set(std::memory_order_acq_rel))
+                UpdateSourceGroupProps(group, context);
+        }
+    }
+}
+
+SourceGroupSubList::~SourceGroupSubList()
+{
+    uint64_t usemask{~FreeMask};
+    while(usemask)
+    {
+        ALsizei idx{CTZ64(usemask)};
+        Groups[idx].~ALsourceGroup();
+        usemask &= ~(1_u64 << idx);
+    }
+    FreeMask = ~usemask;
+    al_free(Groups);
+    Groups = nullptr;
+}
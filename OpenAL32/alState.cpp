@@ -29,6 +29,7 @@
 #include "alcontext.h"
 #include "alu.h"
 #include "alError.h"
+#include "callrecord.h"
 #include "alexcpt.h"
 
 #include "backends/base.h"
@@ -54,6 +55,7 @@ constexpr ALchar alLinearResampler[] = "Linear";
 constexpr ALchar alCubicResampler[] = "Cubic";
 constexpr ALchar alBSinc12Resampler[] = "11th order Sinc";
 constexpr ALchar alBSinc24Resampler[] = "23rd order Sinc";
+constexpr ALchar alBSinc32Resampler[] = "31st order Sinc";
 
 } // namespace
 
@@ -84,6 +86,8 @@ START_API_FUNC
     if(UNLIKELY(!context)) return;
 
     std::lock_guard<std::mutex> _{context->PropLock};
+    if(UNLIKELY(RecordEnabled))
+        RecordCapability(context.get(), RecordCall::Enable, capability);
     switch(capability)
     {
     case AL_SOURCE_DISTANCE_MODEL:
@@ -104,6 +108,8 @@ START_API_FUNC
     if(UNLIKELY(!context)) return;
 
     std::lock_guard<std::mutex> _{context->PropLock};
+    if(UNLIKELY(RecordEnabled))
+        RecordCapability(context.get(), RecordCall::Disable, capability);
     switch(capability)
     {
     case AL_SOURCE_DISTANCE_MODEL:
@@ -184,10 +190,19 @@ START_API_FUNC
         value = AL_TRUE;
         break;
 
+    case AL_MAX_LISTENERS_SOFT:
+        value = AL_TRUE;
+        break;
+
     case AL_DEFAULT_RESAMPLER_SOFT:
         value = ResamplerDefault ? AL_TRUE : AL_FALSE;
         break;
 
+    case AL_EFFECTS_DOWNGRADED_SOFT:
+        if(context->EffectsDowngraded.load(std::memory_order_relaxed))
+            value = AL_TRUE;
+        break;
+
     default:
         alSetError(context.get(), AL_INVALID_VALUE, "Invalid boolean property 0x%04x", pname);
     }
@@ -235,6 +250,10 @@ START_API_FUNC
         value = static_cast<ALdouble>(ResamplerMax + 1);
         break;
 
+    case AL_MAX_LISTENERS_SOFT:
+        value = static_cast<ALdouble>(MAX_LISTENERS);
+        break;
+
     case AL_DEFAULT_RESAMPLER_SOFT:
         value = static_cast<ALdouble>(ResamplerDefault);
         break;
@@ -286,6 +305,10 @@ START_API_FUNC
         value = static_cast<ALfloat>(ResamplerMax + 1);
         break;
 
+    case AL_MAX_LISTENERS_SOFT:
+        value = static_cast<ALfloat>(MAX_LISTENERS);
+        break;
+
     case AL_DEFAULT_RESAMPLER_SOFT:
         value = static_cast<ALfloat>(ResamplerDefault);
         break;
@@ -337,10 +360,27 @@ START_API_FUNC
         value = ResamplerMax + 1;
         break;
 
+    case AL_MAX_LISTENERS_SOFT:
+        value = MAX_LISTENERS;
+        break;
+
     case AL_DEFAULT_RESAMPLER_SOFT:
         value = ResamplerDefault;
         break;
 
+#ifndef _WIN32
+    case AL_BUFFER_COMPLETION_HANDLE_SOFT:
+        if(al::wakeup_handle *wakeup{GetCompletionWakeup(context.get())})
+            value = wakeup->native_handle();
+        else
+        {
+            alSetError(context.get(), AL_INVALID_OPERATION,
+                "Buffer completion handle unavailable");
+            value = -1;
+        }
+        break;
+#endif
+
     default:
         alSetError(context.get(), AL_INVALID_VALUE, "Invalid integer property 0x%04x", pname);
     }
@@ -388,6 +428,10 @@ START_API_FUNC
         value = (ALint64SOFT)(ResamplerMax + 1);
         break;
 
+    case AL_MAX_LISTENERS_SOFT:
+        value = (ALint64SOFT)MAX_LISTENERS;
+        break;
+
     case AL_DEFAULT_RESAMPLER_SOFT:
         value = (ALint64SOFT)ResamplerDefault;
         break;
@@ -418,6 +462,16 @@ START_API_FUNC
         value = context->EventParam;
         break;
 
+#ifdef _WIN32
+    case AL_BUFFER_COMPLETION_HANDLE_SOFT:
+        if(al::wakeup_handle *wakeup{GetCompletionWakeup(context.get())})
+            value = wakeup->native_handle();
+        else
+            alSetError(context.get(), AL_INVALID_OPERATION,
+                "Buffer completion handle unavailable");
+        break;
+#endif
+
     default:
         alSetError(context.get(), AL_INVALID_VALUE, "Invalid pointer property 0x%04x", pname);
     }
@@ -440,7 +494,9 @@ START_API_FUNC
             case AL_DEFERRED_UPDATES_SOFT:
             case AL_GAIN_LIMIT_SOFT:
             case AL_NUM_RESAMPLERS_SOFT:
+            case AL_MAX_LISTENERS_SOFT:
             case AL_DEFAULT_RESAMPLER_SOFT:
+            case AL_EFFECTS_DOWNGRADED_SOFT:
                 values[0] = alGetBoolean(pname);
                 return;
         }
@@ -473,6 +529,7 @@ START_API_FUNC
             case AL_DEFERRED_UPDATES_SOFT:
             case AL_GAIN_LIMIT_SOFT:
             case AL_NUM_RESAMPLERS_SOFT:
+            case AL_MAX_LISTENERS_SOFT:
             case AL_DEFAULT_RESAMPLER_SOFT:
                 values[0] = alGetDouble(pname);
                 return;
@@ -506,6 +563,7 @@ START_API_FUNC
             case AL_DEFERRED_UPDATES_SOFT:
             case AL_GAIN_LIMIT_SOFT:
             case AL_NUM_RESAMPLERS_SOFT:
+            case AL_MAX_LISTENERS_SOFT:
             case AL_DEFAULT_RESAMPLER_SOFT:
                 values[0] = alGetFloat(pname);
                 return;
@@ -519,6 +577,10 @@ START_API_FUNC
         alSetError(context.get(), AL_INVALID_VALUE, "NULL pointer");
     else switch(pname)
     {
+    case AL_EFFECTS_PROCESS_TIME_SOFT:
+        context->EffectsTime.get(values);
+        break;
+
     default:
         alSetError(context.get(), AL_INVALID_VALUE, "Invalid float-vector property 0x%04x", pname);
     }
@@ -539,7 +601,11 @@ START_API_FUNC
             case AL_DEFERRED_UPDATES_SOFT:
             case AL_GAIN_LIMIT_SOFT:
             case AL_NUM_RESAMPLERS_SOFT:
+            case AL_MAX_LISTENERS_SOFT:
             case AL_DEFAULT_RESAMPLER_SOFT:
+#ifndef _WIN32
+            case AL_BUFFER_COMPLETION_HANDLE_SOFT:
+#endif
                 values[0] = alGetInteger(pname);
                 return;
         }
@@ -572,6 +638,7 @@ START_API_FUNC
             case AL_DEFERRED_UPDATES_SOFT:
             case AL_GAIN_LIMIT_SOFT:
             case AL_NUM_RESAMPLERS_SOFT:
+            case AL_MAX_LISTENERS_SOFT:
             case AL_DEFAULT_RESAMPLER_SOFT:
                 values[0] = alGetInteger64SOFT(pname);
                 return;
@@ -685,6 +752,8 @@ START_API_FUNC
     else
     {
         std::lock_guard<std::mutex> _{context->PropLock};
+        if(UNLIKELY(RecordEnabled))
+            RecordStatef(context.get(), AL_DOPPLER_FACTOR, value);
         context->DopplerFactor = value;
         DO_UPDATEPROPS();
     }
@@ -714,6 +783,8 @@ START_API_FUNC
     else
     {
         std::lock_guard<std::mutex> _{context->PropLock};
+        if(UNLIKELY(RecordEnabled))
+            RecordStatef(context.get(), AL_DOPPLER_VELOCITY, value);
         context->DopplerVelocity = value;
         DO_UPDATEPROPS();
     }
@@ -731,6 +802,8 @@ START_API_FUNC
     else
     {
         std::lock_guard<std::mutex> _{context->PropLock};
+        if(UNLIKELY(RecordEnabled))
+            RecordStatef(context.get(), AL_SPEED_OF_SOUND, value);
         context->SpeedOfSound = value;
         DO_UPDATEPROPS();
     }
@@ -751,6 +824,8 @@ START_API_FUNC
     else
     {
         std::lock_guard<std::mutex> _{context->PropLock};
+        if(UNLIKELY(RecordEnabled))
+            RecordStatei(context.get(), AL_DISTANCE_MODEL, value);
         context->mDistanceModel = static_cast<DistanceModel>(value);
         if(!context->SourceDistanceModel)
             DO_UPDATEPROPS();
@@ -765,6 +840,8 @@ START_API_FUNC
     ContextRef context{GetContextRef()};
     if(UNLIKELY(!context)) return;
 
+    if(UNLIKELY(RecordEnabled))
+        RecordDeferUpdates(context.get(), RecordCall::DeferUpdates);
     ALCcontext_DeferUpdates(context.get());
 }
 END_API_FUNC
@@ -775,6 +852,8 @@ START_API_FUNC
     ContextRef context{GetContextRef()};
     if(UNLIKELY(!context)) return;
 
+    if(UNLIKELY(RecordEnabled))
+        RecordDeferUpdates(context.get(), RecordCall::ProcessUpdates);
     ALCcontext_ProcessUpdates(context.get());
 }
 END_API_FUNC
@@ -786,7 +865,7 @@ START_API_FUNC
     const char *ResamplerNames[] = {
         alPointResampler, alLinearResampler,
         alCubicResampler, alBSinc12Resampler,
-        alBSinc24Resampler,
+        alBSinc24Resampler, alBSinc32Resampler,
     };
     static_assert(COUNTOF(ResamplerNames) == ResamplerMax+1, "Incorrect ResamplerNames list");
 
@@ -814,6 +893,7 @@ END_API_FUNC
 
 void UpdateContextProps(ALCcontext *context)
 {
+    al::ArenaScope arena_scope{context->Device->mArena};
     /* Get an unused proprty container, or allocate a new one as needed. */
     ALcontextProps *props{context->FreeContextProps.load(std::memory_order_acquire)};
     if(!props)
@@ -837,6 +917,8 @@ void UpdateContextProps(ALCcontext *context)
     props->SourceDistanceModel = context->SourceDistanceModel;
     props->mDistanceModel = context->mDistanceModel;
 
+    props->Batch = context->PublishBatch.load(std::memory_order_relaxed);
+
     /* Set the new container for updating internal parameters. */
     props = context->Update.exchange(props, std::memory_order_acq_rel);
     if(props)
@@ -2,6 +2,9 @@
 #include "config.h"
 
 #include <algorithm>
+#include <condition_variable>
+#include <functional>
+#include <string>
 
 #include "AL/alc.h"
 #include "AL/al.h"
@@ -11,108 +14,263 @@
 #include "alcontext.h"
 #include "alError.h"
 #include "alAuxEffectSlot.h"
+#include "alconfig.h"
 #include "ringbuffer.h"
 #include "threads.h"
 #include "alexcpt.h"
+#include "altrace.h"
 
 
-static int EventThread(ALCcontext *context)
+namespace {
+
+std::string GetEventMessage(const AsyncEvent &evt)
+{
+    if(evt.EnumType == EventType_SourceStateChange)
+    {
+        std::string msg{"Source ID " + std::to_string(evt.u.srcstate.id)};
+        msg += " state has changed to ";
+        msg += (evt.u.srcstate.state==AL_INITIAL) ? "AL_INITIAL" :
+            (evt.u.srcstate.state==AL_PLAYING) ? "AL_PLAYING" :
+            (evt.u.srcstate.state==AL_PAUSED) ? "AL_PAUSED" :
+            (evt.u.srcstate.state==AL_STOPPED) ? "AL_STOPPED" : "<unknown>";
+        return msg;
+    }
+    if(evt.EnumType == EventType_BufferCompleted)
+    {
+        std::string msg{std::to_string(evt.u.bufcomp.count)};
+        if(evt.u.bufcomp.count == 1) msg += " buffer completed";
+        else msg += " buffers completed";
+        return msg;
+    }
+    return std::string{evt.u.user.msg};
+}
+
+/* Delivers the events waiting in the context's ring. Returns 0 if there
+ * weren't any, 1 if there were, or -1 if the context's kill event was found,
+ * after which the context must not be touched again.
+ */
+int DispatchEvents(ALCcontext *context, al::vector<ALeventSOFT> &batch,
+    al::vector<std::string> &messages)
 {
     RingBuffer *ring{context->AsyncEvents.get()};
+    auto evt_data = ring->getReadVector().first;
+    if(evt_data.len == 0)
+        return 0;
+
     bool quitnow{false};
-    while(LIKELY(!quitnow))
-    {
-        auto evt_data = ring->getReadVector().first;
-        if(evt_data.len == 0)
+    std::lock_guard<std::mutex> _{context->EventCbLock};
+    AL_TRACE_SCOPE("EventDispatch");
+    do {
+        auto &evt = *reinterpret_cast<AsyncEvent*>(evt_data.buf);
+        evt_data.buf += sizeof(AsyncEvent);
+        evt_data.len -= 1;
+        /* This automatically destructs the event object and advances the
+         * ringbuffer's read offset at the end of scope.
+         */
+        const struct EventAutoDestructor {
+            AsyncEvent &evt_;
+            RingBuffer *ring_;
+            ~EventAutoDestructor()
+            {
+                evt_.~AsyncEvent();
+                ring_->readAdvance(1);
+            }
+        } _{evt, ring};
+
+        quitnow = evt.EnumType == EventType_KillThread;
+        if(UNLIKELY(quitnow)) break;
+
+        ALbitfieldSOFT enabledevts{context->EnabledEvts.load(std::memory_order_acquire)};
+        if(!context->EventCb && !context->EventBatchCb) continue;
+
+        ALeventSOFT record{};
+        if(evt.EnumType == EventType_SourceStateChange)
+        {
+            if(!(enabledevts&EventType_SourceStateChange))
+                continue;
+            record.Type = AL_EVENT_TYPE_SOURCE_STATE_CHANGED_SOFT;
+            record.Object = evt.u.srcstate.id;
+            record.Param = static_cast<ALuint>(evt.u.srcstate.state);
+        }
+        else if(evt.EnumType == EventType_BufferCompleted)
+        {
+            if(!(enabledevts&EventType_BufferCompleted))
+                continue;
+            record.Type = AL_EVENT_TYPE_BUFFER_COMPLETED_SOFT;
+            record.Object = evt.u.bufcomp.id;
+            record.Param = evt.u.bufcomp.count;
+        }
+        else if((enabledevts&evt.EnumType) == evt.EnumType)
+        {
+            record.Type = evt.u.user.type;
+            record.Object = evt.u.user.id;
+            record.Param = evt.u.user.param;
+        }
+        else
+            continue;
+
+        /* Batched events are delivered once this read of the ring is done,
+         * with their messages only formatted if wanted.
+         */
+        if(context->EventBatchCb)
         {
-            context->EventSem.wait();
+            batch.emplace_back(record);
+            if(context->EventBatchMessages)
+                messages.emplace_back(GetEventMessage(evt));
             continue;
         }
 
-        std::lock_guard<std::mutex> _{context->EventCbLock};
-        do {
-            auto &evt = *reinterpret_cast<AsyncEvent*>(evt_data.buf);
-            evt_data.buf += sizeof(AsyncEvent);
-            evt_data.len -= 1;
-            /* This automatically destructs the event object and advances the
-             * ringbuffer's read offset at the end of scope.
+        const std::string msg{GetEventMessage(evt)};
+        context->EventCb(record.Type, record.Object, record.Param,
+            static_cast<ALsizei>(msg.length()), msg.c_str(), context->EventParam);
+    } while(evt_data.len != 0);
+
+    if(!batch.empty())
+    {
+        /* The messages' storage is settled now, so they can be pointed to. */
+        for(size_t i{0};i < messages.size();++i)
+        {
+            batch[i].Length = static_cast<ALsizei>(messages[i].length());
+            batch[i].Message = messages[i].c_str();
+        }
+        context->EventBatchCb(static_cast<ALsizei>(batch.size()), batch.data(),
+            context->EventBatchParam);
+        batch.clear();
+        messages.clear();
+    }
+    return quitnow ? -1 : 1;
+}
+
+/* The one thread delivering events for every context that enabled them. It's
+ * started when a context first enables events, and ends once none are left.
+ */
+class EventDispatcher {
+    std::mutex mLock;
+    std::condition_variable mRemoved;
+    al::vector<ALCcontext*> mContexts;
+    std::thread mThread;
+    bool mRunning{false};
+    bool mQuit{false};
+    al::semaphore mSem;
+
+    void run()
+    {
+        althrd_setname(EVENT_THREAD_NAME);
+
+        /* Storage for batched events and the contexts being handled, reused
+         * so delivering them doesn't normally allocate.
+         */
+        al::vector<ALeventSOFT> batch;
+        al::vector<std::string> messages;
+        al::vector<ALCcontext*> contexts;
+
+        std::unique_lock<std::mutex> lock{mLock};
+        while(!mContexts.empty() && LIKELY(!mQuit))
+        {
+            /* A context stays in the list until its kill event is handled, so
+             * the ones copied here remain valid without the lock.
              */
-            const struct EventAutoDestructor {
-                AsyncEvent &evt_;
-                RingBuffer *ring_;
-                ~EventAutoDestructor()
+            contexts.assign(mContexts.begin(), mContexts.end());
+            lock.unlock();
+
+            bool delivered{false};
+            for(ALCcontext *ctx : contexts)
+            {
+                const int res{DispatchEvents(ctx, batch, messages)};
+                if(res < 0)
                 {
-                    evt_.~AsyncEvent();
-                    ring_->readAdvance(1);
+                    lock.lock();
+                    mContexts.erase(std::find(mContexts.begin(), mContexts.end(), ctx));
+                    lock.unlock();
+                    mRemoved.notify_all();
                 }
-            } _{evt, ring};
+                delivered |= (res != 0);
+            }
+            if(!delivered)
+                mSem.wait();
 
-            quitnow = evt.EnumType == EventType_KillThread;
-            if(UNLIKELY(quitnow)) break;
+            lock.lock();
+        }
+        mRunning = false;
+    }
 
-            if(evt.EnumType == EventType_ReleaseEffectState)
-            {
-                evt.u.mEffectState->DecRef();
-                continue;
-            }
+public:
+    ~EventDispatcher()
+    {
+        {
+            std::lock_guard<std::mutex> _{mLock};
+            mQuit = true;
+        }
+        mSem.post();
+        if(mThread.joinable())
+            mThread.join();
+    }
 
-            ALbitfieldSOFT enabledevts{context->EnabledEvts.load(std::memory_order_acquire)};
-            if(!context->EventCb) continue;
+    bool add(ALCcontext *context)
+    {
+        std::lock_guard<std::mutex> _{mLock};
+        mContexts.emplace_back(context);
+        if(mRunning) return true;
 
-            if(evt.EnumType == EventType_SourceStateChange)
-            {
-                if(!(enabledevts&EventType_SourceStateChange))
-                    continue;
-                std::string msg{"Source ID " + std::to_string(evt.u.srcstate.id)};
-                msg += " state has changed to ";
-                msg += (evt.u.srcstate.state==AL_INITIAL) ? "AL_INITIAL" :
-                    (evt.u.srcstate.state==AL_PLAYING) ? "AL_PLAYING" :
-                    (evt.u.srcstate.state==AL_PAUSED) ? "AL_PAUSED" :
-                    (evt.u.srcstate.state==AL_STOPPED) ? "AL_STOPPED" : "<unknown>";
-                context->EventCb(AL_EVENT_TYPE_SOURCE_STATE_CHANGED_SOFT, evt.u.srcstate.id,
-                    evt.u.srcstate.state, static_cast<ALsizei>(msg.length()), msg.c_str(),
-                    context->EventParam
-                );
-            }
-            else if(evt.EnumType == EventType_BufferCompleted)
+        /* Clean up after the last thread, which ended when it was left with
+         * no contexts.
+         */
+        if(mThread.joinable())
+            mThread.join();
+        try {
+            mThread = std::thread{std::mem_fn(&EventDispatcher::run), this};
+            mRunning = true;
+        }
+        catch(std::exception& e) {
+            ERR("Failed to start event thread: %s\n", e.what());
+        }
+        catch(...) {
+            ERR("Failed to start event thread! Expect problems.\n");
+        }
+        if(!mRunning)
+            mContexts.pop_back();
+        return mRunning;
+    }
+
+    /* Waits for the context to be removed, after its kill event was sent. */
+    void remove(ALCcontext *context)
+    {
+        mSem.post();
+        std::unique_lock<std::mutex> lock{mLock};
+        mRemoved.wait(lock,
+            [this,context]() -> bool
             {
-                if(!(enabledevts&EventType_BufferCompleted))
-                    continue;
-                std::string msg{std::to_string(evt.u.bufcomp.count)};
-                if(evt.u.bufcomp.count == 1) msg += " buffer completed";
-                else msg += " buffers completed";
-                context->EventCb(AL_EVENT_TYPE_BUFFER_COMPLETED_SOFT, evt.u.bufcomp.id,
-                    evt.u.bufcomp.count, static_cast<ALsizei>(msg.length()), msg.c_str(),
-                    context->EventParam
-                );
-            }
-            else if((enabledevts&evt.EnumType) == evt.EnumType)
-                context->EventCb(evt.u.user.type, evt.u.user.id, evt.u.user.param,
-                    static_cast<ALsizei>(strlen(evt.u.user.msg)), evt.u.user.msg,
-                    context->EventParam
-                );
-        } while(evt_data.len != 0);
+                return mQuit ||
+                    std::find(mContexts.begin(), mContexts.end(), context) == mContexts.end();
+            });
     }
-    return 0;
-}
 
-void StartEventThrd(ALCcontext *ctx)
+    void wake() { mSem.post(); }
+};
+EventDispatcher Dispatcher;
+
+} // namespace
+
+bool StartEventThrd(ALCcontext *ctx)
 {
-    try {
-        ctx->EventThread = std::thread(EventThread, ctx);
-    }
-    catch(std::exception& e) {
-        ERR("Failed to start event thread: %s\n", e.what());
-    }
-    catch(...) {
-        ERR("Failed to start event thread! Expect problems.\n");
+    ALuint evtcount{511u};
+    ConfigValueUInt(ctx->Device->DeviceName.c_str(), nullptr, "event-queue-size", &evtcount);
+    ctx->AsyncEvents = CreateRingBuffer(clampu(evtcount, 63u, 65535u), sizeof(AsyncEvent),
+        false);
+    if(!Dispatcher.add(ctx))
+    {
+        ctx->AsyncEvents = nullptr;
+        return false;
     }
+    return true;
 }
 
 void StopEventThrd(ALCcontext *ctx)
 {
-    static constexpr AsyncEvent kill_evt{EventType_KillThread};
     RingBuffer *ring{ctx->AsyncEvents.get()};
+    if(!ring) return;
+
+    static constexpr AsyncEvent kill_evt{EventType_KillThread};
     auto evt_data = ring->getWriteVector().first;
     if(evt_data.len == 0)
     {
@@ -124,9 +282,26 @@ void StopEventThrd(ALCcontext *ctx)
     new (evt_data.buf) AsyncEvent{kill_evt};
     ring->writeAdvance(1);
 
-    ctx->EventSem.post();
-    if(ctx->EventThread.joinable())
-        ctx->EventThread.join();
+    Dispatcher.remove(ctx);
+}
+
+void WakeEventThrd()
+{ Dispatcher.wake(); }
+
+al::wakeup_handle *GetCompletionWakeup(ALCcontext *context)
+{
+    al::wakeup_handle *wakeup{context->CompletionWakeup.load(std::memory_order_relaxed)};
+    if(wakeup) return wakeup;
+
+    try {
+        wakeup = new al::wakeup_handle{};
+    }
+    catch(std::exception &e) {
+        ERR("Failed to create buffer completion wakeup handle: %s\n", e.what());
+        return nullptr;
+    }
+    context->CompletionWakeup.store(wakeup, std::memory_order_release);
+    return wakeup;
 }
 
 AL_API void AL_APIENTRY alEventControlSOFT(ALsizei count, const ALenum *types, ALboolean enable)
@@ -156,6 +331,8 @@ START_API_FUNC
                 flags |= EventType_Deprecated;
             else if(type == AL_EVENT_TYPE_DISCONNECTED_SOFT)
                 flags |= EventType_Disconnected;
+            else if(type == AL_EVENT_TYPE_HRTF_READY_SOFT)
+                flags |= EventType_HrtfReady;
             else
                 return false;
             return true;
@@ -166,6 +343,14 @@ START_API_FUNC
 
     if(enable)
     {
+        /* The context only joins the event thread once events are wanted. */
+        if(!context->AsyncEvents)
+        {
+            std::lock_guard<std::mutex> _{context->PropLock};
+            if(!context->AsyncEvents && !StartEventThrd(context.get()))
+                SETERR_RETURN(context.get(), AL_OUT_OF_MEMORY,, "Failed to start event thread");
+        }
+
         ALbitfieldSOFT enabledevts{context->EnabledEvts.load(std::memory_order_relaxed)};
         while(context->EnabledEvts.compare_exchange_weak(enabledevts, enabledevts|flags,
             std::memory_order_acq_rel, std::memory_order_acquire) == 0)
@@ -202,3 +387,18 @@ START_API_FUNC
     context->EventParam = userParam;
 }
 END_API_FUNC
+
+AL_API void AL_APIENTRY alEventBatchCallbackSOFT(ALEVENTBATCHPROCSOFT callback, ALboolean messages,
+    void *userParam)
+START_API_FUNC
+{
+    ContextRef context{GetContextRef()};
+    if(UNLIKELY(!context)) return;
+
+    std::lock_guard<std::mutex> _{context->PropLock};
+    std::lock_guard<std::mutex> __{context->EventCbLock};
+    context->EventBatchCb = callback;
+    context->EventBatchParam = userParam;
+    context->EventBatchMessages = (messages != AL_FALSE);
+}
+END_API_FUNC
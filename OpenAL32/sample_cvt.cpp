@@ -3,6 +3,8 @@
 
 #include "sample_cvt.h"
 
+#include <limits>
+
 #include "AL/al.h"
 #include "alu.h"
 #include "alBuffer.h"
@@ -127,148 +129,160 @@ constexpr int MSADPCMAdaptionCoeff[7][2] = {
     { 392, -232 }
 };
 
-void DecodeIMA4Block(ALshort *dst, const ALubyte *src, ALint numchans, ALsizei align)
-{
-    ALint sample[MAX_INPUT_CHANNELS]{};
-    ALint index[MAX_INPUT_CHANNELS]{};
-    ALuint code[MAX_INPUT_CHANNELS]{};
-
-    for(int c{0};c < numchans;c++)
+/* Single-channel decoders for reading ADPCM blocks in place. They step the
+ * state one frame at a time, starting over at each block's header.
+ */
+struct IMA4Decoder {
+    const ALubyte *mData;
+    ALsizei mNumChans;
+    ALsizei mChan;
+    ALsizei mAlign;
+    ALsizei mBlockSize;
+
+    void initBlock(ADPCMState &state, const int64_t block) const noexcept
     {
-        sample[c]  = *(src++);
-        sample[c] |= *(src++) << 8;
-        sample[c]  = (sample[c]^0x8000) - 32768;
-        index[c]  = *(src++);
-        index[c] |= *(src++) << 8;
-        index[c]  = (index[c]^0x8000) - 32768;
-
-        index[c] = clampi(index[c], 0, 88);
-
-        dst[c] = sample[c];
+        const ALubyte *src{mData + block*mBlockSize + mChan*4};
+        state.Sample = ((src[0] | (src[1]<<8)) ^ 0x8000) - 32768;
+        state.Index = clampi(((src[2] | (src[3]<<8)) ^ 0x8000) - 32768, 0, 88);
+        state.Pos = block * mAlign;
     }
 
-    for(int i{1};i < align;i++)
+    void step(ADPCMState &state) const noexcept
     {
-        if((i&7) == 1)
+        const int64_t block{(state.Pos+1) / mAlign};
+        const auto k = static_cast<ALsizei>((state.Pos+1)%mAlign - 1);
+        if(k < 0)
         {
-            for(int c{0};c < numchans;c++)
-            {
-                code[c]  = *(src++);
-                code[c] |= *(src++) << 8;
-                code[c] |= *(src++) << 16;
-                code[c] |= *(src++) << 24;
-            }
+            initBlock(state, block);
+            return;
         }
 
-        for(int c{0};c < numchans;c++)
-        {
-            int nibble = code[c]&0xf;
-            code[c] >>= 4;
-
-            sample[c] += IMA4Codeword[nibble] * IMAStep_size[index[c]] / 8;
-            sample[c] = clampi(sample[c], -32768, 32767);
-
-            index[c] += IMA4Index_adjust[nibble];
-            index[c] = clampi(index[c], 0, 88);
-
-            *(dst++) = sample[c];
-        }
+        /* After the headers, each channel has 4 bytes (8 nibbles) at a time,
+         * with the first nibble in the lower bits.
+         */
+        const ALubyte *src{mData + block*mBlockSize + mNumChans*4 + (k>>3)*mNumChans*4 +
+            mChan*4};
+        const int nibble{(src[(k&7)>>1] >> ((k&1)*4)) & 0xf};
+
+        state.Sample += IMA4Codeword[nibble] * IMAStep_size[state.Index] / 8;
+        state.Sample = clampi(state.Sample, -32768, 32767);
+        state.Index = clampi(state.Index + IMA4Index_adjust[nibble], 0, 88);
+        ++state.Pos;
     }
-}
+};
 
-void DecodeMSADPCMBlock(ALshort *dst, const ALubyte *src, ALint numchans, ALsizei align)
-{
-    ALubyte blockpred[MAX_INPUT_CHANNELS]{};
-    ALint delta[MAX_INPUT_CHANNELS]{};
-    ALshort samples[MAX_INPUT_CHANNELS][2]{};
+struct MSADPCMDecoder {
+    const ALubyte *mData;
+    ALsizei mNumChans;
+    ALsizei mChan;
+    ALsizei mAlign;
+    ALsizei mBlockSize;
 
-    for(int c{0};c < numchans;c++)
-    {
-        blockpred[c] = *(src++);
-        blockpred[c] = minu(blockpred[c], 6);
-    }
-    for(int c{0};c < numchans;c++)
-    {
-        delta[c]  = *(src++);
-        delta[c] |= *(src++) << 8;
-        delta[c]  = (delta[c]^0x8000) - 32768;
-    }
-    for(int c{0};c < numchans;c++)
+    /* The header stores the second sample before the first. */
+    ALint headerSample(const int64_t block, const ALsizei idx) const noexcept
     {
-        samples[c][0]  = *(src++);
-        samples[c][0] |= *(src++) << 8;
-        samples[c][0]  = (samples[c][0]^0x8000) - 32768;
+        const ALubyte *src{mData + block*mBlockSize + mNumChans*(5-idx*2) + mChan*2};
+        return ((src[0] | (src[1]<<8)) ^ 0x8000) - 32768;
     }
-    for(int c{0};c < numchans;c++)
+
+    void initBlock(ADPCMState &state, const int64_t block) const noexcept
     {
-        samples[c][1]  = *(src++);
-        samples[c][1] |= *(src++) << 8;
-        samples[c][1]  = (samples[c][1]^0x8000) - 0x8000;
+        const ALubyte *src{mData + block*mBlockSize};
+        state.Index = minu(src[mChan], 6);
+        src += mNumChans + mChan*2;
+        state.Delta = ((src[0] | (src[1]<<8)) ^ 0x8000) - 32768;
+        state.Sample = headerSample(block, 0);
+        state.Sample2 = 0;
+        state.Pos = block * mAlign;
     }
 
-    /* Second sample is written first. */
-    for(int c{0};c < numchans;c++)
-        *(dst++) = samples[c][1];
-    for(int c{0};c < numchans;c++)
-        *(dst++) = samples[c][0];
-
-    for(int i{2};i < align;i++)
+    void step(ADPCMState &state) const noexcept
     {
-        for(int c{0};c < numchans;c++)
+        const int64_t block{(state.Pos+1) / mAlign};
+        const auto i = static_cast<ALsizei>((state.Pos+1) % mAlign);
+        if(i == 0)
+        {
+            initBlock(state, block);
+            return;
+        }
+        if(i == 1)
         {
-            const ALint num = (i*numchans) + c;
-            ALint nibble, pred;
+            state.Sample2 = state.Sample;
+            state.Sample = headerSample(block, 1);
+            ++state.Pos;
+            return;
+        }
 
-            /* Read the nibble (first is in the upper bits). */
-            if(!(num&1))
-                nibble = (*src>>4)&0x0f;
-            else
-                nibble = (*(src++))&0x0f;
+        /* After the headers, the channels' nibbles are interleaved, with the
+         * first in the upper bits.
+         */
+        const ALsizei num{i*mNumChans + mChan - mNumChans*2};
+        const ALubyte byte{mData[block*mBlockSize + mNumChans*7 + (num>>1)]};
+        const ALint nibble{(num&1) ? (byte&0x0f) : ((byte>>4)&0x0f)};
 
-            pred  = (samples[c][0]*MSADPCMAdaptionCoeff[blockpred[c]][0] +
-                     samples[c][1]*MSADPCMAdaptionCoeff[blockpred[c]][1]) / 256;
-            pred += ((nibble^0x08) - 0x08) * delta[c];
-            pred  = clampi(pred, -32768, 32767);
+        ALint pred{(state.Sample*MSADPCMAdaptionCoeff[state.Index][0] +
+            state.Sample2*MSADPCMAdaptionCoeff[state.Index][1]) / 256};
+        pred += ((nibble^0x08) - 0x08) * state.Delta;
+        pred = clampi(pred, -32768, 32767);
 
-            samples[c][1] = samples[c][0];
-            samples[c][0] = pred;
+        state.Sample2 = state.Sample;
+        state.Sample = pred;
 
-            delta[c] = (MSADPCMAdaption[nibble] * delta[c]) / 256;
-            delta[c] = maxi(16, delta[c]);
+        state.Delta = maxi(16, (MSADPCMAdaption[nibble] * state.Delta) / 256);
+        ++state.Pos;
+    }
+};
 
-            *(dst++) = pred;
+template<typename Decoder>
+void DecodeADPCM(const Decoder &decoder, ALfloat *dst, const int64_t pos, const ALsizei count,
+    ADPCMState &state, const int64_t checkpoint)
+{
+    const ALsizei align{decoder.mAlign};
+    if(state.Pos > pos || state.Pos/align != pos/align)
+        decoder.initBlock(state, pos/align);
+    while(state.Pos < pos)
+        decoder.step(state);
+
+    ADPCMState saved{};
+    bool havesaved{false};
+    for(ALsizei i{0};i < count;i++)
+    {
+        dst[i] += static_cast<ALfloat>(state.Sample) * (1.0f/32768.0f);
+        if(state.Pos == checkpoint)
+        {
+            saved = state;
+            havesaved = true;
         }
+        if(i+1 < count)
+            decoder.step(state);
     }
+    if(havesaved) state = saved;
 }
 
 } // namespace
 
-void Convert_ALshort_ALima4(ALshort *dst, const ALubyte *src, ALsizei numchans, ALsizei len,
-                            ALsizei align)
+void DecodeADPCMSamples(ALfloat *dst, const ALbuffer *buffer, ALsizei chan, int64_t pos,
+    ALsizei count, ADPCMState &state, int64_t checkpoint)
 {
-    ALsizei byte_align = ((align-1)/2 + 4) * numchans;
+    if(count < 1) return;
 
-    assert(align > 0 && (len%align) == 0);
-    len /= align;
-    while(len--)
+    const ALsizei numchans{ChannelsFromFmt(buffer->mFmtChannels)};
+    const ALsizei align{buffer->OriginalAlign};
+    const auto data = reinterpret_cast<const ALubyte*>(buffer->samples());
+    if(state.Buffer != buffer)
     {
-        DecodeIMA4Block(dst, src, numchans, align);
-        src += byte_align;
-        dst += align*numchans;
+        state.Buffer = buffer;
+        state.Pos = std::numeric_limits<int64_t>::max();
     }
-}
 
-void Convert_ALshort_ALmsadpcm(ALshort *dst, const ALubyte *src, ALsizei numchans, ALsizei len,
-                               ALsizei align)
-{
-    const ALsizei byte_align = ((align-2)/2 + 7) * numchans;
-
-    assert(align > 1 && (len%align) == 0);
-    len /= align;
-    while(len--)
+    if(buffer->mFmtType == FmtIMA4)
+    {
+        const IMA4Decoder decoder{data, numchans, chan, align, ((align-1)/2 + 4) * numchans};
+        DecodeADPCM(decoder, dst, pos, count, state, checkpoint);
+    }
+    else /*if(buffer->mFmtType == FmtMSADPCM)*/
     {
-        DecodeMSADPCMBlock(dst, src, numchans, align);
-        src += byte_align;
-        dst += align*numchans;
+        const MSADPCMDecoder decoder{data, numchans, chan, align, ((align-2)/2 + 7) * numchans};
+        DecodeADPCM(decoder, dst, pos, count, state, checkpoint);
     }
 }
@@ -0,0 +1,55 @@
+# - Find PipeWire includes and libraries
+#
+#   PIPEWIRE_FOUND        - True if PIPEWIRE_INCLUDE_DIR, SPA_INCLUDE_DIR &
+#                           PIPEWIRE_LIBRARY are found
+#   PIPEWIRE_LIBRARIES    - Set when PIPEWIRE_LIBRARY is found
+#   PIPEWIRE_INCLUDE_DIRS - Set when PIPEWIRE_INCLUDE_DIR & SPA_INCLUDE_DIR are
+#                           found
+#
+#   PIPEWIRE_INCLUDE_DIR - where to find pipewire/pipewire.h, etc.
+#   SPA_INCLUDE_DIR      - where to find spa/param/audio/format-utils.h, etc.
+#   PIPEWIRE_LIBRARY     - the pipewire library
+#   PIPEWIRE_VERSION_STRING - the version of PipeWire found
+#
+
+find_package(PkgConfig QUIET)
+if(PKG_CONFIG_FOUND)
+    pkg_check_modules(PC_PIPEWIRE QUIET libpipewire-0.3)
+endif()
+
+find_path(PIPEWIRE_INCLUDE_DIR
+          NAMES pipewire/pipewire.h
+          HINTS ${PC_PIPEWIRE_INCLUDE_DIRS}
+          PATH_SUFFIXES pipewire-0.3
+          DOC "The PipeWire include directory"
+)
+
+find_path(SPA_INCLUDE_DIR
+          NAMES spa/param/audio/format-utils.h
+          HINTS ${PC_PIPEWIRE_INCLUDE_DIRS}
+          PATH_SUFFIXES spa-0.2
+          DOC "The SPA include directory"
+)
+
+find_library(PIPEWIRE_LIBRARY
+             NAMES pipewire-0.3
+             HINTS ${PC_PIPEWIRE_LIBRARY_DIRS}
+             DOC "The PipeWire library"
+)
+
+if(PC_PIPEWIRE_VERSION)
+    set(PIPEWIRE_VERSION_STRING ${PC_PIPEWIRE_VERSION})
+endif()
+
+include(FindPackageHandleStandardArgs)
+find_package_handle_standard_args(PipeWire
+    REQUIRED_VARS PIPEWIRE_LIBRARY PIPEWIRE_INCLUDE_DIR SPA_INCLUDE_DIR
+    VERSION_VAR PIPEWIRE_VERSION_STRING
+)
+
+if(PIPEWIRE_FOUND)
+    set(PIPEWIRE_LIBRARIES ${PIPEWIRE_LIBRARY})
+    set(PIPEWIRE_INCLUDE_DIRS ${PIPEWIRE_INCLUDE_DIR} ${SPA_INCLUDE_DIR})
+endif()
+
+mark_as_advanced(PIPEWIRE_INCLUDE_DIR SPA_INCLUDE_DIR PIPEWIRE_LIBRARY)
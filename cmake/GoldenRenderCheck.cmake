@@ -0,0 +1,20 @@
+# Renders a scene with openal-bench serially, then again with the given config
+# options, and fails unless the outputs are identical.
+#
+# Expects BENCH (the openal-bench executable), GOLDEN (the file to save the
+# serial render to), SCENE (the bench options describing the scene), and
+# OPTIONS (the config options to compare, as -O arguments), with the lists
+# separated by semicolons.
+
+execute_process(COMMAND ${BENCH} ${SCENE} -o ${GOLDEN}
+    RESULT_VARIABLE result OUTPUT_QUIET)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "Serial render failed (${result})")
+endif()
+
+execute_process(COMMAND ${BENCH} ${SCENE} ${OPTIONS} -g ${GOLDEN} -E
+    RESULT_VARIABLE result OUTPUT_VARIABLE output)
+file(REMOVE ${GOLDEN})
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "Output with ${OPTIONS} differs from the serial render (${result}):\n${output}")
+endif()
@@ -3,12 +3,134 @@
 
 #include "alcomplex.h"
 
+#include <algorithm>
 #include <cmath>
 
+#if defined(HAVE_SSE_INTRINSICS)
+#include <xmmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define HAVE_NEON_INTRINSICS
+#endif
+
+#include "opthelpers.h"
+
 namespace {
 
 constexpr double Pi{3.141592653589793238462643383279502884};
 
+
+/* Applies count radix-2 butterflies, combining each a[j] and b[j] with the
+ * twiddle factor tw[j]. The complex multiply is written out to avoid the
+ * extra NaN handling std::complex does.
+ */
+template<typename Real>
+inline void ApplyButterflies(std::complex<Real> *RESTRICT a, std::complex<Real> *RESTRICT b,
+    const std::complex<Real> *RESTRICT tw, const int count)
+{
+    for(int j{0};j < count;++j)
+    {
+        const Real tr{b[j].real()*tw[j].real() - b[j].imag()*tw[j].imag()};
+        const Real ti{b[j].real()*tw[j].imag() + b[j].imag()*tw[j].real()};
+        b[j] = std::complex<Real>{a[j].real() - tr, a[j].imag() - ti};
+        a[j] = std::complex<Real>{a[j].real() + tr, a[j].imag() + ti};
+    }
+}
+
+#if defined(HAVE_SSE_INTRINSICS)
+
+/* Two complex floats fit in a vector, which works for every stage after the
+ * first.
+ */
+template<>
+inline void ApplyButterflies<float>(std::complex<float> *RESTRICT a,
+    std::complex<float> *RESTRICT b, const std::complex<float> *RESTRICT tw, const int count)
+{
+    if(count < 2)
+    {
+        const float tr{b[0].real()*tw[0].real() - b[0].imag()*tw[0].imag()};
+        const float ti{b[0].real()*tw[0].imag() + b[0].imag()*tw[0].real()};
+        b[0] = std::complex<float>{a[0].real() - tr, a[0].imag() - ti};
+        a[0] = std::complex<float>{a[0].real() + tr, a[0].imag() + ti};
+        return;
+    }
+
+    const __m128 signs{_mm_set_ps(1.0f, -1.0f, 1.0f, -1.0f)};
+    for(int j{0};j < count;j += 2)
+    {
+        const __m128 x{_mm_loadu_ps(reinterpret_cast<const float*>(b + j))};
+        const __m128 w{_mm_loadu_ps(reinterpret_cast<const float*>(tw + j))};
+        const __m128 wr{_mm_shuffle_ps(w, w, _MM_SHUFFLE(2, 2, 0, 0))};
+        const __m128 wi{_mm_shuffle_ps(w, w, _MM_SHUFFLE(3, 3, 1, 1))};
+        const __m128 xs{_mm_shuffle_ps(x, x, _MM_SHUFFLE(2, 3, 0, 1))};
+        const __m128 t{_mm_add_ps(_mm_mul_ps(x, wr), _mm_mul_ps(_mm_mul_ps(xs, wi), signs))};
+
+        const __m128 y{_mm_loadu_ps(reinterpret_cast<const float*>(a + j))};
+        _mm_storeu_ps(reinterpret_cast<float*>(b + j), _mm_sub_ps(y, t));
+        _mm_storeu_ps(reinterpret_cast<float*>(a + j), _mm_add_ps(y, t));
+    }
+}
+
+#elif defined(HAVE_NEON_INTRINSICS)
+
+/* Deinterleaving loads give four real and four imaginary parts at a time,
+ * which works for every stage after the second.
+ */
+template<>
+inline void ApplyButterflies<float>(std::complex<float> *RESTRICT a,
+    std::complex<float> *RESTRICT b, const std::complex<float> *RESTRICT tw, const int count)
+{
+    int j{0};
+    for(;j+4 <= count;j += 4)
+    {
+        const float32x4x2_t x{vld2q_f32(reinterpret_cast<const float*>(b + j))};
+        const float32x4x2_t w{vld2q_f32(reinterpret_cast<const float*>(tw + j))};
+        const float32x4_t tr{vmlsq_f32(vmulq_f32(x.val[0], w.val[0]), x.val[1], w.val[1])};
+        const float32x4_t ti{vmlaq_f32(vmulq_f32(x.val[0], w.val[1]), x.val[1], w.val[0])};
+
+        const float32x4x2_t y{vld2q_f32(reinterpret_cast<const float*>(a + j))};
+        float32x4x2_t out;
+        out.val[0] = vsubq_f32(y.val[0], tr);
+        out.val[1] = vsubq_f32(y.val[1], ti);
+        vst2q_f32(reinterpret_cast<float*>(b + j), out);
+        out.val[0] = vaddq_f32(y.val[0], tr);
+        out.val[1] = vaddq_f32(y.val[1], ti);
+        vst2q_f32(reinterpret_cast<float*>(a + j), out);
+    }
+    for(;j < count;++j)
+    {
+        const float tr{b[j].real()*tw[j].real() - b[j].imag()*tw[j].imag()};
+        const float ti{b[j].real()*tw[j].imag() + b[j].imag()*tw[j].real()};
+        b[j] = std::complex<float>{a[j].real() - tr, a[j].imag() - ti};
+        a[j] = std::complex<float>{a[j].real() + tr, a[j].imag() + ti};
+    }
+}
+
+#endif
+
+template<typename Real>
+void ApplyFft(std::complex<Real> *buffer, const int size,
+    const std::vector<std::pair<int,int>> &swaps, const std::complex<Real> *twiddles)
+{
+    for(const auto &swap : swaps)
+        std::swap(buffer[swap.first], buffer[swap.second]);
+
+    /* The first stage's twiddle factor is always 1. */
+    for(int k{0};k < size;k += 2)
+    {
+        const std::complex<Real> t{buffer[k+1]};
+        buffer[k+1] = buffer[k] - t;
+        buffer[k] += t;
+    }
+
+    for(int half{2};half < size;half <<= 1)
+    {
+        const std::complex<Real> *tw{twiddles + half-1};
+        for(int k{0};k < size;k += half*2)
+            ApplyButterflies(buffer+k, buffer+k+half, tw, half);
+    }
+}
+
 } // namespace
 
 void complex_fft(std::complex<double> *FFTBuffer, int FFTSize, double Sign)
@@ -29,7 +151,7 @@ void complex_fft(std::complex<double> *FFTBuffer, int FFTSize, double Sign)
             std::swap(FFTBuffer[i], FFTBuffer[j]);
     }
 
-    /* Iterative form of DanielsonLanczos lemma */
+    /* Iterative form of DanielsonLanczos lemma */
     int step{2};
     for(int i{1};i < FFTSize;i<<=1, step<<=1)
     {
@@ -52,6 +174,154 @@ void complex_fft(std::complex<double> *FFTBuffer, int FFTSize, double Sign)
     }
 }
 
+
+template<typename Real>
+FftPlan<Real>::FftPlan(const int size) : mSize{size}
+{
+    for(int i{1};i < size-1;i++)
+    {
+        int j{0};
+        for(int mask{1};mask < size;mask <<= 1)
+        {
+            if((i&mask) != 0)
+                j++;
+            j <<= 1;
+        }
+        j >>= 1;
+
+        if(i < j)
+            mSwaps.emplace_back(i, j);
+    }
+
+    /* The factors are calculated directly in double precision, rather than
+     * accumulated, to keep them accurate for larger sizes.
+     */
+    const size_t count{static_cast<size_t>((size > 1) ? size-1 : 0)};
+    mTwiddles[0].reserve(count);
+    mTwiddles[1].reserve(count);
+    for(int half{1};half < size;half <<= 1)
+    {
+        for(int j{0};j < half;j++)
+        {
+            const double arg{Pi * j / half};
+            const auto re = static_cast<Real>(std::cos(arg));
+            const auto im = static_cast<Real>(std::sin(arg));
+            mTwiddles[0].emplace_back(re, -im);
+            mTwiddles[1].emplace_back(re, im);
+        }
+    }
+}
+
+template<typename Real>
+void FftPlan<Real>::forward(std::complex<Real> *buffer) const noexcept
+{
+    if(mSize > 1)
+        ApplyFft(buffer, mSize, mSwaps, mTwiddles[0].data());
+}
+
+template<typename Real>
+void FftPlan<Real>::inverse(std::complex<Real> *buffer) const noexcept
+{
+    if(mSize > 1)
+        ApplyFft(buffer, mSize, mSwaps, mTwiddles[1].data());
+}
+
+
+/* The real transform packs the even and odd samples as the real and
+ * imaginary parts of a half-size complex signal z, so with the spectra E and
+ * O of the even and odd samples, and W = exp(-2*pi*i/size):
+ *
+ *     Z[k] = E[k] + i*O[k]
+ *     X[k] = E[k] + W^k * O[k]
+ *
+ * Where E and O are recovered from Z using the symmetry of real signals'
+ * spectra.
+ */
+template<typename Real>
+RealFftPlan<Real>::RealFftPlan(const int size) : mHalf{size/2}
+{
+    const int half{size/2};
+    mTwiddles.reserve(static_cast<size_t>(half));
+    for(int k{0};k < half;k++)
+    {
+        const double arg{2.0 * Pi * k / size};
+        mTwiddles.emplace_back(static_cast<Real>(std::cos(arg)),
+            static_cast<Real>(-std::sin(arg)));
+    }
+}
+
+template<typename Real>
+void RealFftPlan<Real>::forward(const Real *input, std::complex<Real> *output) const noexcept
+{
+    const int half{mHalf.size()};
+    ASSUME(half >= 2);
+
+    Real *RESTRICT packed{reinterpret_cast<Real*>(output)};
+    std::copy_n(input, half*2, packed);
+    mHalf.forward(output);
+
+    /* Separate the DC and Nyquist bins, which are both real. */
+    const std::complex<Real> z0{output[0]};
+    output[0] = std::complex<Real>{z0.real() + z0.imag(), Real{0}};
+    output[half] = std::complex<Real>{z0.real() - z0.imag(), Real{0}};
+
+    /* The other bins are handled in pairs, k and half-k, which use the same
+     * inputs.
+     */
+    for(int k{1};k <= half/2;k++)
+    {
+        const std::complex<Real> a{output[k]};
+        const std::complex<Real> b{std::conj(output[half-k])};
+        const std::complex<Real> w{mTwiddles[static_cast<size_t>(k)]};
+
+        /* E[k] = (a + b) / 2, O[k] = (a - b) / 2i */
+        const Real er{(a.real() + b.real()) * Real{0.5}};
+        const Real ei{(a.imag() + b.imag()) * Real{0.5}};
+        const Real or_{(a.imag() - b.imag()) * Real{0.5}};
+        const Real oi{(b.real() - a.real()) * Real{0.5}};
+        const Real tr{w.real()*or_ - w.imag()*oi};
+        const Real ti{w.real()*oi + w.imag()*or_};
+
+        output[k] = std::complex<Real>{er + tr, ei + ti};
+        output[half-k] = std::complex<Real>{er - tr, ti - ei};
+    }
+}
+
+template<typename Real>
+void RealFftPlan<Real>::inverse(const std::complex<Real> *input, Real *output) const noexcept
+{
+    const int half{mHalf.size()};
+    ASSUME(half >= 2);
+
+    /* Rebuild the packed spectrum, 2*Z[k] = (X[k] + conj(X[half-k])) +
+     * i*conj(W^k)*(X[k] - conj(X[half-k])).
+     */
+    std::complex<Real> *RESTRICT packed{reinterpret_cast<std::complex<Real>*>(output)};
+    for(int k{0};k < half;k++)
+    {
+        const std::complex<Real> a{input[k]};
+        const std::complex<Real> b{std::conj(input[half-k])};
+        const std::complex<Real> w{mTwiddles[static_cast<size_t>(k)]};
+
+        const Real er{a.real() + b.real()};
+        const Real ei{a.imag() + b.imag()};
+        const Real dr{a.real() - b.real()};
+        const Real di{a.imag() - b.imag()};
+        /* o = conj(w) * d */
+        const Real or_{w.real()*dr + w.imag()*di};
+        const Real oi{w.real()*di - w.imag()*dr};
+
+        packed[k] = std::complex<Real>{er - oi, ei + or_};
+    }
+    mHalf.inverse(packed);
+}
+
+template class FftPlan<float>;
+template class FftPlan<double>;
+template class RealFftPlan<float>;
+template class RealFftPlan<double>;
+
+
 void complex_hilbert(std::complex<double> *Buffer, int size)
 {
     const double inverse_size = 1.0/static_cast<double>(size);
@@ -74,3 +344,27 @@ void complex_hilbert(std::complex<double> *Buffer, int size)
 
     complex_fft(Buffer, size, -1.0);
 }
+
+void complex_hilbert(const FftPlan<double> &plan, std::complex<double> *Buffer)
+{
+    const int size{plan.size()};
+    const double inverse_size = 1.0/static_cast<double>(size);
+
+    for(int i{0};i < size;i++)
+        Buffer[i].imag(0.0);
+
+    plan.inverse(Buffer);
+
+    int todo{size>>1};
+    int i{0};
+
+    Buffer[i++] *= inverse_size;
+    while(i < todo)
+        Buffer[i++] *= 2.0*inverse_size;
+    Buffer[i++] *= inverse_size;
+
+    for(;i < size;i++)
+        Buffer[i] = std::complex<double>{};
+
+    plan.forward(Buffer);
+}
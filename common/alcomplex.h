@@ -2,6 +2,8 @@
 #define ALCOMPLEX_H
 
 #include <complex>
+#include <utility>
+#include <vector>
 
 /**
  * Iterative implementation of 2-radix FFT (In-place algorithm). Sign = -1 is
@@ -12,6 +14,75 @@
  */
 void complex_fft(std::complex<double> *FFTBuffer, int FFTSize, double Sign);
 
+/**
+ * A planned radix-2 FFT for a fixed, power of two size. The bit-reversal
+ * permutation and the twiddle factors for each stage are calculated when the
+ * plan is created, so transforms don't allocate or call any trig functions
+ * and a plan can be used by multiple threads at once. Both directions are
+ * in-place and unnormalized, so the inverse of the forward transform is
+ * scaled by the size.
+ */
+template<typename Real>
+class FftPlan {
+    int mSize{0};
+    /* Index pairs to swap for the bit-reversal permutation. */
+    std::vector<std::pair<int,int>> mSwaps;
+    /* Twiddle factors for each stage, one after another. The stage with a
+     * half-size of m starts at index m-1.
+     */
+    std::vector<std::complex<Real>> mTwiddles[2];
+
+public:
+    /* An empty plan, to be assigned a sized one before use. */
+    FftPlan() = default;
+    explicit FftPlan(const int size);
+
+    int size() const noexcept { return mSize; }
+
+    /* Forward transform, with a negative exponent (same as complex_fft with
+     * Sign = -1).
+     */
+    void forward(std::complex<Real> *buffer) const noexcept;
+    /* Inverse transform, with a positive exponent (same as complex_fft with
+     * Sign = 1).
+     */
+    void inverse(std::complex<Real> *buffer) const noexcept;
+};
+
+/**
+ * A planned FFT of real samples, using a half-size complex transform. The
+ * size must be a power of two of at least 4. The spectrum of a real signal is
+ * symmetric, so only the size/2+1 non-negative frequency bins are used. As
+ * with the complex plan, the transforms are unnormalized.
+ */
+template<typename Real>
+class RealFftPlan {
+    FftPlan<Real> mHalf;
+    /* The twiddle factors used to split and merge the half-size transform. */
+    std::vector<std::complex<Real>> mTwiddles;
+
+public:
+    RealFftPlan() = default;
+    explicit RealFftPlan(const int size);
+
+    int size() const noexcept { return mHalf.size()*2; }
+
+    /* Transforms size real samples into size/2+1 frequency bins. The output
+     * is also used as scratch space, and may not overlap the input.
+     */
+    void forward(const Real *input, std::complex<Real> *output) const noexcept;
+    /* Transforms size/2+1 frequency bins into size real samples. The
+     * imaginary parts of the DC and Nyquist bins should be 0. The output may
+     * not overlap the input.
+     */
+    void inverse(const std::complex<Real> *input, Real *output) const noexcept;
+};
+
+extern template class FftPlan<float>;
+extern template class FftPlan<double>;
+extern template class RealFftPlan<float>;
+extern template class RealFftPlan<double>;
+
 /**
  * Calculate the complex helical sequence (discrete-time analytical signal) of
  * the given input using the discrete Hilbert transform (In-place algorithm).
@@ -21,4 +92,10 @@ void complex_fft(std::complex<double> *FFTBuffer, int FFTSize, double Sign);
  */
 void complex_hilbert(std::complex<double> *Buffer, int size);
 
+/**
+ * Same as above, using the given plan for the transforms. The buffer holds
+ * plan.size() values.
+ */
+void complex_hilbert(const FftPlan<double> &plan, std::complex<double> *Buffer);
+
 #endif /* ALCOMPLEX_H */
@@ -5,26 +5,44 @@
 
 #include <cstdlib>
 #include <cstring>
+#include <cstdint>
+
+#include <algorithm>
+#include <atomic>
+#include <iterator>
+#include <mutex>
+#include <new>
 #ifdef HAVE_MALLOC_H
 #include <malloc.h>
 #endif
+#ifdef HAVE_EXECINFO_H
+#include <execinfo.h>
+#endif
 #ifdef HAVE_WINDOWS_H
 #include <windows.h>
 #else
 #include <unistd.h>
 #endif
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
 
-
-#ifdef __GNUC__
-#define LIKELY(x) __builtin_expect(!!(x), !0)
-#define UNLIKELY(x) __builtin_expect(!!(x), 0)
-#else
-#define LIKELY(x) (!!(x))
-#define UNLIKELY(x) (!!(x))
+#include "opthelpers.h"
+#ifdef ALSOFT_RT_ALLOC_CHECK
+#include "logging.h"
 #endif
 
 
-void *al_malloc(size_t alignment, size_t size)
+namespace {
+
+struct Allocator {
+    al_alloc_func alloc;
+    al_free_func free;
+    void *userptr;
+};
+
+void *native_alloc(void*, size_t size, size_t alignment)
 {
 #if defined(HAVE_ALIGNED_ALLOC)
     size = (size+(alignment-1))&~(alignment-1);
@@ -48,14 +66,7 @@ void *al_malloc(size_t alignment, size_t size)
 #endif
 }
 
-void *al_calloc(size_t alignment, size_t size)
-{
-    void *ret = al_malloc(alignment, size);
-    if(ret) memset(ret, 0, size);
-    return ret;
-}
-
-void al_free(void *ptr) noexcept
+void native_free(void*, void *ptr, size_t) noexcept
 {
 #if defined(HAVE_ALIGNED_ALLOC) || defined(HAVE_POSIX_MEMALIGN)
     free(ptr);
@@ -73,6 +84,650 @@ void al_free(void *ptr) noexcept
 #endif
 }
 
+/* Mapping for an arena's large blocks, aligned to and sized in multiples of
+ * 2MB so each can be backed by huge pages.
+ */
+constexpr size_t LargePageSize{size_t{1} << 21};
+
+#ifdef __linux__
+/* MPOL_PREFERRED, from linux/mempolicy.h. */
+constexpr int MpolPreferred{1};
+
+void *map_large(size_t size, bool hugepages, int numanode) noexcept
+{
+    void *ptr{mmap(nullptr, size+LargePageSize, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS,
+        -1, 0)};
+    if(ptr == MAP_FAILED) return nullptr;
+
+    /* Trim the over-allocation so the mapping is aligned. */
+    const auto start = reinterpret_cast<uintptr_t>(ptr);
+    const uintptr_t aligned{(start+LargePageSize-1) & ~uintptr_t{LargePageSize-1}};
+    if(aligned > start)
+        munmap(ptr, aligned-start);
+    if(const size_t tail{LargePageSize - (aligned-start)})
+        munmap(reinterpret_cast<void*>(aligned+size), tail);
+    ptr = reinterpret_cast<void*>(aligned);
+
+#ifdef MADV_HUGEPAGE
+    if(hugepages)
+        madvise(ptr, size, MADV_HUGEPAGE);
+#else
+    (void)hugepages;
+#endif
+#ifdef SYS_mbind
+    /* Pages aren't committed until first touched, so the preferred node
+     * applies regardless of which thread touches them.
+     */
+    constexpr size_t MaskBits{1024};
+    constexpr size_t WordBits{sizeof(unsigned long)*8};
+    if(numanode >= 0 && static_cast<size_t>(numanode) < MaskBits)
+    {
+        unsigned long mask[MaskBits/WordBits]{};
+        mask[static_cast<size_t>(numanode)/WordBits] |= 1ul << (numanode%WordBits);
+        syscall(SYS_mbind, ptr, size, MpolPreferred, mask, MaskBits+1, 0);
+    }
+#else
+    (void)numanode;
+#endif
+    return ptr;
+}
+
+void unmap_large(void *ptr, size_t size) noexcept
+{ munmap(ptr, size); }
+
+#else
+
+void *map_large(size_t, bool, int) noexcept
+{ return nullptr; }
+
+void unmap_large(void*, size_t) noexcept
+{ }
+#endif
+
+const Allocator NativeAllocator{native_alloc, native_free, nullptr};
+std::atomic<const Allocator*> GlobalAllocator{&NativeAllocator};
+
+/* Stored just before each block al_malloc returns, to know how to free it. */
+struct BlockHeader {
+    const Allocator *source;
+    /* The size allocated from the source, and the block's offset into it. */
+    size_t size;
+    size_t offset;
+};
+
+thread_local al::Arena *CurrentArena{nullptr};
+
+#ifdef ALSOFT_RT_ALLOC_CHECK
+
+/* Only the first few offenders get a backtrace, since an allocation in the
+ * mixer would otherwise be logged every update.
+ */
+constexpr unsigned int MaxRTAllocReports{16};
+
+thread_local bool InRTSection{false};
+std::atomic<unsigned int> RTAllocReports{0u};
+
+void ReportRTAlloc(const char *func, size_t size)
+{
+    /* Logging may itself allocate. */
+    InRTSection = false;
+
+    const unsigned int count{RTAllocReports.fetch_add(1u, std::memory_order_relaxed) + 1};
+    if(count <= MaxRTAllocReports)
+    {
+        if(size > 0)
+            ERR("%s(%zu) called while mixing\n", func, size);
+        else
+            ERR("%s called while mixing\n", func);
+#ifdef HAVE_EXECINFO_H
+        void *frames[32];
+        const int numframes{backtrace(frames, 32)};
+        if(char **names{backtrace_symbols(frames, numframes)})
+        {
+            for(int i{1};i < numframes;++i)
+                ERR("    %s\n", names[i]);
+            free(names);
+        }
+#endif
+        if(count == MaxRTAllocReports)
+            ERR("Not logging further heap use while mixing\n");
+    }
+
+    InRTSection = true;
+}
+
+inline void CheckRTAlloc(const char *func, size_t size)
+{
+    if(UNLIKELY(InRTSection))
+        ReportRTAlloc(func, size);
+}
+
+#else
+
+inline void CheckRTAlloc(const char*, size_t) noexcept { }
+
+#endif /* ALSOFT_RT_ALLOC_CHECK */
+
+} // namespace
+
+
+namespace al {
+
+struct Arena {
+    /* Size classes are powers of 2, from 64 to 4096 bytes. Every block is
+     * aligned to 64 bytes, the smallest class size.
+     */
+    static constexpr size_t MinClassBits{6};
+    static constexpr size_t NumClasses{7};
+    static constexpr size_t MaxAlign{size_t{1} << MinClassBits};
+    static constexpr size_t PageSize{65536};
+    static constexpr size_t MaxSmallSize{size_t{1} << (MinClassBits+NumClasses-1)};
+
+    /* With a large block policy, the arena also takes blocks up to 1MB, in
+     * classes from 8KB, out of 2MB regions mapped with the policy. Bigger
+     * blocks get their own mapping.
+     */
+    static constexpr size_t NumLargeClasses{8};
+    static constexpr size_t MaxLargeSize{MaxSmallSize << NumLargeClasses};
+    static constexpr size_t RegionSize{LargePageSize};
+
+    struct Page {
+        Page *next;
+        const Allocator *source;
+    };
+    struct Region {
+        Region *next;
+        char *base;
+    };
+    struct LockedMap {
+        LockedMap *next;
+        void *base;
+        size_t size;
+    };
+
+    Allocator mAllocator;
+    /* One reference for the creator, plus one for each outstanding block. */
+    std::atomic<size_t> mRef{1u};
+
+    std::mutex mLock;
+    void *mFreeList[NumClasses+NumLargeClasses]{};
+    Page *mPages{nullptr};
+    char *mCur{nullptr};
+    char *mEnd{nullptr};
+
+    std::atomic<bool> mLargeBlocks{false};
+    bool mHugePages{false};
+    int mNumaNode{-1};
+    Region *mRegions{nullptr};
+    char *mRegionCur{nullptr};
+    char *mRegionEnd{nullptr};
+
+    /* While locking, each page and region is locked as it's allocated, as is
+     * each block with its own mapping. Those are tracked so they can be
+     * unlocked if locking is turned off.
+     */
+    bool mLocked{false};
+    LockedMap *mLockedMaps{nullptr};
+    std::atomic<size_t> mLockedSize{0u};
+    std::atomic<size_t> mLockFailedSize{0u};
+
+    static size_t classIndex(size_t size) noexcept
+    {
+        size_t idx{0};
+        while((size_t{1}<<(idx+MinClassBits)) < size)
+            ++idx;
+        return idx;
+    }
+
+    void *allocSmall(size_t idx)
+    {
+        const size_t blocksize{size_t{1} << (idx+MinClassBits)};
+
+        void *ret{mFreeList[idx]};
+        if(ret)
+            mFreeList[idx] = *static_cast<void**>(ret);
+        else
+        {
+            char *cur{mCur};
+            if(!cur || static_cast<size_t>(mEnd-cur) < blocksize)
+            {
+                /* Any space left in the old page is abandoned. */
+                const Allocator *source{GlobalAllocator.load(std::memory_order_acquire)};
+                /* Pages are aligned to the system's pages so locking one
+                 * doesn't also lock (and unlocking it doesn't unlock) memory
+                 * around it.
+                 */
+                auto page = static_cast<Page*>(source->alloc(source->userptr, PageSize,
+                    std::max(size_t{MaxAlign}, al_get_page_size())));
+                if(!page) return nullptr;
+                page->next = mPages;
+                page->source = source;
+                mPages = page;
+                if(mLocked)
+                    lockRange(page, PageSize);
+                cur = reinterpret_cast<char*>(page) + MaxAlign;
+                mEnd = reinterpret_cast<char*>(page) + PageSize;
+            }
+            ret = cur;
+            mCur = cur + blocksize;
+        }
+        return ret;
+    }
+
+    void *allocLarge(size_t idx)
+    {
+        const size_t blocksize{size_t{1} << (idx+MinClassBits)};
+
+        void *ret{mFreeList[idx]};
+        if(ret)
+        {
+            mFreeList[idx] = *static_cast<void**>(ret);
+            return ret;
+        }
+
+        if(!mRegionCur || static_cast<size_t>(mRegionEnd-mRegionCur) < blocksize)
+        {
+            auto base = static_cast<char*>(map_large(RegionSize, mHugePages, mNumaNode));
+            if(!base) return nullptr;
+            auto region = static_cast<Region*>(native_alloc(nullptr, sizeof(Region),
+                alignof(Region)));
+            if(!region)
+            {
+                unmap_large(base, RegionSize);
+                return nullptr;
+            }
+            /* The rest of the old region goes to the free lists, in the
+             * biggest blocks that fit. Every large block is a multiple of the
+             * smallest, so what's left always splits evenly.
+             */
+            splitRemaining();
+            region->next = mRegions;
+            region->base = base;
+            mRegions = region;
+            mRegionCur = base;
+            mRegionEnd = base + RegionSize;
+            if(mLocked)
+                lockRange(base, RegionSize);
+        }
+        ret = mRegionCur;
+        mRegionCur += blocksize;
+        return ret;
+    }
+
+    void splitRemaining() noexcept
+    {
+        while(mRegionCur && mRegionCur != mRegionEnd)
+        {
+            size_t idx{NumClasses + NumLargeClasses - 1};
+            while((size_t{1}<<(idx+MinClassBits)) > static_cast<size_t>(mRegionEnd-mRegionCur))
+                --idx;
+            *reinterpret_cast<void**>(mRegionCur) = mFreeList[idx];
+            mFreeList[idx] = mRegionCur;
+            mRegionCur += size_t{1} << (idx+MinClassBits);
+        }
+        mRegionCur = mRegionEnd = nullptr;
+    }
+
+    void lockRange(void *ptr, size_t size) noexcept
+    {
+        if(al::LockMemory(ptr, size))
+            mLockedSize.fetch_add(size, std::memory_order_relaxed);
+        else
+            mLockFailedSize.fetch_add(size, std::memory_order_relaxed);
+    }
+
+    void *mapLocked(size_t size) noexcept
+    {
+        void *ptr{map_large(size, mHugePages, mNumaNode)};
+        if(!ptr) return nullptr;
+
+        auto lmap = static_cast<LockedMap*>(native_alloc(nullptr, sizeof(LockedMap),
+            alignof(LockedMap)));
+        if(!lmap || !al::LockMemory(ptr, size))
+        {
+            native_free(nullptr, lmap, sizeof(LockedMap));
+            mLockFailedSize.fetch_add(size, std::memory_order_relaxed);
+            return ptr;
+        }
+        lmap->next = mLockedMaps;
+        lmap->base = ptr;
+        lmap->size = size;
+        mLockedMaps = lmap;
+        mLockedSize.fetch_add(size, std::memory_order_relaxed);
+        return ptr;
+    }
+
+    void forgetLocked(void *ptr) noexcept
+    {
+        LockedMap **lmap{&mLockedMaps};
+        while(*lmap && (*lmap)->base != ptr)
+            lmap = &(*lmap)->next;
+        if(LockedMap *found{*lmap})
+        {
+            *lmap = found->next;
+            mLockedSize.fetch_sub(found->size, std::memory_order_relaxed);
+            native_free(nullptr, found, sizeof(LockedMap));
+        }
+    }
+
+    void lockAll() noexcept
+    {
+        for(Page *page{mPages};page;page = page->next)
+            lockRange(page, PageSize);
+        for(Region *region{mRegions};region;region = region->next)
+            lockRange(region->base, RegionSize);
+    }
+
+    void unlockAll() noexcept
+    {
+        for(Page *page{mPages};page;page = page->next)
+            al::UnlockMemory(page, PageSize);
+        for(Region *region{mRegions};region;region = region->next)
+            al::UnlockMemory(region->base, RegionSize);
+        while(LockedMap *lmap{mLockedMaps})
+        {
+            mLockedMaps = lmap->next;
+            al::UnlockMemory(lmap->base, lmap->size);
+            native_free(nullptr, lmap, sizeof(LockedMap));
+        }
+        mLockedSize.store(0u, std::memory_order_relaxed);
+        mLockFailedSize.store(0u, std::memory_order_relaxed);
+    }
+
+    /* Returns null if the size or alignment is too large for the arena, or
+     * new memory couldn't be allocated.
+     */
+    void *allocate(size_t size, size_t alignment)
+    {
+        if(alignment > MaxAlign)
+            return nullptr;
+        if(size > MaxSmallSize && !mLargeBlocks.load(std::memory_order_relaxed))
+            return nullptr;
+
+        std::lock_guard<std::mutex> _{mLock};
+        void *ret;
+        if(size <= MaxSmallSize)
+            ret = allocSmall(classIndex(size));
+        else if(size <= MaxLargeSize)
+            ret = allocLarge(classIndex(size));
+        else
+        {
+            const size_t mapsize{(size+RegionSize-1) & ~(RegionSize-1)};
+            ret = mLocked ? mapLocked(mapsize) : map_large(mapsize, mHugePages, mNumaNode);
+        }
+        if(!ret) return nullptr;
+
+        mRef.fetch_add(1u, std::memory_order_relaxed);
+        return ret;
+    }
+
+    void deallocate(void *ptr, size_t size) noexcept
+    {
+        if(size > MaxLargeSize)
+        {
+            { std::lock_guard<std::mutex> _{mLock};
+                forgetLocked(ptr);
+            }
+            unmap_large(ptr, (size+RegionSize-1) & ~(RegionSize-1));
+        }
+        else
+        {
+            const size_t idx{classIndex(size)};
+            std::lock_guard<std::mutex> _{mLock};
+            *static_cast<void**>(ptr) = mFreeList[idx];
+            mFreeList[idx] = ptr;
+        }
+        release();
+    }
+
+    void release() noexcept
+    {
+        if(mRef.fetch_sub(1u, std::memory_order_acq_rel) == 1)
+            destroy();
+    }
+
+    void destroy() noexcept
+    {
+        if(mLocked)
+            unlockAll();
+        Page *page{mPages};
+        while(page)
+        {
+            Page *next{page->next};
+            page->source->free(page->source->userptr, page, PageSize);
+            page = next;
+        }
+        Region *region{mRegions};
+        while(region)
+        {
+            Region *next{region->next};
+            unmap_large(region->base, RegionSize);
+            native_free(nullptr, region, sizeof(Region));
+            region = next;
+        }
+        this->~Arena();
+        native_free(nullptr, this, sizeof(Arena));
+    }
+
+    static void *AllocThunk(void *userptr, size_t size, size_t alignment)
+    { return static_cast<Arena*>(userptr)->allocate(size, alignment); }
+    static void FreeThunk(void *userptr, void *ptr, size_t size)
+    { static_cast<Arena*>(userptr)->deallocate(ptr, size); }
+};
+
+static_assert(Arena::PageSize >= Arena::MaxAlign + Arena::MaxSmallSize,
+    "Arena pages are too small for the largest class");
+static_assert(Arena::RegionSize >= Arena::MaxLargeSize,
+    "Arena regions are too small for the largest class");
+
+Arena *CreateArena()
+{
+    void *ptr{native_alloc(nullptr, sizeof(Arena), alignof(Arena))};
+    if(!ptr) throw std::bad_alloc();
+    Arena *arena{new (ptr) Arena{}};
+    arena->mAllocator = Allocator{Arena::AllocThunk, Arena::FreeThunk, arena};
+    return arena;
+}
+
+void ReleaseArena(Arena *arena) noexcept
+{
+    if(arena)
+        arena->release();
+}
+
+bool SetArenaLargePolicy(Arena *arena, bool hugepages, int numanode) noexcept
+{
+#ifdef __linux__
+    const bool enable{hugepages || numanode >= 0};
+    std::lock_guard<std::mutex> _{arena->mLock};
+    if(hugepages != arena->mHugePages || numanode != arena->mNumaNode)
+    {
+        /* Drop the free large blocks and the rest of the current region, so
+         * new blocks come from regions mapped with the new policy. The old
+         * regions are still unmapped with the arena.
+         */
+        std::fill(std::begin(arena->mFreeList)+Arena::NumClasses, std::end(arena->mFreeList),
+            nullptr);
+        arena->mRegionCur = arena->mRegionEnd = nullptr;
+    }
+    arena->mHugePages = hugepages;
+    arena->mNumaNode = numanode;
+    arena->mLargeBlocks.store(enable || arena->mLocked, std::memory_order_relaxed);
+    return true;
+#else
+    (void)arena;
+    return !hugepages && numanode < 0;
+#endif
+}
+
+bool SetArenaLocked(Arena *arena, bool lock) noexcept
+{
+#ifdef __linux__
+    std::lock_guard<std::mutex> _{arena->mLock};
+    if(lock != arena->mLocked)
+    {
+        /* Blocks that already have their own mapping are left as they are. */
+        if(lock)
+            arena->lockAll();
+        else
+            arena->unlockAll();
+        arena->mLocked = lock;
+    }
+    arena->mLargeBlocks.store(lock || arena->mHugePages || arena->mNumaNode >= 0,
+        std::memory_order_relaxed);
+    return true;
+#else
+    (void)arena;
+    return !lock;
+#endif
+}
+
+size_t GetArenaLockedSize(Arena *arena, size_t *failed) noexcept
+{
+    if(failed)
+        *failed = arena->mLockFailedSize.load(std::memory_order_relaxed);
+    return arena->mLockedSize.load(std::memory_order_relaxed);
+}
+
+bool ArenaContains(Arena *arena, const void *ptr) noexcept
+{
+    auto in_range = [ptr](const void *base, size_t size) noexcept -> bool
+    {
+        const auto addr = reinterpret_cast<uintptr_t>(ptr);
+        const auto start = reinterpret_cast<uintptr_t>(base);
+        return addr >= start && addr-start < size;
+    };
+
+    std::lock_guard<std::mutex> _{arena->mLock};
+    for(Arena::Page *page{arena->mPages};page;page = page->next)
+    {
+        if(in_range(page, Arena::PageSize))
+            return true;
+    }
+    for(Arena::Region *region{arena->mRegions};region;region = region->next)
+    {
+        if(in_range(region->base, Arena::RegionSize))
+            return true;
+    }
+    for(Arena::LockedMap *lmap{arena->mLockedMaps};lmap;lmap = lmap->next)
+    {
+        if(in_range(lmap->base, lmap->size))
+            return true;
+    }
+    return false;
+}
+
+bool LockMemory(const void *ptr, size_t size) noexcept
+{
+#ifdef __linux__
+    /* Locking faults in the pages, with private mappings being written to. */
+    return mlock(ptr, size) == 0;
+#else
+    (void)ptr; (void)size;
+    return false;
+#endif
+}
+
+void UnlockMemory(const void *ptr, size_t size) noexcept
+{
+#ifdef __linux__
+    munlock(ptr, size);
+#else
+    (void)ptr; (void)size;
+#endif
+}
+
+int GetCurrentNumaNode() noexcept
+{
+#if defined(__linux__) && defined(SYS_getcpu)
+    unsigned int cpu, node;
+    if(syscall(SYS_getcpu, &cpu, &node, nullptr) == 0)
+        return static_cast<int>(node);
+#endif
+    return -1;
+}
+
+ArenaScope::ArenaScope(Arena *arena) noexcept : mOldArena{CurrentArena}
+{ CurrentArena = arena; }
+
+ArenaScope::~ArenaScope()
+{ CurrentArena = mOldArena; }
+
+#ifdef ALSOFT_RT_ALLOC_CHECK
+RTSection::RTSection() noexcept : mOldState{InRTSection}
+{ InRTSection = true; }
+
+RTSection::~RTSection()
+{ InRTSection = mOldState; }
+#endif
+
+} // namespace al
+
+
+void al_set_allocator(al_alloc_func allocfn, al_free_func freefn, void *userptr) noexcept
+{
+    const Allocator *source{&NativeAllocator};
+    if(allocfn && freefn)
+    {
+        /* Blocks reference the allocator they came from, so this is never
+         * freed.
+         */
+        void *ptr{native_alloc(nullptr, sizeof(Allocator), alignof(Allocator))};
+        if(!ptr) return;
+        source = new (ptr) Allocator{allocfn, freefn, userptr};
+    }
+    GlobalAllocator.store(source, std::memory_order_release);
+}
+
+
+void *al_malloc(size_t alignment, size_t size)
+{
+    CheckRTAlloc("al_malloc", size);
+
+    alignment = std::max(alignment, alignof(BlockHeader));
+    const size_t offset{(sizeof(BlockHeader)+(alignment-1)) & ~(alignment-1)};
+    if(UNLIKELY(size > std::numeric_limits<size_t>::max()-offset))
+        return nullptr;
+    const size_t total{size + offset};
+
+    const Allocator *source{nullptr};
+    char *base{nullptr};
+    if(al::Arena *arena{CurrentArena})
+    {
+        base = static_cast<char*>(arena->allocate(total, alignment));
+        if(base) source = &arena->mAllocator;
+    }
+    if(!base)
+    {
+        source = GlobalAllocator.load(std::memory_order_acquire);
+        base = static_cast<char*>(source->alloc(source->userptr, total, alignment));
+        if(!base) return nullptr;
+    }
+
+    char *ret{base + offset};
+    BlockHeader *hdr{reinterpret_cast<BlockHeader*>(ret) - 1};
+    hdr->source = source;
+    hdr->size = total;
+    hdr->offset = offset;
+    return ret;
+}
+
+void *al_calloc(size_t alignment, size_t size)
+{
+    void *ret = al_malloc(alignment, size);
+    if(ret) memset(ret, 0, size);
+    return ret;
+}
+
+void al_free(void *ptr) noexcept
+{
+    if(!ptr) return;
+
+    const BlockHeader hdr{*(reinterpret_cast<BlockHeader*>(ptr) - 1)};
+    CheckRTAlloc("al_free", hdr.size);
+    hdr.source->free(hdr.source->userptr, static_cast<char*>(ptr) - hdr.offset, hdr.size);
+}
+
 size_t al_get_page_size() noexcept
 {
     static size_t psize = 0;
@@ -106,3 +761,31 @@ int al_is_sane_alignment_allocator() noexcept
     return 0;
 #endif
 }
+
+
+#ifdef ALSOFT_RT_ALLOC_CHECK
+/* Replace the global operator new and delete too, to catch the standard
+ * containers and other heap use that doesn't go through al_malloc. The other
+ * forms of new and delete use these by default.
+ */
+void *operator new(size_t size)
+{
+    CheckRTAlloc("operator new", size);
+    if(size == 0) size = 1;
+    while(1)
+    {
+        if(void *ret{malloc(size)})
+            return ret;
+        std::new_handler handler{std::get_new_handler()};
+        if(!handler) throw std::bad_alloc();
+        handler();
+    }
+}
+
+void operator delete(void *ptr) noexcept
+{
+    if(!ptr) return;
+    CheckRTAlloc("operator delete", 0);
+    free(ptr);
+}
+#endif
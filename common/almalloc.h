@@ -16,6 +16,21 @@ void al_free(void *ptr) noexcept;
 
 size_t al_get_page_size(void) noexcept;
 
+/* Callbacks for providing the memory al_malloc hands out. The alloc function
+ * must return memory aligned to at least `alignment' bytes (a power of 2), or
+ * null on failure. The free function is given the same size the block was
+ * allocated with.
+ */
+using al_alloc_func = void*(*)(void *userptr, size_t size, size_t alignment);
+using al_free_func = void(*)(void *userptr, void *ptr, size_t size);
+
+/* Sets the functions used for subsequent allocations, or restores the default
+ * when they're null. Each block remembers where it came from, so blocks that
+ * were allocated before are still freed with the functions they were
+ * allocated with.
+ */
+void al_set_allocator(al_alloc_func allocfn, al_free_func freefn, void *userptr) noexcept;
+
 /**
  * Returns non-0 if the allocation function has direct alignment handling.
  * Otherwise, the standard malloc is used with an over-allocation and pointer
@@ -39,6 +54,91 @@ int al_is_sane_alignment_allocator(void) noexcept;
 
 namespace al {
 
+/* A pool for small allocations, carved out of large pages and recycled by
+ * size class. This keeps the many small, long-lived objects a device creates
+ * from fragmenting the heap, and from contending on the heap's lock.
+ */
+struct Arena;
+
+Arena *CreateArena();
+/* Releases the creator's reference. The arena's pages are freed once this is
+ * called and all its blocks are freed.
+ */
+void ReleaseArena(Arena *arena) noexcept;
+
+/* Has the arena also take blocks over 4KB, from 2MB regions mapped with
+ * transparent huge pages when hugepages is true, and preferring the given
+ * NUMA node when numanode isn't -1. Both off (without memory locking) returns
+ * to leaving large blocks to al_malloc's allocator. Returns false if the
+ * system doesn't support it.
+ */
+bool SetArenaLargePolicy(Arena *arena, bool hugepages, int numanode) noexcept;
+
+/* Returns the NUMA node of the CPU the calling thread is running on, or -1 if
+ * unknown.
+ */
+int GetCurrentNumaNode() noexcept;
+
+/* Has the arena lock its memory into RAM when lock is true, faulting in each
+ * page as it's allocated so the mixer never takes a page fault on it. The
+ * arena also takes blocks over 4KB while locking, as with a large block
+ * policy. Returns false if the system doesn't support it.
+ */
+bool SetArenaLocked(Arena *arena, bool lock) noexcept;
+
+/* Returns the number of bytes of the arena's memory that are locked. If
+ * failed isn't null, it's set to the bytes that couldn't be locked, such as
+ * from going over the process's locked memory limit.
+ */
+size_t GetArenaLockedSize(Arena *arena, size_t *failed) noexcept;
+
+/* Returns whether the given memory is in one of the arena's pages, regions,
+ * or locked mappings.
+ */
+bool ArenaContains(Arena *arena, const void *ptr) noexcept;
+
+/* Locks the pages holding the given memory into RAM, faulting them in.
+ * Returns false if they couldn't be locked.
+ */
+bool LockMemory(const void *ptr, size_t size) noexcept;
+void UnlockMemory(const void *ptr, size_t size) noexcept;
+
+/* While in scope, al_malloc on this thread takes small allocations, and large
+ * ones given a large block policy, from the given arena. This includes types
+ * using DEF_NEWDEL and al::allocator.
+ */
+class ArenaScope {
+    Arena *mOldArena;
+
+public:
+    ArenaScope(Arena *arena) noexcept;
+    ~ArenaScope();
+
+    ArenaScope(const ArenaScope&) = delete;
+    ArenaScope& operator=(const ArenaScope&) = delete;
+};
+
+/* Marks the calling thread as mixing while in scope, where it must not touch
+ * the heap. When built with ALSOFT_RT_ALLOC_CHECK, al_malloc, al_free, and the
+ * global operator new and delete log an error with a backtrace when called
+ * in a mixing section. Otherwise this does nothing.
+ */
+class RTSection {
+#ifdef ALSOFT_RT_ALLOC_CHECK
+    bool mOldState;
+
+public:
+    RTSection() noexcept;
+    ~RTSection();
+#else
+public:
+    RTSection() noexcept { }
+#endif
+
+    RTSection(const RTSection&) = delete;
+    RTSection& operator=(const RTSection&) = delete;
+};
+
 template<typename T, size_t alignment=DEF_ALIGN>
 struct allocator : public std::allocator<T> {
     using size_type = size_t;
@@ -314,4 +314,82 @@ inline float fast_roundf(float f) noexcept
 #endif
 }
 
+/**
+ * Converts a float to half-precision (IEEE binary16) bits, rounding to the
+ * nearest even value. Out-of-range values become infinity.
+ */
+inline uint16_t float2half(float f) noexcept
+{
+    union {
+        float f;
+        uint32_t i;
+    } conv;
+
+    conv.f = f;
+    const uint32_t sign{(conv.i>>16) & 0x8000u};
+    const uint32_t absval{conv.i & 0x7fffffffu};
+
+    /* Infinity and NaN (keeping it a quiet NaN). */
+    if(UNLIKELY(absval >= 0x7f800000u))
+        return static_cast<uint16_t>(sign | 0x7c00u | ((absval > 0x7f800000u) ? 0x200u : 0u));
+    /* Anything that rounds to 65520 or higher overflows. */
+    if(UNLIKELY(absval >= 0x477ff000u))
+        return static_cast<uint16_t>(sign | 0x7c00u);
+
+    uint32_t ret, rem, halfway;
+    if(LIKELY(absval >= 0x38800000u))
+    {
+        /* Normal values rebias the exponent and drop 13 mantissa bits. */
+        ret = (absval - 0x38000000u) >> 13;
+        rem = absval & 0x1fffu;
+        halfway = 0x1000u;
+    }
+    else
+    {
+        /* Values under 2^-25 round to 0, otherwise they become denormal. */
+        if(absval <= 0x33000000u)
+            return static_cast<uint16_t>(sign);
+        const uint32_t mant{(absval&0x7fffffu) | 0x800000u};
+        const uint32_t shift{126u - (absval>>23)};
+        ret = mant >> shift;
+        rem = mant & ((1u<<shift) - 1u);
+        halfway = 1u << (shift-1);
+    }
+    /* A carry out of the mantissa correctly increments the exponent. */
+    if(rem > halfway || (rem == halfway && (ret&1u)))
+        ++ret;
+    return static_cast<uint16_t>(sign | ret);
+}
+
+/** Converts half-precision (IEEE binary16) bits to a float. This is exact. */
+inline float half2float(uint16_t h) noexcept
+{
+    union {
+        float f;
+        uint32_t i;
+    } conv;
+
+    const uint32_t sign{(h&0x8000u) << 16};
+    uint32_t expo{(h>>10) & 0x1fu};
+    uint32_t mant{h & 0x3ffu};
+    if(expo == 0x1fu)
+        conv.i = sign | 0x7f800000u | (mant<<13);
+    else if(expo != 0)
+        conv.i = sign | ((expo+112u)<<23) | (mant<<13);
+    else if(mant == 0)
+        conv.i = sign;
+    else
+    {
+        /* Normalize denormals. */
+        expo = 113u;
+        while(!(mant&0x400u))
+        {
+            mant <<= 1;
+            --expo;
+        }
+        conv.i = sign | (expo<<23) | ((mant&0x3ffu)<<13);
+    }
+    return conv.f;
+}
+
 #endif /* AL_NUMERIC_H */
@@ -0,0 +1,204 @@
+
+#include "config.h"
+
+#include "altrace.h"
+
+#ifdef ALSOFT_TRACE
+
+#include <cstdio>
+#include <cstdlib>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+
+#ifdef ALSOFT_TRACE_ITT
+#include <ittnotify.h>
+#endif
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+#endif
+
+
+namespace {
+
+#ifdef ALSOFT_TRACE_CHROME
+
+std::once_flag TraceFileOnce;
+std::mutex TraceFileLock;
+FILE *TraceFile{nullptr};
+long TraceProcessId{0};
+std::atomic<unsigned long> NextTraceThreadId{1u};
+
+/* Opens the trace file on first use, starting its array of events. The array
+ * is never closed, which the trace viewers allow for, so events can be added
+ * until the process exits.
+ */
+FILE *GetTraceFile() noexcept
+{
+    std::call_once(TraceFileOnce, []() -> void
+    {
+        const char *fname{getenv("ALSOFT_TRACE_FILE")};
+        if(!fname || !fname[0]) return;
+
+        TraceFile = fopen(fname, "w");
+        if(!TraceFile)
+        {
+            fprintf(stderr, "AL lib: Failed to open trace file %s\n", fname);
+            return;
+        }
+        fputs("[\n", TraceFile);
+#ifdef _WIN32
+        TraceProcessId = static_cast<long>(GetCurrentProcessId());
+#else
+        TraceProcessId = static_cast<long>(getpid());
+#endif
+    });
+    return TraceFile;
+}
+
+/* Uses the system's thread IDs where possible, to match up with other traces
+ * of the process.
+ */
+unsigned long GetTraceThreadId() noexcept
+{
+#ifdef _WIN32
+    return static_cast<unsigned long>(GetCurrentThreadId());
+#elif defined(__linux__) && defined(SYS_gettid)
+    return static_cast<unsigned long>(syscall(SYS_gettid));
+#else
+    return NextTraceThreadId.fetch_add(1u, std::memory_order_relaxed);
+#endif
+}
+
+double TraceTimeUs(const std::chrono::steady_clock::time_point time) noexcept
+{ return std::chrono::duration<double,std::micro>{time.time_since_epoch()}.count(); }
+
+
+struct TraceEvent {
+    const char *Name;
+    std::chrono::steady_clock::time_point Time;
+    char Phase;
+};
+
+/* Each thread buffers its events, writing them out when the buffer fills and
+ * when the thread ends, so only the writes need to lock.
+ */
+struct ThreadTrace {
+    static constexpr size_t MaxEvents{4096};
+
+    const unsigned long mThreadId{GetTraceThreadId()};
+    size_t mCount{0u};
+    TraceEvent mEvents[MaxEvents];
+
+    ~ThreadTrace() { flush(); }
+
+    void add(const char *name, const char phase) noexcept
+    {
+        if(mCount == MaxEvents)
+            flush();
+        mEvents[mCount++] = TraceEvent{name, std::chrono::steady_clock::now(), phase};
+    }
+
+    void flush() noexcept
+    {
+        std::lock_guard<std::mutex> _{TraceFileLock};
+        for(size_t i{0};i < mCount;++i)
+            fprintf(TraceFile, "{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":%ld,"
+                "\"tid\":%lu},\n", mEvents[i].Name, mEvents[i].Phase,
+                TraceTimeUs(mEvents[i].Time), TraceProcessId, mThreadId);
+        fflush(TraceFile);
+        mCount = 0;
+    }
+};
+
+/* Allocated on a thread's first event, so threads that don't trace don't pay
+ * for the buffer.
+ */
+thread_local std::unique_ptr<ThreadTrace> LocalTrace;
+
+ThreadTrace *GetThreadTrace() noexcept
+{
+    if(!GetTraceFile())
+        return nullptr;
+    if(!LocalTrace)
+        LocalTrace.reset(new (std::nothrow) ThreadTrace{});
+    return LocalTrace.get();
+}
+
+#endif /* ALSOFT_TRACE_CHROME */
+
+#ifdef ALSOFT_TRACE_ITT
+
+__itt_domain *GetTraceDomain() noexcept
+{
+    static __itt_domain *domain{__itt_domain_create("OpenAL Soft")};
+    return domain;
+}
+
+#endif /* ALSOFT_TRACE_ITT */
+
+} // namespace
+
+namespace al {
+
+#ifdef ALSOFT_TRACE_CHROME
+
+TraceName::TraceName(const char *name) noexcept : mName{name}
+{ }
+
+TraceScope::TraceScope(const TraceName &name) noexcept : mName{name}
+{
+    if(ThreadTrace *trace{GetThreadTrace()})
+        trace->add(mName.mName, 'B');
+}
+
+TraceScope::~TraceScope()
+{
+    if(ThreadTrace *trace{GetThreadTrace()})
+        trace->add(mName.mName, 'E');
+}
+
+void TraceThreadName(const char *name) noexcept
+{
+    ThreadTrace *trace{GetThreadTrace()};
+    if(!trace) return;
+
+    std::lock_guard<std::mutex> _{TraceFileLock};
+    fprintf(TraceFile, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%ld,\"tid\":%lu,"
+        "\"args\":{\"name\":\"%s\"}},\n", TraceProcessId, trace->mThreadId, name);
+    fflush(TraceFile);
+}
+
+#endif /* ALSOFT_TRACE_CHROME */
+
+#ifdef ALSOFT_TRACE_ITT
+
+TraceName::TraceName(const char *name) noexcept
+  : mName{name}, mHandle{__itt_string_handle_create(name)}
+{ }
+
+TraceScope::TraceScope(const TraceName &name) noexcept : mName{name}
+{
+    __itt_task_begin(GetTraceDomain(), __itt_null, __itt_null,
+        static_cast<__itt_string_handle*>(mName.mHandle));
+}
+
+TraceScope::~TraceScope()
+{ __itt_task_end(GetTraceDomain()); }
+
+void TraceThreadName(const char *name) noexcept
+{ __itt_thread_set_name(name); }
+
+#endif /* ALSOFT_TRACE_ITT */
+
+} // namespace al
+
+#endif /* ALSOFT_TRACE */
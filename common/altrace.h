@@ -0,0 +1,72 @@
+#ifndef AL_TRACE_H
+#define AL_TRACE_H
+
+/* Begin/end trace events around the mixer's stages and the backends' waits,
+ * for lining up audio stalls with an app's own traces. They're only built in
+ * with the ALSOFT_TRACING CMake option:
+ *
+ * CHROME - Events are written in the Chrome trace event format (for
+ *          chrome://tracing or the Perfetto UI) to the file named by the
+ *          ALSOFT_TRACE_FILE environment variable, if set.
+ * ITT    - Events are sent to Intel's Instrumentation and Tracing Technology
+ *          API (for VTune, etc).
+ *
+ * Otherwise the macros expand to nothing extra.
+ */
+#if defined(ALSOFT_TRACE_CHROME) || defined(ALSOFT_TRACE_ITT)
+#define ALSOFT_TRACE
+
+namespace al {
+
+/* The name of a trace event, created once for each place it's used. */
+class TraceName {
+    const char *mName;
+#ifdef ALSOFT_TRACE_ITT
+    void *mHandle;
+#endif
+
+public:
+    explicit TraceName(const char *name) noexcept;
+
+    friend class TraceScope;
+};
+
+/* Starts an event when constructed, and ends it when destroyed. */
+class TraceScope {
+    const TraceName &mName;
+
+public:
+    explicit TraceScope(const TraceName &name) noexcept;
+    ~TraceScope();
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+};
+
+/* Names the calling thread in the trace. */
+void TraceThreadName(const char *name) noexcept;
+
+} // namespace al
+
+#define AL_TRACE_CONCAT2(a, b) a##b
+#define AL_TRACE_CONCAT(a, b) AL_TRACE_CONCAT2(a, b)
+
+/* Traces the rest of the enclosing scope as the given (string literal) name. */
+#define AL_TRACE_SCOPE(name)                                                  \
+    static const al::TraceName AL_TRACE_CONCAT(trace_name_, __LINE__){name};  \
+    const al::TraceScope AL_TRACE_CONCAT(trace_scope_, __LINE__){             \
+        AL_TRACE_CONCAT(trace_name_, __LINE__)}
+
+/* Traces the evaluation of an expression (e.g. a blocking call), giving its
+ * result.
+ */
+#define AL_TRACE_EXPR(name, expr) ([&]{ AL_TRACE_SCOPE(name); return (expr); }())
+
+#else
+
+#define AL_TRACE_SCOPE(name) ((void)0)
+#define AL_TRACE_EXPR(name, expr) (expr)
+
+#endif
+
+#endif /* AL_TRACE_H */
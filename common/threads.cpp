@@ -22,6 +22,8 @@
 
 #include "threads.h"
 
+#include "altrace.h"
+
 #include <limits>
 #include <system_error>
 
@@ -54,6 +56,9 @@ void althrd_setname(const char *name)
 #else
     (void)name;
 #endif
+#ifdef ALSOFT_TRACE
+    al::TraceThreadName(name);
+#endif
 }
 
 namespace al {
@@ -82,6 +87,20 @@ void semaphore::wait() noexcept
 bool semaphore::try_wait() noexcept
 { return WaitForSingleObject(mSem, 0) == WAIT_OBJECT_0; }
 
+
+wakeup_handle::wakeup_handle()
+{
+    mHandle = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+    if(mHandle == nullptr)
+        throw std::system_error(std::make_error_code(std::errc::resource_unavailable_try_again));
+}
+
+wakeup_handle::~wakeup_handle()
+{ CloseHandle(mHandle); }
+
+void wakeup_handle::signal() noexcept
+{ SetEvent(mHandle); }
+
 } // namespace al
 
 #else
@@ -91,6 +110,10 @@ bool semaphore::try_wait() noexcept
 #ifdef HAVE_PTHREAD_NP_H
 #include <pthread_np.h>
 #endif
+#ifdef HAVE_SYS_EVENTFD_H
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
 
 void althrd_setname(const char *name)
 {
@@ -107,6 +130,9 @@ void althrd_setname(const char *name)
 #else
     (void)name;
 #endif
+#ifdef ALSOFT_TRACE
+    al::TraceThreadName(name);
+#endif
 }
 
 namespace al {
@@ -160,6 +186,38 @@ bool semaphore::try_wait() noexcept
 
 #endif /* __APPLE__ */
 
+
+#ifdef HAVE_SYS_EVENTFD_H
+
+wakeup_handle::wakeup_handle()
+{
+    mHandle = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if(mHandle == -1)
+        throw std::system_error(errno, std::generic_category());
+}
+
+wakeup_handle::~wakeup_handle()
+{ close(mHandle); }
+
+void wakeup_handle::signal() noexcept
+{
+    /* If the counter is somehow saturated, the handle is already ready. */
+    const uint64_t one{1u};
+    ssize_t ret{write(mHandle, &one, sizeof(one))};
+    (void)ret;
+}
+
+#else
+
+wakeup_handle::wakeup_handle() : mHandle{-1}
+{ throw std::system_error(std::make_error_code(std::errc::function_not_supported)); }
+
+wakeup_handle::~wakeup_handle() = default;
+
+void wakeup_handle::signal() noexcept { }
+
+#endif /* HAVE_SYS_EVENTFD_H */
+
 } // namespace al
 
 #endif /* _WIN32 */
@@ -50,6 +50,37 @@ public:
     bool try_wait() noexcept;
 };
 
+/* A handle an application can wait on with its own event loop (e.g. epoll or
+ * WaitForMultipleObjects), which becomes ready when signaled. It's an eventfd
+ * where available, and an auto-reset event on Windows. Construction throws if
+ * the system has neither.
+ */
+class wakeup_handle {
+public:
+#ifdef _WIN32
+    using native_type = HANDLE;
+#else
+    using native_type = int;
+#endif
+
+private:
+    native_type mHandle;
+
+public:
+    wakeup_handle();
+    wakeup_handle(const wakeup_handle&) = delete;
+    ~wakeup_handle();
+
+    wakeup_handle& operator=(const wakeup_handle&) = delete;
+
+    native_type native_handle() const noexcept { return mHandle; }
+
+    /* Makes the handle ready. Safe to call from the mixer, as it never
+     * blocks.
+     */
+    void signal() noexcept;
+};
+
 } // namespace al
 
 #endif /* AL_THREADS_H */
@@ -109,6 +109,7 @@ LPALCGETINTEGER64VSOFT alcGetInteger64vSOFT;
 LPALBUFFERSTORAGESOFT alBufferStorageSOFT;
 LPALMAPBUFFERSOFT alMapBufferSOFT;
 LPALUNMAPBUFFERSOFT alUnmapBufferSOFT;
+LPALFLUSHMAPPEDBUFFERSOFT alFlushMappedBufferSOFT;
 #endif
 
 #ifdef AL_SOFT_events
@@ -299,6 +300,7 @@ struct AudioState {
 
     int getSync();
     int decodeFrame();
+    int convertFrame(uint8_t *samples);
     bool readAudio(uint8_t *samples, int length);
 
     int handler();
@@ -574,26 +576,28 @@ int AudioState::decodeFrame()
                 seconds_d64(av_q2d(mStream->time_base)*mDecodedFrame->best_effort_timestamp)
             );
 
-        if(mDecodedFrame->nb_samples > mSamplesMax)
-        {
-            av_freep(&mSamples);
-            av_samples_alloc(
-                &mSamples, nullptr, mCodecCtx->channels,
-                mDecodedFrame->nb_samples, mDstSampleFmt, 0
-            );
-            mSamplesMax = mDecodedFrame->nb_samples;
-        }
-        /* Return the amount of sample frames converted */
-        int data_size{swr_convert(mSwresCtx.get(), &mSamples, mDecodedFrame->nb_samples,
-            const_cast<const uint8_t**>(mDecodedFrame->data), mDecodedFrame->nb_samples)};
-
-        av_frame_unref(mDecodedFrame.get());
-        return data_size;
+        /* Return the amount of sample frames decoded, leaving the frame to be
+         * converted.
+         */
+        return mDecodedFrame->nb_samples;
     }
 
     return 0;
 }
 
+/* Converts the decoded frame to the output format, writing its samples to the
+ * given buffer, which must have room for them. Returns the amount of sample
+ * frames converted.
+ */
+int AudioState::convertFrame(uint8_t *samples)
+{
+    int data_size{swr_convert(mSwresCtx.get(), &samples, mDecodedFrame->nb_samples,
+        const_cast<const uint8_t**>(mDecodedFrame->data), mDecodedFrame->nb_samples)};
+
+    av_frame_unref(mDecodedFrame.get());
+    return data_size;
+}
+
 /* Duplicates the sample at in to out, count times. The frame size is a
  * multiple of the template type size.
  */
@@ -636,6 +640,35 @@ bool AudioState::readAudio(uint8_t *samples, int length)
             int frame_len = decodeFrame();
             if(frame_len <= 0) break;
 
+            /* Without any samples to skip or duplicate, a frame that fits in
+             * the output is converted straight into it, which is the buffer's
+             * own storage when mapped.
+             */
+            if(sample_skip == 0 && frame_len <= length-audio_size)
+            {
+                frame_len = convertFrame(samples);
+                if(frame_len <= 0) break;
+
+                mSamplesLen = 0;
+                mSamplesPos = 0;
+                mCurrentPts += nanoseconds(seconds(frame_len)) / mCodecCtx->sample_rate;
+                samples += frame_len*mFrameSize;
+                audio_size += frame_len;
+                continue;
+            }
+
+            if(frame_len > mSamplesMax)
+            {
+                av_freep(&mSamples);
+                av_samples_alloc(
+                    &mSamples, nullptr, mCodecCtx->channels,
+                    frame_len, mDstSampleFmt, 0
+                );
+                mSamplesMax = frame_len;
+            }
+            frame_len = convertFrame(mSamples);
+            if(frame_len <= 0) break;
+
             mSamplesLen = frame_len;
             mSamplesPos = std::min(mSamplesLen, sample_skip);
             sample_skip -= mSamplesPos;
@@ -908,6 +941,8 @@ int AudioState::handler()
         }
     }
     void *samples = nullptr;
+    /* Persistently mapped storage of each buffer, if used instead of samples. */
+    std::vector<uint8_t*> mapped;
     ALsizei buffer_len = std::chrono::duration_cast<std::chrono::duration<int>>(
         mCodecCtx->sample_rate * AudioBufferTime).count() * mFrameSize;
 
@@ -975,14 +1010,30 @@ int AudioState::handler()
         goto finish;
 
 #ifdef AL_SOFT_map_buffer
+    /* Map the buffers persistently, so the audio is decoded straight into
+     * their storage and they can be queued while mapped.
+     */
     if(alBufferStorageSOFT)
     {
+        const ALbitfieldSOFT access{AL_MAP_WRITE_BIT_SOFT | AL_MAP_PERSISTENT_BIT_SOFT};
         for(ALuint bufid : mBuffers)
             alBufferStorageSOFT(bufid, mFormat, nullptr, buffer_len, mCodecCtx->sample_rate,
-                                AL_MAP_WRITE_BIT_SOFT);
-        if(alGetError() != AL_NO_ERROR)
+                                access);
+        if(alGetError() == AL_NO_ERROR)
+        {
+            for(ALuint bufid : mBuffers)
+                mapped.emplace_back(static_cast<uint8_t*>(
+                    alMapBufferSOFT(bufid, 0, buffer_len, access)));
+        }
+        if(alGetError() != AL_NO_ERROR || mapped.empty())
         {
             fprintf(stderr, "Failed to use mapped buffers\n");
+            for(size_t i{0};i < mapped.size();++i)
+            {
+                if(mapped[i])
+                    alUnmapBufferSOFT(mBuffers[i]);
+            }
+            mapped.clear();
             samples = av_malloc(buffer_len);
         }
     }
@@ -1013,7 +1064,7 @@ int AudioState::handler()
 
             uint8_t *ptr = reinterpret_cast<uint8_t*>(samples
 #ifdef AL_SOFT_map_buffer
-                ? samples : alMapBufferSOFT(bufid, 0, buffer_len, AL_MAP_WRITE_BIT_SOFT)
+                ? samples : mapped[mBufferIdx]
 #endif
             );
             if(!ptr) break;
@@ -1021,10 +1072,12 @@ int AudioState::handler()
             /* Read the next chunk of data, filling the buffer, and queue it on
              * the source */
             bool got_audio = readAudio(ptr, buffer_len);
+            if(!got_audio) break;
 #ifdef AL_SOFT_map_buffer
-            if(!samples) alUnmapBufferSOFT(bufid);
+            /* Make the written samples visible to the mixer. */
+            if(!samples && alFlushMappedBufferSOFT)
+                alFlushMappedBufferSOFT(bufid, 0, buffer_len);
 #endif
-            if(!got_audio) break;
 
             if(samples)
                 alBufferData(bufid, mFormat, samples, buffer_len, mCodecCtx->sample_rate);
@@ -1076,6 +1129,13 @@ int AudioState::handler()
     alSourcei(mSource, AL_BUFFER, 0);
 
 finish:
+#ifdef AL_SOFT_map_buffer
+    for(size_t i{0};i < mapped.size();++i)
+    {
+        if(mapped[i])
+            alUnmapBufferSOFT(mBuffers[i]);
+    }
+#endif
     av_freep(&samples);
     srclock.unlock();
 
@@ -1823,6 +1883,8 @@ int main(int argc, char *argv[])
             alGetProcAddress("alMapBufferSOFT"));
         alUnmapBufferSOFT = reinterpret_cast<LPALUNMAPBUFFERSOFT>(
             alGetProcAddress("alUnmapBufferSOFT"));
+        alFlushMappedBufferSOFT = reinterpret_cast<LPALFLUSHMAPPEDBUFFERSOFT>(
+            alGetProcAddress("alFlushMappedBufferSOFT"));
     }
 #endif
 #ifdef AL_SOFT_events
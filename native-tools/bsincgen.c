@@ -59,10 +59,10 @@
 #define BSINC_SCALE_COUNT (16)
 #define BSINC_PHASE_COUNT (16)
 
-/* 48 points includes the doubling for downsampling, so the maximum number of
- * base sample points is 24, which is 23rd order.
+/* 64 points includes the doubling for downsampling, so the maximum number of
+ * base sample points is 32, which is 31st order.
  */
-#define BSINC_POINTS_MAX (48)
+#define BSINC_POINTS_MAX (64)
 
 static double MinDouble(double a, double b)
 { return (a <= b) ? a : b; }
@@ -347,13 +347,16 @@ int main(int argc, char *argv[])
     fprintf(output, "/* Generated by bsincgen, do not edit! */\n\n"
 "static_assert(BSINC_SCALE_COUNT == %d, \"Unexpected BSINC_SCALE_COUNT value!\");\n"
 "static_assert(BSINC_PHASE_COUNT == %d, \"Unexpected BSINC_PHASE_COUNT value!\");\n"
-"static_assert(FRACTIONONE == %d, \"Unexpected FRACTIONONE value!\");\n\n"
+"static_assert(FRACTIONONE == %d, \"Unexpected FRACTIONONE value!\");\n"
+"static_assert(BSINC_POINTS_MAX == %d, \"Unexpected BSINC_POINTS_MAX value!\");\n\n"
 "struct BSincTable {\n"
 "    const float scaleBase, scaleRange;\n"
 "    const int m[BSINC_SCALE_COUNT];\n"
 "    const int filterOffset[BSINC_SCALE_COUNT];\n"
 "    const float *Tab;\n"
-"};\n\n", BSINC_SCALE_COUNT, BSINC_PHASE_COUNT, FRACTIONONE);
+"};\n\n", BSINC_SCALE_COUNT, BSINC_PHASE_COUNT, FRACTIONONE, BSINC_POINTS_MAX);
+    /* A 31st order filter with a -80dB drop at nyquist. */
+    BsiGenerateTables(output, "bsinc32", 80.0, 31);
     /* A 23rd order filter with a -60dB drop at nyquist. */
     BsiGenerateTables(output, "bsinc24", 60.0, 23);
     /* An 11th order filter with a -40dB drop at nyquist. */
@@ -8,10 +8,10 @@
 #include <string.h>
 
 #include <algorithm>
+#include <new>
 
 #include "AL/alc.h"
 #include "AL/al.h"
-#include "almalloc.h"
 
 #include "version.h"
 
@@ -355,53 +355,47 @@ void LoadDriverList(void)
 PtrIntMap::~PtrIntMap()
 {
     std::lock_guard<std::mutex> maplock{mLock};
-    al_free(mKeys);
-    mKeys = nullptr;
-    mValues = nullptr;
-    mSize = 0;
-    mCapacity = 0;
+    delete mTable.exchange(nullptr);
+    mRetired.clear();
+}
+
+/* Replaces the current table. Must be called with the map lock held. */
+void PtrIntMap::publish(std::unique_ptr<Table> table)
+{
+    Table *oldtable{mTable.exchange(table.release())};
+    mGeneration.fetch_add(1u, std::memory_order_release);
+    if(oldtable)
+        mRetired.emplace_back(oldtable);
+
+    /* A lookup that starts after this sees the new table, so the replaced
+     * ones can be freed once no lookups are active.
+     */
+    if(mReaders.load() == 0)
+        mRetired.clear();
 }
 
 ALenum PtrIntMap::insert(ALvoid *key, ALint value)
 {
     std::lock_guard<std::mutex> maplock{mLock};
-    auto iter = std::lower_bound(mKeys, mKeys+mSize, key);
-    auto pos = static_cast<ALsizei>(std::distance(mKeys, iter));
+    try {
+        const Table *cur{mTable.load(std::memory_order_relaxed)};
+        std::unique_ptr<Table> table{cur ? new Table{*cur} : new Table{}};
 
-    if(pos == mSize || mKeys[pos] != key)
-    {
-        if(mSize == mCapacity)
+        auto iter = std::lower_bound(table->mKeys.begin(), table->mKeys.end(), key);
+        auto pos = static_cast<size_t>(std::distance(table->mKeys.begin(), iter));
+        if(iter == table->mKeys.end() || *iter != key)
         {
-            ALvoid **newkeys{nullptr};
-            ALsizei newcap{mCapacity ? (mCapacity<<1) : 4};
-            if(newcap > mCapacity)
-                newkeys = static_cast<ALvoid**>(
-                    al_calloc(16, (sizeof(mKeys[0])+sizeof(mValues[0]))*newcap)
-                );
-            if(!newkeys)
-                return AL_OUT_OF_MEMORY;
-            auto newvalues = reinterpret_cast<ALint*>(&newkeys[newcap]);
-
-            if(mKeys)
-            {
-                std::copy_n(mKeys, mSize, newkeys);
-                std::copy_n(mValues, mSize, newvalues);
-            }
-            al_free(mKeys);
-            mKeys = newkeys;
-            mValues = newvalues;
-            mCapacity = newcap;
+            table->mKeys.insert(iter, key);
+            table->mValues.insert(table->mValues.begin()+static_cast<ptrdiff_t>(pos), value);
         }
+        else
+            table->mValues[pos] = value;
 
-        if(pos < mSize)
-        {
-            std::copy_backward(mKeys+pos, mKeys+mSize, mKeys+mSize+1);
-            std::copy_backward(mValues+pos, mValues+mSize, mValues+mSize+1);
-        }
-        mSize++;
+        publish(std::move(table));
+    }
+    catch(std::bad_alloc&) {
+        return AL_OUT_OF_MEMORY;
     }
-    mKeys[pos] = key;
-    mValues[pos] = value;
 
     return AL_NO_ERROR;
 }
@@ -411,17 +405,26 @@ ALint PtrIntMap::removeByKey(ALvoid *key)
     ALint ret = -1;
 
     std::lock_guard<std::mutex> maplock{mLock};
-    auto iter = std::lower_bound(mKeys, mKeys+mSize, key);
-    auto pos = static_cast<ALsizei>(std::distance(mKeys, iter));
-    if(pos < mSize && mKeys[pos] == key)
-    {
-        ret = mValues[pos];
-        if(pos+1 < mSize)
-        {
-            std::copy(mKeys+pos+1, mKeys+mSize, mKeys+pos);
-            std::copy(mValues+pos+1, mValues+mSize, mValues+pos);
-        }
-        mSize--;
+    const Table *cur{mTable.load(std::memory_order_relaxed)};
+    if(!cur) return ret;
+
+    auto iter = std::lower_bound(cur->mKeys.begin(), cur->mKeys.end(), key);
+    if(iter == cur->mKeys.end() || *iter != key)
+        return ret;
+    auto pos = static_cast<size_t>(std::distance(cur->mKeys.begin(), iter));
+    ret = cur->mValues[pos];
+
+    try {
+        std::unique_ptr<Table> table{new Table{*cur}};
+        table->mKeys.erase(table->mKeys.begin()+static_cast<ptrdiff_t>(pos));
+        table->mValues.erase(table->mValues.begin()+static_cast<ptrdiff_t>(pos));
+        publish(std::move(table));
+    }
+    catch(std::bad_alloc&) {
+        /* Leave the key mapped rather than fail; the caller is done with it
+         * either way, and a stale entry is only a missed error check.
+         */
+        ERR("Failed to remove %p from the map\n", key);
     }
 
     return ret;
@@ -429,13 +432,29 @@ ALint PtrIntMap::removeByKey(ALvoid *key)
 
 ALint PtrIntMap::lookupByKey(ALvoid *key)
 {
+    struct LastLookup {
+        const PtrIntMap *map;
+        ALvoid *key;
+        ALint value;
+        ALuint generation;
+    };
+    static thread_local LastLookup last{nullptr, nullptr, -1, 0u};
+
+    const ALuint generation{mGeneration.load(std::memory_order_acquire)};
+    if(last.map == this && last.key == key && last.generation == generation)
+        return last.value;
+
     ALint ret = -1;
 
-    std::lock_guard<std::mutex> maplock{mLock};
-    auto iter = std::lower_bound(mKeys, mKeys+mSize, key);
-    auto pos = static_cast<ALsizei>(std::distance(mKeys, iter));
-    if(pos < mSize && mKeys[pos] == key)
-        ret = mValues[pos];
+    mReaders.fetch_add(1u);
+    if(const Table *table{mTable.load()})
+    {
+        auto iter = std::lower_bound(table->mKeys.begin(), table->mKeys.end(), key);
+        if(iter != table->mKeys.end() && *iter == key)
+            ret = table->mValues[static_cast<size_t>(std::distance(table->mKeys.begin(), iter))];
+    }
+    mReaders.fetch_sub(1u, std::memory_order_release);
 
+    last = LastLookup{this, key, ret, generation};
     return ret;
 }
@@ -10,6 +10,7 @@
 #include <vector>
 #include <string>
 #include <atomic>
+#include <memory>
 #include <mutex>
 
 #include "AL/alc.h"
@@ -151,15 +152,29 @@ extern thread_local DriverIface *ThreadCtxDriver;
 extern std::atomic<DriverIface*> CurrentCtxDriver;
 
 
+/* Maps pointers to driver indices. Lookups are lock-free, since they happen
+ * for most ALC calls: the map is kept as an immutable sorted table that
+ * changes replace with an updated copy. Replaced tables are freed once no
+ * lookup is using them. Each thread also remembers its last lookup, which
+ * stays valid until the map changes.
+ */
 class PtrIntMap {
-    ALvoid **mKeys{nullptr};
-    /* Shares memory with keys. */
-    ALint *mValues{nullptr};
-
-    ALsizei mSize{0};
-    ALsizei mCapacity{0};
+    struct Table {
+        std::vector<ALvoid*> mKeys;
+        std::vector<ALint> mValues;
+    };
+
+    std::atomic<Table*> mTable{nullptr};
+    /* Incremented after each change, to invalidate remembered lookups. */
+    std::atomic<ALuint> mGeneration{0u};
+    std::atomic<ALuint> mReaders{0u};
+
+    /* Replaced tables that lookups may still be using. */
+    std::vector<std::unique_ptr<Table>> mRetired;
     std::mutex mLock;
 
+    void publish(std::unique_ptr<Table> table);
+
 public:
     PtrIntMap() = default;
     ~PtrIntMap();
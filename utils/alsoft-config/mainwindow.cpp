@@ -6,8 +6,11 @@
 #include <iostream>
 #include <cmath>
 
+#include <QApplication>
 #include <QFileDialog>
+#include <QFileInfo>
 #include <QMessageBox>
+#include <QProcess>
 #include <QCloseEvent>
 #include <QSettings>
 #include <QtGlobal>
@@ -23,6 +26,9 @@ static const struct {
 #ifdef HAVE_JACK
     { "jack", "JACK" },
 #endif
+#ifdef HAVE_PIPEWIRE
+    { "pipewire", "PipeWire" },
+#endif
 #ifdef HAVE_PULSEAUDIO
     { "pulse", "PulseAudio" },
 #endif
@@ -56,6 +62,9 @@ static const struct {
 #ifdef HAVE_PORTAUDIO
     { "port", "PortAudio" },
 #endif
+#ifdef HAVE_AAUDIO
+    { "aaudio", "AAudio" },
+#endif
 #ifdef HAVE_OPENSL
     { "opensl", "OpenSL" },
 #endif
@@ -103,6 +112,7 @@ static const struct NameValuePair {
     { "Cubic Spline", "cubic" },
     { "11th order Sinc", "bsinc12" },
     { "23rd order Sinc", "bsinc24" },
+    { "31st order Sinc", "bsinc32" },
 
     { "", "" }
 }, stereoModeList[] = {
@@ -330,6 +340,7 @@ MainWindow::MainWindow(QWidget *parent) :
     connect(ui->actionSave_As, SIGNAL(triggered()), this, SLOT(saveConfigAsFile()));
 
     connect(ui->actionAbout, SIGNAL(triggered()), this, SLOT(showAboutPage()));
+    connect(ui->actionMeasure, SIGNAL(triggered()), this, SLOT(measurePerformance()));
 
     connect(ui->closeCancelButton, SIGNAL(clicked()), this, SLOT(cancelCloseAction()));
     connect(ui->applyButton, SIGNAL(clicked()), this, SLOT(saveCurrentConfig()));
@@ -494,6 +505,95 @@ void MainWindow::showAboutPage()
 }
 
 
+/* Runs openal-info's benchmark, and offers to apply the resampler and HRTF
+ * mode it recommends.
+ */
+void MainWindow::measurePerformance()
+{
+    QString program = QCoreApplication::applicationDirPath() + "/openal-info";
+#ifdef Q_OS_WIN32
+    program += ".exe";
+#endif
+    if(!QFileInfo(program).exists())
+        program = "openal-info";
+
+    QProcess proc;
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    proc.start(program, QStringList() << "--perf");
+    const bool finished = proc.waitForFinished(60000);
+    QApplication::restoreOverrideCursor();
+    if(!finished || proc.exitStatus() != QProcess::NormalExit || proc.exitCode() != 0)
+    {
+        QMessageBox::warning(this, tr("Measure Performance"),
+            tr("Failed to run %1.").arg(program));
+        return;
+    }
+
+    const QString output = QString::fromLocal8Bit(proc.readAllStandardOutput());
+    QString resampler, hrtf;
+    bool recommended = false;
+    foreach(const QString &line, output.split('\n'))
+    {
+        if(line.startsWith("Recommended settings"))
+        {
+            recommended = true;
+            continue;
+        }
+        if(!recommended)
+            continue;
+
+        const QStringList parts = line.split('=');
+        if(parts.size() != 2)
+            continue;
+        if(parts[0].trimmed() == "resampler")
+            resampler = parts[1].trimmed();
+        else if(parts[0].trimmed() == "hrtf")
+            hrtf = parts[1].trimmed();
+    }
+    if(resampler.isEmpty())
+    {
+        QMessageBox::warning(this, tr("Measure Performance"),
+            tr("%1 gave no recommended settings.").arg(program));
+        return;
+    }
+
+    /* A newer or older library may recommend a resampler this list doesn't
+     * know, which can't be applied.
+     */
+    QString resamplerName = getNameFromValue(resamplerList, resampler);
+    if(resamplerName.isEmpty())
+    {
+        QMessageBox::warning(this, tr("Measure Performance"),
+            tr("%1 recommended an unknown resampler (%2).").arg(program, resampler));
+        return;
+    }
+    QString text = tr("Recommended resampler: %1").arg(resamplerName);
+    if(!hrtf.isEmpty())
+        text += tr("\nRecommended HRTF mode: %1").arg((hrtf == "false") ?
+            tr("Force off") : tr("Application preference"));
+    QMessageBox box(QMessageBox::Question, tr("Measure Performance"), text,
+        QMessageBox::Apply | QMessageBox::Cancel, this);
+    box.setInformativeText(tr("Apply these settings, measured on this machine?"));
+    box.setDetailedText(output);
+    if(box.exec() != QMessageBox::Apply)
+        return;
+
+    for(int i = 0;resamplerList[i].name[0];i++)
+    {
+        if(resampler == resamplerList[i].value)
+        {
+            ui->resamplerSlider->setValue(i);
+            break;
+        }
+    }
+    if(hrtf == "false")
+        ui->hrtfStateComboBox->setCurrentIndex(2);
+    else if(hrtf == "auto")
+        ui->hrtfStateComboBox->setCurrentIndex(0);
+    enableApplyButton();
+}
+
+
 QStringList MainWindow::collectHrtfs()
 {
     QStringList ret;
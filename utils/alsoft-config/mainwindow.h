@@ -26,6 +26,8 @@ private slots:
 
     void showAboutPage();
 
+    void measurePerformance();
+
     void enableApplyButton();
 
     void updateResamplerLabel(int num);
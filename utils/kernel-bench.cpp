@@ -0,0 +1,564 @@
+/*
+ * OpenAL Mixer Kernel Benchmark Utility
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/* Times each specialization of the mixer kernels this CPU can run, and checks
+ * its output against the C version. The filters, which only have one version,
+ * are checked against a double-precision or unfused equivalent instead. Each
+ * result is printed as a line of JSON, and the exit code is non-zero if any
+ * check fails.
+ */
+
+#include "config.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include "alMain.h"
+#include "alu.h"
+#include "alBuffer.h"
+#include "hrtf.h"
+#include "cpu_caps.h"
+#include "fpu_modes.h"
+#include "mixer/defs.h"
+#include "mixer/kernels.h"
+#include "filters/biquad.h"
+#include "filters/nfc.h"
+#include "filters/splitter.h"
+
+#include "getopt.h"
+
+
+namespace {
+
+int NumRuns{256};
+const char *KernelFilter{nullptr};
+bool CheckFailed{false};
+
+/* A small LCG, so every run uses the same inputs. */
+unsigned int RandState{22222u};
+float RandFloat()
+{
+    RandState = RandState*1664525u + 1013904223u;
+    return static_cast<float>(RandState>>8)/8388608.0f - 1.0f;
+}
+
+
+/* Inputs and outputs for the kernels. */
+struct BenchData {
+    alignas(16) ALfloat Source[BUFFERSIZE*2 + MAX_RESAMPLE_PADDING*2];
+    alignas(16) ALfloat Input[4][BUFFERSIZE];
+    alignas(16) ALfloat Output[4][BUFFERSIZE];
+    alignas(16) ALfloat HrtfSource[BUFFERSIZE + HRTF_HISTORY_LENGTH];
+    alignas(16) float2 Accum[BUFFERSIZE + HRIR_LENGTH];
+    alignas(16) HrirArray<ALfloat> Coeffs;
+    HrtfParams OldParams;
+    alignas(16) ALshort PCM[BUFFERSIZE*2];
+    alignas(16) ALushort Half[BUFFERSIZE];
+
+    DEF_NEWDEL(BenchData)
+};
+
+
+/* Returns the best time of several trials of NumRuns calls, in nanoseconds. */
+template<typename F>
+double TimeRuns(F func)
+{
+    using clock = std::chrono::steady_clock;
+    auto best = clock::duration::max();
+    for(int trial{0};trial < 5;++trial)
+    {
+        const auto start = clock::now();
+        for(int i{0};i < NumRuns;++i)
+            func();
+        best = std::min(best, clock::now() - start);
+    }
+    return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        best).count()) / NumRuns;
+}
+
+/* Largest difference of out from ref, relative to ref's peak (or 1). */
+double GetError(const std::vector<double> &ref, const std::vector<double> &out)
+{
+    double peak{1.0}, err{0.0};
+    for(const double val : ref)
+        peak = std::max(peak, std::abs(val));
+    for(size_t i{0};i < ref.size();++i)
+    {
+        const double diff{std::abs(out[i] - ref[i])};
+        /* Catches NaNs too. */
+        if(!(diff <= err)) err = diff;
+    }
+    return err / peak;
+}
+
+bool IsSelected(const char *name)
+{ return !KernelFilter || strstr(name, KernelFilter) != nullptr; }
+
+void PrintResult(const char *kernel, const char *impl, const double ns, const int samples,
+    const double error)
+{
+    static constexpr double MaxError{1e-4};
+
+    const bool ok{error <= MaxError};
+    printf("{\"kernel\": \"%s\", \"impl\": \"%s\", \"ns_per_call\": %.1f, "
+        "\"ns_per_sample\": %.3f, \"max_error\": %g, \"ok\": %s}\n", kernel, impl, ns,
+        ns / samples, error, ok ? "true" : "false");
+    if(!ok) CheckFailed = true;
+}
+
+/* Benchmarks each option of a kernel. reset prepares the inputs and state,
+ * run calls the given function, and result gets the output to compare with
+ * the C version's.
+ */
+template<typename T, typename ResetF, typename RunF, typename ResultF>
+void BenchKernel(const char *kernel, const KernelList<T> &list, const int samples,
+    ResetF reset, RunF run, ResultF result)
+{
+    if(!IsSelected(kernel))
+        return;
+
+    /* The C version is always last. */
+    reset();
+    run((list.end()-1)->func);
+    const std::vector<double> ref{result()};
+
+    for(const auto &option : list)
+    {
+        reset();
+        run(option.func);
+        const double error{GetError(ref, result())};
+
+        reset();
+        const double ns{TimeRuns([&run,&option]() -> void { run(option.func); })};
+        PrintResult(kernel, option.name, ns, samples, error);
+    }
+}
+
+template<size_t N>
+void AppendSamples(std::vector<double> &out, const ALfloat (&data)[N], const int count)
+{ out.insert(out.end(), std::begin(data), std::begin(data)+count); }
+
+
+void BenchMixers(BenchData *d, const int todo)
+{
+    ALfloat current[2];
+    BenchKernel("mix", GetMixerOptions(), todo,
+        [d,&current]() -> void
+        {
+            current[0] = 0.5f; current[1] = 0.25f;
+            std::fill(&d->Output[0][0], &d->Output[0][0] + 4*BUFFERSIZE, 0.0f);
+        },
+        [d,todo,&current](MixerFunc func) -> void
+        {
+            const ALfloat target[2]{0.25f, 0.5f};
+            func(d->Input[0], 2, d->Output, current, target, todo/2, 0, todo);
+        },
+        [d,todo]() -> std::vector<double>
+        {
+            std::vector<double> out;
+            AppendSamples(out, d->Output[0], todo);
+            AppendSamples(out, d->Output[1], todo);
+            return out;
+        });
+
+    BenchKernel("row", GetRowMixerOptions(), todo,
+        [d]() -> void { std::fill(std::begin(d->Output[0]), std::end(d->Output[0]), 0.0f); },
+        [d,todo](RowMixerFunc func) -> void
+        {
+            const ALfloat gains[4]{0.5f, 0.25f, -0.25f, 0.125f};
+            func(d->Output[0], gains, d->Input, 4, 0, todo);
+        },
+        [d,todo]() -> std::vector<double>
+        {
+            std::vector<double> out;
+            AppendSamples(out, d->Output[0], todo);
+            return out;
+        });
+}
+
+void BenchHrtfMixers(BenchData *d, const int todo)
+{
+    MixHrtfParams hrtfparams{};
+    hrtfparams.Coeffs = &d->Coeffs;
+    hrtfparams.Delay[0] = 8;
+    hrtfparams.Delay[1] = 2;
+
+    auto reset = [d,todo,&hrtfparams]() -> void
+    {
+        hrtfparams.Gain = 0.25f;
+        hrtfparams.GainStep = 0.5f / static_cast<ALfloat>(todo);
+        std::fill(std::begin(d->Accum), std::end(d->Accum), float2{});
+        std::fill(std::begin(d->Output[0]), std::end(d->Output[0]), 0.0f);
+        std::fill(std::begin(d->Output[1]), std::end(d->Output[1]), 0.0f);
+    };
+    auto result = [d,todo]() -> std::vector<double>
+    {
+        std::vector<double> out;
+        AppendSamples(out, d->Output[0], todo);
+        AppendSamples(out, d->Output[1], todo);
+        return out;
+    };
+
+    BenchKernel("hrtf", GetHrtfMixerOptions(), todo, reset,
+        [d,todo,&hrtfparams](HrtfMixerFunc func) -> void
+        {
+            func(d->Output[0], d->Output[1], d->HrtfSource, d->Accum, 0, HRIR_LENGTH/2,
+                &hrtfparams, todo);
+        }, result);
+
+    BenchKernel("hrtfblend", GetHrtfBlendMixerOptions(), todo, reset,
+        [d,todo,&hrtfparams](HrtfMixerBlendFunc func) -> void
+        {
+            func(d->Output[0], d->Output[1], d->HrtfSource, d->Accum, 0, HRIR_LENGTH/2,
+                &d->OldParams, &hrtfparams, todo);
+        }, result);
+
+    std::unique_ptr<DirectHrtfState> state{DirectHrtfState::Create(4)};
+    state->IrSize = HRIR_LENGTH/2;
+    for(size_t c{0};c < 4;++c)
+    {
+        for(size_t i{0};i < state->Chan[c].Coeffs.size();++i)
+        {
+            state->Chan[c].Coeffs[i][0] = RandFloat() / static_cast<ALfloat>(i+1);
+            state->Chan[c].Coeffs[i][1] = RandFloat() / static_cast<ALfloat>(i+1);
+        }
+    }
+    DirectHrtfState *dstate{state.get()};
+    BenchKernel("directhrtf", GetDirectHrtfMixerOptions(), todo,
+        [d,dstate]() -> void
+        {
+            std::fill(dstate->Values.begin(), dstate->Values.end(), float2{});
+            std::fill(std::begin(d->Output[0]), std::end(d->Output[0]), 0.0f);
+            std::fill(std::begin(d->Output[1]), std::end(d->Output[1]), 0.0f);
+        },
+        [d,todo,dstate](HrtfDirectMixerFunc func) -> void
+        { func(d->Output[0], d->Output[1], d->Input, d->Accum, dstate, 4, todo); },
+        result);
+}
+
+void BenchResamplers(BenchData *d, const int todo)
+{
+    static constexpr const char *Names[ResamplerKernelCount]{
+        "resample_point", "resample_linear", "resample_cubic", "resample_bsinc",
+        "resample_fastbsinc"
+    };
+
+    /* Upsample 44.1khz to 48khz, except for the scaled bsinc kernel which is
+     * only used for downsampling.
+     */
+    const ALuint upinc{static_cast<ALuint>(44100.0 / 48000.0 * FRACTIONONE)};
+    const ALuint downinc{FRACTIONONE*3/2};
+    for(size_t kernel{0};kernel < ResamplerKernelCount;kernel++)
+    {
+        const ALuint increment{(kernel == BSincKernel) ? downinc : upinc};
+        InterpState state{};
+        BsincPrepare(increment, &state.bsinc, &bsinc24);
+
+        const ALfloat *output{nullptr};
+        BenchKernel(Names[kernel], GetResamplerOptions(static_cast<ResamplerKernel>(kernel)),
+            todo,
+            [d]() -> void { std::fill(std::begin(d->Output[0]), std::end(d->Output[0]), 0.0f); },
+            [d,todo,increment,&state,&output](ResamplerFunc func) -> void
+            {
+                output = func(&state, &d->Source[MAX_RESAMPLE_PADDING], FRACTIONONE/3,
+                    static_cast<ALint>(increment), d->Output[0], todo);
+            },
+            [todo,&output]() -> std::vector<double>
+            { return std::vector<double>(output, output+todo); });
+    }
+}
+
+void BenchBiquads(BenchData *d, const int todo)
+{
+    BiquadFilter proto;
+    proto.setParams(BiquadType::HighShelf, 0.5f, 5000.0f/44100.0f,
+        calc_rcpQ_from_slope(0.5f, 1.0f));
+
+    BiquadFilter filters[4];
+    auto result = [d,todo]() -> std::vector<double>
+    {
+        std::vector<double> out;
+        for(auto &buffer : d->Output)
+            AppendSamples(out, buffer, todo);
+        return out;
+    };
+
+    BenchKernel("biquadmulti", GetBiquadMultiOptions(), todo*4,
+        [&filters,&proto]() -> void
+        {
+            for(auto &filter : filters)
+            {
+                filter.copyParamsFrom(proto);
+                filter.clear();
+            }
+        },
+        [d,todo,&filters](BiquadMultiFunc func) -> void
+        {
+            BiquadFilter *filts[4]{&filters[0], &filters[1], &filters[2], &filters[3]};
+            const ALfloat *srcs[4]{d->Input[0], d->Input[1], d->Input[2], d->Input[3]};
+            ALfloat *dsts[4]{d->Output[0], d->Output[1], d->Output[2], d->Output[3]};
+            func(filts, dsts, srcs, 4, todo);
+        }, result);
+
+    BiquadFilter cascades[4][BIQUAD_CASCADE_STAGES];
+    BenchKernel("biquadcascade", GetBiquadCascadeOptions(), todo*4,
+        [&cascades,&proto]() -> void
+        {
+            for(auto &stages : cascades)
+            {
+                for(auto &filter : stages)
+                {
+                    filter.copyParamsFrom(proto);
+                    filter.clear();
+                }
+            }
+        },
+        [d,todo,&cascades](BiquadCascadeFunc func) -> void
+        {
+            BiquadFilter *filts[4]{cascades[0], cascades[1], cascades[2], cascades[3]};
+            const ALfloat *srcs[4]{d->Input[0], d->Input[1], d->Input[2], d->Input[3]};
+            ALfloat *dsts[4]{d->Output[0], d->Output[1], d->Output[2], d->Output[3]};
+            func(filts, dsts, srcs, 4, todo);
+        }, result);
+}
+
+void BenchSampleConverters(BenchData *d, const int todo)
+{
+    auto result = [d,todo]() -> std::vector<double>
+    {
+        std::vector<double> out;
+        AppendSamples(out, d->Output[0], todo);
+        return out;
+    };
+
+    BenchKernel("blendhalf", GetHalfBlendOptions(), todo,
+        [d]() -> void { std::fill(std::begin(d->Output[0]), std::end(d->Output[0]), 0.0f); },
+        [d,todo](HalfBlendFunc func) -> void { func(d->Output[0], d->Half, 0.5f, todo); },
+        result);
+
+    /* One channel of a stereo 16-bit buffer, the most common. */
+    BenchKernel("load", GetSampleLoadOptions(), todo,
+        [d]() -> void { std::fill(std::begin(d->Output[0]), std::end(d->Output[0]), 0.0f); },
+        [d,todo](SampleLoadFunc func) -> void
+        { func(d->Output[0], d->PCM, 2, FmtShort, todo); },
+        result);
+
+    /* Stereo 16-bit output, likewise the most common. */
+    alignas(16) ALshort stored[BUFFERSIZE*2];
+    BenchKernel("store", GetSampleStoreOptions(), todo*2,
+        [&stored]() -> void { std::fill(std::begin(stored), std::end(stored), 0); },
+        [d,todo,&stored](SampleStoreFunc func) -> void
+        {
+            const ALfloat *srcs[2]{d->Input[0], d->Input[1]};
+            func(stored, srcs, 2, 2, DevFmtShort, todo);
+        },
+        [todo,&stored]() -> std::vector<double>
+        { return std::vector<double>(std::begin(stored), std::begin(stored)+todo*2); });
+
+    alignas(16) ALuint seeds[DITHER_RNG_LANES];
+    BenchKernel("dither", GetDitherOptions(), todo,
+        [d,&seeds]() -> void
+        {
+            std::copy(std::begin(d->Input[0]), std::end(d->Input[0]), std::begin(d->Output[0]));
+            for(size_t i{0};i < DITHER_RNG_LANES;++i)
+                seeds[i] = static_cast<ALuint>(i) + 1u;
+        },
+        [d,todo,&seeds](DitherFunc func) -> void
+        { func(d->Output[0], seeds, 32768.0f, todo); },
+        result);
+}
+
+/* The filters below only have a C version, so they're checked against a
+ * double-precision version or the separate passes they fuse.
+ */
+void BenchFilters(BenchData *d, const int todo)
+{
+    if(IsSelected("biquad"))
+    {
+        BiquadFilterR<double> dfilter;
+        dfilter.setParams(BiquadType::Peaking, 2.0, 1000.0/44100.0,
+            calc_rcpQ_from_bandwidth(1000.0f/44100.0f, 0.75f));
+        std::vector<double> dsrc(std::begin(d->Input[0]), std::begin(d->Input[0])+todo);
+        std::vector<double> ref(todo);
+        dfilter.process(ref.data(), dsrc.data(), todo);
+
+        BiquadFilter filter;
+        filter.setParams(BiquadType::Peaking, 2.0f, 1000.0f/44100.0f,
+            calc_rcpQ_from_bandwidth(1000.0f/44100.0f, 0.75f));
+        filter.process(d->Output[0], d->Input[0], todo);
+        std::vector<double> out;
+        AppendSamples(out, d->Output[0], todo);
+        const double error{GetError(ref, out)};
+
+        const double ns{TimeRuns([d,todo,&filter]() -> void
+            { filter.process(d->Output[0], d->Input[0], todo); })};
+        PrintResult("biquad", "c", ns, todo, error);
+    }
+
+    if(IsSelected("bandsplit"))
+    {
+        BandSplitterR<double> dsplitter;
+        dsplitter.init(400.0/44100.0);
+        std::vector<double> dsrc(std::begin(d->Input[0]), std::begin(d->Input[0])+todo);
+        std::vector<double> ref(todo*2);
+        dsplitter.process(ref.data(), ref.data()+todo, dsrc.data(), todo);
+
+        BandSplitter splitter;
+        splitter.init(400.0f/44100.0f);
+        splitter.process(d->Output[0], d->Output[1], d->Input[0], todo);
+        std::vector<double> out;
+        AppendSamples(out, d->Output[0], todo);
+        AppendSamples(out, d->Output[1], todo);
+        const double error{GetError(ref, out)};
+
+        const double ns{TimeRuns([d,todo,&splitter]() -> void
+            { splitter.process(d->Output[0], d->Output[1], d->Input[0], todo); })};
+        PrintResult("bandsplit", "c", ns, todo, error);
+    }
+
+    if(IsSelected("nfc"))
+    {
+        const float w1{343.3f / (1.0f * 44100.0f)};
+        const float w0{343.3f / (0.5f * 44100.0f)};
+
+        NfcFilter ref;
+        ref.init(w1);
+        ref.adjust(w0);
+        NfcFilter fused{ref};
+
+        std::vector<double> refout;
+        {
+            NfcFilter f1{ref}, f2{ref}, f3{ref}, f4{ref};
+            f1.process1(d->Output[0], d->Input[0], todo);
+            f2.process2(d->Output[1], d->Input[0], todo);
+            f3.process3(d->Output[2], d->Input[0], todo);
+            f4.process4(d->Output[3], d->Input[0], todo);
+            for(auto &buffer : d->Output)
+                AppendSamples(refout, buffer, todo);
+        }
+
+        float *dsts[4]{d->Output[0], d->Output[1], d->Output[2], d->Output[3]};
+        fused.process(dsts, d->Input[0], todo, 4);
+        std::vector<double> out;
+        for(auto &buffer : d->Output)
+            AppendSamples(out, buffer, todo);
+        const double error{GetError(refout, out)};
+
+        const double ns{TimeRuns([d,todo,&fused,&dsts]() -> void
+            { fused.process(dsts, d->Input[0], todo, 4); })};
+        PrintResult("nfc", "c", ns, todo*4, error);
+    }
+}
+
+
+void PrintUsage(const char *argv0)
+{
+    fprintf(stderr,
+"Usage: %s [options] [kernel]\n"
+"Times each CPU-specific version of the mixer kernels (or only those with\n"
+"\"kernel\" in their name), and checks their output against the C version.\n"
+"Options:\n"
+"  -n <runs>     Calls per timing trial (default 256)\n"
+"  -s <samples>  Samples processed per call (default and max %d)\n",
+        argv0, BUFFERSIZE);
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    int todo{BUFFERSIZE};
+    int opt;
+    while((opt=getopt(argc, argv, "n:s:")) != -1)
+    {
+        switch(opt)
+        {
+        case 'n':
+            NumRuns = atoi(optarg);
+            break;
+        case 's':
+            todo = atoi(optarg);
+            break;
+        default:
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
+    if(NumRuns < 1 || todo < 4 || todo > BUFFERSIZE || (todo&3) || argc-optind > 1)
+    {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+    if(optind < argc)
+        KernelFilter = argv[optind];
+
+    FillCPUCaps(~0);
+
+    std::unique_ptr<BenchData> data{new BenchData{}};
+    BenchData *d{data.get()};
+    std::generate(std::begin(d->Source), std::end(d->Source), RandFloat);
+    for(auto &buffer : d->Input)
+        std::generate(std::begin(buffer), std::end(buffer), RandFloat);
+    std::generate(std::begin(d->HrtfSource), std::end(d->HrtfSource), RandFloat);
+    for(size_t i{0};i < d->Coeffs.size();i++)
+    {
+        d->Coeffs[i][0] = RandFloat() / static_cast<ALfloat>(i+1);
+        d->Coeffs[i][1] = RandFloat() / static_cast<ALfloat>(i+1);
+    }
+    d->OldParams.Coeffs = d->Coeffs;
+    std::reverse(d->OldParams.Coeffs.begin(), d->OldParams.Coeffs.end());
+    d->OldParams.Delay[0] = 4;
+    d->OldParams.Delay[1] = 12;
+    d->OldParams.Gain = 0.5f;
+    std::generate(std::begin(d->PCM), std::end(d->PCM),
+        []() -> ALshort { return static_cast<ALshort>(RandFloat() * 32767.0f); });
+    /* Half-floats with a random sign and mantissa, and a magnitude within
+     * 1/32 to 2.
+     */
+    std::generate(std::begin(d->Half), std::end(d->Half),
+        []() -> ALushort
+        {
+            RandState = RandState*1664525u + 1013904223u;
+            const ALuint bits{RandState >> 8};
+            return static_cast<ALushort>(((bits&1u) << 15) | ((10u + (bits>>1)%6u) << 10) |
+                ((bits>>4) & 0x3ffu));
+        });
+
+    /* The kernels expect the mixer's FPU mode. */
+    FPUCtl mixer_mode{};
+
+    BenchMixers(d, todo);
+    BenchHrtfMixers(d, todo);
+    BenchResamplers(d, todo);
+    BenchBiquads(d, todo);
+    BenchSampleConverters(d, todo);
+    BenchFilters(d, todo);
+
+    return CheckFailed ? 1 : 0;
+}
@@ -427,14 +427,10 @@ bool CheckIrData(MYSOFA_HRTF *sofaHrtf)
 
 
 /* Calculate the onset time of a HRIR. */
-static double CalcHrirOnset(const uint rate, const uint n, std::vector<double> &upsampled,
-    const double *hrir)
+static double CalcHrirOnset(PPhaseResampler &rs, const uint rate, const uint n,
+    std::vector<double> &upsampled, const double *hrir)
 {
-    {
-        ResamplerT rs;
-        ResamplerSetup(&rs, rate, 10 * rate);
-        ResamplerRun(&rs, n, hrir, 10 * n, upsampled.data());
-    }
+    rs.process(n, hrir, 10 * n, upsampled.data());
 
     double mag{std::accumulate(upsampled.cbegin(), upsampled.cend(), double{0.0},
         [](const double mag, const double sample) -> double
@@ -463,12 +459,12 @@ static bool LoadResponses(MYSOFA_HRTF *sofaHrtf, HrirDataT *hData)
     hData->mHrirsBase.resize(channels * hData->mIrCount * hData->mIrSize);
     double *hrirs = hData->mHrirsBase.data();
 
-    /* Temporary buffers used to calculate the IR's onset and frequency
-     * magnitudes.
+    /* The responses are placed first, then their onsets and magnitudes are
+     * calculated independently on the worker threads.
      */
-    auto upsampled = std::vector<double>(10 * hData->mIrPoints);
-    auto htemp = std::vector<complex_d>(hData->mFftSize);
-    auto hrir = std::vector<double>(hData->mFftSize);
+    struct Response { HrirAzT *azd; uint ti; };
+    std::vector<Response> responses;
+    responses.reserve(sofaHrtf->M * channels);
 
     for(uint si{0u};si < sofaHrtf->M;si++)
     {
@@ -517,13 +513,11 @@ static bool LoadResponses(MYSOFA_HRTF *sofaHrtf, HrirDataT *hData)
 
         for(uint ti{0u};ti < channels;++ti)
         {
-            std::copy_n(&sofaHrtf->DataIR.values[(si*sofaHrtf->R + ti)*sofaHrtf->N],
-                hData->mIrPoints, hrir.begin());
+            /* Hold the IR in its storage until the magnitude replaces it. */
             azd->mIrs[ti] = &hrirs[hData->mIrSize * (hData->mIrCount*ti + azd->mIndex)];
-            azd->mDelays[ti] = CalcHrirOnset(hData->mIrRate, hData->mIrPoints, upsampled,
-                hrir.data());
-            CalcHrirMagnitude(hData->mIrPoints, hData->mFftSize, htemp, hrir.data(),
-                azd->mIrs[ti]);
+            std::copy_n(&sofaHrtf->DataIR.values[(si*sofaHrtf->R + ti)*sofaHrtf->N],
+                hData->mIrPoints, azd->mIrs[ti]);
+            responses.push_back({azd, ti});
         }
 
         // TODO: Since some SOFA files contain minimum phase HRIRs,
@@ -531,6 +525,34 @@ static bool LoadResponses(MYSOFA_HRTF *sofaHrtf, HrirDataT *hData)
         // (when available) to reconstruct the HRTDs.
     }
     printf("\n");
+
+    printf("Analyzing HRIRs...\n");
+    PPhaseResampler rs;
+    rs.init(hData->mIrRate, 10 * hData->mIrRate);
+    const uint rate{hData->mIrRate};
+    const uint points{hData->mIrPoints};
+    const uint fftSize{hData->mFftSize};
+    const bool timeDomain{hData->mTimeDomain};
+    auto analyze = [&responses,&rs,rate,points,fftSize,timeDomain](const size_t idx) -> void
+    {
+        /* Temporary buffers used to calculate the IR's onset and frequency
+         * magnitudes.
+         */
+        thread_local std::vector<double> upsampled;
+        thread_local std::vector<complex_d> htemp;
+        thread_local std::vector<double> hrir;
+        upsampled.resize(10 * points);
+        htemp.resize(fftSize);
+        hrir.resize(points);
+
+        HrirAzT *azd{responses[idx].azd};
+        const uint ti{responses[idx].ti};
+        std::copy_n(azd->mIrs[ti], points, hrir.begin());
+        azd->mDelays[ti] = CalcHrirOnset(rs, rate, points, upsampled, hrir.data());
+        if(!timeDomain)
+            CalcHrirMagnitude(points, fftSize, htemp, hrir.data(), azd->mIrs[ti]);
+    };
+    ParallelFor(responses.size(), analyze, true);
     return true;
 }
 
@@ -540,7 +562,7 @@ struct MySofaHrtfDeleter {
 using MySofaHrtfPtr = std::unique_ptr<MYSOFA_HRTF,MySofaHrtfDeleter>;
 
 bool LoadSofaFile(const char *filename, const uint fftSize, const uint truncSize,
-    const ChannelModeT chanMode, HrirDataT *hData)
+    const ChannelModeT chanMode, const bool timeDomain, HrirDataT *hData)
 {
     int err;
     MySofaHrtfPtr sofaHrtf{mysofa_load(filename, &err)};
@@ -593,7 +615,8 @@ bool LoadSofaFile(const char *filename, const uint fftSize, const uint truncSize
     }
     hData->mIrPoints = sofaHrtf->N;
     hData->mFftSize = fftSize;
-    hData->mIrSize = std::max(1u + (fftSize/2u), sofaHrtf->N);
+    hData->mTimeDomain = timeDomain;
+    hData->mIrSize = timeDomain ? sofaHrtf->N : std::max(1u + (fftSize/2u), sofaHrtf->N);
 
     /* Assume a default head radius of 9cm. */
     hData->mRadius = 0.09;
@@ -4,7 +4,10 @@
 #include "makemhr.h"
 
 
+/* Loads the HRIRs from a SOFA file. With timeDomain set, the responses are
+ * left as time-domain measurements, for processing with less memory.
+ */
 bool LoadSofaFile(const char *filename, const uint fftSize, const uint truncSize,
-    const ChannelModeT chanMode, HrirDataT *hData);
+    const ChannelModeT chanMode, const bool timeDomain, HrirDataT *hData);
 
 #endif /* LOADSOFA_H */
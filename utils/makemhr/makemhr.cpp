@@ -74,14 +74,18 @@
 #ifdef HAVE_STRINGS_H
 #include <strings.h>
 #endif
+#ifndef MAKEMHR_LIBRARY
 #ifdef HAVE_GETOPT
 #include <unistd.h>
 #else
 #include "getopt.h"
 #endif
+#endif
 
 #include <atomic>
 #include <limits>
+#include <memory>
+#include <mutex>
 #include <vector>
 #include <chrono>
 #include <thread>
@@ -92,11 +96,15 @@
 
 #include "mysofa.h"
 
+#include "alcomplex.h"
+
 #include "makemhr.h"
 #include "loaddef.h"
 #include "loadsofa.h"
 
+#ifndef MAKEMHR_LIBRARY
 #include "win_main_utf8.h"
+#endif
 
 namespace {
 
@@ -156,6 +164,20 @@ enum HeadModelT {
 // response protocol 02.
 #define MHR_FORMAT                   ("MinPHR02")
 
+// The native-layout HRTF format marker, which stores the data set the way
+// OpenAL Soft holds it in memory so it can be used from a mapped file.
+#define MHR_FORMAT_NATIVE            ("MinPHR03")
+
+// The default output format version.
+#define DEFAULT_MHR_VERSION          (2)
+
+// The maximum number of worker threads.
+#define MAX_THREADS                  (256)
+
+// The number of responses to hold magnitude responses for at once when
+// streaming a data set.
+#define STREAM_CHUNK_SIZE            (64)
+
 /* Channel index enums. Mono uses LeftChannel only. */
 enum ChannelIndex : uint {
     LeftChannel = 0u,
@@ -237,67 +259,39 @@ static void TpdfDither(double *RESTRICT out, const double *RESTRICT in, const do
     }
 }
 
-/* Fast Fourier transform routines. The number of points must be a power of
- * two.
+/* Fast Fourier transform routines, using the planned transforms from
+ * alcomplex. The number of points must be a power of two.
  */
 
-// Performs bit-reversal ordering.
-static void FftArrange(const uint n, complex_d *inout)
-{
-    // Handle in-place arrangement.
-    uint rk{0u};
-    for(uint k{0u};k < n;k++)
-    {
-        if(rk > k)
-            std::swap(inout[rk], inout[k]);
-
-        uint m{n};
-        while(rk&(m >>= 1))
-            rk &= ~m;
-        rk |= m;
-    }
-}
-
-// Performs the summation.
-static void FftSummation(const int n, const double s, complex_d *cplx)
+/* Gets the plan for the given number of points. Plans are created once per
+ * size and kept for the rest of the run, since creating one costs more than
+ * a transform. Plans can be used by multiple threads at once.
+ */
+static const FftPlan<double> &GetFftPlan(const uint n)
 {
-    double pi;
-    int m, m2;
-    int i, k, mk;
-
-    pi = s * M_PI;
-    for(m = 1, m2 = 2;m < n; m <<= 1, m2 <<= 1)
-    {
-        // v = Complex (-2.0 * sin (0.5 * pi / m) * sin (0.5 * pi / m), -sin (pi / m))
-        double sm = sin(0.5 * pi / m);
-        auto v = complex_d{-2.0*sm*sm, -sin(pi / m)};
-        auto w = complex_d{1.0, 0.0};
-        for(i = 0;i < m;i++)
-        {
-            for(k = i;k < n;k += m2)
-            {
-                mk = k + m;
-                auto t = w * cplx[mk];
-                cplx[mk] = cplx[k] - t;
-                cplx[k] = cplx[k] + t;
-            }
-            w += v*w;
-        }
-    }
+    static std::mutex PlanLock;
+    static std::vector<std::unique_ptr<FftPlan<double>>> Plans;
+
+    std::lock_guard<std::mutex> _{PlanLock};
+    auto iter = std::find_if(Plans.cbegin(), Plans.cend(),
+        [n](const std::unique_ptr<FftPlan<double>> &plan) -> bool
+        { return plan->size() == static_cast<int>(n); });
+    if(iter != Plans.cend())
+        return **iter;
+    Plans.emplace_back(new FftPlan<double>{static_cast<int>(n)});
+    return *Plans.back();
 }
 
 // Performs a forward FFT.
 void FftForward(const uint n, complex_d *inout)
 {
-    FftArrange(n, inout);
-    FftSummation(n, 1.0, inout);
+    GetFftPlan(n).forward(inout);
 }
 
 // Performs an inverse FFT.
 void FftInverse(const uint n, complex_d *inout)
 {
-    FftArrange(n, inout);
-    FftSummation(n, -1.0, inout);
+    GetFftPlan(n).inverse(inout);
     double f{1.0 / n};
     for(uint i{0};i < n;i++)
         inout[i] *= f;
@@ -400,236 +394,49 @@ static void MinimumPhase(const uint n, const double *in, complex_d *out)
 }
 
 
-/***************************
- *** Resampler functions ***
- ***************************/
+/* The number of threads to process HRIRs with (0 to use one per CPU). */
+static uint NumThreads{0u};
 
-/* This is the normalized cardinal sine (sinc) function.
- *
- *   sinc(x) = { 1,                   x = 0
- *             { sin(pi x) / (pi x),  otherwise.
- */
-static double Sinc(const double x)
+void ParallelFor(const size_t count, const std::function<void(size_t)> &func,
+    const bool progress)
 {
-    if(std::abs(x) < EPSILON)
-        return 1.0;
-    return std::sin(M_PI * x) / (M_PI * x);
-}
-
-/* The zero-order modified Bessel function of the first kind, used for the
- * Kaiser window.
- *
- *   I_0(x) = sum_{k=0}^inf (1 / k!)^2 (x / 2)^(2 k)
- *          = sum_{k=0}^inf ((x / 2)^k / k!)^2
- */
-static double BesselI_0(const double x)
-{
-    double term, sum, x2, y, last_sum;
-    int k;
-
-    // Start at k=1 since k=0 is trivial.
-    term = 1.0;
-    sum = 1.0;
-    x2 = x/2.0;
-    k = 1;
-
-    // Let the integration converge until the term of the sum is no longer
-    // significant.
-    do {
-        y = x2 / k;
-        k++;
-        last_sum = sum;
-        term *= y * y;
-        sum += term;
-    } while(sum != last_sum);
-    return sum;
-}
-
-/* Calculate a Kaiser window from the given beta value and a normalized k
- * [-1, 1].
- *
- *   w(k) = { I_0(B sqrt(1 - k^2)) / I_0(B),  -1 <= k <= 1
- *          { 0,                              elsewhere.
- *
- * Where k can be calculated as:
- *
- *   k = i / l,         where -l <= i <= l.
- *
- * or:
- *
- *   k = 2 i / M - 1,   where 0 <= i <= M.
- */
-static double Kaiser(const double b, const double k)
-{
-    if(!(k >= -1.0 && k <= 1.0))
-        return 0.0;
-    return BesselI_0(b * std::sqrt(1.0 - k*k)) / BesselI_0(b);
-}
-
-// Calculates the greatest common divisor of a and b.
-static uint Gcd(uint x, uint y)
-{
-    while(y > 0)
+    std::atomic<size_t> current{0u};
+    std::atomic<size_t> done{0u};
+    auto worker = [count,&func,&current,&done]() -> void
     {
-        uint z{y};
-        y = x % y;
-        x = z;
-    }
-    return x;
-}
-
-/* Calculates the size (order) of the Kaiser window.  Rejection is in dB and
- * the transition width is normalized frequency (0.5 is nyquist).
- *
- *   M = { ceil((r - 7.95) / (2.285 2 pi f_t)),  r > 21
- *       { ceil(5.79 / 2 pi f_t),                r <= 21.
- *
- */
-static uint CalcKaiserOrder(const double rejection, const double transition)
-{
-    double w_t = 2.0 * M_PI * transition;
-    if(rejection > 21.0)
-        return static_cast<uint>(std::ceil((rejection - 7.95) / (2.285 * w_t)));
-    return static_cast<uint>(std::ceil(5.79 / w_t));
-}
-
-// Calculates the beta value of the Kaiser window.  Rejection is in dB.
-static double CalcKaiserBeta(const double rejection)
-{
-    if(rejection > 50.0)
-        return 0.1102 * (rejection - 8.7);
-    if(rejection >= 21.0)
-        return (0.5842 * std::pow(rejection - 21.0, 0.4)) +
-               (0.07886 * (rejection - 21.0));
-    return 0.0;
-}
-
-/* Calculates a point on the Kaiser-windowed sinc filter for the given half-
- * width, beta, gain, and cutoff.  The point is specified in non-normalized
- * samples, from 0 to M, where M = (2 l + 1).
- *
- *   w(k) 2 p f_t sinc(2 f_t x)
- *
- *   x    -- centered sample index (i - l)
- *   k    -- normalized and centered window index (x / l)
- *   w(k) -- window function (Kaiser)
- *   p    -- gain compensation factor when sampling
- *   f_t  -- normalized center frequency (or cutoff; 0.5 is nyquist)
- */
-static double SincFilter(const int l, const double b, const double gain, const double cutoff, const int i)
-{
-    return Kaiser(b, static_cast<double>(i - l) / l) * 2.0 * gain * cutoff * Sinc(2.0 * cutoff * (i - l));
-}
-
-/* This is a polyphase sinc-filtered resampler.
- *
- *              Upsample                      Downsample
- *
- *              p/q = 3/2                     p/q = 3/5
- *
- *          M-+-+-+->                     M-+-+-+->
- *         -------------------+          ---------------------+
- *   p  s * f f f f|f|        |    p  s * f f f f f           |
- *   |  0 *   0 0 0|0|0       |    |  0 *   0 0 0 0|0|        |
- *   v  0 *     0 0|0|0 0     |    v  0 *     0 0 0|0|0       |
- *      s *       f|f|f f f   |       s *       f f|f|f f     |
- *      0 *        |0|0 0 0 0 |       0 *         0|0|0 0 0   |
- *         --------+=+--------+       0 *          |0|0 0 0 0 |
- *          d . d .|d|. d . d            ----------+=+--------+
- *                                        d . . . .|d|. . . .
- *          q->
- *                                        q-+-+-+->
- *
- *   P_f(i,j) = q i mod p + pj
- *   P_s(i,j) = floor(q i / p) - j
- *   d[i=0..N-1] = sum_{j=0}^{floor((M - 1) / p)} {
- *                   { f[P_f(i,j)] s[P_s(i,j)],  P_f(i,j) < M
- *                   { 0,                        P_f(i,j) >= M. }
- */
-
-// Calculate the resampling metrics and build the Kaiser-windowed sinc filter
-// that's used to cut frequencies above the destination nyquist.
-void ResamplerSetup(ResamplerT *rs, const uint srcRate, const uint dstRate)
-{
-    double cutoff, width, beta;
-    uint gcd, l;
-    int i;
-
-    gcd = Gcd(srcRate, dstRate);
-    rs->mP = dstRate / gcd;
-    rs->mQ = srcRate / gcd;
-    /* The cutoff is adjusted by half the transition width, so the transition
-     * ends before the nyquist (0.5).  Both are scaled by the downsampling
-     * factor.
-     */
-    if(rs->mP > rs->mQ)
-    {
-        cutoff = 0.475 / rs->mP;
-        width = 0.05 / rs->mP;
-    }
-    else
-    {
-        cutoff = 0.475 / rs->mQ;
-        width = 0.05 / rs->mQ;
-    }
-    // A rejection of -180 dB is used for the stop band. Round up when
-    // calculating the left offset to avoid increasing the transition width.
-    l = (CalcKaiserOrder(180.0, width)+1) / 2;
-    beta = CalcKaiserBeta(180.0);
-    rs->mM = l*2 + 1;
-    rs->mL = l;
-    rs->mF.resize(rs->mM);
-    for(i = 0;i < (static_cast<int>(rs->mM));i++)
-        rs->mF[i] = SincFilter(static_cast<int>(l), beta, rs->mP, cutoff, i);
-}
+        size_t idx;
+        while((idx=current.fetch_add(1u, std::memory_order_relaxed)) < count)
+        {
+            func(idx);
+            done.fetch_add(1u, std::memory_order_release);
+        }
+    };
 
-// Perform the upsample-filter-downsample resampling operation using a
-// polyphase filter implementation.
-void ResamplerRun(ResamplerT *rs, const uint inN, const double *in, const uint outN, double *out)
-{
-    const uint p = rs->mP, q = rs->mQ, m = rs->mM, l = rs->mL;
-    std::vector<double> workspace;
-    const double *f = rs->mF.data();
-    uint j_f, j_s;
-    double *work;
-    uint i;
+    uint numthreads{NumThreads};
+    if(!numthreads) numthreads = std::max(std::thread::hardware_concurrency(), 1u);
+    numthreads = static_cast<uint>(std::min<size_t>(numthreads, std::max<size_t>(count, 1u)));
 
-    if(outN == 0)
-        return;
+    std::vector<std::thread> threads;
+    threads.reserve(numthreads);
+    for(uint i{0u};i < numthreads;++i)
+        threads.emplace_back(worker);
 
-    // Handle in-place operation.
-    if(in == out)
+    /* Keep track of the number of items done, periodically reporting it. */
+    if(progress)
     {
-        workspace.resize(outN);
-        work = workspace.data();
-    }
-    else
-        work = out;
-    // Resample the input.
-    for(i = 0;i < outN;i++)
-    {
-        double r = 0.0;
-        // Input starts at l to compensate for the filter delay.  This will
-        // drop any build-up from the first half of the filter.
-        j_f = (l + (q * i)) % p;
-        j_s = (l + (q * i)) / p;
-        while(j_f < m)
+        size_t finished;
+        while((finished=done.load(std::memory_order_acquire)) != count)
         {
-            // Only take input when 0 <= j_s < inN.  This single unsigned
-            // comparison catches both cases.
-            if(j_s < inN)
-                r += f[j_f] * in[j_s];
-            j_f += p;
-            j_s--;
+            printf("\r%3zu%% done (%zu of %zu)", finished*100/count, finished, count);
+            fflush(stdout);
+
+            std::this_thread::sleep_for(std::chrono::milliseconds{50});
         }
-        work[i] = r;
-    }
-    // Clean up after in-place operation.
-    if(work != out)
-    {
-        for(i = 0;i < outN;i++)
-            out[i] = work[i];
+        printf("\r%3zu%% done (%zu of %zu)\n", size_t{100}, count, count);
     }
+
+    for(std::thread &thrd : threads)
+        thrd.join();
 }
 
 
@@ -762,6 +569,146 @@ static int StoreMhr(const HrirDataT *hData, const char *filename)
 }
 
 
+// Write a 32-bit IEEE float in little-endian byte order to a file.
+static int WriteFloat(const float in, FILE *fp, const char *filename)
+{
+    uint32_t bits;
+    memcpy(&bits, &in, sizeof(bits));
+    return WriteBin4(4, bits, fp, filename);
+}
+
+// Write zero-valued padding bytes to a file.
+static int WritePadding(const uint bytes, FILE *fp, const char *filename)
+{
+    for(uint i = 0;i < bytes;i++)
+    {
+        if(!WriteBin4(1, 0, fp, filename))
+            return 0;
+    }
+    return 1;
+}
+
+// Store the OpenAL Soft HRTF data set in the native layout. Fields are stored
+// farthest first, the per-elevation HRIR offsets are precalculated, mono data
+// sets are mirrored for the right ear, and the coefficients are written as
+// unquantized floats aligned to 16 bytes from the start of the file.
+static int StoreMhrNative(const HrirDataT *hData, const char *filename)
+{
+    uint n = hData->mIrPoints;
+    uint evTotal = 0, irTotal = 0;
+    size_t offset;
+    FILE *fp;
+    uint fi, ei, ai, i;
+
+    for(fi = 0;fi < hData->mFdCount;fi++)
+    {
+        evTotal += hData->mFds[fi].mEvCount;
+        for(ei = 0;ei < hData->mFds[fi].mEvCount;ei++)
+            irTotal += hData->mFds[fi].mEvs[ei].mAzCount;
+    }
+    if(irTotal > 65535)
+    {
+        fprintf(stderr, "\nError: Too many HRIRs for the native format (%u).\n", irTotal);
+        return 0;
+    }
+
+    if((fp=fopen(filename, "wb")) == nullptr)
+    {
+        fprintf(stderr, "\nError: Could not open MHR file '%s'.\n", filename);
+        return 0;
+    }
+    if(!WriteAscii(MHR_FORMAT_NATIVE, fp, filename))
+        return 0;
+    if(!WriteBin4(4, hData->mIrRate, fp, filename) ||
+       !WriteBin4(2, n, fp, filename) ||
+       !WriteBin4(1, hData->mFdCount, fp, filename) ||
+       !WritePadding(1, fp, filename) ||
+       !WriteBin4(2, evTotal, fp, filename) ||
+       !WritePadding(2, fp, filename) ||
+       !WriteBin4(4, irTotal, fp, filename))
+        return 0;
+    offset = 24;
+
+    for(fi = hData->mFdCount;fi-- > 0;)
+    {
+        if(!WriteFloat(static_cast<float>(hData->mFds[fi].mDistance), fp, filename) ||
+           !WriteBin4(1, hData->mFds[fi].mEvCount, fp, filename) ||
+           !WritePadding(3, fp, filename))
+            return 0;
+        offset += 8;
+    }
+    for(fi = 0;fi < hData->mFdCount;fi++)
+    {
+        for(ei = 0;ei < hData->mFds[fi].mEvCount;ei++)
+        {
+            if(!WriteBin4(1, hData->mFds[fi].mEvs[ei].mAzCount, fp, filename))
+                return 0;
+        }
+    }
+    offset += evTotal;
+    if((offset&1))
+    {
+        if(!WritePadding(1, fp, filename))
+            return 0;
+        offset++;
+    }
+    irTotal = 0;
+    for(fi = 0;fi < hData->mFdCount;fi++)
+    {
+        for(ei = 0;ei < hData->mFds[fi].mEvCount;ei++)
+        {
+            if(!WriteBin4(2, irTotal, fp, filename))
+                return 0;
+            irTotal += hData->mFds[fi].mEvs[ei].mAzCount;
+        }
+    }
+    offset += 2 * evTotal;
+    if(!WritePadding(static_cast<uint>((16 - (offset&15)) & 15), fp, filename))
+        return 0;
+
+    for(fi = 0;fi < hData->mFdCount;fi++)
+    {
+        for(ei = 0;ei < hData->mFds[fi].mEvCount;ei++)
+        {
+            const HrirEvT &evd = hData->mFds[fi].mEvs[ei];
+            for(ai = 0;ai < evd.mAzCount;ai++)
+            {
+                const double *left = evd.mAzs[ai].mIrs[0];
+                const double *right = (hData->mChannelType == CT_STEREO) ? evd.mAzs[ai].mIrs[1] :
+                    evd.mAzs[(evd.mAzCount-ai) % evd.mAzCount].mIrs[0];
+                for(i = 0;i < n;i++)
+                {
+                    if(!WriteFloat(static_cast<float>(left[i]), fp, filename) ||
+                       !WriteFloat(static_cast<float>(right[i]), fp, filename))
+                        return 0;
+                }
+            }
+        }
+    }
+    for(fi = 0;fi < hData->mFdCount;fi++)
+    {
+        for(ei = 0;ei < hData->mFds[fi].mEvCount;ei++)
+        {
+            const HrirEvT &evd = hData->mFds[fi].mEvs[ei];
+            for(ai = 0;ai < evd.mAzCount;ai++)
+            {
+                const double ldelay = evd.mAzs[ai].mDelays[0];
+                const double rdelay = (hData->mChannelType == CT_STEREO) ?
+                    evd.mAzs[ai].mDelays[1] : evd.mAzs[(evd.mAzCount-ai) % evd.mAzCount].mDelays[0];
+                int v = static_cast<int>(std::min(std::round(hData->mIrRate * ldelay), MAX_HRTD));
+                if(!WriteBin4(1, static_cast<uint32_t>(v), fp, filename))
+                    return 0;
+                v = static_cast<int>(std::min(std::round(hData->mIrRate * rdelay), MAX_HRTD));
+                if(!WriteBin4(1, static_cast<uint32_t>(v), fp, filename))
+                    return 0;
+            }
+        }
+    }
+    fclose(fp);
+    return 1;
+}
+
+
 /***********************
  *** HRTF processing ***
  ***********************/
@@ -873,15 +820,14 @@ static void CalculateDfWeights(const HrirDataT *hData, double *weights)
  * coverage of each HRIR.  The final average can then be limited by the
  * specified magnitude range (in positive dB; 0.0 to skip).
  */
-static void CalculateDiffuseFieldAverage(const HrirDataT *hData, const uint channels, const uint m, const int weighted, const double limit, double *dfa)
+static void CalculateDfaWeights(const HrirDataT *hData, const int weighted, double *weights)
 {
-    std::vector<double> weights(hData->mFdCount * MAX_EV_COUNT);
-    uint count, ti, fi, ei, i, ai;
+    uint count, fi, ei;
 
     if(weighted)
     {
         // Use coverage weighting to calculate the average.
-        CalculateDfWeights(hData, weights.data());
+        CalculateDfWeights(hData, weights);
     }
     else
     {
@@ -903,6 +849,30 @@ static void CalculateDiffuseFieldAverage(const HrirDataT *hData, const uint chan
                 weights[(fi * MAX_EV_COUNT) + ei] = weight;
         }
     }
+}
+
+// Finish the average calculation from the accumulated weighted power
+// averages, and apply the limit.
+static void FinishDiffuseFieldAverage(const HrirDataT *hData, const uint channels, const uint m, const double limit, double *dfa)
+{
+    for(uint ti{0u};ti < channels;ti++)
+    {
+        // Keep the average from being too small.
+        for(uint i{0u};i < m;i++)
+            dfa[(ti * m) + i] = std::max(sqrt(dfa[(ti * m) + i]), EPSILON);
+        // Apply a limit to the magnitude range of the diffuse-field average
+        // if desired.
+        if(limit > 0.0)
+            LimitMagnitudeResponse(hData->mFftSize, m, limit, &dfa[ti * m], &dfa[ti * m]);
+    }
+}
+
+static void CalculateDiffuseFieldAverage(const HrirDataT *hData, const uint channels, const uint m, const int weighted, const double limit, double *dfa)
+{
+    std::vector<double> weights(hData->mFdCount * MAX_EV_COUNT);
+    uint ti, fi, ei, i, ai;
+
+    CalculateDfaWeights(hData, weighted, weights.data());
     for(ti = 0;ti < channels;ti++)
     {
         for(i = 0;i < m;i++)
@@ -923,14 +893,8 @@ static void CalculateDiffuseFieldAverage(const HrirDataT *hData, const uint chan
                 }
             }
         }
-        // Finish the average calculation and keep it from being too small.
-        for(i = 0;i < m;i++)
-            dfa[(ti * m) + i] = std::max(sqrt(dfa[(ti * m) + i]), EPSILON);
-        // Apply a limit to the magnitude range of the diffuse-field average
-        // if desired.
-        if(limit > 0.0)
-            LimitMagnitudeResponse(hData->mFftSize, m, limit, &dfa[ti * m], &dfa[ti * m]);
     }
+    FinishDiffuseFieldAverage(hData, channels, m, limit, dfa);
 }
 
 // Perform diffuse-field equalization on the magnitude responses of the HRIR
@@ -957,132 +921,199 @@ static void DiffuseFieldEqualize(const uint channels, const uint m, const double
     }
 }
 
-/* Perform minimum-phase reconstruction using the magnitude responses of the
- * HRIR set. Work is delegated to this struct, which runs asynchronously on one
- * or more threads (sharing the same reconstructor object).
+/* Gets the responses of the HRIR set (excluding elevations that will be
+ * synthesized later), for processing each one independently.
  */
-struct HrirReconstructor {
-    std::vector<double*> mIrs;
-    std::atomic<size_t> mCurrent;
-    std::atomic<size_t> mDone;
-    size_t mFftSize;
-    size_t mIrPoints;
-
-    void Worker()
-    {
-        auto h = std::vector<complex_d>(mFftSize);
+static std::vector<double*> GetHrirResponses(const HrirDataT *hData)
+{
+    const uint channels{(hData->mChannelType == CT_STEREO) ? 2u : 1u};
 
-        while(1)
+    std::vector<double*> irs;
+    irs.reserve(hData->mIrCount * channels);
+    for(uint fi{0u};fi < hData->mFdCount;fi++)
+    {
+        const HrirFdT &field = hData->mFds[fi];
+        for(uint ei{field.mEvStart};ei < field.mEvCount;ei++)
         {
-            /* Load the current index to process. */
-            size_t idx{mCurrent.load()};
-            do {
-                /* If the index is at the end, we're done. */
-                if(idx >= mIrs.size())
-                    return;
-                /* Otherwise, increment the current index atomically so other
-                 * threads know to go to the next one. If this call fails, the
-                 * current index was just changed by another thread and the new
-                 * value is loaded into idx, which we'll recheck.
-                 */
-            } while(!mCurrent.compare_exchange_weak(idx, idx+1, std::memory_order_relaxed));
-
-            /* Now do the reconstruction, and apply the inverse FFT to get the
-             * time-domain response.
-             */
-            MinimumPhase(mFftSize, mIrs[idx], h.data());
-            FftInverse(mFftSize, h.data());
-            for(size_t i{0u};i < mIrPoints;++i)
-                mIrs[idx][i] = h[i].real();
-
-            /* Increment the number of IRs done. */
-            mDone.fetch_add(1);
+            const HrirEvT &elev = field.mEvs[ei];
+            for(uint ai{0u};ai < elev.mAzCount;ai++)
+            {
+                const HrirAzT &azd = elev.mAzs[ai];
+                for(uint ti{0u};ti < channels;ti++)
+                    irs.push_back(azd.mIrs[ti]);
+            }
         }
     }
-};
+    return irs;
+}
 
+/* Perform minimum-phase reconstruction using the magnitude responses of the
+ * HRIR set. Each response is independent, so they're spread over the worker
+ * threads.
+ */
 static void ReconstructHrirs(const HrirDataT *hData)
 {
-    const uint channels{(hData->mChannelType == CT_STEREO) ? 2u : 1u};
+    const std::vector<double*> irs{GetHrirResponses(hData)};
+    const uint fftSize{hData->mFftSize};
+    const uint irPoints{hData->mIrPoints};
 
-    /* Count the number of IRs to process (excluding elevations that will be
-     * synthesized later).
-     */
-    size_t total{hData->mIrCount};
-    for(uint fi{0u};fi < hData->mFdCount;fi++)
+    auto reconstruct = [&irs,fftSize,irPoints](const size_t idx) -> void
     {
-        for(uint ei{0u};ei < hData->mFds[fi].mEvStart;ei++)
-            total -= hData->mFds[fi].mEvs[ei].mAzCount;
-    }
-    total *= channels;
+        thread_local std::vector<complex_d> h;
+        h.resize(fftSize);
 
-    /* Set up the reconstructor with the needed size info and pointers to the
-     * IRs to process.
-     */
-    HrirReconstructor reconstructor;
-    reconstructor.mIrs.reserve(total);
-    reconstructor.mCurrent.store(0, std::memory_order_relaxed);
-    reconstructor.mDone.store(0, std::memory_order_relaxed);
-    reconstructor.mFftSize = hData->mFftSize;
-    reconstructor.mIrPoints = hData->mIrPoints;
+        /* Do the reconstruction, and apply the inverse FFT to get the
+         * time-domain response.
+         */
+        MinimumPhase(fftSize, irs[idx], h.data());
+        FftInverse(fftSize, h.data());
+        for(uint i{0u};i < irPoints;++i)
+            irs[idx][i] = h[i].real();
+    };
+    ParallelFor(irs.size(), reconstruct, true);
+}
+
+/* Performs the field balancing, diffuse-field equalization, and minimum-phase
+ * reconstruction for data sets whose responses are still time-domain
+ * measurements (see HrirDataT::mTimeDomain). The magnitude responses are
+ * calculated in chunks as needed, rather than being held for the whole set,
+ * so memory use beyond the measurements is proportional to one chunk. The
+ * results are the same as loading the magnitude responses and processing
+ * them in separate passes.
+ */
+static void StreamHrirs(HrirDataT *hData, const int equalize, const int surface, const double limit)
+{
+    const uint channels{(hData->mChannelType == CT_STEREO) ? 2u : 1u};
+    const uint m{1u + hData->mFftSize/2u};
+    const uint fftSize{hData->mFftSize};
+    const uint irPoints{hData->mIrPoints};
+
+    struct Response { double *ir; uint ti, fi, ei; };
+    std::vector<Response> responses;
     for(uint fi{0u};fi < hData->mFdCount;fi++)
     {
         const HrirFdT &field = hData->mFds[fi];
         for(uint ei{field.mEvStart};ei < field.mEvCount;ei++)
         {
-            const HrirEvT &elev = field.mEvs[ei];
-            for(uint ai{0u};ai < elev.mAzCount;ai++)
+            for(uint ai{0u};ai < field.mEvs[ei].mAzCount;ai++)
             {
-                const HrirAzT &azd = elev.mAzs[ai];
                 for(uint ti{0u};ti < channels;ti++)
-                    reconstructor.mIrs.push_back(azd.mIrs[ti]);
+                    responses.push_back({field.mEvs[ei].mAzs[ai].mIrs[ti], ti, fi, ei});
             }
         }
     }
 
-    /* Launch two threads to work on reconstruction. */
-    std::thread thrd1{std::mem_fn(&HrirReconstructor::Worker), &reconstructor};
-    std::thread thrd2{std::mem_fn(&HrirReconstructor::Worker), &reconstructor};
+    /* Each field is scaled by its balance factor, as calculated by
+     * BalanceFieldMagnitudes.
+     */
+    std::vector<double> fieldFactors(hData->mFdCount, 1.0);
+    auto calc_magnitude = [&responses,&fieldFactors,fftSize,irPoints,m](const size_t idx,
+        double *mag) -> void
+    {
+        thread_local std::vector<complex_d> h;
+        h.resize(fftSize);
+
+        const Response &resp = responses[idx];
+        for(uint i{0u};i < irPoints;i++)
+            h[i] = complex_d{resp.ir[i], 0.0};
+        std::fill(h.begin()+irPoints, h.end(), complex_d{0.0, 0.0});
+        FftForward(fftSize, h.data());
+        MagnitudeResponse(fftSize, h.data(), mag);
+        if(fieldFactors[resp.fi] != 1.0)
+        {
+            for(uint i{0u};i < m;i++)
+                mag[i] *= fieldFactors[resp.fi];
+        }
+    };
 
-    /* Keep track of the number of IRs done, periodically reporting it. */
-    size_t count;
-    while((count=reconstructor.mDone.load()) != total)
+    /* Calculates the magnitude responses of each chunk on the worker threads,
+     * then passes them in order to the given function.
+     */
+    std::vector<double> chunk(size_t{STREAM_CHUNK_SIZE} * m);
+    auto for_each_magnitude = [&responses,&chunk,&calc_magnitude,m](
+        const std::function<void(const Response&,const double*)> &func) -> void
     {
-        size_t pcdone{count * 100 / total};
+        for(size_t base{0u};base < responses.size();base += STREAM_CHUNK_SIZE)
+        {
+            const size_t count{std::min<size_t>(STREAM_CHUNK_SIZE, responses.size()-base)};
+            ParallelFor(count, [&chunk,&calc_magnitude,base,m](const size_t idx) -> void
+                { calc_magnitude(base+idx, &chunk[idx*m]); },
+                false);
+            for(size_t idx{0u};idx < count;++idx)
+                func(responses[base+idx], &chunk[idx*m]);
+        }
+    };
 
-        printf("\r%3zu%% done (%zu of %zu)", pcdone, count, total);
-        fflush(stdout);
+    std::vector<double> dfa;
+    if(equalize)
+    {
+        if(hData->mFdCount > 1)
+        {
+            fprintf(stdout, "Balancing field magnitudes...\n");
+            std::vector<double> maxMags(hData->mFdCount, 0.0);
+            for_each_magnitude([&maxMags,m](const Response &resp, const double *mag) -> void
+            {
+                for(uint i{0u};i < m;i++)
+                    maxMags[resp.fi] = std::max(mag[i], maxMags[resp.fi]);
+            });
+            const double maxMag{*std::max_element(maxMags.cbegin(), maxMags.cend())};
+            for(uint fi{0u};fi < hData->mFdCount;fi++)
+                fieldFactors[fi] = maxMag / maxMags[fi];
+        }
 
-        std::this_thread::sleep_for(std::chrono::milliseconds{50});
+        fprintf(stdout, "Calculating diffuse-field average...\n");
+        std::vector<double> weights(hData->mFdCount * MAX_EV_COUNT);
+        CalculateDfaWeights(hData, surface, weights.data());
+        dfa.resize(channels * m, 0.0);
+        for_each_magnitude([&dfa,&weights,m](const Response &resp, const double *mag) -> void
+        {
+            const double weight{weights[(resp.fi * MAX_EV_COUNT) + resp.ei]};
+            double *avg{&dfa[resp.ti * m]};
+            for(uint i{0u};i < m;i++)
+                avg[i] += weight * mag[i] * mag[i];
+        });
+        FinishDiffuseFieldAverage(hData, channels, m, limit, dfa.data());
     }
-    size_t pcdone{count * 100 / total};
-    printf("\r%3zu%% done (%zu of %zu)\n", pcdone, count, total);
 
-    if(thrd2.joinable()) thrd2.join();
-    if(thrd1.joinable()) thrd1.join();
+    fprintf(stdout, "Performing diffuse-field equalization and minimum phase reconstruction...\n");
+    auto reconstruct = [&responses,&dfa,&calc_magnitude,fftSize,irPoints,m](const size_t idx)
+        -> void
+    {
+        thread_local std::vector<double> mag;
+        thread_local std::vector<complex_d> h;
+        mag.resize(m);
+        h.resize(fftSize);
+
+        const Response &resp = responses[idx];
+        calc_magnitude(idx, mag.data());
+        if(!dfa.empty())
+        {
+            for(uint i{0u};i < m;i++)
+                mag[i] /= dfa[(resp.ti * m) + i];
+        }
+        MinimumPhase(fftSize, mag.data(), h.data());
+        FftInverse(fftSize, h.data());
+        for(uint i{0u};i < irPoints;++i)
+            resp.ir[i] = h[i].real();
+    };
+    ParallelFor(responses.size(), reconstruct, true);
+    hData->mTimeDomain = false;
 }
 
 // Resamples the HRIRs for use at the given sampling rate.
 static void ResampleHrirs(const uint rate, HrirDataT *hData)
 {
-    uint channels = (hData->mChannelType == CT_STEREO) ? 2 : 1;
-    uint n = hData->mIrPoints;
-    uint ti, fi, ei, ai;
-    ResamplerT rs;
+    const std::vector<double*> irs{GetHrirResponses(hData)};
+    const uint n{hData->mIrPoints};
+    PPhaseResampler rs;
 
-    ResamplerSetup(&rs, hData->mIrRate, rate);
-    for(fi = 0;fi < hData->mFdCount;fi++)
-    {
-        for(ei = hData->mFds[fi].mEvStart;ei < hData->mFds[fi].mEvCount;ei++)
-        {
-            for(ai = 0;ai < hData->mFds[fi].mEvs[ei].mAzCount;ai++)
-            {
-                HrirAzT *azd = &hData->mFds[fi].mEvs[ei].mAzs[ai];
-                for(ti = 0;ti < channels;ti++)
-                    ResamplerRun(&rs, n, azd->mIrs[ti], n, azd->mIrs[ti]);
-            }
-        }
-    }
+    /* The resampler only reads its filter when processing, so the threads
+     * can share it.
+     */
+    rs.init(hData->mIrRate, rate);
+    ParallelFor(irs.size(), [&irs,&rs,n](const size_t idx) -> void
+        { rs.process(n, irs[idx], n, irs[idx]); },
+        false);
     hData->mIrRate = rate;
 }
 
@@ -1533,7 +1564,7 @@ int PrepareHrirData(const uint fdCount, const double (&distances)[MAX_FD_COUNT],
  * resulting data set as desired.  If the input name is NULL it will read
  * from standard input.
  */
-static int ProcessDefinition(const char *inName, const uint outRate, const ChannelModeT chanMode, const uint fftSize, const int equalize, const int surface, const double limit, const uint truncSize, const HeadModelT model, const double radius, const char *outName)
+static int ProcessDefinition(const char *inName, const uint outRate, const ChannelModeT chanMode, const uint fftSize, const int equalize, const int surface, const double limit, const uint truncSize, const HeadModelT model, const double radius, const uint mhrVersion, const bool stream, const char *outName)
 {
     char rateStr[8+1], expName[MAX_PATH_LEN];
     char startbytes[4]{};
@@ -1571,7 +1602,7 @@ static int ProcessDefinition(const char *inName, const uint outRate, const Chann
             fp = nullptr;
 
             fprintf(stdout, "Reading HRTF data from %s...\n", inName);
-            if(!LoadSofaFile(inName, fftSize, truncSize, chanMode, &hData))
+            if(!LoadSofaFile(inName, fftSize, truncSize, chanMode, stream, &hData))
                 return 0;
         }
     }
@@ -1586,24 +1617,29 @@ static int ProcessDefinition(const char *inName, const uint outRate, const Chann
             return 0;
     }
 
-    if(equalize)
+    if(hData.mTimeDomain)
+        StreamHrirs(&hData, equalize, surface, limit);
+    else
     {
-        uint c = (hData.mChannelType == CT_STEREO) ? 2 : 1;
-        uint m = 1 + hData.mFftSize / 2;
-        std::vector<double> dfa(c * m);
-
-        if(hData.mFdCount > 1)
+        if(equalize)
         {
-            fprintf(stdout, "Balancing field magnitudes...\n");
-            BalanceFieldMagnitudes(&hData, c, m);
+            uint c = (hData.mChannelType == CT_STEREO) ? 2 : 1;
+            uint m = 1 + hData.mFftSize / 2;
+            std::vector<double> dfa(c * m);
+
+            if(hData.mFdCount > 1)
+            {
+                fprintf(stdout, "Balancing field magnitudes...\n");
+                BalanceFieldMagnitudes(&hData, c, m);
+            }
+            fprintf(stdout, "Calculating diffuse-field average...\n");
+            CalculateDiffuseFieldAverage(&hData, c, m, surface, limit, dfa.data());
+            fprintf(stdout, "Performing diffuse-field equalization...\n");
+            DiffuseFieldEqualize(c, m, dfa.data(), &hData);
         }
-        fprintf(stdout, "Calculating diffuse-field average...\n");
-        CalculateDiffuseFieldAverage(&hData, c, m, surface, limit, dfa.data());
-        fprintf(stdout, "Performing diffuse-field equalization...\n");
-        DiffuseFieldEqualize(c, m, dfa.data(), &hData);
+        fprintf(stdout, "Performing minimum phase reconstruction...\n");
+        ReconstructHrirs(&hData);
     }
-    fprintf(stdout, "Performing minimum phase reconstruction...\n");
-    ReconstructHrirs(&hData);
     if(outRate != 0 && outRate != hData.mIrRate)
     {
         fprintf(stdout, "Resampling HRIRs...\n");
@@ -1622,11 +1658,25 @@ static int ProcessDefinition(const char *inName, const uint outRate, const Chann
     snprintf(rateStr, 8, "%u", hData.mIrRate);
     StrSubst(outName, "%r", rateStr, MAX_PATH_LEN, expName);
     fprintf(stdout, "Creating MHR data set %s...\n", expName);
-    ret = StoreMhr(&hData, expName);
+    ret = (mhrVersion == 3) ? StoreMhrNative(&hData, expName) : StoreMhr(&hData, expName);
 
     return ret;
 }
 
+#ifdef MAKEMHR_LIBRARY
+
+int ConvertSofaHrtf(const char *inName, const char *outName)
+{
+    /* Streaming keeps the memory use down, which matters more in an app's
+     * process than the extra processing time.
+     */
+    return ProcessDefinition(inName, 0, CM_AllowStereo, DEFAULT_FFTSIZE, DEFAULT_EQUALIZE,
+        DEFAULT_SURFACE, DEFAULT_LIMIT, DEFAULT_TRUNCSIZE, DEFAULT_HEAD_MODEL,
+        DEFAULT_CUSTOM_RADIUS, 3, true, outName);
+}
+
+#else
+
 static void PrintHelp(const char *argv0, FILE *ofile)
 {
     fprintf(ofile, "Usage:  %s [<option>...]\n\n", argv0);
@@ -1648,6 +1698,15 @@ static void PrintHelp(const char *argv0, FILE *ofile)
     fprintf(ofile, " -i <filename>   Specify an HRIR definition file to use (defaults to stdin).\n");
     fprintf(ofile, " -o <filename>   Specify an output file. Use of '%%r' will be substituted with\n");
     fprintf(ofile, "                 the data set sample rate.\n");
+    fprintf(ofile, " -S              Stream SOFA inputs through equalization and reconstruction\n");
+    fprintf(ofile, "                 in chunks, holding only the time-domain responses in memory.\n");
+    fprintf(ofile, "                 Greatly reduces memory use for large data sets, but their\n");
+    fprintf(ofile, "                 magnitude responses are calculated multiple times.\n");
+    fprintf(ofile, " -j <threads>    Specify the number of threads to process HRIRs with\n");
+    fprintf(ofile, "                 (default: one per CPU).\n");
+    fprintf(ofile, " -v <version>    Specify the MHR format version to write (default: %u).\n", DEFAULT_MHR_VERSION);
+    fprintf(ofile, "                 Version 3 stores full-precision coefficients in the layout\n");
+    fprintf(ofile, "                 OpenAL Soft uses in memory, so it can be loaded without parsing.\n");
 }
 
 // Standard command line dispatch.
@@ -1660,6 +1719,8 @@ int main(int argc, char *argv[])
     ChannelModeT chanMode;
     HeadModelT model;
     uint truncSize;
+    uint mhrVersion;
+    bool stream;
     double radius;
     double limit;
     int opt;
@@ -1683,8 +1744,10 @@ int main(int argc, char *argv[])
     truncSize = DEFAULT_TRUNCSIZE;
     model = DEFAULT_HEAD_MODEL;
     radius = DEFAULT_CUSTOM_RADIUS;
+    mhrVersion = DEFAULT_MHR_VERSION;
+    stream = false;
 
-    while((opt=getopt(argc, argv, "r:mf:e:s:l:w:d:c:e:i:o:h")) != -1)
+    while((opt=getopt(argc, argv, "r:mf:e:s:l:w:d:c:e:i:o:Sj:v:h")) != -1)
     {
         switch(opt)
         {
@@ -1786,6 +1849,28 @@ int main(int argc, char *argv[])
             outName = optarg;
             break;
 
+        case 'S':
+            stream = true;
+            break;
+
+        case 'j':
+            NumThreads = static_cast<uint>(strtoul(optarg, &end, 10));
+            if(end[0] != '\0' || NumThreads < 1 || NumThreads > MAX_THREADS)
+            {
+                fprintf(stderr, "\nError: Got unexpected value \"%s\" for option -%c, expected between %u to %u.\n", optarg, opt, 1u, MAX_THREADS);
+                exit(EXIT_FAILURE);
+            }
+            break;
+
+        case 'v':
+            mhrVersion = strtoul(optarg, &end, 10);
+            if(end[0] != '\0' || (mhrVersion != 2 && mhrVersion != 3))
+            {
+                fprintf(stderr, "\nError: Got unexpected value \"%s\" for option -%c, expected 2 or 3.\n", optarg, opt);
+                exit(EXIT_FAILURE);
+            }
+            break;
+
         case 'h':
             PrintHelp(argv[0], stdout);
             exit(EXIT_SUCCESS);
@@ -1797,9 +1882,11 @@ int main(int argc, char *argv[])
     }
 
     int ret = ProcessDefinition(inName, outRate, chanMode, fftSize, equalize, surface, limit,
-        truncSize, model, radius, outName);
+        truncSize, model, radius, mhrVersion, stream, outName);
     if(!ret) return -1;
     fprintf(stdout, "Operation completed.\n");
 
     return EXIT_SUCCESS;
 }
+
+#endif /* MAKEMHR_LIBRARY */
@@ -1,8 +1,13 @@
 #ifndef MAKEMHR_H
 #define MAKEMHR_H
 
+#include <cstdio>
+#include <cstdarg>
 #include <vector>
 #include <complex>
+#include <functional>
+
+#include "polyphase_resampler.h"
 
 
 // The maximum path length used when processing filenames.
@@ -90,6 +95,10 @@ struct HrirDataT {
     uint mIrPoints{0u};
     uint mFftSize{0u};
     uint mIrSize{0u};
+    /* When set, the responses hold the time-domain measurements rather than
+     * magnitude responses, and mIrSize only needs to fit mIrPoints.
+     */
+    bool mTimeDomain{false};
     double mRadius{0.0};
     uint mIrCount{0u};
     uint mFdCount{0u};
@@ -107,19 +116,32 @@ void MagnitudeResponse(const uint n, const complex_d *in, double *out);
 void FftForward(const uint n, complex_d *inout);
 void FftInverse(const uint n, complex_d *inout);
 
-
-// The resampler metrics and FIR filter.
-struct ResamplerT {
-    uint mP, mQ, mM, mL;
-    std::vector<double> mF;
-};
-
-void ResamplerSetup(ResamplerT *rs, const uint srcRate, const uint dstRate);
-void ResamplerRun(ResamplerT *rs, const uint inN, const double *in, const uint outN, double *out);
+/* Calls func with each index below count, spread over the worker threads
+ * (set with the -j option), optionally reporting progress on stdout.
+ */
+void ParallelFor(const size_t count, const std::function<void(size_t)> &func,
+    const bool progress);
 
 
 // Performs linear interpolation.
 inline double Lerp(const double a, const double b, const double f)
 { return a + f * (b - a); }
 
+#ifdef MAKEMHR_LIBRARY
+/* When built into the library (to load SOFA files at runtime), the console
+ * output goes to the library's log instead.
+ */
+int MhrLogPrintf(const char *fmt, ...);
+int MhrLogFprintf(FILE *file, const char *fmt, ...);
+int MhrLogVfprintf(FILE *file, const char *fmt, va_list args);
+#define printf MhrLogPrintf
+#define fprintf MhrLogFprintf
+#define vfprintf MhrLogVfprintf
+
+/* Converts a SOFA file to a native (v3) MHR data set using the default
+ * processing options, writing it to outName. Returns 0 on failure.
+ */
+int ConvertSofaHrtf(const char *inName, const char *outName);
+#endif
+
 #endif /* MAKEMHR_H */
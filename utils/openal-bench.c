@@ -0,0 +1,891 @@
+/*
+ * OpenAL Mixer Benchmark Utility
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/* Renders a configurable scene on a loopback device as fast as possible, and
+ * prints the mixer's throughput as JSON. Nothing is played, so results don't
+ * depend on an audio device, and runs can be compared between releases or
+ * with CPU extensions disabled.
+ *
+ * A run can also save its output as a golden render, for a later run with
+ * different config options (e.g. a faster HRTF or reverb mode) to compare its
+ * output and speed against. With -E, the run fails unless its output matches
+ * the golden render exactly, for options that shouldn't change the output
+ * (e.g. mix-threads).
+ */
+
+/* For mkstemp, setenv, and clock_gettime. */
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "AL/alc.h"
+#include "AL/al.h"
+#include "AL/alext.h"
+#include "AL/efx.h"
+
+#include "getopt.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <time.h>
+#include <unistd.h>
+#endif
+
+#ifndef ALC_SOFT_loopback_bformat
+#define ALC_SOFT_loopback_bformat 1
+#define ALC_AMBISONIC_LAYOUT_SOFT                0x1997
+#define ALC_AMBISONIC_SCALING_SOFT               0x1998
+#define ALC_AMBISONIC_ORDER_SOFT                 0x1999
+#define ALC_MAX_AMBISONIC_ORDER_SOFT             0x199B
+#define ALC_BFORMAT3D_SOFT                       0x1508
+#define ALC_ACN_SOFT                             0x0001
+#define ALC_SN3D_SOFT                            0x0001
+#endif
+
+#ifndef M_PI
+#define M_PI    (3.14159265358979323846)
+#endif
+
+
+static LPALCLOOPBACKOPENDEVICESOFT alcLoopbackOpenDeviceSOFT;
+static LPALCISRENDERFORMATSUPPORTEDSOFT alcIsRenderFormatSupportedSOFT;
+static LPALCRENDERSAMPLESSOFT alcRenderSamplesSOFT;
+
+static LPALGETSTRINGISOFT alGetStringiSOFT;
+
+static LPALGENEFFECTS alGenEffects;
+static LPALDELETEEFFECTS alDeleteEffects;
+static LPALEFFECTI alEffecti;
+static LPALGENAUXILIARYEFFECTSLOTS alGenAuxiliaryEffectSlots;
+static LPALDELETEAUXILIARYEFFECTSLOTS alDeleteAuxiliaryEffectSlots;
+static LPALAUXILIARYEFFECTSLOTI alAuxiliaryEffectSloti;
+
+
+#define MAX_EFFECTS 4
+#define MAX_OPTIONS 16
+
+/* Golden renders start with this, then the header fields in host byte order,
+ * followed by the interleaved float samples.
+ */
+#define GOLDEN_MAGIC "ALBG"
+#define GOLDEN_VERSION 1
+
+typedef struct {
+    char magic[4];
+    ALuint version;
+    ALuint frequency;
+    ALuint channels;
+    ALuint frames;
+    ALuint pad;
+    double elapsed_ns;
+} GoldenHeader;
+
+/* Spectral differences are measured over windows of this many frames. */
+#define SPECTRUM_SIZE 1024
+
+typedef struct {
+    const char *name;
+    ALCenum value;
+    int count;
+} EnumName;
+
+static const EnumName ChannelNames[] = {
+    { "mono", ALC_MONO_SOFT, 1 },
+    { "stereo", ALC_STEREO_SOFT, 2 },
+    { "quad", ALC_QUAD_SOFT, 4 },
+    { "5.1", ALC_5POINT1_SOFT, 6 },
+    { "6.1", ALC_6POINT1_SOFT, 7 },
+    { "7.1", ALC_7POINT1_SOFT, 8 },
+    { NULL, 0, 0 }
+};
+
+static const EnumName TypeNames[] = {
+    { "byte", ALC_BYTE_SOFT, 1 },
+    { "ubyte", ALC_UNSIGNED_BYTE_SOFT, 1 },
+    { "short", ALC_SHORT_SOFT, 2 },
+    { "ushort", ALC_UNSIGNED_SHORT_SOFT, 2 },
+    { "int", ALC_INT_SOFT, 4 },
+    { "uint", ALC_UNSIGNED_INT_SOFT, 4 },
+    { "float", ALC_FLOAT_SOFT, 4 },
+    { NULL, 0, 0 }
+};
+
+static const EnumName EffectNames[] = {
+    { "reverb", AL_EFFECT_REVERB, 0 },
+    { "eaxreverb", AL_EFFECT_EAXREVERB, 0 },
+    { "chorus", AL_EFFECT_CHORUS, 0 },
+    { "echo", AL_EFFECT_ECHO, 0 },
+    { NULL, 0, 0 }
+};
+
+static const EnumName *FindName(const EnumName *names, const char *name)
+{
+    for(;names->name;++names)
+    {
+        if(strcmp(names->name, name) == 0)
+            return names;
+    }
+    return NULL;
+}
+
+
+/* Nanoseconds from a monotonic clock. */
+static double GetTimeNs(void)
+{
+#ifdef _WIN32
+    static LARGE_INTEGER freq;
+    LARGE_INTEGER count;
+    if(!freq.QuadPart)
+        QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&count);
+    return (double)count.QuadPart * 1000000000.0 / (double)freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec*1000000000.0 + (double)ts.tv_nsec;
+#endif
+}
+
+/* A small LCG, so runs use the same pitches and positions. */
+static unsigned int RandState = 22222u;
+static float RandFloat(void)
+{
+    RandState = RandState*1664525u + 1013904223u;
+    return (float)(RandState>>8) / 16777216.0f;
+}
+
+
+/* The mixer's CPU extensions and quality modes are only selectable with
+ * config options, so they're given to the library with a temporary config
+ * file named by ALSOFT_CONF. This must be done before the library is first
+ * used.
+ */
+static char ConfigPath[1024];
+
+static void RemoveConfig(void)
+{
+    if(ConfigPath[0])
+        remove(ConfigPath);
+}
+
+static int WriteConfig(const char *exts, char **options, int numoptions)
+{
+    int i;
+    FILE *file;
+
+#ifdef _WIN32
+    char tmpdir[MAX_PATH];
+    if(!GetTempPathA(MAX_PATH, tmpdir) || !GetTempFileNameA(tmpdir, "alb", 0, ConfigPath))
+        return 0;
+    file = fopen(ConfigPath, "w");
+#else
+    int fd;
+    const char *tmpdir = getenv("TMPDIR");
+    if(!tmpdir || !tmpdir[0]) tmpdir = "/tmp";
+    snprintf(ConfigPath, sizeof(ConfigPath), "%s/openal-bench-XXXXXX", tmpdir);
+    if((fd=mkstemp(ConfigPath)) == -1)
+    {
+        ConfigPath[0] = 0;
+        return 0;
+    }
+    file = fdopen(fd, "w");
+#endif
+    if(!file)
+    {
+        RemoveConfig();
+        return 0;
+    }
+    atexit(RemoveConfig);
+
+    if(exts)
+        fprintf(file, "disable-cpu-exts = %s\n", exts);
+    for(i = 0;i < numoptions;i++)
+    {
+        /* Keys may be given as section/key for options outside [general]. */
+        char *eq = strchr(options[i], '=');
+        *eq = 0;
+        fprintf(file, "%s = %s\n", options[i], eq+1);
+        *eq = '=';
+    }
+    fclose(file);
+
+#ifdef _WIN32
+    return _putenv_s("ALSOFT_CONF", ConfigPath) == 0;
+#else
+    return setenv("ALSOFT_CONF", ConfigPath, 1) == 0;
+#endif
+}
+
+
+static double maxd(double a, double b)
+{ return (a > b) ? a : b; }
+
+/* An in-place radix-2 FFT, for the spectral comparison. */
+static void ComplexFFT(double *re, double *im, int n)
+{
+    int i, j, k, len;
+
+    for(i = 1, j = 0;i < n;i++)
+    {
+        int bit = n >> 1;
+        for(;j & bit;bit >>= 1)
+            j ^= bit;
+        j ^= bit;
+        if(i < j)
+        {
+            double t = re[i]; re[i] = re[j]; re[j] = t;
+            t = im[i]; im[i] = im[j]; im[j] = t;
+        }
+    }
+    for(len = 2;len <= n;len <<= 1)
+    {
+        const double ang = -2.0*M_PI / len;
+        for(i = 0;i < n;i += len)
+        {
+            for(k = 0;k < len/2;k++)
+            {
+                const double wr = cos(ang*k), wi = sin(ang*k);
+                const double xr = re[i+k+len/2]*wr - im[i+k+len/2]*wi;
+                const double xi = re[i+k+len/2]*wi + im[i+k+len/2]*wr;
+                re[i+k+len/2] = re[i+k] - xr;
+                im[i+k+len/2] = im[i+k] - xi;
+                re[i+k] += xr;
+                im[i+k] += xi;
+            }
+        }
+    }
+}
+
+typedef struct {
+    double snr_db; /* HUGE_VAL when the outputs are identical. */
+    double max_diff;
+    double spectral_db;
+} Comparison;
+
+/* Compares rendered output against a golden render of the same format. The
+ * SNR treats the difference as noise. The spectral distance is the RMS
+ * difference of the Hann-windowed log magnitude spectra, in dB, averaged over
+ * the windows that aren't silent in the golden render.
+ */
+static Comparison CompareOutput(const float *golden, const float *test, int numchans,
+    long long frames)
+{
+    double re0[SPECTRUM_SIZE], im0[SPECTRUM_SIZE], re1[SPECTRUM_SIZE], im1[SPECTRUM_SIZE];
+    double signal = 0.0, noise = 0.0, spectral = 0.0;
+    long long i, windows = 0;
+    Comparison ret;
+    int c, k;
+
+    ret.max_diff = 0.0;
+    for(i = 0;i < frames*numchans;i++)
+    {
+        const double diff = (double)test[i] - (double)golden[i];
+        signal += (double)golden[i] * golden[i];
+        noise += diff * diff;
+        if(fabs(diff) > ret.max_diff)
+            ret.max_diff = fabs(diff);
+    }
+    ret.snr_db = (noise > 0.0) ? 10.0*log10(maxd(signal, 1e-30) / noise) : HUGE_VAL;
+
+    for(c = 0;c < numchans;c++)
+    {
+        for(i = 0;i+SPECTRUM_SIZE <= frames;i += SPECTRUM_SIZE)
+        {
+            double energy = 0.0, dist = 0.0;
+            for(k = 0;k < SPECTRUM_SIZE;k++)
+            {
+                const double w = 0.5 - 0.5*cos(2.0*M_PI * k / SPECTRUM_SIZE);
+                re0[k] = golden[(i+k)*numchans + c] * w;
+                re1[k] = test[(i+k)*numchans + c] * w;
+                im0[k] = im1[k] = 0.0;
+                energy += re0[k] * re0[k];
+            }
+            if(energy < 1e-10)
+                continue;
+
+            ComplexFFT(re0, im0, SPECTRUM_SIZE);
+            ComplexFFT(re1, im1, SPECTRUM_SIZE);
+            for(k = 0;k <= SPECTRUM_SIZE/2;k++)
+            {
+                const double m0 = 10.0*log10(re0[k]*re0[k] + im0[k]*im0[k] + 1e-12);
+                const double m1 = 10.0*log10(re1[k]*re1[k] + im1[k]*im1[k] + 1e-12);
+                dist += (m0-m1) * (m0-m1);
+            }
+            spectral += sqrt(dist / (SPECTRUM_SIZE/2 + 1));
+            ++windows;
+        }
+    }
+    ret.spectral_db = windows ? spectral / (double)windows : 0.0;
+    return ret;
+}
+
+
+static void PrintUsage(const char *argv0)
+{
+    fprintf(stderr,
+"Usage: %s [options]\n"
+"Options:\n"
+"  -t <seconds>    Seconds of audio to render (default 10)\n"
+"  -n <voices>     Number of playing sources (default 64)\n"
+"  -r <resampler>  Source resampler, by name (default is the library's)\n"
+"  -H              Enable HRTF (stereo output only)\n"
+"  -a <order>      Render B-Format of the given ambisonic order (1 to 3)\n"
+"  -c <channels>   Output channels: mono, stereo, quad, 5.1, 6.1, 7.1\n"
+"                  (default stereo)\n"
+"  -s <type>       Output sample type: byte, ubyte, short, ushort, int, uint,\n"
+"                  float (default float)\n"
+"  -f <rate>       Output sample rate (default 48000)\n"
+"  -u <samples>    Samples rendered per call (default 1024)\n"
+"  -e <effect>     Add an effect slot that every source sends to: reverb,\n"
+"                  eaxreverb, chorus, echo (up to %d)\n"
+"  -p <amount>     Vary each source's pitch randomly by up to +/-amount\n"
+"  -x <exts>       CPU extensions to disable (as the disable-cpu-exts option)\n"
+"  -O <key=value>  Set a config option, as section/key for sections other than\n"
+"                  [general] (up to %d)\n"
+"  -o <file>       Save the output as a golden render (float output only)\n"
+"  -g <file>       Compare the output and speed against a golden render of the\n"
+"                  same scene (float output only)\n"
+"  -E              Exit with status 2 unless the output is identical to the\n"
+"                  golden render (requires -g)\n",
+        argv0, MAX_EFFECTS, MAX_OPTIONS);
+}
+
+static void PrintJsonString(const char *str)
+{
+    putchar('"');
+    for(;*str;++str)
+    {
+        if(*str == '"' || *str == '\\')
+            printf("\\%c", *str);
+        else if((unsigned char)*str < 0x20)
+            printf("\\u%04x", (unsigned char)*str);
+        else
+            putchar(*str);
+    }
+    putchar('"');
+}
+
+
+int main(int argc, char *argv[])
+{
+    double seconds = 10.0;
+    int numvoices = 64;
+    const char *resampler = NULL;
+    int hrtf = 0;
+    int ambiorder = 0;
+    const EnumName *chans = FindName(ChannelNames, "stereo");
+    const EnumName *type = FindName(TypeNames, "float");
+    int rate = 48000;
+    int updatesize = 1024;
+    const EnumName *effects[MAX_EFFECTS];
+    int numeffects = 0;
+    float pitchvar = 0.0f;
+    const char *cpuexts = NULL;
+    char *options[MAX_OPTIONS];
+    int numoptions = 0;
+    const char *goldenout = NULL;
+    const char *goldenin = NULL;
+    int exact = 0;
+    GoldenHeader golden = { { 0 }, 0, 0, 0, 0, 0, 0.0 };
+    float *goldensamples = NULL;
+    float *rendered = NULL;
+    Comparison cmp = { 0.0, 0.0, 0.0 };
+
+    ALCdevice *device;
+    ALCcontext *context;
+    ALCint attrs[32];
+    ALCint *attr = attrs;
+    ALCint hrtfstate = 0;
+    ALint resampleridx = -1;
+    const char *resamplername = NULL;
+    ALuint effectids[MAX_EFFECTS], slotids[MAX_EFFECTS];
+    ALuint buffer, *sources;
+    ALshort *tone;
+    void *output;
+    int framesize, numchans;
+    long long total, done;
+    double start, elapsed;
+    int opt, i, j;
+
+    while((opt=getopt(argc, argv, "t:n:r:Ha:c:s:f:u:e:p:x:O:o:g:E")) != -1)
+    {
+        switch(opt)
+        {
+        case 't':
+            seconds = atof(optarg);
+            break;
+        case 'n':
+            numvoices = atoi(optarg);
+            break;
+        case 'r':
+            resampler = optarg;
+            break;
+        case 'H':
+            hrtf = 1;
+            break;
+        case 'a':
+            ambiorder = atoi(optarg);
+            if(ambiorder < 1 || ambiorder > 3)
+            {
+                fprintf(stderr, "Invalid ambisonic order: %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 'c':
+            if(!(chans=FindName(ChannelNames, optarg)))
+            {
+                fprintf(stderr, "Invalid channels: %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 's':
+            if(!(type=FindName(TypeNames, optarg)))
+            {
+                fprintf(stderr, "Invalid sample type: %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 'f':
+            rate = atoi(optarg);
+            break;
+        case 'u':
+            updatesize = atoi(optarg);
+            break;
+        case 'e':
+            if(numeffects == MAX_EFFECTS)
+            {
+                fprintf(stderr, "Too many effects (max %d)\n", MAX_EFFECTS);
+                return 1;
+            }
+            if(!(effects[numeffects]=FindName(EffectNames, optarg)))
+            {
+                fprintf(stderr, "Invalid effect: %s\n", optarg);
+                return 1;
+            }
+            ++numeffects;
+            break;
+        case 'p':
+            pitchvar = (float)atof(optarg);
+            break;
+        case 'x':
+            cpuexts = optarg;
+            break;
+        case 'O':
+            if(numoptions == MAX_OPTIONS)
+            {
+                fprintf(stderr, "Too many options (max %d)\n", MAX_OPTIONS);
+                return 1;
+            }
+            if(!strchr(optarg, '=') || optarg[0] == '=')
+            {
+                fprintf(stderr, "Invalid option, expected key=value: %s\n", optarg);
+                return 1;
+            }
+            options[numoptions++] = optarg;
+            break;
+        case 'o':
+            goldenout = optarg;
+            break;
+        case 'g':
+            goldenin = optarg;
+            break;
+        case 'E':
+            exact = 1;
+            break;
+        default:
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
+    if(optind < argc || seconds <= 0.0 || numvoices < 0 || rate < 8000 || updatesize < 1
+        || pitchvar < 0.0f || pitchvar >= 1.0f)
+    {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+    if(hrtf && (ambiorder > 0 || chans->value != ALC_STEREO_SOFT))
+    {
+        fprintf(stderr, "HRTF requires stereo output\n");
+        return 1;
+    }
+
+    if(exact && !goldenin)
+    {
+        fprintf(stderr, "-E needs a golden render to compare against (-g)\n");
+        return 1;
+    }
+    if((goldenout || goldenin) && type->value != ALC_FLOAT_SOFT)
+    {
+        fprintf(stderr, "Golden renders need float output\n");
+        return 1;
+    }
+
+    if((cpuexts || numoptions > 0) && !WriteConfig(cpuexts, options, numoptions))
+    {
+        fprintf(stderr, "Failed to create a config file for the options\n");
+        return 1;
+    }
+
+    if(!alcIsExtensionPresent(NULL, "ALC_SOFT_loopback"))
+    {
+        fprintf(stderr, "ALC_SOFT_loopback not supported\n");
+        return 1;
+    }
+#define LOAD_PROC(d, T, x)  ((x) = (T)alcGetProcAddress((d), #x))
+    LOAD_PROC(NULL, LPALCLOOPBACKOPENDEVICESOFT, alcLoopbackOpenDeviceSOFT);
+    LOAD_PROC(NULL, LPALCISRENDERFORMATSUPPORTEDSOFT, alcIsRenderFormatSupportedSOFT);
+    LOAD_PROC(NULL, LPALCRENDERSAMPLESSOFT, alcRenderSamplesSOFT);
+#undef LOAD_PROC
+
+    device = alcLoopbackOpenDeviceSOFT(NULL);
+    if(!device)
+    {
+        fprintf(stderr, "Failed to open a loopback device\n");
+        return 1;
+    }
+
+    numchans = chans->count;
+    if(ambiorder > 0)
+    {
+        /* ALC_SOFT_loopback_bformat is still in progress and isn't advertised,
+         * so just see if the context can be created with it.
+         */
+        numchans = (ambiorder+1) * (ambiorder+1);
+        *(attr++) = ALC_FORMAT_CHANNELS_SOFT;
+        *(attr++) = ALC_BFORMAT3D_SOFT;
+        *(attr++) = ALC_AMBISONIC_LAYOUT_SOFT;
+        *(attr++) = ALC_ACN_SOFT;
+        *(attr++) = ALC_AMBISONIC_SCALING_SOFT;
+        *(attr++) = ALC_SN3D_SOFT;
+        *(attr++) = ALC_AMBISONIC_ORDER_SOFT;
+        *(attr++) = ambiorder;
+    }
+    else
+    {
+        if(!alcIsRenderFormatSupportedSOFT(device, rate, chans->value, type->value))
+        {
+            fprintf(stderr, "Unsupported render format: %s %s %dhz\n", chans->name,
+                type->name, rate);
+            alcCloseDevice(device);
+            return 1;
+        }
+        *(attr++) = ALC_FORMAT_CHANNELS_SOFT;
+        *(attr++) = chans->value;
+    }
+    *(attr++) = ALC_FORMAT_TYPE_SOFT;
+    *(attr++) = type->value;
+    *(attr++) = ALC_FREQUENCY;
+    *(attr++) = rate;
+    *(attr++) = ALC_MONO_SOURCES;
+    *(attr++) = numvoices;
+    *(attr++) = ALC_MAX_AUXILIARY_SENDS;
+    *(attr++) = MAX_EFFECTS;
+    if(alcIsExtensionPresent(device, "ALC_SOFT_HRTF"))
+    {
+        *(attr++) = ALC_HRTF_SOFT;
+        *(attr++) = hrtf ? ALC_TRUE : ALC_FALSE;
+    }
+    *(attr++) = 0;
+
+    context = alcCreateContext(device, attrs);
+    if(!context || alcMakeContextCurrent(context) == ALC_FALSE)
+    {
+        fprintf(stderr, "Failed to set up a context\n");
+        if(context)
+            alcDestroyContext(context);
+        alcCloseDevice(device);
+        return 1;
+    }
+    if(alcIsExtensionPresent(device, "ALC_SOFT_HRTF"))
+        alcGetIntegerv(device, ALC_HRTF_SOFT, 1, &hrtfstate);
+    if(hrtf && !hrtfstate)
+        fprintf(stderr, "HRTF requested, but not enabled\n");
+
+    if(alIsExtensionPresent("AL_SOFT_source_resampler"))
+    {
+        ALint numresamplers = 0;
+
+        alGetStringiSOFT = (LPALGETSTRINGISOFT)alGetProcAddress("alGetStringiSOFT");
+        numresamplers = alGetInteger(AL_NUM_RESAMPLERS_SOFT);
+        resampleridx = alGetInteger(AL_DEFAULT_RESAMPLER_SOFT);
+        if(resampler)
+        {
+            for(i = 0;i < numresamplers;i++)
+            {
+                if(strcmp(alGetStringiSOFT(AL_RESAMPLER_NAME_SOFT, i), resampler) == 0)
+                    break;
+            }
+            if(i == numresamplers)
+            {
+                fprintf(stderr, "Unknown resampler \"%s\", available:\n", resampler);
+                for(i = 0;i < numresamplers;i++)
+                    fprintf(stderr, "    %s\n", alGetStringiSOFT(AL_RESAMPLER_NAME_SOFT, i));
+                alcMakeContextCurrent(NULL);
+                alcDestroyContext(context);
+                alcCloseDevice(device);
+                return 1;
+            }
+            resampleridx = i;
+        }
+        resamplername = alGetStringiSOFT(AL_RESAMPLER_NAME_SOFT, resampleridx);
+    }
+    else if(resampler)
+        fprintf(stderr, "AL_SOFT_source_resampler not supported, ignoring resampler\n");
+
+    if(numeffects > 0)
+    {
+        if(!alcIsExtensionPresent(device, "ALC_EXT_EFX"))
+        {
+            fprintf(stderr, "ALC_EXT_EFX not supported\n");
+            alcMakeContextCurrent(NULL);
+            alcDestroyContext(context);
+            alcCloseDevice(device);
+            return 1;
+        }
+#define LOAD_PROC(T, x)  ((x) = (T)alGetProcAddress(#x))
+        LOAD_PROC(LPALGENEFFECTS, alGenEffects);
+        LOAD_PROC(LPALDELETEEFFECTS, alDeleteEffects);
+        LOAD_PROC(LPALEFFECTI, alEffecti);
+        LOAD_PROC(LPALGENAUXILIARYEFFECTSLOTS, alGenAuxiliaryEffectSlots);
+        LOAD_PROC(LPALDELETEAUXILIARYEFFECTSLOTS, alDeleteAuxiliaryEffectSlots);
+        LOAD_PROC(LPALAUXILIARYEFFECTSLOTI, alAuxiliaryEffectSloti);
+#undef LOAD_PROC
+
+        alGenEffects(numeffects, effectids);
+        alGenAuxiliaryEffectSlots(numeffects, slotids);
+        for(i = 0;i < numeffects;i++)
+        {
+            alEffecti(effectids[i], AL_EFFECT_TYPE, effects[i]->value);
+            alAuxiliaryEffectSloti(slotids[i], AL_EFFECTSLOT_EFFECT, (ALint)effectids[i]);
+        }
+    }
+
+    /* A second of a 16-bit 440hz tone, for every source to loop. */
+    tone = malloc(sizeof(ALshort) * rate);
+    for(i = 0;i < rate;i++)
+        tone[i] = (ALshort)(sin(2.0*M_PI * 440.0 * i / rate) * 16383.0);
+    alGenBuffers(1, &buffer);
+    alBufferData(buffer, AL_FORMAT_MONO16, tone, (ALsizei)(sizeof(ALshort)*rate), rate);
+    free(tone);
+
+    /* Spread the sources around the listener, so each is panned differently. */
+    sources = calloc(numvoices ? numvoices : 1, sizeof(ALuint));
+    alGenSources(numvoices, sources);
+    for(i = 0;i < numvoices;i++)
+    {
+        const float angle = (float)(2.0*M_PI) * RandFloat();
+        const float dist = 1.0f + 9.0f*RandFloat();
+
+        alSourcei(sources[i], AL_BUFFER, (ALint)buffer);
+        alSourcei(sources[i], AL_LOOPING, AL_TRUE);
+        alSource3f(sources[i], AL_POSITION, sinf(angle)*dist, 0.0f, -cosf(angle)*dist);
+        if(pitchvar > 0.0f)
+            alSourcef(sources[i], AL_PITCH, 1.0f + pitchvar*(RandFloat()*2.0f - 1.0f));
+        if(resampleridx >= 0)
+            alSourcei(sources[i], AL_SOURCE_RESAMPLER_SOFT, resampleridx);
+        for(j = 0;j < numeffects;j++)
+            alSource3i(sources[i], AL_AUXILIARY_SEND_FILTER, (ALint)slotids[j], j,
+                AL_FILTER_NULL);
+    }
+    if(numvoices > 0)
+        alSourcePlayv(numvoices, sources);
+    if(alGetError() != AL_NO_ERROR)
+    {
+        fprintf(stderr, "Failed to set up the sources\n");
+        return 1;
+    }
+
+    framesize = numchans * type->count;
+    output = malloc((size_t)framesize * (size_t)updatesize);
+    total = (long long)(seconds * rate);
+
+    /* Render a bit beforehand, so the sources are playing and any lazily
+     * allocated mixing state is ready before timing starts.
+     */
+    alcRenderSamplesSOFT(device, output, updatesize);
+
+    /* Golden renders keep the whole output, rather than overwriting the same
+     * update. It's allocated before timing starts, so it only costs the
+     * memory traffic.
+     */
+    if(goldenout || goldenin)
+    {
+        rendered = calloc((size_t)total, (size_t)framesize);
+        if(!rendered)
+        {
+            fprintf(stderr, "Failed to allocate %lld frames of output\n", total);
+            return 1;
+        }
+    }
+
+    start = GetTimeNs();
+    for(done = 0;done < total;)
+    {
+        const int todo = (int)((total-done < updatesize) ? total-done : updatesize);
+        alcRenderSamplesSOFT(device, rendered ? (void*)(rendered + done*numchans) : output,
+            todo);
+        done += todo;
+    }
+    elapsed = GetTimeNs() - start;
+    if(elapsed <= 0.0) elapsed = 1.0;
+
+    if(goldenin)
+    {
+        FILE *file = fopen(goldenin, "rb");
+        if(!file)
+        {
+            fprintf(stderr, "Failed to open %s\n", goldenin);
+            return 1;
+        }
+        if(fread(&golden, sizeof(golden), 1, file) != 1 ||
+           memcmp(golden.magic, GOLDEN_MAGIC, 4) != 0 || golden.version != GOLDEN_VERSION)
+        {
+            fprintf(stderr, "%s is not a golden render\n", goldenin);
+            fclose(file);
+            return 1;
+        }
+        if(golden.frequency != (ALuint)rate || golden.channels != (ALuint)numchans ||
+           golden.frames != (ALuint)total)
+        {
+            fprintf(stderr, "%s has a different format or length (%uhz, %u channels, %u frames)\n",
+                goldenin, golden.frequency, golden.channels, golden.frames);
+            fclose(file);
+            return 1;
+        }
+        goldensamples = malloc((size_t)total * (size_t)framesize);
+        if(!goldensamples || fread(goldensamples, (size_t)framesize, (size_t)total, file)
+            != (size_t)total)
+        {
+            fprintf(stderr, "Failed to read %s\n", goldenin);
+            fclose(file);
+            return 1;
+        }
+        fclose(file);
+
+        cmp = CompareOutput(goldensamples, rendered, numchans, total);
+        free(goldensamples);
+    }
+
+    if(goldenout)
+    {
+        FILE *file = fopen(goldenout, "wb");
+        GoldenHeader hdr;
+
+        memset(&hdr, 0, sizeof(hdr));
+        memcpy(hdr.magic, GOLDEN_MAGIC, 4);
+        hdr.version = GOLDEN_VERSION;
+        hdr.frequency = (ALuint)rate;
+        hdr.channels = (ALuint)numchans;
+        hdr.frames = (ALuint)total;
+        hdr.elapsed_ns = elapsed;
+        if(!file || fwrite(&hdr, sizeof(hdr), 1, file) != 1 ||
+           fwrite(rendered, (size_t)framesize, (size_t)total, file) != (size_t)total)
+        {
+            fprintf(stderr, "Failed to write %s\n", goldenout);
+            if(file) fclose(file);
+            return 1;
+        }
+        fclose(file);
+    }
+
+    printf("{\n");
+    printf("  \"seconds\": %g,\n", (double)total / rate);
+    printf("  \"voices\": %d,\n", numvoices);
+    printf("  \"resampler\": ");
+    if(resamplername) PrintJsonString(resamplername);
+    else printf("null");
+    printf(",\n");
+    printf("  \"hrtf\": %s,\n", hrtfstate ? "true" : "false");
+    printf("  \"ambisonic_order\": %d,\n", ambiorder);
+    printf("  \"channels\": \"%s\",\n", (ambiorder > 0) ? "bformat3d" : chans->name);
+    printf("  \"sample_type\": \"%s\",\n", type->name);
+    printf("  \"frequency\": %d,\n", rate);
+    printf("  \"update_size\": %d,\n", updatesize);
+    printf("  \"effects\": [");
+    for(i = 0;i < numeffects;i++)
+        printf("%s\"%s\"", i ? ", " : "", effects[i]->name);
+    printf("],\n");
+    printf("  \"pitch_variation\": %g,\n", pitchvar);
+    printf("  \"disabled_cpu_exts\": ");
+    if(cpuexts) PrintJsonString(cpuexts);
+    else printf("null");
+    printf(",\n");
+    printf("  \"options\": [");
+    for(i = 0;i < numoptions;i++)
+    {
+        printf("%s", i ? ", " : "");
+        PrintJsonString(options[i]);
+    }
+    printf("],\n");
+    if(goldenin)
+    {
+        printf("  \"golden\": ");
+        PrintJsonString(goldenin);
+        printf(",\n");
+        printf("  \"snr_db\": ");
+        if(cmp.snr_db == HUGE_VAL) printf("null");
+        else printf("%.2f", cmp.snr_db);
+        printf(",\n");
+        printf("  \"identical\": %s,\n", (cmp.snr_db == HUGE_VAL) ? "true" : "false");
+        printf("  \"max_abs_diff\": %g,\n", cmp.max_diff);
+        printf("  \"spectral_distance_db\": %.3f,\n", cmp.spectral_db);
+        printf("  \"golden_elapsed_ns\": %.0f,\n", golden.elapsed_ns);
+        printf("  \"speedup\": %.3f,\n", golden.elapsed_ns / elapsed);
+    }
+    printf("  \"elapsed_ns\": %.0f,\n", elapsed);
+    printf("  \"samples_per_sec\": %.1f,\n", (double)total * 1000000000.0 / elapsed);
+    printf("  \"ns_per_voice_sample\": ");
+    if(numvoices > 0) printf("%.3f", elapsed / ((double)total * numvoices));
+    else printf("null");
+    printf(",\n");
+    printf("  \"realtime_factor\": %.2f\n", (double)total / rate * 1000000000.0 / elapsed);
+    printf("}\n");
+
+    free(rendered);
+    free(output);
+    alDeleteSources(numvoices, sources);
+    free(sources);
+    alDeleteBuffers(1, &buffer);
+    if(numeffects > 0)
+    {
+        alDeleteAuxiliaryEffectSlots(numeffects, slotids);
+        alDeleteEffects(numeffects, effectids);
+    }
+
+    alcMakeContextCurrent(NULL);
+    alcDestroyContext(context);
+    alcCloseDevice(device);
+
+    if(exact && cmp.snr_db != HUGE_VAL)
+    {
+        fprintf(stderr, "Output differs from %s\n", goldenin);
+        return 2;
+    }
+    return 0;
+}
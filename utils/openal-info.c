@@ -22,9 +22,16 @@
  * THE SOFTWARE.
  */
 
+/* For clock_gettime. */
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <math.h>
+#include <time.h>
 
 #include "AL/alc.h"
 #include "AL/al.h"
@@ -41,6 +48,12 @@
 #define ALC_MAX_AUXILIARY_SENDS                  0x20003
 #endif
 
+#ifndef ALC_SOFT_kernel_info
+#define ALC_SOFT_kernel_info
+#define ALC_CPU_EXTENSIONS_SOFT                  0x19B6
+#define ALC_MIXER_KERNELS_SOFT                   0x19B7
+#endif
+
 
 #ifdef _WIN32
 #define WIN32_LEAN_AND_MEAN
@@ -375,6 +388,213 @@ static void printEFXInfo(ALCdevice *device)
     printList(effectNames, ',');
 }
 
+/* The alsoftrc names of the resamplers, in the order they're listed by
+ * AL_RESAMPLER_NAME_SOFT.
+ */
+static const char ResamplerOptions[][8] = {
+    "point", "linear", "cubic", "bsinc12", "bsinc24", "bsinc32"
+};
+
+#define PERF_VOICES         64
+#define PERF_RATE           48000
+#define PERF_UPDATE_SIZE    1024
+#define PERF_UPDATES        24
+#define PERF_MAX_RESAMPLERS 8
+/* Recommended settings should leave half the CPU time for the app. */
+#define PERF_TARGET_VOICES  256
+
+static char PerfResamplerNames[PERF_MAX_RESAMPLERS][32];
+
+static double getTimeSeconds(void)
+{
+#ifdef _WIN32
+    static LARGE_INTEGER freq;
+    LARGE_INTEGER count;
+    if(!freq.QuadPart)
+        QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&count);
+    return (double)count.QuadPart / (double)freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec/1000000000.0;
+#endif
+}
+
+/* Plays PERF_VOICES looping mono sources around the listener on a stereo
+ * loopback device with each resampler, and stores how many voices the mixer
+ * could render in real time. Returns the number of resamplers measured, or 0
+ * if the device couldn't be set up (e.g. HRTF is unavailable).
+ */
+static ALint measureVoices(ALCboolean hrtf, double *voices)
+{
+    LPALCLOOPBACKOPENDEVICESOFT alcLoopbackOpenDeviceSOFT;
+    LPALCRENDERSAMPLESSOFT alcRenderSamplesSOFT;
+    LPALGETSTRINGISOFT alGetStringiSOFT = NULL;
+    ALCint attrs[] = {
+        ALC_FORMAT_CHANNELS_SOFT, ALC_STEREO_SOFT,
+        ALC_FORMAT_TYPE_SOFT, ALC_FLOAT_SOFT,
+        ALC_FREQUENCY, PERF_RATE,
+        ALC_HRTF_SOFT, hrtf,
+        ALC_MONO_SOURCES, PERF_VOICES,
+        0
+    };
+    ALuint sources[PERF_VOICES];
+    ALCdevice *device;
+    ALCcontext *context;
+    ALCint hrtfstate = ALC_FALSE;
+    ALint num_resamplers = 1;
+    unsigned int seed = 22222u;
+    ALshort *data;
+    float *out;
+    ALuint buffer;
+    ALint i, r;
+
+    if(alcIsExtensionPresent(NULL, "ALC_SOFT_loopback") == ALC_FALSE)
+        return 0;
+    alcLoopbackOpenDeviceSOFT = alcGetProcAddress(NULL, "alcLoopbackOpenDeviceSOFT");
+    alcRenderSamplesSOFT = alcGetProcAddress(NULL, "alcRenderSamplesSOFT");
+
+    device = alcLoopbackOpenDeviceSOFT(NULL);
+    if(!device) return 0;
+    context = alcCreateContext(device, attrs);
+    if(!context || alcMakeContextCurrent(context) == ALC_FALSE)
+    {
+        if(context)
+            alcDestroyContext(context);
+        alcCloseDevice(device);
+        return 0;
+    }
+    if(alcIsExtensionPresent(device, "ALC_SOFT_HRTF") != ALC_FALSE)
+        alcGetIntegerv(device, ALC_HRTF_SOFT, 1, &hrtfstate);
+    if(hrtfstate != hrtf)
+    {
+        alcMakeContextCurrent(NULL);
+        alcDestroyContext(context);
+        alcCloseDevice(device);
+        return 0;
+    }
+
+    if(alIsExtensionPresent("AL_SOFT_source_resampler"))
+    {
+        alGetStringiSOFT = alGetProcAddress("alGetStringiSOFT");
+        num_resamplers = alGetInteger(AL_NUM_RESAMPLERS_SOFT);
+        if(num_resamplers > PERF_MAX_RESAMPLERS)
+            num_resamplers = PERF_MAX_RESAMPLERS;
+    }
+
+    /* A second of 44.1khz noise, so every voice needs resampling. */
+    data = malloc(44100 * sizeof(*data));
+    for(i = 0;i < 44100;++i)
+    {
+        seed = seed*96314165u + 907633515u;
+        data[i] = (ALshort)((seed>>16) - 32768) / 4;
+    }
+    alGenBuffers(1, &buffer);
+    alBufferData(buffer, AL_FORMAT_MONO16, data, 44100*sizeof(*data), 44100);
+    free(data);
+
+    alGenSources(PERF_VOICES, sources);
+    for(i = 0;i < PERF_VOICES;++i)
+    {
+        const float angle = (float)i * 6.28318530718f / (float)PERF_VOICES;
+        alSource3f(sources[i], AL_POSITION, sinf(angle), 0.0f, -cosf(angle));
+        alSourcei(sources[i], AL_LOOPING, AL_TRUE);
+        alSourcei(sources[i], AL_BUFFER, (ALint)buffer);
+    }
+
+    out = malloc(PERF_UPDATE_SIZE * 2 * sizeof(*out));
+    for(r = 0;r < num_resamplers;++r)
+    {
+        double start, elapsed;
+
+        if(alGetStringiSOFT)
+        {
+            snprintf(PerfResamplerNames[r], sizeof(PerfResamplerNames[r]), "%s",
+                alGetStringiSOFT(AL_RESAMPLER_NAME_SOFT, r));
+            for(i = 0;i < PERF_VOICES;++i)
+                alSourcei(sources[i], AL_SOURCE_RESAMPLER_SOFT, r);
+        }
+        else
+            snprintf(PerfResamplerNames[r], sizeof(PerfResamplerNames[r]), "Default");
+
+        alSourcePlayv(PERF_VOICES, sources);
+        /* The first update fades in the new voices. */
+        alcRenderSamplesSOFT(device, out, PERF_UPDATE_SIZE);
+        start = getTimeSeconds();
+        for(i = 0;i < PERF_UPDATES;++i)
+            alcRenderSamplesSOFT(device, out, PERF_UPDATE_SIZE);
+        elapsed = getTimeSeconds() - start;
+        alSourceStopv(PERF_VOICES, sources);
+
+        voices[r] = PERF_VOICES * ((double)(PERF_UPDATES*PERF_UPDATE_SIZE) / PERF_RATE) /
+            ((elapsed > 0.0) ? elapsed : 1e-9);
+    }
+    free(out);
+    checkALErrors();
+
+    alDeleteSources(PERF_VOICES, sources);
+    alDeleteBuffers(1, &buffer);
+    alcMakeContextCurrent(NULL);
+    alcDestroyContext(context);
+    alcCloseDevice(device);
+
+    return num_resamplers;
+}
+
+static void printPerfInfo(void)
+{
+    double voices[PERF_MAX_RESAMPLERS], hrtfvoices[PERF_MAX_RESAMPLERS];
+    ALint num_resamplers, num_hrtf, best, i;
+
+    printf("CPU extensions:");
+    if(alcIsExtensionPresent(NULL, "ALC_SOFTX_kernel_info") == ALC_FALSE)
+        printf(" not available\n");
+    else
+    {
+        printList(alcGetString(NULL, ALC_CPU_EXTENSIONS_SOFT), ' ');
+        printf("Mixer kernels:");
+        printList(alcGetString(NULL, ALC_MIXER_KERNELS_SOFT), ' ');
+    }
+
+    num_resamplers = measureVoices(ALC_FALSE, voices);
+    if(num_resamplers == 0)
+    {
+        printf("\n!!! Failed to open a loopback device !!!\n\n");
+        return;
+    }
+    num_hrtf = measureVoices(ALC_TRUE, hrtfvoices);
+
+    printf("Voices mixed in real time (%d voices, %dhz stereo):\n", PERF_VOICES, PERF_RATE);
+    printf("    %-24s %10s %10s\n", "Resampler", "Panned", "HRTF");
+    for(i = 0;i < num_resamplers;++i)
+    {
+        if(i < num_hrtf)
+            printf("    %-24s %10.0f %10.0f\n", PerfResamplerNames[i], voices[i], hrtfvoices[i]);
+        else
+            printf("    %-24s %10.0f %10s\n", PerfResamplerNames[i], voices[i], "n/a");
+    }
+
+    /* Recommend the highest quality resampler that can mix the target voice
+     * count using at most half the time, with HRTF if it can too.
+     */
+    best = 0;
+    for(i = 1;i < num_resamplers;++i)
+    {
+        if(voices[i] >= PERF_TARGET_VOICES*2)
+            best = i;
+    }
+    printf("Recommended settings (for %d voices):\n", PERF_TARGET_VOICES);
+    if(num_resamplers <= (ALint)(sizeof(ResamplerOptions)/sizeof(ResamplerOptions[0])))
+        printf("    resampler = %s\n", ResamplerOptions[best]);
+    else
+        printf("    resampler = %s\n", PerfResamplerNames[best]);
+    if(best < num_hrtf && hrtfvoices[best] >= PERF_TARGET_VOICES*2)
+        printf("    hrtf = auto\n");
+    else if(num_hrtf > 0)
+        printf("    hrtf = false\n");
+}
+
 int main(int argc, char *argv[])
 {
     ALCdevice *device;
@@ -383,7 +603,15 @@ int main(int argc, char *argv[])
     if(argc > 1 && (strcmp(argv[1], "--help") == 0 ||
                     strcmp(argv[1], "-h") == 0))
     {
-        printf("Usage: %s [playback device]\n", argv[0]);
+        printf("Usage: %s [playback device]\n"
+               "       %s --perf\n\n"
+               "  --perf  Time the mixer on this machine and recommend settings\n",
+               argv[0], argv[0]);
+        return 0;
+    }
+    if(argc > 1 && strcmp(argv[1], "--perf") == 0)
+    {
+        printPerfInfo();
         return 0;
     }
 
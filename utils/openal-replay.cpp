@@ -0,0 +1,706 @@
+/*
+ * OpenAL Call Replay Utility
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/* Replays a trace recorded with ALSOFT_RECORD_FILE on loopback devices, as
+ * fast as possible. Each device renders up to the time a call was made at
+ * before the call is replayed, so the mixer goes through the same load as it
+ * did for the app, and prints the time taken as JSON. Buffer data is made up
+ * from the recorded hashes, so it's noise in place of the app's audio.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <vector>
+
+#define AL_ALEXT_PROTOTYPES
+#include "AL/alc.h"
+#include "AL/al.h"
+#include "AL/alext.h"
+#include "AL/efx.h"
+
+#include "callrecord.h"
+
+
+namespace {
+
+struct ReplayDevice {
+    ALCdevice *Device{nullptr};
+    ALCuint Frequency{0u};
+    ALCsizei UpdateSize{0};
+    std::vector<float> Output;
+    uint64_t Rendered{0u};
+
+    /* Buffers, effects, and filters belong to the device, so their IDs are
+     * shared by its contexts.
+     */
+    std::map<ALuint,ALuint> Buffers, Effects, Filters;
+};
+
+struct ReplayContext {
+    ALCcontext *Context{nullptr};
+    ReplayDevice *Device{nullptr};
+    std::map<ALuint,ALuint> Sources, EffectSlots;
+};
+
+std::map<ALuint,std::unique_ptr<ReplayDevice>> Devices;
+std::map<ALuint,ReplayContext> Contexts;
+
+std::chrono::nanoseconds RenderTime{0};
+uint64_t NumRecords{0u};
+uint64_t NumSkipped{0u};
+
+
+/* Reads values out of a record's payload, failing instead of reading past
+ * the end.
+ */
+class PayloadReader {
+    const char *mPos;
+    const char *mEnd;
+    bool mOk{true};
+
+public:
+    PayloadReader(const std::vector<char> &data) : mPos{data.data()}, mEnd{data.data()+data.size()}
+    { }
+
+    template<typename T>
+    T get()
+    {
+        T ret{};
+        if(static_cast<size_t>(mEnd-mPos) < sizeof(T))
+            mOk = false;
+        else
+        {
+            memcpy(&ret, mPos, sizeof(T));
+            mPos += sizeof(T);
+        }
+        return ret;
+    }
+
+    template<typename T>
+    std::vector<T> getArray(ALsizei count)
+    {
+        std::vector<T> ret;
+        if(count < 0 || static_cast<size_t>(mEnd-mPos)/sizeof(T) < static_cast<size_t>(count))
+            mOk = false;
+        else
+        {
+            ret.resize(static_cast<size_t>(count));
+            for(auto &val : ret)
+                val = get<T>();
+        }
+        return ret;
+    }
+
+    bool ok() const noexcept { return mOk; }
+};
+
+
+/* IDs the trace doesn't know of (e.g. made before a context was recorded) map
+ * to one that's never valid, so the call fails instead of hitting some other
+ * object.
+ */
+ALuint MapId(const std::map<ALuint,ALuint> &ids, ALuint id)
+{
+    if(!id) return 0;
+    auto iter = ids.find(id);
+    return (iter != ids.end()) ? iter->second : ~0u;
+}
+
+std::map<ALuint,ALuint> &GetIdMap(ReplayContext &ctx, RecordObject obj)
+{
+    switch(obj)
+    {
+    case RecordObject::Buffer: return ctx.Device->Buffers;
+    case RecordObject::Effect: return ctx.Device->Effects;
+    case RecordObject::Filter: return ctx.Device->Filters;
+    case RecordObject::EffectSlot: return ctx.EffectSlots;
+    case RecordObject::Source:
+    case RecordObject::Listener:
+        break;
+    }
+    return ctx.Sources;
+}
+
+/* Maps the object IDs that some integer properties take. */
+template<typename T>
+void MapParamIds(ReplayContext &ctx, RecordObject obj, ALenum param, std::vector<T> &values)
+{
+    if(obj == RecordObject::Source)
+    {
+        if(param == AL_BUFFER && values.size() >= 1)
+            values[0] = static_cast<T>(MapId(ctx.Device->Buffers, static_cast<ALuint>(values[0])));
+        else if(param == AL_DIRECT_FILTER && values.size() >= 1)
+            values[0] = static_cast<T>(MapId(ctx.Device->Filters, static_cast<ALuint>(values[0])));
+        else if(param == AL_AUXILIARY_SEND_FILTER && values.size() >= 3)
+        {
+            values[0] = static_cast<T>(MapId(ctx.EffectSlots, static_cast<ALuint>(values[0])));
+            values[2] = static_cast<T>(MapId(ctx.Device->Filters, static_cast<ALuint>(values[2])));
+        }
+    }
+    else if(obj == RecordObject::EffectSlot && values.size() >= 1)
+    {
+        if(param == AL_EFFECTSLOT_EFFECT)
+            values[0] = static_cast<T>(MapId(ctx.Device->Effects, static_cast<ALuint>(values[0])));
+        else if(param == AL_EFFECTSLOT_TARGET_SOFT)
+            values[0] = static_cast<T>(MapId(ctx.EffectSlots, static_cast<ALuint>(values[0])));
+        else if(param == AL_BUFFER)
+            values[0] = static_cast<T>(MapId(ctx.Device->Buffers, static_cast<ALuint>(values[0])));
+    }
+}
+
+
+/* Makes up a buffer's data from its hash, so identical uploads get identical
+ * data. Float formats get samples in range, since arbitrary bits could make
+ * denormals or NaNs that change the mixer's load.
+ */
+std::vector<char> MakeBufferData(ALenum format, ALsizei size, uint64_t hash)
+{
+    std::vector<char> data(static_cast<size_t>(size));
+    uint64_t state{hash};
+    auto next_rand = [&state]() -> uint32_t
+    {
+        state = state*6364136223846793005ull + 1442695040888963407ull;
+        return static_cast<uint32_t>(state >> 32);
+    };
+
+    switch(format)
+    {
+    case AL_FORMAT_MONO_FLOAT32:
+    case AL_FORMAT_STEREO_FLOAT32:
+    case AL_FORMAT_REAR32:
+    case AL_FORMAT_QUAD32:
+    case AL_FORMAT_51CHN32:
+    case AL_FORMAT_61CHN32:
+    case AL_FORMAT_71CHN32:
+    case AL_FORMAT_BFORMAT2D_FLOAT32:
+    case AL_FORMAT_BFORMAT3D_FLOAT32:
+        for(size_t i{0};i+sizeof(float) <= data.size();i += sizeof(float))
+        {
+            const float val{static_cast<float>(next_rand()>>8)/8388608.0f - 1.0f};
+            memcpy(&data[i], &val, sizeof(val));
+        }
+        break;
+
+    case AL_FORMAT_MONO_DOUBLE_EXT:
+    case AL_FORMAT_STEREO_DOUBLE_EXT:
+        for(size_t i{0};i+sizeof(double) <= data.size();i += sizeof(double))
+        {
+            const double val{static_cast<double>(next_rand()>>8)/8388608.0 - 1.0};
+            memcpy(&data[i], &val, sizeof(val));
+        }
+        break;
+
+    default:
+        for(auto &val : data)
+            val = static_cast<char>(next_rand()>>24);
+        break;
+    }
+    return data;
+}
+
+
+bool CreateContext(ALuint index, PayloadReader &reader)
+{
+    const auto devindex = reader.get<ALuint>();
+    const auto frequency = reader.get<ALuint>();
+    auto channels = reader.get<ALuint>();
+    const auto ambiorder = reader.get<ALuint>();
+    const auto updatesize = reader.get<ALuint>();
+    const auto hrtf = reader.get<ALuint>();
+    const auto monos = reader.get<ALuint>();
+    const auto stereos = reader.get<ALuint>();
+    const auto sends = reader.get<ALuint>();
+    if(!reader.ok()) return false;
+
+    /* 5.1 with rear channels is output as the usual 5.1 on loopback. */
+    if(channels == 0x80000000u)
+        channels = ALC_5POINT1_SOFT;
+
+    std::unique_ptr<ReplayDevice> &device = Devices[devindex];
+    if(!device)
+    {
+        device.reset(new ReplayDevice{});
+        device->Device = alcLoopbackOpenDeviceSOFT(nullptr);
+        if(!device->Device)
+        {
+            fprintf(stderr, "Failed to open a loopback device\n");
+            return false;
+        }
+    }
+
+    ALCint attrs[32];
+    ALCint *attr{attrs};
+    *(attr++) = ALC_FREQUENCY;
+    *(attr++) = static_cast<ALCint>(frequency);
+    *(attr++) = ALC_FORMAT_CHANNELS_SOFT;
+    *(attr++) = static_cast<ALCint>(channels);
+    *(attr++) = ALC_FORMAT_TYPE_SOFT;
+    *(attr++) = ALC_FLOAT_SOFT;
+    if(channels == ALC_BFORMAT3D_SOFT)
+    {
+        *(attr++) = ALC_AMBISONIC_LAYOUT_SOFT;
+        *(attr++) = ALC_ACN_SOFT;
+        *(attr++) = ALC_AMBISONIC_SCALING_SOFT;
+        *(attr++) = ALC_SN3D_SOFT;
+        *(attr++) = ALC_AMBISONIC_ORDER_SOFT;
+        *(attr++) = static_cast<ALCint>(ambiorder);
+    }
+    *(attr++) = ALC_HRTF_SOFT;
+    *(attr++) = hrtf ? ALC_TRUE : ALC_FALSE;
+    *(attr++) = ALC_MONO_SOURCES;
+    *(attr++) = static_cast<ALCint>(monos);
+    *(attr++) = ALC_STEREO_SOURCES;
+    *(attr++) = static_cast<ALCint>(stereos);
+    *(attr++) = ALC_MAX_AUXILIARY_SENDS;
+    *(attr++) = static_cast<ALCint>(sends);
+    *(attr++) = 0;
+
+    ALCcontext *context{alcCreateContext(device->Device, attrs)};
+    if(!context)
+    {
+        fprintf(stderr, "Failed to create a context (%uhz, channels 0x%04x, order %u)\n",
+            frequency, channels, ambiorder);
+        return false;
+    }
+
+    size_t numchans{};
+    switch(channels)
+    {
+    case ALC_MONO_SOFT: numchans = 1; break;
+    case ALC_STEREO_SOFT: numchans = 2; break;
+    case ALC_QUAD_SOFT: numchans = 4; break;
+    case ALC_5POINT1_SOFT: numchans = 6; break;
+    case ALC_6POINT1_SOFT: numchans = 7; break;
+    case ALC_7POINT1_SOFT: numchans = 8; break;
+    case ALC_BFORMAT3D_SOFT: numchans = (ambiorder+1) * (ambiorder+1); break;
+    }
+    device->Frequency = frequency;
+    device->UpdateSize = static_cast<ALCsizei>(updatesize ? updatesize : 1024);
+    device->Output.resize(numchans * static_cast<size_t>(device->UpdateSize));
+
+    ReplayContext &ctx = Contexts[index];
+    ctx.Context = context;
+    ctx.Device = device.get();
+    return true;
+}
+
+void DestroyContext(ALuint index)
+{
+    auto iter = Contexts.find(index);
+    if(iter == Contexts.end()) return;
+
+    /* The device stays open for its other contexts, and any made later. */
+    if(alcGetCurrentContext() == iter->second.Context)
+        alcMakeContextCurrent(nullptr);
+    alcDestroyContext(iter->second.Context);
+    Contexts.erase(iter);
+}
+
+
+/* Renders the device up to the given time since its first context. */
+void RenderTo(ReplayDevice *device, uint64_t clocktime)
+{
+    const uint64_t target{clocktime * device->Frequency / 1000000000u};
+    auto start = std::chrono::steady_clock::now();
+    while(device->Rendered < target)
+    {
+        alcRenderSamplesSOFT(device->Device, device->Output.data(), device->UpdateSize);
+        device->Rendered += static_cast<ALuint>(device->UpdateSize);
+    }
+    RenderTime += std::chrono::steady_clock::now() - start;
+}
+
+
+bool ReplayCall(RecordCall call, ReplayContext &ctx, PayloadReader &reader)
+{
+    switch(call)
+    {
+    case RecordCall::CreateContext:
+    case RecordCall::DestroyContext:
+        break;
+
+    case RecordCall::Gen:
+    {
+        const auto obj = static_cast<RecordObject>(reader.get<ALuint>());
+        const auto count = reader.get<ALsizei>();
+        std::vector<ALuint> ids{reader.getArray<ALuint>(count)};
+        if(!reader.ok()) return false;
+
+        std::vector<ALuint> newids(ids.size());
+        switch(obj)
+        {
+        case RecordObject::Source: alGenSources(count, newids.data()); break;
+        case RecordObject::Buffer: alGenBuffers(count, newids.data()); break;
+        case RecordObject::Effect: alGenEffects(count, newids.data()); break;
+        case RecordObject::Filter: alGenFilters(count, newids.data()); break;
+        case RecordObject::EffectSlot: alGenAuxiliaryEffectSlots(count, newids.data()); break;
+        case RecordObject::Listener: return false;
+        }
+        std::map<ALuint,ALuint> &idmap = GetIdMap(ctx, obj);
+        for(size_t i{0};i < ids.size();++i)
+            idmap[ids[i]] = newids[i];
+        break;
+    }
+    case RecordCall::Delete:
+    {
+        const auto obj = static_cast<RecordObject>(reader.get<ALuint>());
+        const auto count = reader.get<ALsizei>();
+        std::vector<ALuint> ids{reader.getArray<ALuint>(count)};
+        if(!reader.ok()) return false;
+
+        std::map<ALuint,ALuint> &idmap = GetIdMap(ctx, obj);
+        std::vector<ALuint> newids;
+        for(ALuint id : ids)
+        {
+            newids.emplace_back(MapId(idmap, id));
+            idmap.erase(id);
+        }
+        switch(obj)
+        {
+        case RecordObject::Source: alDeleteSources(count, newids.data()); break;
+        case RecordObject::Buffer: alDeleteBuffers(count, newids.data()); break;
+        case RecordObject::Effect: alDeleteEffects(count, newids.data()); break;
+        case RecordObject::Filter: alDeleteFilters(count, newids.data()); break;
+        case RecordObject::EffectSlot: alDeleteAuxiliaryEffectSlots(count, newids.data()); break;
+        case RecordObject::Listener: return false;
+        }
+        break;
+    }
+
+    case RecordCall::Paramf:
+    {
+        const auto obj = static_cast<RecordObject>(reader.get<ALuint>());
+        const auto id = reader.get<ALuint>();
+        const auto param = reader.get<ALenum>();
+        const auto count = reader.get<ALsizei>();
+        std::vector<ALfloat> values{reader.getArray<ALfloat>(count)};
+        if(!reader.ok()) return false;
+
+        const ALuint newid{(obj == RecordObject::Listener) ? 0u : MapId(GetIdMap(ctx, obj), id)};
+        switch(obj)
+        {
+        case RecordObject::Source: alSourcefv(newid, param, values.data()); break;
+        case RecordObject::Effect: alEffectfv(newid, param, values.data()); break;
+        case RecordObject::Filter: alFilterfv(newid, param, values.data()); break;
+        case RecordObject::EffectSlot: alAuxiliaryEffectSlotfv(newid, param, values.data()); break;
+        case RecordObject::Listener: alListenerfv(param, values.data()); break;
+        case RecordObject::Buffer: return false;
+        }
+        break;
+    }
+    case RecordCall::Parami:
+    {
+        const auto obj = static_cast<RecordObject>(reader.get<ALuint>());
+        const auto id = reader.get<ALuint>();
+        const auto param = reader.get<ALenum>();
+        const auto count = reader.get<ALsizei>();
+        std::vector<ALint> values{reader.getArray<ALint>(count)};
+        if(!reader.ok()) return false;
+
+        MapParamIds(ctx, obj, param, values);
+        const ALuint newid{(obj == RecordObject::Listener) ? 0u : MapId(GetIdMap(ctx, obj), id)};
+        switch(obj)
+        {
+        case RecordObject::Source: alSourceiv(newid, param, values.data()); break;
+        case RecordObject::Effect: alEffectiv(newid, param, values.data()); break;
+        case RecordObject::Filter: alFilteriv(newid, param, values.data()); break;
+        case RecordObject::EffectSlot: alAuxiliaryEffectSlotiv(newid, param, values.data()); break;
+        case RecordObject::Listener: alListeneriv(param, values.data()); break;
+        case RecordObject::Buffer: return false;
+        }
+        break;
+    }
+    case RecordCall::Parami64:
+    {
+        const auto obj = static_cast<RecordObject>(reader.get<ALuint>());
+        const auto id = reader.get<ALuint>();
+        const auto param = reader.get<ALenum>();
+        const auto count = reader.get<ALsizei>();
+        std::vector<ALint64SOFT> values{reader.getArray<ALint64SOFT>(count)};
+        if(!reader.ok() || obj != RecordObject::Source) return false;
+
+        MapParamIds(ctx, obj, param, values);
+        alSourcei64vSOFT(MapId(ctx.Sources, id), param, values.data());
+        break;
+    }
+
+    case RecordCall::Statef:
+    {
+        const auto param = reader.get<ALenum>();
+        const auto value = reader.get<ALfloat>();
+        if(!reader.ok()) return false;
+        switch(param)
+        {
+        case AL_DOPPLER_FACTOR: alDopplerFactor(value); break;
+        case AL_DOPPLER_VELOCITY: alDopplerVelocity(value); break;
+        case AL_SPEED_OF_SOUND: alSpeedOfSound(value); break;
+        default: return false;
+        }
+        break;
+    }
+    case RecordCall::Statei:
+    {
+        const auto param = reader.get<ALenum>();
+        const auto value = reader.get<ALint>();
+        if(!reader.ok() || param != AL_DISTANCE_MODEL) return false;
+        alDistanceModel(value);
+        break;
+    }
+    case RecordCall::Enable:
+    case RecordCall::Disable:
+    {
+        const auto capability = reader.get<ALenum>();
+        if(!reader.ok()) return false;
+        if(call == RecordCall::Enable) alEnable(capability);
+        else alDisable(capability);
+        break;
+    }
+    case RecordCall::DeferUpdates:
+        alDeferUpdatesSOFT();
+        break;
+    case RecordCall::ProcessUpdates:
+        alProcessUpdatesSOFT();
+        break;
+
+    case RecordCall::SourcePlay:
+    case RecordCall::SourcePause:
+    case RecordCall::SourceStop:
+    case RecordCall::SourceRewind:
+    {
+        const auto count = reader.get<ALsizei>();
+        std::vector<ALuint> ids{reader.getArray<ALuint>(count)};
+        if(!reader.ok()) return false;
+        for(ALuint &id : ids)
+            id = MapId(ctx.Sources, id);
+
+        if(call == RecordCall::SourcePlay) alSourcePlayv(count, ids.data());
+        else if(call == RecordCall::SourcePause) alSourcePausev(count, ids.data());
+        else if(call == RecordCall::SourceStop) alSourceStopv(count, ids.data());
+        else alSourceRewindv(count, ids.data());
+        break;
+    }
+    case RecordCall::SourceQueue:
+    {
+        const auto source = reader.get<ALuint>();
+        const auto count = reader.get<ALsizei>();
+        std::vector<ALuint> ids{reader.getArray<ALuint>(count)};
+        if(!reader.ok()) return false;
+        for(ALuint &id : ids)
+            id = MapId(ctx.Device->Buffers, id);
+        alSourceQueueBuffers(MapId(ctx.Sources, source), count, ids.data());
+        break;
+    }
+    case RecordCall::SourceUnqueue:
+    {
+        const auto source = reader.get<ALuint>();
+        const auto count = reader.get<ALsizei>();
+        if(!reader.ok() || count < 0) return false;
+        std::vector<ALuint> ids(static_cast<size_t>(count));
+        alSourceUnqueueBuffers(MapId(ctx.Sources, source), count, ids.data());
+        break;
+    }
+    case RecordCall::SourceUpdateBatch:
+    {
+        const auto count = reader.get<ALsizei>();
+        if(!reader.ok() || count < 0) return false;
+        std::vector<ALuint> ids;
+        std::vector<ALsourceUpdateSOFT> updates;
+        for(ALsizei i{0};i < count;++i)
+        {
+            ids.emplace_back(MapId(ctx.Sources, reader.get<ALuint>()));
+            updates.emplace_back(reader.get<ALsourceUpdateSOFT>());
+        }
+        if(!reader.ok()) return false;
+        alSourceUpdateBatchSOFT(count, ids.data(), updates.data());
+        break;
+    }
+
+    case RecordCall::BufferData:
+    {
+        const auto buffer = reader.get<ALuint>();
+        const auto format = reader.get<ALenum>();
+        const auto size = reader.get<ALsizei>();
+        const auto freq = reader.get<ALsizei>();
+        const auto hash = reader.get<uint64_t>();
+        if(!reader.ok() || size < 0) return false;
+
+        std::vector<char> data;
+        if(hash != 0) data = MakeBufferData(format, size, hash);
+        alBufferData(MapId(ctx.Device->Buffers, buffer), format, hash ? data.data() : nullptr,
+            size, freq);
+        break;
+    }
+
+    default:
+        return false;
+    }
+    return true;
+}
+
+
+void PrintUsage(const char *argv0)
+{
+    fprintf(stderr,
+"Usage: %s <trace file>\n"
+"Replays a trace recorded by setting ALSOFT_RECORD_FILE, rendering on loopback\n"
+"devices as fast as possible.\n",
+        argv0);
+}
+
+} // namespace
+
+
+int main(int argc, char *argv[])
+{
+    if(argc != 2 || argv[1][0] == '-')
+    {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    if(!alcIsExtensionPresent(nullptr, "ALC_SOFT_loopback"))
+    {
+        fprintf(stderr, "ALC_SOFT_loopback not supported\n");
+        return 1;
+    }
+
+    FILE *file{fopen(argv[1], "rb")};
+    if(!file)
+    {
+        fprintf(stderr, "Failed to open %s\n", argv[1]);
+        return 1;
+    }
+
+    char magic[4]{};
+    ALuint version{};
+    if(fread(magic, 1, 4, file) != 4 || memcmp(magic, RECORD_FILE_MAGIC, 4) != 0
+        || fread(&version, sizeof(version), 1, file) != 1)
+    {
+        fprintf(stderr, "%s is not a recorded trace\n", argv[1]);
+        fclose(file);
+        return 1;
+    }
+    if(version != RECORD_FILE_VERSION)
+    {
+        fprintf(stderr, "Unsupported trace version %u (expected %d)\n", version,
+            RECORD_FILE_VERSION);
+        fclose(file);
+        return 1;
+    }
+
+    ALCcontext *current{nullptr};
+    std::vector<char> payload;
+    auto start = std::chrono::steady_clock::now();
+    while(true)
+    {
+        ALuint call, ctxindex, size;
+        uint64_t clocktime;
+        if(fread(&call, sizeof(call), 1, file) != 1
+            || fread(&ctxindex, sizeof(ctxindex), 1, file) != 1
+            || fread(&clocktime, sizeof(clocktime), 1, file) != 1
+            || fread(&size, sizeof(size), 1, file) != 1)
+            break;
+
+        payload.resize(size);
+        if(size > 0 && fread(payload.data(), 1, size, file) != size)
+        {
+            fprintf(stderr, "Trace ends in the middle of a record\n");
+            break;
+        }
+        ++NumRecords;
+
+        PayloadReader reader{payload};
+        if(static_cast<RecordCall>(call) == RecordCall::CreateContext)
+        {
+            if(!CreateContext(ctxindex, reader))
+                break;
+            continue;
+        }
+
+        auto ctxiter = Contexts.find(ctxindex);
+        if(ctxiter == Contexts.end())
+        {
+            ++NumSkipped;
+            continue;
+        }
+        ReplayContext &ctx = ctxiter->second;
+
+        RenderTo(ctx.Device, clocktime);
+        if(static_cast<RecordCall>(call) == RecordCall::DestroyContext)
+        {
+            if(current == ctx.Context)
+                current = nullptr;
+            DestroyContext(ctxindex);
+            continue;
+        }
+
+        if(current != ctx.Context)
+        {
+            alcMakeContextCurrent(ctx.Context);
+            current = ctx.Context;
+        }
+        if(!ReplayCall(static_cast<RecordCall>(call), ctx, reader))
+            ++NumSkipped;
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    fclose(file);
+
+    uint64_t rendered{0u};
+    double seconds{0.0};
+    for(auto &device : Devices)
+    {
+        rendered += device.second->Rendered;
+        if(device.second->Frequency)
+            seconds += static_cast<double>(device.second->Rendered) / device.second->Frequency;
+    }
+    const double render_ns{static_cast<double>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(RenderTime).count())};
+    const double total_ns{static_cast<double>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count())};
+
+    printf("{\n");
+    printf("  \"records\": %llu,\n", static_cast<unsigned long long>(NumRecords));
+    printf("  \"skipped_records\": %llu,\n", static_cast<unsigned long long>(NumSkipped));
+    printf("  \"devices\": %zu,\n", Devices.size());
+    printf("  \"samples\": %llu,\n", static_cast<unsigned long long>(rendered));
+    printf("  \"seconds\": %g,\n", seconds);
+    printf("  \"elapsed_ns\": %.0f,\n", total_ns);
+    printf("  \"render_ns\": %.0f,\n", render_ns);
+    printf("  \"realtime_factor\": ");
+    if(render_ns > 0.0) printf("%.2f\n", seconds * 1000000000.0 / render_ns);
+    else printf("null\n");
+    printf("}\n");
+
+    alcMakeContextCurrent(nullptr);
+    for(auto &ctx : Contexts)
+        alcDestroyContext(ctx.second.Context);
+    for(auto &device : Devices)
+        alcCloseDevice(device.second->Device);
+
+    return 0;
+}